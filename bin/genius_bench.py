@@ -0,0 +1,222 @@
+#!/usr/bin/env python
+#
+# regression benchmark of genius on the example decks.
+#
+# each case of the suite copies an example directory to a scratch directory and runs
+# its decks in order with mpirun at the given process counts. genius is started with
+# -trace and -solver_stats, from which the wall time of each logged phase (processor 0)
+# and the Newton/KSP iteration counts are collected. peak RSS is the largest resident
+# set of mpirun and all the processes it waited for.
+#
+# the result is compared against a baseline file, a case is flagged when its wall time,
+# a phase time, the iteration counts or the peak RSS exceed the baseline by more than
+# the threshold. the exit status is 1 when anything is flagged or a case fails.
+#
+#   genius_bench.py [-g genius] [-s suite.json] [-b baseline.json] [-t 0.1]
+#                   [-c case,case...] [-w workdir] [-u]
+#
+
+import getopt
+import json
+import os
+import shutil
+import subprocess
+import sys
+import time
+
+# phase times below this (in second) are too noisy to compare
+MIN_PHASE_TIME = 0.5
+
+
+def usage():
+    sys.stderr.write('Usage: genius_bench.py [-g genius] [-s suite] [-b baseline] [-t threshold] [-c cases] [-w workdir] [-u]\n')
+    sys.stderr.write('  -g  genius executable  [genius]\n')
+    sys.stderr.write('  -m  mpirun executable  [mpirun]\n')
+    sys.stderr.write('  -s  suite file         [examples/bench/suite.json]\n')
+    sys.stderr.write('  -b  baseline file      [examples/bench/baseline.json]\n')
+    sys.stderr.write('  -t  slowdown threshold [0.1]\n')
+    sys.stderr.write('  -c  comma separated case names to run, default all\n')
+    sys.stderr.write('  -w  scratch directory  [bench]\n')
+    sys.stderr.write('  -u  write the results as new baseline\n')
+
+
+def run_process(cmd, cwd, log):
+    """ run cmd, return (exit status, wall time, peak rss in byte) """
+    out = open(log, 'a')
+    t0 = time.time()
+    p = subprocess.Popen(cmd, cwd=cwd, stdout=out, stderr=subprocess.STDOUT)
+    # wait4 reports the rusage of the child and all the descendants it waited for
+    pid, status, rusage = os.wait4(p.pid, 0)
+    if os.WIFEXITED(status): status = os.WEXITSTATUS(status)
+    else:                    status = -os.WTERMSIG(status)
+    p.returncode = status
+    wall = time.time() - t0
+    out.close()
+    rss = rusage.ru_maxrss
+    if sys.platform != 'darwin': rss *= 1024
+    return status, wall, rss
+
+
+def phase_times(trace_file):
+    """ inclusive wall time of each traced phase, by name """
+    times = {}
+    if not os.path.exists(trace_file): return times
+    events = json.load(open(trace_file))['traceEvents']
+    stacks = {}
+    for e in events:
+        if e['ph'] == 'B':
+            stacks.setdefault(e['tid'], []).append(e)
+        elif e['ph'] == 'E':
+            stack = stacks.get(e['tid'], [])
+            if not stack: continue
+            b = stack.pop()
+            # recursive phases are counted once, at the outer level
+            if [x for x in stack if x['name'] == b['name']]: continue
+            times[b['name']] = times.get(b['name'], 0.0) + (e['ts'] - b['ts'])*1e-6
+    return times
+
+
+def solver_counts(stats_file):
+    """ number of solution steps, Newton and KSP iterations, failed steps """
+    counts = {'steps' : 0, 'newton_its' : 0, 'ksp_its' : 0, 'failed_steps' : 0, 'lte_rejects' : 0}
+    if not os.path.exists(stats_file): return counts
+    for line in open(stats_file):
+        line = line.strip()
+        if not line: continue
+        r = json.loads(line)
+        if r['record'] == 'step':
+            counts['steps'] += 1
+            counts['newton_its'] += r.get('its', 0)
+            counts['ksp_its']    += r.get('ksp_its', 0)
+            if not r.get('converged', True): counts['failed_steps'] += 1
+        elif r['record'] == 'lte_reject':
+            counts['lte_rejects'] += 1
+    return counts
+
+
+def run_case(case, np, opts):
+    """ run the decks of case with np processors, return the result record """
+    name = '%s.np%d' % (case['name'], np)
+    src = os.path.join(opts['examples'], case['dir'])
+    work = os.path.join(opts['workdir'], name)
+    if os.path.exists(work): shutil.rmtree(work)
+    shutil.copytree(src, work)
+
+    log = os.path.join(work, 'bench.log')
+    result = {'wall' : 0.0, 'rss' : 0, 'phases' : {}, 'status' : 0}
+    for k, v in solver_counts('').items(): result[k] = v
+
+    for deck in case['decks']:
+        prefix = os.path.join(work, os.path.splitext(deck)[0])
+        cmd = [opts['mpirun'], '-n', str(np), opts['genius'], '-i', deck,
+               '-trace', prefix + '.trace', '-solver_stats', prefix + '.stats']
+        status, wall, rss = run_process(cmd, work, log)
+        result['wall'] += wall
+        result['rss'] = max(result['rss'], rss)
+        if status != 0:
+            result['status'] = status
+            break
+        for k, v in phase_times(prefix + '.trace.0.json').items():
+            result['phases'][k] = result['phases'].get(k, 0.0) + v
+        for k, v in solver_counts(prefix + '.stats').items():
+            result[k] += v
+
+    return name, result
+
+
+def compare(name, result, base, threshold):
+    """ @return the list of regressions of result against base """
+    flags = []
+    def check(what, value, ref, floor=0):
+        if ref is None or ref <= floor: return
+        if value > ref*(1.0+threshold):
+            flags.append('%s: %s %.4g -> %.4g (+%.1f%%)' % (name, what, ref, value, 100.0*(value/ref-1.0)))
+
+    check('wall time', result['wall'], base.get('wall'), MIN_PHASE_TIME)
+    check('peak rss', result['rss'], base.get('rss'))
+    check('newton its', result['newton_its'], base.get('newton_its'))
+    check('ksp its', result['ksp_its'], base.get('ksp_its'))
+    base_phases = base.get('phases', {})
+    for phase, t in sorted(result['phases'].items()):
+        check('phase "%s"' % phase, t, base_phases.get(phase), MIN_PHASE_TIME)
+    if result['failed_steps'] > base.get('failed_steps', 0):
+        flags.append('%s: failed steps %d -> %d' % (name, base.get('failed_steps', 0), result['failed_steps']))
+    return flags
+
+
+def main():
+    here = os.path.abspath(os.path.dirname(os.path.abspath(__file__)) + '/..')
+    opts = { 'genius'   : 'genius',
+             'mpirun'   : 'mpirun',
+             'examples' : os.path.join(here, 'examples'),
+             'suite'    : os.path.join(here, 'examples', 'bench', 'suite.json'),
+             'baseline' : os.path.join(here, 'examples', 'bench', 'baseline.json'),
+             'workdir'  : 'bench',
+             'threshold': 0.1,
+             'cases'    : None,
+             'update'   : False }
+
+    try:
+        optlist, args = getopt.getopt(sys.argv[1:], 'g:m:s:b:t:c:w:uh')
+    except getopt.GetoptError:
+        usage()
+        return 2
+    for o, a in optlist:
+        if   o == '-g': opts['genius'] = a
+        elif o == '-m': opts['mpirun'] = a
+        elif o == '-s': opts['suite'] = a
+        elif o == '-b': opts['baseline'] = a
+        elif o == '-t': opts['threshold'] = float(a)
+        elif o == '-c': opts['cases'] = a.split(',')
+        elif o == '-w': opts['workdir'] = a
+        elif o == '-u': opts['update'] = True
+        elif o == '-h':
+            usage()
+            return 0
+
+    # the cases run in their scratch directory
+    for k in ('genius', 'mpirun'):
+        if os.sep in opts[k]: opts[k] = os.path.abspath(opts[k])
+    opts['workdir'] = os.path.abspath(opts['workdir'])
+    if not os.path.exists(opts['workdir']): os.makedirs(opts['workdir'])
+
+    suite = json.load(open(opts['suite']))
+    baseline = {}
+    if os.path.exists(opts['baseline']):
+        baseline = json.load(open(opts['baseline']))
+
+    results = {}
+    flags = []
+    for case in suite['cases']:
+        if opts['cases'] and case['name'] not in opts['cases']: continue
+        for np in case['np']:
+            name, result = run_case(case, np, opts)
+            results[name] = result
+            if result['status'] != 0:
+                flags.append('%s: failed with status %d, see %s' % (name, result['status'], os.path.join(opts['workdir'], name, 'bench.log')))
+                status = 'FAILED'
+            elif name in baseline:
+                case_flags = compare(name, result, baseline[name], opts['threshold'])
+                flags.extend(case_flags)
+                status = case_flags and 'SLOWER' or 'ok'
+            else:
+                status = 'no baseline'
+            print('%-24s %10.2fs %8d newton %10d ksp %8.1f MB  %s' %
+                  (name, result['wall'], result['newton_its'], result['ksp_its'], result['rss']/1048576.0, status))
+            sys.stdout.flush()
+
+    json.dump(results, open(os.path.join(opts['workdir'], 'results.json'), 'w'), indent=1, sort_keys=True)
+
+    if opts['update']:
+        for name, result in results.items():
+            if result['status'] == 0: baseline[name] = result
+        json.dump(baseline, open(opts['baseline'], 'w'), indent=1, sort_keys=True)
+        print('baseline written to %s' % opts['baseline'])
+        return 0
+
+    for f in flags: print(f)
+    return flags and 1 or 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
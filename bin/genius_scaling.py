@@ -0,0 +1,257 @@
+#!/usr/bin/env python
+#
+# strong and weak scaling benchmark of genius on generated device meshes.
+#
+# each case takes a device template deck (a MESH of S_Quad4 or S_Tri3 with X.MESH/Y.MESH,
+# optionally extruded to 3D by EXTEND) and a list of solves (Poisson, DDM1, EBM3 steady
+# state and short transients). the deck of each run is generated from the template:
+#
+#   {expr}   integer expression of the size variables: s (size scale), sx (x scale) and nz
+#            (EXTEND layers). sx equals s in strong scaling and s*P in weak scaling, P is
+#            the number of cores (ranks x threads) of the run, so the number of elements
+#            grows with P
+#   @NAME@   text of the case: @MESH@ mesh type, @EXTEND@ the EXTEND card (empty in 2D),
+#            @SOLVE@ the solve cards, @VSCAN@ the swept electrode, @REGION@ the semiconductor
+#
+# every run is started with -threads, -trace, -solver_stats and the PETSc log. from them:
+#   setup     time before the first nonlinear solve (mesh, EXTEND, partition, system build)
+#   assembly  residual and jacobian evaluation
+#   pc setup  PETSc PCSetUp
+#   ksp       PETSc KSPSolve, excluding PC setup
+#   io        export and import phases
+#   memory    peak resident set of each rank
+# the phase times are the max over the ranks. the strong and weak scaling tables are printed
+# per case, and all the records are written to results.json and scaling.csv in the workdir.
+#
+#   genius_scaling.py [-g genius] [-m mpirun] [-s scaling.json] [-c case,case...]
+#                     [-n ranks,ranks...] [-T threads,threads...] [-M strong,weak]
+#                     [-L -log_view] [-w workdir]
+#
+
+import getopt
+import json
+import os
+import re
+import shutil
+import sys
+
+from genius_bench import run_process, solver_counts
+
+
+def usage():
+    sys.stderr.write('Usage: genius_scaling.py [-g genius] [-m mpirun] [-s scaling] [-c cases] [-n ranks] [-T threads] [-M modes] [-L log] [-w workdir]\n')
+    sys.stderr.write('  -g  genius executable   [genius]\n')
+    sys.stderr.write('  -m  mpirun executable   [mpirun]\n')
+    sys.stderr.write('  -s  scaling file        [examples/bench/scaling.json]\n')
+    sys.stderr.write('  -c  comma separated case names to run, default all\n')
+    sys.stderr.write('  -n  comma separated MPI ranks, overrides the cases\n')
+    sys.stderr.write('  -T  comma separated threads per rank, overrides the cases\n')
+    sys.stderr.write('  -M  strong, weak or strong,weak, overrides the cases\n')
+    sys.stderr.write('  -L  PETSc log option, -log_view or -log_summary for old PETSc [-log_view]\n')
+    sys.stderr.write('  -w  scratch directory   [scaling]\n')
+
+
+def make_deck(template, case, solve, s, sx):
+    """ the deck of one run from the device template """
+    values = {'s' : s, 'sx' : sx, 'nz' : case.get('nz', 0)}
+    def expr(m):
+        return str(max(1, int(round(eval(m.group(1), {}, values)))))
+    deck = re.sub(r'\{([^{}]+)\}', expr, template)
+
+    extend = ''
+    if case.get('nz', 0) > 0:
+        extend = 'EXTEND    z.min=0 z.max=%g n.spaces=%d' % (case.get('z.width', 1.0), case['nz'])
+    # the solve cards go first, they may hold the other names
+    text = [ ('SOLVE',  solve),
+             ('MESH',   case.get('mesh', 'S_Quad4')),
+             ('EXTEND', extend),
+             ('VSCAN',  case.get('vscan', '')),
+             ('REGION', case.get('region', '')) ]
+    for k, v in text:
+        deck = deck.replace('@%s@' % k, v)
+    return deck
+
+
+def trace_times(trace_file):
+    """ setup, assembly and io time, peak rss (MB) of one rank """
+    result = {'setup' : 0.0, 'assembly' : 0.0, 'io' : 0.0, 'rss' : 0.0}
+    if not os.path.exists(trace_file): return result
+    events = json.load(open(trace_file))['traceEvents']
+    stacks = {}
+    first_solve = None
+    for e in events:
+        if e['ph'] == 'C' and e['name'] == 'memory':
+            result['rss'] = max(result['rss'], e['args'].get('peak_rss', 0.0))
+        elif e['ph'] == 'B':
+            if first_solve is None and e['name'].endswith('_SNES()'): first_solve = e['ts']
+            stacks.setdefault(e['tid'], []).append(e)
+        elif e['ph'] == 'E':
+            stack = stacks.get(e['tid'], [])
+            if not stack: continue
+            b = stack.pop()
+            # recursive phases are counted once, at the outer level
+            if [x for x in stack if x['name'] == b['name']]: continue
+            t = (e['ts'] - b['ts'])*1e-6
+            if b['name'] in ('SNES_Residual()', 'SNES_Jacobian()'):
+                result['assembly'] += t
+            elif re.search('export|import', b['name'], re.I):
+                result['io'] += t
+    if first_solve is not None:
+        result['setup'] = first_solve*1e-6
+    return result
+
+
+def petsc_log_times(log_file):
+    """ max time over ranks of PCSetUp and KSPSolve from the PETSc log """
+    times = {'PCSetUp' : 0.0, 'KSPSolve' : 0.0}
+    if not os.path.exists(log_file): return times
+    for line in open(log_file):
+        fields = line.split()
+        # event, count max, ratio, time max, ratio, ...
+        if len(fields) > 3 and fields[0] in times:
+            try: times[fields[0]] += float(fields[3])
+            except ValueError: pass
+    # PCSetUp is nested in KSPSolve
+    times['KSPSolve'] = max(0.0, times['KSPSolve'] - times['PCSetUp'])
+    return times
+
+
+def run(case, template, solve_name, np, nt, mode, opts):
+    """ one run of a solve of case with np ranks and nt threads per rank """
+    cores = np*nt
+    s = case.get('size', 1)
+    sx = mode == 'weak' and s*cores or s
+    name = '%s.%s.%s.np%d.t%d' % (case['name'], solve_name, mode, np, nt)
+    work = os.path.join(opts['workdir'], name)
+    if os.path.exists(work): shutil.rmtree(work)
+    os.makedirs(work)
+
+    deck = make_deck(template, case, opts['solves'][solve_name], s, sx)
+    open(os.path.join(work, 'bench.inp'), 'w').write(deck)
+
+    petsc_log = os.path.join(work, 'petsc.log')
+    log_value = opts['petsc_log'] == '-log_summary' and petsc_log or ':' + petsc_log
+    cmd = [opts['mpirun'], '-n', str(np), opts['genius'], '-i', 'bench.inp', '-threads', str(nt),
+           '-trace', os.path.join(work, 'bench.trace'), '-solver_stats', os.path.join(work, 'bench.stats'),
+           opts['petsc_log'], log_value]
+    status, wall, rss = run_process(cmd, work, os.path.join(work, 'bench.log'))
+
+    result = { 'case' : case['name'], 'solve' : solve_name, 'mode' : mode, 'np' : np, 'threads' : nt,
+               'cores' : cores, 'sx' : sx, 'status' : status, 'wall' : wall,
+               'setup' : 0.0, 'assembly' : 0.0, 'io' : 0.0, 'rss_max' : 0.0, 'rss_mean' : 0.0 }
+    rss_ranks = []
+    for rank in range(np):
+        trace_file = os.path.join(work, 'bench.trace.%d.json' % rank)
+        if not os.path.exists(trace_file): continue
+        t = trace_times(trace_file)
+        for k in ('setup', 'assembly', 'io'):
+            result[k] = max(result[k], t[k])
+        rss_ranks.append(t['rss'])
+    if rss_ranks:
+        result['rss_max'] = max(rss_ranks)
+        result['rss_mean'] = sum(rss_ranks)/len(rss_ranks)
+    petsc = petsc_log_times(petsc_log)
+    result['pc_setup'] = petsc['PCSetUp']
+    result['ksp'] = petsc['KSPSolve']
+    counts = solver_counts(os.path.join(work, 'bench.stats'))
+    result['newton_its'] = counts['newton_its']
+    result['ksp_its'] = counts['ksp_its']
+    return name, result
+
+
+def print_table(records, mode):
+    """ the scaling table of the runs of one case, solve and mode """
+    records = sorted(records, key=lambda r: (r['cores'], r['np']))
+    base = records[0]
+    print('  %s scaling, reference %d ranks x %d threads' % (mode, base['np'], base['threads']))
+    print('  %5s %4s %6s %9s %8s %6s %9s %9s %9s %9s %8s %10s' %
+          ('ranks', 'thr', 'cores', 'wall[s]', 'speedup', 'eff', 'setup[s]', 'assm[s]', 'pc[s]', 'ksp[s]', 'io[s]', 'MB/rank'))
+    for r in records:
+        if r['status'] != 0:
+            print('  %5d %4d %6d   FAILED with status %d' % (r['np'], r['threads'], r['cores'], r['status']))
+            continue
+        ratio = float(r['cores'])/base['cores']
+        speedup = r['wall'] > 0 and base['wall']/r['wall'] or 0.0
+        # weak scaling keeps the work per core, the ideal wall time is constant
+        if mode == 'weak': eff = speedup
+        else:              eff = speedup/ratio
+        print('  %5d %4d %6d %9.2f %8.2f %5.0f%% %9.2f %9.2f %9.2f %9.2f %8.2f %10.1f' %
+              (r['np'], r['threads'], r['cores'], r['wall'], speedup, 100.0*eff,
+               r['setup'], r['assembly'], r['pc_setup'], r['ksp'], r['io'], r['rss_max']))
+
+
+def main():
+    here = os.path.abspath(os.path.dirname(os.path.abspath(__file__)) + '/..')
+    opts = { 'genius'    : 'genius',
+             'mpirun'    : 'mpirun',
+             'scaling'   : os.path.join(here, 'examples', 'bench', 'scaling.json'),
+             'workdir'   : 'scaling',
+             'petsc_log' : '-log_view',
+             'cases'     : None,
+             'ranks'     : None,
+             'threads'   : None,
+             'modes'     : None }
+
+    try:
+        optlist, args = getopt.getopt(sys.argv[1:], 'g:m:s:c:n:T:M:L:w:h')
+    except getopt.GetoptError:
+        usage()
+        return 2
+    for o, a in optlist:
+        if   o == '-g': opts['genius'] = a
+        elif o == '-m': opts['mpirun'] = a
+        elif o == '-s': opts['scaling'] = a
+        elif o == '-c': opts['cases'] = a.split(',')
+        elif o == '-n': opts['ranks'] = [int(x) for x in a.split(',')]
+        elif o == '-T': opts['threads'] = [int(x) for x in a.split(',')]
+        elif o == '-M': opts['modes'] = a.split(',')
+        elif o == '-L': opts['petsc_log'] = a
+        elif o == '-w': opts['workdir'] = a
+        elif o == '-h':
+            usage()
+            return 0
+
+    # the runs are in their scratch directory
+    for k in ('genius', 'mpirun'):
+        if os.sep in opts[k]: opts[k] = os.path.abspath(opts[k])
+    opts['workdir'] = os.path.abspath(opts['workdir'])
+    if not os.path.exists(opts['workdir']): os.makedirs(opts['workdir'])
+
+    scaling = json.load(open(opts['scaling']))
+    opts['solves'] = scaling['solves']
+    template_dir = os.path.dirname(os.path.abspath(opts['scaling']))
+
+    results = {}
+    failed = 0
+    for case in scaling['cases']:
+        if opts['cases'] and case['name'] not in opts['cases']: continue
+        template = open(os.path.join(template_dir, case['template'])).read()
+        for solve_name in case['solves']:
+            for mode in opts['modes'] or case.get('modes', ['strong']):
+                records = []
+                for np in opts['ranks'] or case.get('ranks', [1]):
+                    for nt in opts['threads'] or case.get('threads', [1]):
+                        name, result = run(case, template, solve_name, np, nt, mode, opts)
+                        results[name] = result
+                        records.append(result)
+                        if result['status'] != 0: failed += 1
+                        sys.stdout.flush()
+                print('%s %s' % (case['name'], solve_name))
+                print_table(records, mode)
+                sys.stdout.flush()
+
+    json.dump(results, open(os.path.join(opts['workdir'], 'results.json'), 'w'), indent=1, sort_keys=True)
+
+    keys = ['case', 'solve', 'mode', 'np', 'threads', 'cores', 'sx', 'status', 'wall', 'setup', 'assembly',
+            'pc_setup', 'ksp', 'io', 'rss_max', 'rss_mean', 'newton_its', 'ksp_its']
+    out = open(os.path.join(opts['workdir'], 'scaling.csv'), 'w')
+    out.write(','.join(keys) + '\n')
+    for name in sorted(results.keys()):
+        out.write(','.join([str(results[name][k]) for k in keys]) + '\n')
+    out.close()
+
+    return failed and 1 or 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
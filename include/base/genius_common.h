@@ -14,11 +14,19 @@
 #include "config.h"
 #include "petscsys.h"
 #include "petsc_macro.h"
+#include "log.h"
 
 #ifndef PETSC_VERSION_DEV
   #define PetscBool PetscTruth
 #endif
 
+// read only access to vector array, which keeps the copy of device vector types valid.
+// PETSC before 3.2 has no such routines
+#if !defined(PETSC_VERSION_DEV) && PETSC_VERSION_LT(3,2,0)
+  #define VecGetArrayRead(v, a)      VecGetArray(v, const_cast<PetscScalar **>(a))
+  #define VecRestoreArrayRead(v, a)  VecRestoreArray(v, const_cast<PetscScalar **>(a))
+#endif
+
 #ifdef CYGWIN
   // something required for building windows dll
   #define DLL_EXPORT_DECLARE  __declspec  (dllexport)
@@ -26,6 +34,13 @@
   #define DLL_EXPORT_DECLARE
 #endif
 
+// thread local storage specifier, used by data which is written inside the assembly loops
+#if defined(CYGWIN) || defined(_MSC_VER)
+  #define GENIUS_THREAD_LOCAL __declspec(thread)
+#else
+  #define GENIUS_THREAD_LOCAL __thread
+#endif
+
 
 // when PETSC_HAVE_MPIUNI is defined by PETSC, no MPI exist!
 #ifdef PETSC_HAVE_MPIUNI
@@ -184,14 +199,15 @@ typedef float ErrorVectorReal;
 #undef genius_assert
 #ifdef CYGWIN
 #  include <csignal>
-#  define genius_assert(a)  {  if (! (a) ) { std::cerr << "Assertion failure at " << __FILE__ << ":" << __LINE__ << std::endl; std::raise(SIGTERM); } }
+#  define genius_assert(a)  {  if (! (a) ) { genius_log.flush(); std::cerr << "Assertion failure at " << __FILE__ << ":" << __LINE__ << std::endl; std::raise(SIGTERM); } }
 #else
-#  define genius_assert(a)  {  if (! (a) ) { std::cerr << "Assertion failure at " << __FILE__ << ":" << __LINE__ << std::endl; std::abort(); } }
+#  define genius_assert(a)  {  if (! (a) ) { genius_log.flush(); std::cerr << "Assertion failure at " << __FILE__ << ":" << __LINE__ << std::endl; std::abort(); } }
 #endif
 
-// The genius_error() macro prints a message and aborts the code
+// The genius_error() macro prints a message and aborts the code,
+// the pending log messages (usually the reason of the error) are written first
 #undef genius_error
-#  define genius_error()    {  std::abort(); }
+#  define genius_error()    {  genius_log.flush(); std::abort(); }
 
 // The untested macro warns that you are using untested code
 #undef genius_untested
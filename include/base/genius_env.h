@@ -4,6 +4,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <vector>
 
 namespace Genius {
 
@@ -49,6 +50,68 @@ namespace Genius {
    */
   bool is_last_processor();
 
+  /**
+   * @returns the number of threads used by the assembly loops of each processor
+   */
+  unsigned int n_threads();
+
+  /**
+   * set the number of threads used by the assembly loops of each processor.
+   * it is always 1 when genius is built without OpenMP support
+   */
+  void set_n_threads(unsigned int n);
+
+  /**
+   * @returns the index of the calling thread, 0 for the master thread
+   */
+  unsigned int thread_id();
+
+  /**
+   * @returns the number of threads each processor can run without oversubscribing its node:
+   * the cpus this processor owns, i.e. its affinity mask when the MPI launcher binds the
+   * processors, otherwise an equal share of the node among the processors running on it
+   */
+  unsigned int default_n_threads();
+
+  /**
+   * pin the threads of each processor to the cpus it owns, one cpu per thread.
+   * the binding is applied again by every set_n_threads() call.
+   * it is ignored when OMP_PROC_BIND is set, then the OpenMP runtime places the threads
+   */
+  void set_thread_binding(bool bind);
+
+  /**
+   * @returns the number of ensemble process groups, 1 when genius runs a single deck.
+   * each group works on its own sub-communicator, which is PETSC_COMM_WORLD
+   * inside the group
+   */
+  unsigned int n_ensemble_groups();
+
+  /**
+   * @returns the ensemble process group this processor belongs to
+   */
+  unsigned int ensemble_group();
+
+  /**
+   * @returns the input decks solved one after another by this process group.
+   * empty when genius is not started in ensemble mode
+   */
+  const std::vector<std::string> & ensemble_decks();
+
+  /**
+   * @returns the number of bias process groups given by -bias_groups, 1 by default.
+   * each group runs the same deck on its own sub-communicator, and the DC sweeps
+   * with parallel.bias are cut into slices which the groups solve at the same time,
+   * the strikes of a transient campaign are shared by the groups in the same way
+   */
+  unsigned int n_bias_groups();
+
+  /**
+   * @returns the bias process group this processor belongs to.
+   * only group 0 writes the output files of the deck
+   */
+  unsigned int bias_group();
+
   /**
    * @returns the input filename;
    */
@@ -69,6 +132,26 @@ namespace Genius {
    */
   void set_genius_dir(const std::string &genius_dir);
 
+  /**
+   * @returns the file prefix of FVM geometry cache, empty if cache is not used
+   */
+  std::string geometry_cache();
+
+  /**
+   * Set the file prefix of FVM geometry cache
+   */
+  void set_geometry_cache(const std::string &prefix);
+
+  /**
+   * @returns the file prefix of optical generation cache, empty if only memory cache is used
+   */
+  std::string optical_cache();
+
+  /**
+   * Set the file prefix of optical generation cache
+   */
+  void set_optical_cache(const std::string &prefix);
+
   /**
    * Namespaces don't provide private data,
    * so let's take the data we would like
@@ -88,6 +171,36 @@ namespace Genius {
      */
     static int  _processor_id;
 
+    /**
+     * The number of threads of each processor
+     */
+    static int  _n_threads;
+
+    /**
+     * The number of ensemble process groups
+     */
+    static int  _n_ensemble_groups;
+
+    /**
+     * The ensemble process group of local processor
+     */
+    static int  _ensemble_group;
+
+    /**
+     * The input decks assigned to the local process group
+     */
+    static std::vector<std::string> _ensemble_decks;
+
+    /**
+     * The number of bias process groups
+     */
+    static int  _n_bias_groups;
+
+    /**
+     * The bias process group of local processor
+     */
+    static int  _bias_group;
+
     /**
      * the user input file.
      */
@@ -98,6 +211,16 @@ namespace Genius {
      */
     static std::string _genius_dir;
 
+    /**
+     * FVM geometry cache file prefix
+     */
+    static std::string _geometry_cache;
+
+    /**
+     * optical generation cache file prefix
+     */
+    static std::string _optical_cache;
+
   };
 }
 
@@ -141,6 +264,42 @@ inline bool Genius::is_last_processor()
 }
 
 
+inline unsigned int Genius::n_threads()
+{
+  return static_cast<unsigned int>(GeniusPrivateData::_n_threads);
+}
+
+
+inline unsigned int Genius::n_ensemble_groups()
+{
+  return static_cast<unsigned int>(GeniusPrivateData::_n_ensemble_groups);
+}
+
+
+inline unsigned int Genius::ensemble_group()
+{
+  return static_cast<unsigned int>(GeniusPrivateData::_ensemble_group);
+}
+
+
+inline const std::vector<std::string> & Genius::ensemble_decks()
+{
+  return GeniusPrivateData::_ensemble_decks;
+}
+
+
+inline unsigned int Genius::n_bias_groups()
+{
+  return static_cast<unsigned int>(GeniusPrivateData::_n_bias_groups);
+}
+
+
+inline unsigned int Genius::bias_group()
+{
+  return static_cast<unsigned int>(GeniusPrivateData::_bias_group);
+}
+
+
 inline const char * Genius::input_file()
 {
   return GeniusPrivateData::_input_file.c_str();
@@ -161,4 +320,24 @@ inline void Genius::set_genius_dir(const std::string &genius_dir)
   GeniusPrivateData::_genius_dir = genius_dir;
 }
 
+inline std::string Genius::geometry_cache()
+{
+  return GeniusPrivateData::_geometry_cache;
+}
+
+inline void Genius::set_geometry_cache(const std::string &prefix)
+{
+  GeniusPrivateData::_geometry_cache = prefix;
+}
+
+inline std::string Genius::optical_cache()
+{
+  return GeniusPrivateData::_optical_cache;
+}
+
+inline void Genius::set_optical_cache(const std::string &prefix)
+{
+  GeniusPrivateData::_optical_cache = prefix;
+}
+
 #endif // #define _genius_env_h_
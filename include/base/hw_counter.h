@@ -0,0 +1,122 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __hw_counter_h__
+#define __hw_counter_h__
+
+
+/**
+ * hardware performance counters of the calling thread, read through the
+ * linux perf_event interface. the counters of one thread are opened as a group,
+ * so they are scheduled on the PMU together and read by one system call.
+ *
+ * there is no portable perf_event for floating point operations, the
+ * FP_OPS counter is a raw, cpu specific event given to enable(), e.g. the
+ * FP_ARITH_INST_RETIRED event of the intel core. it is not counted when no
+ * raw event is given.
+ *
+ * only the calling thread is counted, the work of the other threads in
+ * an OpenMP region is on their own counters.
+ *
+ * the counters are off by default. on the other platforms, or when the kernel
+ * refuses the events (see /proc/sys/kernel/perf_event_paranoid), all the
+ * counters read zero.
+ */
+class HWCounter
+{
+public:
+
+  enum Counter
+  {
+    CYCLES = 0,
+    INSTRUCTIONS,
+    CACHE_REFERENCES,
+    CACHE_MISSES,
+    FP_OPS,
+    N_COUNTERS
+  };
+
+  HWCounter();
+
+  /**
+   * close the counters
+   */
+  ~HWCounter();
+
+  /**
+   * count the events of the threads which read counters from now on.
+   * \p fp_event is the raw perf event config for FP_OPS, 0 for none
+   */
+  static void enable(unsigned long long fp_event=0);
+
+  /**
+   * @return true when the counters are enabled
+   */
+  static bool enabled()
+  { return _enabled; }
+
+  /**
+   * @return the name of counter \p c
+   */
+  static const char * name(unsigned int c);
+
+  /**
+   * read the current value of all the counters into \p values.
+   * the counters are opened for the calling thread at the first call,
+   * a HWCounter must always be read by the same thread.
+   */
+  void read(long long *values);
+
+private:
+
+  /**
+   * file descriptor of each counter, -1 when it is not available.
+   * the first available one is the group leader
+   */
+  int  _fd[N_COUNTERS];
+
+  /**
+   * the counters are opened
+   */
+  bool _opened;
+
+  /**
+   * number of counters in the group
+   */
+  unsigned int _n_opened;
+
+  /**
+   * open the counters for the calling thread
+   */
+  void _open();
+
+  static bool _enabled;
+
+  static unsigned long long _fp_event;
+
+  // not copyable
+  HWCounter(const HWCounter &);
+  HWCounter & operator= (const HWCounter &);
+};
+
+
+#endif
@@ -6,18 +6,88 @@
 #include <string>
 #include <map>
 
+#include "config.h"
+
+#ifdef HAVE_PTHREAD
+  #include <pthread.h>
+#endif
+
 /**
  *  We need two streams for message output: screen and log file.
+ *
+ *  the message is written to the streams by a background thread, record() only
+ *  appends it to a pending buffer. so a slow log file (i.e. on parallel file system)
+ *  does not stall the solver. the messages recorded while the thread is writing are
+ *  written (and flushed) together in the next turn.
+ *
+ *  only processor 0 attaches streams, messages recorded on other processors are dropped.
  */
 class GENIUS_LOG_STREAM
 {
+public:
+
+  /**
+   * log level of a message, the message is formatted only when its level
+   * is not above the level of log system, see MESSAGE_AT
+   */
+  enum Level { QUIET=0, NORMAL=1, ITERATION=2, VERBOSE=3 };
+
 private:
-  static GENIUS_LOG_STREAM *_instance;
 
   std::map<std::string, std::ostream*> _streams;  // output streams.
   std::map<std::string, std::filebuf*> _bufs;  // file buffers opened in genius.
   std::ostringstream _sstream;
 
+  /**
+   * the level of log system
+   */
+  Level _level;
+
+  /**
+   * recorded messages not yet handed to the writer
+   */
+  std::string _pending;
+
+  /**
+   * when the pending messages exceed this size, record() waits for the writer
+   */
+  static const size_t _max_pending = 1<<20;
+
+  /**
+   * write message to all the streams
+   */
+  void _write(const std::string &msg);
+
+#ifdef HAVE_PTHREAD
+  /**
+   * thread entry, loops until _stop is set and all the messages are written
+   */
+  static void * _thread_main(void *);
+
+  pthread_t       _thread;
+  pthread_mutex_t _mutex;
+
+  /**
+   * signaled when message is recorded or the writer stops
+   */
+  pthread_cond_t  _pending_cond;
+
+  /**
+   * signaled when the writer finished a turn
+   */
+  pthread_cond_t  _written_cond;
+
+  /**
+   * the writer is writing messages
+   */
+  bool _writing;
+
+  /**
+   * stop the thread when all the messages are written
+   */
+  bool _stop;
+#endif
+
 public:
   /**
    * constructor
@@ -52,9 +122,30 @@ public:
   std::ostringstream& log_stream() { return _sstream; }
 
   /**
-   * flush the buffer
+   * hand the message to the writer
    */
   void record();
+
+  /**
+   * wait until all the recorded messages are written to the streams
+   */
+  void flush();
+
+  /**
+   * set the level of log system
+   */
+  void set_level(Level level) { _level = level; }
+
+  /**
+   * @return the level of log system
+   */
+  Level level() const { return _level; }
+
+  /**
+   * @return true when message of \p level will be written
+   */
+  bool enabled(Level level) const
+  { return level <= _level && !_streams.empty(); }
 };
 
 extern GENIUS_LOG_STREAM genius_log;
@@ -62,5 +153,12 @@ extern GENIUS_LOG_STREAM genius_log;
 #define   MESSAGE   genius_log.log_stream()
 #define   RECORD()  genius_log.record()
 
+/**
+ * message stream for the given log level, the message is not formatted at all when the
+ * level is disabled. the for statement keeps the macro safe as the body of if-else.
+ * i.e. MESSAGE_AT(GENIUS_LOG_STREAM::ITERATION) << its << "\n"; RECORD();
+ */
+#define   MESSAGE_AT(level)  for(bool __log_once = genius_log.enabled(level); __log_once; __log_once=false) genius_log.log_stream()
+
 
 #endif
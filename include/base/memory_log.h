@@ -0,0 +1,86 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+//  $Id: memory_log.h,v 1.1 2008/07/09 05:58:16 gdiso Exp $
+
+#ifndef __memory_log_h__
+#define __memory_log_h__
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+
+/**
+ * record the bytes held by each subsystem (mesh, FVM nodes, data storage, PETSc objects ...)
+ * and print them for all the processors side by side.
+ * the subsystems are recorded in the same order on every processor, since they are
+ * collected by the same code path.
+ * the bytes of C++ containers are estimated from their size/capacity, the resident set
+ * size of the process is printed as well for comparison.
+ */
+class MemoryLog
+{
+public:
+
+  /**
+   * constructor, \p label is printed as the title
+   */
+  MemoryLog(const std::string &label);
+
+  /**
+   * add \p bytes to \p subsystem, a new subsystem is appended if not exist
+   */
+  void add(const std::string &subsystem, size_t bytes);
+
+  /**
+   * @return total bytes recorded
+   */
+  size_t total() const;
+
+  /**
+   * print the table of all the processors, must be called in parallel
+   */
+  void print_log() const;
+
+  /**
+   * @return the resident set size of this process in bytes, 0 if unknown
+   */
+  static size_t resident_memory();
+
+  /**
+   * @return the peak resident set size of this process in bytes, 0 if unknown
+   */
+  static size_t peak_resident_memory();
+
+private:
+
+  std::string _label;
+
+  /**
+   * subsystem name -> bytes
+   */
+  std::vector< std::pair<std::string, size_t> > _records;
+};
+
+
+#endif
@@ -19,24 +19,30 @@
 
 
 
+
 #ifndef __perflog_h__
 #define __perflog_h__
 
 // enable log
 //#define ENABLE_PERFORMANCE_LOGGING
 
+// the timeline of the logged events, recorded when it is enabled at run time
+#include "trace_log.h"
+
 
 #ifdef ENABLE_PERFORMANCE_LOGGING
 
 // Local includes
 #include "genius_common.h"
+#include "genius_env.h"
 #include "o_string_stream.h"
+#include "hw_counter.h"
 
 // C++ includes
 #include <string>
-#include <stack>
+#include <vector>
 #include <map>
-#include <sys/time.h>
+#include <time.h>
 
 #ifdef HAVE_LOCALE
 #include <locale>
@@ -47,58 +53,124 @@
 
 
 /**
- * The \p PerfData class simply contains the performance
- * data that is recorded for individual events.
+ * The \p PerfNode class contains the performance data of one
+ * node in the call tree, that is, one event called from a given
+ * chain of enclosing events.
  */
 
 // ------------------------------------------------------------
-// PerfData class definition
-class PerfData
+// PerfNode class definition
+class PerfNode
 {
  public:
 
   /**
    * Constructor.  Initializes data to be empty.
    */
-  PerfData () :
-    tot_time(0.),
+  PerfNode (const unsigned int e=invalid_uint,
+            const unsigned int p=invalid_uint) :
+    event(e),
+    parent(p),
     count(0),
-    open(false),
-    called_recursively(0)
-    {}
+    tot_time(0.),
+    child_time(0.)
+    {
+      for (unsigned int c=0; c<HWCounter::N_COUNTERS; ++c)
+        counters[c] = child_counters[c] = 0;
+    }
 
-  
   /**
-   * Total time spent in this event.
+   * The interned id of the event
    */
-  double tot_time;
+  unsigned int event;
 
   /**
-   * Structure defining when the event
-   * was last started.
+   * The enclosing node in the call tree
    */
-  struct timeval tstart;
+  unsigned int parent;
 
   /**
    * The number of times this event has
-   * been executed
+   * been executed from this node
    */
   unsigned int count;
 
   /**
-   * Flag indicating if we are currently
-   * monitoring this event.  Should only
-   * be true while the event is executing.
+   * Total time spent in this event, including nested events.
+   */
+  double tot_time;
+
+  /**
+   * Time spent in the nested events.
+   */
+  double child_time;
+
+  /**
+   * Hardware counters in this event, including nested events.
+   */
+  long long counters[HWCounter::N_COUNTERS];
+
+  /**
+   * Hardware counters in the nested events.
+   */
+  long long child_counters[HWCounter::N_COUNTERS];
+
+  /**
+   * The nested events as (event id, node) pairs. an event
+   * has only a few children, linear search is fast enough.
+   */
+  std::vector<std::pair<unsigned int, unsigned int> > children;
+
+  /**
+   * @returns the time spent in this event only
+   */
+  double self_time() const
+    { return tot_time - child_time; }
+};
+
+
+
+/**
+ * The call tree and the stack of open events of one thread.
+ * Each thread records into its own log, so no lock is needed.
+ */
+class PerfThreadLog
+{
+ public:
+
+  /**
+   * Constructor, the call tree has only the root node
    */
-  bool open;
+  PerfThreadLog () : tree(1), current(0) {}
 
-  void   start ();
-  void   restart ();
-  double pause ();
-  double stopit ();
-    
-  int called_recursively;
-    
+  /**
+   * The call tree, node 0 is the root
+   */
+  std::vector<PerfNode> tree;
+
+  /**
+   * The open events as (node, start time) pairs
+   */
+  std::vector<std::pair<unsigned int, double> > stack;
+
+  /**
+   * The hardware counters at the start of the open events,
+   * HWCounter::N_COUNTERS values per event. Only the events opened
+   * after the counters are enabled have them, they are on the top of stack,
+   * so the top event has counters when this is not empty.
+   */
+  std::vector<long long> counter_stack;
+
+  /**
+   * The node of the innermost open event, 0 when none is open
+   */
+  unsigned int current;
+
+  /**
+   * @returns the child node of the current node for \p event,
+   * created when it is called for the first time
+   */
+  unsigned int child (const unsigned int event);
 };
 
 
@@ -109,8 +181,20 @@ class PerfData
  * An event is defined by a unique string that functions as
  * a label.  Each time the event is executed data are recorded.
  * This class is particulary useful for finding performance
- * bottlenecks. 
+ * bottlenecks.
  *
+ * The (header, label) pair of an event is interned to an integer
+ * id once, the START_LOG/STOP_LOG macros cache the id in a static
+ * variable at the call site, so a logged event only costs two reads
+ * of the monotonic clock and a short search in the call tree.
+ * Each thread records into its own call tree. The log reports the
+ * exclusive time of each event, the call tree with inclusive time,
+ * and, after \p summarize(), the min/avg/max over all processors.
+ *
+ * When HWCounter is enabled, the hardware counters of the calling
+ * thread are read at push and pop as well, and the log reports the
+ * exclusive cycles, IPC, cache misses and floating point operations
+ * of each event. It costs one system call at each push and pop.
  */
 
 // ------------------------------------------------------------
@@ -134,7 +218,7 @@ class PerfLog
    * Destructor. Calls \p clear() and \p print_log().
    */
   ~PerfLog();
-  
+
   /**
    * Clears all the internal data and returns the
    * data structures to a pristine state.  This function
@@ -154,19 +238,43 @@ class PerfLog
    */
   void enable_logging() { log_events = true; }
 
+  /**
+   * Set the number of threads which may log events.
+   * Events of the threads beyond are not recorded.
+   */
+  void set_n_threads(const unsigned int n);
+
+  /**
+   * @returns the interned id of the event \p label under \p header,
+   * it is allocated when the event is seen for the first time
+   */
+  unsigned int event_id (const std::string &label,
+			 const std::string &header="");
+
+  /**
+   * Push the event \p id onto the stack of calling thread.
+   */
+  void push (const unsigned int id);
+
+  /**
+   * Pop the event \p id off the stack of calling thread.
+   */
+  void pop (const unsigned int id);
 
   /**
    * Push the event \p label onto the stack, pausing any active event.
    */
   void push (const std::string &label,
-	     const std::string &header="");
-  
+	     const std::string &header="")
+    { this->push(this->event_id(label, header)); }
+
   /**
    * Pop the event \p label off the stack, resuming any lower event.
    */
   void pop (const std::string &label,
-	    const std::string &header="");
-  
+	    const std::string &header="")
+    { this->pop(this->event_id(label, header)); }
+
   /**
    * Start monitoring the event named \p label.
    */
@@ -180,7 +288,7 @@ class PerfLog
 		  const std::string &header="");
 
   /**
-   * Suspend monitoring of the event. 
+   * Suspend monitoring of the event.
    */
   void pause_event(const std::string &label,
 		   const std::string &header="");
@@ -190,14 +298,22 @@ class PerfLog
    */
   void restart_event(const std::string &label,
 		     const std::string &header="");
-  
+
+  /**
+   * Merge the exclusive time of each event over all the processors
+   * and print min/avg/max on the first processor. This function
+   * must be called by all the processors, before MPI is finalized.
+   * The per processor log is not printed at destruction afterwards.
+   */
+  void summarize();
+
   /**
    * @returns a string containing:
    * (1) Basic machine information (if first call)
    * (2) The performance log
    */
   std::string get_log() const;
-  
+
   /**
    * @returns a string containing ONLY the information header.
    */
@@ -207,7 +323,12 @@ class PerfLog
    * @returns a string containing ONLY the log information
    */
   std::string get_perf_info() const;
-  
+
+  /**
+   * @returns a string containing the call tree
+   */
+  std::string get_call_tree() const;
+
   /**
    * Print the log.
    */
@@ -218,11 +339,15 @@ class PerfLog
    */
   double get_total_time() const
     {return total_time;}
- 
-   
+
+  /**
+   * @returns the time in seconds of a monotonic clock
+   */
+  static double wall_time ();
+
  private:
 
-  
+
   /**
    * The label for this object.
    */
@@ -234,34 +359,78 @@ class PerfLog
   bool log_events;
 
   /**
-   * The total running time for recorded events.
-   */  
+   * The total running time for recorded events of the master thread.
+   */
   double total_time;
-  
+
   /**
    * The time we were constructed or last cleared.
    */
-  struct timeval tstart;
-  
+  double tstart;
+
   /**
-   * The actual log.
+   * The interned ids of (header, label)
    */
   std::map<std::pair<std::string,
 		     std::string>,
-	   PerfData> log;
+	   unsigned int> event_ids;
 
   /**
-   * A stack to hold the current performance log trace.
+   * The (header, label) of each event id
    */
-  std::stack<PerfData*> log_stack;
-  
+  std::vector<std::pair<std::string,
+			std::string> > events;
+
+  /**
+   * The log of each thread
+   */
+  std::vector<PerfThreadLog> thread_logs;
+
+  /**
+   * Flag indicating if summarize() has been called
+   */
+  bool summarized;
+
   /**
    * Flag indicating if print_log() has been called.
    * This is used to print a header with machine-specific
    * data the first time that print_log() is called.
    */
   static bool called;
-  
+
+  /**
+   * Sum the exclusive time and count of each event over all the threads
+   */
+  void _event_totals(std::vector<double> &self_time,
+		     std::vector<unsigned int> &count) const;
+
+  /**
+   * Sum the exclusive hardware counters of each event over all the threads,
+   * HWCounter::N_COUNTERS values per event
+   */
+  void _counter_totals(std::vector<long long> &counters) const;
+
+  /**
+   * @returns the table of hardware counters, \p counters and \p names
+   * are the totals and (header, label) of each event
+   */
+  std::string _counter_table(const std::vector<long long> &counters,
+			     const std::vector<std::pair<std::string,std::string> > &names) const;
+
+  /**
+   * The hardware counters of each thread
+   */
+  std::vector<HWCounter *> thread_counters;
+
+  /**
+   * Print the subtree of \p node with indent \p level
+   */
+  void _print_tree(const PerfThreadLog &log,
+		   const unsigned int node,
+		   const unsigned int level,
+		   const unsigned int event_col_width,
+		   OStringStream &out) const;
+
   /**
    * Prints a line of 'n' repeated characters 'c'
    * to the output string stream "out".
@@ -274,99 +443,99 @@ class PerfLog
 
 
 // ------------------------------------------------------------
-// PerfData class member funcions
+// PerfThreadLog class member funcions
 inline
-void PerfData::start ()
+unsigned int PerfThreadLog::child (const unsigned int event)
 {
-  this->count++;
-  this->called_recursively++;
-  gettimeofday (&(this->tstart), NULL);
+  std::vector<std::pair<unsigned int, unsigned int> > & children = tree[current].children;
+  for (unsigned int i=0; i<children.size(); ++i)
+    if (children[i].first == event)
+      return children[i].second;
+
+  const unsigned int node = tree.size();
+  tree.push_back(PerfNode(event, current));
+  // tree may be reallocated, look up the children again
+  tree[current].children.push_back(std::make_pair(event, node));
+  return node;
 }
 
 
 
+// ------------------------------------------------------------
+// PerfLog class inline member funcions
 inline
-void PerfData::restart ()
-{
-  gettimeofday (&(this->tstart), NULL);
-}
-
-
-
-inline
-double PerfData::pause ()
-{
-  // save the start times, reuse the structure we have rather than create
-  // a new one.
-  const double
-    tstart_tv_sec  = this->tstart.tv_sec,
-    tstart_tv_usec = this->tstart.tv_usec;
-  
-  gettimeofday (&(this->tstart), NULL);
-  
-  const double elapsed_time = (static_cast<double>(this->tstart.tv_sec  - tstart_tv_sec) +
-			       static_cast<double>(this->tstart.tv_usec - tstart_tv_usec)*1.e-6);      
-  
-  this->tot_time += elapsed_time;
-
-  return elapsed_time;
-}
-
-
-inline
-double PerfData::stopit ()
+double PerfLog::wall_time ()
 {
-  // stopit is just like pause except decriments the 
-  // recursive call counter
-  
-  this->called_recursively--;
-  return this->pause();
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec)*1.e-9;
 }
 
 
 
-// ------------------------------------------------------------
-// PerfLog class inline member funcions
 inline
-void PerfLog::push (const std::string &label,
-		    const std::string &header)
+void PerfLog::push (const unsigned int id)
 {
   if (this->log_events)
     {
-      // Get a reference to the event data to avoid
-      // repeated map lookups
-      PerfData *perf_data = &(log[std::make_pair(header,label)]);
-
-      if (!log_stack.empty())
-	total_time += 
-	  log_stack.top()->pause();
-      
-      perf_data->start();
-      log_stack.push(perf_data);
+      const unsigned int tid = Genius::thread_id();
+      if (tid >= thread_logs.size()) return;
+
+      PerfThreadLog & log = thread_logs[tid];
+      const unsigned int node = log.child(id);
+      if (HWCounter::enabled())
+	{
+	  log.counter_stack.resize(log.counter_stack.size() + HWCounter::N_COUNTERS);
+	  thread_counters[tid]->read(&log.counter_stack[log.counter_stack.size() - HWCounter::N_COUNTERS]);
+	}
+      log.stack.push_back(std::make_pair(node, wall_time()));
+      log.current = node;
     }
 }
 
 
 
 inline
-void PerfLog::pop (const std::string &label,
-		   const std::string &header)
+void PerfLog::pop (const unsigned int id)
 {
   if (this->log_events)
     {
-      assert (!log_stack.empty());
-
-#ifndef NDEBUG
-      PerfData *perf_data = &(log[std::make_pair(header,label)]);
-      assert (perf_data == log_stack.top());
-#endif
-
-      total_time += log_stack.top()->stopit();
-
-      log_stack.pop();
-
-      if (!log_stack.empty())
-	log_stack.top()->restart();
+      const unsigned int tid = Genius::thread_id();
+      if (tid >= thread_logs.size()) return;
+
+      PerfThreadLog & log = thread_logs[tid];
+      assert (!log.stack.empty());
+
+      const std::pair<unsigned int, double> & top = log.stack.back();
+      PerfNode & perf_node = log.tree[top.first];
+      assert (perf_node.event == id);
+
+      const double elapsed_time = wall_time() - top.second;
+      perf_node.count++;
+      perf_node.tot_time += elapsed_time;
+      log.tree[perf_node.parent].child_time += elapsed_time;
+
+      // the counters were read when this event was pushed
+      if (!log.counter_stack.empty())
+	{
+	  long long now[HWCounter::N_COUNTERS];
+	  thread_counters[tid]->read(now);
+	  const long long * start = &log.counter_stack[log.counter_stack.size() - HWCounter::N_COUNTERS];
+	  PerfNode & parent_node = log.tree[perf_node.parent];
+	  for (unsigned int c=0; c<HWCounter::N_COUNTERS; ++c)
+	    {
+	      perf_node.counters[c]         += now[c] - start[c];
+	      parent_node.child_counters[c] += now[c] - start[c];
+	    }
+	  log.counter_stack.resize(log.counter_stack.size() - HWCounter::N_COUNTERS);
+	}
+
+      log.current = perf_node.parent;
+      log.stack.pop_back();
+
+      // the active time is the time of the outermost events
+      if (tid == 0 && log.stack.empty())
+	total_time += elapsed_time;
     }
 }
 
@@ -382,15 +551,21 @@ typedef std::time_put<char, TimeIter> TimePut;
 
 #ifdef ENABLE_PERFORMANCE_LOGGING
 extern PerfLog  perflog;
-#  define START_LOG(a,b)   { perflog.push(a,b); }
-#  define STOP_LOG(a,b)    { perflog.pop(a,b); }
+// the event id is interned once at each call site
+#  define START_LOG(a,b)   { static const unsigned int _perf_event_id = perflog.event_id(a,b); perflog.push(_perf_event_id); tracelog.begin(a,b); }
+#  define STOP_LOG(a,b)    { tracelog.end(a,b); static const unsigned int _perf_event_id = perflog.event_id(a,b); perflog.pop(_perf_event_id); }
+// the label is a run time string, interned at each call, not in the timeline
+#  define START_DYNAMIC_LOG(a,b) { perflog.push(a,b); }
+#  define STOP_DYNAMIC_LOG(a,b)  { perflog.pop(a,b); }
 #  define PAUSE_LOG(a,b)   { deprecated(); }
 #  define RESTART_LOG(a,b) { deprecated{}; }
 
 #else
 
-#  define START_LOG(a,b)   {}
-#  define STOP_LOG(a,b)    {}
+#  define START_LOG(a,b)   { tracelog.begin(a,b); }
+#  define STOP_LOG(a,b)    { tracelog.end(a,b); }
+#  define START_DYNAMIC_LOG(a,b) {}
+#  define STOP_DYNAMIC_LOG(a,b)  {}
 #  define PAUSE_LOG(a,b)   {}
 #  define RESTART_LOG(a,b) {}
 
@@ -0,0 +1,68 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#ifndef __shared_library_h__
+#define __shared_library_h__
+
+#include <string>
+
+
+/**
+ * process wide cache of dynamic loaded libraries (material PMI, user source/waveform shells).
+ *
+ * every library file is opened only once and shared by its users with a reference count,
+ * i.e. all the regions of the same material use one handle. the symbols are resolved once
+ * and cached per library. the libraries are bound immediately (RTLD_NOW) at open time, so the
+ * first Newton iteration does not pay for lazy symbol binding. the open time is recorded in
+ * the performance log under "SharedLibrary".
+ */
+namespace SharedLibrary
+{
+
+  /**
+   * open library file, or increase the reference count of the opened one.
+   * @return the handle, or NULL when the library can not be opened, see error()
+   */
+  void * open(const std::string & filename);
+
+  /**
+   * @return the address of symbol name in library handle, NULL when not found
+   */
+  void * symbol(void * handle, const std::string & name);
+
+  /**
+   * decrease the reference count of library handle, the library is closed when it is not used any more
+   */
+  void close(void * handle);
+
+  /**
+   * @return the message of last failed open
+   */
+  std::string error();
+
+  /**
+   * @return the number of opened library files
+   */
+  unsigned int n_libraries();
+
+}
+
+#endif
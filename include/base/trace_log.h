@@ -0,0 +1,114 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __trace_log_h__
+#define __trace_log_h__
+
+#include <string>
+#include <vector>
+
+
+/**
+ * record the begin/end time of events as a timeline, and write it in
+ * chrome trace event format (json), which can be viewed by chrome://tracing
+ * or perfetto. each processor writes its own file <prefix>.<processor id>.json,
+ * pid is the processor id and tid is the thread id, so the files of all the
+ * processors can be loaded together to see where they wait for each other.
+ *
+ * the recording is off by default, an event costs a single test then.
+ * the event name and category must be string literals, only the pointers are
+ * recorded. START_LOG/STOP_LOG feed this log, so all the logged events appear
+ * in the timeline.
+ */
+class TraceLog
+{
+public:
+
+  TraceLog();
+
+  /**
+   * start recording, the timeline will be written to <prefix>.<processor id>.json.
+   * the clock of all the processors is aligned here, must be called in parallel
+   */
+  void enable(const std::string &prefix);
+
+  /**
+   * @return true when the events are recorded
+   */
+  bool enabled() const
+  { return _enabled; }
+
+  /**
+   * set the number of threads which may record events.
+   * events of the threads beyond are not recorded.
+   */
+  void set_n_threads(unsigned int n);
+
+  /**
+   * the event \p name of \p category begins
+   */
+  void begin(const char *name, const char *category)
+  { if( _enabled ) _record(name, category, 'B'); }
+
+  /**
+   * the event \p name of \p category ends
+   */
+  void end(const char *name, const char *category)
+  { if( _enabled ) _record(name, category, 'E'); }
+
+  /**
+   * write the recorded events to the trace file and stop recording
+   */
+  void write();
+
+private:
+
+  struct Event
+  {
+    const char * name;
+    const char * category;
+    double       time;
+    char         phase;
+  };
+
+  bool        _enabled;
+
+  std::string _prefix;
+
+  /**
+   * the time the clocks are aligned
+   */
+  double      _tstart;
+
+  /**
+   * the events of each thread
+   */
+  std::vector< std::vector<Event> > _thread_events;
+
+  void _record(const char *name, const char *category, char phase);
+};
+
+
+extern TraceLog tracelog;
+
+
+#endif
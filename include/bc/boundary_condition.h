@@ -241,6 +241,33 @@ public:
    */
   void set_boundary_id_to_fvm_node();
 
+  /**
+   * a (region, FVM_Node) entry of a boundary node
+   */
+  struct RegionNode
+  {
+    const Node       * node;
+    SimulationRegion * region;
+    FVM_Node         * fvm_node;
+  };
+
+  /**
+   * flatten the region nodes of all the boundary nodes into one array, which is read by
+   * the boundary assembly instead of searching _bd_fvm_nodes for each node.
+   * should be called after all the fvm nodes are inserted
+   */
+  void build_region_node_table();
+
+  /**
+   * the flattened region nodes, entries of boundary node i (in the order of nodes_begin())
+   * are [region_node_table_begin(i), region_node_table_begin(i+1)), sorted by region type
+   */
+  const std::vector<RegionNode> & region_node_table() const
+  { return _region_node_table; }
+
+  unsigned int region_node_table_begin(unsigned int i) const
+  { return _region_node_table_begin[i]; }
+
 
   typedef std::multimap<SimulationRegionType, std::pair<SimulationRegion *, FVM_Node *> >::iterator region_node_iterator;
 
@@ -723,6 +750,16 @@ public:
    */
   virtual void prepare_for_use() {}
 
+  /**
+   * the dof map of a solver is built, derived class can set up the data depend on dof offsets
+   */
+  virtual void prepare_for_solver() {}
+
+  /**
+   * the solver is destroyed, derived class should clear the data depend on its dof offsets
+   */
+  virtual void clear_solver_data() {}
+
 private:
 
   /**
@@ -758,6 +795,16 @@ private:
    */
   std::map<const Node *, std::multimap<SimulationRegionType, std::pair<SimulationRegion *, FVM_Node *> > > _bd_fvm_nodes;
 
+  /**
+   * the flattened _bd_fvm_nodes in the order of _bd_nodes
+   */
+  std::vector<RegionNode>   _region_node_table;
+
+  /**
+   * offset of the entries of each boundary node in _region_node_table, n_nodes()+1 items
+   */
+  std::vector<unsigned int> _region_node_table_begin;
+
 
   /**
    * the electrode region name, which can be used to specify the
@@ -88,6 +88,17 @@ public:
    */
   virtual std::string boundary_condition_in_string() const;
 
+  /**
+   * build the integration weights of surface integral by the dof offsets of current solver
+   */
+  virtual void prepare_for_solver()
+  { this->build_surface_integral_weights(); }
+
+  /**
+   * clear the integration weights of surface integral
+   */
+  virtual void clear_solver_data();
+
 private:
 
   /**
@@ -95,6 +106,30 @@ private:
    */
   PetscScalar      _psi;
 
+  /**
+   * the surface integral of electric displacement \sum eps*cv_area*(psi_nb-psi)/distance over the
+   * insulator nodes on this processor is linear in psi. its integration weights are stored here
+   * as one sparse row, by local and global offset of the psi dofs
+   */
+  std::vector<PetscInt>     _surface_weight_local_offset;
+  std::vector<PetscInt>     _surface_weight_global_offset;
+  std::vector<PetscScalar>  _surface_weight;
+
+  /**
+   * build the integration weights of surface integral, the dof offsets should be set
+   */
+  void build_surface_integral_weights();
+
+  /**
+   * @return the surface integral of electric displacement on this processor, as dot product of weights and psi
+   */
+  PetscScalar surface_integral(const PetscScalar *x) const;
+
+  /**
+   * add the derivatives of surface integral to psi into row of jacobian matrix
+   */
+  void surface_integral_jacobian(Mat *jac, PetscInt row) const;
+
 public:
 
   //////////////////////////////////////////////////////////////////////////////////////////////
@@ -171,6 +206,16 @@ public:
   //----------------Function and Jacobian evaluate for L2 DDM---------------------//
   //////////////////////////////////////////////////////////////////////////////////
 
+  /**
+   * preprocess Function for DDM2 solver
+   */
+  virtual void DDM2_Function_Preprocess(Vec, std::vector<PetscInt>&, std::vector<PetscInt>&, std::vector<PetscInt>&);
+
+  /**
+   * preprocess Jacobian Matrix of DDM2 solver
+   */
+  virtual void DDM2_Jacobian_Preprocess(Mat *, std::vector<PetscInt>&, std::vector<PetscInt>&, std::vector<PetscInt>&);
+
   /**
    * reserve none zero pattern in petsc matrix.
    */
@@ -195,6 +240,16 @@ public:
   //----------------Function and Jacobian evaluate for EBM   ---------------------//
   //////////////////////////////////////////////////////////////////////////////////
 
+  /**
+   * preprocess Function for EBM3 solver
+   */
+  virtual void EBM3_Function_Preprocess(Vec, std::vector<PetscInt>&, std::vector<PetscInt>&, std::vector<PetscInt>&);
+
+  /**
+   * preprocess Jacobian Matrix of EBM3 solver
+   */
+  virtual void EBM3_Jacobian_Preprocess(Mat *, std::vector<PetscInt>&, std::vector<PetscInt>&, std::vector<PetscInt>&);
+
   /**
    * reserve none zero pattern in petsc matrix.
    */
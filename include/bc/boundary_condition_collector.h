@@ -65,6 +65,8 @@ public:
     _bc_label_to_bc.clear();
     _bd_id_to_bc_index.clear();
     _bc_index_to_bd_id.clear();
+    _periodic_pairs.clear();
+    _periodic_node_map.clear();
   }
 
   /**
@@ -205,6 +207,40 @@ public:
         _bcs[n]->ext_circuit()->ground();
   }
 
+  /**
+   * evaluate the displacement charge of all the electrodes in one pass over the
+   * boundary nodes, and cache it in ExternalCircuit::charge().
+   * should be called after each converged solution
+   */
+  void update_electrode_charge();
+
+  /**
+   * the displacement charge of electrode bc, integrated over the boundary nodes on this processor only.
+   * psi is read from the local solution vector lx (psi at offset 0 of each node) when given,
+   * otherwise from the node data
+   */
+  PetscScalar local_electrode_charge(const BoundaryCondition * bc, const PetscScalar * lx=0) const;
+
+  /**
+   * add the external circuit terms of the electrode equations of all the ohmic, schottky, gate,
+   * simple gate and solder pad electrodes to function vector f, as used by DDM1/DDM2/EBM3 solvers.
+   * the electrode current term is assembled by each boundary condition, since it needs the boundary nodes.
+   * the electrode equations live on the last processor, they are set by one VecSetValues
+   */
+  void electrode_circuit_function(const PetscScalar * x, Vec f, InsertMode &add_value_flag) const;
+
+  /**
+   * add the jacobian of external circuit terms of electrode_circuit_function()
+   */
+  void electrode_circuit_jacobian(Mat *jac, InsertMode &add_value_flag) const;
+
+  /**
+   * @return the node of slave periodic boundary -> the node of master periodic boundary
+   * at the same place. the master node is never a slave node itself
+   */
+  const std::map<const Node *, const Node *> & periodic_node_map() const
+  { return _periodic_node_map; }
+
   /**
    * export all the boundary condition to a file
    */
@@ -251,6 +287,21 @@ private:
    */
   std::map<const std::string, BoundaryCondition * >  _bc_label_to_bc;
 
+  /**
+   * the bc index of master and slave boundary of each periodic pair
+   */
+  std::vector<std::pair<unsigned int, unsigned int> > _periodic_pairs;
+
+  /**
+   * slave node -> master node of periodic boundaries
+   */
+  std::map<const Node *, const Node *> _periodic_node_map;
+
+  /**
+   * pair the nodes of periodic boundaries, should be called after the nodes are added to bcs
+   */
+  void build_periodic_node_map();
+
   /**
    * map boundary id to boundary condition index
    */
@@ -275,6 +326,8 @@ private:
 
   int Set_BC_NeumannBoundary(const Parser::Card &c);
 
+  int Set_BC_PeriodicBoundary(const Parser::Card &c);
+
   int Set_BC_OhmicContact(const Parser::Card &c);
 
   int Set_BC_IF_Metal_Ohmic(const Parser::Card &c);
@@ -0,0 +1,96 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#ifndef __boundary_condition_periodic_h__
+#define __boundary_condition_periodic_h__
+
+
+#include "boundary_condition_neumann.h"
+
+
+
+/**
+ * The Periodic Boundary Condition.
+ * Two boundaries of the same shape, shifted by a translation, are paired. Each node of the
+ * slave boundary is identified with the node of master boundary at the same place, they share
+ * the same dofs in the dof map. As a result, the fluxes of both sides are added into one equation
+ * by all the solvers, and the boundary itself has no equation, just as a Neumann boundary.
+ */
+class PeriodicBC : public NeumannBC
+{
+public:
+
+  /**
+   * constructor, \p pair_label is the label of the other boundary,
+   * \p master is true for the boundary whose nodes keep their dofs
+   */
+  PeriodicBC(SimulationSystem  & system, const std::string & label, const std::string & pair_label, bool master);
+
+  /**
+   * destructor
+   */
+  virtual ~PeriodicBC(){}
+
+  /**
+   * @return boundary condition type
+   */
+  virtual BCType bc_type() const
+    { return PeriodicBoundary; }
+
+  /**
+   * @return boundary condition type in string
+   */
+  virtual std::string bc_type_name() const
+  { return "PeriodicBoundary"; }
+
+  /**
+   * @return the label of the paired boundary
+   */
+  const std::string & pair_label() const
+  { return _pair_label; }
+
+  /**
+   * @return true if the nodes of this boundary keep their own dofs
+   */
+  bool is_master() const
+  { return _master; }
+
+  /**
+   * @return the string which indicates the boundary condition
+   */
+  virtual std::string boundary_condition_in_string() const;
+
+private:
+
+  /**
+   * the label of the paired boundary
+   */
+  std::string _pair_label;
+
+  /**
+   * master flag
+   */
+  bool _master;
+
+};
+
+
+#endif
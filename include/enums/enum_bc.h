@@ -72,6 +72,12 @@ enum BCType
    */
   IF_PML_PML                  = 0x0007,
 
+  /**
+   * Periodic Boundary, paired with another boundary of the same shape.
+   * the nodes of the two boundaries share the same dofs
+   */
+  PeriodicBoundary            = 0x0008,
+
   /**
    * The interface of Electrode region to Insulator region.
    * we assume potential and temperature continuous on this boundary
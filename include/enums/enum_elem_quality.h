@@ -44,7 +44,8 @@ namespace libMeshEnums
 		    ASPECT_RATIO_BETA,
 		    ASPECT_RATIO_GAMMA,
 		    CELL_SIZE,
-		    JACOBIAN};
+		    JACOBIAN,
+		    OBTUSE};
 }
 
 
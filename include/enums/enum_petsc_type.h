@@ -74,6 +74,7 @@ namespace SolverSpecify
                          MUMPS,
                          SuperLU_DIST,
                          GSS,
+                         AUTO_LINEAR_SOLVER,  // selected by problem size at solver setup
                          INVALID_LINEAR_SOLVER};
 
  /**
@@ -100,6 +101,9 @@ namespace SolverSpecify
                            ILUT_PRECOND,
                            LU_PRECOND,
                            PARMS_PRECOND,
+                           FIELDSPLIT_PRECOND,
+                           BORDERED_PRECOND,
+                           MG_PRECOND,
                            USER_PRECOND,
                            SHELL_PRECOND,
                            INVALID_PRECONDITIONER};
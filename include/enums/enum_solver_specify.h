@@ -94,7 +94,9 @@ namespace SolverSpecify
     DampingNo=0,
     DampingBankRose,
     DampingPotential,
-    DampingSuperPotential
+    DampingSuperPotential,
+    DampingModel,
+    DampingAvalanche
   };
 
 
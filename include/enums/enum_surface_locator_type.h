@@ -34,6 +34,7 @@ namespace MeshEnums {
   enum SurfaceLocatorType {
     SurfaceLocator_SPHERE = 0,
     SurfaceLocator_LIST,
+    SurfaceLocator_BVH,
     INVALID_SurfaceLocator};
 }
 
@@ -25,6 +25,8 @@
 // C++ includes
 
 // Local includes
+#include <map>
+
 #include "fe_base.h"
 #include "genius_env.h"
 #include "genius_common.h"
@@ -398,6 +400,38 @@ protected:
    * The last side and last edge we did a reinit on
    */
   unsigned int last_side, last_edge;
+
+  /**
+   * The shape function tables of one element type on the quadrature rule.
+   * the reference values only depend on the element type, the physical
+   * derivatives are kept as well so that the vectors keep their size
+   */
+  struct ShapeTables
+  {
+    std::vector<std::vector<Real> >          phi, dphidxi, dphideta, dphidzeta;
+    std::vector<std::vector<RealGradient> >  dphi;
+    std::vector<std::vector<Real> >          dphidx, dphidy, dphidz;
+    std::vector<std::vector<Real> >          phi_map, dphidxi_map, dphideta_map, dphidzeta_map;
+#ifdef ENABLE_SECOND_DERIVATIVES
+    std::vector<std::vector<RealTensor> >    d2phi;
+    std::vector<std::vector<Real> >          d2phidxi2, d2phidxideta, d2phidxidzeta, d2phideta2, d2phidetadzeta, d2phidzeta2;
+    std::vector<std::vector<Real> >          d2phidx2, d2phidxdy, d2phidxdz, d2phidy2, d2phidydz, d2phidz2;
+    std::vector<std::vector<Real> >          d2phidxi2_map, d2phidxideta_map, d2phidxidzeta_map,
+                                             d2phideta2_map, d2phidetadzeta_map, d2phidzeta2_map;
+#endif
+  };
+
+  /**
+   * The shape function tables on the quadrature rule of the element types other than
+   * the current one, so that a mesh mixing element types does not evaluate the
+   * reference shape functions again at each change of element type
+   */
+  std::map<ElemType, ShapeTables> shape_tables;
+
+  /**
+   * exchange the shape function tables of this object with \p t, O(1)
+   */
+  void swap_shape_tables (ShapeTables & t);
 };
 
 
@@ -104,6 +104,16 @@ class Elem :    public DofObject
    */
   virtual ~Elem();
 
+  /**
+   * Elem objects are allocated from ObjectPool
+   */
+  static void * operator new (size_t size);
+
+  /**
+   * return the memory to ObjectPool
+   */
+  static void operator delete (void * p, size_t size);
+
   /**
    * @returns the \p Point associated with local \p Node \p i.
    */
@@ -825,6 +835,25 @@ class Elem :    public DofObject
    */
   virtual void prepare_for_fvm() {}
 
+  /**
+   * @return the number of Real values which hold the geom information
+   * built by prepare_for_fvm(), used by FVM geometry cache
+   */
+  virtual unsigned int n_fvm_geometry() const
+  { return 0; }
+
+  /**
+   * write the geom information built by prepare_for_fvm() into \p data,
+   * which has n_fvm_geometry() values
+   */
+  virtual void pack_fvm_geometry(Real * ) const {}
+
+  /**
+   * restore the geom information from \p data written by pack_fvm_geometry(),
+   * it replaces the call of prepare_for_fvm()
+   */
+  virtual void unpack_fvm_geometry(const Real * ) {}
+
 
   /**
    * @returns the refinement level of the current element.  If the
@@ -152,6 +152,21 @@ public:
    */
   virtual void prepare_for_fvm();
 
+  /**
+   * @return the number of Real values of geom information
+   */
+  virtual unsigned int n_fvm_geometry() const;
+
+  /**
+   * write geom information into \p data
+   */
+  virtual void pack_fvm_geometry(Real * data) const;
+
+  /**
+   * restore geom information from \p data
+   */
+  virtual void unpack_fvm_geometry(const Real * data);
+
   // For FVM usage, we need more Geom information of a QUAD4
 private:
 
@@ -77,6 +77,16 @@ public:
    */
   virtual ~Node ();
 
+  /**
+   * Node objects are allocated from ObjectPool
+   */
+  static void * operator new (size_t size);
+
+  /**
+   * return the memory to ObjectPool
+   */
+  static void operator delete (void * p, size_t size);
+
   /**
    * Assign to a node from a point
    */
@@ -29,6 +29,8 @@
 #include "hook.h"
 #include <time.h>
 
+class BoundaryCondition;
+
 /**
  * write electrode IV into spice raw file (Ascii format).
  * then user can view the IV curve by some other program.
@@ -38,7 +40,7 @@ class CVHook : public Hook
 {
 
 public:
-  CVHook(SolverBase & solver, const std::string & name, void * file);
+  CVHook(SolverBase & solver, const std::string & name, void * param);
 
   virtual ~CVHook();
 
@@ -96,15 +98,29 @@ private:
  std::vector<std::string>  _gate_electrodes;
 
  /**
-  * the variable value buffer
+  * the iv store columns of sweep voltage and gate charges
+  */
+ unsigned int _vsweep_column;
+ std::vector<unsigned int> _gate_charge_columns;
+
+ /**
+  * evaluate the capacitance by the linear response of the converged solution to the
+  * electrode voltages (hook parameter quasistatic=true), instead of the finite
+  * difference of gate charge between sweep points
+  */
+ bool _quasistatic;
+
+ /**
+  * all the electrodes, the capacitance matrix is indexed by them
   */
- std::vector<double> _vsweep;
- std::vector< std::vector<double> > _gate_charge;
+ std::vector<BoundaryCondition *> _electrodes;
+ unsigned int _sweep_index;
+ std::vector<unsigned int> _gate_index;
 
  /**
-  * the total number of values
+  * the capacitance matrix of each sweep point, row major
   */
- unsigned int _n_values;
+ std::vector< std::vector<double> > _capacitance;
 
 };
 
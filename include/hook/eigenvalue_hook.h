@@ -32,7 +32,12 @@
 
 /**
  * calculate eigen value for jacobian matrix on each nonlinear iteration
- * for check the condition number of device
+ * for check the condition number of device.
+ *
+ * by default only cheap estimates are given: the 1-norm condition number by the LU factor of
+ * the linear solver, and the extreme singular values from the Krylov iterations of an
+ * iterative linear solver. parameter mode=slepc solves the eigen values by SLEPC, which
+ * costs more than the newton step itself.
  */
 class EigenValueHook : public Hook
 {
@@ -80,6 +85,11 @@ private:
    */
   bool            _ddm_solver;
 
+  /**
+   * solve the eigen values by SLEPC
+   */
+  bool            _slepc;
+
   /**
    * iteration count
    */
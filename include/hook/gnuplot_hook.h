@@ -30,7 +30,8 @@
 #include <ctime>
 
 /**
- * write electrode IV into file which can be plotted by gnuplot
+ * write electrode IV into file which can be plotted by gnuplot.
+ * each line is the view of the last row of the iv store of solver
  */
 class GnuplotHook : public Hook
 {
@@ -88,9 +89,9 @@ private:
  std::ofstream   _out;
 
  /**
-  * if we are in mixA mode
+  * the rows of iv store already written
   */
- bool            _mixA;
+ unsigned int    _n_rows_written;
 };
 
 #endif
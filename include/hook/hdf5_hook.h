@@ -0,0 +1,230 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __hdf5_hook_h__
+#define __hdf5_hook_h__
+
+
+#include "hook.h"
+#include <vector>
+#include <string>
+
+#include <hdf5.h>
+
+class FVM_NodeData;
+class SimulationRegion;
+
+/**
+ * write the solutions of a transient or sweep simulation into one HDF5 file.
+ * the mesh is written once, each recorded step appends one row to the
+ * per region, per field datasets, which are chunked by step and compressed.
+ *
+ * file layout:
+ *   /mesh/coordinates        [n_node x 3]       node location in um
+ *   /mesh/elem_type          [n_elem]           libMesh ElemType
+ *   /mesh/elem_region        [n_elem]           subdomain id
+ *   /mesh/elem_offset        [n_elem+1]         offset into connectivity
+ *   /mesh/connectivity       [sum of elem nodes] global node id
+ *   /sweep                   [n_step x 1]       time(ps), voltage(V), current(A) or frequency(Hz)
+ *   /regions/<name>/node_id  [n_region_node]    global node id of each row
+ *   /regions/<name>/<field>  [n_step x n_region_node]
+ *   /regions/<name>/<static> [n_region_node]    Na, Nd, net_doping, mole_x, mole_y
+ *
+ * the static fields (doping and mole fraction) do not change during the solve,
+ * they are written once when the file is created. with delta = true, the step
+ * datasets hold the float bits xor the bits of the previous step as uint32 and
+ * carry the attribute "xor_delta"; a reader xor the rows from step 0 up to the
+ * step it wants. the unchanged high bits become zero, which deflate well.
+ *
+ * the rows of a region are ordered by owner processor, so with parallel HDF5
+ * each processor writes a contiguous slab of every dataset. otherwise the rows
+ * are gathered to the first processor, which writes the file alone.
+ *
+ * HOOK card parameters:
+ *   file     = <string>   output file name, default <out.prefix>.h5
+ *   fields   = <string>   comma separated field names, default all the fields
+ *   decimate = <integer>  only record every n-th solution step, default 1
+ *   compress = <bool>     deflate the field datasets, default true
+ *   delta    = <bool>     store the steps as xor against the previous step, default false
+ *   tstep, vstep, istep   minimal step between two records, as VTK hook
+ */
+class HDF5Hook : public Hook
+{
+
+public:
+  HDF5Hook(SolverBase & solver, const std::string & name, void *);
+
+  virtual ~HDF5Hook();
+
+  /**
+   *   This is executed before the initialization of the solver
+   */
+  virtual void on_init();
+
+  /**
+   *   This is executed previously to each solution step.
+   */
+  virtual void pre_solve();
+
+  /**
+   *  This is executed after each solution step.
+   */
+  virtual void post_solve();
+
+  /**
+   *  This is executed after each (nonlinear) iteration
+   */
+  virtual void post_iteration();
+
+  /**
+   * This is executed after the finalization of the solver
+   */
+  virtual void on_close();
+
+private:
+
+  /**
+   * the output file name
+   */
+  std::string     _filename;
+
+  /**
+   * index of the selected fields in the field table
+   */
+  std::vector<unsigned int> _fields;
+
+  /**
+   * record every _decimate solution step
+   */
+  unsigned int    _decimate;
+
+  /**
+   * deflate the field datasets
+   */
+  bool            _compress;
+
+  /**
+   * store the steps as xor delta
+   */
+  bool            _delta;
+
+  /**
+   * number of solution steps seen
+   */
+  unsigned int    _n_solution;
+
+  /**
+   * number of steps recorded in the file
+   */
+  unsigned int    _n_step;
+
+  /**
+   * last value
+   */
+  double _t_last;
+  double _v_last;
+  double _i_last;
+
+  /**
+   * step
+   */
+  double _t_step;
+  double _v_step;
+  double _i_step;
+
+  /**
+   * if we are in ddm mode
+   */
+  bool            _ddm;
+
+  /**
+   * if we are in mixA mode
+   */
+  bool            _mixA;
+
+  /**
+   * all the processors open the file with parallel HDF5
+   */
+  bool            _parallel_io;
+
+  /**
+   * this processor writes to the file
+   */
+  bool            _writer;
+
+  /**
+   * HDF5 handles
+   */
+  hid_t           _file;
+  hid_t           _dxpl;
+  hid_t           _sweep;
+
+  /**
+   * the field datasets of each region, -1 for the fields not available in the region
+   */
+  std::vector< std::vector<hid_t> > _region_datasets;
+
+  /**
+   * bits of the on processor rows of last step, for xor delta
+   */
+  std::vector< std::vector< std::vector<unsigned int> > > _region_last_rows;
+
+  /**
+   * the row of the first on processor node and total rows of each region
+   */
+  std::vector<hsize_t> _region_offset;
+  std::vector<hsize_t> _region_rows;
+
+  /**
+   * @return true when current solution step should be recorded, and the sweep value
+   */
+  bool _record_step(double &value);
+
+  /**
+   * write the mesh and create the datasets
+   */
+  void _create_file();
+
+  /**
+   * append the current solution to the file
+   */
+  void _write_step(double value);
+
+  /**
+   * write count rows of a 1D or 2D (when step is given) dataset starting at row offset.
+   * in gather mode, data are collected to the first processor before writing.
+   */
+  template <typename T>
+  void _write_rows(hid_t dataset, hid_t mem_type, std::vector<T> &data, hsize_t offset, hsize_t total, int step=-1);
+
+  /**
+   * create a dataset, 2D extendible by step when extendible is true
+   */
+  hid_t _create_dataset(hid_t loc, const std::string &name, hid_t file_type, hsize_t rows, bool extendible);
+
+  /**
+   * the value of field at each on processor node of region, for the solution version
+   */
+  static void _region_field_values(const SimulationRegion * region, unsigned int version, unsigned int field, std::vector<float> &data);
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include <map>
 
 #include "hook.h"
+#include "perf_log.h"
 
 
 /**
@@ -59,8 +60,10 @@ public:
   void on_init()
   {
     std::deque<Hook *>::iterator it;
+    START_LOG("on_init()", "HookList");
     for (it=_hook_list.begin(); it!=_hook_list.end(); ++it)
       (*it)->on_init();
+    STOP_LOG("on_init()", "HookList");
   }
 
   /**
@@ -69,8 +72,10 @@ public:
   void pre_solve()
   {
     std::deque<Hook *>::iterator it;
+    START_LOG("pre_solve()", "HookList");
     for (it=_hook_list.begin(); it!=_hook_list.end(); ++it)
       (*it)->pre_solve();
+    STOP_LOG("pre_solve()", "HookList");
   }
 
   /**
@@ -79,8 +84,10 @@ public:
   void post_solve()
   {
     std::deque<Hook *>::iterator it;
+    START_LOG("post_solve()", "HookList");
     for (it=_hook_list.begin(); it!=_hook_list.end(); ++it)
       (*it)->post_solve();
+    STOP_LOG("post_solve()", "HookList");
   }
 
 
@@ -91,8 +98,10 @@ public:
   void pre_iteration()
   {
     std::deque<Hook *>::iterator it;
+    START_LOG("pre_iteration()", "HookList");
     for (it=_hook_list.begin(); it!=_hook_list.end(); ++it)
       (*it)->pre_iteration();
+    STOP_LOG("pre_iteration()", "HookList");
   }
 
   /**
@@ -102,8 +111,10 @@ public:
   void post_iteration()
   {
     std::deque<Hook *>::iterator it;
+    START_LOG("post_iteration()", "HookList");
     for (it=_hook_list.begin(); it!=_hook_list.end(); ++it)
       (*it)->post_iteration();
+    STOP_LOG("post_iteration()", "HookList");
   }
 
   /**
@@ -113,8 +124,10 @@ public:
   void post_iteration(void * f, void * x, void * y, void * w, bool & change_y, bool &change_w)
   {
     std::deque<Hook *>::iterator it;
+    START_LOG("post_iteration()", "HookList");
     for (it=_hook_list.begin(); it!=_hook_list.end(); ++it)
       (*it)->post_iteration(f, x, y, w, change_y, change_w);
+    STOP_LOG("post_iteration()", "HookList");
   }
 
   /**
@@ -123,8 +136,10 @@ public:
   void on_close()
   {
     std::deque<Hook *>::iterator it;
+    START_LOG("on_close()", "HookList");
     for (it=_hook_list.begin(); it!=_hook_list.end(); ++it)
       (*it)->on_close();
+    STOP_LOG("on_close()", "HookList");
 
     this->clear();
   }
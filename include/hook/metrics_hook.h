@@ -0,0 +1,55 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __metrics_hook_h__
+#define __metrics_hook_h__
+
+
+#include "hook.h"
+
+
+/**
+ * expose the solver progress as prometheus metrics, for monitoring many jobs.
+ * the metrics are collected from the solver statistics records by MetricsServer,
+ * which keeps serving after this hook is unloaded, until genius exits.
+ *
+ * HOOK card parameters:
+ *   port     = <integer>  http port of the /metrics endpoint, default 9464.
+ *                         0 for no endpoint, i.e. push only
+ *   bind     = <string>   listen address, default 0.0.0.0
+ *   push     = <string>   push gateway as host:port, default none
+ *   interval = <real>     push interval in second, default 15
+ *   job      = <string>   run label of the metrics and job name at the push gateway,
+ *                         default the input file name
+ */
+class MetricsHook : public Hook
+{
+
+public:
+  MetricsHook(SolverBase & solver, const std::string & name, void * param);
+
+  virtual ~MetricsHook()
+  {}
+
+};
+
+#endif
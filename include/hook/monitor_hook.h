@@ -24,12 +24,15 @@
 #define __monitor_hook_h__
 
 
+#include "genius_common.h"
 #include "hook.h"
 #include <ctime>
 #include <vector>
 #include <string>
+#include <fstream>
 
 class MeshBase;
+class SimulationRegion;
 
 #ifdef HAVE_VTK
 class vtkUnstructuredGrid;
@@ -38,6 +41,20 @@ class vtkUnstructuredGrid;
 /**
  * write vtk file for each nonlinear iteration
  * for check the convergence histroy
+ *
+ * the full dump gathers the whole mesh and solution to the first processor,
+ * which is not usable on large mesh. the sample mode reports, for each iteration,
+ * the norm of residual and Newton update of each equation in each region and
+ * the top K residual nodes of each equation. only the norms and the K nodes of
+ * each processor are reduced. optionally, the processor owns the worst node of
+ * an equation writes a small legacy vtk file of the elements around it.
+ *
+ * HOOK card parameters:
+ *   mode  = vtk | sample  full vtk dump (default) or sampled report
+ *   topk  = <integer>     residual nodes reported for each equation, default 10
+ *   patch = <integer>     element layers around the worst node of each equation written to
+ *                         <out.prefix>.monitor.<solution>.<iteration>.<equation>.vtk, default 0 (none)
+ *   file  = <string>      report file of sample mode, default <out.prefix>.monitor.log
  */
 class MonitorHook : public Hook
 {
@@ -95,6 +112,44 @@ private:
    */
   unsigned int solution_count;
 
+  /**
+   * sample mode instead of full vtk dump
+   */
+  bool            _sample;
+
+  /**
+   * number of worst residual nodes reported for each equation
+   */
+  unsigned int    _topk;
+
+  /**
+   * element layers of the vtk patch around the worst node, 0 for none
+   */
+  unsigned int    _patch;
+
+  /**
+   * report of sample mode, only opened on the first processor
+   */
+  std::string     _report_file;
+  std::ofstream   _report;
+
+  /**
+   * the (equation, dof offset in node) of each equation solved at the nodes of region
+   */
+  void _node_equations(const SimulationRegion * region, std::vector<std::pair<unsigned int, unsigned int> > &equations) const;
+
+  /**
+   * report norms and worst residual nodes of this iteration
+   */
+  void _sample_iteration(void * f, void * x, void * dx);
+
+  /**
+   * write the elements within _patch layers around node of region, with the
+   * residual, solution and update of each equation at the on processor nodes
+   */
+  void _write_patch(const SimulationRegion * region, unsigned int node, unsigned int equation,
+                    const PetscScalar *ff, const PetscScalar *xx, const PetscScalar *dxx, PetscInt start) const;
+
 private:
 
   const MeshBase & mesh;
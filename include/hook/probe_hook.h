@@ -26,9 +26,24 @@
 
 #include "hook.h"
 #include <ctime>
+#include <vector>
+#include <fstream>
+
+class Elem;
+class FVM_NodeData;
 
 /**
- * write electrode IV into file which can be plotted by probe
+ * write the potential and carrier density at probe points after each solve.
+ *
+ * the probe points are located in the mesh once in on_init by the point locator,
+ * the element and the linear shape function weights of its nodes are cached.
+ * after each solve, every processor sums the weighted values of its on processor
+ * nodes for all the probes in one pass, and a single reduction collects them.
+ *
+ * HOOK card parameters:
+ *   x, y, z   = <real>    one probe point in um
+ *   points    = <string>  more probe points, "x,y,z; x,y,z; ..." in um
+ *   pointfile = <string>  text file of probe points, "x y z" in um per line
  */
 class ProbeHook : public Hook
 {
@@ -69,13 +84,30 @@ private:
  SolverBase*     _p_solver;
 
  /**
-  * probe point
+  * probe points
+  */
+ std::vector<Point> _points;
+
+ /**
+  * the element contains each probe point, NULL when the point is out of mesh
   */
- Point _pp;
+ std::vector<const Elem *> _elems;
 
- const FVM_Node* _p_fvm_node;
+ /**
+  * the weights of probe k are [_weight_offset[k], _weight_offset[k+1])
+  * of _weights and _node_data
+  */
+ std::vector<unsigned int> _weight_offset;
 
- unsigned int    _min_loc;
+ /**
+  * shape function weight of each element node at the probe point
+  */
+ std::vector<Real> _weights;
+
+ /**
+  * node data of each element node, NULL when the node is not on this processor
+  */
+ std::vector<const FVM_NodeData *> _node_data;
 
  /**
   * the output file name
@@ -87,7 +119,15 @@ private:
   */
  std::ofstream   _out;
 
+ /**
+  * read probe points from string "x,y,z; x,y,z"
+  */
+ void _parse_points(const std::string &str);
 
+ /**
+  * read probe points from text file
+  */
+ void _read_points(const std::string &file);
 };
 
 #endif
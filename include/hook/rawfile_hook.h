@@ -30,7 +30,8 @@
 #include <time.h>
 
 /**
- * write electrode IV into spice raw file (Ascii format).
+ * write electrode IV into spice raw file (Ascii format, or binary with SOLVE iv.binary).
+ * the values are taken from the iv store of solver when the solver finishes.
  * then user can view the IV curve by some other program.
  * ( can we do real time display here? )
  */
@@ -89,26 +90,6 @@ private:
   */
  std::ofstream   _out;
 
- /**
-  * if we are in mixA mode
-  */
- bool            _mixA;
-
- /**
-  * the variable name buffer
-  */
- std::vector<std::pair<std::string, std::string> >  _variables;
-
- /**
-  * the variable value buffer
-  */
- std::vector< std::vector<double> > _values;
-
- /**
-  * the total number of values
-  */
- unsigned int _n_values;
-
 };
 
 #endif
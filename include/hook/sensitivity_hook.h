@@ -0,0 +1,132 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __sensitivity_hook_h__
+#define __sensitivity_hook_h__
+
+
+#include "hook.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+class BoundaryCondition;
+
+/**
+ * write the sensitivity of electrode currents to PMI parameters at each converged
+ * steadystate/dcsweep point, for device calibration. the derivatives are evaluated by
+ * the adjoint method with the jacobian of the converged point, see DDMSolverBase::current_sensitivity.
+ *
+ * for random dopant fluctuation, the impedance field dI/dN of each semiconductor node is
+ * written to <out_prefix>.ifm<step>, and the current variance is estimated from it by the Poisson
+ * statistics of dopant numbers in each control volume,
+ *   var(I) = sum_i (dI/dN_i)^2 * (Nd_i+Na_i)/volume_i
+ * the estimate can be checked against full solves of random doping instances, sharing the mesh,
+ * jacobian structure and linear solver, see DDMSolverBase::doping_instance_solve.
+ */
+class SensitivityHook : public Hook
+{
+
+public:
+  SensitivityHook(SolverBase & solver, const std::string & name, void * param);
+
+  virtual ~SensitivityHook();
+
+  /**
+   *   This is executed before the initialization of the solver
+   */
+  virtual void on_init();
+
+  /**
+   *   This is executed previously to each solution step.
+   */
+  virtual void pre_solve();
+
+  /**
+   *  This is executed after each solution step.
+   */
+  virtual void post_solve();
+
+  /**
+   *  This is executed after each (nonlinear) iteration
+   */
+  virtual void post_iteration();
+
+  /**
+   * This is executed after the finalization of the solver
+   */
+  virtual void on_close();
+
+private:
+
+  /**
+   * the region and PMI type of the parameters
+   */
+  std::string     _region;
+  std::string     _pmi;
+
+  /**
+   * the parameter names
+   */
+  std::vector<std::string>  _parameters;
+
+  /**
+   * the electrodes, all the electrodes when not given
+   */
+  std::vector<std::string>  _electrode_labels;
+  std::vector<BoundaryCondition *> _electrodes;
+
+  /**
+   * evaluate the impedance field of doping
+   */
+  bool            _doping;
+
+  /**
+   * number of random doping instances solved at each point, and the seed of them
+   */
+  unsigned int    _instances;
+  unsigned int    _seed;
+
+  /**
+   * the index of solution step
+   */
+  unsigned int    _step;
+
+  /**
+   * the output file
+   */
+  std::string     _sens_file;
+  std::ofstream   _out;
+
+  /**
+   * false when the solver or the parameters are not supported
+   */
+  bool            _enabled;
+
+  /**
+   * the impedance field of doping at this step, write it to file and estimate the current deviation
+   */
+  void _doping_sensitivity(std::vector<double> & sigma_ifm, std::vector<double> & sigma_instance);
+
+};
+
+#endif
@@ -30,15 +30,24 @@
 
 
 /**
- * Executes a shell command.
+ * Executes a shell command at each stage of the solver, with the stage as
+ * argument: -init, -pre, -post, -postit or -close.
+ *
+ * by default the command is handed to AsyncExec and the solver does not wait
+ * for it. the commands of one hook keep their order only with jobs = 1.
+ *
+ * HOOK card parameters:
+ *   command = <string>   the shell command
+ *   async   = <bool>     run the command without blocking the solver, default true
+ *   jobs    = <integer>  max number of commands running at the same time, 0 for no limit.
+ *                        the limit is shared by all the hooks, default 0
+ *   wait    = <bool>     wait for all the commands when the solver finishes, default false
  */
 class ShellHook : public Hook
 {
 
 public:
-  ShellHook(SolverBase & solver, const std::string & name, void * command)
-  : Hook(solver, name), _command((const char *)command)
-  {}
+  ShellHook(SolverBase & solver, const std::string & name, void * param);
 
   virtual ~ShellHook()
   {}
@@ -75,6 +84,21 @@ private:
    */
  std::string _command;
 
+  /**
+   * run the command in background
+   */
+  bool _async;
+
+  /**
+   * wait for the background commands in on_close
+   */
+  bool _wait;
+
+  /**
+   * execute the command with the stage argument on the first processor
+   */
+  void _execute(const std::string &stage);
+
 };
 
 #endif
@@ -28,9 +28,26 @@
 #include <ctime>
 #include <vector>
 #include <string>
+#include <map>
 
 /**
- * export specified variable at every step, stop the simulation when the value exceed given threshold
+ * export specified variable at every step, stop the simulation when the value exceed given threshold.
+ *
+ * besides the field thresholds, stop targets can be given as a ';' separated list,
+ * the sweep or transient loop stops cleanly after the step where any target is hit:
+ *   string<stop>="I(drain) > 1e-6; dIdV(drain) > 1e-2; Q(drain) saturate 1e-3"
+ *
+ * a target is <quantity> <op> <value>, with op one of > >= < <=, or
+ * <quantity> saturate <rtol>, hit when the relative change of the quantity per
+ * step stays below rtol for <settle> steps in a row. the quantity can be wrapped
+ * by abs(). quantities:
+ *   V(electrode)     electrode potential [V]
+ *   I(electrode)     electrode current [A]
+ *   dIdV(electrode)  differential conductance between two steps [A/V], i.e. breakdown
+ *   Q(electrode)     charge collected by the electrode since the solve begins [C]
+ *   Emax             max electric field in region/box [V/cm]
+ *   Tmax             max lattice temperature in region/box [K]
+ *   t                transient clock [ps]
  */
 class ThresholdHook : public Hook
 {
@@ -104,6 +121,72 @@ private:
 
   bool _stop_when_violate_threshold;
 
+  /**
+   * quantity of a stop target
+   */
+  enum Quantity {VOLTAGE, CURRENT, DIDV, CHARGE, EMAX, TMAX, CLOCK};
+
+  /**
+   * compare operator of a stop target
+   */
+  enum Compare {GT, GE, LT, LE, SATURATE};
+
+  struct StopTarget
+  {
+    std::string  text;
+    Quantity     quantity;
+    std::string  electrode;
+    bool         absolute;
+    Compare      compare;
+    double       value;
+
+    /**
+     * electrode state of the last step, for dI/dV and charge
+     */
+    bool         has_last;
+    double       last_V;
+    double       last_I;
+    double       last_clock;
+    double       charge;
+
+    /**
+     * the last value and the steps it has been settled, for saturate
+     */
+    bool         has_last_value;
+    double       last_value;
+    unsigned int settled;
+  };
+
+  std::vector<StopTarget> _stop_targets;
+
+  /**
+   * steps a quantity must stay settled
+   */
+  unsigned int _settle;
+
+  /**
+   * export the solution when stopped by a target
+   */
+  bool _export_on_stop;
+
+  /**
+   * parse one target, @return false on syntax error
+   */
+  bool _parse_target(const std::string &text, StopTarget &target);
+
+  /**
+   * evaluate the targets, @return the index of the target hit, or -1
+   */
+  int _check_stop_targets();
+
+  /**
+   * the max field or temperature in region/box, and its location.
+   * @return false if no cell/node in region/box
+   */
+  bool _max_E(Real &E, Point &location);
+
+  bool _max_T(Real &T, Point &location);
+
 
   /**
    * the output file name
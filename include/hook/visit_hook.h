@@ -26,6 +26,10 @@
 
 
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "hook.h"
 
 // visit include
@@ -44,6 +48,17 @@ enum VisitState
 /**
  * Use LLNL Visit to do real time display
  * NOTE since we can only connect to one visit process, we set many member static here.
+ *
+ * the hook never waits for visit: the connection is polled without blocking after
+ * each nonlinear iteration and solution step, and the plots are refreshed at most
+ * once per update interval. each region is given to visit as a mesh whose nodes
+ * follow the order of the region node data block, so the node based variables
+ * are handed to visit without copy (unless they need unit conversion).
+ *
+ * HOOK card parameters:
+ *   launch   = <bool>   fork a visit process which connects to genius, default true
+ *   wait     = <bool>   wait for visit to connect at start and to exit at the end, default false
+ *   interval = <real>   minimal wall time in second between two plot updates, default 0
  */
 class VisitHook : public Hook
 {
@@ -53,7 +68,7 @@ public:
   /**
    * constructor.
    */
-  VisitHook(SolverBase & solver, const std::string & name, void * dummy);
+  VisitHook(SolverBase & solver, const std::string & name, void * param);
 
   /**
    * destructor.
@@ -89,10 +104,20 @@ public:
 
 public:
 
+  /**
+   * open the listen socket and write the .sim file, launch visit if required
+   */
   void connect_to_visit();
 
-  void comm_to_visit();
+  /**
+   * accept the connection and process the pending commands of visit, never blocks.
+   * when \p update is true, ask visit to refresh the plots
+   */
+  void comm_to_visit(bool update);
 
+  /**
+   * wait until visit closes the connection
+   */
   void disconnect_to_visit();
 
 public:
@@ -110,6 +135,26 @@ public:
 
 private:
 
+  /**
+   * fork a visit process
+   */
+  bool _launch;
+
+  /**
+   * wait for visit at start and end
+   */
+  bool _wait;
+
+  /**
+   * minimal wall time between two plot updates
+   */
+  double _interval;
+
+  /**
+   * wall time of last plot update
+   */
+  double _last_update;
+
   /**
    * the visit sim state
    */
@@ -135,7 +180,30 @@ private:
   */
  static unsigned int _n_values;
 
- static std::map<unsigned int, int> global_id_to_index;
+ /**
+  * the visit mesh of a region on this processor. node i is the node with
+  * node_data()->offset() == i, the same order as the region node data block
+  */
+ struct RegionMesh
+ {
+   std::vector<float> x;
+   std::vector<float> y;
+   std::vector<float> z;
+   std::vector<int>   connectivity;
+   int                n_zones;
+ };
+
+ static std::vector<RegionMesh> _region_meshes;
+
+ /**
+  * copy of the variables which are not stored in output unit
+  */
+ static std::map<std::string, std::vector<double> > _scaled_values;
+
+ /**
+  * build the visit mesh of each region
+  */
+ static void build_region_meshes();
 
  /**
   * get the cell type that can be recognized by visit
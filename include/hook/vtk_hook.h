@@ -72,6 +72,11 @@ private:
    */
   std::string     _vtk_prefix;
 
+  /**
+   * the solution fields to be written, separated by comma. all the fields when empty
+   */
+  std::string     _fields;
+
   /**
   * count
   */
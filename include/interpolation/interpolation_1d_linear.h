@@ -8,7 +8,7 @@
 class Interpolation1D_Linear   : public InterpolationBase
 {
 public:
-  Interpolation1D_Linear() {}
+  Interpolation1D_Linear() : _inv_h(0.0) {}
 
   ~Interpolation1D_Linear()
   { this->clear(); }
@@ -39,8 +39,25 @@ public:
    */
   double get_interpolated_value(const Point & point, int group) const;
 
+  /**
+   * get interpolated values with GROUP_ID group at several points.
+   * the interval of each point is searched from the one of previous point,
+   * which is O(1) when the points are in order
+   */
+  virtual void interpolate_points(const std::vector<Point> & points, int group, std::vector<double> & values) const;
+
 private:
 
+  /**
+   * evaluate the interpolation of group data y in interval ival at tval
+   */
+  double _evaluate(int ival, double tval, int group, const std::vector<double> & y) const;
+
+  /**
+   * 1/h when the coordinate is uniform with spacing h, otherwise 0
+   */
+  double _inv_h;
+
   /**
    * the coordinate should be sorted: coordinate[n+1]>coordinate[n]
    */
@@ -22,7 +22,8 @@ public:
   void clear();
 
   /**
-   * build internal data structure
+   * build internal data structure, the spline coefficients of the cells
+   * are fitted by threads
    */
   void setup(int group);
 
@@ -21,7 +21,8 @@ public:
   void clear();
 
   /**
-   * build internal data structure
+   * build internal data structure, the scattered data is released after
+   * the delaunay diagram is built
    */
   void setup(int group);
 
@@ -41,6 +42,18 @@ public:
    */
   double get_interpolated_value(const Point & point, int group) const;
 
+  /**
+   * get interpolated values at several points by threads, each thread starts
+   * the triangle search from the triangle of its previous point
+   */
+  virtual void interpolate_points(const std::vector<Point> & points, int group, std::vector<double> & values) const;
+
+  /**
+   * the point search caches the last triangle in the delaunay diagram
+   */
+  virtual bool thread_safe() const
+  { return false; }
+
 private:
 
 
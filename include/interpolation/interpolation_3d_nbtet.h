@@ -2,6 +2,7 @@
 #define __interpolation_3d_nb_h__
 
 #include <vector>
+#include <map>
 #include "ANN/ANN.h"
 
 #include "interpolation_base.h"
@@ -26,6 +27,9 @@ public:
 
   Point getPointCoord(unsigned int i) const;
 
+  const std::vector<Point> & points() const
+  { return _pts; }
+
   long size() const;
 
 private:
@@ -46,6 +50,8 @@ class Interpolation3D_nbtet : public InterpolationBase
 public:
   Interpolation3D_nbtet ();
 
+  ~Interpolation3D_nbtet ();
+
   /**
    * clear internal interpolation data
    */
@@ -62,8 +68,7 @@ public:
   virtual void broadcast(unsigned int root=0);
 
   /**
-   * add the data with GROUP_ID group in 2D for interpolation
-   * NOTE: only the first coordinate of point is used.
+   * add the data with GROUP_ID group in 3D for interpolation
    */
   void add_scatter_data(const Point & point, int group, double value);
 
@@ -72,9 +77,51 @@ public:
    */
   double get_interpolated_value(const Point & point, int group) const;
 
+  /**
+   * get interpolated values of several groups in location point.
+   * the enclosing tetrahedron is searched once for the groups sharing the same kd-tree
+   */
+  virtual void get_interpolated_values(const Point & point, const std::vector<int> & groups, std::vector<double> & values) const;
+
+  /**
+   * ANN search uses global variables, not thread safe
+   */
+  virtual bool thread_safe() const
+  { return false; }
+
 private:
-  ANNSession _ann;
-  std::vector<double> _field;
+
+  /**
+   * scatter points of each group, before setup
+   */
+  std::map<int, std::vector<Point> >  _points;
+
+  /**
+   * scaled value of each group
+   */
+  std::map<int, std::vector<double> > _field;
+
+  /**
+   * the kd-trees, groups with the same scatter points share one tree
+   */
+  std::vector<ANNSession *>           _sessions;
+
+  /**
+   * the kd-tree of each group
+   */
+  std::map<int, unsigned int>         _group_session;
+
+  /**
+   * find the tetrahedron (or the nearest point) around pt.
+   * the interpolated value is sum(numerator[i]*f[index[i]])/denominator
+   * @return false when interpolation failed
+   */
+  bool _locate(const ANNSession &ann, const Point & pt, int index[4], double numerator[4], double &denominator) const;
+
+  /**
+   * @return interpolated value of group with the located tetrahedron
+   */
+  double _value(int group, const int index[4], const double numerator[4], double denominator) const;
 
 };
 
@@ -0,0 +1,139 @@
+#ifndef __interpolation_3d_shepard_h__
+#define __interpolation_3d_shepard_h__
+
+#include <vector>
+#include <map>
+
+#include "interpolation_base.h"
+
+/**
+ * 3D Interpolation by modified Shepard method, the native replacement of qshep3d.f90.
+ *
+ * each scattered point k carries a quadratic nodal function Q_k, which interpolates f_k
+ * and fits the values of its NQ nearest points by weighted least squares.
+ * the value at point p is the weighted mean of Q_k(p) over the NW nearest points of p,
+ * with weight ((R-d_k)/(R*d_k))^2, R is slightly larger than the distance to the farthest one.
+ *
+ * the nearest points are searched by a kd-tree, which is read only after setup, so the
+ * nodal functions are fitted by threads and the interpolator is thread safe.
+ */
+class Interpolation3D_Shepard : public InterpolationBase
+{
+public:
+  Interpolation3D_Shepard ();
+
+  ~Interpolation3D_Shepard ();
+
+  /**
+   * clear internal interpolation data
+   */
+  void clear();
+
+  /**
+   * build internal data structure
+   */
+  void setup(int group);
+
+  /**
+   * broadcast data to all the processor
+   */
+  virtual void broadcast(unsigned int root=0);
+
+  /**
+   * add the data with GROUP_ID group in 3D for interpolation
+   */
+  void add_scatter_data(const Point & point, int group, double value);
+
+  /**
+   * get interpolated value with GROUP_ID group in location point
+   */
+  double get_interpolated_value(const Point & point, int group) const;
+
+  /**
+   * get interpolated values of several groups in location point.
+   * the nearest points are searched once for the groups sharing the same kd-tree
+   */
+  virtual void get_interpolated_values(const Point & point, const std::vector<int> & groups, std::vector<double> & values) const;
+
+private:
+
+  /**
+   * a balanced kd-tree stored in an index array, the root of range [lo, hi) is at (lo+hi)/2
+   */
+  class PointTree
+  {
+  public:
+    PointTree(const std::vector<Point> & points);
+
+    const std::vector<Point> & points() const
+    { return _points; }
+
+    /**
+     * the k nearest points of p as (squared distance, index) pairs, sorted by distance
+     */
+    void nearest(const Point & p, unsigned int k, std::vector<std::pair<double, unsigned int> > & result) const;
+
+  private:
+
+    void _build(unsigned int lo, unsigned int hi);
+
+    void _search(const Point & p, unsigned int k, unsigned int lo, unsigned int hi,
+                 std::vector<std::pair<double, unsigned int> > & heap) const;
+
+    std::vector<Point>          _points;
+    std::vector<unsigned int>   _index;
+    std::vector<unsigned char>  _split;
+  };
+
+  /**
+   * number of points in the least squares fit of nodal function
+   */
+  static const unsigned int _nq = 17;
+
+  /**
+   * number of points weighted in the interpolation
+   */
+  static const unsigned int _nw = 32;
+
+  /**
+   * scatter points of each group, before setup
+   */
+  std::map<int, std::vector<Point> >  _points;
+
+  /**
+   * scaled value of each group
+   */
+  std::map<int, std::vector<double> > _field;
+
+  /**
+   * the gradient and hessian coefficients of nodal functions of each group, 9 per point
+   */
+  std::map<int, std::vector<double> > _coeffs;
+
+  /**
+   * record the min/max value of the field. the interpolated value should be limited by this value
+   */
+  std::map<int, std::pair<double, double> > _field_limit;
+
+  /**
+   * the kd-trees, groups with the same scatter points share one tree
+   */
+  std::vector<PointTree *>            _trees;
+
+  /**
+   * the kd-tree of each group
+   */
+  std::map<int, unsigned int>         _group_tree;
+
+  /**
+   * fit the nodal functions of all the points
+   */
+  static void _fit(const PointTree & tree, const std::vector<double> & f, std::vector<double> & coeffs);
+
+  /**
+   * @return interpolated value of group at p with the nearest points nn
+   */
+  double _value(int group, const PointTree & tree, const Point & p, const std::vector<std::pair<double, unsigned int> > & nn) const;
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <cassert>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "point.h"
 
@@ -56,6 +57,16 @@ public:
    */
   virtual void setup(int /* group */)=0;
 
+  /**
+   * build internal data structure of several groups at once.
+   * the derived class may share data between groups or build them in parallel
+   */
+  virtual void setup(const std::vector<int> & groups)
+  {
+    for(unsigned int n=0; n<groups.size(); ++n)
+      this->setup(groups[n]);
+  }
+
   /**
    * virtual function to set the options of Interpolation.
    * each dirived class can override it
@@ -67,6 +78,37 @@ public:
    */
   virtual double get_interpolated_value(const Point & point, int group)const=0;
 
+  /**
+   * get interpolated values of several groups in location point.
+   * the derived class may locate the point once for all the groups
+   */
+  virtual void get_interpolated_values(const Point & point, const std::vector<int> & groups, std::vector<double> & values) const
+  {
+    values.resize(groups.size());
+    for(unsigned int n=0; n<groups.size(); ++n)
+      values[n] = this->get_interpolated_value(point, groups[n]);
+  }
+
+  /**
+   * @return true when get_interpolated_value can be called from several threads at once
+   */
+  virtual bool thread_safe() const
+  { return true; }
+
+  /**
+   * get interpolated values with GROUP_ID group at several points.
+   * the points are shared by threads when the interpolator is thread safe
+   */
+  virtual void interpolate_points(const std::vector<Point> & points, int group, std::vector<double> & values) const;
+
+  /**
+   * tiled mode: only fit the scattered data near the given boxes, i.e. the bounding
+   * boxes of the target mesh elements. the interpolated value is only valid inside the boxes.
+   * it should be called before setup, now only the 2D interpolators make use of it.
+   */
+  void set_target_boxes(const std::vector<std::pair<Point, Point> > & boxes)
+  { _target_boxes = boxes; }
+
   /**
    * InterpolationType, should support linear (for potential, etc) and asinh (doping concentration and carrier density)
    */
@@ -85,6 +127,30 @@ public:
 
 protected:
 
+  /**
+   * the target boxes of tiled mode, in the coordinates of the scattered data
+   */
+  std::vector<std::pair<Point, Point> > _target_boxes;
+
+  /**
+   * mark the 2D scattered points (x, y) which lie in the tiles near the target boxes.
+   * all the points are kept when no target box is given
+   */
+  void _near_target_boxes(const std::vector<double> & x, const std::vector<double> & y, std::vector<bool> & keep) const;
+
+  /**
+   * @return 1/h when the sorted 1D coordinate \p t has uniform spacing h, otherwise 0
+   */
+  static double _uniform_inv_spacing(const std::vector<double> & t);
+
+  /**
+   * @return the interval i of the sorted 1D coordinate \p t with t[i] <= x < t[i+1], clamped to [0, n-2].
+   * the interval \p hint of last query (or -1) and its successor are tried first, since the queries are
+   * usually in order. when \p inv_h is not 0, t is uniform and the interval is computed directly,
+   * otherwise it falls back to bisection
+   */
+  static int _locate_interval(const std::vector<double> & t, double x, int hint, double inv_h);
+
   std::map<int, InterpolationType> _interpolation_type;
 
   std::map<std::string, int> _variable_group_map;
@@ -50,6 +50,35 @@ class FVM_NodeData;
 // It links the main solver and material. The solver load required parameters from
 // re-implemented virtual functions.
 
+/**
+ * PMI_Context, the evaluation context of PMI calls: current point, its node data and time.
+ * the material keeps one context for each thread, so concurrent assembly loops can
+ * evaluate the PMI of one region without sharing any mutable state
+ */
+struct PMI_Context
+{
+  /**
+   * current point
+   */
+  const Point         *  point;
+
+  /**
+   * data of current node
+   */
+  const FVM_NodeData  *  node_data;
+
+  /**
+   * current time
+   */
+  PetscScalar            time;
+
+  PMI_Context() : point(0), node_data(0), time(0.0) {}
+
+  PMI_Context(const Point* _point, const FVM_NodeData* _node_data, PetscScalar _time)
+  : point(_point), node_data(_node_data), time(_time) {}
+};
+
+
 /**
  * PMI_Environment, this structure will be passed to PMI class when initializing.
  * It contains interface information for linking main genius code to each PMI class
@@ -80,6 +109,11 @@ struct PMI_Environment
    */
   const std::map<std::string, SimulationVariable>  ** pp_variables;
 
+  /**
+   * the evaluation context of each thread, NULL for PMI which only use the "pointer to pointer" image
+   */
+  std::vector<PMI_Context> * p_contexts;
+
   /**
    *  the basic length unit
    */
@@ -110,8 +144,10 @@ struct PMI_Environment
    */
   PMI_Environment(const Point** point, const FVM_NodeData **node_data, const PetscScalar *time,
                   const std::map<std::string, SimulationVariable> ** variables,
-                  double _m_, double _s_, double _V_, double _C_, double _K_)
-  : pp_point(point), pp_node_data(node_data), p_clock(time), pp_variables(variables), m(_m_), s(_s_), V(_V_), C(_C_), K(_K_)
+                  double _m_, double _s_, double _V_, double _C_, double _K_,
+                  std::vector<PMI_Context> * contexts=0)
+  : pp_point(point), pp_node_data(node_data), p_clock(time), pp_variables(variables), p_contexts(contexts),
+    m(_m_), s(_s_), V(_V_), C(_C_), K(_K_)
   {}
 };
 
@@ -202,6 +238,55 @@ struct RefractionItem
 };
 
 
+/**
+ * linear interpolation of refraction index in the wave table, which is sorted by wave length.
+ * \p lamda is in the unit of the table (um). the wave length outside the table takes the value at the end.
+ * the optical solvers scan the spectrum in order, so the search begins from \p cursor,
+ * the interval of last query, and only falls back to bisection when the hint misses
+ */
+inline std::complex<PetscScalar> interpolate_refraction_index(const std::vector<RefractionItem> & table, PetscScalar lamda, unsigned int & cursor)
+{
+  const unsigned int table_size = table.size();
+
+  if( lamda < table[0].wavelength )
+    return std::complex<PetscScalar> (table[0].RefractionIndexRe, table[0].RefractionIndexIm);
+
+  if( lamda > table[table_size-1].wavelength )
+    return std::complex<PetscScalar> (table[table_size-1].RefractionIndexRe, table[table_size-1].RefractionIndexIm);
+
+  if( table_size < 2 )
+    return std::complex<PetscScalar> (table[0].RefractionIndexRe, table[0].RefractionIndexIm);
+
+  // hunting: the last interval or the next one
+  unsigned int i = cursor < table_size-1 ? cursor : 0;
+  if( !(lamda>=table[i].wavelength && lamda<=table[i+1].wavelength) )
+  {
+    if( i+2<table_size && lamda>=table[i+1].wavelength && lamda<=table[i+2].wavelength )
+      ++i;
+    else
+    {
+      unsigned int begin=0, end=table_size-1;
+      while(end-begin>1)
+      {
+        unsigned int mid = (begin+end)/2;
+        if( lamda < table[mid].wavelength )
+          end = mid;
+        else
+          begin = mid;
+      }
+      i = begin;
+    }
+  }
+  cursor = i;
+
+  std::complex<PetscScalar> n1(table[i].RefractionIndexRe, table[i].RefractionIndexIm);
+  std::complex<PetscScalar> n2(table[i+1].RefractionIndexRe, table[i+1].RefractionIndexIm);
+  PetscScalar d1 = lamda - table[i].wavelength;
+  PetscScalar d2 = table[i+1].wavelength - lamda;
+  return (n1*d2 + n2*d1)/(d1+d2);
+}
+
+
 /**
  * PMI_Server, the base class of PMI
  */
@@ -243,6 +328,27 @@ protected:
    */
   const PetscScalar     *p_clock;
 
+  /**
+   * the evaluation context of each thread, may be NULL
+   */
+  std::vector<PMI_Context> *p_contexts;
+
+  /**
+   * @return current point of the calling thread
+   */
+  const Point * current_point() const;
+
+  /**
+   * @return data of current node of the calling thread
+   */
+  const FVM_NodeData * current_node_data() const;
+
+  /**
+   * set the evaluation context of the calling thread, used by the batch evaluation
+   * which loops over the single node PMI functions
+   */
+  void set_current_context(const PMI_Context &context) const;
+
 protected:
   /**
    * this map links variable \p name to its \p address
@@ -311,6 +417,12 @@ public:
    */
   int calibrate_string_parameter(const std::string & var_name, const std::string &var_value);
 
+  /**
+   * get numeric parameter value by its name, in the unit of calibrate_real_parameter.
+   * @return 0 for success, 1 for variable no find.
+   */
+  int get_real_parameter(const std::string & var_name, PetscScalar & var_value) const;
+
   /**
    * set numeric and string parameters value by its name.
    */
@@ -404,6 +516,22 @@ public:
    * aux function return total Donor concentration of current node
    */
   PetscScalar ReadDopingNd () const;
+
+  /**
+   * aux function return total Acceptor concentration of the node in context, used by batch evaluation
+   */
+  PetscScalar ReadDopingNa (const PMI_Context &context) const;
+
+  /**
+   * aux function return total Donor concentration of the node in context, used by batch evaluation
+   */
+  PetscScalar ReadDopingNd (const PMI_Context &context) const;
+
+  /**
+   * aux function read SRH lifetimes cached in the data of current node.
+   * @return false when the lifetimes are not cached at lattice temperature Tl
+   */
+  bool ReadCachedLifetime (const PetscScalar &Tl, PetscScalar &taun, PetscScalar &taup) const;
 };
 
 
@@ -570,6 +698,30 @@ public:
    */
   virtual AutoDScalar nie            (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl) =0;
 
+  /**
+   * batch evaluation of band gap over n_nodes nodes, node i is evaluated in context[i].
+   * when dEg_dTl is not NULL, the derivative to lattice temperature is written as well.
+   * the default implementation loops over the single node version
+   */
+  virtual void Eg_batch              (unsigned int n_nodes, const PMI_Context *context, const PetscScalar *Tl,
+                                      PetscScalar *Eg, PetscScalar *dEg_dTl=0);
+
+  /**
+   * batch evaluation of band gap narrowing, see Eg_batch.
+   * the derivative arrays may be NULL
+   */
+  virtual void EgNarrow_batch        (unsigned int n_nodes, const PMI_Context *context,
+                                      const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl,
+                                      PetscScalar *EgNarrow, PetscScalar *d_dp=0, PetscScalar *d_dn=0, PetscScalar *d_dTl=0);
+
+  /**
+   * batch evaluation of effective intrinsic carrier concentration, see Eg_batch.
+   * the derivative arrays may be NULL
+   */
+  virtual void nie_batch             (unsigned int n_nodes, const PMI_Context *context,
+                                      const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl,
+                                      PetscScalar *nie, PetscScalar *d_dp=0, PetscScalar *d_dn=0, PetscScalar *d_dTl=0);
+
   /**
    * @return the ion type by given species, the return value is defined as P-type < 0 and N-type >0
    * each semiconductor material can derive this function
@@ -926,6 +1078,21 @@ public:
   virtual AutoDScalar HoleMob (const AutoDScalar &p,  const AutoDScalar &n,  const AutoDScalar &Tl,
                                const AutoDScalar &Ep, const AutoDScalar &Et, const AutoDScalar &Tp) const=0;
 
+  /**
+   * batch evaluation of electron mobility over n_nodes entries, entry i is evaluated in context[i].
+   * the default implementation loops over the single node version
+   */
+  virtual void ElecMob_batch  (unsigned int n_nodes, const PMI_Context *context,
+                               const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                               const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tn, PetscScalar *mob) const;
+
+  /**
+   * batch evaluation of hole mobility, see ElecMob_batch
+   */
+  virtual void HoleMob_batch  (unsigned int n_nodes, const PMI_Context *context,
+                               const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                               const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tp, PetscScalar *mob) const;
+
 };
 
 
@@ -1041,6 +1208,13 @@ public:
    */
   virtual ~PMIS_Trap() {}
 
+  /**
+   * returns true if traps of the given type (bulk or interface) exist at this node.
+   * the solvers only evaluate the trap terms of such nodes.
+   * the default is true, which visits every node
+   */
+  virtual bool HasTrap(const bool flag_bulk) { return true; }
+
   /**
    * returns the electric charge density due to trapped charge at this node
    * one should call Calculate() to calculate the electron occupancy before calling this function
@@ -1163,6 +1337,11 @@ protected:
 
   std::vector<RefractionItem> _wave_table;
 
+  /**
+   * the interval of last RefractionIndex query in the wave table
+   */
+  mutable unsigned int _wave_table_cursor;
+
   /**
    * when refraction_data_file is not empty, read from it
    */
@@ -1173,7 +1352,7 @@ public:
   /**
    * constructor
    */
-  PMIS_Optical(const PMIS_Environment &env):PMIS_Server(env)
+  PMIS_Optical(const PMIS_Environment &env):PMIS_Server(env), _wave_table_cursor(0)
   {
 #ifdef __CALIBRATE__
     parameter_map.insert(para_item("refraction", PARA("refraction", "The refraction data file", &_refraction_data_file)) );
@@ -1360,6 +1539,11 @@ protected:
 
   std::vector<RefractionItem> _wave_table;
 
+  /**
+   * the interval of last RefractionIndex query in the wave table
+   */
+  mutable unsigned int _wave_table_cursor;
+
   /**
    * when refraction_data_file is not empty, read from it
    */
@@ -1369,7 +1553,7 @@ public:
   /**
    * constructor
    */
-  PMII_Optical(const PMII_Environment &env):PMII_Server(env)
+  PMII_Optical(const PMII_Environment &env):PMII_Server(env), _wave_table_cursor(0)
   {
 #ifdef __CALIBRATE__
     parameter_map.insert(para_item("refraction", PARA("refraction", "The refraction data file", &_refraction_data_file)) );
@@ -1507,6 +1691,11 @@ protected:
 
   std::vector<RefractionItem> _wave_table;
 
+  /**
+   * the interval of last RefractionIndex query in the wave table
+   */
+  mutable unsigned int _wave_table_cursor;
+
   /**
    * when refraction_data_file is not empty, read from it
    */
@@ -1516,7 +1705,7 @@ public:
   /**
    * constructor
    */
-  PMIC_Optical(const PMIC_Environment &env):PMIC_Server(env)
+  PMIC_Optical(const PMIC_Environment &env):PMIC_Server(env), _wave_table_cursor(0)
   {
 #ifdef __CALIBRATE__
     parameter_map.insert(para_item("refraction", PARA("refraction", "The refraction data file", &_refraction_data_file)) );
@@ -1653,11 +1842,16 @@ protected:
 
   std::vector<RefractionItem> _wave_table;
 
+  /**
+   * the interval of last RefractionIndex query in the wave table
+   */
+  mutable unsigned int _wave_table_cursor;
+
 public:
   /**
    * constructor
    */
-  PMIV_Optical(const PMIC_Environment &env):PMIV_Server(env)
+  PMIV_Optical(const PMIC_Environment &env):PMIV_Server(env), _wave_table_cursor(0)
   {
 #ifdef __CALIBRATE__
     parameter_map.insert(para_item("refraction", PARA("refraction", "The refraction data file", &_refraction_data_file)) );
@@ -28,16 +28,12 @@
 #include <map>
 
 #include "genius_common.h"
+#include "genius_env.h"
 
 #include "material_define.h"
 #include "physical_unit.h"
 #include "PMI.h"
 
-#ifdef CYGWIN
-  class HINSTANCE__; // Forward or never
-  typedef HINSTANCE__* HINSTANCE;
-#endif
-
 class SimulationRegion;
 
 //using namespace Material;
@@ -77,11 +73,23 @@ public:
    */
   void mapping(const Point* point, const FVM_NodeData* node_data, PetscScalar time)
   {
-    p_point = point;
-    p_node_data = node_data;
-    clock = time;
+    const unsigned int tid = Genius::thread_id();
+    contexts[tid] = PMI_Context(point, node_data, time);
+    // the image is read only by PMI without per-thread context, keep it updated by master thread
+    if( tid == 0 )
+    {
+      p_point = point;
+      p_node_data = node_data;
+      clock = time;
+    }
   }
 
+  /**
+   * mapping with an explicit evaluation context, for the calling thread
+   */
+  void mapping(const PMI_Context & context)
+  { mapping(context.point, context.node_data, context.time); }
+
   /**
    * @return PMI_Environment
    */
@@ -96,7 +104,7 @@ public:
 
   /**
    * function pointer to set_ad_number, set the independent variable
-   * number of automatically differentiation
+   * number of automatically differentiation for the calling thread
    */
   void *              (*set_ad_num)(const unsigned int);
 
@@ -126,6 +134,11 @@ public:
    */
   virtual std::string get_pmi_info(const std::string& type, const int verbosity = 0) = 0;
 
+  /**
+   * @return the PMI object of type, NULL when the material has no such calibratable model
+   */
+  virtual PMI_Server * get_pmi(const std::string &) { return NULL; }
+
 protected:
 
   /**
@@ -153,6 +166,11 @@ protected:
    */
   PetscScalar                clock;
 
+  /**
+   * the evaluation context of each thread, which is updated by mapping function
+   */
+  std::vector<PMI_Context>   contexts;
+
   /**
    * region point based variables
    */
@@ -166,11 +184,7 @@ protected:
   /**
    * pointer to dynamic loaded library file
    */
-#ifdef CYGWIN
-  HINSTANCE                  dll_file;
-#else
   void                      *dll_file;
-#endif
 
 };
 
@@ -249,6 +263,11 @@ public:
    */
   std::string get_pmi_info(const std::string& type, const int verbosity = 0) ;
 
+  /**
+   * @return the PMI object of type, NULL for invalid type
+   */
+  PMI_Server * get_pmi(const std::string &type);
+
 };
 
 
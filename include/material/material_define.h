@@ -112,6 +112,12 @@ extern MaterialType material_type(const std::string & mat_name);
  */
 extern int material_weight(const std::string & mat_name);
 
+/**
+ * @return a weight factor of material when solved by the given solver (the METHOD type string),
+ * which estimates the assembly cost of a node by the number of equations on it
+ */
+extern int material_weight(const std::string & mat_name, const std::string & solver);
+
 //----------------------------------------------------------
 // since some matrial has alias ( such as "Ox" and "SiO2" )
 // format them to unique name
@@ -0,0 +1,157 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#ifndef __GENIUS_PMI_table_h__
+#define __GENIUS_PMI_table_h__
+
+#include <vector>
+
+#include "genius_common.h"
+
+
+/**
+ * the function of 1-3 variables to be tabulated by PMI_Table.
+ * the model implements operator() with its own parameters
+ */
+class PMI_TableFunction
+{
+public:
+  virtual ~PMI_TableFunction() {}
+
+  /**
+   * @return function value at point x, x has the dimension of the table
+   */
+  virtual PetscScalar operator() (const PetscScalar *x) const = 0;
+};
+
+
+/**
+ * tabulation of an expensive PMI function f(x0, x1, x2) of 1-3 variables on a uniform grid.
+ *
+ * the value and gradient are interpolated by tensor product Catmull-Rom spline, which is C1 continuous,
+ * so Newton iteration does not see kinks of the tabulated function.
+ * the grid is refined in each dimension separately until the interpolation error at the cell midpoints
+ * is below rtol times the magnitude of the function. the model should fall back to direct evaluation
+ * when the point is outside the table.
+ *
+ * the model usually uses log(n), log(p) and T as variables, and builds the table when it is
+ * calibrated, since every region has its own PMI object the table is cached per region.
+ */
+class PMI_Table
+{
+public:
+
+  PMI_Table() : _dim(0), _converged(false) {}
+
+  /**
+   * tabulate function f over box [lo, hi] of dimension dim (1-3).
+   * the table starts from init_points per dimension and refines until the error is below rtol,
+   * or the table reaches max_points in total.
+   * @return true when the error bound is satisfied
+   */
+  bool build(const PMI_TableFunction &f, unsigned int dim, const PetscScalar *lo, const PetscScalar *hi,
+             PetscScalar rtol, unsigned int init_points=9, unsigned int max_points=1<<20);
+
+  /**
+   * free the table
+   */
+  void clear();
+
+  /**
+   * @return true when the table has been built
+   */
+  bool valid() const
+  { return _dim>0; }
+
+  /**
+   * @return true when the table satisfies the error bound
+   */
+  bool converged() const
+  { return _converged; }
+
+  /**
+   * @return the number of grid points in total
+   */
+  unsigned int n_points() const
+  { return _values.size(); }
+
+  /**
+   * @return the largest relative interpolation error at the cell midpoints
+   */
+  PetscScalar error() const
+  { return _error; }
+
+  /**
+   * @return true when point x is inside the table
+   */
+  bool contains(const PetscScalar *x) const
+  {
+    for(unsigned int d=0; d<_dim; ++d)
+      if( !(x[d] >= _lo[d] && x[d] <= _hi[d]) ) return false;
+    return true;
+  }
+
+  /**
+   * @return interpolated value at point x, and the gradient in df when df is not null.
+   * x should be inside the table
+   */
+  PetscScalar eval(const PetscScalar *x, PetscScalar *df=0) const;
+
+private:
+
+  unsigned int _dim;
+
+  /**
+   * number of grid points, the grid spacing and the box in each dimension
+   */
+  unsigned int _n[3];
+  PetscScalar  _h[3];
+  PetscScalar  _lo[3];
+  PetscScalar  _hi[3];
+
+  /**
+   * grid values, dimension 0 runs fastest
+   */
+  std::vector<PetscScalar> _values;
+
+  bool _converged;
+
+  PetscScalar _error;
+
+  /**
+   * fill the grid values by f
+   */
+  void _fill(const PMI_TableFunction &f);
+
+  /**
+   * @return the largest interpolation error at midpoints of the cells in dimension d
+   */
+  PetscScalar _midpoint_error(const PMI_TableFunction &f, unsigned int d, PetscScalar scale) const;
+
+  /**
+   * @return the coordinate of grid point i in dimension d
+   */
+  PetscScalar _grid(unsigned int d, unsigned int i) const
+  { return i+1==_n[d] ? _hi[d] : _lo[d] + i*_h[d]; }
+};
+
+
+#endif
@@ -50,6 +50,8 @@
 #include <iostream>
 #include <cmath>
 #include <limits>
+#include <cstring>
+#include <algorithm>
 
 #include "asinh.hpp" // for asinh
 #include "acosh.hpp" // for acosh
@@ -96,144 +98,179 @@ namespace adtl
     return std::numeric_limits<PetscScalar>::quiet_NaN();
   }
 
-  class AutoDScalar
+  /**
+   * the number of active directions shared by all the AutoDScalarT<N> widths.
+   * the full width type AutoDScalar loops over numdir directions, which is set
+   * by each Jacobian routine.
+   * numdir is thread local, each assembly thread sets and reads its own copy,
+   * so several regions (or element batches) can be assembled concurrently.
+   */
+  class AutoDScalarBase
   {
   public:
-    // ctors
-    inline AutoDScalar();
-    inline AutoDScalar(const PetscScalar v);
-    inline AutoDScalar(const PetscScalar v, const PetscScalar * adv);
-    inline AutoDScalar(const PetscScalar v, const PetscScalar * adv, unsigned int n);
-    inline AutoDScalar(const AutoDScalar& a);
-    inline AutoDScalar(const AutoDScalar& a, unsigned int *, unsigned int n);
+    static GENIUS_THREAD_LOCAL unsigned int numdir;
+    static void setNumDir(const unsigned int p)
+    {
+      if (p>NUMBER_DIRECTIONS) numdir=NUMBER_DIRECTIONS;
+      else numdir=p;
+    }
+  };
 
-    /*******************  temporary results  ******************************/
-    // sign
-    inline const AutoDScalar operator - () const;
-    inline const AutoDScalar operator + () const;
 
-    // addition
-    inline const AutoDScalar operator + (const PetscScalar v) const;
-    inline const AutoDScalar operator + (const AutoDScalar& a) const;
-    inline friend
-    const AutoDScalar operator + (const PetscScalar v, const AutoDScalar& a);
+  /**
+   * enable_if for the expression templates
+   */
+  template <bool B, class T=void> struct ADEnableIf {};
+  template <class T> struct ADEnableIf<true, T> { typedef T type; };
 
-    // substraction
-    inline const AutoDScalar operator - (const PetscScalar v) const;
-    inline const AutoDScalar operator - (const AutoDScalar& a) const;
-    inline friend
-    const AutoDScalar operator - (const PetscScalar v, const AutoDScalar& a);
 
-    // multiplication
-    inline const AutoDScalar operator * (const PetscScalar v) const;
-    inline const AutoDScalar operator * (const AutoDScalar& a) const;
-    inline friend
-    const AutoDScalar operator * (const PetscScalar v, const AutoDScalar& a);
+  /**
+   * base of the AD expressions, AutoDScalarT itself and the expression nodes.
+   *
+   * the arithmetic operators of AutoDScalarT do not return a new AutoDScalarT, but a light node of
+   * an expression tree, i.e. eps*S*(V2-V1)/d is built of ADSubExpr and ADScaleExpr nodes. the value of each node
+   * is computed when the node is built, the derivatives are computed per direction only when the tree
+   * is assigned to an AutoDScalarT. so a compound expression is one loop over the directions without
+   * any intermediate derivative array.
+   *
+   * each expression type E provides
+   *   static const unsigned int width;        // the width of AutoDScalarT it evaluates to
+   *   PetscScalar value() const;
+   *   PetscScalar dx(unsigned int i) const;   // derivative in direction i
+   *
+   * the nodes refer to AutoDScalarT operands and hold sub-expressions by value. they only live
+   * until the end of the full expression, which is always the case in C++98 as their type can not be named.
+   * the math functions (exp, pow ...) evaluate an expression argument to AutoDScalarT first.
+   */
+  template <class E>
+  class ADExpr
+  {
+  public:
+    const E & self() const
+    { return static_cast<const E &>(*this); }
 
-    // division
-    inline const AutoDScalar operator / (const PetscScalar v) const;
-    inline const AutoDScalar operator / (const AutoDScalar& a) const;
-    inline friend
-    const AutoDScalar operator / (const PetscScalar v, const AutoDScalar& a);
+    PetscScalar getValue() const
+    { return self().value(); }
+  };
+
+
+  /**
+   * AD scalar with compile time capacity of N directions.
+   * AutoDScalarT<NUMBER_DIRECTIONS> (the AutoDScalar typedef) is the type used by material PMI,
+   * it only process the first numdir directions at run time.
+   * The narrow types, i.e. AutoDScalarT<6>, always process all the N directions. They only zero and loop
+   * over N slots, and should be used by kernels which know the number of independent variables at compile time.
+   */
+  template <unsigned int N>
+  class AutoDScalarT : public AutoDScalarBase, public ADExpr< AutoDScalarT<N> >
+  {
+  public:
+    /**
+     * width as an expression
+     */
+    static const unsigned int width = N;
 
+    // ctors
+    inline AutoDScalarT();
+    inline AutoDScalarT(const PetscScalar v);
+    inline AutoDScalarT(const PetscScalar v, const PetscScalar * adv);
+    inline AutoDScalarT(const PetscScalar v, const PetscScalar * adv, unsigned int n);
+    inline AutoDScalarT(const AutoDScalarT& a);
+    inline AutoDScalarT(const AutoDScalarT& a, unsigned int *, unsigned int n);
+
+    // convert between different width, the extra directions are dropped or set to zero
+    template <unsigned int M>
+    inline explicit AutoDScalarT(const AutoDScalarT<M>& a);
+    // convert between different width, with the directions shifted by order
+    template <unsigned int M>
+    inline AutoDScalarT(const AutoDScalarT<M>& a, unsigned int *, unsigned int n);
+
+    // evaluate an expression of the same width
+    template <class E>
+    inline AutoDScalarT(const ADExpr<E>& e, typename ADEnableIf<E::width==N>::type * =0);
+
+    /*******************  temporary results  ******************************/
     // inc/dec
-    inline const AutoDScalar operator ++ ();
-    inline const AutoDScalar operator ++ (int);
-    inline const AutoDScalar operator -- ();
-    inline const AutoDScalar operator -- (int);
+    inline const AutoDScalarT operator ++ ();
+    inline const AutoDScalarT operator ++ (int);
+    inline const AutoDScalarT operator -- ();
+    inline const AutoDScalarT operator -- (int);
 
     // functions
-    inline friend const AutoDScalar tan(const AutoDScalar &a);
-    inline friend const AutoDScalar exp(const AutoDScalar &a);
-    inline friend const AutoDScalar log(const AutoDScalar &a);
-    inline friend const AutoDScalar sqrt(const AutoDScalar &a);
-    inline friend const AutoDScalar sin(const AutoDScalar &a);
-    inline friend const AutoDScalar cos(const AutoDScalar &a);
-    inline friend const AutoDScalar asin(const AutoDScalar &a);
-    inline friend const AutoDScalar acos(const AutoDScalar &a);
-    inline friend const AutoDScalar atan(const AutoDScalar &a);
-
-    inline friend const AutoDScalar atan2(const AutoDScalar &a, const AutoDScalar &b);
-    inline friend const AutoDScalar pow(const AutoDScalar &a, PetscScalar v);
-    inline friend const AutoDScalar pow(const AutoDScalar &a, const AutoDScalar &b);
-    inline friend const AutoDScalar pow(PetscScalar v, const AutoDScalar &a);
-    inline friend const AutoDScalar log10(const AutoDScalar &a);
-
-    inline friend const AutoDScalar sinh (const AutoDScalar &a);
-    inline friend const AutoDScalar cosh (const AutoDScalar &a);
-    inline friend const AutoDScalar tanh (const AutoDScalar &a);
-
-    inline friend const AutoDScalar asinh (const AutoDScalar &a);
-    inline friend const AutoDScalar acosh (const AutoDScalar &a);
-    inline friend const AutoDScalar atanh (const AutoDScalar &a);
-
-    inline friend const AutoDScalar fabs (const AutoDScalar &a);
-    inline friend const AutoDScalar ceil (const AutoDScalar &a);
-    inline friend const AutoDScalar floor (const AutoDScalar &a);
-    inline friend const AutoDScalar fmax (const AutoDScalar &a, const AutoDScalar &b);
-    inline friend const AutoDScalar fmax (PetscScalar v, const AutoDScalar &a);
-    inline friend const AutoDScalar fmax (const AutoDScalar &a, PetscScalar v);
-    inline friend const AutoDScalar fmin (const AutoDScalar &a, const AutoDScalar &b);
-    inline friend const AutoDScalar fmin (PetscScalar v, const AutoDScalar &a);
-    inline friend const AutoDScalar fmin (const AutoDScalar &a, PetscScalar v);
-    inline friend const AutoDScalar ldexp (const AutoDScalar &a, const AutoDScalar &b);
-    inline friend const AutoDScalar ldexp (const AutoDScalar &a, const PetscScalar v);
-    inline friend const AutoDScalar ldexp (const PetscScalar v, const AutoDScalar &a);
-    inline friend       PetscScalar frexp (const AutoDScalar &a, int* v);
+    template <unsigned int M> friend const AutoDScalarT<M> tan(const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> exp(const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> log(const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> sqrt(const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> sin(const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> cos(const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> asin(const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> acos(const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> atan(const AutoDScalarT<M> &a);
+
+    template <unsigned int M> friend const AutoDScalarT<M> atan2(const AutoDScalarT<M> &a, const AutoDScalarT<M> &b);
+    template <unsigned int M> friend const AutoDScalarT<M> pow(const AutoDScalarT<M> &a, PetscScalar v);
+    template <unsigned int M> friend const AutoDScalarT<M> pow(const AutoDScalarT<M> &a, const AutoDScalarT<M> &b);
+    template <unsigned int M> friend const AutoDScalarT<M> pow(PetscScalar v, const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> log10(const AutoDScalarT<M> &a);
+
+    template <unsigned int M> friend const AutoDScalarT<M> sinh (const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> cosh (const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> tanh (const AutoDScalarT<M> &a);
+
+    template <unsigned int M> friend const AutoDScalarT<M> asinh (const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> acosh (const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> atanh (const AutoDScalarT<M> &a);
+
+    template <unsigned int M> friend const AutoDScalarT<M> fabs (const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> ceil (const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> floor (const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> fmax (const AutoDScalarT<M> &a, const AutoDScalarT<M> &b);
+    template <unsigned int M> friend const AutoDScalarT<M> fmax (PetscScalar v, const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> fmax (const AutoDScalarT<M> &a, PetscScalar v);
+    template <unsigned int M> friend const AutoDScalarT<M> fmin (const AutoDScalarT<M> &a, const AutoDScalarT<M> &b);
+    template <unsigned int M> friend const AutoDScalarT<M> fmin (PetscScalar v, const AutoDScalarT<M> &a);
+    template <unsigned int M> friend const AutoDScalarT<M> fmin (const AutoDScalarT<M> &a, PetscScalar v);
+    template <unsigned int M> friend const AutoDScalarT<M> ldexp (const AutoDScalarT<M> &a, const AutoDScalarT<M> &b);
+    template <unsigned int M> friend const AutoDScalarT<M> ldexp (const AutoDScalarT<M> &a, const PetscScalar v);
+    template <unsigned int M> friend const AutoDScalarT<M> ldexp (const PetscScalar v, const AutoDScalarT<M> &a);
+    template <unsigned int M> friend       PetscScalar     frexp (const AutoDScalarT<M> &a, int* v);
 #ifndef CYGWIN
-    inline friend const AutoDScalar erf (const AutoDScalar &a);
+    template <unsigned int M> friend const AutoDScalarT<M> erf (const AutoDScalarT<M> &a);
 #endif
 
 
     /*******************  nontemporary results  ***************************/
     // assignment
     inline void operator = (const PetscScalar v);
-    inline void operator = (const AutoDScalar& a);
+    inline void operator = (const AutoDScalarT& a);
 
     // addition
     inline void operator += (const PetscScalar v);
-    inline void operator += (const AutoDScalar& a);
+    inline void operator += (const AutoDScalarT& a);
 
     // substraction
     inline void operator -= (const PetscScalar v);
-    inline void operator -= (const AutoDScalar& a);
+    inline void operator -= (const AutoDScalarT& a);
 
     // multiplication
     inline void operator *= (const PetscScalar v);
-    inline void operator *= (const AutoDScalar& a);
+    inline void operator *= (const AutoDScalarT& a);
 
     // division
     inline void operator /= (const PetscScalar v);
-    inline void operator /= (const AutoDScalar& a);
+    inline void operator /= (const AutoDScalarT& a);
+
+    // assignment and accumulation of an expression, in one pass over the directions
+    template <class E>
+    inline typename ADEnableIf<E::width==N>::type operator = (const ADExpr<E>& e);
+    template <class E>
+    inline typename ADEnableIf<E::width==N>::type operator += (const ADExpr<E>& e);
+    template <class E>
+    inline typename ADEnableIf<E::width==N>::type operator -= (const ADExpr<E>& e);
 
     // not
     inline int operator ! () const;
 
-    // comparision
-    inline int operator != (const AutoDScalar&) const;
-    inline int operator != (const PetscScalar) const;
-    inline friend int operator != (const PetscScalar, const AutoDScalar&);
-
-    inline int operator == (const AutoDScalar&) const;
-    inline int operator == (const PetscScalar) const;
-    inline friend int operator == (const PetscScalar, const AutoDScalar&);
-
-    inline int operator <= (const AutoDScalar&) const;
-    inline int operator <= (const PetscScalar) const;
-    inline friend int operator <= (const PetscScalar, const AutoDScalar&);
-
-    inline int operator >= (const AutoDScalar&) const;
-    inline int operator >= (const PetscScalar) const;
-    inline friend int operator >= (const PetscScalar, const AutoDScalar&);
-
-    inline int operator >  (const AutoDScalar&) const;
-    inline int operator >  (const PetscScalar) const;
-    inline friend int operator >  (const PetscScalar, const AutoDScalar&);
-
-    inline int operator <  (const AutoDScalar&) const;
-    inline int operator <  (const PetscScalar) const;
-    inline friend int operator <  (const PetscScalar, const AutoDScalar&);
-
     /*******************  getter / setter  ********************************/
     inline PetscScalar getValue() const;
     inline void setValue(const PetscScalar v);
@@ -243,253 +280,440 @@ namespace adtl
     inline PetscScalar getADValue(const unsigned int p) const;
     inline void setADValue(const unsigned int p, const PetscScalar v);
 #endif
+
+    /**
+     * value and derivative as an expression
+     */
+    PetscScalar value() const
+    { return val; }
+
+    PetscScalar dx(const unsigned int p) const
+    { return adval[p]; }
+
     /*******************  i/o operations  *********************************/
-    inline friend std::ostream& operator << ( std::ostream&, const AutoDScalar& );
-    inline friend std::istream& operator >> ( std::istream&, AutoDScalar& );
+    template <unsigned int M> friend std::ostream& operator << ( std::ostream&, const AutoDScalarT<M>& );
+    template <unsigned int M> friend std::istream& operator >> ( std::istream&, AutoDScalarT<M>& );
 
-    static unsigned int numdir;
-    static void setNumDir(const unsigned int p)
-    {
-      if (p>NUMBER_DIRECTIONS) numdir=NUMBER_DIRECTIONS;
-      else numdir=p;
-    }
+    /**
+     * the number of directions processed by this type
+     */
+    static unsigned int ndir()
+    { return N < NUMBER_DIRECTIONS ? N : numdir; }
+
+    /**
+     * compile time capacity of the direction array
+     */
+    static unsigned int capacity()
+    { return N; }
 
   private:
     // internal variables
 
     PetscScalar val;
-    PetscScalar adval[NUMBER_DIRECTIONS];
+    PetscScalar adval[N];
   };
 
+
+  /**
+   * the AD scalar used by material PMI and the general Jacobian routines
+   */
+  typedef AutoDScalarT<NUMBER_DIRECTIONS> AutoDScalar;
+
+  /**
+   * fixed width AD scalars for kernels with known independent variable number,
+   * i.e. 6 for an edge with 3 variables per node, 9/12 for Tri3/Quad4 cell of DDM1
+   */
+  typedef AutoDScalarT<2>   AutoDScalar2;
+  typedef AutoDScalarT<4>   AutoDScalar4;
+  typedef AutoDScalarT<6>   AutoDScalar6;
+  typedef AutoDScalarT<8>   AutoDScalar8;
+  typedef AutoDScalarT<9>   AutoDScalar9;
+  typedef AutoDScalarT<12>  AutoDScalar12;
+  typedef AutoDScalarT<24>  AutoDScalar24;
+  typedef AutoDScalarT<32>  AutoDScalar32;
+
+
   /*******************************  ctors  ************************************/
-  AutoDScalar::AutoDScalar(): val(0)
+  template <unsigned int N>
+  AutoDScalarT<N>::AutoDScalarT(): val(0)
   {
-    memset(adval, 0, sizeof(PetscScalar)*NUMBER_DIRECTIONS);
+    memset(adval, 0, sizeof(PetscScalar)*N);
   }
 
-  AutoDScalar::AutoDScalar(const PetscScalar v) : val(v)
+  template <unsigned int N>
+  AutoDScalarT<N>::AutoDScalarT(const PetscScalar v) : val(v)
   {
-    memset(adval, 0, sizeof(PetscScalar)*NUMBER_DIRECTIONS);
+    memset(adval, 0, sizeof(PetscScalar)*N);
   }
 
-  AutoDScalar::AutoDScalar(const PetscScalar v, const PetscScalar * adv) : val(v)
+  template <unsigned int N>
+  AutoDScalarT<N>::AutoDScalarT(const PetscScalar v, const PetscScalar * adv) : val(v)
   {
-    memset(adval, 0, sizeof(PetscScalar)*NUMBER_DIRECTIONS);
+    memset(adval, 0, sizeof(PetscScalar)*N);
 
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]=adv[_i];
   }
 
-  AutoDScalar::AutoDScalar(const PetscScalar v, const PetscScalar * adv, unsigned int n) : val(v)
+  template <unsigned int N>
+  AutoDScalarT<N>::AutoDScalarT(const PetscScalar v, const PetscScalar * adv, unsigned int n) : val(v)
   {
-    memset(adval, 0, sizeof(PetscScalar)*NUMBER_DIRECTIONS);
+    memset(adval, 0, sizeof(PetscScalar)*N);
 
     for (unsigned int _i=0; _i<n; ++_i)
       adval[_i]=adv[_i];
   }
 
-  AutoDScalar::AutoDScalar(const AutoDScalar& a) : val(a.val)
+  template <unsigned int N>
+  AutoDScalarT<N>::AutoDScalarT(const AutoDScalarT<N>& a) : val(a.val)
   {
-    memset(adval, 0, sizeof(PetscScalar)*NUMBER_DIRECTIONS);
+    memset(adval, 0, sizeof(PetscScalar)*N);
 
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]=a.adval[_i];
   }
 
-  AutoDScalar::AutoDScalar(const AutoDScalar& a, unsigned int *order, unsigned int n) : val(a.val)
+  template <unsigned int N>
+  AutoDScalarT<N>::AutoDScalarT(const AutoDScalarT<N>& a, unsigned int *order, unsigned int n) : val(a.val)
   {
-    memset(adval, 0, sizeof(PetscScalar)*NUMBER_DIRECTIONS);
+    memset(adval, 0, sizeof(PetscScalar)*N);
 
     for (unsigned int _i=0; _i<n; ++_i)
       adval[order[_i]]=a.adval[_i];
   }
 
-
-  /*************************  temporary results  ******************************/
-  // sign
-  const AutoDScalar AutoDScalar::operator - () const
+  template <unsigned int N>
+  template <unsigned int M>
+  AutoDScalarT<N>::AutoDScalarT(const AutoDScalarT<M>& a) : val(a.getValue())
   {
-    AutoDScalar tmp;
-    tmp.val=-val;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
-      tmp.adval[_i]=-adval[_i];
-    return tmp;
-  }
+    memset(adval, 0, sizeof(PetscScalar)*N);
 
-  const AutoDScalar AutoDScalar::operator + () const
-  {
-    return *this;
+    const unsigned int n = std::min(ndir(), AutoDScalarT<M>::ndir());
+    const PetscScalar * adv = a.getADValue();
+    for (unsigned int _i=0; _i<n; ++_i)
+      adval[_i]=adv[_i];
   }
 
-  // addition
-  const AutoDScalar AutoDScalar::operator + (const PetscScalar v) const
+  template <unsigned int N>
+  template <unsigned int M>
+  AutoDScalarT<N>::AutoDScalarT(const AutoDScalarT<M>& a, unsigned int *order, unsigned int n) : val(a.getValue())
   {
-    return AutoDScalar(val+v, adval);
+    memset(adval, 0, sizeof(PetscScalar)*N);
+
+    const PetscScalar * adv = a.getADValue();
+    for (unsigned int _i=0; _i<n; ++_i)
+      adval[order[_i]]=adv[_i];
   }
 
-  const AutoDScalar AutoDScalar::operator + (const AutoDScalar& a) const
+
+  template <unsigned int N>
+  template <class E>
+  AutoDScalarT<N>::AutoDScalarT(const ADExpr<E>& e, typename ADEnableIf<E::width==N>::type *)
   {
-    AutoDScalar tmp;
-    tmp.val=val+a.val;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
-      tmp.adval[_i]=adval[_i]+a.adval[_i];
-    return tmp;
+    const E & x = e.self();
+    for (unsigned int _i=0; _i<ndir(); ++_i)
+      adval[_i]=x.dx(_i);
+    for (unsigned int _i=ndir(); _i<N; ++_i)
+      adval[_i]=0.0;
+    val=x.value();
   }
 
-  const AutoDScalar operator + (const PetscScalar v, const AutoDScalar& a)
+
+  /*************************  expression nodes  *******************************/
+
+  /**
+   * derivative array of an expression, i.e. for MatSetValues(..., (-f).getADValue(), ...).
+   * the expression is evaluated into an AutoDScalarT which lives until the end of the full expression,
+   * as the temporary AutoDScalarT did before
+   */
+  template <unsigned int N>
+  class ADValueArray
   {
-    return AutoDScalar(v+a.val, a.adval);
-  }
+  public:
+    template <class E>
+    ADValueArray(const ADExpr<E> &e) : _a(e) {}
 
-  // subtraction
-  const AutoDScalar AutoDScalar::operator - (const PetscScalar v) const
+    operator const PetscScalar * () const
+    { return _a.getADValue(); }
+
+  private:
+    AutoDScalarT<N> _a;
+  };
+
+  /**
+   * base of the expression nodes of width W, with the getter of AutoDScalarT
+   */
+  template <class E, unsigned int W>
+  class ADExprNode : public ADExpr<E>
   {
-    return AutoDScalar(val-v, adval);
-  }
+  public:
+    static const unsigned int width = W;
+
+    const ADValueArray<W> getADValue() const
+    { return ADValueArray<W>(*this); }
+
+    PetscScalar getADValue(const unsigned int i) const
+    { return this->self().dx(i); }
+  };
+
+  /**
+   * AutoDScalarT operands are held by reference, sub-expressions by value
+   */
+  template <class E> struct ADExprRef { typedef const E type; };
+  template <unsigned int N> struct ADExprRef< AutoDScalarT<N> > { typedef const AutoDScalarT<N> & type; };
+
+  /**
+   * compile time check of the width of two operands, AD scalars of different width can't be mixed
+   */
+  template <bool B> struct ADWidthCheck;
+  template <> struct ADWidthCheck<true> {};
 
-  const AutoDScalar AutoDScalar::operator - (const AutoDScalar& a) const
+  // l + r
+  template <class L, class R>
+  class ADAddExpr : public ADExprNode< ADAddExpr<L, R>, L::width >, ADWidthCheck<L::width==R::width>
   {
-    AutoDScalar tmp;
-    tmp.val=val-a.val;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
-      tmp.adval[_i]=adval[_i]-a.adval[_i];
-    return tmp;
-  }
+  public:
+    ADAddExpr(const L &l, const R &r) : _l(l), _r(r), _v(l.value()+r.value()) {}
+    PetscScalar value() const { return _v; }
+    PetscScalar dx(const unsigned int i) const { return _l.dx(i)+_r.dx(i); }
+  private:
+    typename ADExprRef<L>::type _l;
+    typename ADExprRef<R>::type _r;
+    PetscScalar _v;
+  };
 
-  const AutoDScalar operator - (const PetscScalar v, const AutoDScalar& a)
+  // l - r
+  template <class L, class R>
+  class ADSubExpr : public ADExprNode< ADSubExpr<L, R>, L::width >, ADWidthCheck<L::width==R::width>
   {
-    AutoDScalar tmp;
-    tmp.val=v-a.val;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
-      tmp.adval[_i]=-a.adval[_i];
-    return tmp;
-  }
+  public:
+    ADSubExpr(const L &l, const R &r) : _l(l), _r(r), _v(l.value()-r.value()) {}
+    PetscScalar value() const { return _v; }
+    PetscScalar dx(const unsigned int i) const { return _l.dx(i)-_r.dx(i); }
+  private:
+    typename ADExprRef<L>::type _l;
+    typename ADExprRef<R>::type _r;
+    PetscScalar _v;
+  };
 
-  // multiplication
-  const AutoDScalar AutoDScalar::operator * (const PetscScalar v) const
+  // l * r
+  template <class L, class R>
+  class ADMulExpr : public ADExprNode< ADMulExpr<L, R>, L::width >, ADWidthCheck<L::width==R::width>
   {
-    AutoDScalar tmp;
-    tmp.val=val*v;
-    for (unsigned int _i=0; _i<numdir; ++_i)
-      tmp.adval[_i]=adval[_i]*v;
-    return tmp;
-  }
+  public:
+    ADMulExpr(const L &l, const R &r) : _l(l), _r(r), _lv(l.value()), _rv(r.value()) {}
+    PetscScalar value() const { return _lv*_rv; }
+    PetscScalar dx(const unsigned int i) const { return _l.dx(i)*_rv+_lv*_r.dx(i); }
+  private:
+    typename ADExprRef<L>::type _l;
+    typename ADExprRef<R>::type _r;
+    PetscScalar _lv, _rv;
+  };
 
-  const AutoDScalar AutoDScalar::operator * (const AutoDScalar& a) const
+  // l / r
+  template <class L, class R>
+  class ADDivExpr : public ADExprNode< ADDivExpr<L, R>, L::width >, ADWidthCheck<L::width==R::width>
   {
-    AutoDScalar tmp;
-    tmp.val=val*a.val;
-    for (unsigned int _i=0; _i<numdir; ++_i)
-      tmp.adval[_i]=adval[_i]*a.val+val*a.adval[_i];
-    return tmp;
-  }
+  public:
+    ADDivExpr(const L &l, const R &r) : _l(l), _r(r), _rinv(1.0/r.value()), _v(l.value()*_rinv) {}
+    PetscScalar value() const { return _v; }
+    PetscScalar dx(const unsigned int i) const { return (_l.dx(i)-_v*_r.dx(i))*_rinv; }
+  private:
+    typename ADExprRef<L>::type _l;
+    typename ADExprRef<R>::type _r;
+    PetscScalar _rinv, _v;
+  };
 
-  const AutoDScalar operator * (const PetscScalar v, const AutoDScalar& a)
+  // -e
+  template <class E>
+  class ADNegExpr : public ADExprNode< ADNegExpr<E>, E::width >
   {
-    AutoDScalar tmp;
-    tmp.val=v*a.val;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
-      tmp.adval[_i]=v*a.adval[_i];
-    return tmp;
-  }
+  public:
+    ADNegExpr(const E &e) : _e(e) {}
+    PetscScalar value() const { return -_e.value(); }
+    PetscScalar dx(const unsigned int i) const { return -_e.dx(i); }
+  private:
+    typename ADExprRef<E>::type _e;
+  };
 
-  // division
-  const AutoDScalar AutoDScalar::operator / (const PetscScalar v) const
+  // e + v
+  template <class E>
+  class ADShiftExpr : public ADExprNode< ADShiftExpr<E>, E::width >
   {
-    AutoDScalar tmp;
-    PetscScalar t=1.0/v;
-    tmp.val=val*t;
-    for (unsigned int _i=0; _i<numdir; ++_i)
-      tmp.adval[_i]=adval[_i]*t;
-    return tmp;
-  }
+  public:
+    ADShiftExpr(const E &e, const PetscScalar v) : _e(e), _v(e.value()+v) {}
+    PetscScalar value() const { return _v; }
+    PetscScalar dx(const unsigned int i) const { return _e.dx(i); }
+  private:
+    typename ADExprRef<E>::type _e;
+    PetscScalar _v;
+  };
 
-  const AutoDScalar AutoDScalar::operator / (const AutoDScalar& a) const
+  // e * v
+  template <class E>
+  class ADScaleExpr : public ADExprNode< ADScaleExpr<E>, E::width >
   {
-    AutoDScalar tmp;
-    tmp.val=val/a.val;
-    for (unsigned int _i=0; _i<numdir; ++_i)
-      tmp.adval[_i]=(adval[_i]*a.val-val*a.adval[_i])/a.val/a.val;
-    return tmp;
-  }
+  public:
+    ADScaleExpr(const E &e, const PetscScalar s) : _e(e), _s(s), _v(e.value()*s) {}
+    PetscScalar value() const { return _v; }
+    PetscScalar dx(const unsigned int i) const { return _s*_e.dx(i); }
+  private:
+    typename ADExprRef<E>::type _e;
+    PetscScalar _s, _v;
+  };
 
-  const AutoDScalar operator / (const PetscScalar v, const AutoDScalar& a)
+  // v / e
+  template <class E>
+  class ADRecipExpr : public ADExprNode< ADRecipExpr<E>, E::width >
   {
-    AutoDScalar tmp;
-    tmp.val=v/a.val;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
-      tmp.adval[_i]=(-v*a.adval[_i])/a.val/a.val;
-    return tmp;
-  }
+  public:
+    ADRecipExpr(const PetscScalar v, const E &e) : _e(e), _v(v/e.value()), _d(-_v/e.value()) {}
+    PetscScalar value() const { return _v; }
+    PetscScalar dx(const unsigned int i) const { return _d*_e.dx(i); }
+  private:
+    typename ADExprRef<E>::type _e;
+    PetscScalar _v, _d;
+  };
+
+
+  /*************************  temporary results  ******************************/
+  // sign
+  template <class E>
+  inline const E & operator + (const ADExpr<E>& e)
+  { return e.self(); }
+
+  template <class E>
+  inline const ADNegExpr<E> operator - (const ADExpr<E>& e)
+  { return ADNegExpr<E>(e.self()); }
+
+  // addition
+  template <class L, class R>
+  inline const ADAddExpr<L, R> operator + (const ADExpr<L>& l, const ADExpr<R>& r)
+  { return ADAddExpr<L, R>(l.self(), r.self()); }
+
+  template <class E>
+  inline const ADShiftExpr<E> operator + (const ADExpr<E>& e, const PetscScalar v)
+  { return ADShiftExpr<E>(e.self(), v); }
+
+  template <class E>
+  inline const ADShiftExpr<E> operator + (const PetscScalar v, const ADExpr<E>& e)
+  { return ADShiftExpr<E>(e.self(), v); }
+
+  // subtraction
+  template <class L, class R>
+  inline const ADSubExpr<L, R> operator - (const ADExpr<L>& l, const ADExpr<R>& r)
+  { return ADSubExpr<L, R>(l.self(), r.self()); }
+
+  template <class E>
+  inline const ADShiftExpr<E> operator - (const ADExpr<E>& e, const PetscScalar v)
+  { return ADShiftExpr<E>(e.self(), -v); }
+
+  template <class E>
+  inline const ADShiftExpr< ADNegExpr<E> > operator - (const PetscScalar v, const ADExpr<E>& e)
+  { return ADShiftExpr< ADNegExpr<E> >(ADNegExpr<E>(e.self()), v); }
+
+  // multiplication
+  template <class L, class R>
+  inline const ADMulExpr<L, R> operator * (const ADExpr<L>& l, const ADExpr<R>& r)
+  { return ADMulExpr<L, R>(l.self(), r.self()); }
+
+  template <class E>
+  inline const ADScaleExpr<E> operator * (const ADExpr<E>& e, const PetscScalar v)
+  { return ADScaleExpr<E>(e.self(), v); }
+
+  template <class E>
+  inline const ADScaleExpr<E> operator * (const PetscScalar v, const ADExpr<E>& e)
+  { return ADScaleExpr<E>(e.self(), v); }
+
+  // division
+  template <class L, class R>
+  inline const ADDivExpr<L, R> operator / (const ADExpr<L>& l, const ADExpr<R>& r)
+  { return ADDivExpr<L, R>(l.self(), r.self()); }
+
+  template <class E>
+  inline const ADScaleExpr<E> operator / (const ADExpr<E>& e, const PetscScalar v)
+  { return ADScaleExpr<E>(e.self(), 1.0/v); }
+
+  template <class E>
+  inline const ADRecipExpr<E> operator / (const PetscScalar v, const ADExpr<E>& e)
+  { return ADRecipExpr<E>(v, e.self()); }
 
   // inc/dec
-  const AutoDScalar AutoDScalar::operator ++ ()
+  template <unsigned int N>
+  const AutoDScalarT<N> AutoDScalarT<N>::operator ++ ()
   {
     ++val;
     return *this;
   }
 
-  const AutoDScalar AutoDScalar::operator ++ (int)
+  template <unsigned int N>
+  const AutoDScalarT<N> AutoDScalarT<N>::operator ++ (int)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=val++;
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       tmp.adval[_i]=adval[_i];
     return tmp;
   }
 
-  const AutoDScalar AutoDScalar::operator -- ()
+  template <unsigned int N>
+  const AutoDScalarT<N> AutoDScalarT<N>::operator -- ()
   {
     --val;
     return *this;
   }
 
-  const AutoDScalar AutoDScalar::operator -- (int)
+  template <unsigned int N>
+  const AutoDScalarT<N> AutoDScalarT<N>::operator -- (int)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=val--;
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       tmp.adval[_i]=adval[_i];
     return tmp;
   }
 
   // functions
-  const AutoDScalar tan(const AutoDScalar& a)
+  template <unsigned int N>
+  const AutoDScalarT<N> tan(const AutoDScalarT<N>& a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     PetscScalar tmp2;
     tmp.val=::tan(a.val);
     tmp2=::cos(a.val);
     tmp2*=tmp2;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=a.adval[_i]/tmp2;
     return tmp;
   }
 
-  const AutoDScalar exp(const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> exp(const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::exp(a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=tmp.val*a.adval[_i];
     return tmp;
   }
 
-  const AutoDScalar log(const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> log(const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::log(a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       if (a.val>0 || (a.val==0 && a.adval[_i]>=0)) tmp.adval[_i]=a.adval[_i]/a.val;
       else tmp.adval[_i]=makeNaN();
     return tmp;
   }
 
-  const AutoDScalar sqrt(const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> sqrt(const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::sqrt(a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
     {
       if (a.val>0)
         tmp.adval[_i]=0.5*a.adval[_i]/tmp.val;
@@ -501,195 +725,212 @@ namespace adtl
     return tmp;
   }
 
-  const AutoDScalar sin(const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> sin(const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     PetscScalar tmp2;
     tmp.val=::sin(a.val);
     tmp2=::cos(a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=tmp2*a.adval[_i];
     return tmp;
   }
 
-  const AutoDScalar cos(const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> cos(const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     PetscScalar tmp2;
     tmp.val=::cos(a.val);
     tmp2=-::sin(a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=tmp2*a.adval[_i];
     return tmp;
   }
 
-  const AutoDScalar asin(const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> asin(const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::asin(a.val);
     PetscScalar tmp2=::sqrt(1-a.val*a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=a.adval[_i]/tmp2;
     return tmp;
   }
 
-  const AutoDScalar acos(const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> acos(const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::acos(a.val);
     PetscScalar tmp2=-::sqrt(1-a.val*a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=a.adval[_i]/tmp2;
     return tmp;
   }
 
-  const AutoDScalar atan(const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> atan(const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::atan(a.val);
     PetscScalar tmp2=1+a.val*a.val;
     tmp2=1/tmp2;
     if (tmp2!=0)
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=a.adval[_i]*tmp2;
     else
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=0.0;
     return tmp;
   }
 
-  const AutoDScalar atan2(const AutoDScalar &a, const AutoDScalar &b)
+  template <unsigned int N>
+  const AutoDScalarT<N> atan2(const AutoDScalarT<N> &a, const AutoDScalarT<N> &b)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::atan2(a.val, b.val);
     PetscScalar tmp2=a.val*a.val;
     PetscScalar tmp3=b.val*b.val;
     PetscScalar tmp4=tmp3/(tmp2+tmp3);
     if (tmp4!=0)
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=(a.adval[_i]*b.val-a.val*b.adval[_i])/tmp3*tmp4;
     else
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=0.0;
     return tmp;
   }
 
-  const AutoDScalar pow(const AutoDScalar &a, PetscScalar v)
+  template <unsigned int N>
+  const AutoDScalarT<N> pow(const AutoDScalarT<N> &a, PetscScalar v)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::pow(a.val, v);
     PetscScalar tmp2=v*::pow(a.val, v-1);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=tmp2*a.adval[_i];
     return tmp;
   }
 
-  const AutoDScalar pow(const AutoDScalar &a, const AutoDScalar &b)
+  template <unsigned int N>
+  const AutoDScalarT<N> pow(const AutoDScalarT<N> &a, const AutoDScalarT<N> &b)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::pow(a.val, b.val);
     PetscScalar tmp2=b.val*::pow(a.val, b.val-1);
     PetscScalar tmp3=::log(a.val)*tmp.val;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=tmp2*a.adval[_i]+tmp3*b.adval[_i];
     return tmp;
   }
 
-  const AutoDScalar pow(PetscScalar v, const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> pow(PetscScalar v, const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::pow(v, a.val);
     PetscScalar tmp2=tmp.val*::log(v);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=tmp2*a.adval[_i];
     return tmp;
   }
 
-  const AutoDScalar log10(const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> log10(const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::log10(a.val);
     PetscScalar tmp2=::log((PetscScalar)10)*a.val;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=a.adval[_i]/tmp2;
     return tmp;
   }
 
-  const AutoDScalar sinh (const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> sinh (const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::sinh(a.val);
     PetscScalar tmp2=::cosh(a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=a.adval[_i]*tmp2;
     return tmp;
   }
 
-  const AutoDScalar cosh (const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> cosh (const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::cosh(a.val);
     PetscScalar tmp2=::sinh(a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=a.adval[_i]*tmp2;
     return tmp;
   }
 
-  const AutoDScalar tanh (const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> tanh (const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::tanh(a.val);
     PetscScalar tmp2=::cosh(a.val);
     tmp2*=tmp2;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=a.adval[_i]/tmp2;
     return tmp;
   }
 
 
-  const AutoDScalar asinh (const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> asinh (const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=boost::math::asinh(a.val);
     PetscScalar tmp2=::sqrt(a.val*a.val+1);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=a.adval[_i]/tmp2;
     return tmp;
   }
 
-  const AutoDScalar acosh (const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> acosh (const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=boost::math::acosh(a.val);
     PetscScalar tmp2=::sqrt(a.val*a.val-1);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=a.adval[_i]/tmp2;
     return tmp;
   }
 
-  const AutoDScalar atanh (const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> atanh (const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=boost::math::atanh(a.val);
     PetscScalar tmp2=1-a.val*a.val;
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=a.adval[_i]/tmp2;
     return tmp;
   }
 
 
-  const AutoDScalar fabs (const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> fabs (const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::fabs(a.val);
     int as=0;
     if (a.val>0) as=1;
     if (a.val<0) as=-1;
     if (as!=0)
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=a.adval[_i]*as;
     else
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       {
         as=0;
         if (a.adval[_i]>0) as=1;
@@ -699,32 +940,35 @@ namespace adtl
     return tmp;
   }
 
-  const AutoDScalar ceil (const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> ceil (const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::ceil(a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=0.0;
     return tmp;
   }
 
-  const AutoDScalar floor (const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> floor (const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::floor(a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=0.0;
     return tmp;
   }
 
-  const AutoDScalar fmax (const AutoDScalar &a, const AutoDScalar &b)
+  template <unsigned int N>
+  const AutoDScalarT<N> fmax (const AutoDScalarT<N> &a, const AutoDScalarT<N> &b)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     PetscScalar tmp2=a.val-b.val;
     if (tmp2<0)
     {
       tmp.val=b.val;
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=b.adval[_i];
     }
     else
@@ -732,12 +976,12 @@ namespace adtl
       tmp.val=a.val;
       if (tmp2>0)
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
           tmp.adval[_i]=a.adval[_i];
       }
       else
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         {
           if (a.adval[_i]<b.adval[_i]) tmp.adval[_i]=b.adval[_i];
           else tmp.adval[_i]=a.adval[_i];
@@ -747,14 +991,15 @@ namespace adtl
     return tmp;
   }
 
-  const AutoDScalar fmax (PetscScalar v, const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> fmax (PetscScalar v, const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     PetscScalar tmp2=v-a.val;
     if (tmp2<0)
     {
       tmp.val=a.val;
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=a.adval[_i];
     }
     else
@@ -762,12 +1007,12 @@ namespace adtl
       tmp.val=v;
       if (tmp2>0)
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
           tmp.adval[_i]=0.0;
       }
       else
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         {
           if (a.adval[_i]>0) tmp.adval[_i]=a.adval[_i];
           else tmp.adval[_i]=0.0;
@@ -777,14 +1022,15 @@ namespace adtl
     return tmp;
   }
 
-  const AutoDScalar fmax (const AutoDScalar &a, PetscScalar v)
+  template <unsigned int N>
+  const AutoDScalarT<N> fmax (const AutoDScalarT<N> &a, PetscScalar v)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     PetscScalar tmp2=a.val-v;
     if (tmp2<0)
     {
       tmp.val=v;
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=0.0;
     }
     else
@@ -792,12 +1038,12 @@ namespace adtl
       tmp.val=a.val;
       if (tmp2>0)
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
           tmp.adval[_i]=a.adval[_i];
       }
       else
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         {
           if (a.adval[_i]>0) tmp.adval[_i]=a.adval[_i];
           else tmp.adval[_i]=0.0;
@@ -807,14 +1053,15 @@ namespace adtl
     return tmp;
   }
 
-  const AutoDScalar fmin (const AutoDScalar &a, const AutoDScalar &b)
+  template <unsigned int N>
+  const AutoDScalarT<N> fmin (const AutoDScalarT<N> &a, const AutoDScalarT<N> &b)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     PetscScalar tmp2=a.val-b.val;
     if (tmp2<0)
     {
       tmp.val=a.val;
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=a.adval[_i];
     }
     else
@@ -822,12 +1069,12 @@ namespace adtl
       tmp.val=b.val;
       if (tmp2>0)
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
           tmp.adval[_i]=b.adval[_i];
       }
       else
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         {
           if (a.adval[_i]<b.adval[_i]) tmp.adval[_i]=a.adval[_i];
           else tmp.adval[_i]=b.adval[_i];
@@ -837,14 +1084,15 @@ namespace adtl
     return tmp;
   }
 
-  const AutoDScalar fmin (PetscScalar v, const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> fmin (PetscScalar v, const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     PetscScalar tmp2=v-a.val;
     if (tmp2<0)
     {
       tmp.val=v;
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=0.0;
     }
     else
@@ -852,12 +1100,12 @@ namespace adtl
       tmp.val=a.val;
       if (tmp2>0)
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
           tmp.adval[_i]=a.adval[_i];
       }
       else
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         {
           if (a.adval[_i]<0) tmp.adval[_i]=a.adval[_i];
           else tmp.adval[_i]=0.0;
@@ -867,14 +1115,15 @@ namespace adtl
     return tmp;
   }
 
-  const AutoDScalar fmin (const AutoDScalar &a, PetscScalar v)
+  template <unsigned int N>
+  const AutoDScalarT<N> fmin (const AutoDScalarT<N> &a, PetscScalar v)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     PetscScalar tmp2=a.val-v;
     if (tmp2<0)
     {
       tmp.val=a.val;
-      for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+      for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         tmp.adval[_i]=a.adval[_i];
     }
     else
@@ -882,12 +1131,12 @@ namespace adtl
       tmp.val=v;
       if (tmp2>0)
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
           tmp.adval[_i]=0.0;
       }
       else
       {
-        for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+        for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
         {
           if (a.adval[_i]<0) tmp.adval[_i]=a.adval[_i];
           else tmp.adval[_i]=0.0;
@@ -897,255 +1146,300 @@ namespace adtl
     return tmp;
   }
 
-  const AutoDScalar ldexp (const AutoDScalar &a, const AutoDScalar &b)
+  template <unsigned int N>
+  const AutoDScalarT<N> ldexp (const AutoDScalarT<N> &a, const AutoDScalarT<N> &b)
   {
     return a*pow(2.,b);
   }
 
-  const AutoDScalar ldexp (const AutoDScalar &a, const PetscScalar v)
+  template <unsigned int N>
+  const AutoDScalarT<N> ldexp (const AutoDScalarT<N> &a, const PetscScalar v)
   {
     return a*::pow(2.,v);
   }
 
-  const AutoDScalar ldexp (const PetscScalar v, const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> ldexp (const PetscScalar v, const AutoDScalarT<N> &a)
   {
     return v*pow(2.,a);
   }
 
-  PetscScalar frexp (const AutoDScalar &a, int* v)
+  template <unsigned int N>
+  PetscScalar frexp (const AutoDScalarT<N> &a, int* v)
   {
     return ::frexp(a.val, v);
   }
 
 #ifndef CYGWIN
-  const AutoDScalar erf (const AutoDScalar &a)
+  template <unsigned int N>
+  const AutoDScalarT<N> erf (const AutoDScalarT<N> &a)
   {
-    AutoDScalar tmp;
+    AutoDScalarT<N> tmp;
     tmp.val=::erf(a.val);
     PetscScalar tmp2=2.0/::sqrt(::acos(-1.0))*::exp(-a.val*a.val);
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       tmp.adval[_i]=tmp2*a.adval[_i];
     return tmp;
   }
 #endif
 
 
+
+  /*******************  functions of expressions  *****************************/
+  // the expression is evaluated to AutoDScalarT, then the function of AutoDScalarT is called.
+  // for an AutoDScalarT argument, the overload above is the better match
+
+#define ADTL_EXPR_FUNCTION_1(func) \
+  template <class E> \
+  inline const AutoDScalarT<E::width> func (const ADExpr<E> &e) \
+  { return func(AutoDScalarT<E::width>(e.self())); }
+
+#define ADTL_EXPR_FUNCTION_2(func) \
+  template <class A, class B> \
+  inline const AutoDScalarT<A::width> func (const ADExpr<A> &a, const ADExpr<B> &b) \
+  { return func(AutoDScalarT<A::width>(a.self()), AutoDScalarT<B::width>(b.self())); } \
+  template <class E> \
+  inline const AutoDScalarT<E::width> func (const ADExpr<E> &e, const PetscScalar v) \
+  { return func(AutoDScalarT<E::width>(e.self()), v); } \
+  template <class E> \
+  inline const AutoDScalarT<E::width> func (const PetscScalar v, const ADExpr<E> &e) \
+  { return func(v, AutoDScalarT<E::width>(e.self())); }
+
+  ADTL_EXPR_FUNCTION_1(tan)
+  ADTL_EXPR_FUNCTION_1(exp)
+  ADTL_EXPR_FUNCTION_1(log)
+  ADTL_EXPR_FUNCTION_1(sqrt)
+  ADTL_EXPR_FUNCTION_1(sin)
+  ADTL_EXPR_FUNCTION_1(cos)
+  ADTL_EXPR_FUNCTION_1(asin)
+  ADTL_EXPR_FUNCTION_1(acos)
+  ADTL_EXPR_FUNCTION_1(atan)
+  ADTL_EXPR_FUNCTION_1(log10)
+  ADTL_EXPR_FUNCTION_1(sinh)
+  ADTL_EXPR_FUNCTION_1(cosh)
+  ADTL_EXPR_FUNCTION_1(tanh)
+  ADTL_EXPR_FUNCTION_1(asinh)
+  ADTL_EXPR_FUNCTION_1(acosh)
+  ADTL_EXPR_FUNCTION_1(atanh)
+  ADTL_EXPR_FUNCTION_1(fabs)
+  ADTL_EXPR_FUNCTION_1(ceil)
+  ADTL_EXPR_FUNCTION_1(floor)
+#ifndef CYGWIN
+  ADTL_EXPR_FUNCTION_1(erf)
+#endif
+
+  ADTL_EXPR_FUNCTION_2(pow)
+  ADTL_EXPR_FUNCTION_2(fmax)
+  ADTL_EXPR_FUNCTION_2(fmin)
+  ADTL_EXPR_FUNCTION_2(ldexp)
+
+  template <class A, class B>
+  inline const AutoDScalarT<A::width> atan2 (const ADExpr<A> &a, const ADExpr<B> &b)
+  { return atan2(AutoDScalarT<A::width>(a.self()), AutoDScalarT<B::width>(b.self())); }
+
+#undef ADTL_EXPR_FUNCTION_1
+#undef ADTL_EXPR_FUNCTION_2
+
+
   /*******************  nontemporary results  *********************************/
-  void AutoDScalar::operator = (const PetscScalar v)
+  template <unsigned int N>
+  void AutoDScalarT<N>::operator = (const PetscScalar v)
   {
     val=v;
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]=0.0;
   }
 
-  void AutoDScalar::operator = (const AutoDScalar& a)
+  template <unsigned int N>
+  void AutoDScalarT<N>::operator = (const AutoDScalarT<N>& a)
   {
     val=a.val;
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]=a.adval[_i];
   }
 
-  void AutoDScalar::operator += (const PetscScalar v)
+  template <unsigned int N>
+  void AutoDScalarT<N>::operator += (const PetscScalar v)
   {
     val+=v;
   }
 
-  void AutoDScalar::operator += (const AutoDScalar& a)
+  template <unsigned int N>
+  void AutoDScalarT<N>::operator += (const AutoDScalarT<N>& a)
   {
     val=val+a.val;
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]+=a.adval[_i];
   }
 
-  void AutoDScalar::operator -= (const PetscScalar v)
+  template <unsigned int N>
+  void AutoDScalarT<N>::operator -= (const PetscScalar v)
   {
     val-=v;
   }
 
-  void AutoDScalar::operator -= (const AutoDScalar& a)
+  template <unsigned int N>
+  void AutoDScalarT<N>::operator -= (const AutoDScalarT<N>& a)
   {
     val=val-a.val;
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]-=a.adval[_i];
   }
 
-  void AutoDScalar::operator *= (const PetscScalar v)
+  template <unsigned int N>
+  void AutoDScalarT<N>::operator *= (const PetscScalar v)
   {
     val=val*v;
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]*=v;
   }
 
-  void AutoDScalar::operator *= (const AutoDScalar& a)
+  template <unsigned int N>
+  void AutoDScalarT<N>::operator *= (const AutoDScalarT<N>& a)
   {
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]=adval[_i]*a.val+val*a.adval[_i];
     val*=a.val;
   }
 
-  void AutoDScalar::operator /= (const PetscScalar v)
+  template <unsigned int N>
+  void AutoDScalarT<N>::operator /= (const PetscScalar v)
   {
     val/=v;
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]/=v;
   }
 
-  void AutoDScalar::operator /= (const AutoDScalar& a)
+  template <unsigned int N>
+  void AutoDScalarT<N>::operator /= (const AutoDScalarT<N>& a)
   {
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]=(adval[_i]*a.val-val*a.adval[_i])/a.val/a.val;
     val=val/a.val;
   }
 
-  // not
-  int AutoDScalar::operator ! () const
-  {
-    return val==0.0;
-  }
-
-  // comparision
-  int AutoDScalar::operator != (const AutoDScalar &a) const
-  {
-    return val!=a.val;
-  }
-
-  int AutoDScalar::operator != (const PetscScalar v) const
-  {
-    return val!=v;
-  }
-
-  int operator != (const PetscScalar v, const AutoDScalar &a)
-  {
-    return v!=a.val;
-  }
-
-  int AutoDScalar::operator == (const AutoDScalar &a) const
-  {
-    return val==a.val;
-  }
-
-  int AutoDScalar::operator == (const PetscScalar v) const
-  {
-    return val==v;
-  }
-
-  int operator == (const PetscScalar v, const AutoDScalar &a)
-  {
-    return v==a.val;
-  }
-
-  int AutoDScalar::operator <= (const AutoDScalar &a) const
-  {
-    return val<=a.val;
-  }
-
-  int AutoDScalar::operator <= (const PetscScalar v) const
-  {
-    return val<=v;
-  }
-
-  int operator <= (const PetscScalar v, const AutoDScalar &a)
-  {
-    return v<=a.val;
-  }
-
-  int AutoDScalar::operator >= (const AutoDScalar &a) const
+  template <unsigned int N>
+  template <class E>
+  typename ADEnableIf<E::width==N>::type AutoDScalarT<N>::operator = (const ADExpr<E>& e)
   {
-    return val>=a.val;
+    // the expression may refer to this, direction i only reads direction i of the operands,
+    // and the value is changed last
+    const E & x = e.self();
+    for (unsigned int _i=0; _i<ndir(); ++_i)
+      adval[_i]=x.dx(_i);
+    val=x.value();
   }
 
-  int AutoDScalar::operator >= (const PetscScalar v) const
+  template <unsigned int N>
+  template <class E>
+  typename ADEnableIf<E::width==N>::type AutoDScalarT<N>::operator += (const ADExpr<E>& e)
   {
-    return val>=v;
+    const E & x = e.self();
+    for (unsigned int _i=0; _i<ndir(); ++_i)
+      adval[_i]+=x.dx(_i);
+    val+=x.value();
   }
 
-  int operator >= (const PetscScalar v, const AutoDScalar &a)
+  template <unsigned int N>
+  template <class E>
+  typename ADEnableIf<E::width==N>::type AutoDScalarT<N>::operator -= (const ADExpr<E>& e)
   {
-    return v>=a.val;
+    const E & x = e.self();
+    for (unsigned int _i=0; _i<ndir(); ++_i)
+      adval[_i]-=x.dx(_i);
+    val-=x.value();
   }
 
-  int AutoDScalar::operator >  (const AutoDScalar &a) const
+  // not
+  template <unsigned int N>
+  int AutoDScalarT<N>::operator ! () const
   {
-    return val>a.val;
+    return val==0.0;
   }
 
-  int AutoDScalar::operator >  (const PetscScalar v) const
-  {
-    return val>v;
-  }
+  // comparision, by value
+#define ADTL_EXPR_COMPARE(op) \
+  template <class L, class R> \
+  inline int operator op (const ADExpr<L> &l, const ADExpr<R> &r) \
+  { return l.self().value() op r.self().value(); } \
+  template <class E> \
+  inline int operator op (const ADExpr<E> &e, const PetscScalar v) \
+  { return e.self().value() op v; } \
+  template <class E> \
+  inline int operator op (const PetscScalar v, const ADExpr<E> &e) \
+  { return v op e.self().value(); }
 
-  int operator >  (const PetscScalar v, const AutoDScalar &a)
-  {
-    return v>a.val;
-  }
+  ADTL_EXPR_COMPARE(!=)
+  ADTL_EXPR_COMPARE(==)
+  ADTL_EXPR_COMPARE(<=)
+  ADTL_EXPR_COMPARE(>=)
+  ADTL_EXPR_COMPARE(>)
+  ADTL_EXPR_COMPARE(<)
 
-  int AutoDScalar::operator <  (const AutoDScalar &a) const
-  {
-    return val<a.val;
-  }
+#undef ADTL_EXPR_COMPARE
 
-  int AutoDScalar::operator <  (const PetscScalar v) const
-  {
-    return val<v;
-  }
 
-  int operator <  (const PetscScalar v, const AutoDScalar &a)
-  {
-    return v<a.val;
-  }
 
   /*******************  getter / setter  **************************************/
-  PetscScalar AutoDScalar::getValue() const
+  template <unsigned int N>
+  PetscScalar AutoDScalarT<N>::getValue() const
   {
     return val;
   }
 
-  void AutoDScalar::setValue(const PetscScalar v)
+  template <unsigned int N>
+  void AutoDScalarT<N>::setValue(const PetscScalar v)
   {
     val=v;
   }
 
-  const PetscScalar * AutoDScalar::getADValue() const
+  template <unsigned int N>
+  const PetscScalar * AutoDScalarT<N>::getADValue() const
   {
     return adval;
   }
 
-  void AutoDScalar::setADValue(const PetscScalar * v)
+  template <unsigned int N>
+  void AutoDScalarT<N>::setADValue(const PetscScalar * v)
   {
-    for (unsigned int _i=0; _i<numdir; ++_i)
+    for (unsigned int _i=0; _i<ndir(); ++_i)
       adval[_i]=v[_i];
   }
 
 #  if defined(NUMBER_DIRECTIONS)
-  PetscScalar AutoDScalar::getADValue(const unsigned int p) const
+  template <unsigned int N>
+  PetscScalar AutoDScalarT<N>::getADValue(const unsigned int p) const
   {
-    genius_assert(p<NUMBER_DIRECTIONS);
+    genius_assert(p<N);
     return adval[p];
   }
 
-  void AutoDScalar::setADValue(const unsigned int p, const PetscScalar v)
+  template <unsigned int N>
+  void AutoDScalarT<N>::setADValue(const unsigned int p, const PetscScalar v)
   {
-    genius_assert(p<NUMBER_DIRECTIONS);
+    genius_assert(p<N);
     adval[p]=v;
   }
 #  endif
 
   /*******************  i/o operations  ***************************************/
-  std::ostream& operator << ( std::ostream& out, const AutoDScalar& a)
+  template <unsigned int N>
+  std::ostream& operator << ( std::ostream& out, const AutoDScalarT<N>& a)
   {
     out << "Value: " << a.val;
 #if !defined(NUMBER_DIRECTIONS)
     out << " ADValue: ";
 #else
-    out << " ADValues (" << AutoDScalar::numdir << "): ";
+    out << " ADValues (" << AutoDScalarT<N>::ndir() << "): ";
 #endif
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       out << a.adval[_i] << " ";
     out << "(a)";
     return out;
   }
 
-  std::istream& operator >> ( std::istream& in, AutoDScalar& a)
+  template <unsigned int N>
+  std::istream& operator >> ( std::istream& in, AutoDScalarT<N>& a)
   {
     char c;
     do
@@ -1162,7 +1456,7 @@ namespace adtl
     do in >> c;
     while (c!='(' && !in.eof());
     in >> num;
-    if (num>NUMBER_DIRECTIONS)
+    if (num>N)
     {
       std::cout << "ADOL-C error: to many directions in input\n";
       exit(-1);
@@ -1170,7 +1464,7 @@ namespace adtl
     do in >> c;
     while (c!=')' && !in.eof());
 #endif
-    for (unsigned int _i=0; _i<AutoDScalar::numdir; ++_i)
+    for (unsigned int _i=0; _i<AutoDScalarT<N>::ndir(); ++_i)
       in >> a.adval[_i];
     do in >> c;
     while (c!=')' && !in.eof());
@@ -1180,3 +1474,4 @@ namespace adtl
 }
 
 #endif
+
@@ -0,0 +1,271 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __dense_matrix_fixed_h__
+#define __dense_matrix_fixed_h__
+
+#include <cmath>
+#include <algorithm>
+
+#include "genius_common.h"
+
+
+/**
+ * Dense vector with compile time size N, stored on the stack.
+ * Used together with DenseMatrixFixed for the small systems solved
+ * per node or per element, where DenseVector / TNT::Array1D costs
+ * a heap allocation each time.
+ */
+template <typename T, unsigned int N>
+class DenseVectorFixed
+{
+public:
+
+  /**
+   * constructor, all the entries are set to \p v
+   */
+  explicit DenseVectorFixed(const T v = T())
+  { for(unsigned int i=0; i<N; ++i) _val[i] = v; }
+
+  /**
+   * @return the size of the vector
+   */
+  static unsigned int size()
+  { return N; }
+
+  /**
+   * set all the entries to 0
+   */
+  void zero()
+  { for(unsigned int i=0; i<N; ++i) _val[i] = 0; }
+
+  /**
+   * @return the \p i th entry
+   */
+  T operator() (const unsigned int i) const
+  { assert(i<N); return _val[i]; }
+
+  /**
+   * @return writable reference to the \p i th entry
+   */
+  T & operator() (const unsigned int i)
+  { assert(i<N); return _val[i]; }
+
+  /**
+   * @return the raw data, for VecSetValues
+   */
+  const T * get_values() const
+  { return _val; }
+
+  /**
+   * @return the writable raw data
+   */
+  T * get_values()
+  { return _val; }
+
+  /**
+   * multiply every entry by \p factor
+   */
+  void scale(const T factor)
+  { for(unsigned int i=0; i<N; ++i) _val[i] *= factor; }
+
+private:
+
+  T _val[N];
+};
+
+
+
+/**
+ * Dense square matrix with compile time size N, stored row major on the stack.
+ * All the loops have a constant trip count so the compiler can unroll and
+ * vectorize them. Only the operations needed by the small local systems are
+ * provided, use DenseMatrix for anything else.
+ */
+template <typename T, unsigned int N>
+class DenseMatrixFixed
+{
+public:
+
+  /**
+   * constructor, all the entries are set to \p v
+   */
+  explicit DenseMatrixFixed(const T v = T())
+  { for(unsigned int i=0; i<N*N; ++i) _val[i] = v; }
+
+  /**
+   * @return the row (and column) number
+   */
+  static unsigned int m()
+  { return N; }
+
+  /**
+   * @return the column number
+   */
+  static unsigned int n()
+  { return N; }
+
+  /**
+   * set all the entries to 0
+   */
+  void zero()
+  { for(unsigned int i=0; i<N*N; ++i) _val[i] = 0; }
+
+  /**
+   * set the matrix to the identity matrix
+   */
+  void identity()
+  {
+    this->zero();
+    for(unsigned int i=0; i<N; ++i) _val[i*N+i] = 1;
+  }
+
+  /**
+   * @return the \p (i,j) entry
+   */
+  T operator() (const unsigned int i, const unsigned int j) const
+  { assert(i<N && j<N); return _val[i*N+j]; }
+
+  /**
+   * @return writable reference to the \p (i,j) entry
+   */
+  T & operator() (const unsigned int i, const unsigned int j)
+  { assert(i<N && j<N); return _val[i*N+j]; }
+
+  /**
+   * @return the raw data in row major, for MatSetValues
+   */
+  const T * get_values() const
+  { return _val; }
+
+  /**
+   * multiply every entry by \p factor
+   */
+  void scale(const T factor)
+  { for(unsigned int i=0; i<N*N; ++i) _val[i] *= factor; }
+
+  /**
+   * add \p factor times \p mat to this matrix
+   */
+  void add(const T factor, const DenseMatrixFixed<T,N> & mat)
+  { for(unsigned int i=0; i<N*N; ++i) _val[i] += factor*mat._val[i]; }
+
+  /**
+   * dest = this * arg
+   */
+  void vector_mult(DenseVectorFixed<T,N> & dest, const DenseVectorFixed<T,N> & arg) const
+  {
+    for(unsigned int i=0; i<N; ++i)
+    {
+      T sum = 0;
+      for(unsigned int j=0; j<N; ++j)
+        sum += _val[i*N+j]*arg(j);
+      dest(i) = sum;
+    }
+  }
+
+  /**
+   * dest = this * B
+   */
+  void matrix_mult(DenseMatrixFixed<T,N> & dest, const DenseMatrixFixed<T,N> & B) const
+  {
+    dest.zero();
+    for(unsigned int i=0; i<N; ++i)
+      for(unsigned int k=0; k<N; ++k)
+      {
+        const T a = _val[i*N+k];
+        for(unsigned int j=0; j<N; ++j)
+          dest._val[i*N+j] += a*B._val[k*N+j];
+      }
+  }
+
+  /**
+   * solve Ax=b by LU decomposition with partial pivoting.
+   * like DenseMatrix::lu_solve, the matrix is overwritten by its LU factors
+   * @return false if the matrix is singular
+   */
+  bool lu_solve(const DenseVectorFixed<T,N> & b, DenseVectorFixed<T,N> & x)
+  {
+    for(unsigned int i=0; i<N; ++i) x(i) = b(i);
+
+    for(unsigned int k=0; k<N; ++k)
+    {
+      // find the pivot row
+      unsigned int p = k;
+      for(unsigned int i=k+1; i<N; ++i)
+        if( std::abs(_val[i*N+k]) > std::abs(_val[p*N+k]) ) p = i;
+      if( _val[p*N+k] == T(0) ) return false;
+
+      if( p != k )
+      {
+        for(unsigned int j=0; j<N; ++j)
+          std::swap(_val[k*N+j], _val[p*N+j]);
+        std::swap(x(k), x(p));
+      }
+
+      // eliminate the entries below the pivot, apply to x on the fly
+      const T inv = T(1)/_val[k*N+k];
+      for(unsigned int i=k+1; i<N; ++i)
+      {
+        const T l = _val[i*N+k]*inv;
+        _val[i*N+k] = l;
+        for(unsigned int j=k+1; j<N; ++j)
+          _val[i*N+j] -= l*_val[k*N+j];
+        x(i) -= l*x(k);
+      }
+    }
+
+    // back substitution
+    for(unsigned int ii=N; ii>0; --ii)
+    {
+      const unsigned int i = ii-1;
+      T sum = x(i);
+      for(unsigned int j=i+1; j<N; ++j)
+        sum -= _val[i*N+j]*x(j);
+      x(i) = sum/_val[i*N+i];
+    }
+
+    return true;
+  }
+
+private:
+
+  T _val[N*N];
+};
+
+
+/**
+ * the sizes of the local systems in genius: 3x3 gradient reconstruction,
+ * 4x4 HDM source, 8x8 and 12x12 element matrix of quad4 (2 dofs per node)
+ * and tet4 (3 dofs per node)
+ */
+typedef DenseMatrixFixed<Real, 3>   DenseMatrix3;
+typedef DenseMatrixFixed<Real, 4>   DenseMatrix4;
+typedef DenseMatrixFixed<Real, 8>   DenseMatrix8;
+typedef DenseMatrixFixed<Real, 12>  DenseMatrix12;
+
+typedef DenseVectorFixed<Real, 3>   DenseVector3;
+typedef DenseVectorFixed<Real, 4>   DenseVector4;
+typedef DenseVectorFixed<Real, 8>   DenseVector8;
+typedef DenseVectorFixed<Real, 12>  DenseVector12;
+
+#endif
@@ -71,6 +71,12 @@ public:
   double operator () (double x, double y, double z, double t)
   { return eval(x,y,z,t); }
 
+  /**
+   * evalute the expression at n points in one pass over the compiled program,
+   * the result of point i is written to value[i]
+   */
+  void eval(unsigned int n, const double *x, const double *y, const double *z, double t, double *value);
+
 private:
 
   /**
@@ -88,6 +94,16 @@ private:
    */
   ExprEval::Expression e;
 
+  /**
+   * expression compiled to stack program
+   */
+  ExprEval::Program program;
+
+  /**
+   * address of independent variable x, y, z and t
+   */
+  double *_x, *_y, *_z, *_t;
+
 };
 
 #endif
@@ -0,0 +1,70 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __fermi_dirac_h__
+#define __fermi_dirac_h__
+
+#include "genius_common.h"
+
+/**
+ * complete Fermi-Dirac integrals of order 1/2 and -1/2, normalized as
+ *
+ *   F_j(x) = 1/Gamma(j+1) \int_0^\infty t^j/(1+exp(t-x)) dt
+ *
+ * (the same as gsl_sf_fermi_dirac_half/mhalf), so F_j(x) -> exp(x) for x -> -infinity
+ * and dF_{1/2}/dx = F_{-1/2}.
+ *
+ * the integrals are evaluated by piecewise chebyshev series:
+ *   x < -2      : exp(x) times a series in exp(x)
+ *   -2 <= x < 46 : a series of degree 14 on each interval of width 2
+ *   x >= 46     : the sommerfeld expansion up to x^-8
+ * the relative error is below 2e-12 for all x. no iteration or branch on the accuracy
+ * is involved, the cost is a table lookup and one series evaluation.
+ */
+namespace FermiDirac
+{
+
+  /**
+   * @return F_{1/2}(x)
+   */
+  Real half(Real x);
+
+  /**
+   * @return F_{-1/2}(x)
+   */
+  Real mhalf(Real x);
+
+  /**
+   * F_{1/2}(x) and its derivative F_{-1/2}(x) in one call
+   */
+  void half(Real x, Real &f, Real &df);
+
+  /**
+   * F_{1/2} and F_{-1/2} of an array of n arguments. the entries are independent and the
+   * kernels are inlined into the loop, so the compiler can vectorize/pipeline it.
+   * df may be NULL when only the value is wanted
+   */
+  void half(const Real *x, Real *f, Real *df, unsigned int n);
+
+}
+
+#endif // #define __fermi_dirac_h__
@@ -27,6 +27,7 @@
 
 
 #include "mathfunc.h"
+#include "jflux1.h"
 
 
 /* ----------------------------------------------------------------------------
@@ -108,6 +109,132 @@ inline AutoDScalar pmid_eb(Real kb, Real e, const AutoDScalar &V1, const AutoDSc
 }
 
 
+//-----------------------------------------------------------------------------
+// hand derived gradient of the energy balance fluxes.
+// the AD versions of In_eb, Ip_eb, Sn_eb and Sp_eb below evaluate the flux and its partial derivatives
+// to the 6 edge variables (V1, V2, u1, u2, T1, T2) in plain arithmetic, and assemble the AD value
+// by the chain rule. the AD directions are visited once per edge variable instead of once per operation.
+
+/**
+ * Theta(T1,T2) and its partial derivatives to T1 and T2
+ */
+inline Real Theta(Real T1, Real T2, Real &dT1, Real &dT2)
+{
+  Real x = T2/T1-1;
+  if(fabs(x)>1e-6)
+  {
+    Real L = log(fabs(T2/T1));
+    dT1 = ((T2-T1)/T1 - L)/(L*L);
+    dT2 = (L - (T2-T1)/T2)/(L*L);
+    return (T2-T1)/L;
+  }
+  Real s = 1-0.5*x;
+  dT1 = 1/s - 0.5*T2/(T1*s*s);
+  dT2 = 0.5/(s*s);
+  return T1/s;
+}
+
+/**
+ * current J = kb/h*0.5*(T1+T2)*theta*(B(a)*u2/T2 - B(-a)*u1/T1), a = (c*(V2-V1)-2*(T2-T1))/theta,
+ * and its gradient g[6] to (V1, V2, u1, u2, T1, T2).
+ * In_eb is J with c = e/kb, Ip_eb is -J with c = -e/kb
+ */
+inline Real J_eb_grad(Real kb, Real c, Real V1, Real V2, Real u1, Real u2, Real T1, Real T2, Real h, Real *g)
+{
+  Real th1, th2;
+  const Real theta = Theta(T1, T2, th1, th2);
+  const Real a = (c*(V2-V1)-2*(T2-T1))/theta;
+
+  // B(a), B(-a) and dB(a)/da. dB(-a)/da = d+1
+  Real bp, bm, d;
+  bern_pair(a, bp, bm, d);
+
+  const Real K  = kb/h;
+  const Real A  = 0.5*(T1+T2)*theta;
+  const Real F  = bp*u2/T2 - bm*u1/T1;
+  const Real Fa = d*u2/T2 - (d+1)*u1/T1;
+
+  g[0] = -K*A*Fa*c/theta;
+  g[1] =  K*A*Fa*c/theta;
+  g[2] = -K*A*bm/T1;
+  g[3] =  K*A*bp/T2;
+  g[4] =  K*((0.5*theta + 0.5*(T1+T2)*th1)*F + A*(Fa*( 2 - a*th1)/theta + bm*u1/(T1*T1)));
+  g[5] =  K*((0.5*theta + 0.5*(T1+T2)*th2)*F + A*(Fa*(-2 - a*th2)/theta - bp*u2/(T2*T2)));
+  return K*A*F;
+}
+
+/**
+ * energy flux S = -kb*kb/(e*h)*(T1+T2)*theta*(G(a,f)*u2 - G(-a,-f)*u1), G(a,f) = B(a)*B(1.25f)/B(f),
+ * a = (c*(V2-V1)-2*(T2-T1))/theta, f = (c*(V2-V1)-(T2-T1))/theta - log(u2/u1),
+ * and its gradient g[6] to (V1, V2, u1, u2, T1, T2).
+ * Sn_eb is S with c = e/kb, Sp_eb is S with c = -e/kb
+ */
+inline Real S_eb_grad(Real kb, Real e, Real c, Real V1, Real V2, Real u1, Real u2, Real T1, Real T2, Real h, Real *g)
+{
+  Real th1, th2;
+  const Real theta = Theta(T1, T2, th1, th2);
+  const Real q = (c*(V2-V1)-(T2-T1))/theta;
+  const Real a = (c*(V2-V1)-2*(T2-T1))/theta;
+  const Real f = q - log(fabs(u2/u1));
+
+  Real ba, bma, da;
+  bern_pair(a, ba, bma, da);
+  Real bf, bmf, df;
+  bern_pair(f, bf, bmf, df);
+  Real bg, bmg, dg;
+  bern_pair(1.25*f, bg, bmg, dg);
+
+  // the second term B(-a)*R(-f), R(f) = B(1.25f)/B(f), and its derivatives to a and f
+  const Real Rm   = bmg/bmf;
+  const Real G2   = bma*Rm;
+  Real       Pa   = -(da+1)*Rm*u1;
+  Real       Pf   = -bma*(1.25*(dg+1)/bmf - bmg*(df+1)/(bmf*bmf))*u1;
+  Real       P    = -G2*u1;
+
+  // the first term is dropped when it underflows, as Sn_eb does
+  Real G1 = 0;
+  if(!(a > BP4_BERN || 1.25*f > BP4_BERN))
+  {
+    const Real Rp = bg/bf;
+    G1  = ba*Rp;
+    P  += G1*u2;
+    Pa += da*Rp*u2;
+    Pf += ba*(1.25*dg/bf - bg*df/(bf*bf))*u2;
+  }
+
+  const Real K = -kb*kb/(e*h);
+  const Real M = (T1+T2)*theta;
+
+  g[0] = -K*M*(Pa+Pf)*c/theta;
+  g[1] =  K*M*(Pa+Pf)*c/theta;
+  g[2] =  K*M*( Pf/u1 - G2);
+  g[3] =  K*M*(-Pf/u2 + G1);
+  g[4] =  K*((theta + (T1+T2)*th1)*P + M*(Pa*( 2 - a*th1) + Pf*( 1 - q*th1))/theta);
+  g[5] =  K*((theta + (T1+T2)*th2)*P + M*(Pa*(-2 - a*th2) + Pf*(-1 - q*th2))/theta);
+  return K*M*P;
+}
+
+/**
+ * AD value of a flux from its value \p v and gradient \p g to the 6 edge variables
+ */
+inline AutoDScalar ad_chain_eb(Real v, const Real *g,
+                               const AutoDScalar &V1, const AutoDScalar &V2,
+                               const AutoDScalar &u1, const AutoDScalar &u2,
+                               const AutoDScalar &T1, const AutoDScalar &T2)
+{
+  AutoDScalar r(v);
+  const PetscScalar * dV1 = V1.getADValue();
+  const PetscScalar * dV2 = V2.getADValue();
+  const PetscScalar * du1 = u1.getADValue();
+  const PetscScalar * du2 = u2.getADValue();
+  const PetscScalar * dT1 = T1.getADValue();
+  const PetscScalar * dT2 = T2.getADValue();
+  for(unsigned int i=0; i<AutoDScalar::ndir(); ++i)
+    r.setADValue(i, g[0]*dV1[i] + g[1]*dV2[i] + g[2]*du1[i] + g[3]*du2[i] + g[4]*dT1[i] + g[5]*dT2[i]);
+  return r;
+}
+
+
 //-----------------------------------------------------------------------------
 
 inline Real In_eb(Real kb, Real e,  Real V1,  Real V2,
@@ -121,9 +248,9 @@ inline Real In_eb(Real kb, Real e,  Real V1,  Real V2,
 inline AutoDScalar In_eb(Real kb, Real e, const AutoDScalar &V1, const AutoDScalar &V2,
                          const AutoDScalar &n1,const AutoDScalar &n2, const AutoDScalar &Tn1,const AutoDScalar &Tn2, Real h)
 {
-  AutoDScalar theta = Theta(Tn1,Tn2);
-  AutoDScalar alpha = (e/kb*(V2-V1)-2*(Tn2-Tn1))/theta;
-  return kb*0.5*(Tn1+Tn2)*theta*(bern(alpha)*n2/Tn2 - bern(-alpha)*n1/Tn1)/h;
+  Real g[6];
+  Real J = J_eb_grad(kb, e/kb, V1.getValue(), V2.getValue(), n1.getValue(), n2.getValue(), Tn1.getValue(), Tn2.getValue(), h, g);
+  return ad_chain_eb(J, g, V1, V2, n1, n2, Tn1, Tn2);
 }
 
 
@@ -141,9 +268,10 @@ inline Real Ip_eb(Real kb, Real e,  Real V1,  Real V2,
 inline AutoDScalar Ip_eb(Real kb, Real e, const AutoDScalar &V1, const AutoDScalar &V2,
                          const AutoDScalar &p1,const AutoDScalar &p2, const AutoDScalar &Tp1,const AutoDScalar &Tp2, Real h)
 {
-  AutoDScalar theta = Theta(Tp1,Tp2);
-  AutoDScalar alpha = (e/kb*(V2-V1)+2*(Tp2-Tp1))/theta;
-  return kb*0.5*(Tp1+Tp2)*theta*(bern(alpha)*p1/Tp1 - bern(-alpha)*p2/Tp2)/h;
+  Real g[6];
+  Real J = J_eb_grad(kb, -e/kb, V1.getValue(), V2.getValue(), p1.getValue(), p2.getValue(), Tp1.getValue(), Tp2.getValue(), h, g);
+  for(unsigned int i=0; i<6; ++i) g[i] = -g[i];
+  return ad_chain_eb(-J, g, V1, V2, p1, p2, Tp1, Tp2);
 }
 
 
@@ -166,13 +294,9 @@ inline Real Sn_eb(Real kb, Real e,  Real V1,  Real V2,
 inline AutoDScalar Sn_eb(Real kb, Real e, const  AutoDScalar &V1,const  AutoDScalar &V2,
                          const AutoDScalar &n1, const AutoDScalar &n2, const AutoDScalar &Tn1,const AutoDScalar &Tn2, Real h)
 {
-  AutoDScalar theta = Theta(Tn1,Tn2);
-  AutoDScalar alpha = (e/kb*(V2-V1)-2*(Tn2-Tn1))/theta;
-  AutoDScalar phi   = (e/kb*(V2-V1)-(Tn2-Tn1))/theta-log(fabs(n2/n1));
-  AutoDScalar Dn    = kb*0.5*(Tn1+Tn2)/e;
-  if(alpha > BP4_BERN || 1.25*phi > BP4_BERN)
-    return -2.0*kb*Dn/h*theta*( - bern(-alpha)*bern(-1.25*phi)/bern(-phi)*n1);
-  return -2.0*kb*Dn/h*theta*(bern(alpha)*bern(1.25*phi)/bern(phi)*n2 - bern(-alpha)*bern(-1.25*phi)/bern(-phi)*n1);
+  Real g[6];
+  Real S = S_eb_grad(kb, e, e/kb, V1.getValue(), V2.getValue(), n1.getValue(), n2.getValue(), Tn1.getValue(), Tn2.getValue(), h, g);
+  return ad_chain_eb(S, g, V1, V2, n1, n2, Tn1, Tn2);
 }
 
 
@@ -194,13 +318,9 @@ inline Real Sp_eb(Real kb, Real e,  Real V1,  Real V2,
 inline AutoDScalar Sp_eb(Real kb, Real e, const  AutoDScalar &V1,const  AutoDScalar &V2,
                          const AutoDScalar &p1, const AutoDScalar &p2, const AutoDScalar &Tp1,const AutoDScalar &Tp2, Real h)
 {
-  AutoDScalar theta = Theta(Tp1,Tp2);
-  AutoDScalar alpha = (-e/kb*(V2-V1)-2*(Tp2-Tp1))/theta;
-  AutoDScalar phi   = (-e/kb*(V2-V1)-(Tp2-Tp1))/theta-log(fabs(p2/p1));
-  AutoDScalar Dp    = kb*0.5*(Tp1+Tp2)/e;
-  if(alpha > BP4_BERN || 1.25*phi > BP4_BERN)
-    return -2.0*kb*Dp/h*theta*(- bern(-alpha)*bern(-1.25*phi)/bern(-phi)*p1);
-  return   -2.0*kb*Dp/h*theta*(bern(alpha)*bern(1.25*phi)/bern(phi)*p2 - bern(-alpha)*bern(-1.25*phi)/bern(-phi)*p1);
+  Real g[6];
+  Real S = S_eb_grad(kb, e, -e/kb, V1.getValue(), V2.getValue(), p1.getValue(), p2.getValue(), Tp1.getValue(), Tp2.getValue(), h, g);
+  return ad_chain_eb(S, g, V1, V2, p1, p2, Tp1, Tp2);
 }
 
 
@@ -0,0 +1,251 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+//  $Id: mat_slot_map.h,v 1.1 2008/07/09 05:58:16 gdiso Exp $
+
+#ifndef __mat_slot_map_h__
+#define __mat_slot_map_h__
+
+#include <vector>
+#include <map>
+
+#include "petscmat.h"
+#include "genius_common.h"
+
+
+/**
+ * precomputed slots of the nonzero entries of a (MPI/Seq) AIJ matrix.
+ *
+ * PETSc searches the column of every entry in each MatSetValues call. Since the nonzero
+ * pattern of the jacobian matrix is fixed after its first assembly, the position of each
+ * entry in the AIJ value array can be located once and reused by every Newton iteration.
+ * the slot of a local entry is its index in the value array of the diagonal block (>=0),
+ * or -(index+2) for the entry in the off-diagonal block of MPIAIJ matrix.
+ */
+class MatSlotMap
+{
+public:
+
+  /**
+   * constructor, the map is empty
+   */
+  MatSlotMap();
+
+  /**
+   * the slot of the entry which belongs to other processor, it is skipped by add()
+   */
+  static const PetscInt skip_slot = -1;
+
+  /**
+   * the entry is not in the nonzero pattern of local rows
+   */
+  static const PetscInt invalid_slot = -2147483647;
+
+  /**
+   * build the map from the nonzero pattern of assembled matrix A.
+   * only rows on this processor are recorded
+   */
+  PetscErrorCode build(Mat A);
+
+  /**
+   * clear the map
+   */
+  void clear();
+
+  /**
+   * @return true when the map has been built
+   */
+  bool valid() const
+  { return _valid; }
+
+  /**
+   * @return a stamp which is changed every time the map is built,
+   * block caches compare it to find out outdated slots. the stamps are taken
+   * from one process wide counter, so the maps of different solvers never share one
+   */
+  unsigned int stamp() const
+  { return _stamp; }
+
+  /**
+   * @return the slot of entry (row, col). skip_slot if row not on this processor,
+   * invalid_slot if the entry is not in the nonzero pattern
+   */
+  PetscInt slot(PetscInt row, PetscInt col) const;
+
+  /**
+   * append the slots of all the entries of local \p row to \p slots
+   */
+  void row_slots(PetscInt row, std::vector<PetscInt> &slots) const;
+
+  /**
+   * locate the slots of the dense block rows x cols, row major.
+   * negative rows are skipped, as MatSetValues does.
+   * @return false if any entry of local rows is not in the nonzero pattern
+   */
+  bool locate(PetscInt m, const PetscInt rows[], PetscInt n, const PetscInt cols[], std::vector<PetscInt> &slots) const;
+
+  /**
+   * get the value arrays of matrix A. values can be added by slots till end() is called.
+   * A must be the matrix this map built from, and should be assembled
+   */
+  PetscErrorCode begin(Mat A);
+
+  /**
+   * restore the value arrays of matrix A
+   */
+  PetscErrorCode end(Mat A);
+
+  /**
+   * @return true between begin() and end()
+   */
+  bool active() const
+  { return _ad!=0; }
+
+  /**
+   * add n values to the matrix by slots, entries with skip_slot are ignored
+   */
+  void add(PetscInt n, const PetscInt slots[], const PetscScalar v[])
+  {
+    for(PetscInt i=0; i<n; ++i)
+    {
+      const PetscInt s = slots[i];
+      if( s >= 0 )              _ad[s] += v[i];
+      else if( s != skip_slot ) _ao[-(s+2)] += v[i];
+    }
+  }
+
+  /**
+   * get n values of the matrix by slots, entries with skip_slot are 0
+   */
+  void get(PetscInt n, const PetscInt slots[], PetscScalar v[]) const
+  {
+    for(PetscInt i=0; i<n; ++i)
+    {
+      const PetscInt s = slots[i];
+      if( s >= 0 )              v[i] = _ad[s];
+      else if( s != skip_slot ) v[i] = _ao[-(s+2)];
+      else                      v[i] = 0.0;
+    }
+  }
+
+  /**
+   * register the slot map of matrix A, so the assembly routines which only know A can find it
+   */
+  static void attach(Mat A, MatSlotMap *map);
+
+  /**
+   * remove the slot map of matrix A
+   */
+  static void detach(Mat A);
+
+  /**
+   * @return the slot map registered with matrix A, NULL if none
+   */
+  static MatSlotMap * get(Mat A);
+
+private:
+
+  bool           _valid;
+
+  unsigned int   _stamp;
+
+  /**
+   * the last stamp given to a map
+   */
+  static unsigned int _stamp_counter;
+
+  /**
+   * local row range [_row_begin, _row_end)
+   */
+  PetscInt       _row_begin, _row_end;
+
+  /**
+   * CSR of local rows, global column sorted in each row
+   */
+  std::vector<PetscInt> _row_ptr;
+
+  std::vector<PetscInt> _col;
+
+  std::vector<PetscInt> _pos;
+
+  /**
+   * diagonal and off-diagonal block of MPIAIJ matrix, or the SeqAIJ matrix itself with NULL _Ao
+   */
+  Mat            _Ad, _Ao;
+
+  /**
+   * value arrays, only valid between begin() and end()
+   */
+  PetscScalar   *_ad, *_ao;
+
+  static std::map<Mat, MatSlotMap *> _registry;
+};
+
+
+
+/**
+ * cache of slots for a sequence of dense blocks, i.e. one block per cell.
+ * the slots are located on the first visit after the slot map is (re)built.
+ */
+class MatBlockSlotCache
+{
+public:
+
+  MatBlockSlotCache() : _stamp(0) {}
+
+  /**
+   * @return the slots of block b, rows x cols in row major.
+   * NULL if the block has entries out of the nonzero pattern, caller should fall back to MatSetValues
+   */
+  const PetscInt * slots(const MatSlotMap &map, unsigned int b, PetscInt m, const PetscInt rows[], PetscInt n, const PetscInt cols[])
+  {
+    if( _stamp != map.stamp() )
+    {
+      _slots.clear();
+      _located.clear();
+      _stamp = map.stamp();
+    }
+    if( b >= _slots.size() )
+    {
+      _slots.resize(b+1);
+      _located.resize(b+1, char(-1));
+    }
+    if( _located[b] < 0 )
+      _located[b] = map.locate(m, rows, n, cols, _slots[b]) ? 1 : 0;
+    return _located[b] ? &(_slots[b][0]) : 0;
+  }
+
+  /**
+   * clear the cache
+   */
+  void clear()
+  { _slots.clear(); _located.clear(); _stamp=0; }
+
+private:
+
+  unsigned int _stamp;
+
+  std::vector< std::vector<PetscInt> > _slots;
+
+  std::vector<char> _located;
+};
+
+#endif // #define __mat_slot_map_h__
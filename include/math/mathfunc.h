@@ -3,10 +3,7 @@
 
 
 #include "brkpnts.h"
-
-#ifdef HAVE_GSL
-#include <gsl/gsl_sf_fermi_dirac.h>
-#endif
+#include "fermi_dirac.h"
 
 #ifdef LINUX
 #include <fenv.h>
@@ -282,115 +279,43 @@ inline Real pd1erf ( Real x )
 
 
 /* ----------------------------------------------------------------------------
- * fermi_half:  This function returns value of 1/2 order Fermi-Dirac Integral
+ * fermi_half:  This function returns value of 1/2 order Fermi-Dirac Integral,
+ * see FermiDirac::half, the relative error is below 2e-12
  */
 inline Real fermi_half(Real x)
 {
-#ifdef HAVE_GSL
-  return Real(gsl_sf_fermi_dirac_half(double(x)));
-#else
-  /* use an analytic expression. The result achieves within 0.4% error in all ranges.*/
-  if(x<-4.5)
-  {
-    //for small arguments, fhfp and exp are almost identical.
-    return 1.0/exp(-x);
-  }
-  else if(x<0.0)
-  {
-    Real v = std::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
-    Real p = 1.329340388179*std::pow(v,Real(-0.375));
-    return 1.0/(exp(-x) + p);
-  }
-  else
-  {
-    Real v = std::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
-    Real p = 1.329340388179*std::pow(v,Real(-0.375));
-    return 1.0/(1.0/exp(x) + p);
-  }
-#endif
+  return FermiDirac::half(x);
 }
 
 
-inline AutoDScalar fermi_half(AutoDScalar x)
+/* ----------------------------------------------------------------------------
+ * fermi_half:  AD version of fermi_half, the derivative is F-1/2
+ */
+template <unsigned int N>
+inline AutoDScalarT<N> fermi_half(const AutoDScalarT<N> &x)
 {
-#ifdef HAVE_GSL
-  genius_error();
-#else
-  /* use an analytic expression. The result achieves within 0.4% error in all ranges.*/
-  if(x<-4.5)
-  {
-    //for small arguments, fhfp and exp are almost identical.
-    return 1.0/exp(-x);
-  }
-  else if(x<0.0)
-  {
-    AutoDScalar v = adtl::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
-    AutoDScalar p = 1.329340388179*adtl::pow(v,Real(-0.375));
-    return 1.0/(exp(-x) + p);
-  }
-  else
-  {
-    AutoDScalar v = adtl::pow(x,4) + 50 + 33.6*x*(1-0.68*exp(-0.17*(x+1)*(x+1)));
-    AutoDScalar p = 1.329340388179*adtl::pow(v,Real(-0.375));
-    return 1.0/(1.0/exp(x) + p);
-  }
-#endif
+  Real f, df;
+  FermiDirac::half(x.getValue(), f, df);
+
+  AutoDScalarT<N> tmp;
+  tmp.setValue(f);
+  for (unsigned int i=0; i<AutoDScalarT<N>::ndir(); ++i)
+    tmp.setADValue(i, df*x.getADValue(i));
+  return tmp;
 }
 
 
 /*-----------------------------------------------------------------------
  *
  *     fhfm evaluates the fermi-dirac integral of minus one-half order
- *     f-1/2(x) from x
+ *     f-1/2(x) from x, see FermiDirac::mhalf
  */
 inline Real fermi_mhalf(Real x)
 {
-#ifdef HAVE_GSL
-  return Real(gsl_sf_fermi_dirac_mhalf(double(x)));
-#else
-/*     the formulae used are after j.s. blakemore, ''semiconductor
- *     statistics,'' new york: pergamon press, appendix c, 1962, for
- *     x greater than or equal to 5.5; when x is less than 5.5,
- *     f-1/2=1/(1/f+a+2*b*f+3*c*f*f+4*d*f*f*f) where f=f1/2 and it
- *     is the derivative of approximate form of f1/2 (see function
- *     fermi_half)
- *     the maximum relative error is about 1.2%
- */
-  Real a=3.53553e-1,b=4.95009e-3,c=1.48386e-4,d=4.42563e-6;
-  if(x<-4.5)
-  {
-    //for small argument, fhfm1 and exp are almost identical.
-    return exp(x);
-  }
-  else
-  {
-    if(x<5.5)
-    {
-      Real f=fermi_half(x);
-      return f/(1.0+f*(a+f*(-2.0*b+f*(3*c-4*d*f))));
-    }
-    else
-      return 2.0*x/(SQRTPI*std::pow((x*x+0.6),Real(0.25)));
-  }
-#endif
+  return FermiDirac::mhalf(x);
 }
 
 
-/* ----------------------------------------------------------------------------
- * fermi_half:  AD version of fermi_half
- */
-
-/*
-inline AutoDScalar fermi_half(const AutoDScalar &x)
-{
-    AutoDScalar tmp;
-    tmp.setValue(fermi_half(x.getValue()));
-    for (unsigned int i=0; i<AutoDScalar::numdir; ++i)
-      tmp.setADValue(i, fermi_mhalf(x.getValue())*x.getADValue(i) );
-    return tmp;
-}
-*/
-
 /*-----------------------------------------------------------------------
  *
  *     fhfm2 evaluates the fermi-dirac integral of minus one-half order
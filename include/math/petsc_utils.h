@@ -98,6 +98,12 @@ namespace PetscUtils
   extern PetscErrorCode  VecAddRowToRow(Vec vec, std::vector<PetscInt> & src_rows, std::vector<PetscInt> & dst_rows, std::vector<PetscScalar> & alpha);
 
 
+  /**
+   * @brief collect the clear rows of all the processors, sorted and without duplicates.
+   * it is collective, the caller should keep the result as long as the clear rows do not change
+   */
+  extern void GlobalClearRows(const std::vector<PetscInt> & clear_rows, std::vector<PetscInt> & all_clear_rows);
+
  /**-------------------------------------------------------------------
   * @brief add source rows to destination rows, and clear some rows
   *
@@ -105,11 +111,14 @@ namespace PetscUtils
   * @param  src_rows   source rows
   * @param  dst_rows   the destination rows will be added to
   * @param  clear_rows the rows to be cleared .
+  * @param  all_clear_rows the clear rows of all the processors, by GlobalClearRows
   *
-  * @note   If vec is not assembled, this function will do it for you. the src row should on local processor.
+  * @note   vec should be assembled, the src and clear rows should on local processor.
+  *         only ADD_VALUES is used and vec is NOT assembled on return.
   *
   */
-  extern PetscErrorCode  VecAddClearRow(Vec vec, std::vector<PetscInt> & src_rows, std::vector<PetscInt> & dst_rows, std::vector<PetscInt> & clear_rows);
+  extern PetscErrorCode  VecAddClearRow(Vec vec, std::vector<PetscInt> & src_rows, std::vector<PetscInt> & dst_rows, std::vector<PetscInt> & clear_rows,
+                                        const std::vector<PetscInt> & all_clear_rows);
 
   /**
    * @brief add source rows to destination rows, multi by alpha
@@ -173,11 +182,14 @@ namespace PetscUtils
    * @param  src_rows   source rows
    * @param  dst_rows   the destination rows will be added to
    * @param  clear_rows the rows to be cleared
+   * @param  all_clear_rows the clear rows of all the processors, by GlobalClearRows
    *
-   * @note   If mat is not assembled, this function will do it for you. the src row should on local processor.
+   * @note   mat should be assembled, the src row should on local processor.
+   *         only ADD_VALUES is used after the rows are cleared, mat is NOT assembled on return.
    *
    */
-  //extern PetscErrorCode  MatAddClearRow(Mat mat, std::vector<PetscInt> & src_rows, std::vector<PetscInt> & dst_rows, std::vector<PetscInt> & clear_rows);
+  extern PetscErrorCode  MatAddClearRow(Mat mat, std::vector<PetscInt> & src_rows, std::vector<PetscInt> & dst_rows, std::vector<PetscInt> & clear_rows,
+                                        const std::vector<PetscInt> & all_clear_rows);
 
   /**
    * @brief add real DenseVector to PetscVec by dof_indices
@@ -219,6 +231,26 @@ namespace PetscUtils
    */
   extern PetscErrorCode  MatAdd(Mat mat, const DenseMatrix<Complex> &complex_mat, const std::vector<PetscInt> & dof_indices);
 
+
+  /**
+   * @brief replace the value array of a host (seq/mpi) vector by a zeroed one placed by first touch
+   *
+   * @param  vec        Petsc Vector, just created
+   *
+   * @note   PETSC zeroes the array by one thread at creation, which puts all the pages on one NUMA node.
+   *         other vector types (i.e. GPU vector) are left as they are.
+   */
+  extern PetscErrorCode  VecFirstTouch(Vec vec);
+
+  /**
+   * @brief zero the value arrays of a preallocated AIJ matrix by the threads, so the pages are placed by first touch
+   *
+   * @param  mat        Petsc Matrix, preallocated but not assembled yet
+   *
+   * @note   only (MPI/Seq) AIJ matrix, which is the one the slot map assembly writes into. others are left as they are.
+   */
+  extern PetscErrorCode  MatFirstTouch(Mat mat);
+
 }
 
 #endif //#define __petsc_utils_h__
@@ -202,6 +202,12 @@ public:
   unsigned int n_boundary_conds () const
   { return _boundary_side_id.size(); }
 
+  /**
+   * @returns the number of node-based boundary conditions.
+   */
+  unsigned int n_boundary_nodes () const
+  { return _boundary_node_id.size(); }
+
 
   /**
    * @return a list of nodes on boundary side, nodes are sorted by their id, node on the interface of two boundary will exist on both side
@@ -209,6 +215,29 @@ public:
   void boundary_side_nodes_with_id ( std::map<short int, std::set<const Node *> > & boundary_side_nodes_id_map) const;
 
 
+  /**
+   * iterator over the (elem, side) pairs with a given boundary id
+   */
+  typedef std::vector< std::pair<const Elem *, unsigned short int> >::const_iterator side_iterator;
+
+  /**
+   * iterator over the nodes with a given boundary id
+   */
+  typedef std::vector<const Node *>::const_iterator node_iterator;
+
+  /**
+   * @return the range of (elem, side) pairs with boundary_id, in the order of _boundary_side_id.
+   * the elem may not be active. the range is valid until the next add/remove/clear operator
+   */
+  std::pair<side_iterator, side_iterator> boundary_sides(short int boundary_id) const;
+
+  /**
+   * @return the range of nodes with boundary_id, they are NOT ordered by node id.
+   * the range is valid until the next add/remove/clear operator
+   */
+  std::pair<node_iterator, node_iterator> boundary_nodes(short int boundary_id) const;
+
+
   // NOTE: node are created by build_node_ids_from_priority_order for the following functions.
 
   /**
@@ -410,6 +439,27 @@ public:
    */
   std::set<short int> _boundary_ids;
 
+  /**
+   * index of _boundary_side_id and _boundary_node_id by boundary id in CSR format,
+   * built on demand and dropped when the boundary information changes.
+   * the entries of the n-th boundary id in _side_index_ids are
+   * _side_index[_side_index_begin[n]] ... _side_index[_side_index_begin[n+1]-1], the same for nodes
+   */
+  mutable bool _index_valid;
+
+  mutable std::vector<short int>    _side_index_ids;
+  mutable std::vector<unsigned int> _side_index_begin;
+  mutable std::vector< std::pair<const Elem *, unsigned short int> > _side_index;
+
+  mutable std::vector<short int>    _node_index_ids;
+  mutable std::vector<unsigned int> _node_index_begin;
+  mutable std::vector<const Node *> _node_index;
+
+  /**
+   * (re)build the boundary id index
+   */
+  void build_index() const;
+
 
   /**
    * data structure for convert label to index
@@ -0,0 +1,74 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+//  $Id: fvm_geometry_cache.h,v 1.1 2008/07/09 05:58:16 gdiso Exp $
+
+#ifndef __fvm_geometry_cache_h__
+#define __fvm_geometry_cache_h__
+
+#include <string>
+#include <vector>
+
+class Elem;
+
+/**
+ * binary cache of the FVM geometry (control volumes, cv surface areas and the
+ * least squares matrices) built by Elem::prepare_for_fvm().
+ *
+ * a run over the same mesh can restore the geometry of its FVM elements from the
+ * cache instead of computing it again. the cache is keyed by a hash of the element
+ * ids, types, node ids and node coordinates, so any change of the mesh or of the
+ * partition invalidates it. each processor has its own file.
+ *
+ * file layout: magic, version, hash, number of elements, number of values, values
+ */
+namespace FVMGeometryCache
+{
+  /**
+   * the version of cache file layout, increase it when any n_fvm_geometry() changes
+   */
+  const unsigned int version = 1;
+
+  /**
+   * @return the cache file name of this processor with \p prefix
+   */
+  std::string file_name(const std::string &prefix);
+
+  /**
+   * @return the hash of the elements, in the order of \p elems
+   */
+  unsigned long long mesh_hash(const std::vector<Elem *> &elems);
+
+  /**
+   * restore the FVM geometry of \p elems from the \p file.
+   * @return false if the file is missing or does not match the elements,
+   * nothing is changed in this case.
+   */
+  bool load(const std::string &file, const std::vector<Elem *> &elems);
+
+  /**
+   * write the FVM geometry of \p elems to \p file
+   * @return false if the file can not be written
+   */
+  bool save(const std::string &file, const std::vector<Elem *> &elems);
+}
+
+#endif
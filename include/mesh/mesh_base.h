@@ -356,8 +356,28 @@ public:
 
 
   /**
-   * reorder the node index by Reverse Cuthill-McKee Algorithm
-   * which can reduce filling in LU (ILU) Factorization
+   * the reorder strategy of nodes and elements in prepare_for_use()
+   */
+  enum ReorderType { REORDER_NONE, REORDER_RCM, REORDER_HILBERT };
+
+  /**
+   * set the reorder strategy, default is REORDER_RCM
+   */
+  void set_reorder_type (ReorderType t)
+  { _reorder_type = t; }
+
+  /**
+   * @return the reorder strategy
+   */
+  ReorderType reorder_type () const
+  { return _reorder_type; }
+
+  /**
+   * reorder the node (and element) index by the strategy of reorder_type().
+   * REORDER_RCM reorders nodes by Reverse Cuthill-McKee Algorithm
+   * which can reduce filling in LU (ILU) Factorization.
+   * REORDER_HILBERT sorts nodes and elements along the Hilbert curve
+   * which gives better cache reuse in assembly.
    */
   virtual void reorder_nodes ()
   {genius_error();}
@@ -401,14 +421,26 @@ public:
    * is called from Mesh::read after reading an xda file.  It prevents
    * the renumbering of nodes and elements.  In general, leave this at
    * the default value of false.
+   *
+   * The elements_added_only flag is true when elements have only been
+   * added (i.e. by mesh refinement), so the point locator is updated
+   * in place instead of being rebuilt.
    */
-  virtual void prepare_for_use (const bool skip_renumber_nodes_and_elements=false);
+  virtual void prepare_for_use (const bool skip_renumber_nodes_and_elements=false, const bool elements_added_only=false);
 
   /**
    * Call the default partitioner (currently \p metis_partition()).
    */
   void partition (const unsigned int n_parts=Genius::n_processors());
 
+  /**
+   * Partition the mesh again, i.e. after mesh refinement. The new partition is
+   * relabeled to keep as many elements as possible on their old processor,
+   * so that the least data have to be moved between processors.
+   * should be called by all the processors.
+   */
+  void repartition (const unsigned int n_parts=Genius::n_processors());
+
   /**
    * Returns the number of subdomains in the global mesh. Note that it is
    * convenient to have one subdomain on each processor on parallel machines,
@@ -476,6 +508,55 @@ public:
   int subdomain_weight(unsigned int id) const
   { genius_assert(id<_subdomain_materials.size()); return (*_subdomain_weight.find(id)).second; }
 
+  /**
+   * set the extra weight of each labeled boundary side
+   */
+  void set_boundary_weight(int weight)
+  { _boundary_weight = weight; }
+
+  /**
+   * @return the extra weight of each labeled boundary side
+   */
+  int boundary_weight() const
+  { return _boundary_weight; }
+
+  /**
+   * set the weight of dual graph edges which cross region interfaces or labeled boundaries
+   */
+  void set_interface_weight(int weight)
+  { _interface_weight = weight; }
+
+  /**
+   * @return the weight of dual graph edges which cross region interfaces or labeled boundaries
+   */
+  int interface_weight() const
+  { return _interface_weight; }
+
+  /**
+   * @return the weight of elem used by partitioner, which is the subdomain weight
+   * times the number of nodes, plus the boundary weight for each labeled side
+   */
+  int partition_weight(const Elem * elem) const
+  { return partition_dof_weight(elem) + partition_bc_weight(elem); }
+
+  /**
+   * @return the subdomain weight times the number of nodes of elem
+   */
+  int partition_dof_weight(const Elem * elem) const
+  { return this->subdomain_weight( elem->subdomain_id () ) * elem->n_nodes(); }
+
+  /**
+   * @return the boundary weight for each labeled side of elem
+   */
+  int partition_bc_weight(const Elem * elem) const;
+
+  /**
+   * @return the weight of the dual graph edge between elem and its active face neighbor,
+   * which is the interface weight when they lie in different regions or the face is labeled,
+   * so the partitioner avoids to cut the region interfaces and electrodes
+   */
+  int partition_edge_weight(const Elem * elem, const Elem * neighbor) const;
+
   /**
    * Returns the number of partitions which have been defined via
    * a call to either mesh.partition() or by building a Partitioner
@@ -743,6 +824,16 @@ protected:
    */
   std::map<unsigned int, int> _subdomain_weight;
 
+  /**
+   * the extra weight for boundary condition workload
+   */
+  int _boundary_weight;
+
+  /**
+   * the weight of dual graph edges across region interfaces and labeled boundaries
+   */
+  int _interface_weight;
+
 
   /**
    * The number of partitions the mesh has.  This is set by
@@ -765,6 +856,11 @@ protected:
    */
   bool _is_prepared;
 
+  /**
+   * the reorder strategy of nodes and elements
+   */
+  ReorderType _reorder_type;
+
   /**
    * A \p PointLocator class for this mesh.
    * This will not actually be built unless needed. Further, since we want
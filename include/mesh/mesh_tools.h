@@ -235,6 +235,23 @@ namespace MeshTools
     */
    void find_hanging_nodes_and_parents(const MeshBase& mesh, std::map<unsigned int, std::vector<unsigned int> >& hanging_nodes);
 
+   /**
+    * @return the index of point \p p along the Hilbert space filling curve
+    * which covers the box \p bbox. only the first \p dim coordinates are used.
+    * each coordinate is quantized to 21 bits, so the key fits 63 bits.
+    * sort geometric objects by this key gives them good memory locality.
+    */
+   unsigned long long hilbert_key(const Point &p, const BoundingBox &bbox, unsigned int dim);
+
+   /**
+    * build the FVM geometry of \p elems by threads.
+    * a quality pre-pass flags the obtuse elements first, then the elements are
+    * processed in batches of the same type and obtuse flag, so the threads run
+    * the same branch of the geometry kernel.
+    * @return the number of obtuse elements
+    */
+   unsigned int prepare_for_fvm(const std::vector<Elem *> &elems);
+
 } // end namespace MeshTools
 
 
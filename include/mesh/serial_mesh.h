@@ -188,6 +188,18 @@ class SerialMesh : public UnstructuredMesh
    */
   virtual void reorder_nodes ();
 
+private:
+
+  /**
+   * reorder the node index by Reverse Cuthill-McKee Algorithm
+   */
+  void reorder_nodes_rcm ();
+
+  /**
+   * sort nodes and elements along the Hilbert curve
+   */
+  void reorder_nodes_and_elems_hilbert ();
+
 public:
   /**
    * Elem iterator accessor functions.
@@ -28,6 +28,10 @@
 
 /**
  * the simple quad4 mesh generator
+ *
+ * the mesh is a tensor product of X.MESH/Y.MESH lines. the region of each cell and the
+ * boundary mark of each grid edge are kept in flat arrays indexed by grid position,
+ * the nodes, elements, boundary and interface sides are created directly from them.
  */
 class MeshGeneratorQuad4 : public MeshGenerator
 {
@@ -77,9 +81,19 @@ private:
   Parser::InputParser & _decks;
 
   /**
-   * the data structure for reserved boundary edge in xy plane
+   * boundary mark of the grid edge from (i,j) to (i+1,j), indexed by i + (IX-1)*j, 0 for none
    */
-  std::map<SkeletonEdge, int, lt_edge>        edge_table;
+  std::vector<int>                            x_edge_mark;
+
+  /**
+   * boundary mark of the grid edge from (i,j) to (i,j+1), indexed by i + IX*j, 0 for none
+   */
+  std::vector<int>                            y_edge_mark;
+
+  /**
+   * region index of the cell (i,j), indexed by i + (IX-1)*j
+   */
+  std::vector<int>                            cell_region;
 
  /**
    * the user specified face information
@@ -121,10 +135,9 @@ private:
                  const std::string &label);
 
   /**
-   * get the region index of a quad4 cell by its bound
+   * fill the region index of all the cells, if region is overlaped, the last defined region wins
    */
-  int  get_cell_region_id(unsigned int ixmin, unsigned int ixmax,
-                          unsigned int iymin, unsigned int iymax);
+  void build_cell_region();
 
 };
 
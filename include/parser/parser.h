@@ -25,8 +25,10 @@
 #define __parser_h_
 
 // C++ header file
+#include <cstdio>
 #include <stack>
 #include <list>
+#include <iterator>
 
 #include "key.h"
 #include "pattern.h"
@@ -66,6 +68,44 @@ namespace Parser
       return 0;
     }
 
+    /**
+     * read card from the text of user's file in memory, i.e. the buffer of SharedFile.
+     * the text is read in place, without copy. the cards are appended to the ones already read
+     */
+    int read_card_buffer(const char *data, size_t size)
+    {
+      // no card in empty file
+      if( size == 0 )
+        return 0;
+
+      InputYY::yyin = fmemopen(const_cast<char *>(data), size, "r");
+
+      if( InputYY::yyin == NULL )
+        return 1;
+
+      const size_t n_old = _card_list.size();
+
+      if( InputYY::yyparse((void*)this) )
+        return 1;
+
+      fclose(InputYY::yyin);
+
+      // only the new cards need check
+      std::list<Card>::iterator it = _card_list.begin();
+      std::advance(it, n_old);
+      for( ; it!=_card_list.end(); it++ )
+      {
+        _pattern.check_detail(*it);
+      }
+      return 0;
+    }
+
+    /**
+     * @return the number of cards read
+     */
+    size_t n_cards() const
+    { return _card_list.size(); }
+
     /**
      * card search begin
      */
@@ -154,6 +154,26 @@ namespace Parser
      * @returns zero if successful
      */
     int get_from_XML(const std::string &);
+
+    /**
+     * read pattern description from the binary cache file when it was built from the
+     * same xml file (same size and modification time), otherwise parse the xml file
+     * and rebuild the cache. an empty cache file name disables the cache.
+     * @returns zero if successful
+     */
+    int get_from_XML(const std::string &, const std::string &cache_file);
+
+    /**
+     * read pattern description from binary cache file of xml file fname
+     * @returns zero if successful, nonzero if the cache is missing, broken or out of date
+     */
+    int get_from_cache(const std::string &cache_file, const std::string &fname);
+
+    /**
+     * save pattern description, which was read from xml file fname, to binary cache file
+     * @returns zero if successful
+     */
+    int save_to_cache(const std::string &cache_file, const std::string &fname) const;
   };
 
 }
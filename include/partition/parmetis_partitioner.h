@@ -0,0 +1,70 @@
+// $Id: parmetis_partitioner.h,v 1.1 2008/03/20 13:16:25 gdiso Exp $
+
+// The libMesh Finite Element Library.
+// Copyright (C) 2002-2007  Benjamin S. Kirk, John W. Peterson
+  
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+  
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+  
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+
+#ifndef __parmetis_partitioner_h__
+#define __parmetis_partitioner_h__
+
+// C++ Includes   -----------------------------------
+
+// Local Includes -----------------------------------
+#include "partitioner.h"
+
+
+
+/**
+ * The \p ParmetisPartitioner partitions the elements with the parallel
+ * graph partitioner of PETSc (ParMETIS by default, PT-Scotch by -mat_partitioning_type ptscotch).
+ * each processor only builds and holds the dual graph of a contiguous block of
+ * active elements, and the result is gathered to all the processors.
+ * falls back to \p MetisPartitioner when running on a single processor.
+ */
+
+// ------------------------------------------------------------
+// ParmetisPartitioner class definition
+class ParmetisPartitioner : public Partitioner
+{
+ public:
+
+  /**
+   * Constructor.
+   */
+  ParmetisPartitioner () {}
+
+  /**
+   * @return true when PETSc is configured with a parallel graph partitioner
+   */
+  static bool available ();
+
+protected:
+  /**
+   * Partition the \p MeshBase into \p n subdomains.
+   */
+  virtual void _do_partition (MeshBase& mesh,
+			      const unsigned int n);
+
+private:
+};
+
+
+
+
+#endif // #define __parmetis_partitioner_h__
@@ -23,6 +23,7 @@
 #define __partitioner_h__
 
 // C++ Includes   -----------------------------------
+#include <vector>
 
 // Local Includes -----------------------------------
 #include "genius_env.h"
@@ -73,7 +74,9 @@ class Partitioner
    * Repartitions the \p MeshBase into \p n parts.  This
    * is required since some partitoning algorithms can repartition
    * more efficiently than computing a new partitioning from scratch.
-   * The default behavior is to simply call this->partition(n)
+   * The default behavior is to simply call this->partition(n),
+   * and then relabel the new subdomains to keep as many elements
+   * as possible on their old processor.
   */
   void repartition (MeshBase& mesh,
 		    const unsigned int n=Genius::n_processors());
@@ -105,6 +108,15 @@ protected:
   virtual void _do_repartition (MeshBase& mesh,
 				const unsigned int n) { this->_do_partition (mesh, n); }
 
+  /**
+   * Relabel the subdomains of the new partition, which maximizes the (weighted)
+   * elements whose processor id is not changed from \p old_pid.
+   * \p old_pid holds the processor id of each active element before repartition.
+   */
+  void _remap_processor_ids(MeshBase& mesh,
+                            const std::vector<unsigned int> & old_pid,
+                            const unsigned int n);
+
   /**
    * This function is called after partitioning to set the processor IDs
    * for the nodes.  By definition, a Node's processor ID is the minimum
@@ -26,6 +26,7 @@
 #include <vector>
 #include <string>
 #include <utility>
+#include <map>
 
 // Local includes
 #include "genius_common.h"
@@ -322,6 +323,12 @@ protected:
    * The value of the quadrature weights.
    */
   std::vector<Real> _weights;
+
+  /**
+   * The points and weights built for each element type and p level,
+   * so that switching between element types does not rebuild the rule
+   */
+  std::map<std::pair<ElemType, unsigned int>, std::pair<std::vector<Point>, std::vector<Real> > > _rules;
 };
 
 
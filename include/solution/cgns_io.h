@@ -27,6 +27,8 @@
 
 // C++ includes
 #include <map>
+#include <vector>
+#include <string>
 
 // Local includes
 #include "genius_common.h"
@@ -37,6 +39,8 @@
 
 // Forward declarations
 class MeshBase;
+class SimulationRegion;
+class FVM_NodeData;
 
 
 
@@ -77,6 +81,13 @@ public:
    */
   virtual void write (const std::string& );
 
+  /**
+   * only import the solution fields in \p fields, each item is a solution name
+   * (i.e. Doping, Mole) or a field name (i.e. Na, potential). empty for all the fields
+   */
+  void set_fields(const std::vector<std::string> & fields)
+  { _fields = fields; }
+
 
 private:
 // some id for cgns file read/write
@@ -137,9 +148,16 @@ private:
   std::vector< std::map<int, unsigned int > > region_global_id_to_node_id;
 
   /**
-   * region solution
+   * the solution fields to be imported
+   */
+  std::vector<std::string> _fields;
+
+  /**
+   * the solution name, field name and cgns solution id of the fields to be imported in each region
    */
-  std::vector< std::map<std::pair<std::string,std::string>, std::vector<double> > > region_solutions;
+  std::vector< std::vector<std::string> > region_field_solution;
+  std::vector< std::vector<std::string> > region_field_name;
+  std::vector< std::vector<int> >         region_field_solution_id;
 
   /**
    * unit of solution
@@ -151,6 +169,22 @@ private:
    */
   std::map< short int, double > electrode_potential;
 
+  /**
+   * @return true if the field is required by user
+   */
+  bool _field_selected(const std::string &solution_name, const std::string &field_name) const;
+
+  /**
+   * @return true if the field can be loaded into region
+   */
+  bool _field_acceptable(const SimulationRegion * region, const std::string &solution_name, const std::string &field_name) const;
+
+  /**
+   * set the value of field to node data
+   */
+  void _set_node_field(const SimulationRegion * region, FVM_NodeData * node_data,
+                       const std::string &solution_name, const std::string &field_name, double value) const;
+
   /**
    * aux function to sort x by increase order of id
    */
@@ -72,6 +72,17 @@ public:
    */
   int mainloop();
 
+  /**
+   * run the cards of the deck from the n-th one, i.e. the cards appended by DeckServer
+   * to the deck of a finished mainloop(). the simulation system is kept
+   */
+  int run_cards(size_t first);
+
+  /**
+   * run one command card
+   */
+  int do_card(const Parser::Card & c);
+
   /**
    * set the input deck
    */
@@ -139,6 +150,13 @@ public:
    */
   int  do_solve   ( const Parser::Card & c );
 
+  /**
+   * run the transient of SOLVE card once for each particle strike of the campaign file.
+   * all the strikes start from the state in memory, i.e. the DC operating point solved before,
+   * the collected charge of each electrode is written to <out.prefix>.campaign.dat
+   */
+  int  do_strike_campaign ( const Parser::Card & c );
+
   /**
    * process and do "EXPORT" card
    */
@@ -161,6 +179,11 @@ public:
    */
   int do_ray_trace( const Parser::Card & c );
 
+  /**
+   * create stress solver, solve the load cases of STRESS.LOAD cards before "STRESS" card
+   */
+  int do_stress_solve( const Parser::Card & c );
+
   /**
    * process and do "NODESET" card
    */
@@ -186,6 +209,13 @@ public:
    */
   int do_refine_hierarchical ( const Parser::Card & c );
 
+  /**
+   * process and do "REFINE.ADAPTIVE" card.
+   * estimate the error, refine hierarchically and solve the last SOLVE card again,
+   * starting from the interpolated solution, until the error target or node budget is reached
+   */
+  int do_refine_adaptive ( const Parser::Card & c );
+
   /**
    * process and do "REFINE.UNIFORM" card
    */
@@ -201,10 +231,25 @@ public:
    */
   int  plot_mesh ( const Parser::Card & c );
 
+  /**
+   * process "MEMORY" card, print the memory usage of each subsystem
+   */
+  int  do_memory ( const Parser::Card & c );
+
+  /**
+   * print the memory usage of system and \p solver (if not NULL) on all the processors
+   */
+  void print_memory ( const std::string & label, const SolverBase * solver = NULL );
+
 private:
 
   Parser::InputParser *_decks;
 
+  /**
+   * the STRESS.LOAD cards waiting for the next STRESS card
+   */
+  std::vector<Parser::Card> _stress_loads;
+
   /**
    * the main mesh structure
    */
@@ -222,6 +267,25 @@ private:
    */
   AutoPtr<MeshGeneratorBase> meshgen;
 
+  /**
+   * @return a new device solver of SolverSpecify::Solver, NULL if not supported
+   */
+  SolverBase * new_device_solver();
+
+  /**
+   * add the hooks to \p solver, run it and delete it. \p extra_hook is added before the control hook.
+   * only bias group 0 writes the hook output, unless \p group_output is set for a solve of the group's own
+   */
+  void run_device_solver(SolverBase * solver, Hook * extra_hook = NULL, bool group_output = false);
+
+  /**
+   * flag the cells by \p error_per_cell with the criterion of card \p c, refine the mesh hierarchically
+   * and rebuild the system. doping and mole fraction are interpolated to the new mesh if no solver
+   * provides them. when \p keep_solution is true, the solution and the electrode states are carried
+   * to the new mesh too, as the initial guess of the next solve.
+   */
+  void refine_hierarchical(const Parser::Card & c, const ErrorVector & error_per_cell, bool keep_solution);
+
   /**
    * import mesh from CAD system
    */
@@ -251,6 +315,16 @@ private:
   mxml_node_t *_dom_solution;
 
   std::string _fname_solution;
+
+  /**
+   * print memory usage at the begin and end of each SOLVE
+   */
+  bool _memory_log_solve;
+
+  /**
+   * the last SOLVE card, REFINE.ADAPTIVE solves it again after each refinement
+   */
+  Parser::Card _last_solve;
 };
 
 class SolverControlHook : public Hook
@@ -23,9 +23,11 @@
 #define __data_storage_h__
 
 #include <vector>
+#include <iostream>
 #include "enum_data_type.h"
 #include "vector_value.h"
 #include "tensor_value.h"
+#include "first_touch.h"
 
 class DataStorage
 {
@@ -279,6 +281,39 @@ public:
   Real & scalar(const unsigned int v, const unsigned int offset)
   { return _scalar_block[v][offset]; }
 
+  /**
+   * @return the contiguous data block of scalar variable v, indexed by offset.
+   * NULL when the variable is not allocated
+   */
+  Real * scalar_data(const unsigned int v)
+  { return (v < _scalar_fill.size() && _scalar_fill[v] && _size) ? &_scalar_block[v][0] : NULL; }
+
+  /**
+   * @return the contiguous data block of scalar variable v, indexed by offset.
+   * NULL when the variable is not allocated
+   */
+  const Real * scalar_data(const unsigned int v) const
+  { return (v < _scalar_fill.size() && _scalar_fill[v] && _size) ? &_scalar_block[v][0] : NULL; }
+
+  /**
+   * @return true when the data block of scalar variable v is allocated
+   */
+  bool scalar_allocated(const unsigned int v) const
+  { return v < _scalar_fill.size() && _scalar_fill[v]; }
+
+  /**
+   * exchange the data blocks of scalar variable v1 and v2 without copy.
+   * used to rotate the solution of current step into the one of previous step
+   * when the current one will be overwritten for every entry anyway.
+   * @return false (and nothing is done) when either variable is not allocated
+   */
+  bool swap_scalar(const unsigned int v1, const unsigned int v2)
+  {
+    if( !scalar_allocated(v1) || !scalar_allocated(v2) ) return false;
+    _scalar_block[v1].swap(_scalar_block[v2]);
+    return true;
+  }
+
   /**
    * data access function
    */
@@ -316,6 +351,52 @@ public:
   { return _tensor_block[v][offset]; }
 
 
+  /**
+   * @return the bytes held by the data blocks
+   */
+  size_t memory_size() const
+  {
+    size_t bytes = 0;
+    for(unsigned int n=0; n<_scalar_block.size(); ++n)
+      bytes += _scalar_block[n].capacity()*sizeof(Real);
+    for(unsigned int n=0; n<_complex_block.size(); ++n)
+      bytes += _complex_block[n].capacity()*sizeof(std::complex<Real>);
+    for(unsigned int n=0; n<_vector_block.size(); ++n)
+      bytes += _vector_block[n].capacity()*sizeof(VectorValue<Real>);
+    for(unsigned int n=0; n<_tensor_block.size(); ++n)
+      bytes += _tensor_block[n].capacity()*sizeof(TensorValue<Real>);
+    return bytes;
+  }
+
+  /**
+   * write the allocated scalar data blocks to binary stream, used by checkpoint
+   */
+  void write_scalar(std::ostream & out) const
+  {
+    unsigned int n = _scalar_fill.size();
+    out.write(reinterpret_cast<const char *>(&_size), sizeof(_size));
+    out.write(reinterpret_cast<const char *>(&n), sizeof(n));
+    for(unsigned int v=0; v<n; ++v)
+      if( _scalar_fill[v] && _size )
+        out.write(reinterpret_cast<const char *>(&_scalar_block[v][0]), _size*sizeof(Real));
+  }
+
+  /**
+   * read the scalar data blocks written by write_scalar
+   * @return false when the data layout does not match
+   */
+  bool read_scalar(std::istream & in)
+  {
+    unsigned int size, n;
+    in.read(reinterpret_cast<char *>(&size), sizeof(size));
+    in.read(reinterpret_cast<char *>(&n), sizeof(n));
+    if( !in.good() || size != _size || n != _scalar_fill.size() ) return false;
+    for(unsigned int v=0; v<n; ++v)
+      if( _scalar_fill[v] && _size )
+        in.read(reinterpret_cast<char *>(&_scalar_block[v][0]), _size*sizeof(Real));
+    return in.good();
+  }
+
   /**
    * universal data access function via template
    */
@@ -342,28 +423,29 @@ private:
   unsigned int _reserve_size;
 
   /**
-   * indicator of scalar value
+   * indicator of scalar value.
+   * the data blocks of all the types are placed by first touch of the threads, see FirstTouchAllocator
    */
   std::vector<bool> _scalar_fill;
-  std::vector< std::vector<Real> > _scalar_block;
+  std::vector< std::vector<Real, FirstTouchAllocator<Real> > > _scalar_block;
 
   /**
    * indicator of complex value
    */
   std::vector<bool> _complex_fill;
-  std::vector< std::vector<std::complex<Real> > > _complex_block;
+  std::vector< std::vector<std::complex<Real>, FirstTouchAllocator<std::complex<Real> > > > _complex_block;
 
   /**
    * indicator of vector value
    */
   std::vector<bool> _vector_fill;
-  std::vector< std::vector<VectorValue<Real> > > _vector_block;
+  std::vector< std::vector<VectorValue<Real>, FirstTouchAllocator<VectorValue<Real> > > > _vector_block;
 
   /**
    * indicator of tensor value
    */
   std::vector<bool> _tensor_fill;
-  std::vector< std::vector<TensorValue<Real> > > _tensor_block;
+  std::vector< std::vector<TensorValue<Real>, FirstTouchAllocator<TensorValue<Real> > > > _tensor_block;
 
 };
 
@@ -26,6 +26,8 @@
 #define __external_circuit_h__
 
 #include <complex>
+#include <iostream>
+#include <vector>
 
 
 #include "solver_specify.h"
@@ -45,7 +47,7 @@ public:
   ExternalCircuit()
   : _res(0), _cap(0), _ind(0), _Vapp(0), _Iapp(0),
     _potential(0), _current(0), _current_displacement(0),
-    _current_conductance(0), _cap_current(0),
+    _current_conductance(0), _cap_current(0), _charge(0),
     _Vac(0.0026),
     _drv(VDRIVEN)
   {}
@@ -235,6 +237,19 @@ public:
   { return _potential_ac;}
 
 
+  /**
+   * @return the charge of the electrode, the flux of electric displacement into the device.
+   * it is evaluated once after each achieved solution, see BoundaryConditionCollector::update_electrode_charge()
+   */
+  virtual PetscScalar charge() const
+  { return _charge;}
+
+  /**
+   * @return writable reference to the charge of the electrode.
+   */
+  virtual PetscScalar & charge()
+  { return _charge;}
+
   /**
    * @return the electrode current of AC scan.
    */
@@ -260,6 +275,74 @@ public:
     _current = _current_itering;
 
     _cap_current = _cap*(_potential-_potential_old)/SolverSpecify::dt;
+
+    _time_history.push_back(SolverSpecify::clock);
+    _potential_history.push_back(_potential);
+    _current_history.push_back(_current);
+  }
+
+  /**
+   * @return the coefficient of electrode current in the circuit equation of stand alone electrode,
+   * L/dt+R for voltage driven, 1 for current driven
+   */
+  PetscScalar mna_scaling(PetscScalar dt) const
+  {
+    if( _drv == VDRIVEN ) return _ind/dt + _res;
+    if( _drv == IDRIVEN ) return 1.0;
+    return 0.0;
+  }
+
+  /**
+   * @return the circuit equation of stand alone electrode at electrode potential Ve, except the
+   * electrode current term mna_scaling()*I, which is assembled by the boundary condition
+   *   voltage driven : (Ve-Vapp) + (L/dt+R)*C/dt*(Ve-P) - L/dt*(I+Ic)
+   *   current driven : Ic - Iapp
+   * where P, I and Ic are the potential, current and cap current of last step
+   */
+  PetscScalar mna_function(PetscScalar Ve, PetscScalar dt) const
+  {
+    if( _drv == VDRIVEN )
+      return (Ve-_Vapp) + (_ind/dt+_res)*_cap/dt*(Ve-_potential) - _ind/dt*(_current+_cap_current);
+    if( _drv == IDRIVEN )
+      return _cap_current - _Iapp;
+    return 0.0;
+  }
+
+  /**
+   * @return d(mna_function)/d(Ve)
+   */
+  PetscScalar mna_jacobian(PetscScalar dt) const
+  {
+    if( _drv == VDRIVEN ) return 1.0 + (_ind/dt+_res)*_cap/dt;
+    return 0.0;
+  }
+
+  /**
+   * @return the simulation time of each achieved solution
+   */
+  const std::vector<PetscScalar> & time_history() const
+  { return _time_history; }
+
+  /**
+   * @return the electrode potential of each achieved solution
+   */
+  const std::vector<PetscScalar> & potential_history() const
+  { return _potential_history; }
+
+  /**
+   * @return the electrode current of each achieved solution
+   */
+  const std::vector<PetscScalar> & current_history() const
+  { return _current_history; }
+
+  /**
+   * forget the recorded solutions
+   */
+  void clear_history()
+  {
+    _time_history.clear();
+    _potential_history.clear();
+    _current_history.clear();
   }
 
 
@@ -309,6 +392,35 @@ public:
   bool is_float() const
   { return _drv == FLOAT; }
 
+  /**
+   * write the DC/transient state of external circuit to binary stream, used by checkpoint
+   */
+  void write_state(std::ostream & out) const
+  {
+    const PetscScalar state[14] = { _res, _cap, _ind, _Vapp, _Iapp, _potential, _potential_itering, _potential_old,
+                                    _current, _current_displacement, _current_conductance, _current_itering,
+                                    _current_old, _cap_current };
+    const int drv = _drv;
+    out.write(reinterpret_cast<const char *>(state), sizeof(state));
+    out.write(reinterpret_cast<const char *>(&drv), sizeof(drv));
+  }
+
+  /**
+   * read the state written by write_state
+   */
+  void read_state(std::istream & in)
+  {
+    PetscScalar state[14];
+    int drv;
+    in.read(reinterpret_cast<char *>(state), sizeof(state));
+    in.read(reinterpret_cast<char *>(&drv), sizeof(drv));
+    _res = state[0]; _cap = state[1]; _ind = state[2]; _Vapp = state[3]; _Iapp = state[4];
+    _potential = state[5]; _potential_itering = state[6]; _potential_old = state[7];
+    _current = state[8]; _current_displacement = state[9]; _current_conductance = state[10];
+    _current_itering = state[11]; _current_old = state[12]; _cap_current = state[13];
+    _drv = static_cast<DRIVEN>(drv);
+  }
+
 
 private:
 
@@ -383,6 +495,11 @@ private:
    */
   PetscScalar      _cap_current;
 
+  /**
+   * the charge of the electrode
+   */
+  PetscScalar      _charge;
+
   /**
    * the application voltage for AC sweep.
    */
@@ -404,6 +521,14 @@ private:
    */
   DRIVEN        _drv;
 
+  /**
+   * time, potential and current recorded by update(), in internal unit.
+   * they are stored as plain arrays so the python binding can view them without copy
+   */
+  std::vector<PetscScalar>       _time_history;
+  std::vector<PetscScalar>       _potential_history;
+  std::vector<PetscScalar>       _current_history;
+
 };
 
 
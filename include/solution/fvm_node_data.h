@@ -49,6 +49,16 @@ public:
    */
   virtual ~FVM_NodeData() {}
 
+  /**
+   * FVM_NodeData objects are allocated from ObjectPool
+   */
+  static void * operator new (size_t size);
+
+  /**
+   * return the memory to ObjectPool
+   */
+  static void operator delete (void * p, size_t size);
+
 
   enum NodeDataType {SemiconductorData, InsulatorData, ConductorData, ResistanceData, VacuumData, InvalidData };
 
@@ -739,6 +749,45 @@ public:
   { return FVM_NodeData::_scalar_dummy_; }
 
 
+  /**
+   * @return the cached SRH lifetime of electron
+   */
+  virtual Real         taun()          const
+  { return 0; }
+
+  /**
+   * @return the writable reference to cached SRH lifetime of electron
+   */
+  virtual Real &       taun()
+  { return FVM_NodeData::_scalar_dummy_; }
+
+
+  /**
+   * @return the cached SRH lifetime of hole
+   */
+  virtual Real         taup()          const
+  { return 0; }
+
+  /**
+   * @return the writable reference to cached SRH lifetime of hole
+   */
+  virtual Real &       taup()
+  { return FVM_NodeData::_scalar_dummy_; }
+
+
+  /**
+   * @return the lattice temperature of cached material quantities, negative means no cache
+   */
+  virtual Real         T_material()          const
+  { return -1; }
+
+  /**
+   * @return the writable reference to lattice temperature of cached material quantities
+   */
+  virtual Real &       T_material()
+  { return FVM_NodeData::_scalar_dummy_; }
+
+
   /**
    * @return the electrical field
    */
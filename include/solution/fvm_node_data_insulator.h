@@ -239,8 +239,8 @@ class FVM_Insulator_NodeData : public FVM_NodeData
     {
       switch ( variable )
       {
-        case POTENTIAL   :  psi() = value;                             /* potential */
-        case TEMPERATURE :  T() = value;                               /* lattice temperature */
+        case POTENTIAL   :  psi() = value; break;                      /* potential */
+        case TEMPERATURE :  T() = value; break;                        /* lattice temperature */
         default          :  return;
       }
     }
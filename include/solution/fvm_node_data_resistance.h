@@ -230,8 +230,8 @@ class FVM_Resistance_NodeData : public FVM_NodeData
     {
       switch ( variable )
       {
-        case POTENTIAL   :  psi() = value;                             /* potential */
-        case TEMPERATURE :  T() = value;                               /* lattice temperature */
+        case POTENTIAL   :  psi() = value; break;                      /* potential */
+        case TEMPERATURE :  T() = value; break;                        /* lattice temperature */
         default          :  return;
       }
     }
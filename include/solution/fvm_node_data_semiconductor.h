@@ -246,6 +246,22 @@ class FVM_Semiconductor_NodeData : public FVM_NodeData
        */
       _rho_,
 
+      /**
+       * SRH lifetime of electron, cached at lattice temperature _T_material_
+       */
+      _taun_,
+
+      /**
+       * SRH lifetime of hole, cached at lattice temperature _T_material_
+       */
+      _taup_,
+
+      /**
+       * lattice temperature at which the field independent material quantities
+       * (Nc, Nv and SRH lifetimes) of this node are evaluated, negative means invalid
+       */
+      _T_material_,
+
       /**
        * last enum number
        */
@@ -444,19 +460,19 @@ class FVM_Semiconductor_NodeData : public FVM_NodeData
     {
       switch ( variable )
       {
-        case POTENTIAL     :  psi() = value;                             /* potential */
-        case ELECTRON      :  n() = value;                               /* electron concentration */
-        case HOLE          :  p() = value;                               /* hole concentration */
-        case TEMPERATURE   :  T() = value;                               /* lattice temperature */
-        case E_TEMP        :  Tn() = value;                              /* electron temperature */
-        case H_TEMP        :  Tp() = value;                              /* hole temperature */
-        case DOPING_Na     :  Na() = value;                              /* acceptor */
-        case DOPING_Nd     :  Nd() = value;                              /* donor */
-        case OPTICAL_GEN   :  OptG() = value;                            /* charge genetated by optical ray */
-        case OPTICAL_HEAT  :  OptQ() = value;                            /* heat genetated by optical ray */
-        case PARTICLE_GEN  :  PatG() = value;                            /* charge genetated by particle ray */
-        case MOLE_X        :  mole_x() = value;
-        case MOLE_Y        :  mole_y() = value;
+        case POTENTIAL     :  psi() = value; break;                      /* potential */
+        case ELECTRON      :  n() = value; break;                        /* electron concentration */
+        case HOLE          :  p() = value; break;                        /* hole concentration */
+        case TEMPERATURE   :  T() = value; break;                        /* lattice temperature */
+        case E_TEMP        :  Tn() = value; break;                       /* electron temperature */
+        case H_TEMP        :  Tp() = value; break;                       /* hole temperature */
+        case DOPING_Na     :  Na() = value; break;                       /* acceptor */
+        case DOPING_Nd     :  Nd() = value; break;                       /* donor */
+        case OPTICAL_GEN   :  OptG() = value; break;                     /* charge genetated by optical ray */
+        case OPTICAL_HEAT  :  OptQ() = value; break;                     /* heat genetated by optical ray */
+        case PARTICLE_GEN  :  PatG() = value; break;                     /* charge genetated by particle ray */
+        case MOLE_X        :  mole_x() = value; break;
+        case MOLE_Y        :  mole_y() = value; break;
         default            :  return;
       }
     }
@@ -1090,6 +1106,45 @@ class FVM_Semiconductor_NodeData : public FVM_NodeData
     { return _data_storage->scalar ( _Recomb_Auger_, _offset ); }
 
 
+    /**
+     * @return the cached SRH lifetime of electron
+     */
+    virtual Real         taun()          const
+    { return _data_storage->scalar ( _taun_, _offset ); }
+
+    /**
+     * @return the writable reference to cached SRH lifetime of electron
+     */
+    virtual Real &       taun()
+    { return _data_storage->scalar ( _taun_, _offset ); }
+
+
+    /**
+     * @return the cached SRH lifetime of hole
+     */
+    virtual Real         taup()          const
+    { return _data_storage->scalar ( _taup_, _offset ); }
+
+    /**
+     * @return the writable reference to cached SRH lifetime of hole
+     */
+    virtual Real &       taup()
+    { return _data_storage->scalar ( _taup_, _offset ); }
+
+
+    /**
+     * @return the lattice temperature of cached material quantities
+     */
+    virtual Real         T_material()          const
+    { return _data_storage->scalar ( _T_material_, _offset ); }
+
+    /**
+     * @return the writable reference to lattice temperature of cached material quantities
+     */
+    virtual Real &       T_material()
+    { return _data_storage->scalar ( _T_material_, _offset ); }
+
+
     /**
      * @return the electrical field
      */
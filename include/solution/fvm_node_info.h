@@ -83,6 +83,16 @@ public:
    */
   ~FVM_Node();
 
+  /**
+   * FVM_Node objects are allocated from ObjectPool
+   */
+  static void * operator new (size_t size);
+
+  /**
+   * return the memory to ObjectPool
+   */
+  static void operator delete (void * p, size_t size);
+
 
   /**
    * @return the centre node pointer
@@ -138,10 +148,17 @@ public:
   /**
    * set the node which connects to me as my neighbor.
    */
-  void set_node_neighbor(const Node * n, FVM_Node *fn=NULL)
-  {
-    _node_neighbor[n] = fn;
-  }
+  void set_node_neighbor(const Node * n, FVM_Node *fn=NULL);
+
+  /**
+   * release the spare capacity of neighbor storage, call it when neighbors are all set
+   */
+  void shrink_node_neighbor();
+
+  /**
+   * @return the bytes held by this FVM_Node, node data not included
+   */
+  size_t memory_size() const;
 
   /**
    * set ghost node, which has the same root_node but in different region
@@ -165,8 +182,9 @@ public:
    */
   Real & cv_surface_area(const Node * neighbor)
   {
-    genius_assert(this->is_neighbor(neighbor));
-    return _cv_surface_area[neighbor];
+    unsigned int i = neighbor_index(neighbor);
+    genius_assert(i != invalid_uint);
+    return _cv_surface_area[i];
   }
 
   /**
@@ -174,8 +192,9 @@ public:
    */
   Real cv_surface_area(const Node * neighbor) const
   {
-    genius_assert(this->is_neighbor(neighbor));
-    return _cv_surface_area.find(neighbor)->second;
+    unsigned int i = neighbor_index(neighbor);
+    genius_assert(i != invalid_uint);
+    return _cv_surface_area[i];
   }
 
   typedef std::map< FVM_Node *, std::pair<unsigned int, Real> >::const_iterator fvm_ghost_node_iterator;
@@ -366,7 +385,7 @@ public:
   std::vector<unsigned int> subdomains() const;
 
 
-  typedef std::map<const Node *, FVM_Node *>::const_iterator fvm_neighbor_node_iterator;
+  typedef std::vector<std::pair<const Node *, FVM_Node *> >::const_iterator fvm_neighbor_node_iterator;
 
 
   /**
@@ -403,7 +422,7 @@ public:
    * @return true iff node is a neighbor of this FVM_Node
    */
   bool is_neighbor(const Node * node) const
-  { return _node_neighbor.find(node)!=_node_neighbor.end(); }
+  { return neighbor_index(node)!=invalid_uint; }
 
 
   /**
@@ -475,16 +494,23 @@ private:
 
 
   /**
-   * the node neighbor (link this node by a side edge) as well as their FVM_Node map.
+   * the node neighbor (link this node by a side edge) as well as their FVM_Node.
    * only neighbors belong to same region (have the same subdomain id) are recorded.
+   * kept sorted by Node pointer in a flat array, which is much lighter than a map
+   * for the few neighbors a node has and keeps the iteration order of the old map
    */
-  std::map< const Node *, FVM_Node * > _node_neighbor;
+  std::vector< std::pair<const Node *, FVM_Node *> > _node_neighbor;
+
 
+  /**
+   * control volume surface area, aligned with _node_neighbor
+   */
+  std::vector<Real> _cv_surface_area;
 
   /**
-   * control volume surface area. indicated by neighbor Node
+   * @return the position of neighbor in _node_neighbor, invalid_uint if not found
    */
-  std::map< const Node *, Real > _cv_surface_area;
+  unsigned int neighbor_index(const Node * neighbor) const;
 
   /**
    * the FVM Node with same root node, but in different region
@@ -0,0 +1,93 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __output_field_h__
+#define __output_field_h__
+
+#include <string>
+#include <vector>
+
+class FVM_NodeData;
+
+/**
+ * the node based solution fields known by the export writers and hooks.
+ * a field is evaluated only when an export asks for it, the values of each region
+ * are kept by SimulationRegion::output_field() for one solution version, so the
+ * exports and hooks running at the same step evaluate each field once.
+ */
+namespace OutputField
+{
+  /**
+   * the field index
+   */
+  enum Field
+  {
+    PSI=0, EC, EV, QFN, QFP, T,
+    NA, ND, NET_DOPING, NET_CHARGE, ELECTRON, HOLE,
+    MOLE_X, MOLE_Y,
+    N_FIELDS
+  };
+
+  /**
+   * @return the name of the field, as it appears in the output file
+   */
+  const char * name(unsigned int f);
+
+  /**
+   * @return true when the field only exist in semiconductor region
+   */
+  bool semiconductor_only(unsigned int f);
+
+  /**
+   * @return true when the field does not change during the solve
+   */
+  bool is_static(unsigned int f);
+
+  /**
+   * @return the index of field by its name, invalid_uint when not found.
+   * the name is not case sensitive, and a space is the same as underline
+   */
+  unsigned int find(const std::string & name);
+
+  /**
+   * @return the key of a field name for comparison, in lower case and with space as underline
+   */
+  std::string key(const std::string & name);
+
+  /**
+   * split a comma separated name list, the blanks around each name are removed
+   */
+  std::vector<std::string> split(const std::string & name_list);
+
+  /**
+   * parse a comma separated field list, unknown field is warned and ignored.
+   * @return all the fields when the list is empty
+   */
+  std::vector<unsigned int> parse(const std::string & field_list, const std::string & who);
+
+  /**
+   * @return the value of field at node_data, in the output unit
+   */
+  float value(unsigned int f, const FVM_NodeData * node_data);
+}
+
+#endif
@@ -33,6 +33,7 @@
 #include "fvm_node_info.h"
 #include "material.h"
 #include "simulation_region.h"
+#include "mat_slot_map.h"
 
 class Elem;
 class GateContactBC;
@@ -98,6 +99,25 @@ public:
    */
   virtual void reinit_after_import();
 
+  /**
+   * evaluate the field independent material quantities (Nc, Nv and SRH lifetimes) of local nodes
+   * and cache them in the node data. the lattice temperature is T_external() when isothermal is true,
+   * or the node temperature otherwise. only the nodes whose lattice temperature changed are evaluated,
+   * unless force is true, i.e. the doping or material model changed
+   */
+  void update_material_cache(bool isothermal, bool force=false);
+
+  /**
+   * set the physical model, the trap node list is rebuilt at next use
+   */
+  virtual void set_pmi(const std::string &type, const std::string &model_name, std::vector<Parser::Parameter> & pmi_parameters);
+
+  /**
+   * @return the local nodes (on processor and ghost) which carry bulk or interface traps.
+   * the list is built from the trap PMI at the first call after the PMI or the region changed
+   */
+  const std::vector<FVM_Node *> & trap_nodes();
+
   /**
    * clear stored data
    */
@@ -234,6 +254,79 @@ private:
    */
   Material::MaterialSemiconductor *mt;
 
+  /**
+   * slots of the cell blocks of DDM1 jacobian matrix
+   */
+  MatBlockSlotCache _ddm1_cell_slots;
+
+  typedef std::vector<adtl::AutoDScalar6, FirstTouchAllocator<adtl::AutoDScalar6> > AD6Array;
+
+  /**
+   * node values of DDM1 function and jacobian, indexed by the position of the node in the local node list.
+   * the on processor nodes can be filled by DDM1_*_Interior before the ghost dofs arrive
+   */
+  struct DDM1NodeCache
+  {
+    DDM1NodeCache() : value_ready(false), ad_ready(false) {}
+    bool value_ready;
+    bool ad_ready;
+    // the node arrays are read by the threaded edge loops, placed by first touch
+    RealArray V, n, p, eps, Ec, Ev;
+    AD6Array  Ec_ad, Ev_ad;
+    // scratch of the batched nie evaluation
+    std::vector<unsigned int> batch_index;
+    std::vector<PMI_Context>  batch_context;
+    std::vector<PetscScalar>  batch_n, batch_p, batch_T, batch_nie;
+  };
+  DDM1NodeCache _ddm1_node_cache;
+
+  /**
+   * the local nodes with traps, the trap terms of DDM/EBM solvers only visit these nodes
+   */
+  std::vector<FVM_Node *> _trap_nodes;
+
+  /**
+   * false when _trap_nodes should be rebuilt
+   */
+  bool _trap_nodes_valid;
+
+  /**
+   * gather the node values of on processor nodes (ghost=false) or ghost nodes (ghost=true)
+   */
+  void DDM1_Fill_Node_Cache(PetscScalar * x, bool ghost);
+
+  /**
+   * gather the node values with AD of on processor nodes (ghost=false) or ghost nodes (ghost=true)
+   */
+  void DDM1_Fill_Node_AD_Cache(PetscScalar * x, bool ghost);
+
+  /**
+   * DDM1 function kernel, the magnetic field term of HALL solver is added when B is not null
+   */
+  void DDM1_Function_Kernel(const VectorValue<double> * B, PetscScalar * x, Vec f, InsertMode &add_value_flag);
+
+  /**
+   * DDM1 jacobian kernel, the magnetic field term of HALL solver is added when B is not null
+   */
+  void DDM1_Jacobian_Kernel(const VectorValue<double> * B, PetscScalar * x, Mat *jac, InsertMode &add_value_flag);
+
+  /**
+   * magnetic field term of HALL solver in the cell nelem, with the edge mobility and current of the DDM1 kernel.
+   * the edge density at mid point is read from the DDM1 node cache
+   */
+  void HALL_Cell_Function(const VectorValue<double> & B, const Elem * elem, unsigned int nelem, bool truncation,
+                          const std::vector<PetscScalar> & mun_edge, const std::vector<PetscScalar> & mup_edge,
+                          const std::vector<PetscScalar> & Jn_edge, const std::vector<PetscScalar> & Jp_edge,
+                          std::vector<int> & iy, std::vector<PetscScalar> & y);
+
+  /**
+   * jacobian of the magnetic field term of HALL solver in the cell nelem, added to the cell block of the DDM1 kernel
+   */
+  void HALL_Cell_Jacobian(const VectorValue<double> & B, const Elem * elem, unsigned int nelem, bool truncation,
+                          const std::vector<adtl::AutoDScalar> & mun_edge, const std::vector<adtl::AutoDScalar> & mup_edge,
+                          const std::vector<adtl::AutoDScalar> & Jn_edge, const std::vector<adtl::AutoDScalar> & Jp_edge,
+                          std::vector<PetscScalar> & cell_jac, unsigned int n_col);
+
 
 private:
 
@@ -296,6 +389,16 @@ public:
    */
   virtual void DDM1_Jacobian(PetscScalar * x, Mat *jac, InsertMode &add_value_flag);
 
+  /**
+   * evaluate node values of L1 DDM function on the on processor nodes, before ghost dofs arrive
+   */
+  virtual void DDM1_Function_Interior(PetscScalar * x);
+
+  /**
+   * evaluate node values of L1 DDM jacobian on the on processor nodes, before ghost dofs arrive
+   */
+  virtual void DDM1_Jacobian_Interior(PetscScalar * x);
+
   /**
    * build time derivative term and its jacobian for L1 DDM
    */
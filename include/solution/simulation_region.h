@@ -35,6 +35,8 @@
 #include "petscmat.h"
 #include "advanced_model.h"
 #include "enum_region.h"
+#include "memory_log.h"
+#include "first_touch.h"
 
 #if defined(HAVE_TR1_UNORDERED_MAP)
 #include <tr1/unordered_map>
@@ -123,6 +125,17 @@ public:
    */
   void reserve_data_block(unsigned int n_cell_data, unsigned int n_node_data);
 
+  /**
+   * write the scalar node and cell data of this region to binary checkpoint stream
+   */
+  void write_checkpoint(std::ostream & out) const;
+
+  /**
+   * read the scalar node and cell data written by write_checkpoint
+   * @return false when the data layout does not match
+   */
+  bool read_checkpoint(std::istream & in);
+
   /**
    * insert local mesh element into the region, only copy the pointer
    * and create cell data
@@ -195,24 +208,14 @@ public:
    * if no find, NULL is returned
    */
   FVM_Node * region_fvm_node(const Node* node) const
-  {
-    std::map<unsigned int, FVM_Node *>::const_iterator it = _region_node.find( node->id() );
-    if( it!=_region_node.end() )
-      return (*it).second;
-    return NULL;
-  }
+  { return find_region_node( node->id() ); }
 
   /**
    * @return the fvm_node pointer by Node id
    * if no find, NULL is returned
    */
   FVM_Node * region_fvm_node(unsigned int id) const
-  {
-    std::map<unsigned int, FVM_Node *>::const_iterator it = _region_node.find( id );
-    if( it!=_region_node.end() )
-      return (*it).second;
-    return NULL;
-  }
+  { return find_region_node( id ); }
 
   /**
    * @return the node data pointer by Node *
@@ -220,10 +223,8 @@ public:
    */
   FVM_NodeData * region_node_data(const Node* node) const
   {
-    std::map<unsigned int, FVM_Node *>::const_iterator it = _region_node.find( node->id() );
-    if( it!=_region_node.end() )
-      return (*it).second->node_data();
-    return NULL;
+    FVM_Node * fvm_node = find_region_node( node->id() );
+    return fvm_node ? fvm_node->node_data() : NULL;
   }
 
   /**
@@ -232,10 +233,8 @@ public:
    */
   FVM_NodeData * region_node_data(unsigned int id) const
   {
-    std::map<unsigned int, FVM_Node *>::const_iterator it = _region_node.find( id );
-    if( it!=_region_node.end() )
-      return (*it).second->node_data();
-    return NULL;
+    FVM_Node * fvm_node = find_region_node( id );
+    return fvm_node ? fvm_node->node_data() : NULL;
   }
 
   /**
@@ -356,6 +355,12 @@ public:
     return _region_local_node.end();
   }
 
+  /**
+   * @return the size of a buffer which can be indexed by the local offset
+   * of any on local node of this region, for the current solver
+   */
+  unsigned int local_node_buffer_size() const;
+
 
   /**
    * typedef processor_node_iterator
@@ -452,16 +457,262 @@ public:
   unsigned int elem_edge_index(const Elem* elem, unsigned int e) const
   { return _region_elem_edge_in_edges_index.find(elem)->second[e]; }
 
+  /**
+   * the flattened arrays below are streamed by the threaded assembly loops, their pages are
+   * placed by first touch of the threads which work on them, see FirstTouchAllocator
+   */
+  typedef std::vector<unsigned int, FirstTouchAllocator<unsigned int> > IndexArray;
+  typedef std::vector<Real, FirstTouchAllocator<Real> >                 RealArray;
+
+  /**
+   * the edges of this region flattened as structure of arrays, in the order of _region_edges.
+   * the two nodes of an edge are given by their index in the on local node list, so an
+   * assembly kernel can gather node values into plain arrays once and stream the edge loop
+   */
+  struct EdgeArrays
+  {
+    /**
+     * index of node 1 and node 2 of the edge in on_local_nodes_begin() ... on_local_nodes_end()
+     */
+    IndexArray node1;
+    IndexArray node2;
+
+    /**
+     * the length of the edge
+     */
+    RealArray  length;
+
+    /**
+     * the area of control volume surface between the two nodes
+     */
+    RealArray  area;
+
+    void clear()
+    { node1.clear(); node2.clear(); length.clear(); area.clear(); }
+  };
+
+  /**
+   * @return the flattened edge arrays
+   */
+  const EdgeArrays & edge_arrays() const
+  { return _edge_arrays; }
+
+  /**
+   * the jacobian of linear poisson flux eps*area/length*(psi2-psi1) over the region edges,
+   * summed into the rows of on local nodes. the entries of row i are begin[i] ... begin[i+1]-1,
+   * the first one is the diagonal, and the columns are given by node index in the on local node list.
+   */
+  struct EdgeOperator
+  {
+    std::vector<unsigned int> begin;
+    std::vector<unsigned int> node;
+    std::vector<Real>         value;
+
+    void clear()
+    { begin.clear(); node.clear(); value.clear(); }
+  };
+
+  /**
+   * @return the linear poisson operator of the region edges. it only depends on the mesh and eps,
+   * so it is evaluated when first asked and kept until the region is rebuilt
+   */
+  const EdgeOperator & poisson_edge_operator() const;
+
+  /**
+   * the edges of each region cell flattened as structure of arrays. the edges of the n-th cell
+   * are begin[n] ... begin[n+1]-1, in the order of the local edge index of the cell.
+   * the values are the same as Elem::nodes_on_edge, Elem::edge_length, Elem::partial_area_with_edge ...
+   * but they are evaluated once, so a cell loop can read them without virtual calls
+   */
+  struct CellEdgeArrays
+  {
+    /**
+     * offset of the first edge of each cell, with n_cell()+1 entries
+     */
+    IndexArray begin;
+
+    /**
+     * the location of the edge in _region_edges
+     */
+    IndexArray edge;
+
+    /**
+     * local index of node 1 and node 2 of the edge in the cell
+     */
+    IndexArray node1;
+    IndexArray node2;
+
+    /**
+     * the length of the edge
+     */
+    RealArray  length;
+
+    /**
+     * partial area and partial volume associated with the edge
+     */
+    RealArray  area;
+    RealArray  volume;
+
+    /**
+     * partial area and partial volume with voronoi truncation
+     */
+    RealArray  area_truncated;
+    RealArray  volume_truncated;
+
+    /**
+     * coefficient of the edge projection in the cell vector, the column of the
+     * least squares matrix of Elem::reconstruct_vector
+     */
+    RealArray  reconstruct_x;
+    RealArray  reconstruct_y;
+    RealArray  reconstruct_z;
+
+    void clear()
+    {
+      begin.clear(); edge.clear(); node1.clear(); node2.clear();
+      length.clear(); area.clear(); volume.clear(); area_truncated.clear(); volume_truncated.clear();
+      reconstruct_x.clear(); reconstruct_y.clear(); reconstruct_z.clear();
+    }
+  };
+
+  /**
+   * @return the flattened cell edge arrays
+   */
+  const CellEdgeArrays & cell_edge_arrays() const
+  { return _cell_edge_arrays; }
+
+  /**
+   * the nodes of each region cell flattened as structure of arrays. the nodes of the n-th cell
+   * are begin[n] ... begin[n+1]-1, in the order of the local node index of the cell.
+   */
+  struct CellNodeArrays
+  {
+    /**
+     * offset of the first node of each cell, with n_cell()+1 entries
+     */
+    IndexArray begin;
+
+    /**
+     * index of the node in on_local_nodes_begin() ... on_local_nodes_end()
+     */
+    IndexArray node;
+
+    /**
+     * coefficient of the node value in the cell gradient, the same as Elem::gradient
+     */
+    RealArray  grad_x;
+    RealArray  grad_y;
+    RealArray  grad_z;
+
+    void clear()
+    { begin.clear(); node.clear(); grad_x.clear(); grad_y.clear(); grad_z.clear(); }
+  };
+
+  /**
+   * @return the flattened cell node arrays
+   */
+  const CellNodeArrays & cell_node_arrays() const
+  { return _cell_node_arrays; }
+
+  /**
+   * @return the gradient of a variable in the n-th cell, value is given on the cell nodes
+   * in the order of local node index. the same as Elem::gradient without virtual call
+   */
+  template <typename T>
+  VectorValue<T> cell_gradient(unsigned int n, const T * value) const
+  {
+    const CellNodeArrays & cn = _cell_node_arrays;
+    T dx=0, dy=0, dz=0;
+    for(unsigned int i=cn.begin[n], k=0; i<cn.begin[n+1]; ++i, ++k)
+    {
+      dx += cn.grad_x[i]*value[k];
+      dy += cn.grad_y[i]*value[k];
+      dz += cn.grad_z[i]*value[k];
+    }
+    return VectorValue<T>(dx, dy, dz);
+  }
+
+  /**
+   * @return the vector in the n-th cell reconstructed from its projection on the cell edges,
+   * in the order of local edge index. the same as Elem::reconstruct_vector without virtual call
+   */
+  template <typename T>
+  VectorValue<T> cell_reconstruct_vector(unsigned int n, const T * projection) const
+  {
+    const CellEdgeArrays & ce = _cell_edge_arrays;
+    T vx=0, vy=0, vz=0;
+    for(unsigned int i=ce.begin[n], k=0; i<ce.begin[n+1]; ++i, ++k)
+    {
+      vx += ce.reconstruct_x[i]*projection[k];
+      vy += ce.reconstruct_y[i]*projection[k];
+      vz += ce.reconstruct_z[i]*projection[k];
+    }
+    return VectorValue<T>(vx, vy, vz);
+  }
+
+  /**
+   * evaluate the vector fields of all the region cells in one pass.
+   * E = -grad(psi), psi is given on the nodes in the order of on_local_nodes_begin() ... on_local_nodes_end().
+   * Jn and Jp are reconstructed from the current along the cell edges, flattened as cell_edge_arrays().
+   * the field with NULL input is not touched.
+   * @note the sign follows the S-G edge current of the DDM solvers, the cell Jn is -reconstruct(Jn)
+   */
+  void update_cell_fields(const PetscScalar * psi, const PetscScalar * Jn, const PetscScalar * Jp);
+
+  /**
+   * evaluate E = -grad(psi) of all the region cells from the psi of node data
+   */
+  void update_cell_electric_field();
+
   /**
    * (re)build _region_local_node and _region_processor_node for fast iteration
    */
   void rebuild_region_fvm_node_list();
 
+  /**
+   * (re)build _edge_arrays from _region_edges and _region_local_node
+   */
+  void rebuild_edge_arrays();
+
+  /**
+   * (re)build _cell_edge_arrays from _region_cell and _region_elem_edge_in_edges_index
+   */
+  void rebuild_cell_edge_arrays();
+
+  /**
+   * (re)build _cell_node_arrays from _region_cell and _region_local_node
+   */
+  void rebuild_cell_node_arrays();
+
+  /**
+   * (re)build the node id lookup table from _region_node
+   */
+  void rebuild_region_node_index();
+
+  /**
+   * @return the value of output field f (see OutputField) on the on local nodes, in the order of
+   * on_local_nodes_begin() ... on_local_nodes_end(). the values are evaluated when first asked,
+   * and kept until the solution version changes
+   */
+  const std::vector<float> & output_field(unsigned int f, unsigned int version) const;
+
+  /**
+   * record the bytes held by FVM nodes, node/cell data and edges of this region
+   */
+  void memory_usage(MemoryLog & log) const;
+
   /**
    * for some pre process
    */
   virtual void prepare_for_use();
 
+  /**
+   * @return the region type and the element shapes in the region, i.e. "SemiconductorRegion Tri+Quad",
+   * which labels the performance log of the region kernels. built by prepare_for_use()
+   */
+  const std::string & kernel_label() const
+  { return _kernel_label; }
+
   /**
    * delete fvm_node NOT on this processor, dangerous
    */
@@ -549,6 +800,21 @@ public:
   template <typename T>
   bool get_variable_data(const std::string &v, DataLocation, std::vector<T> &) const;
 
+  /**
+   * direct access to the data block of node based scalar variable v on this processor,
+   * entry i belongs to the local node whose node_data()->offset() is i, see node_data_ids().
+   * the data is in internal unit, \p unit is the factor of output unit.
+   * the pointer is invalid after the region is rebuilt.
+   * @return NULL when the variable does not exist or is not allocated
+   */
+  Real * node_scalar_data(const std::string &v, unsigned int &size, Real &unit);
+
+  /**
+   * @return the node id of each entry of the node data block, and whether the
+   * node is on processor (1) or a ghost node (0)
+   */
+  void node_data_ids(std::vector<unsigned int> &ids, std::vector<int> &on_processor) const;
+
   /**
    * @return the region node based variables
    */
@@ -641,10 +907,9 @@ public:
    */
   void add_hanging_node_on_side(const Node * node, const Elem * elem, unsigned int s)
   {
-    std::map<unsigned int, FVM_Node *>::iterator it = _region_node.find(node->id());
-    genius_assert( it!=_region_node.end() );
+    const FVM_Node * fvm_node = find_region_node(node->id());
+    genius_assert( fvm_node );
 
-    const FVM_Node * fvm_node = (*it).second;
     _hanging_node_on_elem_side[fvm_node] = std::pair<const Elem *, unsigned int>(elem, s);
   }
 
@@ -653,10 +918,9 @@ public:
    */
   void add_hanging_node_on_edge(const Node * node, const Elem * elem, unsigned int e)
   {
-    std::map<unsigned int, FVM_Node *>::iterator it = _region_node.find(node->id());
-    genius_assert( it!=_region_node.end() );
+    const FVM_Node * fvm_node = find_region_node(node->id());
+    genius_assert( fvm_node );
 
-    const FVM_Node * fvm_node = (*it).second;
     _hanging_node_on_elem_edge[fvm_node] = std::pair<const Elem *, unsigned int>(elem, e);
 
   }
@@ -710,6 +974,56 @@ public:
     return _hanging_node_on_elem_edge.end();
   }
 
+  /**
+   * a hanging node with the fvm nodes of the element side/edge it lies on.
+   * the flux of the hanging node is distributed to these parent nodes with the same weight
+   */
+  struct HangingNodeConstraint
+  {
+    const FVM_Node * node;
+    std::vector<const FVM_Node *> parents;
+  };
+
+  typedef std::vector<HangingNodeConstraint>::const_iterator       hanging_node_constraint_iterator;
+
+  /**
+   * precompute the parent nodes of all the hanging nodes and the hanging node flags,
+   * should be called after all the hanging nodes are added
+   */
+  void build_hanging_node_constraints();
+
+  /**
+   * const begin() accessor of hanging node on elem side with its parent nodes
+   */
+  hanging_node_constraint_iterator hanging_node_on_elem_side_constraints_begin        () const
+  {
+    return _hanging_node_on_elem_side_constraints.begin();
+  }
+
+  /**
+   * const end() accessor of hanging node on elem side with its parent nodes
+   */
+  hanging_node_constraint_iterator hanging_node_on_elem_side_constraints_end          () const
+  {
+    return _hanging_node_on_elem_side_constraints.end();
+  }
+
+  /**
+   * const begin() accessor of hanging node on elem edge with its parent nodes
+   */
+  hanging_node_constraint_iterator hanging_node_on_elem_edge_constraints_begin        () const
+  {
+    return _hanging_node_on_elem_edge_constraints.begin();
+  }
+
+  /**
+   * const end() accessor of hanging node on elem edge with its parent nodes
+   */
+  hanging_node_constraint_iterator hanging_node_on_elem_edge_constraints_end          () const
+  {
+    return _hanging_node_on_elem_edge_constraints.end();
+  }
+
 
 protected:
 
@@ -724,6 +1038,11 @@ protected:
    */
   std::string                    _region_material;
 
+  /**
+   * label of the region kernels in performance log
+   */
+  std::string                    _kernel_label;
+
 
   /**
    * region's default temperature
@@ -771,6 +1090,49 @@ protected:
    */
   std::map< unsigned int, FVM_Node * > _region_node;
 
+  /**
+   * flat lookup table of _region_node, used by region_fvm_node() and region_node_data().
+   * when the node ids of this region are compact enough, it is a dense array
+   * indexed by (id - _region_node_index_begin), else it is a sorted id array
+   * with the FVM_Node aligned in _region_node_index.
+   * any change of _region_node should set _region_node_index_valid to false,
+   * the map is used for lookup until the table is rebuilt.
+   */
+  std::vector<FVM_Node *>    _region_node_index;
+
+  /**
+   * sorted node ids for the sparse lookup table, empty for the dense one
+   */
+  std::vector<unsigned int>  _region_node_index_id;
+
+  /**
+   * the first node id of the dense lookup table
+   */
+  unsigned int               _region_node_index_begin;
+
+  /**
+   * true when _region_node_index is in sync with _region_node
+   */
+  bool                       _region_node_index_valid;
+
+  /**
+   * find FVM_Node by node id, NULL if not in this region
+   */
+  FVM_Node * find_region_node(unsigned int id) const
+  {
+    if( _region_node_index_valid && _region_node_index_id.empty() )
+    {
+      unsigned int i = id - _region_node_index_begin;
+      return i < _region_node_index.size() ? _region_node_index[i] : NULL;
+    }
+    return find_region_node_sparse(id);
+  }
+
+  /**
+   * node lookup by sorted id table, or by _region_node when the table is out of date
+   */
+  FVM_Node * find_region_node_sparse(unsigned int id) const;
+
 
   /**
    * on local nodes belong to this region.
@@ -793,6 +1155,31 @@ protected:
    */
   std::vector< std::pair<FVM_Node *, FVM_Node *> > _region_edges;
 
+  /**
+   * _region_edges as structure of arrays
+   */
+  EdgeArrays _edge_arrays;
+
+  /**
+   * linear poisson operator over _region_edges, built on demand
+   */
+  mutable EdgeOperator _poisson_edge_operator;
+
+  /**
+   * flattened edges of each region cell
+   */
+  CellEdgeArrays _cell_edge_arrays;
+
+  /**
+   * flattened nodes of each region cell
+   */
+  CellNodeArrays _cell_node_arrays;
+
+  /**
+   * the output fields evaluated for a solution version, by field index
+   */
+  mutable std::map<unsigned int, std::pair<unsigned int, std::vector<float> > > _output_field_cache;
+
   /**
    * the corresponding location of an element's edge in _region_edges
    * by given an element pointer, and the local index of the edge
@@ -832,6 +1219,19 @@ protected:
    */
   std::map<const FVM_Node *, std::pair<const Elem *, unsigned int> >  _hanging_node_on_elem_edge;
 
+  /**
+   * the hanging nodes of _hanging_node_on_elem_side and _hanging_node_on_elem_edge
+   * with their parent nodes, built by build_hanging_node_constraints()
+   */
+  std::vector<HangingNodeConstraint> _hanging_node_on_elem_side_constraints;
+  std::vector<HangingNodeConstraint> _hanging_node_on_elem_edge_constraints;
+
+  /**
+   * global flags of 2D/3D hanging node, built by build_hanging_node_constraints()
+   */
+  bool _has_2d_hanging_node;
+  bool _has_3d_hanging_node;
+
 
     /**
    * region advanced models
@@ -969,6 +1369,23 @@ public:
    */
   virtual void DDM1_Jacobian(PetscScalar * x, Mat *jac, InsertMode &add_value_flag)=0;
 
+  /**
+   * @brief virtual function for evaluating the part of level 1 DDM equation which only depends on
+   * on processor dofs. it is called while the ghost dofs of x are still being scattered,
+   * the result is used by the following DDM1_Function call
+   *
+   * @param x                local unknown vector, only the on processor dofs are valid
+   */
+  virtual void DDM1_Function_Interior(PetscScalar * ) {}
+
+  /**
+   * @brief virtual function for evaluating the part of Jacobian of level 1 DDM equation which only
+   * depends on on processor dofs, the same as DDM1_Function_Interior
+   *
+   * @param x                local unknown vector, only the on processor dofs are valid
+   */
+  virtual void DDM1_Jacobian_Interior(PetscScalar * ) {}
+
   /**
    * @brief virtual function for evaluating time derivative term of level 1 DDM equation.
    *
@@ -24,6 +24,7 @@
 #ifndef __simulation_system_h__
 #define __simulation_system_h__
 
+#include <deque>
 
 #include "vector_value.h"
 #include "enum_solution.h"
@@ -43,6 +44,7 @@ class BoundaryConditionCollector;
 class ElectricalSource;
 class FieldSource;
 class SPICE_CKT;
+class MemoryLog;
 
 /**
  * @brief the main structure for mesh and solution data storage
@@ -119,9 +121,10 @@ public:
   { return  _T_external;}
 
   /**
-   * @brief the main saving / loading mechanism, from cgnsfile
+   * @brief the main saving / loading mechanism, from cgnsfile.
+   * only the solution fields listed in \p fields are loaded, all of them when it is empty
    */
-  void import_cgns(const std::string& filename);
+  void import_cgns(const std::string& filename, const std::vector<std::string> & fields = std::vector<std::string>());
 
   /**
    * @brief load system from xml vtk file, only for debug reason
@@ -160,9 +163,14 @@ public:
   void export_ise(const std::string& filename) const;
 
   /**
-   * @brief the main saving mechanism, to vtk file
+   * @brief the main saving mechanism, to vtk file.
+   * with \p background, the XML VTK file is written to disk by a background thread.
+   * \p compress enables zlib compression of the binary XML VTK writer, which is used
+   * for .pvtu files and when genius is built without VTK library.
+   * only the solution fields in the comma separated list \p fields are written, all of them when it is empty
    */
-  void export_vtk(const std::string& filename, bool ascii) const;
+  void export_vtk(const std::string& filename, bool ascii, bool background=false, bool compress=true,
+                  const std::string & fields="") const;
 
   /**
    * @brief write geometry info to gdml file
@@ -179,6 +187,17 @@ public:
    */
   void export_node_location(const std::string& filename, const PetscScalar unit, const bool number=true) const;
 
+  /**
+   * write region data and electrode circuit state of this processor to binary checkpoint stream
+   */
+  void write_checkpoint(std::ostream & out) const;
+
+  /**
+   * read the region data and electrode circuit state written by write_checkpoint
+   * @return false when the checkpoint does not match this system
+   */
+  bool read_checkpoint(std::istream & in);
+
   /**
    * @return the pointer to nth region
    */
@@ -281,6 +300,11 @@ public:
    */
   void print_info (std::ostream& os=std::cout) const;
 
+  /**
+   * record the bytes held by mesh, boundary info and regions of this processor
+   */
+  void memory_usage (MemoryLog & log) const;
+
   /**
    * @brief Synchronized output debug information
    */
@@ -306,11 +330,23 @@ public:
    */
   void fill_interpolator(InterpolationBase *, const std::string &, InterpolationBase::InterpolationType /* type */) const;
 
+  /**
+   * fill several variables into interpolator at once, the (variable, type) pairs
+   * share one traversal of the nodes and are set up together
+   */
+  void fill_interpolator(InterpolationBase *, const std::vector<std::pair<std::string, InterpolationBase::InterpolationType> > &) const;
+
   /**
    * get data from interpolator after mesh refinement
    */
   void do_interpolation(const InterpolationBase *, const std::string &);
 
+  /**
+   * get data of several variables from interpolator after mesh refinement,
+   * all the variables of a node are evaluated together
+   */
+  void do_interpolation(const InterpolationBase *, const std::vector<std::string> &);
+
   /**
    * set unique solver name to _solver_active_history
    */
@@ -323,6 +359,36 @@ public:
   const std::vector<SolverSpecify::SolverType> & solve_history() const
   { return _solver_active_history; }
 
+  /**
+   * keep the converged solution of solver_type at electrode bias (applied voltages and currents),
+   * x is the local part of the solution vector on this processor. the solution of the same bias is replaced,
+   * the oldest one is dropped when the cache is full
+   */
+  void cache_bias_solution(SolverSpecify::SolverType solver_type, const std::vector<PetscScalar> & vapp,
+                           const std::vector<PetscScalar> & iapp, const std::vector<PetscScalar> & x);
+
+  /**
+   * @return the cached solution of solver_type with local size n_local, which has the same applied currents
+   * and the nearest applied voltages to the electrode bias. distance is the max difference of applied voltage.
+   * NULL when there is no such one
+   */
+  const std::vector<PetscScalar> * nearest_bias_solution(SolverSpecify::SolverType solver_type, unsigned int n_local,
+                                                         const std::vector<PetscScalar> & vapp, const std::vector<PetscScalar> & iapp,
+                                                         PetscScalar & distance) const;
+
+  /**
+   * @return the version of the solution, the output fields cached by regions are
+   * valid as long as the version does not change
+   */
+  unsigned int solution_version() const
+  { return _solution_version; }
+
+  /**
+   * the solution is (going to be) changed, invalidate the cached output fields
+   */
+  void new_solution_version()
+  { ++_solution_version; }
+
 private:
 
   /**
@@ -384,12 +450,44 @@ private:
    */
   double  _z_width;
 
+  /**
+   * the solver (METHOD type) used to estimate the partition weight of each region
+   */
+  std::string _partition_solver;
+
+  /**
+   * the extra partition weight of each labeled boundary side
+   */
+  int _partition_boundary_weight;
+
+  /**
+   * the partition weight of dual graph edges across region interfaces and electrodes
+   */
+  int _partition_interface_weight;
+
   /**
    * each solver should record itself in this _solver_active_history vector when active
    * we can determine the solve sequence by this vector
    */
   std::vector<SolverSpecify::SolverType> _solver_active_history;
 
+  /**
+   * the converged solutions of steadystate and DC sweep, see cache_bias_solution()
+   */
+  struct BiasSolution
+  {
+    SolverSpecify::SolverType solver_type;
+    std::vector<PetscScalar>  vapp;
+    std::vector<PetscScalar>  iapp;
+    std::vector<PetscScalar>  x;
+  };
+  std::deque<BiasSolution> _bias_solutions;
+
+  /**
+   * the version of the solution
+   */
+  unsigned int _solution_version;
+
 };
 
 
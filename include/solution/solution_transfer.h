@@ -0,0 +1,95 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __solution_transfer_h__
+#define __solution_transfer_h__
+
+#include <vector>
+#include <map>
+#include <string>
+
+#include "genius_common.h"
+#include "auto_ptr.h"
+#include "enum_solution.h"
+
+// Forward declarations
+class MeshBase;
+class SimulationSystem;
+
+
+/**
+ * Transfer the solution of a simulation system to another system built on a different mesh,
+ * i.e. the device structure is imported again from a re-meshed file.
+ *
+ * The constructor keeps a copy of the active elements of the source mesh together with the
+ * solution of each region, so the source system can be cleared afterwards.
+ * apply() locates all the nodes of the target system in the source mesh with one batched
+ * point locator query, and evaluates the linear shape functions of the source element.
+ * Only the nodes of the source region with the same name contribute to a target region.
+ * Carrier concentrations are interpolated in log space.
+ */
+class SolutionTransfer
+{
+public:
+
+  /**
+   * constructor, take a snapshot of the source system
+   */
+  SolutionTransfer(const SimulationSystem & source);
+
+  /**
+   * destructor
+   */
+  ~SolutionTransfer();
+
+  /**
+   * interpolate the saved solution to the nodes of \p target.
+   * the caller should call SimulationSystem::reinit_region_after_import() later
+   * @return the number of nodes not found in the source mesh
+   */
+  unsigned int apply(SimulationSystem & target) const;
+
+private:
+
+  /**
+   * the active elements of source mesh, node id is the index of _values
+   */
+  AutoPtr<MeshBase> _mesh;
+
+  /**
+   * the name of each source region
+   */
+  std::vector<std::string> _region_names;
+
+  /**
+   * the transferred variables and whether they are interpolated in log space
+   */
+  std::vector<std::pair<SolutionVariable, bool> > _variables;
+
+  /**
+   * for each source region and variable, node id -> value
+   */
+  std::vector< std::vector< std::map<unsigned int, Real> > > _values;
+
+};
+
+#endif
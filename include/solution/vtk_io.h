@@ -26,6 +26,7 @@
 
 // C++ includes
 #include <map>
+#include <set>
 #include <fstream>
 
 // Local includes
@@ -81,8 +82,47 @@ public:
    */
   virtual void write (const std::string& );
 
+  /**
+   * when set, the XML VTK file is formatted in memory and written to disk
+   * by the background thread of AsyncFileWriter
+   */
+  void set_background_write(bool flag)
+  { _background_write = flag; }
+
+  /**
+   * zlib compress the data arrays of the binary .vtu writer, default on when zlib is available
+   */
+  void set_compress(bool flag)
+  { _compress = flag; }
+
+  /**
+   * only write the solution fields in the comma separated list, by the name they have
+   * in the output file. all the fields are written when the list is empty
+   */
+  void set_fields(const std::string & field_list);
+
 private:
 
+  /**
+   * write XML VTK file in background
+   */
+  bool _background_write;
+
+  /**
+   * compress the data arrays of binary .vtu writer
+   */
+  bool _compress;
+
+  /**
+   * the keys (see OutputField::key) of the fields to be written, empty for all
+   */
+  std::set<std::string> _fields;
+
+  /**
+   * @return true when the field should be written
+   */
+  bool _export_field(const std::string & sol_name) const;
+
   // boundary info
   std::vector<unsigned int>       _el;
   std::vector<unsigned short int> _sl;
@@ -225,6 +265,25 @@ private:
                                    std::vector<float > & sol_z,
                                    const std::string & sol_name, std::ofstream& out);
 
+  /**
+   * each processor writes the elements it owns to its own XML .vtu piece,
+   * and processor 0 writes the .pvtu index of all the pieces.
+   * no data is gathered to processor 0.
+   */
+  void write_parallel(const std::string & name);
+
+  /**
+   * write the elements of this processor and their nodes into a binary .vtu file
+   * with appended raw data, zlib compressed when enabled.
+   * it needs no VTK library, the names of the point data arrays are returned in \p sol_name
+   */
+  void write_piece(const std::string & name, std::vector<std::string> & sol_name);
+
+  /**
+   * @return the file name of the .vtu piece written by processor \p proc
+   */
+  static std::string piece_file_name(const std::string & pvtu_name, unsigned int proc);
+
   /**
    * out file stream
    */
@@ -239,7 +298,9 @@ private:
 inline
 VTKIO::VTKIO (SimulationSystem& system) :
     FieldInput<SimulationSystem> (system),
-    FieldOutput<SimulationSystem> (system)
+    FieldOutput<SimulationSystem> (system),
+    _background_write(false),
+    _compress(true)
 {
 #ifdef HAVE_VTK
   _vtk_grid = NULL;
@@ -250,7 +311,9 @@ VTKIO::VTKIO (SimulationSystem& system) :
 
 inline
 VTKIO::VTKIO (const SimulationSystem& system) :
-    FieldOutput<SimulationSystem>(system)
+    FieldOutput<SimulationSystem>(system),
+    _background_write(false),
+    _compress(true)
 {
 #ifdef HAVE_VTK
   _vtk_grid = NULL;
@@ -192,6 +192,8 @@ public:
       case SolverSpecify::DampingPotential      : potential_damping(x, y, w, false, changed_y, changed_w); break;
       case SolverSpecify::DampingSuperPotential : potential_damping(x, y, w, true, changed_y, changed_w); break;
       case SolverSpecify::DampingBankRose       : bank_rose_damping(x, y, w, changed_y, changed_w); break;
+      case SolverSpecify::DampingModel          : model_damping(x, y, w, changed_y, changed_w); break;
+      case SolverSpecify::DampingAvalanche      : model_damping(x, y, w, changed_y, changed_w, true); break;
       case SolverSpecify::DampingNo             : positive_density_damping(x, y, w, changed_y, changed_w); break;
       default: positive_density_damping(x, y, w, changed_y, changed_w);
     }
@@ -225,10 +227,73 @@ private:
    */
   void bank_rose_damping(Vec x, Vec y, Vec w, PetscBool *changed_y, PetscBool *changed_w);
 
+  /**
+   * Newton damping by trust region on potential update, sized by linear model of function norm.
+   * with avalanche, the step is also limited so that no carrier density grows more than
+   * SolverSpecify::carrier_update times, which keeps Newton from overshooting the multiplied
+   * carriers at avalanche onset
+   */
+  void model_damping(Vec x, Vec y, Vec w, PetscBool *changed_y, PetscBool *changed_w, bool avalanche=false);
+
   /**
    * Positive carrier density Newton damping scheme
    */
   void positive_density_damping(Vec x, Vec y, Vec w, PetscBool *changed_y, PetscBool *changed_w);
+
+  /**
+   * the jacobian contribution of one region, kept in the slot space of J_slot_map.
+   * a region only adds to the rows of its own nodes, so after DDM1_Jacobian of the region
+   * these rows of J hold exactly its contribution
+   */
+  struct RegionJacobianCache
+  {
+    RegionJacobianCache() : valid(false), stamp(0), n_processor_dofs(0) {}
+
+    bool valid;
+
+    /**
+     * the stamp of J_slot_map the slots belong to
+     */
+    unsigned int stamp;
+
+    /**
+     * the slots of the on processor rows of the region, and the values the region added there
+     */
+    std::vector<PetscInt>    slots;
+    std::vector<PetscScalar> values;
+
+    /**
+     * the dofs of lx the region jacobian depends on, the on processor ones first,
+     * their values when the jacobian was evaluated and the change allowed for each one
+     */
+    std::vector<PetscInt>    dofs;
+    unsigned int             n_processor_dofs;
+    std::vector<PetscScalar> x;
+    std::vector<PetscScalar> tol;
+  };
+
+  /**
+   * the jacobian cache of each region, used when SolverSpecify::RegionJacobianReuse is set.
+   * it is dropped at the beginning of each solve, the models may have changed
+   */
+  std::vector<RegionJacobianCache> _region_jacobian_cache;
+
+  /**
+   * @return true when the cached jacobian of region \p n is valid and the on processor (\p ghost = false)
+   * or the ghost (\p ghost = true) dofs of the region have not moved out of the tolerance
+   */
+  bool region_jacobian_unchanged(unsigned int n, const PetscScalar * lxx, bool ghost) const;
+
+  /**
+   * keep the rows of region \p n in J and the solution they are evaluated at.
+   * J_slot_map should be active
+   */
+  void save_region_jacobian(unsigned int n, const PetscScalar * lxx);
+
+  /**
+   * add the cached rows of region \p n to J. J_slot_map should be active
+   */
+  void load_region_jacobian(unsigned int n);
 };
 
 
@@ -87,6 +87,18 @@ public:
    */
   virtual int destroy_solver() ;
 
+  /**
+   * build the AC system at frequency omega and solve it once, return the time of the two phases.
+   * used by the AC benchmark of genius_bench
+   */
+  void benchmark_frequency(double omega, double & t_build, double & t_solve, KSPConvergedReason & reason);
+
+  /**
+   * @return the (preconditioned) AC matrix in doubled real layout
+   */
+  Mat ac_matrix() const
+  { return A; }
+
   /**
    * @return node's dof for each region.
    * since they are all complex numbers, the required dofs are doubled for real solver
@@ -233,6 +245,22 @@ private:
    * building the Matrix A, RHS vector b under certain freq omega
    */
   void build_ddm_ac(double omega);
+
+  /**
+   * split the AC system into (K + omega G) x = b0 by assembly at omega=0 and omega=1, and check it at omega_check.
+   * A_, b_, A and b are left at omega_check.
+   * @return false when the AC system is not affine in omega (i.e. electrode with inductance), K, G and b0 are not created
+   */
+  bool split_ddm_ac(double omega_check, Mat & K, Mat & G, Vec & b0);
+
+  /**
+   * AC sweep by model order reduction. the AC system is written as (K + omega G) x = b, and projected to
+   * the Krylov subspace span{ (K+omega0 G)^-1 b, [(K+omega0 G)^-1 G] (K+omega0 G)^-1 b, ... } of order
+   * SolverSpecify::ACMOROrder around the center frequency omega0 of the sweep (one sided Arnoldi, as in PRIMA).
+   * the reduced model is then evaluated at each frequency.
+   * @return false when the AC system is not affine in omega (i.e. electrode with inductance), and nothing is done
+   */
+  bool solve_mor();
 };
 
 
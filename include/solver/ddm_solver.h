@@ -58,6 +58,13 @@ public:
    */
   virtual int solve_dcsweep();
 
+  /**
+   * DC voltage sweep cut into SolverSpecify::ParallelBias slices, solved at the same time by
+   * the bias process groups. each group is seeded at the start of its slice by a coarse sweep,
+   * the IV of all the slices are merged into the iv store of group 0
+   */
+  int solve_dcsweep_parallel_bias();
+
   /**
    * do transient simulation
    */
@@ -120,8 +127,58 @@ public:
    */
   virtual void petsc_ksp_convergence_test(PetscInt its, PetscReal rnorm, KSPConvergedReason* reason);
 
+  /**
+   * f norm of each governing equation, for the iteration statistics
+   */
+  virtual void equation_norms(std::vector<std::pair<std::string, PetscReal> > &norms) const;
+
+  /**
+   * adjoint sensitivity of electrode currents to the real parameters of PMI model pmi (basic, band, mobility...)
+   * of region, at the converged solution in x and fixed electrode potentials. for each electrode e,
+   *   J^T lambda_e = dI_e/dx,   dI_e/dp = pI_e/pp - lambda_e^T dF/dp
+   * so one transposed solve per electrode serves all the parameters. dF/dp and pI/pp are forward differences
+   * of the residual. dIdp[e][k] is in internal current unit per user unit of parameter k.
+   * only for solvers which support IV trace (DDML1, DDML2 and EBML3)
+   * @return false when the region/PMI/parameter is not found or the linear solve failed
+   */
+  bool current_sensitivity(const std::vector<BoundaryCondition *> & electrodes, const std::string & region,
+                           const std::string & pmi, const std::vector<std::string> & parameters,
+                           std::vector<std::vector<PetscScalar> > & dIdp);
+
+  /**
+   * impedance field of electrode currents to the net doping of semiconductor nodes, at the converged solution
+   * in x and fixed electrode potentials, by one transposed solve per electrode:
+   *   dI_e/dN_i = -lambda_e^T dF/dN_i
+   * the net doping enters only the poisson equation of its node. the doping dependence of mobility
+   * and incomplete ionization is neglected. the nodes on electrode boundaries are skipped, since the contact
+   * replaces their poisson equation. nodes are the on processor semiconductor nodes, dIdN[e][i] in internal unit.
+   * only for solvers which support IV trace (DDML1, DDML2 and EBML3)
+   * @return false when the linear solve failed
+   */
+  bool doping_sensitivity(const std::vector<BoundaryCondition *> & electrodes,
+                          std::vector<FVM_Node *> & nodes,
+                          std::vector<std::vector<PetscScalar> > & dIdN);
+
+  /**
+   * Newton solve of one doping instance, the donor/acceptor concentrations of nodes are shifted by dNd/dNa.
+   * it starts from the converged solution in x and reuses the mesh, jacobian structure and linear solver of
+   * this solver. the electrode currents of the instance are returned in I, then the nominal doping, solution
+   * and electrode currents are restored. the hooks are not called for the instance.
+   * @return true when Newton converged
+   */
+  bool doping_instance_solve(const std::vector<FVM_Node *> & nodes,
+                             const std::vector<PetscScalar> & dNd, const std::vector<PetscScalar> & dNa,
+                             const std::vector<BoundaryCondition *> & electrodes, std::vector<PetscScalar> & I);
+
 protected:
 
+  /**
+   * write the statistics record of a bias point or time step solved by \p solve.
+   * \p value is the sweep value, \p retries the failed tries of this step so far and
+   * \p recovery is true when the step is diverged and will be tried again
+   */
+  void record_step_stats(const char * solve, double value, int retries, bool recovery);
+
   /**
    * the global privious solution vector at n step
    */
@@ -147,6 +204,76 @@ protected:
    */
   Vec            LTE;
 
+  /**
+   * the normalized LTE of last accepted time step, used by PI time step control
+   */
+  PetscScalar    lte_last;
+
+  /**
+   * PI control of transient time step, see Gustafsson, ACM TOMS 17(4), 1991.
+   * lte is the normalized LTE of the time step just accepted, order is the order of time integration scheme.
+   * @return the scale factor of next time step
+   */
+  PetscScalar pi_step_factor(PetscScalar lte, unsigned int order);
+
+  /**
+   * the function of the last time level in the trapezoidal stage of TR-BDF2
+   */
+  Vec            f_tr;
+
+  /**
+   * evaluate f_tr, the DC function at solution x with the sources at time \p t
+   */
+  void trbdf2_function(PetscScalar t);
+
+  /**
+   * limit the time step from time by the breakpoints of electrical and field sources,
+   * the time step lands exactly on the first breakpoint it would step over
+   */
+  PetscScalar limit_dt_by_breakpoint(PetscScalar time, PetscScalar dt);
+
+  /**
+   * write time step history, solution history and system state of transient simulation
+   * to binary checkpoint file with name prefix, one file per processor
+   */
+  void write_transient_checkpoint(const std::string & prefix);
+
+  /**
+   * resume transient simulation from binary checkpoint file SolverSpecify::RestartFile.
+   * the checkpointed initial guess of next time step is loaded into xp
+   */
+  void read_transient_checkpoint();
+
+  /**
+   * the coarse propagator of parareal: BDF1 with one step per time slice from TStart to TStop.
+   * the state at the end of slice k is written to checkpoint SolverSpecify::CheckpointFile.slice<k>,
+   * as the start point of a fine transient (restart from it, tstop at the end of slice k+1)
+   */
+  void parareal_coarse_pass();
+
+  /**
+   * compare the solution at the end of a fine slice with the coarse one in checkpoint SolverSpecify::PararealNext.
+   * the relative difference is the parareal jump, the slices after it should be corrected when it is large
+   */
+  void parareal_jump();
+
+  /**
+   * solution at the last period boundary, used by PSS detection
+   */
+  Vec            x_pss;
+
+  /**
+   * the next period boundary of PSS detection, negative before the first accepted time step
+   */
+  PetscScalar    pss_clock;
+
+  /**
+   * compare the solution of accepted time step with the one period before when the clock
+   * reaches a period boundary. the period boundaries are counted from the first accepted time step.
+   * @return true when the relative change over one period is below SolverSpecify::PSSTol
+   */
+  bool pss_converged();
+
 
 
   // extra KSP solver for Trace mode
@@ -166,6 +293,11 @@ protected:
    */
   Vec          pdx_pdV;
 
+  /**
+   * the last accepted solution of trace mode
+   */
+  Vec          x_trace;
+
   /**
    * dI/dV = dI/dx * dx/dV
    */
@@ -191,12 +323,77 @@ protected:
    */
   void solve_iv_trace_end();
 
+  /**
+   * predict the solution at bias s of DC sweep by polynomial extrapolation. x holds the solution xs1
+   * at last bias s1 on entry, xs2 and xs3 are the solutions at bias s2 and s3.
+   * n_points is the number of solved bias points, the order is limited by SolverSpecify::PredictOrder
+   */
+  void sweep_predict(PetscScalar s, PetscScalar s1, PetscScalar s2, PetscScalar s3,
+                     Vec xs1, Vec xs2, Vec xs3, unsigned int n_points);
+
+  /**
+   * @return the step of DC sweep for next bias point. with SolverSpecify::SweepAutoStep, the step is scaled by
+   * the ratio of aimed to actual Newton iterations of last bias point, otherwise it grows by 1.1.
+   * the step grows no more than |step_max|
+   */
+  PetscScalar sweep_step(PetscScalar step, PetscScalar step_max);
+
+  /**
+   * gather the iv rows from row \p r of each bias group, which solved \p slice of the
+   * parallel bias sweep (-1 for none), and replace the rows of group 0 by them in slice order.
+   * \p ierr is the sweep status of this group, nothing is merged when any group failed.
+   * must be called on all the processors of all the bias groups
+   * @return nonzero when the sweep of any group failed
+   */
+  int merge_parallel_bias_iv(unsigned int r, int slice, unsigned int n_slices, int ierr);
+
+  /**
+   * the applied voltage and current of all the electrodes, in the order of bcs
+   */
+  void electrode_bias(std::vector<PetscScalar> & vapp, std::vector<PetscScalar> & iapp) const;
+
+  /**
+   * with SolverSpecify::BiasCache, load the cached solution of the nearest electrode bias into x
+   * when its applied voltages differ less than max_distance from the present ones.
+   * called after pre_solve_process(), as the initial guess of Newton
+   * @return true when x is loaded
+   */
+  bool load_bias_solution(PetscScalar max_distance);
+
+  /**
+   * with SolverSpecify::BiasCache, keep the converged solution x at the present electrode bias
+   */
+  void cache_bias_solution();
+
+  /**
+   * continuation to the electrode bias already set, when Newton fails to reach it from the solution
+   * in x, which was solved at electrode bias vapp0/iapp0. the bias is ramped from there with the step
+   * adapted by Newton iterations. when the ramp step gets too small, pseudo transient continuation
+   * (BDF1 with growing time step) is run at the full bias. the intermediate steps are not post processed.
+   * @return true when Newton converged at the full bias, with the solution in x
+   */
+  bool homotopy_solve(const std::vector<PetscScalar> & vapp0, const std::vector<PetscScalar> & iapp0);
+
   /**
    * virtual function for set electrode dI/dV, each ddm solver should re-implement this function
    */
   virtual void set_trace_electrode(BoundaryCondition *)
   { genius_error(); }
 
+  /**
+   * solve J^T lambda = dI/dx of electrode bc with the jacobian of IV trace at the converged solution x,
+   * the entry of the electrode equation in lambda is zeroed since its potential is fixed.
+   * called between solve_iv_trace_begin() and solve_iv_trace_end()
+   * @return false when the linear solve failed
+   */
+  bool current_adjoint(BoundaryCondition * bc, Vec lambda);
+
+  /**
+   * unit tangent (tv, ti) of IV curve at the converged solution, in the IV plane scaled by Vs and Is.
+   * dx/dV is left in pdx_pdV. the tangent keeps the orientation of (tv, ti) on entry
+   */
+  void trace_tangent(BoundaryCondition * bc, PetscScalar Vs, PetscScalar Is, PetscScalar &tv, PetscScalar &ti);
+
   /**
    * x norm of potential
    */
@@ -118,17 +118,10 @@ private:
   */
  void set_doping_function_file(const Parser::Card & c);
 
- double _do_doping_interp(int i, const Node *node, const std::string &msg=std::string());
-
- /**
-  * @return the acceptor concentration of node
-  */
- double doping_Na(const Node * node);
-
  /**
-  * @return the donor concentration of node
+  * @return the location of node in the coordinates of doping file with given axes
   */
- double doping_Nd(const Node * node);
+ Point _doping_data_point(int axes, const Node *node) const;
 
  /**
   * the pointer vector to DopingFunction
@@ -66,6 +66,16 @@ public:
    */
   virtual double profile(double x, double y, double z)=0;
 
+  /**
+   * the box of significant influence, out of which the profile is negligible.
+   * default is the whole space
+   */
+  virtual void influence_box(double &xmin, double &xmax, double &ymin, double &ymax, double &zmin, double &zmax) const
+  {
+    xmin = ymin = zmin = -1e30;
+    xmax = ymax = zmax =  1e30;
+  }
+
 protected:
   /**
    * impurity ion type N-ion or P-ion
@@ -133,6 +143,16 @@ public:
       return 0.0;
   }
 
+  /**
+   * the doping bound box
+   */
+  void influence_box(double &xmin, double &xmax, double &ymin, double &ymax, double &zmin, double &zmax) const
+  {
+    xmin = _xmin-1e-6;  xmax = _xmax+1e-6;
+    ymin = _ymin-1e-6;  ymax = _ymax+1e-6;
+    zmin = _zmin-1e-6;  zmax = _zmax+1e-6;
+  }
+
 private:
   /**
    * the peak value of doping concentration
@@ -217,6 +237,18 @@ public:
     return _ion*_PEAK*dx*dy*dz;
   }
 
+  /**
+   * the doping bound box extended by 6 characteristic lengths,
+   * where both gauss and erfc tails drop below 1e-15 of the peak
+   */
+  void influence_box(double &xmin, double &xmax, double &ymin, double &ymax, double &zmin, double &zmax) const
+  {
+    const double tail = 6.0;
+    xmin = _xmin-tail*_XCHAR;  xmax = _xmax+tail*_XCHAR;
+    ymin = _ymin-tail*_YCHAR;  ymax = _ymax+tail*_YCHAR;
+    zmin = _zmin-tail*_ZCHAR;  zmax = _zmax+tail*_ZCHAR;
+  }
+
 private:
   /**
    * the peak value of doping concentration
@@ -85,42 +85,32 @@ public:
 
   /**
    * @return node's dof for each region.
+   * only the equations enabled by the EBM level of the region are allocated,
+   * i.e. psi, n, p and Tl in semiconductor for lattice heating only
    */
   virtual unsigned int node_dofs(const SimulationRegion * region) const
   {
     switch(region->type())
     {
       case SemiconductorRegion :
-      switch(region->get_advanced_model()->EB_Level)
-      {
-        case ModelSpecify::NONE : return 3; // 3 basic dofs, psi, n and p
-        case ModelSpecify::Tl   :
-        case ModelSpecify::Tn   :
-        case ModelSpecify::Tp   : return 4; // 4 dofs for one of the extra Tl, Tn and Tp equation
-        case ModelSpecify::TnTp :
-        case ModelSpecify::TnTl :
-        case ModelSpecify::TpTl : return 5; // 5 dofs for Tn/Tp, Tn/Tl or Tp/Tl pair
-        case ModelSpecify::ALL  : return 6; // 6 dofs for all of the extra Tl, Tn and Tp equations
-      }
-      //dofs for insulator/conductor node
       case InsulatorRegion     :
       case ElectrodeRegion     :
-      case MetalRegion         :
-      switch(region->get_advanced_model()->EB_Level)
-      {
-        case ModelSpecify::NONE :
-        case ModelSpecify::Tn   :
-        case ModelSpecify::Tp   :
-        case ModelSpecify::TnTp : return 1; // only potential equation
-        case ModelSpecify::Tl   :
-        case ModelSpecify::TnTl :
-        case ModelSpecify::TpTl :
-        case ModelSpecify::ALL  : return 2;// potential equation plus Tl equation
-      }
+      case MetalRegion         : return region->ebm_n_variables();
       default : return 0;
     }
   }
 
+  /**
+   * @return the solution variable of the i-th nodal dof, which depends on the EBM level of region
+   */
+  virtual SolutionVariable node_dof_variable(const SimulationRegion * region, unsigned int i) const
+  {
+    const SolutionVariable vars[6] = {POTENTIAL, ELECTRON, HOLE, TEMPERATURE, E_TEMP, H_TEMP};
+    for(unsigned int n=0; n<6; ++n)
+      if( region->ebm_variable_offset(vars[n]) == i ) return vars[n];
+    return INVALID_Variable;
+  }
+
   /**
    * @return the dofs of each boundary condition.
    */
@@ -163,10 +153,9 @@ public:
    */
   virtual unsigned int bc_node_dofs(const BoundaryCondition * bc) const
   {
-    // return maximum possiable dofs of all the EBM level
     switch (bc->bc_type())
     {
-      case OhmicContact      : return 6; // ohmic electrode current
+      case OhmicContact      : return ohmic_bc_node_dofs(bc); // ohmic electrode current
       case SchottkyContact   : return 1; // displacement current
       case SimpleGateContact : return 1; // displacement current
       case GateContact       : return 1; // displacement current
@@ -177,6 +166,19 @@ public:
   }
 
 
+  /**
+   * @return the dofs of semiconductor node the ohmic electrode current depends on,
+   * maximum possiable dofs of all the EBM level when the semiconductor region is unknown
+   */
+  unsigned int ohmic_bc_node_dofs(const BoundaryCondition * bc) const
+  {
+    const SimulationRegion * r1 = bc->bc_regions().first;
+    const SimulationRegion * r2 = bc->bc_regions().second;
+    if( r1 && r1->type() == SemiconductorRegion ) return r1->ebm_n_variables();
+    if( r2 && r2->type() == SemiconductorRegion ) return r2->ebm_n_variables();
+    return 6;
+  }
+
   /**
    * indicates if PDE involves all neighbor elements.
    * when it is true, the matrix bandwidth will include all the nodes belongs to neighbor elements, i.e. DDM solver
@@ -145,6 +145,22 @@ private:
    */
   void solve_TE_scatter_problem(double lamda, double power, double phase0);
 
+  /**
+   * solve the linear system of current wave length, reuse the factorization
+   * of the first wave length in a batch as preconditioner
+   */
+  void solve_linear_system();
+
+  /**
+   * the number of wave lengths sharing one factorization
+   */
+  unsigned int _batch;
+
+  /**
+   * the number of wave lengths solved in current batch
+   */
+  unsigned int _batch_count;
+
   /**
    * build the matrix A, precondition matrix PC and RHS for TE scatter problem
    */
@@ -0,0 +1,257 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __fvm_edge_assembly_h__
+#define __fvm_edge_assembly_h__
+
+#include <vector>
+
+#include "genius_common.h"
+#include "petsc_type.h"
+#include "adolc.h"
+#include "simulation_region.h"
+#include "solver_specify.h"
+
+
+/**
+ * compile time assembly of the edge flux terms of a region.
+ *
+ * the loop over the region edges, the ghost node filter and the scatter into the
+ * function vector / jacobian matrix are written once here. the physics is given by
+ * a flux model class as template parameter, which defines
+ *
+ *   static const unsigned int n_equation;                    // equations carried by the edge
+ *   unsigned int offset(unsigned int eq) const;              // offset of the equation in the node dofs
+ *   template <typename Scalar>
+ *   void flux(unsigned int edge, const FVM_Node *n1, const FVM_Node *n2,
+ *             const Scalar *u1, const Scalar *u2, Scalar *f) const; // "flux" from node 2 to node 1
+ *
+ * the flux is evaluated with PetscScalar for function, and with AD type of width
+ * 2*n_equation (the variables of the two nodes) for jacobian. so each solver gets its own
+ * instantiation of the loop, specialised by the compiler.
+ *
+ * the edge geometry is read from SimulationRegion::edge_arrays().
+ */
+namespace FVM_EdgeAssembly
+{
+
+  /**
+   * value of a scalar, for flux models which freeze the coefficient in the jacobian
+   */
+  inline PetscScalar value(PetscScalar v)
+  { return v; }
+
+  template <unsigned int N>
+  inline PetscScalar value(const adtl::AutoDScalarT<N> &v)
+  { return v.getValue(); }
+
+
+  /**
+   * add the edge flux of the region into the buffer of function vector
+   */
+  template <class FluxModel>
+  void function(const SimulationRegion & region, const FluxModel & model, const PetscScalar * x,
+                std::vector<int> & iy, std::vector<PetscScalar> & y)
+  {
+    const unsigned int N = FluxModel::n_equation;
+
+    SimulationRegion::const_edge_iterator it = region.edges_begin();
+    SimulationRegion::const_edge_iterator it_end = region.edges_end();
+    for(unsigned int e=0; it!=it_end; ++it, ++e)
+    {
+      const FVM_Node * fvm_n1 = (*it).first;
+      const FVM_Node * fvm_n2 = (*it).second;
+
+      PetscScalar u1[N], u2[N], f[N];
+      for(unsigned int i=0; i<N; ++i)
+      {
+        u1[i] = x[fvm_n1->local_offset()+model.offset(i)];
+        u2[i] = x[fvm_n2->local_offset()+model.offset(i)];
+      }
+
+      model.flux(e, fvm_n1, fvm_n2, u1, u2, f);
+
+      // ignore thoese ghost nodes
+      for(unsigned int i=0; i<N; ++i)
+      {
+        if( fvm_n1->on_processor() )
+        {
+          iy.push_back(fvm_n1->global_offset()+model.offset(i));
+          y.push_back(f[i]);
+        }
+
+        if( fvm_n2->on_processor() )
+        {
+          iy.push_back(fvm_n2->global_offset()+model.offset(i));
+          y.push_back(-f[i]);
+        }
+      }
+    }
+  }
+
+
+  /**
+   * add the jacobian of edge flux of the region into matrix
+   */
+  template <class FluxModel>
+  void jacobian(const SimulationRegion & region, const FluxModel & model, const PetscScalar * x, Mat *jac)
+  {
+    const unsigned int N = FluxModel::n_equation;
+    typedef adtl::AutoDScalarT<2*FluxModel::n_equation> ADScalar;
+
+    SimulationRegion::const_edge_iterator it = region.edges_begin();
+    SimulationRegion::const_edge_iterator it_end = region.edges_end();
+    for(unsigned int e=0; it!=it_end; ++it, ++e)
+    {
+      const FVM_Node * fvm_n1 = (*it).first;
+      const FVM_Node * fvm_n2 = (*it).second;
+
+      // the variables of node 1 are AD direction 0 ... N-1, the ones of node 2 are N ... 2N-1
+      ADScalar u1[N], u2[N], f[N];
+      PetscInt col[2*N];
+      for(unsigned int i=0; i<N; ++i)
+      {
+        u1[i] = x[fvm_n1->local_offset()+model.offset(i)];  u1[i].setADValue(i, 1.0);
+        u2[i] = x[fvm_n2->local_offset()+model.offset(i)];  u2[i].setADValue(N+i, 1.0);
+        col[i]   = fvm_n1->global_offset()+model.offset(i);
+        col[N+i] = fvm_n2->global_offset()+model.offset(i);
+      }
+
+      model.flux(e, fvm_n1, fvm_n2, u1, u2, f);
+
+      // ignore thoese ghost nodes
+      for(unsigned int i=0; i<N; ++i)
+      {
+        if( fvm_n1->on_processor() )
+          MatSetValues(*jac, 1, &col[i], 2*N, &col[0], f[i].getADValue(), ADD_VALUES);
+
+        if( fvm_n2->on_processor() )
+        {
+          ADScalar g = -f[i];
+          MatSetValues(*jac, 1, &col[N+i], 2*N, &col[0], g.getADValue(), ADD_VALUES);
+        }
+      }
+    }
+  }
+
+
+
+  /**
+   * add the jacobian of PoissonFlux into matrix. the flux is linear with constant coefficient,
+   * so the rows are taken from SimulationRegion::poisson_edge_operator() instead of
+   * differentiating the flux of each edge in every Newton iteration
+   */
+  inline void poisson_jacobian(const SimulationRegion & region, Mat *jac, unsigned int psi_offset=0)
+  {
+    const SimulationRegion::EdgeOperator & op = region.poisson_edge_operator();
+
+    std::vector<FVM_Node *>::const_iterator nodes = region.on_local_nodes_begin();
+    const unsigned int n_nodes = region.on_local_nodes_end() - nodes;
+
+    std::vector<PetscInt> col;
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      // ignore thoese ghost nodes
+      if( !nodes[i]->on_processor() ) continue;
+
+      const unsigned int n_entries = op.begin[i+1] - op.begin[i];
+      col.resize(n_entries);
+      for(unsigned int k=0; k<n_entries; ++k)
+        col[k] = nodes[op.node[op.begin[i]+k]]->global_offset() + psi_offset;
+
+      PetscInt row = col[0];
+      MatSetValues(*jac, 1, &row, n_entries, &col[0], &op.value[op.begin[i]], ADD_VALUES);
+    }
+  }
+
+
+  /**
+   * poisson's equation, eps*grad(psi) on the edge
+   */
+  class PoissonFlux
+  {
+  public:
+    static const unsigned int n_equation = 1;
+
+    PoissonFlux(const SimulationRegion & region, unsigned int psi_offset=0)
+      : _edges(region.edge_arrays()), _psi_offset(psi_offset) {}
+
+    unsigned int offset(unsigned int) const
+    { return _psi_offset; }
+
+    template <typename Scalar>
+    void flux(unsigned int e, const FVM_Node *n1, const FVM_Node *n2, const Scalar *u1, const Scalar *u2, Scalar *f) const
+    {
+      // eps at mid point of the edge
+      PetscScalar eps = 0.5*(n1->node_data()->eps() + n2->node_data()->eps());
+      f[0] = eps*_edges.area[e]*(u2[0] - u1[0])/_edges.length[e];
+    }
+
+  private:
+    const SimulationRegion::EdgeArrays & _edges;
+    unsigned int _psi_offset;
+  };
+
+
+  /**
+   * poisson's equation and lattice heat equation, the heat conductance of the material
+   * is evaluated at the temperature of the nodes, and is frozen in the jacobian
+   */
+  template <class MaterialType>
+  class PoissonHeatFlux
+  {
+  public:
+    static const unsigned int n_equation = 2;
+
+    PoissonHeatFlux(const SimulationRegion & region, MaterialType * mt, unsigned int psi_offset=0, unsigned int Tl_offset=1)
+      : _edges(region.edge_arrays()), _mt(mt)
+    { _offset[0] = psi_offset;  _offset[1] = Tl_offset; }
+
+    unsigned int offset(unsigned int eq) const
+    { return _offset[eq]; }
+
+    template <typename Scalar>
+    void flux(unsigned int e, const FVM_Node *n1, const FVM_Node *n2, const Scalar *u1, const Scalar *u2, Scalar *f) const
+    {
+      _mt->mapping(n1->root_node(), n1->node_data(), SolverSpecify::clock);
+      PetscScalar kap1 = _mt->thermal->HeatConduction(value(u1[1]));
+
+      _mt->mapping(n2->root_node(), n2->node_data(), SolverSpecify::clock);
+      PetscScalar kap2 = _mt->thermal->HeatConduction(value(u2[1]));
+
+      // eps and kapa at mid point of the edge
+      PetscScalar eps = 0.5*(n1->node_data()->eps() + n2->node_data()->eps());
+      PetscScalar kap = 0.5*(kap1+kap2);
+
+      f[0] = eps*_edges.area[e]*(u2[0] - u1[0])/_edges.length[e];
+      f[1] = kap*_edges.area[e]*(u2[1] - u1[1])/_edges.length[e];
+    }
+
+  private:
+    const SimulationRegion::EdgeArrays & _edges;
+    MaterialType * _mt;
+    unsigned int _offset[2];
+  };
+
+}
+
+#endif
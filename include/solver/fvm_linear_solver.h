@@ -53,6 +53,11 @@ public:
    */
   void setup_linear_data();
 
+  /**
+   * record the bytes of matrix and vectors
+   */
+  virtual void memory_usage(MemoryLog & log) const;
+
   /**
    * clear linear data
    */
@@ -28,6 +28,7 @@
 #include "config.h"
 #include "enum_petsc_type.h"
 #include "fvm_pde_solver.h"
+#include "mat_slot_map.h"
 //#include "petscis.h"
 //#include "petscvec.h"
 //#include "petscmat.h"
@@ -61,6 +62,11 @@ public:
    */
   void setup_nonlinear_data();
 
+  /**
+   * record the bytes of jacobian matrix and vectors
+   */
+  virtual void memory_usage(MemoryLog & log) const;
+
   /**
    * dump jacobian matrix in petsc format to external file
    * for more detailed analysis of the properties of jacobian matrix
@@ -82,9 +88,29 @@ public:
   void dump_function_vector_petsc(const std::string &file) const;
 
   /**
-   * @return the condition number of jacobian matrix
+   * @return the condition number of jacobian matrix. by default it is the 1-norm estimate of
+   * condition_number_estimate(), the SLEPC singular value solves are used when \p slepc is true
+   */
+  double condition_number_of_jacobian_matrix(bool slepc=false);
+
+  /**
+   * @return the 1-norm condition number estimate of jacobian matrix by Hager/Higham's method.
+   * the inverse of jacobian is applied by the preconditioner of last linear solve, which is
+   * exact when the LU factor is used. only a few extra triangular solves are needed
+   */
+  double condition_number_estimate();
+
+  /**
+   * let the iterative linear solver estimate extreme singular values by its Krylov
+   * (Lanczos/Arnoldi) iterations. must be called before the first solve
    */
-  double condition_number_of_jacobian_matrix();
+  void compute_singular_values(bool flag);
+
+  /**
+   * the extreme singular values of preconditioned operator estimated by last linear solve
+   * @return false if not available, i.e. direct solver or compute_singular_values not enabled
+   */
+  bool extreme_singular_values(PetscReal & emax, PetscReal & emin);
 
   /**
    * calculate eigen value of jacobian matrix
@@ -111,6 +137,16 @@ public:
    */
   virtual void sens_solve();
 
+  /**
+   * quasi-static capacitance matrix C[i][j] = dQ_i/dV_j of the electrodes at the converged solution.
+   * the response to the applied voltage of electrode j is the linear solve J*dx = -dF/dV_j with the
+   * jacobian and preconditioner of the last nonlinear solve, i.e. one back substitution per electrode.
+   * dF/dV_j is the residual difference of a small perturbation of Vapp, since the residual is
+   * linear in Vapp. must be called after sens_solve
+   * @return false if a linear solve failed
+   */
+  bool electrode_capacitance(const std::vector<BoundaryCondition *> & electrodes, std::vector<std::vector<PetscScalar> > & C);
+
   /**
    * clear all the nonlinear solver contex
    */
@@ -142,6 +178,8 @@ public:
 
   /**
    * pure virtual function for evaluating the residual of function f at x
+   * it is called several times in each Newton iteration by line search,
+   * so only PetscScalar should be used here, never the AD types
    */
   virtual void build_petsc_sens_residual(Vec x, Vec r)=0;
 
@@ -175,15 +213,135 @@ public:
    */
   virtual void sens_line_search_post_check(Vec x, Vec y, Vec w, PetscBool *changed_y, PetscBool *changed_w);
 
+  /**
+   * record the function norm of each Newton iteration, used by jacobian reuse test
+   */
+  void record_function_norm(PetscInt its, PetscReal fnorm);
+
+  /**
+   * record the converged reason of nonlinear solver, used by jacobian reuse test
+   */
+  void record_converged_reason(SNESConvergedReason reason);
+
+  /**
+   * write the statistics record of Newton iteration \p its when SolverStats is enabled
+   */
+  void record_iteration_stats(PetscInt its, PetscReal fnorm, SNESConvergedReason reason);
+
+  /**
+   * the residual norm of each governing equation, written to the iteration statistics.
+   * derived class can override it as needed.
+   */
+  virtual void equation_norms(std::vector<std::pair<std::string, PetscReal> > &) const {}
+
+  /**
+   * statistics of current Newton iteration: wall time spent in residual and jacobian
+   * evaluation, and the ratio of damped to original Newton step
+   */
+  double    stats_residual_time;
+  double    stats_jacobian_time;
+  PetscReal stats_damping;
+
+  /**
+   * constant vector added to the residual of SNES when it is not PETSC_NULL,
+   * i.e. the function of the last time level in a trapezoidal time step
+   */
+  Vec       residual_shift;
+
+  /**
+   * test if the jacobian matrix (and the factorized preconditioner) of previous
+   * Newton iteration can be reused when SolverSpecify::JacobianReuse is set.
+   * @return false when the jacobian matrix should be rebuilt
+   */
+  bool reuse_jacobian_matrix();
+
+  /**
+   * after the first assembly, the nonzero pattern of jacobian matrix is known exactly.
+   * re-preallocate the matrix with the actual row lengths to release the memory held by
+   * the estimated pattern of build_dof_map(). the values are kept.
+   * only done once for serial AIJ matrix, does nothing otherwise
+   */
+  void compact_jacobian_matrix();
+
+  /**
+   * take a work vector with the layout of solution vector x, or of local vector lx when local is true.
+   * the vectors are kept in a pool and reused by later solves until the layout changes.
+   * the content is undefined
+   */
+  Vec get_work_vector(bool local=false);
+
+  /**
+   * give the work vector taken by get_work_vector() back to the pool
+   */
+  void restore_work_vector(Vec v, bool local=false);
+
 
 protected:
 
+  /**
+   * the pool of free work vectors with the layout of x and lx
+   */
+  std::vector<Vec> work_vectors;
+  std::vector<Vec> local_work_vectors;
+
 
   /**
    * incidate that the jacobian_matrix is never assembled
    */
   bool jacobian_matrix_first_assemble;
 
+  /**
+   * the preallocation of jacobian matrix has been shrinked to its exact nonzero pattern
+   */
+  bool jacobian_matrix_compacted;
+
+  /**
+   * the jacobian matrix is built in a nonlinear solve which is not diverged, it can be reused
+   */
+  bool jacobian_matrix_reusable;
+
+  /**
+   * the Newton iterations the current jacobian matrix has been reused
+   */
+  unsigned int jacobian_matrix_reuse_count;
+
+  /**
+   * the last nonlinear solve is converged
+   */
+  bool nonlinear_solve_converged;
+
+  /**
+   * Newton iteration number and function norm of current/previous iteration
+   */
+  PetscInt  _snes_its;
+  PetscReal _fnorm;
+  PetscReal _fnorm_previous;
+
+  /**
+   * model damping: the max update allowed in one Newton iteration, and the function norm
+   * before and predicted after last damped Newton step
+   */
+  PetscReal _damping_radius;
+  PetscReal _damping_fnorm;
+  PetscReal _damping_predicted_fnorm;
+  bool      _damping_step_limited;
+
+  /**
+   * @return the damping factor of Newton step y with max update step_max.
+   * the radius starts from radius_init for each nonlinear solve, and is adjusted by the ratio of
+   * actual to predicted reduction of function norm. the prediction comes from the linear model
+   * F - lambda*J*y = (1-lambda)*F + lambda*(F-J*y), which only needs the residual of the linear solve,
+   * one MatMult with the jacobian and no extra residual evaluation. the factor is no more than lambda_max,
+   * which carries the limit of other variables
+   */
+  PetscReal model_damping_factor(Vec y, PetscReal step_max, PetscReal radius_init, PetscReal lambda_max=1.0);
+
+  /**
+   * @return the node-level block size of the jacobian matrix when every node has the
+   * same dofs and each bc/extra dof row block is aligned to it, otherwise 1
+   */
+  PetscInt jacobian_block_size();
+
   /**
    * which type of nonlinear solver to use.
    */
@@ -199,6 +357,95 @@ protected:
    */
   void set_petsc_preconditioner_type(SolverSpecify::PreconditionerType t);
 
+  /**
+   * @return the clear rows of the bcs on all the processors. the rows only change with the bc setting,
+   * so they are gathered at the first Newton iteration of each nonlinear solve, not at every evaluation
+   */
+  const std::vector<PetscInt> & global_clear_rows(const std::vector<PetscInt> & clear_rows);
+
+  /**
+   * the clear rows of all the processors, and if they have been gathered for current solve
+   */
+  std::vector<PetscInt> _global_clear_rows;
+  bool                  _global_clear_rows_valid;
+
+  /**
+   * set an option of PETSc options database for this solver. the option is removed from
+   * the database in clear_nonlinear_data, it should not be seen by the solvers created later
+   */
+  void set_solver_option(const std::string &name, const std::string &value);
+
+  /**
+   * the PETSc options set by set_solver_option
+   */
+  std::vector<std::string> _solver_options;
+
+  /**
+   * physics based block preconditioner, the dofs are split by solution variable (potential,
+   * carriers and temperatures) with AMG on potential block and ILU on the others
+   */
+  void set_petsc_fieldsplit_preconditioner();
+
+  /**
+   * the global index of the local dofs of each solution variable, in the order of
+   * POTENTIAL, ELECTRON, HOLE, TEMPERATURE, E_TEMP, H_TEMP. bc and extra dofs go with potential
+   */
+  void variable_split_index(std::vector< std::vector<PetscInt> > & split_index);
+
+  /**
+   * decoupled Gummel sweeps ahead of the coupled Newton solve, enabled by -gummel_presolve <max sweeps>.
+   * each sweep solves the diagonal block of every solution variable in turn (potential, then carriers
+   * and temperatures) with the others frozen, until the function norm drops by -gummel_presolve_rtol
+   */
+  void gummel_presolve();
+
+  /**
+   * bordered system preconditioner. the bc dofs (electrode, float metal and inter connect
+   * equations) and extra dofs are condensed by schur complement, so their dense rows and
+   * columns never enter the sparse factorization of the node dofs
+   */
+  void set_petsc_bordered_preconditioner();
+
+  /**
+   * two level geometric multigrid preconditioner. the coarse space is the nodes of the
+   * unrefined (level 0) mesh, the fine dofs are interpolated from it through the embedding
+   * matrices of the REFINE.HIERARCHICAL element tree. the coarse operator is the galerkin product
+   */
+  void set_petsc_mg_preconditioner();
+
+  /**
+   * build the interpolation from the level 0 mesh nodes to the dofs of this solver
+   * @return the coarse dofs, 0 when the mesh is not refined
+   */
+  unsigned int build_mg_interpolation(Mat *P);
+
+  /**
+   * select linear solver and preconditioner for LS=auto by global dofs, dofs per processor
+   * and the linear convergence of previous nonlinear solves with LS=auto in this run
+   */
+  void select_auto_linear_solver(SolverSpecify::LinearSolverType &ls, SolverSpecify::PreconditionerType &pc);
+
+  /**
+   * add the linear convergence of last nonlinear solve to the statistic of the LS=auto selection
+   */
+  void record_auto_linear_solver();
+
+  /**
+   * the strategy selected by LS=auto, -1 when LS is given by user
+   */
+  int _auto_linear_solver;
+
+  /**
+   * serial number of the nonlinear solves, links the iteration and step statistics
+   */
+  unsigned int _stats_solve;
+
+  /**
+   * begin time and linear iterations before current Newton iteration
+   */
+  double    _stats_iteration_begin;
+  PetscInt  _stats_lits;
+
   /**
    * the global solution vector
    */
@@ -214,6 +461,16 @@ protected:
    */
   Mat            J;
 
+  /**
+   * the matrix free jacobian operator of JFNK method, J is used as preconditioner matrix then
+   */
+  Mat            Jmf;
+
+  /**
+   * precomputed slots of the nonzero entries of J, built after its first assembly
+   */
+  MatSlotMap     J_slot_map;
+
   /**
    * the left scaling vector of J
    */
@@ -244,6 +501,24 @@ protected:
    */
   VecScatter     scatter;
 
+  /**
+   * scatter of the ghost dofs only. the on processor dofs are located at the head of lx in
+   * the same order as x, they are copied directly. PETSC_NULL if lx does not have this layout
+   */
+  VecScatter     ghost_scatter;
+
+  /**
+   * begin to scatter x to lx. the on processor dofs of lx are ready on return and the caller
+   * can work on them before scatter_local_end. when ghost_scatter is not available, the whole
+   * scatter is finished here and there is no overlap
+   */
+  void scatter_local_begin(Vec x);
+
+  /**
+   * finish the scatter of x to lx, all the dofs of lx are ready on return
+   */
+  void scatter_local_end(Vec x);
+
   /**
    * petsc nonlinear solver contex
    */
@@ -90,6 +90,23 @@ public:
   virtual unsigned int node_dofs(const SimulationRegion * region) const
   { genius_assert(region!=NULL); return 1; }
 
+  /**
+   * @return the solution variable of the i-th nodal dof of each simulation region.
+   * the default follows the DDM layout: psi, n, p and Tl for semiconductor, psi and Tl for others.
+   * solvers with other nodal layout should override it
+   */
+  virtual SolutionVariable node_dof_variable(const SimulationRegion * region, unsigned int i) const
+  {
+    genius_assert(region!=NULL);
+    if( region->type() == SemiconductorRegion )
+    {
+      const SolutionVariable vars[4] = {POTENTIAL, ELECTRON, HOLE, TEMPERATURE};
+      return i<4 ? vars[i] : INVALID_Variable;
+    }
+    const SolutionVariable vars[2] = {POTENTIAL, TEMPERATURE};
+    return i<2 ? vars[i] : INVALID_Variable;
+  }
+
   /**
    * @return the (exact) dofs of each boundary condition
    */
@@ -118,7 +118,12 @@ class HDMSolver : public FVM_ExplicitSolver
 
   private:
 
-    void local_time_advance(int , Real alpha);
+    /**
+     * advance the solution by one explicit step, scaled by alpha.
+     * with local_dt, each node uses its own CFL time step instead of the global minimum,
+     * it is not time accurate but reaches the steady state much faster
+     */
+    void local_time_advance(int , Real alpha, bool local_dt=false);
 
     bool convergence_criteria(int );
 
@@ -35,7 +35,8 @@ public:
   /**
    * constructor
    */
-  MixASolverBase(SimulationSystem & system): DDMSolverBase(system), _circuit(system.get_circuit())
+  MixASolverBase(SimulationSystem & system): DDMSolverBase(system), _circuit(system.get_circuit()), _spice_load_mode(0),
+    _spice_clock(0.0), _spice_substep(0.0)
   {}
 
   /**
@@ -93,6 +94,12 @@ public:
    */
   void build_spice_jacobian(PetscScalar *lxx, Mat *jac, InsertMode &add_value_flag);
 
+  /**
+   * load spice circuit with node values lxx. when reuse is true, the load is skipped if spice still holds
+   * the stamps of the same node values and circuit mode, i.e. the jacobian right after the residual
+   */
+  void spice_circuit_load(const PetscScalar *lxx, bool reuse);
+
   /**
    * spice node 0 is the ground node with V=0, we should set it here
    */
@@ -136,11 +143,73 @@ public:
 
 protected:
 
+  /**
+   * fieldsplit preconditioner with schur complement: the device block is factorized and
+   * the circuit dofs are solved on the schur complement, which avoids zero pivot of circuit rows
+   */
+  void set_spice_schur_preconditioner();
+
+  /**
+   * multirate transient: record the electrode voltage and current of the device at the synchronized step,
+   * and update the norton companion (current source plus secant conductance) seen by the circuit
+   */
+  void spice_multirate_sync();
+
+  /**
+   * multirate transient: advance the circuit alone from the synchronized time \p t_sync toward \p t_next
+   * with its own sub-steps. the sub-steps stop when the electrode voltage drifts more than SpiceMultirateTol
+   * @return the time the device should synchronize at, not larger than \p t_next.
+   * the circuit state is left at _spice_clock, the final circuit step is solved together with the device
+   */
+  PetscScalar spice_multirate_advance(PetscScalar t_sync, PetscScalar t_next);
+
+  /**
+   * newton iteration of the circuit alone, the device is replaced by its norton companion.
+   * only the last processor calls it
+   * @return true when converged
+   */
+  bool spice_circuit_newton();
+
   /**
    * hold the pointer to spice circuit
    */
   SPICE_CKT * _circuit;
 
+  /**
+   * node values and circuit mode of the last spice circuit load
+   */
+  std::vector<PetscScalar> _spice_load_x;
+
+  long _spice_load_mode;
+
+  /**
+   * circuit rows of the jacobian in CSR, the structure is fixed after spice matrix reorder
+   */
+  std::vector<PetscInt>    _spice_row_ptr;
+  std::vector<PetscInt>    _spice_rows;
+  std::vector<PetscInt>    _spice_cols;
+  std::vector<PetscScalar> _spice_values;
+
+  /**
+   * slots of circuit rows in the jacobian, one block per row
+   */
+  MatBlockSlotCache        _spice_slots;
+
+  /**
+   * norton companion of the device at each spice node linked to electrode:
+   * node index, voltage and current at the last synchronized step, and the secant conductance
+   */
+  std::vector<unsigned int> _spice_sync_nodes;
+  std::vector<PetscScalar>  _spice_sync_v;
+  std::vector<PetscScalar>  _spice_sync_i;
+  std::vector<PetscScalar>  _spice_sync_g;
+
+  /**
+   * time of the last accepted circuit state and the last circuit sub-step
+   */
+  PetscScalar               _spice_clock;
+  PetscScalar               _spice_substep;
+
 };
 
 #endif //#define __mixA_solver_h__
@@ -23,6 +23,7 @@
 #define __mole_analytic_h__
 
 #include "point_solver.h"
+#include "simulation_region.h"
 #include "parser.h"
 #include "mole_fun.h"
 
@@ -93,14 +94,12 @@ private:
  void set_mole_function_file(const Parser::Card & c);
 
  /**
-  * @return the first mole fraction of given node
+  * the first (\p first is true) or second mole fraction of n_nodes nodes from node_it.
+  * the mole function is evaluated by threads, the profile file is interpolated at all the nodes at once
   */
- double mole_x(const std::string & region, const Node * node);
-
- /**
-  * @return the second mole fraction of given node
-  */
- double mole_y(const std::string & region, const Node * node);
+ void mole_fraction(const std::string & region, bool first,
+                    SimulationRegion::local_node_iterator node_it, int n_nodes,
+                    std::vector<double> & mole);
 
  /**
   * the pointer vector to DopingFunction
@@ -0,0 +1,110 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __face_bvh_h__
+#define __face_bvh_h__
+
+#include <vector>
+
+#include "point.h"
+
+// Forward Declarations
+class MeshBase;
+class Elem;
+
+/**
+ * a bounding volume hierarchy over the boundary and interface sides of one region,
+ * built by the surface area heuristic. it finds the side where a ray started
+ * inside the region leaves it, without walking the elements in between.
+ */
+class FaceBVH
+{
+public:
+
+  /**
+   * build the tree over the sides of the elements of \p subdomain which have no
+   * neighbor or a neighbor in other subdomain
+   */
+  FaceBVH (const MeshBase& mesh, unsigned int subdomain, unsigned int dim);
+
+  ~FaceBVH();
+
+  /**
+   * @return the number of sides in the tree
+   */
+  unsigned int n_faces() const
+  { return _faces.size(); }
+
+  /**
+   * find the nearest side the ray(p,d) hit with ray parameter larger than t_min
+   * @return the elem the side belongs to, NULL when nothing hit
+   */
+  const Elem * hit(const Point & p, const Point & d, double t_min, unsigned int & side, double & t) const;
+
+private:
+
+  /**
+   * a boundary/interface side
+   */
+  struct Face
+  {
+    const Elem * elem;
+    unsigned int side;
+    const Elem * side_elem;
+    Point        lower, upper;
+    Point        centroid;
+  };
+
+  /**
+   * tree node, the children of internal node are stored next to each other
+   */
+  struct Node
+  {
+    Point        lower, upper;
+    /**
+     * first child for internal node, first face for leaf
+     */
+    unsigned int first;
+    /**
+     * number of faces, zero for internal node
+     */
+    unsigned int n_faces;
+  };
+
+  std::vector<Face> _faces;
+
+  std::vector<Node> _nodes;
+
+  unsigned int      _dim;
+
+  /**
+   * split the faces [begin, end) of node n at depth
+   */
+  void _build(unsigned int n, unsigned int begin, unsigned int end, unsigned int depth);
+
+  /**
+   * @return true if ray(p, d) enters the box of node before t_max, inv_d is 1/d
+   */
+  static bool _hit_box(const Node & node, const Point & p, const Point & inv_d, double t_max, double & t_enter);
+};
+
+#endif
@@ -24,87 +24,138 @@
 #define __light_thread_h__
 
 #include <cmath>
+#include <vector>
+#include <cstddef>
 
 //local include
 #include "point.h"
 #include "plane.h"
 
 class Elem;
+class FixedSizePool;
 
 /**
  * class to define a light
+ *
+ * a ray spawns many short lived secondary rays at interfaces, they are allocated
+ * from a FixedSizePool of the calling thread. a ray must be deleted by the thread
+ * which created it, which holds since each primary ray and its secondaries are traced
+ * by one thread.
  */
 class LightThread
 {
 public:
 
-  LightThread(const Point & p, const Point & dir, const Point & E_dir, double wavelength, double init_power, double power)
-      :_p(p), _dir(dir.unit()), _E_dir(E_dir), _wavelength(wavelength),
-      _init_power(init_power), _power(power)
+  /**
+   * allocate from the pool of the calling thread
+   */
+  static void * operator new(size_t size);
+
+  /**
+   * return to the pool of the calling thread
+   */
+  static void operator delete(void * p, size_t size);
+
+  /**
+   * create the pools of \p n_threads threads, must be called before tracing in threads
+   */
+  static void init_pools(unsigned int n_threads);
+
+  /**
+   * release the pools, all the rays should be deleted
+   */
+  static void clear_pools();
+
+  /**
+   * the most wave lengths a ray carries
+   */
+  static const unsigned int max_waves = 8;
+
+  /**
+   * a ray carries \p n_waves wave lengths along the same path, each with its own power
+   */
+  LightThread(const Point & p, const Point & dir, const Point & E_dir, unsigned int n_waves, const double * wavelength, const double * power)
+      :_p(p), _dir(dir.unit()), _E_dir(E_dir), _n_waves(n_waves)
   {
     hit_elem = NULL;
+    for(unsigned int w=0; w<_n_waves; ++w)
+    {
+      _wavelength[w] = wavelength[w];
+      _init_power[w] = power[w];
+      _power[w]      = power[w];
+    }
   }
 
   /**
-   * light advance to a new point. recalculate the light power.
+   * light advance to a new point. recalculate the light power of each wave length.
    * @param  p_end new light point
-   * @param  im_index loss parameter
-   * @return power loss
+   * @param  im_index loss parameter of each wave length
+   * @param  loss power loss of each wave length
    */
-  double advance_to(const Point & p_end, double im_index)
+  void advance_to(const Point & p_end, const double * im_index, double * loss)
   {
     const double pi = 3.14159265358979;
-    double loss_rate = 4*pi*im_index/_wavelength;
 
     double length = (_p - p_end).size();
     _p = p_end;
 
-    double power_start = _power;
-    _power *= exp(-loss_rate*length);
-    return  power_start - _power;
+    for(unsigned int w=0; w<_n_waves; ++w)
+    {
+      double loss_rate = 4*pi*im_index[w]/_wavelength[w];
+      double power_start = _power[w];
+      _power[w] *= exp(-loss_rate*length);
+      loss[w] = power_start - _power[w];
+    }
   }
 
   /**
-   * when light energy less than 1/1000 of origin energy, it is dead
+   * when light energy of all the wave lengths less than 1/1000 of origin energy, it is dead
    */
   bool is_dead() const
-    { return _power < 1e-3*_init_power; }
+  {
+    for(unsigned int w=0; w<_n_waves; ++w)
+      if( _power[w] >= 1e-3*_init_power[w] ) return false;
+    return true;
+  }
 
   /**
-   * @return the start point of the light
+   * @return the number of wave lengths
    */
-  Point & start_point()
-  { return _p; }
+  unsigned int n_waves() const
+    { return _n_waves; }
 
   /**
-   * @return the start point of the light
+   * @return light power of wave length w
    */
-  const Point & start_point() const
-    { return _p; }
+  double power(unsigned int w) const
+    { return _power[w]; }
 
   /**
-   * @return the direction of the light
+   * scale the power of all the wave lengths, when the ray is split
    */
-  const Point & dir() const
-    { return _dir; }
+  void scale_power(double f)
+  {
+    for(unsigned int w=0; w<_n_waves; ++w)
+      _power[w] *= f;
+  }
 
   /**
-   * @return the intial power
+   * @return the start point of the light
    */
-  double init_power() const
-    { return _init_power; }
+  Point & start_point()
+  { return _p; }
 
   /**
-   * @return light power
+   * @return the start point of the light
    */
-  double power() const
-    { return _power; }
+  const Point & start_point() const
+    { return _p; }
 
   /**
-   * writable reference to power
+   * @return the direction of the light
    */
-  double & power()
-  { return _power; }
+  const Point & dir() const
+    { return _dir; }
 
   /**
    * generate reflection and transmission light at interface
@@ -112,6 +163,8 @@ public:
    * @param norm the norm of interface, form material 2 to material 1
    * @param n1   refraction index of material 1
    * @param n2   refraction index of material 2
+   * the refraction index of the reference wave length decides the path and the
+   * Fresnel coefficients, which are applied to all the wave lengths
    */
   std::pair<LightThread *, LightThread *> interface_light_gen_linear_polarized(const Point & in_p, const Point & norm, double n1, double n2)
   {
@@ -169,13 +222,13 @@ public:
             _E_dir_reflect = (sqrt(reflect_parallel)*reflect_dir.cross(incident_plane.unit_normal()) - sqrt(reflect_perpendicular)*E_perpendicular).unit();
           else
             _E_dir_reflect = (sqrt(reflect_parallel)*reflect_dir.cross(incident_plane.unit_normal()) + sqrt(reflect_perpendicular)*E_perpendicular).unit();
-          LightThread * reflect_light = new LightThread(in_p, reflect_dir, _E_dir_reflect, _wavelength, _init_power, reflect_eff*_power);
+          reflect_light = new LightThread(in_p, reflect_dir, _E_dir_reflect, *this, reflect_eff);
         }
 
         if( refract_eff >=1e-9 )
         {
           Point _E_dir_refract = (sqrt(refract_parallel)*refract_dir.cross(incident_plane.unit_normal()) + sqrt(refract_perpendicular)*E_perpendicular).unit();
-          LightThread * refract_light = new LightThread(in_p, refract_dir, _E_dir_refract, _wavelength, _init_power, refract_eff*_power);
+          refract_light = new LightThread(in_p, refract_dir, _E_dir_refract, *this, refract_eff);
         }
 
         return std::make_pair(reflect_light, refract_light);
@@ -183,7 +236,7 @@ public:
       else //for full reflection
       {
         Point _E_dir_reflect = (reflect_dir.cross(incident_plane.unit_normal()) + E_perpendicular).unit();
-        LightThread * reflect_light = new LightThread(in_p, reflect_dir, _E_dir_reflect, _wavelength, _init_power, _power);
+        LightThread * reflect_light = new LightThread(in_p, reflect_dir, _E_dir_reflect, *this, 1.0);
 
         return std::make_pair(reflect_light, (LightThread *)0);
       }
@@ -193,8 +246,8 @@ public:
       double reflect_eff = (n-1)*(n-1)/((n+1)*(n+1));
       double refract_eff = 4*n/((n+1)*(n+1));
 
-      LightThread * reflect_light = new LightThread(in_p, -_dir, -_E_dir, _wavelength, _init_power, reflect_eff*_power);
-      LightThread * refract_light = new LightThread(in_p,  _dir,  _E_dir, _wavelength, _init_power, refract_eff*_power);
+      LightThread * reflect_light = new LightThread(in_p, -_dir, -_E_dir, *this, reflect_eff);
+      LightThread * refract_light = new LightThread(in_p,  _dir,  _E_dir, *this, refract_eff);
 
       return std::make_pair(reflect_light, refract_light);
     }
@@ -213,6 +266,21 @@ public:
 
 private:
 
+  /**
+   * secondary ray of \p parent, carries \p eff of its power
+   */
+  LightThread(const Point & p, const Point & dir, const Point & E_dir, const LightThread & parent, double eff)
+      :_p(p), _dir(dir.unit()), _E_dir(E_dir), _n_waves(parent._n_waves)
+  {
+    hit_elem = NULL;
+    for(unsigned int w=0; w<_n_waves; ++w)
+    {
+      _wavelength[w] = parent._wavelength[w];
+      _init_power[w] = parent._init_power[w];
+      _power[w]      = eff*parent._power[w];
+    }
+  }
+
   /**
    * starting point of this thread
    */
@@ -228,20 +296,30 @@ private:
    */
   Point _E_dir;
 
+  /**
+   * number of wave lengths
+   */
+  unsigned int _n_waves;
+
   /**
    * wave length of the light
    */
-  const double _wavelength;
+  double _wavelength[max_waves];
 
   /**
    * initial power of this thread
    */
-  const double _init_power;
+  double _init_power[max_waves];
 
   /**
    * current power of this thread
    */
-  double _power;
+  double _power[max_waves];
+
+  /**
+   * the pool of each thread
+   */
+  static std::vector<FixedSizePool *> _pools;
 
 };
 
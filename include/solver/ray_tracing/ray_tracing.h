@@ -36,6 +36,7 @@
 
 
 class ObjectTree;
+class FaceBVH;
 class LightThread;
 
 /**
@@ -96,14 +97,20 @@ private:
   unsigned int _dim;
 
   /**
-   * contains refractive_index of each region for a special lamda
+   * contains refractive_index of each region for the reference (first) wave length of
+   * the bundle being traced, the imaginary part is the largest one in the bundle
    */
   std::map<unsigned int, std::pair<double, double> > _region_refractive_index;
 
   /**
-   * build _region_refractive_index
+   * the imaginary part of refractive_index of each region for each wave length of the bundle
    */
-  void build_region_refractive_index(double lamda);
+  std::map<unsigned int, std::vector<double> > _region_extinction;
+
+  /**
+   * build _region_refractive_index and _region_extinction for a bundle of wave lengths
+   */
+  void build_region_refractive_index(const std::vector<double> & lamdas);
 
   /**
    * after build the _region_refractive_index map, we can access refractive index
@@ -117,6 +124,24 @@ private:
   double get_refractive_index_im(unsigned int sub_id) const
   {return _region_refractive_index.find(sub_id)->second.second;}
 
+  /**
+   * @return the imaginary part of refractive index of each wave length in the bundle
+   */
+  const double * get_extinction(unsigned int sub_id) const
+  { return &(_region_extinction.find(sub_id)->second[0]); }
+
+  /**
+   * the largest relative difference of the real refractive index between the wave lengths
+   * traced along the same path
+   */
+  double _wave_tolerance;
+
+  /**
+   * @return the number of optical sources from \p first on, which can be traced in one bundle,
+   * i.e. the real refractive index of each region differs less than _wave_tolerance
+   */
+  unsigned int wave_bundle(unsigned int first);
+
   /**
    * record all the elements which contains this Node as its vertex
    */
@@ -197,6 +222,19 @@ private:
    */
   ObjectTree *surface_elem_tree;
 
+  /**
+   * boundary/interface side tree of each region, indexed by subdomain
+   */
+  std::vector<FaceBVH *> _region_face_bvh;
+
+  /**
+   * when the region of \p elem does not absorb, the ray deposits nothing on its way,
+   * move it to the elem where it leaves the region instead of stepping through
+   * the elements in between.
+   * @return false if the ray should step to the neighbor elem as usual
+   */
+  bool jump_to_interface(LightThread *ray, const Elem *elem) const;
+
   /**
    * when the light source can be considered as plane wave, this struct stores the plane norm to wave direction.
    * we will build a bounding sphere(C,R) of the mesh, then we build the plane with plane_norm = light_direction
@@ -237,16 +275,20 @@ private:
     { return min_dist*min_dist; }
 
     /**
-     * the start point of each ray, each takes three double value as (X,Y,Z)
-     * only record the rays own by local processor
+     * the start point of all the rays
      */
     std::vector<Point> ray_start_points;
 
+    /**
+     * index of the rays traced by local processor
+     */
+    std::vector<unsigned int> local_rays;
+
     unsigned int n_on_processor_rays() const
-    { return static_cast<unsigned int>(ray_start_points.size()); }
+    { return static_cast<unsigned int>(local_rays.size()); }
 
     const Point & ray_start_point(unsigned int n) const
-    { return ray_start_points[n]; }
+    { return ray_start_points[local_rays[n]]; }
   };
 
   WavePlane _wave_plane;
@@ -274,18 +316,44 @@ private:
 
   /**
    * create the light source, ray direction and how many rays should be traced
-   * if parallel simulation trigged, distribute the task to all the processors
    */
   void create_rays();
 
   /**
-   * do ray tracing of a single ray
+   * the cost (traced segments, including the secondary rays) of each ray
+   * in the last wave length, summed over all the processors
+   */
+  std::vector<unsigned int> _ray_cost;
+
+  /**
+   * distribute the rays to the processors. before any cost is known, the rays
+   * are dealt round robin, since neighbor rays tend to have similar cost.
+   * later each processor gets rays of about equal measured cost.
+   */
+  void distribute_rays();
+
+  /**
+   * order rays by decreasing cost, then by index
+   */
+  struct ray_cost_greater
+  {
+    bool operator()(const std::pair<unsigned int, unsigned int> &a, const std::pair<unsigned int, unsigned int> &b) const
+    {
+      if(a.first != b.first) return a.first > b.first;
+      return a.second < b.second;
+    }
+  };
+
+  /**
+   * do ray tracing of a single ray, add the deposited energy of each elem to \p energy_deposit,
+   * which holds n_waves values for each elem
+   * @return the number of traced segments
    */
-  void ray_tracing(LightThread *);
+  unsigned int ray_tracing(LightThread *, std::vector<double> & energy_deposit) const;
 
   /**
-   * save the energy deposit. for parallel simulation, we must gather this vector
-   * from all the processors (call Parallel::sum(_energy_deposit_in_elem))
+   * the energy deposit of one wave length. each thread traces into its own array,
+   * they are added and summed over all the processors, then split by wave length here
    */
   std::vector<double> _energy_deposit_in_elem;
 
@@ -30,8 +30,10 @@
 #include "boundary_condition_collector.h"
 #include "solver_specify.h"
 #include "hook_list.h"
+#include "iv_store.h"
 #include "log.h"
 #include "perf_log.h"
+#include "memory_log.h"
 
 #include "mxml.h"
 
@@ -93,6 +95,11 @@ public:
    */
   virtual int destroy_solver();
 
+  /**
+   * virtual function, record the bytes of solver data (matrices, vectors ...)
+   */
+  virtual void memory_usage(MemoryLog &) const {}
+
   /**
    * @return reference to system
    */
@@ -134,6 +141,37 @@ public:
   HookList * hook_list()
   { return & _hooks; }
 
+  /**
+   * ask the sweep or transient loop to stop after the current step, i.e. by a hook
+   * when the wanted data are obtained. must be called on all the processors.
+   */
+  void request_stop(const std::string &reason)
+  { _stop_requested = true; _stop_reason = reason; }
+
+  /**
+   * @return true when the solve loop should stop
+   */
+  bool stop_requested() const
+  { return _stop_requested; }
+
+  /**
+   * @return why the solve loop should stop
+   */
+  const std::string & stop_reason() const
+  { return _stop_reason; }
+
+  /**
+   * @return the terminal results of this solve, one row per converged step
+   */
+  const IVStore & iv_store() const
+  { return _iv_store; }
+
+  /**
+   * @return the iv store column of \p quantity (Vapp, potential, current, charge) of
+   * electrode \p bc, invalid_uint if not recorded
+   */
+  unsigned int iv_column(const BoundaryCondition *bc, const std::string &quantity) const;
+
   /**
    * set the root node of solution dom
    */
@@ -156,6 +194,22 @@ protected:
    */
   HookList           _hooks;
 
+  /**
+   * when false, the solve steps are not recorded in iv store, i.e. the seed solutions of a parallel bias sweep
+   */
+  bool               _record_steps;
+
+  /**
+   * when false, the hooks are not called before and after each solve step
+   */
+  bool               _step_hooks;
+
+  /**
+   * replace the rows of iv store from row \p r on by \p rows, which holds n_columns() values per row.
+   * used to merge the terminal results solved by other process groups
+   */
+  void replace_iv_rows(unsigned int r, const std::vector<double> &rows);
+
   /**
    * create a solution dom element, and add to the dom document
    */
@@ -171,6 +225,27 @@ private:
 
   std::string _label;
 
+  /**
+   * stop requested by a hook, and the reason
+   */
+  bool        _stop_requested;
+  std::string _stop_reason;
+
+  /**
+   * the terminal results, filled before the hooks are called
+   */
+  IVStore _iv_store;
+
+  /**
+   * set up the columns of iv store by the solve type, the boundary conditions and circuit
+   */
+  void init_iv_store();
+
+  /**
+   * append the values of the converged step to iv store
+   */
+  void record_iv();
+
 };
 
 
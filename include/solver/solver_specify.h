@@ -62,6 +62,11 @@ namespace SolverSpecify
    */
   extern std::string      out_prefix;
 
+  /**
+   * write the IV results in binary: SPICE binary raw file and the columnar iv store
+   */
+  extern bool             IVBinary;
+
   /**
    * hooks to be installed, \<id \<hook_name, hook_parameters\> \>
    */
@@ -74,6 +79,7 @@ namespace SolverSpecify
 
   /**
    * linear solver scheme: LU, BCGS, GMRES ...
+   * AUTO lets the nonlinear solver select one by problem size
    */
   extern LinearSolverType        LS;
 
@@ -128,6 +134,17 @@ namespace SolverSpecify
   */
   extern double   potential_update;
 
+  /**
+   * the max ratio a carrier density may grow in one Newton step with avalanche damping
+   */
+  extern double   carrier_update;
+
+  /**
+   * evaluate the derivative of impact ionization coefficient by its projection on the driving force,
+   * instead of carrying all the AD directions through the PMI
+   */
+  extern bool     IIProjectedJacobian;
+
 
   /**
    * When absolute error of equation less
@@ -194,6 +211,104 @@ namespace SolverSpecify
    */
   extern double      electrode_abs_toler;
 
+  //--------------------------------------------
+  // preconditioner reuse
+  //--------------------------------------------
+
+  /**
+   * rebuild the preconditioner every PCLag times the jacobian is built in a Newton solve,
+   * -1 never rebuilds it after the first one
+   */
+  extern int         PCLag;
+
+  /**
+   * keep the ordering, fill and symbolic factorization of factor preconditioners (LU/ILU/ICC and
+   * the external direct solvers) across Newton iterations and bias steps
+   */
+  extern bool        PCReuseOrdering;
+
+  //--------------------------------------------
+  // jacobian storage
+  //--------------------------------------------
+
+  /**
+   * store the jacobian matrix in BAIJ format with node-level blocks,
+   * only used when every dof row belongs to a block of the same size
+   */
+  extern bool        JacobianBlock;
+
+  /**
+   * PETSC matrix type of the jacobian, i.e. aijcusparse for GPU linear solvers.
+   * empty for the default host AIJ/BAIJ format
+   */
+  extern std::string MatrixType;
+
+  /**
+   * PETSC vector type of the global solution/residual vectors, should match MatrixType.
+   * empty for the default host vector
+   */
+  extern std::string VectorType;
+
+  //--------------------------------------------
+  // jacobian reuse
+  //--------------------------------------------
+
+  /**
+   * keep the jacobian matrix (and the factorized preconditioner) across
+   * Newton iterations and sweep steps, rebuild it only when the residual
+   * reduction stalls
+   */
+  extern bool        JacobianReuse;
+
+  /**
+   * max Newton iterations one jacobian matrix can be reused
+   */
+  extern unsigned int JacobianReuseMax;
+
+  /**
+   * rebuild the jacobian matrix when the function norm reduction of one Newton
+   * iteration, |F|_{k}/|F|_{k-1}, is larger than this value
+   */
+  extern double      JacobianReuseRatio;
+
+  /**
+   * DDM1: keep the jacobian contribution of each region, and reuse it while the solution of
+   * the region hardly changes, i.e. the regions far from the swept electrode
+   */
+  extern bool        RegionJacobianReuse;
+
+  /**
+   * a region jacobian is reused while no potential changes more than this times kT/q, and
+   * no carrier density changes more than this ratio since the jacobian was evaluated
+   */
+  extern double      RegionJacobianReuseTol;
+
+  /**
+   * Jacobian-free Newton-Krylov: the Krylov solver uses matrix free jacobian-vector product
+   * by finite difference of the residual, the assembled jacobian matrix is only used as preconditioner
+   */
+  extern bool        JFNK;
+
+  //--------------------------------------------
+  // direct solver refinement
+  //--------------------------------------------
+
+  /**
+   * factorize the equilibrated jacobian with static pivoting by MUMPS/SuperLU_DIST, and
+   * recover the accuracy by GMRES against the jacobian with the factorization as preconditioner
+   */
+  extern bool        DirectRefine;
+
+  //--------------------------------------------
+  // device/circuit coupling of mixed mode solvers
+  //--------------------------------------------
+
+  /**
+   * eliminate the device dofs to a schur complement on the spice circuit dofs, the device block is
+   * factorized alone and the small circuit system is solved by GMRES on the complement
+   */
+  extern bool        SpiceSchur;
+
   //--------------------------------------------
   // TS (transient solver)
   //--------------------------------------------
@@ -239,6 +354,21 @@ namespace SolverSpecify
    */
   extern bool      Predict;
 
+  /**
+   * max order of polynomial predict of DC sweep, 1 for linear (secant) and 2 for quadratic
+   */
+  extern unsigned int PredictOrder;
+
+  /**
+   * adjust the step of DC sweep by Newton iterations of last bias point, bounded by VStepMax/IStepMax
+   */
+  extern bool      SweepAutoStep;
+
+  /**
+   * the Newton iterations of one bias point the adaptive DC sweep step aims at
+   */
+  extern unsigned int SweepAutoStepIts;
+
   /**
    * relative tol of TS truncate error, used in AutoStep
    */
@@ -249,6 +379,27 @@ namespace SolverSpecify
    */
   extern double    TS_atol;
 
+  /**
+   * use PI controller (on the LTE of current and last step) instead of the basic controller in AutoStep
+   */
+  extern bool      TS_PIControl;
+
+  /**
+   * mixed mode transient: spice circuit advances with its own sub-steps between device steps,
+   * the device is seen by the circuit as a norton companion of the last synchronized step
+   */
+  extern bool      SpiceMultirate;
+
+  /**
+   * relative change of electrode voltage after which the circuit sub-steps stop and the device is synchronized
+   */
+  extern double    SpiceMultirateTol;
+
+  /**
+   * max number of circuit sub-steps between two device steps
+   */
+  extern int       SpiceMultirateSubsteps;
+
   /**
    * indicate BDF2 can be started.
    */
@@ -290,6 +441,43 @@ namespace SolverSpecify
    */
   extern int       T_Cycles;
 
+  /**
+   * binary checkpoint file of transient simulation, empty for no checkpoint
+   */
+  extern std::string CheckpointFile;
+
+  /**
+   * write transient checkpoint every this number of time steps
+   */
+  extern unsigned int CheckpointSteps;
+
+  /**
+   * resume transient simulation from this binary checkpoint file, empty for a fresh start
+   */
+  extern std::string RestartFile;
+
+  /**
+   * period of periodic steady state (PSS) detection, transient stops when the solution
+   * changes less than PSSTol over one period. 0 for no detection
+   */
+  extern double    PSSPeriod;
+
+  /**
+   * relative tolerance of PSS detection
+   */
+  extern double    PSSTol;
+
+  /**
+   * number of time slices of parareal coarse pass. when nonzero, transient runs a BDF1 pass with one step
+   * per slice and writes a checkpoint at each slice boundary, the fine slices are then run as restarts
+   */
+  extern unsigned int PararealSlices;
+
+  /**
+   * checkpoint of the coarse pass at the end of this slice, the fine slice reports its jump to it
+   */
+  extern std::string PararealNext;
+
 
   //------------------------------------------------------
   // parameters for DC and TRACE simulation
@@ -365,6 +553,24 @@ namespace SolverSpecify
    */
   extern double    RampUpIStep;
 
+  /**
+   * when Newton fails at the first bias point of steadystate or DC sweep, reach it by
+   * adaptive bias ramping from the last solution and then pseudo transient continuation
+   */
+  extern bool      Homotopy;
+
+  /**
+   * start steadystate and DC sweep from the converged solution of the nearest electrode bias
+   * solved before on this system, i.e. by an earlier SOLVE command
+   */
+  extern bool      BiasCache;
+
+  /**
+   * the number of slices of DC voltage sweep, which are solved at the same time by
+   * the bias process groups (genius -bias_groups n). 1 for serial sweep
+   */
+  extern unsigned int ParallelBias;
+
   /**
    * the initial value of gmin
    */
@@ -417,6 +623,18 @@ namespace SolverSpecify
    */
   extern double    Freq;
 
+  /**
+   * the number of frequencies in one batch for AC sweep. the matrix is factorized at the first frequency of each batch,
+   * the other frequencies of the batch are solved by GMRES preconditioned with this factorization.
+   * when the AC system is affine in omega, the other frequencies of the batch are not assembled again
+   */
+  extern unsigned int ACBatch;
+
+  /**
+   * the order of reduced model for AC sweep, 0 for solving the full AC system at each frequency
+   */
+  extern unsigned int ACMOROrder;
+
   /**
    * when OptG is true,
    * the optical carrier generation is considered in the simulation
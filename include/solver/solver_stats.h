@@ -0,0 +1,146 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __solver_stats_h__
+#define __solver_stats_h__
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <utility>
+
+
+/**
+ * machine readable statistics of the nonlinear solves, written as JSON lines
+ * (one JSON object per line) by the first processor. it is enabled by the
+ * command line option -solver_stats <file>.
+ *
+ * each record has a "record" key telling its kind:
+ *   "iteration"  one Newton iteration: equation norms, damping, linear iterations,
+ *                assembly and linear solve time, resident memory
+ *   "step"       one bias point or time step: solve type, sweep value or clock, dt,
+ *                converged reason, retries and diverged recovery
+ *
+ * a record is built by chaining add() and written by write():
+ *   SolverStats("step").add("dt", dt).add("converged", true).write();
+ *
+ * besides the file, the records can be observed by listeners, i.e. the live
+ * metrics endpoint. the listeners must be added on all the processors, the
+ * records are built collectively; only the first processor calls them.
+ */
+class SolverStats
+{
+public:
+
+  /**
+   * receives each record written on the first processor
+   */
+  class Listener
+  {
+  public:
+    virtual ~Listener() {}
+
+    /**
+     * @param record   kind of the record
+     * @param values   the numeric and bool (as 0/1) values
+     * @param strings  the string values
+     */
+    virtual void record(const std::string &record,
+                        const std::vector<std::pair<std::string, double> > &values,
+                        const std::vector<std::pair<std::string, std::string> > &strings) = 0;
+  };
+
+  /**
+   * add a listener, it is not owned by SolverStats
+   */
+  static void add_listener(Listener *listener);
+
+  /**
+   * remove a listener
+   */
+  static void remove_listener(Listener *listener);
+
+  /**
+   * open the statistics file, the first processor writes to it
+   */
+  static void open(const std::string &file);
+
+  /**
+   * close the statistics file
+   */
+  static void close();
+
+  /**
+   * @return true when the statistics are recorded, to file or by a listener
+   */
+  static bool enabled()
+  { return _enabled || !_listeners.empty(); }
+
+  /**
+   * begin a record of kind \p record
+   */
+  SolverStats(const std::string &record);
+
+  SolverStats & add(const std::string &key, double value);
+
+  SolverStats & add(const std::string &key, int value);
+
+  SolverStats & add(const std::string &key, unsigned int value);
+
+  SolverStats & add(const std::string &key, bool value);
+
+  SolverStats & add(const std::string &key, const std::string &value);
+
+  SolverStats & add(const std::string &key, const char * value)
+  { return add(key, std::string(value)); }
+
+  /**
+   * write the record as one line
+   */
+  void write();
+
+private:
+
+  std::ostringstream _record;
+
+  /**
+   * kind of the record and its values, for the listeners
+   */
+  std::string _kind;
+  std::vector<std::pair<std::string, double> > _values;
+  std::vector<std::pair<std::string, std::string> > _strings;
+
+  /**
+   * begin a new key
+   */
+  void _key(const std::string &key);
+
+  /**
+   * the statistics file is open
+   */
+  static bool _enabled;
+
+  static std::vector<Listener *> _listeners;
+};
+
+
+#endif
@@ -25,6 +25,7 @@
 #define __stress_solver_h__
 
 #include <vector>
+#include <string>
 
 #include "enum_petsc_type.h"
 #include "fvm_linear_solver.h"
@@ -32,10 +33,21 @@
 //#include "petscvec.h"
 //#include "petscmat.h"
 #include "petscksp.h"
+#include "parser.h"
 
 
 /**
- * The linear solver contex.
+ * linear elastic solver with 3 displacement dofs per node.
+ * 2D meshes are solved as plane strain with anti-plane displacement.
+ *
+ * the stiffness matrix only depends on the mesh and the elastic constants, it is assembled and
+ * preconditioned once. each load case (a set of STRESS.LOAD cards with the same id) is solved as a
+ * new right hand side against it. a load is an isotropic eigenstrain of a region, either
+ * thermal mismatch alpha*dT or the strain which balances the intrinsic stress sigma of a layer.
+ *
+ * the displacement is continuous across region interfaces: the dofs of an interface node
+ * are assembled to the node of the region with the lowest index, the others follow it.
+ * the boundary given by STRESS fixed=<label> is clamped.
  */
 class StressSolver : public FVM_LinearSolver
 {
@@ -46,8 +58,8 @@ public:
    * solution vector, right hand side (RHS) vector, matrix
    * as well as parallel scatter
    */
-  StressSolver(SimulationSystem & system, Parser::InputParser & decks)
-  : FVM_LinearSolver(system), _decks(decks)
+  StressSolver(SimulationSystem & system, const Parser::Card & c)
+  : FVM_LinearSolver(system), _card(c), _current_case(0), _E(0), _nu(0)
   {system.record_active_solver(this->solver_type());}
 
   /**
@@ -61,6 +73,11 @@ public:
   virtual SolverSpecify::SolverType solver_type() const
   {return SolverSpecify::STRESS;}
 
+  /**
+   * add the load of STRESS.LOAD card to the load case of its id
+   */
+  void add_load(const Parser::Card & c);
+
   /**
    * virtual function, create the solver
    */
@@ -77,7 +94,7 @@ public:
   virtual int destroy_solver() ;
 
   /**
-   * virtual function for building the RHS vector
+   * virtual function for building the RHS vector of current load case
    */
   virtual void build_rhs(Vec b);
 
@@ -88,10 +105,10 @@ public:
 
 
   /**
-   * @return node's dof for each region. only 1 dof here
+   * @return node's dof for each region. 3 displacement dofs for solid region
    */
   virtual unsigned int node_dofs(const SimulationRegion * region) const
-  { assert(region!=NULL); return 1; }
+  { assert(region!=NULL); return _solid(region) ? 3 : 0; }
 
   /**
    * @return the dofs of each boundary condition
@@ -105,18 +122,78 @@ public:
   virtual unsigned int bc_node_dofs(const BoundaryCondition * bc) const
   { assert(bc!=NULL); return 0; }
 
+  /**
+   * the stiffness matrix couples all the nodes of an element
+   */
   virtual bool all_neighbor_elements_involved(const SimulationRegion *) const
-  { return false; }
+  { return true; }
+
+  /**
+   * @return the number of load cases
+   */
+  unsigned int n_load_cases() const
+  { return _load_cases.size(); }
+
+  /**
+   * @return the displacement of load case i, valid after solve
+   */
+  Vec displacement(unsigned int i) const
+  { return _displacement[i]; }
 
  private:
 
-   /**
-  * since reading deck involves stack operate, we can not use const here
-  */
- Parser::InputParser & _decks;
+  /**
+   * the STRESS card
+   */
+  const Parser::Card & _card;
+
+  /**
+   * a load case, the isotropic eigenstrain of each loaded region
+   */
+  struct LoadCase
+  {
+    std::string name;
+    std::vector<std::pair<unsigned int, double> > eigenstrain;
+  };
+
+  std::vector<LoadCase> _load_cases;
+
+  /**
+   * the load case build_rhs works on
+   */
+  unsigned int _current_case;
+
+  /**
+   * young's modulus and poisson ratio
+   */
+  double _E, _nu;
+
+  /**
+   * the clamped dofs on this processor
+   */
+  std::vector<PetscInt> _fixed_dofs;
+
+  /**
+   * the solution of each load case
+   */
+  std::vector<Vec> _displacement;
 
+  /**
+   * @return true if the region takes part in the elastic problem
+   */
+  static bool _solid(const SimulationRegion * region)
+  { return region->type() != VacuumRegion && region->type() != PMLRegion; }
+
+  /**
+   * @return the fvm_node which owns the displacement dofs of the node of fvm_node
+   */
+  const FVM_Node * _master(const FVM_Node * fvm_node) const;
+
+  /**
+   * the rigid body modes as near null space of AMG preconditioner
+   */
+  void _set_near_null_space();
 };
 
 
 #endif // #define __stress_solver_h__
-
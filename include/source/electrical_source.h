@@ -103,6 +103,11 @@ public:
    */
   PetscScalar limit_dt(PetscScalar time, PetscScalar dt, PetscScalar v_change, PetscScalar i_change) const;
 
+  /**
+   * @return the first breakpoint after time of all the sources attached to electrodes
+   */
+  PetscScalar next_breakpoint(PetscScalar time) const;
+
   /**
    * update Vapp or Iapp for all the electrode bcs to new time step
    * @note the default vapp/iapp is 0 for all the electrode
@@ -52,11 +52,31 @@ public:
    */
   void update(double time);
 
+  /**
+   * @return the first breakpoint after time of the effective particle sources and light waveform
+   */
+  double next_breakpoint(double time) const;
+
   /**
    * update system after mesh refine
    */
   void update_system();
 
+  /**
+   * @return the first particle source given by tracks, NULL if there is none
+   */
+  Particle_Source_Track * particle_track_source();
+
+  /**
+   * @return the first particle source fed by in process energy deposits, NULL if there is none
+   */
+  Particle_Source_Deposit * particle_deposit_source();
+
+  /**
+   * clear PatG and assign it again from all the particle sources, i.e. after the tracks changed
+   */
+  void update_particle_generation();
+
   /**
    * @return true when we have particle incident
    */
@@ -72,6 +72,13 @@ public:
    */
   virtual double iapp(double t)=0;
 
+  /**
+   * virtual function, @return the first breakpoint (corner of the waveform) after time t.
+   * the default 1e100 means the waveform is smooth after t
+   */
+  virtual double next_breakpoint(double ) const
+  { return 1e100; }
+
   /**
    * @return const reference of label
    */
@@ -123,6 +130,12 @@ public:
    */
   double iapp(double t)
   { return t>=td? Idc:0;};
+
+  /**
+   * @return td as breakpoint
+   */
+  double next_breakpoint(double t) const
+  { return t<td ? td : 1e100; }
 };
 
 
@@ -175,6 +188,12 @@ public:
    */
   double iapp(double t)
   { return t>=td? Iamp*exp(-alpha*(t-td))*sin(2*3.14159265358979323846*fre*(t-td)):0;};
+
+  /**
+   * @return td as breakpoint
+   */
+  double next_breakpoint(double t) const
+  { return t<td ? td : 1e100; }
 };
 
 
@@ -255,6 +274,21 @@ public:
       else    return I1;
     }
   }
+
+  /**
+   * @return the corners of pulse as breakpoints
+   */
+  double next_breakpoint(double t) const
+  {
+    if(t<td) return td;
+    // start time of current period
+    double t0 = td;
+    if(pr>0) t0 += floor((t-td)/pr)*pr;
+    const double corners[4] = {tr, tr+pw, tr+pw+tf, pr};
+    for(int i=0; i<4; ++i)
+      if(t0+corners[i]>t) return t0+corners[i];
+    return 1e100;
+  }
 };
 
 
@@ -323,6 +357,16 @@ public:
       return I1+(I2-I1)*(1-exp(-(t-td)/trc))+(I1-I2)*(1-exp(-(t-tfd)/tfc));
   }
 
+  /**
+   * @return the start of raising and falling edges as breakpoints
+   */
+  double next_breakpoint(double t) const
+  {
+    if(t<td)  return td;
+    if(t<tfd) return tfd;
+    return 1e100;
+  }
+
 };
 
 
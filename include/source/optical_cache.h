@@ -0,0 +1,112 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __optical_cache_h__
+#define __optical_cache_h__
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "parser.h"
+
+class SimulationSystem;
+class FVM_NodeData;
+
+/**
+ * cache of the optical generation computed by RAYTRACE or EMFEM2D.
+ *
+ * the generation (OptG and OptQ) added by the optical solver is kept in memory,
+ * and with -optical_cache prefix, also in a file of each processor. a later solve
+ * with the same key restores it instead of tracing again. the key is a hash of
+ * the solver card, the content of the files it names (e.g. the spectrum file),
+ * the region materials and the id and location of the on processor nodes.
+ * the time dependence is applied by the ENVELOP waveform in FieldSource::update,
+ * which scales the stored generation.
+ *
+ * file layout: magic, version, key, number of nodes, OptG and OptQ of each node
+ */
+class OpticalCache
+{
+public:
+
+  /**
+   * compute the cache key of the optical solver described by card \p c
+   */
+  OpticalCache(SimulationSystem & system, const Parser::Card & c);
+
+  /**
+   * add the cached generation to the nodes when all the processors have it.
+   * @return true if restored, the solver need not run
+   */
+  bool restore();
+
+  /**
+   * record the generation before the solver runs
+   */
+  void begin();
+
+  /**
+   * store the generation added by the solver since begin()
+   */
+  void end();
+
+private:
+
+  SimulationSystem & _system;
+
+  /**
+   * the cache key of this processor
+   */
+  unsigned long long _key;
+
+  /**
+   * the cache file of this processor, empty when only memory cache is used
+   */
+  std::string _file;
+
+  /**
+   * OptG and OptQ of each node, recorded by begin()
+   */
+  std::vector<double> _before;
+
+  /**
+   * the node data of on processor semiconductor nodes, in a fixed order
+   */
+  void _node_data(std::vector<FVM_NodeData *> & data) const;
+
+  /**
+   * OptG and OptQ of each node
+   */
+  void _values(std::vector<double> & values) const;
+
+  bool _load(std::vector<double> & values) const;
+
+  bool _save(const std::vector<double> & values) const;
+
+  /**
+   * the generations computed in this run, by key
+   */
+  static std::map<unsigned long long, std::vector<double> > _memory;
+};
+
+#endif
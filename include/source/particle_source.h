@@ -24,6 +24,10 @@
 #ifndef __particle_source_h__
 #define __particle_source_h__
 
+#include <string>
+#include <vector>
+#include <algorithm>
+
 #include "auto_ptr.h"
 #include "parser.h"
 #include "point.h"
@@ -57,6 +61,16 @@ public:
     return 0;
   }
 
+  /**
+   * @return the particle incident time and the time of max generation rate as breakpoints
+   */
+  virtual double next_breakpoint(double t) const
+  {
+    if(t<_t0)    return _t0;
+    if(t<_t_max) return _t_max;
+    return 1e100;
+  }
+
   /**
    * assign PatG to mesh node
    */
@@ -199,8 +213,6 @@ public:
    */
   virtual void update_system();
 
-private:
-
   /// track struct
   struct track_t
   {
@@ -209,6 +221,36 @@ private:
     double energy;
   };
 
+  /// the tracks of one particle strike
+  struct strike_t
+  {
+    std::string label;
+    std::vector<track_t> tracks;
+  };
+
+  /**
+   * read the tracks of a track file, grouped by strike.
+   * a line "T x1 y1 z1 x2 y2 z2 E" gives a track from (x1,y1,z1) to (x2,y2,z2) in um with
+   * deposited energy E in MeV, a line "S [label]" starts a new strike. tracks before the
+   * first "S" line form a strike of their own. other lines are ignored.
+   * only the first processor reads the file, the strikes are broadcast to all the processors
+   */
+  static std::vector<strike_t> read_strikes(const std::string &file);
+
+  /**
+   * @return the tracks
+   */
+  const std::vector<track_t> & tracks() const
+  { return _tracks; }
+
+  /**
+   * replace the tracks, update_system() should be called to apply the new tracks
+   */
+  void set_tracks(const std::vector<track_t> &tracks)
+  { _tracks = tracks; }
+
+private:
+
   std::vector<track_t> _tracks;
 
   void _read_particle_profile_track(const std::string &file);
@@ -222,4 +264,84 @@ private:
 };
 
 
+
+/**
+ * set electron/hole generation by energy deposits handed over in process, i.e. by the
+ * stepping action of a Geant4 run linked into a hook, instead of exchanging GDML and data files.
+ *
+ * the producer threads append deposits to their own slot, so no lock is needed as long as
+ * each thread keeps to one slot. set_n_slots() and clear() must not be called when the producers run.
+ * the deposits are collected on the first processor, and binned to the nearest vertex of the
+ * mesh element containing them by update_system()
+ */
+class  Particle_Source_Deposit : public Particle_Source
+{
+public:
+  /**
+   *  constructor
+   */
+  Particle_Source_Deposit(SimulationSystem &, const Parser::Card &);
+
+  /**
+   * destructor
+   */
+  ~Particle_Source_Deposit() {}
+
+  /**
+   * assign PatG to mesh node
+   */
+  virtual void update_system();
+
+  /**
+   * set the number of producer threads, i.e. G4Threading::GetNumberOfRunningWorkerThreads()
+   */
+  void set_n_slots(unsigned int n)
+  { _slots.resize(std::max(1u, n)); }
+
+  /**
+   * @return the number of producer threads
+   */
+  unsigned int n_slots() const
+  { return _slots.size(); }
+
+  /**
+   * append an energy deposit from producer thread \p slot.
+   * the position (x, y, z) is in um and the energy in MeV, the units of the track file and of
+   * the geometry given by region_surface()
+   */
+  void deposit(unsigned int slot, double x, double y, double z, double energy)
+  {
+    std::vector<double> & buffer = _slots[slot];
+    buffer.push_back(x);
+    buffer.push_back(y);
+    buffer.push_back(z);
+    buffer.push_back(energy);
+  }
+
+  /**
+   * forget all the deposits, i.e. before the next event
+   */
+  void clear()
+  {
+    for(unsigned int n=0; n<_slots.size(); ++n)
+      _slots[n].clear();
+  }
+
+  /**
+   * the boundary of region r as triangles in um, for a tessellated solid of the transport code.
+   * vertices holds 3 coordinates for each vertex, facets holds 3 vertex indices for each triangle,
+   * the triangles are oriented with the outside normal of the region
+   */
+  void region_surface(unsigned int r, std::vector<double> &vertices, std::vector<unsigned int> &facets) const;
+
+private:
+
+  /**
+   * x, y, z and energy of each deposit, one buffer per producer thread
+   */
+  std::vector< std::vector<double> > _slots;
+
+};
+
+
 #endif // #define __particle_source_h__
@@ -71,6 +71,13 @@ public:
    */
   virtual double vapp(double t)=0;
 
+  /**
+   * virtual function, @return the first breakpoint (corner of the waveform) after time t.
+   * the default 1e100 means the waveform is smooth after t
+   */
+  virtual double next_breakpoint(double ) const
+  { return 1e100; }
+
   /**
    * @return const reference of label
    */
@@ -124,6 +131,12 @@ public:
   double vapp(double t)
   { return t>=td? Vdc:0;}
 
+  /**
+   * @return td as breakpoint
+   */
+  double next_breakpoint(double t) const
+  { return t<td ? td : 1e100; }
+
 };
 
 
@@ -177,6 +190,12 @@ public:
    */
   double vapp(double t)
   { return t>=td ? V0+Vamp*exp(-alpha*(t-td))*sin(2*3.14159265358979323846*fre*(t-td)) : V0; }
+
+  /**
+   * @return td as breakpoint
+   */
+  double next_breakpoint(double t) const
+  { return t<td ? td : 1e100; }
 };
 
 
@@ -257,6 +276,21 @@ public:
     }
   }
 
+  /**
+   * @return the corners of pulse as breakpoints
+   */
+  double next_breakpoint(double t) const
+  {
+    if(t<td) return td;
+    // start time of current period
+    double t0 = td;
+    if(pr>0) t0 += floor((t-td)/pr)*pr;
+    const double corners[4] = {tr, tr+pw, tr+pw+tf, pr};
+    for(int i=0; i<4; ++i)
+      if(t0+corners[i]>t) return t0+corners[i];
+    return 1e100;
+  }
+
 };
 
 
@@ -324,6 +358,16 @@ public:
 
   }
 
+  /**
+   * @return the start of raising and falling edges as breakpoints
+   */
+  double next_breakpoint(double t) const
+  {
+    if(t<td)  return td;
+    if(t<tfd) return tfd;
+    return 1e100;
+  }
+
 };
 
 
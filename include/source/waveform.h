@@ -38,6 +38,13 @@ public:
 
   virtual double waveform(double )=0;
 
+  /**
+   * virtual function, @return the first breakpoint (corner of the waveform) after time t.
+   * the default 1e100 means the waveform is smooth after t
+   */
+  virtual double next_breakpoint(double ) const
+  { return 1e100; }
+
 private:
 
   /**
@@ -87,6 +94,12 @@ public:
   double waveform(double t)
 { return t>=_td? _amplitude:0.0;}
 
+  /**
+   * @return _td as breakpoint
+   */
+  double next_breakpoint(double t) const
+  { return t<_td ? _td : 1e100; }
+
 };
 
 
@@ -140,6 +153,12 @@ public:
    */
   double waveform(double t)
   { return t>=_td ? _amplitude_bias+_amplitude*exp(-_alpha*(t-_td))*sin(2*3.14159265358979323846*_frequency*(t-_td)) : _amplitude_bias; }
+
+  /**
+   * @return _td as breakpoint
+   */
+  double next_breakpoint(double t) const
+  { return t<_td ? _td : 1e100; }
 };
 
 
@@ -220,6 +239,21 @@ public:
     }
   }
 
+  /**
+   * @return the corners of pulse as breakpoints
+   */
+  double next_breakpoint(double t) const
+  {
+    if(t<_td) return _td;
+    // start time of current period
+    double t0 = _td;
+    if(_pr>0) t0 += floor((t-_td)/_pr)*_pr;
+    const double corners[4] = {_tr, _tr+_pw, _tr+_pw+_tf, _pr};
+    for(int i=0; i<4; ++i)
+      if(t0+corners[i]>t) return t0+corners[i];
+    return 1e100;
+  }
+
 };
 
 
@@ -291,6 +325,16 @@ public:
 
   }
 
+  /**
+   * @return the start of raising and falling edges as breakpoints
+   */
+  double next_breakpoint(double t) const
+  {
+    if(t<_td)  return _td;
+    if(t<_tfd) return _tfd;
+    return 1e100;
+  }
+
 };
 
 
@@ -338,6 +382,17 @@ public:
     return _amplitude*exp(-(t-_t0)*(t-_t0)/(2.0*_tao*_tao));
   }
 
+  /**
+   * @return the rise (3 tao before peak), the peak and the tail (3 tao after peak) of gauss as breakpoints
+   */
+  double next_breakpoint(double t) const
+  {
+    if(t<_t0-3*_tao) return _t0-3*_tao;
+    if(t<_t0)        return _t0;
+    if(t<_t0+3*_tao) return _t0+3*_tao;
+    return 1e100;
+  }
+
 };
 
 
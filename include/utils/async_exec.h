@@ -0,0 +1,109 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#ifndef __async_exec_h__
+#define __async_exec_h__
+
+#include <string>
+
+#include "config.h"
+
+
+/**
+ * run shell commands without blocking the solver.
+ *
+ * a small helper process is forked on the first asynchronous request, so only
+ * the processor which runs the shell hooks pays for it, and only when a hook
+ * asks for it. the solver sends the command lines to the helper over a socket
+ * and goes on; the helper launches each one with posix_spawn("/bin/sh -c <command>")
+ * and reaps the finished children. when a limit of concurrent commands is set,
+ * the extra commands wait in the queue of the helper, never in the solver.
+ * the helper only uses system calls and the heap after the fork, since other
+ * threads (i.e. the log writer) may hold locks at that time.
+ *
+ * without the helper (it failed to start, or on windows), the command is run
+ * synchronously with system().
+ */
+class AsyncExec
+{
+public:
+
+  /**
+   * fork the helper process. it is called by the first request,
+   * a failed start is not tried again
+   */
+  static void start();
+
+  /**
+   * stop the helper after all the queued commands finished, and wait for it
+   */
+  static void stop();
+
+  /**
+   * @return true when the helper is running
+   */
+  static bool running();
+
+  /**
+   * queue \p command for execution, returns immediately
+   */
+  static void run(const std::string &command);
+
+  /**
+   * at most \p n commands run at the same time, 0 for no limit
+   */
+  static void set_max_jobs(unsigned int n);
+
+  /**
+   * wait until all the queued commands finished
+   */
+  static void wait();
+
+private:
+
+  /**
+   * send a request of \p type with \p data to the helper
+   * @return false if the helper is not reachable
+   */
+  static bool _send(char type, const std::string &data);
+
+  /**
+   * main loop of the helper process, never returns
+   */
+  static void _helper_main(int fd);
+
+  /**
+   * the socket connected to the helper, -1 when there is no helper
+   */
+  static int  _fd;
+
+  /**
+   * pid of the helper
+   */
+  static int  _pid;
+
+  /**
+   * true after the first start of the helper
+   */
+  static bool _started;
+};
+
+#endif // #define __async_exec_h__
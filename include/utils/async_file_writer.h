@@ -0,0 +1,117 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#ifndef __async_file_writer_h__
+#define __async_file_writer_h__
+
+#include <string>
+#include <deque>
+#include <utility>
+
+#include "config.h"
+
+#ifdef HAVE_PTHREAD
+  #include <pthread.h>
+#endif
+
+
+/**
+ * write output files from a background thread of the local processor.
+ *
+ * the caller formats the whole file content in memory (a snapshot of the solution),
+ * and hands it over here. the thread writes it to disk while the solver continues
+ * with the next bias or time step. at most two files are staged (double buffering),
+ * a further submit waits until the oldest one is written, so memory stays bounded
+ * when the disk is slower than the solver.
+ *
+ * without pthread support, the file is written immediately.
+ */
+class AsyncFileWriter
+{
+public:
+
+  /**
+   * @return the writer of local processor, the thread is started on first use
+   */
+  static AsyncFileWriter & instance();
+
+  /**
+   * write \p content to file \p name in background.
+   * the content is swapped out, \p content is empty on return
+   */
+  void submit(const std::string &name, std::string &content);
+
+  /**
+   * wait until all the staged files are written
+   */
+  void flush();
+
+  /**
+   * flush the staged files and stop the thread
+   */
+  ~AsyncFileWriter();
+
+private:
+
+  AsyncFileWriter();
+
+  /**
+   * write a file to disk
+   */
+  static void _write_file(const std::string &name, const std::string &content);
+
+  /**
+   * max number of staged files
+   */
+  static const unsigned int _max_staged = 2;
+
+  /**
+   * staged files, filename and content
+   */
+  std::deque< std::pair<std::string, std::string> > _staged;
+
+#ifdef HAVE_PTHREAD
+  /**
+   * thread entry, loops until _stop is set and all the files are written
+   */
+  static void * _thread_main(void *);
+
+  pthread_t       _thread;
+  pthread_mutex_t _mutex;
+
+  /**
+   * signaled when a file is staged or the writer stops
+   */
+  pthread_cond_t  _staged_cond;
+
+  /**
+   * signaled when a file is written
+   */
+  pthread_cond_t  _written_cond;
+
+  /**
+   * stop the thread when all the staged files are written
+   */
+  bool _stop;
+#endif
+};
+
+#endif // #define __async_file_writer_h__
@@ -0,0 +1,83 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#ifndef __deck_server_h__
+#define __deck_server_h__
+
+#include <string>
+
+namespace Parser { class InputParser; }
+class SolverControl;
+
+
+/**
+ * serve input cards over a TCP socket, for optimisation and calibration loops
+ * which run many small decks against the same device.
+ *
+ * the deck given by -i builds the simulation system as usual, then the server
+ * keeps the simulation system and the solver objects alive. each client connection
+ * sends the text of some cards, i.e. MODEL, METHOD, SOLVE, EXPORT, PMI or ATTACH,
+ * and closes its write side or sends a line "END". the cards are appended to the
+ * input deck and run in order, the log is streamed back to the client while they
+ * run. a connection with the text "SHUTDOWN" stops the server.
+ *
+ * only the first processor touches the socket, the cards are broadcast to the others.
+ */
+class DeckServer
+{
+public:
+
+  /**
+   * the cards are appended to decks and run by control
+   */
+  DeckServer(SolverControl &control, Parser::InputParser &decks);
+
+  ~DeckServer();
+
+  /**
+   * listen on address:port, must be called on all the processors.
+   * @return false when the socket can't be set up
+   */
+  bool listen(const std::string &address, int port);
+
+  /**
+   * accept and run the clients one by one until SHUTDOWN
+   */
+  void run();
+
+private:
+
+  SolverControl & _control;
+
+  Parser::InputParser & _decks;
+
+  /**
+   * listening socket of the first processor, -1 otherwise
+   */
+  int _listen_fd;
+
+  /**
+   * read the cards of a client until EOF or a line "END"
+   */
+  std::string _read_cards(int fd);
+};
+
+#endif // #define __deck_server_h__
@@ -35,6 +35,12 @@ class SimulationSystem;
 /**
  * give a 2D mesh (tri/quad), extend it to 3D prismatic mesh.
  * and rebuild the simulation system
+ *
+ * the 3D mesh is built on processor 0 layer by layer, each layer of nodes is
+ * followed by the elements between it and the previous layer, the saved 2D mesh is
+ * released as soon as the extrusion finished.
+ * the z spacing of layers is uniform or graded by z.ratio (from front to back, or from
+ * both faces to the center when z.symmetric is set).
  */
 class ExtendTo3D
 {
@@ -146,10 +152,22 @@ private:
   void sync_solution(const std::string &sol);
 
   /**
-   * map renumbered node id to original node id
+   * the z location of each layer
+   */
+  std::vector<double> z_layers() const;
+
+  /**
+   * map renumbered node id to original node id, only for the nodes of this processor
    */
   std::map<unsigned int, unsigned int> _node_to_old_node_id_map;
 
+  /**
+   * scatter the renumbered node id to original node id map of processor 0 to
+   * the processor which holds the node. the map is broadcast in fixed size pieces,
+   * no processor holds the whole map except processor 0.
+   */
+  void scatter_node_map(const std::vector<unsigned int> &new_to_old);
+
   /**
    * setup new 3d system
    */
@@ -0,0 +1,77 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#ifndef __first_touch_h__
+#define __first_touch_h__
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+
+/**
+ * zero the memory [p, p+bytes) by the threads of this processor, each thread writes the same
+ * contiguous share as a schedule(static) loop over the data would give it.
+ *
+ * the OS places a page on the NUMA node of the thread which writes it first. called right after
+ * the memory is allocated, each share lands close to the thread which works on it later in the
+ * threaded assembly, instead of all the pages landing on the node of the master thread.
+ */
+void first_touch(void * p, size_t bytes);
+
+
+/**
+ * allocator for the large arrays read by the threaded loops, the memory is placed by first_touch().
+ * small blocks come from the heap which is touched already, they are not worth a parallel region.
+ *
+ * the elements are constructed serially by std::vector after allocate() returns,
+ * which does not move the pages any more.
+ */
+template <typename T>
+class FirstTouchAllocator : public std::allocator<T>
+{
+public:
+
+  template <typename U>
+  struct rebind { typedef FirstTouchAllocator<U> other; };
+
+  FirstTouchAllocator() {}
+
+  FirstTouchAllocator(const FirstTouchAllocator &) : std::allocator<T>() {}
+
+  template <typename U>
+  FirstTouchAllocator(const FirstTouchAllocator<U> &) : std::allocator<T>() {}
+
+  T * allocate(size_t n, const void * = 0)
+  {
+    T * p = std::allocator<T>::allocate(n);
+    if( n*sizeof(T) >= min_bytes )
+      first_touch(p, n*sizeof(T));
+    return p;
+  }
+
+  /**
+   * the smallest block placed by first_touch(), larger than the mmap threshold of malloc
+   */
+  static const size_t min_bytes = 256*1024;
+};
+
+#endif
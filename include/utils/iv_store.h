@@ -0,0 +1,148 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+
+#ifndef __iv_store_h__
+#define __iv_store_h__
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "genius_common.h"
+
+
+/**
+ * columnar store of the terminal results of a solve, i.e. electrode voltage, current
+ * and charge, circuit node values, time and frequency. the solver appends one row
+ * after each converged step, and the output hooks read it instead of keeping their own copy.
+ *
+ * the text files are only views of the store. the binary export writes each column as
+ * a contiguous array of doubles with one write.
+ */
+class IVStore
+{
+public:
+
+  IVStore() : _n_rows(0) {}
+
+  /**
+   * remove all the columns and rows
+   */
+  void clear()
+  { _columns.clear(); _n_rows = 0; }
+
+  /**
+   * add a column, must be called before the first row is appended.
+   * \p type is the SPICE variable type, i.e. voltage, current, time.
+   * a column with \p text false is kept in the store but not written by the text views
+   * @return the index of the column
+   */
+  unsigned int add_column(const std::string &name, const std::string &type, bool text=true);
+
+  /**
+   * @return the number of columns
+   */
+  unsigned int n_columns() const
+  { return _columns.size(); }
+
+  /**
+   * @return the number of rows
+   */
+  unsigned int n_rows() const
+  { return _n_rows; }
+
+  /**
+   * @return the name of column \p c
+   */
+  const std::string & name(unsigned int c) const
+  { return _columns[c].name; }
+
+  /**
+   * @return the type of column \p c
+   */
+  const std::string & type(unsigned int c) const
+  { return _columns[c].type; }
+
+  /**
+   * @return true when column \p c is written by the text views
+   */
+  bool text(unsigned int c) const
+  { return _columns[c].text; }
+
+  /**
+   * @return the index of column \p name, invalid_uint if not found
+   */
+  unsigned int column_index(const std::string &name) const;
+
+  /**
+   * @return the values of column \p c
+   */
+  const std::vector<double> & column(unsigned int c) const
+  { return _columns[c].values; }
+
+  /**
+   * @return the value at row \p r of column \p c
+   */
+  double value(unsigned int r, unsigned int c) const
+  { return _columns[c].values[r]; }
+
+  /**
+   * append a row, \p row has one value per column
+   */
+  void append_row(const std::vector<double> &row);
+
+  /**
+   * keep only the first \p n_rows rows
+   */
+  void truncate(unsigned int n_rows);
+
+  /**
+   * write the text columns in SPICE raw format, from the "Flags" line on.
+   * the caller writes the title, date and plot name before.
+   * with \p binary the values are written as "Binary:" rows of doubles
+   */
+  void write_raw(std::ostream &out, bool binary) const;
+
+  /**
+   * write all the columns in binary, column by column. the text head lists the
+   * number of columns and rows, and the name and type of each column, then each column
+   * follows the "Binary:" line as n_rows() doubles in native byte order
+   */
+  void write_columns(std::ostream &out) const;
+
+private:
+
+  struct Column
+  {
+    std::string name;
+    std::string type;
+    bool text;
+    std::vector<double> values;
+  };
+
+  std::vector<Column> _columns;
+
+  unsigned int _n_rows;
+};
+
+#endif // #define __iv_store_h__
@@ -0,0 +1,158 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#ifndef __mapped_file_h__
+#define __mapped_file_h__
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+
+/**
+ * read only view of a whole file. the file is memory mapped when the
+ * platform supports it, otherwise it is loaded into a buffer.
+ */
+class MappedFile
+{
+public:
+
+  /**
+   * open and map file \p filename
+   */
+  MappedFile(const std::string &filename);
+
+  /**
+   * unmap the file
+   */
+  ~MappedFile();
+
+  /**
+   * @return true when the file is opened
+   */
+  bool good() const
+  { return _good; }
+
+  /**
+   * @return the first char of the file
+   */
+  const char * begin() const
+  { return _data; }
+
+  /**
+   * @return one past the last char of the file
+   */
+  const char * end() const
+  { return _data + _size; }
+
+  /**
+   * @return the file size
+   */
+  std::size_t size() const
+  { return _size; }
+
+private:
+
+  const char *      _data;
+
+  std::size_t       _size;
+
+  bool              _good;
+
+  /**
+   * the file is mapped, or loaded into _buffer
+   */
+  bool              _mapped;
+
+  std::vector<char> _buffer;
+
+  // not copyable
+  MappedFile(const MappedFile &);
+  MappedFile & operator= (const MappedFile &);
+};
+
+
+
+/**
+ * hand written scanner for the numeric records of the text mesh files.
+ * all the functions take the current position and the end of text,
+ * they never read beyond the end.
+ */
+namespace NumberScan
+{
+  /**
+   * @return the position of first char after \p p which is not blank (space, tab or CR)
+   */
+  inline const char * skip_blank(const char *p, const char *end)
+  {
+    while( p<end && (*p==' ' || *p=='\t' || *p=='\r') ) ++p;
+    return p;
+  }
+
+  /**
+   * @return the position of first char after \p p which is not blank or new line
+   */
+  inline const char * skip_space(const char *p, const char *end)
+  {
+    while( p<end && (*p==' ' || *p=='\t' || *p=='\r' || *p=='\n') ) ++p;
+    return p;
+  }
+
+  /**
+   * @return the position of the next line
+   */
+  inline const char * next_line(const char *p, const char *end)
+  {
+    while( p<end && *p!='\n' ) ++p;
+    return p<end ? p+1 : end;
+  }
+
+  /**
+   * read a number (integer or real in C notation) at \p p.
+   * @return the position after the number, or NULL when there is no number at \p p.
+   * \p is_integer is set when the number has neither decimal point nor exponent.
+   */
+  const char * read_number(const char *p, const char *end, double &value, bool &is_integer);
+
+  /**
+   * read a real number at \p p, integer is accepted
+   */
+  inline const char * read_real(const char *p, const char *end, double &value)
+  {
+    bool is_integer;
+    return read_number(p, end, value, is_integer);
+  }
+
+  /**
+   * read an integer at \p p, a real number is rounded to nearest integer
+   */
+  inline const char * read_int(const char *p, const char *end, int &value)
+  {
+    bool is_integer;
+    double v;
+    p = read_number(p, end, v, is_integer);
+    if( p ) value = is_integer ? static_cast<int>(v) : static_cast<int>(v+0.5);
+    return p;
+  }
+}
+
+
+#endif
@@ -0,0 +1,161 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#ifndef __metrics_server_h__
+#define __metrics_server_h__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+#include "config.h"
+#include "solver_stats.h"
+
+#ifdef HAVE_PTHREAD
+  #include <pthread.h>
+#endif
+
+
+/**
+ * live solver metrics in the prometheus text exposition format.
+ *
+ * the server listens to the SolverStats records and keeps the latest state:
+ * sweep value, time step, Newton and linear iterations, equation norms, the
+ * wall time of the last step and resident memory. the I/O bytes of the process
+ * are read from /proc when the metrics are collected.
+ *
+ * a background thread of the first processor serves "GET /metrics" over HTTP,
+ * and/or pushes the metrics to a prometheus push gateway periodically. it lives
+ * for the whole run, across the SOLVE commands.
+ */
+class MetricsServer : public SolverStats::Listener
+{
+public:
+
+  /**
+   * @return the server of this process
+   */
+  static MetricsServer & instance();
+
+  /**
+   * start the server, must be called on all the processors.
+   * it is started only once, later calls are ignored.
+   * @param address   listen address, empty for no http endpoint
+   * @param port      listen port
+   * @param gateway   push gateway as host:port, empty for no push
+   * @param interval  push interval in second
+   * @param job       job label of the metrics
+   */
+  void start(const std::string &address, int port,
+             const std::string &gateway, double interval,
+             const std::string &job);
+
+  /**
+   * @return true when started
+   */
+  bool started() const
+  { return _started; }
+
+  /**
+   * update the state from a statistics record
+   */
+  virtual void record(const std::string &record,
+                      const std::vector<std::pair<std::string, double> > &values,
+                      const std::vector<std::pair<std::string, std::string> > &strings);
+
+  /**
+   * @return the metrics in text exposition format
+   */
+  std::string exposition();
+
+  /**
+   * push the last metrics and stop the thread
+   */
+  ~MetricsServer();
+
+private:
+
+  MetricsServer();
+
+  bool _started;
+
+  std::string _job;
+
+  std::string _gateway;
+
+  double _interval;
+
+  /**
+   * listening socket, -1 when there is no http endpoint
+   */
+  int _listen_fd;
+
+  /**
+   * wall clock of the start and of the last step record
+   */
+  double _t_start;
+  double _t_last_step;
+
+  /**
+   * accumulated counters and latest gauges, by metric name
+   */
+  std::map<std::string, double> _counters;
+  std::map<std::string, double> _gauges;
+
+  /**
+   * latest norm of each equation
+   */
+  std::map<std::string, double> _norms;
+
+  /**
+   * type of the last step, i.e. dcsweep or transient
+   */
+  std::string _step_type;
+
+  /**
+   * answer one http connection
+   */
+  void _serve(int fd);
+
+  /**
+   * PUT the metrics to the push gateway
+   */
+  void _push();
+
+#ifdef HAVE_PTHREAD
+  /**
+   * thread entry, serves and pushes until _stop is set
+   */
+  static void * _thread_main(void *);
+
+  pthread_t       _thread;
+
+  /**
+   * guards the metrics state
+   */
+  pthread_mutex_t _mutex;
+
+  bool _stop;
+#endif
+};
+
+#endif // #define __metrics_server_h__
@@ -23,16 +23,20 @@
 #ifndef __nn_locator_h__
 #define __nn_locator_h__
 
-#include <set>
 #include <vector>
-#include <functional>
-#include <kdtree.hpp>
+
+#include "genius_common.h"
+#include "point.h"
 
 class Node;
 class MeshBase;
+class ANNkd_tree;
 
 /**
- * find the nearest nodes in given subdomain by point p
+ * find the nearest nodes in given subdomain by point p.
+ * the nodes of each subdomain are held by an ANN kd-tree, the radius
+ * search is done by ANN fixed radius search, which is exact.
+ * ANN search uses global variables, the locator is not thread safe.
  */
 // ------------------------------------------------------------
 // NearestNodeLocator class definition
@@ -57,27 +61,49 @@ public:
   std::vector<const Node * > nearest_nodes(const Point &p, Real radius, unsigned int subdomain) const;
 
   /**
-   * @return the nearest nodes of segment p1-p2 inside given radius and in specified region
+   * @return the nodes in specified region whose distance to segment p1-p2 is within given radius,
+   * sorted by address
    */
   std::vector<const Node * > nearest_nodes(const Point &p1, const Point &p2, Real radius, unsigned int subdomain) const;
 
   /**
-   * @return the nearest nodes of segment p1-p2 inside given radius and in specified region
+   * batched version of above, the nodes near each segment in specified region.
+   * nns[i] holds the nodes of segments[i]
    */
-  void nearest_nodes(const Point &p1, const Point &p2, Real radius, unsigned int subdomain, std::set<const Node * >& nns) const;
+  void nearest_nodes(const std::vector< std::pair<Point, Point> > &segments, Real radius, unsigned int subdomain,
+                     std::vector< std::vector<const Node * > > &nns) const;
 
 private:
 
   const MeshBase& _mesh;
 
-  typedef KDTree::KDTree<3, const Node *, std::pointer_to_binary_function<const Node *, unsigned int, Real> > kdtree_type;
+  /**
+   * the nodes of each subdomain, indexed by ANN point index
+   */
+  std::vector< std::vector<const Node *> > _nodes;
 
   /**
-   * kdtree for each subdomain
+   * coordinates of the nodes of each subdomain, ANN points point into it
    */
-  std::vector<kdtree_type *> _kdtrees;
+  std::vector< std::vector<double> > _coords;
+
+  /**
+   * ANN point array of each subdomain
+   */
+  std::vector< std::vector<double *> > _ann_points;
+
+  /**
+   * kdtree for each subdomain, NULL for the subdomain without node
+   */
+  std::vector<ANNkd_tree *> _kdtrees;
+
+  /**
+   * append the nodes of subdomain within radius of segment p1-p2 to nns.
+   * idx and dist are work arrays
+   */
+  void _segment_search(const Point &p1, const Point &p2, Real radius, unsigned int subdomain,
+                       std::vector<int> &idx, std::vector<double> &dist, std::vector<const Node * > &nns) const;
 };
 
 
 #endif
-
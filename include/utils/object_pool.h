@@ -0,0 +1,158 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+//  $Id: object_pool.h,v 1.1 2008/07/09 05:58:16 gdiso Exp $
+
+#ifndef __object_pool_h__
+#define __object_pool_h__
+
+#include <vector>
+#include <cstddef>
+
+
+/**
+ * chunked allocator of fixed size memory blocks.
+ *
+ * a mesh holds millions of small Node, Elem and FVM_Node objects. allocating them
+ * one by one from the heap is slow and fragments the memory. the pool carves the
+ * blocks from large chunks and recycles freed blocks by a free list.
+ * when the last block is freed (i.e. the mesh is cleared), all the chunks are
+ * released to the system at once.
+ *
+ * @note the pool is not thread safe, objects should be created and destroyed serially.
+ */
+class FixedSizePool
+{
+public:
+
+  /**
+   * pool of blocks with \p size bytes, each chunk holds \p n_block_per_chunk blocks.
+   */
+  FixedSizePool(size_t size, size_t n_block_per_chunk = 4096);
+
+  ~FixedSizePool();
+
+  /**
+   * @return a free block
+   */
+  void * allocate();
+
+  /**
+   * return block \p p to the pool
+   */
+  void deallocate(void * p);
+
+  /**
+   * @return the block size
+   */
+  size_t block_size() const
+  { return _block_size; }
+
+  /**
+   * @return the block size used to serve objects of \p size bytes,
+   * enough for the free list link and aligned for double/pointer
+   */
+  static size_t aligned_size(size_t size);
+
+  /**
+   * @return number of blocks in use
+   */
+  size_t n_used() const
+  { return _n_used; }
+
+private:
+
+  /**
+   * free block is linked by its first bytes
+   */
+  struct FreeBlock { FreeBlock * next; };
+
+  size_t _block_size;
+
+  size_t _n_block_per_chunk;
+
+  std::vector<char *> _chunks;
+
+  FreeBlock * _free_list;
+
+  size_t _n_used;
+
+  /**
+   * release all the chunks
+   */
+  void release();
+};
+
+
+
+/**
+ * object allocation for a class hierarchy, each object size has its own FixedSizePool.
+ * a class becomes pool allocated by forwarding its operator new/delete here:
+ \verbatim
+   static void * operator new(size_t size)           { return pool().allocate(size); }
+   static void operator delete(void * p, size_t size) { pool().deallocate(p, size); }
+ \endverbatim
+ * since delete of a class with virtual destructor passes the size of the dynamic type,
+ * derived classes find their pool without any change.
+ * large objects are passed to the global operator new/delete.
+ */
+class ObjectPool
+{
+public:
+
+  ObjectPool() {}
+
+  ~ObjectPool();
+
+  /**
+   * allocate an object of \p size bytes
+   */
+  void * allocate(size_t size);
+
+  /**
+   * free an object of \p size bytes
+   */
+  void deallocate(void * p, size_t size);
+
+private:
+
+  /**
+   * the max object size served by pools
+   */
+  static const size_t max_pool_size = 1024;
+
+  /**
+   * the pools, one for each object size. only a few derived types, so a vector is enough
+   */
+  std::vector<FixedSizePool *> _pools;
+
+  /**
+   * find the pool of \p size, create it if not exist
+   */
+  FixedSizePool * find_pool(size_t size);
+
+  // forbid copy
+  ObjectPool(const ObjectPool &);
+  ObjectPool & operator= (const ObjectPool &);
+};
+
+
+#endif
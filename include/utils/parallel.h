@@ -27,6 +27,7 @@
 #include <map>
 #include <set>
 #include <complex>
+#include <algorithm>
 
 // Local includes
 #include "genius_env.h"
@@ -433,6 +434,15 @@ namespace Parallel
   template <typename T1, typename T2>
   inline void broadcast(std::map<T1, T2> &map, const unsigned int root_id=0);
 
+  //-------------------------------------------------------------------
+  /**
+   * Broadcast a buffer of \p size elements in place. All the processors
+   * should know the size and own the buffer already, so neither the size
+   * is broadcasted nor the buffer is resized or copied.
+   */
+  template <typename T>
+  inline void broadcast_buffer(T *data, const unsigned int size, const unsigned int root_id=0);
+
   //-----------------------------------------------------------------------
   // Parallel members
 
@@ -1458,21 +1468,30 @@ namespace Parallel
       return;
     }
 
-    // copy the input buffer
-    std::vector<T> r_src = r;
-
-    // now resize it to hold the global data
-    // on the receiving processor
+    int ierr;
     if (root_id == Genius::processor_id())
+    {
+      // resize the buffer to hold the global data on the receiving processor,
+      // and move our own data to its slot, it is received in place
       r.resize(globalsize);
+      if (mysize && displacements[root_id])
+        std::copy_backward (r.begin(), r.begin()+mysize, r.begin()+displacements[root_id]+mysize);
 
-    // and get the data from the remote processors
-    const int ierr =
-      MPI_Gatherv (r_src.empty() ? NULL : &r_src[0], mysize, datatype<T>(),
-                   r.empty() ? NULL :  &r[0], &sendlengths[0],
-                   &displacements[0], datatype<T>(),
-                   root_id,
-                   PETSC_COMM_WORLD);
+      ierr = MPI_Gatherv (MPI_IN_PLACE, 0, datatype<T>(),
+                          &r[0], &sendlengths[0],
+                          &displacements[0], datatype<T>(),
+                          root_id,
+                          PETSC_COMM_WORLD);
+    }
+    else
+    {
+      // the others send their buffer directly
+      ierr = MPI_Gatherv (r.empty() ? NULL : &r[0], mysize, datatype<T>(),
+                          NULL, &sendlengths[0],
+                          &displacements[0], datatype<T>(),
+                          root_id,
+                          PETSC_COMM_WORLD);
+    }
 
     assert (ierr == MPI_SUCCESS);
 
@@ -1721,17 +1740,17 @@ namespace Parallel
       return;
     }
 
-    // copy the input buffer
-    std::vector<T> r_src(r);
-
-    // now resize it to hold the global data
+    // now resize it to hold the global data, and move our own data
+    // to its slot, it is gathered in place without a copy of the input buffer
+    const unsigned int my_displacement = displacements[Genius::processor_id()];
     r.resize(globalsize);
+    if (mysize && my_displacement)
+      std::copy_backward (r.begin(), r.begin()+mysize, r.begin()+my_displacement+mysize);
 
     // and get the data from the remote processors.
-    // Pass NULL if our vector is empty.
     const int ierr =
-      MPI_Allgatherv (r_src.empty() ? NULL : &r_src[0], mysize, datatype<T>(),
-                      r.empty()     ? NULL : &r[0],     &sendlengths[0],
+      MPI_Allgatherv (MPI_IN_PLACE, 0, datatype<T>(),
+                      &r[0], &sendlengths[0],
                       &displacements[0], datatype<T>(), PETSC_COMM_WORLD);
 
     assert (ierr == MPI_SUCCESS);
@@ -2121,6 +2140,28 @@ namespace Parallel
     STOP_LOG("broadcast()", "Parallel");
   }
 
+
+
+  template <typename T>
+  inline void broadcast_buffer (T *data, const unsigned int size, const unsigned int root_id)
+  {
+    if (Genius::n_processors() == 1)
+    {
+      assert (Genius::processor_id() == root_id);
+      return;
+    }
+
+    if (size == 0) return;
+
+    START_LOG("broadcast()", "Parallel");
+
+    const int ierr = MPI_Bcast (data, size, datatype<T>(), root_id, PETSC_COMM_WORLD);
+
+    assert (ierr == MPI_SUCCESS);
+
+    STOP_LOG("broadcast()", "Parallel");
+  }
+
   inline void broadcast (std::vector<std::string> &data, const unsigned int root_id)
   {
     if (Genius::n_processors() == 1)
@@ -2371,6 +2412,9 @@ namespace Parallel
   template <typename T>
   inline void broadcast (std::set<T> &, const unsigned int) {}
 
+  template <typename T>
+  inline void broadcast_buffer (T *, const unsigned int, const unsigned int) {}
+
   template <typename T1, typename T2>
   inline void broadcast(std::map<T1, T2> &, const unsigned int) {}
 
@@ -101,6 +101,18 @@ public:
    */
   virtual const Elem* operator() (const Point& p) const = 0;
 
+  /**
+   * Locates the element of each point in \p p. the default implementation
+   * calls \p operator() for each point
+   */
+  virtual void locate_batch (const std::vector<Point>& p, std::vector<const Elem*>& elems) const;
+
+  /**
+   * Updates the locator after elements are added to the mesh, i.e. by mesh refinement.
+   * @return false when the locator can not be updated and should be rebuilt
+   */
+  virtual bool update () { return false; }
+
   /**
    * @returns \p true when this object is properly initialized
    * and ready for use, \p false otherwise.
@@ -115,6 +115,20 @@ public:
    */
   virtual const Elem* operator() (const Point& p) const;
 
+  /**
+   * Locates the element of each point in \p p. the points are sorted by Morton code,
+   * so that successive points are near in space, and are shared by threads in contiguous
+   * blocks. each thread starts its search from the element of its previous point.
+   * the cached element of \p operator() is not used, it is safe to call concurrently.
+   */
+  virtual void locate_batch (const std::vector<Point>& p, std::vector<const Elem*>& elems) const;
+
+  /**
+   * Inserts the elements added by mesh refinement into the tree
+   * @return false when the tree can not be updated and should be rebuilt
+   */
+  virtual bool update ();
+
   /**
    * Enables out-of-mesh mode.  In this mode, if asked to find a point
    * that is contained in no mesh at all, the point locator will
@@ -132,6 +146,12 @@ public:
 
 protected:
 
+  /**
+   * Locates the element contains point \p p, check element \p hint first.
+   * it does not modify the locator.
+   */
+  const Elem* _locate (const Point& p, const Elem * hint) const;
+
   /**
    * Pointer to our tree.  The tree is built at run-time
    * through \p init().  For servant PointLocators (not master),
@@ -29,6 +29,12 @@
 #include "auto_ptr.h"
 #include "enum_surface_locator_type.h"
 
+#include <vector>
+
+class MeshBase;
+class Elem;
+class Point;
+
 /**
  * This is the base class for surface element locators.
  * They locate surface element of a specified region in space
@@ -94,6 +100,15 @@ public:
    */
   virtual std::pair<const Elem*, unsigned int> operator() (const Point& p, Point & project_point, Real dist=1e30) const = 0;
 
+  /**
+   * Locates the nearest surface element of each point in \p p, the points are shared by threads.
+   * the element of a point without surface element found is NULL
+   */
+  void locate_batch (const std::vector<Point>& p,
+                     std::vector< std::pair<const Elem*, unsigned int> > & surface_elems,
+                     std::vector<Point> & project_points,
+                     Real dist=1e30) const;
+
   /**
    * @returns \p true when this object is properly initialized
    * and ready for use, \p false otherwise.
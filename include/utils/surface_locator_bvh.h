@@ -0,0 +1,125 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __surface_locator_bvh_h__
+#define __surface_locator_bvh_h__
+
+#include "surface_locator_base.h"
+#include "point.h"
+
+#include <vector>
+
+// Forward Declarations
+class MeshBase;
+class Elem;
+
+
+
+/**
+ * surface element locator by a bounding volume hierarchy.
+ * the bounding boxes of surface elements are split at the median of the longest axis
+ * until a few elements left. the nearest element is searched from the nearest box first,
+ * boxes farther than the best element found so far are skipped. so a query visits
+ * O(log n) boxes instead of all the n surface elements.
+ */
+
+// ------------------------------------------------------------
+// SurfaceLocatorBVH class definition
+class SurfaceLocatorBVH : public SurfaceLocatorBase
+{
+public:
+
+  /**
+   * Constructor.
+   */
+  SurfaceLocatorBVH (const MeshBase& mesh, const unsigned int subdomain);
+
+  /**
+   * Constructor.
+   */
+  SurfaceLocatorBVH (const MeshBase& mesh, const short int boundary);
+
+  /**
+   * Destructor.
+   */
+  ~SurfaceLocatorBVH ();
+
+  /**
+   * Clears the \p SurfaceLocator.
+   */
+  void clear();
+
+  /**
+   * Initializes the surface locator, so that the \p operator() methods can
+   * be used.
+   */
+  void init();
+
+  /**
+   * Locates the element with specified subdomain which is nearest to given point p.
+   * only elements within dist are considered
+   */
+  std::pair<const Elem*, unsigned int> operator() (const Point& p, Point & project_point, const Real dist=1e30) const ;
+
+
+private:
+
+  /**
+   * a node of the hierarchy. leaf holds n_elems > 0 surface elements from first,
+   * otherwise the children are left and right
+   */
+  struct BVHNode
+  {
+    Point bmin, bmax;
+    unsigned int left, right;
+    unsigned int first, n_elems;
+  };
+
+  /**
+   * build the hierarchy of surface elements order[first, last), the range of order is
+   * rearranged such that the elements of each leaf are contiguous
+   * @return the index of the node
+   */
+  unsigned int _build(unsigned int first, unsigned int last, std::vector<unsigned int> &order,
+                      const std::vector<Point> &centroids, const std::vector<Point> &bmin, const std::vector<Point> &bmax);
+
+  /**
+   * @return the distance of p to the bounding box of node, 0 for p inside the box
+   */
+  static Real _box_distance(const BVHNode & node, const Point &p);
+
+  std::vector<BVHNode> _nodes;
+
+  /**
+   * store surface elem here, delete them when exit, ordered by leaf
+   */
+  std::vector<const Elem *> _surface_element_list;
+
+  /**
+   * the volume element and side of each surface element
+   */
+  std::vector< std::pair<const Elem *, unsigned int> > _surface_to_volume_element;
+
+};
+
+
+#endif
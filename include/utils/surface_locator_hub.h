@@ -28,6 +28,9 @@
 #include "genius_common.h"
 #include "enum_surface_locator_type.h"
 
+#include <vector>
+#include <map>
+
 class MeshBase;
 class Elem;
 class Point;
@@ -49,7 +52,7 @@ public:
   /**
    * Constructor.
    */
-  SurfaceLocatorHub (const MeshBase& mesh, const SurfaceLocatorType t=SurfaceLocator_SPHERE);
+  SurfaceLocatorHub (const MeshBase& mesh, const SurfaceLocatorType t=SurfaceLocator_BVH);
 
   /**
    * Destructor.
@@ -74,8 +77,32 @@ public:
    */
   std::pair<const Elem*, unsigned int> operator() (const Point& p, const short int boundary, Point & project_point, const Real dist=1e30);
 
+  /**
+   * Locates the surface elements with specified subdomain which are nearest to each point of p
+   */
+  void operator() (const std::vector<Point>& p, const unsigned int subdomain,
+                   std::vector< std::pair<const Elem*, unsigned int> > & surface_elems,
+                   std::vector<Point> & project_points, const Real dist=1e30);
+
+  /**
+   * Locates the surface elements with specified boundary which are nearest to each point of p
+   */
+  void operator() (const std::vector<Point>& p, const short int boundary,
+                   std::vector< std::pair<const Elem*, unsigned int> > & surface_elems,
+                   std::vector<Point> & project_points, const Real dist=1e30);
+
 private:
 
+  /**
+   * @return the locator of subdomain, build it at the first call
+   */
+  const SurfaceLocatorBase * _subdomain_locator(const unsigned int subdomain);
+
+  /**
+   * @return the locator of boundary, build it at the first call
+   */
+  const SurfaceLocatorBase * _boundary_locator(const short int boundary);
+
   /**
    * constant reference to the mesh
    */
@@ -24,6 +24,71 @@
 #ifndef __sync_file_h__
 #define __sync_file_h__
 
+#include <string>
+
+#include "genius_common.h"
+
+/**
+ * the text of a file, read once by processor 0 and shared by all the processors.
+ *
+ * with MPI-3, the processors on one node map the same shared memory window: the text is
+ * broadcast to the first processor of each node only, and the others read it in place.
+ * otherwise each processor holds its own copy.
+ * the constructor and destructor are collective on PETSC_COMM_WORLD
+ */
+class SharedFile
+{
+public:
+  SharedFile(const char * filename);
+
+  ~SharedFile();
+
+  /**
+   * @return the text, not null terminated
+   */
+  const char * data() const
+  { return _data; }
+
+  /**
+   * @return the length of the text
+   */
+  size_t size() const
+  { return _size; }
+
+private:
+
+  const char * _data;
+
+  size_t       _size;
+
+  /**
+   * the text, when it is not in shared memory
+   */
+  std::string  _text;
+
+#if defined(HAVE_MPI) && MPI_VERSION >= 3
+  /**
+   * processors on this node
+   */
+  MPI_Comm     _node_comm;
+
+  /**
+   * the first processor of each node, MPI_COMM_NULL on the others
+   */
+  MPI_Comm     _leader_comm;
+
+  /**
+   * shared memory window of the text
+   */
+  MPI_Win      _win;
+#endif
+
+  // not copyable
+  SharedFile(const SharedFile &);
+  SharedFile & operator= (const SharedFile &);
+};
+
+
 /**
  * transport text file to other processor,
  * return local name as filename.processor_id 
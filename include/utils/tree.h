@@ -90,6 +90,12 @@ public:
    */
   const Elem* operator() (const Point& p) const;
 
+  /**
+   * insert the active elements of the mesh which are not in the tree yet
+   * @return false when the tree can not be updated and should be rebuilt
+   */
+  bool update();
+
   /**
    * @return the first element the ray(p,dir) hit
    */
@@ -118,6 +124,11 @@ private:
    */
   std::vector<const Elem *> surface_elems;
 
+  /**
+   * the mesh elements in the tree, sorted by address
+   */
+  std::vector<const Elem *> tree_elems;
+
 };
 
 
@@ -106,6 +106,14 @@ public:
    */
   virtual bool hit_boundbox(const Point & p, const Point & dir) const=0;
 
+  /**
+   * insert the active elements of the mesh which are not in the tree yet,
+   * i.e. the children created by mesh refinement. elements must not be deleted from
+   * the mesh since the tree was built.
+   * @return false when the tree can not be updated and should be rebuilt
+   */
+  virtual bool update() = 0;
+
   /**
    * @return how many leaf per level
    */
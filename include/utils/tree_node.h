@@ -102,6 +102,12 @@ public:
    */
   void set_bounding_box (const std::pair<Point, Point>& bbox);
 
+  /**
+   * @return the bounding box
+   */
+  const std::pair<Point, Point>& get_bounding_box () const
+  { return bounding_box; }
+
   /**
    * @return the first element the ray(p,dir) hit
    */
@@ -0,0 +1,612 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+// standalone benchmark of the FVM residual/jacobian assembly.
+//
+// usage: genius_bench -i card_file [-bench_n N] [-bench_solver poisson|ddml1|ddml2|ebml3|all|ddmac|locality|meshbcast]
+//                     [-bench_freq f(Hz)] [-bench_ac_electrode electrode]
+//
+// the card file is processed as usual up to the point where the simulation
+// system is ready: GLOBAL, mesh/process, MODEL, METHOD, IMPORT (i.e. a CGNS mesh
+// with solution), PMI, ATTACH and NODESET cards are honored, SOLVE and EXPORT
+// cards are ignored. then for each selected solver, build_petsc_sens_residual and
+// build_petsc_sens_jacobian are called N times at the current solution and the
+// cost per call, per edge and per cell is reported. the jacobian/residual ratio
+// and the residual share of a Newton step with 3 to 5 line search residuals tell
+// whether residual or jacobian assembly dominates the nonlinear solve. for the DDM
+// solvers the error_norm() evaluation of the convergence test is timed as well.
+//
+// the MatSetValues cost is measured by a row replay: the rows of the assembled
+// jacobian are captured once and inserted again with ADD_VALUES into the zeroed
+// matrix, so insertion and final assembly can be timed apart from the physics.
+//
+// ddmac (not included in all, the imported solution should be a DC solution) times
+// the AC matrix assembly and linear solve at frequency bench_freq with small signal
+// on bench_ac_electrode (default the first electrode). the memory of the doubled real
+// AC matrix is compared with the estimated memory of the equivalent complex matrix,
+// which has a quarter of the nonzeros with complex values.
+//
+// locality (also in all) reports how close the two nodes of each edge are in the
+// local node storage and times an edge loop which gathers both FVM_Node. run it
+// with MESH reorder=rcm|hilbert|none to compare the node orderings.
+//
+// meshbcast (not included in all, needs more than one processor) times
+// MeshCommunication::broadcast of a copy of the mesh with its boundary sides and
+// nodes from processor 0, as done when the mesh is built. compare the time per
+// broadcast of two builds to see the effect of a change in the mesh communication.
+
+
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+
+#include "genius_common.h"
+#include "genius_env.h"
+#include "material_define.h"
+#include "file_include.h"
+#include "sync_file.h"
+#include "parser.h"
+#include "control.h"
+#include "parallel.h"
+#include "mesh.h"
+#include "mesh_communication.h"
+#include "boundary_info.h"
+#include "simulation_system.h"
+#include "simulation_region.h"
+#include "solver_specify.h"
+#include "electrical_source.h"
+#include "field_source.h"
+#include "poisson/poisson.h"
+#include "ddm1/ddm1.h"
+#include "ddm2/ddm2.h"
+#include "ebm3/ebm3.h"
+#include "ddm_solver.h"
+#include "ddm_ac/ddm_ac.h"
+#include "boundary_condition_collector.h"
+#include "mathfunc.h"  // for PI
+
+
+#ifdef CYGWIN
+  #include <io.h>      // for windows _access function
+#else
+  #include <unistd.h>  // for POSIX access function
+#endif
+
+
+static void bench_solver(FVM_NonlinearSolver * solver, SimulationSystem & system, unsigned int n);
+static void bench_ac_solver(DDMACSolver * solver, unsigned int n, double freq);
+static void bench_locality(SimulationSystem & system, unsigned int n);
+static void bench_mesh_broadcast(const Mesh & mesh, unsigned int n);
+
+
+// --------------------------------------------------------
+// The entrance of GENIUS assembly benchmark
+int main(int argc, char ** args)
+{
+  Genius::init_processors(&argc, &args);
+
+  if(argc<2)
+  {
+    PetscPrintf(PETSC_COMM_WORLD,"usage: genius_bench -i card_file [-bench_n N] [-bench_solver poisson|ddml1|ddml2|ebml3|all|ddmac|locality|meshbcast]\n");
+    PetscFinalize();
+    exit(0);
+  }
+
+  // test if GENIUS_DIR has been set correctly
+  if( getenv("GENIUS_DIR") == NULL )
+  {
+    PetscPrintf(PETSC_COMM_WORLD,"ERROR: User should set entironment variable GENIUS_DIR.\n");
+    PetscFinalize();
+    exit(0);
+  }
+  Genius::set_genius_dir(getenv("GENIUS_DIR"));
+
+  PetscBool     flg;
+  char input_file[1024];
+  PetscOptionsGetString(PETSC_NULL, "-i", input_file, 1023, &flg);
+  if( !flg )
+  {
+    PetscPrintf(PETSC_COMM_WORLD,"ERROR: I want an input file to tell me what to do.\n");
+    PetscFinalize();
+    exit(0);
+  }
+  Genius::set_input_file(input_file);
+
+  // repetitions of each assembly
+  PetscInt n_repeat = 10;
+  PetscOptionsGetInt(PETSC_NULL, "-bench_n", &n_repeat, &flg);
+  if( n_repeat < 1 ) n_repeat = 1;
+
+  // which solver to benchmark
+  char solver_name[256] = "all";
+  PetscOptionsGetString(PETSC_NULL, "-bench_solver", solver_name, 255, &flg);
+  const std::string which(solver_name);
+
+  // frequency (Hz) and small signal electrode of AC benchmark
+  PetscReal bench_freq = 1e9;
+  PetscOptionsGetReal(PETSC_NULL, "-bench_freq", &bench_freq, &flg);
+  char ac_electrode[256] = "";
+  PetscOptionsGetString(PETSC_NULL, "-bench_ac_electrode", ac_electrode, 255, &flg);
+
+  // the number of threads used by the assembly loops of each processor
+  PetscInt n_threads = 1;
+  PetscOptionsGetInt(PETSC_NULL, "-threads", &n_threads, &flg);
+  if( flg )
+    Genius::set_n_threads(n_threads);
+
+  // console log only
+  if (Genius::processor_id() == 0)
+    genius_log.addStream("console", std::cerr.rdbuf());
+
+  if ( Genius::processor_id() == 0 )
+  {
+#ifdef CYGWIN
+    if ( _access( Genius::input_file(),  04 ) == -1 )
+#else
+    if ( access( Genius::input_file(),  R_OK ) == -1 )
+#endif
+    {
+      PetscPrintf(PETSC_COMM_WORLD,"ERROR: I can't read input file '%s', access failed.\n", Genius::input_file() );
+      PetscFinalize();
+      exit(0);
+    }
+  }
+
+  // preprocess include statement of input file
+  std::string input_file_pp;
+  if (Genius::processor_id() == 0)
+  {
+    Parser::FilePreProcess * file_preprocess = new Parser::FilePreProcess(Genius::input_file());
+    input_file_pp = file_preprocess->output();
+    delete file_preprocess;
+  }
+  Parallel::broadcast(input_file_pp);
+
+  // read card specification file
+  Parser::Pattern pt;
+  std::string pattern_file = Genius::genius_dir() +  "/lib/GeniusSyntax.xml";
+  if (pt.get_from_XML(pattern_file, pattern_file + ".cache") )
+  {
+    PetscPrintf(PETSC_COMM_WORLD,"ERROR: I can't parse pattern file 'GeniusSyntax.xml'.\n" );
+    genius_error();
+  }
+
+  // parse the input file
+  AutoPtr<Parser::InputParser> input = AutoPtr<Parser::InputParser>(new Parser::InputParser(pt));
+  int parse_error;
+  {
+    SharedFile input_text(input_file_pp.c_str());
+    parse_error = input->read_card_buffer(input_text.data(), input_text.size());
+  }
+
+  if (Genius::processor_id() == 0)
+    remove(input_file_pp.c_str());
+
+  if( parse_error )
+  {
+    PetscPrintf(PETSC_COMM_WORLD,"ERROR: I can't parse input file.\n");
+    PetscFinalize();
+    exit(0);
+  }
+
+  // set material define
+  std::string material_file = Genius::genius_dir() +  "/lib/material.def";
+  Material::init_material_define(material_file);
+
+  // build the simulation system, skip any SOLVE/EXPORT card
+  AutoPtr<SolverControl>  solve_ctrl = AutoPtr<SolverControl>(new SolverControl());
+  solve_ctrl->setDecks(input.get());
+  solve_ctrl->reset_simulation_system();
+  solve_ctrl->do_mesh();
+  solve_ctrl->do_process();
+
+  for( solve_ctrl->decks().begin(); !solve_ctrl->decks().end(); solve_ctrl->decks().next() )
+  {
+    Parser::Card c = solve_ctrl->decks().get_current_card();
+
+    if(c.key() == "MODEL")
+      solve_ctrl->set_model ( c );
+
+    if(c.key() == "METHOD")
+      solve_ctrl->set_method ( c );
+
+    if(c.key() == "IMPORT")
+      solve_ctrl->do_import ( c );
+
+    if(c.key() == "NODESET")
+      solve_ctrl->set_initial_node_voltage( c );
+
+    if(c.key() == "PMI")
+      solve_ctrl->set_physical_model ( c );
+
+    if(c.key() == "ATTACH")
+      solve_ctrl->set_electrode_source ( c );
+  }
+
+  SimulationSystem & system = solve_ctrl->system();
+
+  // evaluate as a steady-state problem at time 0
+  system.get_sources()->update ( 0 );
+  system.get_field_source()->update ( 0 );
+  SolverSpecify::Type = SolverSpecify::STEADYSTATE;
+  SolverSpecify::TimeDependent = false;
+  SolverSpecify::dt = 1e100;
+  SolverSpecify::clock = 0.0;
+
+  {
+    unsigned int n_cell=0, n_edge=0;
+    for(unsigned int r=0; r<system.n_regions(); r++)
+    {
+      n_cell += system.region(r)->n_cell();
+      n_edge += system.region(r)->n_edge();
+    }
+    MESSAGE<<"Assembly benchmark: " << n_repeat << " repetitions, "
+           << n_cell << " cells, " << n_edge << " edges\n\n";
+    RECORD();
+  }
+
+  if( which == "all" || which == "locality" )
+    bench_locality(system, n_repeat);
+
+  if( which == "meshbcast" )
+    bench_mesh_broadcast(solve_ctrl->mesh(), n_repeat);
+
+  if( which == "all" || which == "poisson" )
+  {
+    SolverSpecify::Solver = SolverSpecify::POISSON;
+    PoissonSolver * solver = new PoissonSolver(system);
+    solver->set_label("POISSON");
+    bench_solver(solver, system, n_repeat);
+    delete solver;
+  }
+
+  if( which == "all" || which == "ddml1" )
+  {
+    SolverSpecify::Solver = SolverSpecify::DDML1;
+    DDM1Solver * solver = new DDM1Solver(system);
+    solver->set_label("DDML1");
+    bench_solver(solver, system, n_repeat);
+    delete solver;
+  }
+
+  if( which == "all" || which == "ddml2" )
+  {
+    SolverSpecify::Solver = SolverSpecify::DDML2;
+    DDM2Solver * solver = new DDM2Solver(system);
+    solver->set_label("DDML2");
+    bench_solver(solver, system, n_repeat);
+    delete solver;
+  }
+
+  if( which == "all" || which == "ebml3" )
+  {
+    SolverSpecify::Solver = SolverSpecify::EBML3;
+    EBM3Solver * solver = new EBM3Solver(system);
+    solver->set_label("EBML3");
+    bench_solver(solver, system, n_repeat);
+    delete solver;
+  }
+
+  if( which == "ddmac" )
+  {
+    // small signal at the given electrode, or the first electrode
+    SolverSpecify::Electrode_ACScan.clear();
+    for(unsigned int b=0; b<system.get_bcs()->n_bcs(); ++b)
+    {
+      const BoundaryCondition * bc = system.get_bcs()->get_bc(b);
+      if( !bc->is_electrode() ) continue;
+      if( std::string(ac_electrode).empty() || bc->label() == ac_electrode )
+      {
+        SolverSpecify::Electrode_ACScan.push_back(bc->label());
+        break;
+      }
+    }
+    if( SolverSpecify::Electrode_ACScan.empty() )
+    {
+      MESSAGE<<"ERROR: no electrode for AC benchmark.\n"; RECORD();
+      genius_error();
+    }
+    SolverSpecify::VAC = 0.0026*PhysicalUnit::V;
+    SolverSpecify::Type = SolverSpecify::ACSWEEP;
+
+    SolverSpecify::Solver = SolverSpecify::DDMAC;
+    DDMACSolver * solver = new DDMACSolver(system);
+    solver->set_label("DDMAC");
+    bench_ac_solver(solver, n_repeat, bench_freq/PhysicalUnit::s);
+    delete solver;
+  }
+
+  if (Genius::processor_id() == 0)
+    genius_log.removeStream("console");
+
+  Genius::clean_processors();
+  return 0;
+}
+
+
+
+/**
+ * time residual, jacobian and MatSetValues replay of one solver
+ */
+void bench_solver(FVM_NonlinearSolver * solver, SimulationSystem & system, unsigned int n)
+{
+  solver->create_solver();
+  solver->pre_solve_process();
+
+  Vec & x = solver->solution_vector();
+  Vec & f = solver->rhs_vector();
+  Mat & J = solver->jacobian_matrix();
+
+  // warm up, the first jacobian also fixes the nonzero pattern
+  solver->build_petsc_sens_residual(x, f);
+  solver->build_petsc_sens_jacobian(x, &J, &J);
+
+  PetscLogDouble t0, t1;
+
+  PetscGetTime(&t0);
+  for(unsigned int i=0; i<n; ++i)
+    solver->build_petsc_sens_residual(x, f);
+  PetscGetTime(&t1);
+  const double t_residual = (t1-t0)/n;
+
+  PetscGetTime(&t0);
+  for(unsigned int i=0; i<n; ++i)
+    solver->build_petsc_sens_jacobian(x, &J, &J);
+  PetscGetTime(&t1);
+  const double t_jacobian = (t1-t0)/n;
+
+  // the error norm of the convergence test, it reads the residual of the last evaluation
+  double t_error_norm = 0.0;
+  DDMSolverBase * ddm_solver = dynamic_cast<DDMSolverBase *>(solver);
+  if( ddm_solver )
+  {
+    solver->build_petsc_sens_residual(x, f);
+    PetscGetTime(&t0);
+    for(unsigned int i=0; i<n; ++i)
+      ddm_solver->error_norm();
+    PetscGetTime(&t1);
+    t_error_norm = (t1-t0)/n;
+  }
+
+  // capture the local rows of the assembled jacobian
+  PetscInt row_begin, row_end;
+  MatGetOwnershipRange(J, &row_begin, &row_end);
+
+  std::vector<PetscInt>    row_ptr(1, 0);
+  std::vector<PetscInt>    cols;
+  std::vector<PetscScalar> vals;
+  for(PetscInt row=row_begin; row<row_end; ++row)
+  {
+    PetscInt ncols;
+    const PetscInt    *row_cols;
+    const PetscScalar *row_vals;
+    MatGetRow(J, row, &ncols, &row_cols, &row_vals);
+    cols.insert(cols.end(), row_cols, row_cols+ncols);
+    vals.insert(vals.end(), row_vals, row_vals+ncols);
+    MatRestoreRow(J, row, &ncols, &row_cols, &row_vals);
+    row_ptr.push_back(cols.size());
+  }
+
+  // replay the rows into the zeroed matrix
+  double t_set_values = 0.0, t_assembly = 0.0;
+  for(unsigned int i=0; i<n; ++i)
+  {
+    MatZeroEntries(J);
+
+    PetscGetTime(&t0);
+    for(PetscInt row=row_begin; row<row_end; ++row)
+    {
+      const PetscInt r = row - row_begin;
+      const PetscInt ncols = row_ptr[r+1] - row_ptr[r];
+      if( ncols )
+        MatSetValues(J, 1, &row, ncols, &cols[row_ptr[r]], &vals[row_ptr[r]], ADD_VALUES);
+    }
+    PetscGetTime(&t1);
+    t_set_values += t1-t0;
+
+    MatAssemblyBegin(J, MAT_FINAL_ASSEMBLY);
+    MatAssemblyEnd(J, MAT_FINAL_ASSEMBLY);
+    PetscGetTime(&t0);
+    t_assembly += t0-t1;
+  }
+  t_set_values /= n;
+  t_assembly   /= n;
+
+  unsigned int n_cell=0, n_edge=0;
+  for(unsigned int r=0; r<system.n_regions(); r++)
+  {
+    n_cell += system.region(r)->n_cell();
+    n_edge += system.region(r)->n_edge();
+  }
+  const double ns = 1e9;
+  const double edge_scale = n_edge ? ns/n_edge : 0.0;
+  const double cell_scale = n_cell ? ns/n_cell : 0.0;
+
+  MESSAGE<<std::setiosflags(std::ios::scientific) << std::setprecision(3)
+         <<solver->label()<<":\n"
+         <<"  residual     " << t_residual   << " s/call, " << t_residual*edge_scale   << " ns/edge, " << t_residual*cell_scale   << " ns/cell\n"
+         <<"  jacobian     " << t_jacobian   << " s/call, " << t_jacobian*edge_scale   << " ns/edge, " << t_jacobian*cell_scale   << " ns/cell\n"
+         <<"  MatSetValues " << t_set_values << " s/call (" << cols.size() << " entries in replay)\n"
+         <<"  MatAssembly  " << t_assembly   << " s/call\n"
+         <<"  error_norm   " << t_error_norm << " s/call" << (ddm_solver ? "\n" : " (not a DDM solver)\n")
+         <<"  jacobian/residual ratio " << (t_residual > 0 ? t_jacobian/t_residual : 0.0) << "\n"
+         <<"  residual share of a Newton step with 3/5 residuals "
+         << (t_residual > 0 ? 3*t_residual/(3*t_residual+t_jacobian) : 0.0) << " / "
+         << (t_residual > 0 ? 5*t_residual/(5*t_residual+t_jacobian) : 0.0)
+         << std::resetiosflags(std::ios::scientific) << "\n\n";
+  RECORD();
+
+  solver->destroy_solver();
+}
+
+
+
+
+/**
+ * time AC assembly and solve, report the memory of doubled real and equivalent complex layout
+ */
+void bench_ac_solver(DDMACSolver * solver, unsigned int n, double freq)
+{
+  solver->create_solver();
+  solver->pre_solve_process();
+
+  const double omega = 2*PI*freq;
+  double t_build, t_solve;
+  KSPConvergedReason reason;
+
+  // warm up, the first assembly also fixes the nonzero pattern and the first solve does the symbolic factorization
+  solver->benchmark_frequency(omega, t_build, t_solve, reason);
+
+  double t_build_sum = 0.0, t_solve_sum = 0.0;
+  for(unsigned int i=0; i<n; ++i)
+  {
+    solver->benchmark_frequency(omega, t_build, t_solve, reason);
+    t_build_sum += t_build;
+    t_solve_sum += t_solve;
+  }
+
+  // the nonzeros of the doubled real matrix, each complex entry is a 2x2 real block
+  MatInfo info;
+  PetscInt n_rows, n_cols;
+  MatGetInfo(solver->ac_matrix(), MAT_GLOBAL_SUM, &info);
+  MatGetSize(solver->ac_matrix(), &n_rows, &n_cols);
+
+  const double nz_real    = info.nz_used;
+  const double mem_real   = nz_real*(sizeof(PetscScalar)+sizeof(PetscInt)) + n_rows*sizeof(PetscInt);
+  const double nz_complex = 0.25*nz_real;
+  const double mem_complex= nz_complex*(2*sizeof(PetscScalar)+sizeof(PetscInt)) + 0.5*n_rows*sizeof(PetscInt);
+
+  MESSAGE<<std::setiosflags(std::ios::scientific) << std::setprecision(3)
+         <<solver->label()<<" at f = " << freq*PhysicalUnit::s << " Hz, " << KSPConvergedReasons[reason] << ":\n"
+         <<"  build AC system  " << t_build_sum/n << " s/call\n"
+         <<"  linear solve     " << t_solve_sum/n << " s/call\n"
+         <<"  doubled real     " << n_rows << " rows, " << nz_real << " nonzeros, " << mem_real/1048576 << " MB (matrix memory reported " << info.memory/1048576 << " MB)\n"
+         <<"  complex (est.)   " << n_rows/2 << " rows, " << nz_complex << " nonzeros, " << mem_complex/1048576 << " MB"
+         << std::resetiosflags(std::ios::scientific) << "\n\n";
+  RECORD();
+
+  solver->destroy_solver();
+}
+
+
+
+/**
+ * node index distance of edges and the cost of an edge loop gathering both nodes
+ */
+void bench_locality(SimulationSystem & system, unsigned int n)
+{
+  unsigned int n_edge = 0;
+  double gap_sum = 0.0;
+  unsigned int n_near = 0;
+  double t_gather = 0.0, sum = 0.0;
+
+  for(unsigned int r=0; r<system.n_regions(); r++)
+  {
+    const SimulationRegion * region = system.region(r);
+    const SimulationRegion::EdgeArrays & edges = region->edge_arrays();
+    const std::vector<const FVM_Node *> nodes(region->on_local_nodes_begin(), region->on_local_nodes_end());
+
+    for(unsigned int e=0; e<edges.node1.size(); ++e)
+    {
+      if( edges.node1[e] == invalid_uint || edges.node2[e] == invalid_uint ) continue;
+      const unsigned int gap = edges.node1[e] > edges.node2[e] ?
+                               edges.node1[e] - edges.node2[e] : edges.node2[e] - edges.node1[e];
+      gap_sum += gap;
+      // two nodes within a 4KB page of 64 byte node records
+      if( gap < 64 ) n_near++;
+      n_edge++;
+    }
+
+    PetscLogDouble t0, t1;
+    PetscGetTime(&t0);
+    for(unsigned int i=0; i<n; ++i)
+      for(unsigned int e=0; e<edges.node1.size(); ++e)
+      {
+        if( edges.node1[e] == invalid_uint || edges.node2[e] == invalid_uint ) continue;
+        const Node * n1 = nodes[edges.node1[e]]->root_node();
+        const Node * n2 = nodes[edges.node2[e]]->root_node();
+        sum += ((*n1)(0) - (*n2)(0))*edges.area[e]/edges.length[e];
+      }
+    PetscGetTime(&t1);
+    t_gather += t1-t0;
+  }
+
+  const double ns = 1e9;
+  MESSAGE<<std::setiosflags(std::ios::scientific) << std::setprecision(3)
+         <<"LOCALITY:\n"
+         <<"  mean edge node index gap " << (n_edge ? gap_sum/n_edge : 0.0) << "\n"
+         <<"  edges with gap < 64      " << (n_edge ? double(n_near)/n_edge : 0.0) << "\n"
+         <<"  edge gather              " << (n_edge && n ? t_gather*ns/(double(n)*n_edge) : 0.0) << " ns/edge"
+         <<" (checksum " << sum << ")"
+         << std::resetiosflags(std::ios::scientific) << "\n\n";
+  RECORD();
+}
+
+
+
+/**
+ * time the broadcast of a copy of \p mesh from processor 0
+ */
+void bench_mesh_broadcast(const Mesh & mesh, unsigned int n)
+{
+  if( Genius::n_processors() == 1 )
+  {
+    MESSAGE<<"MESH BROADCAST: nothing to broadcast on one processor.\n\n"; RECORD();
+    return;
+  }
+
+  // the boundary sides and nodes of the mesh
+  std::vector<unsigned int>       el_id, node_id;
+  std::vector<unsigned short int> side_id;
+  std::vector<short int>          bc_id, node_bc_id;
+  mesh.boundary_info->build_side_list (el_id, side_id, bc_id);
+  mesh.boundary_info->build_node_list (node_id, node_bc_id);
+
+  MeshCommunication mesh_comm;
+  double t_broadcast = 0.0;
+  for(unsigned int i=0; i<n; ++i)
+  {
+    // the copy is rebuilt on each repetition, broadcast clears it on the other processors
+    Mesh copy(mesh);
+    for(unsigned int e=0; e<el_id.size(); ++e)
+      copy.boundary_info->add_side (el_id[e], side_id[e], bc_id[e]);
+    for(unsigned int v=0; v<node_id.size(); ++v)
+      copy.boundary_info->add_node (node_id[v], node_bc_id[v]);
+
+    Parallel::barrier();
+    PetscLogDouble t0, t1;
+    PetscGetTime(&t0);
+    mesh_comm.broadcast(copy);
+    PetscGetTime(&t1);
+    t_broadcast += t1-t0;
+  }
+
+  const double ms = 1e3;
+  MESSAGE<<std::setiosflags(std::ios::scientific) << std::setprecision(3)
+         <<"MESH BROADCAST: " << mesh.n_nodes() << " nodes, " << mesh.n_elem() << " elems, "
+         << el_id.size() << " boundary sides, " << Genius::n_processors() << " processors\n"
+         <<"  broadcast                " << t_broadcast*ms/n << " ms"
+         << std::resetiosflags(std::ios::scientific) << "\n\n";
+  RECORD();
+}
@@ -19,22 +19,202 @@
 /*                                                                              */
 /********************************************************************************/
 
+#include <algorithm>
+
 #include "genius_env.h"
 #include "genius_common.h"
+#include "perf_log.h"
 
 #ifdef HAVE_SLEPC
   #include "slepcsys.h"
 #endif
 
+#ifdef HAVE_OPENMP
+  #include <omp.h>
+#endif
+
+#ifdef __linux__
+  #include <sched.h>
+  #include <unistd.h>
+#endif
+
 // ------------------------------------------------------------
 // Genius::GeniusPrivateData data initialization
 int  Genius::GeniusPrivateData::_n_processors = 1;
 int  Genius::GeniusPrivateData::_processor_id = 0;
+int  Genius::GeniusPrivateData::_n_threads = 1;
+int  Genius::GeniusPrivateData::_n_ensemble_groups = 1;
+int  Genius::GeniusPrivateData::_ensemble_group = 0;
+std::vector<std::string> Genius::GeniusPrivateData::_ensemble_decks;
+int  Genius::GeniusPrivateData::_n_bias_groups = 1;
+int  Genius::GeniusPrivateData::_bias_group = 0;
 std::string Genius::GeniusPrivateData::_input_file;
 std::string Genius::GeniusPrivateData::_genius_dir;
+std::string Genius::GeniusPrivateData::_geometry_cache;
+std::string Genius::GeniusPrivateData::_optical_cache;
+
+#ifdef HAVE_MPI
+// the communicator of local ensemble or bias process group
+static MPI_Comm _ensemble_comm = MPI_COMM_NULL;
+#endif
+
+// the cpus owned by local processor, in the order the threads are pinned to
+static std::vector<int> _processor_cpus;
+
+// pin the threads to _processor_cpus
+static bool _bind_threads = false;
+
+
+/**
+ * find the cpus owned by local processor. it must be called before any thread is pinned,
+ * and by all the processors since the node layout is collective.
+ * when the launcher already bound the processor (i.e. mpirun --bind-to socket), these are the
+ * cpus of its affinity mask. otherwise the node is cut into contiguous blocks, one for each
+ * processor on it, so the threads of a processor stay on one socket as long as the number of
+ * processors per node is a multiple of the sockets.
+ * all the ensemble groups are counted, they share the cores of the node
+ */
+static void _find_processor_cpus()
+{
+  _processor_cpus.clear();
+
+  int n_node_processors = 1, node_rank = 0;
+#if defined(HAVE_MPI) && MPI_VERSION >= 3
+  {
+    int world_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, world_rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_size(node_comm, &n_node_processors);
+    MPI_Comm_rank(node_comm, &node_rank);
+    MPI_Comm_free(&node_comm);
+  }
+#endif
+
+#ifdef __linux__
+  std::vector<int> cpus;
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if( sched_getaffinity(0, sizeof(mask), &mask) == 0 )
+    for(int c=0; c<CPU_SETSIZE; ++c)
+      if( CPU_ISSET(c, &mask) ) cpus.push_back(c);
+
+  const long n_online = sysconf(_SC_NPROCESSORS_ONLN);
+  if( n_node_processors > 1 && static_cast<long>(cpus.size()) >= n_online )
+  {
+    // not bound by the launcher, take our own block
+    const int block = std::max(1, static_cast<int>(cpus.size())/n_node_processors);
+    const int begin = (node_rank*block) % static_cast<int>(cpus.size());
+    for(int c=begin; c<begin+block && c<static_cast<int>(cpus.size()); ++c)
+      _processor_cpus.push_back(cpus[c]);
+  }
+  else
+    _processor_cpus = cpus;
+#else
+  (void)node_rank;
+#ifdef HAVE_OPENMP
+  // no affinity mask, only the share of the node
+  const int block = std::max(1, omp_get_num_procs()/n_node_processors);
+  for(int c=0; c<block; ++c)
+    _processor_cpus.push_back(c);
+#endif
+#endif
+}
+
+
+
+/**
+ * scan the command line for "-i deck1,deck2,...", "-ensemble_groups n" and "-bias_groups n".
+ * this must be done before PETSC is initialized, since PETSC_COMM_WORLD
+ * can only be changed before PetscInitialize
+ */
+static void _parse_ensemble_options(int argc, char ** args, std::vector<std::string> &decks, int &n_groups, int &n_bias_groups)
+{
+  for(int i=1; i<argc-1; ++i)
+  {
+    if( !strcmp(args[i], "-i") )
+    {
+      decks.clear();
+      std::string deck_list(args[i+1]);
+      std::string::size_type begin = 0;
+      while( begin <= deck_list.size() )
+      {
+        std::string::size_type end = deck_list.find(',', begin);
+        if( end == std::string::npos ) end = deck_list.size();
+        if( end > begin )
+          decks.push_back(deck_list.substr(begin, end-begin));
+        begin = end + 1;
+      }
+    }
+
+    if( !strcmp(args[i], "-ensemble_groups") )
+      n_groups = atoi(args[i+1]);
+
+    if( !strcmp(args[i], "-bias_groups") )
+      n_bias_groups = atoi(args[i+1]);
+  }
+}
+
+
+#ifdef HAVE_MPI
+/**
+ * split MPI_COMM_WORLD into n_groups contiguous groups (no more than the processors),
+ * the communicator of local group becomes PETSC_COMM_WORLD.
+ * @return the group of local processor, and n_groups is updated
+ */
+static int _split_processors(int *argc, char *** args, int &n_groups)
+{
+  MPI_Init(argc, args);
+
+  int world_rank, world_size;
+  MPI_Comm_rank (MPI_COMM_WORLD, &world_rank);
+  MPI_Comm_size (MPI_COMM_WORLD, &world_size);
+
+  n_groups = std::min(n_groups, world_size);
+
+  const int group = static_cast<int>((static_cast<long>(world_rank)*n_groups)/world_size);
+  MPI_Comm_split(MPI_COMM_WORLD, group, world_rank, &_ensemble_comm);
+  PETSC_COMM_WORLD = _ensemble_comm;
+
+  return group;
+}
+#endif
+
 
 bool Genius::init_processors(int *argc, char *** args)
 {
+#ifdef HAVE_MPI
+  // more than one deck given by -i option: run as an ensemble.
+  // the processors are split into contiguous groups, each group solves its
+  // share of the decks on a sub-communicator which becomes PETSC_COMM_WORLD
+  std::vector<std::string> decks;
+  int n_groups = 0, n_bias_groups = 0;
+  _parse_ensemble_options(*argc, *args, decks, n_groups, n_bias_groups);
+
+  if( decks.size() > 1 )
+  {
+    // default: as many groups as decks, but no more than processors
+    if( n_groups < 1 ) n_groups = static_cast<int>(decks.size());
+    n_groups = std::min(n_groups, static_cast<int>(decks.size()));
+
+    const int group = _split_processors(argc, args, n_groups);
+
+    GeniusPrivateData::_n_ensemble_groups = n_groups;
+    GeniusPrivateData::_ensemble_group    = group;
+    for(unsigned int n=group; n<decks.size(); n+=n_groups)
+      GeniusPrivateData::_ensemble_decks.push_back(decks[n]);
+  }
+  // one deck with -bias_groups n: every group runs the deck, the sweeps with
+  // parallel.bias are shared among the groups
+  else if( n_bias_groups > 1 )
+  {
+    const int group = _split_processors(argc, args, n_bias_groups);
+
+    GeniusPrivateData::_n_bias_groups = n_bias_groups;
+    GeniusPrivateData::_bias_group    = group;
+  }
+#endif
+
   // GENIUS is built on top of PETSC, we should init PETSC first
 #ifdef HAVE_SLEPC
   // if we have slepc, call  SlepcInitialize instead of PetscInitialize
@@ -47,16 +227,99 @@ bool Genius::init_processors(int *argc, char *** args)
   MPI_Comm_rank (PETSC_COMM_WORLD, &Genius::GeniusPrivateData::_processor_id);
   MPI_Comm_size (PETSC_COMM_WORLD, &Genius::GeniusPrivateData::_n_processors);
 
+  _find_processor_cpus();
+
+#ifdef HAVE_OPENMP
+  // all the parallel regions run on one team of n_threads(): no dynamic team size and
+  // no nested team, i.e. a threaded loop called inside another one runs serially
+  omp_set_dynamic(0);
+  omp_set_max_active_levels(1);
+  omp_set_num_threads(Genius::GeniusPrivateData::_n_threads);
+#endif
+
   return true;
 }
 
+void Genius::set_n_threads(unsigned int n)
+{
+#ifdef HAVE_OPENMP
+  if( n < 1 ) n = 1;
+  Genius::GeniusPrivateData::_n_threads = n;
+  omp_set_num_threads(n);
+#ifdef ENABLE_PERFORMANCE_LOGGING
+  perflog.set_n_threads(n);
+#endif
+  tracelog.set_n_threads(n);
+
+#ifdef __linux__
+  // pin thread t to the t-th cpu of this processor. the OpenMP runtime keeps its
+  // threads alive between the parallel regions, so the binding holds for all of them
+  if( _bind_threads && !_processor_cpus.empty() && getenv("OMP_PROC_BIND") == NULL )
+  {
+    const int n_cpus = static_cast<int>(_processor_cpus.size());
+#pragma omp parallel num_threads(n)
+    {
+      cpu_set_t mask;
+      CPU_ZERO(&mask);
+      CPU_SET(_processor_cpus[omp_get_thread_num() % n_cpus], &mask);
+      sched_setaffinity(0, sizeof(mask), &mask);
+    }
+  }
+#endif
+#endif
+}
+
+
+unsigned int Genius::default_n_threads()
+{
+#ifdef HAVE_OPENMP
+  return std::max(static_cast<unsigned int>(1), static_cast<unsigned int>(_processor_cpus.size()));
+#else
+  return 1;
+#endif
+}
+
+
+void Genius::set_thread_binding(bool bind)
+{
+  _bind_threads = bind;
+  Genius::set_n_threads(Genius::n_threads());
+}
+
+
+unsigned int Genius::thread_id()
+{
+#ifdef HAVE_OPENMP
+  return static_cast<unsigned int>(omp_get_thread_num());
+#else
+  return 0;
+#endif
+}
+
+
 bool Genius::clean_processors()
 {
+  tracelog.write();
+
+#ifdef ENABLE_PERFORMANCE_LOGGING
+  // merge the log of all the processors while MPI is alive
+  perflog.summarize();
+#endif
+
   // end PETSC
 #ifdef  HAVE_SLEPC
   SlepcFinalize();
 #else
   PetscFinalize();
 #endif
+
+#ifdef HAVE_MPI
+  // PETSC does not finalize MPI it did not initialize
+  if( _ensemble_comm != MPI_COMM_NULL )
+  {
+    MPI_Comm_free(&_ensemble_comm);
+    MPI_Finalize();
+  }
+#endif
   return true;
 }
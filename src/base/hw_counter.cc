@@ -0,0 +1,140 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <cstring>
+
+#include "config.h"
+#include "hw_counter.h"
+
+#ifdef LINUX
+  #include <unistd.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <linux/perf_event.h>
+#endif
+
+
+bool HWCounter::_enabled = false;
+
+unsigned long long HWCounter::_fp_event = 0;
+
+
+HWCounter::HWCounter()
+  : _opened(false), _n_opened(0)
+{
+  for(unsigned int c=0; c<N_COUNTERS; ++c)
+    _fd[c] = -1;
+}
+
+
+HWCounter::~HWCounter()
+{
+#ifdef LINUX
+  for(unsigned int c=0; c<N_COUNTERS; ++c)
+    if( _fd[c] >= 0 ) close(_fd[c]);
+#endif
+}
+
+
+void HWCounter::enable(unsigned long long fp_event)
+{
+  _enabled  = true;
+  _fp_event = fp_event;
+}
+
+
+const char * HWCounter::name(unsigned int c)
+{
+  static const char * names[N_COUNTERS] =
+  {
+    "cycles", "instructions", "cache_references", "cache_misses", "fp_ops"
+  };
+  return c < N_COUNTERS ? names[c] : "";
+}
+
+
+void HWCounter::_open()
+{
+  _opened = true;
+
+#ifdef LINUX
+  int leader = -1;
+  for(unsigned int c=0; c<N_COUNTERS; ++c)
+  {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    switch(c)
+    {
+    case CYCLES           : attr.config = PERF_COUNT_HW_CPU_CYCLES;       break;
+    case INSTRUCTIONS     : attr.config = PERF_COUNT_HW_INSTRUCTIONS;     break;
+    case CACHE_REFERENCES : attr.config = PERF_COUNT_HW_CACHE_REFERENCES; break;
+    case CACHE_MISSES     : attr.config = PERF_COUNT_HW_CACHE_MISSES;     break;
+    case FP_OPS           :
+      if( !_fp_event ) continue;
+      attr.type   = PERF_TYPE_RAW;
+      attr.config = _fp_event;
+      break;
+    }
+    // count this thread in user space only, the group is read at once
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP;
+    attr.disabled       = (leader < 0);
+
+    _fd[c] = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+    if( _fd[c] < 0 ) continue;
+    if( leader < 0 ) leader = _fd[c];
+    ++_n_opened;
+  }
+
+  if( leader >= 0 )
+  {
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif
+}
+
+
+void HWCounter::read(long long *values)
+{
+  for(unsigned int c=0; c<N_COUNTERS; ++c)
+    values[c] = 0;
+
+  if( !_enabled ) return;
+  if( !_opened ) _open();
+  if( !_n_opened ) return;
+
+#ifdef LINUX
+  // PERF_FORMAT_GROUP: the number of counters, then their values in the order of opening
+  unsigned long long buffer[1+N_COUNTERS];
+  int leader = -1;
+  for(unsigned int c=0; c<N_COUNTERS && leader<0; ++c)
+    leader = _fd[c];
+  if( ::read(leader, buffer, sizeof(buffer)) <= 0 ) return;
+
+  unsigned int i = 1;
+  for(unsigned int c=0; c<N_COUNTERS && i<=buffer[0]; ++c)
+    if( _fd[c] >= 0 ) values[c] = buffer[i++];
+#endif
+}
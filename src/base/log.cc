@@ -23,12 +23,44 @@
 
 GENIUS_LOG_STREAM genius_log;
 
+
+void GENIUS_LOG_STREAM::_write(const std::string &msg)
+{
+  for (std::map<std::string, std::ostream*>::iterator it = _streams.begin();
+       it != _streams.end(); it++)
+  {
+    (*it->second) << msg;
+    it->second->flush();
+  }
+}
+
+
+#ifdef HAVE_PTHREAD
+
 GENIUS_LOG_STREAM::GENIUS_LOG_STREAM()
+  : _level(ITERATION), _writing(false), _stop(false)
 {
+  pthread_mutex_init(&_mutex, NULL);
+  pthread_cond_init(&_pending_cond, NULL);
+  pthread_cond_init(&_written_cond, NULL);
+  pthread_create(&_thread, NULL, _thread_main, this);
 }
 
+
 GENIUS_LOG_STREAM::~GENIUS_LOG_STREAM()
 {
+  pthread_mutex_lock(&_mutex);
+  _stop = true;
+  pthread_cond_signal(&_pending_cond);
+  pthread_mutex_unlock(&_mutex);
+
+  // the thread leaves after the pending messages are written
+  pthread_join(_thread, NULL);
+
+  pthread_cond_destroy(&_written_cond);
+  pthread_cond_destroy(&_pending_cond);
+  pthread_mutex_destroy(&_mutex);
+
   for (std::map<std::string, std::ostream*>::iterator it = _streams.begin();
        it != _streams.end(); it++)
   {
@@ -36,22 +68,108 @@ GENIUS_LOG_STREAM::~GENIUS_LOG_STREAM()
   }
 }
 
+
 void GENIUS_LOG_STREAM::record()
+{
+  // no stream attached (processors other than 0), drop the message
+  if( _streams.empty() )
+  {
+    _sstream.str("");
+    return;
+  }
+
+  std::string msg(_sstream.str());
+  _sstream.str("");
+  if( msg.empty() ) return;
+
+  pthread_mutex_lock(&_mutex);
+  while( _pending.size() > _max_pending )
+    pthread_cond_wait(&_written_cond, &_mutex);
+  _pending += msg;
+  pthread_cond_signal(&_pending_cond);
+  pthread_mutex_unlock(&_mutex);
+}
+
+
+void GENIUS_LOG_STREAM::flush()
+{
+  pthread_mutex_lock(&_mutex);
+  while( !_pending.empty() || _writing )
+    pthread_cond_wait(&_written_cond, &_mutex);
+  pthread_mutex_unlock(&_mutex);
+}
+
+
+void * GENIUS_LOG_STREAM::_thread_main(void * arg)
+{
+  GENIUS_LOG_STREAM * log = static_cast<GENIUS_LOG_STREAM *>(arg);
+
+  std::string msg;
+  pthread_mutex_lock(&log->_mutex);
+  while( true )
+  {
+    while( log->_pending.empty() && !log->_stop )
+      pthread_cond_wait(&log->_pending_cond, &log->_mutex);
+
+    if( log->_pending.empty() ) break;
+
+    // take all the pending messages, record() continues to fill an empty buffer
+    msg.swap(log->_pending);
+    log->_writing = true;
+    pthread_mutex_unlock(&log->_mutex);
+
+    // streams are only changed after flush(), no lock needed here
+    log->_write(msg);
+    msg.clear();
+
+    pthread_mutex_lock(&log->_mutex);
+    log->_writing = false;
+    pthread_cond_broadcast(&log->_written_cond);
+  }
+  pthread_mutex_unlock(&log->_mutex);
+
+  return NULL;
+}
+
+#else
+
+GENIUS_LOG_STREAM::GENIUS_LOG_STREAM()
+  : _level(ITERATION)
+{
+}
+
+
+GENIUS_LOG_STREAM::~GENIUS_LOG_STREAM()
 {
   for (std::map<std::string, std::ostream*>::iterator it = _streams.begin();
        it != _streams.end(); it++)
   {
-    std::string msg(_sstream.str());
-    (*it->second) << msg;
-    it->second->flush();
+    delete it->second;
   }
+}
+
+
+void GENIUS_LOG_STREAM::record()
+{
+  if( !_streams.empty() && _sstream.tellp() > 0 )
+    _write(_sstream.str());
   _sstream.str("");
 }
 
+
+void GENIUS_LOG_STREAM::flush()
+{}
+
+#endif
+
+
 void GENIUS_LOG_STREAM::addStream(const std::string &name, std::streambuf* buf)
 {
   if (buf)
   {
+    // the writer may not touch the streams while we change them
+    flush();
+
     std::ostream *os = new std::ostream(buf);
     os->setf(std::ios::scientific);
     _streams.insert(std::pair<std::string, std::ostream*>(name, os) );
@@ -60,6 +178,8 @@ void GENIUS_LOG_STREAM::addStream(const std::string &name, std::streambuf* buf)
 
 void GENIUS_LOG_STREAM::addStream(const std::string &name, const std::string &fname)
 {
+  flush();
+
   std::filebuf *buf = new std::filebuf;
   buf->open(fname.c_str(), std::ios::out);
 
@@ -71,6 +191,8 @@ void GENIUS_LOG_STREAM::addStream(const std::string &name, const std::string &fn
 
 void GENIUS_LOG_STREAM::removeStream(const std::string &name)
 {
+  flush();
+
   {
     std::map<std::string, std::ostream*>::iterator it = _streams.find(name);
     for (;it != _streams.end(); ++it)
@@ -90,4 +212,3 @@ void GENIUS_LOG_STREAM::removeStream(const std::string &name)
     _bufs.clear();
   }
 }
-
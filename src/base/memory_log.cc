@@ -0,0 +1,136 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#ifndef CYGWIN
+  #include <unistd.h>
+  #include <sys/resource.h>
+#endif
+
+#include "memory_log.h"
+#include "genius_env.h"
+#include "parallel.h"
+#include "log.h"
+
+
+MemoryLog::MemoryLog(const std::string &label)
+  : _label(label)
+{}
+
+
+void MemoryLog::add(const std::string &subsystem, size_t bytes)
+{
+  for(unsigned int n=0; n<_records.size(); ++n)
+    if( _records[n].first == subsystem )
+    {
+      _records[n].second += bytes;
+      return;
+    }
+  _records.push_back( std::make_pair(subsystem, bytes) );
+}
+
+
+size_t MemoryLog::total() const
+{
+  size_t bytes = 0;
+  for(unsigned int n=0; n<_records.size(); ++n)
+    bytes += _records[n].second;
+  return bytes;
+}
+
+
+size_t MemoryLog::resident_memory()
+{
+#ifndef CYGWIN
+  // the second field of /proc/self/statm is the resident pages
+  std::ifstream in("/proc/self/statm");
+  unsigned long pages=0, resident=0;
+  if( in >> pages >> resident )
+    return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+  return 0;
+}
+
+
+size_t MemoryLog::peak_resident_memory()
+{
+#ifndef CYGWIN
+  struct rusage usage;
+  if( getrusage(RUSAGE_SELF, &usage) == 0 )
+  {
+  #ifdef DARWIN
+    // in byte on darwin
+    return static_cast<size_t>(usage.ru_maxrss);
+  #else
+    // in KB on linux
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+  #endif
+  }
+#endif
+  return 0;
+}
+
+
+void MemoryLog::print_log() const
+{
+  // values of this processor in MB, the last two are total and resident memory
+  const double MB = 1024.0*1024.0;
+  std::vector<double> values;
+  for(unsigned int n=0; n<_records.size(); ++n)
+    values.push_back(_records[n].second/MB);
+  values.push_back(total()/MB);
+  values.push_back(resident_memory()/MB);
+
+  const unsigned int n_values = values.size();
+  Parallel::gather(0, values);
+
+  if( Genius::processor_id() != 0 ) return;
+
+  MESSAGE<<"Memory usage (MB) " << _label << "\n";
+  MESSAGE<<"  " << std::setw(24) << std::left << "subsystem" << std::right;
+  for(unsigned int p=0; p<Genius::n_processors(); ++p)
+  {
+    std::ostringstream rank;
+    rank << "rank " << p;
+    MESSAGE<<std::setw(12) << rank.str();
+  }
+  MESSAGE<<"\n";
+
+  MESSAGE<<std::fixed<<std::setprecision(2);
+  for(unsigned int n=0; n<n_values; ++n)
+  {
+    std::string name;
+    if( n < _records.size() ) name = _records[n].first;
+    else if( n == _records.size() ) name = "total recorded";
+    else name = "resident set";
+
+    MESSAGE<<"  " << std::setw(24) << std::left << name << std::right;
+    for(unsigned int p=0; p<Genius::n_processors(); ++p)
+      MESSAGE<<std::setw(12) << values[p*n_values + n];
+    MESSAGE<<"\n";
+  }
+  MESSAGE<<std::resetiosflags(std::ios::fixed)<<std::setprecision(6)<<"\n";
+  RECORD();
+}
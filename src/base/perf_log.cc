@@ -28,9 +28,12 @@
 #include <sys/types.h>
 #include <pwd.h>
 #include <vector>
+#include <set>
+#include <algorithm>
 
 // Local includes
 #include "perf_log.h"
+#include "parallel.h"
 
 
 
@@ -44,8 +47,12 @@ PerfLog::PerfLog(const std::string& ln,
                  const bool le) :
   label_name(ln),
   log_events(le),
-  total_time(0.)
+  total_time(0.),
+  tstart(0.),
+  summarized(false)
 {
+  thread_counters.push_back(new HWCounter);
+
   if (log_events)
     this->clear();
 }
@@ -54,8 +61,11 @@ PerfLog::PerfLog(const std::string& ln,
 
 PerfLog::~PerfLog()
 {
-  if (log_events)
+  if (log_events && !summarized)
     this->print_log();
+
+  for (unsigned int t=0; t<thread_counters.size(); ++t)
+    delete thread_counters[t];
 }
 
 
@@ -65,30 +75,191 @@ void PerfLog::clear()
   if (log_events)
     {
       //  check that all events are closed
-      for (std::map<std::pair<std::string,std::string>, PerfData>::iterator
-             pos = log.begin(); pos != log.end(); ++pos)
-        if (pos->second.open)
+      for (unsigned int t=0; t<thread_logs.size(); ++t)
+        if (!thread_logs[t].stack.empty())
           {
+            const PerfNode & perf_node = thread_logs[t].tree[thread_logs[t].stack.back().first];
             std::cout
               << "ERROR clearning performance log for class "
               << label_name << std::endl
-              << "event " << pos->first.second << " is still being monitored!"
+              << "event " << events[perf_node.event].second << " is still being monitored!"
               << std::endl;
 
             genius_error();
           }
 
+      tstart = wall_time();
+      total_time = 0.;
+
+      // the interned event ids are kept, they are cached at the call sites
+      const unsigned int n_threads = std::max(1u, static_cast<unsigned int>(thread_logs.size()));
+      thread_logs.clear();
+      thread_logs.resize(n_threads);
+    }
+}
+
+
+
+void PerfLog::set_n_threads(const unsigned int n)
+{
+  // only the master thread may be logging now
+  if (n > thread_logs.size())
+    thread_logs.resize(n);
+
+  while (thread_counters.size() < thread_logs.size())
+    thread_counters.push_back(new HWCounter);
+}
+
+
+
+unsigned int PerfLog::event_id(const std::string &label,
+                               const std::string &header)
+{
+  unsigned int id;
+
+  // the first call of a call site may happen in a parallel region
+#pragma omp critical (perflog_event_id)
+  {
+    std::pair<std::string,std::string> key(header, label);
+    std::map<std::pair<std::string,std::string>, unsigned int>::const_iterator it = event_ids.find(key);
+    if (it != event_ids.end())
+      id = it->second;
+    else
+      {
+        id = events.size();
+        events.push_back(key);
+        event_ids.insert(std::make_pair(key, id));
+      }
+  }
+
+  return id;
+}
+
+
+
+void PerfLog::_event_totals(std::vector<double> &self_time,
+                            std::vector<unsigned int> &count) const
+{
+  self_time.assign(events.size(), 0.);
+  count.assign(events.size(), 0);
+
+  for (unsigned int t=0; t<thread_logs.size(); ++t)
+    {
+      const std::vector<PerfNode> & tree = thread_logs[t].tree;
+      // skip the root node
+      for (unsigned int n=1; n<tree.size(); ++n)
+        {
+          self_time[tree[n].event] += tree[n].self_time();
+          count[tree[n].event]     += tree[n].count;
+        }
+    }
+}
+
+
+void PerfLog::_counter_totals(std::vector<long long> &counters) const
+{
+  const unsigned int n_counters = HWCounter::N_COUNTERS;
+  counters.assign(n_counters*events.size(), 0);
+
+  for (unsigned int t=0; t<thread_logs.size(); ++t)
+    {
+      const std::vector<PerfNode> & tree = thread_logs[t].tree;
+      for (unsigned int n=1; n<tree.size(); ++n)
+        for (unsigned int c=0; c<n_counters; ++c)
+          counters[n_counters*tree[n].event + c] += tree[n].counters[c] - tree[n].child_counters[c];
+    }
+}
+
 
-      gettimeofday (&tstart, NULL);
 
-      log.clear();
+std::string PerfLog::_counter_table(const std::vector<long long> &counters,
+                                    const std::vector<std::pair<std::string,std::string> > &names) const
+{
+  OStringStream out;
 
-      while (!log_stack.empty())
-        log_stack.pop();
+  const unsigned int n_counters = HWCounter::N_COUNTERS;
+
+  unsigned int event_col_width        = 32;
+  const unsigned int count_col_width  = 14;
+  const unsigned int ratio_col_width  = 10;
+  for (unsigned int e=0; e<names.size(); ++e)
+    if (names[e].second.size()+3 > event_col_width)
+      event_col_width = names[e].second.size()+3;
+
+  const unsigned int total_col_width = event_col_width + 3*count_col_width + 3*ratio_col_width + 1;
+
+  out << ' ';
+  this->_character_line(total_col_width, '-', out);
+  out << '\n';
+
+  out << "| ";
+  OSSStringleft(out,event_col_width,"Hardware Counters (exclusive)");
+  OSSStringleft(out,count_col_width,"Cycles");
+  OSSStringleft(out,count_col_width,"Instructions");
+  OSSStringleft(out,ratio_col_width,"IPC");
+  OSSStringleft(out,count_col_width,"Cache Misses");
+  OSSStringleft(out,ratio_col_width,"Miss Rate");
+  OSSStringleft(out,ratio_col_width,"Flop/Inst");
+  out << "|\n|";
+  this->_character_line(total_col_width, '-', out);
+  out << "|\n";
+
+  std::string last_header("");
+  for (unsigned int e=0; e<names.size(); ++e)
+    {
+      const long long * v = &counters[n_counters*e];
+      if (v[HWCounter::CYCLES] == 0 && v[HWCounter::INSTRUCTIONS] == 0) continue;
+
+      if (names[e].first.empty())
+        {
+          out << "| ";
+          OSSStringleft(out,event_col_width,names[e].second);
+        }
+      else
+        {
+          if (last_header != names[e].first)
+            {
+              last_header = names[e].first;
+              out << "| ";
+              OSSStringleft(out, total_col_width-1, last_header);
+              out << "|\n";
+            }
+          out << "|   ";
+          OSSStringleft(out, event_col_width-2, names[e].second);
+        }
+
+      const double cycles       = static_cast<double>(v[HWCounter::CYCLES]);
+      const double instructions = static_cast<double>(v[HWCounter::INSTRUCTIONS]);
+      const double references   = static_cast<double>(v[HWCounter::CACHE_REFERENCES]);
+      const double misses       = static_cast<double>(v[HWCounter::CACHE_MISSES]);
+      const double fp_ops       = static_cast<double>(v[HWCounter::FP_OPS]);
+
+      out.setf(std::ios::scientific);
+      OSSRealleft(out,count_col_width,4,cycles);
+      OSSRealleft(out,count_col_width,4,instructions);
+      out.unsetf(std::ios::scientific);
+      out.setf(std::ios::fixed);
+      OSSRealleft(out,ratio_col_width,3,cycles > 0 ? instructions/cycles : 0.);
+      out.unsetf(std::ios::fixed);
+      out.setf(std::ios::scientific);
+      OSSRealleft(out,count_col_width,4,misses);
+      out.unsetf(std::ios::scientific);
+      out.setf(std::ios::fixed);
+      OSSRealleft(out,ratio_col_width,3,references > 0 ? misses/references : 0.);
+      OSSRealleft(out,ratio_col_width,3,instructions > 0 ? fp_ops/instructions : 0.);
+      out.unsetf(std::ios::fixed);
+      out << "|\n";
     }
+
+  out << ' ';
+  this->_character_line(total_col_width, '-', out);
+  out << '\n';
+
+  return out.str();
 }
 
 
+
 std::string PerfLog::get_info_header() const
 {
   OStringStream out;
@@ -198,15 +369,14 @@ std::string PerfLog::get_perf_info() const
 {
   OStringStream out;
 
-  if (log_events && !log.empty())
+  if (log_events && !events.empty())
     {
-      // Stop timing for this event.
-      struct timeval tstop;
-
-      gettimeofday (&tstop, NULL);
+      const double elapsed_time = wall_time() - tstart;
 
-      const double elapsed_time = (static_cast<double>(tstop.tv_sec  - tstart.tv_sec) +
-                                   static_cast<double>(tstop.tv_usec - tstart.tv_usec)*1.e-6);
+      // the exclusive time of each event, summed over the call tree of all threads
+      std::vector<double>       self_time;
+      std::vector<unsigned int> self_count;
+      this->_event_totals(self_time, self_count);
 
       // Figure out the formatting required based on the event names
       // Unsigned ints for each of the column widths
@@ -216,12 +386,12 @@ std::string PerfLog::get_perf_info() const
       const unsigned int avg_time_col_width   = 12;
       const unsigned int pct_active_col_width = 13;
 
-      // Iterator to be used to loop over the map of timed events
-      std::map<std::pair<std::string,std::string>, PerfData>::const_iterator pos;
+      // Iterator to be used to loop over the events, ordered by (header, label)
+      std::map<std::pair<std::string,std::string>, unsigned int>::const_iterator pos;
 
       // Reset the event column width based on the longest event name plus
       // a possible 2-character indentation, plus a space.
-      for (pos = log.begin(); pos != log.end(); ++pos)
+      for (pos = event_ids.begin(); pos != event_ids.end(); ++pos)
         if (pos->first.second.size()+3 > event_col_width)
           event_col_width = pos->first.second.size()+3;
 
@@ -295,15 +465,13 @@ std::string PerfLog::get_perf_info() const
 
       std::string last_header("");
 
-      for (pos = log.begin(); pos != log.end(); ++pos)
+      for (pos = event_ids.begin(); pos != event_ids.end(); ++pos)
         {
-          const PerfData& perf_data = pos->second;
-
           // Only print the event if the count is non-zero.
-          if (perf_data.count != 0)
+          if (self_count[pos->second] != 0)
             {
-              const unsigned int perf_count    = perf_data.count;
-              const double       perf_time     = perf_data.tot_time;
+              const unsigned int perf_count    = self_count[pos->second];
+              const double       perf_time     = self_time[pos->second];
               const double       perf_avg_time = perf_time / static_cast<double>(perf_count);
               const double       perf_percent  = (total_time != 0.) ? perf_time / total_time * 100. : 0.;
 
@@ -408,7 +576,7 @@ std::string PerfLog::get_log() const
     {
       // Only print the log
       // if it isn't empty
-      if (!log.empty())
+      if (!events.empty())
         {
           // Possibly print machine info,
           // but only do this once
@@ -418,6 +586,27 @@ std::string PerfLog::get_log() const
               out << get_info_header();
             }
           out << get_perf_info();
+          out << get_call_tree();
+
+          if (HWCounter::enabled())
+            {
+              // the events ordered by (header, label)
+              std::vector<long long> counters;
+              this->_counter_totals(counters);
+
+              const unsigned int n_counters = HWCounter::N_COUNTERS;
+              std::vector<long long> ordered_counters;
+              std::vector<std::pair<std::string,std::string> > names;
+              std::map<std::pair<std::string,std::string>, unsigned int>::const_iterator pos = event_ids.begin();
+              for (; pos != event_ids.end(); ++pos)
+                {
+                  names.push_back(pos->first);
+                  ordered_counters.insert(ordered_counters.end(),
+                                          counters.begin() + n_counters*pos->second,
+                                          counters.begin() + n_counters*(pos->second+1));
+                }
+              out << _counter_table(ordered_counters, names);
+            }
         }
     }
 
@@ -467,6 +656,264 @@ void PerfLog::restart_event(const std::string &,
 
 
 
+std::string PerfLog::get_call_tree() const
+{
+  OStringStream out;
+
+  if (log_events && !events.empty())
+    {
+      unsigned int event_col_width        = 40;
+      const unsigned int ncalls_col_width = 10;
+      const unsigned int time_col_width   = 12;
+
+      for (unsigned int e=0; e<events.size(); ++e)
+        if (events[e].second.size()+20 > event_col_width)
+          event_col_width = events[e].second.size()+20;
+
+      const unsigned int total_col_width = event_col_width + ncalls_col_width + 2*time_col_width + 1;
+
+      out << ' ';
+      this->_character_line(total_col_width, '-', out);
+      out << '\n';
+
+      out << "| ";
+      OSSStringleft(out,event_col_width,"Call Tree");
+      OSSStringleft(out,ncalls_col_width,"nCalls");
+      OSSStringleft(out,time_col_width,"Inclusive");
+      OSSStringleft(out,time_col_width,"Exclusive");
+      out << "|\n|";
+      this->_character_line(total_col_width, '-', out);
+      out << "|\n";
+
+      for (unsigned int t=0; t<thread_logs.size(); ++t)
+        {
+          if (thread_logs[t].tree[0].children.empty()) continue;
+
+          if (thread_logs.size() > 1)
+            {
+              OStringStream temp;
+              temp << "Thread " << t;
+              out << "| ";
+              OSSStringleft(out, total_col_width-1, temp.str());
+              out << "|\n";
+            }
+
+          const std::vector<std::pair<unsigned int, unsigned int> > & roots = thread_logs[t].tree[0].children;
+          for (unsigned int i=0; i<roots.size(); ++i)
+            this->_print_tree(thread_logs[t], roots[i].second, 0, event_col_width, out);
+        }
+
+      out << ' ';
+      this->_character_line(total_col_width, '-', out);
+      out << '\n';
+    }
+
+  return out.str();
+}
+
+
+
+void PerfLog::_print_tree(const PerfThreadLog &log,
+                          const unsigned int node,
+                          const unsigned int level,
+                          const unsigned int event_col_width,
+                          OStringStream &out) const
+{
+  const PerfNode & perf_node = log.tree[node];
+  const std::pair<std::string,std::string> & event = events[perf_node.event];
+
+  OStringStream name;
+  for (unsigned int l=0; l<level; ++l)
+    name << "  ";
+  name << event.second;
+  if (!event.first.empty())
+    name << " (" << event.first << ")";
+
+  out << "| ";
+  OSSStringleft(out, event_col_width, name.str());
+  OSSInt(out, 10, perf_node.count);
+  out.setf(std::ios::fixed);
+  OSSRealleft(out, 12, 4, perf_node.tot_time);
+  OSSRealleft(out, 12, 4, perf_node.self_time());
+  out << "|\n";
+
+  for (unsigned int i=0; i<perf_node.children.size(); ++i)
+    this->_print_tree(log, perf_node.children[i].second, level+1, event_col_width, out);
+}
+
+
+
+void PerfLog::summarize()
+{
+  if (!log_events) return;
+
+  // the event ids differ between processors, merge them by name.
+  // the names are collected on the first processor and broadcast back
+  std::vector<char> local_names;
+  for (unsigned int e=0; e<events.size(); ++e)
+    {
+      local_names.insert(local_names.end(), events[e].first.begin(), events[e].first.end());
+      local_names.push_back('\0');
+      local_names.insert(local_names.end(), events[e].second.begin(), events[e].second.end());
+      local_names.push_back('\0');
+    }
+  Parallel::gather(0, local_names);
+
+  std::vector<std::string> names;
+  if (Genius::is_first_processor())
+    {
+      const std::vector<char> & all_names = local_names;
+      std::set<std::pair<std::string,std::string> > all_events;
+      std::vector<char>::const_iterator it = all_names.begin();
+      while (it != all_names.end())
+        {
+          std::vector<char>::const_iterator header_end = std::find(it, all_names.end(), '\0');
+          std::vector<char>::const_iterator label_end  = std::find(header_end+1, all_names.end(), '\0');
+          all_events.insert(std::make_pair(std::string(it, header_end), std::string(header_end+1, label_end)));
+          it = label_end+1;
+        }
+
+      std::set<std::pair<std::string,std::string> >::const_iterator e = all_events.begin();
+      for (; e != all_events.end(); ++e)
+        {
+          names.push_back(e->first);
+          names.push_back(e->second);
+        }
+    }
+  Parallel::broadcast(names);
+
+  // the local exclusive time and count of each merged event
+  std::vector<double>       self_time;
+  std::vector<unsigned int> self_count;
+  this->_event_totals(self_time, self_count);
+
+  const unsigned int n_events = names.size()/2;
+  std::vector<double> time_min(n_events, 0.), time_max(n_events, 0.), time_sum(n_events, 0.);
+  std::vector<unsigned int> count_sum(n_events, 0);
+
+  // the hardware counters are summed over the processors
+  const bool hw_counters = HWCounter::enabled();
+  const unsigned int n_counters = HWCounter::N_COUNTERS;
+  std::vector<long long> local_counters, counter_sum;
+  if (hw_counters)
+    {
+      this->_counter_totals(local_counters);
+      counter_sum.assign(n_counters*n_events, 0);
+    }
+
+  for (unsigned int e=0; e<n_events; ++e)
+    {
+      std::map<std::pair<std::string,std::string>, unsigned int>::const_iterator it =
+        event_ids.find(std::make_pair(names[2*e], names[2*e+1]));
+      if (it == event_ids.end()) continue;
+      time_min[e] = time_max[e] = time_sum[e] = self_time[it->second];
+      count_sum[e] = self_count[it->second];
+      if (hw_counters)
+        for (unsigned int c=0; c<n_counters; ++c)
+          counter_sum[n_counters*e + c] = local_counters[n_counters*it->second + c];
+    }
+  Parallel::min(time_min);
+  Parallel::max(time_max);
+  Parallel::sum(time_sum);
+  Parallel::sum(count_sum);
+  if (hw_counters)
+    Parallel::sum(counter_sum);
+
+  double alive_time = wall_time() - tstart;
+  Parallel::max(alive_time);
+
+  summarized = true;
+
+  if (!Genius::is_first_processor()) return;
+
+  OStringStream out;
+
+  unsigned int event_col_width        = 30;
+  const unsigned int ncalls_col_width = 12;
+  const unsigned int time_col_width   = 12;
+  for (unsigned int e=0; e<n_events; ++e)
+    if (names[2*e+1].size()+3 > event_col_width)
+      event_col_width = names[2*e+1].size()+3;
+
+  const unsigned int total_col_width = event_col_width + ncalls_col_width + 3*time_col_width + 1;
+
+  out << get_info_header();
+
+  out << ' ';
+  this->_character_line(total_col_width, '-', out);
+  out << '\n';
+  {
+    OStringStream temp;
+    temp << "| " << label_name << " Performance over " << Genius::n_processors()
+         << " processors: Alive time=" << alive_time;
+    out << temp.str();
+    if (temp.str().size() < total_col_width+2)
+      {
+        OSSStringright(out, total_col_width-temp.str().size()+2, "|");
+      }
+    out << '\n';
+  }
+
+  out << "| ";
+  OSSStringleft(out,event_col_width,"Event");
+  OSSStringleft(out,ncalls_col_width,"nCalls");
+  OSSStringleft(out,time_col_width,"Min Time");
+  OSSStringleft(out,time_col_width,"Avg Time");
+  OSSStringleft(out,time_col_width,"Max Time");
+  out << "|\n|";
+  this->_character_line(total_col_width, '-', out);
+  out << "|\n";
+
+  std::string last_header("");
+  for (unsigned int e=0; e<n_events; ++e)
+    {
+      if (count_sum[e] == 0) continue;
+
+      if (names[2*e].empty())
+        {
+          out << "| ";
+          OSSStringleft(out,event_col_width,names[2*e+1]);
+        }
+      else
+        {
+          if (last_header != names[2*e])
+            {
+              last_header = names[2*e];
+              out << "| ";
+              OSSStringleft(out, total_col_width-1, last_header);
+              out << "|\n";
+            }
+          out << "|   ";
+          OSSStringleft(out, event_col_width-2, names[2*e+1]);
+        }
+
+      OSSInt(out,ncalls_col_width,count_sum[e]);
+      out.setf(std::ios::fixed);
+      OSSRealleft(out,time_col_width,4,time_min[e]);
+      OSSRealleft(out,time_col_width,4,time_sum[e]/Genius::n_processors());
+      OSSRealleft(out,time_col_width,4,time_max[e]);
+      out << "|\n";
+    }
+
+  out << ' ';
+  this->_character_line(total_col_width, '-', out);
+  out << '\n';
+
+  out << get_call_tree();
+
+  if (hw_counters)
+    {
+      std::vector<std::pair<std::string,std::string> > counter_names;
+      for (unsigned int e=0; e<n_events; ++e)
+        counter_names.push_back(std::make_pair(names[2*e], names[2*e+1]));
+      out << _counter_table(counter_sum, counter_names);
+    }
+
+  std::cout << out.str() << std::endl;
+}
+
+
+
 void PerfLog::_character_line(const unsigned int n,
                               const char c,
                               OStringStream& out) const
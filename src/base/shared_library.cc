@@ -0,0 +1,193 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <map>
+#include <sstream>
+
+#ifdef CYGWIN
+  #include <Windows.h>
+  #undef max
+  #undef min
+#else
+  #include <dlfcn.h>
+#endif
+
+#include "genius_common.h"
+#include "perf_log.h"
+#include "shared_library.h"
+
+
+namespace
+{
+  /**
+   * an opened library and its resolved symbols
+   */
+  struct Library
+  {
+    Library() : handle(0), ref(0) {}
+    std::string filename;
+    void *      handle;
+    unsigned int ref;
+    std::map<std::string, void *> symbols;
+  };
+
+  /**
+   * opened libraries, indexed by file name and by handle
+   */
+  std::map<std::string, Library *> & libraries_by_name()
+  {
+    static std::map<std::string, Library *> libraries;
+    return libraries;
+  }
+
+  std::map<void *, Library *> & libraries_by_handle()
+  {
+    static std::map<void *, Library *> libraries;
+    return libraries;
+  }
+
+  std::string & last_error()
+  {
+    static std::string message;
+    return message;
+  }
+}
+
+
+namespace SharedLibrary
+{
+
+  void * open(const std::string & filename)
+  {
+    std::map<std::string, Library *>::iterator it = libraries_by_name().find(filename);
+    if( it != libraries_by_name().end() )
+    {
+      it->second->ref++;
+      return it->second->handle;
+    }
+
+    START_LOG("open()", "SharedLibrary");
+
+    void * handle = 0;
+#ifdef CYGWIN
+    handle = reinterpret_cast<void *>(LoadLibrary(filename.c_str()));
+    if( !handle )
+    {
+      std::stringstream ss;
+      ss << GetLastError();
+      last_error() = ss.str();
+    }
+#else
+    // bind all the symbols now, fall back to lazy binding for library with unresolved symbols
+    handle = dlopen(filename.c_str(), RTLD_NOW);
+    if( !handle )
+      handle = dlopen(filename.c_str(), RTLD_LAZY);
+    if( !handle )
+      last_error() = dlerror();
+#endif
+
+    STOP_LOG("open()", "SharedLibrary");
+
+    if( !handle ) return 0;
+
+    // the system may return the same handle for different names of one file
+    std::map<void *, Library *>::iterator hit = libraries_by_handle().find(handle);
+    if( hit != libraries_by_handle().end() )
+    {
+#ifndef CYGWIN
+      // drop the extra reference held by the system
+      dlclose(handle);
+#else
+      FreeLibrary(reinterpret_cast<HINSTANCE>(handle));
+#endif
+      hit->second->ref++;
+      return handle;
+    }
+
+    Library * library = new Library;
+    library->filename = filename;
+    library->handle   = handle;
+    library->ref      = 1;
+    libraries_by_name()[filename]  = library;
+    libraries_by_handle()[handle]  = library;
+
+    return handle;
+  }
+
+
+  void * symbol(void * handle, const std::string & name)
+  {
+    if( !handle ) return 0;
+
+    std::map<void *, Library *>::iterator it = libraries_by_handle().find(handle);
+    genius_assert( it != libraries_by_handle().end() );
+
+    Library * library = it->second;
+    std::map<std::string, void *>::const_iterator sit = library->symbols.find(name);
+    if( sit != library->symbols.end() ) return sit->second;
+
+#ifdef CYGWIN
+    void * address = reinterpret_cast<void *>(GetProcAddress(reinterpret_cast<HINSTANCE>(handle), name.c_str()));
+#else
+    void * address = dlsym(handle, name.c_str());
+#endif
+
+    // not found symbols are cached as well, the caller reports the error
+    library->symbols[name] = address;
+    return address;
+  }
+
+
+  void close(void * handle)
+  {
+    if( !handle ) return;
+
+    std::map<void *, Library *>::iterator it = libraries_by_handle().find(handle);
+    genius_assert( it != libraries_by_handle().end() );
+
+    Library * library = it->second;
+    if( --library->ref ) return;
+
+#ifdef CYGWIN
+    FreeLibrary(reinterpret_cast<HINSTANCE>(handle));
+#else
+    dlclose(handle);
+#endif
+
+    libraries_by_handle().erase(it);
+    libraries_by_name().erase(library->filename);
+    delete library;
+  }
+
+
+  std::string error()
+  {
+    return last_error();
+  }
+
+
+  unsigned int n_libraries()
+  {
+    return libraries_by_handle().size();
+  }
+
+}
@@ -0,0 +1,147 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <time.h>
+
+#include "genius_env.h"
+#include "genius_common.h"
+#include "parallel.h"
+#include "trace_log.h"
+#include "memory_log.h"
+
+
+namespace
+{
+  // seconds of a monotonic clock
+  inline double monotonic_time()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec)*1.e-9;
+  }
+
+  // escape the chars not allowed in json string
+  std::string json_string(const char *s)
+  {
+    std::string out;
+    for( ; s && *s; ++s )
+    {
+      if( *s == '"' || *s == '\\' ) out += '\\';
+      if( static_cast<unsigned char>(*s) < 0x20 ) continue;
+      out += *s;
+    }
+    return out;
+  }
+}
+
+
+TraceLog::TraceLog()
+  : _enabled(false), _tstart(0.0), _thread_events(1)
+{}
+
+
+void TraceLog::enable(const std::string &prefix)
+{
+  _prefix = prefix;
+
+  // all the processors leave the barrier at nearly the same time,
+  // use it as the common origin of the timeline
+  Parallel::barrier();
+  _tstart = monotonic_time();
+
+  _enabled = true;
+}
+
+
+void TraceLog::set_n_threads(unsigned int n)
+{
+  // only the master thread may be recording now
+  if( n > _thread_events.size() )
+    _thread_events.resize(n);
+}
+
+
+void TraceLog::_record(const char *name, const char *category, char phase)
+{
+  const unsigned int tid = Genius::thread_id();
+  if( tid >= _thread_events.size() ) return;
+
+  Event event;
+  event.name     = name;
+  event.category = category;
+  event.time     = monotonic_time();
+  event.phase    = phase;
+  _thread_events[tid].push_back(event);
+}
+
+
+void TraceLog::write()
+{
+  if( !_enabled ) return;
+  _enabled = false;
+
+  std::stringstream ss;
+  ss << _prefix << '.' << Genius::processor_id() << ".json";
+
+  std::ofstream out(ss.str().c_str());
+  if( !out.good() )
+  {
+    std::cerr << "Warning: can not open trace file " << ss.str() << std::endl;
+    return;
+  }
+
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+  // name of the process and threads
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << Genius::processor_id()
+      << ",\"args\":{\"name\":\"processor " << Genius::processor_id() << "\"}}";
+
+  char buffer[64];
+  for( unsigned int t=0; t<_thread_events.size(); ++t )
+  {
+    const std::vector<Event> & events = _thread_events[t];
+    for( unsigned int i=0; i<events.size(); ++i )
+    {
+      const Event & event = events[i];
+      // time stamp in micro second
+      snprintf(buffer, sizeof(buffer), "%.3f", (event.time - _tstart)*1e6);
+      out << ",\n{\"name\":\"" << json_string(event.name) << "\",\"cat\":\"" << json_string(event.category)
+          << "\",\"ph\":\"" << event.phase << "\",\"ts\":" << buffer
+          << ",\"pid\":" << Genius::processor_id() << ",\"tid\":" << t << "}";
+    }
+    std::vector<Event>().swap(_thread_events[t]);
+  }
+
+  // resident memory of this processor at the end of the timeline, in MB
+  snprintf(buffer, sizeof(buffer), "%.3f", (monotonic_time() - _tstart)*1e6);
+  out << ",\n{\"name\":\"memory\",\"ph\":\"C\",\"ts\":" << buffer
+      << ",\"pid\":" << Genius::processor_id() << ",\"tid\":0,\"args\":{\"rss\":"
+      << MemoryLog::resident_memory()/1048576.0 << ",\"peak_rss\":"
+      << MemoryLog::peak_resident_memory()/1048576.0 << "}}";
+
+  out << "\n]}\n";
+}
+
+
+TraceLog tracelog;
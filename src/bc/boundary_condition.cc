@@ -60,6 +60,8 @@ void init_bc_name_to_bc_type_map()
   if ( bc_name_to_bc_type.empty() )
   {
     bc_name_to_bc_type["neumann"                  ]  = NeumannBoundary;
+    bc_name_to_bc_type["symmetry"                 ]  = NeumannBoundary;
+    bc_name_to_bc_type["periodic"                 ]  = PeriodicBoundary;
     bc_name_to_bc_type["ohmiccontact"             ]  = OhmicContact;
     bc_name_to_bc_type["metalohmicinterface"      ]  = IF_Metal_Ohmic;
     bc_name_to_bc_type["schottkycontact"          ]  = SchottkyContact;
@@ -104,6 +106,7 @@ void init_bc_type_to_bc_name_map()
     bc_type_to_bc_name[IF_Metal_Vacuum            ]  = std::string("IF_Metal_Vacuum");
     bc_type_to_bc_name[IF_PML_Scatter                  ]  = std::string("IF_PML_Scatter");
     bc_type_to_bc_name[IF_PML_PML                      ]  = std::string("IF_PML_PML");
+    bc_type_to_bc_name[PeriodicBoundary                ]  = std::string("PeriodicBoundary");
     bc_type_to_bc_name[IF_Electrode_Insulator          ]  = std::string("IF_Electrode_Insulator");
     bc_type_to_bc_name[IF_Insulator_Semiconductor      ]  = std::string("IF_Insulator_Semiconductor");
     bc_type_to_bc_name[IF_Insulator_Insulator          ]  = std::string("IF_Insulator_Insulator");
@@ -378,6 +381,33 @@ void BoundaryCondition::set_boundary_id_to_fvm_node()
   }
 }
 
+void BoundaryCondition::build_region_node_table()
+{
+  _region_node_table.clear();
+  _region_node_table_begin.clear();
+  _region_node_table_begin.reserve(_bd_nodes.size()+1);
+
+  for(unsigned int n=0; n<_bd_nodes.size(); ++n)
+  {
+    _region_node_table_begin.push_back(_region_node_table.size());
+
+    std::map<const Node *, std::multimap<SimulationRegionType, std::pair<SimulationRegion *, FVM_Node *> > >::const_iterator
+    it = _bd_fvm_nodes.find(_bd_nodes[n]);
+    if( it == _bd_fvm_nodes.end() ) continue;
+
+    const_region_node_iterator rnode_it = (*it).second.begin();
+    for( ; rnode_it!=(*it).second.end(); ++rnode_it)
+    {
+      RegionNode entry;
+      entry.node     = _bd_nodes[n];
+      entry.region   = (*rnode_it).second.first;
+      entry.fvm_node = (*rnode_it).second.second;
+      _region_node_table.push_back(entry);
+    }
+  }
+  _region_node_table_begin.push_back(_region_node_table.size());
+}
+
 //---------------------------------------------------------------------------------
 // constructors for each derived class
 //---------------------------------------------------------------------------------
@@ -389,6 +419,7 @@ void BoundaryCondition::set_boundary_id_to_fvm_node()
 #include "boundary_condition_is.h"
 #include "boundary_condition_ei.h"
 #include "boundary_condition_neumann.h"
+#include "boundary_condition_periodic.h"
 #include "boundary_condition_gate.h"
 #include "boundary_condition_ohmic.h"
 #include "boundary_condition_resistance_ohmic.h"
@@ -425,6 +456,13 @@ NeumannBC::NeumannBC(SimulationSystem  & system, const std::string & label): Bou
 }
 
 
+PeriodicBC::PeriodicBC(SimulationSystem  & system, const std::string & label, const std::string & pair_label, bool master)
+  : NeumannBC(system,label), _pair_label(pair_label), _master(master)
+{
+  MESSAGE<<"  Pair ""<< label <<"" with ""<< pair_label <<"" as Periodic BC..."<<std::endl; RECORD();
+}
+
+
 
 OhmicContactBC::OhmicContactBC(SimulationSystem  & system, const std::string & label, bool _interface): BoundaryCondition(system,label)
 {
@@ -582,6 +620,27 @@ std::string NeumannBC::boundary_condition_in_string() const
 }
 
 
+std::string PeriodicBC::boundary_condition_in_string() const
+{
+  // only the master boundary writes the card, which builds the pair
+  if( !_master ) return std::string();
+
+  std::stringstream ss;
+
+  ss <<"BOUNDARY "
+  <<"string<id>="<<this->label()<<" "
+  <<"enum<type>=Periodic "
+  <<"string<periodic.pair>="<<_pair_label<<" ";
+
+  if(system().mesh().mesh_dimension () == 2)
+    ss<<"real<z.width>="<<z_width()/um;
+
+  ss<<std::endl;
+
+  return ss.str();
+}
+
+
 std::string OhmicContactBC::boundary_condition_in_string() const
 {
   std::stringstream ss;
@@ -21,6 +21,7 @@
 
 //  $Id: boundary_condition_collector.cc,v 1.28 2008/07/09 05:58:16 gdiso Exp $
 #include <fstream>
+#include <algorithm>
 
 #include "mesh_base.h"
 #include "boundary_info.h"
@@ -31,6 +32,7 @@
 #include "boundary_condition_collector.h"
 #include "mxml.h"
 #include "MXMLUtil.h"
+#include "parallel.h"
 
 
 // all the derived boundary conditions
@@ -41,6 +43,7 @@
 #include "boundary_condition_is.h"
 #include "boundary_condition_ei.h"
 #include "boundary_condition_neumann.h"
+#include "boundary_condition_periodic.h"
 #include "boundary_condition_gate.h"
 #include "boundary_condition_ohmic.h"
 #include "boundary_condition_resistance_ohmic.h"
@@ -63,6 +66,7 @@ using PhysicalUnit::mu0;
 using PhysicalUnit::s;
 using PhysicalUnit::cm;
 using PhysicalUnit::um;
+using PhysicalUnit::nm;
 using PhysicalUnit::V;
 using PhysicalUnit::A;
 using PhysicalUnit::C;
@@ -211,6 +215,7 @@ int  BoundaryConditionCollector::bc_setup()
       switch ( bc_type )
       {
         case NeumannBoundary             :  { if ( Set_BC_NeumannBoundary ( c ) )              return 1; break;}
+        case PeriodicBoundary            :  { if ( Set_BC_PeriodicBoundary ( c ) )             return 1; break;}
         case OhmicContact                :  { if ( Set_BC_OhmicContact ( c ) )                 return 1; break;}
         case IF_Metal_Ohmic              :  { if ( Set_BC_IF_Metal_Ohmic ( c ) )               return 1; break;}
         case SchottkyContact             :  { if ( Set_BC_SchottkyContact ( c ) )              return 1; break;}
@@ -258,6 +263,7 @@ int  BoundaryConditionCollector::bc_setup()
       switch(bc_type)
       {
         case NeumannBoundary             :  { if( Set_BC_NeumannBoundary(c) )                  return 1; break;}
+        case PeriodicBoundary            :  { if( Set_BC_PeriodicBoundary(c) )                 return 1; break;}
         case OhmicContact                :  { if( Set_BC_OhmicContact(c) )                     return 1; break;}
         case IF_Metal_Ohmic              :  { if( Set_BC_IF_Metal_Ohmic ( c ) )                return 1; break;}
         case SchottkyContact             :  { if( Set_BC_SchottkyContact(c) )                  return 1; break;}
@@ -449,8 +455,12 @@ int  BoundaryConditionCollector::bc_setup()
 
 
     _bcs[i]->set_boundary_id_to_fvm_node();
+    _bcs[i]->build_region_node_table();
   }
 
+  // the nodes of slave periodic boundary share the dofs of master boundary
+  build_periodic_node_map();
+
 
   // process inter-connect /charge boundary here
   for ( _decks.begin(); !_decks.end(); _decks.next() )
@@ -547,11 +557,138 @@ int BoundaryConditionCollector::Set_BC_NeumannBoundary ( const Parser::Card &c )
   _bcs[bc_index]->z_width()       = c.get_real ( "z.width", _bcs[bc_index]->z_width() /um ) *um;
   _bcs[bc_index]->reflection()    = c.get_bool ( "reflection", false );
 
+  // the mirror plane of a symmetric structure has zero flux of all the equations,
+  // and reflects the light back
+  if ( c.is_enum_value ( "type", "symmetry" ) )
+  {
+    _bcs[bc_index]->Heat_Transfer() = 0.0;
+    _bcs[bc_index]->reflection()    = true;
+  }
+
   return 0;
 }
 
 
 
+int BoundaryConditionCollector::Set_BC_PeriodicBoundary ( const Parser::Card &c )
+{
+  std::string Identifier;
+  unsigned int bc_index = get_bc_from_card ( c, Identifier );
+
+  std::string pair_label = c.get_string ( "periodic.pair", "" );
+  short int pair_bd_id = _mesh.boundary_info->get_id_by_label ( pair_label );
+  if ( pair_bd_id == BoundaryInfo::invalid_id || pair_label == Identifier )
+  {
+    MESSAGE<<"ERROR at " <<c.get_fileline() << " Boundary: Periodic pair "<< pair_label <<" can't be found in mesh boundaries." <<std::endl; RECORD();
+    genius_error();
+  }
+  unsigned int pair_index = get_bc_index_by_bd_id ( pair_bd_id );
+
+  // the boundary given by id keeps its dofs, the paired one is the slave
+  _bcs[bc_index] = new PeriodicBC ( _system, Identifier, pair_label, true );
+  _bcs[bc_index]->T_external()    = c.get_real ( "ext.temp", _system.T_external() /K ) *K;
+  _bcs[bc_index]->z_width()       = c.get_real ( "z.width", _bcs[bc_index]->z_width() /um ) *um;
+
+  delete _bcs[pair_index];
+  _bcs[pair_index] = new PeriodicBC ( _system, pair_label, Identifier, false );
+  _bcs[pair_index]->T_external()  = _bcs[bc_index]->T_external();
+  _bcs[pair_index]->z_width()     = _bcs[bc_index]->z_width();
+
+  _periodic_pairs.push_back( std::make_pair(bc_index, pair_index) );
+
+  return 0;
+}
+
+
+
+void BoundaryConditionCollector::build_periodic_node_map()
+{
+  _periodic_node_map.clear();
+  if ( _periodic_pairs.empty() ) return;
+
+  // the dofs are identified by the serial dof map, both nodes of a pair should be local
+  if ( Genius::n_processors() > 1 )
+  {
+    MESSAGE<<"ERROR: Periodic boundary can only be used on one processor." <<std::endl; RECORD();
+    genius_error();
+  }
+
+  // all the nodes on the boundary sides, including the ones taken by other bc of higher priority
+  std::map<short int, std::set<const Node *> > boundary_side_nodes;
+  _mesh.boundary_info->boundary_side_nodes_with_id ( boundary_side_nodes );
+
+  for ( unsigned int p=0; p<_periodic_pairs.size(); ++p )
+  {
+    const std::set<const Node *> & master_nodes = boundary_side_nodes[_bcs[_periodic_pairs[p].first]->boundary_id()];
+    const std::set<const Node *> & slave_nodes  = boundary_side_nodes[_bcs[_periodic_pairs[p].second]->boundary_id()];
+    if ( master_nodes.empty() || slave_nodes.empty() ) continue;
+
+    // the translation moves master boundary onto slave boundary
+    Point master_min( 1e30,  1e30,  1e30), slave_min( 1e30,  1e30,  1e30);
+    Point master_max(-1e30, -1e30, -1e30);
+    std::set<const Node *>::const_iterator it;
+    for ( it = master_nodes.begin(); it != master_nodes.end(); ++it )
+      for ( unsigned int i=0; i<3; i++ )
+      {
+        master_min(i) = std::min ( master_min(i), (**it)(i) );
+        master_max(i) = std::max ( master_max(i), (**it)(i) );
+      }
+    for ( it = slave_nodes.begin(); it != slave_nodes.end(); ++it )
+      for ( unsigned int i=0; i<3; i++ )
+        slave_min(i) = std::min ( slave_min(i), (**it)(i) );
+    const Point translation = slave_min - master_min;
+    const Point extent = master_max - master_min;
+    const Real tol = std::max ( 1e-6*extent.size(), 1e-6*nm );
+
+    // master nodes sorted along the longest extent of the boundary
+    unsigned int axis = 0;
+    for ( unsigned int i=1; i<3; i++ )
+      if ( extent(i) > extent(axis) ) axis = i;
+
+    std::vector< std::pair<Real, const Node *> > sorted_master;
+    for ( it = master_nodes.begin(); it != master_nodes.end(); ++it )
+      sorted_master.push_back ( std::make_pair ( (**it)(axis), *it ) );
+    std::sort ( sorted_master.begin(), sorted_master.end() );
+
+    unsigned int n_unpaired = 0;
+    for ( it = slave_nodes.begin(); it != slave_nodes.end(); ++it )
+    {
+      const Point q = **it - translation;
+
+      const Node * master = NULL;
+      std::vector< std::pair<Real, const Node *> >::const_iterator m =
+        std::lower_bound ( sorted_master.begin(), sorted_master.end(), std::make_pair ( q(axis)-tol, static_cast<const Node *>(NULL) ) );
+      for ( ; m != sorted_master.end() && m->first <= q(axis)+tol; ++m )
+        if ( ( *(m->second) - q ).size() < tol ) { master = m->second; break; }
+
+      if ( master == NULL ) { n_unpaired++; continue; }
+      if ( master != *it ) _periodic_node_map[*it] = master;
+    }
+
+    if ( n_unpaired )
+    {
+      MESSAGE<<"Warning: " << n_unpaired << " nodes of periodic boundary " << _bcs[_periodic_pairs[p].second]->label()
+             << " have no pair on boundary " << _bcs[_periodic_pairs[p].first]->label() << "." <<std::endl; RECORD();
+    }
+  }
+
+  // the node on more than one periodic pairs (i.e. the corner) takes the dofs of the last master
+  std::map<const Node *, const Node *>::iterator node_it = _periodic_node_map.begin();
+  for ( ; node_it != _periodic_node_map.end(); ++node_it )
+  {
+    const Node * master = node_it->second;
+    for ( unsigned int n=0; n<_periodic_node_map.size(); ++n )
+    {
+      std::map<const Node *, const Node *>::const_iterator next = _periodic_node_map.find ( master );
+      if ( next == _periodic_node_map.end() || next->second == node_it->first ) break;
+      master = next->second;
+    }
+    node_it->second = master;
+  }
+}
+
+
+
 int BoundaryConditionCollector::Set_BC_OhmicContact ( const Parser::Card &c )
 {
   std::string Identifier;
@@ -1283,6 +1420,163 @@ std::vector<std::string> BoundaryConditionCollector::_find_interface_by_2_region
 }
 
 
+void BoundaryConditionCollector::update_electrode_charge()
+{
+  std::vector<BoundaryCondition *> electrodes;
+  for(unsigned int n=0; n<_bcs.size(); n++)
+    if( _bcs[n]->is_electrode() )
+      electrodes.push_back(_bcs[n]);
+
+  std::vector<PetscScalar> charge(electrodes.size(), 0.0);
+  for(unsigned int n=0; n<electrodes.size(); n++)
+    charge[n] = local_electrode_charge(electrodes[n]);
+
+  // one reduction for all the electrodes
+  Parallel::sum(charge);
+
+  for(unsigned int n=0; n<electrodes.size(); n++)
+    electrodes[n]->ext_circuit()->charge() = charge[n];
+}
+
+
+PetscScalar BoundaryConditionCollector::local_electrode_charge(const BoundaryCondition * bc, const PetscScalar * lx) const
+{
+  PetscScalar charge = 0.0;
+
+  BoundaryCondition::const_node_iterator node_it = bc->nodes_begin();
+  BoundaryCondition::const_node_iterator end_it  = bc->nodes_end();
+  for(; node_it != end_it; ++node_it)
+  {
+    // skip node not belonging to this processor
+    if ( (*node_it)->processor_id() != Genius::processor_id() ) continue;
+
+    // iterate over all fvm_node associated to *node_it
+    BoundaryCondition::const_region_node_iterator rnode_it = bc->region_node_begin(*node_it);
+    BoundaryCondition::const_region_node_iterator end_rnode_it = bc->region_node_end(*node_it);
+    for( ; rnode_it!=end_rnode_it; ++rnode_it)
+    {
+      const SimulationRegion * region = (*rnode_it).second.first;
+      if( region->type() != InsulatorRegion && region->type() != SemiconductorRegion ) continue;
+
+      const FVM_Node * fvm_node = (*rnode_it).second.second;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+      PetscScalar psi = lx ? lx[fvm_node->local_offset()] : node_data->psi();
+
+      FVM_Node::fvm_neighbor_node_iterator nb_it = fvm_node->neighbor_node_begin();
+      for( ; nb_it != fvm_node->neighbor_node_end(); ++nb_it )
+      {
+        const FVM_Node *nb_node = (*nb_it).second;
+        PetscScalar nb_psi = lx ? lx[nb_node->local_offset()] : nb_node->node_data()->psi();
+        PetscScalar distance = (*(fvm_node->root_node()) - *(nb_node->root_node())).size();
+        PetscScalar cv_area = fvm_node->cv_surface_area(nb_node->root_node());
+        charge += cv_area*node_data->eps()*(psi - nb_psi)/distance;
+      }
+    }
+  }
+
+  // device in Z dimension. for 3D mesh, z_width() should return 1.0.
+  return charge*bc->z_width();
+}
+
+
+/**
+ * @return true when the extra equation of bc is the lumped circuit equation of DDM1/DDM2/EBM3 solvers
+ */
+static bool has_circuit_equation(const BoundaryCondition * bc)
+{
+  switch( bc->bc_type() )
+  {
+      case OhmicContact      :
+      case SchottkyContact   :
+      case GateContact       :
+      case SimpleGateContact :
+      case SolderPad         : return true;
+      default                : return false;
+  }
+}
+
+
+void BoundaryConditionCollector::electrode_circuit_function(const PetscScalar * x, Vec f, InsertMode &add_value_flag) const
+{
+  // since we will use ADD_VALUES operat, check the vector state.
+  if( (add_value_flag != ADD_VALUES) && (add_value_flag != NOT_SET_VALUES) )
+  {
+    VecAssemblyBegin(f);
+    VecAssemblyEnd(f);
+  }
+
+  if( Genius::is_last_processor() )
+  {
+    const PetscScalar dt = SolverSpecify::dt;
+
+    std::vector<PetscInt>    rows;
+    std::vector<PetscScalar> values;
+    for(unsigned int n=0; n<_bcs.size(); n++)
+    {
+      const BoundaryCondition * bc = _bcs[n];
+      if( !has_circuit_equation(bc) ) continue;
+
+      // the electrode potential
+      PetscScalar Ve = x[bc->local_offset()];
+
+      rows.push_back(bc->global_offset());
+      // for inter connect electrode, Ve - V_ic + R*current
+      if( bc->is_inter_connect_bc() )
+        values.push_back(Ve - x[bc->inter_connect_hub()->local_offset()]);
+      // for stand alone electrode
+      else
+        values.push_back(bc->ext_circuit()->mna_function(Ve, dt));
+    }
+
+    if( !rows.empty() )
+      VecSetValues(f, rows.size(), &rows[0], &values[0], ADD_VALUES);
+  }
+
+  // the last operator is ADD_VALUES
+  add_value_flag = ADD_VALUES;
+}
+
+
+void BoundaryConditionCollector::electrode_circuit_jacobian(Mat *jac, InsertMode &add_value_flag) const
+{
+  // since we will use ADD_VALUES operat, check the matrix state.
+  if( (add_value_flag != ADD_VALUES) && (add_value_flag != NOT_SET_VALUES) )
+  {
+    MatAssemblyBegin(*jac, MAT_FLUSH_ASSEMBLY);
+    MatAssemblyEnd(*jac, MAT_FLUSH_ASSEMBLY);
+  }
+
+  if( Genius::is_last_processor() )
+  {
+    const PetscScalar dt = SolverSpecify::dt;
+
+    for(unsigned int n=0; n<_bcs.size(); n++)
+    {
+      const BoundaryCondition * bc = _bcs[n];
+      if( !has_circuit_equation(bc) ) continue;
+
+      PetscInt row = bc->global_offset();
+      if( bc->is_inter_connect_bc() )
+      {
+        PetscInt    cols[2]   = { row, bc->inter_connect_hub()->global_offset() };
+        PetscScalar values[2] = { 1.0, -1.0 };
+        MatSetValues(*jac, 1, &row, 2, cols, values, ADD_VALUES);
+      }
+      else
+      {
+        // current driven electrode has nothing here
+        PetscScalar value = bc->ext_circuit()->mna_jacobian(dt);
+        if( value != 0.0 )
+          MatSetValue(*jac, row, row, value, ADD_VALUES);
+      }
+    }
+  }
+
+  // the last operator is ADD_VALUES
+  add_value_flag = ADD_VALUES;
+}
+
+
 void BoundaryConditionCollector::export_boundary_condition ( const std::string& filename ) const
 {
   MESSAGE<<"Write Boundary Condition to file "<< filename << "...\n" << std::endl; RECORD();
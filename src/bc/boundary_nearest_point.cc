@@ -73,6 +73,9 @@ void InsulatorSemiconductorInterfaceBC::_find_nearest_points_in_gate_region()
     if( distance < 1e-6*nm || distance > 30*nm ) continue; // skip adjacent and far away regions
 
 
+    // the nodes near the region, locate their nearest surface in one batch
+    std::vector<unsigned int> query_nodes;
+    std::vector<Point> query_points;
     for(unsigned int n=0; n<nodes.size(); ++n)
     {
       // skip node not on processor
@@ -82,8 +85,20 @@ void InsulatorSemiconductorInterfaceBC::_find_nearest_points_in_gate_region()
       // point is far from boundingbox of region, skip it
       if( MeshTools::minimal_distance(region_bounding_box, p) >  30*nm ) continue;
 
-      Point project_point;
-      std::pair<const Elem*, unsigned int> surface_elem_pair = surface_locator(p, r, project_point, 30*nm);
+      query_nodes.push_back(n);
+      query_points.push_back(p);
+    }
+
+    std::vector< std::pair<const Elem*, unsigned int> > surface_elem_pairs;
+    std::vector<Point> project_points;
+    if( !query_points.empty() )
+      surface_locator(query_points, r, surface_elem_pairs, project_points, 30*nm);
+
+    for(unsigned int q=0; q<query_nodes.size(); ++q)
+    {
+      const unsigned int n = query_nodes[q];
+      const Point & project_point = project_points[q];
+      const std::pair<const Elem*, unsigned int> & surface_elem_pair = surface_elem_pairs[q];
       if( surface_elem_pair.first == NULL ) continue;
 
       // ok, which bc the nearset point on?
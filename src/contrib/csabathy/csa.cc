@@ -360,6 +360,7 @@ namespace CSA
     a->npmax = NPMAX_DEF;
     a->k = K_DEF;
     a->nppc = NPPC_DEF;
+    a->nthreads = 1;
 
     svd_verbose = (csa_verbose > 1) ? 1 : 0;
 
@@ -808,6 +809,7 @@ namespace CSA
         if (!increased)
         {
           increased = 1;
+#pragma omp atomic
           a->nincreased++;
         }
         t->r *= 1.25;
@@ -815,6 +817,7 @@ namespace CSA
       }
       else if (t->npoints > a->npmax)
       {
+#pragma omp atomic
         a->nthinned++;
         thindata(t, a->npmax);
         if (t->npoints > a->npmin)
@@ -1079,6 +1082,7 @@ namespace CSA
     }
     while (!ok);
 
+#pragma omp atomic
     a->norder[q]++;
     s->order = q;
 
@@ -1126,6 +1130,10 @@ namespace CSA
     if (csa_verbose)
       fprintf(stderr, "calculating spline coefficients for primary triangles:\n  ");
 
+    /* the primary triangles are fitted independently, each one only writes
+     * to its own triangle and square, and to the counters of a atomically
+     */
+#pragma omp parallel for schedule(dynamic, 16) num_threads(a->nthreads)
     for (i = 0; i < a->npt; ++i)
     {
       triangle* t = a->pt[i];
@@ -1481,6 +1489,11 @@ namespace CSA
     a->nppc = nppc;
   }
 
+  void csa_setnthreads(csa* a, int nthreads)
+  {
+    a->nthreads = (nthreads > 0) ? nthreads : 1;
+  }
+
 #define BUFSIZE 10240
 #define STRBUFSIZE 64
 #define NALLOCATED_START 1024
@@ -113,6 +113,8 @@ namespace CSA
                                      * value, the higher degree of the locally
                                      * fitted spline (recommended 80 < k < 200) */
     int nppc;                   /* average number of points per cell */
+    int nthreads;               /* number of threads fitting the primary
+                                     * triangles */
   };
 
 
@@ -128,6 +130,7 @@ namespace CSA
   void csa_setnpmax(csa* a, int npmax);
   void csa_setk(csa* a, int k);
   void csa_setnppc(csa* a, int nppc);
+  void csa_setnthreads(csa* a, int nthreads);
 
   void points_read(char* fname, int dim,  int* n, point** points, double** std);
   void parse_commandline(char* arg, int *invY, int *logz, int* invariant, int* square, int* nppc, int* k);
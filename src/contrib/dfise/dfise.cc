@@ -21,13 +21,17 @@
 
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cctype>
 #include <map>
 #include <set>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 #include "dfise_block.h"
 #include "dfise.h"
+#include "mapped_file.h"
 
 #include "config.h"
 #ifdef CYGWIN
@@ -53,6 +57,120 @@ namespace DFISE
 #include "dfise_lex.yy.c"
 #include "dfise_parser.tab.c"
 
+
+  // keywords of the blocks which hold a large array of numbers
+  static bool is_numeric_block(const char *begin, const char *end)
+  {
+    const std::string keyword(begin, end);
+    return keyword == "Vertices" || keyword == "Edges"  || keyword == "Faces" ||
+           keyword == "Elements" || keyword == "Values";
+  }
+
+
+  // move the numbers scanned for the placeholders to their blocks
+  static void fill_numeric_blocks(BLOCK * block, std::vector< std::vector<double> > & arrays)
+  {
+    if(block->_values.size()==1 && block->_values[0]->token_type == TOKEN::string_token)
+    {
+      const std::string & placeholder = *(std::string *)block->_values[0]->value;
+      if(placeholder.compare(0, 10, "__numeric_") == 0)
+      {
+        unsigned int n = atoi(placeholder.c_str()+10);
+        assert(n < arrays.size());
+        block->clear(block->_values);
+        block->_numbers.swap(arrays[n]);
+      }
+    }
+
+    for(unsigned int n=0; n<block->n_sub_blocks(); ++n)
+      fill_numeric_blocks(block->get_sub_block(n), arrays);
+  }
+
+
+  /**
+   * read DF-ISE file into block. the body of numeric blocks, "Vertices (n) {...}" for example,
+   * makes up nearly all of the file. they are scanned directly from the memory mapped file and
+   * replaced by a placeholder, the remaining text, which is small, is parsed by yyparse.
+   */
+  static int parse_dfise_blocks(const std::string & file, BLOCK * block)
+  {
+    MappedFile input(file);
+    if( !input.good() ) return 1;
+
+    std::string text;
+    std::vector< std::vector<double> > arrays;
+
+    const char * end = input.end();
+    const char * copied = input.begin();
+    const char * p = input.begin();
+    while( p < end )
+    {
+      // comment
+      if( *p == '#' ) { p = NumberScan::next_line(p, end); continue; }
+
+      // quoted string
+      if( *p == '"' )
+      {
+        for( ++p; p<end && *p!='"' && *p!='\n'; ) ++p;
+        if( p < end ) ++p;
+        continue;
+      }
+
+      if( !isalpha(*p) && *p!='_' ) { ++p; continue; }
+
+      const char * word = p;
+      while( p<end && (isalnum(*p) || *p=='_' || *p=='.' || *p=='+' || *p=='&') ) ++p;
+      if( !is_numeric_block(word, p) ) continue;
+
+      // keyword (n) {
+      const char * q = NumberScan::skip_space(p, end);
+      if( q==end || *q!='(' ) continue;
+      double size;
+      bool   is_integer;
+      q = NumberScan::read_number(NumberScan::skip_space(q+1, end), end, size, is_integer);
+      if( !q || !is_integer ) continue;
+      q = NumberScan::skip_space(q, end);
+      if( q==end || *q!=')' ) continue;
+      q = NumberScan::skip_space(q+1, end);
+      if( q==end || *q!='{' ) continue;
+      const char * body = q+1;
+
+      // the body should only have numbers, or the block is left to the grammar
+      std::vector<double> values;
+      values.reserve(static_cast<size_t>(size));
+      bool numeric = true;
+      for( q = NumberScan::skip_space(body, end); q<end && *q!='}'; q = NumberScan::skip_space(q, end) )
+      {
+        double value;
+        const char * next = NumberScan::read_number(q, end, value, is_integer);
+        if( !next || (next<end && !isspace(*next) && *next!='}') ) { numeric = false; break; }
+        values.push_back(value);
+        q = next;
+      }
+      if( !numeric || q==end ) continue;
+
+      std::ostringstream placeholder;
+      placeholder << " __numeric_" << arrays.size() << " ";
+      text.append(copied, body);
+      text.append(placeholder.str());
+      copied = p = q;
+
+      arrays.push_back(std::vector<double>());
+      arrays.back().swap(values);
+    }
+    text.append(copied, end);
+
+    yylineno = 1;
+    YY_BUFFER_STATE buffer = yy_scan_bytes(text.c_str(), text.size());
+    int ierr = yyparse(block);
+    yy_delete_buffer(buffer);
+
+    fill_numeric_blocks(block, arrays);
+
+    return ierr;
+  }
+
+
   int DFISE_MESH::parse_dfise(const std::string & file)
   {
     std::string grid_file = file + ".grd";
@@ -128,11 +246,8 @@ namespace DFISE
     // top block
     BLOCK *block= new BLOCK;
 
-    yyin = fopen(grid_file.c_str(), "r");
-    assert( yyin != NULL );
-    assert(!yyparse(block));
-    fclose(yyin);
-    YY_FLUSH_BUFFER;
+    int ierr = parse_dfise_blocks(grid_file, block);
+    assert(!ierr);
 
     for(unsigned int n=0; n<block->n_sub_blocks(); ++n)
     {
@@ -408,11 +523,8 @@ namespace DFISE
 
     BLOCK *block = new BLOCK;
 
-    yyin = fopen(dataset_file.c_str(), "r");
-    assert( yyin != NULL );
-    assert(!yyparse(block));
-    fclose(yyin);
-    YY_FLUSH_BUFFER;
+    int ierr = parse_dfise_blocks(dataset_file, block);
+    assert(!ierr);
 
     for(unsigned int n=0; n<block->n_sub_blocks(); ++n)
     {
@@ -120,6 +120,7 @@ namespace DFISE
       _parameters.clear();
 
       clear(_values);
+      std::vector<double>().swap(_numbers);
 
       for(unsigned int n=0; n<_sub_blocks.size(); ++n)
       {
@@ -184,7 +185,7 @@ namespace DFISE
      */
     unsigned int n_values() const
     {
-      return _values.size();
+      return _numbers.empty() ? _values.size() : _numbers.size();
     }
 
     /**
@@ -227,6 +228,7 @@ namespace DFISE
 
     std::string get_string_value(unsigned int i)
     {
+      assert(_numbers.empty());
       assert(i<_values.size());
       assert(_values[i]->token_type == TOKEN::string_token);
       return *(std::string*)_values[i]->value;
@@ -234,6 +236,11 @@ namespace DFISE
 
     int get_int_value(unsigned int i)
     {
+      if(!_numbers.empty())
+      {
+        assert(i<_numbers.size());
+        return static_cast<int>(_numbers[i]);
+      }
       assert(i<_values.size());
       assert(_values[i]->token_type == TOKEN::int_token);
       return *(int*)_values[i]->value;
@@ -241,6 +248,11 @@ namespace DFISE
 
     double get_float_value(unsigned int i)
     {
+      if(!_numbers.empty())
+      {
+        assert(i<_numbers.size());
+        return _numbers[i];
+      }
       assert(i<_values.size());
       assert(_values[i]->token_type == TOKEN::int_token || _values[i]->token_type == TOKEN::float_token);
       if(_values[i]->token_type == TOKEN::int_token)
@@ -275,6 +287,12 @@ namespace DFISE
      */
     std::vector<TOKEN *>  _values;
 
+    /**
+     * the values of a block which only holds numbers (vertices, elements, dataset values...).
+     * they are scanned directly from file and stored packed, instead of as TOKENs in _values
+     */
+    std::vector<double>  _numbers;
+
     /**
      * the sub blocks
      */
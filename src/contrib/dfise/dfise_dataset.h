@@ -20,9 +20,42 @@
 /********************************************************************************/
 
 
+#include "dfise_format.h"
+
 namespace DFISE
 {
 
+  /**
+   * row formatter of scalar values in DATASET::print
+   */
+  struct ScalarRow
+  {
+    const std::vector<double> & v;
+    ScalarRow(const std::vector<double> & v_) : v(v_) {}
+    void operator() (std::string & buf, unsigned int n) const
+    {
+      buf += "      ";
+      append_real(buf, v[n]);
+      buf += '\n';
+    }
+  };
+
+  /**
+   * row formatter of vector values in DATASET::print
+   */
+  struct VectorRow
+  {
+    const std::vector< std::vector<double> > & v;
+    VectorRow(const std::vector< std::vector<double> > & v_) : v(v_) {}
+    void operator() (std::string & buf, unsigned int n) const
+    {
+      buf += "      ";
+      for(unsigned int d=0; d<v[n].size(); ++d)
+      { append_real(buf, v[n][d]); buf += ' '; }
+      buf += '\n';
+    }
+  };
+
   /**
    * data block of dataset file
    */
@@ -101,20 +134,9 @@ namespace DFISE
       out<<  "    Values (" << n_data << ") {" << std::endl;
       out<< std::scientific << std::setprecision(15);
       if(type == scalar)
-      {
-        for(unsigned int n=0; n<Scalar_Values.size(); ++n)
-          out <<  "      "  << Scalar_Values[n] << std::endl;
-      }
+        write_rows(out, Scalar_Values.size(), ScalarRow(Scalar_Values));
       if(type == vector)
-      {
-        for(unsigned int n=0; n<Vector_Values.size(); ++n)
-        {
-          out <<  "      ";
-          for(unsigned int d=0; d<Vector_Values[n].size(); ++d)
-            out << Vector_Values[n][d] << " ";
-          out<<std::endl;
-        }
-      }
+        write_rows(out, Vector_Values.size(), VectorRow(Vector_Values));
 
       out<<"    }"<< std::endl;
 
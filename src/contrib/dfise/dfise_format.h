@@ -0,0 +1,96 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#ifndef __dfise_format_h__
+#define __dfise_format_h__
+
+#include <cstdio>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+
+#include "genius_env.h"
+
+
+namespace DFISE
+{
+
+  /**
+   * append real value to buf, the same text as std::scientific with precision 15
+   */
+  inline void append_real(std::string & buf, double v)
+  {
+    char s[32];
+    int n = snprintf(s, sizeof(s), "%.15e", v);
+    buf.append(s, n);
+  }
+
+  /**
+   * append integer value to buf
+   */
+  inline void append_int(std::string & buf, long v)
+  {
+    char s[24];
+    char *p = s + sizeof(s);
+    unsigned long u = v < 0 ? 0UL - static_cast<unsigned long>(v) : static_cast<unsigned long>(v);
+    do { *--p = static_cast<char>('0' + u%10); u /= 10; } while(u);
+    if(v < 0) *--p = '-';
+    buf.append(p, s + sizeof(s) - p);
+  }
+
+
+  /**
+   * write the rows [0, n) to out, row i is formatted by f(buf, i) which appends the text to buf.
+   * the rows are formatted in blocks by the threads at the same time, and the blocks are written
+   * in order with one write each, without per line flush. at most one wave of blocks is held in memory
+   */
+  template <typename Formatter>
+  void write_rows(std::ostream & out, unsigned int n, const Formatter & f)
+  {
+    const int block = 4096;
+    const int wave  = 64;
+
+    std::vector<std::string> buffers(wave);
+    for(unsigned int begin=0; begin<n; begin += block*wave)
+    {
+      const int n_blocks = std::min<unsigned int>(wave, (n - begin + block - 1)/block);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(Genius::n_threads())
+      for(int b=0; b<n_blocks; ++b)
+      {
+        std::string & buf = buffers[b];
+        buf.clear();
+        const unsigned int row_begin = begin + b*block;
+        const unsigned int row_end = std::min<unsigned int>(n, row_begin + block);
+        for(unsigned int i=row_begin; i<row_end; ++i)
+          f(buf, i);
+      }
+
+      for(int b=0; b<n_blocks; ++b)
+        out.write(buffers[b].data(), buffers[b].size());
+    }
+  }
+
+}
+
+#endif
@@ -25,6 +25,7 @@
 #include <string>
 #include <algorithm>
 #include "dfise_grid.h"
+#include "dfise_format.h"
 
 //---------------------------------------------------
 // functions for class GRID
@@ -317,6 +318,67 @@ namespace DFISE
   }
 
 
+  namespace
+  {
+    // the row formatters of GRID::print
+
+    struct VertexRow
+    {
+      const std::vector<Point> & v; int dim;
+      VertexRow(const std::vector<Point> & v_, int d) : v(v_), dim(d) {}
+      void operator() (std::string & buf, unsigned int n) const
+      {
+        buf += "   ";
+        for(int d=0; d<dim; ++d)
+        { buf += ' '; append_real(buf, v[n].coords[d]); }
+        buf += '\n';
+      }
+    };
+
+    struct EdgeRow
+    {
+      const std::vector< std::pair<int, int> > & e;
+      EdgeRow(const std::vector< std::pair<int, int> > & e_) : e(e_) {}
+      void operator() (std::string & buf, unsigned int n) const
+      {
+        buf += "    ";
+        append_int(buf, e[n].first);
+        buf += ' ';
+        append_int(buf, e[n].second);
+        buf += '\n';
+      }
+    };
+
+    struct FaceRow
+    {
+      const std::vector< std::vector<int> > & f;
+      FaceRow(const std::vector< std::vector<int> > & f_) : f(f_) {}
+      void operator() (std::string & buf, unsigned int n) const
+      {
+        buf += "    ";
+        append_int(buf, f[n].size());
+        for(unsigned int e=0; e<f[n].size(); ++e)
+        { buf += ' '; append_int(buf, f[n][e]); }
+        buf += '\n';
+      }
+    };
+
+    struct ElementRow
+    {
+      const std::vector<Element> & el;
+      ElementRow(const std::vector<Element> & el_) : el(el_) {}
+      void operator() (std::string & buf, unsigned int n) const
+      {
+        buf += "    ";
+        append_int(buf, el[n].elem_code);
+        for(unsigned int f=0; f<el[n].faces.size(); ++f)
+        { buf += ' '; append_int(buf, el[n].faces[f]); }
+        buf += '\n';
+      }
+    };
+  }
+
+
   void GRID::print( std::ostream & out ) const
   {
     out<<"Data {" << std::endl;
@@ -333,36 +395,21 @@ namespace DFISE
 
     // print vertices
     out<<"  Vertices (" << Vertices.size() << ") {" <<std::endl;
-    if(dimension==2)
-    {
-      for(unsigned int n=0; n<Vertices.size(); n++)
-        out<< "    " << Vertices[n].coords[0] << " " << Vertices[n].coords[1] << std::endl;
-    }
-    if(dimension==3)
-    {
-      for(unsigned int n=0; n<Vertices.size(); n++)
-        out<< "    " << Vertices[n].coords[0] << " " << Vertices[n].coords[1] << " " << Vertices[n].coords[2] << std::endl;
-    }
+    if(dimension==2 || dimension==3)
+      write_rows(out, Vertices.size(), VertexRow(Vertices, dimension));
     out<<"  }" << std::endl;
     out << std::endl;
 
     // print edges
     out<<"  Edges (" << Edges.size() << ") {" << std::endl;
-    for(unsigned int n=0; n<Edges.size(); n++)
-      out<< "    " << Edges[n].first << " " << Edges[n].second << std::endl;
+    write_rows(out, Edges.size(), EdgeRow(Edges));
     out<<"  }" << std::endl;
     out << std::endl;
 
     if(dimension==3)
     {
       out<<"  Faces (" << Faces.size() << ") {" << std::endl;
-      for(unsigned int n=0; n<Faces.size(); n++)
-      {
-        out<< "    " << Faces[n].size();
-        for(unsigned int e=0; e<Faces[n].size(); ++e)
-          out<< " " << Faces[n][e] ;
-        out << std::endl;
-      }
+      write_rows(out, Faces.size(), FaceRow(Faces));
       out<<"  }" << std::endl;
       out << std::endl;
     }
@@ -387,14 +434,7 @@ namespace DFISE
 
     // print element
     out<<"  Elements (" << Elements.size() << ") {" << std::endl;
-    for(unsigned int n=0; n<Elements.size(); n++)
-    {
-      const Element & elem = Elements[n];
-      out<< "    " << elem.elem_code;
-      for(unsigned int f=0; f<elem.faces.size(); ++f)
-        out<< " " << elem.faces[f];
-      out << std::endl;
-    }
+    write_rows(out, Elements.size(), ElementRow(Elements));
     out<<"  }" << std::endl;
     out << std::endl;
 
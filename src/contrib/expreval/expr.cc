@@ -11,6 +11,7 @@
 #include "expr_parser.h"
 #include "expr_node.h"
 #include "expr_except.h"
+#include "expr_program.h"
 
 using namespace std;
 using namespace ExprEval;
@@ -150,4 +151,18 @@ double Expression::Evaluate()
         throw(EmptyExpressionException());
         }    
     }
+
+// Compile expression
+void Expression::Compile(Program &program)
+    {
+    if(m_expr)
+        {
+        program.Clear();
+        m_expr->Compile(program);
+        }
+    else
+        {
+        throw(EmptyExpressionException());
+        }
+    }
             
@@ -18,6 +18,7 @@ namespace ExprEval
     class FunctionList;
     class DataList;
     class Node;
+    class Program;
     
     // Expression class
     //--------------------------------------------------------------------------
@@ -52,6 +53,9 @@ namespace ExprEval
             
             // Evaluate expression
             double Evaluate();
+
+            // Compile expression into a program
+            void Compile(Program &program);
             
         protected:
             ValueList *m_vlist;
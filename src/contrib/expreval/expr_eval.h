@@ -12,6 +12,7 @@
 #include "expr_datalist.h"
 #include "expr.h"
 #include "expr_node.h"
+#include "expr_program.h"
 #include "expr_parser.h"
 #include "expr_except.h"
 
@@ -19,6 +19,7 @@
 #include "expr_funclist.h"
 #include "expr_node.h"
 #include "expr_except.h"
+#include "expr_program.h"
 
 using namespace std;
 using namespace ExprEval;
@@ -36,6 +37,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, fabs);
+                }
+
             double DoEvaluate()
                 {
                 return fabs(m_nodes[0]->Evaluate());
@@ -253,6 +259,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, sqrt);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -290,6 +301,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, sin);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -327,6 +343,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, cos);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -364,6 +385,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, tan);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -401,6 +427,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, sinh);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -438,6 +469,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, cosh);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -475,6 +511,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, tanh);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -512,6 +553,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, asin);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -549,6 +595,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, acos);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -586,6 +637,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, atan);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -773,6 +829,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, log10);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -810,6 +871,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, log);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -847,6 +913,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, exp);
+                }
+
             double DoEvaluate()
                 {
                 errno = 0;
@@ -1036,6 +1107,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, ceil);
+                }
+
             double DoEvaluate()
                 {
                 return ceil(m_nodes[0]->Evaluate());
@@ -1066,6 +1142,11 @@ namespace
                 SetArgumentCount(1, 1, 0, 0);
                 }
 
+            void Compile(Program &program)
+                {
+                CompileCall(program, floor);
+                }
+
             double DoEvaluate()
                 {
                 return floor(m_nodes[0]->Evaluate());
@@ -16,6 +16,7 @@
 #include "expr_funclist.h"
 #include "expr_datalist.h"
 #include "expr_except.h"
+#include "expr_program.h"
 
 using namespace std;
 using namespace ExprEval;
@@ -43,6 +44,12 @@ double Node::Evaluate()
     return DoEvaluate();
     }
 
+// Compile
+void Node::Compile(Program &program)
+    {
+    program.CallNode(this);
+    }
+
 // Function node
 //------------------------------------------------------------------------------
 
@@ -70,6 +77,13 @@ string FunctionNode::GetName() const
     return m_factory->GetName();
     }
 
+// Compile the function of one argument
+void FunctionNode::CompileCall(Program &program, double (*func)(double))
+    {
+    m_nodes[0]->Compile(program);
+    program.Call(func, GetName());
+    }
+
 // Set argument count
 void FunctionNode::SetArgumentCount(long argMin, long argMax, long refMin, long refMax,
         long dataMin, long dataMax)
@@ -368,6 +382,22 @@ double MultiNode::DoEvaluate()
     return result;
     }
 
+// Compile
+void MultiNode::Compile(Program &program)
+    {
+    vector<Node*>::size_type pos;
+
+    if(m_nodes.empty())
+        program.Const(0.0);
+
+    for(pos = 0; pos < m_nodes.size(); pos++)
+        {
+        if(pos)
+            program.Pop();
+        m_nodes[pos]->Compile(program);
+        }
+    }
+
 // Parse
 void MultiNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -475,6 +505,13 @@ double AssignNode::DoEvaluate()
     return (*m_var = m_rhs->Evaluate());
     }
 
+// Compile
+void AssignNode::Compile(Program &program)
+    {
+    m_rhs->Compile(program);
+    program.Store(m_var);
+    }
+
 // Parse
 void AssignNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -563,6 +600,14 @@ double AddNode::DoEvaluate()
     return m_lhs->Evaluate() + m_rhs->Evaluate();
     }
 
+// Compile
+void AddNode::Compile(Program &program)
+    {
+    m_lhs->Compile(program);
+    m_rhs->Compile(program);
+    program.Op(Program::OP_ADD);
+    }
+
 // Parse
 void AddNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -607,6 +652,14 @@ double SubtractNode::DoEvaluate()
     return m_lhs->Evaluate() - m_rhs->Evaluate();
     }
 
+// Compile
+void SubtractNode::Compile(Program &program)
+    {
+    m_lhs->Compile(program);
+    m_rhs->Compile(program);
+    program.Op(Program::OP_SUB);
+    }
+
 // Parse
 void SubtractNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -651,6 +704,14 @@ double MultiplyNode::DoEvaluate()
     return m_lhs->Evaluate() * m_rhs->Evaluate();
     }
 
+// Compile
+void MultiplyNode::Compile(Program &program)
+    {
+    m_lhs->Compile(program);
+    m_rhs->Compile(program);
+    program.Op(Program::OP_MUL);
+    }
+
 // Parse
 void MultiplyNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -704,6 +765,14 @@ double DivideNode::DoEvaluate()
         }
     }
 
+// Compile
+void DivideNode::Compile(Program &program)
+    {
+    m_lhs->Compile(program);
+    m_rhs->Compile(program);
+    program.Op(Program::OP_DIV);
+    }
+
 // Parse
 void DivideNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -747,6 +816,13 @@ double NegateNode::DoEvaluate()
     return -(m_rhs->Evaluate());
     }
 
+// Compile
+void NegateNode::Compile(Program &program)
+    {
+    m_rhs->Compile(program);
+    program.Op(Program::OP_NEG);
+    }
+
 // Parse
 void NegateNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -796,6 +872,14 @@ double ExponentNode::DoEvaluate()
     return result;
     }
 
+// Compile
+void ExponentNode::Compile(Program &program)
+    {
+    m_lhs->Compile(program);
+    m_rhs->Compile(program);
+    program.Op(Program::OP_POW);
+    }
+
 // Parse
 void ExponentNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -837,6 +921,12 @@ double VariableNode::DoEvaluate()
     return *m_var;
     }
 
+// Compile
+void VariableNode::Compile(Program &program)
+    {
+    program.Var(m_var);
+    }
+
 // Parse
 void VariableNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
@@ -907,6 +997,12 @@ double ValueNode::DoEvaluate()
     return m_val;
     }
 
+// Compile
+void ValueNode::Compile(Program &program)
+    {
+    program.Const(m_val);
+    }
+
 // Parse
 void ValueNode::Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
         Parser::size_type v1)
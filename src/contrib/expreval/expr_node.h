@@ -19,6 +19,7 @@ namespace ExprEval
     class Expression;
     class FunctionFactory;
     class DataEntry;
+    class Program;
 
     // Node class
     //--------------------------------------------------------------------------
@@ -34,6 +35,9 @@ namespace ExprEval
 
             double Evaluate(); // Calls Expression::TestAbort, then DoEvaluate
 
+            // Compile the node into program, default calls the node itself
+            virtual void Compile(Program &program);
+
         protected:
             Expression *m_expr;
         };
@@ -71,6 +75,9 @@ namespace ExprEval
             // Function name (using factory)
             ::std::string GetName() const;
 
+            // Compile the function of one argument into program
+            void CompileCall(Program &program, double (*func)(double));
+
             // Normal, reference, and data parameters
             ::std::vector<Node*> m_nodes;
             ::std::vector<double*> m_refs;
@@ -90,6 +97,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            void Compile(Program &program);
 
         private:
             ::std::vector<Node*> m_nodes;
@@ -106,6 +114,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            void Compile(Program &program);
 
         private:
             double *m_var;
@@ -123,6 +132,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            void Compile(Program &program);
 
         private:
             Node *m_lhs;
@@ -140,6 +150,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            void Compile(Program &program);
 
         private:
             Node *m_lhs;
@@ -157,6 +168,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            void Compile(Program &program);
 
         private:
             Node *m_lhs;
@@ -174,6 +186,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            void Compile(Program &program);
 
         private:
             Node *m_lhs;
@@ -191,6 +204,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            void Compile(Program &program);
 
         private:
             Node *m_rhs;
@@ -207,6 +221,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            void Compile(Program &program);
 
         private:
             Node *m_lhs;
@@ -224,6 +239,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            void Compile(Program &program);
 
         private:
             double *m_var;
@@ -240,6 +256,7 @@ namespace ExprEval
             double DoEvaluate();
             void Parse(Parser &parser, Parser::size_type start, Parser::size_type end,
                     Parser::size_type v1 = 0);
+            void Compile(Program &program);
 
         private:
             double m_val;
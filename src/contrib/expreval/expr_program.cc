@@ -0,0 +1,250 @@
+// File:    expr_program.cc
+// Purpose: Flat stack bytecode compiled from the expression node tree
+//------------------------------------------------------------------------------
+
+
+// Includes
+#include <cmath>
+#include <cerrno>
+#include <algorithm>
+
+#include "expr_program.h"
+#include "expr_node.h"
+#include "expr_except.h"
+
+using namespace std;
+using namespace ExprEval;
+
+// Points evaluated together by the block evaluation
+static const size_t block_size = 64;
+
+// Program
+//------------------------------------------------------------------------------
+
+// Constructor
+Program::Program() : m_depth(0), m_maxdepth(0), m_serial(false)
+    {
+    }
+
+// Clear
+void Program::Clear()
+    {
+    m_code.clear();
+    m_names.clear();
+    m_depth = 0;
+    m_maxdepth = 0;
+    m_serial = false;
+    }
+
+bool Program::Empty() const
+    {
+    return m_code.empty();
+    }
+
+// Emit an instruction, which changes the stack depth by depth
+void Program::Emit(const Instruction &ins, long depth)
+    {
+    m_code.push_back(ins);
+    m_depth += depth;
+    m_maxdepth = max(m_maxdepth, m_depth);
+    }
+
+void Program::Const(double value)
+    {
+    Instruction ins = {OP_CONST, value, 0, 0, 0, 0};
+    Emit(ins, 1);
+    }
+
+void Program::Var(double *var)
+    {
+    Instruction ins = {OP_VAR, 0.0, var, 0, 0, 0};
+    Emit(ins, 1);
+    }
+
+void Program::Store(double *var)
+    {
+    Instruction ins = {OP_STORE, 0.0, var, 0, 0, 0};
+    Emit(ins, 0);
+    m_serial = true;
+    }
+
+void Program::Pop()
+    {
+    Instruction ins = {OP_POP, 0.0, 0, 0, 0, 0};
+    Emit(ins, -1);
+    }
+
+void Program::Op(OpCode op)
+    {
+    Instruction ins = {op, 0.0, 0, 0, 0, 0};
+    Emit(ins, op == OP_NEG ? 0 : -1);
+    }
+
+void Program::Call(double (*func)(double), const string &name)
+    {
+    m_names.push_back(name);
+    Instruction ins = {OP_CALL, 0.0, 0, func, 0, m_names.size()-1};
+    Emit(ins, 0);
+    }
+
+void Program::CallNode(Node *node)
+    {
+    Instruction ins = {OP_NODE, 0.0, 0, 0, node, 0};
+    Emit(ins, 1);
+    m_serial = true;
+    }
+
+// Evaluate with current variable values
+double Program::Run() const
+    {
+    if(m_code.empty())
+        throw(EmptyExpressionException());
+
+    m_stack.resize(m_maxdepth);
+    double *stack = &m_stack[0];
+    long top = -1;
+
+    vector<Instruction>::const_iterator it = m_code.begin();
+    for(; it != m_code.end(); ++it)
+        {
+        switch(it->op)
+            {
+            case OP_CONST : stack[++top] = it->value; break;
+            case OP_VAR   : stack[++top] = *(it->var); break;
+            case OP_STORE : *(it->var) = stack[top]; break;
+            case OP_POP   : --top; break;
+            case OP_ADD   : stack[top-1] += stack[top]; --top; break;
+            case OP_SUB   : stack[top-1] -= stack[top]; --top; break;
+            case OP_MUL   : stack[top-1] *= stack[top]; --top; break;
+            case OP_DIV   :
+                if(stack[top] == 0.0)
+                    throw(DivideByZeroException());
+                stack[top-1] /= stack[top]; --top;
+                break;
+            case OP_NEG   : stack[top] = -stack[top]; break;
+            case OP_POW   :
+                errno = 0;
+                stack[top-1] = pow(stack[top-1], stack[top]); --top;
+                if(errno)
+                    throw(MathException("^"));
+                break;
+            case OP_CALL  :
+                errno = 0;
+                stack[top] = it->func(stack[top]);
+                if(errno)
+                    throw(MathException(m_names[it->name]));
+                break;
+            case OP_NODE  : stack[++top] = it->node->Evaluate(); break;
+            }
+        }
+
+    return stack[top];
+    }
+
+// Evaluate at n points
+void Program::Run(size_t n, const vector<double*> &vars, const vector<const double*> &values, double *out) const
+    {
+    if(m_code.empty())
+        throw(EmptyExpressionException());
+
+    // the variables are read by the node tree or changed by assignment,
+    // evaluate point by point
+    if(m_serial)
+        {
+        for(size_t i = 0; i < n; ++i)
+            {
+            for(size_t k = 0; k < vars.size(); ++k)
+                *(vars[k]) = values[k][i];
+            out[i] = Run();
+            }
+        return;
+        }
+
+    // the input array of each variable instruction, 0 for the variable not in vars
+    vector<const double*> input(m_code.size(), static_cast<const double*>(0));
+    for(size_t c = 0; c < m_code.size(); ++c)
+        if(m_code[c].op == OP_VAR)
+            {
+            vector<double*>::const_iterator v = find(vars.begin(), vars.end(), m_code[c].var);
+            if(v != vars.end())
+                input[c] = values[v - vars.begin()];
+            }
+
+    // every stack entry holds one block of points
+    m_stack.resize(m_maxdepth*block_size);
+    double *stack = &m_stack[0];
+
+    for(size_t begin = 0; begin < n; begin += block_size)
+        {
+        const size_t m = min(block_size, n - begin);
+        long top = -1;
+
+        errno = 0;
+        for(size_t c = 0; c < m_code.size(); ++c)
+            {
+            const Instruction &ins = m_code[c];
+            double *a = 0, *b = 0;
+            switch(ins.op)
+                {
+                case OP_CONST :
+                    a = stack + (++top)*block_size;
+                    for(size_t i = 0; i < m; ++i) a[i] = ins.value;
+                    break;
+                case OP_VAR   :
+                    a = stack + (++top)*block_size;
+                    if(input[c])
+                        {
+                        const double *x = input[c] + begin;
+                        for(size_t i = 0; i < m; ++i) a[i] = x[i];
+                        }
+                    else
+                        {
+                        const double x = *(ins.var);
+                        for(size_t i = 0; i < m; ++i) a[i] = x;
+                        }
+                    break;
+                case OP_POP   : --top; break;
+                case OP_ADD   :
+                    b = stack + (top--)*block_size; a = b - block_size;
+                    for(size_t i = 0; i < m; ++i) a[i] += b[i];
+                    break;
+                case OP_SUB   :
+                    b = stack + (top--)*block_size; a = b - block_size;
+                    for(size_t i = 0; i < m; ++i) a[i] -= b[i];
+                    break;
+                case OP_MUL   :
+                    b = stack + (top--)*block_size; a = b - block_size;
+                    for(size_t i = 0; i < m; ++i) a[i] *= b[i];
+                    break;
+                case OP_DIV   :
+                    b = stack + (top--)*block_size; a = b - block_size;
+                    for(size_t i = 0; i < m; ++i)
+                        if(b[i] == 0.0)
+                            throw(DivideByZeroException());
+                    for(size_t i = 0; i < m; ++i) a[i] /= b[i];
+                    break;
+                case OP_NEG   :
+                    a = stack + top*block_size;
+                    for(size_t i = 0; i < m; ++i) a[i] = -a[i];
+                    break;
+                case OP_POW   :
+                    b = stack + (top--)*block_size; a = b - block_size;
+                    for(size_t i = 0; i < m; ++i) a[i] = pow(a[i], b[i]);
+                    if(errno)
+                        throw(MathException("^"));
+                    break;
+                case OP_CALL  :
+                    a = stack + top*block_size;
+                    for(size_t i = 0; i < m; ++i) a[i] = ins.func(a[i]);
+                    if(errno)
+                        throw(MathException(m_names[ins.name]));
+                    break;
+                default : break; // serial instructions
+                }
+            }
+
+        const double *result = stack + top*block_size;
+        for(size_t i = 0; i < m; ++i)
+            out[begin+i] = result[i];
+        }
+    }
@@ -0,0 +1,100 @@
+// File:    expr_program.h
+// Purpose: Flat stack bytecode compiled from the expression node tree
+//------------------------------------------------------------------------------
+
+
+#ifndef __EXPREVAL_PROGRAM_H
+#define __EXPREVAL_PROGRAM_H
+
+// Includes
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Part of expreval namespace
+namespace ExprEval
+    {
+    // Forward declarations
+    class Node;
+
+    // Program class
+    //--------------------------------------------------------------------------
+    // The node tree is compiled into postfix instructions of a stack machine.
+    // Arithmetic and the common math functions are executed in place, other
+    // function nodes are called through their Evaluate().  The program can be
+    // evaluated over blocks of points, with a set of variables taking the
+    // values of arrays.
+    class Program
+        {
+        public:
+            enum OpCode
+                {
+                OP_CONST,   // push constant
+                OP_VAR,     // push variable
+                OP_STORE,   // store top in variable, keep top
+                OP_POP,     // drop top
+                OP_ADD,
+                OP_SUB,
+                OP_MUL,
+                OP_DIV,
+                OP_NEG,
+                OP_POW,
+                OP_CALL,    // call math function of one argument on top
+                OP_NODE     // push the value of node tree
+                };
+
+            Program();
+
+            // Clear the program
+            void Clear();
+            bool Empty() const;
+
+            // Emit instructions
+            void Const(double value);
+            void Var(double *var);
+            void Store(double *var);
+            void Pop();
+            void Op(OpCode op);
+            void Call(double (*func)(double), const ::std::string &name);
+            void CallNode(Node *node);
+
+            // Evaluate the program with current variable values
+            double Run() const;
+
+            // Evaluate the program at n points. variable vars[k] takes the values
+            // of array values[k], the result is written in out
+            void Run(::std::size_t n, const ::std::vector<double*> &vars,
+                    const ::std::vector<const double*> &values, double *out) const;
+
+        private:
+            struct Instruction
+                {
+                OpCode op;
+                double value;
+                double *var;
+                double (*func)(double);
+                Node *node;
+                ::std::size_t name;
+                };
+
+            ::std::vector<Instruction> m_code;
+
+            // Names of called functions, for math exception
+            ::std::vector< ::std::string> m_names;
+
+            // Current and max stack depth
+            long m_depth;
+            long m_maxdepth;
+
+            // Program has assignment or node call, can not be evaluated by blocks
+            bool m_serial;
+
+            // Stack buffer
+            mutable ::std::vector<double> m_stack;
+
+            void Emit(const Instruction &ins, long depth);
+        };
+
+    } // namespace ExprEval
+
+#endif // __EXPREVAL_PROGRAM_H
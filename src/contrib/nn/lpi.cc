@@ -116,16 +116,32 @@ namespace NN
   void lpi_interpolate_point(lpi* l, point* p)
   {
     delaunay* d = l->d;
-    int tid = delaunay_xytoi(d, p, d->first_id);
+    int tid = lpi_interpolate_point_seed(l, p, d->first_id);
+    if (tid >= 0)
+      d->first_id = tid;
+  }
+
+  /* Finds linearly interpolated value in a point, without modifying the
+   * interpolator.
+   *
+   * @param l Linear interpolation
+   * @param p Point to be interpolated (p->x, p->y -- input; p->z -- output)
+   * @param seed Triangle to start the search from
+   * @return The triangle holding p, or -1
+   */
+  int lpi_interpolate_point_seed(lpi* l, point* p, int seed)
+  {
+    delaunay* d = l->d;
+    int tid = delaunay_xytoi(d, p, seed);
     if (tid >= 0)
     {
       lweights* lw = &l->weights[tid];
 
-      d->first_id = tid;
       p->z = p->x * lw->w[0] + p->y * lw->w[1] + lw->w[2];
     }
     else
       p->z = 0.0;
+    return tid;
   }
 
   /* Linearly interpolates data in an array of points.
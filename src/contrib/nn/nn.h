@@ -94,6 +94,17 @@ namespace NN
    */
   void lpi_interpolate_point(lpi* l, point* p);
 
+  /** Finds linearly interpolated value in a point, starting the triangle
+   * search from triangle `seed'. It does not modify the interpolator, so it
+   * can be called by several threads at once.
+   *
+   * @param l Linear interpolation
+   * @param p Point to be interpolated (p->x, p->y -- input; p->z -- output)
+   * @param seed Triangle to start the search from
+   * @return The triangle holding p, or -1 when p is outside the convex hull
+   */
+  int lpi_interpolate_point_seed(lpi* l, point* p, int seed);
+
   /** Linearly interpolates data in an array of points.
    *
    * @param nin Number of input points
@@ -414,6 +414,13 @@ namespace TIF
   extern FILE * yyin;
   extern int yyparse();
 
+  /**
+   * read tif file. the numeric records, which are the bulk of the file, are scanned
+   * directly from the memory mapped file, the others are parsed by yyparse.
+   * @return 0 on success
+   */
+  extern int parse(const std::string & file);
+
   //  the parser will fill data into these structure
   extern std::vector<Node_t>        node_array;
   extern std::vector<Edge_t>        edge_array;
@@ -23,8 +23,10 @@
 
 #include <cstdio>
 #include <cstring>
+#include <cctype>
 
 #include "tif_data.h"
+#include "mapped_file.h"
 
 // avoid isatty() problem of Bison 2.3
 #include "config.h"
@@ -59,6 +61,190 @@ namespace TIF
   }
 
 
+  // a number of numeric record should be followed by blank, comment or end of line
+  static const char * record_field(const char *p, const char *eol)
+  {
+    if( p==0 || p==eol ) return p;
+    if( *p==' ' || *p=='\t' || *p=='\r' || *p=='\n' || *p=='#' ) return p;
+    return 0;
+  }
+
+  static const char * record_int(const char *p, const char *eol, int &value)
+  {
+    p = NumberScan::skip_blank(p, eol);
+    return record_field(NumberScan::read_int(p, eol, value), eol);
+  }
+
+  static const char * record_real(const char *p, const char *eol, double &value)
+  {
+    p = NumberScan::skip_blank(p, eol);
+    return record_field(NumberScan::read_real(p, eol, value), eol);
+  }
+
+
+  /**
+   * scan the fields of a numeric record, which starts with \p key, in [p, eol).
+   * it does the same as the grammar rules of these records.
+   * @return false when the record is not recognized
+   */
+  static bool parse_numeric_record(char key, const char *p, const char *eol)
+  {
+    switch(key)
+    {
+    case 'c':
+      {
+        Node_t node;
+        if( !(p = record_int(p, eol, node.index)) ) return false;
+        if( !(p = record_real(p, eol, node.x)) ) return false;
+        if( !(p = record_real(p, eol, node.y)) ) return false;
+        if( !(p = record_real(p, eol, node.h)) ) return false;
+        node.index -= 1;
+        node_array.push_back(node);
+        break;
+      }
+    case 'e':
+      {
+        int index, point1, point2, bcode;
+        if( !(p = record_int(p, eol, index)) ) return false;
+        if( !(p = record_int(p, eol, point1)) ) return false;
+        if( !(p = record_int(p, eol, point2)) ) return false;
+        if( !(p = record_int(p, eol, bcode)) ) return false;
+        Edge_t edge;
+        edge.index  = index-1;
+        edge.point1 = point1 < point2 ? point1-1 : point2-1 ;
+        edge.point2 = point1 > point2 ? point1-1 : point2-1 ;
+        edge.bcode  = bcode;
+        edge.bc_index = -1024;
+        edge_array.push_back(edge);
+        break;
+      }
+    case 't':
+      {
+        int v[8];
+        for(unsigned int i=0; i<8; ++i)
+          if( !(p = record_int(p, eol, v[i])) ) return false;
+        Tri_t tri;
+        tri.index = v[0]-1;
+        tri.region = v[1]-1;
+        tri.c1 = v[2]-1;
+        tri.c2 = v[3]-1;
+        tri.c3 = v[4]-1;
+        tri.t1 = v[5]-1;
+        tri.t2 = v[6]-1;
+        tri.t3 = v[7]-1;
+        if(tri.c1==-1 || tri.c2==-1 || tri.c3==-1)
+        {
+          printf("Warning, degradation triangle meet at index %d. Ignored.\n",tri.index);
+        }
+        else
+          tri_array.push_back(tri);
+        break;
+      }
+    case 'q':
+      {
+        int v[6];
+        for(unsigned int i=0; i<6; ++i)
+          if( !(p = record_int(p, eol, v[i])) ) return false;
+        Quad_t quad;
+        quad.index = v[0]-1;
+        quad.region = v[1]-1;
+        quad.c1 = v[2]-1;
+        quad.c2 = v[3]-1;
+        quad.c3 = v[4]-1;
+        quad.c4 = v[5]-1;
+        quad_array.push_back(quad);
+        break;
+      }
+    case 'n':
+      {
+        SolData_t data;
+        if( !(p = record_int(p, eol, data.index)) ) return false;
+        data.index -= 1;
+
+        // material name
+        p = NumberScan::skip_blank(p, eol);
+        const char * name = p;
+        while( p<eol && !isspace(*p) ) ++p;
+        if( p==name || !(isalpha(*name) || *name=='_') ) return false;
+        data.material.assign(name, p);
+
+        sol_data.push_back(data);
+        std::vector<double> & values = sol_data.back().data_array;
+        values.reserve(sol_head.sol_num > 0 ? sol_head.sol_num : 0);
+        while(true)
+        {
+          p = NumberScan::skip_blank(p, eol);
+          if( p==eol || *p=='\n' || *p=='#' ) break;
+          double value;
+          if( !(p = record_real(p, eol, value)) ) { sol_data.pop_back(); return false; }
+          values.push_back(value);
+        }
+        if( values.empty() ) { sol_data.pop_back(); return false; }
+        break;
+      }
+    default: return false;
+    }
+
+    // nothing else in the record
+    p = NumberScan::skip_blank(p, eol);
+    return p==eol || *p=='\n' || *p=='#';
+  }
+
+
+  int parse(const std::string & file)
+  {
+    MappedFile input(file);
+    if( !input.good() ) return 1;
+
+    // the records left to the grammar
+    std::string records;
+
+    const char * end = input.end();
+    bool continued = false;
+    int  line_no = 1;
+    for(const char * line = input.begin(); line < end; ++line_no)
+    {
+      const char * eol = NumberScan::next_line(line, end);
+      const char * p = NumberScan::skip_blank(line, eol);
+
+      // the record key is a single char followed by blank
+      const char key = p+1<eol ? tolower(*p) : 0;
+      const bool numeric = !continued && key && strchr("cetqn", key) && (p[1]==' ' || p[1]=='\t');
+
+      if( numeric )
+      {
+        if( !parse_numeric_record(key, p+1, eol) )
+        {
+          printf("\nline %d unrecognized record\n", line_no);
+          return 1;
+        }
+      }
+      else
+      {
+        records.append(line, eol);
+
+        // a line ends with '+' is continued by the next line
+        const char * q = eol;
+        if( q>line && q[-1]=='\n' ) --q;
+        while( q>line && (q[-1]==' ' || q[-1]=='\t') ) --q;
+        continued = (q>line && q[-1]=='+');
+      }
+
+      line = eol;
+    }
+
+    if( records.empty() ) return 0;
+    if( records[records.size()-1] != '\n' ) records.push_back('\n');
+
+    yylineno = 1;
+    YY_BUFFER_STATE buffer = yy_scan_bytes(records.c_str(), records.size());
+    int ierr = yyparse();
+    yy_delete_buffer(buffer);
+
+    return ierr;
+  }
+
+
 
 }
 
@@ -20,10 +20,10 @@
 /********************************************************************************/
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <cctype>
 
 #include "tif3d.h"
+#include "mapped_file.h"
 
 
 //stuff for the TIF3D read write
@@ -35,32 +35,67 @@ TIF3D::TIF3D(const std::string & file) : _file(file)
 }
 
 
+namespace
+{
+  // read a word of non-space chars
+  const char * read_word(const char *p, const char *end, std::string &word)
+  {
+    p = NumberScan::skip_space(p, end);
+    const char * begin = p;
+    while( p<end && !isspace(*p) ) ++p;
+    if( p==begin ) return 0;
+    word.assign(begin, p);
+    return p;
+  }
+
+  const char * read_int(const char *p, const char *end, int &value)
+  {
+    p = NumberScan::skip_space(p, end);
+    return NumberScan::read_int(p, end, value);
+  }
+
+  const char * read_real(const char *p, const char *end, double &value)
+  {
+    p = NumberScan::skip_space(p, end);
+    return NumberScan::read_real(p, end, value);
+  }
+}
+
+
 int TIF3D::read()
 {
-  std::ifstream ctmp(_file.c_str(), std::ios::in);
+  MappedFile input(_file);
 
-  if (!ctmp.good())
+  if (!input.good())
   {
     std::cerr<<"Open TIF3D file error."<<std::endl;
     return 1;
   }
 
-
-  char flag;
-  while(ctmp >> flag)
+  // the file is scanned record by record from memory, the fields of a
+  // record are read in sequence, each record begins on a new line
+  const char * end = input.end();
+  for(const char * p = input.begin(); p < end; )
   {
+    p = NumberScan::skip_space(p, end);
+    if( p == end ) break;
+
+    const char flag = *p++;
+    const char * eol = NumberScan::next_line(p, end);
+
+    bool ok = true;
 
     if (flag == 'H' || flag == 'h')
     {
       // skip tif file header
-      std::string buf;
-      std::getline(ctmp, buf);
+      std::string buf(p, eol);
 
       if( buf.find("V1.1") == std::string::npos )
       {
         std::cerr<<"TIF3D should have version >= 1.1"<<std::endl;
         return 1;
       }
+      p = eol;
     }
 
 
@@ -68,68 +103,69 @@ int TIF3D::read()
     else if (flag == 'C' || flag == 'c')
     {
       Node_t node;
-      ctmp >> node.index >> node.x >> node.y >> node.z;
+      ok = (p = read_int(p, end, node.index)) && (p = read_real(p, end, node.x)) &&
+           (p = read_real(p, end, node.y))    && (p = read_real(p, end, node.z));
       // save it
-      _nodes.push_back(node);
+      if( ok ) _nodes.push_back(node);
     }
 
     // face
     else if (flag == 'F' || flag == 'f')
     {
       Face_t f;
-      ctmp >> f.index >> f.point1 >> f.point2 >> f.point3 >> f.bc_index;
+      ok = (p = read_int(p, end, f.index))  && (p = read_int(p, end, f.point1)) &&
+           (p = read_int(p, end, f.point2)) && (p = read_int(p, end, f.point3)) &&
+           (p = read_int(p, end, f.bc_index));
       // save it
-      _faces.push_back(f);
+      if( ok ) _faces.push_back(f);
     }
 
 
     // tet
     else if (flag == 'T' || flag == 't')
     {
-      std::string buf;
-      std::getline(ctmp, buf);
-      std::stringstream ss(buf);
-
       Tet_t t;
-      ss >> t.index >> t.region >> t.c1 >> t.c2 >> t.c3 >> t.c4;
+      ok = (p = read_int(p, eol, t.index)) && (p = read_int(p, eol, t.region)) &&
+           (p = read_int(p, eol, t.c1))    && (p = read_int(p, eol, t.c2))     &&
+           (p = read_int(p, eol, t.c3))    && (p = read_int(p, eol, t.c4));
       // save it
-      _tets.push_back(t);
+      if( ok ) _tets.push_back(t);
+      p = eol;
     }
 
 
     //region
     else if (flag == 'R' || flag == 'r')
     {
-      std::string buf;
-      std::getline(ctmp, buf);
-      std::stringstream ss(buf);
-
       Region_t region;
-      ss >> region.index >> region.material >> region.name;
+      ok = (p = read_int(p, eol, region.index)) && (p = read_word(p, eol, region.material)) &&
+           (p = read_word(p, eol, region.name));
       region.node_num  = 0;
       region.tet_num   = 0;
       // save it
-      _regions.push_back(region);
+      if( ok ) _regions.push_back(region);
+      p = eol;
     }
 
     //face label
     else if (flag == 'I' || flag == 'i')
     {
       int index, bc_index;
-      std::string type, name;
-      ctmp >> index >> name >> bc_index;
+      std::string name;
+      ok = (p = read_int(p, end, index)) && (p = read_word(p, end, name)) &&
+           (p = read_int(p, end, bc_index));
       // save it
-      _face_labels.insert(std::make_pair(bc_index, name));
+      if( ok ) _face_labels.insert(std::make_pair(bc_index, name));
     }
 
     // solutions
     else if (flag == 'S' || flag == 's')
     {
-      ctmp >> _sol_head.sol_num;
-      for(int i = 0; i < _sol_head.sol_num; i++)
+      ok = (p = read_int(p, end, _sol_head.sol_num));
+      for(int i = 0; ok && i < _sol_head.sol_num; i++)
       {
         std::string sol_name;
-        ctmp >> sol_name;
+        ok = (p = read_word(p, end, sol_name));
         _sol_head.sol_name_array.push_back(sol_name);
       }
     }
@@ -137,26 +173,26 @@ int TIF3D::read()
     // solution data
     else if (flag == 'N' || flag == 'n')
     {
-      SolData_t solution;
-      ctmp >> solution.index >> solution.region_index;
+      _sol_data.push_back(SolData_t());
+      SolData_t & solution = _sol_data.back();
+      ok = (p = read_int(p, end, solution.index)) && (p = read_int(p, end, solution.region_index));
       //For all data values...
-      for(int i = 0; i < _sol_head.sol_num; i++)
-      {
-        double dval;
-        ctmp >> dval;
-        solution.data_array.push_back(dval);
-      }
-      _sol_data.push_back(solution);
+      solution.data_array.resize(_sol_head.sol_num);
+      for(int i = 0; ok && i < _sol_head.sol_num; i++)
+        ok = (p = read_real(p, end, solution.data_array[i]));
     }
 
     else
     {
-      std::string rubbish;
-      std::getline(ctmp, rubbish);
+      p = eol;
     }
-  }
 
-  ctmp.close();
+    if( !ok )
+    {
+      std::cerr<<"TIF3D file error at record "<< flag << "."<<std::endl;
+      return 1;
+    }
+  }
 
   //statistic how many triangles in each region
   for(unsigned int n=0; n<_tets.size(); ++n)
@@ -648,6 +648,14 @@ REAL o3derrboundA, o3derrboundB, o3derrboundC;
 
 unsigned long randomseed;                     /* Current random number seed. */
 
+/* Each thread triangulating its own mesh keeps its own copy of the globals. */
+#ifdef _OPENMP
+#pragma omp threadprivate(splitter, epsilon, resulterrbound, \
+                          ccwerrboundA, ccwerrboundB, ccwerrboundC, \
+                          iccerrboundA, iccerrboundB, iccerrboundC, \
+                          o3derrboundA, o3derrboundB, o3derrboundC, randomseed)
+#endif
+
 
 /* Mesh data structure.  Triangle operates on only one mesh, but the mesh    */
 /*   structure is used (instead of global variables) to allow reentrancy.    */
@@ -44,10 +44,51 @@ void FE<Dim,T>::attach_quadrature_rule (QBase* q)
   qrule = q;
   // make sure we don't cache results from a previous quadrature rule
   elem_type = INVALID_ELEM;
+  shape_tables.clear();
   return;
 }
 
 
+
+template <unsigned int Dim, FEFamily T>
+void FE<Dim,T>::swap_shape_tables (ShapeTables & t)
+{
+  phi.swap(t.phi);
+  dphidxi.swap(t.dphidxi);
+  dphideta.swap(t.dphideta);
+  dphidzeta.swap(t.dphidzeta);
+  dphi.swap(t.dphi);
+  dphidx.swap(t.dphidx);
+  dphidy.swap(t.dphidy);
+  dphidz.swap(t.dphidz);
+  phi_map.swap(t.phi_map);
+  dphidxi_map.swap(t.dphidxi_map);
+  dphideta_map.swap(t.dphideta_map);
+  dphidzeta_map.swap(t.dphidzeta_map);
+#ifdef ENABLE_SECOND_DERIVATIVES
+  d2phi.swap(t.d2phi);
+  d2phidxi2.swap(t.d2phidxi2);
+  d2phidxideta.swap(t.d2phidxideta);
+  d2phidxidzeta.swap(t.d2phidxidzeta);
+  d2phideta2.swap(t.d2phideta2);
+  d2phidetadzeta.swap(t.d2phidetadzeta);
+  d2phidzeta2.swap(t.d2phidzeta2);
+  d2phidx2.swap(t.d2phidx2);
+  d2phidxdy.swap(t.d2phidxdy);
+  d2phidxdz.swap(t.d2phidxdz);
+  d2phidy2.swap(t.d2phidy2);
+  d2phidydz.swap(t.d2phidydz);
+  d2phidz2.swap(t.d2phidz2);
+  d2phidxi2_map.swap(t.d2phidxi2_map);
+  d2phidxideta_map.swap(t.d2phidxideta_map);
+  d2phidxidzeta_map.swap(t.d2phidxidzeta_map);
+  d2phideta2_map.swap(t.d2phideta2_map);
+  d2phidetadzeta_map.swap(t.d2phidetadzeta_map);
+  d2phidzeta2_map.swap(t.d2phidzeta2_map);
+#endif
+}
+
+
 template <unsigned int Dim, FEFamily T>
 unsigned int FE<Dim,T>::n_quadrature_points () const
 {
@@ -148,10 +189,27 @@ void FE<Dim,T>::reinit(const Elem* elem,
     if (elem_type != elem->type() ||
         !shapes_on_quadrature)
     {
+      // keep the tables of the last element type on the quadrature rule, and
+      // reuse the ones of this element type when they are evaluated before
+      bool tables_restored = false;
+      if (!this->shapes_need_reinit())
+      {
+        if (shapes_on_quadrature && elem_type != INVALID_ELEM)
+          this->swap_shape_tables (shape_tables[elem_type]);
+
+        typename std::map<ElemType, ShapeTables>::iterator it = shape_tables.find(elem->type());
+        if (it != shape_tables.end() && !it->second.phi_map.empty())
+        {
+          this->swap_shape_tables (it->second);
+          tables_restored = true;
+        }
+      }
+
       // Set the type and p level for this element
       elem_type = elem->type();
       // Initialize the shape functions
-      this->init_shape_functions (qrule->get_points(), elem);
+      if (!tables_restored)
+        this->init_shape_functions (qrule->get_points(), elem);
 
 
       if (this->shapes_need_reinit())
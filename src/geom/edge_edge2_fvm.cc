@@ -32,6 +32,18 @@ void Edge2_FVM::prepare_for_fvm()
   vol = Edge2::volume();
 }
 
+
+unsigned int Edge2_FVM::n_fvm_geometry() const
+{ return 1; }
+
+
+void Edge2_FVM::pack_fvm_geometry(Real * data) const
+{ data[0] = vol; }
+
+
+void Edge2_FVM::unpack_fvm_geometry(const Real * data)
+{ vol = data[0]; }
+
 /**
  * return the gradient of input variable in the cell
  */
@@ -44,12 +44,37 @@
 #endif
 
 #include "elem_clone.h"
+#include "object_pool.h"
 
 
 // Initialize static member variables
 const unsigned int Elem::_bp1 = 65449;
 const unsigned int Elem::_bp2 = 48661;
 
+
+// the pool is never destroyed, Elem objects may be deleted during static destruction
+static ObjectPool & elem_pool()
+{
+  static ObjectPool * pool = new ObjectPool;
+  return *pool;
+}
+
+// temporary sides and edges are also built by the threads of ray tracing,
+// so the pool is guarded
+void * Elem::operator new (size_t size)
+{
+  void * p;
+#pragma omp critical (elem_pool)
+  p = elem_pool().allocate(size);
+  return p;
+}
+
+void Elem::operator delete (void * p, size_t size)
+{
+#pragma omp critical (elem_pool)
+  elem_pool().deallocate(p, size);
+}
+
 // ------------------------------------------------------------
 // Elem class member funcions
 AutoPtr<Elem> Elem::build(const ElemType type,
@@ -652,6 +677,12 @@ Real Elem::quality (const ElemQuality q) const
 {
   switch (q)
   {
+      /**
+       * only the 2D elements can be obtuse for FVM usage
+       */
+      case OBTUSE:
+        return 0.;
+
       /**
        * I don't know what to do for this metric.
        */
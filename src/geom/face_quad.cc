@@ -153,6 +153,21 @@ Real Quad::quality (const ElemQuality q) const
     break;
       }
 
+      /**
+       * 1 if any interior angle is larger than 90 degree
+       */
+    case OBTUSE:
+      {
+        for (unsigned int i=0; i<4; i++)
+          {
+            const Point u = this->point((i+1)%4) - this->point(i);
+            const Point w = this->point((i+3)%4) - this->point(i);
+            if (u*w < -1e-10*u.size()*w.size())
+              return 1.;
+          }
+        return 0.;
+      }
+
     default:
       return Elem::quality(q);
     }
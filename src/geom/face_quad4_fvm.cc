@@ -379,3 +379,46 @@ VectorValue<AutoDScalar> Quad4_FVM::reconstruct_vector( const std::vector<AutoDS
 }
 
 
+unsigned int Quad4_FVM::n_fvm_geometry() const
+{
+  // d, l, v, vol, 3x4 gradient matrix and 2x4 vector reconstruct matrix
+  return 4*3 + 1 + 3*4 + 2*4;
+}
+
+
+void Quad4_FVM::pack_fvm_geometry(Real * data) const
+{
+  for(unsigned int i=0; i<4; ++i)
+  {
+    *data++ = d[i];
+    *data++ = l[i];
+    *data++ = v[i];
+  }
+  *data++ = vol;
+  for(unsigned int i=0; i<3; ++i)
+    for(unsigned int j=0; j<4; ++j)
+      *data++ = least_squares_gradient_matrix[i][j];
+  for(unsigned int i=0; i<2; ++i)
+    for(unsigned int j=0; j<4; ++j)
+      *data++ = least_squares_vector_reconstruct_matrix[i][j];
+}
+
+
+void Quad4_FVM::unpack_fvm_geometry(const Real * data)
+{
+  for(unsigned int i=0; i<4; ++i)
+  {
+    d[i] = *data++;
+    l[i] = *data++;
+    v[i] = *data++;
+  }
+  vol = *data++;
+  least_squares_gradient_matrix = TNT::Array2D<Real>(3, 4);
+  for(unsigned int i=0; i<3; ++i)
+    for(unsigned int j=0; j<4; ++j)
+      least_squares_gradient_matrix[i][j] = *data++;
+  least_squares_vector_reconstruct_matrix = TNT::Array2D<Real>(2, 4);
+  for(unsigned int i=0; i<2; ++i)
+    for(unsigned int j=0; j<4; ++j)
+      least_squares_vector_reconstruct_matrix[i][j] = *data++;
+}
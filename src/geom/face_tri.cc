@@ -146,6 +146,24 @@ Real Tri::quality (const ElemQuality q) const
         return 8. * s1 * s2 * s3;
 
       }
+
+      /**
+       * 1 if any angle is larger than 90 degree, the circumcircle center
+       * is outside the triangle then. only the sign of the dot product
+       * is tested, no acos is needed
+       */
+    case OBTUSE:
+      {
+        for (unsigned int i=0; i<3; i++)
+          {
+            const Point u = this->point((i+1)%3) - this->point(i);
+            const Point w = this->point((i+2)%3) - this->point(i);
+            if (u*w < -1e-10*u.size()*w.size())
+              return 1.;
+          }
+        return 0.;
+      }
+
     default:
       return Elem::quality(q);
     }
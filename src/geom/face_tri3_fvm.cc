@@ -103,42 +103,29 @@ void Tri3_FVM::prepare_for_fvm()
   // clear partitial volume
   v[0] = v[1] = v[2] = 0;
 
-  // the circle centre of ABC
-  Point circumcircle_center;
-  {
-    Point v12 = this->point(0) - this->point(1);
-    Point v23 = this->point(1) - this->point(2);
-    Point v13 = this->point(0) - this->point(2);
-
-    Real ccdet = v12.cross(v23).size_sq();
-    Real alpha = v23.size_sq() * v12.dot(v13) /2.0/ccdet;
-    Real beta  = - v13.size_sq() * v12.dot(v23) /2.0/ccdet;
-    Real gamma = v12.size_sq() * v13.dot(v23) /2.0/ccdet;
-
-    circumcircle_center = alpha * this->point(0) +
-                          beta  * this->point(1) +
-                          gamma * this->point(2);
-  }
-
-  Point side_centers[3];
+  // twice of the triangle area
+  const Point p0 = this->point(0);
+  const Point p1 = this->point(1);
+  const Point p2 = this->point(2);
+  const Real A2 = (p1-p0).cross(p2-p0).size();
+
+  // the signed distance from circumcircle center to edge i is 0.5*l*cot(a),
+  // a is the angle opposite to the edge. cot(a) = dot/cross of the two edges
+  // meet at the opposite vertex, it is negative for obtuse angle.
+  // no circumcircle center, acos or tan is needed
+  const Point * pts[3] = { &p0, &p1, &p2 };
   unsigned int obtuse_edge = invalid_uint;
   for( unsigned int i=0; i<3; i++ )
   {
-    Point p1 =  this->point(side_nodes_map[i][0]) ;
-    Point p2 =  this->point(side_nodes_map[i][1]) ;
-    Point p3 =  this->point((2+i)%3) ;
-    // the side (edge) center
-    side_centers[i] = 0.5*(p1+p2);
+    const Point & a =  *pts[side_nodes_map[i][0]] ;
+    const Point & b =  *pts[side_nodes_map[i][1]] ;
+    const Point & c =  *pts[(2+i)%3] ;
     // the side (edge) length
-    l[i] = (p1-p2).size();
-    // the distance from circumcircle center to edge
-    if( (p1-p3).cos_angle(p2-p3) < 0 )
-    {
-      d[i] = -(side_centers[i] - circumcircle_center).size();
-      obtuse_edge = i; //we need special process to obtuse angle
-    }
-    else
-      d[i] =  (side_centers[i] - circumcircle_center).size();
+    l[i] = (a-b).size();
+    const Real dot = (a-c)*(b-c);
+    d[i] = 0.5*l[i]*dot/A2;
+    //we need special process to obtuse angle
+    if( dot < 0 ) obtuse_edge = i;
 
     dt[i] = d[i];
   }
@@ -147,18 +134,17 @@ void Tri3_FVM::prepare_for_fvm()
   if(obtuse_edge!=invalid_uint)
   {
     unsigned int obtuse_node = (2+obtuse_edge)%3;
-    Point p1 =  this->point(side_nodes_map[obtuse_edge][0]) ;
-    Point p2 =  this->point(side_nodes_map[obtuse_edge][1]) ;
-    Point p3 =  this->point(obtuse_node) ;
-    double a1 = (p1-p2).angle(p1-p3);
-    double a2 = (p2-p1).angle(p2-p3);
+    const Point & a =  *pts[side_nodes_map[obtuse_edge][0]] ;
+    const Point & b =  *pts[side_nodes_map[obtuse_edge][1]] ;
+    const Point & c =  *pts[obtuse_node] ;
 
     unsigned int pre_edge = (obtuse_edge + 3 - 1)%3;
     unsigned int pos_edge = (obtuse_edge + 3 + 1)%3;
 
+    // tan of the angle at a and b, the two angles are acute
     dt[obtuse_edge] = 0;
-    dt[pre_edge] = 0.5*(p3-p1).size()*tan(a1);
-    dt[pos_edge] = 0.5*(p3-p2).size()*tan(a2);
+    dt[pre_edge] = 0.5*(c-a).size()*A2/((b-a)*(c-a));
+    dt[pos_edge] = 0.5*(c-b).size()*A2/((a-b)*(c-b));
   }
 
 
@@ -410,3 +396,42 @@ VectorValue<AutoDScalar> Tri3_FVM::reconstruct_vector( const std::vector<AutoDSc
   return VectorValue<AutoDScalar>(Vx, Vy, Vz);
 }
 
+
+unsigned int Tri3_FVM::n_fvm_geometry() const
+{
+  // d, dt, l, v, vol and 2x3 vector reconstruct matrix
+  return 3*4 + 1 + 2*3;
+}
+
+
+void Tri3_FVM::pack_fvm_geometry(Real * data) const
+{
+  for(unsigned int i=0; i<3; ++i)
+  {
+    *data++ = d[i];
+    *data++ = dt[i];
+    *data++ = l[i];
+    *data++ = v[i];
+  }
+  *data++ = vol;
+  for(unsigned int i=0; i<2; ++i)
+    for(unsigned int j=0; j<3; ++j)
+      *data++ = least_squares_vector_reconstruct_matrix[i][j];
+}
+
+
+void Tri3_FVM::unpack_fvm_geometry(const Real * data)
+{
+  for(unsigned int i=0; i<3; ++i)
+  {
+    d[i]  = *data++;
+    dt[i] = *data++;
+    l[i]  = *data++;
+    v[i]  = *data++;
+  }
+  vol = *data++;
+  least_squares_vector_reconstruct_matrix = TNT::Array2D<Real>(2, 3);
+  for(unsigned int i=0; i<2; ++i)
+    for(unsigned int j=0; j<3; ++j)
+      least_squares_vector_reconstruct_matrix[i][j] = *data++;
+}
@@ -0,0 +1,41 @@
+// $Id: node.cc,v 1.1 2008/07/09 05:58:16 gdiso Exp $
+
+// The libMesh Finite Element Library.
+// Copyright (C) 2002-2007  Benjamin S. Kirk, John W. Peterson
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+// Local includes
+#include "node.h"
+#include "object_pool.h"
+
+// the pool is never destroyed, Node objects may be deleted during static destruction
+static ObjectPool & node_pool()
+{
+  static ObjectPool * pool = new ObjectPool;
+  return *pool;
+}
+
+void * Node::operator new (size_t size)
+{
+  return node_pool().allocate(size);
+}
+
+void Node::operator delete (void * p, size_t size)
+{
+  node_pool().deallocate(p, size);
+}
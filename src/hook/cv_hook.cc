@@ -23,19 +23,28 @@
 
 #include <string>
 #include <cstdlib>
-#include <numeric>
 
 #include "solver_base.h"
+#include "fvm_nonlinear_solver.h"
+#include "parser.h"
 #include "cv_hook.h"
-#include "parallel.h"
 
 
 /*----------------------------------------------------------------------
  * constructor, open the rawfile for writing
  */
-CVHook::CVHook(SolverBase & solver, const std::string & name, void * file)
-    : Hook(solver, name), _input_file((const char *)file), _raw_file(SolverSpecify::out_prefix + ".cv"), _out(_raw_file.c_str()), _n_values(0)
-{}
+CVHook::CVHook(SolverBase & solver, const std::string & name, void * param)
+    : Hook(solver, name), _input_file(Genius::input_file()), _raw_file(SolverSpecify::out_prefix + ".cv"), _out(_raw_file.c_str()),
+      _quasistatic(false), _vsweep_column(invalid_uint), _sweep_index(0)
+{
+  const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+  for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+        parm_it != parm_list.end(); parm_it++ )
+  {
+    if ( parm_it->name() == "quasistatic" && parm_it->type() == Parser::BOOL )
+      _quasistatic = parm_it->get_bool();
+  }
+}
 
 
 /*----------------------------------------------------------------------
@@ -65,13 +74,26 @@ void CVHook::on_init()
       if(bc->label() == SolverSpecify::Electrode_VScan[0])
       {
         _sweep_electrode = bc->label();
+        _vsweep_column = _solver.iv_column(bc, "Vapp");
       }
       if( bc->bc_type() == GateContact )
       {
         _gate_electrodes.push_back (bc->label());
+        _gate_charge_columns.push_back(_solver.iv_column(bc, "charge"));
       }
+      if( bc->is_electrode() )
+      {
+        _electrodes.push_back(bc);
+        if( bc->label() == _sweep_electrode ) _sweep_index = _electrodes.size()-1;
+        if( bc->bc_type() == GateContact ) _gate_index.push_back(_electrodes.size()-1);
+      }
+    }
+    // the capacitance matrix needs the jacobian of a nonlinear solver
+    if( _quasistatic && !dynamic_cast<FVM_NonlinearSolver *>(&_solver) )
+    {
+      MESSAGE<<"Warning: CV hook: quasistatic capacitance is not supported by this solver, use finite difference of gate charge." << std::endl; RECORD();
+      _quasistatic = false;
     }
-    _gate_charge.resize( _gate_electrodes.size() );
   }
 
 }
@@ -93,83 +115,24 @@ void CVHook::pre_solve()
 void CVHook::post_solve()
 {
 
-  // available in DCSWEEP mode only
+  // available in DCSWEEP mode only, the sweep voltage and gate charges are recorded in iv store
   if (SolverSpecify::Type == SolverSpecify::DCSWEEP)
   {
-    BoundaryConditionCollector * bcs = _solver.get_system().get_bcs();
-    unsigned int elec_count=0;
-    for(unsigned int n=0; n<bcs->n_bcs(); n++)
+    if( _quasistatic && !_gate_electrodes.empty() )
     {
-      BoundaryCondition * bc = bcs->get_bc(n);
-
-      // Save sweep voltage
-      if(bc->label() == SolverSpecify::Electrode_VScan[0])
+      FVM_NonlinearSolver * solver = dynamic_cast<FVM_NonlinearSolver *>(&_solver);
+      std::vector<std::vector<PetscScalar> > C;
+      if( !solver->electrode_capacitance(_electrodes, C) )
       {
-        _vsweep.push_back(bc->ext_circuit()->Vapp()/PhysicalUnit::V);
+        MESSAGE<<"Warning: CV hook: linear solve of quasistatic capacitance failed." << std::endl; RECORD();
       }
 
-      // skip bc which is not gate
-      if( bc->bc_type() != GateContact ) continue;
-
-      std::vector<double> flux_buffer;
-
-      // device in Z dimension. for 3D mesh, z_width() should return 1.0.
-      PetscScalar flux_scale = bc->z_width();
-
-      BoundaryCondition::const_node_iterator node_it = bc->nodes_begin();
-      BoundaryCondition::const_node_iterator end_it  = bc->nodes_end();
-
-      for(; node_it != end_it; ++node_it)
-      {
-        // skip node not belonging to this processor
-        if ( (*node_it)->processor_id() != Genius::processor_id() ) continue;
-
-        // iterate over all fvm_node associated to *node_it
-        BoundaryCondition::region_node_iterator rnode_it = bc->region_node_begin(*node_it);
-        BoundaryCondition::region_node_iterator end_rnode_it = bc->region_node_end(*node_it);
-
-        std::vector<SimulationRegion *> regions;
-        std::vector<FVM_Node *> fvm_nodes;
-
-        //
-        for (unsigned int i=0 ; rnode_it!=end_rnode_it; ++i, ++rnode_it)
-        {
-          regions.push_back( (*rnode_it).second.first );
-          fvm_nodes.push_back( (*rnode_it).second.second );
-
-          switch ( regions[i]->type() )
-          {
-            case InsulatorRegion:
-              {
-                FVM_NodeData * node_data = fvm_nodes[i]->node_data();
-
-                FVM_Node::fvm_neighbor_node_iterator nb_it = fvm_nodes[i]->neighbor_node_begin();
-                for( ; nb_it != fvm_nodes[i]->neighbor_node_end(); ++nb_it )
-                {
-                  FVM_Node *nb_node = (*nb_it).second;
-                  FVM_NodeData * nb_node_data = nb_node->node_data();
-
-                  PetscScalar distance = (*(fvm_nodes[i]->root_node()) - *(nb_node->root_node())).size();
-                  PetscScalar cv_area = fvm_nodes[i]->cv_surface_area(nb_node->root_node());
-                  PetscScalar EFlux = (node_data->psi()-nb_node_data->psi())/distance;
-
-                  flux_buffer.push_back(cv_area*node_data->eps()*EFlux*flux_scale);
-                }
-                break;
-              }
-            case ElectrodeRegion:
-              {
-                break;
-              }
-            default: genius_error(); //we should never reach here
-          }
-        }
-      }
-      Parallel::allgather(flux_buffer);
-      PetscScalar charge = std::accumulate(flux_buffer.begin(), flux_buffer.end(), 0.0);
-      _gate_charge[elec_count++].push_back(charge/PhysicalUnit::C);
+      std::vector<double> cap;
+      for(unsigned int i=0; i<C.size(); i++)
+        for(unsigned int j=0; j<C[i].size(); j++)
+          cap.push_back(C[i][j]/(PhysicalUnit::C/PhysicalUnit::V));
+      _capacitance.push_back(cap);
     }
-    if (elec_count) _n_values++;
   }
 }
 
@@ -193,52 +156,91 @@ void CVHook::on_close()
   // only root processor do this command
   if ( !Genius::processor_id() )
   {
-    if (SolverSpecify::Type == SolverSpecify::DCSWEEP)
+    if (SolverSpecify::Type == SolverSpecify::DCSWEEP && _vsweep_column != invalid_uint)
     {
+      // the sweep voltage and gate charges of each step
+      const IVStore & iv_store = _solver.iv_store();
+      const std::vector<double> & vsweep = iv_store.column(_vsweep_column);
+      std::vector<const std::vector<double> *> gate_charge;
+      for(unsigned int n=0; n<_gate_charge_columns.size(); n++)
+      {
+        // gate charge is not recorded, i.e. mixA solver
+        if( _gate_charge_columns[n] == invalid_uint ) return;
+        gate_charge.push_back(&iv_store.column(_gate_charge_columns[n]));
+      }
+
       // write raw file head
-      _out << "# Title: CV Curve Created by Genius TCAD Simulation" << std::endl;
-      _out << "# Date: " << ctime(&_time) << std::endl;
+      _out << "# Title: CV Curve Created by Genius TCAD Simulation" << '\n';
+      _out << "# Date: " << ctime(&_time) << '\n';
 
       //_out << std::setprecision(15) << std::scientific << std::right;
-      _out << "#\t1\t"<< _sweep_electrode << " [V]" << std::endl;
-      for(unsigned int n=0; n<_gate_charge.size(); n++)
-        _out << "#\t" << n+2 << "\t"<< _gate_electrodes[n] << " [F]" << std::endl;
+      _out << "#\t1\t"<< _sweep_electrode << " [V]" << '\n';
+      for(unsigned int n=0; n<gate_charge.size(); n++)
+        _out << "#\t" << n+2 << "\t"<< _gate_electrodes[n] << " [F]" << '\n';
+
+      if( _quasistatic )
+      {
+        for(unsigned int a=0; a<_electrodes.size(); a++)
+          for(unsigned int b=0; b<_electrodes.size(); b++)
+            _out << "#\t" << gate_charge.size()+2+a*_electrodes.size()+b << "\t"
+                 << "C(" << _electrodes[a]->label() << "," << _electrodes[b]->label() << ") [F]" << '\n';
+        _out << '\n';
+
+        // gate capacitance to the sweep electrode, then the full capacitance matrix
+        const unsigned int n = _electrodes.size();
+        for(unsigned int i=0; i<_capacitance.size(); i++)
+        {
+          _out << vsweep[i];
+          for(unsigned int g=0; g<_gate_index.size(); g++)
+            _out << '\t' << _capacitance[i][_gate_index[g]*n + _sweep_index];
+          for(unsigned int k=0; k<n*n; k++)
+            _out << '\t' << _capacitance[i][k];
+          _out << '\n';
+        }
+        _out.flush();
+        return;
+      }
+
+      _out << '\n';
 
-      _out << std::endl;
+      // finite difference needs two sweep points at least
+      const unsigned int n_values = gate_charge.empty() ? 0 : iv_store.n_rows();
+      if( n_values < 2 ) return;
 
       {
         unsigned int i=0;
-        _out << _vsweep[i];
-        for (unsigned int n=0; n<_gate_charge.size(); n++)
-          _out << "\t" << (_gate_charge[n][i+1]-_gate_charge[n][i])/(_vsweep[i+1]-_vsweep[i]);
-        _out << std::endl;
+        _out << vsweep[i];
+        for (unsigned int n=0; n<gate_charge.size(); n++)
+          _out << "\t" << ((*gate_charge[n])[i+1]-(*gate_charge[n])[i])/(vsweep[i+1]-vsweep[i]);
+        _out << '\n';
       }
 
-      for(unsigned int i=1; i<_n_values-1; i++)
+      for(unsigned int i=1; i<n_values-1; i++)
       {
-        _out << _vsweep[i];
-        for(unsigned int n=0; n<_gate_charge.size(); n++)
+        _out << vsweep[i];
+        for(unsigned int n=0; n<gate_charge.size(); n++)
         {
-          double hl = _vsweep[i-1]-_vsweep[i];
-          double hr = _vsweep[i+1]-_vsweep[i];
+          double hl = vsweep[i-1]-vsweep[i];
+          double hr = vsweep[i+1]-vsweep[i];
           double c1 = hr/hl/(hr-hl);
           double c2 = -(hr+hl)/hl/hr;
           double c3 = -hl/hr/(hr-hl);
 
-          _out  << '\t' <<  c1*_gate_charge[n][i-1]
-                          + c2*_gate_charge[n][i]
-                          + c3*_gate_charge[n][i+1];
+          _out  << '\t' <<  c1*(*gate_charge[n])[i-1]
+                          + c2*(*gate_charge[n])[i]
+                          + c3*(*gate_charge[n])[i+1];
         }
-        _out << std::endl;
+        _out << '\n';
       }
 
       {
-        unsigned int i= _n_values-1;
-        _out << _vsweep[i];
-        for (unsigned int n=0; n<_gate_charge.size(); n++)
-          _out << "\t" << (_gate_charge[n][i]-_gate_charge[n][i-1])/(_vsweep[i]-_vsweep[i-1]);
-        _out << std::endl;
+        unsigned int i= n_values-1;
+        _out << vsweep[i];
+        for (unsigned int n=0; n<gate_charge.size(); n++)
+          _out << "\t" << ((*gate_charge[n])[i]-(*gate_charge[n])[i-1])/(vsweep[i]-vsweep[i-1]);
+        _out << '\n';
       }
+      _out.flush();
 
     }
   }
@@ -26,6 +26,7 @@
 
 #include "fvm_nonlinear_solver.h"
 #include "eigenvalue_hook.h"
+#include "parser.h"
 
 #ifdef HAVE_SLEPC
 #include "slepceps.h"
@@ -42,8 +43,17 @@ EigenValueHook::EigenValueHook ( SolverBase & solver, const std::string & name,
 {
   this->_poisson_solver = false;
   this->_ddm_solver = false;
+  this->_slepc = false;
   this->solution_count=0;
   this->iteration_count=0;
+
+  const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+  for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+        parm_it != parm_list.end(); parm_it++ )
+  {
+    if ( parm_it->name() == "mode" && parm_it->type() == Parser::STRING )
+      _slepc = ( parm_it->get_string() == "slepc" );
+  }
 }
 
 
@@ -81,7 +91,12 @@ void EigenValueHook::on_init()
     _ddm_solver = true;
   }
 
-
+  // the Krylov iterations estimate singular values as a by-product
+  if( (_poisson_solver || _ddm_solver) && !_slepc )
+  {
+    FVM_NonlinearSolver & nonlinear_solver = dynamic_cast<FVM_NonlinearSolver &>(_solver);
+    nonlinear_solver.compute_singular_values(true);
+  }
 }
 
 
@@ -110,6 +125,26 @@ void EigenValueHook::post_solve()
  */
 void EigenValueHook::pre_iteration()
 {
+  if( !_poisson_solver && !_ddm_solver ) return;
+
+  if( !_slepc )
+  {
+    FVM_NonlinearSolver & nonlinear_solver = dynamic_cast<FVM_NonlinearSolver &>(_solver);
+
+    double cond = nonlinear_solver.condition_number_of_jacobian_matrix();
+    PetscReal emax, emin;
+    bool krylov = nonlinear_solver.extreme_singular_values(emax, emin);
+
+    if(Genius::processor_id() == 0)
+    {
+      std::cout<< "Estimated 1-norm condition number: " << std::scientific << std::setprecision(6)<<std::setw(10) << cond << std::endl;
+      if( krylov )
+        std::cout<< "Singular values of preconditioned operator: " << std::scientific << std::setprecision(6)<<std::setw(10)
+                 << emin << " to " << emax << ", ratio " << emax/emin << std::endl;
+    }
+    return;
+  }
+
 #ifdef HAVE_SLEPC
 
   EPS            eps_s;
@@ -27,28 +27,32 @@
 
 #include "solver_base.h"
 #include "gnuplot_hook.h"
-#include "spice_ckt.h"
 #include "mxml.h"
 #include "MXMLUtil.h"
 
+/*----------------------------------------------------------------------
+ * the unit of SPICE variable type
+ */
+static std::string _unit(const std::string & type)
+{
+  if( type == "time" )    return " [s]";
+  if( type == "Hz" )      return " [Hz]";
+  if( type == "voltage" ) return " [V]";
+  if( type == "current" ) return " [A]";
+  if( type == "charge" )  return " [C]";
+  return "    ";
+}
+
+
 /*----------------------------------------------------------------------
  * constructor, open the file for writing
  */
 GnuplotHook::GnuplotHook(SolverBase & solver, const std::string & name, void * file)
     : Hook(solver, name), _input_file((const char *)file),
-    _gnuplot_file(SolverSpecify::out_prefix + ".dat"), _mixA(false)
+    _gnuplot_file(SolverSpecify::out_prefix + ".dat"), _n_rows_written(0)
 {
   if ( !Genius::processor_id() )
     _out.open(_gnuplot_file.c_str());
-
-  SolverSpecify::SolverType solver_type = this->get_solver().solver_type();
-
-  // if we are called by mixA solver?
-  if(solver_type == SolverSpecify::DDML1MIXA ||
-      solver_type == SolverSpecify::DDML2MIXA ||
-      solver_type == SolverSpecify::EBML3MIXA
-    )
-    _mixA = true;
 }
 
 
@@ -75,119 +79,40 @@ void GnuplotHook::on_init()
     time(&_time);
 
     // write file head
-    _out << "# Title: Gnuplot File Created by Genius TCAD Simulation" << std::endl;
-    _out << "# Date: " << ctime(&_time) << std::endl;
+    _out << "# Title: Gnuplot File Created by Genius TCAD Simulation" << '\n';
+    _out << "# Date: " << ctime(&_time) << '\n';
 
     switch (SolverSpecify::Type)
     {
         case SolverSpecify::DCSWEEP   :
-        _out << "# Plotname: DC transfer characteristic" << std::endl; break;
+        _out << "# Plotname: DC transfer characteristic" << '\n'; break;
         case SolverSpecify::TRANSIENT :
-        _out << "# Plotname: Transient Analysis" << std::endl; break;
+        _out << "# Plotname: Transient Analysis" << '\n'; break;
         case SolverSpecify::ACSWEEP   :
-        _out << "# Plotname: AC small signal Analysis" << std::endl; break;
+        _out << "# Plotname: AC small signal Analysis" << '\n'; break;
         default: break;
     }
 
-    // write variables
-    _out << "# Variables: " << std::endl;
-
-    if( SolverSpecify::Type==SolverSpecify::DCSWEEP || SolverSpecify::Type==SolverSpecify::TRANSIENT )
-    {
-      unsigned int n_var = 0;
-      // if transient simulation, we need to record time
-      if ( SolverSpecify::Type == SolverSpecify::TRANSIENT )
-      {
-        _out << '#' <<'\t' << ++n_var <<'\t' << "time" << " [s]"<< std::endl;
-        _out << '#' <<'\t' << ++n_var <<'\t' << "time_step" << " [s]"<< std::endl;
-      }
-
-      if( !_mixA )
-      {
-        // record electrode IV information
-        const BoundaryConditionCollector * bcs = this->get_solver().get_system().get_bcs();
-        // search for all the bcs
-        for(unsigned int n=0; n<bcs->n_bcs(); n++)
-        {
-          const BoundaryCondition * bc = bcs->get_bc(n);
-          // for electrode
-          if( bc->is_electrode() )
-          {
-            std::string bc_label = bc->label();
-            if(!bc->electrode_label().empty())
-              bc_label = bc->electrode_label();
-
-            _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_Vapp"      << " [V]"<< std::endl;
-            _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_potential" << " [V]"<< std::endl;
-            _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_current"   << " [A]"<< std::endl;
-            continue;
-          }
-
-          if( bc->has_current_flow() )
-          {
-            std::string bc_label = bc->label();
-            _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_current"   << " [A]"<< std::endl;
-          }
-
-          if( bc->bc_type() == IF_Metal_Ohmic || bc->bc_type() == IF_Metal_Schottky)
-          {
-            std::string bc_label = bc->label();
-            _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_average_potential"   << " [V]"<< std::endl;
-          }
-
-          // charge integral interface
-          if( bc->bc_type() == ChargeIntegral )
-          {
-            std::string bc_label = bc->label();
-            _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_Q"          << " [C]"<< std::endl;
-            _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_potential"  << " [V]"<< std::endl;
-          }
-        }
-      }
-      else
-      {
-        const SPICE_CKT * spice_ckt = this->get_solver().get_system().get_circuit();
-        for(unsigned int n=0; n<spice_ckt->n_ckt_nodes(); n++)
-        {
-          if(spice_ckt->is_voltage_node(n))
-            _out << '#' <<'\t' << ++n_var <<'\t' << spice_ckt->ckt_node_name(n)   << " [V]"<< std::endl;
-          else
-            _out << '#' <<'\t' << ++n_var <<'\t' << spice_ckt->ckt_node_name(n)   << " [A]"<< std::endl;
-        }
-      }
-    }
+    // write variables, the text columns of iv store
+    _out << "# Variables: " << '\n';
 
-    if( SolverSpecify::Type==SolverSpecify::ACSWEEP)
+    const IVStore & iv_store = this->get_solver().iv_store();
+    unsigned int n_var = 0;
+    for(unsigned int c=0; c<iv_store.n_columns(); c++)
     {
-      unsigned int n_var = 0;
-
-      _out << '#' <<'\t' << ++n_var <<'\t' << "frequency" << " [Hz]"<< std::endl;
+      if( !iv_store.text(c) ) continue;
+      _out << '#' <<'\t' << ++n_var <<'\t' << iv_store.name(c) << _unit(iv_store.type(c)) << '\n';
 
-      // record electrode IV information
-      const BoundaryConditionCollector * bcs = this->get_solver().get_system().get_bcs();
-      // search for all the bcs
-      for(unsigned int n=0; n<bcs->n_bcs(); n++)
+      // AC analysis, admittance of each electrode follows its current angle
+      if( SolverSpecify::Type==SolverSpecify::ACSWEEP && c>0 && c%4==0 )
       {
-        const BoundaryCondition * bc = bcs->get_bc(n);
-        // skip bc which is not electrode
-        if( !bc->is_electrode() ) continue;
-        //
-        std::string bc_label = bc->label();
-        if(!bc->electrode_label().empty())
-          bc_label = bc->electrode_label();
-        //
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_potential_magnitude" << " [V]"<< std::endl;
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_potential_angle"     << "    "<< std::endl;
-
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_current_magnitude"   << " [A]"<< std::endl;
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_current_angle"       << "    "<< std::endl;
-
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_G"   << " [S]"<< std::endl;
-        _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_C"   << " [F]"<< std::endl;
+        const std::string bc_label = iv_store.name(c).substr(0, iv_store.name(c).size()-std::string("_current_angle").size());
+        _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_G"   << " [S]"<< '\n';
+        _out << '#' <<'\t' << ++n_var <<'\t' << bc_label + "_C"   << " [F]"<< '\n';
       }
     }
 
-    _out << std::endl;
+    _out << '\n';
 
   }
 
@@ -213,99 +138,48 @@ void GnuplotHook::post_solve()
   // only root processor do this command
   if ( !Genius::processor_id() )
   {
-    // set the float number precision
-    _out.precision(6);
-
-    // set output width and format
-    _out<< std::scientific << std::right;
-
-    if( SolverSpecify::Type==SolverSpecify::DCSWEEP || SolverSpecify::Type==SolverSpecify::TRANSIENT )
+    // the view of the rows of iv store appended since last call, usually only the last row.
+    // the rows merged from other bias groups come together
+    const IVStore & iv_store = this->get_solver().iv_store();
+    for( ; _n_rows_written < iv_store.n_rows(); ++_n_rows_written)
     {
-      // if transient simulation, we need to record time
-      if (SolverSpecify::Type == SolverSpecify::TRANSIENT)
-      {
-        _out << SolverSpecify::clock/PhysicalUnit::s << '\t';
-        _out << std::setw(15) << SolverSpecify::dt/PhysicalUnit::s;
-      }
-
-      if( !_mixA )
-      {
-        // search for all the bc
-        const BoundaryConditionCollector * bcs = this->get_solver().get_system().get_bcs();
-        for(unsigned int n=0; n<bcs->n_bcs(); n++)
-        {
-          const BoundaryCondition * bc = bcs->get_bc(n);
-
-          // electrode
-          if( bc->is_electrode() )
-          {
-            //record vapp, electrode potential and electrode current
-            _out << std::setw(15) << bc->ext_circuit()->Vapp()/PhysicalUnit::V;
-            _out << std::setw(15) << bc->ext_circuit()->potential()/PhysicalUnit::V;
-            _out << std::setw(15) << bc->ext_circuit()->current()/PhysicalUnit::A;
-            continue;
-          }
-
-          if( bc->has_current_flow() )
-          {
-            _out << std::setw(15) << bc->current()/PhysicalUnit::A;
-          }
-
-          if( bc->bc_type() == IF_Metal_Ohmic || bc->bc_type() == IF_Metal_Schottky)
-          {
-            _out << std::setw(15) << bc->psi()/PhysicalUnit::V;
-          }
-
-          // charge integral interface
-          if( bc->bc_type() == ChargeIntegral )
-          {
-            _out << std::setw(15) << bc->Qf()/PhysicalUnit::C;
-            _out << std::setw(15) << bc->psi()/PhysicalUnit::V;
-          }
-        }
-      }
-      else
-      {
-        const SPICE_CKT * spice_ckt = this->get_solver().get_system().get_circuit();
-        for(unsigned int n=0; n<spice_ckt->n_ckt_nodes(); n++)
-        {
-          _out << std::setw(15) << spice_ckt->get_solution(n);
-        }
-      }
-    }
+      const unsigned int r = _n_rows_written;
 
+      // set the float number precision
+      _out.precision(6);
 
-    if( SolverSpecify::Type==SolverSpecify::ACSWEEP)
-    {
-      PetscScalar omega = 2*3.14159265358979323846*SolverSpecify::Freq*PhysicalUnit::s;
-      _out << SolverSpecify::Freq*PhysicalUnit::s << '\t';
+      // set output width and format
+      _out<< std::scientific << std::right;
 
-      // search for all the bc
-      const BoundaryConditionCollector * bcs = this->get_solver().get_system().get_bcs();
-      for(unsigned int n=0; n<bcs->n_bcs(); n++)
+      for(unsigned int c=0; c<iv_store.n_columns(); c++)
       {
-        const BoundaryCondition * bc = bcs->get_bc(n);
-        // skip bc which is not electrode
-        if( !bc->is_electrode() ) continue;
+        if( !iv_store.text(c) ) continue;
 
-        //record electrode potential and electrode current for AC simulation
-        _out << std::setw(15) << std::abs(bc->ext_circuit()->potential_ac())/PhysicalUnit::V;
-        _out << std::setw(15) << std::arg(bc->ext_circuit()->potential_ac());
-
-        _out << std::setw(15) << std::abs(bc->ext_circuit()->current_ac())/PhysicalUnit::A;
-        _out << std::setw(15) << std::arg(bc->ext_circuit()->current_ac());
-
-        std::complex<PetscScalar> Y;
-        if(bc->ext_circuit()->potential_ac() != 0.0)
-          Y = (bc->ext_circuit()->current_ac()/PhysicalUnit::A)/(bc->ext_circuit()->potential_ac()/PhysicalUnit::V);
+        // time and frequency lead the line
+        if( c==0 && (iv_store.type(c) == "time" || iv_store.type(c) == "Hz") )
+          _out << iv_store.value(r, c) << '\t';
         else
-          Y = 0.0;
-        _out << std::setw(15) << Y.real();
-        _out << std::setw(15) << Y.imag()/omega;
+          _out << std::setw(15) << iv_store.value(r, c);
+
+        // AC analysis, admittance of each electrode follows its current angle
+        if( SolverSpecify::Type==SolverSpecify::ACSWEEP && c>0 && c%4==0 )
+        {
+          const PetscScalar omega = 2*3.14159265358979323846*iv_store.value(r, 0);
+          const PetscScalar V = iv_store.value(r, c-3);
+          const PetscScalar I = iv_store.value(r, c-1);
+          std::complex<PetscScalar> Y;
+          if( V != 0.0 )
+            Y = std::polar(I/V, iv_store.value(r, c) - iv_store.value(r, c-2));
+          else
+            Y = 0.0;
+          _out << std::setw(15) << Y.real();
+          _out << std::setw(15) << Y.imag()/omega;
+        }
       }
-    }
 
-    _out << std::endl;
+      // no flush here, the file is flushed when closed
+      _out << '\n';
+    }
 
     ////----
     {
@@ -0,0 +1,590 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "mesh_base.h"
+#include "solver_base.h"
+#include "hdf5_hook.h"
+#include "spice_ckt.h"
+#include "fvm_node_data.h"
+#include "material_define.h"
+#include "parallel.h"
+#include "output_field.h"
+#include "MXMLUtil.h"
+
+
+namespace
+{
+  // bit pattern of a float
+  inline unsigned int float_bits(float v)
+  {
+    unsigned int bits;
+    std::memcpy(&bits, &v, sizeof(float));
+    return bits;
+  }
+}
+
+
+/*----------------------------------------------------------------------
+ * constructor, parse the parameters
+ */
+HDF5Hook::HDF5Hook ( SolverBase & solver, const std::string & name, void * param)
+    : Hook ( solver, name ), _filename ( SolverSpecify::out_prefix + ".h5" ),
+      _decimate ( 1 ), _compress ( true ), _delta ( false ), _n_solution ( 0 ), _n_step ( 0 ),
+      _ddm ( false ), _mixA ( false ), _parallel_io ( false ), _writer ( false ),
+      _file ( -1 ), _dxpl ( -1 ), _sweep ( -1 )
+{
+  this->_t_step=0;
+  this->_v_step=0;
+  this->_i_step=0;
+  this->_t_last=0;
+  this->_v_last=0;
+  this->_i_last=0;
+
+  std::string field_list;
+
+  const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+  for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+        parm_it != parm_list.end(); parm_it++ )
+  {
+    if ( parm_it->name() == "file" && parm_it->type() == Parser::STRING )
+      _filename = parm_it->get_string();
+    if ( parm_it->name() == "fields" && parm_it->type() == Parser::STRING )
+      field_list = parm_it->get_string();
+    if ( parm_it->name() == "decimate" && parm_it->type() == Parser::INTEGER )
+      _decimate = std::max(1, parm_it->get_int());
+    if ( parm_it->name() == "compress" && parm_it->type() == Parser::BOOL )
+      _compress = parm_it->get_bool();
+    if ( parm_it->name() == "delta" && parm_it->type() == Parser::BOOL )
+      _delta = parm_it->get_bool();
+    if ( parm_it->name() == "tstep" && parm_it->type() == Parser::REAL )
+      _t_step=parm_it->get_real() * PhysicalUnit::s;
+    if ( parm_it->name() == "vstep" && parm_it->type() == Parser::REAL )
+      _v_step=parm_it->get_real() * PhysicalUnit::V;
+    if ( parm_it->name() == "istep" && parm_it->type() == Parser::REAL )
+      _i_step=parm_it->get_real() * PhysicalUnit::A;
+  }
+
+  // the selected fields, separated by comma. all the fields by default
+  _fields = OutputField::parse(field_list, "HDF5 hook");
+
+  // if we are called by mixA solver?
+  switch ( this->get_solver().solver_type() )
+  {
+    case SolverSpecify::DDML1     :
+    case SolverSpecify::DDML2     :
+    case SolverSpecify::EBML3     :   _ddm = true; break;
+    case SolverSpecify::DDML1MIXA :
+    case SolverSpecify::DDML2MIXA :
+    case SolverSpecify::EBML3MIXA :   _mixA = true; break;
+    default : break;
+  }
+
+#ifdef H5_HAVE_PARALLEL
+  _parallel_io = Genius::n_processors() > 1;
+#endif
+  _writer = _parallel_io || Genius::is_first_processor();
+}
+
+
+/*----------------------------------------------------------------------
+ * destructor, close file
+ */
+HDF5Hook::~HDF5Hook()
+{}
+
+
+/*----------------------------------------------------------------------
+ *   This is executed before the initialization of the solver
+ */
+void HDF5Hook::on_init()
+{
+  _create_file();
+
+  // the initial solution
+  double value = 0;
+  if ( SolverSpecify::Type==SolverSpecify::TRANSIENT ) value = SolverSpecify::clock/PhysicalUnit::ps;
+  _write_step(value);
+}
+
+
+
+/*----------------------------------------------------------------------
+ *   This is executed previously to each solution step.
+ */
+void HDF5Hook::pre_solve()
+{}
+
+
+
+/*----------------------------------------------------------------------
+ *  This is executed after each solution step.
+ */
+void HDF5Hook::post_solve()
+{
+  if ( (++_n_solution) % _decimate ) return;
+
+  double value;
+  if ( _record_step(value) )
+    _write_step(value);
+}
+
+
+
+/*----------------------------------------------------------------------
+ *  This is executed after each (nonlinear) iteration
+ */
+void HDF5Hook::post_iteration()
+{}
+
+
+
+/*----------------------------------------------------------------------
+ * This is executed after the finalization of the solver
+ */
+void HDF5Hook::on_close()
+{
+  for(unsigned int r=0; r<_region_datasets.size(); ++r)
+    for(unsigned int f=0; f<_region_datasets[r].size(); ++f)
+      if( _region_datasets[r][f] >= 0 ) H5Dclose(_region_datasets[r][f]);
+  _region_datasets.clear();
+  _region_last_rows.clear();
+
+  if( _sweep >= 0 ) H5Dclose(_sweep);
+  if( _dxpl >= 0 )  H5Pclose(_dxpl);
+  if( _file >= 0 )  H5Fclose(_file);
+  _sweep = _dxpl = _file = -1;
+}
+
+
+
+bool HDF5Hook::_record_step(double &value)
+{
+  if ( SolverSpecify::Type==SolverSpecify::DCSWEEP && SolverSpecify::Electrode_VScan.size() )
+  {
+    double Vscan = 0;
+
+    // DDM solver
+    if ( _ddm )
+    {
+      const BoundaryConditionCollector * bcs = _solver.get_system().get_bcs();
+      const BoundaryCondition * bc = bcs->get_bc ( SolverSpecify::Electrode_VScan[0] );
+      Vscan = bc->ext_circuit()->Vapp();
+    }
+
+    // MIXA solver
+    if ( _mixA )
+    {
+      SPICE_CKT * spice_ckt = _solver.get_system().get_circuit();
+      Vscan = spice_ckt->get_voltage_from ( SolverSpecify::Electrode_VScan[0] );
+    }
+
+    if ( std::fabs ( Vscan - this->_v_last ) < this->_v_step ) return false;
+    _v_last = Vscan;
+    value = Vscan/PhysicalUnit::V;
+    return true;
+  }
+
+  if ( SolverSpecify::Type==SolverSpecify::DCSWEEP && SolverSpecify::Electrode_IScan.size() )
+  {
+    // DDM solver only
+    assert ( _ddm );
+
+    const BoundaryConditionCollector * bcs = _solver.get_system().get_bcs();
+    const BoundaryCondition * bc = bcs->get_bc ( SolverSpecify::Electrode_IScan[0] );
+    double Iscan = bc->ext_circuit()->Iapp();
+
+    if ( std::fabs ( Iscan - this->_i_last ) < this->_i_step ) return false;
+    _i_last = Iscan;
+    value = Iscan/PhysicalUnit::A;
+    return true;
+  }
+
+  if ( SolverSpecify::Type==SolverSpecify::TRANSIENT )
+  {
+    if ( SolverSpecify::clock - this->_t_last < this->_t_step ) return false;
+    _t_last = SolverSpecify::clock;
+    value = SolverSpecify::clock/PhysicalUnit::ps;
+    return true;
+  }
+
+  if ( SolverSpecify::Type==SolverSpecify::ACSWEEP )
+  {
+    value = SolverSpecify::Freq*PhysicalUnit::s;
+    return true;
+  }
+
+  // other solvers, record the step number
+  value = _n_solution;
+  return true;
+}
+
+
+
+void HDF5Hook::_create_file()
+{
+  const SimulationSystem &system = get_solver().get_system();
+  const MeshBase &mesh = system.mesh();
+
+  // the rows of each region, ordered by owner processor
+  _region_offset.clear();
+  _region_rows.clear();
+  for( unsigned int r=0; r<system.n_regions(); r++)
+  {
+    const SimulationRegion * region = system.region(r);
+    unsigned int n_local = region->n_on_processor_node();
+    std::vector<unsigned int> n_rows;
+    Parallel::allgather(n_local, n_rows);
+
+    hsize_t offset = 0, rows = 0;
+    for(unsigned int p=0; p<n_rows.size(); ++p)
+    {
+      if( p < Genius::processor_id() ) offset += n_rows[p];
+      rows += n_rows[p];
+    }
+    _region_offset.push_back(offset);
+    _region_rows.push_back(rows);
+  }
+
+  if( _writer )
+  {
+    hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+    _dxpl = H5Pcreate(H5P_DATASET_XFER);
+#ifdef H5_HAVE_PARALLEL
+    if( _parallel_io )
+    {
+      H5Pset_fapl_mpio(fapl, PETSC_COMM_WORLD, MPI_INFO_NULL);
+      H5Pset_dxpl_mpio(_dxpl, H5FD_MPIO_COLLECTIVE);
+    }
+#endif
+    _file = H5Fcreate(_filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    H5Pclose(fapl);
+    genius_assert(_file >= 0);
+  }
+
+  MESSAGE<<"Write time series to HDF5 file " << _filename << "..."; RECORD();
+
+  // the mesh. it is replicated, the first processor writes all of it
+  {
+    std::vector<double> coordinates(3*mesh.max_node_id(), 0.0);
+    MeshBase::const_node_iterator       node_it  = mesh.nodes_begin();
+    const MeshBase::const_node_iterator node_it_end = mesh.nodes_end();
+    for (; node_it != node_it_end; ++node_it)
+      for(unsigned int d=0; d<3; ++d)
+        coordinates[3*(*node_it)->id()+d] = (**node_it)(d)/PhysicalUnit::um;
+
+    std::vector<int> elem_type, elem_region, elem_offset(1, 0), connectivity;
+    MeshBase::const_element_iterator       elem_it  = mesh.active_elements_begin();
+    const MeshBase::const_element_iterator elem_it_end = mesh.active_elements_end();
+    for (; elem_it != elem_it_end; ++elem_it)
+    {
+      const Elem * elem = *elem_it;
+      elem_type.push_back(elem->type());
+      elem_region.push_back(elem->subdomain_id());
+      for(unsigned int i=0; i<elem->n_nodes(); ++i)
+        connectivity.push_back(elem->node(i));
+      elem_offset.push_back(connectivity.size());
+    }
+
+    const hsize_t n_coordinates = coordinates.size();
+    const hsize_t n_elem = elem_type.size();
+    const hsize_t n_connectivity = connectivity.size();
+    if( !Genius::is_first_processor() )
+    {
+      std::vector<double>().swap(coordinates);
+      std::vector<int>().swap(elem_type);
+      std::vector<int>().swap(elem_region);
+      std::vector<int>().swap(elem_offset);
+      std::vector<int>().swap(connectivity);
+    }
+
+    hid_t group = _writer ? H5Gcreate2(_file, "mesh", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT) : -1;
+
+    hid_t dataset = _create_dataset(group, "coordinates", H5T_IEEE_F64LE, n_coordinates, false);
+    _write_rows(dataset, H5T_NATIVE_DOUBLE, coordinates, 0, n_coordinates);
+    if( dataset >= 0 ) H5Dclose(dataset);
+
+    dataset = _create_dataset(group, "elem_type", H5T_STD_I32LE, n_elem, false);
+    _write_rows(dataset, H5T_NATIVE_INT, elem_type, 0, n_elem);
+    if( dataset >= 0 ) H5Dclose(dataset);
+
+    dataset = _create_dataset(group, "elem_region", H5T_STD_I32LE, n_elem, false);
+    _write_rows(dataset, H5T_NATIVE_INT, elem_region, 0, n_elem);
+    if( dataset >= 0 ) H5Dclose(dataset);
+
+    dataset = _create_dataset(group, "elem_offset", H5T_STD_I32LE, n_elem+1, false);
+    _write_rows(dataset, H5T_NATIVE_INT, elem_offset, 0, n_elem+1);
+    if( dataset >= 0 ) H5Dclose(dataset);
+
+    dataset = _create_dataset(group, "connectivity", H5T_STD_I32LE, n_connectivity, false);
+    _write_rows(dataset, H5T_NATIVE_INT, connectivity, 0, n_connectivity);
+    if( dataset >= 0 ) H5Dclose(dataset);
+
+    if( group >= 0 ) H5Gclose(group);
+  }
+
+  _sweep = _create_dataset(_file, "sweep", H5T_IEEE_F64LE, 1, true);
+
+  // the region datasets
+  hid_t regions = _writer ? H5Gcreate2(_file, "regions", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT) : -1;
+  _region_datasets.assign(system.n_regions(), std::vector<hid_t>(_fields.size(), -1));
+  _region_last_rows.assign(system.n_regions(), std::vector< std::vector<unsigned int> >(_fields.size()));
+  for( unsigned int r=0; r<system.n_regions(); r++)
+  {
+    const SimulationRegion * region = system.region(r);
+    const bool semiconductor = Material::IsSemiconductor(region->material());
+
+    hid_t group = _writer ? H5Gcreate2(regions, region->name().c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT) : -1;
+
+    std::vector<int> node_id;
+    SimulationRegion::const_processor_node_iterator node_it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator node_it_end = region->on_processor_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+      node_id.push_back((*node_it)->root_node()->id());
+
+    hid_t dataset = _create_dataset(group, "node_id", H5T_STD_I32LE, _region_rows[r], false);
+    _write_rows(dataset, H5T_NATIVE_INT, node_id, _region_offset[r], _region_rows[r]);
+    if( dataset >= 0 ) H5Dclose(dataset);
+
+    // empty region has no field dataset
+    if( _region_rows[r] )
+      for(unsigned int f=0; f<_fields.size(); ++f)
+      {
+        if( OutputField::semiconductor_only(_fields[f]) && !semiconductor ) continue;
+
+        // static field is written here as a 1D dataset, and never again
+        if( OutputField::is_static(_fields[f]) )
+        {
+          std::vector<float> data;
+          _region_field_values(region, system.solution_version(), _fields[f], data);
+          dataset = _create_dataset(group, OutputField::name(_fields[f]), H5T_IEEE_F32LE, _region_rows[r], false);
+          _write_rows(dataset, H5T_NATIVE_FLOAT, data, _region_offset[r], _region_rows[r]);
+          if( dataset >= 0 ) H5Dclose(dataset);
+          continue;
+        }
+
+        if( _delta )
+        {
+          _region_datasets[r][f] = _create_dataset(group, OutputField::name(_fields[f]), H5T_STD_U32LE, _region_rows[r], true);
+          // mark the dataset, reader should xor the rows up to the step it wants
+          if( _region_datasets[r][f] >= 0 )
+          {
+            const int xor_delta = 1;
+            hid_t space = H5Screate(H5S_SCALAR);
+            hid_t attr = H5Acreate2(_region_datasets[r][f], "xor_delta", H5T_STD_I32LE, space, H5P_DEFAULT, H5P_DEFAULT);
+            H5Awrite(attr, H5T_NATIVE_INT, &xor_delta);
+            H5Aclose(attr);
+            H5Sclose(space);
+          }
+        }
+        else
+          _region_datasets[r][f] = _create_dataset(group, OutputField::name(_fields[f]), H5T_IEEE_F32LE, _region_rows[r], true);
+      }
+
+    if( group >= 0 ) H5Gclose(group);
+  }
+  if( regions >= 0 ) H5Gclose(regions);
+
+  MESSAGE<<"ok" << std::endl; RECORD();
+}
+
+
+
+void HDF5Hook::_write_step(double value)
+{
+  const SimulationSystem &system = get_solver().get_system();
+
+  std::vector<double> sweep;
+  if( Genius::is_first_processor() ) sweep.push_back(value);
+  _write_rows(_sweep, H5T_NATIVE_DOUBLE, sweep, 0, 1, _n_step);
+
+  for( unsigned int r=0; r<system.n_regions(); r++)
+  {
+    if( !_region_rows[r] ) continue;
+
+    const SimulationRegion * region = system.region(r);
+    const bool semiconductor = Material::IsSemiconductor(region->material());
+
+    for(unsigned int f=0; f<_fields.size(); ++f)
+    {
+      if( OutputField::semiconductor_only(_fields[f]) && !semiconductor ) continue;
+      if( OutputField::is_static(_fields[f]) ) continue;
+
+      std::vector<float> data;
+      _region_field_values(region, system.solution_version(), _fields[f], data);
+
+      if( !_delta )
+      {
+        _write_rows(_region_datasets[r][f], H5T_NATIVE_FLOAT, data, _region_offset[r], _region_rows[r], _n_step);
+        continue;
+      }
+
+      // xor the bit pattern against the previous step, unchanged bits become zero.
+      // the first step xor against zero, which is the value itself
+      std::vector<unsigned int> & last = _region_last_rows[r][f];
+      last.resize(data.size(), 0);
+
+      std::vector<unsigned int> delta(data.size());
+      for(unsigned int i=0; i<data.size(); ++i)
+      {
+        const unsigned int bits = float_bits(data[i]);
+        delta[i] = bits ^ last[i];
+        last[i]  = bits;
+      }
+
+      _write_rows(_region_datasets[r][f], H5T_NATIVE_UINT, delta, _region_offset[r], _region_rows[r], _n_step);
+    }
+  }
+
+  if( _writer ) H5Fflush(_file, H5F_SCOPE_GLOBAL);
+
+  ++_n_step;
+
+  mxml_node_t *eSolution = get_solver().current_dom_solution_elem();
+  if ( eSolution )
+  {
+    mxml_node_t *eOutput  = mxmlFindElement ( eSolution, eSolution, "output", NULL, NULL, MXML_DESCEND_FIRST );
+    mxml_node_t *eHdf5 = mxmlNewElement ( eOutput, "hdf5" );
+    mxml_node_t *eFile    = mxmlNewElement ( eHdf5, "file" );
+    mxmlAdd ( eFile, MXML_ADD_AFTER, NULL, MXMLQVariant::makeQVString ( _filename ) );
+    mxml_node_t *eStep    = mxmlNewElement ( eHdf5, "step" );
+    mxmlAdd ( eStep, MXML_ADD_AFTER, NULL, MXMLQVariant::makeQVInt ( static_cast<int>(_n_step-1) ) );
+  }
+}
+
+
+
+template <typename T>
+void HDF5Hook::_write_rows(hid_t dataset, hid_t mem_type, std::vector<T> &data, hsize_t offset, hsize_t total, int step)
+{
+  if( !_parallel_io )
+  {
+    // the first processor collects all the rows, which are ordered by processor
+    Parallel::gather(0, data);
+    offset = 0;
+    if( !_writer ) return;
+  }
+
+  hsize_t count = data.size();
+
+  hsize_t start[2], block[2];
+  if( step < 0 )
+  {
+    start[0] = offset;  block[0] = count;
+  }
+  else
+  {
+    hsize_t dims[2] = { static_cast<hsize_t>(step+1), total };
+    H5Dset_extent(dataset, dims);
+    start[0] = step;    block[0] = 1;
+    start[1] = offset;  block[1] = count;
+  }
+
+  hid_t file_space = H5Dget_space(dataset);
+  hid_t mem_space  = H5Screate_simple(1, &count, NULL);
+  if( count )
+    H5Sselect_hyperslab(file_space, H5S_SELECT_SET, start, NULL, block, NULL);
+  else
+  {
+    H5Sselect_none(file_space);
+    H5Sselect_none(mem_space);
+  }
+
+  H5Dwrite(dataset, mem_type, mem_space, file_space, _dxpl, data.empty() ? NULL : &data[0]);
+
+  H5Sclose(mem_space);
+  H5Sclose(file_space);
+}
+
+
+
+hid_t HDF5Hook::_create_dataset(hid_t loc, const std::string &name, hid_t file_type, hsize_t rows, bool extendible)
+{
+  if( !_writer ) return -1;
+
+  hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+  hid_t space;
+  if( extendible )
+  {
+    // one chunk holds (part of) one step
+    hsize_t dims[2]    = { 0, rows };
+    hsize_t maxdims[2] = { H5S_UNLIMITED, rows };
+    hsize_t chunk[2]   = { 1, std::min(rows, static_cast<hsize_t>(1<<16)) };
+    space = H5Screate_simple(2, dims, maxdims);
+    H5Pset_chunk(dcpl, 2, chunk);
+
+    // filters need collective write, which is only supported since HDF5 1.10.2
+    bool compress = _compress && rows > 1 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0;
+#if !H5_VERSION_GE(1,10,2)
+    if( _parallel_io ) compress = false;
+#endif
+    if( compress )
+    {
+      H5Pset_shuffle(dcpl);
+      H5Pset_deflate(dcpl, 6);
+    }
+  }
+  else
+    space = H5Screate_simple(1, &rows, NULL);
+
+  hid_t dataset = H5Dcreate2(loc, name.c_str(), file_type, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+  genius_assert(dataset >= 0);
+
+  H5Sclose(space);
+  H5Pclose(dcpl);
+  return dataset;
+}
+
+
+
+void HDF5Hook::_region_field_values(const SimulationRegion * region, unsigned int version, unsigned int field, std::vector<float> &data)
+{
+  data.clear();
+  data.reserve(region->n_on_processor_node());
+
+  // the field is evaluated on local nodes and shared with other exports of the same solution,
+  // the on processor nodes are in the same order
+  const std::vector<float> & values = region->output_field(field, version);
+
+  SimulationRegion::const_local_node_iterator node_it = region->on_local_nodes_begin();
+  SimulationRegion::const_local_node_iterator node_it_end = region->on_local_nodes_end();
+  for(unsigned int n=0; node_it!=node_it_end; ++node_it, ++n)
+    if( (*node_it)->on_processor() )
+      data.push_back(values[n]);
+}
+
+
+#ifndef CYGWIN
+
+// dll interface
+extern "C"
+{
+  Hook* get_hook ( SolverBase & solver, const std::string & name, void * fun_data )
+  {
+    return new HDF5Hook ( solver, name, fun_data );
+  }
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <string>
+
+#include "solver_base.h"
+#include "metrics_hook.h"
+#include "metrics_server.h"
+
+
+/*----------------------------------------------------------------------
+ * constructor, start the metrics server on first use
+ */
+MetricsHook::MetricsHook(SolverBase & solver, const std::string & name, void * param)
+  : Hook(solver, name)
+{
+  std::string address = "0.0.0.0";
+  int port = 9464;
+  std::string gateway;
+  double interval = 15.0;
+
+  std::string job = Genius::input_file();
+  std::string::size_type slash = job.rfind('/');
+  if( slash != std::string::npos ) job = job.substr(slash+1);
+
+  if( param )
+  {
+    const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+    for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+          parm_it != parm_list.end(); parm_it++ )
+    {
+      if ( parm_it->name() == "port" && parm_it->type() == Parser::INTEGER )
+        port = parm_it->get_int();
+      if ( parm_it->name() == "bind" && parm_it->type() == Parser::STRING )
+        address = parm_it->get_string();
+      if ( parm_it->name() == "push" && parm_it->type() == Parser::STRING )
+        gateway = parm_it->get_string();
+      if ( parm_it->name() == "interval" && parm_it->type() == Parser::REAL )
+        interval = parm_it->get_real();
+      if ( parm_it->name() == "job" && parm_it->type() == Parser::STRING )
+        job = parm_it->get_string();
+    }
+  }
+
+  if( port <= 0 ) address.clear();
+
+  if( !MetricsServer::instance().started() )
+  {
+    MetricsServer::instance().start(address, port, gateway, interval, job);
+    if( !address.empty() )
+    {
+      MESSAGE<<"Solver metrics at http://" << address << ":" << port << "/metrics" << std::endl; RECORD();
+    }
+  }
+}
+
+
+
+#ifndef CYGWIN
+
+// dll interface
+extern "C"
+{
+  Hook* get_hook (SolverBase & solver, const std::string & name, void * fun_data)
+  {
+    return new MetricsHook(solver, name, fun_data );
+  }
+}
+
+#endif
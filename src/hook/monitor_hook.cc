@@ -21,6 +21,8 @@
 
 #include <cstdlib>
 #include <iomanip>
+#include <algorithm>
+#include <set>
 
 #include "mesh_base.h"
 #include "boundary_info.h"
@@ -54,6 +56,36 @@ using PhysicalUnit::A;
 using PhysicalUnit::K;
 
 
+namespace
+{
+  // the equations solved at nodes, as the norms reported by the solvers
+  enum { POISSON_EQ=0, ELEC_CONTINUITY_EQ, HOLE_CONTINUITY_EQ, HEAT_EQ, ELEC_ENERGY_EQ, HOLE_ENERGY_EQ, N_EQUATION };
+
+  const char * equation_names[N_EQUATION] =
+  { "poisson", "elec_continuity", "hole_continuity", "heat", "elec_energy", "hole_energy" };
+
+  // residual of one node, flattened to 6 doubles for parallel reduction
+  struct NodeSample
+  {
+    double abs_f;
+    double node;
+    double region;
+    double processor;
+    double x;
+    double dx;
+  };
+
+  // order for min-heap of the K largest residuals
+  struct SampleGreater
+  {
+    bool operator()(const NodeSample &a, const NodeSample &b) const
+    { return a.abs_f > b.abs_f; }
+  };
+
+  const unsigned int sample_size = sizeof(NodeSample)/sizeof(double);
+}
+
+
 #ifdef HAVE_VTK
 class MonitorHook::XMLUnstructuredGridWriter : public vtkXMLUnstructuredGridWriter
 {
@@ -87,7 +119,7 @@ private:
 /*----------------------------------------------------------------------
  * constructor, open the file for writing
  */
-MonitorHook::MonitorHook ( SolverBase & solver, const std::string & name, void * )
+MonitorHook::MonitorHook ( SolverBase & solver, const std::string & name, void * param )
     : Hook ( solver, name ),  mesh(solver.get_system().mesh())
 {
   this->_poisson_solver = false;
@@ -95,6 +127,28 @@ MonitorHook::MonitorHook ( SolverBase & solver, const std::string & name, void *
   this->solution_count=0;
   this->iteration_count=0;
   mesh.boundary_info->build_on_processor_side_list (el, sl, il);
+
+  _sample = false;
+  _topk   = 10;
+  _patch  = 0;
+  _report_file = SolverSpecify::out_prefix + ".monitor.log";
+
+  if( param )
+  {
+    const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+    for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+          parm_it != parm_list.end(); parm_it++ )
+    {
+      if ( parm_it->name() == "mode" && parm_it->type() == Parser::STRING )
+        _sample = (parm_it->get_string() == "sample");
+      if ( parm_it->name() == "topk" && parm_it->type() == Parser::INTEGER )
+        _topk = std::max(1, parm_it->get_int());
+      if ( parm_it->name() == "patch" && parm_it->type() == Parser::INTEGER )
+        _patch = std::max(0, parm_it->get_int());
+      if ( parm_it->name() == "file" && parm_it->type() == Parser::STRING )
+        _report_file = parm_it->get_string();
+    }
+  }
 }
 
 
@@ -129,6 +183,15 @@ void MonitorHook::on_init()
   {
     _ddm_solver = true;
   }
+
+  if( _sample && Genius::is_first_processor() && !_report.is_open() )
+  {
+    _report.open(_report_file.c_str(), std::ios::out | std::ios::app);
+    if( !_report.good() )
+    {
+      MESSAGE<<"Warning: MonitorHook can not open report file " << _report_file << std::endl; RECORD();
+    }
+  }
 }
 
 
@@ -162,6 +225,14 @@ void MonitorHook::post_iteration(void * f, void * x, void * dx, void * w, bool &
 
   const SimulationSystem &system = _solver.get_system();
 
+  if( _sample )
+  {
+    if( this->_ddm_solver || this->_poisson_solver )
+      _sample_iteration(f, x, dx);
+    this->iteration_count++;
+    return;
+  }
+
 #ifdef HAVE_VTK
   std::string vtk_prefix = SolverSpecify::out_prefix+".monitor";
   std::ostringstream vtk_filename;
@@ -226,7 +297,332 @@ void MonitorHook::post_iteration(void * f, void * x, void * dx, void * w, bool &
  * This is executed after the finalization of the solver
  */
 void MonitorHook::on_close()
-{}
+{
+  if( _report.is_open() )
+    _report.close();
+}
+
+
+
+void MonitorHook::_node_equations(const SimulationRegion * region, std::vector<std::pair<unsigned int, unsigned int> > &equations) const
+{
+  equations.clear();
+
+  if( region->type() == VacuumRegion ) return;
+  const bool semiconductor = (region->type() == SemiconductorRegion);
+
+  switch( _solver.solver_type() )
+  {
+  case SolverSpecify::EBML3     :
+  case SolverSpecify::EBML3MIXA :
+    {
+      equations.push_back( std::make_pair(static_cast<unsigned int>(POISSON_EQ), region->ebm_variable_offset(POTENTIAL)) );
+      if( semiconductor )
+      {
+        equations.push_back( std::make_pair(static_cast<unsigned int>(ELEC_CONTINUITY_EQ), region->ebm_variable_offset(ELECTRON)) );
+        equations.push_back( std::make_pair(static_cast<unsigned int>(HOLE_CONTINUITY_EQ), region->ebm_variable_offset(HOLE)) );
+      }
+      if( region->get_advanced_model()->enable_Tl() )
+        equations.push_back( std::make_pair(static_cast<unsigned int>(HEAT_EQ), region->ebm_variable_offset(TEMPERATURE)) );
+      if( semiconductor && region->get_advanced_model()->enable_Tn() )
+        equations.push_back( std::make_pair(static_cast<unsigned int>(ELEC_ENERGY_EQ), region->ebm_variable_offset(E_TEMP)) );
+      if( semiconductor && region->get_advanced_model()->enable_Tp() )
+        equations.push_back( std::make_pair(static_cast<unsigned int>(HOLE_ENERGY_EQ), region->ebm_variable_offset(H_TEMP)) );
+      break;
+    }
+  case SolverSpecify::POISSON :
+    {
+      equations.push_back( std::make_pair(static_cast<unsigned int>(POISSON_EQ), 0u) );
+      break;
+    }
+  default :
+    {
+      // DDML1 and DDML2: psi, n, p and T of DDML2 in semiconductor; psi and T of DDML2 in the others
+      const bool lattice_temperature = ( _solver.solver_type() == SolverSpecify::DDML2 ||
+                                         _solver.solver_type() == SolverSpecify::DDML2MIXA );
+      equations.push_back( std::make_pair(static_cast<unsigned int>(POISSON_EQ), 0u) );
+      if( semiconductor )
+      {
+        equations.push_back( std::make_pair(static_cast<unsigned int>(ELEC_CONTINUITY_EQ), 1u) );
+        equations.push_back( std::make_pair(static_cast<unsigned int>(HOLE_CONTINUITY_EQ), 2u) );
+      }
+      if( lattice_temperature )
+        equations.push_back( std::make_pair(static_cast<unsigned int>(HEAT_EQ), semiconductor ? 3u : 1u) );
+      break;
+    }
+  }
+}
+
+
+
+void MonitorHook::_sample_iteration(void * _f, void * _x, void * _dx)
+{
+  const SimulationSystem & system = _solver.get_system();
+
+  Vec f  = Vec(_f);  // previous function residual
+  Vec x  = Vec(_x);  // previous iterate value
+  Vec dx = Vec(_dx); // new search direction and length
+
+  PetscScalar *ff, *xx, *dxx;
+  VecGetArray(f, &ff);
+  VecGetArray(x, &xx);
+  VecGetArray(dx, &dxx);
+
+  // the global vectors, on processor dofs only
+  PetscInt start, end;
+  VecGetOwnershipRange(f, &start, &end);
+
+  const unsigned int n_regions = system.n_regions();
+
+  // sum of f^2 and dx^2 of each (region, equation)
+  std::vector<double> norms(2*N_EQUATION*n_regions, 0.0);
+
+  // the K largest residuals of each equation on this processor, kept as min-heap
+  std::vector< std::vector<NodeSample> > worst(N_EQUATION);
+
+  std::vector<std::pair<unsigned int, unsigned int> > equations;
+  for(unsigned int r=0; r<n_regions; r++)
+  {
+    const SimulationRegion * region = system.region(r);
+    _node_equations(region, equations);
+    if( equations.empty() ) continue;
+
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+    {
+      const FVM_Node * fvm_node = *it;
+      const unsigned int offset = fvm_node->global_offset() - start;
+
+      for(unsigned int e=0; e<equations.size(); ++e)
+      {
+        const unsigned int eq = equations[e].first;
+        const PetscScalar fv  = ff [offset + equations[e].second];
+        const PetscScalar dxv = dxx[offset + equations[e].second];
+        norms[2*(N_EQUATION*r + eq)    ] += fv*fv;
+        norms[2*(N_EQUATION*r + eq) + 1] += dxv*dxv;
+
+        std::vector<NodeSample> & heap = worst[eq];
+        if( heap.size() == _topk && std::abs(fv) <= heap.front().abs_f ) continue;
+
+        NodeSample sample;
+        sample.abs_f     = std::abs(fv);
+        sample.node      = fvm_node->root_node()->id();
+        sample.region    = r;
+        sample.processor = Genius::processor_id();
+        sample.x         = xx[offset + equations[e].second];
+        sample.dx        = dxv;
+
+        if( heap.size() == _topk )
+        {
+          std::pop_heap(heap.begin(), heap.end(), SampleGreater());
+          heap.back() = sample;
+        }
+        else
+          heap.push_back(sample);
+        std::push_heap(heap.begin(), heap.end(), SampleGreater());
+      }
+    }
+  }
+
+  // only the norms and K samples of each processor are reduced
+  Parallel::sum(norms);
+
+  std::vector< std::vector<NodeSample> > global_worst(N_EQUATION);
+  for(unsigned int eq=0; eq<N_EQUATION; ++eq)
+  {
+    std::vector<double> buffer(sample_size*worst[eq].size());
+    for(unsigned int k=0; k<worst[eq].size(); ++k)
+    {
+      const NodeSample & sample = worst[eq][k];
+      const double values[] = { sample.abs_f, sample.node, sample.region, sample.processor, sample.x, sample.dx };
+      std::copy(values, values+sample_size, buffer.begin() + sample_size*k);
+    }
+    Parallel::allgather(buffer);
+
+    for(unsigned int k=0; k<buffer.size()/sample_size; ++k)
+    {
+      const double * v = &buffer[sample_size*k];
+      NodeSample sample;
+      sample.abs_f = v[0]; sample.node = v[1]; sample.region = v[2]; sample.processor = v[3]; sample.x = v[4]; sample.dx = v[5];
+      global_worst[eq].push_back(sample);
+    }
+    std::sort(global_worst[eq].begin(), global_worst[eq].end(), SampleGreater());
+    if( global_worst[eq].size() > _topk )
+      global_worst[eq].resize(_topk);
+  }
+
+  if( _report.is_open() )
+  {
+    // the solution variable of each equation in the output unit
+    const double scale[N_EQUATION] = { V, pow(cm, -3), pow(cm, -3), K, 1.0, 1.0 };
+
+    std::ostream & out = _report;
+    out << "# solution " << this->solution_count << " iteration " << this->iteration_count << '\n';
+    out << std::scientific << std::setprecision(4);
+
+    out << "#   " << std::setw(24) << std::left << "region" << std::setw(18) << "equation"
+        << std::setw(14) << "|f|" << std::setw(14) << "|dx|" << std::right << '\n';
+    for(unsigned int r=0; r<n_regions; r++)
+    {
+      _node_equations(system.region(r), equations);
+      for(unsigned int e=0; e<equations.size(); ++e)
+      {
+        const unsigned int eq = equations[e].first;
+        out << "    " << std::setw(24) << std::left << system.region(r)->name() << std::setw(18) << equation_names[eq]
+            << std::setw(14) << std::sqrt(norms[2*(N_EQUATION*r + eq)])
+            << std::setw(14) << std::sqrt(norms[2*(N_EQUATION*r + eq) + 1]/(scale[eq]*scale[eq])) << std::right << '\n';
+      }
+    }
+
+    for(unsigned int eq=0; eq<N_EQUATION; ++eq)
+    {
+      if( global_worst[eq].empty() ) continue;
+      out << "#   worst " << equation_names[eq] << ": node region x(um) y(um) z(um) |f| x dx\n";
+      for(unsigned int k=0; k<global_worst[eq].size(); ++k)
+      {
+        const NodeSample & sample = global_worst[eq][k];
+        const Point & p = mesh.point(static_cast<unsigned int>(sample.node));
+        out << "    " << static_cast<unsigned int>(sample.node) << ' '
+            << system.region(static_cast<unsigned int>(sample.region))->name() << ' '
+            << p(0)/um << ' ' << p(1)/um << ' ' << p(2)/um << ' '
+            << sample.abs_f << ' ' << sample.x/scale[eq] << ' ' << sample.dx/scale[eq] << '\n';
+      }
+    }
+    out.flush();
+  }
+
+  // the owner of the worst node of each equation writes the elements around it
+  if( _patch )
+    for(unsigned int eq=0; eq<N_EQUATION; ++eq)
+    {
+      if( global_worst[eq].empty() ) continue;
+      const NodeSample & sample = global_worst[eq].front();
+      if( static_cast<unsigned int>(sample.processor) != Genius::processor_id() ) continue;
+      _write_patch(system.region(static_cast<unsigned int>(sample.region)), static_cast<unsigned int>(sample.node), eq,
+                   ff, xx, dxx, start);
+    }
+
+  VecRestoreArray(f, &ff);
+  VecRestoreArray(x, &xx);
+  VecRestoreArray(dx, &dxx);
+}
+
+
+
+void MonitorHook::_write_patch(const SimulationRegion * region, unsigned int node, unsigned int equation,
+                               const PetscScalar *ff, const PetscScalar *xx, const PetscScalar *dxx, PetscInt start) const
+{
+  // grow the patch by layers of the local region elements touching it
+  std::set<unsigned int> patch_nodes;
+  patch_nodes.insert(node);
+  std::vector<const Elem *> patch_elems;
+  std::vector<bool> in_patch(region->n_cell(), false);
+  for(unsigned int layer=0; layer<_patch; ++layer)
+  {
+    std::vector<unsigned int> new_nodes;
+    for(unsigned int c=0; c<region->n_cell(); ++c)
+    {
+      if( in_patch[c] ) continue;
+      const Elem * elem = region->get_region_elem(c);
+      bool touch = false;
+      for(unsigned int i=0; i<elem->n_vertices() && !touch; ++i)
+        touch = patch_nodes.count(elem->get_node(i)->id()) > 0;
+      if( !touch ) continue;
+
+      in_patch[c] = true;
+      patch_elems.push_back(elem);
+      for(unsigned int i=0; i<elem->n_vertices(); ++i)
+        new_nodes.push_back(elem->get_node(i)->id());
+    }
+    patch_nodes.insert(new_nodes.begin(), new_nodes.end());
+  }
+
+  std::vector<unsigned int> nodes(patch_nodes.begin(), patch_nodes.end());
+  std::map<unsigned int, unsigned int> node_index;
+  for(unsigned int n=0; n<nodes.size(); ++n)
+    node_index[nodes[n]] = n;
+
+  std::ostringstream filename;
+  filename << SolverSpecify::out_prefix << ".monitor." << this->solution_count << '.' << this->iteration_count
+           << '.' << equation_names[equation] << ".vtk";
+
+  std::ofstream out(filename.str().c_str());
+  if( !out.good() ) return;
+
+  out << "# vtk DataFile Version 3.0\n";
+  out << "MonitorHook worst " << equation_names[equation] << " residual at node " << node << '\n';
+  out << "ASCII\nDATASET UNSTRUCTURED_GRID\n";
+
+  out << "POINTS " << nodes.size() << " float\n";
+  for(unsigned int n=0; n<nodes.size(); ++n)
+  {
+    const Point & p = mesh.point(nodes[n]);
+    out << p(0)/um << ' ' << p(1)/um << ' ' << p(2)/um << '\n';
+  }
+
+  unsigned int cell_size = 0;
+  for(unsigned int c=0; c<patch_elems.size(); ++c)
+    cell_size += patch_elems[c]->n_vertices() + 1;
+  out << "CELLS " << patch_elems.size() << ' ' << cell_size << '\n';
+  for(unsigned int c=0; c<patch_elems.size(); ++c)
+  {
+    const Elem * elem = patch_elems[c];
+    out << elem->n_vertices();
+    for(unsigned int i=0; i<elem->n_vertices(); ++i)
+      out << ' ' << node_index[elem->get_node(i)->id()];
+    out << '\n';
+  }
+
+  // linear vtk cell types by number of vertices and dimension
+  out << "CELL_TYPES " << patch_elems.size() << '\n';
+  for(unsigned int c=0; c<patch_elems.size(); ++c)
+  {
+    const Elem * elem = patch_elems[c];
+    int type = 1;
+    switch( elem->n_vertices() )
+    {
+    case 2 : type = 3;  break;                          // line
+    case 3 : type = 5;  break;                          // triangle
+    case 4 : type = elem->dim() == 2 ? 9 : 10; break;   // quad or tetra
+    case 5 : type = 14; break;                          // pyramid
+    case 6 : type = 13; break;                          // wedge
+    case 8 : type = 12; break;                          // hexahedron
+    }
+    out << type << '\n';
+  }
+
+  // residual, solution and update at the on processor nodes, zero elsewhere
+  std::vector<std::pair<unsigned int, unsigned int> > equations;
+  _node_equations(region, equations);
+
+  std::vector<const FVM_Node *> fvm_nodes(nodes.size());
+  for(unsigned int n=0; n<nodes.size(); ++n)
+  {
+    const FVM_Node * fvm_node = region->region_fvm_node(nodes[n]);
+    fvm_nodes[n] = (fvm_node && fvm_node->on_processor()) ? fvm_node : 0;
+  }
+
+  out << "POINT_DATA " << nodes.size() << '\n';
+  out << "SCALARS on_processor int 1\nLOOKUP_TABLE default\n";
+  for(unsigned int n=0; n<nodes.size(); ++n)
+    out << (fvm_nodes[n] ? 1 : 0) << '\n';
+
+  const char * kinds[3] = { "f", "x", "dx" };
+  const PetscScalar * arrays[3] = { ff, xx, dxx };
+  for(unsigned int e=0; e<equations.size(); ++e)
+    for(unsigned int k=0; k<3; ++k)
+    {
+      out << "SCALARS " << kinds[k] << '_' << equation_names[equations[e].first] << " double 1\nLOOKUP_TABLE default\n";
+      for(unsigned int n=0; n<nodes.size(); ++n)
+      {
+        double value = 0.0;
+        if( fvm_nodes[n] )
+          value = arrays[k][fvm_nodes[n]->global_offset() - start + equations[e].second];
+        out << value << '\n';
+      }
+    }
+}
 
 
 //---------------------------------------------------------------------
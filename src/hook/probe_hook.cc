@@ -22,7 +22,14 @@
 #include <string>
 #include <cstdlib>
 #include <iomanip>
-
+#include <fstream>
+#include <sstream>
+
+#include "elem.h"
+#include "mesh_base.h"
+#include "point_locator_base.h"
+#include "fe_type.h"
+#include "fe_interface.h"
 #include "solver_base.h"
 #include "probe_hook.h"
 #include "parallel.h"
@@ -35,21 +42,28 @@ ProbeHook::ProbeHook(SolverBase & solver, const std::string & name, void * param
     : Hook(solver, name), _probe_file(SolverSpecify::out_prefix + ".probe")
 {
   _p_solver = & solver;
-  _p_fvm_node   = NULL;
-  _min_loc = invalid_uint;
+
+  Point pp;
+  bool single_point = false;
 
   const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
   for(std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
       parm_it != parm_list.end(); parm_it++)
   {
     if(parm_it->name() == "x" && parm_it->type() == Parser::REAL)
-      _pp(0)=parm_it->get_real() * PhysicalUnit::um;
+    { pp(0)=parm_it->get_real() * PhysicalUnit::um; single_point = true; }
     if(parm_it->name() == "y" && parm_it->type() == Parser::REAL)
-      _pp(1)=parm_it->get_real() * PhysicalUnit::um;
+    { pp(1)=parm_it->get_real() * PhysicalUnit::um; single_point = true; }
     if(parm_it->name() == "z" && parm_it->type() == Parser::REAL)
-      _pp(2)=parm_it->get_real() * PhysicalUnit::um;
+    { pp(2)=parm_it->get_real() * PhysicalUnit::um; single_point = true; }
+    if(parm_it->name() == "points" && parm_it->type() == Parser::STRING)
+      _parse_points(parm_it->get_string());
+    if(parm_it->name() == "pointfile" && parm_it->type() == Parser::STRING)
+      _read_points(parm_it->get_string());
   }
 
+  if( single_point || _points.empty() )
+    _points.insert(_points.begin(), pp);
 
   if ( !Genius::processor_id() )
     _out.open(_probe_file.c_str());
@@ -67,82 +81,109 @@ ProbeHook::~ProbeHook()
 }
 
 
+
+void ProbeHook::_parse_points(const std::string &str)
+{
+  std::stringstream ss(str);
+  std::string point;
+  while( std::getline(ss, point, ';') )
+  {
+    for(unsigned int i=0; i<point.size(); ++i)
+      if( point[i] == ',' ) point[i] = ' ';
+    std::stringstream ps(point);
+    Real x=0, y=0, z=0;
+    if( !(ps >> x) ) continue;
+    ps >> y >> z;
+    _points.push_back( Point(x*PhysicalUnit::um, y*PhysicalUnit::um, z*PhysicalUnit::um) );
+  }
+}
+
+
+
+void ProbeHook::_read_points(const std::string &file)
+{
+  std::ifstream in(file.c_str());
+  if( !in.good() )
+  {
+    MESSAGE<<"Warning: ProbeHook can not open point file " << file << std::endl; RECORD();
+    return;
+  }
+
+  std::string line;
+  while( std::getline(in, line) )
+  {
+    if( line.empty() || line[0] == '#' ) continue;
+    std::stringstream ps(line);
+    Real x=0, y=0, z=0;
+    if( !(ps >> x) ) continue;
+    ps >> y >> z;
+    _points.push_back( Point(x*PhysicalUnit::um, y*PhysicalUnit::um, z*PhysicalUnit::um) );
+  }
+}
+
+
+
 /*----------------------------------------------------------------------
  *   This is executed before the initialization of the solver
  */
 void ProbeHook::on_init()
 {
+  const SimulationSystem & system = _p_solver->get_system();
+  const MeshBase & mesh = system.mesh();
+
+  // the mesh is the same on all the processors, so is the element found for each probe.
+  // only the node data of on processor nodes are recorded, each node is counted once.
+  const PointLocatorBase & locator = mesh.point_locator();
+  const FEType fe_type(FIRST, LAGRANGE);
 
-  double min_dis = 1e100;
-  for( unsigned int r=0; r<_p_solver->get_system().n_regions(); r++)
+  _elems.clear();
+  _weight_offset.assign(1, 0);
+  _weights.clear();
+  _node_data.clear();
+
+  std::vector<const Elem *> elems;
+  locator.locate_batch(_points, elems);
+
+  for(unsigned int k=0; k<_points.size(); ++k)
   {
-    const SimulationRegion * region = _p_solver->get_system().region(r);
+    const Elem * elem = elems[k];
+    _elems.push_back(elem);
 
-    SimulationRegion::const_local_node_iterator node_it = region->on_local_nodes_begin();
-    SimulationRegion::const_local_node_iterator node_it_end = region->on_local_nodes_end();
-    for(; node_it!=node_it_end; ++node_it)
+    if( elem )
     {
-      const FVM_Node * fvm_node = *node_it;
-      const Node * node = fvm_node->root_node();
-
-      double dis = ((*node)-_pp).size();
-      if(dis<min_dis)
+      const SimulationRegion * region = system.region(elem->subdomain_id());
+      const unsigned int dim = elem->dim();
+      const Point ref_point = FEInterface::inverse_map(dim, fe_type, elem, _points[k], TOLERANCE, false);
+      const unsigned int n_shape = FEInterface::n_shape_functions(dim, fe_type, elem->type());
+      for(unsigned int i=0; i<n_shape; ++i)
       {
-        min_dis = dis;
-        _p_fvm_node = fvm_node;
+        const FVM_Node * fvm_node = region->region_fvm_node(elem->get_node(i));
+        _weights.push_back( FEInterface::shape(dim, fe_type, elem->type(), i, ref_point) );
+        _node_data.push_back( (fvm_node && fvm_node->on_processor()) ? fvm_node->node_data() : NULL );
       }
     }
+    _weight_offset.push_back(_weights.size());
   }
 
-  // after this call, the _min_loc contains processor_id with minimal min_dis
-  Parallel::min_loc(min_dis, _min_loc);
-
-  double x,y,z;
-  std::vector<std::string> var_name;
-  int n_var;
-
-  x = (*_p_fvm_node->root_node())(0);
-  y = (*_p_fvm_node->root_node())(1);
-  z = (*_p_fvm_node->root_node())(2);
-  Parallel::broadcast(x, _min_loc);
-  Parallel::broadcast(y, _min_loc);
-  Parallel::broadcast(z, _min_loc);
-
-  if (Genius::processor_id() == _min_loc)
+  if ( !Genius::processor_id() )
   {
-    const FVM_NodeData * node_data = _p_fvm_node->node_data();
-    switch (node_data->type())
+    for(unsigned int k=0; k<_points.size(); ++k)
     {
-      case FVM_NodeData::SemiconductorData:
-        n_var = 3;
-        var_name.push_back("psi (V)");
-        var_name.push_back("n (cm^-3)");
-        var_name.push_back("p (cm^-3)");
-        break;
-      case FVM_NodeData::InsulatorData:
-      case FVM_NodeData::ConductorData:
-        n_var = 1;
-        var_name.push_back("potenial (V)");
-        break;
-      default:
-        n_var = 0;
+      _out << "# probe " << k << " at x=" << _points[k](0)/PhysicalUnit::um << "\ty=" << _points[k](1)/PhysicalUnit::um
+           << "\tz=" << _points[k](2)/PhysicalUnit::um;
+      if( _elems[k] )
+        _out << "\tregion " << system.region(_elems[k]->subdomain_id())->name() << std::endl;
+      else
+        _out << "\tout of mesh" << std::endl;
     }
 
-  }
-
-  Parallel::broadcast(n_var, _min_loc);
-  var_name.resize(n_var);
-  for(int i=0; i<n_var; i++)
-    Parallel::broadcast(var_name[i], _min_loc);
-
-  if ( !Genius::processor_id() )
-  {
-    _out << "Nearest node is at  : ";
-    _out << "x=" << x/PhysicalUnit::um << "\ty=" << y/PhysicalUnit::um << "\tz=" << z/PhysicalUnit::um << std::endl;
-
-    for(int i=0; i<n_var; i++)
+    for(unsigned int k=0; k<_points.size(); ++k)
     {
-      _out << std::setw(15) << var_name[i];
+      std::stringstream ss;
+      ss << '[' << k << ']';
+      _out << std::setw(15) << "psi" + ss.str() + "(V)"
+           << std::setw(15) << "n"   + ss.str() + "(cm^-3)"
+           << std::setw(15) << "p"   + ss.str() + "(cm^-3)";
     }
     _out << std::endl;
   }
@@ -162,34 +203,28 @@ void ProbeHook::pre_solve()
  */
 void ProbeHook::post_solve()
 {
-  int n_var;
-  std::vector<double> var;
-  if (Genius::processor_id() == _min_loc)
-  {
-    const FVM_NodeData * node_data = _p_fvm_node->node_data();
-    switch (node_data->type())
+  // psi, n, p of each probe, summed over the on processor nodes of its element
+  std::vector<Real> var(3*_points.size(), 0.0);
+  for(unsigned int k=0; k<_points.size(); ++k)
+    for(unsigned int i=_weight_offset[k]; i<_weight_offset[k+1]; ++i)
     {
-      case FVM_NodeData::SemiconductorData:
-        n_var = 3;
-        var.push_back(node_data->psi());
-        var.push_back(node_data->n());
-        var.push_back(node_data->p());
-        break;
-      case FVM_NodeData::InsulatorData:
-      case FVM_NodeData::ConductorData:
-        n_var = 1;
-        var.push_back(node_data->psi());
-        break;
-      default:
-        n_var = 0;
+      const FVM_NodeData * node_data = _node_data[i];
+      if( !node_data ) continue;
+
+      const Real w = _weights[i];
+      var[3*k+0] += w*node_data->psi();
+      if( node_data->type() == FVM_NodeData::SemiconductorData )
+      {
+        var[3*k+1] += w*node_data->n();
+        var[3*k+2] += w*node_data->p();
+      }
     }
-  }
 
-  var.resize(n_var);
-  Parallel::broadcast(n_var,_min_loc);
+  Parallel::sum(var);
 
   if ( !Genius::processor_id() )
   {
+    const Real concentration_scale = std::pow(PhysicalUnit::cm, -3);
 
     // set the float number precision
     _out.precision(6);
@@ -197,9 +232,12 @@ void ProbeHook::post_solve()
     // set output width and format
     _out<< std::scientific << std::right;
 
-    //_out << std::setw(15) << SolverSpecify::clock;
-    for(unsigned int i=0; i<var.size(); i++)
-      _out << std::setw(15) << var[i];
+    for(unsigned int k=0; k<_points.size(); ++k)
+    {
+      _out << std::setw(15) << var[3*k+0]/PhysicalUnit::V
+           << std::setw(15) << var[3*k+1]/concentration_scale
+           << std::setw(15) << var[3*k+2]/concentration_scale;
+    }
 
     _out << std::endl;
   }
@@ -0,0 +1,382 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cstdlib>
+
+#include "solver_base.h"
+#include "ddm_solver.h"
+#include "parser.h"
+#include "parallel.h"
+#include "sensitivity_hook.h"
+
+/*
+ * usage: HOOK Load=sensitivity string<region>=(region_name) string<pmi>=(basic|band|mobility|impact|...)
+ *             string<parameters>=(comma separated parameter names) string<electrodes>=(comma separated labels)
+ *             bool<doping>=(true|false) int<instances>=(n) int<seed>=(n)
+ * the dI/dp of each electrode to each parameter is written to <out_prefix>.sens at every converged
+ * steadystate/dcsweep point, in A per the unit of parameter in the PMI card.
+ * with doping, the impedance field dI/dN [A*cm^3] of each semiconductor node is written to <out_prefix>.ifm<step>,
+ * the current deviation of random dopant fluctuation estimated by it is added to <out_prefix>.sens.
+ * with instances>0, so many random doping instances are solved at each point, their current deviation
+ * is added to <out_prefix>.sens as well.
+ */
+
+static std::vector<std::string> split_list(const std::string & list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while( std::getline(ss, item, ',') )
+  {
+    const std::string::size_type begin = item.find_first_not_of(" \t");
+    if( begin == std::string::npos ) continue;
+    const std::string::size_type end = item.find_last_not_of(" \t");
+    items.push_back(item.substr(begin, end-begin+1));
+  }
+  return items;
+}
+
+
+/**
+ * uniform random number in (0, 1)
+ */
+static double uniform_random()
+{ return (std::rand() + 0.5)/(RAND_MAX + 1.0); }
+
+
+/**
+ * Poisson distributed dopant number of mean mu, normal approximation for large mu
+ */
+static double poisson_random(double mu)
+{
+  if( mu <= 0.0 ) return 0.0;
+
+  if( mu > 30.0 )
+  {
+    const double g = std::sqrt(-2.0*std::log(uniform_random()))*std::cos(2*3.14159265358979323846*uniform_random());
+    return std::max(0.0, std::floor(mu + std::sqrt(mu)*g + 0.5));
+  }
+
+  const double L = std::exp(-mu);
+  double k = 0.0, p = uniform_random();
+  while( p > L )
+  {
+    k += 1.0;
+    p *= uniform_random();
+  }
+  return k;
+}
+
+
+/*----------------------------------------------------------------------
+ * constructor, open the sens file for writing
+ */
+SensitivityHook::SensitivityHook(SolverBase & solver, const std::string & name, void * param)
+    : Hook(solver, name), _pmi("mobility"), _doping(false), _instances(0), _seed(0), _step(0),
+      _sens_file(SolverSpecify::out_prefix + ".sens"), _enabled(true)
+{
+  const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+  for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+        parm_it != parm_list.end(); parm_it++ )
+  {
+    if ( parm_it->name() == "region" && parm_it->type() == Parser::STRING )
+      _region = parm_it->get_string();
+    if ( parm_it->name() == "pmi" && parm_it->type() == Parser::STRING )
+      _pmi = parm_it->get_string();
+    if ( parm_it->name() == "parameters" && parm_it->type() == Parser::STRING )
+      _parameters = split_list(parm_it->get_string());
+    if ( parm_it->name() == "electrodes" && parm_it->type() == Parser::STRING )
+      _electrode_labels = split_list(parm_it->get_string());
+    if ( parm_it->name() == "doping" && parm_it->type() == Parser::BOOL )
+      _doping = parm_it->get_bool();
+    if ( parm_it->name() == "instances" && parm_it->type() == Parser::INTEGER )
+      _instances = std::max(0, parm_it->get_int());
+    if ( parm_it->name() == "seed" && parm_it->type() == Parser::INTEGER )
+      _seed = std::max(0, parm_it->get_int());
+  }
+
+  if( _instances ) _doping = true;
+
+  if ( !Genius::processor_id() )
+    _out.open(_sens_file.c_str());
+}
+
+
+/*----------------------------------------------------------------------
+ * destructor, close the sens file
+ */
+SensitivityHook::~SensitivityHook()
+{ _out.close(); }
+
+
+/*----------------------------------------------------------------------
+ *   This is executed before the initialization of the solver
+ */
+void SensitivityHook::on_init()
+{
+  // the jacobian with fixed electrode potential is the one of IV trace
+  if( !dynamic_cast<DDMSolverBase *>(&_solver) ||
+      !( SolverSpecify::Solver == SolverSpecify::DDML1 ||
+         SolverSpecify::Solver == SolverSpecify::DDML2 ||
+         SolverSpecify::Solver == SolverSpecify::EBML3 ) )
+  {
+    MESSAGE<<"Warning: Sensitivity hook: only DDML1, DDML2 and EBML3 solvers are supported." << std::endl; RECORD();
+    _enabled = false;
+    return;
+  }
+
+  if( !_doping && ( _region.empty() || _parameters.empty() ) )
+  {
+    MESSAGE<<"Warning: Sensitivity hook: region and parameters, or doping should be given." << std::endl; RECORD();
+    _enabled = false;
+    return;
+  }
+
+  BoundaryConditionCollector * bcs = _solver.get_system().get_bcs();
+  _electrodes.clear();
+  if( _electrode_labels.empty() )
+  {
+    for(unsigned int n=0; n<bcs->n_bcs(); n++)
+      if( bcs->get_bc(n)->is_electrode() )
+        _electrodes.push_back(bcs->get_bc(n));
+  }
+  else
+  {
+    for(unsigned int n=0; n<_electrode_labels.size(); n++)
+    {
+      BoundaryCondition * bc = bcs->get_bc_nocase(_electrode_labels[n]);
+      if( bc == NULL || !bc->is_electrode() )
+      {
+        MESSAGE<<"Warning: Sensitivity hook: " << _electrode_labels[n] << " is not an electrode, skipped." << std::endl; RECORD();
+        continue;
+      }
+      _electrodes.push_back(bc);
+    }
+  }
+
+  std::srand(_seed);
+
+  if ( !Genius::processor_id() )
+  {
+    _out << "# Title: Current Sensitivity Created by Genius TCAD Simulation" << std::endl;
+    if( !_parameters.empty() )
+      _out << "# Region: " << _region << "  PMI: " << _pmi << std::endl;
+
+    unsigned int column = 1;
+    for(unsigned int e=0; e<_electrodes.size(); e++)
+      _out << "#\t" << column++ << "\tV(" << _electrodes[e]->label() << ") [V]" << std::endl;
+    for(unsigned int e=0; e<_electrodes.size(); e++)
+      _out << "#\t" << column++ << "\tI(" << _electrodes[e]->label() << ") [A]" << std::endl;
+    for(unsigned int e=0; e<_electrodes.size(); e++)
+      for(unsigned int k=0; k<_parameters.size(); k++)
+        _out << "#\t" << column++ << "\tdI(" << _electrodes[e]->label() << ")/d(" << _parameters[k] << ")" << std::endl;
+    if( _doping )
+      for(unsigned int e=0; e<_electrodes.size(); e++)
+        _out << "#\t" << column++ << "\tsigma_ifm(" << _electrodes[e]->label() << ") [A]" << std::endl;
+    if( _instances )
+      for(unsigned int e=0; e<_electrodes.size(); e++)
+        _out << "#\t" << column++ << "\tsigma_rdf(" << _electrodes[e]->label() << ") [A]" << std::endl;
+    _out << std::endl;
+    _out << std::scientific << std::setprecision(8);
+  }
+}
+
+
+
+/*----------------------------------------------------------------------
+ *   This is executed previously to each solution step.
+ */
+void SensitivityHook::pre_solve()
+{
+}
+
+
+
+/*----------------------------------------------------------------------
+ *  This is executed after each solution step.
+ */
+void SensitivityHook::post_solve()
+{
+  if( !_enabled ) return;
+
+  if( SolverSpecify::Type != SolverSpecify::STEADYSTATE && SolverSpecify::Type != SolverSpecify::DCSWEEP ) return;
+
+  DDMSolverBase * solver = dynamic_cast<DDMSolverBase *>(&_solver);
+  std::vector<std::vector<PetscScalar> > dIdp;
+  if( !_parameters.empty() && !solver->current_sensitivity(_electrodes, _region, _pmi, _parameters, dIdp) )
+  {
+    MESSAGE<<"Warning: Sensitivity hook: failed to evaluate the sensitivity to " << _pmi << " parameters of region " << _region << "." << std::endl; RECORD();
+    return;
+  }
+
+  std::vector<double> sigma_ifm, sigma_instance;
+  if( _doping )
+    _doping_sensitivity(sigma_ifm, sigma_instance);
+  _step++;
+
+  if ( !Genius::processor_id() )
+  {
+    for(unsigned int e=0; e<_electrodes.size(); e++)
+      _out << _electrodes[e]->ext_circuit()->potential()/PhysicalUnit::V << '\t';
+    for(unsigned int e=0; e<_electrodes.size(); e++)
+      _out << _electrodes[e]->ext_circuit()->current()/PhysicalUnit::A << '\t';
+    for(unsigned int e=0; e<_electrodes.size(); e++)
+      for(unsigned int k=0; k<_parameters.size(); k++)
+        _out << dIdp[e][k]/PhysicalUnit::A << '\t';
+    for(unsigned int e=0; e<sigma_ifm.size(); e++)
+      _out << sigma_ifm[e]/PhysicalUnit::A << '\t';
+    for(unsigned int e=0; e<sigma_instance.size(); e++)
+      _out << sigma_instance[e]/PhysicalUnit::A << '\t';
+    _out << std::endl;
+  }
+}
+
+
+
+/*----------------------------------------------------------------------
+ * the impedance field of doping, and the current deviation estimated by it.
+ * the random doping instances are solved when required
+ */
+void SensitivityHook::_doping_sensitivity(std::vector<double> & sigma_ifm, std::vector<double> & sigma_instance)
+{
+  DDMSolverBase * solver = dynamic_cast<DDMSolverBase *>(&_solver);
+  const unsigned int n_electrodes = _electrodes.size();
+
+  std::vector<FVM_Node *> nodes;
+  std::vector<std::vector<PetscScalar> > dIdN;
+  if( !solver->doping_sensitivity(_electrodes, nodes, dIdN) )
+  {
+    MESSAGE<<"Warning: Sensitivity hook: failed to evaluate the impedance field of doping." << std::endl; RECORD();
+    return;
+  }
+
+  // var(N_i) = N_i/volume_i for Poisson distributed dopant number N_i*volume_i
+  sigma_ifm.assign(n_electrodes, 0.0);
+  for(unsigned int e=0; e<n_electrodes; e++)
+    for(unsigned int i=0; i<nodes.size(); i++)
+    {
+      const FVM_NodeData * node_data = nodes[i]->node_data();
+      sigma_ifm[e] += dIdN[e][i]*dIdN[e][i]*node_data->Total_doping()/nodes[i]->volume();
+    }
+  Parallel::sum(sigma_ifm);
+  for(unsigned int e=0; e<n_electrodes; e++)
+    sigma_ifm[e] = std::sqrt(sigma_ifm[e]);
+
+  // the impedance field of each node, one file per processor
+  {
+    std::stringstream fname;
+    fname << SolverSpecify::out_prefix << ".ifm" << _step;
+    if( Genius::n_processors() > 1 ) fname << '.' << Genius::processor_id();
+    std::ofstream out(fname.str().c_str());
+    out << "# x [um]\ty [um]\tz [um]\tnet doping [cm^-3]";
+    for(unsigned int e=0; e<n_electrodes; e++)
+      out << "\tdI(" << _electrodes[e]->label() << ")/dN [A*cm^3]";
+    out << std::endl;
+    out << std::scientific << std::setprecision(8);
+
+    const double conc = std::pow(PhysicalUnit::cm, -3);
+    for(unsigned int i=0; i<nodes.size(); i++)
+    {
+      const Point & p = *(nodes[i]->root_node());
+      out << p(0)/PhysicalUnit::um << '\t' << p(1)/PhysicalUnit::um << '\t' << p(2)/PhysicalUnit::um << '\t'
+          << nodes[i]->node_data()->Net_doping()/conc;
+      for(unsigned int e=0; e<n_electrodes; e++)
+        out << '\t' << dIdN[e][i]/(PhysicalUnit::A/conc);
+      out << std::endl;
+    }
+  }
+
+  if( !_instances ) return;
+
+  // random doping instances, the dopant number of each control volume is Poisson distributed
+  std::vector<double> sum(n_electrodes, 0.0), sum2(n_electrodes, 0.0);
+  unsigned int n_converged = 0;
+  std::vector<PetscScalar> dNd(nodes.size()), dNa(nodes.size());
+  for(unsigned int m=0; m<_instances; m++)
+  {
+    for(unsigned int i=0; i<nodes.size(); i++)
+    {
+      const FVM_NodeData * node_data = nodes[i]->node_data();
+      const double volume = nodes[i]->volume();
+      dNd[i] = poisson_random(node_data->Total_Nd()*volume)/volume - node_data->Total_Nd();
+      dNa[i] = poisson_random(node_data->Total_Na()*volume)/volume - node_data->Total_Na();
+    }
+
+    std::vector<PetscScalar> I;
+    if( !solver->doping_instance_solve(nodes, dNd, dNa, _electrodes, I) )
+    {
+      MESSAGE<<"Warning: Sensitivity hook: doping instance " << m << " not converged, skipped." << std::endl; RECORD();
+      continue;
+    }
+    for(unsigned int e=0; e<n_electrodes; e++)
+    {
+      sum[e]  += I[e];
+      sum2[e] += I[e]*I[e];
+    }
+    n_converged++;
+  }
+
+  if( n_converged < 2 ) return;
+
+  sigma_instance.assign(n_electrodes, 0.0);
+  for(unsigned int e=0; e<n_electrodes; e++)
+  {
+    const double mean = sum[e]/n_converged;
+    sigma_instance[e] = std::sqrt(std::max(0.0, (sum2[e] - n_converged*mean*mean)/(n_converged-1)));
+  }
+}
+
+
+
+/*----------------------------------------------------------------------
+ *  This is executed after each (nonlinear) iteration
+ */
+void SensitivityHook::post_iteration()
+{
+}
+
+
+
+/*----------------------------------------------------------------------
+ * This is executed after the finalization of the solver
+ */
+void SensitivityHook::on_close()
+{
+}
+
+
+#ifndef CYGWIN
+
+// dll interface
+extern "C"
+{
+  Hook* get_hook (SolverBase & solver, const std::string & name, void * fun_data)
+  {
+    return new SensitivityHook(solver, name, fun_data );
+  }
+
+}
+
+#endif
@@ -21,38 +21,88 @@
 
 #include <string>
 #include <cstdlib>
+#include <algorithm>
 
 #include "solver_base.h"
 #include "shell_hook.h"
+#include "async_exec.h"
 
 
 /*----------------------------------------------------------------------
- *   This is executed before the initialization of the solver
+ * constructor, read the hook parameters
  */
-void ShellHook::on_init()
+ShellHook::ShellHook(SolverBase & solver, const std::string & name, void * param)
+  : Hook(solver, name), _async(true), _wait(false)
 {
-  // only root processor do this command
-  if ( !Genius::processor_id() )
+  unsigned int jobs = 0;
+  bool set_jobs = false;
+
+  if( param )
   {
-    std::string exec_cmd = _command + " -init ";
-    system(exec_cmd.c_str());
+    const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+    for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+          parm_it != parm_list.end(); parm_it++ )
+    {
+      if ( parm_it->name() == "command" && parm_it->type() == Parser::STRING )
+        _command = parm_it->get_string();
+      if ( parm_it->name() == "async" && parm_it->type() == Parser::BOOL )
+        _async = parm_it->get_bool();
+      if ( parm_it->name() == "wait" && parm_it->type() == Parser::BOOL )
+        _wait = parm_it->get_bool();
+      if ( parm_it->name() == "jobs" && parm_it->type() == Parser::INTEGER )
+      {
+        jobs = std::max(0, parm_it->get_int());
+        set_jobs = true;
+      }
+    }
   }
-}
 
+  if( _command.empty() )
+  {
+    MESSAGE<<"Warning: ShellHook " << name << " has no command." << std::endl; RECORD();
+  }
+
+  if( set_jobs && Genius::is_first_processor() )
+    AsyncExec::set_max_jobs(jobs);
+}
 
 
 /*----------------------------------------------------------------------
- *   This is executed previously to each solution step.
+ * execute the command on the first processor
  */
-void ShellHook::pre_solve()
+void ShellHook::_execute(const std::string &stage)
 {
   // only root processor do this command
-  if ( !Genius::processor_id() )
+  if ( !Genius::processor_id() && !_command.empty() )
   {
-    std::string exec_cmd = _command + " -pre ";
-    system(exec_cmd.c_str());
+    std::string exec_cmd = _command + " " + stage + " ";
+    if( _async )
+      AsyncExec::run(exec_cmd);
+    else
+    {
+      int status = system(exec_cmd.c_str());
+      (void)status;
+    }
   }
+}
+
 
+/*----------------------------------------------------------------------
+ *   This is executed before the initialization of the solver
+ */
+void ShellHook::on_init()
+{
+  _execute("-init");
+}
+
+
+
+/*----------------------------------------------------------------------
+ *   This is executed previously to each solution step.
+ */
+void ShellHook::pre_solve()
+{
+  _execute("-pre");
 }
 
 
@@ -62,12 +112,7 @@ void ShellHook::pre_solve()
  */
 void ShellHook::post_solve()
 {
-  // only root processor do this command
-  if ( !Genius::processor_id() )
-  {
-    std::string exec_cmd = _command + " -post ";
-    system(exec_cmd.c_str());
-  }
+  _execute("-post");
 }
 
 
@@ -77,12 +122,7 @@ void ShellHook::post_solve()
  */
 void ShellHook::post_iteration()
 {
-  // only root processor do this command
-  if ( !Genius::processor_id() )
-  {
-    std::string exec_cmd = _command + " -postit ";
-    system(exec_cmd.c_str());
-  }
+  _execute("-postit");
 }
 
 
@@ -92,12 +132,10 @@ void ShellHook::post_iteration()
  */
 void ShellHook::on_close()
 {
-  // only root processor do this command
-  if ( !Genius::processor_id() )
-  {
-    std::string exec_cmd = _command + " -close ";
-    system(exec_cmd.c_str());
-  }
+  _execute("-close");
+
+  if ( _wait && !Genius::processor_id() )
+    AsyncExec::wait();
 }
 
 
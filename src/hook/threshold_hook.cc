@@ -21,6 +21,8 @@
 
 #include <cstdlib>
 #include <iomanip>
+#include <sstream>
+#include <cmath>
 
 #include "mesh_base.h"
 #include "solver_base.h"
@@ -29,17 +31,25 @@
 
 /*
  * usage: HOOK Load=threshold string<region>=(region_name) real<e.field>=(threshold_value) bool<interrupt>=(true|false)
+ *             string<stop>=(targets) int<settle>=(steps) bool<export>=(true|false)
  * <region> specifies which region will be used for threshold evaluation. If ommited, genius will calculate threshold in all regions
  * <e.field> electrical magnitude, in V/cm
- * <interrupt> indicate if genius will exit when exceeding the given threshold
+ * <temperature> lattice temperature, in K
+ * <interrupt> indicate if genius will stop the sweep when exceeding the given threshold
+ * <stop> ';' separated stop targets, i.e. "I(drain) > 1e-6; Q(drain) saturate 1e-3", see threshold_hook.h
+ * <settle> steps a quantity should stay within the saturate tolerance, default 3
+ * <export> write the solution to <prefix>stop.vtu/cgns when a target is hit
  */
 
 /*----------------------------------------------------------------------
  * constructor, open the file for writing
  */
 ThresholdHook::ThresholdHook ( SolverBase & solver, const std::string & name, void * param)
-    : Hook ( solver, name ), _violate_threshold(false), _stop_when_violate_threshold(false)
+    : Hook ( solver, name ), _violate_threshold(false), _stop_when_violate_threshold(false),
+      _settle(3), _export_on_stop(false)
 {
+  std::string stop_targets;
+
   const SimulationSystem & system = get_solver().get_system();
 
   const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
@@ -100,6 +110,24 @@ ThresholdHook::ThresholdHook ( SolverBase & solver, const std::string & name, vo
       continue;
     }
 
+    if( parm_it->name() == "stop" )
+    {
+      stop_targets = parm_it->get_string();
+      continue;
+    }
+
+    if( parm_it->name() == "settle" )
+    {
+      _settle = std::max(1, parm_it->get_int());
+      continue;
+    }
+
+    if( parm_it->name() == "export" )
+    {
+      _export_on_stop = parm_it->get_bool();
+      continue;
+    }
+
     // the variable to be monitor
     {
       SolutionVariable var = solution_string_to_enum (parm_it->name());
@@ -121,6 +149,23 @@ ThresholdHook::ThresholdHook ( SolverBase & solver, const std::string & name, vo
     }
   }
 
+  // the stop targets
+  std::stringstream ss(stop_targets);
+  std::string text;
+  while( std::getline(ss, text, ';') )
+  {
+    if( text.find_first_not_of(" \t") == std::string::npos ) continue;
+
+    StopTarget target;
+    if( !_parse_target(text, target) )
+    {
+      if( Genius::is_first_processor() )
+        std::cerr<<"ThresholdHook: Invalid stop target \""<< text  <<  "\"." << std::endl;
+      continue;
+    }
+    _stop_targets.push_back(target);
+  }
+
 }
 
 
@@ -157,6 +202,23 @@ void ThresholdHook::post_solve()
 
   if(_vector_variable_threshold_map.find(E_FIELD) !=  _vector_variable_threshold_map.end())
     _check_E_threshold();
+
+  if( _stop_targets.empty() || get_solver().stop_requested() ) return;
+
+  int hit = _check_stop_targets();
+  if( hit < 0 ) return;
+
+  const StopTarget & target = _stop_targets[hit];
+  MESSAGE<<"Threshold "<< _threshold_prefix << ": stop target \"" << target.text << "\" is hit." << std::endl; RECORD();
+
+  if( _export_on_stop )
+  {
+    const SimulationSystem & system = get_solver().get_system();
+    system.export_vtk ( _threshold_prefix + "stop.vtu", false );
+    system.export_cgns ( _threshold_prefix + "stop.cgns" );
+  }
+
+  _solver.request_stop(target.text);
 }
 
 
@@ -177,19 +239,86 @@ void ThresholdHook::on_close()
 
 
 void ThresholdHook::_check_T_threshold()
-{}
+{
+  const Real T_threshold = _scalar_variable_threshold_map[TEMPERATURE];
+
+  Real T_max;
+  Point location;
+  if( !_max_T(T_max, location) )
+  {
+    if( Genius::is_first_processor() )
+      std::cerr<<"ThresholdHook: no solution exist in given region/bound box." << std::endl;
+    return;
+  }
+
+  location /= PhysicalUnit::um;
+  MESSAGE << "Threshold "<< _threshold_prefix  << ": Max T " << T_max/PhysicalUnit::K << " K "
+          <<"at (" << location[0] <<", " <<location[1] <<", "<<location[2] <<")" << std::endl;
+  RECORD();
+
+  if( T_max > T_threshold )
+  {
+    MESSAGE << "           which exceed threshold " << T_threshold/PhysicalUnit::K << " K !" << std::endl; RECORD();
+
+    if( _violate_threshold == false )
+    {
+      const SimulationSystem & system = get_solver().get_system();
+      system.export_vtk ( _threshold_prefix + "device_violate_T_threshold.vtu", false );
+      system.export_cgns ( _threshold_prefix + "device_violate_T_threshold.cgns" );
+      _violate_threshold = true;
+    }
+
+    if( _stop_when_violate_threshold )
+      _solver.request_stop("temperature threshold");
+  }
+}
 
 
 void ThresholdHook::_check_E_threshold()
+{
+  const Real E_threshold = _vector_variable_threshold_map[E_FIELD];
+
+  Real E_magnitude;
+  Point location;
+  if( !_max_E(E_magnitude, location) )
+  {
+    if( Genius::is_first_processor() )
+      std::cerr<<"ThresholdHook: no solution exist in given region/bound box." << std::endl;
+    return;
+  }
+
+  location /= PhysicalUnit::um;
+  MESSAGE << "Threshold "<< _threshold_prefix  << ": Max E magnitude " << E_magnitude/(PhysicalUnit::V/PhysicalUnit::cm) << " V/cm "
+          <<"at (" << location[0] <<", " <<location[1] <<", "<<location[2] <<")" << std::endl;
+  RECORD();
+
+  if( E_magnitude > E_threshold )
+  {
+    MESSAGE << "           which exceed threshold " << E_threshold/(PhysicalUnit::V/PhysicalUnit::cm) << " V/cm !" << std::endl; RECORD();
+
+    if( _violate_threshold == false )
+    {
+      const SimulationSystem & system = get_solver().get_system();
+      system.export_vtk ( _threshold_prefix + "device_violate_E_threshold.vtu", false );
+      system.export_cgns ( _threshold_prefix + "device_violate_E_threshold.cgns" );
+      _violate_threshold = true;
+    }
+
+    // stop the sweep cleanly, the results of the steps done are kept
+    if( _stop_when_violate_threshold )
+      _solver.request_stop("electric field threshold");
+  }
+}
+
+
+bool ThresholdHook::_max_E(Real &E_magnitude, Point &location)
 {
   const SimulationSystem & system = get_solver().get_system();
   const MeshBase & mesh = system.mesh();
 
-  const Real E_threshold = _vector_variable_threshold_map[E_FIELD];
-
   bool box = _is_bound_box_valid();
 
-  Real E_magnitude = 0;
+  E_magnitude = 0;
   unsigned int cell = invalid_uint;
 
   for( unsigned int n=0; n<system.n_regions(); ++n )
@@ -219,51 +348,220 @@ void ThresholdHook::_check_E_threshold()
 
   Parallel::allgather(order);
 
-  if(!order.empty())
-  {
-    E_magnitude = order.rbegin()->first;
-    cell = order.rbegin()->second;
+  if(order.empty()) return false;
 
-    AutoPtr<Elem> elem = mesh.elem_clone(cell);
+  E_magnitude = order.rbegin()->first;
+  cell = order.rbegin()->second;
 
-    if( Genius::is_first_processor() )
-    {
-      Point location = elem->centroid()/(PhysicalUnit::um);
-      std::cout << "Threshold "<< _threshold_prefix  << ": Max E magnitude " << E_magnitude/(PhysicalUnit::V/PhysicalUnit::cm) << " V/cm "
-      <<"at (" << location[0] <<", " <<location[1] <<", "<<location[2] <<")" << std::endl;
-    }
+  AutoPtr<Elem> elem = mesh.elem_clone(cell);
+  location = elem->centroid();
+  return true;
+}
 
-    if( E_magnitude > E_threshold )
+
+bool ThresholdHook::_max_T(Real &T_max, Point &location)
+{
+  const SimulationSystem & system = get_solver().get_system();
+  const MeshBase & mesh = system.mesh();
+
+  bool box = _is_bound_box_valid();
+
+  T_max = 0;
+  unsigned int node = invalid_uint;
+
+  for( unsigned int n=0; n<system.n_regions(); ++n )
+  {
+    const SimulationRegion * region = system.region(n);
+    if( !_region.empty() && region->name() != _region ) continue;
+
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
     {
-      if( Genius::is_first_processor() )
-      {
-        std::cout << "           which exceed threshold " << E_threshold/(PhysicalUnit::V/PhysicalUnit::cm) << " V/cm !" << std::endl;
-      }
-      if( _violate_threshold == false )
-      {
-        system.export_vtk ( _threshold_prefix + "device_violate_E_threshold.vtu", false );
-        system.export_cgns ( _threshold_prefix + "device_violate_E_threshold.cgns" );
-        _violate_threshold = true;
-      }
+      const FVM_Node * fvm_node = *it;
+      if(box && !_in_bound_box(*fvm_node->root_node())) continue;
 
-      if( _violate_threshold && _stop_when_violate_threshold )
+      const Real T = fvm_node->node_data()->T();
+      if( T > T_max )
       {
-        Parallel::verify(_violate_threshold);
-        std::abort();
+        T_max = T;
+        node = fvm_node->root_node()->id();
       }
     }
   }
-  else
+
+  std::map<Real, unsigned int> order;
+  if(node != invalid_uint)
+    order.insert(std::make_pair(T_max, node));
+
+  Parallel::allgather(order);
+
+  if(order.empty()) return false;
+
+  T_max = order.rbegin()->first;
+  location = mesh.point(order.rbegin()->second);
+  return true;
+}
+
+
+bool ThresholdHook::_parse_target(const std::string &text, StopTarget &target)
+{
+  target.text = text.substr(text.find_first_not_of(" \t"));
+  target.text = target.text.substr(0, target.text.find_last_not_of(" \t")+1);
+  target.absolute = false;
+  target.has_last = false;
+  target.last_V = target.last_I = target.last_clock = target.charge = 0.0;
+  target.has_last_value = false;
+  target.last_value = 0.0;
+  target.settled = 0;
+
+  // split at the compare operator
+  std::string lower = target.text;
+  for(unsigned int i=0; i<lower.size(); ++i)
+    lower[i] = tolower(lower[i]);
+
+  std::string::size_type pos, op_len;
+  if( (pos = lower.find("saturate")) != std::string::npos )  { target.compare = SATURATE; op_len = 8; }
+  else if( (pos = lower.find(">=")) != std::string::npos )   { target.compare = GE; op_len = 2; }
+  else if( (pos = lower.find("<=")) != std::string::npos )   { target.compare = LE; op_len = 2; }
+  else if( (pos = lower.find('>')) != std::string::npos )    { target.compare = GT; op_len = 1; }
+  else if( (pos = lower.find('<')) != std::string::npos )    { target.compare = LT; op_len = 1; }
+  else return false;
+
+  std::string lhs;
+  for(unsigned int i=0; i<pos; ++i)
+    if( !isspace(lower[i]) ) lhs += lower[i];
+
+  std::stringstream rhs(lower.substr(pos+op_len));
+  if( !(rhs >> target.value) ) return false;
+
+  if( lhs.size() > 5 && lhs.compare(0, 4, "abs(") == 0 && lhs[lhs.size()-1] == ')' )
   {
-    if( Genius::is_first_processor() )
+    target.absolute = true;
+    lhs = lhs.substr(4, lhs.size()-5);
+  }
+
+  // the quantity, with electrode as argument
+  std::string q = lhs, arg;
+  std::string::size_type lp = lhs.find('(');
+  if( lp != std::string::npos )
+  {
+    if( lhs[lhs.size()-1] != ')' ) return false;
+    q   = lhs.substr(0, lp);
+    arg = lhs.substr(lp+1, lhs.size()-lp-2);
+  }
+
+  if     ( q == "v" )    target.quantity = VOLTAGE;
+  else if( q == "i" )    target.quantity = CURRENT;
+  else if( q == "didv" ) target.quantity = DIDV;
+  else if( q == "q" )    target.quantity = CHARGE;
+  else if( q == "emax" ) target.quantity = EMAX;
+  else if( q == "tmax" ) target.quantity = TMAX;
+  else if( q == "t" )    target.quantity = CLOCK;
+  else return false;
+
+  const bool need_electrode = (target.quantity == VOLTAGE || target.quantity == CURRENT ||
+                               target.quantity == DIDV || target.quantity == CHARGE);
+  if( need_electrode != !arg.empty() ) return false;
+
+  if( need_electrode )
+  {
+    const BoundaryCondition * bc = get_solver().get_system().get_bcs()->get_bc_nocase(arg);
+    if( bc == NULL || !bc->is_electrode() ) return false;
+    target.electrode = bc->label();
+  }
+
+  return true;
+}
+
+
+int ThresholdHook::_check_stop_targets()
+{
+  const BoundaryConditionCollector * bcs = get_solver().get_system().get_bcs();
+
+  // the field maxima are computed once, in parallel, when any target needs them
+  bool need_E = false, need_T = false;
+  for(unsigned int n=0; n<_stop_targets.size(); ++n)
+  {
+    need_E = need_E || _stop_targets[n].quantity == EMAX;
+    need_T = need_T || _stop_targets[n].quantity == TMAX;
+  }
+
+  Real E_max = 0, T_max = 0;
+  Point location;
+  if( need_E ) _max_E(E_max, location);
+  if( need_T ) _max_T(T_max, location);
+
+  // all the quantities are the same on every processor, so is the decision
+  int hit = -1;
+  for(unsigned int n=0; n<_stop_targets.size(); ++n)
+  {
+    StopTarget & target = _stop_targets[n];
+
+    double V = 0, I = 0;
+    const double clock = SolverSpecify::clock/PhysicalUnit::s;
+    if( !target.electrode.empty() )
     {
-      std::cerr<<"ThresholdHook: no solution exist in given region/bound box." << std::endl;
+      const BoundaryCondition * bc = bcs->get_bc(target.electrode);
+      V = bc->ext_circuit()->potential()/PhysicalUnit::V;
+      I = bc->ext_circuit()->current()/PhysicalUnit::A;
     }
-  }
 
+    bool valid = true;
+    double value = 0;
+    switch( target.quantity )
+    {
+    case VOLTAGE : value = V; break;
+    case CURRENT : value = I; break;
+    case DIDV    :
+      // undefined at the first step or when the bias did not change
+      valid = target.has_last && std::abs(V - target.last_V) > 1e-12;
+      if( valid ) value = (I - target.last_I)/(V - target.last_V);
+      break;
+    case CHARGE  :
+      if( target.has_last && SolverSpecify::TimeDependent )
+        target.charge += 0.5*(I + target.last_I)*(clock - target.last_clock);
+      value = target.charge;
+      valid = target.has_last;
+      break;
+    case EMAX    : value = E_max/(PhysicalUnit::V/PhysicalUnit::cm); break;
+    case TMAX    : value = T_max/PhysicalUnit::K; break;
+    case CLOCK   : value = SolverSpecify::clock/PhysicalUnit::ps; break;
+    }
+
+    target.has_last   = true;
+    target.last_V     = V;
+    target.last_I     = I;
+    target.last_clock = clock;
+
+    if( !valid ) continue;
+    if( target.absolute ) value = std::abs(value);
+
+    bool reached = false;
+    switch( target.compare )
+    {
+    case GT : reached = value >  target.value; break;
+    case GE : reached = value >= target.value; break;
+    case LT : reached = value <  target.value; break;
+    case LE : reached = value <= target.value; break;
+    case SATURATE :
+      if( target.has_last_value && std::abs(value - target.last_value) <= target.value*std::abs(value) )
+        target.settled++;
+      else
+        target.settled = 0;
+      reached = target.settled >= _settle;
+      break;
+    }
+    target.has_last_value = true;
+    target.last_value = value;
+
+    if( reached && hit < 0 ) hit = n;
+  }
 
+  return hit;
 }
 
+
 bool ThresholdHook::_is_bound_box_valid()
 {
   return _lower_bound.x()<_upper_bound.x() || _lower_bound.y()<_upper_bound.y() || _lower_bound.z()<_upper_bound.z();
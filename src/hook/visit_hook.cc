@@ -24,6 +24,7 @@
 // system include
 #include <string>
 #include <cstdlib>
+#include <cmath>
 
 
 // genius include
@@ -31,6 +32,7 @@
 #include "solver_specify.h"
 #include "visit_hook.h"
 #include "parallel.h"
+#include "parser.h"
 
 /******************************************************************************
  *  VisitHook static member
@@ -41,7 +43,8 @@ SolverBase*  VisitHook::_p_solver   = 0;
 std::vector<std::pair<std::string, std::string> >  VisitHook::_variables;
 std::vector< std::vector<double> > VisitHook::_values;
 unsigned int VisitHook::_n_values   = 0;
-std::map<unsigned int, int> VisitHook::global_id_to_index;
+std::vector<VisitHook::RegionMesh> VisitHook::_region_meshes;
+std::map<std::string, std::vector<double> > VisitHook::_scaled_values;
 
 
 
@@ -126,11 +129,23 @@ static int ProcessVisItCommand(void)
 /*----------------------------------------------------------------------
  * constructor, connect to visit
  */
-VisitHook::VisitHook(SolverBase & _solver, const std::string & name, void * dummy)
-    : Hook(_solver, name)
+VisitHook::VisitHook(SolverBase & _solver, const std::string & name, void * param)
+    : Hook(_solver, name), _launch(true), _wait(false), _interval(0.0), _last_update(0.0)
 {
   _p_solver = &_solver;
 
+  const std::vector<Parser::Parameter> & parm_list = *((std::vector<Parser::Parameter> *)param);
+  for ( std::vector<Parser::Parameter>::const_iterator parm_it = parm_list.begin();
+        parm_it != parm_list.end(); parm_it++ )
+  {
+    if ( parm_it->name() == "launch" && parm_it->type() == Parser::BOOL )
+      _launch = parm_it->get_bool();
+    if ( parm_it->name() == "wait" && parm_it->type() == Parser::BOOL )
+      _wait = parm_it->get_bool();
+    if ( parm_it->name() == "interval" && parm_it->type() == Parser::REAL )
+      _interval = parm_it->get_real();
+  }
+
   if(SolverSpecify::Type != SolverSpecify::TRANSIENT && SolverSpecify::Type != SolverSpecify::DCSWEEP ) return;
 
   connect_to_visit();
@@ -153,6 +168,14 @@ void VisitHook::on_init()
 {
   if(SolverSpecify::Type != SolverSpecify::TRANSIENT && SolverSpecify::Type != SolverSpecify::DCSWEEP ) return;
 
+  // the IV buffer of previous solve
+  _variables.clear();
+  _values.clear();
+  _n_values = 0;
+
+  // the mesh does not change during the solve, build it once
+  build_region_meshes();
+
   // record electrode IV (and time) information
   {
     // if transient simulation, we need to record time
@@ -222,8 +245,12 @@ void VisitHook::post_solve()
   }
 
 
-  // recive information from visit and answer it!
-  comm_to_visit();
+  // recive information from visit and answer it, refresh the plots when it is time
+  double now = MPI_Wtime();
+  Parallel::broadcast(now);
+  bool update = (now - _last_update >= _interval);
+  if(update) _last_update = now;
+  comm_to_visit(update);
 
 }
 
@@ -234,7 +261,12 @@ void VisitHook::post_solve()
  *  This is executed after each (nonlinear) iteration
  */
 void VisitHook::post_iteration()
-{}
+{
+  if(SolverSpecify::Type != SolverSpecify::TRANSIENT && SolverSpecify::Type != SolverSpecify::DCSWEEP ) return;
+
+  // keep visit responsive during long solution steps
+  comm_to_visit(false);
+}
 
 
 
@@ -244,11 +276,25 @@ void VisitHook::post_iteration()
  */
 void VisitHook::on_close()
 {
+  if(SolverSpecify::Type != SolverSpecify::TRANSIENT && SolverSpecify::Type != SolverSpecify::DCSWEEP ) return;
 
-  if(visit_state  != CONNECTED) return;
-  std::cout << "Please exit visit to continue..." << std::endl;
-  // wait for visit until it exist
-  disconnect_to_visit();
+  // show the final solution
+  comm_to_visit(true);
+
+  if(visit_state == CONNECTED && _wait)
+  {
+    std::cout << "Please exit visit to continue..." << std::endl;
+    // wait for visit until it exist
+    disconnect_to_visit();
+    return;
+  }
+
+  // detach from visit and go on
+  if(visit_state == CONNECTED)
+    VisItDisconnect();
+  visit_state = UNKNOWN;
+  if(Genius::processor_id()==0)
+    remove("genius.sim1");
 }
 
 
@@ -329,9 +375,11 @@ void VisitHook::connect_to_visit()
                                         NULL,
                                         NULL,
                                         "genius.sim1");
+  }
 
-
-    // we fork a child process to run visit
+  // we fork a child process to run visit
+  if(Genius::processor_id()==0 && _launch)
+  {
     pid_t pid = fork();
 
     // child process
@@ -356,8 +404,8 @@ void VisitHook::connect_to_visit()
     }
   }
 
-  // wait until connected to visit
-  do
+  // only wait for the connection when required, otherwise it is accepted by comm_to_visit
+  while( _wait && visit_state == UNKNOWN )
   {
     /* Get input from VisIt */
     int visit_input;
@@ -368,58 +416,37 @@ void VisitHook::connect_to_visit()
 
     switch (visit_input)
     {
-    case 0 :/* There was no input from VisIt. Continue waiting . */
-      {
-        break;
-      }
-
     case 1 :/* VisIt is trying to connect to sim. */
       {
         if(VisItAttemptToCompleteConnection())
         {
           visit_state  = CONNECTED;
-	  std::cout << "VisIt connected! \n"<<std::endl;
+          std::cout << "VisIt connected! \n"<<std::endl;
           VisItSetSlaveProcessCallback(SlaveProcessCallback);
-          //VisItSetCommandCallback(ControlCommandCallback);
         }
         else
         {
           std::cout << "VisIt NOT connected! \n" << VisItGetLastError() << std::endl;
           visit_state  = DISCONNECTED;
         }
-
-        break;
-      }
-
-    case 2 :/* VisIt wants to tell the engine something. */
-      {
-        if(!ProcessVisItCommand())
-        {
-          /* Disconnect on an error or closed connection. */
-          VisItDisconnect();
-          visit_state  = DISCONNECTED;
-          remove("genius.sim1");
-        }
         break;
       }
     default: break;
     }
   }
-  while( visit_state == UNKNOWN );
 
 }
 
 
 
-void VisitHook::comm_to_visit()
+void VisitHook::comm_to_visit(bool update)
 {
-
-  if(visit_state  != CONNECTED) return;
+  // the connection is closed, do not listen again
+  if(visit_state == DISCONNECTED) return;
 
   do
   {
-
-    /* Get input from VisIt */
+    /* Poll VisIt without blocking */
     int visit_input;
     if(Genius::processor_id()==0)
       visit_input = VisItDetectInput(0, -1);
@@ -427,17 +454,31 @@ void VisitHook::comm_to_visit()
 
     switch (visit_input)
     {
-    case 0 :/* There was no input from VisIt. Send simulation data to visit */
+    case 0 :/* There was no input from VisIt. Tell visit the simulation updated */
       {
-
-        /**
-         * we should use this function to tell visit that simulation updated
-         */
-        VisItTimeStepChanged();
-        VisItUpdatePlots();
+        if(visit_state == CONNECTED && update)
+        {
+          VisItTimeStepChanged();
+          VisItUpdatePlots();
+        }
         return;
       }
 
+    case 1 :/* VisIt is trying to connect to sim. */
+      {
+        if(VisItAttemptToCompleteConnection())
+        {
+          visit_state  = CONNECTED;
+          std::cout << "VisIt connected! \n"<<std::endl;
+          VisItSetSlaveProcessCallback(SlaveProcessCallback);
+        }
+        else
+        {
+          std::cout << "VisIt NOT connected! \n" << VisItGetLastError() << std::endl;
+        }
+        break;
+      }
+
     case 2 :/* VisIt wants to tell the engine something. */
       {
         if(!ProcessVisItCommand())
@@ -451,7 +492,7 @@ void VisitHook::comm_to_visit()
         }
         break;
       }
-    default: break;
+    default: return;
     }
   }
   while(1);
@@ -533,47 +574,57 @@ VisIt_SimulationMetaData * VisitHook::get_meta_data(void)
   }
 
 
-  /* Allocate enough room for mesh in the metadata. */
-  md->numMeshes = 1;
+  SimulationSystem & system = _p_solver->get_system();
+
+  /* Each region is a mesh. */
+  md->numMeshes = system.n_regions();
   sz = sizeof(VisIt_MeshMetaData) * md->numMeshes;
   md->meshes = (VisIt_MeshMetaData *)malloc(sz);
   memset(md->meshes, 0, sz);
 
-  /* Set mesh properties.*/
-  md->meshes[0].name = strdup("Genius Mesh3D");
-  md->meshes[0].meshType = VISIT_MESHTYPE_UNSTRUCTURED;
-  md->meshes[0].topologicalDimension = 3;
-  md->meshes[0].spatialDimension = 3;
-  md->meshes[0].numBlocks = Genius::n_processors();
-  md->meshes[0].blockTitle = strdup("Domains");
-  md->meshes[0].blockPieceName = strdup("domain");
-  md->meshes[0].numGroups = 0;
-  md->meshes[0].units = strdup("um");
-  md->meshes[0].xLabel = strdup("Width");
-  md->meshes[0].yLabel = strdup("Height");
-  md->meshes[0].zLabel = strdup("Depth");
-
-
-  /* Add some scalar variables. */
-  md->numScalars = 3;
+  std::vector<std::pair<std::string, std::string> > scalars;
+  for( unsigned int r=0; r<system.n_regions(); r++)
+  {
+    SimulationRegion * region = system.region(r);
+
+    /* Set mesh properties.*/
+    md->meshes[r].name = strdup(region->name().c_str());
+    md->meshes[r].meshType = VISIT_MESHTYPE_UNSTRUCTURED;
+    md->meshes[r].topologicalDimension = system.mesh().mesh_dimension();
+    md->meshes[r].spatialDimension = 3;
+    md->meshes[r].numBlocks = Genius::n_processors();
+    md->meshes[r].blockTitle = strdup("Domains");
+    md->meshes[r].blockPieceName = strdup("domain");
+    md->meshes[r].numGroups = 0;
+    md->meshes[r].units = strdup("um");
+    md->meshes[r].xLabel = strdup("Width");
+    md->meshes[r].yLabel = strdup("Height");
+    md->meshes[r].zLabel = strdup("Depth");
+
+    /* all the node based scalar variables which have data in this region */
+    const std::map<std::string, SimulationVariable> & variables = region->region_point_variables();
+    std::map<std::string, SimulationVariable>::const_iterator it = variables.begin();
+    for( ; it != variables.end(); ++it)
+    {
+      unsigned int size;
+      Real unit;
+      if( region->node_scalar_data(it->first, size, unit) == NULL ) continue;
+      scalars.push_back( std::make_pair(region->name() + "/" + it->first, region->name()) );
+    }
+  }
+
+  /* Add scalar variables. */
+  md->numScalars = scalars.size();
   sz = sizeof(VisIt_ScalarMetaData) * md->numScalars;
   md->scalars = (VisIt_ScalarMetaData *)malloc(sz);
   memset(md->scalars, 0, sz);
 
-  /* Add potential nodal variable on mesh3d. */
-  md->scalars[0].name = strdup("potential");
-  md->scalars[0].meshName = strdup("Genius Mesh3D");
-  md->scalars[0].centering = VISIT_VARCENTERING_NODE;
-
-  /* Add electron density nodal variable on mesh3d. */
-  md->scalars[1].name = strdup("electron_density");
-  md->scalars[1].meshName = strdup("Genius Mesh3D");
-  md->scalars[1].centering = VISIT_VARCENTERING_NODE;
-
-  /* Add hole density nodal variable on mesh3d. */
-  md->scalars[2].name = strdup("hole_density");
-  md->scalars[2].meshName = strdup("Genius Mesh3D");
-  md->scalars[2].centering = VISIT_VARCENTERING_NODE;
+  for(unsigned int n=0; n<scalars.size(); ++n)
+  {
+    md->scalars[n].name = strdup(scalars[n].first.c_str());
+    md->scalars[n].meshName = strdup(scalars[n].second.c_str());
+    md->scalars[n].centering = VISIT_VARCENTERING_NODE;
+  }
 
   /* Add curve variable. */
 
@@ -748,24 +799,74 @@ VisIt_CurveData * VisitHook::get_electrode_iv(const std::string & visit_cv_name)
 
 
 
-VisIt_MeshData *  VisitHook::get_mesh(int domain,  const std::string &name)
+void VisitHook::build_region_meshes()
 {
+  const SimulationSystem & system = _p_solver->get_system();
+  const MeshBase & mesh = system.mesh();
+
+  _region_meshes.clear();
+  _region_meshes.resize(system.n_regions());
+  _scaled_values.clear();
+
+  for( unsigned int r=0; r<system.n_regions(); r++)
+  {
+    const SimulationRegion * region = system.region(r);
+    RegionMesh & region_mesh = _region_meshes[r];
+
+    // node location, ordered as the node data block
+    std::vector<unsigned int> ids;
+    std::vector<int> on_processor;
+    region->node_data_ids(ids, on_processor);
+
+    region_mesh.x.resize(ids.size(), 0.0);
+    region_mesh.y.resize(ids.size(), 0.0);
+    region_mesh.z.resize(ids.size(), 0.0);
+    for(unsigned int i=0; i<ids.size(); ++i)
+    {
+      if( ids[i] == invalid_uint ) continue;
+      const Point & p = mesh.point(ids[i]);
+      region_mesh.x[i] = p(0)/PhysicalUnit::um;
+      region_mesh.y[i] = p(1)/PhysicalUnit::um;
+      region_mesh.z[i] = p(2)/PhysicalUnit::um;
+    }
+
+    // cell connectivity, refer to the offset of node data
+    region_mesh.n_zones = 0;
+    for(unsigned int n=0; n<region->n_cell(); ++n)
+    {
+      const Elem * elem = region->get_region_elem(n);
+      if( elem->processor_id() != Genius::processor_id() ) continue;
+
+      std::vector<unsigned int> conn;
+      elem->connectivity(0, VTK, conn);
+
+      region_mesh.connectivity.push_back(visit_cell_type(elem));
+      for(unsigned int i=0; i<conn.size(); ++i)
+        region_mesh.connectivity.push_back(region->region_node_data(conn[i])->offset());
+      region_mesh.n_zones++;
+    }
+  }
+}
 
-  VisIt_MeshData *mesh = NULL;
-  size_t sz = sizeof(VisIt_MeshData);
 
+
+VisIt_MeshData *  VisitHook::get_mesh(int domain,  const std::string &name)
+{
   genius_assert( domain < Genius::n_processors());
-  genius_assert( name == "Genius Mesh3D" );
 
-  const MeshBase & _mesh = _p_solver->get_system().mesh();
+  SimulationSystem & system = _p_solver->get_system();
+  if( _region_meshes.size() != system.n_regions() )
+    build_region_meshes();
 
-  static std::vector<float> x;
-  static std::vector<float> y;
-  static std::vector<float> z;
-  static std::vector<int>   connectivity;
+  unsigned int r=0;
+  for( ; r<system.n_regions(); r++)
+    if( system.region(r)->name() == name ) break;
+  genius_assert( r<system.n_regions() );
+  const RegionMesh & region_mesh = _region_meshes[r];
 
   /* Allocate VisIt_MeshData. */
-  mesh = (VisIt_MeshData *)malloc(sz);
+  size_t sz = sizeof(VisIt_MeshData);
+  VisIt_MeshData *mesh = (VisIt_MeshData *)malloc(sz);
   memset(mesh, 0, sz);
 
   /* Make VisIt_MeshData contain a VisIt_UnstructuredMesh. */
@@ -774,63 +875,26 @@ VisIt_MeshData *  VisitHook::get_mesh(int domain,  const std::string &name)
 
   /* Tell VisIt which mesh object to use. */
   mesh->meshType = VISIT_MESHTYPE_UNSTRUCTURED;
-  /* Set the meshs number of dimensions. */
   mesh->umesh->ndims = 3;
 
   /* Set the number of nodes and zones in the mesh domain. */
-  mesh->umesh->nnodes = _mesh.n_nodes();
-  mesh->umesh->nzones = _mesh.n_elem();
+  mesh->umesh->nnodes = region_mesh.x.size();
+  mesh->umesh->nzones = region_mesh.n_zones;
 
   /* Set the indices for the first and last real zones. */
   mesh->umesh->firstRealZone = 0;
-  mesh->umesh->lastRealZone  = _mesh.n_elem()-1;
-
-  // clear old data
-  x.clear();
-  y.clear();
-  z.clear();
-  connectivity.clear();
-  global_id_to_index.clear();
-
-  //get node location
-  MeshBase::const_node_iterator node_it = _mesh.active_nodes_begin();
-  MeshBase::const_node_iterator node_it_end = _mesh.active_nodes_end();
-  for(int i=0; node_it!=node_it_end; ++node_it)
-  {
-    const Node * node = (*node_it);
-    x.push_back((*node)(0)/PhysicalUnit::um);
-    y.push_back((*node)(1)/PhysicalUnit::um);
-    z.push_back((*node)(2)/PhysicalUnit::um);
-    global_id_to_index[node->id()] = i++;
-  }
+  mesh->umesh->lastRealZone  = region_mesh.n_zones-1;
 
-  // get cell connectivity information
-  MeshBase::const_element_iterator       elem_it  = _mesh.active_elements_begin();
-  const MeshBase::const_element_iterator elem_it_end = _mesh.active_elements_end();
-  for(; elem_it!=elem_it_end; ++elem_it)
+  /* Let VisIt use the cached copy of the mesh coordinates and connectivity. */
+  if( region_mesh.n_zones )
   {
-    if( (*elem_it)->processor_id() != Genius::processor_id() ) continue;
-
-    std::vector<unsigned int> conn;
-    (*elem_it)->connectivity(0, VTK, conn);
-
-    connectivity.push_back(visit_cell_type(*elem_it));
-    for(unsigned int i=0; i<conn.size(); ++i)
-      connectivity.push_back(global_id_to_index[conn[i]]);
+    mesh->umesh->xcoords = VisIt_CreateDataArrayFromFloat(VISIT_OWNER_SIM, const_cast<float *>(&region_mesh.x[0]));
+    mesh->umesh->ycoords = VisIt_CreateDataArrayFromFloat(VISIT_OWNER_SIM, const_cast<float *>(&region_mesh.y[0]));
+    mesh->umesh->zcoords = VisIt_CreateDataArrayFromFloat(VISIT_OWNER_SIM, const_cast<float *>(&region_mesh.z[0]));
+    mesh->umesh->connectivity = VisIt_CreateDataArrayFromInt(VISIT_OWNER_SIM, const_cast<int *>(&region_mesh.connectivity[0]));
+    mesh->umesh->connectivityLen = region_mesh.connectivity.size();
   }
 
-  // fill node location and cell connectivity information to visit
-
-  /* Let VisIt use simulations copy of the mesh coordinates. */
-  mesh->umesh->xcoords = VisIt_CreateDataArrayFromFloat(VISIT_OWNER_SIM, &x[0]);
-  mesh->umesh->ycoords = VisIt_CreateDataArrayFromFloat(VISIT_OWNER_SIM, &y[0]);
-  mesh->umesh->zcoords = VisIt_CreateDataArrayFromFloat(VISIT_OWNER_SIM, &z[0]);
-
-  /* Let VisIt use the simulations copy of the connectivity. */
-  mesh->umesh->connectivity = VisIt_CreateDataArrayFromInt(VISIT_OWNER_SIM, &connectivity[0]);
-  mesh->umesh->connectivityLen = connectivity.size();
-
-
   return mesh;
 }
 
@@ -838,46 +902,39 @@ VisIt_MeshData *  VisitHook::get_mesh(int domain,  const std::string &name)
 
 VisIt_ScalarData * VisitHook::get_scalar(int domain, const std::string &name)
 {
-
-  size_t sz = sizeof(VisIt_ScalarData);
-  VisIt_ScalarData *scalar = (VisIt_ScalarData*)malloc(sz);
-  memset(scalar, 0, sz);
-
   genius_assert( domain < Genius::n_processors() );
-  genius_assert( !global_id_to_index.empty() );
 
-  static std::vector<double> solution;
-  solution.resize(global_id_to_index.size());
+  // the variable name is region/variable
+  std::string::size_type pos = name.rfind('/');
+  genius_assert( pos != std::string::npos );
 
-  for( unsigned int r=0; r<_p_solver->get_system().n_regions(); r++)
-  {
-    const SimulationRegion * region = _p_solver->get_system().region(r);
-
-    SimulationRegion::const_node_iterator node_it     = region->nodes_begin();
-    SimulationRegion::const_node_iterator node_it_end = region->nodes_end();
-    for(int i=0; node_it!=node_it_end; ++node_it)
-    {
-      const Node * node = (*node_it).second->root_node();
-      const FVM_NodeData * node_data = (*node_it).second->node_data();
+  SimulationRegion * region = _p_solver->get_system().region(name.substr(0, pos));
+  genius_assert( region );
 
-      if( !node->on_local() ) continue;
+  unsigned int size;
+  Real unit;
+  Real * data = region->node_scalar_data(name.substr(pos+1), size, unit);
+  genius_assert( data );
 
-      int index = global_id_to_index[node->id()];
+  size_t sz = sizeof(VisIt_ScalarData);
+  VisIt_ScalarData *scalar = (VisIt_ScalarData*)malloc(sz);
+  memset(scalar, 0, sz);
+  scalar->len  = size;
 
-      if(name == "potential")
-        solution[index] = (node_data->psi()/PhysicalUnit::V);
-      if(name == "electron_density")
-        solution[index] = (node_data->n()/std::pow(PhysicalUnit::cm,-3));
-      if(name == "hole_density")
-        solution[index] = (node_data->p()/std::pow(PhysicalUnit::cm,-3));
-    }
+  // stored in output unit, give visit the data block itself
+  if( unit == 1.0 )
+  {
+    scalar->data = VisIt_CreateDataArrayFromDouble(VISIT_OWNER_SIM, data);
+    return scalar;
   }
 
-  scalar->len  = solution.size();
-  scalar->data = VisIt_CreateDataArrayFromDouble(VISIT_OWNER_SIM, &solution[0]);
+  std::vector<double> & values = _scaled_values[name];
+  values.resize(size);
+  for(unsigned int i=0; i<size; ++i)
+    values[i] = data[i]/unit;
+  scalar->data = VisIt_CreateDataArrayFromDouble(VISIT_OWNER_SIM, &values[0]);
 
   return  scalar;
-
 }
 
 
@@ -934,9 +991,10 @@ VisIt_DomainList *VisItGetDomainList(void)
   VisIt_DomainList *dl = (VisIt_DomainList*)malloc(sz);
   memset(dl, 0, sz);
 
-  /* Get number of processors and rank from MPI. */
+  /* Get number of processors and rank from MPI. visit keeps the pointer of rank */
   int np   = Genius::n_processors();
-  int rank = Genius::processor_id();
+  static int rank;
+  rank = Genius::processor_id();
 
   dl->nTotalDomains = np;
   dl->nMyDomains = 1;
@@ -25,6 +25,7 @@
 #include "solver_base.h"
 #include "vtk_hook.h"
 #include "spice_ckt.h"
+#include "async_file_writer.h"
 #include "MXMLUtil.h"
 
 
@@ -55,13 +56,15 @@ VTKHook::VTKHook ( SolverBase & solver, const std::string & name, void * param)
       _v_step=parm_it->get_real() * PhysicalUnit::V;
     if ( parm_it->name() == "istep" && parm_it->type() == Parser::REAL )
       _i_step=parm_it->get_real() * PhysicalUnit::A;
+    if ( parm_it->name() == "fields" && parm_it->type() == Parser::STRING )
+      _fields=parm_it->get_string();
   }
 
   const SimulationSystem &system = get_solver().get_system();
 
   std::ostringstream vtk_filename;
   vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-  system.export_vtk ( vtk_filename.str(), false );
+  system.export_vtk ( vtk_filename.str(), false, true, true, _fields );
 
   SolverSpecify::SolverType solver_type = this->get_solver().solver_type();
 
@@ -137,7 +140,7 @@ void VTKHook::post_solve()
       const SimulationSystem &system = get_solver().get_system();
 
       vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-      system.export_vtk ( vtk_filename.str(),false );
+      system.export_vtk ( vtk_filename.str(), false, true, true, _fields );
 
       time_sequence.push_back ( std::make_pair ( Vscan/PhysicalUnit::V, vtk_filename.str() ) );
       _v_last = Vscan;
@@ -158,7 +161,7 @@ void VTKHook::post_solve()
       const SimulationSystem &system = get_solver().get_system();
 
       vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-      system.export_vtk ( vtk_filename.str(),false );
+      system.export_vtk ( vtk_filename.str(), false, true, true, _fields );
 
       time_sequence.push_back ( std::make_pair ( Iscan/PhysicalUnit::A, vtk_filename.str() ) );
       _i_last = Iscan;
@@ -173,7 +176,7 @@ void VTKHook::post_solve()
       const SimulationSystem &system = get_solver().get_system();
 
       vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-      system.export_vtk ( vtk_filename.str(), false );
+      system.export_vtk ( vtk_filename.str(), false, true, true, _fields );
 
       time_sequence.push_back ( std::make_pair ( SolverSpecify::clock/PhysicalUnit::ps, vtk_filename.str() ) );
       _t_last = SolverSpecify::clock;
@@ -187,7 +190,7 @@ void VTKHook::post_solve()
     const SimulationSystem &system = get_solver().get_system();
 
     vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-    system.export_vtk ( vtk_filename.str(), false );
+    system.export_vtk ( vtk_filename.str(), false, true, true, _fields );
 
     time_sequence.push_back ( std::make_pair ( SolverSpecify::Freq*PhysicalUnit::us, vtk_filename.str() ) );
     _f_last = SolverSpecify::Freq;
@@ -199,7 +202,7 @@ void VTKHook::post_solve()
     const SimulationSystem &system = get_solver().get_system();
 
     vtk_filename << _vtk_prefix << ( this->count++ ) << ".vtu";
-    system.export_vtk ( vtk_filename.str(),false );
+    system.export_vtk ( vtk_filename.str(), false, true, true, _fields );
   }
   */
 
@@ -232,6 +235,9 @@ void VTKHook::post_iteration()
  */
 void VTKHook::on_close()
 {
+  // the vtk files are complete when the solver returns
+  AsyncFileWriter::instance().flush();
+
   if ( time_sequence.size() ==0 ) return;
 
   if ( !Genius::processor_id() )
@@ -9,6 +9,7 @@
 void Interpolation1D_Linear::clear()
 {
   _coordinate.clear();
+  _inv_h = 0.0;
   _values.clear();
   _pre_computed_value.clear();
 }
@@ -25,6 +26,8 @@ void Interpolation1D_Linear::add_scatter_data(const Point & point, int group, do
 
 void Interpolation1D_Linear::setup(int group)
 {
+  _inv_h = _uniform_inv_spacing(_coordinate);
+
   const std::vector<double> & value = _values[group];
   std::vector<double> & y = _pre_computed_value[group];
 
@@ -61,39 +64,44 @@ void Interpolation1D_Linear::broadcast(unsigned int root)
 
 double Interpolation1D_Linear::get_interpolated_value(const Point & point, int group) const
 {
-  int n = _coordinate.size();
-  const std::vector<double> & t = _coordinate;
   const std::vector<double> & y = _pre_computed_value.find(group)->second;
 
   double tval = point.x();
-  double yval = 0.0;
+  int ival = _locate_interval(_coordinate, tval, -1, _inv_h);
+  return _evaluate(ival, tval, group, y);
+}
 
+
+void Interpolation1D_Linear::interpolate_points(const std::vector<Point> & points, int group, std::vector<double> & values) const
+{
+  values.resize(points.size());
+
+  const std::vector<double> & y = _pre_computed_value.find(group)->second;
+  const int n_points = points.size();
+
+#pragma omp parallel num_threads(Genius::n_threads())
   {
-    int begin=0, end=n-1;
-    while(end-begin>2)
+    // each thread hunts from its own last interval
+    int ival = -1;
+#pragma omp for schedule(static)
+    for(int n=0; n<n_points; ++n)
     {
-      int mid = (begin+end)/2;
-      if( tval < t[mid] )
-        end = mid;
-      else
-        begin = mid;
+      double tval = points[n].x();
+      ival = _locate_interval(_coordinate, tval, ival, _inv_h);
+      values[n] = _evaluate(ival, tval, group, y);
     }
+  }
+}
 
-    int ival = n - 2;
-    for (int i = begin; i < end; i++ )
-    {
-      if ( tval < t[i+1] )
-      {
-        ival = i;
-        break;
-      }
-    }
-    genius_assert(ival>=0 && ival <n);
 
-    double dt = tval - t[ival];
-    double h = t[ival+1] - t[ival];
-    yval = y[ival]+ dt * ( y[ival+1] - y[ival] ) / h;
-  }
+double Interpolation1D_Linear::_evaluate(int ival, double tval, int group, const std::vector<double> & y) const
+{
+  const std::vector<double> & t = _coordinate;
+  genius_assert(ival>=0 && ival+1 < static_cast<int>(t.size()));
+
+  double dt = tval - t[ival];
+  double h = t[ival+1] - t[ival];
+  double yval = y[ival]+ dt * ( y[ival+1] - y[ival] ) / h;
 
   InterpolationType type = _interpolation_type.find(group)->second;
   switch(type)
@@ -106,5 +114,3 @@ double Interpolation1D_Linear::get_interpolated_value(const Point & point, int g
 
   return  yval;
 }
-
-
@@ -9,6 +9,7 @@
 void Interpolation1D_Spline::clear()
 {
   _coordinate.clear();
+  _inv_h = 0.0;
   _values.clear();
   _pre_computed_value.clear();
   _pre_computed_value_pp.clear();
@@ -26,6 +27,8 @@ void Interpolation1D_Spline::add_scatter_data(const Point & point, int group, do
 
 void Interpolation1D_Spline::setup(int group)
 {
+  _inv_h = _uniform_inv_spacing(_coordinate);
+
   int n = _coordinate.size();
 
   std::vector<double> a(3*n);
@@ -130,36 +133,45 @@ void Interpolation1D_Spline::broadcast(unsigned int root)
 
 double Interpolation1D_Spline::get_interpolated_value(const Point & point, int group) const
 {
-  int n = _coordinate.size();
-  const std::vector<double> & t = _coordinate;
   const std::vector<double> & y = _pre_computed_value.find(group)->second;
   const std::vector<double> & ypp = _pre_computed_value_pp.find(group)->second;
 
   double tval = point.x();
-  double yval = 0.0;
   //
   //  Determine the interval [ double(I), double(I+1) ] that contains TVAL.
   //  Values below double[0] or above double[N-1] use extrapolation.
   //
-  int begin=0, end=n-1;
-  while(end-begin>2)
-  {
-    int mid = (begin+end)/2;
-    if( tval < t[mid] )
-      end = mid;
-    else
-      begin = mid;
-  }
+  int ival = _locate_interval(_coordinate, tval, -1, _inv_h);
+  return _evaluate(ival, tval, group, y, ypp);
+}
+
 
-  int ival = n - 2;
-  for (int i = begin; i < end; i++ )
+void Interpolation1D_Spline::interpolate_points(const std::vector<Point> & points, int group, std::vector<double> & values) const
+{
+  values.resize(points.size());
+
+  const std::vector<double> & y = _pre_computed_value.find(group)->second;
+  const std::vector<double> & ypp = _pre_computed_value_pp.find(group)->second;
+  const int n_points = points.size();
+
+#pragma omp parallel num_threads(Genius::n_threads())
   {
-    if ( tval < t[i+1] )
+    // each thread hunts from its own last interval
+    int ival = -1;
+#pragma omp for schedule(static)
+    for(int n=0; n<n_points; ++n)
     {
-      ival = i;
-      break;
+      double tval = points[n].x();
+      ival = _locate_interval(_coordinate, tval, ival, _inv_h);
+      values[n] = _evaluate(ival, tval, group, y, ypp);
     }
   }
+}
+
+
+double Interpolation1D_Spline::_evaluate(int ival, double tval, int group, const std::vector<double> & y, const std::vector<double> & ypp) const
+{
+  const std::vector<double> & t = _coordinate;
 
   //
   //  In the interval I, the polynomial is in terms of a normalized
@@ -168,9 +180,9 @@ double Interpolation1D_Spline::get_interpolated_value(const Point & point, int g
   double dt = tval - t[ival];
   double h = t[ival+1] - t[ival];
 
-  yval = y[ival]+ dt * ( ( y[ival+1] - y[ival] ) / h
-                        - ( ypp[ival+1] / 6.0 + ypp[ival] / 3.0 ) * h
-                        + dt * ( 0.5 * ypp[ival] + dt * ( ( ypp[ival+1] - ypp[ival] ) / ( 6.0 * h ) ) ) );
+  double yval = y[ival]+ dt * ( ( y[ival+1] - y[ival] ) / h
+                               - ( ypp[ival+1] / 6.0 + ypp[ival] / 3.0 ) * h
+                               + dt * ( 0.5 * ypp[ival] + dt * ( ( ypp[ival+1] - ypp[ival] ) / ( 6.0 * h ) ) ) );
 
 
   InterpolationType type = _interpolation_type.find(group)->second;
@@ -184,5 +196,3 @@ double Interpolation1D_Spline::get_interpolated_value(const Point & point, int g
 
   return  yval;
 }
-
-
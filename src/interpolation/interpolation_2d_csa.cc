@@ -5,6 +5,7 @@
 #include "asinh.hpp"
 #include "interpolation_2d_csa.h"
 #include "parallel.h"
+#include "genius_env.h"
 
 Interpolation2D_CSA::Interpolation2D_CSA()
 {}
@@ -21,6 +22,7 @@ void Interpolation2D_CSA::clear()
   std::map<int, CSA::csa *>::iterator it = field_map.begin();
   for(; it != field_map.end(); ++it)
     CSA::csa_destroy(it->second);
+  field_map.clear();
   csa_points.clear();
 }
 
@@ -56,10 +58,36 @@ void Interpolation2D_CSA::add_scatter_data(const Point & point, int group, doubl
 
 void Interpolation2D_CSA::setup(int group)
 {
+  std::vector<CSA::point> & points = csa_points[group];
+
+  // tiled mode, drop the points far from the target
+  if( !_target_boxes.empty() )
+  {
+    std::vector<double> x(points.size()), y(points.size());
+    for(unsigned int i=0; i<points.size(); ++i)
+    {
+      x[i] = points[i].x;
+      y[i] = points[i].y;
+    }
+    std::vector<bool> keep;
+    _near_target_boxes(x, y, keep);
+
+    std::vector<CSA::point> near_points;
+    for(unsigned int i=0; i<points.size(); ++i)
+      if( keep[i] ) near_points.push_back(points[i]);
+    points.swap(near_points);
+  }
+
   CSA::csa * field=CSA::csa_create();
   field_map[group] = field;
-  CSA::csa_addpoints(field, csa_points[group].size(), &(csa_points[group][0]));
+  CSA::csa_setnthreads(field, Genius::n_threads());
+  CSA::csa_addpoints(field, points.size(), &(points[0]));
   CSA::csa_calculatespline(field);
+
+  // the spline coefficients are all we need for approximation,
+  // the points referenced by csa are not used any more
+  std::vector<CSA::point>().swap(points);
+
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   feclearexcept(FE_INVALID);
 #endif
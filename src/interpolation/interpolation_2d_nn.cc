@@ -5,6 +5,7 @@
 #include "asinh.hpp"
 #include "interpolation_2d_nn.h"
 #include "parallel.h"
+#include "genius_env.h"
 
 #include "log.h"
 
@@ -53,14 +54,27 @@ void Interpolation2D_NN::add_scatter_data(const Point & point, int group, double
 void Interpolation2D_NN::setup(int group)
 {
   DATA & data = field[group];
+  data.n = data.f.size();
+
+  // tiled mode, drop the points far from the target
+  std::vector<bool> keep;
+  _near_target_boxes(data.x, data.y, keep);
+
   std::vector<NN::point> points;
   for( unsigned int i=0; i<data.n; ++i )
   {
+    if( !keep[i] ) continue;
     NN::point  p = { data.x[i], data.y[i], data.f[i] };
     points.push_back(p);
   }
+  data.n = points.size();
   data.d = NN::delaunay_build(data.n, &points[0], 0, 0, 0, 0 );
   data.li = NN::lpi_build(data.d);
+
+  // delaunay keeps its own copy of the points
+  std::vector<double>().swap(data.x);
+  std::vector<double>().swap(data.y);
+  std::vector<double>().swap(data.f);
 }
 
 
@@ -90,3 +104,24 @@ double Interpolation2D_NN::get_interpolated_value(const Point & point, int group
   return p.z;
 }
 
+
+void Interpolation2D_NN::interpolate_points(const std::vector<Point> & points, int group, std::vector<double> & values) const
+{
+  const DATA & data = field.find(group)->second;
+  values.resize(points.size());
+
+  const int n_points = points.size();
+#pragma omp parallel num_threads(Genius::n_threads())
+  {
+    int seed = -1;
+
+#pragma omp for schedule(static)
+    for(int n=0; n<n_points; ++n)
+    {
+      NN::point  p = { points[n].x(), points[n].y(), 0 };
+      int tid = NN::lpi_interpolate_point_seed(data.li, &p, seed);
+      if( tid >= 0 ) seed = tid;
+      values[n] = p.z;
+    }
+  }
+}
@@ -26,9 +26,9 @@ ANNSession::ANNSession(int dim) :
 void ANNSession::clear()
 {
   if (_datapts!=NULL)
-    delete _datapts;
+    delete [] _datapts;
   if (_databuf!=NULL)
-    delete _databuf;
+    delete [] _databuf;
   if (_kdTree!=NULL)
     delete _kdTree;
 
@@ -129,7 +129,10 @@ ANNResultType ANNSession::search(const Point &pt, const unsigned int k) const
   ANNdistArray _resdist;      // distances of result points
 
   if (_pts.size()<k)
+  {
+    delete [] ann_pt;
     return res;
+  }
 
   _residx  = new ANNidx[k];            // allocate near neighbor indices
   _resdist = new ANNdist[k];           // allocate near neighbor dists
@@ -140,8 +143,9 @@ ANNResultType ANNSession::search(const Point &pt, const unsigned int k) const
     res.push_back(std::pair<int, double>(_residx[i],_resdist[i]));
   }
 
-  delete _residx;
-  delete _resdist;
+  delete [] _residx;
+  delete [] _resdist;
+  delete [] ann_pt;
 
   return res;
 }
@@ -159,56 +163,164 @@ long ANNSession::size() const
   return _pts.size();
 }
 
-Interpolation3D_nbtet::Interpolation3D_nbtet() :
-  _ann(3)
+Interpolation3D_nbtet::Interpolation3D_nbtet()
+{
+}
+
+Interpolation3D_nbtet::~Interpolation3D_nbtet()
 {
+  this->clear();
 }
 
 void Interpolation3D_nbtet::clear()
 {
+  _points.clear();
   _field.clear();
-  _ann.clear();
+  for(unsigned int n=0; n<_sessions.size(); ++n)
+    delete _sessions[n];
+  _sessions.clear();
+  _group_session.clear();
 }
 
 void Interpolation3D_nbtet::broadcast(unsigned int root)
 {
-  _ann.broadcast(root);
-  Parallel::broadcast(_field, root);
+  std::vector<int> groups;
+  if(Genius::processor_id()==root)
+  {
+    std::map<int, std::vector<Point> >::const_iterator it = _points.begin();
+    for(; it != _points.end(); ++it)
+      groups.push_back(it->first);
+  }
+  Parallel::broadcast(groups, root);
+
+  for(unsigned int g=0; g<groups.size(); ++g)
+  {
+    std::vector<Point> & pts = _points[groups[g]];
+
+    std::vector<double> x,y,z;
+    if(Genius::processor_id()==root)
+    {
+      for (unsigned int i=0; i<pts.size(); i++){
+        x.push_back(pts[i](0));
+        y.push_back(pts[i](1));
+        z.push_back(pts[i](2));
+      }
+    }
+    Parallel::broadcast(x, root);
+    Parallel::broadcast(y, root);
+    Parallel::broadcast(z, root);
+    if(Genius::processor_id()!=root)
+    {
+      pts.resize(x.size());
+      for (unsigned int i=0; i<x.size(); i++)
+        pts[i] = Point(x[i], y[i], z[i]);
+    }
+
+    Parallel::broadcast(_field[groups[g]], root);
+  }
 }
 
 void Interpolation3D_nbtet::add_scatter_data(const Point & pt, int group, double value)
 {
-  assert(group==0); // we currently support 1 group only
-  _ann.addPoint(pt);
+  _points[group].push_back(pt);
 
   InterpolationType type = _interpolation_type[group];
-  _field.push_back(scaleValue(type, value));
+  _field[group].push_back(scaleValue(type, value));
 }
 
 void Interpolation3D_nbtet::setup(int group)
 {
-  assert(group==0);
-  _ann.setup();
+  std::vector<Point> & pts = _points[group];
+
+  // reuse the kd-tree of other group when the scatter points are the same
+  for(unsigned int n=0; n<_sessions.size(); ++n)
+  {
+    if( _sessions[n]->points() == pts )
+    {
+      _group_session[group] = n;
+      pts.clear();
+      return;
+    }
+  }
+
+  ANNSession * ann = new ANNSession(3);
+  for(unsigned int i=0; i<pts.size(); ++i)
+    ann->addPoint(pts[i]);
+  ann->setup();
+
+  _group_session[group] = _sessions.size();
+  _sessions.push_back(ann);
+  pts.clear();
 }
 
+
 double Interpolation3D_nbtet::get_interpolated_value(const Point & pt, int group) const
 {
-  assert(group==0); // we currently support 1 group only
+  genius_assert(_group_session.find(group) != _group_session.end());
+  const ANNSession & ann = *_sessions[_group_session.find(group)->second];
 
+  int index[4];
+  double numerator[4], denominator;
+  if( !_locate(ann, pt, index, numerator, denominator) )
+  {
+    MESSAGE << "Interpolation: warning: interpolation failed, assume zero at this point." << std::endl; RECORD();
+    return 0.0;
+  }
+  return _value(group, index, numerator, denominator);
+}
+
+
+void Interpolation3D_nbtet::get_interpolated_values(const Point & pt, const std::vector<int> & groups, std::vector<double> & values) const
+{
+  values.resize(groups.size());
+
+  // located tetrahedron of each kd-tree
+  std::vector<int>    located(_sessions.size(), -1);
+  std::vector<int>    index(4*_sessions.size());
+  std::vector<double> numerator(4*_sessions.size());
+  std::vector<double> denominator(_sessions.size());
+
+  for(unsigned int n=0; n<groups.size(); ++n)
+  {
+    genius_assert(_group_session.find(groups[n]) != _group_session.end());
+    unsigned int s = _group_session.find(groups[n])->second;
+
+    if( located[s] < 0 )
+    {
+      located[s] = _locate(*_sessions[s], pt, &index[4*s], &numerator[4*s], denominator[s]) ? 1 : 0;
+      if( !located[s] )
+      {
+        MESSAGE << "Interpolation: warning: interpolation failed, assume zero at this point." << std::endl; RECORD();
+      }
+    }
+
+    values[n] = located[s] ? _value(groups[n], &index[4*s], &numerator[4*s], denominator[s]) : 0.0;
+  }
+}
+
+
+double Interpolation3D_nbtet::_value(int group, const int index[4], const double numerator[4], double denominator) const
+{
+  const std::vector<double> & f = _field.find(group)->second;
+  InterpolationType type = _interpolation_type.find(group)->second;
+  return unscaleValue(type, (numerator[0]*f[index[0]] + numerator[1]*f[index[1]] + numerator[2]*f[index[2]] + numerator[3]*f[index[3]])/denominator);
+}
+
+
+bool Interpolation3D_nbtet::_locate(const ANNSession &ann, const Point & pt, int index[4], double numerator[4], double &denominator) const
+{
   double toler;
   unsigned int maxpt = 20;
   int ia, ib, ic, id;
   Point tetp[4];
-  ANNResultType ann_res = _ann.search(pt,maxpt);
+  ANNResultType ann_res = ann.search(pt,maxpt);
 
   assert(ann_res.size()==maxpt);
 
   ia = ann_res[0].first;
   ib = ann_res[1].first;
-  tetp[0] = _ann.getPointCoord(ia); // coord of 1st point
-  tetp[1] = _ann.getPointCoord(ib); // coord of 2nd point
-
-  InterpolationType type = _interpolation_type.find(group)->second;
+  tetp[0] = ann.getPointCoord(ia); // coord of 1st point
+  tetp[1] = ann.getPointCoord(ib); // coord of 2nd point
 
   for (int pass=0; pass<2; pass++)
   {
@@ -221,7 +333,7 @@ double Interpolation3D_nbtet::get_interpolated_value(const Point & pt, int group
         Point vab, vac, r, vtmp;
 
         ic = ann_res[j].first;
-        tetp[2] = _ann.getPointCoord(ic); // coord of 3rd point
+        tetp[2] = ann.getPointCoord(ic); // coord of 3rd point
         vab = tetp[0]-tetp[1];
         vac = tetp[0]-tetp[2];
         r = vab.cross(vac);
@@ -242,7 +354,7 @@ double Interpolation3D_nbtet::get_interpolated_value(const Point & pt, int group
         Point vab, vac, vad, vtmp;
 
         id = ann_res[j].first;
-        tetp[3] = _ann.getPointCoord(id); // coord of 4th point
+        tetp[3] = ann.getPointCoord(id); // coord of 4th point
         vab = tetp[1]-tetp[0];
         vac = tetp[2]-tetp[0];
         vad = tetp[3]-tetp[0];
@@ -282,7 +394,10 @@ double Interpolation3D_nbtet::get_interpolated_value(const Point & pt, int group
           // in the first pass, we require strictly that the point is in the tetrahedron
           if (vol_a>=0 && vol_b>=0 && vol_c>=0 && vol_d>=0)
           {
-            return unscaleValue(type, (vol_a*_field[ia] + vol_b*_field[ib] + vol_c*_field[ic] + vol_d*_field[id])/vol);
+            index[0] = ia; index[1] = ib; index[2] = ic; index[3] = id;
+            numerator[0] = vol_a; numerator[1] = vol_b; numerator[2] = vol_c; numerator[3] = vol_d;
+            denominator = vol;
+            return true;
           }
         }
         else
@@ -291,7 +406,10 @@ double Interpolation3D_nbtet::get_interpolated_value(const Point & pt, int group
           double extrap_tol = -1e-2*vol;
           if (vol_a>extrap_tol && vol_b>extrap_tol && vol_c>extrap_tol && vol_d>extrap_tol)
           {
-            return unscaleValue(type, (vol_a*_field[ia] + vol_b*_field[ib] + vol_c*_field[ic] + vol_d*_field[id])/vol);
+            index[0] = ia; index[1] = ib; index[2] = ic; index[3] = id;
+            numerator[0] = vol_a; numerator[1] = vol_b; numerator[2] = vol_c; numerator[3] = vol_d;
+            denominator = vol;
+            return true;
           }
         }
       }
@@ -300,13 +418,12 @@ double Interpolation3D_nbtet::get_interpolated_value(const Point & pt, int group
   if((pt-tetp[0]).size()<1e10) // FIXME: should have a more reasonable threshold here.
   {
     //MESSAGE << "Interpolation: warning: using nearest data point at line " << ia << std::endl; RECORD();
-    return unscaleValue(type, _field[ia]);
-  }
-  else
-  {
-    MESSAGE << "Interpolation: warning: interpolation failed, assume zero at this point." << std::endl; RECORD();
-    return 0.0;
+    index[0] = index[1] = index[2] = index[3] = ia;
+    numerator[0] = 1.0; numerator[1] = numerator[2] = numerator[3] = 0.0;
+    denominator = 1.0;
+    return true;
   }
+  return false;
 }
 
 
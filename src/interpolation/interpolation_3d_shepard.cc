@@ -0,0 +1,398 @@
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include "genius_common.h"
+#include "genius_env.h"
+#include "interpolation_3d_shepard.h"
+#include "parallel.h"
+
+
+const unsigned int Interpolation3D_Shepard::_nq;
+const unsigned int Interpolation3D_Shepard::_nw;
+
+
+Interpolation3D_Shepard::PointTree::PointTree(const std::vector<Point> & points)
+  : _points(points), _index(points.size()), _split(points.size(), 0)
+{
+  for(unsigned int i=0; i<_index.size(); ++i)
+    _index[i] = i;
+  _build(0, _index.size());
+}
+
+
+namespace
+{
+  /**
+   * compare the point index by one coordinate
+   */
+  struct CoordLess
+  {
+    CoordLess(const std::vector<Point> & points, unsigned int dim) : _points(points), _dim(dim) {}
+    bool operator() (unsigned int a, unsigned int b) const
+    { return _points[a](_dim) < _points[b](_dim); }
+    const std::vector<Point> & _points;
+    unsigned int _dim;
+  };
+}
+
+
+void Interpolation3D_Shepard::PointTree::_build(unsigned int lo, unsigned int hi)
+{
+  if( hi <= lo + 1 ) return;
+
+  // split along the widest dimension of the range
+  Point pmin = _points[_index[lo]], pmax = pmin;
+  for(unsigned int i=lo+1; i<hi; ++i)
+    for(unsigned int d=0; d<3; ++d)
+    {
+      pmin(d) = std::min(pmin(d), _points[_index[i]](d));
+      pmax(d) = std::max(pmax(d), _points[_index[i]](d));
+    }
+  unsigned int dim = 0;
+  for(unsigned int d=1; d<3; ++d)
+    if( pmax(d) - pmin(d) > pmax(dim) - pmin(dim) ) dim = d;
+
+  const unsigned int mid = (lo + hi)/2;
+  std::nth_element(_index.begin()+lo, _index.begin()+mid, _index.begin()+hi, CoordLess(_points, dim));
+  _split[mid] = dim;
+
+  _build(lo, mid);
+  _build(mid+1, hi);
+}
+
+
+void Interpolation3D_Shepard::PointTree::nearest(const Point & p, unsigned int k, std::vector<std::pair<double, unsigned int> > & result) const
+{
+  result.clear();
+  k = std::min(k, static_cast<unsigned int>(_points.size()));
+  if( k == 0 ) return;
+
+  _search(p, k, 0, _index.size(), result);
+  std::sort_heap(result.begin(), result.end());
+}
+
+
+void Interpolation3D_Shepard::PointTree::_search(const Point & p, unsigned int k, unsigned int lo, unsigned int hi,
+    std::vector<std::pair<double, unsigned int> > & heap) const
+{
+  if( hi <= lo ) return;
+
+  const unsigned int mid = (lo + hi)/2;
+  const unsigned int index = _index[mid];
+  const double d2 = (p - _points[index]).size_sq();
+
+  // heap is a max-heap of the k nearest points found so far
+  if( heap.size() < k )
+  {
+    heap.push_back(std::make_pair(d2, index));
+    std::push_heap(heap.begin(), heap.end());
+  }
+  else if( d2 < heap.front().first )
+  {
+    std::pop_heap(heap.begin(), heap.end());
+    heap.back() = std::make_pair(d2, index);
+    std::push_heap(heap.begin(), heap.end());
+  }
+
+  if( hi == lo + 1 ) return;
+
+  const double diff = p(_split[mid]) - _points[index](_split[mid]);
+  if( diff < 0 )
+  {
+    _search(p, k, lo, mid, heap);
+    if( heap.size() < k || diff*diff < heap.front().first )
+      _search(p, k, mid+1, hi, heap);
+  }
+  else
+  {
+    _search(p, k, mid+1, hi, heap);
+    if( heap.size() < k || diff*diff < heap.front().first )
+      _search(p, k, lo, mid, heap);
+  }
+}
+
+
+
+Interpolation3D_Shepard::Interpolation3D_Shepard()
+{}
+
+
+Interpolation3D_Shepard::~Interpolation3D_Shepard()
+{
+  this->clear();
+}
+
+
+void Interpolation3D_Shepard::clear()
+{
+  _points.clear();
+  _field.clear();
+  _coeffs.clear();
+  _field_limit.clear();
+  for(unsigned int n=0; n<_trees.size(); ++n)
+    delete _trees[n];
+  _trees.clear();
+  _group_tree.clear();
+}
+
+
+void Interpolation3D_Shepard::broadcast(unsigned int root)
+{
+  std::vector<int> groups;
+  if(Genius::processor_id()==root)
+  {
+    std::map<int, std::vector<Point> >::const_iterator it = _points.begin();
+    for(; it != _points.end(); ++it)
+      groups.push_back(it->first);
+  }
+  Parallel::broadcast(groups, root);
+
+  for(unsigned int g=0; g<groups.size(); ++g)
+  {
+    std::vector<Point> & pts = _points[groups[g]];
+
+    std::vector<double> xyz;
+    if(Genius::processor_id()==root)
+    {
+      for (unsigned int i=0; i<pts.size(); i++)
+        for (unsigned int d=0; d<3; d++)
+          xyz.push_back(pts[i](d));
+    }
+    Parallel::broadcast(xyz, root);
+    if(Genius::processor_id()!=root)
+    {
+      pts.resize(xyz.size()/3);
+      for (unsigned int i=0; i<pts.size(); i++)
+        pts[i] = Point(xyz[3*i], xyz[3*i+1], xyz[3*i+2]);
+    }
+
+    Parallel::broadcast(_field[groups[g]], root);
+
+    std::pair<double, double> & limits = _field_limit[groups[g]];
+    Parallel::broadcast(limits.first,  root);
+    Parallel::broadcast(limits.second, root);
+  }
+}
+
+
+void Interpolation3D_Shepard::add_scatter_data(const Point & pt, int group, double value)
+{
+  _points[group].push_back(pt);
+
+  if(_field_limit.find(group)==_field_limit.end())
+    _field_limit[group] = std::make_pair(value, value);
+  else
+  {
+    _field_limit[group].first  = std::min(_field_limit[group].first, value);
+    _field_limit[group].second = std::max(_field_limit[group].second, value);
+  }
+
+  InterpolationType type = _interpolation_type[group];
+  _field[group].push_back(scaleValue(type, value));
+}
+
+
+void Interpolation3D_Shepard::setup(int group)
+{
+  std::vector<Point> & pts = _points[group];
+  genius_assert(!pts.empty());
+
+  // reuse the kd-tree of other group when the scatter points are the same
+  unsigned int t = _trees.size();
+  for(unsigned int n=0; n<_trees.size(); ++n)
+    if( _trees[n]->points() == pts )
+      t = n;
+
+  if( t == _trees.size() )
+    _trees.push_back(new PointTree(pts));
+  _group_tree[group] = t;
+  std::vector<Point>().swap(pts);
+
+  _fit(*_trees[t], _field[group], _coeffs[group]);
+}
+
+
+namespace
+{
+  /**
+   * solve the n x n system A x = b by gauss elimination with partial pivoting
+   * @return false when A is singular to the given relative tolerance
+   */
+  bool dense_solve(unsigned int n, double A[9][9], double b[9], double x[9])
+  {
+    double scale = 0.0;
+    for(unsigned int i=0; i<n; ++i)
+      scale = std::max(scale, std::abs(A[i][i]));
+    if( !(scale > 0.0) ) return false;
+
+    for(unsigned int c=0; c<n; ++c)
+    {
+      unsigned int p = c;
+      for(unsigned int r=c+1; r<n; ++r)
+        if( std::abs(A[r][c]) > std::abs(A[p][c]) ) p = r;
+      if( std::abs(A[p][c]) < 1e-12*scale ) return false;
+      if( p != c )
+      {
+        for(unsigned int k=0; k<n; ++k) std::swap(A[p][k], A[c][k]);
+        std::swap(b[p], b[c]);
+      }
+      for(unsigned int r=c+1; r<n; ++r)
+      {
+        const double m = A[r][c]/A[c][c];
+        for(unsigned int k=c; k<n; ++k) A[r][k] -= m*A[c][k];
+        b[r] -= m*b[c];
+      }
+    }
+
+    for(int r=n-1; r>=0; --r)
+    {
+      double s = b[r];
+      for(unsigned int k=r+1; k<n; ++k) s -= A[r][k]*x[k];
+      x[r] = s/A[r][r];
+    }
+    return true;
+  }
+}
+
+
+void Interpolation3D_Shepard::_fit(const PointTree & tree, const std::vector<double> & f, std::vector<double> & coeffs)
+{
+  const std::vector<Point> & pts = tree.points();
+  coeffs.assign(9*pts.size(), 0.0);
+
+  const int n_points = pts.size();
+#pragma omp parallel for schedule(dynamic, 256) num_threads(Genius::n_threads())
+  for(int k=0; k<n_points; ++k)
+  {
+    // the nearest points, except k itself and the duplicated ones
+    std::vector<std::pair<double, unsigned int> > nn;
+    tree.nearest(pts[k], _nq+1, nn);
+    while( !nn.empty() && nn.front().first == 0.0 )
+      nn.erase(nn.begin());
+    if( nn.empty() ) continue;
+
+    const double R = 1.0001*std::sqrt(nn.back().first);
+
+    // quadratic fit, or linear fit when there are not enough points or they are degenerated.
+    // the coordinates are scaled by R
+    for(unsigned int order=2; order>=1; --order)
+    {
+      const unsigned int n_unknown = (order == 2) ? 9 : 3;
+      if( nn.size() < n_unknown ) continue;
+
+      double A[9][9], b[9], x[9];
+      for(unsigned int i=0; i<n_unknown; ++i)
+      {
+        b[i] = 0.0;
+        for(unsigned int j=0; j<n_unknown; ++j) A[i][j] = 0.0;
+      }
+
+      for(unsigned int j=0; j<nn.size(); ++j)
+      {
+        const Point dp = (pts[nn[j].second] - pts[k])/R;
+        const double d = std::sqrt(nn[j].first)/R;
+        const double w = (1.0 - d)/d;
+        const double w2 = w*w;
+
+        const double row[9] = { dp(0), dp(1), dp(2),
+                                dp(0)*dp(0), dp(0)*dp(1), dp(0)*dp(2), dp(1)*dp(1), dp(1)*dp(2), dp(2)*dp(2) };
+        const double df = f[nn[j].second] - f[k];
+        for(unsigned int r=0; r<n_unknown; ++r)
+        {
+          b[r] += w2*row[r]*df;
+          for(unsigned int c=0; c<n_unknown; ++c)
+            A[r][c] += w2*row[r]*row[c];
+        }
+      }
+
+      if( !dense_solve(n_unknown, A, b, x) ) continue;
+
+      for(unsigned int i=0; i<3; ++i)
+        coeffs[9*k+i] = x[i]/R;
+      for(unsigned int i=3; i<n_unknown; ++i)
+        coeffs[9*k+i] = x[i]/(R*R);
+      break;
+    }
+  }
+}
+
+
+double Interpolation3D_Shepard::get_interpolated_value(const Point & pt, int group) const
+{
+  genius_assert(_group_tree.find(group) != _group_tree.end());
+  const PointTree & tree = *_trees[_group_tree.find(group)->second];
+
+  std::vector<std::pair<double, unsigned int> > nn;
+  tree.nearest(pt, _nw, nn);
+  return _value(group, tree, pt, nn);
+}
+
+
+void Interpolation3D_Shepard::get_interpolated_values(const Point & pt, const std::vector<int> & groups, std::vector<double> & values) const
+{
+  values.resize(groups.size());
+
+  // the nearest points of each kd-tree
+  std::vector< std::vector<std::pair<double, unsigned int> > > nn(_trees.size());
+  std::vector<bool> searched(_trees.size(), false);
+
+  for(unsigned int n=0; n<groups.size(); ++n)
+  {
+    genius_assert(_group_tree.find(groups[n]) != _group_tree.end());
+    unsigned int t = _group_tree.find(groups[n])->second;
+
+    if( !searched[t] )
+    {
+      _trees[t]->nearest(pt, _nw, nn[t]);
+      searched[t] = true;
+    }
+
+    values[n] = _value(groups[n], *_trees[t], pt, nn[t]);
+  }
+}
+
+
+double Interpolation3D_Shepard::_value(int group, const PointTree & tree, const Point & p, const std::vector<std::pair<double, unsigned int> > & nn) const
+{
+  const std::vector<Point>  & pts = tree.points();
+  const std::vector<double> & f = _field.find(group)->second;
+  const std::vector<double> & coeffs = _coeffs.find(group)->second;
+  InterpolationType type = _interpolation_type.find(group)->second;
+
+  double value;
+  const double R = 1.0001*std::sqrt(nn.back().first);
+  if( nn.front().first <= 1e-20*R*R )
+  {
+    // p is on a scatter point
+    value = f[nn.front().second];
+  }
+  else
+  {
+    double sum = 0.0, sum_w = 0.0;
+    for(unsigned int j=0; j<nn.size(); ++j)
+    {
+      const unsigned int k = nn[j].second;
+      const double d = std::sqrt(nn[j].first);
+      const double w = (R - d)*(R - d)/nn[j].first;
+
+      const Point dp = p - pts[k];
+      const double * c = &coeffs[9*k];
+      const double q = f[k] + c[0]*dp(0) + c[1]*dp(1) + c[2]*dp(2)
+                       + c[3]*dp(0)*dp(0) + c[4]*dp(0)*dp(1) + c[5]*dp(0)*dp(2)
+                       + c[6]*dp(1)*dp(1) + c[7]*dp(1)*dp(2) + c[8]*dp(2)*dp(2);
+      sum   += w*q;
+      sum_w += w;
+    }
+    value = sum/sum_w;
+  }
+
+  value = unscaleValue(type, value);
+
+  double vmin = _field_limit.find(group)->second.first;
+  double vmax = _field_limit.find(group)->second.second;
+  if(value<vmin) value = vmin;
+  if(value>vmax) value = vmax;
+
+  return value;
+}
@@ -0,0 +1,125 @@
+#include <cmath>
+#include <algorithm>
+
+#include "interpolation_base.h"
+#include "genius_env.h"
+
+
+void InterpolationBase::interpolate_points(const std::vector<Point> & points, int group, std::vector<double> & values) const
+{
+  values.resize(points.size());
+
+  const bool threaded = this->thread_safe();
+  const int n_points = points.size();
+#pragma omp parallel for schedule(static) num_threads(Genius::n_threads()) if(threaded)
+  for(int n=0; n<n_points; ++n)
+    values[n] = this->get_interpolated_value(points[n], group);
+}
+
+
+/**
+ * the target boxes are covered by a grid of square tiles, the tile is not smaller
+ * than the margin, which is 8 times of the average spacing of the scattered points.
+ * a point is kept when its tile or the tiles around it overlap any target box.
+ */
+void InterpolationBase::_near_target_boxes(const std::vector<double> & x, const std::vector<double> & y, std::vector<bool> & keep) const
+{
+  keep.assign(x.size(), true);
+  if( _target_boxes.empty() || x.empty() ) return;
+
+  double xmin = *std::min_element(x.begin(), x.end());
+  double xmax = *std::max_element(x.begin(), x.end());
+  double ymin = *std::min_element(y.begin(), y.end());
+  double ymax = *std::max_element(y.begin(), y.end());
+  const double margin = 8.0*std::sqrt((xmax-xmin)*(ymax-ymin)/x.size());
+  // the scattered points are not distributed in 2D
+  if( !(margin > 0.0) ) return;
+
+  double txmin = _target_boxes[0].first(0),  txmax = _target_boxes[0].second(0);
+  double tymin = _target_boxes[0].first(1),  tymax = _target_boxes[0].second(1);
+  for(unsigned int n=1; n<_target_boxes.size(); ++n)
+  {
+    txmin = std::min(txmin, _target_boxes[n].first(0));
+    txmax = std::max(txmax, _target_boxes[n].second(0));
+    tymin = std::min(tymin, _target_boxes[n].first(1));
+    tymax = std::max(tymax, _target_boxes[n].second(1));
+  }
+
+  const double x0 = txmin - margin;
+  const double y0 = tymin - margin;
+  const double tile = std::max(margin, std::max(txmax-txmin, tymax-tymin)/256.0);
+  const int ni = static_cast<int>((txmax - txmin + 2*margin)/tile) + 1;
+  const int nj = static_cast<int>((tymax - tymin + 2*margin)/tile) + 1;
+
+  // the tiles overlap the target boxes, extended by one tile
+  std::vector<bool> near(ni*nj, false);
+  for(unsigned int n=0; n<_target_boxes.size(); ++n)
+  {
+    const int i0 = std::max(0,    static_cast<int>((_target_boxes[n].first(0)  - x0)/tile) - 1);
+    const int i1 = std::min(ni-1, static_cast<int>((_target_boxes[n].second(0) - x0)/tile) + 1);
+    const int j0 = std::max(0,    static_cast<int>((_target_boxes[n].first(1)  - y0)/tile) - 1);
+    const int j1 = std::min(nj-1, static_cast<int>((_target_boxes[n].second(1) - y0)/tile) + 1);
+    for(int i=i0; i<=i1; ++i)
+      for(int j=j0; j<=j1; ++j)
+        near[i*nj+j] = true;
+  }
+
+  unsigned int n_keep = 0;
+  for(unsigned int n=0; n<x.size(); ++n)
+  {
+    const double fi = std::floor((x[n] - x0)/tile);
+    const double fj = std::floor((y[n] - y0)/tile);
+    keep[n] = fi >= 0 && fj >= 0 && fi < ni && fj < nj && near[static_cast<int>(fi)*nj + static_cast<int>(fj)];
+    if( keep[n] ) n_keep++;
+  }
+
+  // too few points to fit, keep all of them
+  if( n_keep < 3 )
+    keep.assign(x.size(), true);
+}
+
+
+
+double InterpolationBase::_uniform_inv_spacing(const std::vector<double> & t)
+{
+  if( t.size() < 3 ) return 0.0;
+
+  const double h = (t.back() - t.front())/(t.size()-1);
+  if( !(h > 0.0) ) return 0.0;
+
+  for(unsigned int i=0; i<t.size()-1; ++i)
+    if( std::abs((t[i+1] - t[i]) - h) > 1e-10*h ) return 0.0;
+
+  return 1.0/h;
+}
+
+
+int InterpolationBase::_locate_interval(const std::vector<double> & t, double x, int hint, double inv_h)
+{
+  const int n = t.size();
+  if( n < 3 ) return 0;
+
+  // hunting from the last interval
+  if( hint >= 0 && hint < n-1 )
+  {
+    if( x >= t[hint] && (x < t[hint+1] || hint == n-2) ) return hint;
+    if( hint < n-2 && x >= t[hint+1] && (x < t[hint+2] || hint+1 == n-2) ) return hint+1;
+  }
+
+  if( x < t[1] ) return 0;
+  if( x >= t[n-2] ) return n-2;
+
+  int i;
+  if( inv_h > 0.0 )
+  {
+    // uniform grid, correct the round off of the direct index
+    i = static_cast<int>((x - t[0])*inv_h);
+    i = std::max(0, std::min(i, n-2));
+    while( i > 0 && x < t[i] ) --i;
+    while( i < n-2 && x >= t[i+1] ) ++i;
+  }
+  else
+    i = static_cast<int>(std::upper_bound(t.begin(), t.end(), x) - t.begin()) - 1;
+
+  return i;
+}
@@ -20,11 +20,14 @@
 /********************************************************************************/
 
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <string>
+#include <vector>
 
 #include "genius_common.h"
 #include "genius_env.h"
@@ -35,6 +38,10 @@
 #include "parser.h"
 #include "control.h"
 #include "parallel.h"
+#include "solver_stats.h"
+#include "hw_counter.h"
+#include "async_exec.h"
+#include "deck_server.h"
 
 
 
@@ -46,6 +53,8 @@
 
 static void show_logo();
 
+static void solve_deck(const std::string &deck, Parser::Pattern &pt, const std::string &server);
+
 #ifdef PETSC_VERSION_DEV
 static PetscErrorCode genius_error_handler(MPI_Comm comm, int line, const char *func, const char *file, const char *dir,PetscErrorCode n, PetscErrorType p, const char *mess,void *ctx);
 #else
@@ -69,20 +78,16 @@ int main(int argc, char ** args)
   if( Genius::n_processors() > 1 )
   {
     PetscPrintf(PETSC_COMM_WORLD,"ERROR: Open Source Version does not support multi-processor.\n");
-    PetscFinalize();
+    Genius::clean_processors();
     exit(0);
   }
 #endif
 
-  // record the start time
-  PetscLogDouble t_start;
-  PetscGetTime(&t_start);
-
   // count the number of user's input argument
   if(argc<2)
   {
-    PetscPrintf(PETSC_COMM_WORLD,"usage: mpirun -n [1-9]+ genius -i card_file [petsc_option]\n");
-    PetscFinalize();
+    PetscPrintf(PETSC_COMM_WORLD,"usage: mpirun -n [1-9]+ genius -i card_file[,card_file...] [-ensemble_groups n] [-bias_groups n] [-threads n] [-geometry_cache prefix] [-optical_cache prefix] [-pattern_cache file] [-trace prefix] [-hw_counters [fp_event]] [-solver_stats file] [-server [address:]port] [petsc_option]\n");
+    Genius::clean_processors();
     exit(0);
   }
 
@@ -91,7 +96,7 @@ int main(int argc, char ** args)
   if( getenv("GENIUS_DIR") == NULL )
   {
     PetscPrintf(PETSC_COMM_WORLD,"ERROR: User should set entironment variable GENIUS_DIR.\n");
-    PetscFinalize();
+    Genius::clean_processors();
     exit(0);
   }
   Genius::set_genius_dir(getenv("GENIUS_DIR"));
@@ -104,49 +109,72 @@ int main(int argc, char ** args)
   if( !flg )
   {
     PetscPrintf(PETSC_COMM_WORLD,"ERROR: I want an input file to tell me what to do.\n");
-    PetscFinalize();
+    Genius::clean_processors();
     exit(0);
   }
-  Genius::set_input_file(input_file);
 
-  // prepare log system
-  std::ofstream logfs;
-  if (Genius::processor_id() == 0)
+  // in ensemble mode, this process group solves its own share of the decks one by one,
+  // otherwise the only deck is the input file
+  std::vector<std::string> decks = Genius::ensemble_decks();
+  if( decks.empty() )
+    decks.push_back(input_file);
+
+  // all the threaded loops of each processor (assembly, interpolation, ray tracing, file output)
+  // share one OpenMP team of this size. it is given by -threads or the environment variable
+  // GENIUS_THREADS, 0 takes the cpus owned by the processor, which keeps the threads of all
+  // the processors on a node within its cores
+  PetscInt n_threads = 1;
+  PetscOptionsGetInt(PETSC_NULL, "-threads", &n_threads, &flg);
+  if( !flg && getenv("GENIUS_THREADS") )
   {
-    genius_log.addStream("console", std::cerr.rdbuf());
-    std::stringstream log_file;
-    log_file << Genius::input_file() << ".log";
-    logfs.open(log_file.str().c_str());
-    genius_log.addStream("file", logfs.rdbuf());
+    n_threads = atoi(getenv("GENIUS_THREADS"));
+    flg = PETSC_TRUE;
   }
 
-  // test if input file can be opened on processor 0 for read
-  if ( Genius::processor_id() == 0 )
-  {
-#ifdef CYGWIN
-    if ( _access( Genius::input_file(),  04 ) == -1 )
-#else
-    if ( access( Genius::input_file(),  R_OK ) == -1 )
-#endif
-    {
-      PetscPrintf(PETSC_COMM_WORLD,"ERROR: I can't read input file '%s', access failed.\n", Genius::input_file() );
-      PetscFinalize();
-      exit(0);
-    }
-  }
-
-  // preprocess include statement of input file
-  std::string input_file_pp;
-  if (Genius::processor_id() == 0)
-  {
-    Parser::FilePreProcess * file_preprocess = new Parser::FilePreProcess(Genius::input_file());
-    input_file_pp = file_preprocess->output();
-    delete file_preprocess;
-  }
-  Parallel::broadcast(input_file_pp);
-
-  // sync input file to other processor
-  const std::string localfile = sync_file(input_file_pp.c_str());
+  // pin each thread to its own cpu of the processor, by -thread_bind or GENIUS_THREAD_BIND
+  PetscBool bind_threads;
+  PetscOptionsHasName(PETSC_NULL, "-thread_bind", &bind_threads);
+  if( bind_threads || getenv("GENIUS_THREAD_BIND") )
+    Genius::set_thread_binding(true);
+
+  if( flg )
+    Genius::set_n_threads(n_threads > 0 ? n_threads : Genius::default_n_threads());
+
+  // log level, 0 quiet, 1 normal, 2 also the residual of each nonlinear iteration (default), 3 verbose
+  PetscInt log_level = GENIUS_LOG_STREAM::ITERATION;
+  PetscOptionsGetInt(PETSC_NULL, "-log_level", &log_level, &flg);
+  if( flg )
+    genius_log.set_level(static_cast<GENIUS_LOG_STREAM::Level>(std::max(0, std::min(3, static_cast<int>(log_level)))));
+
+  // record the timeline of the logged events, each processor writes prefix.<processor id>.json
+  char trace_prefix[1024];
+  PetscOptionsGetString(PETSC_NULL, "-trace", trace_prefix, 1023, &flg);
+  if( flg )
+    tracelog.enable(trace_prefix);
+
+  // hardware counters of the logged events, the optional value is the raw perf event counting flops
+  char hw_fp_event[1024] = "";
+  PetscOptionsGetString(PETSC_NULL, "-hw_counters", hw_fp_event, 1023, &flg);
+  if( flg )
+    HWCounter::enable(strtoull(hw_fp_event, NULL, 0));
+
+  // machine readable statistics of the nonlinear solves, as JSON lines
+  char solver_stats_file[1024];
+  PetscOptionsGetString(PETSC_NULL, "-solver_stats", solver_stats_file, 1023, &flg);
+  if( flg )
+    SolverStats::open(solver_stats_file);
+
+  // reuse the FVM geometry of the same mesh from cache file
+  char geometry_cache[1024];
+  PetscOptionsGetString(PETSC_NULL, "-geometry_cache", geometry_cache, 1023, &flg);
+  if( flg )
+    Genius::set_geometry_cache(geometry_cache);
+
+  // reuse the optical generation of the same mesh and light source from cache file
+  char optical_cache[1024];
+  PetscOptionsGetString(PETSC_NULL, "-optical_cache", optical_cache, 1023, &flg);
+  if( flg )
+    Genius::set_optical_cache(optical_cache);
 
   // read card specification file
   Parser::Pattern pt;
@@ -160,69 +188,175 @@ int main(int argc, char ** args)
 #endif
   {
     PetscPrintf(PETSC_COMM_WORLD,"ERROR: I can't read pattern file at %s, access failed.\n", pattern_file.c_str() );
-    PetscFinalize();
+    Genius::clean_processors();
     exit(0);
   }
 
+  // the parsed pattern is cached in binary form beside the xml file,
+  // and rebuilt when the xml file is changed. -pattern_cache without value disables it
+  std::string pattern_cache = pattern_file + ".cache";
+  char pattern_cache_file[1024] = "";
+  PetscOptionsGetString(PETSC_NULL, "-pattern_cache", pattern_cache_file, 1023, &flg);
+  if( flg )
+    pattern_cache = pattern_cache_file;
 
-  if (pt.get_from_XML(pattern_file) )
+  if (pt.get_from_XML(pattern_file, pattern_cache) )
   {
     PetscPrintf(PETSC_COMM_WORLD,"ERROR: I can't parse pattern file 'GeniusSyntax.xml'.\n" );
     genius_error();
   }
 
-  // parse the input file
-  AutoPtr<Parser::InputParser> input = AutoPtr<Parser::InputParser>(new Parser::InputParser(pt));
-  if (input->read_card_file(localfile.c_str()) )
-  {
-    // remove preprocessed file
-    if (Genius::processor_id() == 0)
-      remove(input_file_pp.c_str());
-
-    remove(localfile.c_str());
+  // set material define
+  std::string material_file = Genius::genius_dir() +  "/lib/material.def";
+  Material::init_material_define(material_file);
 
-    PetscPrintf(PETSC_COMM_WORLD,"ERROR: I can't parse input file.\n");
-    PetscFinalize();
+  // keep the simulation system of the deck and run the cards sent by clients
+  char server[1024] = "";
+  PetscOptionsGetString(PETSC_NULL, "-server", server, 1023, &flg);
+  if( flg && decks.size() > 1 )
+  {
+    PetscPrintf(PETSC_COMM_WORLD,"ERROR: server mode serves one deck, it can't be used with ensemble.\n");
+    Genius::clean_processors();
+    exit(0);
+  }
+  if( flg && Genius::n_bias_groups() > 1 )
+  {
+    PetscPrintf(PETSC_COMM_WORLD,"ERROR: server mode can't be used with bias groups.\n");
+    Genius::clean_processors();
     exit(0);
   }
 
-  // remove preprocessed file
-  if (Genius::processor_id() == 0)
-    remove(input_file_pp.c_str());
+  for(unsigned int n=0; n<decks.size(); ++n)
+    solve_deck(decks[n], pt, server);
 
-  // after that, remove local copy of input file
-  remove(localfile.c_str());
+  SolverStats::close();
+  AsyncExec::stop();
+  Genius::clean_processors();
+  return 0;
+}
 
-  // set material define
-  std::string material_file = Genius::genius_dir() +  "/lib/material.def";
-  Material::init_material_define(material_file);
 
-  // do solve process here
-  AutoPtr<SolverControl>  solve_ctrl = AutoPtr<SolverControl>(new SolverControl());
-  solve_ctrl->setDecks(input.get());
+
+/**
+ * solve one input deck on the processors of PETSC_COMM_WORLD,
+ * log and solution file are named after the deck.
+ * with server as [address:]port, the cards sent by clients are run after the deck
+ */
+void solve_deck(const std::string &deck, Parser::Pattern &pt, const std::string &server)
+{
+  // record the start time
+  PetscLogDouble t_start;
+  PetscGetTime(&t_start);
+
+  Genius::set_input_file(deck.c_str());
+
+  // prepare log system. the other bias groups run the same deck, they only keep their own log file
+  std::ofstream logfs;
+  if (Genius::processor_id() == 0)
+  {
+    std::stringstream log_file;
+    log_file << Genius::input_file();
+    if( Genius::bias_group() == 0 )
+      genius_log.addStream("console", std::cerr.rdbuf());
+    else
+      log_file << ".bias" << Genius::bias_group();
+    log_file << ".log";
+    logfs.open(log_file.str().c_str());
+    genius_log.addStream("file", logfs.rdbuf());
+  }
+
+  // test if input file can be opened on processor 0 for read
+  int readable = 1;
+  if ( Genius::processor_id() == 0 )
+  {
+#ifdef CYGWIN
+    if ( _access( Genius::input_file(),  04 ) == -1 )
+#else
+    if ( access( Genius::input_file(),  R_OK ) == -1 )
+#endif
+      readable = 0;
+  }
+  Parallel::broadcast(readable);
+
+  // parse the input file
+  AutoPtr<Parser::InputParser> input;
+  if ( readable )
   {
-    std::stringstream fsol;
-    fsol << Genius::input_file() << ".sol";
-    solve_ctrl->setSolutionFile(fsol.str().c_str());
+    // preprocess include statement of input file
+    std::string input_file_pp;
+    if (Genius::processor_id() == 0)
+    {
+      Parser::FilePreProcess * file_preprocess = new Parser::FilePreProcess(Genius::input_file());
+      input_file_pp = file_preprocess->output();
+      delete file_preprocess;
+    }
+    Parallel::broadcast(input_file_pp);
+
+    {
+      // share input file with other processor, and parse it in place
+      SharedFile input_text(input_file_pp.c_str());
+
+      input = AutoPtr<Parser::InputParser>(new Parser::InputParser(pt));
+      if (input->read_card_buffer(input_text.data(), input_text.size()) )
+      {
+        PetscPrintf(PETSC_COMM_WORLD,"ERROR: I can't parse input file '%s'.\n", Genius::input_file());
+        input.reset();
+      }
+    }
+
+    // remove preprocessed file
+    if (Genius::processor_id() == 0)
+      remove(input_file_pp.c_str());
   }
-  solve_ctrl->mainloop();
+  else
+    PetscPrintf(PETSC_COMM_WORLD,"ERROR: I can't read input file '%s', access failed.\n", Genius::input_file() );
 
-  // record the end time
-  PetscLogDouble t_end;
-  PetscGetTime(&t_end);
-  PetscLogDouble elapsed_time = t_end - t_start;
+  // do solve process here
+  if ( input.get() )
+  {
+    AutoPtr<SolverControl>  solve_ctrl = AutoPtr<SolverControl>(new SolverControl());
+    solve_ctrl->setDecks(input.get());
+    if( Genius::bias_group() == 0 )
+    {
+      std::stringstream fsol;
+      fsol << Genius::input_file() << ".sol";
+      solve_ctrl->setSolutionFile(fsol.str().c_str());
+    }
+    solve_ctrl->mainloop();
 
-  // change to mm:ss format
-  int    min = static_cast<int>(elapsed_time/60);
-  double sec = elapsed_time - min*60;
-  std::stringstream time_ss;
-  time_ss<<"Genius finished. Totol time is "
-  << min <<" min "
-  << std::setiosflags(std::ios::fixed) <<  std::setprecision(3)
-  << sec<<" second."
-  <<" Good bye." << std::endl;
+    if( !server.empty() )
+    {
+      std::string address;
+      std::string port = server;
+      std::string::size_type colon = server.rfind(':');
+      if( colon != std::string::npos )
+      {
+        address = server.substr(0, colon);
+        port = server.substr(colon+1);
+      }
+
+      DeckServer deck_server(*solve_ctrl, *input);
+      if( deck_server.listen(address, atoi(port.c_str())) )
+        deck_server.run();
+    }
 
-  MESSAGE<<time_ss.str(); RECORD();
+    // record the end time
+    PetscLogDouble t_end;
+    PetscGetTime(&t_end);
+    PetscLogDouble elapsed_time = t_end - t_start;
+
+    // change to mm:ss format
+    int    min = static_cast<int>(elapsed_time/60);
+    double sec = elapsed_time - min*60;
+    std::stringstream time_ss;
+    time_ss<<"Genius finished. Totol time is "
+    << min <<" min "
+    << std::setiosflags(std::ios::fixed) <<  std::setprecision(3)
+    << sec<<" second."
+    <<" Good bye." << std::endl;
+
+    MESSAGE<<time_ss.str(); RECORD();
+  }
 
   //finish log system
   if (Genius::processor_id() == 0)
@@ -231,9 +365,6 @@ int main(int argc, char ** args)
     genius_log.removeStream("file");
     logfs.close();
   }
-
-  Genius::clean_processors();
-  return 0;
 }
 
 
@@ -78,29 +78,8 @@ public:
 
   std::complex<PetscScalar> RefractionIndex(PetscScalar lamda, PetscScalar Tl, PetscScalar Eg=0) const
   {
-    std::complex<PetscScalar> n(1.0,0.0);
-    unsigned int table_size = _wave_table.size();
-
-    if( lamda < _wave_table[0].wavelength*um )
-      return std::complex<PetscScalar> (_wave_table[0].RefractionIndexRe, _wave_table[0].RefractionIndexIm);
-
-    if( lamda > _wave_table[table_size-1].wavelength*um )
-      return std::complex<PetscScalar> (_wave_table[table_size-1].RefractionIndexRe, _wave_table[table_size-1].RefractionIndexIm);
-
-    for(unsigned int i=0; i<table_size-1; i++)
-    {
-      // do a linear interpolation
-      if(lamda>=_wave_table[i].wavelength*um && lamda<=_wave_table[i+1].wavelength*um)
-      {
-        std::complex<PetscScalar> n1(_wave_table[i].RefractionIndexRe, _wave_table[i].RefractionIndexIm);
-        std::complex<PetscScalar> n2(_wave_table[i+1].RefractionIndexRe, _wave_table[i+1].RefractionIndexIm);
-        PetscScalar d1 = lamda - _wave_table[i].wavelength*um;
-        PetscScalar d2 = _wave_table[i+1].wavelength*um - lamda;
-        n = (n1*d2 + n2*d1)/(d1+d2);
-        break;
-      }
-    }
-    return n;
+    // the wave table is in um
+    return interpolate_refraction_index(_wave_table, lamda/um, _wave_table_cursor);
   }
 
   // constructions
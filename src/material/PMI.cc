@@ -27,18 +27,66 @@
 #include "point.h"
 #include "fvm_node_data.h"
 
+#include "genius_common.h"
 #include "PMI.h"
 
+#ifdef HAVE_OPENMP
+  #include <omp.h>
+#endif
+
 using namespace adtl;
 
+/**
+ * the index of calling thread, the material keeps one evaluation context for each thread
+ */
+static inline unsigned int pmi_thread_id()
+{
+#ifdef HAVE_OPENMP
+  return static_cast<unsigned int>(omp_get_thread_num());
+#else
+  return 0;
+#endif
+}
+
+
+const Point * PMI_Server::current_point() const
+{
+  if( p_contexts ) return (*p_contexts)[pmi_thread_id()].point;
+  return *pp_point;
+}
+
+
+const FVM_NodeData * PMI_Server::current_node_data() const
+{
+  if( p_contexts ) return (*p_contexts)[pmi_thread_id()].node_data;
+  return *pp_node_data;
+}
+
+
+void PMI_Server::set_current_context(const PMI_Context &context) const
+{
+  const unsigned int tid = pmi_thread_id();
+  if( p_contexts )
+    (*p_contexts)[tid] = context;
+
+  // material plugins may still read the "pointer to pointer" image directly, keep it updated by master thread
+  if( !p_contexts || tid == 0 )
+  {
+    *pp_point = context.point;
+    *pp_node_data = context.node_data;
+  }
+}
+
+
 /**
  * aux function return node coordinate.
  */
 void PMI_Server::ReadCoordinate (PetscScalar& x, PetscScalar& y, PetscScalar& z) const
 {
-  x = (*(*pp_point))(0);
-  y = (*(*pp_point))(1);
-  z = (*(*pp_point))(2);
+  const Point * point = current_point();
+  x = (*point)(0);
+  y = (*point)(1);
+  z = (*point)(2);
 }
 
 /**
@@ -46,6 +94,7 @@ void PMI_Server::ReadCoordinate (PetscScalar& x, PetscScalar& y, PetscScalar& z)
 */
 PetscScalar PMI_Server::ReadTime () const
 {
+  if( p_contexts ) return (*p_contexts)[pmi_thread_id()].time;
   return *p_clock;
 }
 
@@ -75,7 +124,7 @@ unsigned int PMI_Server::VariableIndex(const std::string &v) const
  */
 PetscScalar PMI_Server::ReadRealVariable (const unsigned int v) const
 {
-  return (*pp_node_data)->data<Real>(v);
+  return current_node_data()->data<Real>(v);
 }
 
 
@@ -84,7 +133,7 @@ PetscScalar PMI_Server::ReadRealVariable (const unsigned int v) const
  */
 PetscScalar PMI_Server::ReadRealVariable (const std::string & v) const
 {
-  return (*pp_node_data)->data<Real>(v);
+  return current_node_data()->data<Real>(v);
 }
 
 
@@ -103,6 +152,21 @@ int PMI_Server::calibrate_real_parameter(const std::string & var_name, PetscScal
   return 1;
 }
 
+/**
+ * get numeric parameter value by its name.
+ * @return 0 for success, 1 for variable no find.
+ */
+int PMI_Server::get_real_parameter(const std::string & var_name, PetscScalar & var_value) const
+{
+  std::map<const std::string, PARA>::const_iterator it = parameter_map.find(var_name);
+  if( it != parameter_map.end() && it->second.type==PARA::Real)
+  {
+    var_value = *((PetscScalar*)it->second.value)/(it->second.unit_in_real);
+    return 0;
+  }
+  return 1;
+}
+
 /**
  * set string parameter value by its name.
  * @return 0 for success, 1 for variable no find.
@@ -215,7 +279,7 @@ std::string PMI_Server::get_parameter_string(const int verbosity)
  * also set the physical constants
  */
 PMI_Server::PMI_Server(const PMI_Environment &env)
-  : pp_variables(env.pp_variables), pp_point(env.pp_point), pp_node_data(env.pp_node_data), p_clock(env.p_clock)
+  : pp_variables(env.pp_variables), pp_point(env.pp_point), pp_node_data(env.pp_node_data), p_clock(env.p_clock), p_contexts(env.p_contexts)
 {
 
   m  = env.m;
@@ -254,7 +318,7 @@ PMI_Server::PMI_Server(const PMI_Environment &env)
  */
 PetscScalar PMIS_Server::ReadxMoleFraction () const
 {
-  return (*pp_node_data)->mole_x();
+  return current_node_data()->mole_x();
 }
 
 /**
@@ -262,7 +326,7 @@ PetscScalar PMIS_Server::ReadxMoleFraction () const
  */
 PetscScalar PMIS_Server::ReadxMoleFraction (const PetscScalar mole_xmin, const PetscScalar mole_xmax) const
 {
-  PetscScalar mole_x=(*pp_node_data)->mole_x();
+  PetscScalar mole_x=current_node_data()->mole_x();
   if( mole_x < mole_xmin ) return mole_xmin;
   if( mole_x > mole_xmax ) return mole_xmax;
   return mole_x;
@@ -273,7 +337,7 @@ PetscScalar PMIS_Server::ReadxMoleFraction (const PetscScalar mole_xmin, const P
  */
 PetscScalar PMIS_Server::ReadyMoleFraction () const
 {
-  return (*pp_node_data)->mole_y();
+  return current_node_data()->mole_y();
 }
 
 /**
@@ -281,7 +345,7 @@ PetscScalar PMIS_Server::ReadyMoleFraction () const
  */
 PetscScalar PMIS_Server::ReadyMoleFraction (const PetscScalar mole_ymin, const PetscScalar mole_ymax) const
 {
-  PetscScalar mole_y=(*pp_node_data)->mole_y();
+  PetscScalar mole_y=current_node_data()->mole_y();
   if( mole_y < mole_ymin ) return mole_ymin;
   if( mole_y > mole_ymax ) return mole_ymax;
   return mole_y;
@@ -292,7 +356,7 @@ PetscScalar PMIS_Server::ReadyMoleFraction (const PetscScalar mole_ymin, const P
  */
 PetscScalar PMIS_Server::ReadDopingNa () const
 {
-  return (*pp_node_data)->Total_Na();
+  return current_node_data()->Total_Na();
 }
 
 /**
@@ -300,7 +364,7 @@ PetscScalar PMIS_Server::ReadDopingNa () const
  */
 PetscScalar PMIS_Server::ReadDopingNd () const
 {
-  return (*pp_node_data)->Total_Nd();
+  return current_node_data()->Total_Nd();
 }
 
 
@@ -388,3 +452,147 @@ void PMIC_Optical ::post_calibrate_process()
 
   in.close();
 }
+
+
+
+/*****************************************************************************
+ *               batch evaluation of PMIS, loop over single node version
+ ****************************************************************************/
+
+PetscScalar PMIS_Server::ReadDopingNa (const PMI_Context &context) const
+{
+  return context.node_data->Total_Na();
+}
+
+
+PetscScalar PMIS_Server::ReadDopingNd (const PMI_Context &context) const
+{
+  return context.node_data->Total_Nd();
+}
+
+
+bool PMIS_Server::ReadCachedLifetime (const PetscScalar &Tl, PetscScalar &taun, PetscScalar &taup) const
+{
+  const FVM_NodeData * node_data = current_node_data();
+  if( !node_data || node_data->T_material() != Tl ) return false;
+  taun = node_data->taun();
+  taup = node_data->taup();
+  return true;
+}
+
+
+void PMIS_BandStructure::Eg_batch(unsigned int n_nodes, const PMI_Context *context, const PetscScalar *Tl,
+                                  PetscScalar *Eg, PetscScalar *dEg_dTl)
+{
+  if( !dEg_dTl )
+  {
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      set_current_context(context[i]);
+      Eg[i] = this->Eg(Tl[i]);
+    }
+    return;
+  }
+
+  const unsigned int numdir = AutoDScalar::numdir;
+  AutoDScalar::numdir = 1;
+  for(unsigned int i=0; i<n_nodes; ++i)
+  {
+    set_current_context(context[i]);
+    AutoDScalar T = Tl[i];  T.setADValue(0, 1.0);
+    AutoDScalar r = this->Eg(T);
+    Eg[i]      = r.getValue();
+    dEg_dTl[i] = r.getADValue(0);
+  }
+  AutoDScalar::numdir = numdir;
+}
+
+
+void PMIS_BandStructure::EgNarrow_batch(unsigned int n_nodes, const PMI_Context *context,
+                                        const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl,
+                                        PetscScalar *EgNarrow, PetscScalar *d_dp, PetscScalar *d_dn, PetscScalar *d_dTl)
+{
+  if( !d_dp && !d_dn && !d_dTl )
+  {
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      set_current_context(context[i]);
+      EgNarrow[i] = this->EgNarrow(p[i], n[i], Tl[i]);
+    }
+    return;
+  }
+
+  // derivatives by AD with 3 directions
+  const unsigned int numdir = AutoDScalar::numdir;
+  AutoDScalar::numdir = 3;
+  for(unsigned int i=0; i<n_nodes; ++i)
+  {
+    set_current_context(context[i]);
+    AutoDScalar _p = p[i];   _p.setADValue(0, 1.0);
+    AutoDScalar _n = n[i];   _n.setADValue(1, 1.0);
+    AutoDScalar _T = Tl[i];  _T.setADValue(2, 1.0);
+    AutoDScalar r = this->EgNarrow(_p, _n, _T);
+    EgNarrow[i] = r.getValue();
+    if( d_dp )  d_dp[i]  = r.getADValue(0);
+    if( d_dn )  d_dn[i]  = r.getADValue(1);
+    if( d_dTl ) d_dTl[i] = r.getADValue(2);
+  }
+  AutoDScalar::numdir = numdir;
+}
+
+
+void PMIS_BandStructure::nie_batch(unsigned int n_nodes, const PMI_Context *context,
+                                   const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl,
+                                   PetscScalar *nie, PetscScalar *d_dp, PetscScalar *d_dn, PetscScalar *d_dTl)
+{
+  if( !d_dp && !d_dn && !d_dTl )
+  {
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      set_current_context(context[i]);
+      nie[i] = this->nie(p[i], n[i], Tl[i]);
+    }
+    return;
+  }
+
+  // derivatives by AD with 3 directions
+  const unsigned int numdir = AutoDScalar::numdir;
+  AutoDScalar::numdir = 3;
+  for(unsigned int i=0; i<n_nodes; ++i)
+  {
+    set_current_context(context[i]);
+    AutoDScalar _p = p[i];   _p.setADValue(0, 1.0);
+    AutoDScalar _n = n[i];   _n.setADValue(1, 1.0);
+    AutoDScalar _T = Tl[i];  _T.setADValue(2, 1.0);
+    AutoDScalar r = this->nie(_p, _n, _T);
+    nie[i] = r.getValue();
+    if( d_dp )  d_dp[i]  = r.getADValue(0);
+    if( d_dn )  d_dn[i]  = r.getADValue(1);
+    if( d_dTl ) d_dTl[i] = r.getADValue(2);
+  }
+  AutoDScalar::numdir = numdir;
+}
+
+
+void PMIS_Mobility::ElecMob_batch(unsigned int n_nodes, const PMI_Context *context,
+                                  const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                                  const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tn, PetscScalar *mob) const
+{
+  for(unsigned int i=0; i<n_nodes; ++i)
+  {
+    set_current_context(context[i]);
+    mob[i] = this->ElecMob(p[i], n[i], Tl[i], Ep[i], Et[i], Tn[i]);
+  }
+}
+
+
+void PMIS_Mobility::HoleMob_batch(unsigned int n_nodes, const PMI_Context *context,
+                                  const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                                  const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tp, PetscScalar *mob) const
+{
+  for(unsigned int i=0; i<n_nodes; ++i)
+  {
+    set_current_context(context[i]);
+    mob[i] = this->HoleMob(p[i], n[i], Tl[i], Ep[i], Et[i], Tp[i]);
+  }
+}
@@ -190,6 +190,63 @@ public:
     return sqrt(Nc*Nv)*exp(-bandgap/(2*kb*Tl))*exp(EgNarrow(p, n, Tl));
   }
 
+  //---------------------------------------------------------------------------
+  // batch version, closed form derivatives and no virtual call in the loop
+  void Eg_batch(unsigned int n_nodes, const PMI_Context *context, const PetscScalar *Tl,
+                PetscScalar *Eg, PetscScalar *dEg_dTl)
+  {
+    const PetscScalar Eg300 = EG300+EGALPH*T300*T300/(T300+EGBETA);
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      const PetscScalar T = Tl[i];
+      Eg[i] = Eg300 - EGALPH*T*T/(T+EGBETA);
+      if( dEg_dTl ) dEg_dTl[i] = -EGALPH*T*(T+2*EGBETA)/((T+EGBETA)*(T+EGBETA));
+    }
+  }
+
+  // Slotboom's narrowing only depends on doping
+  void EgNarrow_batch(unsigned int n_nodes, const PMI_Context *context,
+                      const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl,
+                      PetscScalar *EgNarrow, PetscScalar *d_dp, PetscScalar *d_dn, PetscScalar *d_dTl)
+  {
+    const PetscScalar N_min = 1.0*std::pow(cm,-3);
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      const PetscScalar N = ReadDopingNa(context[i]) + ReadDopingNd(context[i]) + N_min;
+      const PetscScalar x = log(N/N0_BGN);
+      EgNarrow[i] = V0_BGN*(x+sqrt(x*x+CON_BGN));
+      if( d_dp )  d_dp[i]  = 0.0;
+      if( d_dn )  d_dn[i]  = 0.0;
+      if( d_dTl ) d_dTl[i] = 0.0;
+    }
+  }
+
+  void nie_batch(unsigned int n_nodes, const PMI_Context *context,
+                 const PetscScalar *p, const PetscScalar *n, const PetscScalar *Tl,
+                 PetscScalar *nie, PetscScalar *d_dp, PetscScalar *d_dn, PetscScalar *d_dTl)
+  {
+    const PetscScalar N_min   = 1.0*std::pow(cm,-3);
+    const PetscScalar NcNv300 = sqrt(NC300*NV300);
+    const PetscScalar DOS_F   = 0.5*(NC_F+NV_F);
+    const PetscScalar Eg300   = EG300+EGALPH*T300*T300/(T300+EGBETA);
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      const PetscScalar T  = Tl[i];
+      const PetscScalar bandgap = Eg300 - EGALPH*T*T/(T+EGBETA);
+      const PetscScalar N  = ReadDopingNa(context[i]) + ReadDopingNd(context[i]) + N_min;
+      const PetscScalar x  = log(N/N0_BGN);
+      const PetscScalar en = V0_BGN*(x+sqrt(x*x+CON_BGN));
+      nie[i] = NcNv300*std::pow(T/T300,DOS_F)*exp(-bandgap/(2*kb*T))*exp(en);
+      if( d_dp )  d_dp[i] = 0.0;
+      if( d_dn )  d_dn[i] = 0.0;
+      if( d_dTl )
+      {
+        const PetscScalar dEg = -EGALPH*T*(T+2*EGBETA)/((T+EGBETA)*(T+EGBETA));
+        d_dTl[i] = nie[i]*(DOS_F/T - dEg/(2*kb*T) + bandgap/(2*kb*T*T));
+      }
+    }
+  }
+
   //end of Bandgap
 public:
   //
@@ -579,6 +636,29 @@ public:
     PetscScalar Nd = ReadDopingNd();
     return TAUP0/(1+(Na+Nd)/NSRHP)*adtl::pow(Tl/T300,EXP_TAU);
   }
+
+  //---------------------------------------------------------------------------
+  // SRH lifetimes, read from the node cache when it is evaluated at Tl
+  void SRH_Lifetime (const PetscScalar &Tl, PetscScalar &taun, PetscScalar &taup)
+  {
+    if( ReadCachedLifetime(Tl, taun, taup) ) return;
+    taun = TAUN(Tl);
+    taup = TAUP(Tl);
+  }
+  void SRH_Lifetime (const AutoDScalar &Tl, AutoDScalar &taun, AutoDScalar &taup)
+  {
+    PetscScalar taun0, taup0;
+    if( ReadCachedLifetime(Tl.getValue(), taun0, taup0) )
+    {
+      // first order expansion of (Tl/T300)^EX_TAU at the cached temperature, exact in value and derivative
+      AutoDScalar dT = (Tl - Tl.getValue())/Tl.getValue();
+      taun = taun0*(1.0 + EXN_TAU*dT);
+      taup = taup0*(1.0 + EXP_TAU*dT);
+      return;
+    }
+    taun = TAUN(Tl);
+    taup = TAUP(Tl);
+  }
   // End of Lifetime
 
   //[the fit parameter for density-gradient solver]
@@ -681,15 +761,15 @@ public:
   PetscScalar R_SHR     (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
     PetscScalar ni =   nie(p, n, Tl);
-    PetscScalar taun = TAUN(Tl);
-    PetscScalar taup = TAUP(Tl);
+    PetscScalar taun, taup;
+    SRH_Lifetime(Tl, taun, taup);
     return (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
   }
   AutoDScalar R_SHR     (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
     AutoDScalar ni =   nie(p, n, Tl);
-    AutoDScalar taun = TAUN(Tl);
-    AutoDScalar taup = TAUP(Tl);
+    AutoDScalar taun, taup;
+    SRH_Lifetime(Tl, taun, taup);
     return (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
   }
 
@@ -721,8 +801,8 @@ public:
   PetscScalar Recomb (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
     PetscScalar ni =   nie(p, n, Tl);
-    PetscScalar taun = TAUN(Tl);
-    PetscScalar taup = TAUP(Tl);
+    PetscScalar taun, taup;
+    SRH_Lifetime(Tl, taun, taup);
     PetscScalar dn   = p*n-ni*ni;
     PetscScalar Rshr = dn/(taup*(n+ni)+taun*(p+ni));
     PetscScalar Rdir = C_DIRECT*dn;
@@ -732,8 +812,8 @@ public:
   AutoDScalar Recomb (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
     AutoDScalar ni =   nie(p, n, Tl);
-    AutoDScalar taun = TAUN(Tl);
-    AutoDScalar taup = TAUP(Tl);
+    AutoDScalar taun, taup;
+    SRH_Lifetime(Tl, taun, taup);
     AutoDScalar dn   = p*n-ni*ni;
     AutoDScalar Rshr = dn/(taup*(n+ni)+taun*(p+ni));
     AutoDScalar Rdir = C_DIRECT*dn;
@@ -23,6 +23,7 @@
 #include <algorithm>
 
 #include "PMI.h"
+#include "pmi_table.h"
 #include "mathfunc.h"
 
 class GSS_Si_BandStructure_Schenk : public PMIS_BandStructure
@@ -77,6 +78,27 @@ private:
 
   PetscScalar n_scale;
 
+  // tabulation of the exchange-correlation BGN over (log neS, log nhS, F)
+  bool        bgn_table;      // use the tables
+  PetscScalar bgn_table_tol;  // relative error bound of the tables
+  PMI_Table   bgn_xc_e_table;
+  PMI_Table   bgn_xc_h_table;
+
+  // the exchange-correlation BGN in unit of Ryex, evaluated for tabulation
+  class BGN_XC_Function : public PMI_TableFunction
+  {
+  public:
+    BGN_XC_Function(const GSS_Si_BandStructure_Schenk *model, bool electron) : _model(model), _electron(electron) {}
+    PetscScalar operator() (const PetscScalar *x) const
+    {
+      return _electron ? _model->BGN_xc_e(exp(x[0]), exp(x[1]), x[2]) : _model->BGN_xc_h(exp(x[0]), exp(x[1]), x[2]);
+    }
+  private:
+    const GSS_Si_BandStructure_Schenk *_model;
+    bool _electron;
+  };
+  friend class BGN_XC_Function;
+
   // Init value
   void Eg_Init()
   {
@@ -127,6 +149,9 @@ private:
 
     n_scale = std::pow(aex, -3.0);
 
+    bgn_table = false;
+    bgn_table_tol = 1e-4;
+
 #ifdef __CALIBRATE__
     parameter_map.insert(para_item("EG0",    PARA("EG0",    "The energy bandgap of the material at 0 K", "eV", eV, &EG0)) );
     parameter_map.insert(para_item("EG300",  PARA("EG300",  "The energy bandgap of the material at 300 K", "eV", eV, &EG300)) );
@@ -172,6 +197,84 @@ private:
   {
     alphae = mh_eff / (me_eff+mh_eff);
     alphah = me_eff / (me_eff+mh_eff);
+    BGN_Table_Build();
+  }
+
+  // read the tabulation options, bool<bgn.table> and real<bgn.table.tol>
+  void BGN_Table_Setup(std::vector<Parser::Parameter> & pmi_parameters)
+  {
+    for(std::vector<Parser::Parameter>::iterator it = pmi_parameters.begin(); it != pmi_parameters.end();)
+    {
+      if( it->type() == Parser::BOOL && it->name() == "bgn.table" )
+      { bgn_table = it->get_bool(); it = pmi_parameters.erase(it); }
+      else if( it->type() == Parser::REAL && it->name() == "bgn.table.tol" )
+      { bgn_table_tol = it->get_real(); it = pmi_parameters.erase(it); }
+      else
+        ++it;
+    }
+  }
+
+  // tabulate the exchange-correlation BGN with the calibrated parameters.
+  // carrier density from 1e8 to 1e22 cm^-3, lattice temperature from 150K to 800K,
+  // the point outside the table is evaluated directly
+  void BGN_Table_Build()
+  {
+    bgn_xc_e_table.clear();
+    bgn_xc_h_table.clear();
+    if( !bgn_table ) return;
+
+    const PetscScalar lo[3] = { log(1e8*std::pow(cm,-3)/n_scale),  log(1e8*std::pow(cm,-3)/n_scale),  kb*150.0*K/Ryex };
+    const PetscScalar hi[3] = { log(1e22*std::pow(cm,-3)/n_scale), log(1e22*std::pow(cm,-3)/n_scale), kb*800.0*K/Ryex };
+
+    bgn_xc_e_table.build(BGN_XC_Function(this, true),  3, lo, hi, bgn_table_tol);
+    bgn_xc_h_table.build(BGN_XC_Function(this, false), 3, lo, hi, bgn_table_tol);
+  }
+
+  // exchange-correlation BGN of electron in unit of Ryex, neS, nhS are scaled densities and F = kT/Ryex
+  PetscScalar BGN_xc_e(const PetscScalar &neS, const PetscScalar &nhS, const PetscScalar &F) const
+  {
+    const PetscScalar pi = 3.1415927;
+    PetscScalar nsigma = neS + nhS;
+    PetscScalar np = alphae * neS + alphah * nhS;
+    return -( pow(4.0 * pi, 3.0) * nsigma*nsigma * ( pow(48.0 * neS / pi / ge, 1.0/3.0) + ce * log(1.0 + de * pow(np, pe))  )
+              +(8.0 * pi * alphae/ge)* neS * F*F
+              +sqrt(8.0 *pi*nsigma) * pow(F, 5.0 / 2.0)
+            ) / (pow(4.0*pi, 3.0) * nsigma*nsigma + pow(F, 3.0) + be * sqrt(nsigma) * F*F + 40.0 * pow(nsigma, 3.0/2.0) * F);
+  }
+
+  // exchange-correlation BGN of hole in unit of Ryex
+  PetscScalar BGN_xc_h(const PetscScalar &neS, const PetscScalar &nhS, const PetscScalar &F) const
+  {
+    const PetscScalar pi = 3.1415927;
+    PetscScalar nsigma = neS + nhS;
+    PetscScalar np = alphae * neS + alphah * nhS;
+    return -( pow(4.0 * pi, 3.0) * nsigma*nsigma * ( pow(48.0 * nhS / pi / gh, 1.0/3.0) + ch * log(1.0 + dh * pow(np, ph))  )
+              +(8.0 * pi * alphah/gh)* nhS * F*F
+              +sqrt(8.0 *pi*nsigma) * pow(F, 5.0 / 2.0)
+            ) / (pow(4.0*pi, 3.0) * nsigma*nsigma + pow(F,3.0) + bh * sqrt(nsigma) * F*F + 40.0 * pow(nsigma, 3.0/2.0) * F);
+  }
+
+  // look up the tabulated BGN, return false when the table is not used or the point is outside
+  bool BGN_Table_Lookup(const PMI_Table &table, const PetscScalar &neS, const PetscScalar &nhS, const PetscScalar &F, PetscScalar &xc) const
+  {
+    if( !table.valid() ) return false;
+    const PetscScalar x[3] = { log(neS), log(nhS), F };
+    if( !table.contains(x) ) return false;
+    xc = table.eval(x);
+    return true;
+  }
+
+  bool BGN_Table_Lookup(const PMI_Table &table, const AutoDScalar &neS, const AutoDScalar &nhS, const AutoDScalar &F, AutoDScalar &xc) const
+  {
+    if( !table.valid() ) return false;
+    const PetscScalar x[3] = { log(neS.getValue()), log(nhS.getValue()), F.getValue() };
+    if( !table.contains(x) ) return false;
+    PetscScalar df[3];
+    xc = table.eval(x, df);
+    // chain rule through the log density variables
+    for(unsigned int i=0; i<AutoDScalar::ndir(); ++i)
+      xc.setADValue(i, df[0]*neS.getADValue(i)/neS.getValue() + df[1]*nhS.getADValue(i)/nhS.getValue() + df[2]*F.getADValue(i));
+    return true;
   }
 
 public:
@@ -212,7 +315,6 @@ public:
     PetscScalar F = kb * Tl / Ryex;    // [adim]
 
     PetscScalar nsigma = neS + nhS;
-    PetscScalar np = alphae * neS + alphah * nhS;
 
     PetscScalar nsigma2 = ndS + naS;                // For SCR:  nsigma = niS
     PetscScalar np2 = alphae * ndS + alphah * naS;  // For SCR: np = alphae * NDOP + alphah * PDOP
@@ -220,10 +322,9 @@ public:
     PetscScalar Ui = nsigma * nsigma / pow(F,3.0);
 
     // BGN due to exchange-correlation (carrier-carrier)
-    PetscScalar De_xc = -( pow(4.0 * pi, 3.0) * nsigma*nsigma * ( pow(48.0 * neS / pi / ge, 1.0/3.0) + ce * log(1.0 + de * pow(np, pe))  )
-                           +(8.0 * pi * alphae/ge)* neS * F*F
-                           +sqrt(8.0 *pi*nsigma) * pow(F, 5.0 / 2.0)
-                         ) / (pow(4.0*pi, 3.0) * nsigma*nsigma + pow(F, 3.0) + be * sqrt(nsigma) * F*F + 40.0 * pow(nsigma, 3.0/2.0) * F);
+    PetscScalar De_xc;
+    if( !BGN_Table_Lookup(bgn_xc_e_table, neS, nhS, F, De_xc) )
+      De_xc = BGN_xc_e(neS, nhS, F);
 
     PetscScalar De_i = -( niS * (1.0 + Ui))
                        /( sqrt(F * nsigma2 / (2.0 * pi)) * (1.0 + he * log(1.0 + sqrt(nsigma2) / F) )
@@ -249,17 +350,15 @@ public:
     PetscScalar F = kb * Tl / Ryex;    // [adim]
 
     PetscScalar nsigma = neS + nhS;
-    PetscScalar np = alphae * neS + alphah * nhS;
 
     PetscScalar nsigma2 = ndS + naS;                // For SCR:  nsigma = niS
     PetscScalar np2 = alphae * ndS + alphah * naS;  // For SCR: np = alphae * NDOP + alphah * PDOP
 
     PetscScalar Ui = nsigma * nsigma / pow(F,3.0);
 
-    PetscScalar Dh_xc = -( pow(4.0 * pi, 3.0) * nsigma*nsigma * ( pow(48.0 * nhS / pi / gh, 1.0/3.0) + ch * log(1.0 + dh * pow(np, ph))  )
-                           +(8.0 * pi * alphah/gh)* nhS * F*F
-                           +sqrt(8.0 *pi*nsigma) * pow(F, 5.0 / 2.0)
-                         ) / (pow(4.0*pi, 3.0) * nsigma*nsigma + pow(F,3.0) + bh * sqrt(nsigma) * F*F + 40.0 * pow(nsigma, 3.0/2.0) * F);
+    PetscScalar Dh_xc;
+    if( !BGN_Table_Lookup(bgn_xc_h_table, neS, nhS, F, Dh_xc) )
+      Dh_xc = BGN_xc_h(neS, nhS, F);
     PetscScalar Dh_i = -( niS * (1.0 + Ui))
                        /( sqrt(F * nsigma2 / (2.0 * pi)) * (1.0 + hh * log(1.0 + sqrt(nsigma2) / F) )
                           +jh * Ui * pow(np2, 3.0/4.0) * (1.0 + kh * pow(np2, qh))
@@ -296,10 +395,12 @@ public:
     AutoDScalar Ui = nsigma * nsigma / pow(F,3.0);
 
     // BGN due to exchange-correlation (carrier-carrier)
-    AutoDScalar De_xc = -( pow(4.0 * pi, 3.0) * nsigma*nsigma * ( pow(48.0 * neS / pi / ge, 1.0/3.0) + ce * log(1.0 + de * pow(np, pe))  )
-                           +(8.0 * pi * alphae/ge)* neS * F*F
-                           +sqrt(8.0 *pi*nsigma) * pow(F, 5.0 / 2.0)
-                         ) / (pow(4.0*pi, 3.0) * nsigma*nsigma + pow(F, 3.0) + be * sqrt(nsigma) * F*F + 40.0 * pow(nsigma, 3.0/2.0) * F);
+    AutoDScalar De_xc;
+    if( !BGN_Table_Lookup(bgn_xc_e_table, neS, nhS, F, De_xc) )
+      De_xc = -( pow(4.0 * pi, 3.0) * nsigma*nsigma * ( pow(48.0 * neS / pi / ge, 1.0/3.0) + ce * log(1.0 + de * pow(np, pe))  )
+                 +(8.0 * pi * alphae/ge)* neS * F*F
+                 +sqrt(8.0 *pi*nsigma) * pow(F, 5.0 / 2.0)
+               ) / (pow(4.0*pi, 3.0) * nsigma*nsigma + pow(F, 3.0) + be * sqrt(nsigma) * F*F + 40.0 * pow(nsigma, 3.0/2.0) * F);
 
     AutoDScalar De_i = -( niS * (1.0 + Ui))
                        /( sqrt(F * nsigma2 / (2.0 * pi)) * (1.0 + he * log(1.0 + sqrt(nsigma2) / F) )
@@ -329,10 +430,12 @@ public:
 
     AutoDScalar Ui = nsigma * nsigma / pow(F,3.0);
 
-    AutoDScalar Dh_xc = -( pow(4.0 * pi, 3.0) * nsigma*nsigma * ( pow(48.0 * nhS / pi / gh, 1.0/3.0) + ch * log(1.0 + dh * pow(np, ph))  )
-                           +(8.0 * pi * alphah/gh)* nhS * F*F
-                           +sqrt(8.0 *pi*nsigma) * pow(F, 5.0 / 2.0)
-                         ) / (pow(4.0*pi, 3.0) * nsigma*nsigma + pow(F,3.0) + bh * sqrt(nsigma) * F*F + 40.0 * pow(nsigma, 3.0/2.0) * F);
+    AutoDScalar Dh_xc;
+    if( !BGN_Table_Lookup(bgn_xc_h_table, neS, nhS, F, Dh_xc) )
+      Dh_xc = -( pow(4.0 * pi, 3.0) * nsigma*nsigma * ( pow(48.0 * nhS / pi / gh, 1.0/3.0) + ch * log(1.0 + dh * pow(np, ph))  )
+                 +(8.0 * pi * alphah/gh)* nhS * F*F
+                 +sqrt(8.0 *pi*nsigma) * pow(F, 5.0 / 2.0)
+               ) / (pow(4.0*pi, 3.0) * nsigma*nsigma + pow(F,3.0) + bh * sqrt(nsigma) * F*F + 40.0 * pow(nsigma, 3.0/2.0) * F);
     AutoDScalar Dh_i = -( niS * (1.0 + Ui))
                        /( sqrt(F * nsigma2 / (2.0 * pi)) * (1.0 + hh * log(1.0 + sqrt(nsigma2) / F) )
                           +jh * Ui * pow(np2, 3.0/4.0) * (1.0 + kh * pow(np2, qh))
@@ -792,6 +895,29 @@ public:
     PetscScalar Nd = ReadDopingNd();
     return TAUP0/(1+(Na+Nd)/NSRHP)*adtl::pow(Tl/T300,EXP_TAU);
   }
+
+  //---------------------------------------------------------------------------
+  // SRH lifetimes, read from the node cache when it is evaluated at Tl
+  void SRH_Lifetime (const PetscScalar &Tl, PetscScalar &taun, PetscScalar &taup)
+  {
+    if( ReadCachedLifetime(Tl, taun, taup) ) return;
+    taun = TAUN(Tl);
+    taup = TAUP(Tl);
+  }
+  void SRH_Lifetime (const AutoDScalar &Tl, AutoDScalar &taun, AutoDScalar &taup)
+  {
+    PetscScalar taun0, taup0;
+    if( ReadCachedLifetime(Tl.getValue(), taun0, taup0) )
+    {
+      // first order expansion of (Tl/T300)^EX_TAU at the cached temperature, exact in value and derivative
+      AutoDScalar dT = (Tl - Tl.getValue())/Tl.getValue();
+      taun = taun0*(1.0 + EXN_TAU*dT);
+      taup = taup0*(1.0 + EXP_TAU*dT);
+      return;
+    }
+    taun = TAUN(Tl);
+    taup = TAUP(Tl);
+  }
   // End of Lifetime
 
   //[the fit parameter for density-gradient solver]
@@ -894,15 +1020,15 @@ public:
   PetscScalar R_SHR     (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
     PetscScalar ni =   nie(p, n, Tl);
-    PetscScalar taun = TAUN(Tl);
-    PetscScalar taup = TAUP(Tl);
+    PetscScalar taun, taup;
+    SRH_Lifetime(Tl, taun, taup);
     return (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
   }
   AutoDScalar R_SHR     (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
     AutoDScalar ni =   nie(p, n, Tl);
-    AutoDScalar taun = TAUN(Tl);
-    AutoDScalar taup = TAUP(Tl);
+    AutoDScalar taun, taup;
+    SRH_Lifetime(Tl, taun, taup);
     return (p*n-ni*ni)/(taup*(n+ni)+taun*(p+ni));
   }
 
@@ -934,8 +1060,8 @@ public:
   PetscScalar Recomb (const PetscScalar &p, const PetscScalar &n, const PetscScalar &Tl)
   {
     PetscScalar ni =   nie(p, n, Tl);
-    PetscScalar taun = TAUN(Tl);
-    PetscScalar taup = TAUP(Tl);
+    PetscScalar taun, taup;
+    SRH_Lifetime(Tl, taun, taup);
     PetscScalar dn   = p*n-ni*ni;
     PetscScalar Rshr = dn/(taup*(n+ni)+taun*(p+ni));
     PetscScalar Rdir = C_DIRECT*dn;
@@ -945,8 +1071,8 @@ public:
   AutoDScalar Recomb (const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &Tl)
   {
     AutoDScalar ni =   nie(p, n, Tl);
-    AutoDScalar taun = TAUN(Tl);
-    AutoDScalar taup = TAUP(Tl);
+    AutoDScalar taun, taup;
+    SRH_Lifetime(Tl, taun, taup);
     AutoDScalar dn   = p*n-ni*ni;
     AutoDScalar Rshr = dn/(taup*(n+ni)+taun*(p+ni));
     AutoDScalar Rdir = C_DIRECT*dn;
@@ -1302,6 +1428,7 @@ public:
   int calibrate(std::vector<Parser::Parameter> & pmi_parameters)
   {
     IncompleteIonization_Setup(pmi_parameters);
+    BGN_Table_Setup(pmi_parameters);
     return  PMIS_BandStructure::calibrate(pmi_parameters);
   }
 
@@ -43,6 +43,23 @@ private:
   PetscScalar HoleTauw;
   PetscScalar T300    ;
 
+  // the lattice temperature dependent prefactor and energy free path of the last call.
+  // they are shared by all the edges of a device at uniform temperature
+  mutable PetscScalar cache_Tl;
+  mutable PetscScalar cache_alpha_n, cache_L_n;
+  mutable PetscScalar cache_alpha_p, cache_L_p;
+
+  void update_coefficient(const PetscScalar &Tl) const
+  {
+    if( Tl == cache_Tl ) return;
+    const PetscScalar th = tanh(OP_PH_EN/(2*kb*Tl));
+    cache_alpha_n = N_IONIZA + N_ION_1*Tl + N_ION_2*Tl*Tl;
+    cache_L_n     = LAN300*th;
+    cache_alpha_p = P_IONIZA + P_ION_1*Tl + P_ION_2*Tl*Tl;
+    cache_L_p     = LAP300*th;
+    cache_Tl      = Tl;
+  }
+
   void 	Avalanche_Init()
   {
     N_IONIZA  =  7.030000e+05/cm;
@@ -60,6 +77,7 @@ private:
     ElecTauw  = 6.800000E-13*s;
     HoleTauw  = 2.000000E-13*s;
     T300      = 300.0*K;
+    cache_Tl  = -1.0;
 
 #ifdef __CALIBRATE__
     parameter_map.insert(para_item("N.IONIZA",    PARA("N.IONIZA",    "The constant term in the multiplicative prefactor of the electron ionization coefficient", "/cm", 1.0/cm, &N_IONIZA)) );
@@ -88,10 +106,9 @@ public:
     }
     else
     {
-      PetscScalar alpha = N_IONIZA + N_ION_1*Tl + N_ION_2*Tl*Tl;
-      PetscScalar L = LAN300*tanh(OP_PH_EN/(2*kb*Tl));
-      PetscScalar Ecrit = Eg/(e*L);
-      return alpha*exp(-std::pow(Ecrit/Ep,EXN_II));
+      update_coefficient(Tl);
+      PetscScalar Ecrit = Eg/(e*cache_L_n);
+      return cache_alpha_n*exp(-std::pow(Ecrit/Ep,EXN_II));
     }
   }
   AutoDScalar ElecGenRate (const AutoDScalar &Tl,const AutoDScalar &Ep,const AutoDScalar &Eg) const
@@ -119,10 +136,9 @@ public:
     }
     else
     {
-      PetscScalar alpha = P_IONIZA+P_ION_1*Tl+P_ION_2*Tl*Tl;
-      PetscScalar L = LAP300*tanh(OP_PH_EN/(2*kb*Tl));
-      PetscScalar Ecrit = Eg/(e*L);
-      return alpha*exp(-std::pow(Ecrit/Ep,EXP_II));
+      update_coefficient(Tl);
+      PetscScalar Ecrit = Eg/(e*cache_L_p);
+      return cache_alpha_p*exp(-std::pow(Ecrit/Ep,EXP_II));
     }
   }
   AutoDScalar HoleGenRate (const AutoDScalar &Tl,const AutoDScalar &Ep,const AutoDScalar &Eg) const
@@ -208,6 +224,10 @@ public:
     }
   }
 
+  // the cached coefficients depend on the parameters
+  void post_calibrate_process()
+  { cache_Tl = -1.0; }
+
 //----------------------------------------------------------------
 // constructor and destructor
 public:
@@ -53,10 +53,31 @@ private:
 
   PetscScalar ElecTauw;
   PetscScalar HoleTauw;
+
+  // the lattice temperature dependent coefficients of the last call.
+  // they are shared by all the edges of a device at uniform temperature
+  mutable PetscScalar cache_Tl;
+  mutable PetscScalar cache_an, cache_bn, cache_cn, cache_dn;
+  mutable PetscScalar cache_ap, cache_bp, cache_cp, cache_dp;
+
+  void update_coefficient(const PetscScalar &Tl) const
+  {
+    if( Tl == cache_Tl ) return;
+    cache_an = A0N_VALD + A1N_VALD*std::pow(Tl,A2N_VALD);
+    cache_bn = B0N_VALD*exp(B1N_VALD*Tl);
+    cache_cn = C0N_VALD + C1N_VALD*std::pow(Tl,C2N_VALD) + C3N_VALD*Tl*Tl;
+    cache_dn = D0N_VALD + D1N_VALD*Tl + D2N_VALD*Tl*Tl;
+    cache_ap = A0P_VALD + A1P_VALD*std::pow(Tl,A2P_VALD);
+    cache_bp = B0P_VALD*exp(B1P_VALD*Tl);
+    cache_cp = C0P_VALD + C1P_VALD*std::pow(Tl,C2P_VALD) + C3P_VALD*Tl*Tl;
+    cache_dp = D0P_VALD + D1P_VALD*Tl + D2P_VALD*Tl*Tl;
+    cache_Tl = Tl;
+  }
   PetscScalar T300    ;
 
   void 	Avalanche_Init()
   {
+    cache_Tl = -1.0;
     A0N_VALD = 4.338300E+00*V;
     A0P_VALD = 2.376000E+00*V;
     A2N_VALD = 4.123300E+00;
@@ -126,11 +147,8 @@ public:
     }
     else
     {
-      PetscScalar a = A0N_VALD + A1N_VALD*std::pow(Tl,A2N_VALD);
-      PetscScalar b = B0N_VALD*exp(B1N_VALD*Tl);
-      PetscScalar c = C0N_VALD + C1N_VALD*std::pow(Tl,C2N_VALD) + C3N_VALD*Tl*Tl;
-      PetscScalar d = D0N_VALD + D1N_VALD*Tl + D2N_VALD*Tl*Tl;
-      return Ep/(a+b*exp(d/(Ep+c)));
+      update_coefficient(Tl);
+      return Ep/(cache_an+cache_bn*exp(cache_dn/(Ep+cache_cn)));
     }
   }
   AutoDScalar ElecGenRate (const AutoDScalar &Tl,const AutoDScalar &Ep,const AutoDScalar &Eg) const
@@ -159,11 +177,8 @@ public:
     }
     else
     {
-      PetscScalar a = A0P_VALD + A1P_VALD*std::pow(Tl,A2P_VALD);
-      PetscScalar b = B0P_VALD*exp(B1P_VALD*Tl);
-      PetscScalar c = C0P_VALD + C1P_VALD*std::pow(Tl,C2P_VALD) + C3P_VALD*Tl*Tl;
-      PetscScalar d = D0P_VALD + D1P_VALD*Tl + D2P_VALD*Tl*Tl;
-      return Ep/(a+b*exp(d/(Ep+c)));
+      update_coefficient(Tl);
+      return Ep/(cache_ap+cache_bp*exp(cache_dp/(Ep+cache_cp)));
     }
   }
   AutoDScalar HoleGenRate (const AutoDScalar &Tl,const AutoDScalar &Ep,const AutoDScalar &Eg) const
@@ -229,6 +244,10 @@ public:
   }
 
 
+  // the cached coefficients depend on the parameters
+  void post_calibrate_process()
+  { cache_Tl = -1.0; }
+
   //----------------------------------------------------------------
   GSS_Si_Avalanche_Valdinoci(const PMIS_Environment &env):PMIS_Avalanche(env)
   {
@@ -292,6 +292,70 @@ public:
     return mu0/adtl::pow(1+adtl::pow(mu0*fabs(Ep)/vsat,BETAP),1.0/BETAP);
   }
 
+  //---------------------------------------------------------------------------
+  // batch version, the temperature dependent terms are only evaluated when the temperature changes
+  void ElecMob_batch(unsigned int n_nodes, const PMI_Context *context,
+                     const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                     const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tn, PetscScalar *mob) const
+  {
+    const PetscScalar N_min = 1e0*std::pow(cm,-3);
+    const PetscScalar E_min = 1.0*V/cm;
+    PetscScalar T_last = -1.0;
+    PetscScalar mu_max=0, vsat=0;
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      // temperature dependent terms
+      if( Tl[i] != T_last )
+      {
+        T_last = Tl[i];
+        mu_max = MUN2_LSM*std::pow(Tl[i]/T300,-EXN3_LSM);
+        vsat   = VSATN0/(1+VSATN_A*exp(Tl[i]/(2*T300)));
+      }
+
+      const PetscScalar N_total = ReadDopingNa(context[i])+ReadDopingNd(context[i])+N_min;
+      const PetscScalar mu_low  = MUN0_LSM+(mu_max-MUN0_LSM)/(1+std::pow(N_total/CRN_LSM,EXN1_LSM))-MUN1_LSM/(1+std::pow(CSN_LSM/N_total,EXN2_LSM));
+
+      const PetscScalar ET    = Et[i]+E_min;
+      const PetscScalar mu_ac = BN_LSM/ET + CN_LSM*std::pow(N_total,EXN4_LSM)/Tl[i]*std::pow(ET,PetscScalar(-1.0/3.0));
+      const PetscScalar mu_sr = DN_LSM*std::pow(ET,-EXN8_LSM);
+      const PetscScalar mu_surf = 1.0/(1.0/mu_ac+1.0/mu_sr);
+
+      const PetscScalar mu0 = 1.0/(1.0/mu_low+1.0/mu_surf);
+      mob[i] = mu0/std::pow(1+std::pow(mu0*fabs(Ep[i])/vsat,BETAN),1.0/BETAN);
+    }
+  }
+
+  void HoleMob_batch(unsigned int n_nodes, const PMI_Context *context,
+                     const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                     const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tp, PetscScalar *mob) const
+  {
+    const PetscScalar N_min = 1e0*std::pow(cm,-3);
+    const PetscScalar E_min = 1.0*V/cm;
+    PetscScalar T_last = -1.0;
+    PetscScalar mu_max=0, vsat=0;
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      // temperature dependent terms
+      if( Tl[i] != T_last )
+      {
+        T_last = Tl[i];
+        mu_max = MUP2_LSM*std::pow(Tl[i]/T300,-EXP3_LSM);
+        vsat   = VSATP0/(1+VSATP_A*exp(Tl[i]/(2*T300)));
+      }
+
+      const PetscScalar N_total = ReadDopingNa(context[i])+ReadDopingNd(context[i])+N_min;
+      const PetscScalar mu_low  = MUP0_LSM*exp(-PC_LSM/N_total)+mu_max/(1+std::pow(N_total/CRP_LSM,EXP1_LSM))-MUP1_LSM/(1+std::pow(CSP_LSM/N_total,EXP2_LSM));
+
+      const PetscScalar ET    = Et[i]+E_min;
+      const PetscScalar mu_ac = BP_LSM/ET + CP_LSM*std::pow(N_total,EXP4_LSM)/Tl[i]*std::pow(ET,PetscScalar(-1.0/3.0));
+      const PetscScalar mu_sr = DP_LSM*std::pow(ET,-EXP8_LSM);
+      const PetscScalar mu_surf = 1.0/(1.0/mu_ac+1.0/mu_sr);
+
+      const PetscScalar mu0 = 1.0/(1.0/mu_low+1.0/mu_surf);
+      mob[i] = mu0/std::pow(1+std::pow(mu0*fabs(Ep[i])/vsat,BETAP),1.0/BETAP);
+    }
+  }
+
   // constructor
 public:
   GSS_Si_Mob_Lombardi(const PMIS_Environment &env):PMIS_Mobility(env)
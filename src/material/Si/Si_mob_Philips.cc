@@ -247,6 +247,86 @@ public:
     return mu0/adtl::pow(1+adtl::pow(mu0*fabs(Ep)/vsat,BETAP),1.0/BETAP);
   }
 
+  //---------------------------------------------------------------------------
+  // batch version, the temperature dependent terms are only evaluated when the temperature changes
+  void ElecMob_batch(unsigned int n_nodes, const PMI_Context *context,
+                     const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                     const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tn, PetscScalar *mob) const
+  {
+    const PetscScalar N_min = 1e0*std::pow(cm,-3);
+    PetscScalar T_last = -1.0;
+    PetscScalar t=0, mu_lattice=0, mu1=0, mu2=0, GT1=0, GT2=0, vsat=0;
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      // temperature dependent terms
+      if( Tl[i] != T_last )
+      {
+        T_last     = Tl[i];
+        t          = Tl[i]/T300;
+        mu_lattice = MMXN_UM*std::pow(t,-TETN_UM);
+        mu1        = MMXN_UM*MMXN_UM/(MMXN_UM-MMNN_UM)*std::pow(t,3*ALPN_UM-1.5);
+        mu2        = MMXN_UM*MMNN_UM/(MMXN_UM-MMNN_UM)*sqrt(T300/Tl[i]);
+        GT1        = std::pow(t/me_over_m0,PetscScalar(0.0001));
+        GT2        = std::pow(T300/Tl[i]*me_over_m0,PetscScalar(1.595787));
+        vsat       = VSATN0/(1+VSATN_A*exp(Tl[i]/(2*T300)));
+      }
+
+      const PetscScalar Na  = ReadDopingNa(context[i])+N_min;
+      const PetscScalar Nd  = ReadDopingNd(context[i])+N_min;
+      const PetscScalar Nds = Nd*(1.0+1.0/(CRFD_UM+(NRFD_UM/Nd)*(NRFD_UM/Nd)));
+      const PetscScalar Nas = Na*(1.0+1.0/(CRFA_UM+(NRFA_UM/Na)*(NRFA_UM/Na)));
+      const PetscScalar Nsc = Nds+Nas+fabs(p[i]);
+
+      const PetscScalar P   = 1.0/(2.459/(NSC_REF/std::pow(Nsc,PetscScalar(2.0/3.0)))+3.828/(CAR_REF/fabs(n[i]+p[i])*me_over_m0))*t*t;
+      const PetscScalar pp1 = std::pow(P,PetscScalar(0.6478));
+      const PetscScalar F   = (0.7643*pp1+2.2999+6.5502*me_over_mh)/(pp1+2.3670-0.8552*me_over_mh);
+      const PetscScalar G   = 1-4.41804/std::pow(39.9014+P*GT1,PetscScalar(0.38297))+0.52896/std::pow(P*GT2,PetscScalar(0.25948));
+      const PetscScalar Nsce = Nds+Nas*G+fabs(p[i])/F;
+      const PetscScalar mu_scatt = mu1*(Nsc/Nsce)*std::pow(NRFN_UM/Nsc,ALPN_UM)+mu2*(fabs(n[i]+p[i])/Nsce);
+      const PetscScalar mu0 = 1.0/(1.0/mu_lattice+1.0/mu_scatt);
+      mob[i] = mu0/std::pow(1+std::pow(mu0*fabs(Ep[i])/vsat,BETAN),1.0/BETAN);
+    }
+  }
+
+  void HoleMob_batch(unsigned int n_nodes, const PMI_Context *context,
+                     const PetscScalar *p,  const PetscScalar *n,  const PetscScalar *Tl,
+                     const PetscScalar *Ep, const PetscScalar *Et, const PetscScalar *Tp, PetscScalar *mob) const
+  {
+    const PetscScalar N_min = 1e0*std::pow(cm,-3);
+    PetscScalar T_last = -1.0;
+    PetscScalar t=0, mu_lattice=0, mu1=0, mu2=0, GT1=0, GT2=0, vsat=0;
+    for(unsigned int i=0; i<n_nodes; ++i)
+    {
+      // temperature dependent terms
+      if( Tl[i] != T_last )
+      {
+        T_last     = Tl[i];
+        t          = Tl[i]/T300;
+        mu_lattice = MMXP_UM*std::pow(t,-TETP_UM);
+        mu1        = MMXP_UM*MMXP_UM/(MMXP_UM-MMNP_UM)*std::pow(t,3*ALPP_UM-1.5);
+        mu2        = MMXP_UM*MMNP_UM/(MMXP_UM-MMNP_UM)*sqrt(T300/Tl[i]);
+        GT1        = std::pow(t/mh_over_m0,PetscScalar(0.0001));
+        GT2        = std::pow(T300/Tl[i]*mh_over_m0,PetscScalar(1.595787));
+        vsat       = VSATP0/(1+VSATP_A*exp(Tl[i]/(2*T300)));
+      }
+
+      const PetscScalar Na  = ReadDopingNa(context[i])+N_min;
+      const PetscScalar Nd  = ReadDopingNd(context[i])+N_min;
+      const PetscScalar Nds = Nd*(1.0+1.0/(CRFD_UM+(NRFD_UM/Nd)*(NRFD_UM/Nd)));
+      const PetscScalar Nas = Na*(1.0+1.0/(CRFA_UM+(NRFA_UM/Na)*(NRFA_UM/Na)));
+      const PetscScalar Nsc = Nds+Nas+fabs(n[i]);
+
+      const PetscScalar P   = 1.0/(2.459/(NSC_REF/std::pow(Nsc,PetscScalar(2.0/3.0)))+3.828/(CAR_REF/fabs(n[i]+p[i])*mh_over_m0))*t*t;
+      const PetscScalar pp1 = std::pow(P,PetscScalar(0.6478));
+      const PetscScalar F   = (0.7643*pp1+2.2999+6.5502/me_over_mh)/(pp1+2.3670-0.8552/me_over_mh);
+      const PetscScalar G   = 1-4.41804/std::pow(39.9014+P*GT1,PetscScalar(0.38297))+0.52896/std::pow(P*GT2,PetscScalar(0.25948));
+      const PetscScalar Nsce = Nas+Nds*G+fabs(n[i])/F;
+      const PetscScalar mu_scatt = mu1*(Nsc/Nsce)*std::pow(NRFP_UM/Nsc,ALPP_UM)+mu2*(fabs(n[i]+p[i])/Nsce);
+      const PetscScalar mu0 = 1.0/(1.0/mu_lattice+1.0/mu_scatt);
+      mob[i] = mu0/std::pow(1+std::pow(mu0*fabs(Ep[i])/vsat,BETAP),1.0/BETAP);
+    }
+  }
+
 // constructor
 public:
   GSS_Si_Mob_Philips(const PMIS_Environment &env):PMIS_Mobility(env)
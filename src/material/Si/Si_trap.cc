@@ -245,6 +245,17 @@ public:
   }
   // }}}
 
+  // {{{ bool HasTrap(const bool flag_bulk)
+  /**
+   * returns true if there are traps of the given type at this node
+   */
+  bool HasTrap(const bool flag_bulk)
+  {
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
+    return TrapStore.find(tloc) != TrapStore.end();
+  }
+  // }}}
+
   // {{{ PetscScalar Charge(const bool flag_bulk)
   /**
    * returns the electric charge density due to trapped charge at this node
@@ -252,7 +263,7 @@ public:
    */
   PetscScalar Charge(const bool flag_bulk)
   {
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -285,7 +296,7 @@ public:
    */
   AutoDScalar ChargeAD(const bool flag_bulk)
   {
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -316,7 +327,7 @@ public:
   {
     PetscScalar theta_n = 1.0e7*cm/s * sqrt(Tl/300/K);     // electron thermal velocity
 
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -355,7 +366,7 @@ public:
   {
     AutoDScalar theta_n = 1.0e7*cm/s * sqrt(Tl/300/K);
 
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -392,7 +403,7 @@ public:
   {
     PetscScalar theta_p = 1.0e7*cm/s * sqrt(Tl/300/K);     // hole thermal velocity
 
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -431,7 +442,7 @@ public:
   {
     AutoDScalar theta_p = 1.0e7*cm/s * sqrt(Tl/300/K);
 
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -464,7 +475,7 @@ public:
     PetscScalar theta_n = 1.0e7*cm/s * sqrt(Tl/300/K);     // electron thermal velocity
     PetscScalar theta_p = 1.0e7*cm/s * sqrt(Tl/300/K);     // hole thermal velocity
 
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -508,7 +519,7 @@ public:
     AutoDScalar theta_n = 1.0e7*cm/s * sqrt(Tl/300/K);     // electron thermal velocity
     AutoDScalar theta_p = 1.0e7*cm/s * sqrt(Tl/300/K);     // hole thermal velocity
 
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -551,7 +562,7 @@ public:
   {
     AutoDScalar theta_n = 1.0e7*cm/s * sqrt(Tl/300/K);     // electron thermal velocity
 
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -596,7 +607,7 @@ public:
       PetscScalar conc = ReadRealVariable(TrapSpecs[i].profile_name); // read concentration from profile
       conc=conc*TrapSpecs[i].prefactor;     // concentration is scaled by the prefactor
       if (conc>0)
-        AddTrap(*(*pp_point),i,conc);
+        AddTrap(*current_point(),i,conc);
     }
   }
   // }}}
@@ -618,7 +629,7 @@ public:
 
       PetscScalar conc = TrapSpecs[i].interface_density;
       if (conc>0)
-        AddTrap(*(*pp_point),i,conc);
+        AddTrap(*current_point(),i,conc);
     }
   }
   // }}}
@@ -630,7 +641,7 @@ public:
   void Calculate(const bool flag_bulk, const PetscScalar &p, const PetscScalar &n, const PetscScalar &ni, const PetscScalar &Tl)
   {
 
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -689,7 +700,7 @@ public:
   void Calculate(const bool flag_bulk, const AutoDScalar &p, const AutoDScalar &n, const AutoDScalar &ni, const AutoDScalar &Tl)
   {
 
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -744,7 +755,7 @@ public:
    */
   void Update(const bool flag_bulk, const PetscScalar &p, const PetscScalar &n, const PetscScalar &ni, const PetscScalar &Tl)
   {
-    TrapLocation tloc = TrapLocation(*(*pp_point),flag_bulk?Bulk:Interface);
+    TrapLocation tloc = TrapLocation(*current_point(),flag_bulk?Bulk:Interface);
 
     TrapStore_t::iterator it = TrapStore.find(tloc);
 
@@ -23,13 +23,14 @@
 
 #include "adolc.h"
 
-unsigned int adtl::AutoDScalar::numdir = 12;
+GENIUS_THREAD_LOCAL unsigned int adtl::AutoDScalarBase::numdir = 12;
 
 
 extern "C"
 {
   DLL_EXPORT_DECLARE  void  set_ad_number(const unsigned int p)
   {
+    // set the AD direction number of the calling thread
     adtl::AutoDScalar::numdir = p;
   }
 }
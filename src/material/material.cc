@@ -28,17 +28,11 @@
 #include "genius_env.h"
 #include "genius_common.h"
 #include "log.h"
+#include "shared_library.h"
 #include "material_define.h"
 
-#ifdef CYGWIN
-  #include <Windows.h>
-  #undef max
-  #undef min
-  #define LDFUN GetProcAddress
-#else
-  #include <dlfcn.h>
-  #define LDFUN dlsym
-#endif
+// the symbols are resolved once per library file and shared by all the regions
+#define LDFUN(dll, name) SharedLibrary::symbol(dll, name)
 
 
 #include "material.h"
@@ -51,7 +45,8 @@ namespace Material
 {
 
   MaterialBase::MaterialBase(const SimulationRegion * reg)
-  : set_ad_num(0),  region(reg) , material(reg->material()), p_point(0), p_node_data(0), dll_file(0)
+  : set_ad_num(0),  region(reg) , material(reg->material()), p_point(0), p_node_data(0), clock(0.0),
+    contexts(std::max(1u, Genius::n_threads())), dll_file(0)
   {
     point_variables = &(region->region_point_variables());
     cell_variables = &(region->region_cell_variables());
@@ -59,19 +54,15 @@ namespace Material
 
   MaterialBase::~MaterialBase()
   {
-#ifdef CYGWIN
-    FreeLibrary(dll_file);
-#else
-    if ( dll_file )
-      dlclose( dll_file );
-#endif
+    SharedLibrary::close( dll_file );
   }
 
 
   PMI_Environment MaterialBase::build_PMI_Environment()
   {
      PMI_Environment env(  &p_point, &p_node_data, &clock, &point_variables,
-                            PhysicalUnit::m, PhysicalUnit::s, PhysicalUnit::V, PhysicalUnit::C, PhysicalUnit::K);
+                            PhysicalUnit::m, PhysicalUnit::s, PhysicalUnit::V, PhysicalUnit::C, PhysicalUnit::K,
+                            &contexts);
      return env;
   }
 
@@ -84,23 +75,14 @@ namespace Material
     std::string filename =  Genius::genius_dir() + "/lib/lib" + _material + ".so";
 #endif
 
-#ifdef CYGWIN
-    dll_file = LoadLibrary(filename.c_str());
+    // the regions of the same material share one library handle
+    dll_file = SharedLibrary::open(filename);
     if(dll_file==NULL)
     {
-      MESSAGE<<"Open material file lib"<< _material <<".dll error." << '\n'; RECORD();
-      MESSAGE<<"Error code: " << GetLastError() << '\n'; RECORD();
+      MESSAGE<<"Open material file "<< filename <<" error." << '\n'; RECORD();
+      MESSAGE<<"Error code: " << SharedLibrary::error() << '\n'; RECORD();
       genius_error();
     }
-#else
-    dll_file = dlopen(filename.c_str(), RTLD_LAZY);
-    if(dll_file==NULL)
-    {
-      MESSAGE<<"Open material file lib"<< _material <<".so error." << '\n'; RECORD();
-      MESSAGE<<"Error code: " << dlerror() << '\n'; RECORD();
-      genius_error();
-    }
-#endif
   }
 
 
@@ -246,30 +228,36 @@ namespace Material
 
   }
 
-  std::string MaterialSemiconductor::get_pmi_info(const std::string& type, const int verbosity)
+  PMI_Server * MaterialSemiconductor::get_pmi(const std::string &type)
   {
-    std::string _material = FormatMaterialString(material);
-    std::stringstream output;
-
-    PMI_Server* pmi;
     switch(PMI_Type_string_to_enum(type))
     {
     case Basic:
-      pmi = basic; break;
+      return basic;
     case Band:
-      pmi = band; break;
+      return band;
     case Mobility:
-      pmi = mob; break;
+      return mob;
     case Impact:
-      pmi = gen; break;
+      return gen;
     case Thermal:
-      pmi = thermal; break;
+      return thermal;
     case Optical:
-      pmi = optical; break;
+      return optical;
     case Trap:
-      pmi = trap; break;
-    default: genius_error();
+      return trap;
+    default: break;
     }
+    return NULL;
+  }
+
+  std::string MaterialSemiconductor::get_pmi_info(const std::string& type, const int verbosity)
+  {
+    std::string _material = FormatMaterialString(material);
+    std::stringstream output;
+
+    PMI_Server* pmi = get_pmi(type);
+    genius_assert(pmi);
     output << pmi->get_PMI_info() << std::endl;
     output << pmi->get_parameter_string(verbosity) ;
 
@@ -314,6 +314,26 @@ namespace Material
   }
 
 
+  int material_weight(const std::string & mat_name, const std::string & solver)
+  {
+    // the potential equation only
+    if( solver == "poisson" ) return 1;
+
+    // the semiconductor region has one more than its equations for the carrier
+    // generation/recombination terms, other regions solve the potential (and lattice temperature)
+    if( solver == "ddml1" || solver == "ddml1m" || solver == "hall" || solver == "ddmac" )
+      return IsSemiconductor(mat_name) ? 4 : 1;
+    if( solver == "qddm" )
+      return IsSemiconductor(mat_name) ? 6 : 1;
+    if( solver == "ddml2" || solver == "ddml2m" )
+      return IsSemiconductor(mat_name) ? 5 : 2;
+    if( solver == "ebml3" || solver == "ebml3m" )
+      return IsSemiconductor(mat_name) ? 7 : 2;
+
+    return material_weight(mat_name);
+  }
+
+
   //----------------------------------------------------------
   // since some matrial has alias ( such as "Ox" and "SiO2" )
   // format them to unique name
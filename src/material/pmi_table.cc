@@ -0,0 +1,234 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cmath>
+#include <algorithm>
+
+#include "pmi_table.h"
+
+
+/**
+ * weights of Catmull-Rom spline on nodes i-1, i, i+1, i+2 and their derivatives to t,
+ * t in [0,1] is the local coordinate in the cell [i, i+1]
+ */
+static void catmull_rom_weights(PetscScalar t, PetscScalar *w, PetscScalar *dw)
+{
+  const PetscScalar t2 = t*t;
+  const PetscScalar t3 = t2*t;
+
+  w[0] = 0.5*(-t3 + 2.0*t2 - t);
+  w[1] = 0.5*(3.0*t3 - 5.0*t2 + 2.0);
+  w[2] = 0.5*(-3.0*t3 + 4.0*t2 + t);
+  w[3] = 0.5*(t3 - t2);
+
+  dw[0] = 0.5*(-3.0*t2 + 4.0*t - 1.0);
+  dw[1] = 0.5*(9.0*t2 - 10.0*t);
+  dw[2] = 0.5*(-9.0*t2 + 8.0*t + 1.0);
+  dw[3] = 0.5*(3.0*t2 - 2.0*t);
+}
+
+
+bool PMI_Table::build(const PMI_TableFunction &f, unsigned int dim, const PetscScalar *lo, const PetscScalar *hi,
+                      PetscScalar rtol, unsigned int init_points, unsigned int max_points)
+{
+  genius_assert(dim>=1 && dim<=3);
+  genius_assert(init_points>=2);
+
+  this->clear();
+
+  _dim = dim;
+  for(unsigned int d=0; d<3; ++d)
+  {
+    if( d<dim )
+    {
+      genius_assert(hi[d] > lo[d]);
+      _lo[d] = lo[d];
+      _hi[d] = hi[d];
+      _n[d]  = init_points;
+    }
+    else
+    {
+      _lo[d] = _hi[d] = 0.0;
+      _n[d]  = 1;
+      _h[d]  = 1.0;
+    }
+  }
+
+  while(true)
+  {
+    for(unsigned int d=0; d<dim; ++d)
+      _h[d] = (_hi[d] - _lo[d])/(_n[d]-1);
+
+    _fill(f);
+
+    PetscScalar scale = 0.0;
+    for(unsigned int i=0; i<_values.size(); ++i)
+      scale = std::max(scale, std::abs(_values[i]));
+    if( scale == 0.0 ) scale = 1.0;
+
+    // refine the dimensions which do not reach the error bound
+    bool refine[3] = {false, false, false};
+    bool any_refine = false;
+    unsigned int new_points = 1;
+    _error = 0.0;
+    for(unsigned int d=0; d<dim; ++d)
+    {
+      PetscScalar e = _midpoint_error(f, d, scale);
+      _error = std::max(_error, e);
+      if( e > rtol ) { refine[d] = true; any_refine = true; }
+      new_points *= refine[d] ? 2*_n[d]-1 : _n[d];
+    }
+
+    if( !any_refine ) { _converged = true; break; }
+
+    // the table is too large, keep the current one
+    if( new_points > max_points ) break;
+
+    for(unsigned int d=0; d<dim; ++d)
+      if( refine[d] ) _n[d] = 2*_n[d]-1;
+  }
+
+  return _converged;
+}
+
+
+void PMI_Table::clear()
+{
+  _dim = 0;
+  _converged = false;
+  _error = 0.0;
+  _values.clear();
+}
+
+
+void PMI_Table::_fill(const PMI_TableFunction &f)
+{
+  _values.resize(_n[0]*_n[1]*_n[2]);
+
+  PetscScalar x[3];
+  unsigned int p=0;
+  for(unsigned int k=0; k<_n[2]; ++k)
+    for(unsigned int j=0; j<_n[1]; ++j)
+      for(unsigned int i=0; i<_n[0]; ++i, ++p)
+      {
+        x[0] = _grid(0, i);
+        x[1] = _grid(1, j);
+        x[2] = _grid(2, k);
+        _values[p] = f(x);
+      }
+}
+
+
+PetscScalar PMI_Table::_midpoint_error(const PMI_TableFunction &f, unsigned int d, PetscScalar scale) const
+{
+  PetscScalar error = 0.0;
+
+  PetscScalar x[3];
+  unsigned int index[3];
+  for(index[2]=0; index[2]<_n[2]; ++index[2])
+    for(index[1]=0; index[1]<_n[1]; ++index[1])
+      for(index[0]=0; index[0]<_n[0]; ++index[0])
+      {
+        if( index[d]+1 == _n[d] ) continue;
+        for(unsigned int c=0; c<3; ++c)
+          x[c] = _grid(c, index[c]);
+        x[d] += 0.5*_h[d];
+        error = std::max(error, std::abs(eval(x) - f(x))/scale);
+      }
+
+  return error;
+}
+
+
+PetscScalar PMI_Table::eval(const PetscScalar *x, PetscScalar *df) const
+{
+  // the spline weights of each dimension, the ghost nodes outside the table are
+  // linearly extrapolated and folded onto the two boundary nodes
+  unsigned int index[3][6];
+  PetscScalar  w[3][6];
+  PetscScalar  dw[3][6];
+  unsigned int count[3];
+
+  for(unsigned int d=0; d<3; ++d)
+  {
+    count[d] = 0;
+    if( d>=_dim )
+    {
+      index[d][0] = 0;  w[d][0] = 1.0;  dw[d][0] = 0.0;
+      count[d] = 1;
+      continue;
+    }
+
+    const int n = static_cast<int>(_n[d]);
+    const PetscScalar s = (x[d] - _lo[d])/_h[d];
+    const int i = std::max(0, std::min(static_cast<int>(std::floor(s)), n-2));
+
+    PetscScalar cw[4], cdw[4];
+    catmull_rom_weights(s-i, cw, cdw);
+
+    for(int c=0; c<4; ++c)
+    {
+      const int j = i-1+c;
+      const PetscScalar wc  = cw[c];
+      const PetscScalar dwc = cdw[c]/_h[d];
+      if( j < 0 )
+      {
+        index[d][count[d]] = 0;   w[d][count[d]] =  2.0*wc;  dw[d][count[d]] =  2.0*dwc;  ++count[d];
+        index[d][count[d]] = 1;   w[d][count[d]] = -wc;      dw[d][count[d]] = -dwc;      ++count[d];
+      }
+      else if( j > n-1 )
+      {
+        index[d][count[d]] = n-1; w[d][count[d]] =  2.0*wc;  dw[d][count[d]] =  2.0*dwc;  ++count[d];
+        index[d][count[d]] = n-2; w[d][count[d]] = -wc;      dw[d][count[d]] = -dwc;      ++count[d];
+      }
+      else
+      {
+        index[d][count[d]] = j;   w[d][count[d]] =  wc;      dw[d][count[d]] =  dwc;      ++count[d];
+      }
+    }
+  }
+
+  const unsigned int stride1 = _n[0];
+  const unsigned int stride2 = _n[0]*_n[1];
+
+  PetscScalar value = 0.0;
+  PetscScalar grad[3] = {0.0, 0.0, 0.0};
+  for(unsigned int c=0; c<count[2]; ++c)
+    for(unsigned int b=0; b<count[1]; ++b)
+    {
+      const unsigned int offset = index[2][c]*stride2 + index[1][b]*stride1;
+      for(unsigned int a=0; a<count[0]; ++a)
+      {
+        const PetscScalar v = _values[offset + index[0][a]];
+        value   += w[0][a] *w[1][b] *w[2][c] *v;
+        grad[0] += dw[0][a]*w[1][b] *w[2][c] *v;
+        grad[1] += w[0][a] *dw[1][b]*w[2][c] *v;
+        grad[2] += w[0][a] *w[1][b] *dw[2][c]*v;
+      }
+    }
+
+  if( df )
+    for(unsigned int d=0; d<_dim; ++d)
+      df[d] = grad[d];
+
+  return value;
+}
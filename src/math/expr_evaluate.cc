@@ -96,6 +96,14 @@ ExprEvalute::ExprEvalute(const std::string & expr)
   e.SetValueList(&vlist);
 
   e.Parse(expr);
+
+  // variable address never changes after parse
+  _x = vlist.GetAddress("x");
+  _y = vlist.GetAddress("y");
+  _z = vlist.GetAddress("z");
+  _t = vlist.GetAddress("t");
+
+  e.Compile(program);
 }
 
 
@@ -103,11 +111,25 @@ ExprEvalute::ExprEvalute(const std::string & expr)
 double ExprEvalute::eval(double x, double y, double z, double t)
 {
   //assign variable value to the expr
-  *(vlist.GetAddress("x")) = x;
-  *(vlist.GetAddress("y")) = y;
-  *(vlist.GetAddress("z")) = z;
-  *(vlist.GetAddress("t")) = t;
+  *_x = x;
+  *_y = y;
+  *_z = z;
+  *_t = t;
 
-  return e.Evaluate();
+  return program.Run();
+}
+
+
+void ExprEvalute::eval(unsigned int n, const double *x, const double *y, const double *z, double t, double *value)
+{
+  *_t = t;
+
+  std::vector<double *> vars;
+  std::vector<const double *> values;
+  vars.push_back(_x);  values.push_back(x);
+  vars.push_back(_y);  values.push_back(y);
+  vars.push_back(_z);  values.push_back(z);
+
+  program.Run(n, vars, values, value);
 }
 
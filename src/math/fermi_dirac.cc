@@ -0,0 +1,562 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cmath>
+
+#include "fermi_dirac.h"
+
+namespace
+{
+  const unsigned int n_low  = 11;
+  const unsigned int n_mid  = 24;
+  const unsigned int n_cheb = 15;
+  const unsigned int n_high = 4;
+
+  const Real x_low  = -2.0;
+  const Real x_high = 46.0;
+  const Real t_low  = 0.1353352832366127;  // exp(x_low)
+
+  // the coefficients are chebyshev interpolants of the integrals evaluated by
+  // gauss-legendre quadrature (x >= -2) or the series sum (-1)^(k+1) exp(kx)/k^(j+1) (x < -2)
+
+  /**
+   * F_{1/2}(x)/exp(x) as function of t=exp(x) on [0, exp(-2)]
+   */
+  const Real half_low[n_low] =
+  {
+    +9.77308379081188172e-01, -2.22949641547278490e-02, +3.88421681660715138e-04,
+    -8.04719093942681065e-06, +1.83340356795337250e-07, -4.43623491477105561e-09,
+    +1.11902305603579904e-10, -2.90999547690841042e-12, +7.71504072748608747e-14,
+    -9.89107785575139571e-16, +2.82602224450039842e-16
+  };
+
+  /**
+   * F_{1/2}(x) on [-2, 46], interval of width 2
+   */
+  const Real half_mid[n_mid][n_cheb] =
+  {
+    // [-2, 0]
+    {
+      +3.87390387386900625e-01, +3.12040670230237516e-01, +5.97181735665643920e-02,
+      +5.92844472793223939e-03, +1.18494725762783673e-04, -4.51467056250728013e-05,
+      -4.36754462509643861e-06, +2.85862798156862487e-07, +8.19932068389187864e-08,
+      +1.64880195977860447e-09, -1.16595040659343372e-09, -1.14224352198988299e-10,
+      +1.08611564186844596e-11, +2.79331419106298995e-12, +3.08177094954231747e-14
+    },
+    // [0, 2]
+    {
+      +1.68553827314098825e+00, +1.02867469800625022e+00, +1.09392789194931062e-01,
+      +5.85901906180522980e-04, -5.00798469793665556e-04, +2.71379905577943496e-05,
+      +3.89880995779930546e-06, -6.21526693060185134e-07, -1.11076666975407082e-08,
+      +1.01330661195220266e-08, -5.73412236211841742e-10, -1.21936831002737251e-10,
+      +1.88673854317755727e-11, +6.47023175777879576e-13, -3.83911421171963718e-13
+    },
+    // [2, 4]
+    {
+      +4.57755609901289162e+00, +1.84629626764557453e+00, +9.00498718406306936e-02,
+      -2.38195031310635148e-03, +3.98306964326522461e-05, +8.73866786884984064e-06,
+      -1.36508819655508274e-06, +1.02410507274441892e-07, -1.49435660882583448e-09,
+      -7.26390473696862204e-10, +1.10813817381464708e-10, -7.93551890865273922e-12,
+      -1.71418435002124176e-14, +8.57092175010620849e-14, -6.80936788436762704e-15
+    },
+    // [4, 6]
+    {
+      +8.91159068028307821e+00, +2.46888799857760821e+00, +6.74373924930253138e-02,
+      -1.36990603788476059e-03, +5.56122485262970173e-05, -2.00658326493889181e-06,
+      +3.72179537559228850e-09, +8.86582943356491634e-09, -1.07872383618238623e-09,
+      +8.56024584550141325e-11, -4.88101411140936112e-12, +1.46727074934460678e-13,
+      +1.88293824976426543e-14, +6.33567272719422624e-15, +1.53802896344738351e-14
+    },
+    // [6, 8]
+    {
+      +1.43456369913048469e+01, +2.95496734052786003e+00, +5.51483381847132151e-02,
+      -7.56164455652926447e-04, +2.45821187535947664e-05, -1.00598202313525072e-06,
+      +3.98920448674289232e-08, -1.16802236031314042e-09, -2.88054025077144599e-12,
+      +3.97453921626341379e-12, -4.09746310954991090e-13, +2.58163860659503065e-14,
+      +1.29674049276218281e-14, +6.98700356830765146e-15, +2.47505719623101569e-14
+    },
+    // [8, 10]
+    {
+      +2.06719167453016013e+01, +3.36530094659924517e+00, +4.79101507708061050e-02,
+      -4.82136069500427311e-04, +1.16317288307262356e-05, -3.87865062142130513e-07,
+      +1.47104467866180731e-08, -5.57037083126488142e-10, +1.87514596442876304e-11,
+      -4.44326057428649303e-13, -1.68161780796557046e-14, -2.72374715374705050e-15,
+      +1.68161780796557046e-14, +6.63173220042760184e-15, +3.70074341541718826e-14
+    },
+    // [10, 12]
+    {
+      +2.77693883382183344e+01, +3.72811650199817457e+00, +4.30353509861414324e-02,
+      -3.43172373692368648e-04, +6.43134204144265188e-06, -1.68239221901937209e-07,
+      +5.28811672969216747e-09, -1.81782885041078173e-10, +6.32619882405075892e-12,
+      -1.95399252334027551e-13, -1.25529216650951029e-14, -6.15803704325420182e-15,
+      +3.97903932025656079e-14, +1.13686837721616036e-14, +5.25209505516007383e-14
+    },
+    // [12, 14]
+    {
+      +3.55579536614690213e+01, +4.05745825427727969e+00, +3.94420881656017755e-02,
+      -2.61686926685911181e-04, +4.01746552209184902e-06, -8.50532117624425181e-08,
+      +2.17651934993530915e-09, -6.29564548641307478e-11, +1.97815097635611876e-12,
+      -6.91594929473164122e-14, -3.22112706877912076e-14, +5.21064672890740099e-15,
+      +4.83169060316868114e-14, +1.93030776548160559e-14, +5.12775007640205643e-14
+    },
+    // [14, 16]
+    {
+      +4.39791589626180155e+01, +4.36141335748064662e+00, +3.66391991515863935e-02,
+      -2.08672327253604339e-04, +2.72529132606299136e-06, -4.85434147397730456e-08,
+      +1.03625647322284444e-09, -2.51020537689328174e-11, +6.65541695828627208e-13,
+      -8.05281767194780190e-15, -4.12114786740858095e-14, +4.26325641456060096e-15,
+      +5.06853818175538099e-14, +1.53950926081355030e-14, +3.57639843665917085e-14
+    },
+    // [16, 18]
+    {
+      +5.29876492349496928e+01, +4.64518591751074617e+00, +3.43685343781743313e-02,
+      -1.71685634453903430e-04, +1.95646718073779384e-06, -3.01982415370124143e-08,
+      +5.54031961049380084e-10, -1.14217376297650240e-11, +2.57690165502329661e-13,
+      +9.47390314346800195e-15, -5.92118946466750197e-14, -2.41584530158434057e-14,
+      +4.80800584531001122e-14, +2.27373675443232072e-14, +5.66065712822213156e-14
+    },
+    // [18, 20]
+    {
+      +6.25467933362815529e+01, +4.91238375269104299e+00, +3.24782746415792217e-02,
+      -1.44585879506090948e-04, +1.46359155053232834e-06, -1.99842493960507740e-08,
+      +3.22587349425399817e-10, -5.83118738480455526e-12, +1.29792473065511627e-13,
+      +2.55795384873636073e-14, -6.48962365327558136e-14, +5.68434188608080180e-15,
+      +4.73695157173400145e-14, +3.07901852162710091e-15, +1.00068101952880780e-13
+    },
+    // [20, 22]
+    {
+      +7.26261553302968963e+01, +5.16564003307123176e+00, +3.08717862520192440e-02,
+      -1.23994166466445682e-04, +1.12995767362159922e-06, -1.38536336180550269e-08,
+      +2.00193994714936702e-10, -3.18796840777698297e-12, +8.62125186055588192e-14,
+      +2.27373675443232072e-14, -4.64221254029932113e-14, -2.46321481730168073e-14,
+      +7.05805784188366201e-14, +2.13162820728030048e-15, +9.41469124882132746e-14
+    },
+    // [22, 24]
+    {
+      +8.31999019617675515e+01, +5.40695045077996461e+00, +2.94839582805195739e-02,
+      -1.07897864647081107e-04, +8.94529862686492019e-07, -9.95980447745144700e-09,
+      +1.30388381573235768e-10, -1.91278104466618962e-12, +7.67386154620908251e-14,
+      +1.89478062869360047e-15, -7.86333960907844189e-14, -6.25277607468888214e-14,
+      +3.78956125738720078e-14, +1.32634644008552037e-14, +1.31450406115618534e-13
+    },
+    // [24, 26]
+    {
+      +9.42457368261155608e+01, +5.63787221494268387e+00, +2.82689909641684750e-02,
+      -9.50252422740049951e-05, +7.22818363859308467e-07, -7.37465863191270436e-09,
+      +8.83081459808939430e-11, -1.14255271910224118e-12, +5.40012479177676116e-14,
+      +6.63173220042760216e-14, -1.01370763635107620e-13, -6.53699316899292121e-14,
+      +8.57388234483854207e-14, -3.07901852162710060e-14, +1.60819505860369339e-13
+    },
+    // [26, 28]
+    {
+      +1.05744154056190112e+02, +5.85964902511729324e+00, +2.71935563483358088e-02,
+      -8.45350867128521116e-05, +5.94144840230607452e-07, -5.59580257686320659e-09,
+      +6.18437449399304283e-11, -7.71175715878295388e-13, +2.46321481730168073e-14,
+      +4.35799544599528080e-14, -1.56319401867222041e-13, -1.04212934578148020e-14,
+      +1.77161988782851648e-13, +4.45273447742996112e-14, +2.19320857771284261e-13
+    },
+    // [28, 30]
+    {
+      +1.17677897002232598e+02, +6.07329338389732598e+00, +2.62327228457327997e-02,
+      -7.58501026344523155e-05, +4.95516066697139988e-07, -4.33465743299166239e-09,
+      +4.45102917486413675e-11, -4.73695157173400158e-13, +0.00000000000000000e+00,
+      -2.65269288017104074e-14, -5.68434188608080149e-14, -2.93690997447508043e-14,
+      +1.27897692436818033e-13, -1.04212934578148020e-14, +2.10557497363576352e-13
+    },
+    // [30, 32]
+    {
+      +1.30031554268123415e+02, +6.27964290755467491e+00, +2.53674057506183687e-02,
+      -6.85618799479925602e-05, +4.18448269101645554e-07, -3.41781098237940243e-09,
+      +3.26754919418211427e-11, -3.78956125738720116e-13, +3.78956125738720094e-15,
+      +7.57912251477440156e-14, -1.25055521493777643e-13, -7.76860057764376220e-14,
+      +1.62003743753302847e-13, -1.42108547152020045e-15, +2.17426077142590642e-13
+    },
+    // [32, 34]
+    {
+      +1.42791251060294542e+02, +6.47940006779492705e+00, +2.45827081491256649e-02,
+      -6.23739801426381746e-05, +3.57221305572844982e-07, -2.73662976724153867e-09,
+      +2.45942525604429355e-11, -2.17899772299764065e-13, +7.01068832616632217e-14,
+      +4.16851738312592080e-14, -1.45898108409407225e-13, -2.27373675443232072e-14,
+      +1.51582450295488031e-13, -4.73695157173400117e-16, +2.12925973149443344e-13
+    },
+    // [34, 36]
+    {
+      +1.55944408618549829e+02, +6.67316098352383680e+00, +2.38668051728609491e-02,
+      -5.70664575586003281e-05, +3.07871304509414279e-07, -2.22099743041326275e-09,
+      +1.87659073465814189e-11, -2.36847578586700079e-13, +5.68434188608080180e-15,
+      -9.47390314346800195e-15, -1.87583282240666439e-13, -6.82121026329696153e-14,
+      +1.76214598468504851e-13, +1.20792265079217032e-13, +4.10693701269337887e-13
+    },
+    // [36, 38]
+    {
+      +1.69479553482756387e+02, +6.86143675110484619e+00, +2.32101724025407449e-02,
+      -5.24729797007239499e-05, +2.67585320064730092e-07, -1.82406741563075526e-09,
+      +1.45026509320208178e-11, -8.71599089199056161e-14, -4.73695157173400145e-14,
+      +6.06329801181952150e-14, -1.78109379097198445e-13, -7.20016638903568155e-14,
+      +2.22636723871498050e-13, +9.09494701772928288e-14, +2.86585570089907092e-13
+    },
+    // [38, 40]
+    {
+      +1.83386164013772259e+02, +7.04466955546720275e+00, +2.26050392649919246e-02,
+      -4.84656383567501819e-05, +2.34325796100165462e-07, -1.51403204048013614e-09,
+      +1.14747914873684450e-11, -1.59161572810262432e-13, -9.47390314346800195e-15,
+      +2.25478894814538466e-13, -1.98951966012828052e-13, -2.84217094304040074e-14,
+      +2.09373259470642843e-13, +1.26002911808124440e-13, +2.51532128459075456e-13
+    },
+    // [40, 42]
+    {
+      +1.97654545276488705e+02, +7.22324504686526225e+00, +2.20449935901304642e-02,
+      -4.49446085099225470e-05, +2.06589201449484478e-07, -1.26879437326958083e-09,
+      +9.05326184389802231e-12, -1.13686837721616030e-13, +5.87381994895016086e-14,
+      +1.11792057092922423e-13, -2.00846746641521646e-13, -3.22112706877912076e-14,
+      +1.33582034322898840e-13, +2.84217094304040090e-15, +3.11691413420097285e-13
+    },
+    // [42, 44]
+    {
+      +2.12275725864291928e+02, +7.39750199208458170e+00, +2.15246901813391858e-02,
+      -4.18309484719732880e-05, +1.83247921844061535e-07, -1.07240794022800401e-09,
+      +7.39343401316242892e-12, -1.13686837721616036e-14, +9.85285926920672291e-14,
+      +7.01068832616632217e-14, -1.76214598468504851e-13, -4.73695157173400145e-14,
+      +3.34428780964420461e-13, -5.68434188608080180e-15, +3.61903100080477671e-13
+    },
+    // [44, 46]
+    {
+      +2.27241371940607564e+02, +7.56773990114096495e+00, +2.10396324734385097e-02,
+      -3.90614885759532653e-05, +1.63444027142152970e-07, -9.13481320215699566e-10,
+      +6.01403371547348781e-12, -1.02318153949454429e-13, +1.17476398979003217e-13,
+      -2.27373675443232072e-14, -2.02741527270215240e-13, -3.03164900590976075e-14,
+      +3.20217926249218457e-13, +9.47390314346800235e-16, +2.78532752417959293e-13
+    }
+  };
+
+  /**
+   * coefficients of the sommerfeld expansion of F_{1/2}, x>46
+   */
+  const Real half_high[n_high] =
+  {
+    +1.23370055013616975e+00, +1.06541193318440142e+00, +9.70151855495912585e+00,
+    +2.42715048146678214e+02
+  };
+
+  /**
+   * F_{-1/2}(x)/exp(x) as function of t=exp(x) on [0, exp(-2)]
+   */
+  const Real mhalf_low[n_low] =
+  {
+    +9.55766828548856973e-01, -4.30831010646618787e-02, +1.11840556313294853e-03,
+    -3.07650999710700789e-05, +8.73642715282230142e-07, -2.53141284297956036e-08,
+    +7.43774617652868303e-10, -2.20776730230909379e-11, +6.60219353934818118e-13,
+    -1.88334196722776575e-14, +8.67992546525122404e-16
+  };
+
+  /**
+   * F_{-1/2}(x) on [-2, 46], interval of width 2
+   */
+  const Real mhalf_mid[n_mid][n_cheb] =
+  {
+    // [-2, 0]
+    {
+      +3.29602285543851459e-01, +2.39769530370421868e-01, +3.51232306272285591e-02,
+      +8.96836104164727655e-04, -4.47437740364906933e-04, -5.11217019371031561e-05,
+      +4.02931588520301816e-06, +1.28883356333061214e-06, +2.72367103648640787e-08,
+      -2.30577451798552589e-08, -2.44171685093164106e-09, +2.61265191888367566e-10,
+      +7.12204758131681053e-11, +5.99567155183204201e-13, -1.43096830681107195e-12
+    },
+    // [0, 2]
+    {
+      +1.03056383285565811e+00, +4.33611365992241260e-01, +3.77826969881671620e-03,
+      -3.95979078748485893e-03, +2.62858261729152331e-04, +4.65969708627037946e-05,
+      -8.52164385726587351e-06, -1.88748628016099918e-07, +1.79729848122830061e-07,
+      -1.10259565329802932e-08, -2.66534265029131713e-09, +4.42266441987489633e-10,
+      +1.72798701273772323e-11, -1.04707575943052685e-11, +5.48091202053531837e-13
+    },
+    // [2, 4]
+    {
+      +1.83919482029545045e+00, +3.60501730181455926e-01, -1.42028947002440144e-02,
+      +3.02242818931356793e-04, +8.88071783747908683e-05, -1.64027525450490458e-05,
+      +1.42049968051930859e-06, -2.16941711113823515e-08, -1.32474113456737535e-08,
+      +2.21555603493091756e-09, -1.72357787301772686e-10, -8.09574629556664149e-13,
+      +2.20898114614935066e-12, -3.21875859299325364e-13, +2.40104232792267171e-14
+    },
+    // [4, 6]
+    {
+      +2.46476831038052913e+00, +2.70194495265012768e-01, -8.23937639416480287e-03,
+      +4.44925292910329062e-04, -1.99401668479500430e-05, +2.73046651066977106e-08,
+      +1.25665777250816296e-07, -1.73568080796826520e-08, +1.54412151213515845e-09,
+      -9.72367075746660729e-11, +3.19557713623908065e-12, +1.98729921407903021e-13,
+      -4.65997610869332389e-14, +4.92198874250486093e-15, +2.97539770599541961e-15
+    },
+    // [6, 8]
+    {
+      +2.95269380911071577e+00, +2.20790488339076524e-01, -4.54706283429366902e-03,
+      +1.97135600230187902e-04, -1.00761003501167082e-05, +4.78650215463005679e-07,
+      -1.62801526334040610e-08, -5.41685807320391190e-11, +7.20786097474501756e-11,
+      -8.00325731612853523e-12, +6.22909131683021197e-13, -4.10042370428224461e-14,
+      +5.26985862355407659e-15, +5.32907051820075120e-16, +3.80436423104886964e-15
+    },
+    // [8, 10]
+    {
+      +3.36385259516222046e+00, +1.91733833739194448e-01, -2.89670287401767954e-03,
+      +9.32306560028332317e-05, -3.88645715633610181e-06, +1.76825265540969667e-07,
+      -7.80666606914337502e-09, +2.99908956928144720e-10, -8.13162870372252623e-12,
+      -2.20860367032097812e-14, +2.06945571790129185e-14, -3.52310773147716353e-15,
+      +4.58892183511731396e-15, +2.27965794389698789e-15, +6.16543853008503578e-15
+    },
+    // [10, 12]
+    {
+      +3.72708614240676184e+00, +1.72192918239433945e-01, -2.06071918283493938e-03,
+      +5.15142949023328342e-05, -1.68494070897177530e-06, +6.35586655898616041e-08,
+      -2.54844193155652939e-09, +1.01290057822704202e-10, -3.74225095356450733e-12,
+      +1.22094926761443884e-13, -5.26985862355407659e-15, -2.30926389122032568e-15,
+      +2.27965794389698789e-15, +9.76996261670137834e-16, +6.28386231937838618e-15
+    },
+    // [12, 14]
+    {
+      +4.05667276778970720e+00, +1.57800518535794743e-01, -1.57097297519683812e-03,
+      +3.21658734473354968e-05, -8.51415135964354387e-07, +2.61492822062336914e-08,
+      -8.82949417283877327e-10, +3.13027825882272762e-11, -1.11265071230567023e-12,
+      +3.97903932025656079e-14, -5.98040135931417662e-15, -1.59872115546022546e-15,
+      +3.31586610021380092e-15, +1.40628249785853155e-15, +5.13663186059905749e-15
+    },
+    // [14, 16]
+    {
+      +4.36078709760614736e+00, +1.46578611382488677e-01, -1.25251974900599796e-03,
+      +2.18147760622381760e-05, -4.85785444996148864e-07, +1.24454631489356861e-08,
+      -3.51512241536511262e-10, +1.06464762931561079e-11, -3.34487992859067183e-13,
+      +1.11910480882215776e-14, -4.44089209850062616e-15, +2.66453525910037560e-16,
+      +6.01000730663751402e-15, -3.25665420556712562e-16, +5.87678054368249492e-15
+    },
+    // [16, 18]
+    {
+      +4.64467070953601358e+00, +1.37489795902514089e-01, -1.03041594941627088e-03,
+      +1.56583898264746807e-05, -3.02142646546599302e-07, +6.65241609946557853e-09,
+      -1.60409404278046459e-10, +4.14891824599787144e-12, -1.12857871196562576e-13,
+      +4.79616346638067657e-15, -5.21064672890740099e-15, +7.40148683083437726e-16,
+      +1.30266168222685025e-15, +2.22044604925031308e-16, +7.54211508062023052e-15
+    },
+    // [18, 20]
+    {
+      +4.91194989509057756e+00, +1.29924811171558463e-01, -8.67715200932058449e-04,
+      +1.17126051713730330e-05, -1.99924121465263233e-07, +3.87292390750341562e-09,
+      -8.16412419150462197e-11, +1.83426607236469847e-12, -4.16259619366125363e-14,
+      +2.90138283768707571e-15, -5.03301104496737658e-15, -1.39147952419686285e-15,
+      +5.47710025481743920e-15, +5.47710025481743920e-16, +5.34387349186242010e-15
+    },
+    // [20, 22]
+    {
+      +5.16526798128123499e+00, +1.23496187072123689e-01, -7.44103579973772323e-04,
+      +9.04206410806314804e-06, -1.38581182677436715e-07, +2.40246542659861015e-09,
+      -4.51297665904348820e-11, +9.01678731679567075e-13, -1.57503639760155550e-14,
+      +2.01320441798695047e-15, -2.66453525910037570e-15, -1.06581410364015024e-15,
+      +4.97379915032070099e-15, +1.33226762955018785e-15, +5.90638649100583232e-15
+    },
+    // [22, 24]
+    {
+      +5.40662670737371887e+00, +1.17942990926057450e-01, -6.47486812493032883e-04,
+      +7.15780421162529965e-06, -9.96242864204077678e-08, +1.56508039121187421e-09,
+      -2.65670744662808511e-11, +4.76418904327147154e-13, -8.46730093447452711e-15,
+      +1.30266168222685025e-15, -6.21724893790087663e-15, +2.96059473233375061e-16,
+      +5.71394783340413921e-15, +3.64153152077051314e-15, +1.27897692436818037e-14
+    },
+    // [24, 26]
+    {
+      +5.63758710233426630e+00, +1.13081747463956120e-01, -5.70225216779955257e-04,
+      +5.78360720714007001e-06, -7.37631144905511376e-08, +1.06030289733401637e-09,
+      -1.64400641248600232e-11, +2.66927221067210943e-13, -1.42108547152020045e-15,
+      +3.61192557344717573e-15, -6.03961325396085142e-15, -4.85537536102735138e-15,
+      +8.08242361927113930e-15, +7.40148683083437726e-16, +9.85878045867138976e-15
+    },
+    // [26, 28]
+    {
+      +5.85939539187326908e+00, +1.08778979294096578e-01, -5.07266487982486591e-04,
+      +4.75390059087032990e-06, -5.59683205854829156e-08, +7.41864288518930469e-10,
+      -1.05950211567081465e-11, +1.61766896174716136e-13, -1.77635683940025046e-15,
+      +3.96719694132722614e-15, -5.80276567537415141e-15, +1.18423789293350029e-16,
+      +6.95739762098431406e-15, +1.83556873404692527e-15, +9.02981393361793934e-15
+    },
+    // [28, 30]
+    {
+      +6.07306581191262929e+00, +1.04934856044426539e-01, -4.55143969334415011e-04,
+      +3.96466165746289806e-06, -4.33536452959515399e-08, +5.33318100792712399e-10,
+      -7.06030789388023534e-12, +9.91207116385339709e-14, -1.18423789293350029e-16,
+      +5.26985862355407659e-15, -3.73034936274052613e-15, -4.26325641456060096e-15,
+      +7.81597009336110268e-15, +3.43428988950715092e-15, +8.77816338136957063e-15
+    },
+    // [30, 32]
+    {
+      +6.27943720482353829e+00, +1.01472970980664934e-01, -4.11405462295633139e-04,
+      +3.34797839727229976e-06, -3.41827919451513168e-08, +3.92379580678910591e-10,
+      -4.84258559178366925e-12, +6.47778127434624703e-14, -1.06581410364015024e-15,
+      +1.71714494475357546e-15, -4.20404451991392615e-15, -2.30926389122032568e-15,
+      -8.88178419700125282e-17, +1.89478062869360047e-15, +1.03176726421831219e-14
+    },
+    // [32, 34]
+    {
+      +6.47921293216972050e+00, +9.83336906615694117e-02, -3.74271250401037058e-04,
+      +2.85806504921974148e-06, -2.73696228939949534e-08, +2.94523990381397494e-10,
+      -3.40799980828402714e-12, +4.40536496171262128e-14, +3.55271367880050093e-15,
+      -1.42108547152020045e-15, -6.39488462184090183e-15, -1.95399252334027567e-15,
+      +4.82576941370401397e-15, +1.86517468137026307e-15, +1.16055313507483028e-14
+    },
+    // [34, 36]
+    {
+      +6.67298977304545460e+00, +9.54696838865871228e-02, -3.42420956889929074e-04,
+      +2.46319523498073059e-06, -2.22117861881088174e-08, +2.24983054408767197e-10,
+      -2.44628021543273137e-12, +2.85401332196973570e-14, +1.65793305010690046e-15,
+      +5.62512999143412621e-15, -4.44089209850062616e-15, -1.36187357687352525e-15,
+      +9.17784367023462793e-15, +5.56591809678745140e-15, +8.67454256573788893e-15
+    },
+    // [36, 38]
+    {
+      +6.86127932304483679e+00, +9.28428304679895233e-02, -3.14856119933182277e-04,
+      +2.14085738991324596e-06, -1.82420066607846833e-08, +1.74535941255271609e-10,
+      -1.79234405095485272e-12, +1.90662300762293535e-14, -9.47390314346800235e-16,
+      +4.14483262526725115e-16, -1.95399252334027567e-15, -1.00660220899347524e-15,
+      +5.80276567537415141e-15, +1.33226762955018785e-15, +1.03472785895064593e-14
+    },
+    // [38, 40]
+    {
+      +7.04452415098108009e+00, +9.04220318037726456e-02, -2.90808972292092959e-04,
+      +1.87474378385843457e-06, -1.51415453804778112e-08, +1.37282777738316015e-10,
+      -1.33558349565040166e-12, +1.59872115546022542e-14, -2.60532336445370050e-15,
+      +1.77635683940025046e-15, -1.01844458792281028e-14, +4.14483262526725115e-16,
+      +3.19744231092045092e-15, +7.40148683083437726e-16, +1.72898732368291031e-14
+    },
+    // [40, 42]
+    {
+      +7.22311020669519621e+00, +8.81816271830748177e-02, -2.69680340172110755e-04,
+      +1.65282264982617262e-06, -1.26881958569432147e-08, +1.09318657829741522e-10,
+      -1.01133916056520933e-12, +9.00020798629460193e-15, -3.67113746809385054e-15,
+      -7.10542735760100225e-16, -2.90138283768707571e-15, -3.07901852162710091e-15,
+      +5.74355378072747661e-15, +2.25005199657365048e-15, +1.34559030584568976e-14
+    },
+    // [42, 44]
+    {
+      +7.39737649387684471e+00, +8.61002267964211115e-02, -2.50996415486544767e-04,
+      +1.46607127469167145e-06, -1.07239700971225225e-08, +8.80177708495466478e-11,
+      -7.68096697356668261e-13, +5.21064672890740099e-15, +3.78956125738720094e-15,
+      -1.06581410364015024e-15, -8.34887714518117750e-15, -4.20404451991392615e-15,
+      +1.13094718775149272e-14, +2.66453525910037570e-15, +1.31450406115618525e-14
+    },
+    // [44, 46]
+    {
+      +7.56762271210763604e+00, +8.41598375179321012e-02, -2.34378066606192686e-04,
+      +1.30762396584790009e-06, -9.13459956564111119e-09, +7.15951150217127490e-11,
+      -6.00053340349404627e-13, +6.51330841113425144e-15, +3.78956125738720094e-15,
+      -3.43428988950715092e-15, -1.01252339845814280e-14, -7.10542735760100225e-16,
+      +5.44749430749410100e-15, +3.99680288865056355e-15, +3.00500365331875701e-15
+    }
+  };
+
+  /**
+   * coefficients of the sommerfeld expansion of F_{-1/2}, x>46
+   */
+  const Real mhalf_high[n_high] =
+  {
+    -4.11233516712056602e-01, -1.77568655530733555e+00, -2.91045556648773776e+01,
+    -1.05176520863560563e+03
+  };
+
+
+  /**
+   * sum c[k]*T_k(y), clenshaw recurrence
+   */
+  template <unsigned int N>
+  inline Real chebyshev(const Real * c, Real y)
+  {
+    Real b1 = 0.0, b2 = 0.0;
+    for(unsigned int k=N-1; k>0; --k)
+    {
+      Real b0 = 2.0*y*b1 - b2 + c[k];
+      b2 = b1;
+      b1 = b0;
+    }
+    return y*b1 - b2 + c[0];
+  }
+
+  /**
+   * F_j by the tables of order j, c_lead*x^(j+1) is the lead term of the sommerfeld expansion
+   */
+  template <bool positive_order>
+  inline Real fermi_dirac(const Real * low, const Real (*mid)[n_cheb], const Real * high, Real c_lead, Real x)
+  {
+    if( x < x_low )
+    {
+      Real t = exp(x);
+      return t*chebyshev<n_low>(low, 2.0*t/t_low - 1.0);
+    }
+
+    if( x < x_high )
+    {
+      unsigned int i = static_cast<unsigned int>(0.5*(x - x_low));
+      Real y = x - x_low - 2.0*i - 1.0;
+      return chebyshev<n_cheb>(mid[i], y);
+    }
+
+    Real r = 1.0/(x*x);
+    Real lead = positive_order ? c_lead*x*sqrt(x) : c_lead*sqrt(x);
+    return lead*(1.0 + r*(high[0] + r*(high[1] + r*(high[2] + r*high[3]))));
+  }
+
+  inline Real fermi_half(Real x)
+  {
+    // 1/Gamma(5/2)
+    return fermi_dirac<true>(half_low, half_mid, half_high, 0.75225277806367504925, x);
+  }
+
+  inline Real fermi_mhalf(Real x)
+  {
+    // 1/Gamma(3/2)
+    return fermi_dirac<false>(mhalf_low, mhalf_mid, mhalf_high, 1.12837916709551257390, x);
+  }
+}
+
+
+namespace FermiDirac
+{
+
+  Real half(Real x)
+  { return fermi_half(x); }
+
+
+  Real mhalf(Real x)
+  { return fermi_mhalf(x); }
+
+
+  void half(Real x, Real &f, Real &df)
+  {
+    f  = fermi_half(x);
+    df = fermi_mhalf(x);
+  }
+
+
+  void half(const Real *x, Real *f, Real *df, unsigned int n)
+  {
+    for(unsigned int i=0; i<n; ++i)
+      f[i] = fermi_half(x[i]);
+
+    if( df )
+      for(unsigned int i=0; i<n; ++i)
+        df[i] = fermi_mhalf(x[i]);
+  }
+
+}
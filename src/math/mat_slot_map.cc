@@ -0,0 +1,231 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+//  $Id: mat_slot_map.cc,v 1.1 2008/07/09 05:58:16 gdiso Exp $
+
+#include <algorithm>
+#include <cstring>
+
+#include "mat_slot_map.h"
+#include "petsc_macro.h"
+
+std::map<Mat, MatSlotMap *> MatSlotMap::_registry;
+unsigned int MatSlotMap::_stamp_counter = 0;
+
+
+MatSlotMap::MatSlotMap()
+  : _valid(false), _stamp(0), _row_begin(0), _row_end(0), _Ad(0), _Ao(0), _ad(0), _ao(0)
+{}
+
+
+void MatSlotMap::clear()
+{
+  genius_assert(!active());
+  _valid = false;
+  _row_ptr.clear();
+  _col.clear();
+  _pos.clear();
+  _Ad = _Ao = 0;
+}
+
+
+PetscErrorCode MatSlotMap::build(Mat A)
+{
+  PetscErrorCode ierr;
+
+  clear();
+
+  ierr = MatGetOwnershipRange(A, &_row_begin, &_row_end); genius_assert(!ierr);
+
+  // local block(s) of the matrix
+  MatType type;
+  ierr = MatGetType(A, &type); genius_assert(!ierr);
+
+  PetscInt *colmap = 0;
+  PetscInt  col_begin = 0;
+  if( !strcmp(type, MATMPIAIJ) )
+  {
+    ierr = MatMPIAIJGetSeqAIJ(A, &_Ad, &_Ao, &colmap); genius_assert(!ierr);
+    ierr = MatGetOwnershipRangeColumn(A, &col_begin, PETSC_NULL); genius_assert(!ierr);
+  }
+  else if( !strcmp(type, MATSEQAIJ) )
+  {
+    _Ad = A;
+    _Ao = 0;
+  }
+  else
+  {
+    // slot map only works with AIJ format
+    return 0;
+  }
+
+  const PetscInt n_rows = _row_end - _row_begin;
+
+  PetscInt  nd, no;
+  PetscInt *ia_d=0, *ja_d=0, *ia_o=0, *ja_o=0;
+  PetscBool done;
+  ierr = MatGetRowIJ(_Ad, 0, PETSC_FALSE, PETSC_FALSE, &nd, &ia_d, &ja_d, &done); genius_assert(!ierr);
+  if( !done ) return 0;
+  if( _Ao )
+  {
+    ierr = MatGetRowIJ(_Ao, 0, PETSC_FALSE, PETSC_FALSE, &no, &ia_o, &ja_o, &done); genius_assert(!ierr);
+    if( !done )
+    {
+      ierr = MatRestoreRowIJ(_Ad, 0, PETSC_FALSE, PETSC_FALSE, &nd, &ia_d, &ja_d, &done); genius_assert(!ierr);
+      return 0;
+    }
+  }
+  genius_assert(nd == n_rows);
+
+  _row_ptr.resize(n_rows+1);
+  _row_ptr[0] = 0;
+  for(PetscInt r=0; r<n_rows; ++r)
+  {
+    PetscInt nz = ia_d[r+1] - ia_d[r];
+    if( _Ao ) nz += ia_o[r+1] - ia_o[r];
+    _row_ptr[r+1] = _row_ptr[r] + nz;
+  }
+
+  _col.resize(_row_ptr[n_rows]);
+  _pos.resize(_row_ptr[n_rows]);
+
+  std::vector< std::pair<PetscInt, PetscInt> > row_entries;
+  for(PetscInt r=0; r<n_rows; ++r)
+  {
+    row_entries.clear();
+    for(PetscInt k=ia_d[r]; k<ia_d[r+1]; ++k)
+      row_entries.push_back( std::make_pair(ja_d[k] + col_begin, k) );
+    if( _Ao )
+      for(PetscInt k=ia_o[r]; k<ia_o[r+1]; ++k)
+        row_entries.push_back( std::make_pair(colmap[ja_o[k]], -(k+2)) );
+
+    std::sort(row_entries.begin(), row_entries.end());
+    for(unsigned int k=0; k<row_entries.size(); ++k)
+    {
+      _col[_row_ptr[r]+k] = row_entries[k].first;
+      _pos[_row_ptr[r]+k] = row_entries[k].second;
+    }
+  }
+
+  ierr = MatRestoreRowIJ(_Ad, 0, PETSC_FALSE, PETSC_FALSE, &nd, &ia_d, &ja_d, &done); genius_assert(!ierr);
+  if( _Ao )
+  {
+    ierr = MatRestoreRowIJ(_Ao, 0, PETSC_FALSE, PETSC_FALSE, &no, &ia_o, &ja_o, &done); genius_assert(!ierr);
+  }
+
+  _valid = true;
+  _stamp = ++_stamp_counter;
+
+  return 0;
+}
+
+
+PetscInt MatSlotMap::slot(PetscInt row, PetscInt col) const
+{
+  if( row < _row_begin || row >= _row_end ) return skip_slot;
+
+  const PetscInt r = row - _row_begin;
+  std::vector<PetscInt>::const_iterator b = _col.begin() + _row_ptr[r];
+  std::vector<PetscInt>::const_iterator e = _col.begin() + _row_ptr[r+1];
+  std::vector<PetscInt>::const_iterator it = std::lower_bound(b, e, col);
+  if( it == e || *it != col ) return invalid_slot;
+
+  return _pos[it - _col.begin()];
+}
+
+
+void MatSlotMap::row_slots(PetscInt row, std::vector<PetscInt> &slots) const
+{
+  genius_assert(_valid);
+  if( row < _row_begin || row >= _row_end ) return;
+
+  const PetscInt r = row - _row_begin;
+  slots.insert(slots.end(), _pos.begin() + _row_ptr[r], _pos.begin() + _row_ptr[r+1]);
+}
+
+
+bool MatSlotMap::locate(PetscInt m, const PetscInt rows[], PetscInt n, const PetscInt cols[], std::vector<PetscInt> &slots) const
+{
+  genius_assert(_valid);
+
+  slots.resize(m*n);
+  for(PetscInt i=0; i<m; ++i)
+    for(PetscInt j=0; j<n; ++j)
+    {
+      PetscInt s = rows[i] < 0 ? skip_slot : slot(rows[i], cols[j]);
+      if( s == invalid_slot ) return false;
+      slots[i*n+j] = s;
+    }
+  return true;
+}
+
+
+PetscErrorCode MatSlotMap::begin(Mat A)
+{
+  PetscErrorCode ierr;
+  genius_assert(_valid && !active());
+
+#if PETSC_VERSION_GE(3,4,0)
+  ierr = MatSeqAIJGetArray(_Ad, &_ad); genius_assert(!ierr);
+  if( _Ao ) { ierr = MatSeqAIJGetArray(_Ao, &_ao); genius_assert(!ierr); }
+#else
+  ierr = MatGetArray(_Ad, &_ad); genius_assert(!ierr);
+  if( _Ao ) { ierr = MatGetArray(_Ao, &_ao); genius_assert(!ierr); }
+#endif
+
+  return 0;
+}
+
+
+PetscErrorCode MatSlotMap::end(Mat A)
+{
+  PetscErrorCode ierr;
+  if( !active() ) return 0;
+
+#if PETSC_VERSION_GE(3,4,0)
+  ierr = MatSeqAIJRestoreArray(_Ad, &_ad); genius_assert(!ierr);
+  if( _Ao ) { ierr = MatSeqAIJRestoreArray(_Ao, &_ao); genius_assert(!ierr); }
+#else
+  ierr = MatRestoreArray(_Ad, &_ad); genius_assert(!ierr);
+  if( _Ao ) { ierr = MatRestoreArray(_Ao, &_ao); genius_assert(!ierr); }
+#endif
+  _ad = _ao = 0;
+
+  // NOTE: the state of A is increased by the following assembly of A
+
+  return 0;
+}
+
+
+void MatSlotMap::attach(Mat A, MatSlotMap *map)
+{ _registry[A] = map; }
+
+
+void MatSlotMap::detach(Mat A)
+{ _registry.erase(A); }
+
+
+MatSlotMap * MatSlotMap::get(Mat A)
+{
+  std::map<Mat, MatSlotMap *>::const_iterator it = _registry.find(A);
+  if( it == _registry.end() ) return 0;
+  return it->second;
+}
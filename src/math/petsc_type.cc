@@ -92,6 +92,7 @@ namespace SolverSpecify
       LinearSolverName_to_LinearSolverType["mumps"       ]  = MUMPS;
       LinearSolverName_to_LinearSolverType["superlu_dist"]  = SuperLU_DIST;
       LinearSolverName_to_LinearSolverType["gss"         ]  = GSS;
+      LinearSolverName_to_LinearSolverType["auto"        ]  = AUTO_LINEAR_SOLVER;
     }
 
   }
@@ -123,6 +124,9 @@ namespace SolverSpecify
       PreconditionerName_to_PreconditionerType["ilut"        ]  = ILUT_PRECOND;
       PreconditionerName_to_PreconditionerType["lu"          ]  = LU_PRECOND;
       PreconditionerName_to_PreconditionerType["parms"       ]  = PARMS_PRECOND;
+      PreconditionerName_to_PreconditionerType["fieldsplit"  ]  = FIELDSPLIT_PRECOND;
+      PreconditionerName_to_PreconditionerType["bordered"    ]  = BORDERED_PRECOND;
+      PreconditionerName_to_PreconditionerType["mg"          ]  = MG_PRECOND;
     }
 
   }
@@ -23,9 +23,36 @@
 
 #include <map>
 #include <vector>
+#include <algorithm>
+#include <cstring>
 
 
 #include "petsc_utils.h"
+#include "petsc_macro.h"
+#include "parallel.h"
+#include "dense_matrix_fixed.h"
+#include "first_touch.h"
+
+
+/**
+ * add complex matrix with N/2 rows to petsc Mat, the real form is built on the stack
+ */
+template <unsigned int N>
+static void mat_add_complex_fixed(Mat mat, const DenseMatrix<Complex> &complex_mat, const std::vector<PetscInt> & dof_indices)
+{
+  DenseMatrixFixed<Real, N> real_mat;
+  for(unsigned int m=0; m<N/2; ++m)
+  {
+    for(unsigned int n=0; n<N/2; ++n)
+    {
+      real_mat(2*m,  2*n)   =   complex_mat.el(m,n).real();
+      real_mat(2*m,  2*n+1) = - complex_mat.el(m,n).imag();
+      real_mat(2*m+1,2*n)   =   complex_mat.el(m,n).imag();
+      real_mat(2*m+1,2*n+1) =   complex_mat.el(m,n).real();
+    }
+  }
+  MatSetValues(mat, N, &dof_indices[0], N, &dof_indices[0], real_mat.get_values(), ADD_VALUES);
+}
 
 
 namespace PetscUtils
@@ -196,6 +223,18 @@ namespace PetscUtils
   }
 
 
+  /*-------------------------------------------------------------------
+   * @brief collect the clear rows of all the processors
+   */
+  void GlobalClearRows(const std::vector<PetscInt> & clear_rows, std::vector<PetscInt> & all_clear_rows)
+  {
+    all_clear_rows = clear_rows;
+    Parallel::allgather(all_clear_rows);
+    std::sort(all_clear_rows.begin(), all_clear_rows.end());
+    all_clear_rows.erase(std::unique(all_clear_rows.begin(), all_clear_rows.end()), all_clear_rows.end());
+  }
+
+
  /*-------------------------------------------------------------------
   * @brief add source rows to destination rows, and clear some rows
   *
@@ -203,43 +242,58 @@ namespace PetscUtils
   * @param  src_rows   source rows
   * @param  dst_rows   the destination rows will be added to
   * @param  clear_rows the rows to be cleared .
+  * @param  all_clear_rows the clear rows of all the processors, by GlobalClearRows
   *
-  * @note   If vec is not assembled, this function will do it for you. the src row should on local processor.
+  * @note   vec should be assembled, the src and clear rows should on local processor.
+  *         only ADD_VALUES is used and vec is NOT assembled on return.
   *
    */
-  PetscErrorCode  VecAddClearRow(Vec vec, std::vector<PetscInt> & src_rows, std::vector<PetscInt> & dst_rows, std::vector<PetscInt> & clear_rows)
+  PetscErrorCode  VecAddClearRow(Vec vec, std::vector<PetscInt> & src_rows, std::vector<PetscInt> & dst_rows, std::vector<PetscInt> & clear_rows,
+                                 const std::vector<PetscInt> & all_clear_rows)
   {
-    // we assembly vec for any case!
-    VecAssemblyBegin(vec);
-    VecAssemblyEnd(vec);
-
     genius_assert(src_rows.size() == dst_rows.size());
+
+    // destination rows cleared on any processor get nothing
+
+    std::vector<PetscInt>    rows;
+    std::vector<PetscScalar> y;
+
+    // get source value from vec, they are added to destination rows
     if( src_rows.size() )
     {
-      // get source value from vec
-      std::vector<PetscScalar> y(src_rows.size());
-      VecGetValues(vec, src_rows.size(), &src_rows[0], &y[0]);
-      // add value to vec destination
-      VecSetValues(vec, dst_rows.size(), &dst_rows[0], &y[0], ADD_VALUES);
+      std::vector<PetscScalar> src_y(src_rows.size());
+      VecGetValues(vec, src_rows.size(), &src_rows[0], &src_y[0]);
+      for(unsigned int n=0; n<dst_rows.size(); ++n)
+      {
+        if( std::binary_search(all_clear_rows.begin(), all_clear_rows.end(), dst_rows[n]) ) continue;
+        rows.push_back(dst_rows[n]);
+        y.push_back(src_y[n]);
+      }
     }
 
-    // we assembly vec for INSERT_VALUES!
-    VecAssemblyBegin(vec);
-    VecAssemblyEnd(vec);
-
-    if( clear_rows.size() )
+    // clear rows by adding the negative of their value, so INSERT_VALUES is not required
+    // a row may be cleared by several bcs, only count it once
+    std::vector<PetscInt> local_clear_rows(clear_rows);
+    std::sort(local_clear_rows.begin(), local_clear_rows.end());
+    local_clear_rows.erase(std::unique(local_clear_rows.begin(), local_clear_rows.end()), local_clear_rows.end());
+    if( local_clear_rows.size() )
     {
-      std::vector<PetscScalar> y(clear_rows.size(), 0.0);
-      VecSetValues(vec, clear_rows.size(), &clear_rows[0], &y[0], INSERT_VALUES);
+      std::vector<PetscScalar> clear_y(local_clear_rows.size());
+      VecGetValues(vec, local_clear_rows.size(), &local_clear_rows[0], &clear_y[0]);
+      for(unsigned int n=0; n<local_clear_rows.size(); ++n)
+      {
+        rows.push_back(local_clear_rows[n]);
+        y.push_back(-clear_y[n]);
+      }
     }
 
-    // we assembly vec for any case!
-    VecAssemblyBegin(vec);
-    VecAssemblyEnd(vec);
+    if( rows.size() )
+      VecSetValues(vec, rows.size(), &rows[0], &y[0], ADD_VALUES);
 
     return 0;
   }
 
+
   /*-------------------------------------------------------------------
    * @brief add source rows to destination rows, multi by alpha
    *
@@ -536,6 +590,66 @@ namespace PetscUtils
 
 
 
+  /*-------------------------------------------------------------------
+   * @brief add source rows to destination rows, and clear some rows
+   *
+   * @param  mat        Petsc Matrix
+   * @param  src_rows   source rows
+   * @param  dst_rows   the destination rows will be added to
+   * @param  clear_rows the rows to be cleared
+   * @param  all_clear_rows the clear rows of all the processors, by GlobalClearRows
+   *
+   * @note   mat should be assembled, the src row should on local processor.
+   *         the source rows are buffered before the rows are cleared, and the buffer is added to
+   *         destination rows (except those cleared) with ADD_VALUES. mat is NOT assembled on return,
+   *         so the following ADD_VALUES operators and this one only need one final assembly.
+   */
+  PetscErrorCode  MatAddClearRow(Mat mat, std::vector<PetscInt> & src_rows, std::vector<PetscInt> & dst_rows, std::vector<PetscInt> & clear_rows,
+                                 const std::vector<PetscInt> & all_clear_rows)
+  {
+    genius_assert(src_rows.size() == dst_rows.size());
+
+    std::multimap< PetscInt, std::pair<std::vector<PetscInt>, std::vector<PetscScalar> > > row_add_to_buffer;
+
+    // read the row
+    for(unsigned int nrow=0; nrow<src_rows.size(); nrow++)
+    {
+      if( std::binary_search(all_clear_rows.begin(), all_clear_rows.end(), dst_rows[nrow]) ) continue;
+
+      PetscInt ncols;
+      const PetscInt * row_cols_pointer;
+      const PetscScalar * row_vals_pointer;
+
+      MatGetRow(mat, src_rows[nrow], &ncols, &row_cols_pointer, &row_vals_pointer);
+
+      // save the values
+      std::vector<PetscInt>    row_cols(row_cols_pointer, row_cols_pointer+ncols);
+      std::vector<PetscScalar> row_vals(row_vals_pointer, row_vals_pointer+ncols);
+
+      row_add_to_buffer.insert(std::pair< PetscInt, std::pair<std::vector<PetscInt>, std::vector<PetscScalar> > >
+                               (dst_rows[nrow], std::pair<std::vector<PetscInt>, std::vector<PetscScalar> >(row_cols, row_vals)));
+
+      // restore pointers
+      MatRestoreRow(mat, src_rows[nrow], &ncols, &row_cols_pointer, &row_vals_pointer);
+    }
+
+    // clear rows, the matrix is still assembled here
+    PetscUtils::MatZeroRows(mat, clear_rows.size(), clear_rows.empty() ? NULL : &clear_rows[0], 0.0);
+
+    //ok, we add rows to destination
+    std::multimap< PetscInt, std::pair<std::vector<PetscInt>, std::vector<PetscScalar> > >::iterator row_add_it =  row_add_to_buffer.begin();
+    for(; row_add_it !=  row_add_to_buffer.end(); ++row_add_it)
+    {
+      if( (*row_add_it).second.first.empty() ) continue;
+      MatSetValues(mat, 1, &((*row_add_it).first) ,
+                   (*row_add_it).second.first.size(), &((*row_add_it).second.first[0]) ,
+                   &((*row_add_it).second.second[0]), ADD_VALUES);
+    }
+
+    return 0;
+  }
+
+
   /*-------------------------------------------------------------------
    * @brief add real DenseVector to PetscVec by dof_indices
    *
@@ -608,6 +722,14 @@ namespace PetscUtils
     genius_assert(complex_mat.m()*2==dof_indices.size());
     genius_assert(complex_mat.n()*2==dof_indices.size());
 
+    // the element matrix of tri3, quad4 and tet4
+    switch(complex_mat.m())
+    {
+      case 3: mat_add_complex_fixed<6>(mat, complex_mat, dof_indices);  return 0;
+      case 4: mat_add_complex_fixed<8>(mat, complex_mat, dof_indices);  return 0;
+      default: break;
+    }
+
     //convert complex indices to real indices?
     DenseMatrix<Real> real_mat(complex_mat.m()*2, complex_mat.n()*2);
     for(unsigned int m=0; m<complex_mat.m(); ++m)
@@ -625,5 +747,72 @@ namespace PetscUtils
     return 0;
   }
 
-}
 
+
+  PetscErrorCode  VecFirstTouch(Vec vec)
+  {
+    PetscErrorCode ierr;
+
+    VecType type;
+    ierr = VecGetType(vec, &type); genius_assert(!ierr);
+    if( strcmp(type, VECSEQ) && strcmp(type, VECMPI) ) return 0;
+
+    PetscInt n;
+    ierr = VecGetLocalSize(vec, &n); genius_assert(!ierr);
+    if( !n ) return 0;
+
+    // the vector takes the new array, and frees it by PetscFree
+    PetscScalar * array;
+    ierr = PetscMalloc(n*sizeof(PetscScalar), &array); genius_assert(!ierr);
+    first_touch(array, n*sizeof(PetscScalar));
+    ierr = VecReplaceArray(vec, array); genius_assert(!ierr);
+
+    return 0;
+  }
+
+
+
+  PetscErrorCode  MatFirstTouch(Mat mat)
+  {
+    PetscErrorCode ierr;
+
+    MatType type;
+    ierr = MatGetType(mat, &type); genius_assert(!ierr);
+
+    // the diagonal and off-diagonal block of MPIAIJ matrix, or the SeqAIJ matrix itself
+    Mat blocks[2] = {0, 0};
+    if( !strcmp(type, MATMPIAIJ) )
+    {
+      PetscInt *colmap;
+      ierr = MatMPIAIJGetSeqAIJ(mat, &blocks[0], &blocks[1], &colmap); genius_assert(!ierr);
+    }
+    else if( !strcmp(type, MATSEQAIJ) )
+      blocks[0] = mat;
+    else
+      return 0;
+
+    for(unsigned int b=0; b<2; ++b)
+    {
+      if( !blocks[b] ) continue;
+
+      MatInfo info;
+      ierr = MatGetInfo(blocks[b], MAT_LOCAL, &info); genius_assert(!ierr);
+      const size_t n = static_cast<size_t>(info.nz_allocated);
+      if( !n ) continue;
+
+      PetscScalar * array;
+#if PETSC_VERSION_GE(3,4,0)
+      ierr = MatSeqAIJGetArray(blocks[b], &array); genius_assert(!ierr);
+      first_touch(array, n*sizeof(PetscScalar));
+      ierr = MatSeqAIJRestoreArray(blocks[b], &array); genius_assert(!ierr);
+#else
+      ierr = MatGetArray(blocks[b], &array); genius_assert(!ierr);
+      first_touch(array, n*sizeof(PetscScalar));
+      ierr = MatRestoreArray(blocks[b], &array); genius_assert(!ierr);
+#endif
+    }
+
+    return 0;
+  }
+
+}
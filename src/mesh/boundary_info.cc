@@ -20,6 +20,7 @@
 
 
 // C++ includes
+#include <algorithm>
 
 
 // Local includes
@@ -46,7 +47,7 @@ const short int BoundaryInfo::invalid_id = -1234;
 //------------------------------------------------------
 // BoundaryInfo functions
 BoundaryInfo::BoundaryInfo(const MeshBase& m) :
-    _mesh (m)
+    _mesh (m), _index_valid(false)
 {}
 
 
@@ -63,6 +64,7 @@ void BoundaryInfo::clear()
   _boundary_node_id.clear();
   _boundary_side_id.clear();
   _boundary_ids.clear();
+  _index_valid = false;
   _boundary_labels_to_ids.clear();
   _boundary_ids_to_labels.clear();
   _boundary_ids_to_descriptions.clear();
@@ -225,6 +227,7 @@ void BoundaryInfo::add_node(const Node* node, const short int id)
 
   _boundary_node_id[node] = id;
   _boundary_ids.insert(id);
+  _index_valid = false;
 }
 
 
@@ -273,6 +276,7 @@ void BoundaryInfo::add_side(const Elem* elem,
 
   _boundary_side_id.insert(kv);
   _boundary_ids.insert(id);
+  _index_valid = false;
 
   // Possilby add the nodes of the side,
   // no matter they are already there.
@@ -318,9 +322,89 @@ void BoundaryInfo::boundary_side_nodes_with_id ( std::map<short int, std::set<co
 
 
 
+void BoundaryInfo::build_index() const
+{
+  // count the entries of each boundary id, the std::map gives sorted ids
+  std::map<short int, unsigned int> side_count;
+  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator side_it = _boundary_side_id.begin();
+  for(; side_it != _boundary_side_id.end(); ++side_it)
+    side_count[side_it->second.second]++;
+
+  std::map<short int, unsigned int> node_count;
+  std::map<const Node*, short int>::const_iterator node_it = _boundary_node_id.begin();
+  for(; node_it != _boundary_node_id.end(); ++node_it)
+    node_count[node_it->second]++;
+
+  _side_index_ids.clear();
+  _side_index_begin.assign(1, 0);
+  for(std::map<short int, unsigned int>::const_iterator it=side_count.begin(); it!=side_count.end(); ++it)
+  {
+    _side_index_ids.push_back(it->first);
+    _side_index_begin.push_back(_side_index_begin.back() + it->second);
+  }
+
+  _node_index_ids.clear();
+  _node_index_begin.assign(1, 0);
+  for(std::map<short int, unsigned int>::const_iterator it=node_count.begin(); it!=node_count.end(); ++it)
+  {
+    _node_index_ids.push_back(it->first);
+    _node_index_begin.push_back(_node_index_begin.back() + it->second);
+  }
+
+  // fill the entries, they keep the order of _boundary_side_id and _boundary_node_id
+  _side_index.resize(_boundary_side_id.size());
+  std::vector<unsigned int> side_pos(_side_index_begin.begin(), _side_index_begin.end()-1);
+  for(side_it = _boundary_side_id.begin(); side_it != _boundary_side_id.end(); ++side_it)
+  {
+    unsigned int n = std::lower_bound(_side_index_ids.begin(), _side_index_ids.end(), side_it->second.second) - _side_index_ids.begin();
+    _side_index[side_pos[n]++] = std::make_pair(side_it->first, side_it->second.first);
+  }
+
+  _node_index.resize(_boundary_node_id.size());
+  std::vector<unsigned int> node_pos(_node_index_begin.begin(), _node_index_begin.end()-1);
+  for(node_it = _boundary_node_id.begin(); node_it != _boundary_node_id.end(); ++node_it)
+  {
+    unsigned int n = std::lower_bound(_node_index_ids.begin(), _node_index_ids.end(), node_it->second) - _node_index_ids.begin();
+    _node_index[node_pos[n]++] = node_it->first;
+  }
+
+  _index_valid = true;
+}
+
+
+
+std::pair<BoundaryInfo::side_iterator, BoundaryInfo::side_iterator> BoundaryInfo::boundary_sides(short int boundary_id) const
+{
+  if( !_index_valid ) build_index();
+
+  std::vector<short int>::const_iterator it = std::lower_bound(_side_index_ids.begin(), _side_index_ids.end(), boundary_id);
+  if( it == _side_index_ids.end() || *it != boundary_id )
+    return std::make_pair(_side_index.end(), _side_index.end());
+
+  unsigned int n = it - _side_index_ids.begin();
+  return std::make_pair(_side_index.begin() + _side_index_begin[n], _side_index.begin() + _side_index_begin[n+1]);
+}
+
+
+
+std::pair<BoundaryInfo::node_iterator, BoundaryInfo::node_iterator> BoundaryInfo::boundary_nodes(short int boundary_id) const
+{
+  if( !_index_valid ) build_index();
+
+  std::vector<short int>::const_iterator it = std::lower_bound(_node_index_ids.begin(), _node_index_ids.end(), boundary_id);
+  if( it == _node_index_ids.end() || *it != boundary_id )
+    return std::make_pair(_node_index.end(), _node_index.end());
+
+  unsigned int n = it - _node_index_ids.begin();
+  return std::make_pair(_node_index.begin() + _node_index_begin[n], _node_index.begin() + _node_index_begin[n+1]);
+}
+
+
+
 void BoundaryInfo::build_node_ids_from_priority_order(const std::map<short int, unsigned int> & order)
 {
   _boundary_node_id.clear();
+  _index_valid = false;
 
   std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
 
@@ -378,6 +462,7 @@ void BoundaryInfo::remove (const Node* node)
 
   // Erase everything associated with node
   _boundary_node_id.erase (node);
+  _index_valid = false;
 
   // for efficency reason, we don't do it here.
   // please call rebuild_ids() after all the remove operator
@@ -394,6 +479,7 @@ void BoundaryInfo::remove (const Elem* elem)
 
   // Erase everything associated with elem
   _boundary_side_id.erase (elem);
+  _index_valid = false;
 
 
   // for efficency reason, we don't do it here.
@@ -426,6 +512,7 @@ void BoundaryInfo::remove (const Elem* elem, unsigned short int side)
   // erase here
   for(size_t n=0; n<its.size(); n++)
     _boundary_side_id.erase (its[n]);
+  _index_valid = false;
 
 
   // for efficency reason, we don't do it here.
@@ -662,18 +749,13 @@ void BoundaryInfo::build_on_processor_side_list (std::vector<unsigned int>&
 void BoundaryInfo::nodes_with_boundary_id (std::vector<unsigned int>& nl, short int boundary_id) const
 {
   nl.clear();
-  // use set to reorder the nodes by their id
-  std::set<unsigned int> bd_node_set;
 
-  std::map<const Node*, short int>::const_iterator pos = _boundary_node_id.begin();
-  for (; pos != _boundary_node_id.end(); ++pos)
-  {
-    if( pos->second==boundary_id )
-      bd_node_set.insert(pos->first->id());
-  }
+  std::pair<node_iterator, node_iterator> range = boundary_nodes(boundary_id);
+  for (; range.first != range.second; ++range.first)
+    nl.push_back((*range.first)->id());
 
-  for(std::set<unsigned int>::iterator it=bd_node_set.begin(); it!=bd_node_set.end(); ++it)
-      nl.push_back(*it);
+  // reorder the nodes by their id
+  std::sort(nl.begin(), nl.end());
 }
 
 
@@ -681,18 +763,17 @@ void BoundaryInfo::nodes_with_boundary_id (std::vector<unsigned int>& nl, short
 void BoundaryInfo::nodes_with_boundary_id (std::vector<const Node *>& nl, short int boundary_id) const
 {
   nl.clear();
-  // use map to reorder the nodes by their id
-  std::map<unsigned int, const Node *> bd_node_map;
 
-  std::map<const Node*, short int>::const_iterator pos = _boundary_node_id.begin();
-  for (; pos != _boundary_node_id.end(); ++pos)
-  {
-    if( pos->second==boundary_id )
-      bd_node_map[pos->first->id()] = pos->first;
-  }
+  // reorder the nodes by their id
+  std::vector< std::pair<unsigned int, const Node *> > bd_nodes;
+  std::pair<node_iterator, node_iterator> range = boundary_nodes(boundary_id);
+  for (; range.first != range.second; ++range.first)
+    bd_nodes.push_back(std::make_pair((*range.first)->id(), *range.first));
+  std::sort(bd_nodes.begin(), bd_nodes.end());
 
-  for(std::map<unsigned int, const Node *>::iterator it=bd_node_map.begin(); it!=bd_node_map.end(); ++it)
-    nl.push_back((*it).second);
+  nl.reserve(bd_nodes.size());
+  for(unsigned int n=0; n<bd_nodes.size(); ++n)
+    nl.push_back(bd_nodes[n].second);
 }
 
 void BoundaryInfo::nodes_with_boundary_id ( std::map<short int, std::vector<const Node *> > & node_boundary_id_map) const
@@ -744,35 +825,27 @@ void BoundaryInfo::active_elem_with_boundary_id (std::vector<const Elem *>& el,
   el.clear();
   sl.clear();
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-
-  for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end();
-       ++pos)
+  std::pair<side_iterator, side_iterator> range = boundary_sides(boundary_id);
+  for (; range.first != range.second; ++range.first)
   {
-    const Elem * elem = pos->first;
+    const Elem * elem = range.first->first;
+    unsigned short int side = range.first->second;
     if (elem->active() )
     {
-      if( pos->second.second == boundary_id )
-      {
-        el.push_back (pos->first);
-        sl.push_back (pos->second.first);
-      }
+      el.push_back (elem);
+      sl.push_back (side);
     }
     // this element has child
     else
     {
-      unsigned short int side = pos->second.first;
       std::vector<const Elem*> family;
 
       elem->active_family_tree_by_side(family, side);
 
       for(unsigned int n=0; n<family.size(); ++n)
       {
-        if( pos->second.second == boundary_id )
-        {
-          el.push_back (family[n]);
-          sl.push_back (side);
-        }
+        el.push_back (family[n]);
+        sl.push_back (side);
       }
 
     }
@@ -814,22 +887,17 @@ void BoundaryInfo::active_elem_with_boundary_id (
 void BoundaryInfo::get_subdomains_bd_on(short int boundary_id, unsigned int & sub_id1, unsigned int & sub_id2) const
 {
 
-  std::multimap<const Elem*, std::pair<unsigned short int, short int> >::const_iterator pos;
-
   std::set< unsigned int > sub_ids;
 
-
-  for (pos=_boundary_side_id.begin(); pos != _boundary_side_id.end(); ++pos)
+  // only process element with this boundary_id
+  std::pair<side_iterator, side_iterator> range = boundary_sides(boundary_id);
+  for (; range.first != range.second; ++range.first)
   {
-    // if not match required  boundary_id, continue
-    if( pos->second.second != boundary_id ) continue;
-
-    // only process element with this boundary_id
-    const Elem * elem = pos->first;
+    const Elem * elem = range.first->first;
     sub_ids.insert( elem->subdomain_id() );
 
     // get the side
-    unsigned int side = pos->second.first;
+    unsigned int side = range.first->second;
 
     const Elem * neighbor_elem = elem->neighbor(side);
 
@@ -0,0 +1,190 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <fstream>
+
+#ifndef CYGWIN
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+#include "fvm_geometry_cache.h"
+#include "elem.h"
+#include "genius_env.h"
+
+
+namespace
+{
+  const char magic[8] = {'G','F','V','M','G','E','O','\0'};
+
+  struct CacheHeader
+  {
+    char               magic[8];
+    unsigned int       version;
+    unsigned int       n_elem;
+    unsigned long long hash;
+    unsigned long long n_values;
+  };
+
+  // 64-bit FNV-1a
+  inline void hash_bytes(unsigned long long &h, const void * p, size_t n)
+  {
+    const unsigned char * c = static_cast<const unsigned char *>(p);
+    for(size_t i=0; i<n; ++i)
+    {
+      h ^= c[i];
+      h *= 1099511628211ULL;
+    }
+  }
+
+  unsigned long long n_values(const std::vector<Elem *> &elems)
+  {
+    unsigned long long n = 0;
+    for(unsigned int e=0; e<elems.size(); ++e)
+      n += elems[e]->n_fvm_geometry();
+    return n;
+  }
+
+  // check the header and unpack the values
+  bool unpack(const char * buffer, size_t size, const std::vector<Elem *> &elems)
+  {
+    if( size < sizeof(CacheHeader) ) return false;
+
+    CacheHeader header;
+    memcpy(&header, buffer, sizeof(CacheHeader));
+    if( memcmp(header.magic, magic, sizeof(magic)) ) return false;
+    if( header.version != FVMGeometryCache::version ) return false;
+    if( header.n_elem != elems.size() ) return false;
+    if( header.n_values != n_values(elems) ) return false;
+    if( size != sizeof(CacheHeader) + header.n_values*sizeof(Real) ) return false;
+    if( header.hash != FVMGeometryCache::mesh_hash(elems) ) return false;
+
+    const Real * data = reinterpret_cast<const Real *>(buffer + sizeof(CacheHeader));
+    for(unsigned int e=0; e<elems.size(); ++e)
+    {
+      elems[e]->unpack_fvm_geometry(data);
+      data += elems[e]->n_fvm_geometry();
+    }
+    return true;
+  }
+}
+
+
+std::string FVMGeometryCache::file_name(const std::string &prefix)
+{
+  std::stringstream ss;
+  ss << prefix << "." << Genius::n_processors() << "." << Genius::processor_id() << ".fvmgeo";
+  return ss.str();
+}
+
+
+unsigned long long FVMGeometryCache::mesh_hash(const std::vector<Elem *> &elems)
+{
+  unsigned long long h = 14695981039346656037ULL;
+  for(unsigned int e=0; e<elems.size(); ++e)
+  {
+    const Elem * elem = elems[e];
+    const unsigned int id = elem->id();
+    const int type = elem->type();
+    hash_bytes(h, &id, sizeof(id));
+    hash_bytes(h, &type, sizeof(type));
+    for(unsigned int n=0; n<elem->n_nodes(); ++n)
+    {
+      const Node * node = elem->get_node(n);
+      const unsigned int node_id = node->id();
+      hash_bytes(h, &node_id, sizeof(node_id));
+      for(unsigned int i=0; i<3; ++i)
+      {
+        const Real x = (*node)(i);
+        hash_bytes(h, &x, sizeof(x));
+      }
+    }
+  }
+  return h;
+}
+
+
+bool FVMGeometryCache::load(const std::string &file, const std::vector<Elem *> &elems)
+{
+#ifndef CYGWIN
+  // map the file into memory and unpack the values from the mapped pages directly
+  int fd = open(file.c_str(), O_RDONLY);
+  if( fd < 0 ) return false;
+
+  struct stat st;
+  if( fstat(fd, &st) || st.st_size <= 0 )
+  {
+    close(fd);
+    return false;
+  }
+
+  void * buffer = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if( buffer == MAP_FAILED ) return false;
+
+  bool ok = unpack(static_cast<const char *>(buffer), st.st_size, elems);
+  munmap(buffer, st.st_size);
+  return ok;
+#else
+  std::ifstream in(file.c_str(), std::ios::binary);
+  if( !in.good() ) return false;
+  std::vector<char> buffer( (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>() );
+  if( buffer.empty() ) return false;
+  return unpack(&buffer[0], buffer.size(), elems);
+#endif
+}
+
+
+bool FVMGeometryCache::save(const std::string &file, const std::vector<Elem *> &elems)
+{
+  CacheHeader header;
+  memcpy(header.magic, magic, sizeof(magic));
+  header.version  = version;
+  header.n_elem   = elems.size();
+  header.hash     = mesh_hash(elems);
+  header.n_values = n_values(elems);
+
+  std::vector<Real> values(header.n_values);
+  Real * data = values.empty() ? 0 : &values[0];
+  for(unsigned int e=0; e<elems.size(); ++e)
+  {
+    elems[e]->pack_fvm_geometry(data);
+    data += elems[e]->n_fvm_geometry();
+  }
+
+  // write to a temporary file first, so a concurrent run never sees a partial cache
+  const std::string tmp_file = file + ".tmp";
+  std::ofstream out(tmp_file.c_str(), std::ios::binary);
+  if( !out.good() ) return false;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(CacheHeader));
+  if( !values.empty() )
+    out.write(reinterpret_cast<const char *>(&values[0]), values.size()*sizeof(Real));
+  out.close();
+  if( !out.good() ) return false;
+
+  return std::rename(tmp_file.c_str(), file.c_str()) == 0;
+}
@@ -30,6 +30,7 @@
 // Local includes
 #include "mesh_base.h"
 #include "metis_partitioner.h" // for default partitioning
+#include "parmetis_partitioner.h"
 #include "elem.h"
 #include "boundary_info.h"
 #include "point_locator_base.h"
@@ -42,9 +43,12 @@ MeshBase::MeshBase (unsigned int d) :
     boundary_info   (new BoundaryInfo(*this)),
     _magic_num      (invalid_uint),
     _n_sbd          (1),
+    _boundary_weight(0),
+    _interface_weight(1),
     _n_parts        (1),
     _dim            (d),
     _is_prepared    (false),
+    _reorder_type   (REORDER_RCM),
     _point_locator  (NULL),
     _surface_locator(NULL)
 {
@@ -58,9 +62,13 @@ MeshBase::MeshBase (const MeshBase& other_mesh) :
     boundary_info   (new BoundaryInfo(*this)), // no copy constructor defined for BoundaryInfo?
     _magic_num      (other_mesh._magic_num),
     _n_sbd          (other_mesh._n_sbd),
+    _subdomain_weight(other_mesh._subdomain_weight),
+    _boundary_weight(other_mesh._boundary_weight),
+    _interface_weight(other_mesh._interface_weight),
     _n_parts        (other_mesh._n_parts),
     _dim            (other_mesh._dim),
     _is_prepared    (other_mesh._is_prepared),
+    _reorder_type   (other_mesh._reorder_type),
     _point_locator  (NULL),
     _surface_locator(NULL)
 
@@ -75,7 +83,7 @@ MeshBase::~MeshBase()
 
 
 
-void MeshBase::prepare_for_use (const bool skip_renumber_nodes_and_elements)
+void MeshBase::prepare_for_use (const bool skip_renumber_nodes_and_elements, const bool elements_added_only)
 {
   // Renumber the nodes and elements so that they in contiguous
   // blocks.  By default, skip_renumber_nodes_and_elements is false,
@@ -92,16 +100,27 @@ void MeshBase::prepare_for_use (const bool skip_renumber_nodes_and_elements)
   // Let all the elements find their neighbors
   this->find_neighbors();
 
-  // Reorder the node index by Reverse Cuthill-McKee Algorithm
-  if(!skip_renumber_nodes_and_elements)
+  // Reorder the node (and element) index for solver efficiency
+  if(!skip_renumber_nodes_and_elements && _reorder_type != REORDER_NONE)
     this->reorder_nodes();
 
-  // Partition the mesh.
-  this->partition();
+  // Partition the mesh. we may be called on processor 0 only (i.e. by mesh refinement),
+  // so the serial partitioner is used here. when the mesh has been partitioned before,
+  // the refined elements keep the processor id of their parent, repartition them
+  {
+    MetisPartitioner partitioner;
+    if( _n_parts > 1 )
+      partitioner.repartition (*this);
+    else
+      partitioner.partition (*this);
+  }
 
   // Reset our PointLocator.  This needs to happen any time the elements
   // in the underlying elements in the mesh have changed, so we do it here.
-  this->clear_point_locator();
+  // when elements have only been added, the tree of the point locator can be
+  // updated in place, which is much cheaper than a rebuild.
+  if( !(elements_added_only && _point_locator.get() && _point_locator->update()) )
+    this->clear_point_locator();
   this->clear_surface_locator();
 
   // The mesh is now prepared for use.
@@ -274,12 +293,81 @@ std::ostream& operator << (std::ostream& os, const MeshBase& m)
 
 void MeshBase::partition (const unsigned int n_parts)
 {
+  // the parallel partitioner only builds part of the graph on each processor
+  if( ParmetisPartitioner::available() && Genius::n_processors() > 1 )
+  {
+    ParmetisPartitioner partitioner;
+    partitioner.partition (*this, n_parts);
+    return;
+  }
+
   MetisPartitioner partitioner;
   partitioner.partition (*this, n_parts);
 }
 
 
 
+void MeshBase::repartition (const unsigned int n_parts)
+{
+  if( ParmetisPartitioner::available() && Genius::n_processors() > 1 )
+  {
+    ParmetisPartitioner partitioner;
+    partitioner.repartition (*this, n_parts);
+    return;
+  }
+
+  MetisPartitioner partitioner;
+  partitioner.repartition (*this, n_parts);
+}
+
+
+
+int MeshBase::partition_bc_weight(const Elem * elem) const
+{
+  int weight = 0;
+
+  // boundary conditions are set on the sides of top level elements
+  if( _boundary_weight && this->boundary_info->is_boundary_elem(elem->top_parent()) )
+  {
+    for (unsigned int s=0; s<elem->n_sides(); ++s)
+      if (this->boundary_info->boundary_id (elem, s) != BoundaryInfo::invalid_id)
+        weight += _boundary_weight;
+  }
+
+  return weight;
+}
+
+
+
+int MeshBase::partition_edge_weight(const Elem * elem, const Elem * neighbor) const
+{
+  if( _interface_weight <= 1 ) return 1;
+
+  // region interface
+  if( elem->subdomain_id() != neighbor->subdomain_id() ) return _interface_weight;
+
+  // labeled face inside a region, i.e. an electrode. test it from both sides since
+  // the label may be set on either elem; the neighbor can be finer than elem after refinement
+  const Elem * pair[2][2] = { {elem, neighbor}, {neighbor, elem} };
+  for (unsigned int p=0; p<2; ++p)
+  {
+    const Elem * e = pair[p][0];
+    const Elem * n = pair[p][1];
+    if( !this->boundary_info->is_boundary_elem(e->top_parent()) ) continue;
+    for (unsigned int s=0; s<e->n_sides(); ++s)
+    {
+      const Elem * en = e->neighbor(s);
+      if( en == NULL || (en != n && !en->is_ancestor_of(n)) ) continue;
+      if( this->boundary_info->boundary_id (e, s) != BoundaryInfo::invalid_id )
+        return _interface_weight;
+    }
+  }
+
+  return 1;
+}
+
+
+
 unsigned int MeshBase::recalculate_n_partitions()
 {
   const_element_iterator       el  = this->active_elements_begin();
@@ -317,7 +405,7 @@ void MeshBase::clear_point_locator ()
 SurfaceLocatorHub & MeshBase::surface_locator () const
 {
   if (_surface_locator.get() == NULL)
-    _surface_locator.reset (new SurfaceLocatorHub(*this, SurfaceLocator_SPHERE));
+    _surface_locator.reset (new SurfaceLocatorHub(*this, SurfaceLocator_BVH));
 
   return *_surface_locator;
 }
@@ -46,6 +46,10 @@ namespace
   const unsigned int packed_elem_header_size = 4;
 #endif
 
+  // the number of nodes or elements sent by one broadcast of the mesh,
+  // it bounds the memory of the communication buffers
+  const unsigned int broadcast_block_size = 1<<18;
+
 }
 
 
@@ -188,56 +192,47 @@ void MeshCommunication::broadcast_mesh (MeshBase&) const
 
 
 
-  // First build up the pts vector which contains
-  // the spatial locations of all the nodes
+  // Then send the spatial locations of all the nodes.
+  // The nodes are sent in blocks, so no processor holds a buffer
+  // of the whole mesh besides the mesh itself
   {
     std::vector<Real> pts;
 
-    // If we are processor 0, we must populate this vector and
-    // broadcast it to the other processors.
-    if (Genius::processor_id() == 0)
+    for (unsigned int begin=0; begin<n_nodes; begin+=broadcast_block_size)
     {
-      pts.reserve (3*n_nodes);
+      const unsigned int end = std::min(n_nodes, begin+broadcast_block_size);
 
-      MeshBase::node_iterator       it     = mesh.nodes_begin();
-      const MeshBase::node_iterator it_end = mesh.nodes_end();
-
-      for (; it != it_end; ++it)
+      // If we are processor 0, we must populate this block and
+      // broadcast it to the other processors.
+      pts.resize (3*(end-begin));
+      if (Genius::processor_id() == 0)
       {
-        assert (*it != NULL);
-        assert ((*it)->id()*3 == pts.size());
-
-        const Point& p = **it;
-
-        pts.push_back ( p(0) ); // x
-        pts.push_back ( p(1) ); // y
-        pts.push_back ( p(2) ); // z
+        for (unsigned int i=begin; i<end; ++i)
+        {
+          const Point& p = mesh.node(i);
+          assert (mesh.node(i).id() == i);
 
+          pts[3*(i-begin)+0] = p(0); // x
+          pts[3*(i-begin)+1] = p(1); // y
+          pts[3*(i-begin)+2] = p(2); // z
+        }
       }
 
-    }
-    else
-      pts.resize (3*n_nodes);
-
-    // Sanity check for all processors
-    assert (pts.size() == (3*n_nodes));
+      // Broadcast the pts block, its size is known by all the processors
+      Parallel::broadcast_buffer (&pts[0], pts.size());
 
-    // Broadcast the pts vector
-    Parallel::broadcast (pts);
-
-    // Add the nodes we just received if we are not
-    // processor 0.
-    if (Genius::processor_id() != 0)
-    {
-      assert (mesh.n_nodes() == 0);
-
-      for (unsigned int i=0; i<pts.size(); i += 3)
+      // Add the nodes we just received if we are not
+      // processor 0.
+      if (Genius::processor_id() != 0)
       {
-        mesh.add_point (Point(pts[i+0],
-                              pts[i+1],
-                              pts[i+2]),
-                        i/3);
+        for (unsigned int i=0; i<pts.size(); i += 3)
+        {
+          mesh.add_point (Point(pts[i+0],
+                                pts[i+1],
+                                pts[i+2]),
+                          begin + i/3);
 
+        }
       }
     }
 
@@ -254,20 +249,16 @@ void MeshCommunication::broadcast_mesh (MeshBase&) const
     // [ level p_level r_flag p_flag etype subdomain_id
     //   self_ID parent_ID which_child node_0 node_1 ... node_n]
     // We cannot use unsigned int because parent_ID can be negative
+    // The elements are sent in blocks of broadcast_block_size elements.
     std::vector<int> conn;
 
-    // If we are processor 0, we must populate this vector and
-    // broadcast it to the other processors.
+    // On processor 0, the elements in the order of levels.
+    // By filling conn in order of levels, parents should exist before children
+    // are built when we reconstruct the elements on the other processors.
+    std::vector<const Elem *> elems;
     if (Genius::processor_id() == 0)
     {
-      conn.reserve (packed_elem_header_size*n_elem + total_weight);
-
-      // We start from level 0. This is a bit simpler than in xdr_io.C
-      // because we do not have to worry about economizing by group elements
-      // of the same type. Element type is simply specified as an
-      // entry in the connectivity vector, "conn".
-      // By filling conn in order of levels, parents should exist before children
-      // are built when we reconstruct the elements on the other processors.
+      elems.reserve (n_elem);
 
       for (unsigned int level=0; level<=n_levels; ++level)
       {
@@ -277,109 +268,127 @@ void MeshCommunication::broadcast_mesh (MeshBase&) const
         for (; it != it_end; ++it)
         {
           assert (*it);
-          const Elem* elem = *it;
-          pack_element (conn, elem);
+          elems.push_back(*it);
         }
       }
-    }
-    else
-      conn.resize (packed_elem_header_size*n_elem + total_weight);
 
-    // Sanity check for all processors
-    assert (conn.size() == (packed_elem_header_size*n_elem + total_weight));
+      assert (elems.size() == n_elem);
+    }
 
-    // Broadcast the element connectivity
-    Parallel::broadcast (conn);
+    // This map keeps track of elements we've previously added to the mesh
+    // to avoid O(n) lookup times for parent pointers.
+    std::map<unsigned int, Elem*> parents;
+    // the received elems wait for FVM geometry
+    std::vector<Elem *> fvm_elems;
 
-    // Build the elements we just received if we are not
-    // processor 0.
-    if (Genius::processor_id() != 0)
+    for (unsigned int begin=0; begin<n_elem; begin+=broadcast_block_size)
     {
-      assert (mesh.n_elem() == 0);
+      const unsigned int end = std::min(n_elem, begin+broadcast_block_size);
 
-      unsigned int cnt = 0;
+      // If we are processor 0, we must populate this block and
+      // broadcast it to the other processors.
+      conn.clear();
+      if (Genius::processor_id() == 0)
+      {
+        for (unsigned int i=begin; i<end; ++i)
+          pack_element (conn, elems[i]);
+      }
 
-      // This map keeps track of elements we've previously added to the mesh
-      // to avoid O(n) lookup times for parent pointers.
-      std::map<unsigned int, Elem*> parents;
+      // Broadcast the element connectivity, the receivers get the size with it
+      Parallel::broadcast (conn);
 
-      while (cnt < conn.size())
+      // Build the elements we just received if we are not
+      // processor 0.
+      if (Genius::processor_id() != 0)
       {
-        // Declare the element that we will add
-        Elem* elem = NULL;
+        unsigned int cnt = 0;
+
+        while (cnt < conn.size())
+        {
+          // Declare the element that we will add
+          Elem* elem = NULL;
 
-        // Unpack the element header
+          // Unpack the element header
 #ifdef ENABLE_AMR
-        const int level             = conn[cnt++];
-        const int p_level           = conn[cnt++];
-        const Elem::RefinementState refinement_flag =
-          static_cast<Elem::RefinementState>(conn[cnt++]);
-        const Elem::RefinementState p_refinement_flag =
-          static_cast<Elem::RefinementState>(conn[cnt++]);
+          const int level             = conn[cnt++];
+          const int p_level           = conn[cnt++];
+          const Elem::RefinementState refinement_flag =
+            static_cast<Elem::RefinementState>(conn[cnt++]);
+          const Elem::RefinementState p_refinement_flag =
+            static_cast<Elem::RefinementState>(conn[cnt++]);
 #endif
-        const ElemType elem_type    = static_cast<ElemType>(conn[cnt++]);
-        const unsigned int elem_PID = conn[cnt++];
-        const int subdomain_ID      = conn[cnt++];
-        const int self_ID           = conn[cnt++];
+          const ElemType elem_type    = static_cast<ElemType>(conn[cnt++]);
+          const unsigned int elem_PID = conn[cnt++];
+          const int subdomain_ID      = conn[cnt++];
+          const int self_ID           = conn[cnt++];
 #ifdef ENABLE_AMR
-        const int parent_ID         = conn[cnt++];
-        const int which_child       = conn[cnt++];
+          const int parent_ID         = conn[cnt++];
+          const int which_child       = conn[cnt++];
 
-        if (parent_ID != -1) // Do a log(n) search for the parent
-        {
-          Elem* my_parent = parents.count(parent_ID) ? parents[parent_ID] : NULL;
-
-          // If the parent was not previously added, we cannot continue.
-          if (my_parent == NULL)
+          if (parent_ID != -1) // Do a log(n) search for the parent
           {
-            std::cerr << "Parent element with ID " << parent_ID
-            << " not found." << std::endl;
-            genius_error();
-          }
+            Elem* my_parent = parents.count(parent_ID) ? parents[parent_ID] : NULL;
 
-          assert (my_parent->refinement_flag() == Elem::INACTIVE);
+            // If the parent was not previously added, we cannot continue.
+            if (my_parent == NULL)
+            {
+              std::cerr << "Parent element with ID " << parent_ID
+              << " not found." << std::endl;
+              genius_error();
+            }
 
-          elem = Elem::build(elem_type, my_parent).release();
-          my_parent->add_child(elem);
+            assert (my_parent->refinement_flag() == Elem::INACTIVE);
 
-          assert (my_parent->fvm_compatible_type(my_parent->type())==elem->fvm_compatible_type(elem->type()));
-          assert (my_parent->child(which_child) == elem);
-        }
+            elem = Elem::build(elem_type, my_parent).release();
+            my_parent->add_child(elem);
 
-        else // level 0 element has no parent
-        {
-          assert (level == 0);
+            assert (my_parent->fvm_compatible_type(my_parent->type())==elem->fvm_compatible_type(elem->type()));
+            assert (my_parent->child(which_child) == elem);
+          }
+
+          else // level 0 element has no parent
+          {
+            assert (level == 0);
 #endif
 
-          // should be able to just use the integer elem_type
-          elem = Elem::build(elem_type).release();
+            // should be able to just use the integer elem_type
+            elem = Elem::build(elem_type).release();
 #ifdef ENABLE_AMR
 
-        }
+          }
 
-        // Assign the IDs
-        assert (elem->level() == static_cast<unsigned int>(level));
-        elem->set_refinement_flag(refinement_flag);
-        elem->set_p_refinement_flag(p_refinement_flag);
-        elem->set_p_level(p_level);
+          // Assign the IDs
+          assert (elem->level() == static_cast<unsigned int>(level));
+          elem->set_refinement_flag(refinement_flag);
+          elem->set_p_refinement_flag(p_refinement_flag);
+          elem->set_p_level(p_level);
 #endif
-        elem->processor_id() = elem_PID;
-        elem->subdomain_id() = subdomain_ID;
-        elem->set_id() = self_ID;
+          elem->processor_id() = elem_PID;
+          elem->subdomain_id() = subdomain_ID;
+          elem->set_id() = self_ID;
 
-        // Add elem to the map of parents, since it may have
-        // children to be added later
-        parents.insert(std::make_pair(self_ID,elem));
+          // Add elem to the map of parents, since it may have
+          // children to be added later
+          parents.insert(std::make_pair(self_ID,elem));
 
-        // Assign the connectivity
-        for (unsigned int n=0; n<elem->n_nodes(); n++)
-        {
-          assert (cnt < conn.size());
+          // Assign the connectivity
+          for (unsigned int n=0; n<elem->n_nodes(); n++)
+          {
+            assert (cnt < conn.size());
 
-          elem->set_node(n) = mesh.node_ptr (conn[cnt++]);
-        }
-        elem->prepare_for_fvm();
-      } // end while cnt < conn.size
+            elem->set_node(n) = mesh.node_ptr (conn[cnt++]);
+          }
+          fvm_elems.push_back(elem);
+        } // end while cnt < conn.size
+      }
+    }
+
+    if (Genius::processor_id() != 0)
+    {
+      assert (mesh.n_elem() == 0);
+
+      // build the FVM geometry of all the received elems together
+      MeshTools::prepare_for_fvm(fvm_elems);
 
       // Iterate in ascending elem ID order
       for (std::map<unsigned int, Elem *>::iterator i =
@@ -495,14 +504,14 @@ void MeshCommunication::broadcast_bcs (MeshBase&,
       side_id.resize (n_bcs);
       bc_id.resize   (n_bcs);
 
-      // Broadcast the element identities
-      Parallel::broadcast (el_id);
+      // Broadcast the element identities, the size is known already
+      Parallel::broadcast_buffer (&el_id[0], n_bcs);
 
       // Broadcast the side ids for those elements
-      Parallel::broadcast (side_id);
+      Parallel::broadcast_buffer (&side_id[0], n_bcs);
 
       // Broadcast the bc ids for each side
-      Parallel::broadcast (bc_id);
+      Parallel::broadcast_buffer (&bc_id[0], n_bcs);
 
       // Build the boundary_info structure if we aren't processor 0
       if (Genius::processor_id() != 0)
@@ -590,11 +599,11 @@ void MeshCommunication::broadcast_bcs (MeshBase&,
       node_id.resize (n_bcs);
       bc_id.resize   (n_bcs);
 
-      // Broadcast the node ids
-      Parallel::broadcast (node_id);
+      // Broadcast the node ids, the size is known already
+      Parallel::broadcast_buffer (&node_id[0], n_bcs);
 
       // Broadcast the bc ids for each side
-      Parallel::broadcast (bc_id);
+      Parallel::broadcast_buffer (&bc_id[0], n_bcs);
 
       // Build the boundary_info structure if we aren't processor 0
       if (Genius::processor_id() != 0)
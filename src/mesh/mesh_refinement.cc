@@ -407,7 +407,7 @@ bool MeshRefinement::refine_and_coarsen_elements (const bool maintain_level_one)
   // Finally, the new mesh needs to be prepared for use
   if (coarsening_changed_mesh || refining_changed_mesh)
   {
-    _mesh.prepare_for_use ();
+    _mesh.prepare_for_use (false, true);
 
     return true;
   }
@@ -506,7 +506,7 @@ bool MeshRefinement::coarsen_elements (const bool maintain_level_one)
 
   // Finally, the new mesh may need to be prepared for use
   if (mesh_changed)
-    _mesh.prepare_for_use ();
+    _mesh.prepare_for_use (false, true);
 
   return mesh_changed;
 }
@@ -595,7 +595,7 @@ bool MeshRefinement::refine_elements (const bool maintain_level_one)
 
   // Finally, the new mesh needs to be prepared for use
   if (mesh_changed)
-    _mesh.prepare_for_use ();
+    _mesh.prepare_for_use (false, true);
 
   return mesh_changed;
 }
@@ -875,157 +875,155 @@ bool MeshRefinement::make_refinement_compatible(const bool maintain_level_one)
   else
     _maintain_level_one = _face_level_mismatch_limit;
 
-  // Unless we encounter a specific situation level-one
-  // will be satisfied after executing this loop just once
-  bool level_one_satisfied = true;
-
   // Unless we encounter a specific situation we will be compatible
   // with any selected coarsening flags
   bool compatible_with_coarsening = true;
 
   // This loop enforces the level-1 rule.  We should only
   // execute it if the user indeed wants level-1 satisfied!
+  // Only the elements flagged for refinement can violate the rule, so
+  // they are kept in a work list, and an element newly flagged for refinement
+  // is pushed into it. the flags of the neighbors are only raised
+  // to REFINE, so each element is visited once after its flag changed
+  // instead of sweeping the whole mesh until nothing changes.
   if (_maintain_level_one)
   {
-    do
+    std::vector<Elem *> work_list;
     {
-      level_one_satisfied = true;
-
       MeshBase::element_iterator       el     = _mesh.active_elements_begin();
       const MeshBase::element_iterator end_el = _mesh.active_elements_end();
-
       for (; el != end_el; ++el)
+        if ((*el)->refinement_flag() == Elem::REFINE || (*el)->p_refinement_flag() == Elem::REFINE)
+          work_list.push_back(*el);
+    }
+
+    while (!work_list.empty())
+    {
+      Elem *elem = work_list.back();
+      work_list.pop_back();
+
+      if (elem->refinement_flag() == Elem::REFINE)  // If the element is active and the
+        // h refinement flag is set
       {
-        Elem *elem = *el;
-        if (elem->refinement_flag() == Elem::REFINE)  // If the element is active and the
-          // h refinement flag is set
-        {
-          const unsigned int my_level = elem->level();
+        const unsigned int my_level = elem->level();
 
-          for (unsigned int side=0; side != elem->n_sides(); side++)
+        for (unsigned int side=0; side != elem->n_sides(); side++)
+        {
+          Elem* neighbor = elem->neighbor(side);
+          if (neighbor != NULL &&     // I have a neighbor
+              neighbor->active()) // and it is active
           {
-            Elem* neighbor = elem->neighbor(side);
-            if (neighbor != NULL &&     // I have a neighbor
-                neighbor->active()) // and it is active
-            {
 
 
-              // Case 1:  The neighbor is at the same level I am.
-              //        1a: The neighbor will be refined       -> NO PROBLEM
-              //        1b: The neighbor won't be refined      -> NO PROBLEM
-              //        1c: The neighbor wants to be coarsened -> PROBLEM
-              if (neighbor->level() == my_level)
+            // Case 1:  The neighbor is at the same level I am.
+            //        1a: The neighbor will be refined       -> NO PROBLEM
+            //        1b: The neighbor won't be refined      -> NO PROBLEM
+            //        1c: The neighbor wants to be coarsened -> PROBLEM
+            if (neighbor->level() == my_level)
+            {
+              if (neighbor->refinement_flag() == Elem::COARSEN)
               {
-                if (neighbor->refinement_flag() == Elem::COARSEN)
-                {
-                  neighbor->set_refinement_flag(Elem::DO_NOTHING);
-                  if (neighbor->parent())
-                    neighbor->parent()->set_refinement_flag(Elem::INACTIVE);
-                  compatible_with_coarsening = false;
-                  level_one_satisfied = false;
-                }
+                neighbor->set_refinement_flag(Elem::DO_NOTHING);
+                if (neighbor->parent())
+                  neighbor->parent()->set_refinement_flag(Elem::INACTIVE);
+                compatible_with_coarsening = false;
               }
+            }
 
 
-              // Case 2: The neighbor is one level lower than I am.
-              //         The neighbor thus MUST be refined to satisfy
-              //         the level-one rule, regardless of whether it
-              //         was originally flagged for refinement. If it
-              //         wasn't flagged already we need to repeat
-              //         this process.
-              else if ((neighbor->level()+1) == my_level)
+            // Case 2: The neighbor is one level lower than I am.
+            //         The neighbor thus MUST be refined to satisfy
+            //         the level-one rule, regardless of whether it
+            //         was originally flagged for refinement. If it
+            //         wasn't flagged already it goes to the work list.
+            else if ((neighbor->level()+1) == my_level)
+            {
+              if (neighbor->refinement_flag() != Elem::REFINE)
               {
-                if (neighbor->refinement_flag() != Elem::REFINE)
-                {
-                  neighbor->set_refinement_flag(Elem::REFINE);
-                  if (neighbor->parent())
-                    neighbor->parent()->set_refinement_flag(Elem::INACTIVE);
-                  compatible_with_coarsening = false;
-                  level_one_satisfied = false;
-                }
+                neighbor->set_refinement_flag(Elem::REFINE);
+                if (neighbor->parent())
+                  neighbor->parent()->set_refinement_flag(Elem::INACTIVE);
+                compatible_with_coarsening = false;
+                work_list.push_back(neighbor);
               }
+            }
 #ifdef DEBUG
 
-              // Sanity check. We should never get into a
-              // case when our neighbot is more than one
-              // level away.
-              else if ((neighbor->level()+1) < my_level)
-              {
-                genius_error();
-              }
+            // Sanity check. We should never get into a
+            // case when our neighbot is more than one
+            // level away.
+            else if ((neighbor->level()+1) < my_level)
+            {
+              genius_error();
+            }
 
 
-              // Note that the only other possibility is that the
-              // neighbor is already refined, in which case it isn't
-              // active and we should never get here.
-              else
-              {
-                genius_error();
-              }
-#endif
+            // Note that the only other possibility is that the
+            // neighbor is already refined, in which case it isn't
+            // active and we should never get here.
+            else
+            {
+              genius_error();
             }
+#endif
           }
         }
-        if (elem->p_refinement_flag() == Elem::REFINE)  // If the element is active and the
-          // p refinement flag is set
-        {
-          const unsigned int my_p_level = elem->p_level();
+      }
+      if (elem->p_refinement_flag() == Elem::REFINE)  // If the element is active and the
+        // p refinement flag is set
+      {
+        const unsigned int my_p_level = elem->p_level();
 
-          for (unsigned int side=0; side != elem->n_sides(); side++)
-          {
-            Elem *neighbor = elem->neighbor(side);
-            if (neighbor != NULL)     // I have a neighbor
-              if (neighbor->active()) // and it is active
+        for (unsigned int side=0; side != elem->n_sides(); side++)
+        {
+          Elem *neighbor = elem->neighbor(side);
+          if (neighbor != NULL)     // I have a neighbor
+            if (neighbor->active()) // and it is active
+            {
+              if (neighbor->p_level() < my_p_level &&
+                  neighbor->p_refinement_flag() != Elem::REFINE)
               {
-                if (neighbor->p_level() < my_p_level &&
-                    neighbor->p_refinement_flag() != Elem::REFINE)
-                {
-                  neighbor->set_p_refinement_flag(Elem::REFINE);
-                  level_one_satisfied = false;
-                  compatible_with_coarsening = false;
-                }
-                if (neighbor->p_level() == my_p_level &&
-                    neighbor->p_refinement_flag() == Elem::COARSEN)
-                {
-                  neighbor->set_p_refinement_flag(Elem::DO_NOTHING);
-                  level_one_satisfied = false;
-                  compatible_with_coarsening = false;
-                }
+                neighbor->set_p_refinement_flag(Elem::REFINE);
+                compatible_with_coarsening = false;
+                work_list.push_back(neighbor);
               }
-              else // I have an inactive neighbor
+              if (neighbor->p_level() == my_p_level &&
+                  neighbor->p_refinement_flag() == Elem::COARSEN)
               {
-                genius_assert(neighbor->has_children());
-                for (unsigned int c=0; c!=neighbor->n_children(); c++)
-                {
-                  Elem *subneighbor = neighbor->child(c);
-                  if (subneighbor->active() &&
-                      subneighbor->is_neighbor(elem))
-                    if (subneighbor->p_level() < my_p_level &&
-                        subneighbor->p_refinement_flag() != Elem::REFINE)
-                    {
-                      // We should already be level one
-                      // compatible
-                      genius_assert(subneighbor->p_level() + 2u >
-                             my_p_level);
-                      subneighbor->set_p_refinement_flag(Elem::REFINE);
-                      level_one_satisfied = false;
-                      compatible_with_coarsening = false;
-                    }
-                  if (subneighbor->p_level() == my_p_level &&
-                      subneighbor->p_refinement_flag() == Elem::COARSEN)
+                neighbor->set_p_refinement_flag(Elem::DO_NOTHING);
+                compatible_with_coarsening = false;
+              }
+            }
+            else // I have an inactive neighbor
+            {
+              genius_assert(neighbor->has_children());
+              for (unsigned int c=0; c!=neighbor->n_children(); c++)
+              {
+                Elem *subneighbor = neighbor->child(c);
+                if (subneighbor->active() &&
+                    subneighbor->is_neighbor(elem))
+                  if (subneighbor->p_level() < my_p_level &&
+                      subneighbor->p_refinement_flag() != Elem::REFINE)
                   {
-                    subneighbor->set_p_refinement_flag(Elem::DO_NOTHING);
-                    level_one_satisfied = false;
+                    // We should already be level one
+                    // compatible
+                    genius_assert(subneighbor->p_level() + 2u >
+                           my_p_level);
+                    subneighbor->set_p_refinement_flag(Elem::REFINE);
                     compatible_with_coarsening = false;
+                    work_list.push_back(subneighbor);
                   }
+                if (subneighbor->p_level() == my_p_level &&
+                    subneighbor->p_refinement_flag() == Elem::COARSEN)
+                {
+                  subneighbor->set_p_refinement_flag(Elem::DO_NOTHING);
+                  compatible_with_coarsening = false;
                 }
               }
-          }
+            }
         }
       }
     }
-
-    while (!level_one_satisfied);
   } // end if (_maintain_level_one)
 
 
@@ -1295,7 +1293,7 @@ void MeshRefinement::uniformly_refine (unsigned int n)
   }
 
   // Finally, the new mesh needs to be prepared for use
-  _mesh.prepare_for_use ();
+  _mesh.prepare_for_use (false, true);
 }
 
 
@@ -1325,7 +1323,7 @@ void MeshRefinement::uniformly_coarsen (unsigned int n)
 
 
   // Finally, the new mesh needs to be prepared for use
-  _mesh.prepare_for_use ();
+  _mesh.prepare_for_use (false, true);
 }
 
 
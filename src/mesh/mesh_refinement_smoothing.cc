@@ -152,7 +152,7 @@ bool MeshRefinement::limit_level_mismatch_at_edge (const unsigned int max_mismat
             if (childnode1 < childnode0)
               std::swap(childnode0, childnode1);
 
-	    for (const Elem *p = elem; p != NULL; p = elem->parent())
+	    for (const Elem *p = elem; p != NULL; p = p->parent())
 	      {
                 AutoPtr<Elem> pedge = p->build_edge(n);
 		unsigned int node0 = pedge->node(0);
@@ -21,12 +21,14 @@
 
 // C++ includes
 #include <set>
+#include <algorithm>
 
 // Local includes
 #include "mesh_tools.h"
 #include "mesh_base.h"
 #include "elem.h"
 #include "sphere.h"
+#include "genius_env.h"
 
 
 
@@ -611,3 +613,86 @@ void MeshTools::find_hanging_nodes_and_parents(const MeshBase& mesh, std::map<un
     }
   }
 }
+
+
+
+unsigned long long MeshTools::hilbert_key(const Point &p, const BoundingBox &bbox, unsigned int dim)
+{
+  genius_assert(dim>=1 && dim<=3);
+
+  const unsigned int bits = 21;
+  const unsigned int max_coord = (1u<<bits) - 1;
+
+  // quantize coordinates into [0, 2^bits)
+  unsigned int X[3] = {0, 0, 0};
+  for(unsigned int i=0; i<dim; ++i)
+  {
+    const Real length = bbox.second(i) - bbox.first(i);
+    Real r = length > 0.0 ? (p(i) - bbox.first(i))/length : 0.0;
+    r = std::max(0.0, std::min(1.0, r));
+    X[i] = static_cast<unsigned int>(r*max_coord);
+  }
+
+  // convert axes to the transposed Hilbert index, see
+  // J. Skilling, Programming the Hilbert curve, AIP Conf. Proc. 707, 381 (2004)
+  const unsigned int M = 1u<<(bits-1);
+  for(unsigned int Q=M; Q>1; Q>>=1)
+  {
+    const unsigned int P = Q-1;
+    for(unsigned int i=0; i<dim; ++i)
+    {
+      if( X[i] & Q ) X[0] ^= P;
+      else
+      {
+        const unsigned int t = (X[0]^X[i]) & P;
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+    }
+  }
+
+  // gray encode
+  for(unsigned int i=1; i<dim; ++i)
+    X[i] ^= X[i-1];
+  unsigned int t = 0;
+  for(unsigned int Q=M; Q>1; Q>>=1)
+    if( X[dim-1] & Q ) t ^= Q-1;
+  for(unsigned int i=0; i<dim; ++i)
+    X[i] ^= t;
+
+  // interleave the transposed bits into one key
+  unsigned long long key = 0;
+  for(int b=bits-1; b>=0; --b)
+    for(unsigned int i=0; i<dim; ++i)
+      key = (key<<1) | ((X[i]>>b) & 1u);
+
+  return key;
+}
+
+
+
+unsigned int MeshTools::prepare_for_fvm(const std::vector<Elem *> &elems)
+{
+  const int n_elems = elems.size();
+
+  // quality pre-pass, the batch key is (type, obtuse)
+  std::vector< std::pair<unsigned int, unsigned int> > batch(n_elems);
+  unsigned int n_obtuse = 0;
+#pragma omp parallel for schedule(static) num_threads(Genius::n_threads()) reduction(+:n_obtuse)
+  for(int n=0; n<n_elems; ++n)
+  {
+    const Elem * elem = elems[n];
+    const unsigned int obtuse = elem->quality(OBTUSE) > 0.5 ? 1 : 0;
+    batch[n] = std::make_pair(2*static_cast<unsigned int>(elem->type()) + obtuse, static_cast<unsigned int>(n));
+    n_obtuse += obtuse;
+  }
+  // keep the order of elements inside a batch
+  std::sort(batch.begin(), batch.end());
+
+  // obtuse elements take the truncated branch, which costs more, so use dynamic schedule
+#pragma omp parallel for schedule(dynamic, 256) num_threads(Genius::n_threads())
+  for(int n=0; n<n_elems; ++n)
+    elems[batch[n].second]->prepare_for_fvm();
+
+  return n_obtuse;
+}
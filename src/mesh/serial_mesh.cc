@@ -320,11 +320,85 @@ static bool less_than( const Node * n1, const Node * n2 )
 
 
 
+template <typename K, typename V>
+static bool first_less_than( const std::pair<K, V> &a, const std::pair<K, V> &b )
+{
+  return a.first < b.first;
+}
+
+
+
 void SerialMesh::reorder_nodes()
 {
   // do it only on serial mesh
   assert(_is_serial);
 
+  switch( _reorder_type )
+  {
+      case REORDER_RCM     : reorder_nodes_rcm(); break;
+      case REORDER_HILBERT : reorder_nodes_and_elems_hilbert(); break;
+      default : break;
+  }
+}
+
+
+
+void SerialMesh::reorder_nodes_and_elems_hilbert()
+{
+  if( _nodes.empty() ) return;
+
+  // the bounding box of all the nodes, computed locally.
+  // every processor holds the same serial mesh, so they get the same order
+  MeshTools::BoundingBox bbox( *_nodes[0], *_nodes[0] );
+  for(unsigned int n=0; n<_nodes.size(); ++n)
+  {
+    _nodes[n]->assign_min_to(bbox.first);
+    _nodes[n]->assign_max_to(bbox.second);
+  }
+
+  const unsigned int dim = this->mesh_dimension();
+
+  // sort nodes by Hilbert key, node id breaks the tie
+  {
+    std::vector< std::pair<unsigned long long, Node *> > keys;
+    keys.reserve(_nodes.size());
+    for(unsigned int n=0; n<_nodes.size(); ++n)
+      keys.push_back( std::make_pair(MeshTools::hilbert_key(*_nodes[n], bbox, dim), _nodes[n]) );
+    std::stable_sort( keys.begin(), keys.end(), first_less_than<unsigned long long, Node *> );
+
+    for(unsigned int n=0; n<keys.size(); ++n)
+    {
+      _nodes[n] = keys[n].second;
+      _nodes[n]->set_id() = n;
+    }
+  }
+
+  // sort elements by refinement level and the Hilbert key of centroid,
+  // so parents are still ahead of their children
+  {
+    std::vector< std::pair<std::pair<unsigned int, unsigned long long>, Elem *> > keys;
+    keys.reserve(_elements.size());
+    for(unsigned int n=0; n<_elements.size(); ++n)
+    {
+      Elem * elem = _elements[n];
+      std::pair<unsigned int, unsigned long long> key( elem->level(), MeshTools::hilbert_key(elem->centroid(), bbox, dim) );
+      keys.push_back( std::make_pair(key, elem) );
+    }
+    std::stable_sort( keys.begin(), keys.end(), first_less_than<std::pair<unsigned int, unsigned long long>, Elem *> );
+
+    for(unsigned int n=0; n<keys.size(); ++n)
+    {
+      _elements[n] = keys[n].second;
+      _elements[n]->set_id() = n;
+    }
+  }
+}
+
+
+
+void SerialMesh::reorder_nodes_rcm()
+{
+
   // reorder the node index by Reverse Cuthill-McKee Algorithm
   // which can reduce filling in LU (ILU) Factorization
   node_iterator       node_it  = nodes_begin();
@@ -926,6 +1000,8 @@ void SerialMesh::_unpack_mesh (const std::vector<Real> &pts, const std::vector<i
     std::map<unsigned int, Elem*> top_elems;
     // This map saved elem neighbor information
     std::map<unsigned int, std::vector<int> > elem_neighbors;
+    // the elems wait for FVM geometry
+    std::vector<Elem *> fvm_elems;
 
     while (cnt < conn.size())
     {
@@ -1008,9 +1084,12 @@ void SerialMesh::_unpack_mesh (const std::vector<Real> &pts, const std::vector<i
       }
       elem_neighbors.insert( std::make_pair(elem->id(), neighbors) );
 
-      elem->prepare_for_fvm();
+      fvm_elems.push_back(elem);
     } // end while cnt < conn.size
 
+    // build the FVM geometry of all the elems together
+    MeshTools::prepare_for_fvm(fvm_elems);
+
     // assign elems to _elements array
     for (unsigned int n=0; n<_elements.size(); ++n)
     {
@@ -30,6 +30,9 @@
 #include "mesh_tools.h" // For n_levels
 #include "perf_log.h"
 #include "elem.h"
+#include "genius_env.h"
+#include "log.h"
+#include "fvm_geometry_cache.h"
 
 #if defined(HAVE_TR1_UNORDERED_MAP)
 #include <tr1/unordered_map>
@@ -317,6 +320,7 @@ void UnstructuredMesh::all_first_order ()
    * First make sure they _are_ indeed high-order, and then replace
    * them with an equivalent first-order element.
    */
+  unsigned int n_converted = 0;
   const_element_iterator endit = elements_end();
   for (const_element_iterator it = elements_begin();
        it != endit; ++it)
@@ -327,6 +331,8 @@ void UnstructuredMesh::all_first_order ()
 
     if ( Elem::first_order_equivalent_type(so_elem->type()) == so_elem->type() ) continue;
 
+    ++n_converted;
+
     /*
      * build the first-order equivalent, add to
      * the new_elements list.
@@ -405,6 +411,11 @@ void UnstructuredMesh::all_first_order ()
 
   STOP_LOG("all_first_order()", "Mesh");
 
+  // a prepared mesh of first order elements, i.e. after mesh refinement, is not touched.
+  // prepare it again would renumber, reorder and partition the mesh once more
+  if (n_converted == 0 && this->_is_prepared)
+    return;
+
   // delete or renumber nodes, etc
   this->prepare_for_use();
 }
@@ -682,8 +693,13 @@ bool UnstructuredMesh::all_fvm_elem ()
   this->all_first_order ();
 
 
-  // here we convert all the active FEM element to FVM element, maybe only element belongs to local
+  // here we convert all the active FEM element to FVM element, only element belongs to local
   // procesor needs to be converted.
+  // the elements which are FVM elements already, i.e. kept from the mesh before a
+  // refinement or the children of refined FVM elements, are not rebuilt.
+  // only their geometry is computed again.
+  std::vector<Elem *> fem_elems;
+  std::vector<Elem *> kept_fvm_elems;
   const_element_iterator endit = active_elements_end();
   for (const_element_iterator it = active_elements_begin();  it != endit; ++it )
   {
@@ -697,12 +713,65 @@ bool UnstructuredMesh::all_fvm_elem ()
     // can this element be used in FVM?
     if ( fem_elem->fvm_compatible_test() == false ) return false;
 
-    /*
-     * build the FVM compatible element, add to
-     * the new_elements list.
-     */
+    if ( Elem::fvm_compatible_type(fem_elem->type()) == fem_elem->type() )
+    {
+      kept_fvm_elems.push_back(fem_elem);
+      continue;
+    }
+
+    fem_elems.push_back(fem_elem);
+  }
+
+  /*
+   * build the FVM compatible element
+   * The FVM element and first order FEM elem has the same node
+   */
+  std::vector<Elem *> fvm_elems(fem_elems.size());
+  for (unsigned int n=0; n<fem_elems.size(); ++n)
+  {
+    Elem* fem_elem = fem_elems[n];
+    Elem *fvm_elem = Elem::build (Elem::fvm_compatible_type(fem_elem->type()), fem_elem->parent()).release();
+
+    assert (fvm_elem->n_vertices() == fem_elem->n_vertices());
+
+    for (unsigned int v=0; v < fem_elem->n_vertices(); v++)
+      fvm_elem->set_node(v) = fem_elem->get_node(v);
+
+    // the new FVM element will replace the FEM element with the same id
+    fvm_elem->set_id(fem_elem->id());
+
+    fvm_elems[n] = fvm_elem;
+  }
+
+  /*
+   * build cell's geometry information for FVM usage.
+   * restore it from the geometry cache when the cache matches the mesh,
+   * else each element only reads its own nodes, so it can be done by threads
+   */
+  std::vector<Elem *> geometry_elems(fvm_elems);
+  geometry_elems.insert(geometry_elems.end(), kept_fvm_elems.begin(), kept_fvm_elems.end());
+
+  const std::string cache_file = Genius::geometry_cache().empty() ? std::string() :
+                                 FVMGeometryCache::file_name(Genius::geometry_cache());
+  if( cache_file.empty() || !FVMGeometryCache::load(cache_file, geometry_elems) )
+  {
+    const unsigned int n_obtuse = MeshTools::prepare_for_fvm(geometry_elems);
+    if( n_obtuse )
+    {
+      MESSAGE<<"Mesh has "<<n_obtuse<<" obtuse elements, their control volumes are truncated."<<std::endl;
+      RECORD();
+    }
+
+    if( !cache_file.empty() )
+      FVMGeometryCache::save(cache_file, geometry_elems);
+  }
+
+  // replace the FEM elements by the FVM elements
+  for (unsigned int n=0; n<fem_elems.size(); ++n)
+  {
+    Elem* fem_elem = fem_elems[n];
+    Elem* fvm_elem = fvm_elems[n];
     Elem *newparent = fem_elem->parent();
-    Elem *fvm_elem = Elem::build (Elem::fvm_compatible_type(fem_elem->type()), newparent).release();
 
 #ifdef ENABLE_AMR
 
@@ -732,18 +801,6 @@ bool UnstructuredMesh::all_fvm_elem ()
     fvm_elem->set_refinement_flag(fem_elem->refinement_flag());
     fvm_elem->set_p_refinement_flag(fem_elem->p_refinement_flag());
 #endif
-    assert (fvm_elem->n_vertices() == fem_elem->n_vertices());
-
-    /*
-     * The FVM element and first order FEM elem has the same node
-     */
-    for (unsigned int v=0; v < fem_elem->n_vertices(); v++)
-      fvm_elem->set_node(v) = fem_elem->get_node(v);
-
-    /*
-     * build cell's geometry information for FVM usage
-     */
-    fvm_elem->prepare_for_fvm();
 
     /*
      * set the subdomain id
@@ -793,8 +850,6 @@ bool UnstructuredMesh::all_fvm_elem ()
      * Inserting it into the mesh will replace and delete
      * the first-order FEM element.
      */
-    fvm_elem->set_id(fem_elem->id());
-
     // delete old fem element,
     this->insert_elem(fvm_elem);
 
@@ -69,6 +69,10 @@ void MeshGeneratorQuad4::build_rectangle_mesh()
       point_array3d[0][j][i].set_location(x,y,z);
     }
 
+  // no boundary edge at present
+  x_edge_mark.assign((IX-1)*IY, 0);
+  y_edge_mark.assign(IX*(IY-1), 0);
+
   // set the bound box
   xmin  =  point_array3d[0][0][0].x;
   xmax  =  point_array3d[0][0][IX-1].x;
@@ -156,25 +160,17 @@ int MeshGeneratorQuad4::set_region(const Parser::Card &c)
 
 
 /* ----------------------------------------------------------------------------
- * get the region index of a quad4 cell by its bound
- * if region is overlaped, return the last defined region id
+ * fill the region index of all the quad4 cells
+ * if region is overlaped, the last defined region wins
  */
-int  MeshGeneratorQuad4::get_cell_region_id(unsigned int ixmin, unsigned int  ixmax,
-                                            unsigned int iymin, unsigned int  iymax)
+void MeshGeneratorQuad4::build_cell_region()
 {
-  int id = 0;
-
-  for(size_t i=0; i < region_array1d.size(); i++)
-  {
-    if( ixmin >= region_array1d[i].ixmin && ixmax <= region_array1d[i].ixmax &&
-        iymin >= region_array1d[i].iymin && iymax <= region_array1d[i].iymax )
-    {
-      id = i;
-    }
-  }
-
-  return id;
+  cell_region.assign((IX-1)*(IY-1), 0);
 
+  for(size_t r=0; r < region_array1d.size(); r++)
+    for(unsigned int j=region_array1d[r].iymin; j<region_array1d[r].iymax; j++)
+      for(unsigned int i=region_array1d[r].ixmin; i<region_array1d[r].ixmax; i++)
+        cell_region[i + (IX-1)*j] = r;
 }
 
 
@@ -302,35 +298,15 @@ int  MeshGeneratorQuad4::make_face(unsigned int ixmin,unsigned int ixmax,
   face.izmax = 0;
   face_array1d.push_back(face);
 
-  SkeletonEdge edge;
-  edge.IX = IX;
-  edge.IY = IY;
-
   if(iymin==iymax) //top or bottom face
   {
-    // set the projection segment of this face on xy plane
-    for(unsigned int i=ixmin;i<ixmax;)
-    {
-      edge.p1[0]=i++;
-      edge.p1[1]=iymax;
-      while(point_array3d[0][iymax][i].eliminated) i++;
-      edge.p2[0]=i;
-      edge.p2[1]=iymax;
-      edge_table[edge]=face_mark;
-    }
+    for(unsigned int i=ixmin;i<ixmax;i++)
+      x_edge_mark[i + (IX-1)*iymax] = face_mark;
   }
   else if(ixmin==ixmax) //left or right face
   {
-    // set the projection segment of this face on xy plane
-    for(unsigned int i=iymin;i<iymax;)
-    {
-      edge.p1[0]=ixmin;
-      edge.p1[1]=i++;
-      while(point_array3d[0][i][ixmin].eliminated) i++;
-      edge.p2[0]=ixmin;
-      edge.p2[1]=i;
-      edge_table[edge]=face_mark;
-    }
+    for(unsigned int j=iymin;j<iymax;j++)
+      y_edge_mark[ixmin + IX*j] = face_mark;
   }
 
   return 0;
@@ -343,9 +319,6 @@ int  MeshGeneratorQuad4::make_face(unsigned int ixmin,unsigned int ixmax,
  */
 int  MeshGeneratorQuad4::make_region_boundary()
 {
-  // set segment bounding
-  std::map<SkeletonEdge, int, lt_edge>::iterator pt;
-
   for(size_t r=0;r<region_array1d.size();r++)
   {
     //if(region_array1d[r].shape! = Rectangle) continue;
@@ -355,50 +328,19 @@ int  MeshGeneratorQuad4::make_region_boundary()
     face.face_mark=r+1;
     face_array1d.push_back(face);
 
-    SkeletonEdge edge;
-    edge.IX = IX;
-    edge.IY = IY;
+    const SkeletonRegion2D & region = region_array1d[r];
 
-    //process bottom line
-    for( unsigned int  i=region_array1d[r].ixmin; i<region_array1d[r].ixmax; )
-    {
-      edge.p1[0] = i++;
-      edge.p1[1] = region_array1d[r].iymax;
-      while( point_array3d[0][region_array1d[r].iymax][i].eliminated ) i++;
-      edge.p2[0] = i;
-      edge.p2[1] = region_array1d[r].iymax;
-      edge_table[edge] =  (r+1);
-    }
-    //process top line
-    for( unsigned int  i=region_array1d[r].ixmin; i<region_array1d[r].ixmax; )
+    //process bottom and top line
+    for( unsigned int  i=region.ixmin; i<region.ixmax; i++ )
     {
-      edge.p1[0] = i++;
-      edge.p1[1] = region_array1d[r].iymin;
-      while( point_array3d[0][region_array1d[r].iymin][i].eliminated ) i++;
-      edge.p2[0] = i;
-      edge.p2[1] = region_array1d[r].iymin;
-      edge_table[edge] =  (r+1);
+      x_edge_mark[i + (IX-1)*region.iymax] = (r+1);
+      x_edge_mark[i + (IX-1)*region.iymin] = (r+1);
     }
-    //process left line
-    for( unsigned int  i=region_array1d[r].iymin; i<region_array1d[r].iymax; )
+    //process left and right line
+    for( unsigned int  j=region.iymin; j<region.iymax; j++ )
     {
-      edge.p1[0] = region_array1d[r].ixmin;
-      edge.p1[1] = i++;
-      while( point_array3d[0][i][region_array1d[r].ixmin].eliminated ) i++;
-      edge.p2[0] = region_array1d[r].ixmin;
-      edge.p2[1] = i;
-      // is it the global left line
-      edge_table[edge] =  (r+1);
-    }
-    //process right line
-    for( unsigned int  i=region_array1d[r].iymin; i<region_array1d[r].iymax; )
-    {
-      edge.p1[0] = region_array1d[r].ixmax;
-      edge.p1[1] = i++;
-      while( point_array3d[0][i][region_array1d[r].ixmax].eliminated ) i++;
-      edge.p2[0] = region_array1d[r].ixmax;
-      edge.p2[1] = i;
-      edge_table[edge] =  (r+1);
+      y_edge_mark[region.ixmin + IX*j] = (r+1);
+      y_edge_mark[region.ixmax + IX*j] = (r+1);
     }
   }
 
@@ -485,6 +427,9 @@ int MeshGeneratorQuad4::do_mesh()
       if( set_face(c) ) return 1;
   }
 
+  // the region of each cell
+  build_cell_region();
+
   // fill the _mesh structure
   _mesh.magic_num() = this->magic_num();
 
@@ -493,79 +438,88 @@ int MeshGeneratorQuad4::do_mesh()
   _mesh.reserve_elem( (IX-1)*(IY-1));
 
   // Build the nodes. we do dimension scale here
-  {
-      for (unsigned int j=0; j<IY; j++)
-        for (unsigned int i=0; i<IX; i++)
-        {
-          _mesh.add_point(Point(point_array3d[0][j][i].x*dscale,
-                                point_array3d[0][j][i].y*dscale,
-                                0));
-        }
+  std::vector<Node *> nodes(IX*IY);
+  for (unsigned int j=0; j<IY; j++)
+    for (unsigned int i=0; i<IX; i++)
+    {
+      nodes[i + IX*j] = _mesh.add_point(Point(point_array3d[0][j][i].x*dscale,
+                                              point_array3d[0][j][i].y*dscale,
+                                              0));
+    }
 
-  }
+  // the label faces have mark larger than region number,
+  // a region boundary side shared by two regions is an interface
+  const int n_regions = region_array1d.size();
+  std::map<const std::string, short int> bd_map;
+  typedef std::map<const std::string, short int>::iterator Bd_It;
 
   //set the elem , the region(subdomain) id is also set
-    for (unsigned int j=0; j<IY-1; j++)
-      for (unsigned int i=0; i<IX-1; i++)
+  for (unsigned int j=0; j<IY-1; j++)
+    for (unsigned int i=0; i<IX-1; i++)
+    {
+      Elem* elem = _mesh.add_elem(Elem::build(QUAD4).release());
+
+      elem->set_node(0) = nodes[ i + IX*(j)         ];
+      elem->set_node(1) = nodes[ (i+1) + IX*(j)     ];
+      elem->set_node(2) = nodes[ (i+1) + IX*((j+1)) ];
+      elem->set_node(3) = nodes[ i + IX*((j+1))     ];
+
+      // set subdomain id
+      const int sbd_id1 = cell_region[i + (IX-1)*j];
+      elem->subdomain_id() = sbd_id1;
+
+      // the edge mark and the neighbor cell of side 0(bottom), 1(right), 2(top) and 3(left)
+      int side_mark[4];
+      side_mark[0] = x_edge_mark[i + (IX-1)*j];
+      side_mark[1] = y_edge_mark[(i+1) + IX*j];
+      side_mark[2] = x_edge_mark[i + (IX-1)*(j+1)];
+      side_mark[3] = y_edge_mark[i + IX*j];
+
+      int neighbor_region[4];
+      neighbor_region[0] = j>0    ? cell_region[i + (IX-1)*(j-1)] : -1;
+      neighbor_region[1] = i<IX-2 ? cell_region[(i+1) + (IX-1)*j] : -1;
+      neighbor_region[2] = j<IY-2 ? cell_region[i + (IX-1)*(j+1)] : -1;
+      neighbor_region[3] = i>0    ? cell_region[(i-1) + (IX-1)*j] : -1;
+
+      for(unsigned int s=0; s<4; s++)
       {
-        Elem* elem = _mesh.add_elem(Elem::build(QUAD4).release());
-
+        if( side_mark[s] == 0 ) continue;
 
-        elem->set_node(0) = _mesh.node_ptr( i + IX*(j)             );
-        elem->set_node(1) = _mesh.node_ptr( (i+1) + IX*(j)         );
-        elem->set_node(2) = _mesh.node_ptr( (i+1) + IX*((j+1))     );
-        elem->set_node(3) = _mesh.node_ptr( i + IX*((j+1))         );
+        const int sbd_id2 = neighbor_region[s];
 
-        // set subdomain id
-        elem->subdomain_id() = get_cell_region_id (i,i+1,j,j+1);
-
-        // set boundary id, however, all the region faces are set to Neumann at present,
-        // we should pick up the face lies on interface of two regions later.
-        SkeletonEdge  edge;
-        edge.IX = IX;
-        edge.IY = IY;
-
-        //top face
+        // label face or outer boundary
+        if( side_mark[s] > n_regions || sbd_id2 < 0 )
         {
-          edge.p1[0] = i;
-          edge.p1[1] = j+1;
-          edge.p2[0] = i+1;
-          edge.p2[1] = j+1;
-          if ( edge_table.find(edge) != edge_table.end() )
-            _mesh.boundary_info->add_side(elem, 2, static_cast<short int>(edge_table[edge]) );
+          _mesh.boundary_info->add_side(elem, s, static_cast<short int>(side_mark[s]) );
+          continue;
         }
 
-        //bottom face
-        {
-          edge.p1[0] = i;
-          edge.p1[1] = j;
-          edge.p2[0] = i+1;
-          edge.p2[1] = j;
-          if ( edge_table.find(edge) != edge_table.end() )
-            _mesh.boundary_info->add_side(elem, 0, static_cast<short int>(edge_table[edge]) );
-        }
+        // region boundary inside a region (covered by a later region), not a boundary at all
+        if( sbd_id1 == sbd_id2 ) continue;
 
-        //left face
-        {
-          edge.p1[0] = i;
-          edge.p1[1] = j;
-          edge.p2[0] = i;
-          edge.p2[1] = j+1;
-          if ( edge_table.find(edge) != edge_table.end() )
-            _mesh.boundary_info->add_side(elem, 3, static_cast<short int>(edge_table[edge]) );
-        }
+        // build the label for the interface, which has the form of RegionLabel1_to_RegionLabel2,
+        // the two region is alpha ordered.
+        std::string bd_label;
+        if( region_array1d[sbd_id1].label < region_array1d[sbd_id2].label)
+          bd_label = region_array1d[sbd_id1].label + "_to_" + region_array1d[sbd_id2].label;
+        else
+          bd_label = region_array1d[sbd_id2].label + "_to_" + region_array1d[sbd_id1].label;
 
-        //right face
+        short int bd_index;
+
+        // if the label already exist
+        if( bd_map.find(bd_label) != bd_map.end() )
+          bd_index = (*bd_map.find(bd_label)).second;
+        else
         {
-          edge.p1[0] = i+1;
-          edge.p1[1] = j;
-          edge.p2[0] = i+1;
-          edge.p2[1] = j+1;
-          if ( edge_table.find(edge) != edge_table.end() )
-            _mesh.boundary_info->add_side(elem, 1, static_cast<short int>(edge_table[edge]) );
+          //else, increase bd_index, insert it into bd_map
+          bd_index = face_array1d.size() + bd_map.size() + 1;
+          bd_map.insert(std::pair<const std::string, short int>(bd_label,bd_index));
         }
 
+        _mesh.boundary_info->add_side(elem, s, bd_index);
       }
+    }
 
   // write region label and material info to _mesh
 
@@ -581,65 +535,7 @@ int MeshGeneratorQuad4::do_mesh()
   for(size_t f=0; f < face_array1d.size(); f++)
     _mesh.boundary_info->set_label_to_id( face_array1d[f].face_mark, face_array1d[f].face_label );
 
-  //the interface information should be set here
-
-  std::vector<unsigned int>       elems;
-  std::vector<unsigned short int> sides;
-  std::vector<short int>          bds;
-  std::map<const std::string, short int> bd_map;
-  typedef std::map<const std::string, short int>::iterator Bd_It;
-
-  // get all the boundary element
-  _mesh.boundary_info->build_side_list (elems, sides, bds);
-
-  //build neighbor information for mesh. then elem->neighbor() is functional
-  _mesh.boundary_info->find_neighbors();
-
-
-  for (size_t nbd=0; nbd<elems.size(); nbd++ )
-  {
-    // get the element which has boundary/interface side
-    const Elem* elem = _mesh.elem(elems[nbd]);
-    //is it an interface side && not a label face?
-    if( elem->neighbor(sides[nbd])!=NULL && bds[nbd]<=static_cast<short int>(region_array1d.size()) )
-    {
-       // the element and its neighbor should in diffetent subdomain
-       unsigned int sbd_id1 = elem->subdomain_id();
-       unsigned int sbd_id2 = elem->neighbor(sides[nbd])->subdomain_id();
-       assert (sbd_id1 != sbd_id2);
-
-       //remove the side from boundary
-       _mesh.boundary_info->remove(elem, sides[nbd]);
-
-       // build the label for the interface, which has the form of RegionLabel1_to_RegionLabel2,
-       // the two region is alpha ordered.
-       std::string bd_label;
-       if( region_array1d[sbd_id1].label < region_array1d[sbd_id2].label)
-         bd_label = region_array1d[sbd_id1].label + "_to_" + region_array1d[sbd_id2].label;
-       else
-         bd_label = region_array1d[sbd_id2].label + "_to_" + region_array1d[sbd_id1].label;
-
-       short int bd_index;
-
-       // if the label already exist
-       if( bd_map.find(bd_label) != bd_map.end() )
-         bd_index = (*bd_map.find(bd_label)).second;
-       else
-       {
-         //else, increase bd_index, insert it into bd_map
-         bd_index = face_array1d.size() + bd_map.size() + 1;
-         bd_map.insert(std::pair<const std::string, short int>(bd_label,bd_index));
-       }
-
-       // add element to boundary again with new bd_index
-       _mesh.boundary_info->add_side(elem, sides[nbd], bd_index);
-    }
-  }
-
-  // after the previous remove and insert operation, the number of boundary id maybe changed. renumber it here.
-  _mesh.boundary_info->rebuild_ids();
-
-  // write down new labels
+  // write down interface labels
   Bd_It bd_it = bd_map.begin();
   for(; bd_it != bd_map.end(); bd_it++)
     _mesh.boundary_info->set_label_to_id( (*bd_it).second, (*bd_it).first );
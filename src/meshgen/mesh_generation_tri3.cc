@@ -25,6 +25,7 @@
 // C++ includes
 #include <cmath> // for std::sqrt
 #include <cstdlib>
+#include <cstring>
 
 // Local includes
 #include "genius_env.h"
@@ -1249,6 +1250,116 @@ int MeshGeneratorTri3::do_mesh()
 
 
 
+namespace
+{
+  /**
+   * one tile of the 2D mesh (a region), which is triangulated alone.
+   * the points are numbered locally, the first n_input points are the mesh nodes in input_nodes,
+   * the rest are the steiner points added by triangle
+   */
+  struct TriTile
+  {
+    bool                               changed;
+    std::vector<unsigned int>          input_nodes;
+    std::vector<Point>                 points;
+    std::vector<std::pair<int, int> >  segments;
+    std::vector<int>                   segment_marks;
+    std::vector<Point>                 holes;
+
+    /**
+     * the result, 3 local points and 3 boundary marks of each triangle
+     */
+    std::vector<int>                   triangles;
+    std::vector<int>                   triangle_marks;
+
+    TriTile() : changed(false) {}
+  };
+
+
+  /**
+   * triangulate the tile with the constrained segments of its boundary.
+   * it only touches the tile, so the tiles can be triangulated by threads
+   */
+  void triangulate_tile(const std::string & cmd, TriTile & tile)
+  {
+#ifdef __triangle_h__
+    triangulateio in, out;
+    memset(&in,  0, sizeof(triangulateio));
+    memset(&out, 0, sizeof(triangulateio));
+
+    in.numberofpoints = tile.points.size();
+    in.pointlist      = (double *) calloc(in.numberofpoints*2, sizeof(double));
+    for(unsigned int i=0; i<tile.points.size(); ++i)
+    {
+      in.pointlist[2*i+0] = tile.points[i](0);
+      in.pointlist[2*i+1] = tile.points[i](1);
+    }
+
+    in.numberofsegments  = tile.segments.size();
+    in.segmentlist       = (int *) calloc(in.numberofsegments*2, sizeof(int));
+    in.segmentmarkerlist = (int *) calloc(in.numberofsegments, sizeof(int));
+    for(unsigned int i=0; i<tile.segments.size(); ++i)
+    {
+      in.segmentlist[2*i+0]   = tile.segments[i].first;
+      in.segmentlist[2*i+1]   = tile.segments[i].second;
+      in.segmentmarkerlist[i] = tile.segment_marks[i];
+    }
+
+    // the cells of other regions enclosed by this tile are holes
+    in.numberofholes = tile.holes.size();
+    in.holelist      = (double *) calloc(in.numberofholes*2, sizeof(double));
+    for(unsigned int i=0; i<tile.holes.size(); ++i)
+    {
+      in.holelist[2*i+0] = tile.holes[i](0);
+      in.holelist[2*i+1] = tile.holes[i](1);
+    }
+
+    triangulate(const_cast<char *>(cmd.c_str()), &in, &out, (struct triangulateio *) NULL);
+
+    // the input points keep their order at the head of output points
+    for(int i=in.numberofpoints; i<out.numberofpoints; ++i)
+      tile.points.push_back(Point(out.pointlist[2*i+0], out.pointlist[2*i+1], 0.0));
+
+    std::map<std::pair<int, int>, int> edge_marks;
+    for(int i=0; i<out.numberofsegments; i++)
+    {
+      int p1 = out.segmentlist[2*i+0];
+      int p2 = out.segmentlist[2*i+1];
+      if(p2 < p1) std::swap(p1, p2);
+      edge_marks[std::make_pair(p1, p2)] = out.segmentmarkerlist[i];
+    }
+
+    tile.triangles.assign(out.trianglelist, out.trianglelist + 3*out.numberoftriangles);
+    tile.triangle_marks.assign(3*out.numberoftriangles, 0);
+    for(int i=0; i<out.numberoftriangles; i++)
+      for(int s=0; s<3; ++s)
+      {
+        int p1 = out.trianglelist[3*i+s];
+        int p2 = out.trianglelist[3*i+(s+1)%3];
+        if(p2 < p1) std::swap(p1, p2);
+        std::map<std::pair<int, int>, int>::const_iterator it = edge_marks.find(std::make_pair(p1, p2));
+        if( it != edge_marks.end() )
+          tile.triangle_marks[3*i+s] = it->second;
+      }
+
+    free(in.pointlist);
+    free(in.segmentlist);
+    free(in.segmentmarkerlist);
+    free(in.holelist);
+
+    free(out.pointlist);
+    free(out.pointattributelist);
+    free(out.pointmarkerlist);
+    free(out.trianglelist);
+    free(out.triangleattributelist);
+    free(out.segmentlist);
+    free(out.segmentmarkerlist);
+#endif
+  }
+}
+
+
+
 /* ----------------------------------------------------------------------------
  * over write the do_refine() virtual function in meshgen base class
  * this is a general mesh refine method for 2D mesh, both TRI and QUAD cells
@@ -1264,132 +1375,141 @@ int MeshGeneratorTri3::do_refine(MeshRefinement & mesh_refinement)
   // call MeshRefinement class to do FEM refine
   mesh_refinement.refine_and_coarsen_elements ();
 
+  // each region is a tile, which is triangulated alone with its boundary segments fixed.
+  // the cells on both sides of a region interface are refined together, so the tiles share
+  // the same interface nodes. a tile untouched by the refinement keeps its triangles.
+  const unsigned int n_tiles = _mesh.n_subdomains();
+  std::vector<TriTile> tiles(n_tiles);
+  {
+    MeshBase::element_iterator elem_it = _mesh.active_elements_begin();
+    for(; elem_it != _mesh.active_elements_end(); ++elem_it)
+    {
+      const Elem * elem = *elem_it;
+      if( elem->refinement_flag() == Elem::JUST_REFINED || elem->refinement_flag() == Elem::JUST_COARSENED ||
+          elem->n_nodes() != 3 )
+        tiles[elem->subdomain_id()].changed = true;
+    }
+  }
+
   // we can simply flat refined mesh to level 0
   // since we do not need these information
   MeshTools::Modification::flatten(_mesh);
 
-  // do necessarily prepare for call triangulate
-  triangulateio_init();
-
-  // prepare point information for triangle io
+  std::vector<Point> old_points(_mesh.max_node_id());
   {
-    in.numberofpoints           = _mesh.max_node_id();
-    in.numberofpointattributes  = 0;
-    in.pointattributelist       = NULL;
-#ifdef __triangle_h__
-    in.pointlist                = (double *)calloc(in.numberofpoints*2, sizeof(double));
-    in.pointmarkerlist          = (int *) calloc(in.numberofpoints, sizeof(int));
-#else
-    in.pointlist                = new double[in.numberofpoints*2];
-    in.pointmarkerlist          = new int[in.numberofpoints];
-#endif
-    // push mesh nodes into triangle io
     MeshBase::node_iterator node_it = _mesh.active_nodes_begin();
-    for(int i=0; node_it != _mesh.active_nodes_end() ; ++i, ++node_it)
-    {
-      in.pointlist[2*i+0] = (*(*node_it))(0);
-      in.pointlist[2*i+1] = (*(*node_it))(1);
-      in.pointmarkerlist[i] = _mesh.boundary_info->boundary_id(*node_it);
-    }
+    for(; node_it != _mesh.active_nodes_end() ; ++node_it)
+      old_points[(*node_it)->id()] = *(*node_it);
   }
 
-  // fill mesh elements into triangle io. in fact no need to do this.
-  std::vector< std::vector<Point> > region_point;
-  region_point.resize(_mesh.n_subdomains());
+  // fill the points, boundary segments and holes of each tile
   {
+    std::vector<std::map<unsigned int, int> > local_index(n_tiles);
 
     MeshBase::element_iterator elem_it = _mesh.active_elements_begin();
     for(; elem_it != _mesh.active_elements_end(); ++elem_it)
     {
-      region_point[(*elem_it)->subdomain_id()].push_back( (*elem_it)->centroid () );
-    }
-
-  }
+      const Elem * elem = *elem_it;
+      TriTile & tile = tiles[elem->subdomain_id()];
+      std::map<unsigned int, int> & local = local_index[elem->subdomain_id()];
 
+      std::vector<int> elem_local(elem->n_nodes());
+      for(unsigned int n=0; n<elem->n_nodes(); ++n)
+      {
+        const unsigned int id = elem->node(n);
+        std::map<unsigned int, int>::iterator it = local.find(id);
+        if( it == local.end() )
+        {
+          it = local.insert(std::make_pair(id, static_cast<int>(tile.input_nodes.size()))).first;
+          tile.input_nodes.push_back(id);
+          tile.points.push_back(old_points[id]);
+        }
+        elem_local[n] = it->second;
+      }
 
-  // set region information
-  std::map<unsigned int, std::pair<std::string, std::string> > region_info_map;
-  {
-    in.numberofholes   = 0;
-    in.numberofregions = _mesh.n_subdomains();
-#ifdef __triangle_h__
-    in.regionlist = (double *) calloc(in.numberofregions*4, sizeof(double));
-#else
-    in.regionlist = new double[in.numberofregions*4];
-#endif
-    double *pregionlist =  in.regionlist;
-    for(int i=0; i<in.numberofregions; i++)
-    {
-      *pregionlist++ = (region_point[i])[0](0);
-      *pregionlist++ = (region_point[i])[0](1);
-      *pregionlist++ = double(i);
-      *pregionlist++ = 0;
-    }
+      for(unsigned int s=0; s<elem->n_sides(); ++s)
+      {
+        const short int bd_id = _mesh.boundary_info->boundary_id(elem, s);
+        if( bd_id != BoundaryInfo::invalid_id )
+        {
+          AutoPtr<Elem> side_elem = elem->build_side(s);
+          tile.segments.push_back(std::make_pair(local[side_elem->node(0)], local[side_elem->node(1)]));
+          tile.segment_marks.push_back(bd_id);
+        }
 
-    for(unsigned int n_sub=0; n_sub<_mesh.n_subdomains(); n_sub++)
-      region_info_map[n_sub] = std::make_pair( _mesh.subdomain_label_by_id(n_sub),_mesh.subdomain_material(n_sub) );
+        const Elem * neighbor = elem->neighbor(s);
+        if( neighbor && neighbor->subdomain_id() != elem->subdomain_id() )
+          tile.holes.push_back(neighbor->centroid());
+      }
 
+      if( !tile.changed )
+      {
+        for(unsigned int n=0; n<3; ++n)
+        {
+          tile.triangles.push_back(elem_local[n]);
+          const short int bd_id = _mesh.boundary_info->boundary_id(elem, n);
+          tile.triangle_marks.push_back(bd_id != BoundaryInfo::invalid_id ? bd_id : 0);
+        }
+      }
+    }
   }
 
-  // set mesh boundary to triangle io
+  // set region information
+  std::map<unsigned int, std::pair<std::string, std::string> > region_info_map;
+  for(unsigned int n_sub=0; n_sub<_mesh.n_subdomains(); n_sub++)
+    region_info_map[n_sub] = std::make_pair( _mesh.subdomain_label_by_id(n_sub),_mesh.subdomain_material(n_sub) );
+
   std::map<short int, std::string> bd_label_map;
   {
-    in.numberofsegments =  _mesh.boundary_info->n_boundary_conds();
-#ifdef __triangle_h__
-    in.segmentlist =  (int *) calloc(in.numberofsegments*2, sizeof(int));
-    in.segmentmarkerlist = (int *) calloc(in.numberofsegments, sizeof(int));
-#else
-    in.segmentlist =  new int[in.numberofsegments*2];
-    in.segmentmarkerlist = new int[in.numberofsegments];
-#endif
-    std::vector<unsigned int>       el;
-    std::vector<unsigned short int> sl;
-    std::vector<short int>          il;
-    _mesh.boundary_info->build_side_list (el, sl, il);
-
-    for(unsigned int i=0; i<el.size(); i++)
-    {
-      AutoPtr<Elem> side_elem = _mesh.elem(el[i])->build_side(sl[i]);
-      in.segmentlist[2*i]   = side_elem->get_node(0)->id();
-      in.segmentlist[2*i+1] = side_elem->get_node(1)->id();
-      in.segmentmarkerlist[i]  = il[i];
-    }
-
     const std::set<short int>& boundary_ids = _mesh.boundary_info->get_boundary_ids();
     std::set<short int>::const_iterator it = boundary_ids.begin();
     for(; it != boundary_ids.end(); ++it)
       bd_label_map[*it] =  _mesh.boundary_info->get_label_by_id(*it);
-
   }
 
-  // rebuild the triangulation mesh
-#ifdef __triangle_h__
-  triangulate(const_cast<char *>(tri_cmd.c_str()), &in, &out, (struct triangulateio *) NULL);
-#else
-  ctri_triangulate(const_cast<char *>(tri_cmd.c_str()), &in, &out);
-#endif
+  // the segments on tile boundary should not be split, else the tiles do not match
+  std::string tile_cmd = tri_cmd;
+  if( tile_cmd.find('Y') == std::string::npos )
+    tile_cmd += "Y";
 
-  // set boundary mark to output edge
-  out_edge_table.clear();
-  for(int i=0; i<out.numberofsegments; i++)
+  // rebuild the triangulation of the changed tiles
   {
-    OutEdge edge;
-    edge.pointno = out.numberofpoints;
-    if(out.segmentlist[2*i+0] < out.segmentlist[2*i+1])
+    std::vector<unsigned int> changed_tiles;
+    for(unsigned int t=0; t<n_tiles; ++t)
+      if( tiles[t].changed && !tiles[t].points.empty() )
+        changed_tiles.push_back(t);
+
+    const int n_changed = changed_tiles.size();
+#pragma omp parallel for schedule(dynamic, 1) num_threads(Genius::n_threads())
+    for(int i=0; i<n_changed; ++i)
+      triangulate_tile(tile_cmd, tiles[changed_tiles[i]]);
+  }
+
+  // stitch the tiles. the shared nodes of tiles are mesh nodes before refinement
+  std::vector<int> node_map(old_points.size(), -1);
+  std::vector<Point> points;
+  std::vector<std::vector<int> > tile_nodes(n_tiles);
+  for(unsigned int t=0; t<n_tiles; ++t)
+  {
+    const TriTile & tile = tiles[t];
+    tile_nodes[t].resize(tile.points.size());
+    for(unsigned int i=0; i<tile.input_nodes.size(); ++i)
     {
-      edge.p1 = out.segmentlist[2*i+0];
-      edge.p2 = out.segmentlist[2*i+1];
+      const unsigned int id = tile.input_nodes[i];
+      if( node_map[id] < 0 )
+      {
+        node_map[id] = points.size();
+        points.push_back(old_points[id]);
+      }
+      tile_nodes[t][i] = node_map[id];
     }
-    else
+    for(unsigned int i=tile.input_nodes.size(); i<tile.points.size(); ++i)
     {
-      edge.p1 = out.segmentlist[2*i+1];
-      edge.p2 = out.segmentlist[2*i+0];
+      tile_nodes[t][i] = points.size();
+      points.push_back(tile.points[i]);
     }
-    edge.mark = out.segmentmarkerlist[i];
-    out_edge_table[edge] = edge.mark;
   }
 
-
   // clear old mesh structure
   _mesh.clear();
 
@@ -1397,34 +1517,28 @@ int MeshGeneratorTri3::do_refine(MeshRefinement & mesh_refinement)
   _mesh.magic_num() = this->magic_num();
 
   // Build the nodes.
-  _mesh.reserve_nodes( out.numberofpoints );
-  _mesh.reserve_elem( out.numberoftriangles );
-
-  for(int i = 0; i < out.numberofpoints; i++)
-    _mesh.add_point(Point(out.pointlist[2*i+0], out.pointlist[2*i+1], 0.0));
+  _mesh.reserve_nodes( points.size() );
+  for(unsigned int i = 0; i < points.size(); i++)
+    _mesh.add_point(points[i]);
 
   // build the elements
-  for(int i = 0; i < out.numberoftriangles; i++)
+  for(unsigned int t=0; t<n_tiles; ++t)
   {
-    Elem* elem = _mesh.add_elem(Elem::build(TRI3).release());
-
-    elem->set_node(0) = _mesh.node_ptr( out.trianglelist[3*i+0] );
-    elem->set_node(1) = _mesh.node_ptr( out.trianglelist[3*i+1] );
-    elem->set_node(2) = _mesh.node_ptr( out.trianglelist[3*i+2] );
-
-    elem->subdomain_id() = static_cast<int>(out.triangleattributelist[i]+0.5);
-
-    int bc_index;
-
-    if( (bc_index = get_bc_id(elem, out.trianglelist[3*i+0], out.trianglelist[3*i+1])) > 0 )
-      _mesh.boundary_info->add_side(elem, 0, bc_index);
+    const TriTile & tile = tiles[t];
+    for(unsigned int i = 0; i < tile.triangles.size()/3; i++)
+    {
+      Elem* elem = _mesh.add_elem(Elem::build(TRI3).release());
 
-    if( (bc_index = get_bc_id(elem, out.trianglelist[3*i+1], out.trianglelist[3*i+2])) > 0 )
-      _mesh.boundary_info->add_side(elem, 1, bc_index);
+      elem->set_node(0) = _mesh.node_ptr( tile_nodes[t][tile.triangles[3*i+0]] );
+      elem->set_node(1) = _mesh.node_ptr( tile_nodes[t][tile.triangles[3*i+1]] );
+      elem->set_node(2) = _mesh.node_ptr( tile_nodes[t][tile.triangles[3*i+2]] );
 
-    if( (bc_index = get_bc_id(elem, out.trianglelist[3*i+2], out.trianglelist[3*i+0])) > 0 )
-      _mesh.boundary_info->add_side(elem, 2, bc_index);
+      elem->subdomain_id() = t;
 
+      for(unsigned int s=0; s<3; ++s)
+        if( tile.triangle_marks[3*i+s] > 0 )
+          _mesh.boundary_info->add_side(elem, s, tile.triangle_marks[3*i+s]);
+    }
   }
 
   // write region label and material info to _mesh
@@ -1441,10 +1555,6 @@ int MeshGeneratorTri3::do_refine(MeshRefinement & mesh_refinement)
   for(; bd_it != bd_label_map.end(); ++bd_it)
     _mesh.boundary_info->set_label_to_id( (*bd_it).first, (*bd_it).second );
 
-
-  // free tri_io structure
-  triangulateio_finalize();
-
   MESSAGE<<"Tri3 mesh successfully Regrided.\n"<<std::endl; RECORD();
 
   STOP_LOG("do_mesh()", "MeshGenerator");
@@ -0,0 +1,225 @@
+#include "config.h"
+#include "genius_env.h"
+#include "pattern.h"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <cstdio>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Parser;
+
+/**
+ * the binary cache of the pattern is a flat dump of the pattern card map:
+ *   magic, version, size and modification time of the xml file it was built from,
+ *   then for each card its key, description and parameters.
+ * strings are stored as length followed by the chars
+ */
+namespace
+{
+  const char         cache_magic[8] = {'G','S','Y','N','T','A','X','\0'};
+  const unsigned int cache_version  = 1;
+
+  template <typename T>
+  void write_raw(std::ostream &out, const T &v)
+  { out.write(reinterpret_cast<const char *>(&v), sizeof(T)); }
+
+  template <typename T>
+  bool read_raw(std::istream &in, T &v)
+  { return in.read(reinterpret_cast<char *>(&v), sizeof(T)).good(); }
+
+  void write_string(std::ostream &out, const std::string &s)
+  {
+    unsigned int len = s.size();
+    write_raw(out, len);
+    out.write(s.data(), len);
+  }
+
+  bool read_string(std::istream &in, std::string &s)
+  {
+    unsigned int len;
+    if( !read_raw(in, len) ) return false;
+    s.resize(len);
+    if( len == 0 ) return true;
+    return in.read(&s[0], len).good();
+  }
+
+  /**
+   * size and modification time of the xml file
+   */
+  bool file_stamp(const std::string &fname, long long &size, long long &mtime)
+  {
+    struct stat st;
+    if( stat(fname.c_str(), &st) != 0 ) return false;
+    size  = st.st_size;
+    mtime = st.st_mtime;
+    return true;
+  }
+}
+
+
+int Pattern::get_from_cache(const std::string &cache_file, const std::string &fname)
+{
+  long long size, mtime;
+  if( !file_stamp(fname, size, mtime) ) return -1;
+
+  std::ifstream in(cache_file.c_str(), std::ios::in | std::ios::binary);
+  if( !in.good() ) return -1;
+
+  char magic[8];
+  unsigned int version;
+  long long cache_size, cache_mtime;
+  if( !in.read(magic, 8).good() || std::string(magic, 8) != std::string(cache_magic, 8) ) return -1;
+  if( !read_raw(in, version) || version != cache_version ) return -1;
+  if( !read_raw(in, cache_size) || !read_raw(in, cache_mtime) ) return -1;
+
+  // the xml file has been modified since the cache was built
+  if( cache_size != size || cache_mtime != mtime ) return -1;
+
+  std::map< std::string, PatternCard> pattern_card_map;
+
+  unsigned int n_cards;
+  if( !read_raw(in, n_cards) ) return -1;
+  for(unsigned int c=0; c<n_cards; ++c)
+  {
+    PatternCard card;
+    if( !read_string(in, card._key) || !read_string(in, card._description) ) return -1;
+
+    unsigned int n_parameters;
+    if( !read_raw(in, n_parameters) ) return -1;
+    for(unsigned int p=0; p<n_parameters; ++p)
+    {
+      Parameter param;
+      std::string name, description;
+      int type;
+      if( !read_string(in, name) || !read_string(in, description) || !read_raw(in, type) ) return -1;
+      param.set_name(name);
+      param.set_description(description);
+
+      switch(type)
+      {
+      case BOOL    : { bool v;   if( !read_raw(in, v) ) return -1; param.set_bool(v); break; }
+      case INTEGER : { int v;    if( !read_raw(in, v) ) return -1; param.set_int(v);  break; }
+      case REAL    : { double v; if( !read_raw(in, v) ) return -1; param.set_real(v); break; }
+      case STRING  :
+      case ENUM    : { std::string v; if( !read_string(in, v) ) return -1; param.set_string(v); break; }
+      default      : return -1;
+      }
+      param.set_type(static_cast<ElemType>(type));
+
+      unsigned int n_enums;
+      if( !read_raw(in, n_enums) ) return -1;
+      for(unsigned int e=0; e<n_enums; ++e)
+      {
+        std::string s;
+        if( !read_string(in, s) ) return -1;
+        param.add_string_pattern(s);
+      }
+
+      card._parameter_map.insert(std::make_pair(param.name(), param));
+    }
+
+    pattern_card_map.insert(std::make_pair(card._key, card));
+  }
+
+  _pattern_card_map.swap(pattern_card_map);
+  return 0;
+}
+
+
+int Pattern::save_to_cache(const std::string &cache_file, const std::string &fname) const
+{
+  long long size, mtime;
+  if( !file_stamp(fname, size, mtime) ) return -1;
+
+  // write to a private file first, several runs may refresh the cache at the same time
+  std::stringstream ss;
+  ss << cache_file << '.' << getpid();
+  const std::string tmp_file = ss.str();
+
+  {
+    std::ofstream out(tmp_file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if( !out.good() ) return -1;
+
+    out.write(cache_magic, 8);
+    write_raw(out, cache_version);
+    write_raw(out, size);
+    write_raw(out, mtime);
+
+    unsigned int n_cards = _pattern_card_map.size();
+    write_raw(out, n_cards);
+
+    std::map< std::string, PatternCard>::const_iterator it = _pattern_card_map.begin();
+    for( ; it != _pattern_card_map.end(); ++it)
+    {
+      const PatternCard & card = it->second;
+      write_string(out, card._key);
+      write_string(out, card._description);
+
+      unsigned int n_parameters = card._parameter_map.size();
+      write_raw(out, n_parameters);
+
+      std::map<std::string, Parameter>::const_iterator pp = card._parameter_map.begin();
+      for( ; pp != card._parameter_map.end(); ++pp)
+      {
+        const Parameter & param = pp->second;
+        write_string(out, param.name());
+        write_string(out, param.description());
+        int type = param.type();
+        write_raw(out, type);
+
+        switch(param.type())
+        {
+        case BOOL    : write_raw(out, param.get_bool()); break;
+        case INTEGER : write_raw(out, param.get_int());  break;
+        case REAL    : write_raw(out, param.get_real()); break;
+        default      : write_string(out, param.get_string()); break;
+        }
+
+        unsigned int n_enums = std::distance(param.stringPatternBegin(), param.stringPatternEnd());
+        write_raw(out, n_enums);
+        for(Parameter::StringEnumIterator e = param.stringPatternBegin(); e != param.stringPatternEnd(); ++e)
+          write_string(out, *e);
+      }
+    }
+
+    if( !out.good() )
+    {
+      out.close();
+      remove(tmp_file.c_str());
+      return -1;
+    }
+  }
+
+  if( rename(tmp_file.c_str(), cache_file.c_str()) != 0 )
+  {
+    remove(tmp_file.c_str());
+    return -1;
+  }
+
+  return 0;
+}
+
+
+int Pattern::get_from_XML(const std::string &fname, const std::string &cache_file)
+{
+  if( cache_file.empty() )
+    return get_from_XML(fname);
+
+  if( get_from_cache(cache_file, fname) == 0 )
+    return 0;
+
+  _pattern_card_map.clear();
+  if( get_from_XML(fname) )
+    return -1;
+
+  // the cache directory may be read only, it is not an error
+  if( Genius::is_first_processor() )
+    save_to_cache(cache_file, fname);
+
+  return 0;
+}
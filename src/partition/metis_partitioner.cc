@@ -69,8 +69,9 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
 
   std::vector<int> xadj;
   std::vector<int> adjncy;
+  std::vector<int> adjwgt;
   std::vector<int> options(8);
-  std::vector<int> vwgt(n_active_elem);
+  std::vector<int> vwgt(2*n_active_elem);
   std::vector<int> part(n_active_elem);
 
   xadj.reserve(n_active_elem+1);
@@ -78,8 +79,8 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
   int
     n = static_cast<int>(n_active_elem),  // number of "nodes" (elements)
                                           //   in the graph
-    wgtflag = 2,                          // weights on vertices only,
-                                          //   none on edges
+    ncon = 1,                             // number of vertex weights
+    wgtflag = 3,                          // weights on both vertices and edges
     numflag = 0,                          // C-style 0-based numbering
     nparts  = static_cast<int>(n_pieces), // number of subdomains to create
     edgecut = 0;                          // the numbers of edges cut by the
@@ -123,6 +124,7 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
     // This will be exact when there is no refinement and all the
     // elements are of the same type.
     adjncy.reserve (n_active_elem*(*elem_it)->n_neighbors());
+    adjwgt.reserve (n_active_elem*(*elem_it)->n_neighbors());
 
     for (; elem_it != elem_end; ++elem_it)
       {
@@ -131,8 +133,10 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
 	assert (elem->id() < forward_map.size());
 	assert (forward_map[elem->id()] != invalid_uint);
 
-	// The weight is used to define what a balanced graph is
-	vwgt[forward_map[elem->id()]] = mesh.subdomain_weight( elem->subdomain_id () ) * elem->n_nodes();
+	// The weight is used to define what a balanced graph is,
+	// both the dofs and the boundary condition sides should be balanced
+	vwgt[2*forward_map[elem->id()]]   = mesh.partition_dof_weight(elem);
+	vwgt[2*forward_map[elem->id()]+1] = mesh.partition_bc_weight(elem);
 
 	// The beginning of the adjacency array for this elem
 	xadj.push_back(adjncy.size());
@@ -153,6 +157,7 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
 		    assert (forward_map[neighbor->id()] != invalid_uint);
 
 		    adjncy.push_back (forward_map[neighbor->id()]);
+		    adjwgt.push_back (mesh.partition_edge_weight(elem, neighbor));
 		  }
 
 #ifdef ENABLE_AMR
@@ -189,6 +194,7 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
 			    assert (forward_map[child->id()] != invalid_uint);
 
 			    adjncy.push_back (forward_map[child->id()]);
+			    adjwgt.push_back (mesh.partition_edge_weight(elem, child));
 			  }
 		      }
 		  }
@@ -206,21 +212,55 @@ void MetisPartitioner::_do_partition (MeshBase& mesh,
 
 
   if (adjncy.empty())
-    adjncy.push_back(0);
+    {
+      adjncy.push_back(0);
+      adjwgt.push_back(1);
+    }
+
+  // balance the boundary condition sides as the second constraint,
+  // only when there are weighted boundary sides, else the constraint is empty
+  {
+    int bc_weight = 0;
+    for (unsigned int i=0; i<n_active_elem; ++i)
+      bc_weight += vwgt[2*i+1];
+    if (bc_weight > 0)
+      ncon = 2;
+    else
+      for (unsigned int i=0; i<n_active_elem; ++i)
+        vwgt[i] = vwgt[2*i];
+  }
 
   // Select which type of partitioning to create
 
   // Use recursive if the number of partitions is less than or equal to 8
   if (n_pieces <= 8)
-    Metis::METIS_PartGraphRecursive(&n, &xadj[0], &adjncy[0], &vwgt[0], NULL,
-				    &wgtflag, &numflag, &nparts, &options[0],
-				    &edgecut, &part[0]);
+    {
+      if (ncon > 1)
+        Metis::METIS_mCPartGraphRecursive(&n, &ncon, &xadj[0], &adjncy[0], &vwgt[0], &adjwgt[0],
+                                          &wgtflag, &numflag, &nparts, &options[0],
+                                          &edgecut, &part[0]);
+      else
+        Metis::METIS_PartGraphRecursive(&n, &xadj[0], &adjncy[0], &vwgt[0], &adjwgt[0],
+                                        &wgtflag, &numflag, &nparts, &options[0],
+                                        &edgecut, &part[0]);
+    }
 
   // Otherwise  use kway
   else
-    Metis::METIS_PartGraphKway(&n, &xadj[0], &adjncy[0], &vwgt[0], NULL,
-			       &wgtflag, &numflag, &nparts, &options[0],
-			       &edgecut, &part[0]);
+    {
+      if (ncon > 1)
+        {
+          // the allowed load imbalance of each constraint
+          std::vector<float> ubvec(ncon, 1.05);
+          Metis::METIS_mCPartGraphKway(&n, &ncon, &xadj[0], &adjncy[0], &vwgt[0], &adjwgt[0],
+                                       &wgtflag, &numflag, &nparts, &ubvec[0], &options[0],
+                                       &edgecut, &part[0]);
+        }
+      else
+        Metis::METIS_PartGraphKway(&n, &xadj[0], &adjncy[0], &vwgt[0], &adjwgt[0],
+                                   &wgtflag, &numflag, &nparts, &options[0],
+                                   &edgecut, &part[0]);
+    }
 
 
   // Assign the returned processor ids.  The part array contains
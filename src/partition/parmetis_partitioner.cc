@@ -0,0 +1,230 @@
+// $Id: parmetis_partitioner.cc,v 1.1 2008/05/22 04:53:44 gdiso Exp $
+
+// The libMesh Finite Element Library.
+// Copyright (C) 2002-2007  Benjamin S. Kirk, John W. Peterson
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+
+// C++ Includes   -----------------------------------
+#include <vector>
+#include <algorithm>
+
+// Local Includes -----------------------------------
+#include "mesh_base.h"
+#include "parmetis_partitioner.h"
+#include "metis_partitioner.h"
+#include "parallel.h"
+#include "perf_log.h"
+#include "elem.h"
+
+#include "petscmat.h"
+
+#if defined(HAVE_MPI) && (defined(PETSC_HAVE_PARMETIS) || defined(PETSC_HAVE_PTSCOTCH))
+#define HAVE_PARALLEL_PARTITIONER
+#endif
+
+
+// ------------------------------------------------------------
+// ParmetisPartitioner implementation
+bool ParmetisPartitioner::available ()
+{
+#ifdef HAVE_PARALLEL_PARTITIONER
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+
+void ParmetisPartitioner::_do_partition (MeshBase& mesh,
+					 const unsigned int n_pieces)
+{
+  assert (n_pieces > 0);
+
+  // Check for an easy return
+  if (n_pieces == 1)
+    {
+      this->single_partition (mesh);
+      return;
+    }
+
+#ifndef HAVE_PARALLEL_PARTITIONER
+  // no parallel partitioner, use serial one
+  MetisPartitioner metis;
+  metis.partition (mesh, n_pieces);
+  return;
+#else
+
+  // the graph will not be distributed on a single processor
+  if (Genius::n_processors() == 1)
+    {
+      MetisPartitioner metis;
+      metis.partition (mesh, n_pieces);
+      return;
+    }
+
+  START_LOG("partition()", "ParmetisPartitioner");
+
+  const unsigned int n_active_elem = mesh.n_active_elem();
+  const unsigned int n_elem        = mesh.n_elem();
+
+  // map each active element id into a contiguous block of indices
+  std::vector<unsigned int> forward_map (n_elem, invalid_uint);
+  {
+    MeshBase::element_iterator       elem_it  = mesh.active_elements_begin();
+    const MeshBase::element_iterator elem_end = mesh.active_elements_end();
+
+    unsigned int el_num = 0;
+    for (; elem_it != elem_end; ++elem_it)
+      forward_map[(*elem_it)->id()] = el_num++;
+
+    assert (el_num == n_active_elem);
+  }
+
+  // each processor owns the graph vertex [vertex_begin, vertex_end)
+  const unsigned int n_procs = Genius::n_processors();
+  const unsigned int rank    = Genius::processor_id();
+  const unsigned int vertex_begin = rank*(n_active_elem/n_procs) + std::min(rank, n_active_elem%n_procs);
+  const unsigned int n_local_vertex = n_active_elem/n_procs + (rank < n_active_elem%n_procs ? 1 : 0);
+  const unsigned int vertex_end = vertex_begin + n_local_vertex;
+
+  // build the local rows of the graph in CSR format, the edges in
+  // the graph correspond to face neighbors
+  std::vector<PetscInt> xadj;
+  std::vector<PetscInt> adjncy;
+  std::vector<PetscInt> adjwgt;
+  std::vector<PetscInt> vwgt;
+  xadj.reserve(n_local_vertex+1);
+  vwgt.reserve(n_local_vertex);
+  {
+    std::vector<const Elem*> neighbors_offspring;
+
+    MeshBase::element_iterator       elem_it  = mesh.active_elements_begin();
+    const MeshBase::element_iterator elem_end = mesh.active_elements_end();
+
+    for (; elem_it != elem_end; ++elem_it)
+      {
+	const Elem* elem = *elem_it;
+
+	const unsigned int vertex = forward_map[elem->id()];
+	if (vertex < vertex_begin || vertex >= vertex_end) continue;
+
+	// The weight is used to define what a balanced graph is
+	vwgt.push_back(mesh.partition_weight(elem));
+
+	// The beginning of the adjacency array for this elem
+	xadj.push_back(adjncy.size());
+
+	for (unsigned int ms=0; ms<elem->n_neighbors(); ms++)
+	  {
+	    const Elem* neighbor = elem->neighbor(ms);
+	    if (neighbor == NULL) continue;
+
+	    if (neighbor->active())
+	      {
+		adjncy.push_back (forward_map[neighbor->id()]);
+		adjwgt.push_back (mesh.partition_edge_weight(elem, neighbor));
+		continue;
+	      }
+
+#ifdef ENABLE_AMR
+	    // the active children of the neighbor that live on our side
+	    const unsigned int ns = neighbor->which_neighbor_am_i (elem);
+	    neighbor->active_family_tree (neighbors_offspring);
+	    for (unsigned int nc=0; nc<neighbors_offspring.size(); nc++)
+	      if (neighbors_offspring[nc]->neighbor(ns) == elem)
+		{
+		  adjncy.push_back (forward_map[neighbors_offspring[nc]->id()]);
+		  adjwgt.push_back (mesh.partition_edge_weight(elem, neighbors_offspring[nc]));
+		}
+#endif
+	  }
+      }
+
+    // The end of the adjacency array for the last elem
+    xadj.push_back(adjncy.size());
+  }
+
+  genius_assert(vwgt.size() == n_local_vertex);
+
+  // MatCreateMPIAdj and MatPartitioningSetVertexWeights take over the arrays,
+  // they should be allocated by PetscMalloc.
+  // the edge weights discourage cuts through region interfaces and electrodes
+  PetscErrorCode ierr;
+  PetscInt *ia, *ja, *values, *weights;
+  ierr = PetscMalloc((xadj.size())*sizeof(PetscInt), &ia); genius_assert(!ierr);
+  ierr = PetscMalloc((adjncy.size()+1)*sizeof(PetscInt), &ja); genius_assert(!ierr);
+  ierr = PetscMalloc((adjwgt.size()+1)*sizeof(PetscInt), &values); genius_assert(!ierr);
+  ierr = PetscMalloc((vwgt.size()+1)*sizeof(PetscInt), &weights); genius_assert(!ierr);
+  std::copy(xadj.begin(), xadj.end(), ia);
+  std::copy(adjncy.begin(), adjncy.end(), ja);
+  std::copy(adjwgt.begin(), adjwgt.end(), values);
+  std::copy(vwgt.begin(), vwgt.end(), weights);
+
+  Mat adj;
+  ierr = MatCreateMPIAdj(PETSC_COMM_WORLD, n_local_vertex, n_active_elem, ia, ja, values, &adj); genius_assert(!ierr);
+
+  MatPartitioning part;
+  ierr = MatPartitioningCreate(PETSC_COMM_WORLD, &part); genius_assert(!ierr);
+  ierr = MatPartitioningSetAdjacency(part, adj); genius_assert(!ierr);
+  ierr = MatPartitioningSetNParts(part, n_pieces); genius_assert(!ierr);
+  ierr = MatPartitioningSetVertexWeights(part, weights); genius_assert(!ierr);
+#ifdef PETSC_HAVE_PARMETIS
+  ierr = MatPartitioningSetType(part, MATPARTITIONINGPARMETIS); genius_assert(!ierr);
+#else
+  ierr = MatPartitioningSetType(part, MATPARTITIONINGPTSCOTCH); genius_assert(!ierr);
+#endif
+  // user may choose the partitioner by -mat_partitioning_type
+  ierr = MatPartitioningSetFromOptions(part); genius_assert(!ierr);
+
+  IS is;
+  ierr = MatPartitioningApply(part, &is); genius_assert(!ierr);
+
+  // gather the part of all the vertex to every processor
+  std::vector<int> part_id(n_local_vertex);
+  {
+    const PetscInt * indices;
+    ierr = ISGetIndices(is, &indices); genius_assert(!ierr);
+    for (unsigned int n=0; n<n_local_vertex; ++n)
+      part_id[n] = indices[n];
+    ierr = ISRestoreIndices(is, &indices); genius_assert(!ierr);
+  }
+  Parallel::allgather(part_id);
+  genius_assert(part_id.size() == n_active_elem);
+
+  ierr = ISDestroy(is); genius_assert(!ierr);
+  ierr = MatPartitioningDestroy(part); genius_assert(!ierr);
+  ierr = MatDestroy(adj); genius_assert(!ierr);
+
+  // Assign the returned processor ids
+  {
+    MeshBase::element_iterator       elem_it  = mesh.active_elements_begin();
+    const MeshBase::element_iterator elem_end = mesh.active_elements_end();
+
+    for (; elem_it != elem_end; ++elem_it)
+      {
+	Elem* elem = *elem_it;
+	elem->processor_id() = static_cast<short int>(part_id[forward_map[elem->id()]]);
+      }
+  }
+
+  STOP_LOG("partition()", "ParmetisPartitioner");
+
+#endif
+}
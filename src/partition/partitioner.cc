@@ -21,6 +21,9 @@
 
 // C++ Includes   -----------------------------------
 #include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
 
 // Local Includes -----------------------------------
 #include "partitioner.h"
@@ -56,9 +59,24 @@ void Partitioner::repartition (MeshBase& mesh,
   // Set the number of partitions in the mesh
   mesh.set_n_partitions()=n;
 
+  // Record the processor ids before repartition. after mesh refinement,
+  // the children elements hold the processor id of their parent
+  std::vector<unsigned int> old_pid;
+  old_pid.reserve(mesh.n_active_elem());
+  {
+    MeshBase::element_iterator       elem_it  = mesh.active_elements_begin();
+    const MeshBase::element_iterator elem_end = mesh.active_elements_end();
+
+    for ( ; elem_it != elem_end; ++elem_it)
+      old_pid.push_back((*elem_it)->valid_processor_id() ? (*elem_it)->processor_id() : invalid_uint);
+  }
+
   // Call the partitioning function
   this->_do_repartition(mesh,n);
 
+  // Keep the elements on their old processor as much as possible
+  this->_remap_processor_ids(mesh, old_pid, n);
+
   // Set the node's processor ids
   this->_set_node_processor_ids(mesh);
 }
@@ -97,6 +115,74 @@ void Partitioner::single_partition (MeshBase& mesh)
 
 
 
+void Partitioner::_remap_processor_ids(MeshBase& mesh,
+                                       const std::vector<unsigned int> & old_pid,
+                                       const unsigned int n)
+{
+  START_LOG("remap_processor_ids()", "Partitioner");
+
+  // the weight of elements in new subdomain i which were on old processor j
+  std::map< std::pair<unsigned int, unsigned int>, int > overlap;
+  {
+    MeshBase::element_iterator       elem_it  = mesh.active_elements_begin();
+    const MeshBase::element_iterator elem_end = mesh.active_elements_end();
+
+    for (unsigned int i=0; elem_it != elem_end; ++elem_it, ++i)
+    {
+      const Elem* elem = *elem_it;
+      if (old_pid[i] >= n) continue;
+      overlap[std::make_pair(static_cast<unsigned int>(elem->processor_id()), old_pid[i])] += mesh.partition_weight(elem);
+    }
+  }
+
+  // greedy matching, the pair with the largest overlap is matched first
+  std::vector< std::pair<int, std::pair<unsigned int, unsigned int> > > pairs;
+  std::map< std::pair<unsigned int, unsigned int>, int >::const_iterator it = overlap.begin();
+  for ( ; it != overlap.end(); ++it)
+    pairs.push_back(std::make_pair(it->second, it->first));
+  std::sort(pairs.begin(), pairs.end(), std::greater< std::pair<int, std::pair<unsigned int, unsigned int> > >());
+
+  std::vector<unsigned int> new_to_old(n, invalid_uint);
+  std::vector<bool> old_used(n, false);
+  for (unsigned int p=0; p<pairs.size(); ++p)
+  {
+    const unsigned int new_id = pairs[p].second.first;
+    const unsigned int old_id = pairs[p].second.second;
+    if (new_id >= n || new_to_old[new_id] != invalid_uint || old_used[old_id]) continue;
+    new_to_old[new_id] = old_id;
+    old_used[old_id]   = true;
+  }
+
+  // the unmatched subdomains take the unused processor ids in order
+  unsigned int next_old = 0;
+  for (unsigned int new_id=0; new_id<n; ++new_id)
+  {
+    if (new_to_old[new_id] != invalid_uint) continue;
+    while (old_used[next_old]) ++next_old;
+    new_to_old[new_id] = next_old;
+    old_used[next_old] = true;
+  }
+
+  // Assign the relabeled processor ids
+  {
+    MeshBase::element_iterator       elem_it  = mesh.active_elements_begin();
+    const MeshBase::element_iterator elem_end = mesh.active_elements_end();
+
+    for ( ; elem_it != elem_end; ++elem_it)
+    {
+      Elem* elem = *elem_it;
+      if (elem->processor_id() < n)
+        elem->processor_id() = static_cast<unsigned short int>(new_to_old[elem->processor_id()]);
+    }
+  }
+
+  STOP_LOG("remap_processor_ids()", "Partitioner");
+}
+
+
+
+
+
 void Partitioner::_set_node_processor_ids(MeshBase& mesh)
 {
   // Unset any previously-set node processor ids
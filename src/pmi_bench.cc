@@ -0,0 +1,325 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+// standalone benchmark of the semiconductor material models.
+//
+// usage: genius_pmi_bench [-bench_material Si,GaAs,...] [-bench_n N]
+//                         [-bench_band model] [-bench_mobility model] [-bench_impact model]
+//                         [-bench_trap model] [-bench_thermal model]
+//
+// each material (default: every semiconductor in material.def which has a material
+// library in $GENIUS_DIR/lib) is instantiated through the normal PMI factory, attached
+// to a free standing semiconductor region and mapped to a single node. the model of a
+// PMI type can be replaced by -bench_<type>, i.e. -bench_mobility Lombardi.
+//
+// the band, mobility, impact, trap and thermal functions are swept N times over a
+// grid of n, p, T and E, both with PetscScalar and AutoDScalar arguments (4 AD
+// directions), and the cost per call is reported in ns.
+
+
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "genius_common.h"
+#include "genius_env.h"
+#include "log.h"
+#include "material_define.h"
+#include "material.h"
+#include "physical_unit.h"
+#include "parser.h"
+#include "semiconductor_region.h"
+#include "fvm_node_data_semiconductor.h"
+#include "data_storage.h"
+#include "point.h"
+
+
+#ifdef CYGWIN
+  #include <io.h>      // for windows _access function
+#else
+  #include <unistd.h>  // for POSIX access function
+#endif
+
+using PhysicalUnit::cm;
+using PhysicalUnit::V;
+using PhysicalUnit::K;
+
+
+/**
+ * one point of the sweep grid
+ */
+struct BenchPoint
+{
+  PetscScalar n, p, T, E;
+  AutoDScalar n_ad, p_ad, T_ad, E_ad;
+};
+
+
+/**
+ * time expr over all the grid points, repeated n_repeat times.
+ * the results are summed into a sink so the calls can not be optimized out
+ */
+#define PMI_BENCH(label, expr)                                                   \
+  {                                                                              \
+    PetscScalar sink = 0.0;                                                      \
+    PetscLogDouble t0, t1;                                                       \
+    PetscGetTime(&t0);                                                           \
+    for(unsigned int r=0; r<n_repeat; ++r)                                       \
+      for(unsigned int i=0; i<grid.size(); ++i)                                  \
+      {                                                                          \
+        const BenchPoint & g = grid[i];                                          \
+        sink += (expr);                                                          \
+      }                                                                          \
+    PetscGetTime(&t1);                                                           \
+    report(label, (t1-t0)/(n_repeat*grid.size()), sink);                         \
+  }
+
+
+static void report(const std::string &label, PetscLogDouble t, PetscScalar sink)
+{
+  std::stringstream ss;
+  ss << "  " << std::left << std::setw(32) << label << std::right
+     << std::setw(12) << std::fixed << std::setprecision(1) << t*1e9 << " ns/call"
+     << (sink==sink ? "" : "  (NaN)") << '\n';
+  MESSAGE<<ss.str(); RECORD();
+}
+
+
+static void bench_material(const std::string &material, const std::map<std::string, std::string> &models, unsigned int n_repeat);
+
+
+// --------------------------------------------------------
+// The entrance of GENIUS material model benchmark
+int main(int argc, char ** args)
+{
+  Genius::init_processors(&argc, &args);
+
+  // test if GENIUS_DIR has been set correctly
+  if( getenv("GENIUS_DIR") == NULL )
+  {
+    PetscPrintf(PETSC_COMM_WORLD,"ERROR: User should set entironment variable GENIUS_DIR.\n");
+    PetscFinalize();
+    exit(0);
+  }
+  Genius::set_genius_dir(getenv("GENIUS_DIR"));
+
+  PetscBool     flg;
+
+  // repetitions of the grid sweep
+  PetscInt n_repeat = 20;
+  PetscOptionsGetInt(PETSC_NULL, "-bench_n", &n_repeat, &flg);
+  if( n_repeat < 1 ) n_repeat = 1;
+
+  // comma separated material list
+  char material_list[1024] = "";
+  PetscOptionsGetString(PETSC_NULL, "-bench_material", material_list, 1023, &flg);
+
+  // replace the default model of PMI type
+  std::map<std::string, std::string> models;
+  const char * pmi_types[] = {"band", "mobility", "impact", "trap", "thermal"};
+  for(unsigned int n=0; n<sizeof(pmi_types)/sizeof(pmi_types[0]); ++n)
+  {
+    char model[256];
+    std::string option = std::string("-bench_") + pmi_types[n];
+    PetscOptionsGetString(PETSC_NULL, option.c_str(), model, 255, &flg);
+    if( flg ) models[pmi_types[n]] = model;
+  }
+
+  // console log only
+  if (Genius::processor_id() == 0)
+    genius_log.addStream("console", std::cerr.rdbuf());
+
+  std::string material_file = Genius::genius_dir() +  "/lib/material.def";
+  Material::init_material_define(material_file);
+
+  std::vector<std::string> materials;
+  if( std::string(material_list).empty() )
+  {
+    std::vector<unsigned int> ids = Material::get_material_ids();
+    for(unsigned int n=0; n<ids.size(); ++n)
+    {
+      std::string material = Material::get_material_by_id(ids[n]);
+      if( !Material::IsSemiconductor(material) ) continue;
+      if( std::find(materials.begin(), materials.end(), material) != materials.end() ) continue;
+
+      // only the materials with library in this installation
+#ifdef CYGWIN
+      std::string filename = Genius::genius_dir() + "\\lib\\lib" + Material::FormatMaterialString(material) + ".dll";
+      if ( _access( filename.c_str(),  04 ) == -1 ) continue;
+#else
+      std::string filename = Genius::genius_dir() + "/lib/lib" + Material::FormatMaterialString(material) + ".so";
+      if ( access( filename.c_str(),  R_OK ) == -1 ) continue;
+#endif
+      materials.push_back(material);
+    }
+  }
+  else
+  {
+    std::stringstream ss(material_list);
+    std::string material;
+    while( std::getline(ss, material, ',') )
+    {
+      if( material.empty() ) continue;
+      if( !Material::IsSemiconductor(material) )
+      {
+        MESSAGE<<"ERROR: " << material << " is not a semiconductor material.\n"; RECORD();
+        genius_error();
+      }
+      materials.push_back(material);
+    }
+  }
+
+  MESSAGE<<"Material model benchmark: " << n_repeat << " repetitions\n\n"; RECORD();
+
+  for(unsigned int n=0; n<materials.size(); ++n)
+    bench_material(materials[n], models, n_repeat);
+
+  if (Genius::processor_id() == 0)
+    genius_log.removeStream("console");
+
+  Genius::clean_processors();
+  return 0;
+}
+
+
+
+/**
+ * sweep the PMIS functions of one material
+ */
+static void bench_material(const std::string &material, const std::map<std::string, std::string> &models, unsigned int n_repeat)
+{
+  // free standing region, it holds the material and the variable table
+  SemiconductorSimulationRegion region("bench", material, 300.0*K);
+
+  std::map<std::string, std::string>::const_iterator it = models.begin();
+  for( ; it != models.end(); ++it)
+  {
+    std::vector<Parser::Parameter> pmi_parameters;
+    region.set_pmi(it->first, it->second, pmi_parameters);
+  }
+
+  Material::MaterialSemiconductor * mt = region.material();
+
+  // one node with moderate doping
+  DataStorage storage;
+  storage.allocate_scalar_variable( std::vector<bool>(FVM_Semiconductor_NodeData::n_scalar(), true) );
+  storage.allocate_complex_variable( std::vector<bool>(FVM_Semiconductor_NodeData::n_complex(), true) );
+  storage.allocate_vector_variable( std::vector<bool>(FVM_Semiconductor_NodeData::n_vector(), true) );
+  storage.allocate_tensor_variable( std::vector<bool>(FVM_Semiconductor_NodeData::n_tensor(), true) );
+  FVM_Semiconductor_NodeData node_data(&storage, region.region_point_variables());
+  node_data.Na() = 1e15*std::pow(cm, -3);
+  node_data.Nd() = 1e17*std::pow(cm, -3);
+  node_data.T()  = 300.0*K;
+  node_data.n()  = 1e17*std::pow(cm, -3);
+  node_data.p()  = 1e3*std::pow(cm, -3);
+
+  const Point point(0.0, 0.0, 0.0);
+  mt->mapping(&point, &node_data, 0.0);
+
+  // n, p and E in log scale, T in linear scale. AD direction 0 to 3 are n, p, T and E
+  adtl::AutoDScalar::numdir = 4;
+  mt->set_ad_num(adtl::AutoDScalar::numdir);
+
+  std::vector<BenchPoint> grid;
+  const PetscScalar T_grid[] = {250.0, 300.0, 350.0, 400.0, 500.0};
+  for(int in=8; in<=20; in+=2)
+    for(int ip=8; ip<=20; ip+=2)
+      for(unsigned int iT=0; iT<sizeof(T_grid)/sizeof(T_grid[0]); ++iT)
+        for(int iE=2; iE<=6; ++iE)
+        {
+          BenchPoint g;
+          g.n = std::pow(10.0, in)*std::pow(cm, -3);
+          g.p = std::pow(10.0, ip)*std::pow(cm, -3);
+          g.T = T_grid[iT]*K;
+          g.E = std::pow(10.0, iE)*V/cm;
+          g.n_ad = g.n;  g.n_ad.setADValue(0, 1.0);
+          g.p_ad = g.p;  g.p_ad.setADValue(1, 1.0);
+          g.T_ad = g.T;  g.T_ad.setADValue(2, 1.0);
+          g.E_ad = g.E;  g.E_ad.setADValue(3, 1.0);
+          grid.push_back(g);
+        }
+
+  const PetscScalar Eg = mt->band->Eg(300.0*K);
+  const AutoDScalar Eg_ad = Eg;
+
+  MESSAGE<<"Material " << material << ", " << grid.size() << " grid points\n"; RECORD();
+
+  if( mt->band )
+  {
+    PMI_BENCH("Eg(T)",                    mt->band->Eg(g.T));
+    PMI_BENCH("EgNarrow(p,n,T)",          mt->band->EgNarrow(g.p, g.n, g.T));
+    PMI_BENCH("Nc(T)",                    mt->band->Nc(g.T));
+    PMI_BENCH("Nv(T)",                    mt->band->Nv(g.T));
+    PMI_BENCH("nie(p,n,T)",               mt->band->nie(g.p, g.n, g.T));
+    PMI_BENCH("R_SHR(p,n,T)",             mt->band->R_SHR(g.p, g.n, g.T));
+    PMI_BENCH("R_Auger(p,n,T)",           mt->band->R_Auger(g.p, g.n, g.T));
+    PMI_BENCH("Recomb(p,n,T)",            mt->band->Recomb(g.p, g.n, g.T));
+    PMI_BENCH("Eg(T) AD",                 mt->band->Eg(g.T_ad).getValue());
+    PMI_BENCH("EgNarrow(p,n,T) AD",       mt->band->EgNarrow(g.p_ad, g.n_ad, g.T_ad).getValue());
+    PMI_BENCH("Nc(T) AD",                 mt->band->Nc(g.T_ad).getValue());
+    PMI_BENCH("Nv(T) AD",                 mt->band->Nv(g.T_ad).getValue());
+    PMI_BENCH("nie(p,n,T) AD",            mt->band->nie(g.p_ad, g.n_ad, g.T_ad).getValue());
+    PMI_BENCH("R_SHR(p,n,T) AD",          mt->band->R_SHR(g.p_ad, g.n_ad, g.T_ad).getValue());
+    PMI_BENCH("R_Auger(p,n,T) AD",        mt->band->R_Auger(g.p_ad, g.n_ad, g.T_ad).getValue());
+    PMI_BENCH("Recomb(p,n,T) AD",         mt->band->Recomb(g.p_ad, g.n_ad, g.T_ad).getValue());
+  }
+
+  if( mt->mob )
+  {
+    // the transverse field is taken as a tenth of the parallel field
+    PMI_BENCH("ElecMob(p,n,T,Ep,Et,Tn)",    mt->mob->ElecMob(g.p, g.n, g.T, g.E, 0.1*g.E, g.T));
+    PMI_BENCH("HoleMob(p,n,T,Ep,Et,Tp)",    mt->mob->HoleMob(g.p, g.n, g.T, g.E, 0.1*g.E, g.T));
+    PMI_BENCH("ElecMob(p,n,T,Ep,Et,Tn) AD", mt->mob->ElecMob(g.p_ad, g.n_ad, g.T_ad, g.E_ad, 0.1*g.E_ad, g.T_ad).getValue());
+    PMI_BENCH("HoleMob(p,n,T,Ep,Et,Tp) AD", mt->mob->HoleMob(g.p_ad, g.n_ad, g.T_ad, g.E_ad, 0.1*g.E_ad, g.T_ad).getValue());
+  }
+
+  if( mt->gen )
+  {
+    PMI_BENCH("ElecGenRate(T,Ep,Eg)",     mt->gen->ElecGenRate(g.T, g.E, Eg));
+    PMI_BENCH("HoleGenRate(T,Ep,Eg)",     mt->gen->HoleGenRate(g.T, g.E, Eg));
+    PMI_BENCH("ElecGenRate(T,Ep,Eg) AD",  mt->gen->ElecGenRate(g.T_ad, g.E_ad, Eg_ad).getValue());
+    PMI_BENCH("HoleGenRate(T,Ep,Eg) AD",  mt->gen->HoleGenRate(g.T_ad, g.E_ad, Eg_ad).getValue());
+  }
+
+  if( mt->trap )
+  {
+    const PetscScalar ni = mt->band->ni(300.0*K);
+    const AutoDScalar ni_ad = ni;
+    PMI_BENCH("ElectronTrapRate(n,ni,T)",    mt->trap->ElectronTrapRate(true, g.n, ni, g.T));
+    PMI_BENCH("HoleTrapRate(p,ni,T)",        mt->trap->HoleTrapRate(true, g.p, ni, g.T));
+    PMI_BENCH("ElectronTrapRate(n,ni,T) AD", mt->trap->ElectronTrapRate(true, g.n_ad, ni_ad, g.T_ad).getValue());
+    PMI_BENCH("HoleTrapRate(p,ni,T) AD",     mt->trap->HoleTrapRate(true, g.p_ad, ni_ad, g.T_ad).getValue());
+  }
+
+  if( mt->thermal )
+  {
+    PMI_BENCH("HeatCapacity(T)",          mt->thermal->HeatCapacity(g.T));
+    PMI_BENCH("HeatConduction(T)",        mt->thermal->HeatConduction(g.T));
+    PMI_BENCH("HeatCapacity(T) AD",       mt->thermal->HeatCapacity(g.T_ad).getValue());
+    PMI_BENCH("HeatConduction(T) AD",     mt->thermal->HeatConduction(g.T_ad).getValue());
+  }
+
+  MESSAGE<<'\n'; RECORD();
+}
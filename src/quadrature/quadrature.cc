@@ -36,33 +36,44 @@ void QBase::init(const ElemType t,
       _p_level = p;
     }
 
-
+  // the rule may have been built for this element type before,
+  // i.e. when a mesh mixes triangles and quadrilaterals
+  std::map<std::pair<ElemType, unsigned int>, std::pair<std::vector<Point>, std::vector<Real> > >::const_iterator
+    it = _rules.find(std::make_pair(_type, _p_level));
+  if (it != _rules.end())
+    {
+      _points  = it->second.first;
+      _weights = it->second.second;
+      return;
+    }
 
   switch(_dim)
     {
     case 0:
       this->init_0D(_type,_p_level);
 
-      return;
+      break;
 
     case 1:
       this->init_1D(_type,_p_level);
 
-      return;
+      break;
 
     case 2:
       this->init_2D(_type,_p_level);
 
-      return;
+      break;
 
     case 3:
       this->init_3D(_type,_p_level);
 
-      return;
+      break;
 
     default:
       genius_error();
     }
+
+  _rules[std::make_pair(_type, _p_level)] = std::make_pair(_points, _weights);
 }
 
 
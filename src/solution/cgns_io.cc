@@ -21,6 +21,7 @@
 
 // C++ includes
 #include <numeric>
+#include <algorithm>
 
 // cgns lib include
 #include <cgnslib.h>
@@ -496,10 +497,10 @@ void CGNSIO::read (const std::string& filename)
         }
       }
 
-      //read all the solutions
-
-      // the solution name to solution value for this region map
-      std::map<std::pair<std::string,std::string> , std::vector<double> > sol_map;
+      // record the solution fields of this zone, the arrays are read after the mesh is distributed
+      std::vector<std::string> field_solution;
+      std::vector<std::string> field_name;
+      std::vector<int>         field_solution_id;
 
       //how many fieldsol node?
       genius_assert(!cg_nsols(fn, B, z_id, &SOL));
@@ -511,15 +512,17 @@ void CGNSIO::read (const std::string& filename)
         genius_assert(!cg_sol_info(fn,B,z_id,sol_id,solutionname, &locationtype));
         for(int f_id=1; f_id<=F; f_id++)
         {
-          int        imin=1;
           DataType_t datatype;
           char       fieldname[32];
           cg_field_info(fn, B, z_id, sol_id, f_id, &datatype, fieldname);
           genius_assert(datatype==RealDouble);
 
-          std::pair<std::string, std::string> key(solutionname,fieldname);
-          sol_map[key].resize(isize[0]);
-          genius_assert(!cg_field_read(fn, B, z_id, sol_id, fieldname, datatype, &imin, &isize[0], &((sol_map[key])[0])));
+          // skip the field not required by user
+          if( !_field_selected(solutionname, fieldname) ) continue;
+
+          field_solution.push_back(solutionname);
+          field_name.push_back(fieldname);
+          field_solution_id.push_back(sol_id);
         }
 
         std::string path = std::string("/") + base_name + "/" + zone_name + "/" + solutionname;
@@ -537,8 +540,9 @@ void CGNSIO::read (const std::string& filename)
         }
       }
 
-      // save solution name to solution value map for later usage
-      region_solutions.push_back(sol_map);
+      region_field_solution.push_back(field_solution);
+      region_field_name.push_back(field_name);
+      region_field_solution_id.push_back(field_solution_id);
 
     }// search for each zone
 
@@ -587,7 +591,7 @@ void CGNSIO::read (const std::string& filename)
   // this is done only for processor 0.
   if( Genius::processor_id() == 0)
   {
-    for(unsigned int r=0; r<region_solutions.size(); r++)
+    for(unsigned int r=0; r<region_global_id.size(); r++)
     {
       std::map<int, unsigned int > global_id_to_node_id;
       std::vector<int>::iterator it = region_global_id[r].begin();
@@ -611,233 +615,79 @@ void CGNSIO::read (const std::string& filename)
   for(unsigned int r=0; r<system.n_regions(); r++)
     Parallel::broadcast(region_global_id_to_node_id[r] , 0);
 
-  // distribute solution data to all the processor
+  // distribute the field list of each region to all the processor
   if(Genius::processor_id() != 0)
-    region_solutions.resize(system.n_regions());
-
-  for(unsigned int r=0; r<region_solutions.size(); r++)
   {
-    unsigned int n_solutions = region_solutions[r].size();
-    Parallel::broadcast(n_solutions , 0);
-
-    std::string sol_name;
-    std::string field_name;
-    std::vector<double> sol_array;
-
-    std::map<std::pair<std::string,std::string>, std::vector<double> >::iterator it = region_solutions[r].begin();
-
-    for(unsigned int n=0; n<n_solutions; n++)
-    {
-      if(Genius::processor_id() == 0)
-      {
-        sol_name  = (*it).first.first;
-        field_name  = (*it).first.second;
-        sol_array = (*it).second;
-        ++it;
-      }
-
-      Parallel::broadcast(sol_name   , 0);
-      Parallel::broadcast(field_name , 0);
-      Parallel::broadcast(sol_array  , 0);
-
-      if(Genius::processor_id() != 0)
-        (region_solutions[r])[std::pair<std::string,std::string>(sol_name,field_name)] = sol_array;
-    }
+    region_field_solution.resize(system.n_regions());
+    region_field_name.resize(system.n_regions());
+    region_field_solution_id.resize(system.n_regions());
+  }
+  for(unsigned int r=0; r<system.n_regions(); r++)
+  {
+    Parallel::broadcast(region_field_solution[r], 0);
+    Parallel::broadcast(region_field_name[r], 0);
+    Parallel::broadcast(region_field_solution_id[r], 0);
   }
 
   Parallel::broadcast(region_solution_units   , 0);
 
+  // each processor opens the file for read, and reads the index range covers its own nodes.
+  // the fields are read one by one, only one array of a region is in memory at a time
+  genius_assert(!cg_open(filename.c_str(), MODE_READ, &fn));
+  B = 1;
 
-  // now all the processor have enough information for
-  // updating region solution data
   for(unsigned int r=0; r<system.n_regions(); r++)
   {
     SimulationRegion * region = system.region(r);
 
     const std::vector<int> & global_id = region_global_id[r];
     const std::map<int, unsigned int > & global_id_to_node_id = region_global_id_to_node_id[r];
-    const std::map<std::pair<std::string,std::string>, std::vector<double> > & solution = region_solutions[r];
 
-    switch ( region->type() )
+    // the on processor nodes of this region, and their position in the cgns arrays
+    std::vector<FVM_NodeData *> node_data;
+    std::vector<int> node_position;
+    for(unsigned int n=0; n<global_id.size(); n++)
     {
-        case SemiconductorRegion :
-        {
-
-          for(std::map< std::pair<std::string, std::string>, std::vector<double> >::const_iterator var_it = solution.begin();
-              var_it!=solution.end(); var_it++)
-          {
-            if(var_it->first.first == "Custom")
-            {
-              const std::string & variable = var_it->first.second;
-              const std::string & variable_unit = region_solution_units[variable+".unit"];
-              region->add_variable( SimulationVariable(variable, SCALAR, POINT_CENTER, variable_unit, invalid_uint, true, true)  );
-            }
-          }
+      unsigned int node_id = global_id_to_node_id.find(global_id[n])->second;
+      FVM_Node * fvm_node = region->region_fvm_node(node_id);
+      if( !fvm_node || !fvm_node->root_node()->on_local() ) continue;
 
-          for(unsigned int n=0; n<global_id.size(); n++)
-          {
-            unsigned int node_id = global_id_to_node_id.find(global_id[n])->second;
-            FVM_Node * fvm_node = region->region_fvm_node(node_id);
-            if( !fvm_node || !fvm_node->root_node()->on_local() ) continue;
-
-            FVM_NodeData * node_data = fvm_node->node_data();  genius_assert(node_data);
-
-            for(std::map< std::pair<std::string,std::string>, std::vector<double> >::const_iterator var_it = solution.begin();
-                var_it!=solution.end(); var_it++)
-            {
-              if(var_it->first.first == "Solution")
-              {
-                // field solution
-                if(var_it->first.second == "electron" || var_it->first.second == "elec_density")
-                {
-                  node_data->n() = var_it->second[n] * pow(cm,-3);
-                  continue;
-                }
-                if(var_it->first.second == "hole" || var_it->first.second == "hole_density")
-                {
-                  node_data->p() = var_it->second[n] * pow(cm,-3);
-                  continue;
-                }
-                if(var_it->first.second == "potential")
-                {
-                  node_data->psi() = var_it->second[n] * V;
-                  continue;
-                }
-                if(var_it->first.second == "temperature" || var_it->first.second == "lattice_temperature" )
-                {
-                  node_data->T() = var_it->second[n] * K;
-                  continue;
-                }
-                if(var_it->first.second == "elec_temperature")
-                {
-                  node_data->Tn() = var_it->second[n] * K;
-                  continue;
-                }
-                if(var_it->first.second == "hole_temperature")
-                {
-                  node_data->Tp() = var_it->second[n] * K;
-                  continue;
-                }
-              }
-              if(var_it->first.first == "Doping")
-              {
-                // doping
-                if(var_it->first.second == "Na" || var_it->first.second == "na")
-                {
-                  node_data->Na()  = var_it->second[n] * pow(cm, -3);
-                  continue;
-                }
-                if(var_it->first.second == "Nd" || var_it->first.second == "nd")
-                {
-                  node_data->Nd()  = var_it->second[n] * pow(cm, -3);
-                  continue;
-                }
-              }
-              if(var_it->first.first == "Mole")
-              {
-                // mole fraction
-                if(var_it->first.second =="mole_x")
-                {
-                  node_data->mole_x() = var_it->second[n];
-                  genius_assert(node_data->mole_x() <= 1.0);
-                  continue;
-                }
-                if(var_it->first.second =="mole_y")
-                {
-                  node_data->mole_y() = var_it->second[n];
-                  genius_assert(node_data->mole_y() <= 1.0);
-                  continue;
-                }
-              }
-
-              if(var_it->first.first == "Custom")
-              {
-                const SimulationVariable & variable = region->get_variable(var_it->first.second, POINT_CENTER);
-                node_data->data<Real>(variable.variable_index) = var_it->second[n]*variable.variable_unit;
-              }
-
-            }
-          }
-
-          // after import previous solutions, we re-init region here
-          region->reinit_after_import();
-
-          break;
-        }
-        case InsulatorRegion     :
-        case ElectrodeRegion     :
-        case MetalRegion         :
-        {
-          for(std::map< std::pair<std::string, std::string>, std::vector<double> >::const_iterator var_it = solution.begin();
-              var_it!=solution.end(); var_it++)
-          {
-            if(var_it->first.first == "Custom")
-            {
-              const std::string & variable = var_it->first.second;
-              const std::string & variable_unit = region_solution_units[variable+".unit"];
-              region->add_variable( SimulationVariable(variable, SCALAR, POINT_CENTER, variable_unit, invalid_uint, true, true)  );
-            }
-          }
-
-          for(unsigned int n=0; n<global_id.size(); n++)
-          {
-            unsigned int node_id = global_id_to_node_id.find(global_id[n])->second;
-            FVM_Node * fvm_node = region->region_fvm_node(node_id);
-            if( !fvm_node || !fvm_node->root_node()->on_local() ) continue;
+      genius_assert(fvm_node->node_data());
+      node_data.push_back(fvm_node->node_data());
+      node_position.push_back(n);
+    }
 
-            FVM_NodeData * node_data = fvm_node->node_data();  genius_assert(node_data);
+    for(unsigned int f=0; f<region_field_name[r].size(); f++)
+    {
+      const std::string & solution_name = region_field_solution[r][f];
+      const std::string & field_name    = region_field_name[r][f];
 
-            for(std::map< std::pair<std::string,std::string>, std::vector<double> >::const_iterator var_it = solution.begin();
-                var_it!=solution.end(); var_it++)
-            {
-              if(var_it->first.first == "Solution")
-              {
-                // field solution
-                if(var_it->first.second == "potential")
-                {
-                  node_data->psi() = var_it->second[n] * V;
-                  continue;
-                }
-                if(var_it->first.second == "temperature" || var_it->first.second == "lattice_temperature" )
-                {
-                  node_data->T() = var_it->second[n] * K;
-                  continue;
-                }
-              }
+      if( !_field_acceptable(region, solution_name, field_name) ) continue;
 
-              if(var_it->first.first == "Custom")
-              {
-                const SimulationVariable & variable = region->get_variable(var_it->first.second, POINT_CENTER);
-                node_data->data<Real>(variable.variable_index) = var_it->second[n]*variable.variable_unit;
-              }
-            }
-          }
+      if(solution_name == "Custom")
+      {
+        const std::string & variable_unit = region_solution_units[field_name+".unit"];
+        region->add_variable( SimulationVariable(field_name, SCALAR, POINT_CENTER, variable_unit, invalid_uint, true, true)  );
+      }
 
-          // after import previous solutions, we re-init region here
-          region->reinit_after_import();
+      if( node_position.empty() ) continue;
 
-          break;
-        }
+      // partial read, cgns index starts from 1
+      int imin = node_position.front() + 1;
+      int imax = node_position.back() + 1;
+      std::vector<double> value(imax - imin + 1);
+      genius_assert(!cg_field_read(fn, B, r+1, region_field_solution_id[r][f], field_name.c_str(), RealDouble, &imin, &imax, &value[0]));
 
-        // no solution data in vacuum region?
-        case VacuumRegion     :
-        {
-          region->reinit_after_import();
-          break;
-        }
-        case PMLRegion     :
-        {
-          region->reinit_after_import();
-          break;
-        }
-        default:
-        {
-          MESSAGE<<"ERROR: Unsupported region type found during CGNS import."<<std::endl; RECORD();
-          genius_error();
-        }
+      for(unsigned int n=0; n<node_data.size(); n++)
+        _set_node_field(region, node_data[n], solution_name, field_name, value[node_position[n] - node_position.front()]);
     }
+
+    // after import previous solutions, we re-init region here
+    region->reinit_after_import();
   }
 
+  cg_close(fn);
+
   // set potential of electrode
   Parallel::broadcast(electrode_potential, 0);
   std::map< short int, double >::iterator el_it = electrode_potential.begin();
@@ -853,6 +703,102 @@ void CGNSIO::read (const std::string& filename)
 
 
 
+bool CGNSIO::_field_selected(const std::string &solution_name, const std::string &field_name) const
+{
+  if( _fields.empty() ) return true;
+  return std::find(_fields.begin(), _fields.end(), solution_name) != _fields.end() ||
+         std::find(_fields.begin(), _fields.end(), field_name) != _fields.end();
+}
+
+
+
+bool CGNSIO::_field_acceptable(const SimulationRegion * region, const std::string &solution_name, const std::string &field_name) const
+{
+  switch ( region->type() )
+  {
+      case SemiconductorRegion :
+      return true;
+      case InsulatorRegion     :
+      case ElectrodeRegion     :
+      case MetalRegion         :
+      {
+        if(solution_name == "Custom") return true;
+        if(solution_name == "Solution")
+          return field_name == "potential" || field_name == "temperature" || field_name == "lattice_temperature";
+        return false;
+      }
+      // no solution data in vacuum region?
+      case VacuumRegion        :
+      case PMLRegion           :
+      return false;
+      default:
+      {
+        MESSAGE<<"ERROR: Unsupported region type found during CGNS import."<<std::endl; RECORD();
+        genius_error();
+      }
+  }
+  return false;
+}
+
+
+
+void CGNSIO::_set_node_field(const SimulationRegion * region, FVM_NodeData * node_data,
+                             const std::string &solution_name, const std::string &field_name, double value) const
+{
+  if(solution_name == "Solution")
+  {
+    // field solution
+    if(field_name == "electron" || field_name == "elec_density")
+      node_data->n() = value * pow(cm,-3);
+    else if(field_name == "hole" || field_name == "hole_density")
+      node_data->p() = value * pow(cm,-3);
+    else if(field_name == "potential")
+      node_data->psi() = value * V;
+    else if(field_name == "temperature" || field_name == "lattice_temperature" )
+      node_data->T() = value * K;
+    else if(field_name == "elec_temperature")
+      node_data->Tn() = value * K;
+    else if(field_name == "hole_temperature")
+      node_data->Tp() = value * K;
+    return;
+  }
+
+  if(solution_name == "Doping")
+  {
+    // doping
+    if(field_name == "Na" || field_name == "na")
+      node_data->Na()  = value * pow(cm, -3);
+    else if(field_name == "Nd" || field_name == "nd")
+      node_data->Nd()  = value * pow(cm, -3);
+    return;
+  }
+
+  if(solution_name == "Mole")
+  {
+    // mole fraction
+    if(field_name =="mole_x")
+    {
+      node_data->mole_x() = value;
+      genius_assert(node_data->mole_x() <= 1.0);
+    }
+    else if(field_name =="mole_y")
+    {
+      node_data->mole_y() = value;
+      genius_assert(node_data->mole_y() <= 1.0);
+    }
+    return;
+  }
+
+  if(solution_name == "Custom")
+  {
+    const SimulationVariable & variable = region->get_variable(field_name, POINT_CENTER);
+    node_data->data<Real>(variable.variable_index) = value*variable.variable_unit;
+  }
+}
+
+
+
+
 void CGNSIO::write (const std::string& filename)
 {
   const SimulationSystem & system = FieldOutput<SimulationSystem>::system();
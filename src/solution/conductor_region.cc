@@ -70,6 +70,7 @@ void ElectrodeSimulationRegion::insert_fvm_node(FVM_Node * fn)
     fn->hold_node_data( new FVM_Conductor_NodeData(&_node_data_storage, _region_point_variables) );
 
   _region_node[fn->root_node()->id()] = fn;
+  _region_node_index_valid = false;
 }
 
 
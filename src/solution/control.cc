@@ -21,7 +21,12 @@
 
 //  $Id: control.cc,v 1.54 2008/07/09 12:56:23 gdiso Exp $
 
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
 #include "genius_common.h"
+#include "parallel.h"
 
 #ifdef CYGWIN
     #include <io.h>
@@ -50,6 +55,8 @@
 #include "boundary_info.h"
 #include "electrical_source.h"
 #include "field_source.h"
+#include "boundary_condition.h"
+#include "optical_cache.h"
 #include "enum_solution.h"
 #include "doping_analytic/doping_analytic.h"
 #include "mole_analytic/mole_analytic.h"
@@ -79,6 +86,7 @@
 #include "interpolation_2d_csa.h"
 #include "interpolation_3d_qshep.h"
 #include "interpolation_3d_nbtet.h"
+#include "solution_transfer.h"
 
 #include "dlhook.h"
 #ifdef CYGWIN
@@ -109,7 +117,7 @@ using PhysicalUnit::s;
 
 //------------------------------------------------------------------------------
 SolverControl::SolverControl()
-    : _decks(NULL), _mesh(NULL), _system(NULL)
+    : _decks(NULL), _mesh(NULL), _system(NULL), _memory_log_solve(false)
 {
   _dom_solution = mxmlNewXML("1.0");
   mxmlNewElement(_dom_solution, "genius-solutions");
@@ -167,69 +175,112 @@ int SolverControl::mainloop()
   if (_mesh.get() == NULL || _system.get() == NULL)
     reset_simulation_system();
 
+  PetscLogDouble t_start, t_mesh, t_process;
+  PetscGetTime(&t_start);
+
   // first, we should see if mesh generation card exist
   this->do_mesh();
 
+  PetscGetTime(&t_mesh);
+
   // then, we should see if doping profile and/or mole card exist
   this->do_process();
 
+  PetscGetTime(&t_process);
+
+  // startup breakdown, the phases inside are in the performance log and trace
+  MESSAGE<<"Startup takes "<<t_process-t_start<<" s: mesh and simulation system "<<t_mesh-t_start
+         <<" s, doping and region data "<<t_process-t_mesh<<" s."<<std::endl; RECORD();
+
   // from above tow steps, maybe the simulation system has been build.
   // if not, user should use IMPORT command to get an (previous) system into memory.
 
   // we can begin the main loop here
   for( decks().begin(); !decks().end(); decks().next() )
-  {
+    this->do_card( decks().get_current_card() );
+
+  return 0;
+}
+
+
+//------------------------------------------------------------------------------
+int SolverControl::run_cards(size_t first)
+{
+  if (_decks == NULL)
+    return 0;
+
+  size_t n = 0;
+  for( decks().begin(); !decks().end(); decks().next(), ++n )
+    if( n >= first )
+      this->do_card( decks().get_current_card() );
 
-    Parser::Card c = decks().get_current_card();
+  return 0;
+}
+
+
+//------------------------------------------------------------------------------
+int SolverControl::do_card( const Parser::Card & c )
+{
+  if(c.key() == "MODEL")
+    this->set_model ( c );
 
-    if(c.key() == "MODEL")
-      this->set_model ( c );
+  if(c.key() == "METHOD")
+    this->set_method ( c );
 
-    if(c.key() == "METHOD")
-      this->set_method ( c );
+  if(c.key() == "HOOK")
+    this->do_hook( c );
 
-    if(c.key() == "HOOK")
-      this->do_hook( c );
+  if(c.key() == "SOLVE")
+    this->do_solve( c );
 
-    if(c.key() == "SOLVE")
-      this->do_solve( c );
+  // the other bias groups run the same deck, only group 0 writes the files
+  if(c.key() == "EXPORT" && Genius::bias_group() == 0)
+    this->do_export( c );
 
-    if(c.key() == "EXPORT")
-      this->do_export( c );
+  if(c.key() == "IMPORT")
+    this->do_import( c );
 
-    if(c.key() == "IMPORT")
-      this->do_import( c );
+  if(c.key() == "EMFEM2D")
+    this->do_em_fem2d_solve( c );
 
-    if(c.key() == "EMFEM2D")
-      this->do_em_fem2d_solve( c );
+  if(c.key() == "RAYTRACE")
+    this->do_ray_trace( c );
 
-    if(c.key() == "RAYTRACE")
-      this->do_ray_trace( c );
+  if(c.key() == "STRESS.LOAD")
+    _stress_loads.push_back( c );
 
-    if(c.key() == "NODESET")
-      this->set_initial_node_voltage( c );
+  if(c.key() == "STRESS")
+    this->do_stress_solve( c );
 
-    if(c.key() == "REFINE.CONFORM")
-      this->do_refine_conform( c );
+  if(c.key() == "NODESET")
+    this->set_initial_node_voltage( c );
 
-    if(c.key() == "REFINE.HIERARCHICAL")
-      this->do_refine_hierarchical( c );
+  if(c.key() == "REFINE.CONFORM")
+    this->do_refine_conform( c );
 
-    if(c.key() == "REFINE.UNIFORM")
-      this->do_refine_uniform( c );
+  if(c.key() == "REFINE.HIERARCHICAL")
+    this->do_refine_hierarchical( c );
 
-    if(c.key() == "PMI")
-      this->set_physical_model ( c );
+  if(c.key() == "REFINE.ADAPTIVE")
+    this->do_refine_adaptive( c );
 
-    if(c.key() == "ATTACH")
-      this->set_electrode_source ( c );
+  if(c.key() == "REFINE.UNIFORM")
+    this->do_refine_uniform( c );
 
-    if(c.key() == "EXTEND")
-      this->extend_to_3d( c );
+  if(c.key() == "PMI")
+    this->set_physical_model ( c );
 
-    if(c.key() == "PLOTMESH")
-      this->plot_mesh( c );
-  }
+  if(c.key() == "ATTACH")
+    this->set_electrode_source ( c );
+
+  if(c.key() == "EXTEND")
+    this->extend_to_3d( c );
+
+  if(c.key() == "PLOTMESH")
+    this->plot_mesh( c );
+
+  if(c.key() == "MEMORY")
+    this->do_memory( c );
 
   return 0;
 }
@@ -241,9 +292,21 @@ int  SolverControl::do_mesh()
 
   if ( decks().is_card_exist("MESH") )
   {
+    // node and element ordering, applied on all processors when the mesh is prepared
+    for( decks().begin(); !decks().end(); decks().next() )
+    {
+      Parser::Card c = decks().get_current_card();
+      if(c.key() != "MESH") continue;
+      if( c.is_enum_value("reorder","none") )    mesh().set_reorder_type(MeshBase::REORDER_NONE);
+      if( c.is_enum_value("reorder","rcm") )     mesh().set_reorder_type(MeshBase::REORDER_RCM);
+      if( c.is_enum_value("reorder","hilbert") ) mesh().set_reorder_type(MeshBase::REORDER_HILBERT);
+    }
+
     // build meshgenerator only on processor 0
     // I am afraid about mesh generator may have different
     // behavior due to float point round-off error
+    START_LOG("do_mesh()", "SolverControl");
+
     if (Genius::processor_id() == 0)
     {
       // which mesh generator should we use?
@@ -295,8 +358,10 @@ int  SolverControl::do_mesh()
     // since we only build mesh on processor 0,
     // sync mesh to other processors.
     // this procedure also prepare the mesh for using
+    START_LOG("broadcast mesh", "SolverControl");
     MeshCommunication mesh_comm;
     mesh_comm.broadcast(mesh());
+    STOP_LOG("broadcast mesh", "SolverControl");
 
     // please note, until here, mesh is still not prepared
     // mesh.is_prepared() will return false
@@ -304,6 +369,8 @@ int  SolverControl::do_mesh()
     // now we can build solution system since mesh is done
     system().build_simulation_system();
     system().sync_print_info();
+
+    STOP_LOG("do_mesh()", "SolverControl");
   }
 
   return 0;
@@ -316,23 +383,27 @@ int SolverControl::do_process()
   // if doping profile card exist
   if ( decks().is_card_exist("DOPING") )
   {
+    START_LOG("doping", "SolverControl");
     DopingSolver = AutoPtr<SolverBase>( new DopingAnalytic(system(), decks()) );
     // parse "PROFILE" card
     DopingSolver->create_solver();
     // set doping profile to semiconductor region
     DopingSolver->solve();
     // we will not destroy the doping solver here
+    STOP_LOG("doping", "SolverControl");
   }
 
   // if mole card exist
   if ( decks().is_card_exist("MOLE") )
   {
+    START_LOG("mole", "SolverControl");
     MoleSolver = AutoPtr<SolverBase>( new MoleAnalytic(system(), decks()) );
     // parse "MOLE" card
     MoleSolver->create_solver();
     // set mole fraction to semiconductor region
     MoleSolver->solve();
     // we will not destroy the mole solver here
+    STOP_LOG("mole", "SolverControl");
   }
 
   // after doping profile and mole is set, we can init system data.
@@ -363,6 +434,13 @@ int SolverControl::set_method ( const Parser::Card & c )
   // set preconditioner type
   SolverSpecify::PC = SolverSpecify::preconditioner_type(c.get_string("pc", "asm"));
 
+  // the threads of each processor from now on, 0 takes all the cpus owned by the processor
+  if(c.is_parameter_exist("threads"))
+  {
+    const int n_threads = c.get_int("threads", 1);
+    Genius::set_n_threads(n_threads > 0 ? n_threads : Genius::default_n_threads());
+  }
+
   // set Newton damping type
   if(c.is_parameter_exist("damping"))
   {
@@ -370,6 +448,8 @@ int SolverControl::set_method ( const Parser::Card & c )
     if (c.is_enum_value("damping", "potential"))      SolverSpecify::Damping = SolverSpecify::DampingPotential;
     if (c.is_enum_value("damping", "superpotential")) SolverSpecify::Damping = SolverSpecify::DampingSuperPotential;
     if (c.is_enum_value("damping", "bankrose"))       SolverSpecify::Damping = SolverSpecify::DampingBankRose;
+    if (c.is_enum_value("damping", "model"))          SolverSpecify::Damping = SolverSpecify::DampingModel;
+    if (c.is_enum_value("damping", "avalanche"))      SolverSpecify::Damping = SolverSpecify::DampingAvalanche;
   }
 
    // set voronoi truncation flag
@@ -383,6 +463,8 @@ int SolverControl::set_method ( const Parser::Card & c )
   //set convergence test
   SolverSpecify::MaxIteration              = c.get_int("maxiteration", 30);
   SolverSpecify::potential_update          = c.get_real("potential.update", 1.0);
+  SolverSpecify::carrier_update            = std::max(2.0, c.get_real("carrier.update", 10.0));
+  SolverSpecify::IIProjectedJacobian       = c.get_bool("ii.projected", false);
 
   SolverSpecify::ksp_rtol                  = c.get_real("ksp.rtol", 1e-8);
   SolverSpecify::ksp_atol                  = c.get_real("ksp.atol", 1e-20);
@@ -401,6 +483,29 @@ int SolverControl::set_method ( const Parser::Card & c )
   SolverSpecify::elec_quantum_abs_toler    = c.get_real("elec.quantum.tol", 1e-29)*C;
   SolverSpecify::hole_quantum_abs_toler    = c.get_real("hole.quantum.tol", 1e-29)*C;
 
+  // jacobian reuse
+  SolverSpecify::JacobianReuse             = c.get_bool("jacobian.reuse", false);
+  SolverSpecify::JacobianReuseMax          = c.get_int("jacobian.reuse.max", 5);
+  SolverSpecify::JacobianReuseRatio        = c.get_real("jacobian.reuse.ratio", 0.5);
+  SolverSpecify::RegionJacobianReuse       = c.get_bool("jacobian.reuse.region", false);
+  SolverSpecify::RegionJacobianReuseTol    = c.get_real("jacobian.reuse.region.tol", 1e-3);
+  SolverSpecify::JFNK                      = c.get_bool("jfnk", false);
+
+  // jacobian storage
+  SolverSpecify::JacobianBlock             = c.get_bool("jacobian.block", false);
+  SolverSpecify::MatrixType                = c.get_string("mat.type", "");
+  SolverSpecify::VectorType                = c.get_string("vec.type", "");
+
+  // preconditioner reuse
+  SolverSpecify::PCLag                     = c.get_int("pc.lag", 1);
+  SolverSpecify::PCReuseOrdering           = c.get_bool("pc.reuse.ordering", false);
+
+  // direct solver refinement
+  SolverSpecify::DirectRefine              = c.get_bool("direct.refine", false);
+
+  // device/circuit schur complement of mixed mode solvers
+  SolverSpecify::SpiceSchur                = c.get_bool("spice.schur", false);
+
   // set which solver will be used
   if(c.is_parameter_exist("type"))
   {
@@ -578,8 +683,26 @@ int SolverControl::do_hook( const Parser::Card & c )
 }
 
 
+int SolverControl::do_memory( const Parser::Card & c )
+{
+  _memory_log_solve = c.get_bool("solve", _memory_log_solve);
+  print_memory("on demand");
+  return 0;
+}
+
+
+void SolverControl::print_memory( const std::string & label, const SolverBase * solver )
+{
+  MemoryLog log(label);
+  system().memory_usage(log);
+  if( solver ) solver->memory_usage(log);
+  log.print_log();
+}
+
+
 int SolverControl::do_solve( const Parser::Card & c )
 {
+  _last_solve = c;
 
   // set solution type solver will do
   SolverSpecify::Type = SolverSpecify::INVALID_SolutionType;
@@ -606,6 +729,8 @@ int SolverControl::do_solve( const Parser::Card & c )
         SolverSpecify::RampUpSteps = c.get_int("rampup.steps", 1);
         SolverSpecify::RampUpVStep = c.get_real("rampup.vstep", 0.25)*V;
         SolverSpecify::RampUpIStep = c.get_real("rampup.istep", 0.1)*A;
+        SolverSpecify::Homotopy    = c.get_bool("homotopy", true);
+        SolverSpecify::BiasCache   = c.get_bool("bias.cache", false);
         SolverSpecify::GminInit    = c.get_real("gmin.init", 1e-6);
         SolverSpecify::Gmin        = c.get_real("gmin", 1e-12);
         break;
@@ -722,6 +847,12 @@ int SolverControl::do_solve( const Parser::Card & c )
         }
 
         SolverSpecify::Predict   = c.get_bool("predict", true);
+        SolverSpecify::PredictOrder     = c.get_int("predict.order", 2);
+        SolverSpecify::SweepAutoStep    = c.get_bool("sweep.autostep", false);
+        SolverSpecify::SweepAutoStepIts = c.get_int("sweep.autostep.its", 6);
+        SolverSpecify::Homotopy         = c.get_bool("homotopy", true);
+        SolverSpecify::BiasCache        = c.get_bool("bias.cache", false);
+        SolverSpecify::ParallelBias     = std::max(1, c.get_int("parallel.bias", 1));
 
         SolverSpecify::OptG      = c.get_bool("optical.gen", false);
         SolverSpecify::PatG      = c.get_bool("particle.gen", false);
@@ -759,11 +890,13 @@ int SolverControl::do_solve( const Parser::Card & c )
         }
         SolverSpecify::VStart    = c.get_real("vstart", 0.0)*V;
         SolverSpecify::VStep     = c.get_real("vstep", 0.1)*V;
-        SolverSpecify::VStepMax  = c.get_real("vstepmax", SolverSpecify::VStep/V)*V;
+        // the arc-length of trace is not limited unless vstepmax is given
+        SolverSpecify::VStepMax  = c.get_real("vstepmax", 0.0)*V;
         SolverSpecify::VStop     = c.get_real("vstop", 5.0)*V;
         SolverSpecify::IStop     = c.get_real("istop", 1.0)*A; //current limit
 
         SolverSpecify::Predict   = c.get_bool("predict", true);
+        SolverSpecify::PredictOrder     = c.get_int("predict.order", 2);
 
         SolverSpecify::OptG      = c.get_bool("optical.gen", false);
         SolverSpecify::PatG      = c.get_bool("particle.gen", false);
@@ -784,6 +917,8 @@ int SolverControl::do_solve( const Parser::Card & c )
         SolverSpecify::FStop     = c.get_real("f.stop", 10e9)/s;
         SolverSpecify::FMultiple = c.get_real("f.multiple", 1.1);
         SolverSpecify::VAC       = c.get_real("vac", 0.0026)*V;
+        SolverSpecify::ACBatch   = std::max(1, c.get_int("ac.batch", 1));
+        SolverSpecify::ACMOROrder = std::max(0, c.get_int("ac.mor", 0));
 
         unsigned int elec_num = c.parameter_count("acscan");
         for(unsigned int n=0; n<elec_num; n++)
@@ -823,6 +958,21 @@ int SolverControl::do_solve( const Parser::Card & c )
 
         SolverSpecify::TS_rtol   = c.get_real("ts.rtol", 1e-3);
         SolverSpecify::TS_atol   = c.get_real("ts.atol", 1e-4);
+        SolverSpecify::TS_PIControl = c.get_bool("ts.pi", false);
+
+        SolverSpecify::SpiceMultirate         = c.get_bool("spice.multirate", false);
+        SolverSpecify::SpiceMultirateTol      = c.get_real("spice.multirate.tol", 1e-2);
+        SolverSpecify::SpiceMultirateSubsteps = std::max(1, c.get_int("spice.multirate.substeps", 32));
+
+        SolverSpecify::CheckpointFile  = c.get_string("checkpoint", "");
+        SolverSpecify::CheckpointSteps = std::max(1, c.get_int("checkpoint.steps", 10));
+        SolverSpecify::RestartFile     = c.get_string("restart", "");
+
+        SolverSpecify::PSSPeriod = c.get_real("pss.period", 0.0)*s;
+        SolverSpecify::PSSTol    = c.get_real("pss.tol", 1e-4);
+
+        SolverSpecify::PararealSlices = std::max(0, c.get_int("parareal.slices", 0));
+        SolverSpecify::PararealNext   = c.get_string("parareal.next", "");
 
         SolverSpecify::VStepMax  = c.get_real("vstepmax", 1.0)*V;
         SolverSpecify::IStepMax  = c.get_real("istepmax", 1.0)*A;
@@ -838,6 +988,7 @@ int SolverControl::do_solve( const Parser::Card & c )
           if (c.is_enum_value("ts", "impliciteuler"))   SolverSpecify::TS_type = SolverSpecify::BDF1;
           if (c.is_enum_value("ts", "bdf1"))            SolverSpecify::TS_type = SolverSpecify::BDF1;
           if (c.is_enum_value("ts", "bdf2"))            SolverSpecify::TS_type = SolverSpecify::BDF2;
+          if (c.is_enum_value("ts", "trbdf2"))          SolverSpecify::TS_type = SolverSpecify::TRBDF2;
         }
 
         SolverSpecify::OptG      = c.get_bool("optical.gen", false);
@@ -856,7 +1007,23 @@ int SolverControl::do_solve( const Parser::Card & c )
   }
 
   SolverSpecify::out_prefix = c.get_string("out.prefix", "result");
+  SolverSpecify::IVBinary = c.get_bool("iv.binary", false);
 
+  // a campaign of particle strikes forked from current state
+  if( SolverSpecify::Type == SolverSpecify::TRANSIENT && c.is_parameter_exist("campaign") )
+    return this->do_strike_campaign( c );
+
+  SolverBase * solver = this->new_device_solver();
+  if (solver)
+    this->run_device_solver(solver);
+
+  return 0;
+}
+
+
+
+SolverBase * SolverControl::new_device_solver()
+{
   SolverBase * solver = NULL;
 
   // call each solver here
@@ -919,94 +1086,279 @@ int SolverControl::do_solve( const Parser::Card & c )
       break;
   }
 
-  if (solver)
-  {
-    solver->set_label(SolverSpecify::label);
+  return solver;
+}
 
-    // create a solution group;
-    mxml_node_t *eGroup = NULL;
-    {
-      mxml_node_t *eRoot = mxmlFindElement(_dom_solution, _dom_solution, "genius-solutions", NULL, NULL, MXML_DESCEND_FIRST);
-      eGroup = mxmlNewElement(eRoot, "solution-group");
-      mxml_node_t *eLabel = mxmlNewElement(eGroup, "label");
-      mxmlAdd(eLabel, MXML_ADD_AFTER, NULL, MXMLQVariant::makeQVString(solver->label()));
 
-      solver->set_solution_dom_root(eGroup);
-    }
 
-    // init (user defined) hook functions here
+void SolverControl::run_device_solver(SolverBase * solver, Hook * extra_hook, bool group_output)
+{
+  solver->set_label(SolverSpecify::label);
+
+  // create a solution group;
+  mxml_node_t *eGroup = NULL;
+  {
+    mxml_node_t *eRoot = mxmlFindElement(_dom_solution, _dom_solution, "genius-solutions", NULL, NULL, MXML_DESCEND_FIRST);
+    eGroup = mxmlNewElement(eRoot, "solution-group");
+    mxml_node_t *eLabel = mxmlNewElement(eGroup, "label");
+    mxmlAdd(eLabel, MXML_ADD_AFTER, NULL, MXMLQVariant::makeQVString(solver->label()));
 
-    if( SolverSpecify::Type == SolverSpecify::DCSWEEP   ||
-        SolverSpecify::Type == SolverSpecify::TRANSIENT ||
-        SolverSpecify::Type == SolverSpecify::TRACE     ||
-        SolverSpecify::Solver == SolverSpecify::DDMAC
-      )
-    {
+    solver->set_solution_dom_root(eGroup);
+  }
+
+  // init (user defined) hook functions here, the other bias groups write no output
+  const bool output_hooks = ( group_output || Genius::bias_group() == 0 );
+
+  if( output_hooks && (
+      SolverSpecify::Type == SolverSpecify::DCSWEEP   ||
+      SolverSpecify::Type == SolverSpecify::TRANSIENT ||
+      SolverSpecify::Type == SolverSpecify::TRACE     ||
+      SolverSpecify::Solver == SolverSpecify::DDMAC )
+    )
+  {
 #ifdef CYGWIN
-      // for windows cygwin system, dynamic link is not supported. we have to use static link.
-      // it is not as flexible as unix/linux system().
-      // rawfile hook, write electrode IV in SPICE raw file format
-      Hook * rawfile_hook =  new RawFileHook(*solver, "rawfile_hook", (void *)Genius::input_file());
-      solver->add_hook(rawfile_hook);
-      // gnuplot hook, write electrode IV in gnuplot file format
-      Hook * gnuplot_hook =  new GnuplotHook(*solver, "gnuplot_hook", (void *)Genius::input_file());
-      solver->add_hook(gnuplot_hook);
+    // for windows cygwin system, dynamic link is not supported. we have to use static link.
+    // it is not as flexible as unix/linux system().
+    // rawfile hook, write electrode IV in SPICE raw file format
+    Hook * rawfile_hook =  new RawFileHook(*solver, "rawfile_hook", (void *)Genius::input_file());
+    solver->add_hook(rawfile_hook);
+    // gnuplot hook, write electrode IV in gnuplot file format
+    Hook * gnuplot_hook =  new GnuplotHook(*solver, "gnuplot_hook", (void *)Genius::input_file());
+    solver->add_hook(gnuplot_hook);
 #else
-      Hook * rawfile_hook =  new DllHook(*solver, "rawfile_hook", (void *)(Genius::input_file()));
-      solver->add_hook(rawfile_hook);
+    Hook * rawfile_hook =  new DllHook(*solver, "rawfile_hook", (void *)(Genius::input_file()));
+    solver->add_hook(rawfile_hook);
 
-      Hook * gnuplot_hook =  new DllHook(*solver, "gnuplot_hook", (void *)(Genius::input_file()));
-      solver->add_hook(gnuplot_hook);
+    Hook * gnuplot_hook =  new DllHook(*solver, "gnuplot_hook", (void *)(Genius::input_file()));
+    solver->add_hook(gnuplot_hook);
 #endif
 
-    }
+  }
 
 #ifdef CYGWIN
-    // load static user defined hooks, only support predefined hooks, sigh
-    for (std::map<std::string, std::pair<std::string, std::vector<Parser::Parameter> > >::iterator it=SolverSpecify::Hooks.begin();
-         it!=SolverSpecify::Hooks.end(); it++)
-    {
-      Hook * hook=NULL;
+  // load static user defined hooks, only support predefined hooks, sigh
+  for (std::map<std::string, std::pair<std::string, std::vector<Parser::Parameter> > >::iterator it=SolverSpecify::Hooks.begin();
+       output_hooks && it!=SolverSpecify::Hooks.end(); it++)
+  {
+    Hook * hook=NULL;
 
-      if((*it).second.first=="vtk")
-        hook = new VTKHook(*solver, "vtk_hook", (void *)(&(*it).second.second));
-      if((*it).second.first=="cv")
-        hook = new CVHook (*solver, "cv_hook",  (void *)(&(*it).second.second));
-      if((*it).second.first=="probe")
-        hook = new ProbeHook (*solver, "probe_hook",  (void *)(&(*it).second.second));
+    if((*it).second.first=="vtk")
+      hook = new VTKHook(*solver, "vtk_hook", (void *)(&(*it).second.second));
+    if((*it).second.first=="cv")
+      hook = new CVHook (*solver, "cv_hook",  (void *)(&(*it).second.second));
+    if((*it).second.first=="probe")
+      hook = new ProbeHook (*solver, "probe_hook",  (void *)(&(*it).second.second));
 
-      if(hook) solver->add_hook(hook);
-    }
+    if(hook) solver->add_hook(hook);
+  }
 
 #else
-    // dynamic load user defined hooks, stupid win32 platform does not support this function.
-    for (std::map<std::string, std::pair<std::string, std::vector<Parser::Parameter> > >::iterator it=SolverSpecify::Hooks.begin();
-         it!=SolverSpecify::Hooks.end(); it++)
+  // dynamic load user defined hooks, stupid win32 platform does not support this function.
+  for (std::map<std::string, std::pair<std::string, std::vector<Parser::Parameter> > >::iterator it=SolverSpecify::Hooks.begin();
+       output_hooks && it!=SolverSpecify::Hooks.end(); it++)
+  {
+    solver->add_hook( new DllHook(*solver, ((*it).second.first)+"_hook", (void *)(&(*it).second.second)) );
+  }
+#endif
+
+  // the hook given by caller
+  if(extra_hook) solver->add_hook(extra_hook);
+
+  {
+    // always load the control hook. We load it last, such that it is called last
+    SolverControlHook * control_hook =  new SolverControlHook(*solver, "control_hook", *this, _fname_solution);
+    solver->add_hook(control_hook);
+  }
+
+  solver->create_solver();
+  if( _memory_log_solve ) print_memory("at SOLVE begin", solver);
+  solver->solve();
+  if( _memory_log_solve ) print_memory("at SOLVE end", solver);
+  solver->destroy_solver();
+
+  {
+    // if there is a solution in the group, add it to the solution document
+    if (mxmlFindElement(eGroup, eGroup, "solution", NULL, NULL, MXML_DESCEND_FIRST)==NULL)
     {
-      solver->add_hook( new DllHook(*solver, ((*it).second.first)+"_hook", (void *)(&(*it).second.second)) );
+      mxmlDelete(eGroup);
     }
-#endif
+  }
 
+  delete solver;
+}
+
+
+
+
+namespace
+{
+  /**
+   * integrate the current of each electrode over a transient solution,
+   * with the current of the initial state subtracted
+   */
+  class StrikeChargeHook : public Hook
+  {
+  public:
+    StrikeChargeHook(SolverBase & solver, SimulationSystem & system, std::vector<double> & charge)
+      : Hook(solver, "strike_charge_hook"), _system(system), _charge(charge)
+    {}
+
+    virtual void on_init()
+    {
+      _current_init = electrode_currents();
+      _current_last = _current_init;
+      _charge.assign(_current_init.size(), 0.0);
+      _clock_last = SolverSpecify::TStart;
+    }
+
+    virtual void post_solve()
     {
-      // always load the control hook. We load it last, such that it is called last
-      SolverControlHook * control_hook =  new SolverControlHook(*solver, "control_hook", *this, _fname_solution);
-      solver->add_hook(control_hook);
+      std::vector<double> current = electrode_currents();
+      double dt = SolverSpecify::clock - _clock_last;
+      for(unsigned int n=0; n<current.size(); ++n)
+        _charge[n] += 0.5*(current[n] + _current_last[n] - 2*_current_init[n])*dt;
+      _current_last = current;
+      _clock_last = SolverSpecify::clock;
     }
 
-    solver->create_solver();
-    solver->solve();
-    solver->destroy_solver();
+  private:
 
+    std::vector<double> electrode_currents() const
     {
-      // if there is a solution in the group, add it to the solution document
-      if (mxmlFindElement(eGroup, eGroup, "solution", NULL, NULL, MXML_DESCEND_FIRST)==NULL)
+      std::vector<double> current;
+      for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
       {
-        mxmlDelete(eGroup);
+        const BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+        if( bc->is_electrode() )
+          current.push_back(bc->ext_circuit()->current());
       }
+      return current;
     }
 
-    delete solver;
+    SimulationSystem & _system;
+
+    std::vector<double> & _charge;
+
+    std::vector<double> _current_init;
+
+    std::vector<double> _current_last;
+
+    double _clock_last;
+  };
+}
+
+
+int SolverControl::do_strike_campaign( const Parser::Card & c )
+{
+  FieldSource * field_source = system().get_field_source();
+  Particle_Source_Track * track_source = field_source->particle_track_source();
+  if( track_source == NULL )
+  {
+    MESSAGE<<"ERROR at " <<c.get_fileline()<< " SOLVE: strike campaign requires a PARTICLE source with track profile." << std::endl; RECORD();
+    genius_error();
+  }
+
+  std::vector<Particle_Source_Track::strike_t> strikes = Particle_Source_Track::read_strikes(c.get_string("campaign", ""));
+
+  std::vector<std::string> electrodes;
+  for(unsigned int b=0; b<system().get_bcs()->n_bcs(); b++)
+  {
+    const BoundaryCondition * bc = system().get_bcs()->get_bc(b);
+    if( !bc->is_electrode() ) continue;
+    electrodes.push_back( bc->electrode_label().empty() ? bc->label() : bc->electrode_label() );
+  }
+
+  // with bias process groups (genius -bias_groups n), group g runs the strikes n with n%n_groups == g
+  const unsigned int n_groups = Genius::n_bias_groups();
+  const unsigned int group    = Genius::bias_group();
+
+  MESSAGE<<"Strike campaign of "<<strikes.size()<<" particle strikes from current state";
+  if( n_groups > 1 )
+    MESSAGE<<", on "<<n_groups<<" bias process groups";
+  MESSAGE<<"...\n\n"; RECORD();
+
+  // keep the pre-strike state in memory, each strike starts from it
+  std::stringstream snapshot(std::ios::in | std::ios::out | std::ios::binary);
+  system().write_checkpoint(snapshot);
+  const std::vector<Particle_Source_Track::track_t> tracks = track_source->tracks();
+
+  const std::string out_prefix = SolverSpecify::out_prefix;
+  SolverSpecify::PatG    = true;
+  // the kept state is the operating point
+  SolverSpecify::tran_op = false;
 
+  std::vector< std::vector<double> > charges(strikes.size());
+  for(unsigned int n=group; n<strikes.size(); n+=n_groups)
+  {
+    MESSAGE<<"Particle strike "<<n+1<<" of "<<strikes.size()<<" "<<strikes[n].label
+           <<", "<<strikes[n].tracks.size()<<" tracks\n"
+           <<"--------------------------------------------------------------------------------\n"; RECORD();
+
+    snapshot.clear();
+    snapshot.seekg(0);
+    genius_assert( system().read_checkpoint(snapshot) );
+
+    track_source->set_tracks(strikes[n].tracks);
+    field_source->update_particle_generation();
+
+    std::stringstream ss;
+    ss << out_prefix << ".strike" << n;
+    SolverSpecify::out_prefix = ss.str();
+
+    SolverBase * solver = this->new_device_solver();
+    if( solver == NULL ) break;
+    // the output prefix is of this strike, each group writes the output of its own strikes
+    this->run_device_solver(solver, new StrikeChargeHook(*solver, system(), charges[n]), true);
+  }
+
+  // back to the pre-strike state
+  snapshot.clear();
+  snapshot.seekg(0);
+  genius_assert( system().read_checkpoint(snapshot) );
+  track_source->set_tracks(tracks);
+  SolverSpecify::out_prefix = out_prefix;
+
+#ifdef HAVE_MPI
+  // the first processor of each group holds the charges of its strikes,
+  // collect them to the first processor of group 0
+  if( n_groups > 1 )
+  {
+    const unsigned int n_electrodes = electrodes.size();
+    std::vector<double> local(strikes.size()*n_electrodes, 0.0), all(strikes.size()*n_electrodes, 0.0);
+    if( Genius::is_first_processor() )
+      for(unsigned int n=0; n<strikes.size(); ++n)
+        for(unsigned int e=0; e<charges[n].size(); ++e)
+          local[n*n_electrodes+e] = charges[n][e];
+
+    if( !local.empty() )
+      MPI_Reduce(&local[0], &all[0], static_cast<int>(local.size()), MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    for(unsigned int n=0; n<strikes.size(); ++n)
+      charges[n].assign(all.begin()+n*n_electrodes, all.begin()+(n+1)*n_electrodes);
+  }
+#endif
+
+  // collected charge of each strike
+  if( Genius::is_first_processor() && group == 0 )
+  {
+    std::string filename = out_prefix + ".campaign.dat";
+    std::ofstream out(filename.c_str());
+    out << "# strike\tlabel";
+    for(unsigned int e=0; e<electrodes.size(); ++e)
+      out << '\t' << electrodes[e] << "_charge [C]";
+    out << std::endl;
+
+    out << std::scientific << std::setprecision(8);
+    for(unsigned int n=0; n<strikes.size(); ++n)
+    {
+      out << n << '\t' << (strikes[n].label.empty() ? std::string("-") : strikes[n].label);
+      for(unsigned int e=0; e<charges[n].size(); ++e)
+        out << '\t' << charges[n][e]/C;
+      out << std::endl;
+    }
+    out.close();
+
+    MESSAGE<<"Collected charge of the strike campaign written to "<<filename<<"\n\n"; RECORD();
   }
 
   return 0;
@@ -1117,7 +1469,9 @@ int  SolverControl::set_physical_model  ( const Parser::Card & c )
 
   if ( (type.length() > 0  ) )
   {
+    START_LOG("set_pmi()", "SolverControl");
     system().region(region_label)->set_pmi(type, model, pmi_parameters);
+    STOP_LOG("set_pmi()", "SolverControl");
     system().get_bcs()->pmi_init_bc(region_label,type);
   }
   else
@@ -1147,7 +1501,10 @@ int SolverControl::do_export( const Parser::Card & c )
   {
     std::string vtk_filename = c.get_string("vtkfile", "");
     bool ascii = c.get_bool("ascii", false);
-    system().export_vtk(vtk_filename, ascii);
+    bool compress = c.get_bool("compress", true);
+    // the solution fields to be written, separated by comma
+    std::string fields = c.get_string("fields", "");
+    system().export_vtk(vtk_filename, ascii, false, compress, fields);
   }
 
   // if export to CGNS format is required
@@ -1223,6 +1580,23 @@ int SolverControl::do_export( const Parser::Card & c )
 
 int SolverControl::do_import( const Parser::Card & c )
 {
+  // keep the present solution and electrode states, they are transferred to the imported mesh
+  AutoPtr<SolutionTransfer> transfer;
+  std::map<std::string, std::string> electrode_states;
+  if( c.get_bool("transfer", false) && system().n_regions() > 0 )
+  {
+    transfer = AutoPtr<SolutionTransfer>(new SolutionTransfer(system()));
+
+    for(unsigned int b=0; b<system().get_bcs()->n_bcs(); b++)
+    {
+      const BoundaryCondition * bc = system().get_bcs()->get_bc(b);
+      if( !bc->is_electrode() ) continue;
+      std::ostringstream out;
+      bc->ext_circuit()->write_state(out);
+      electrode_states[bc->label()] = out.str();
+    }
+  }
+
   if(c.is_parameter_exist("cgnsfile"))
   {
     std::string cgns_filename = c.get_string("cgnsfile", "");
@@ -1235,7 +1609,22 @@ int SolverControl::do_import( const Parser::Card & c )
       MESSAGE<<"ERROR at " <<c.get_fileline()<< " IMPORT: CGNSFile " << cgns_filename << " doesn't exist." << std::endl; RECORD();
       genius_error();
     }
-    system().import_cgns(cgns_filename);
+
+    // the solution fields to be imported, separated by comma
+    std::vector<std::string> fields;
+    {
+      std::string field_list = c.get_string("fields", "");
+      std::string::size_type begin = 0;
+      while( begin < field_list.size() )
+      {
+        std::string::size_type end = field_list.find(',', begin);
+        if( end == std::string::npos ) end = field_list.size();
+        if( end > begin )
+          fields.push_back(field_list.substr(begin, end-begin));
+        begin = end + 1;
+      }
+    }
+    system().import_cgns(cgns_filename, fields);
   }
 
   if(c.is_parameter_exist("vtkfile"))
@@ -1306,6 +1695,31 @@ int SolverControl::do_import( const Parser::Card & c )
     system().import_ise(ise_filename);
   }
 
+  if( transfer.get() != NULL )
+  {
+    MESSAGE<<"Transfer solution to the imported mesh..." << std::endl; RECORD();
+    unsigned int n_missing = transfer->apply(system());
+    if( n_missing )
+    {
+      MESSAGE<<"  Warning: " << n_missing << " nodes are outside the previous mesh, their solution is kept." << std::endl; RECORD();
+    }
+    transfer.reset();
+
+    // update the carrier dependent parameters as an imported solution
+    system().reinit_region_after_import();
+
+    for(unsigned int b=0; b<system().get_bcs()->n_bcs(); b++)
+    {
+      BoundaryCondition * bc = system().get_bcs()->get_bc(b);
+      if( !bc->is_electrode() || electrode_states.find(bc->label()) == electrode_states.end() ) continue;
+      std::istringstream in(electrode_states[bc->label()]);
+      bc->ext_circuit()->read_state(in);
+    }
+  }
+
+  // the solution is replaced by the imported one
+  system().new_solution_version();
+
   return 0;
 }
 
@@ -1314,11 +1728,17 @@ int SolverControl::do_import( const Parser::Card & c )
 
 int  SolverControl::do_em_fem2d_solve ( const Parser::Card & c )
 {
+  // the same optical problem has been solved before
+  OpticalCache cache(system(), c);
+  if( cache.restore() ) return 0;
+
+  cache.begin();
   EMFEM2DSolver * solver = new EMFEM2DSolver(system(), c);
   solver->create_solver();
   solver->solve();
   solver->destroy_solver();
   delete solver;
+  cache.end();
 
   return 0;
 }
@@ -1326,8 +1746,29 @@ int  SolverControl::do_em_fem2d_solve ( const Parser::Card & c )
 
 int SolverControl::do_ray_trace( const Parser::Card & c )
 {
+  // the same optical problem has been solved before
+  OpticalCache cache(system(), c);
+  if( cache.restore() ) return 0;
 
+  cache.begin();
   RayTraceSolver * solver = new RayTraceSolver(system(), c);
+  solver->create_solver();
+  solver->solve();
+  solver->destroy_solver();
+  delete solver;
+  cache.end();
+
+  return 0;
+}
+
+
+int SolverControl::do_stress_solve( const Parser::Card & c )
+{
+  StressSolver * solver = new StressSolver(system(), c);
+  for(unsigned int n=0; n<_stress_loads.size(); ++n)
+    solver->add_load( _stress_loads[n] );
+  _stress_loads.clear();
+
   solver->create_solver();
   solver->solve();
   solver->destroy_solver();
@@ -1368,20 +1809,24 @@ int SolverControl::do_refine_conform(const Parser::Card & c)
   else
     interpolator = AutoPtr<InterpolationBase>(new Interpolation3D_nbtet);
 
+  // all the variables are filled into the interpolator together
+  std::vector<std::pair<std::string, InterpolationBase::InterpolationType> > interpolate_variables;
   if( DopingSolver.get() == NULL )
   {
-    system().fill_interpolator(interpolator.get(), "doping.na", InterpolationBase::Asinh);
-    system().fill_interpolator(interpolator.get(), "doping.nd", InterpolationBase::Asinh);
+    interpolate_variables.push_back(std::make_pair(std::string("doping.na"), InterpolationBase::Asinh));
+    interpolate_variables.push_back(std::make_pair(std::string("doping.nd"), InterpolationBase::Asinh));
   }
 
   if(system().has_single_compound_semiconductor_region()  && MoleSolver.get() == NULL )
   {
-    system().fill_interpolator(interpolator.get(), "mole.x", InterpolationBase::Linear);
+    interpolate_variables.push_back(std::make_pair(std::string("mole.x"), InterpolationBase::Linear));
   }
   if(system().has_complex_compound_semiconductor_region()  && MoleSolver.get() == NULL )
   {
-    system().fill_interpolator(interpolator.get(), "mole.y", InterpolationBase::Linear);
+    interpolate_variables.push_back(std::make_pair(std::string("mole.y"), InterpolationBase::Linear));
   }
+  if( !interpolate_variables.empty() )
+    system().fill_interpolator(interpolator.get(), interpolate_variables);
 
   // fill error vector from system level
   ErrorVector error_per_cell;
@@ -1450,25 +1895,19 @@ int SolverControl::do_refine_conform(const Parser::Card & c)
   system().build_simulation_system();
   system().sync_print_info();
 
-  // set doping profile to semiconductor region
+  // set doping profile and mole fraction to semiconductor region
   if( DopingSolver.get() != NULL )
     DopingSolver->solve();
-  else
-  {
-    // no doping information?
-    system().do_interpolation(interpolator.get(), "doping.na");
-    system().do_interpolation(interpolator.get(), "doping.nd");
-  }
-
-  // set mole fraction to semiconductor region
   if( MoleSolver.get() != NULL )
     MoleSolver->solve();
-  else
+
+  // the interpolated variables are evaluated in one pass
   {
-    if(system().has_single_compound_semiconductor_region())
-      system().do_interpolation(interpolator.get(), "mole.x");
-    if(system().has_complex_compound_semiconductor_region())
-      system().do_interpolation(interpolator.get(), "mole.y");
+    std::vector<std::string> variables;
+    for(unsigned int n=0; n<interpolate_variables.size(); ++n)
+      variables.push_back(interpolate_variables[n].first);
+    if( !variables.empty() )
+      system().do_interpolation(interpolator.get(), variables);
   }
 
   // after doping profile is set, we can init system data.
@@ -1489,6 +1928,79 @@ int SolverControl::do_refine_hierarchical(const Parser::Card & c)
 
   MESSAGE<<"Hierarchical mesh refinement...\n"<<std::endl; RECORD();
 
+  // fill error vector from system level
+  ErrorVector error_per_cell;
+  system().estimate_error(c, error_per_cell);
+
+  this->refine_hierarchical(c, error_per_cell, false);
+
+  return 0;
+
+}
+
+
+int SolverControl::do_refine_adaptive(const Parser::Card & c)
+{
+
+  MESSAGE<<"Adaptive mesh refinement...\n"<<std::endl; RECORD();
+
+  // we solve the last SOLVE card again on the refined mesh, it should be a single operating point
+  SolverSpecify::SolutionType type = SolverSpecify::INVALID_SolutionType;
+  if( _last_solve.is_parameter_exist("type") )
+    type = SolverSpecify::type_string_to_enum(_last_solve.get_string("type", ""));
+  if( type != SolverSpecify::EQUILIBRIUM && type != SolverSpecify::STEADYSTATE && type != SolverSpecify::OP )
+  {
+    MESSAGE<<"ERROR at " <<c.get_fileline()<< " REFINE.ADAPTIVE: should follow a SOLVE of EQUILIBRIUM, STEADYSTATE or OP type." << std::endl; RECORD();
+    genius_error();
+  }
+
+  const int    max_step     = c.get_int("max.step", 5);
+  const double error_target = c.get_real("error.target", 0.0);
+  const unsigned int max_node = c.get_int("max.node", 1000000);
+
+  for(int step=0; ; ++step)
+  {
+    // each processor estimates the cells it owns
+    ErrorVector error_per_cell;
+    system().estimate_error(c, error_per_cell);
+
+    double error_max = 0.0;
+    if (Genius::processor_id() == 0)
+      error_max = error_per_cell.maximum();
+    Parallel::broadcast(error_max);
+
+    MESSAGE<<"  Step "<< step <<": "<< mesh().n_nodes() <<" nodes, "<< mesh().n_active_elem() <<" cells, max cell error "<< error_max <<std::endl; RECORD();
+
+    if( error_max <= error_target )
+    {
+      MESSAGE<<"  Error target reached.\n"<<std::endl; RECORD();
+      break;
+    }
+    if( mesh().n_nodes() >= max_node )
+    {
+      MESSAGE<<"  Node budget reached.\n"<<std::endl; RECORD();
+      break;
+    }
+    if( step >= max_step )
+    {
+      MESSAGE<<"  Max refinement step reached.\n"<<std::endl; RECORD();
+      break;
+    }
+
+    this->refine_hierarchical(c, error_per_cell, true);
+
+    // solve again from the interpolated solution
+    Parser::Card solve_card = _last_solve;
+    this->do_solve(solve_card);
+  }
+
+  return 0;
+
+}
+
+
+void SolverControl::refine_hierarchical(const Parser::Card & c, const ErrorVector & error_per_cell, bool keep_solution)
+{
   // save previous solution
   AutoPtr<InterpolationBase> interpolator;
   if( mesh().magic_num() < 2008 )
@@ -1496,24 +2008,55 @@ int SolverControl::do_refine_hierarchical(const Parser::Card & c)
   else
     interpolator = AutoPtr<InterpolationBase>(new Interpolation3D_nbtet);
 
+  // all the variables are filled into the interpolator together
+  std::vector<std::pair<std::string, InterpolationBase::InterpolationType> > interpolate_variables;
   if( DopingSolver.get() == NULL )
   {
-    system().fill_interpolator(interpolator.get(), "doping.na", InterpolationBase::Asinh);
-    system().fill_interpolator(interpolator.get(), "doping.nd", InterpolationBase::Asinh);
+    interpolate_variables.push_back(std::make_pair(std::string("doping.na"), InterpolationBase::Asinh));
+    interpolate_variables.push_back(std::make_pair(std::string("doping.nd"), InterpolationBase::Asinh));
   }
 
   if(system().has_single_compound_semiconductor_region()  && MoleSolver.get() == NULL )
   {
-    system().fill_interpolator(interpolator.get(), "mole.x", InterpolationBase::Linear);
+    interpolate_variables.push_back(std::make_pair(std::string("mole.x"), InterpolationBase::Linear));
   }
   if(system().has_complex_compound_semiconductor_region()  && MoleSolver.get() == NULL )
   {
-    system().fill_interpolator(interpolator.get(), "mole.y", InterpolationBase::Linear);
+    interpolate_variables.push_back(std::make_pair(std::string("mole.y"), InterpolationBase::Linear));
   }
 
-  // fill error vector from system level
-  ErrorVector error_per_cell;
-  system().estimate_error(c, error_per_cell);
+  // the solution variables are set after init_region, they are the initial guess of the next solve
+  std::vector<std::pair<std::string, InterpolationBase::InterpolationType> > solution_variables;
+  std::map<std::string, std::string> electrode_states;
+  if( keep_solution )
+  {
+    solution_variables.push_back(std::make_pair(std::string("potential"), InterpolationBase::Linear));
+    solution_variables.push_back(std::make_pair(std::string("electron"), InterpolationBase::Asinh));
+    solution_variables.push_back(std::make_pair(std::string("hole"), InterpolationBase::Asinh));
+    solution_variables.push_back(std::make_pair(std::string("temperature"), InterpolationBase::Linear));
+    if( SolverSpecify::Solver == SolverSpecify::EBML3 || SolverSpecify::Solver == SolverSpecify::EBML3MIXA )
+    {
+      solution_variables.push_back(std::make_pair(std::string("e.temp"), InterpolationBase::Linear));
+      solution_variables.push_back(std::make_pair(std::string("h.temp"), InterpolationBase::Linear));
+    }
+
+    // the bias of electrodes, the boundary conditions are rebuilt with the system
+    for(unsigned int b=0; b<system().get_bcs()->n_bcs(); b++)
+    {
+      const BoundaryCondition * bc = system().get_bcs()->get_bc(b);
+      if( !bc->is_electrode() ) continue;
+      std::ostringstream out;
+      bc->ext_circuit()->write_state(out);
+      electrode_states[bc->label()] = out.str();
+    }
+  }
+
+  {
+    std::vector<std::pair<std::string, InterpolationBase::InterpolationType> > variables(interpolate_variables);
+    variables.insert(variables.end(), solution_variables.begin(), solution_variables.end());
+    if( !variables.empty() )
+      system().fill_interpolator(interpolator.get(), variables);
+  }
 
   if (Genius::processor_id() == 0)
   {
@@ -1552,31 +2095,42 @@ int SolverControl::do_refine_hierarchical(const Parser::Card & c)
   system().build_simulation_system();
   system().sync_print_info();
 
-  // set doping profile to semiconductor region
+  // set doping profile and mole fraction to semiconductor region
   if( DopingSolver.get() != NULL )
     DopingSolver->solve();
-  else
-  {
-    // no doping information?
-    system().do_interpolation(interpolator.get(), "doping.na");
-    system().do_interpolation(interpolator.get(), "doping.nd");
-  }
-
-  // set mole fraction to semiconductor region
   if( MoleSolver.get() != NULL )
     MoleSolver->solve();
-  else
+
+  // the interpolated variables are evaluated in one pass
   {
-    if(system().has_single_compound_semiconductor_region())
-      system().do_interpolation(interpolator.get(), "mole.x");
-    if(system().has_complex_compound_semiconductor_region())
-      system().do_interpolation(interpolator.get(), "mole.y");
+    std::vector<std::string> variables;
+    for(unsigned int n=0; n<interpolate_variables.size(); ++n)
+      variables.push_back(interpolate_variables[n].first);
+    if( !variables.empty() )
+      system().do_interpolation(interpolator.get(), variables);
   }
 
   // after doping profile is set, we can init system data.
   system().init_region();
 
-  return 0;
+  if( keep_solution )
+  {
+    std::vector<std::string> variables;
+    for(unsigned int n=0; n<solution_variables.size(); ++n)
+      variables.push_back(solution_variables[n].first);
+    system().do_interpolation(interpolator.get(), variables);
+
+    // update the carrier dependent parameters as an imported solution
+    system().reinit_region_after_import();
+
+    for(unsigned int b=0; b<system().get_bcs()->n_bcs(); b++)
+    {
+      BoundaryCondition * bc = system().get_bcs()->get_bc(b);
+      if( !bc->is_electrode() || electrode_states.find(bc->label()) == electrode_states.end() ) continue;
+      std::istringstream in(electrode_states[bc->label()]);
+      bc->ext_circuit()->read_state(in);
+    }
+  }
 
 }
 
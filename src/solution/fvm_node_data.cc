@@ -27,6 +27,7 @@
 #include "fvm_node_data_conductor.h"
 #include "fvm_node_data_resistance.h"
 #include "physical_unit.h"
+#include "object_pool.h"
 
 
 using PhysicalUnit::kb;
@@ -40,6 +41,24 @@ std::complex<PetscScalar> FVM_NodeData::_complex_dummy_ = std::complex<PetscScal
 
 VectorValue<PetscScalar> FVM_NodeData::_vector_dummy_(0,0,0);
 
+
+// the pool is never destroyed, FVM_NodeData objects may be deleted during static destruction
+static ObjectPool & fvm_node_data_pool()
+{
+  static ObjectPool * pool = new ObjectPool;
+  return *pool;
+}
+
+void * FVM_NodeData::operator new (size_t size)
+{
+  return fvm_node_data_pool().allocate(size);
+}
+
+void FVM_NodeData::operator delete (void * p, size_t size)
+{
+  fvm_node_data_pool().deallocate(p, size);
+}
+
 /*----------------------------------------------------------------
  * @return the intrinsic carrier concentration.
  * @note will not consider bandgap narrowing
@@ -21,18 +21,48 @@
 
 //  $Id: fvm_node_info.cc,v 1.8 2008/07/09 05:58:16 gdiso Exp $
 
+#include <algorithm>
+
 #include "elem.h"
 #include "fvm_node_info.h"
 #include "boundary_info.h"
+#include "object_pool.h"
 
-// TNT matrix-vector library
-#include <TNT/tnt.h>
-#include <TNT/jama_lu.h>
+#include "dense_matrix_fixed.h"
 
 
 unsigned int FVM_Node::_solver_index=0;
 
 
+// the pool is never destroyed, FVM_Node objects may be deleted during static destruction
+static ObjectPool & fvm_node_pool()
+{
+  static ObjectPool * pool = new ObjectPool;
+  return *pool;
+}
+
+void * FVM_Node::operator new (size_t size)
+{
+  return fvm_node_pool().allocate(size);
+}
+
+void FVM_Node::operator delete (void * p, size_t size)
+{
+  fvm_node_pool().deallocate(p, size);
+}
+
+
+namespace
+{
+  // order neighbor entries by their Node pointer
+  struct NeighborLess
+  {
+    bool operator() (const std::pair<const Node *, FVM_Node *> &a, const Node * b) const
+    { return a.first < b; }
+  };
+}
+
+
 FVM_Node::FVM_Node(const Node *n)
     : _node(n),
     _node_data(0),
@@ -56,6 +86,52 @@ FVM_Node::~FVM_Node()
 }
 
 
+unsigned int FVM_Node::neighbor_index(const Node * neighbor) const
+{
+  std::vector< std::pair<const Node *, FVM_Node *> >::const_iterator it =
+    std::lower_bound(_node_neighbor.begin(), _node_neighbor.end(), neighbor, NeighborLess());
+  if( it == _node_neighbor.end() || it->first != neighbor ) return invalid_uint;
+  return static_cast<unsigned int>(it - _node_neighbor.begin());
+}
+
+
+void FVM_Node::set_node_neighbor(const Node * n, FVM_Node *fn)
+{
+  std::vector< std::pair<const Node *, FVM_Node *> >::iterator it =
+    std::lower_bound(_node_neighbor.begin(), _node_neighbor.end(), n, NeighborLess());
+  if( it != _node_neighbor.end() && it->first == n )
+  {
+    it->second = fn;
+    return;
+  }
+
+  // insert a new neighbor, the cv surface area is zero until assigned
+  unsigned int i = static_cast<unsigned int>(it - _node_neighbor.begin());
+  _node_neighbor.insert(it, std::make_pair(n, fn));
+  _cv_surface_area.insert(_cv_surface_area.begin()+i, 0.0);
+}
+
+
+void FVM_Node::shrink_node_neighbor()
+{
+  std::vector< std::pair<const Node *, FVM_Node *> >(_node_neighbor).swap(_node_neighbor);
+  std::vector<Real>(_cv_surface_area).swap(_cv_surface_area);
+}
+
+
+size_t FVM_Node::memory_size() const
+{
+  size_t bytes = sizeof(FVM_Node);
+  bytes += _elem_has_this_node.capacity()*sizeof(std::pair<const Elem *, unsigned int>);
+  bytes += _node_neighbor.capacity()*sizeof(std::pair<const Node *, FVM_Node *>);
+  bytes += _cv_surface_area.capacity()*sizeof(Real);
+  // estimate the map node as the value plus three pointers and a color flag
+  if( _ghost_nodes )
+    bytes += sizeof(*_ghost_nodes) + _ghost_nodes->size()*(sizeof(std::pair< FVM_Node *, std::pair<unsigned int, Real> >) + 4*sizeof(void *));
+  return bytes;
+}
+
+
 void FVM_Node::set_ghost_node_area(unsigned int sub_id, Real area)
 {
   // the sub_id of boundary face equal to this FVM_Node and _ghost_nodes are empty
@@ -435,20 +511,19 @@ VectorValue<PetscScalar> FVM_Node::gradient(SolutionVariable var, bool ghost) co
   // so we set it to 1.0
   if(fabs(f)<1e-6) f=1.0;
 
-  TNT::Array2D<Real> A (3, 3);
-  TNT::Array1D<Real> r (3);
-  A[0][0] = a; A[0][1] = b; A[0][2] = c;
-  A[1][0] = b; A[1][1] = d; A[1][2] = e;
-  A[2][0] = c; A[2][1] = e; A[2][2] = f;
+  DenseMatrix3 A;
+  DenseVector3 r, dphi;
+  A(0,0) = a; A(0,1) = b; A(0,2) = c;
+  A(1,0) = b; A(1,1) = d; A(1,2) = e;
+  A(2,0) = c; A(2,1) = e; A(2,2) = f;
 
-  r[0] = r1;
-  r[1] = r2;
-  r[2] = r3;
+  r(0) = r1;
+  r(1) = r2;
+  r(2) = r3;
 
-  JAMA::LU<Real> solver(A);
-  TNT::Array1D<Real> dphi = solver.solve(r);
+  A.lu_solve(r, dphi);
 
-  return VectorValue<PetscScalar>(dphi[0], dphi[1], dphi[2]);
+  return VectorValue<PetscScalar>(dphi(0), dphi(1), dphi(2));
 }
 
 
@@ -463,21 +538,21 @@ void FVM_Node::operator += (const FVM_Node &other_node)
   // combine element
   _elem_has_this_node.insert(_elem_has_this_node.end(),  other_node.elem_begin(),  other_node.elem_end());
 
-  // combine neighbor node
-  _node_neighbor.insert(other_node.neighbor_node_begin(),  other_node.neighbor_node_end());
-
-  // add volume
-  _volume += other_node._volume;
-
-  // add cv surface
-  std::map< const Node *, Real >::const_iterator cv_it = other_node._cv_surface_area.begin();
-  for(; cv_it != other_node._cv_surface_area.end(); ++cv_it)
+  // combine neighbor node and add cv surface
+  for(unsigned int n=0; n<other_node._node_neighbor.size(); ++n)
   {
-    if(_cv_surface_area.find(cv_it->first) != _cv_surface_area.end())
-      (*_cv_surface_area.find(cv_it->first)).second += cv_it->second;
-    else
+    const Node * neighbor = other_node._node_neighbor[n].first;
+    unsigned int i = neighbor_index(neighbor);
+    if( i == invalid_uint )
+    {
       // insert a new item
-      _cv_surface_area[(*cv_it).first] = cv_it->second;
+      set_node_neighbor(neighbor, other_node._node_neighbor[n].second);
+      i = neighbor_index(neighbor);
+    }
+    _cv_surface_area[i] += other_node._cv_surface_area[n];
   }
 
+  // add volume
+  _volume += other_node._volume;
+
 }
@@ -72,6 +72,7 @@ void InsulatorSimulationRegion::insert_fvm_node(FVM_Node * fn)
     fn->hold_node_data( new FVM_Insulator_NodeData(&_node_data_storage, _region_point_variables) );
 
   _region_node[fn->root_node()->id()] = fn;
+  _region_node_index_valid = false;
 }
 
 
@@ -0,0 +1,155 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <cmath>
+#include <cctype>
+
+#include "genius_common.h"
+#include "log.h"
+#include "output_field.h"
+#include "fvm_node_data.h"
+#include "physical_unit.h"
+
+
+namespace
+{
+  const char * field_names[OutputField::N_FIELDS] =
+  {
+    "psi", "Ec", "Ev", "elec_quasi_Fermi_level", "hole_quasi_Fermi_level", "temperature",
+    "Na", "Nd", "net_doping", "net_charge", "electron_density", "hole_density",
+    "mole_x", "mole_y"
+  };
+  const bool field_semiconductor_only[OutputField::N_FIELDS] =
+  {
+    false, false, false, false, false, false,
+    true,  true,  true,  true,  true,  true,
+    true,  true
+  };
+  const bool field_static[OutputField::N_FIELDS] =
+  {
+    false, false, false, false, false, false,
+    true,  true,  true,  false, false, false,
+    true,  true
+  };
+}
+
+
+const char * OutputField::name(unsigned int f)
+{ return field_names[f]; }
+
+
+bool OutputField::semiconductor_only(unsigned int f)
+{ return field_semiconductor_only[f]; }
+
+
+bool OutputField::is_static(unsigned int f)
+{ return field_static[f]; }
+
+
+std::string OutputField::key(const std::string & name)
+{
+  std::string s;
+  for(unsigned int i=0; i<name.size(); ++i)
+    s += (name[i] == ' ' ? '_' : static_cast<char>(tolower(name[i])));
+  return s;
+}
+
+
+unsigned int OutputField::find(const std::string & name)
+{
+  const std::string k = key(name);
+  for(unsigned int f=0; f<N_FIELDS; ++f)
+    if( key(field_names[f]) == k ) return f;
+  return invalid_uint;
+}
+
+
+std::vector<std::string> OutputField::split(const std::string & name_list)
+{
+  std::vector<std::string> names;
+
+  std::string::size_type begin = 0;
+  while( begin < name_list.size() )
+  {
+    std::string::size_type end = name_list.find(',', begin);
+    if( end == std::string::npos ) end = name_list.size();
+
+    // strip the blanks around the name
+    std::string::size_type b = name_list.find_first_not_of(' ', begin);
+    std::string::size_type e = name_list.find_last_not_of(' ', end-1);
+    if( b < end && e != std::string::npos && e >= b )
+      names.push_back(name_list.substr(b, e-b+1));
+    begin = end + 1;
+  }
+
+  return names;
+}
+
+
+std::vector<unsigned int> OutputField::parse(const std::string & field_list, const std::string & who)
+{
+  std::vector<unsigned int> fields;
+
+  const std::vector<std::string> names = split(field_list);
+  for(unsigned int i=0; i<names.size(); ++i)
+  {
+    const unsigned int f = find(names[i]);
+    if( f != invalid_uint )
+      fields.push_back(f);
+    else
+    {
+      MESSAGE<<"Warning: " << who << ", unknown field " << names[i] << " ignored." << std::endl; RECORD();
+    }
+  }
+
+  if( field_list.empty() )
+    for(unsigned int f=0; f<N_FIELDS; ++f)
+      fields.push_back(f);
+
+  return fields;
+}
+
+
+float OutputField::value(unsigned int f, const FVM_NodeData * node_data)
+{
+  // scale back to normal unit
+  const double concentration_scale = pow(PhysicalUnit::cm, -3);
+
+  switch(f)
+  {
+      case PSI        : return static_cast<float>(node_data->psi()/PhysicalUnit::V);
+      case EC         : return static_cast<float>(node_data->Ec()/PhysicalUnit::eV);
+      case EV         : return static_cast<float>(node_data->Ev()/PhysicalUnit::eV);
+      case QFN        : return static_cast<float>(node_data->qFn()/PhysicalUnit::eV);
+      case QFP        : return static_cast<float>(node_data->qFp()/PhysicalUnit::eV);
+      case T          : return static_cast<float>(node_data->T()/PhysicalUnit::K);
+      case NA         : return static_cast<float>(node_data->Total_Na()/concentration_scale);
+      case ND         : return static_cast<float>(node_data->Total_Nd()/concentration_scale);
+      case NET_DOPING : return static_cast<float>(node_data->Net_doping()/concentration_scale);
+      case NET_CHARGE : return static_cast<float>(node_data->Net_charge()/concentration_scale);
+      case ELECTRON   : return static_cast<float>(node_data->n()/concentration_scale);
+      case HOLE       : return static_cast<float>(node_data->p()/concentration_scale);
+      case MOLE_X     : return static_cast<float>(node_data->mole_x());
+      case MOLE_Y     : return static_cast<float>(node_data->mole_y());
+      default : break;
+  }
+  return 0.0f;
+}
@@ -28,6 +28,7 @@
 #include "semiconductor_region.h"
 #include "fvm_node_data_semiconductor.h"
 #include "fvm_cell_data_semiconductor.h"
+#include "solver_specify.h"
 
 using PhysicalUnit::cm;
 using PhysicalUnit::nm;
@@ -47,7 +48,7 @@ using PhysicalUnit::mu0;
 
 
 SemiconductorSimulationRegion::SemiconductorSimulationRegion(const std::string &name, const std::string &material, const PetscScalar T)
-    :SimulationRegion(name, material, T)
+    :SimulationRegion(name, material, T), _trap_nodes_valid(false)
 {
   // material should be initializted after region variables
   this->set_region_variables();
@@ -59,6 +60,11 @@ void SemiconductorSimulationRegion::clear()
 {
   SimulationRegion::clear();
 
+  _ddm1_node_cache = DDM1NodeCache();
+
+  _trap_nodes.clear();
+  _trap_nodes_valid = false;
+
   // clear previous value
   _elem_on_insulator_interface.clear();
   _elem_in_mos_channel.clear();
@@ -86,6 +92,7 @@ void SemiconductorSimulationRegion::insert_fvm_node(FVM_Node * fn)
     fn->hold_node_data( new FVM_Semiconductor_NodeData(&_node_data_storage, _region_point_variables) );
 
   _region_node[fn->root_node()->id()] = fn;
+  _region_node_index_valid = false;
 }
 
 
@@ -156,6 +163,10 @@ void SemiconductorSimulationRegion::set_region_variables()
 
   _region_point_variables["charge_density"     ] = SimulationVariable("charge_density", SCALAR, POINT_CENTER, "cm^-3", FVM_Semiconductor_NodeData::_rho_, true);
 
+  _region_point_variables["taun"               ] = SimulationVariable("taun", SCALAR, POINT_CENTER, "s", FVM_Semiconductor_NodeData::_taun_, true);
+  _region_point_variables["taup"               ] = SimulationVariable("taup", SCALAR, POINT_CENTER, "s", FVM_Semiconductor_NodeData::_taup_, true);
+  _region_point_variables["temperature.material"] = SimulationVariable("temperature.material", SCALAR, POINT_CENTER, "K", FVM_Semiconductor_NodeData::_T_material_, true);
+
   _region_point_variables["efield"             ] = SimulationVariable("efield", VECTOR, POINT_CENTER, "V/cm", FVM_Semiconductor_NodeData::_E_, true);
   _region_point_variables["elec_current"       ] = SimulationVariable("elec_current", VECTOR, POINT_CENTER, "A/cm", FVM_Semiconductor_NodeData::_Jn_, true);
   _region_point_variables["hole_current"       ] = SimulationVariable("hole_current", VECTOR, POINT_CENTER, "A/cm", FVM_Semiconductor_NodeData::_Jp_, true);
@@ -265,6 +276,9 @@ void SemiconductorSimulationRegion::init(PetscScalar T_external)
     */
   }
 
+  // cache the field independent material quantities
+  update_material_cache(false, true);
+
     // build data structure for insulator interface
   find_elem_on_insulator_interface();
   find_nearest_interface_normal();
@@ -301,6 +315,9 @@ void SemiconductorSimulationRegion::reinit_after_import()
     node_data->mup()      = mt->mob->HoleMob(node_data->p(), node_data->n(), T, 0, 0, T);
   }
 
+  // doping may be changed by import
+  update_material_cache(false, true);
+
     // build data structure for insulator interface
   find_elem_on_insulator_interface();
   find_nearest_interface_normal();
@@ -308,6 +325,61 @@ void SemiconductorSimulationRegion::reinit_after_import()
 }
 
 
+void SemiconductorSimulationRegion::update_material_cache(bool isothermal, bool force)
+{
+  const PetscScalar T_ext = T_external();
+
+  local_node_iterator node_it = on_local_nodes_begin();
+  local_node_iterator node_it_end = on_local_nodes_end();
+  for(; node_it!=node_it_end; ++node_it)
+  {
+    FVM_Node * fvm_node = *node_it;
+    FVM_NodeData * node_data = fvm_node->node_data();
+
+    const PetscScalar T = isothermal ? T_ext : node_data->T();
+    if( !force && node_data->T_material() == T ) continue;
+
+    mt->mapping(fvm_node->root_node(), node_data, 0.0);
+    node_data->Nc()   = mt->band->Nc(T);
+    node_data->Nv()   = mt->band->Nv(T);
+    node_data->taun() = mt->band->TAUN(T);
+    node_data->taup() = mt->band->TAUP(T);
+    node_data->T_material() = T;
+  }
+}
+
+
+void SemiconductorSimulationRegion::set_pmi(const std::string &type, const std::string &model_name, std::vector<Parser::Parameter> & pmi_parameters)
+{
+  SimulationRegion::set_pmi(type, model_name, pmi_parameters);
+
+  // the interface traps are created by boundary conditions after this call,
+  // so only mark the list as invalid here
+  _trap_nodes_valid = false;
+}
+
+
+const std::vector<FVM_Node *> & SemiconductorSimulationRegion::trap_nodes()
+{
+  if( _trap_nodes_valid ) return _trap_nodes;
+
+  _trap_nodes.clear();
+
+  local_node_iterator node_it = on_local_nodes_begin();
+  local_node_iterator node_it_end = on_local_nodes_end();
+  for(; node_it!=node_it_end; ++node_it)
+  {
+    FVM_Node * fvm_node = *node_it;
+    mt->mapping(fvm_node->root_node(), fvm_node->node_data(), SolverSpecify::clock);
+    if( mt->trap->HasTrap(true) || mt->trap->HasTrap(false) )
+      _trap_nodes.push_back(fvm_node);
+  }
+
+  _trap_nodes_valid = true;
+  return _trap_nodes;
+}
+
+
 void SemiconductorSimulationRegion::find_elem_on_insulator_interface()
 {
   const_element_iterator it = elements_begin();
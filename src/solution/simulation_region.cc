@@ -19,18 +19,46 @@
 /*                                                                              */
 /********************************************************************************/
 
+#include <algorithm>
+
 #include "elem.h"
 #include "simulation_region.h"
 #include "material.h"
 #include "parallel.h"
+#include "genius_env.h"
+#include "output_field.h"
 
 // static member
 std::map<unsigned int,  SimulationRegion *>  SimulationRegion::_subdomain_id_to_region_map;
 
 
+// find the value of key in sorted <key, index> table, invalid_uint if not found
+template <typename K>
+static unsigned int sorted_index_of(const std::vector< std::pair<K, unsigned int> > &table, const K key)
+{
+  typename std::vector< std::pair<K, unsigned int> >::const_iterator it =
+    std::lower_bound(table.begin(), table.end(), std::make_pair(key, 0u));
+  if( it != table.end() && it->first == key ) return it->second;
+  return invalid_uint;
+}
+
+// sorted <FVM_Node, index> table of the on local nodes
+static void build_local_node_index(const std::vector<FVM_Node *> & local_nodes,
+                                   std::vector< std::pair<const FVM_Node *, unsigned int> > & local_node_index)
+{
+  local_node_index.clear();
+  local_node_index.reserve(local_nodes.size());
+  for(unsigned int n=0; n<local_nodes.size(); ++n)
+    local_node_index.push_back( std::make_pair(static_cast<const FVM_Node *>(local_nodes[n]), n) );
+  std::sort(local_node_index.begin(), local_node_index.end());
+}
+
+
 
 SimulationRegion::SimulationRegion(const std::string &name, const std::string &material, const PetscScalar T)
-    :_region_name(name), _region_material(material), _T_external(T)
+    :_region_name(name), _region_material(material), _T_external(T),
+     _has_2d_hanging_node(false), _has_3d_hanging_node(false),
+     _region_node_index_begin(0), _region_node_index_valid(false)
 {}
 
 
@@ -63,6 +91,17 @@ unsigned int SimulationRegion::n_on_processor_node() const
 }
 
 
+unsigned int SimulationRegion::local_node_buffer_size() const
+{
+  unsigned int size = 0;
+  std::vector<FVM_Node *>::const_iterator it = _region_local_node.begin();
+  for(; it != _region_local_node.end(); ++it)
+    if( (*it)->local_offset() != invalid_uint )
+      size = std::max(size, (*it)->local_offset()+1);
+  return size;
+}
+
+
 void SimulationRegion::region_node(std::vector<unsigned int> & nodes) const
 {
   parallel_only();
@@ -78,6 +117,19 @@ void SimulationRegion::region_node(std::vector<unsigned int> & nodes) const
 }
 
 
+void SimulationRegion::write_checkpoint(std::ostream & out) const
+{
+  _node_data_storage.write_scalar(out);
+  _cell_data_storage.write_scalar(out);
+}
+
+
+bool SimulationRegion::read_checkpoint(std::istream & in)
+{
+  return _node_data_storage.read_scalar(in) && _cell_data_storage.read_scalar(in);
+}
+
+
 void SimulationRegion::clear()
 {
   _region_cell.clear();
@@ -95,6 +147,9 @@ void SimulationRegion::clear()
   }
 
   _region_node.clear();
+  _region_node_index.clear();
+  _region_node_index_id.clear();
+  _region_node_index_valid = false;
   _region_local_node.clear();
   _region_processor_node.clear();
 
@@ -102,12 +157,18 @@ void SimulationRegion::clear()
   _node_data_storage.clear();
 
   _region_edges.clear();
+  _edge_arrays.clear();
+  _cell_edge_arrays.clear();
   _region_elem_edge_in_edges_index.clear();
   _region_neighbors.clear();
   _region_bounding_box = std::make_pair(Point(), Point());
 
   _hanging_node_on_elem_side.clear();
   _hanging_node_on_elem_edge.clear();
+  _hanging_node_on_elem_side_constraints.clear();
+  _hanging_node_on_elem_edge_constraints.clear();
+  _has_2d_hanging_node = false;
+  _has_3d_hanging_node = false;
 }
 
 
@@ -132,12 +193,363 @@ void SimulationRegion::rebuild_region_fvm_node_list()
     }
     if( fvm_node->on_processor() ) _region_processor_node.push_back(fvm_node);
   }
+
+  // the index of local node changed
+  rebuild_edge_arrays();
+  rebuild_cell_node_arrays();
+  _output_field_cache.clear();
+
+  rebuild_region_node_index();
+}
+
+
+void SimulationRegion::rebuild_region_node_index()
+{
+  _region_node_index.clear();
+  _region_node_index_id.clear();
+  _region_node_index_begin = 0;
+  _region_node_index_valid = true;
+
+  if( _region_node.empty() ) return;
+
+  // _region_node is ordered by id
+  unsigned int id_begin = _region_node.begin()->first;
+  unsigned int id_span  = _region_node.rbegin()->first - id_begin + 1;
+
+  // use dense table if it is not much larger than the node number
+  if( id_span <= 4*_region_node.size() + 1024 )
+  {
+    _region_node_index_begin = id_begin;
+    _region_node_index.resize(id_span, NULL);
+    std::map<unsigned int, FVM_Node *>::const_iterator it = _region_node.begin();
+    for(; it != _region_node.end(); ++it)
+      _region_node_index[it->first - id_begin] = it->second;
+    return;
+  }
+
+  _region_node_index.reserve(_region_node.size());
+  _region_node_index_id.reserve(_region_node.size());
+  std::map<unsigned int, FVM_Node *>::const_iterator it = _region_node.begin();
+  for(; it != _region_node.end(); ++it)
+  {
+    _region_node_index_id.push_back(it->first);
+    _region_node_index.push_back(it->second);
+  }
+}
+
+
+void SimulationRegion::memory_usage(MemoryLog & log) const
+{
+  // the map node of _region_node is estimated as the value plus three pointers and a color flag
+  size_t node_bytes = _region_node.size()*(sizeof(std::pair<unsigned int, FVM_Node *>) + 4*sizeof(void *));
+  node_bytes += _region_node_index.capacity()*sizeof(FVM_Node *) + _region_node_index_id.capacity()*sizeof(unsigned int);
+  node_bytes += (_region_local_node.capacity() + _region_processor_node.capacity())*sizeof(FVM_Node *);
+
+  size_t node_data_bytes = _node_data_storage.memory_size();
+  std::map<unsigned int, FVM_Node *>::const_iterator it = _region_node.begin();
+  for(; it != _region_node.end(); ++it)
+  {
+    node_bytes += it->second->memory_size();
+    if( it->second->node_data() ) node_data_bytes += sizeof(FVM_NodeData);
+  }
+  log.add("FVM node", node_bytes);
+  log.add("FVM node data", node_data_bytes);
+
+  size_t cell_bytes = _cell_data_storage.memory_size();
+  cell_bytes += _region_cell.capacity()*sizeof(const Elem *) + _region_cell_data.size()*sizeof(FVM_CellData);
+  log.add("FVM cell data", cell_bytes);
+
+  size_t edge_bytes = _region_edges.capacity()*sizeof(std::pair<FVM_Node *, FVM_Node *>);
+  edge_bytes += (_edge_arrays.node1.capacity() + _edge_arrays.node2.capacity())*sizeof(unsigned int);
+  edge_bytes += (_edge_arrays.length.capacity() + _edge_arrays.area.capacity())*sizeof(Real);
+  edge_bytes += (_cell_edge_arrays.begin.capacity() + _cell_edge_arrays.edge.capacity())*sizeof(unsigned int);
+  edge_bytes += (_cell_edge_arrays.node1.capacity() + _cell_edge_arrays.node2.capacity())*sizeof(unsigned int);
+  edge_bytes += (_cell_edge_arrays.length.capacity() + _cell_edge_arrays.area.capacity() + _cell_edge_arrays.volume.capacity())*sizeof(Real);
+  edge_bytes += (_cell_edge_arrays.area_truncated.capacity() + _cell_edge_arrays.volume_truncated.capacity())*sizeof(Real);
+  edge_bytes += (_cell_edge_arrays.reconstruct_x.capacity() + _cell_edge_arrays.reconstruct_y.capacity() + _cell_edge_arrays.reconstruct_z.capacity())*sizeof(Real);
+  edge_bytes += (_cell_node_arrays.begin.capacity() + _cell_node_arrays.node.capacity())*sizeof(unsigned int);
+  edge_bytes += (_cell_node_arrays.grad_x.capacity() + _cell_node_arrays.grad_y.capacity() + _cell_node_arrays.grad_z.capacity())*sizeof(Real);
+  edge_bytes += _region_elem_edge_in_edges_index.size()*(sizeof(const Elem *) + sizeof(std::vector<unsigned int>) + 6*sizeof(unsigned int) + 2*sizeof(void *));
+  log.add("FVM edge", edge_bytes);
+}
+
+
+FVM_Node * SimulationRegion::find_region_node_sparse(unsigned int id) const
+{
+  if( !_region_node_index_valid )
+  {
+    std::map<unsigned int, FVM_Node *>::const_iterator it = _region_node.find( id );
+    if( it!=_region_node.end() )
+      return (*it).second;
+    return NULL;
+  }
+
+  std::vector<unsigned int>::const_iterator it =
+    std::lower_bound(_region_node_index_id.begin(), _region_node_index_id.end(), id);
+  if( it != _region_node_index_id.end() && *it == id )
+    return _region_node_index[it - _region_node_index_id.begin()];
+  return NULL;
+}
+
+
+void SimulationRegion::rebuild_edge_arrays()
+{
+  _edge_arrays.clear();
+  _poisson_edge_operator.clear();
+
+  std::vector< std::pair<const FVM_Node *, unsigned int> > local_node_index;
+  build_local_node_index(_region_local_node, local_node_index);
+
+  const int n_edges = _region_edges.size();
+  _edge_arrays.node1.resize(n_edges);
+  _edge_arrays.node2.resize(n_edges);
+  _edge_arrays.length.resize(n_edges);
+  _edge_arrays.area.resize(n_edges);
+
+  // each edge only writes its own slot
+#pragma omp parallel for schedule(static) num_threads(Genius::n_threads())
+  for(int n=0; n<n_edges; ++n)
+  {
+    const FVM_Node * fvm_n1 = _region_edges[n].first;
+    const FVM_Node * fvm_n2 = _region_edges[n].second;
+
+    // nodes of local cell should be on local, invalid_uint otherwise
+    _edge_arrays.node1[n] = sorted_index_of(local_node_index, fvm_n1);
+    _edge_arrays.node2[n] = sorted_index_of(local_node_index, fvm_n2);
+    _edge_arrays.length[n] = fvm_n1->distance(fvm_n2);
+    _edge_arrays.area[n] = fvm_n1->cv_surface_area(fvm_n2->root_node());
+  }
+}
+
+
+const SimulationRegion::EdgeOperator & SimulationRegion::poisson_edge_operator() const
+{
+  if( !_poisson_edge_operator.begin.empty() || _region_local_node.empty() )
+    return _poisson_edge_operator;
+
+  const unsigned int n_nodes = _region_local_node.size();
+  const unsigned int n_edges = _edge_arrays.node1.size();
+
+  // one diagonal entry for each node and one off diagonal entry for each end of an edge
+  std::vector<unsigned int> n_entries(n_nodes, 1);
+  for(unsigned int e=0; e<n_edges; ++e)
+  {
+    n_entries[_edge_arrays.node1[e]]++;
+    n_entries[_edge_arrays.node2[e]]++;
+  }
+
+  EdgeOperator & op = _poisson_edge_operator;
+  op.begin.resize(n_nodes+1);
+  op.begin[0] = 0;
+  for(unsigned int i=0; i<n_nodes; ++i)
+    op.begin[i+1] = op.begin[i] + n_entries[i];
+  op.node.resize(op.begin[n_nodes]);
+  op.value.resize(op.begin[n_nodes], 0.0);
+
+  std::vector<unsigned int> fill(op.begin.begin(), op.begin.end()-1);
+  for(unsigned int i=0; i<n_nodes; ++i)
+    op.node[fill[i]++] = i;
+
+  for(unsigned int e=0; e<n_edges; ++e)
+  {
+    const unsigned int i = _edge_arrays.node1[e];
+    const unsigned int j = _edge_arrays.node2[e];
+
+    // eps at mid point of the edge
+    Real eps = 0.5*(_region_local_node[i]->node_data()->eps() + _region_local_node[j]->node_data()->eps());
+    Real g = eps*_edge_arrays.area[e]/_edge_arrays.length[e];
+
+    op.value[op.begin[i]] -= g;
+    op.node[fill[i]] = j;  op.value[fill[i]++] = g;
+
+    op.value[op.begin[j]] -= g;
+    op.node[fill[j]] = i;  op.value[fill[j]++] = g;
+  }
+
+  return op;
+}
+
+
+void SimulationRegion::rebuild_cell_edge_arrays()
+{
+  _cell_edge_arrays.clear();
+
+  const int n_cells = _region_cell.size();
+  _cell_edge_arrays.begin.resize(n_cells+1);
+  _cell_edge_arrays.begin[0] = 0;
+  for(int c=0; c<n_cells; ++c)
+    _cell_edge_arrays.begin[c+1] = _cell_edge_arrays.begin[c] + _region_cell[c]->n_edges();
+
+  const unsigned int n_cell_edges = _cell_edge_arrays.begin[n_cells];
+  _cell_edge_arrays.edge.resize(n_cell_edges);
+  _cell_edge_arrays.node1.resize(n_cell_edges);
+  _cell_edge_arrays.node2.resize(n_cell_edges);
+  _cell_edge_arrays.length.resize(n_cell_edges);
+  _cell_edge_arrays.area.resize(n_cell_edges);
+  _cell_edge_arrays.volume.resize(n_cell_edges);
+  _cell_edge_arrays.area_truncated.resize(n_cell_edges);
+  _cell_edge_arrays.volume_truncated.resize(n_cell_edges);
+  _cell_edge_arrays.reconstruct_x.resize(n_cell_edges);
+  _cell_edge_arrays.reconstruct_y.resize(n_cell_edges);
+  _cell_edge_arrays.reconstruct_z.resize(n_cell_edges);
+
+  // each cell only writes its own slots, the map is only read here
+#pragma omp parallel for schedule(static) num_threads(Genius::n_threads())
+  for(int c=0; c<n_cells; ++c)
+  {
+    const Elem * elem = _region_cell[c];
+    const std::vector<unsigned int> & edge_index = _region_elem_edge_in_edges_index.find(elem)->second;
+    for(unsigned int ne=0; ne<elem->n_edges(); ++ne)
+    {
+      const unsigned int i = _cell_edge_arrays.begin[c] + ne;
+
+      std::pair<unsigned int, unsigned int> edge_nodes;
+      elem->nodes_on_edge(ne, edge_nodes);
+
+      _cell_edge_arrays.edge[i]  = edge_index[ne];
+      _cell_edge_arrays.node1[i] = edge_nodes.first;
+      _cell_edge_arrays.node2[i] = edge_nodes.second;
+      _cell_edge_arrays.length[i] = elem->edge_length(ne);
+      _cell_edge_arrays.area[i]   = elem->partial_area_with_edge(ne);
+      _cell_edge_arrays.volume[i] = elem->partial_volume_with_edge(ne);
+      _cell_edge_arrays.area_truncated[i]   = elem->partial_area_with_edge_truncated(ne);
+      _cell_edge_arrays.volume_truncated[i] = elem->partial_volume_with_edge_truncated(ne);
+    }
+
+    // the reconstruction is linear, its coefficients are the response to unit projections.
+    // a 1D cell has only one edge, the vector is the projection along it
+    if( elem->dim() == 1 )
+    {
+      const unsigned int i = _cell_edge_arrays.begin[c];
+      const Point dir = (elem->point(1) - elem->point(0)).unit();
+      _cell_edge_arrays.reconstruct_x[i] = dir(0);
+      _cell_edge_arrays.reconstruct_y[i] = dir(1);
+      _cell_edge_arrays.reconstruct_z[i] = dir(2);
+      continue;
+    }
+
+    std::vector<PetscScalar> projection(elem->n_edges(), 0.0);
+    for(unsigned int ne=0; ne<elem->n_edges(); ++ne)
+    {
+      const unsigned int i = _cell_edge_arrays.begin[c] + ne;
+      projection[ne] = 1.0;
+      const VectorValue<PetscScalar> v = elem->reconstruct_vector(projection);
+      projection[ne] = 0.0;
+      _cell_edge_arrays.reconstruct_x[i] = v(0);
+      _cell_edge_arrays.reconstruct_y[i] = v(1);
+      _cell_edge_arrays.reconstruct_z[i] = v(2);
+    }
+  }
+}
+
+
+void SimulationRegion::rebuild_cell_node_arrays()
+{
+  _cell_node_arrays.clear();
+
+  std::vector< std::pair<const FVM_Node *, unsigned int> > local_node_index;
+  build_local_node_index(_region_local_node, local_node_index);
+
+  const int n_cells = _region_cell.size();
+  _cell_node_arrays.begin.resize(n_cells+1);
+  _cell_node_arrays.begin[0] = 0;
+  for(int c=0; c<n_cells; ++c)
+    _cell_node_arrays.begin[c+1] = _cell_node_arrays.begin[c] + _region_cell[c]->n_nodes();
+
+  const unsigned int n_cell_nodes = _cell_node_arrays.begin[n_cells];
+  _cell_node_arrays.node.resize(n_cell_nodes);
+  _cell_node_arrays.grad_x.resize(n_cell_nodes);
+  _cell_node_arrays.grad_y.resize(n_cell_nodes);
+  _cell_node_arrays.grad_z.resize(n_cell_nodes);
+
+  // each cell only writes its own slots
+#pragma omp parallel for schedule(static) num_threads(Genius::n_threads())
+  for(int c=0; c<n_cells; ++c)
+  {
+    const Elem * elem = _region_cell[c];
+
+    // the gradient is linear, its coefficients are the response to unit node values
+    std::vector<PetscScalar> value(elem->n_nodes(), 0.0);
+    for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
+    {
+      const unsigned int i = _cell_node_arrays.begin[c] + nd;
+      _cell_node_arrays.node[i] = sorted_index_of(local_node_index, static_cast<const FVM_Node *>(elem->get_fvm_node(nd)));
+
+      value[nd] = 1.0;
+      const VectorValue<PetscScalar> g = elem->gradient(value);
+      value[nd] = 0.0;
+      _cell_node_arrays.grad_x[i] = g(0);
+      _cell_node_arrays.grad_y[i] = g(1);
+      _cell_node_arrays.grad_z[i] = g(2);
+    }
+  }
+}
+
+
+void SimulationRegion::update_cell_fields(const PetscScalar * psi, const PetscScalar * Jn, const PetscScalar * Jp)
+{
+  const CellNodeArrays & cn = _cell_node_arrays;
+  const CellEdgeArrays & ce = _cell_edge_arrays;
+
+  // each cell only writes its own cell data
+  const int n_cells = _region_cell.size();
+#pragma omp parallel for schedule(static) num_threads(Genius::n_threads())
+  for(int c=0; c<n_cells; ++c)
+  {
+    FVM_CellData * elem_data = _region_cell_data[c];
+
+    if( psi )
+    {
+      PetscScalar Ex=0, Ey=0, Ez=0;
+      for(unsigned int i=cn.begin[c]; i<cn.begin[c+1]; ++i)
+      {
+        const PetscScalar v = psi[cn.node[i]];
+        Ex -= cn.grad_x[i]*v;
+        Ey -= cn.grad_y[i]*v;
+        Ez -= cn.grad_z[i]*v;
+      }
+      elem_data->E() = VectorValue<PetscScalar>(Ex, Ey, Ez);
+    }
+
+    if( Jn )
+      elem_data->Jn() = -cell_reconstruct_vector(c, Jn + ce.begin[c]);
+
+    if( Jp )
+      elem_data->Jp() =  cell_reconstruct_vector(c, Jp + ce.begin[c]);
+  }
+}
+
+
+const std::vector<float> & SimulationRegion::output_field(unsigned int f, unsigned int version) const
+{
+  std::pair<unsigned int, std::vector<float> > & cache = _output_field_cache[f];
+  if( cache.first == version && cache.second.size() == _region_local_node.size() )
+    return cache.second;
+
+  cache.first = version;
+  cache.second.resize(_region_local_node.size());
+  for(unsigned int n=0; n<_region_local_node.size(); ++n)
+    cache.second[n] = OutputField::value(f, _region_local_node[n]->node_data());
+  return cache.second;
+}
+
+
+void SimulationRegion::update_cell_electric_field()
+{
+  std::vector<PetscScalar> psi(_region_local_node.size());
+  for(unsigned int n=0; n<_region_local_node.size(); ++n)
+    psi[n] = _region_local_node[n]->node_data()->psi();
+
+  if( !psi.empty() )
+    update_cell_fields(&psi[0], 0, 0);
 }
 
 
 void SimulationRegion::prepare_for_use()
 {
-  // first, we set std::map< const Node *, FVM_Node * > _node_neighbor for FVM_Node
+  rebuild_region_node_index();
+
+  // first, we set the FVM_Node of each entry in _node_neighbor for FVM_Node
   std::map<unsigned int, FVM_Node *>::iterator nodes_it = _region_node.begin();
   for(; nodes_it != _region_node.end(); ++nodes_it)
   {
@@ -149,6 +561,7 @@ void SimulationRegion::prepare_for_use()
     FVM_Node::fvm_neighbor_node_iterator  nb_fvm_node_it = fvm_node->neighbor_node_begin();
     for(; nb_fvm_node_it!=fvm_node->neighbor_node_end(); ++nb_fvm_node_it)
       fvm_node->set_node_neighbor( (*nb_fvm_node_it).first, region_fvm_node((*nb_fvm_node_it).first) );
+    fvm_node->shrink_node_neighbor();
   }
 
   // for efficient reason, let each element hold pointer to corresponding FVM_Node
@@ -185,14 +598,40 @@ void SimulationRegion::prepare_for_use()
   // build these two vector for fast iteration
   rebuild_region_fvm_node_list();
 
+  // the element shapes in this region, for the performance log of region kernels
+  {
+    static const char * shapes[] = { "Edge", "Tri", "Quad", "Tet", "Hex", "Prism", "Pyramid", "Inf" };
+    std::vector<bool> has_shape(8, false);
+    for(unsigned int c=0; c<_region_cell.size(); ++c)
+    {
+      const ElemType type = _region_cell[c]->type();
+      if     ( type <= EDGE4 )    has_shape[0] = true;
+      else if( type <= TRI6 )     has_shape[1] = true;
+      else if( type <= QUAD9 )    has_shape[2] = true;
+      else if( type <= TET10 )    has_shape[3] = true;
+      else if( type <= HEX27 )    has_shape[4] = true;
+      else if( type <= PRISM18 )  has_shape[5] = true;
+      else if( type <= PYRAMID5_FVM ) has_shape[6] = true;
+      else                        has_shape[7] = true;
+    }
+    _kernel_label = this->type_name();
+    char sep = ' ';
+    for(unsigned int i=0; i<has_shape.size(); ++i)
+      if( has_shape[i] ) { _kernel_label += sep; _kernel_label += shapes[i]; sep = '+'; }
+  }
+
 
   // build region edges
   {
-    typedef std::map<std::pair<unsigned int, unsigned int>, std::vector<std::pair<const Elem*, unsigned int> > > EdgeCellMap;
-    EdgeCellMap region_edge_map;
-    for(elem_it = elements_begin(); elem_it != elements_end(); elem_it++)
+    // all the (edge, elem, local edge index) records, sorted by edge nodes.
+    // one flat array and one sort is much cheaper than a map with a vector for each edge
+    typedef std::pair< std::pair<unsigned int, unsigned int>, std::pair<unsigned int, unsigned int> > EdgeCellRecord;
+    std::vector<EdgeCellRecord> edge_records;
+    edge_records.reserve(6*_region_cell.size());
+    for(unsigned int c=0; c<_region_cell.size(); ++c)
     {
-      const Elem * elem = *elem_it; // elem are on local
+      const Elem * elem = _region_cell[c]; // elem are on local
+      _region_elem_edge_in_edges_index[elem].resize(elem->n_edges());
       for(unsigned int n=0; n<elem->n_edges(); ++n)
       {
         std::pair<unsigned int, unsigned int> local_edge_nodes;
@@ -203,31 +642,25 @@ void SimulationRegion::prepare_for_use()
         std::pair<unsigned int, unsigned int> edge_nodes = std::make_pair(node1_id, node2_id);
         if( edge_nodes.first > edge_nodes.second )
           std::swap(edge_nodes.first, edge_nodes.second);
-        region_edge_map[edge_nodes].push_back(std::make_pair(elem, n));
+        edge_records.push_back( std::make_pair(edge_nodes, std::make_pair(c, n)) );
       }
     }
-    EdgeCellMap::const_iterator  edge_it = region_edge_map.begin();
-    for(; edge_it != region_edge_map.end(); ++edge_it)
-    {
-      const std::pair<unsigned int, unsigned int> & edge_nodes = edge_it->first;
-      unsigned int edge_index =  _region_edges.size();
-      _region_edges.push_back( std::make_pair(region_fvm_node(edge_nodes.first), region_fvm_node(edge_nodes.second)) );
-
-      const std::vector<std::pair<const Elem*, unsigned int> > & elem_shares_edge = edge_it->second;
-      for(unsigned int n=0; n<elem_shares_edge.size(); ++n)
-      {
-        const Elem * elem = elem_shares_edge[n].first;
-        unsigned int local_edge_index = elem_shares_edge[n].second;
+    std::sort(edge_records.begin(), edge_records.end());
 
-        if(_region_elem_edge_in_edges_index.find(elem) == _region_elem_edge_in_edges_index.end())
-        {
-          _region_elem_edge_in_edges_index[elem].resize(elem->n_edges());
-          _region_elem_edge_in_edges_index[elem][local_edge_index] = edge_index;
-        }
-        else
-          _region_elem_edge_in_edges_index[elem][local_edge_index] = edge_index;
-      }
+    for(unsigned int r=0; r<edge_records.size(); ++r)
+    {
+      const std::pair<unsigned int, unsigned int> & edge_nodes = edge_records[r].first;
+      if( r==0 || edge_nodes != edge_records[r-1].first )
+        _region_edges.push_back( std::make_pair(region_fvm_node(edge_nodes.first), region_fvm_node(edge_nodes.second)) );
+      unsigned int edge_index =  _region_edges.size() - 1;
+
+      const Elem * elem = _region_cell[edge_records[r].second.first];
+      unsigned int local_edge_index = edge_records[r].second.second;
+      _region_elem_edge_in_edges_index[elem][local_edge_index] = edge_index;
     }
+
+    rebuild_edge_arrays();
+    rebuild_cell_edge_arrays();
   }
 
 
@@ -320,6 +753,7 @@ void SimulationRegion::remove_remote_object()
 
   for(unsigned int n=0; n<remote_nodes.size(); ++n)
     _region_node.erase( remote_nodes[n] );
+  _region_node_index_valid = false;
 }
 
 
@@ -493,6 +927,45 @@ void SimulationRegion::get_user_defined_variable(DataLocation location, DataType
 
 
 
+Real * SimulationRegion::node_scalar_data(const std::string &v, unsigned int &size, Real &unit)
+{
+  size = 0;
+  unit = 1.0;
+
+  if( _region_point_variables.find(v) == _region_point_variables.end() ) return NULL;
+
+  const SimulationVariable & variable = _region_point_variables.find(v)->second;
+  if( variable.variable_data_type != SCALAR ) return NULL;
+
+  Real * data = _node_data_storage.scalar_data(variable.variable_index);
+  if( data == NULL ) return NULL;
+
+  size = _node_data_storage.size();
+  unit = variable.variable_unit;
+  return data;
+}
+
+
+void SimulationRegion::node_data_ids(std::vector<unsigned int> &ids, std::vector<int> &on_processor) const
+{
+  ids.assign(_node_data_storage.size(), invalid_uint);
+  on_processor.assign(_node_data_storage.size(), 0);
+
+  std::map< unsigned int, FVM_Node * >::const_iterator it = _region_node.begin();
+  for( ; it != _region_node.end(); ++it)
+  {
+    const FVM_Node * fvm_node = it->second;
+    // only local nodes hold node data
+    if( fvm_node->node_data() == NULL ) continue;
+
+    unsigned int offset = fvm_node->node_data()->offset();
+    ids[offset] = it->first;
+    on_processor[offset] = fvm_node->on_processor() ? 1 : 0;
+  }
+}
+
+
+
 template <typename T>
 bool SimulationRegion::get_variable_data(const std::string &var_name, DataLocation location, std::vector<T> &sv) const
 {
@@ -563,6 +1036,8 @@ void SimulationRegion::set_pmi(const std::string &type, const std::string &model
     FVM_NodeData * node_data = (*it)->node_data();
     genius_assert(node_data!=NULL);
     get_material_base()->init_node(type, (*it)->root_node(), node_data);
+    // the cached material quantities are evaluated by the old model
+    node_data->T_material() = -1.0;
   }
 }
 
@@ -585,16 +1060,58 @@ std::string SimulationRegion::get_pmi_info(const std::string& type, const int ve
 
 bool SimulationRegion::has_2d_hanging_node() const
 {
-  bool flag = ( _hanging_node_on_elem_side.size() != 0 && _hanging_node_on_elem_edge.size() == 0 );
-  Parallel::max(flag);
-  return flag;
+  return _has_2d_hanging_node;
 }
 
 bool SimulationRegion::has_3d_hanging_node() const
 {
-  bool flag = ( _hanging_node_on_elem_edge.size() != 0 );
-  Parallel::max(flag);
-  return flag;
+  return _has_3d_hanging_node;
+}
+
+
+void SimulationRegion::build_hanging_node_constraints()
+{
+  _hanging_node_on_elem_side_constraints.clear();
+  _hanging_node_on_elem_edge_constraints.clear();
+
+  // hanging node on element side, the parents are the nodes of the side
+  for(hanging_node_on_elem_side_iterator it = _hanging_node_on_elem_side.begin(); it != _hanging_node_on_elem_side.end(); ++it)
+  {
+    HangingNodeConstraint constraint;
+    constraint.node = (*it).first;
+
+    const Elem * elem = (*it).second.first;
+    AutoPtr<Elem>  side = elem->build_side((*it).second.second);
+    for(unsigned int n=0; n < side->n_nodes(); n++)
+      constraint.parents.push_back( region_fvm_node(side->get_node(n)) );
+
+    _hanging_node_on_elem_side_constraints.push_back(constraint);
+  }
+
+  // hanging node on element edge, the parents are the two nodes of the edge
+  for(hanging_node_on_elem_edge_iterator it = _hanging_node_on_elem_edge.begin(); it != _hanging_node_on_elem_edge.end(); ++it)
+  {
+    HangingNodeConstraint constraint;
+    constraint.node = (*it).first;
+
+    const Elem * elem = (*it).second.first;
+    AutoPtr<Elem>  edge = elem->build_edge((*it).second.second);
+    for(unsigned int n=0; n < edge->n_nodes(); n++)
+    {
+      const FVM_Node * edge_fvm_node = region_fvm_node(edge->get_node(n));
+      genius_assert(edge_fvm_node!=NULL);
+      constraint.parents.push_back( edge_fvm_node );
+    }
+
+    _hanging_node_on_elem_edge_constraints.push_back(constraint);
+  }
+
+  // the flags are global, evaluate them once here instead of every assembly
+  _has_2d_hanging_node = ( _hanging_node_on_elem_side.size() != 0 && _hanging_node_on_elem_edge.size() == 0 );
+  Parallel::max(_has_2d_hanging_node);
+
+  _has_3d_hanging_node = ( _hanging_node_on_elem_edge.size() != 0 );
+  Parallel::max(_has_3d_hanging_node);
 }
 
 //explicit instantiation
@@ -23,6 +23,8 @@
 
 #include <sstream>
 #include <numeric>
+#include <cmath>
+#include <algorithm>
 
 #include "parser.h"
 #include "unstructured_mesh.h"
@@ -35,6 +37,7 @@
 #include "vacuum_region.h"
 #include "pml_region.h"
 #include "parallel.h"
+#include "genius_env.h"
 #include "boundary_info.h"
 #include "boundary_condition_collector.h"
 #include "electrical_source.h"
@@ -53,6 +56,7 @@
 #include "interpolation_2d_csa.h"
 
 #include "perf_log.h"
+#include "memory_log.h"
 #include "sync_file.h"
 
 
@@ -68,7 +72,8 @@
 
 SimulationSystem::SimulationSystem(MeshBase & mesh)
     : _mesh(mesh), _resistive_metal_mode(false), _bcs(0), _sources(0),
-    _field_source(0), _spice_ckt(0), _z_width(1.0)
+    _field_source(0), _spice_ckt(0), _z_width(1.0), _partition_boundary_weight(0),
+    _partition_interface_weight(1), _solution_version(0)
 {
   // set PhysicalUnit
   PhysicalUnit::set_unit( std::pow(1e18,1.0/3.0) );
@@ -80,7 +85,8 @@ SimulationSystem::SimulationSystem(MeshBase & mesh)
 
 SimulationSystem::SimulationSystem(MeshBase & mesh, Parser::InputParser & _decks)
     :  _T_external(300.0), _mesh(mesh), _resistive_metal_mode(false), _bcs(0), _sources(0),
-    _field_source(0), _spice_ckt(0), _z_width(1.0)
+    _field_source(0), _spice_ckt(0), _z_width(1.0), _partition_boundary_weight(1),
+    _partition_interface_weight(5), _solution_version(0)
 {
 
   MESSAGE<<"Constructing Simulation System...\n"<<std::endl;  RECORD();
@@ -104,6 +110,25 @@ SimulationSystem::SimulationSystem(MeshBase & mesh, Parser::InputParser & _decks
     }
   }
 
+  // the partition weight is estimated by the first solver in the deck if not given by PARTITION card
+  for( _decks.begin(); !_decks.end(); _decks.next() )
+  {
+    Parser::Card c = _decks.get_current_card();
+    if( c.key() == "METHOD" && _partition_solver.empty() )
+      _partition_solver = c.get_string("type", "ddml1");
+  }
+  for( _decks.begin(); !_decks.end(); _decks.next() )
+  {
+    Parser::Card c = _decks.get_current_card();
+    if( c.key() == "PARTITION" )
+    {
+      std::string solver = c.get_string("solver", "auto");
+      if( solver != "auto" ) _partition_solver = solver;
+      _partition_boundary_weight = c.get_int("boundary.weight", 1);
+      _partition_interface_weight = c.get_int("interface.weight", 5);
+    }
+  }
+
   // set PhysicalUnit
   PhysicalUnit::set_unit( std::pow(doping_scale,1.0/3.0) );
 
@@ -194,14 +219,90 @@ void SimulationSystem::clear(bool clear_mesh)
 
   //since we cleared all the solution data, previous solve histroy is meaningless
   _solver_active_history.clear();
+  _bias_solutions.clear();
+}
+
+
+
+/**
+ * the max number of solutions kept by bias solution cache
+ */
+static const unsigned int max_bias_solutions = 64;
+
+/**
+ * applied voltage/current of two bias are the same
+ */
+static bool same_bias(const std::vector<PetscScalar> & b1, const std::vector<PetscScalar> & b2)
+{
+  if( b1.size() != b2.size() ) return false;
+  for(unsigned int i=0; i<b1.size(); ++i)
+    if( std::abs(b1[i]-b2[i]) > 1e-9*std::max(std::abs(b1[i]), std::abs(b2[i])) ) return false;
+  return true;
+}
+
+
+void SimulationSystem::cache_bias_solution(SolverSpecify::SolverType solver_type, const std::vector<PetscScalar> & vapp,
+                                           const std::vector<PetscScalar> & iapp, const std::vector<PetscScalar> & x)
+{
+  std::deque<BiasSolution>::iterator it = _bias_solutions.begin();
+  for( ; it != _bias_solutions.end(); ++it )
+    if( it->solver_type == solver_type && same_bias(it->vapp, vapp) && same_bias(it->iapp, iapp) )
+    {
+      it->x = x;
+      return;
+    }
+
+  if( _bias_solutions.size() >= max_bias_solutions )
+    _bias_solutions.pop_front();
+
+  BiasSolution solution;
+  solution.solver_type = solver_type;
+  solution.vapp = vapp;
+  solution.iapp = iapp;
+  solution.x = x;
+  _bias_solutions.push_back(solution);
+}
+
+
+const std::vector<PetscScalar> * SimulationSystem::nearest_bias_solution(SolverSpecify::SolverType solver_type, unsigned int n_local,
+                                                                         const std::vector<PetscScalar> & vapp, const std::vector<PetscScalar> & iapp,
+                                                                         PetscScalar & distance) const
+{
+  const std::vector<PetscScalar> * nearest = NULL;
+
+  std::deque<BiasSolution>::const_iterator it = _bias_solutions.begin();
+  for( ; it != _bias_solutions.end(); ++it )
+  {
+    if( it->solver_type != solver_type || it->x.size() != n_local ) continue;
+    if( it->vapp.size() != vapp.size() || !same_bias(it->iapp, iapp) ) continue;
+
+    PetscScalar d = 0.0;
+    for(unsigned int i=0; i<vapp.size(); ++i)
+      d = std::max(d, std::abs(it->vapp[i]-vapp[i]));
+
+    if( nearest == NULL || d < distance )
+    {
+      nearest = &it->x;
+      distance = d;
+    }
+  }
+
+  return nearest;
 }
 
 
 
 void SimulationSystem::init_region()
 {
-  for(unsigned int r=0; r<_simulation_regions.size(); r++)
+  START_LOG("init_region()", "SimulationSystem");
+
+  // each region only touches its own nodes and material, so the regions are initialized concurrently
+  const int n_regions = static_cast<int>(_simulation_regions.size());
+#pragma omp parallel for schedule(dynamic) num_threads(Genius::n_threads())
+  for(int r=0; r<n_regions; r++)
     _simulation_regions[r]->init(_T_external);
+
+  STOP_LOG("init_region()", "SimulationSystem");
 }
 
 
@@ -275,6 +376,8 @@ bool SimulationSystem::has_complex_compound_semiconductor_region() const
 
 void SimulationSystem::build_simulation_system()
 {
+  START_LOG("build_simulation_system()", "SimulationSystem");
+
   unsigned int region_num = _mesh.n_subdomains();
 
   _simulation_regions.resize( region_num );
@@ -332,7 +435,19 @@ void SimulationSystem::build_simulation_system()
     subdomain_id_to_region_map[r] = _simulation_regions[r];
 
     //set partition weight for each region
-    _mesh.set_subdomain_weight(r, Material::material_weight(_mesh.subdomain_material(r)));
+    _mesh.set_subdomain_weight(r, Material::material_weight(_mesh.subdomain_material(r), _partition_solver));
+  }
+
+  // the mesh was partitioned with equal weight when it was prepared,
+  // partition it again with the cost of each region and boundary.
+  // after mesh refinement, repartition keeps most elements on their old processor
+  _mesh.set_boundary_weight(_partition_boundary_weight);
+  _mesh.set_interface_weight(_partition_interface_weight);
+  if( Genius::n_processors() > 1 )
+  {
+    START_LOG("repartition()", "SimulationSystem");
+    _mesh.repartition();
+    STOP_LOG("repartition()", "SimulationSystem");
   }
 
   // each region should hold subdomain_id_to_region_map
@@ -342,7 +457,9 @@ void SimulationSystem::build_simulation_system()
   build_region_fvm_mesh();
 
   // boundary condition
+  START_LOG("bc_setup()", "SimulationSystem");
   _bcs->bc_setup();
+  STOP_LOG("bc_setup()", "SimulationSystem");
 
   // electrical source should konw where is the (electrode) bc
   _sources->link_to_bcs( _bcs );
@@ -369,6 +486,7 @@ void SimulationSystem::build_simulation_system()
   if( Genius::processor_id() != 0 )
     _mesh.delete_remote_elements();
 
+  STOP_LOG("build_simulation_system()", "SimulationSystem");
 }
 
 
@@ -772,6 +890,9 @@ void SimulationSystem::build_region_fvm_mesh()
           region->add_hanging_node_on_edge(node, *it, e);
     }
 
+    // the parent nodes of hanging nodes are fixed from now on
+    region->build_hanging_node_constraints();
+
   }
   MESSAGE<<std::endl;  RECORD();
 
@@ -840,7 +961,8 @@ void SimulationSystem::estimate_error (const Parser::Card &c, ErrorVector & erro
   // if regions array is not empty, we only refine region in the regions array!
   if( !regions.empty() ) refine_flag = false;
 
-  // fill gradient of var for all the cells in each region
+  // fill gradient of var for all the cells in each region.
+  // each processor only estimates the cells it owns, and the cells are shared by threads
   for(unsigned int n=0; n<n_regions(); n++)
   {
     const SimulationRegion * region = this->region(n);
@@ -850,12 +972,22 @@ void SimulationSystem::estimate_error (const Parser::Card &c, ErrorVector & erro
     if( regions.find(region->name()) != regions.end())
       region_refine_flag = true;
 
+    std::vector<const Elem *> elems;
     SimulationRegion::const_element_iterator it = region->elements_begin();
     SimulationRegion::const_element_iterator it_end = region->elements_end();
     for(; it!=it_end; ++it)
     {
       // only process cell belongs to this processor
       if( (*it)->processor_id() != Genius::processor_id() ) continue;
+      elems.push_back(*it);
+    }
+
+    std::vector<ErrorVectorReal> elem_error(elems.size(), 0.0);
+    const int n_elems = elems.size();
+#pragma omp parallel for schedule(dynamic, 256) num_threads(Genius::n_threads())
+    for(int e=0; e<n_elems; ++e)
+    {
+      const Elem * elem = elems[e];
 
       bool element_refine_flag = true;
       std::vector<PetscScalar> var_vertex;
@@ -863,9 +995,9 @@ void SimulationSystem::estimate_error (const Parser::Card &c, ErrorVector & erro
       double exmin=1e100, exmax=-1e100;
       double eymin=1e100, eymax=-1e100;
       double ezmin=1e100, ezmax=-1e100;
-      for(unsigned int nd=0; nd<(*it)->n_nodes(); ++nd)
+      for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
       {
-        const FVM_Node * fvm_node = (*it)->get_fvm_node(nd);
+        const FVM_Node * fvm_node = elem->get_fvm_node(nd);
         const FVM_NodeData * fvm_node_data = fvm_node->node_data();
         const Node * node = fvm_node->root_node();
 
@@ -895,26 +1027,27 @@ void SimulationSystem::estimate_error (const Parser::Card &c, ErrorVector & erro
       {
         if (v_volume)
         {
-          cell_error_map[(*it)->id()] = static_cast<ErrorVectorReal>((*it)->volume()/std::pow(PhysicalUnit::um,3.0)); // use cell volume as error
+          elem_error[e] = static_cast<ErrorVectorReal>(elem->volume()/std::pow(PhysicalUnit::um,3.0)); // use cell volume as error
         }
         else
         {
           // compute the gradient
           if(gradient)
           {
-            VectorValue<PetscScalar> grad_var   = (*it)->gradient(var_vertex);
-            cell_error_map[(*it)->id()] = static_cast<ErrorVectorReal>(grad_var.size()*(*it)->hmax()); // use gradient*hmax as error
+            VectorValue<PetscScalar> grad_var   = elem->gradient(var_vertex);
+            elem_error[e] = static_cast<ErrorVectorReal>(grad_var.size()*elem->hmax()); // use gradient*hmax as error
           }
           // use cell average value as error
           else
           {
-            cell_error_map[(*it)->id()] = std::accumulate(var_vertex.begin(), var_vertex.end(), 0.0)/var_vertex.size();
+            elem_error[e] = std::accumulate(var_vertex.begin(), var_vertex.end(), 0.0)/var_vertex.size();
           }
         }
       }
-      else
-        cell_error_map[(*it)->id()] = 0.0;
     }
+
+    for(unsigned int e=0; e<elems.size(); ++e)
+      cell_error_map[elems[e]->id()] = elem_error[e];
   }
 
   // gather from all the processors
@@ -947,13 +1080,31 @@ void SimulationSystem::fill_interpolator(InterpolationBase *interpolator,
     const std::string & variable_string,
     InterpolationBase::InterpolationType type) const
 {
-  SolutionVariable variable = solution_string_to_enum(variable_string);
-  genius_assert(variable!=INVALID_Variable);
-  genius_assert(variable_data_type(variable)==SCALAR);
+  std::vector<std::pair<std::string, InterpolationBase::InterpolationType> > variables;
+  variables.push_back(std::make_pair(variable_string, type));
+  this->fill_interpolator(interpolator, variables);
+}
 
-  int group_code = interpolator->set_group_code(variable_string);
 
-  std::map<unsigned int, double> value_map;
+/**
+ * fill several variables into interpolator. the nodes are visited once,
+ * and the interpolator builds all the groups together
+ */
+void SimulationSystem::fill_interpolator(InterpolationBase *interpolator,
+    const std::vector<std::pair<std::string, InterpolationBase::InterpolationType> > & variable_strings) const
+{
+  std::vector<SolutionVariable> variables;
+  std::vector<int> group_codes;
+  for(unsigned int v=0; v<variable_strings.size(); ++v)
+  {
+    SolutionVariable variable = solution_string_to_enum(variable_strings[v].first);
+    genius_assert(variable!=INVALID_Variable);
+    genius_assert(variable_data_type(variable)==SCALAR);
+    variables.push_back(variable);
+    group_codes.push_back(interpolator->set_group_code(variable_strings[v].first));
+  }
+
+  std::vector< std::map<unsigned int, double> > value_maps(variables.size());
   for( unsigned int r=0; r<this->n_regions(); r++)
   {
     const SimulationRegion * region = this->region(r);
@@ -974,20 +1125,26 @@ void SimulationSystem::fill_interpolator(InterpolationBase *interpolator,
         const FVM_Node * primary_fvm_node = (*bc->region_node_begin(fvm_node->root_node())).second.second;
         node_data = primary_fvm_node->node_data();
       }
-      if(node_data->is_variable_valid(variable))
-        value_map [fvm_node->root_node()->id()] = node_data->get_variable_real(variable);
+      for(unsigned int v=0; v<variables.size(); ++v)
+        if(node_data->is_variable_valid(variables[v]))
+          value_maps[v][fvm_node->root_node()->id()] = node_data->get_variable_real(variables[v]);
     }
   }
-  Parallel::allgather(value_map);
 
-  interpolator->set_interpolation_type(group_code, type);
+  for(unsigned int v=0; v<variables.size(); ++v)
+  {
+    Parallel::allgather(value_maps[v]);
+
+    interpolator->set_interpolation_type(group_codes[v], variable_strings[v].second);
 
-  // fill the interpolator
-  std::map<unsigned int, double>::const_iterator it = value_map.begin();
-  for(; it != value_map.end(); ++it)
-    interpolator->add_scatter_data(_mesh.point(it->first), group_code, it->second);
+    // fill the interpolator
+    std::map<unsigned int, double>::const_iterator it = value_maps[v].begin();
+    for(; it != value_maps[v].end(); ++it)
+      interpolator->add_scatter_data(_mesh.point(it->first), group_codes[v], it->second);
+    value_maps[v].clear();
+  }
 
-  interpolator->setup(group_code);
+  interpolator->setup(group_codes);
 }
 
 
@@ -996,13 +1153,28 @@ void SimulationSystem::fill_interpolator(InterpolationBase *interpolator,
  */
 void SimulationSystem::do_interpolation(const InterpolationBase * interpolator , const std::string & variable_string)
 {
-  SolutionVariable variable = solution_string_to_enum(variable_string);
-  genius_assert(variable!=INVALID_Variable);
-  genius_assert(variable_data_type(variable)==SCALAR);
+  this->do_interpolation(interpolator, std::vector<std::string>(1, variable_string));
+}
+
 
-  int group_code = interpolator->group_code(variable_string);
+/**
+ * get data of several variables from interpolator after mesh refinement.
+ * each processor only evaluates its local nodes, by threads when the interpolator allows
+ */
+void SimulationSystem::do_interpolation(const InterpolationBase * interpolator , const std::vector<std::string> & variable_strings)
+{
+  std::vector<SolutionVariable> variables;
+  std::vector<int> group_codes;
+  for(unsigned int v=0; v<variable_strings.size(); ++v)
+  {
+    SolutionVariable variable = solution_string_to_enum(variable_strings[v]);
+    genius_assert(variable!=INVALID_Variable);
+    genius_assert(variable_data_type(variable)==SCALAR);
+    variables.push_back(variable);
+    group_codes.push_back(interpolator->group_code(variable_strings[v]));
+  }
 
-  // fill gradient of var for all the cells in each region
+  std::vector<FVM_Node *> fvm_nodes;
   for(unsigned int n=0; n<n_regions(); n++)
   {
     SimulationRegion * region = this->region(n);
@@ -1010,20 +1182,60 @@ void SimulationSystem::do_interpolation(const InterpolationBase * interpolator ,
     SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
     SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
     for(; node_it!=node_it_end; ++node_it)
-    {
-      FVM_Node * fvm_node = (*node_it);
+      fvm_nodes.push_back(*node_it);
+  }
 
-      FVM_NodeData * node_data = fvm_node->node_data();
-      if(node_data->is_variable_valid(variable))
+  const bool threaded = interpolator->thread_safe();
+  const int n_nodes = fvm_nodes.size();
+#pragma omp parallel for schedule(dynamic, 64) num_threads(Genius::n_threads()) if(threaded)
+  for(int n=0; n<n_nodes; ++n)
+  {
+    FVM_Node * fvm_node = fvm_nodes[n];
+    FVM_NodeData * node_data = fvm_node->node_data();
+
+    // only the variables valid at this node
+    std::vector<unsigned int> valid;
+    std::vector<int> groups;
+    for(unsigned int v=0; v<variables.size(); ++v)
+      if(node_data->is_variable_valid(variables[v]))
       {
-        double value = interpolator->get_interpolated_value(*(fvm_node->root_node()), group_code);
-        node_data->set_variable_real(variable, value);
+        valid.push_back(v);
+        groups.push_back(group_codes[v]);
       }
-    }
+    if(groups.empty()) continue;
+
+    std::vector<double> values;
+    interpolator->get_interpolated_values(*(fvm_node->root_node()), groups, values);
+    for(unsigned int i=0; i<valid.size(); ++i)
+      node_data->set_variable_real(variables[valid[i]], values[i]);
   }
 }
 
 
+void SimulationSystem::memory_usage (MemoryLog & log) const
+{
+  // mesh nodes and elements, element objects are estimated by their pointer arrays and FVM geometry
+  size_t mesh_bytes = _mesh.n_nodes()*(sizeof(Node) + sizeof(Node *));
+  MeshBase::const_element_iterator       el  = _mesh.elements_begin();
+  const MeshBase::const_element_iterator end = _mesh.elements_end();
+  for (; el != end; ++el)
+  {
+    const Elem * elem = *el;
+    mesh_bytes += sizeof(Elem) + sizeof(Elem *);
+    mesh_bytes += elem->n_nodes()*(sizeof(Node *) + sizeof(FVM_Node *)) + elem->n_neighbors()*sizeof(Elem *);
+    mesh_bytes += elem->n_fvm_geometry()*sizeof(Real);
+  }
+  log.add("mesh", mesh_bytes);
+
+  // boundary info keeps a map node for each boundary node and boundary side
+  const size_t map_node = 4*sizeof(void *) + sizeof(void *) + sizeof(short int);
+  log.add("boundary info", (_mesh.boundary_info->n_boundary_conds() + _mesh.boundary_info->n_boundary_nodes())*map_node);
+
+  for(unsigned int n=0; n<_simulation_regions.size(); n++)
+    _simulation_regions[n]->memory_usage(log);
+}
+
+
 void SimulationSystem::print_info (std::ostream& os) const
 {
   os << "Simulation System Information on processor " << Genius::processor_id() << " :" << '\n'
@@ -1074,11 +1286,25 @@ void SimulationSystem::sync_print_info () const
 
 
 
-void SimulationSystem::export_vtk(const std::string& filename, bool ascii) const
+void SimulationSystem::export_vtk(const std::string& filename, bool ascii, bool background, bool compress,
+                                  const std::string & fields) const
 {
+  START_LOG("export_vtk()", "SimulationSystem");
+
+  // parallel vtk file, each processor writes the part of mesh it owns
+  if (filename.rfind(".pvtu") < filename.size())
+  {
+    MESSAGE<<"Write System to parallel XML VTK file "<< filename << "...\n" << std::endl; RECORD();
+    VTKIO vtk_io(*this);
+    vtk_io.set_compress(compress);
+    vtk_io.set_fields(fields);
+    vtk_io.write (filename);
+    STOP_LOG("export_vtk()", "SimulationSystem");
+    return;
+  }
+
   if(!ascii)
   {
-#ifdef HAVE_VTK
     std::string file_name = filename;
     // preprocess vtk file extension to make sure it has a ".vtu" format
     if (file_name.rfind(".vtu") > file_name.size())
@@ -1099,10 +1325,12 @@ void SimulationSystem::export_vtk(const std::string& filename, bool ascii) const
     }
 
     MESSAGE<<"Write System to XML VTK file "<< file_name << "...\n" << std::endl; RECORD();
-    VTKIO(*this).write (file_name);
-#else
-    MESSAGE<<"Genius is not compiled with XML VTK support, skip VTK export... "<< std::endl; RECORD();
-#endif
+    // without VTK library, VTKIO uses its own binary writer
+    VTKIO vtk_io(*this);
+    vtk_io.set_background_write(background);
+    vtk_io.set_compress(compress);
+    vtk_io.set_fields(fields);
+    vtk_io.write (file_name);
 
   }
   else
@@ -1126,9 +1354,12 @@ void SimulationSystem::export_vtk(const std::string& filename, bool ascii) const
     }
 
     MESSAGE<<"Write System to Legacy VTK file "<< file_name << "...\n" << std::endl; RECORD();
-    VTKIO(*this).write (file_name);
+    VTKIO vtk_io(*this);
+    vtk_io.set_fields(fields);
+    vtk_io.write (file_name);
   }
 
+  STOP_LOG("export_vtk()", "SimulationSystem");
 
 }
 
@@ -1144,11 +1375,49 @@ void SimulationSystem::export_node_location(const std::string& filename, const P
 }
 
 
+void SimulationSystem::write_checkpoint(std::ostream & out) const
+{
+  unsigned int n_region = this->n_regions();
+  out.write(reinterpret_cast<const char *>(&n_region), sizeof(n_region));
+  for(unsigned int n=0; n<n_region; n++)
+    this->region(n)->write_checkpoint(out);
+
+  for(unsigned int b=0; b<get_bcs()->n_bcs(); b++)
+  {
+    const BoundaryCondition * bc = get_bcs()->get_bc(b);
+    if( bc->is_electrode() )
+      bc->ext_circuit()->write_state(out);
+  }
+}
+
+
+bool SimulationSystem::read_checkpoint(std::istream & in)
+{
+  unsigned int n_region;
+  in.read(reinterpret_cast<char *>(&n_region), sizeof(n_region));
+  if( !in.good() || n_region != this->n_regions() ) return false;
+
+  for(unsigned int n=0; n<n_region; n++)
+    if( !this->region(n)->read_checkpoint(in) ) return false;
+
+  for(unsigned int b=0; b<get_bcs()->n_bcs(); b++)
+  {
+    BoundaryCondition * bc = get_bcs()->get_bc(b);
+    if( bc->is_electrode() )
+      bc->ext_circuit()->read_state(in);
+  }
+
+  return in.good();
+}
+
+
 void SimulationSystem::export_cgns(const std::string& filename) const
 {
   MESSAGE<<"Write System to CGNS file "<< filename << "...\n" << std::endl; RECORD();
 
+  START_LOG("export_cgns()", "SimulationSystem");
   CGNSIO(*this).write (filename);
+  STOP_LOG("export_cgns()", "SimulationSystem");
 }
 
 
@@ -1187,12 +1456,14 @@ void SimulationSystem::export_gdml_body(const std::string& filename) const
   GDMLIO(*this, false).write (filename);
 }
 
-void SimulationSystem::import_cgns(const std::string& filename)
+void SimulationSystem::import_cgns(const std::string& filename, const std::vector<std::string> & fields)
 {
 
   MESSAGE<<"Import System from CGNS file "<< filename << "...\n" << std::endl; RECORD();
 
-  CGNSIO(*this).read (filename);
+  CGNSIO cgns_io(*this);
+  cgns_io.set_fields(fields);
+  cgns_io.read (filename);
 }
 
 void SimulationSystem::import_vtk(const std::string& filename)
@@ -0,0 +1,214 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <cmath>
+
+#include "mesh.h"
+#include "elem.h"
+#include "fe_type.h"
+#include "fe_interface.h"
+#include "point_locator_base.h"
+#include "simulation_system.h"
+#include "simulation_region.h"
+#include "solution_transfer.h"
+#include "parallel.h"
+#include "genius_env.h"
+#include "perf_log.h"
+
+
+
+SolutionTransfer::SolutionTransfer(const SimulationSystem & source)
+{
+  START_LOG("SolutionTransfer()", "SolutionTransfer");
+
+  _variables.push_back(std::make_pair(POTENTIAL,   false));
+  _variables.push_back(std::make_pair(ELECTRON,    true));
+  _variables.push_back(std::make_pair(HOLE,        true));
+  _variables.push_back(std::make_pair(TEMPERATURE, false));
+
+  // copy the active elements of the source mesh, the node ids are kept.
+  // the mesh is serial, so every processor holds the same copy
+  const MeshBase & mesh = source.mesh();
+  _mesh = AutoPtr<MeshBase>(new Mesh(mesh.mesh_dimension()));
+  {
+    MeshBase::const_node_iterator node_it = mesh.nodes_begin();
+    MeshBase::const_node_iterator node_it_end = mesh.nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+      _mesh->add_point(**node_it, (*node_it)->id());
+
+    MeshBase::const_element_iterator elem_it = mesh.active_elements_begin();
+    MeshBase::const_element_iterator elem_it_end = mesh.active_elements_end();
+    for(; elem_it!=elem_it_end; ++elem_it)
+    {
+      const Elem * old_elem = *elem_it;
+      Elem * elem = Elem::build(old_elem->type()).release();
+      for(unsigned int n=0; n<old_elem->n_nodes(); ++n)
+        elem->set_node(n) = _mesh->node_ptr(old_elem->node(n));
+      elem->subdomain_id() = old_elem->subdomain_id();
+      _mesh->add_elem(elem);
+    }
+    // no renumber, the node ids index the saved solution
+    _mesh->prepare_for_use(true);
+  }
+
+  // the solution of each region, gathered from all the processors
+  _region_names.resize(source.n_regions());
+  _values.resize(source.n_regions());
+  for(unsigned int r=0; r<source.n_regions(); r++)
+  {
+    const SimulationRegion * region = source.region(r);
+    genius_assert(region->subdomain_id() == r);
+    _region_names[r] = region->name();
+    _values[r].resize(_variables.size());
+
+    SimulationRegion::const_processor_node_iterator on_processor_nodes_it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator on_processor_nodes_it_end = region->on_processor_nodes_end();
+    for(; on_processor_nodes_it!=on_processor_nodes_it_end; ++on_processor_nodes_it)
+    {
+      const FVM_Node * fvm_node = *on_processor_nodes_it;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+      for(unsigned int v=0; v<_variables.size(); ++v)
+        if(node_data->is_variable_valid(_variables[v].first))
+          _values[r][v][fvm_node->root_node()->id()] = node_data->get_variable_real(_variables[v].first);
+    }
+
+    for(unsigned int v=0; v<_variables.size(); ++v)
+      Parallel::allgather(_values[r][v]);
+  }
+
+  STOP_LOG("SolutionTransfer()", "SolutionTransfer");
+}
+
+
+
+SolutionTransfer::~SolutionTransfer()
+{}
+
+
+
+unsigned int SolutionTransfer::apply(SimulationSystem & target) const
+{
+  START_LOG("apply()", "SolutionTransfer");
+
+  // all the local nodes of target system, and the source region each one takes value from
+  std::vector<FVM_Node *> fvm_nodes;
+  std::vector<unsigned int> source_regions;
+  for(unsigned int r=0; r<target.n_regions(); r++)
+  {
+    SimulationRegion * region = target.region(r);
+
+    unsigned int source_region = invalid_uint;
+    for(unsigned int s=0; s<_region_names.size(); s++)
+      if( _region_names[s] == region->name() ) source_region = s;
+    if( source_region == invalid_uint ) continue;
+
+    SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
+    SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+    {
+      fvm_nodes.push_back(*node_it);
+      source_regions.push_back(source_region);
+    }
+  }
+
+  // locate the nodes in source mesh all together
+  std::vector<Point> points(fvm_nodes.size());
+  for(unsigned int n=0; n<fvm_nodes.size(); ++n)
+    points[n] = *(fvm_nodes[n]->root_node());
+  std::vector<const Elem *> elems;
+  _mesh->point_locator().locate_batch(points, elems);
+
+  const unsigned int dim = _mesh->mesh_dimension();
+  const FEType fe_type(FIRST, LAGRANGE);
+
+  unsigned int n_missing = 0;
+  const int n_nodes = fvm_nodes.size();
+#pragma omp parallel for schedule(dynamic, 64) num_threads(Genius::n_threads()) reduction(+:n_missing)
+  for(int n=0; n<n_nodes; ++n)
+  {
+    const Elem * elem = elems[n];
+    if( elem == NULL )
+    {
+      if( fvm_nodes[n]->on_processor() ) n_missing++;
+      continue;
+    }
+
+    FVM_NodeData * node_data = fvm_nodes[n]->node_data();
+    const std::vector< std::map<unsigned int, Real> > & region_values = _values[source_regions[n]];
+
+    // linear shape function of the vertex. when the element belongs to a neighbor region,
+    // only the vertex on the interface has the value of this region
+    const Point p = FEInterface::inverse_map(dim, fe_type, elem, points[n]);
+    std::vector<Real> weights(elem->n_vertices());
+    for(unsigned int i=0; i<elem->n_vertices(); ++i)
+      weights[i] = FEInterface::shape(dim, fe_type, elem->type(), i, p);
+
+    for(unsigned int v=0; v<_variables.size(); ++v)
+    {
+      const SolutionVariable variable = _variables[v].first;
+      if( !node_data->is_variable_valid(variable) ) continue;
+
+      const std::map<unsigned int, Real> & values = region_values[v];
+      std::vector<Real> vertex_values;
+      std::vector<Real> vertex_weights;
+      bool positive = true;
+      unsigned int nearest = invalid_uint;
+      Real nearest_distance = 0.0;
+      for(unsigned int i=0; i<elem->n_vertices(); ++i)
+      {
+        std::map<unsigned int, Real>::const_iterator it = values.find(elem->node(i));
+        if( it == values.end() ) continue;
+        vertex_values.push_back(it->second);
+        vertex_weights.push_back(weights[i]);
+        if( it->second <= 0.0 ) positive = false;
+
+        const Real distance = (elem->point(i) - points[n]).size();
+        if( nearest == invalid_uint || distance < nearest_distance )
+        {
+          nearest = vertex_values.size()-1;
+          nearest_distance = distance;
+        }
+      }
+      if( vertex_values.empty() ) continue;
+
+      const bool log_space = _variables[v].second && positive;
+      Real sum = 0.0, weight_sum = 0.0;
+      for(unsigned int i=0; i<vertex_values.size(); ++i)
+      {
+        sum += vertex_weights[i]*(log_space ? std::log(vertex_values[i]) : vertex_values[i]);
+        weight_sum += vertex_weights[i];
+      }
+
+      Real value;
+      if( weight_sum > 1e-6 )
+        value = sum/weight_sum;
+      else
+        value = log_space ? std::log(vertex_values[nearest]) : vertex_values[nearest];
+      node_data->set_variable_real(variable, log_space ? std::exp(value) : value);
+    }
+  }
+
+  Parallel::sum(n_missing);
+
+  STOP_LOG("apply()", "SolutionTransfer");
+
+  return n_missing;
+}
@@ -47,16 +47,11 @@ using PhysicalUnit::eV;
 void TIFIO::read (const std::string& filename)
 {
   /*
-   * first, we call yyparse to read tif file
+   * first, we call TIF::parse to read tif file
    */
   if( Genius::processor_id() == 0)
   {
-    TIF::yyin = fopen(filename.c_str(), "r");
-    genius_assert( TIF::yyin != NULL );
-
-    genius_assert( !TIF::yyparse() );
-
-    fclose(TIF::yyin);
+    genius_assert( !TIF::parse(filename) );
   }
 
   /*
@@ -23,6 +23,7 @@
 // C++ includes
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 // Local includes
 #include "vtk_io.h"
@@ -38,8 +39,14 @@
 #include "field_source.h"
 #include "ngspice_interface.h"
 #include "spice_ckt.h"
+#include "async_file_writer.h"
 #include "material.h"
 #include "solver_specify.h"
+#include "output_field.h"
+
+#ifdef HAVE_ZLIB
+  #include <zlib.h>
+#endif
 
 #ifdef HAVE_VTK
 
@@ -93,6 +100,153 @@ private:
 };
 #endif
 
+namespace
+{
+  /**
+   * @return the VTK cell type of the element type
+   */
+  unsigned int vtk_cell_type(const ElemType type)
+  {
+    unsigned int celltype = 0;
+    switch(type)
+    {
+        case EDGE2:
+        case EDGE2_FVM:
+        celltype = 3;  //VTK_LINE;
+        break;
+        case EDGE3:
+        celltype = 21; //VTK_QUADRATIC_EDGE;
+        break;// 1
+        case TRI3:
+        case TRI3_FVM:
+        celltype = 5;  //VTK_TRIANGLE;
+        break;// 3
+        case TRI6:
+        celltype = 22; //VTK_QUADRATIC_TRIANGLE;
+        break;// 4
+        case QUAD4:
+        case QUAD4_FVM:
+        celltype = 9;  //VTK_QUAD;
+        break;// 5
+        case QUAD8:
+        celltype = 23; //VTK_QUADRATIC_QUAD;
+        break;// 6
+        case TET4:
+        case TET4_FVM:
+        celltype = 10; //VTK_TETRA;
+        break;// 8
+        case TET10:
+        celltype = 24; //VTK_QUADRATIC_TETRA;
+        break;// 9
+        case HEX8:
+        case HEX8_FVM:
+        celltype = 12; //VTK_HEXAHEDRON;
+        break;// 10
+        case HEX20:
+        celltype = 25; //VTK_QUADRATIC_HEXAHEDRON;
+        break;// 12
+        case PRISM6:
+        case PRISM6_FVM:
+        celltype = 13; //VTK_WEDGE;
+        break;// 13
+        case PYRAMID5:
+        case PYRAMID5_FVM:
+        celltype = 14; //VTK_PYRAMID;
+        break;// 16
+        default:
+        {
+          std::cerr<<"element type "<<type<<" not implemented"<<std::endl;
+          genius_error();
+        }
+    }
+    return celltype;
+  }
+
+
+  /**
+   * @return the byte order attribute of VTK XML file for this machine
+   */
+  const char * vtk_byte_order()
+  {
+    const unsigned short int one = 1;
+    return *reinterpret_cast<const unsigned char *>(&one) ? "LittleEndian" : "BigEndian";
+  }
+
+
+  /**
+   * the data arrays of a .vtu file in the appended raw format.
+   * each array is a block of UInt32 byte count followed by the array bytes, or
+   * when compressed, the vtkZLibDataCompressor block header followed by the zlib streams
+   */
+  class AppendedData
+  {
+  public:
+    AppendedData(bool compress) : _compress(compress) {}
+
+    /**
+     * append \p data, @return its offset inside the appended data section
+     */
+    template <typename T>
+    unsigned int add(const std::vector<T> & data)
+    {
+      const unsigned int offset = _data.size();
+      const char * bytes = data.empty() ? 0 : reinterpret_cast<const char *>(&data[0]);
+      const unsigned int n_bytes = data.size()*sizeof(T);
+
+#ifdef HAVE_ZLIB
+      if(_compress)
+      {
+        const unsigned int block_size = 1<<20;
+        const unsigned int n_blocks = (n_bytes + block_size - 1)/block_size;
+
+        std::vector<unsigned int> header(3+n_blocks);
+        header[0] = n_blocks;
+        header[1] = block_size;
+        header[2] = n_bytes % block_size;
+
+        std::string compressed;
+        std::vector<Bytef> buffer(compressBound(block_size));
+        for(unsigned int b=0; b<n_blocks; ++b)
+        {
+          const unsigned int size = std::min(block_size, n_bytes - b*block_size);
+          uLongf compressed_size = buffer.size();
+          compress2(&buffer[0], &compressed_size, reinterpret_cast<const Bytef *>(bytes + b*block_size), size, Z_DEFAULT_COMPRESSION);
+          header[3+b] = compressed_size;
+          compressed.append(reinterpret_cast<const char *>(&buffer[0]), compressed_size);
+        }
+
+        _data.append(reinterpret_cast<const char *>(&header[0]), header.size()*sizeof(unsigned int));
+        _data.append(compressed);
+        return offset;
+      }
+#endif
+
+      _data.append(reinterpret_cast<const char *>(&n_bytes), sizeof(unsigned int));
+      if(n_bytes) _data.append(bytes, n_bytes);
+      return offset;
+    }
+
+    /**
+     * @return the content of appended data section
+     */
+    const std::string & data() const
+    { return _data; }
+
+    bool compressed() const
+    {
+#ifdef HAVE_ZLIB
+      return _compress;
+#else
+      return false;
+#endif
+    }
+
+  private:
+    bool _compress;
+    std::string _data;
+  };
+}
+
 // private functions
 #ifdef HAVE_VTK
 
@@ -896,6 +1050,9 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, vtkUnstructuredGrid* grid)
 void VTKIO::write_node_scaler_solution(const std::vector<unsigned int> & order, std::vector<float> &sol,
                                        const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
+  // the field is not asked by the user
+  if( !_export_field(sol_name) ) return;
+
   // this should run on parallel for all the processor
   Parallel::gather(0, sol);
 
@@ -931,6 +1088,9 @@ void VTKIO::write_node_scaler_solution(const std::vector<unsigned int> & order,
 void VTKIO::write_node_complex_solution(const std::vector<unsigned int> & order, std::vector<std::complex<float> > & sol,
                                         const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
+  // the field is not asked by the user
+  if( !_export_field(sol_name) ) return;
+
   // this should run on parallel for all the processor
   Parallel::gather(0, sol);
 
@@ -983,6 +1143,9 @@ void VTKIO::write_node_vector_solution(const std::vector<unsigned int> & order,
                                        std::vector<float > & sol_z,
                                        const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
+  // the field is not asked by the user
+  if( !_export_field(sol_name) ) return;
+
   // this should run on parallel for all the processor
   Parallel::gather(0, sol_x);
   Parallel::gather(0, sol_y);
@@ -1028,6 +1191,9 @@ void VTKIO::write_node_vector_solution(const std::vector<unsigned int> & order,
 void VTKIO::write_cell_scaler_solution(const std::vector<unsigned int> & order, std::vector<float> &sol,
                                        const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
+  // the field is not asked by the user
+  if( !_export_field(sol_name) ) return;
+
   // this should run on parallel for all the processor
   Parallel::gather(0, sol);
 
@@ -1065,6 +1231,9 @@ void VTKIO::write_cell_vector_solution(const std::vector<unsigned int> & order,
                                        std::vector<float > & sol_z,
                                        const std::string & sol_name, vtkUnstructuredGrid* grid)
 {
+  // the field is not asked by the user
+  if( !_export_field(sol_name) ) return;
+
   // this should run on parallel for all the processor
   Parallel::gather(0, sol_x);
   Parallel::gather(0, sol_y);
@@ -1189,60 +1358,7 @@ void VTKIO::cells_to_vtk(const MeshBase& mesh,  std::ofstream & out)
     std::map<unsigned int, unsigned int>::const_iterator it = elem_type.begin();
     for (; it != elem_type.end(); ++it)
     {
-      unsigned int celltype;
-      const ElemType type    = static_cast<ElemType>(it->second);
-      switch(type)
-      {
-          case EDGE2:
-          case EDGE2_FVM:
-          celltype = 3;  //VTK_LINE;
-          break;
-          case EDGE3:
-          celltype = 21; //VTK_QUADRATIC_EDGE;
-          break;// 1
-          case TRI3:
-          case TRI3_FVM:
-          celltype = 5;  //VTK_TRIANGLE;
-          break;// 3
-          case TRI6:
-          celltype = 22; //VTK_QUADRATIC_TRIANGLE;
-          break;// 4
-          case QUAD4:
-          case QUAD4_FVM:
-          celltype = 9;  //VTK_QUAD;
-          break;// 5
-          case QUAD8:
-          celltype = 23; //VTK_QUADRATIC_QUAD;
-          break;// 6
-          case TET4:
-          case TET4_FVM:
-          celltype = 10; //VTK_TETRA;
-          break;// 8
-          case TET10:
-          celltype = 24; //VTK_QUADRATIC_TETRA;
-          break;// 9
-          case HEX8:
-          case HEX8_FVM:
-          celltype = 12; //VTK_HEXAHEDRON;
-          break;// 10
-          case HEX20:
-          celltype = 25; //VTK_QUADRATIC_HEXAHEDRON;
-          break;// 12
-          case PRISM6:
-          case PRISM6_FVM:
-          celltype = 13; //VTK_WEDGE;
-          break;// 13
-          case PYRAMID5:
-          case PYRAMID5_FVM:
-          celltype = 14; //VTK_PYRAMID;
-          break;// 16
-          default:
-          {
-            std::cerr<<"element type "<<type<<" not implemented"<<std::endl;
-            genius_error();
-          }
-      }
-
+      const unsigned int celltype = vtk_cell_type(static_cast<ElemType>(it->second));
       out << celltype << std::endl;
     }
 
@@ -1619,6 +1735,9 @@ void VTKIO::solution_to_vtk(const MeshBase& mesh, std::ofstream & out)
 void VTKIO::write_node_scaler_solution(const std::vector<unsigned int> & order, std::vector<float> & sol,
                                        const std::string & sol_name, std::ofstream & out)
 {
+  // the field is not asked by the user
+  if( !_export_field(sol_name) ) return;
+
   // this should run on parallel for all the processor
   Parallel::gather(0, sol);
 
@@ -1643,6 +1762,9 @@ void VTKIO::write_node_scaler_solution(const std::vector<unsigned int> & order,
 void VTKIO::write_node_complex_solution(const std::vector<unsigned int> & order, std::vector<std::complex<float> > & sol,
                                         const std::string & sol_name, std::ofstream & out)
 {
+  // the field is not asked by the user
+  if( !_export_field(sol_name) ) return;
+
   // this should run on parallel for all the processor
   Parallel::gather(0, sol);
 
@@ -1683,6 +1805,9 @@ void VTKIO::write_node_vector_solution(const std::vector<unsigned int> & order,
                                        std::vector<float > & sol_z,
                                        const std::string & sol_name, std::ofstream & out)
 {
+  // the field is not asked by the user
+  if( !_export_field(sol_name) ) return;
+
   // this should run on parallel for all the processor
   Parallel::gather(0, sol_x);
   Parallel::gather(0, sol_y);
@@ -1714,6 +1839,9 @@ void VTKIO::write_node_vector_solution(const std::vector<unsigned int> & order,
 void VTKIO::write_cell_scaler_solution(const std::vector<unsigned int> & order, std::vector<float> & sol,
                                        const std::string & sol_name, std::ofstream & out)
 {
+  // the field is not asked by the user
+  if( !_export_field(sol_name) ) return;
+
   // this should run on parallel for all the processor
   Parallel::gather(0, sol);
 
@@ -1738,6 +1866,9 @@ void VTKIO::write_cell_vector_solution(const std::vector<unsigned int> & order,
                                        std::vector<float > & sol_z,
                                        const std::string & sol_name, std::ofstream & out)
 {
+  // the field is not asked by the user
+  if( !_export_field(sol_name) ) return;
+
   // this should run on parallel for all the processor
   Parallel::gather(0, sol_x);
   Parallel::gather(0, sol_y);
@@ -1788,6 +1919,243 @@ void VTKIO::_smooth_numerical_error(std::map<unsigned int, float> &dataset, floa
 }
 
 
+std::string VTKIO::piece_file_name(const std::string & pvtu_name, unsigned int proc)
+{
+  std::stringstream ss;
+  ss << pvtu_name.substr(0, pvtu_name.rfind(".pvtu")) << "_" << proc << ".vtu";
+  return ss.str();
+}
+
+
+void VTKIO::set_fields(const std::string & field_list)
+{
+  _fields.clear();
+  const std::vector<std::string> names = OutputField::split(field_list);
+  for(unsigned int i=0; i<names.size(); ++i)
+    _fields.insert(OutputField::key(names[i]));
+}
+
+
+bool VTKIO::_export_field(const std::string & sol_name) const
+{
+  return _fields.empty() || _fields.find(OutputField::key(sol_name)) != _fields.end();
+}
+
+
+void VTKIO::write_piece(const std::string & name, std::vector<std::string> & sol_name)
+{
+  const SimulationSystem & system = FieldOutput<SimulationSystem>::system();
+  const MeshBase& mesh = system.mesh();
+
+  // the elements of this processor and the nodes they use, with a local numbering
+  std::vector<const Elem *> elems;
+  std::map<const Node *, unsigned int> node_index;
+  std::vector<const Node *> nodes;
+  {
+    MeshBase::const_element_iterator       elem_it  = mesh.active_this_pid_elements_begin();
+    const MeshBase::const_element_iterator elem_it_end = mesh.active_this_pid_elements_end();
+    for (; elem_it != elem_it_end; ++elem_it)
+    {
+      const Elem * elem = *elem_it;
+      elems.push_back(elem);
+      for(unsigned int i=0; i<elem->n_nodes(); ++i)
+        if( node_index.insert( std::make_pair(elem->get_node(i), nodes.size()) ).second )
+          nodes.push_back(elem->get_node(i));
+    }
+  }
+
+  // node based data. the nodes on the interface of two material regions use the
+  // node data of semiconductor region, it just for visualization reason.
+  // the fields are evaluated by the regions on demand, and shared with the other exports of this solution
+  std::vector<unsigned int> fields;
+  for(unsigned int f=0; f<OutputField::N_FIELDS; ++f)
+  {
+    // mole fraction is written only when asked
+    if( _fields.empty() && (f == OutputField::MOLE_X || f == OutputField::MOLE_Y) ) continue;
+    if( _export_field(OutputField::name(f)) ) fields.push_back(f);
+  }
+
+  sol_name.clear();
+  for(unsigned int i=0; i<fields.size(); ++i)
+    sol_name.push_back(OutputField::name(fields[i]));
+  std::vector< std::vector<float> > sol(sol_name.size(), std::vector<float>(nodes.size(), 0.0));
+  std::vector<bool> from_semiconductor(nodes.size(), false);
+
+  for( unsigned int r=0; r<system.n_regions(); r++)
+  {
+    const SimulationRegion * region = system.region(r);
+    const bool semiconductor = Material::IsSemiconductor(region->material());
+
+    // the index in the node list of this piece
+    std::vector<unsigned int> piece_node;
+    {
+      SimulationRegion::const_local_node_iterator node_it = region->on_local_nodes_begin();
+      SimulationRegion::const_local_node_iterator node_it_end = region->on_local_nodes_end();
+      for(; node_it!=node_it_end; ++node_it)
+      {
+        const FVM_Node * fvm_node = *node_it;
+        std::map<const Node *, unsigned int>::const_iterator it = node_index.find(fvm_node->root_node());
+        if( it == node_index.end() || from_semiconductor[it->second] )
+        {
+          piece_node.push_back(invalid_uint);
+          continue;
+        }
+        piece_node.push_back(it->second);
+        from_semiconductor[it->second] = semiconductor;
+      }
+    }
+
+    for(unsigned int i=0; i<fields.size(); ++i)
+    {
+      if( OutputField::semiconductor_only(fields[i]) && !semiconductor ) continue;
+
+      const std::vector<float> & values = region->output_field(fields[i], system.solution_version());
+      for(unsigned int k=0; k<piece_node.size(); ++k)
+        if( piece_node[k] != invalid_uint )
+          sol[i][piece_node[k]] = values[k];
+    }
+  }
+
+  // all the arrays go to the appended data section, each array is released after it is encoded
+  AppendedData appended(_compress);
+
+  std::vector<unsigned int> sol_offset;
+  for(unsigned int i=0; i<sol_name.size(); ++i)
+  {
+    sol_offset.push_back(appended.add(sol[i]));
+    std::vector<float>().swap(sol[i]);
+  }
+
+  unsigned int region_offset, partition_offset;
+  {
+    std::vector<int> region, partition;
+    for(unsigned int e=0; e<elems.size(); ++e)
+    {
+      region.push_back(elems[e]->subdomain_id());
+      partition.push_back(elems[e]->processor_id());
+    }
+    region_offset = appended.add(region);
+    partition_offset = appended.add(partition);
+  }
+
+  unsigned int points_offset;
+  {
+    std::vector<float> pts;
+    pts.reserve(3*nodes.size());
+    for(unsigned int n=0; n<nodes.size(); ++n)
+      for(unsigned int d=0; d<3; ++d)
+        pts.push_back(static_cast<float>((*nodes[n])(d)/um));
+    points_offset = appended.add(pts);
+  }
+
+  unsigned int conn_offset, offsets_offset, types_offset;
+  {
+    std::vector<int> conn, offsets;
+    std::vector<unsigned char> types;
+    for(unsigned int e=0; e<elems.size(); ++e)
+    {
+      for(unsigned int i=0; i<elems[e]->n_nodes(); ++i)
+        conn.push_back(node_index[elems[e]->get_node(i)]);
+      offsets.push_back(conn.size());
+      types.push_back(vtk_cell_type(elems[e]->type()));
+    }
+    conn_offset = appended.add(conn);
+    offsets_offset = appended.add(offsets);
+    types_offset = appended.add(types);
+  }
+
+  std::ofstream out(name.c_str(), std::ofstream::trunc | std::ofstream::binary);
+
+  out << "<?xml version=\"1.0\"?>" << '\n';
+  out << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"" << vtk_byte_order() << "\"";
+  if(appended.compressed())
+    out << " compressor=\"vtkZLibDataCompressor\"";
+  out << ">" << '\n';
+  out << "<UnstructuredGrid>" << '\n';
+  out << "<Piece NumberOfPoints=\"" << nodes.size() << "\" NumberOfCells=\"" << elems.size() << "\">" << '\n';
+
+  out << "<PointData";
+  if( !sol_name.empty() ) out << " Scalars=\"" << sol_name[0] << "\"";
+  out << ">" << '\n';
+  for(unsigned int i=0; i<sol_name.size(); ++i)
+    out << "<DataArray type=\"Float32\" Name=\"" << sol_name[i] << "\" format=\"appended\" offset=\"" << sol_offset[i] << "\"/>" << '\n';
+  out << "</PointData>" << '\n';
+
+  out << "<CellData Scalars=\"region\">" << '\n';
+  out << "<DataArray type=\"Int32\" Name=\"region\" format=\"appended\" offset=\"" << region_offset << "\"/>" << '\n';
+  out << "<DataArray type=\"Int32\" Name=\"partition\" format=\"appended\" offset=\"" << partition_offset << "\"/>" << '\n';
+  out << "</CellData>" << '\n';
+
+  out << "<Points>" << '\n';
+  out << "<DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"appended\" offset=\"" << points_offset << "\"/>" << '\n';
+  out << "</Points>" << '\n';
+
+  out << "<Cells>" << '\n';
+  out << "<DataArray type=\"Int32\" Name=\"connectivity\" format=\"appended\" offset=\"" << conn_offset << "\"/>" << '\n';
+  out << "<DataArray type=\"Int32\" Name=\"offsets\" format=\"appended\" offset=\"" << offsets_offset << "\"/>" << '\n';
+  out << "<DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"" << types_offset << "\"/>" << '\n';
+  out << "</Cells>" << '\n';
+
+  out << "</Piece>" << '\n';
+  out << "</UnstructuredGrid>" << '\n';
+
+  out << "<AppendedData encoding=\"raw\">" << '\n' << '_';
+  out.write(appended.data().data(), appended.data().size());
+  out << '\n' << "</AppendedData>" << '\n';
+
+  out << "</VTKFile>" << std::endl;
+  out.close();
+}
+
+
+void VTKIO::write_parallel(const std::string & name)
+{
+  // write the piece of this processor
+  std::vector<std::string> sol_name;
+  write_piece(piece_file_name(name, Genius::processor_id()), sol_name);
+
+  // processor 0 writes the index of all the pieces
+  if(Genius::processor_id() == 0)
+  {
+    std::ofstream out(name.c_str(), std::ofstream::trunc);
+
+    out << "<?xml version=\"1.0\"?>" << '\n';
+    out << "<VTKFile type=\"PUnstructuredGrid\" version=\"0.1\" byte_order=\"" << vtk_byte_order() << "\">" << '\n';
+    out << "<PUnstructuredGrid GhostLevel=\"0\">" << '\n';
+
+    out << "<PPointData";
+    if( !sol_name.empty() ) out << " Scalars=\"" << sol_name[0] << "\"";
+    out << ">" << '\n';
+    for(unsigned int i=0; i<sol_name.size(); ++i)
+      out << "<PDataArray type=\"Float32\" Name=\"" << sol_name[i] << "\"/>" << '\n';
+    out << "</PPointData>" << '\n';
+
+    out << "<PCellData Scalars=\"region\">" << '\n';
+    out << "<PDataArray type=\"Int32\" Name=\"region\"/>" << '\n';
+    out << "<PDataArray type=\"Int32\" Name=\"partition\"/>" << '\n';
+    out << "</PCellData>" << '\n';
+
+    out << "<PPoints>" << '\n';
+    out << "<PDataArray type=\"Float32\" NumberOfComponents=\"3\"/>" << '\n';
+    out << "</PPoints>" << '\n';
+
+    // the pieces are in the same directory as the index file
+    for(unsigned int p=0; p<Genius::n_processors(); ++p)
+    {
+      std::string piece = piece_file_name(name, p);
+      out << "<Piece Source=\"" << piece.substr(piece.rfind('/')+1) << "\"/>" << '\n';
+    }
+
+    out << "</PUnstructuredGrid>" << '\n';
+    out << "</VTKFile>" << std::endl;
+    out.close();
+  }
+
+  Parallel::barrier();
+}
+
+
+
 // ------------------------------------------------------------
 // vtkIO class members
 //
@@ -1800,6 +2168,13 @@ void VTKIO::_smooth_numerical_error(std::map<unsigned int, float> &dataset, floa
 void VTKIO::write (const std::string& name)
 {
 
+  // parallel vtk file, each processor writes its own piece
+  if(name.rfind(".pvtu") < name.size())
+  {
+    write_parallel(name);
+    return;
+  }
+
   const MeshBase& mesh = FieldOutput<SimulationSystem>::system().mesh();
   mesh.boundary_info->build_on_processor_side_list (_el, _sl, _il);
 
@@ -1823,13 +2198,34 @@ void VTKIO::write (const std::string& name)
       writer->SetInput(_vtk_grid);
       writer->setExtraHeader(this->export_extra_info());
 
-      writer->SetFileName(name.c_str());
-      writer->Write();
+      if(_background_write)
+      {
+        // format the file in memory, the disk write overlaps with the following solve
+        writer->SetWriteToOutputString(1);
+        writer->Write();
+        std::string content = writer->GetOutputString();
+        AsyncFileWriter::instance().submit(name, content);
+      }
+      else
+      {
+        writer->SetFileName(name.c_str());
+        writer->Write();
+      }
       writer->Delete();
 
     }
     //clean up
     _vtk_grid->Delete();
+#else
+    // self-contained binary writer. on a single processor the whole mesh is one piece,
+    // otherwise each processor writes its own piece of a .pvtu file
+    if(Genius::n_processors() == 1)
+    {
+      std::vector<std::string> sol_name;
+      write_piece(name, sol_name);
+    }
+    else
+      write_parallel(name.substr(0, name.rfind(".vtu")) + ".pvtu");
 #endif
 
   }
@@ -23,6 +23,9 @@
 
 
 
+#include <algorithm>
+#include <cmath>
+
 #include "ddm1/ddm1.h"
 #include "parallel.h"
 #include "petsc_utils.h"
@@ -94,6 +97,9 @@ int DDM1Solver::solve()
 
   START_LOG("DDM1Solver_SNES()", "DDM1Solver");
 
+  // the cached region jacobians may be evaluated with other models or solve type
+  _region_jacobian_cache.clear();
+
   switch( SolverSpecify::Type )
   {
       case SolverSpecify::EQUILIBRIUM :
@@ -382,6 +388,95 @@ void DDM1Solver::bank_rose_damping(Vec , Vec , Vec , PetscBool *changed_y, Petsc
 
 
 
+/*------------------------------------------------------------------
+ * model Newton Damping, avalanche aware when required
+ */
+void DDM1Solver::model_damping(Vec x, Vec y, Vec w, PetscBool *changed_y, PetscBool *changed_w, bool avalanche)
+{
+  PetscScalar    *xx;
+  PetscScalar    *yy;
+  VecGetArray(x, &xx);  // previous iterate value
+  VecGetArray(y, &yy);  // new search direction and length
+
+  PetscScalar dV_max = 0.0; // the max changes of psi
+  PetscScalar lambda_carrier = 1.0; // the step limit of carrier growth
+  const PetscScalar growth = SolverSpecify::carrier_update - 1.0;
+  for(unsigned int n=0; n<_system.n_regions(); n++)
+  {
+    const SimulationRegion * region = _system.region(n);
+    if( region->type() != SemiconductorRegion ) continue;
+
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+    {
+      const unsigned int local_offset = (*it)->local_offset();
+      dV_max = std::max(dV_max, std::abs(yy[local_offset]));
+      if( !avalanche ) continue;
+
+      // the candidate is x-y, the carrier grows where y is negative
+      for(unsigned int k=1; k<3; ++k)
+        if( -yy[local_offset+k] > growth*xx[local_offset+k] && xx[local_offset+k] > 0 )
+          lambda_carrier = std::min(lambda_carrier, growth*xx[local_offset+k]/(-yy[local_offset+k]));
+    }
+  }
+  VecRestoreArray(x, &xx);
+  VecRestoreArray(y, &yy);
+
+  Parallel::max( dV_max );
+  if( avalanche ) Parallel::min( lambda_carrier );
+
+  // start with 1V potential update, the same limit as positive density damping
+  const PetscScalar lambda = model_damping_factor(y, dV_max, 1.0, lambda_carrier);
+
+  int changed_flag = 0;
+  if( lambda < 1.0 )
+  {
+    // w = x - lambda*y
+    VecWAXPY(w, -lambda, y, x);
+    changed_flag = 1;
+  }
+
+  PetscScalar    *ww;
+  VecGetArray(x, &xx);  // previous iterate value
+  VecGetArray(w, &ww);  // current candidate iterate
+
+  const PetscScalar onePerCMC = 1.0*std::pow(cm,-3);
+  for(unsigned int n=0; n<_system.n_regions(); n++)
+  {
+    const SimulationRegion * region = _system.region(n);
+    if( region->type() != SemiconductorRegion ) continue;
+
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+    {
+      unsigned int local_offset = (*it)->local_offset();
+      //prevent negative carrier density
+      if ( ww[local_offset+1] < 0 )
+      { ww[local_offset+1] = 1e-2*fabs(xx[local_offset+1]) + onePerCMC; changed_flag = 1; }
+      if ( ww[local_offset+2] < 0 )
+      { ww[local_offset+2] = 1e-2*fabs(xx[local_offset+2]) + onePerCMC; changed_flag = 1; }
+    }
+  }
+
+  VecRestoreArray(x, &xx);
+  VecRestoreArray(w, &ww);
+
+  //synch changed_flag, if it is not zero, the vector is changed
+  Parallel::sum( changed_flag );
+
+  if(changed_flag)
+  {
+    *changed_y = PETSC_FALSE;
+    *changed_w = PETSC_TRUE;
+  }
+
+  return;
+}
+
+
+
 /*------------------------------------------------------------------
  * positive density Newton Damping
  */
@@ -637,20 +732,19 @@ PetscScalar DDM1Solver::LTE_norm()
 void DDM1Solver::error_norm()
 {
   PetscScalar    *xx;
-  PetscScalar    *ff;
+  const PetscScalar *ff;
 
   // scatte global solution vector x to local vector lx
   // this is not necessary since it had already done in function evaluation
   //VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
   //VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
 
-  // scatte global function vector f to local vector lf
-  VecScatterBegin(scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
+  // only the on processor dofs are involved, read them from the global function vector f
+  // directly (indexed by global offset) instead of scattering f to local vector lf
 
 
   VecGetArray(lx, &xx);  // solution value
-  VecGetArray(lf, &ff);  // function value
+  VecGetArrayRead(f, &ff);   // function value
 
   // do clear
   potential_norm        = 0;
@@ -679,6 +773,7 @@ void DDM1Solver::error_norm()
     {
       const FVM_Node * fvm_node = *it;
       unsigned int offset = fvm_node->local_offset();
+      unsigned int f_offset = fvm_node->global_offset() - global_offset;
 
       switch ( region->type() )
       {
@@ -688,27 +783,27 @@ void DDM1Solver::error_norm()
             electron_norm  += xx[offset+1]*xx[offset+1];
             hole_norm      += xx[offset+2]*xx[offset+2];
 
-            poisson_norm         += ff[offset+0]*ff[offset+0];
-            elec_continuity_norm += ff[offset+1]*ff[offset+1];
-            hole_continuity_norm += ff[offset+2]*ff[offset+2];
+            poisson_norm         += ff[f_offset+0]*ff[f_offset+0];
+            elec_continuity_norm += ff[f_offset+1]*ff[f_offset+1];
+            hole_continuity_norm += ff[f_offset+2]*ff[f_offset+2];
             break;
           }
           case InsulatorRegion :
           {
             potential_norm += xx[offset]*xx[offset];
-            poisson_norm   += ff[offset]*ff[offset];
+            poisson_norm   += ff[f_offset]*ff[f_offset];
             break;
           }
           case ElectrodeRegion :
           {
             potential_norm += xx[offset]*xx[offset];
-            poisson_norm   += ff[offset]*ff[offset];
+            poisson_norm   += ff[f_offset]*ff[f_offset];
             break;
           }
           case MetalRegion :
           {
             potential_norm += xx[offset]*xx[offset];
-            poisson_norm   += ff[offset]*ff[offset];
+            poisson_norm   += ff[f_offset]*ff[f_offset];
             break;
           }
           case VacuumRegion:
@@ -724,10 +819,11 @@ void DDM1Solver::error_norm()
     {
       const BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
       unsigned int offset = bc->local_offset();
+      unsigned int f_offset = bc->global_offset() - global_offset;
       if( offset != invalid_uint )
       {
         potential_norm += xx[offset]*xx[offset];
-        electrode_norm += ff[offset]*ff[offset];
+        electrode_norm += ff[f_offset]*ff[f_offset];
       }
     }
 
@@ -759,7 +855,7 @@ void DDM1Solver::error_norm()
 
 
   VecRestoreArray(lx, &xx);
-  VecRestoreArray(lf, &ff);
+  VecRestoreArrayRead(f, &ff);
 
 }
 
@@ -784,8 +880,7 @@ void DDM1Solver::build_petsc_sens_residual(Vec x, Vec r)
   START_LOG("DDM1Solver_Residual()", "DDM1Solver");
 
   // scatte global solution vector x to local vector lx
-  VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+  scatter_local_begin(x);
 
   PetscScalar *lxx;
   // get PetscScalar array contains solution from local solution vector lx
@@ -794,6 +889,19 @@ void DDM1Solver::build_petsc_sens_residual(Vec x, Vec r)
   // clear old data
   VecZeroEntries (r);
 
+  // the on processor dofs of lx are ready, evaluate the terms need no ghost dofs while they are in flight
+  for(unsigned int n=0; n<_system.n_regions(); n++)
+  {
+    SimulationRegion * region = _system.region(n);
+    START_LOG("Region_Function_Interior()", "DDM1Solver");
+    START_DYNAMIC_LOG(region->kernel_label(), "DDM1 Region_Function_Interior");
+    region->DDM1_Function_Interior(lxx);
+    STOP_DYNAMIC_LOG(region->kernel_label(), "DDM1 Region_Function_Interior");
+    STOP_LOG("Region_Function_Interior()", "DDM1Solver");
+  }
+
+  scatter_local_end(x);
+
   // flag for indicate ADD_VALUES operator.
   InsertMode add_value_flag = NOT_SET_VALUES;
 
@@ -801,7 +909,11 @@ void DDM1Solver::build_petsc_sens_residual(Vec x, Vec r)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    START_LOG("Region_Function()", "DDM1Solver");
+    START_DYNAMIC_LOG(region->kernel_label(), "DDM1 Region_Function");
     region->DDM1_Function(lxx, r, add_value_flag);
+    STOP_DYNAMIC_LOG(region->kernel_label(), "DDM1 Region_Function");
+    STOP_LOG("Region_Function()", "DDM1Solver");
   }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
@@ -841,16 +953,21 @@ void DDM1Solver::build_petsc_sens_residual(Vec x, Vec r)
     bc->DDM1_Function_Preprocess(r, src_row, dst_row, clear_row);
   }
   //add source rows to destination rows, and clear rows
-  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row);
-  add_value_flag = NOT_SET_VALUES;
+  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
 
   // evaluate governing equations of DDML1 for all the boundaries
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
   {
     BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+    START_LOG("BC_Function()", "DDM1Solver");
     bc->DDM1_Function(lxx, r, add_value_flag);
+    STOP_LOG("BC_Function()", "DDM1Solver");
   }
 
+  // the external circuit of all the electrodes
+  _system.get_bcs()->electrode_circuit_function(lxx, r, add_value_flag);
+
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
@@ -860,23 +977,14 @@ void DDM1Solver::build_petsc_sens_residual(Vec x, Vec r)
   VecRestoreArray(lx, &lxx);
 
   // assembly the function Vec
+  START_LOG("VecAssembly()", "DDM1Solver");
   VecAssemblyBegin(r);
   VecAssemblyEnd(r);
+  STOP_LOG("VecAssembly()", "DDM1Solver");
 
-  // scale the function vec
-  PetscScalar *ff,*scale;
-  // get function array and scale array.
-  VecGetArray(r, &ff);
-  // L is the scaling vector, the Jacobian evaluate function may dynamically update it.
-  VecGetArray(L, &scale);
-
-  // scale it!
-  for(unsigned int n=0; n<n_local_dofs; n++)
-    ff[n] *= scale[n];
-
-  // restore back
-  VecRestoreArray(r, &ff);
-  VecRestoreArray(L, &scale);
+  // scale the function vec, L is the scaling vector, the Jacobian evaluate function may dynamically update it.
+  // a vector operation does not pull device vector types back to host memory
+  VecPointwiseMult(r, r, L);
 
   //VecView(r, PETSC_VIEWER_STDOUT_SELF);
   //getchar();
@@ -896,8 +1004,7 @@ void DDM1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   START_LOG("DDM1Solver_Jacobian()", "DDM1Solver");
 
   // scatte global solution vector x to local vector lx
-  VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+  scatter_local_begin(x);
 
   PetscScalar *lxx;
   // get PetscScalar array contains solution from local solution vector lx
@@ -905,14 +1012,63 @@ void DDM1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
 
   MatZeroEntries(J);
 
+  // the regions whose solution has not moved since their jacobian was kept take it from the cache.
+  // the cache works in the slot space of J, which is known after the first assembly
+  const bool region_reuse = SolverSpecify::RegionJacobianReuse && J_slot_map.valid();
+  std::vector<bool> region_reused(_system.n_regions(), false);
+  if( region_reuse )
+  {
+    _region_jacobian_cache.resize(_system.n_regions());
+    for(unsigned int n=0; n<_system.n_regions(); n++)
+      region_reused[n] = region_jacobian_unchanged(n, lxx, false);
+  }
+
+  // the on processor dofs of lx are ready, evaluate the terms need no ghost dofs while they are in flight
+  for(unsigned int n=0; n<_system.n_regions(); n++)
+  {
+    if( region_reused[n] ) continue;
+    SimulationRegion * region = _system.region(n);
+    START_LOG("Region_Jacobian_Interior()", "DDM1Solver");
+    START_DYNAMIC_LOG(region->kernel_label(), "DDM1 Region_Jacobian_Interior");
+    region->DDM1_Jacobian_Interior(lxx);
+    STOP_DYNAMIC_LOG(region->kernel_label(), "DDM1 Region_Jacobian_Interior");
+    STOP_LOG("Region_Jacobian_Interior()", "DDM1Solver");
+  }
+
+  scatter_local_end(x);
+
+  // the ghost dofs have arrived, they should not have moved either
+  if( region_reuse )
+    for(unsigned int n=0; n<_system.n_regions(); n++)
+      if( region_reused[n] )
+        region_reused[n] = region_jacobian_unchanged(n, lxx, true);
+
+  // after the first assembly, region routines can add values to J by precomputed slots
+  if( J_slot_map.valid() )
+    J_slot_map.begin(J);
+
   // flag for indicate ADD_VALUES operator.
   InsertMode add_value_flag = NOT_SET_VALUES;
 
   // evaluate Jacobian matrix of governing equations of DDML1 in all the regions
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
+    if( region_reused[n] )
+    {
+      load_region_jacobian(n);
+      add_value_flag = ADD_VALUES;
+      continue;
+    }
+
     SimulationRegion * region = _system.region(n);
+    START_LOG("Region_Jacobian()", "DDM1Solver");
+    START_DYNAMIC_LOG(region->kernel_label(), "DDM1 Region_Jacobian");
     region->DDM1_Jacobian(lxx, &J, add_value_flag);
+    STOP_DYNAMIC_LOG(region->kernel_label(), "DDM1 Region_Jacobian");
+    STOP_LOG("Region_Jacobian()", "DDM1Solver");
+
+    if( region_reuse )
+      save_region_jacobian(n, lxx);
   }
 
 
@@ -955,9 +1111,14 @@ void DDM1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
 
+  // slot assembly is finished, the value arrays should be restored before assembly
+  J_slot_map.end(J);
+
   // evaluate Jacobian matrix of governing equations of DDML1 for all the boundaries
+  START_LOG("MatAssembly()", "DDM1Solver");
   MatAssemblyBegin(J, MAT_FINAL_ASSEMBLY);
   MatAssemblyEnd(J, MAT_FINAL_ASSEMBLY);
+  STOP_LOG("MatAssembly()", "DDM1Solver");
 
   // we do not allow zero insert/add to matrix
   if( !jacobian_matrix_first_assemble )
@@ -969,18 +1130,21 @@ void DDM1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
     BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
     bc->DDM1_Jacobian_Preprocess(&J, src_row, dst_row, clear_row);
   }
-  //add source rows to destination rows
-  PetscUtils::MatAddRowToRow(J, src_row, dst_row);
-  // clear row
-  PetscUtils::MatZeroRows(J, clear_row.size(), clear_row.empty() ? NULL : &clear_row[0], 0.0);
+  //add source rows to destination rows, and clear rows
+  PetscUtils::MatAddClearRow(J, src_row, dst_row, clear_row, global_clear_rows(clear_row));
 
-  add_value_flag = NOT_SET_VALUES;
+  add_value_flag = ADD_VALUES;
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
   {
     BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+    START_LOG("BC_Jacobian()", "DDM1Solver");
     bc->DDM1_Jacobian(lxx, &J, add_value_flag);
+    STOP_LOG("BC_Jacobian()", "DDM1Solver");
   }
 
+  // the external circuit of all the electrodes
+  _system.get_bcs()->electrode_circuit_jacobian(&J, add_value_flag);
+
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
@@ -990,8 +1154,10 @@ void DDM1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   VecRestoreArray(lx, &lxx);
 
   // assembly the matrix
+  START_LOG("MatAssembly()", "DDM1Solver");
   MatAssemblyBegin(J, MAT_FINAL_ASSEMBLY);
   MatAssemblyEnd  (J, MAT_FINAL_ASSEMBLY);
+  STOP_LOG("MatAssembly()", "DDM1Solver");
 
   //scaling the matrix
   MatDiagonalScale(J, L, PETSC_NULL);
@@ -1009,12 +1175,107 @@ void DDM1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   //dump_jacobian_matrix_petsc("jacobian.mat");
 
   if(!jacobian_matrix_first_assemble)
+  {
     jacobian_matrix_first_assemble = true;
+    // the nonzero pattern of J is fixed now
+    J_slot_map.build(J);
+  }
 
   STOP_LOG("DDM1Solver_Jacobian()", "DDM1Solver");
 
 }
 
+
+
+/*------------------------------------------------------------------
+ * test if the cached jacobian of region n can be reused at solution lxx
+ */
+bool DDM1Solver::region_jacobian_unchanged(unsigned int n, const PetscScalar * lxx, bool ghost) const
+{
+  const RegionJacobianCache & cache = _region_jacobian_cache[n];
+  if( !cache.valid || cache.stamp != J_slot_map.stamp() ) return false;
+
+  const unsigned int begin = ghost ? cache.n_processor_dofs : 0;
+  const unsigned int end   = ghost ? cache.dofs.size() : cache.n_processor_dofs;
+  for(unsigned int i=begin; i<end; ++i)
+    if( std::abs(lxx[cache.dofs[i]] - cache.x[i]) > cache.tol[i] ) return false;
+
+  return true;
+}
+
+
+/*------------------------------------------------------------------
+ * keep the rows of region n in J, evaluated at solution lxx
+ */
+void DDM1Solver::save_region_jacobian(unsigned int n, const PetscScalar * lxx)
+{
+  const SimulationRegion * region = _system.region(n);
+  RegionJacobianCache & cache = _region_jacobian_cache[n];
+  const unsigned int n_dofs = this->node_dofs(region);
+
+  // the slots and the dofs only change with the slot map
+  if( cache.stamp != J_slot_map.stamp() )
+  {
+    cache.slots.clear();
+    cache.dofs.clear();
+
+    // on processor rows, a node shared by periodic boundaries appears twice
+    std::vector<PetscInt> rows;
+    SimulationRegion::const_processor_node_iterator node_it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator node_it_end = region->on_processor_nodes_end();
+    for(; node_it!=node_it_end; ++node_it)
+      for(unsigned int k=0; k<n_dofs; ++k)
+      {
+        rows.push_back((*node_it)->global_offset()+k);
+        cache.dofs.push_back((*node_it)->local_offset()+k);
+      }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    for(unsigned int r=0; r<rows.size(); ++r)
+      J_slot_map.row_slots(rows[r], cache.slots);
+
+    cache.n_processor_dofs = cache.dofs.size();
+    SimulationRegion::const_local_node_iterator local_it = region->on_local_nodes_begin();
+    SimulationRegion::const_local_node_iterator local_it_end = region->on_local_nodes_end();
+    for(; local_it!=local_it_end; ++local_it)
+      if( !(*local_it)->on_processor() )
+        for(unsigned int k=0; k<n_dofs; ++k)
+          cache.dofs.push_back((*local_it)->local_offset()+k);
+
+    cache.stamp = J_slot_map.stamp();
+  }
+
+  cache.values.resize(cache.slots.size());
+  if( !cache.slots.empty() )
+    J_slot_map.get(cache.slots.size(), &cache.slots[0], &cache.values[0]);
+
+  // the first dof of each node is the potential, the others are carrier densities.
+  // the potential is allowed to change a fraction of kT/q, the densities a fraction of their value
+  const PetscScalar Vt = kb*region->T_external()/e;
+  cache.x.resize(cache.dofs.size());
+  cache.tol.resize(cache.dofs.size());
+  for(unsigned int i=0; i<cache.dofs.size(); ++i)
+  {
+    cache.x[i] = lxx[cache.dofs[i]];
+    cache.tol[i] = SolverSpecify::RegionJacobianReuseTol * ( i%n_dofs == 0 ? Vt : std::abs(cache.x[i]) );
+  }
+
+  cache.valid = true;
+}
+
+
+/*------------------------------------------------------------------
+ * add the cached rows of region n to J
+ */
+void DDM1Solver::load_region_jacobian(unsigned int n)
+{
+  const RegionJacobianCache & cache = _region_jacobian_cache[n];
+  if( !cache.slots.empty() )
+    J_slot_map.add(cache.slots.size(), &cache.slots[0], &cache.values[0]);
+}
+
+
+
 void DDM1Solver::set_trace_electrode(BoundaryCondition *bc)
 {
   // we needn't scatter again
@@ -280,60 +280,10 @@ void GateContactBC::DDM1_Function(PetscScalar * x, Vec f, InsertMode &add_value_
   // for stand alone electrode
   else
   {
-    if(ext_circuit()->is_voltage_driven())
-    {
-      PetscScalar R = ext_circuit()->R();             // resistance
-      PetscScalar L = ext_circuit()->L();             // inductance
-      PetscScalar dt = SolverSpecify::dt;
-      PetscScalar f_ext = (L/dt+R)*current;
-      VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
-    }
-
-    if(ext_circuit()->is_current_driven())
-    {
-      PetscScalar f_ext = current;
-      VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
-    }
-  }
-
-  if(Genius::is_last_processor())
-  {
-    //for inter connect electrode
-    if(this->is_inter_connect_bc())
-    {
-      PetscScalar V_ic = x[this->inter_connect_hub()->local_offset()];  // potential at inter connect node
-      PetscScalar R = ext_circuit()->R();                               // resistance
-      PetscScalar f_ext = Ve - V_ic;
-      VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
-    }
-    // for stand alone electrode
-    else
-    {
-      if(ext_circuit()->is_voltage_driven())
-      {
-        PetscScalar Vapp = ext_circuit()->Vapp();       // application voltage
-        PetscScalar R = ext_circuit()->R();             // resistance
-        PetscScalar C = ext_circuit()->C();             // capacitance
-        PetscScalar L = ext_circuit()->L();             // inductance
-        PetscScalar I = ext_circuit()->current();       // the previous step current flow into electrode
-        PetscScalar Ic = ext_circuit()->cap_current();  // the previous step current flow pass though cap to ground.
-        PetscScalar P  = ext_circuit()->potential();    // the previous step potential of the electrode
-        PetscScalar dt = SolverSpecify::dt;
-        PetscScalar f_ext = (Ve-Vapp) + (L/dt+R)*C/dt*Ve - (L/dt+R)*C/dt*P - L/dt*(I+Ic);
-        VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
-      }
-
-      if(ext_circuit()->is_current_driven())
-      {
-        PetscScalar Iapp = ext_circuit()->Iapp();         // application current
-        PetscScalar Ic   = ext_circuit()->cap_current();  // the previous step current flow pass though cap to ground.
-        PetscScalar f_ext = Ic - Iapp;
-        VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
-      }
-    }
+    PetscScalar f_ext = ext_circuit()->mna_scaling(SolverSpecify::dt)*current;
+    VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
   }
 
-
   // save the IV of current iteration
   ext_circuit()->current_itering() = current;
   ext_circuit()->potential_itering() = Ve;
@@ -695,43 +645,6 @@ void GateContactBC::DDM1_Jacobian(PetscScalar * x, Mat *jac, InsertMode &add_val
   //
   //
 
-  if(Genius::is_last_processor())
-  {
-    // here we process the external circuit, we do not use AD here
-    // NOTE current item such as (L/dt+R)*current and current has already been processed before
-
-    //for inter connect electrode
-    if(this->is_inter_connect_bc())
-    {
-      // the external electrode equation is:
-      // f_ext = Ve - V_ic + R*current;
-
-      // d(f_ext)/d(Ve)
-      MatSetValue(*jac, bc_global_offset, bc_global_offset, 1.0, ADD_VALUES);
-      // d(f_ext)/d(V_ic)
-      MatSetValue(*jac, bc_global_offset, this->inter_connect_hub()->global_offset(), -1.0, ADD_VALUES);
-    }
-    //for stand alone electrode
-    else
-    {
-      if(ext_circuit()->is_voltage_driven())
-      {
-        // the external electrode equation is:
-        // f_ext = (L/dt+R)*current + (Ve-Vapp) + (L/dt+R)*C/dt*Ve - (L/dt+R)*C/dt*P - L/dt*(I+Ic);
-
-        // d(f_ext)/d(Ve)
-        MatSetValue(*jac, bc_global_offset, bc_global_offset, 1+(L/dt+R)*C/dt, ADD_VALUES);
-      }
-
-      if(ext_circuit()->is_current_driven())
-      {
-        // the external electrode equation is:
-        // f_ext = current + Ic - Iapp;
-        // so nothing to do
-      }
-    }
-  }
-
   // the last operator is ADD_VALUES
   add_value_flag = ADD_VALUES;
 
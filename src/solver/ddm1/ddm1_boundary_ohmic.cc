@@ -88,59 +88,54 @@ void OhmicContactBC::DDM1_Function_Preprocess(Vec f, std::vector<PetscInt> &src_
 {
   this->_current_buffer.clear();
 
-  BoundaryCondition::const_node_iterator node_it = nodes_begin();
-  BoundaryCondition::const_node_iterator end_it = nodes_end();
-  for(; node_it!=end_it; ++node_it )
-  {
-    // skip node not belongs to this processor
-    if( (*node_it)->processor_id()!=Genius::processor_id() ) continue;
-
-    // search all the fvm_node which has *node_it as root node
-    BoundaryCondition::region_node_iterator  rnode_it     = region_node_begin(*node_it);
-    BoundaryCondition::region_node_iterator  end_rnode_it = region_node_end(*node_it);
+  // the electron and hole equation rows of all the semiconductor nodes, read by one VecGetValues
+  std::vector<PetscInt> ix;
 
-    // should clear all the rows related with ohmic boundary condition
-    for(unsigned int i=0 ; rnode_it!=end_rnode_it; ++i, ++rnode_it  )
+  // should clear all the rows related with ohmic boundary condition.
+  // the flattened region node table avoids searching the region nodes of each boundary node
+  const std::vector<RegionNode> & table = region_node_table();
+  for(unsigned int i=0; i<table.size(); ++i)
+  {
+    const SimulationRegion * region = table[i].region;
+    const FVM_Node *  fvm_node = table[i].fvm_node;
+    switch ( region->type() )
     {
-      const SimulationRegion * region = (*rnode_it).second.first;
-      const FVM_Node *  fvm_node = (*rnode_it).second.second ;
-      switch ( region->type() )
-      {
-          case SemiconductorRegion:
-          {
-            PetscInt row = fvm_node->global_offset();
-            clear_row.push_back(row+0);
-            clear_row.push_back(row+1);
-            clear_row.push_back(row+2);
-
-            // for conduction current
-            {
-              PetscInt    ix[2] = {fvm_node->global_offset()+1, fvm_node->global_offset()+2};
-              // I={In, Ip} the electron and hole current flow into this boundary cell.
-              // NOTE: although In has dn/dt and R items, they are zero since n is const and n=n0 holds
-              // so does Ip
-              PetscScalar I[2];
-
-              VecGetValues(f, 2, ix, I);
-
-              // the current = In - Ip;
-              this->_current_buffer.push_back((I[0] - I[1]));
-            }
-            break;
-          }
-          case ElectrodeRegion:
-          case InsulatorRegion:
-          {
-            PetscInt row = fvm_node->global_offset();
-            clear_row.push_back(row);
-            break;
-          }
-          case VacuumRegion:
+        case SemiconductorRegion:
+        {
+          PetscInt row = fvm_node->global_offset();
+          clear_row.push_back(row+0);
+          clear_row.push_back(row+1);
+          clear_row.push_back(row+2);
+
+          // for conduction current
+          ix.push_back(row+1);
+          ix.push_back(row+2);
           break;
-          default: genius_error(); //we should never reach here
-      }
+        }
+        case ElectrodeRegion:
+        case InsulatorRegion:
+        {
+          PetscInt row = fvm_node->global_offset();
+          clear_row.push_back(row);
+          break;
+        }
+        case VacuumRegion:
+        break;
+        default: genius_error(); //we should never reach here
     }
   }
+
+  if( ix.empty() ) return;
+
+  // I={In, Ip} the electron and hole current flow into each boundary cell.
+  // NOTE: although In has dn/dt and R items, they are zero since n is const and n=n0 holds
+  // so does Ip
+  std::vector<PetscScalar> I(ix.size());
+  VecGetValues(f, ix.size(), &ix[0], &I[0]);
+
+  // the current = In - Ip;
+  for(unsigned int i=0; i<I.size(); i+=2)
+    this->_current_buffer.push_back((I[i] - I[i+1]));
 }
 
 
@@ -406,60 +401,10 @@ void OhmicContactBC::DDM1_Function(PetscScalar * x, Vec f, InsertMode &add_value
   // for stand alone electrode
   else
   {
-    if(ext_circuit()->is_voltage_driven())
-    {
-      PetscScalar R = ext_circuit()->R();             // resistance
-      PetscScalar L = ext_circuit()->L();             // inductance
-      PetscScalar dt = SolverSpecify::dt;
-      PetscScalar f_ext = (L/dt+R)*current;
-      VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
-    }
-
-    if(ext_circuit()->is_current_driven())
-    {
-      PetscScalar f_ext = current;
-      VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
-    }
-  }
-
-  if(Genius::is_last_processor())
-  {
-    //for inter connect electrode
-    if(this->is_inter_connect_bc())
-    {
-      PetscScalar V_ic = x[this->inter_connect_hub()->local_offset()];  // potential at inter connect node
-      PetscScalar R = ext_circuit()->R();                               // resistance
-      PetscScalar f_ext = Ve - V_ic;
-      VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
-    }
-    // for stand alone electrode
-    else
-    {
-      if(ext_circuit()->is_voltage_driven())
-      {
-        PetscScalar Vapp = ext_circuit()->Vapp();       // application voltage
-        PetscScalar R = ext_circuit()->R();             // resistance
-        PetscScalar C = ext_circuit()->C();             // capacitance
-        PetscScalar L = ext_circuit()->L();             // inductance
-        PetscScalar I = ext_circuit()->current();       // the previous step current flow into electrode
-        PetscScalar Ic = ext_circuit()->cap_current();  // the previous step current flow pass though cap to ground.
-        PetscScalar P  = ext_circuit()->potential();    // the previous step potential of the electrode
-        PetscScalar dt = SolverSpecify::dt;
-        PetscScalar f_ext = (Ve-Vapp) + (L/dt+R)*C/dt*Ve - (L/dt+R)*C/dt*P - L/dt*(I+Ic);
-        VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
-      }
-
-      if(ext_circuit()->is_current_driven())
-      {
-        PetscScalar Iapp = ext_circuit()->Iapp();         // application current
-        PetscScalar Ic   = ext_circuit()->cap_current();  // the previous step current flow pass though cap to ground.
-        PetscScalar f_ext = Ic - Iapp;
-        VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
-      }
-    }
+    PetscScalar f_ext = ext_circuit()->mna_scaling(SolverSpecify::dt)*current;
+    VecSetValue(f, this->global_offset(), f_ext, ADD_VALUES);
   }
 
-
   // save the IV of current iteration
   ext_circuit()->current_itering() = current;
   ext_circuit()->potential_itering() = Ve;
@@ -615,144 +560,94 @@ void OhmicContactBC::DDM1_Jacobian_Preprocess(Mat *jac, std::vector<PetscInt> &s
   PetscScalar L = ext_circuit()->L();             // inductance
   PetscScalar dt = SolverSpecify::dt;
 
+  // the scale of electrode current in the external circuit equation
+  PetscScalar scale = current_scale;
+  if(this->is_inter_connect_bc())
+    scale *= R;
+  else if(ext_circuit()->is_voltage_driven())
+    scale *= (L/dt+R);
+
+  // the flattened region node table avoids searching the region nodes of each boundary node
+  const std::vector<RegionNode> & table = region_node_table();
+
+  // column indices and values of the electron/hole rows of a node, reused for all the nodes
+  std::vector<PetscInt>    cols;
+  std::vector<PetscScalar> A;
+
   // search and process all the boundary nodes
-  BoundaryCondition::const_node_iterator node_it;
-  BoundaryCondition::const_node_iterator end_it = nodes_end();
-  for(node_it = nodes_begin(); node_it!=end_it; ++node_it )
+  for(unsigned int i=0; i<table.size(); ++i)
   {
-    // only process nodes belong to this processor
-    if( (*node_it)->processor_id() != Genius::processor_id() ) continue;
-
     // get the derivative of electrode current to ohmic node
-    const FVM_Node *  fvm_node = get_region_fvm_node(*node_it, SemiconductorRegion);
-    const FVM_NodeData * node_data = fvm_node->node_data();
+    if( table[i].region->type() != SemiconductorRegion ) continue;
+    const FVM_Node *  fvm_node = table[i].fvm_node;
 
-    PetscScalar A1[3], A2[3];
-    std::vector<PetscScalar> JM(3), JN(3);
     std::vector<PetscInt>    row(3);
     row[0] = fvm_node->global_offset()+0;
     row[1] = fvm_node->global_offset()+1;
     row[2] = fvm_node->global_offset()+2;
 
-    //NOTE MatGetValues only get value from local block!
-    MatGetValues(*jac, 1, &row[1], 3, &row[0], &A1[0]);
-    MatGetValues(*jac, 1, &row[2], 3, &row[0], &A2[0]);
-
-    //for inter connect electrode
-    if(this->is_inter_connect_bc())
-    {
-      JM[0] = R*(A1[0]-A2[0])*current_scale;
-      JM[1] = R*(A1[1]-A2[1])*current_scale;
-      JM[2] = R*(A1[2]-A2[2])*current_scale;
-    }
-    // for stand alone electrode
-    else
-    {
-      if(ext_circuit()->is_voltage_driven())
-      {
-        JM[0] = (L/dt+R)*(A1[0]-A2[0])*current_scale;
-        JM[1] = (L/dt+R)*(A1[1]-A2[1])*current_scale;
-        JM[2] = (L/dt+R)*(A1[2]-A2[2])*current_scale;
-      }
-
-      if(ext_circuit()->is_current_driven())
-      {
-        JM[0] = (A1[0]-A2[0])*current_scale;
-        JM[1] = (A1[1]-A2[1])*current_scale;
-        JM[2] = (A1[2]-A2[2])*current_scale;
-      }
-    }
-
-    // get the derivative of electrode current to neighbors of ohmic node
+    // the columns of this node followed by its neighbors
     // NOTE neighbors and ohmic bc node may on different processor!
+    cols.assign(row.begin(), row.end());
     FVM_Node::fvm_neighbor_node_iterator nb_it = fvm_node->neighbor_node_begin();
     FVM_Node::fvm_neighbor_node_iterator nb_it_end = fvm_node->neighbor_node_end();
     for(; nb_it != nb_it_end; ++nb_it)
     {
       const FVM_Node *  fvm_nb_node = (*nb_it).second;
+      cols.push_back(fvm_nb_node->global_offset()+0);
+      cols.push_back(fvm_nb_node->global_offset()+1);
+      cols.push_back(fvm_nb_node->global_offset()+2);
+    }
 
-      // distance from nb node to this node
-      PetscScalar distance = (*(fvm_node->root_node()) - *(fvm_nb_node->root_node())).size();
-      // area of out surface of control volume related with neighbor node
-      PetscScalar cv_boundary = fvm_node->cv_surface_area(fvm_nb_node->root_node());
-
-      std::vector<PetscInt>    col(3);
-      col[0] = fvm_nb_node->global_offset()+0;
-      col[1] = fvm_nb_node->global_offset()+1;
-      col[2] = fvm_nb_node->global_offset()+2;
-
-      MatGetValues(*jac, 1, &row[1], 3, &col[0], &A1[0]);
-      MatGetValues(*jac, 1, &row[2], 3, &col[0], &A2[0]);
-
-      //for inter connect electrode
-      if(this->is_inter_connect_bc())
-      {
-        JN[0] = R*(A1[0]-A2[0])*current_scale;
-        JN[1] = R*(A1[1]-A2[1])*current_scale;
-        JN[2] = R*(A1[2]-A2[2])*current_scale;
-      }
-      // for stand alone electrode
-      else
-      {
-        if(ext_circuit()->is_voltage_driven())
-        {
-          JN[0] = (L/dt+R)*(A1[0]-A2[0])*current_scale;
-          JN[1] = (L/dt+R)*(A1[1]-A2[1])*current_scale;
-          JN[2] = (L/dt+R)*(A1[2]-A2[2])*current_scale;
-        }
+    // the electron and hole rows at all the columns in one call
+    //NOTE MatGetValues only get value from local block!
+    const unsigned int n_cols = cols.size();
+    A.resize(2*n_cols);
+    MatGetValues(*jac, 2, &row[1], n_cols, &cols[0], &A[0]);
 
-        if(ext_circuit()->is_current_driven())
-        {
-          JN[0] = (A1[0]-A2[0])*current_scale;
-          JN[1] = (A1[1]-A2[1])*current_scale;
-          JN[2] = (A1[2]-A2[2])*current_scale;
-        }
-      }
-      _buffer_cols.push_back(col);
+    // derivative of electrode current to the neighbors
+    for(unsigned int c=3; c<n_cols; c+=3)
+    {
+      std::vector<PetscScalar> JN(3);
+      for(unsigned int k=0; k<3; ++k)
+        JN[k] = scale*(A[c+k]-A[n_cols+c+k]);
+      _buffer_cols.push_back(std::vector<PetscInt>(cols.begin()+c, cols.begin()+c+3));
       _buffer_jacobian_entries.push_back(JN);
     }
 
+    // derivative of electrode current to ohmic node
+    std::vector<PetscScalar> JM(3);
+    for(unsigned int k=0; k<3; ++k)
+      JM[k] = scale*(A[k]-A[n_cols+k]);
     _buffer_cols.push_back(row);
     _buffer_jacobian_entries.push_back(JM);
   }
 
-  for(node_it = nodes_begin(); node_it!=end_it; ++node_it )
+  // should clear all the rows related with ohmic boundary condition
+  for(unsigned int i=0; i<table.size(); ++i)
   {
-
-    // only process nodes belong to this processor
-    if( (*node_it)->processor_id() != Genius::processor_id() ) continue;
-
-    // search all the fvm_node which has *node_it as root node, these nodes are the same in geometry,
-    // but in different region.
-    BoundaryCondition::region_node_iterator  rnode_it     = region_node_begin(*node_it);
-    BoundaryCondition::region_node_iterator  end_rnode_it = region_node_end(*node_it);
-
-    // should clear all the rows related with ohmic boundary condition
-    for(unsigned int i=0 ; rnode_it!=end_rnode_it; ++i, ++rnode_it  )
+    const SimulationRegion * region = table[i].region;
+    const FVM_Node *  fvm_node = table[i].fvm_node;
+    switch ( region->type() )
     {
-      const SimulationRegion * region = (*rnode_it).second.first;
-      const FVM_Node *  fvm_node = (*rnode_it).second.second ;
-      switch ( region->type() )
-      {
-          case SemiconductorRegion:
-          {
-            PetscInt row = fvm_node->global_offset();
-            clear_row.push_back(row+0);
-            clear_row.push_back(row+1);
-            clear_row.push_back(row+2);
-            break;
-          }
-          case ElectrodeRegion:
-          case InsulatorRegion:
-          {
-            PetscInt row = fvm_node->global_offset();
-            clear_row.push_back(row);
-            break;
-          }
-          case VacuumRegion:
+        case SemiconductorRegion:
+        {
+          PetscInt row = fvm_node->global_offset();
+          clear_row.push_back(row+0);
+          clear_row.push_back(row+1);
+          clear_row.push_back(row+2);
           break;
-          default: genius_error(); //we should never reach here
-      }
+        }
+        case ElectrodeRegion:
+        case InsulatorRegion:
+        {
+          PetscInt row = fvm_node->global_offset();
+          clear_row.push_back(row);
+          break;
+        }
+        case VacuumRegion:
+        break;
+        default: genius_error(); //we should never reach here
     }
   }
 
@@ -1022,44 +917,6 @@ void OhmicContactBC::DDM1_Jacobian(PetscScalar * x, Mat *jac, InsertMode &add_va
   //
   //
 
-  if(Genius::is_last_processor())
-  {
-    // here we process the external circuit, we do not use AD here
-    // NOTE current item such as (L/dt+R)*current and current has already been processed before
-
-    //for inter connect electrode
-    if(this->is_inter_connect_bc())
-    {
-      // the external electrode equation is:
-      // f_ext = Ve - V_ic + R*current;
-
-      // d(f_ext)/d(Ve)
-      MatSetValue(*jac, bc_global_offset, bc_global_offset, 1.0, ADD_VALUES);
-      // d(f_ext)/d(V_ic)
-      MatSetValue(*jac, bc_global_offset, this->inter_connect_hub()->global_offset(), -1.0, ADD_VALUES);
-    }
-    //for stand alone electrode
-    else
-    {
-      if(ext_circuit()->is_voltage_driven())
-      {
-        // the external electrode equation is:
-        // f_ext = (L/dt+R)*current + (Ve-Vapp) + (L/dt+R)*C/dt*Ve - (L/dt+R)*C/dt*P - L/dt*(I+Ic);
-
-        // d(f_ext)/d(Ve)
-        MatSetValue(*jac, bc_global_offset, bc_global_offset, 1+(L/dt+R)*C/dt, ADD_VALUES);
-      }
-
-      if(ext_circuit()->is_current_driven())
-      {
-        // the external electrode equation is:
-        // f_ext = current + Ic - Iapp;
-        // so nothing to do
-      }
-    }
-
-  }
-
   // the last operator is ADD_VALUES
   add_value_flag = ADD_VALUES;
 
@@ -23,6 +23,7 @@
 
 #include "elem.h"
 #include "simulation_system.h"
+#include "fvm_edge_assembly.h"
 #include "conductor_region.h"
 
 using PhysicalUnit::kb;
@@ -92,51 +93,7 @@ void ElectrodeSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, InsertMode
   y.reserve(2*n_edge());
 
   // search all the edges of this region, do integral over control volume...
-  const_edge_iterator it = edges_begin();
-  const_edge_iterator it_end = edges_end();
-  for(; it!=it_end; ++it)
-  {
-    // fvm_node of node1
-    const FVM_Node * fvm_n1 = (*it).first;
-    // fvm_node of node2
-    const FVM_Node * fvm_n2 = (*it).second;
-
-    // fvm_node_data of node1
-    const FVM_NodeData * n1_data =  fvm_n1->node_data();
-    // fvm_node_data of node2
-    const FVM_NodeData * n2_data =  fvm_n2->node_data();
-
-    const unsigned int n1_local_offset = fvm_n1->local_offset();
-    const unsigned int n2_local_offset = fvm_n2->local_offset();
-
-    {
-      // electrostatic potential, as independent variable
-      PetscScalar V1   =  x[n1_local_offset];
-      PetscScalar eps1 =  n1_data->eps();
-
-
-      PetscScalar V2   =  x[n2_local_offset];
-      PetscScalar eps2 =  n2_data->eps();
-
-      PetscScalar eps = 0.5*(eps1+eps2);
-
-      // "flux" from node 2 to node 1
-      PetscScalar f =  eps*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
-
-      // ignore thoese ghost nodes
-      if( fvm_n1->on_processor() )
-      {
-        iy.push_back(fvm_n1->global_offset());
-        y.push_back(f);
-      }
-
-      if( fvm_n2->on_processor() )
-      {
-        iy.push_back(fvm_n2->global_offset());
-        y.push_back(-f);
-      }
-    }
-  }
+  FVM_EdgeAssembly::function(*this, FVM_EdgeAssembly::PoissonFlux(*this), x, iy, y);
 
   if(iy.size()) VecSetValues(f, iy.size(), &iy[0], &y[0], ADD_VALUES);
 
@@ -164,62 +121,10 @@ void ElectrodeSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, InsertM
     MatAssemblyEnd(*jac, MAT_FLUSH_ASSEMBLY);
   }
 
-  //the indepedent variable number, since we only process edges, 2 is enough
-  adtl::AutoDScalar::numdir=2;
-
-  //synchronize with material database
-  mt->set_ad_num(adtl::AutoDScalar::numdir);
 
 
   // search all the edges of this region, do integral over control volume...
-  const_edge_iterator it = edges_begin();
-  const_edge_iterator it_end = edges_end();
-  for(; it!=it_end; ++it)
-  {
-    // fvm_node of node1
-    const FVM_Node * fvm_n1 = (*it).first;
-    // fvm_node of node2
-    const FVM_Node * fvm_n2 = (*it).second;
-
-    // fvm_node_data of node1
-    const FVM_NodeData * n1_data =  fvm_n1->node_data();
-    // fvm_node_data of node2
-    const FVM_NodeData * n2_data =  fvm_n2->node_data();
-
-    const unsigned int n1_local_offset = fvm_n1->local_offset();
-    const unsigned int n2_local_offset = fvm_n2->local_offset();
-
-    // the row/colume position of variables in the matrix
-    PetscInt row[2],col[2];
-    row[0] = col[0] = fvm_n1->global_offset();
-    row[1] = col[1] = fvm_n2->global_offset();
-
-    // here we use AD, however it is great overkill for such a simple problem.
-    {
-      // electrostatic potential, as independent variable
-      AutoDScalar V1   =  x[n1_local_offset];   V1.setADValue(0,1.0);
-      PetscScalar eps1 =  n1_data->eps();
-
-
-      AutoDScalar V2   =  x[n2_local_offset];   V2.setADValue(1,1.0);
-      PetscScalar eps2 =  n2_data->eps();
-
-      PetscScalar eps = 0.5*(eps1+eps2);
-
-      AutoDScalar f =  eps*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
-
-      // ignore thoese ghost nodes
-      if( fvm_n1->on_processor() )
-      {
-        MatSetValues(*jac, 1, &row[0], 2, &col[0], f.getADValue(), ADD_VALUES);
-      }
-
-      if( fvm_n2->on_processor() )
-      {
-        MatSetValues(*jac, 1, &row[1], 2, &col[0], (-f).getADValue(), ADD_VALUES);
-      }
-    }
-  }
+  FVM_EdgeAssembly::poisson_jacobian(*this, jac);
 
 
   // boundary condition should be processed later!
@@ -199,11 +199,11 @@ void MetalSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, InsertMode
     // here we use AD, however it is great overkill for such a simple problem.
     {
       // electrostatic potential, as independent variable
-      AutoDScalar V1   =  x[n1_local_offset];   V1.setADValue(0,1.0);
-      AutoDScalar V2   =  x[n2_local_offset];   V2.setADValue(1,1.0);
+      AutoDScalar2 V1   =  x[n1_local_offset];   V1.setADValue(0,1.0);
+      AutoDScalar2 V2   =  x[n2_local_offset];   V2.setADValue(1,1.0);
 
 
-      AutoDScalar f =  sigma*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
+      AutoDScalar2 f =  sigma*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
 
       // ignore thoese ghost nodes
       if( fvm_n1->on_processor() )
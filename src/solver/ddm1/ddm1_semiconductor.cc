@@ -24,6 +24,7 @@
 #include "elem.h"
 #include "simulation_system.h"
 #include "semiconductor_region.h"
+#include "fvm_node_data_semiconductor.h"
 #include "solver_specify.h"
 
 #include "log.h"
@@ -37,6 +38,47 @@ using PhysicalUnit::A;
 using PhysicalUnit::um;
 using PhysicalUnit::cm;
 
+
+// accumulate the AD derivatives of one equation into the dense cell block
+static inline void add_to_cell_block(std::vector<PetscScalar> &block, unsigned int row, const PetscScalar *v, unsigned int n)
+{
+  PetscScalar * r = &block[row*n];
+  for(unsigned int j=0; j<n; ++j)
+    r[j] += v[j];
+}
+
+/**
+ * add AD gradient with only local directions to row of the dense cell block,
+ * direction j of the gradient goes to column cols[j] of the cell block
+ */
+static inline void add_to_cell_block(std::vector<PetscScalar> &block, unsigned int row, const PetscScalar *v, unsigned int n,
+                                     const unsigned int *cols, unsigned int n_dir)
+{
+  if( !cols ) { add_to_cell_block(block, row, v, n); return; }
+  PetscScalar * r = &block[row*n];
+  for(unsigned int j=0; j<n_dir; ++j)
+    r[cols[j]] += v[j];
+}
+
+/**
+ * impact ionization coefficient of driving force F for the jacobian. with SolverSpecify::IIProjectedJacobian,
+ * the PMI is evaluated in scalar and its derivative is projected on F: alpha(F0) + alpha'(F0)*(F-F0),
+ * alpha' by a central difference, instead of carrying all the AD directions of the cell through the PMI
+ */
+static inline AutoDScalar ii_rate(const PMIS_Avalanche * gen, bool electron, PetscScalar T, const AutoDScalar &F, PetscScalar Eg)
+{
+  if( !SolverSpecify::IIProjectedJacobian )
+    return electron ? gen->ElecGenRate(T, F, Eg) : gen->HoleGenRate(T, F, Eg);
+
+  const PetscScalar F0 = F.getValue();
+  const PetscScalar h  = 1e-4*F0 + 1e-3*V/cm;
+  const PetscScalar a0 = electron ? gen->ElecGenRate(T, F0, Eg) : gen->HoleGenRate(T, F0, Eg);
+  const PetscScalar a1 = electron ? gen->ElecGenRate(T, F0+h, Eg) : gen->HoleGenRate(T, F0+h, Eg);
+  const PetscScalar a2 = electron ? gen->ElecGenRate(T, std::max(F0-h, 0.0), Eg) : gen->HoleGenRate(T, std::max(F0-h, 0.0), Eg);
+  const PetscScalar da = (a1 - a2)/(F0 + h - std::max(F0-h, 0.0));
+  return a0 + da*(F - F0);
+}
+
 //#define DEBUG
 
 
@@ -47,6 +89,9 @@ using PhysicalUnit::cm;
 
 void SemiconductorSimulationRegion::DDM1_Fill_Value(Vec x, Vec L)
 {
+  // the lattice temperature is fixed in DDM1, the field independent material quantities are evaluated once
+  update_material_cache(true);
+
   std::vector<int> ix;
   std::vector<PetscScalar> y;
   std::vector<PetscScalar> s;
@@ -88,10 +133,188 @@ void SemiconductorSimulationRegion::DDM1_Fill_Value(Vec x, Vec L)
 }
 
 
+/*---------------------------------------------------------------------
+ * gather the node values of DDM1 function, on processor nodes first and then the ghost nodes
+ */
+void SemiconductorSimulationRegion::DDM1_Fill_Node_Cache(PetscScalar * x, bool ghost)
+{
+  const PetscScalar T   = T_external();
+  const PetscScalar Vt  = kb*T/e;
+
+  const unsigned int n_local_node = on_local_nodes_end() - on_local_nodes_begin();
+  if( !ghost )
+  {
+    _ddm1_node_cache.V.resize(n_local_node);
+    _ddm1_node_cache.n.resize(n_local_node);
+    _ddm1_node_cache.p.resize(n_local_node);
+    _ddm1_node_cache.eps.resize(n_local_node);
+    _ddm1_node_cache.Ec.resize(n_local_node);
+    _ddm1_node_cache.Ev.resize(n_local_node);
+  }
+
+  // NOTE: Here Ec, Ev are not the conduction/valence band energy.
+  // They are here for the calculation of effective driving field for electrons and holes
+  // They differ from the conduction/valence band energy by the term with kb*T*log(Nc or Nv), which
+  // takes care of the change effective DOS.
+  // Ec/Ev should not be used except when its difference between two nodes.
+  // They only depend on the node, so evaluate them once per node here.
+  // the nodes of this pass are gathered first, and nie is evaluated by one batch call of the material.
+  // material evaluation is not reentrant, this loop is kept serial.
+  DDM1NodeCache & cache = _ddm1_node_cache;
+  cache.batch_index.clear();
+  cache.batch_context.clear();
+  cache.batch_n.clear();
+  cache.batch_p.clear();
+
+  const_local_node_iterator node_it = on_local_nodes_begin();
+  const_local_node_iterator node_it_end = on_local_nodes_end();
+  for(unsigned int k=0; node_it!=node_it_end; ++node_it, ++k)
+  {
+    const FVM_Node * fvm_node = *node_it;
+    if( fvm_node->on_processor() == ghost ) continue;
+
+    const FVM_NodeData * node_data = fvm_node->node_data();
+    const unsigned int local_offset = fvm_node->local_offset();
+
+    cache.V[k]   = x[local_offset+0];                  // electrostatic potential
+    cache.n[k]   = x[local_offset+1];                  // electron density
+    cache.p[k]   = x[local_offset+2];                  // hole density
+    cache.eps[k] = node_data->eps();
+
+    cache.batch_index.push_back(k);
+    cache.batch_context.push_back(PMI_Context(fvm_node->root_node(), node_data, SolverSpecify::clock));
+    cache.batch_n.push_back(cache.n[k]);
+    cache.batch_p.push_back(cache.p[k]);
+  }
+
+  const unsigned int n_batch = cache.batch_index.size();
+  if( !n_batch ) return;
+
+  cache.batch_T.assign(n_batch, T);
+  cache.batch_nie.resize(n_batch);
+  mt->band->nie_batch(n_batch, &cache.batch_context[0], &cache.batch_p[0], &cache.batch_n[0], &cache.batch_T[0], &cache.batch_nie[0]);
+
+  for(unsigned int i=0; i<n_batch; ++i)
+  {
+    const unsigned int k = cache.batch_index[i];
+    const FVM_NodeData * node_data = cache.batch_context[i].node_data;
+
+    const PetscScalar V   =  cache.V[k];
+    const PetscScalar n   =  cache.n[k];
+    const PetscScalar p   =  cache.p[k];
+    const PetscScalar nie =  cache.batch_nie[i];
+
+    PetscScalar Ec =  -(e*V + node_data->affinity() + kb*T*log(nie));
+    PetscScalar Ev =  -(e*V + node_data->affinity() - kb*T*log(nie));
+    if(get_advanced_model()->Fermi)
+    {
+      Ec = Ec - e*Vt*log(gamma_f(fabs(n)/node_data->Nc()));
+      Ev = Ev + e*Vt*log(gamma_f(fabs(p)/node_data->Nv()));
+    }
+    cache.Ec[k]  = Ec;
+    cache.Ev[k]  = Ev;
+  }
+
+  // leave the material mapped to the last node, as the per node loop did
+  const PMI_Context & last = cache.batch_context[n_batch-1];
+  mt->mapping(last);
+}
+
+
+/*---------------------------------------------------------------------
+ * gather the node values of DDM1 jacobian, on processor nodes first and then the ghost nodes
+ */
+void SemiconductorSimulationRegion::DDM1_Fill_Node_AD_Cache(PetscScalar * x, bool ghost)
+{
+  const PetscScalar T   = T_external();
+  const PetscScalar Vt  = kb*T/e;
+
+  const unsigned int n_local_node = on_local_nodes_end() - on_local_nodes_begin();
+  if( !ghost )
+  {
+    _ddm1_node_cache.n.resize(n_local_node);
+    _ddm1_node_cache.p.resize(n_local_node);
+    _ddm1_node_cache.eps.resize(n_local_node);
+    _ddm1_node_cache.Ec_ad.resize(n_local_node);
+    _ddm1_node_cache.Ev_ad.resize(n_local_node);
+  }
+
+  //the indepedent variable number, 3 variables per node
+  adtl::AutoDScalar::numdir = 3;
+
+  //synchronize with material database
+  mt->set_ad_num(adtl::AutoDScalar::numdir);
+
+  // material evaluation is not reentrant, this loop is kept serial.
+  const_local_node_iterator node_it = on_local_nodes_begin();
+  const_local_node_iterator node_it_end = on_local_nodes_end();
+  for(unsigned int k=0; node_it!=node_it_end; ++node_it, ++k)
+  {
+    const FVM_Node * fvm_node = *node_it;
+    if( fvm_node->on_processor() == ghost ) continue;
+
+    const FVM_NodeData * node_data = fvm_node->node_data();
+    const unsigned int local_offset = fvm_node->local_offset();
+
+    mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);
+
+    AutoDScalar V   =  x[local_offset+0];   V.setADValue(0, 1.0);               // electrostatic potential
+    AutoDScalar n   =  x[local_offset+1];   n.setADValue(1, 1.0);               // electron density
+    AutoDScalar p   =  x[local_offset+2];   p.setADValue(2, 1.0);               // hole density
+
+    // NOTE: Here Ec, Ev are not the conduction/valence band energy.
+    // They are here for the calculation of effective driving field for electrons and holes
+    // They differ from the conduction/valence band energy by the term with kb*T*log(Nc or Nv), which
+    // takes care of the change effective DOS.
+    // Ec/Ev should not be used except when its difference between two nodes.
+    AutoDScalar Ec =  -(e*V + node_data->affinity() + kb*T*log(mt->band->nie(p, n, T)) );
+    AutoDScalar Ev =  -(e*V + node_data->affinity() - kb*T*log(mt->band->nie(p, n, T)) );
+    if(get_advanced_model()->Fermi)
+    {
+      Ec = Ec - e*Vt*log(gamma_f(fabs(n)/node_data->Nc()));
+      Ev = Ev + e*Vt*log(gamma_f(fabs(p)/node_data->Nv()));
+    }
+    _ddm1_node_cache.n[k]     = x[local_offset+1];
+    _ddm1_node_cache.p[k]     = x[local_offset+2];
+    _ddm1_node_cache.eps[k]   = node_data->eps();
+    _ddm1_node_cache.Ec_ad[k] = AutoDScalar6(Ec);
+    _ddm1_node_cache.Ev_ad[k] = AutoDScalar6(Ev);
+  }
+}
+
+
+/*---------------------------------------------------------------------
+ * the node values only need on processor dofs, evaluate them before ghost dofs arrive
+ */
+void SemiconductorSimulationRegion::DDM1_Function_Interior(PetscScalar * x)
+{
+  DDM1_Fill_Node_Cache(x, false);
+  _ddm1_node_cache.value_ready = true;
+}
+
+
+void SemiconductorSimulationRegion::DDM1_Jacobian_Interior(PetscScalar * x)
+{
+  DDM1_Fill_Node_AD_Cache(x, false);
+  _ddm1_node_cache.ad_ready = true;
+}
+
+
+
 /*---------------------------------------------------------------------
  * build function and its jacobian for DDML1 solver
  */
 void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, InsertMode &add_value_flag)
+{
+  this->DDM1_Function_Kernel(0, x, f, add_value_flag);
+}
+
+
+/*---------------------------------------------------------------------
+ * the DDML1 function kernel, also used by HALL solver.
+ * when B is given, the magnetic field term of HALL solver is added to the continuity equations of each cell
+ */
+void SemiconductorSimulationRegion::DDM1_Function_Kernel(const VectorValue<double> * B, PetscScalar * x, Vec f, InsertMode &add_value_flag)
 {
 
   // note, we will use ADD_VALUES to set values of vec f
@@ -116,95 +339,82 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
   bool  highfield_mob   = highfield_mobility() && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM;
 
   // precompute S-G current on each edge
-  std::vector<PetscScalar> Jn_edge_buffer;
-  std::vector<PetscScalar> Jp_edge_buffer;
+  RealArray Jn_edge_buffer(n_edge());
+  RealArray Jp_edge_buffer(n_edge());
   {
-    Jn_edge_buffer.reserve(n_edge());
-    Jp_edge_buffer.reserve(n_edge());
-
-    // search all the edges of this region
-    const_edge_iterator it = edges_begin();
-    const_edge_iterator it_end = edges_end();
-    for(; it!=it_end; ++it)
+    // the node values used by the edge loop are gathered into arrays indexed by the
+    // position of the node in the local node list, the same index used by edge_arrays().
+    // the on processor nodes may have been filled by DDM1_Function_Interior already
+    if( !_ddm1_node_cache.value_ready )
+      DDM1_Fill_Node_Cache(x, false);
+    DDM1_Fill_Node_Cache(x, true);
+    _ddm1_node_cache.value_ready = false;
+
+    const RealArray & V_node    = _ddm1_node_cache.V;
+    const RealArray & elec_node = _ddm1_node_cache.n;
+    const RealArray & hole_node = _ddm1_node_cache.p;
+    const RealArray & eps_node  = _ddm1_node_cache.eps;
+    const RealArray & Ec_node   = _ddm1_node_cache.Ec;
+    const RealArray & Ev_node   = _ddm1_node_cache.Ev;
+
+    // the edge loop only reads the node and edge arrays and writes the slot of its own edge,
+    // so it can be shared by threads without conflict.
+    const EdgeArrays & edge_data = edge_arrays();
+    RealArray f_edge_buffer(n_edge());
+    const int n_edges = n_edge();
+
+    // the edges are processed by blocks, the node values of a block are gathered into
+    // contiguous arrays and the S-G current of the whole block is evaluated at once
+    const int edge_block = 64;
+    const int n_edge_blocks = (n_edges + edge_block - 1)/edge_block;
+
+#pragma omp parallel for schedule(static) num_threads(Genius::n_threads())
+    for(int b=0; b<n_edge_blocks; ++b)
     {
-      // fvm_node of node1
-      const FVM_Node * fvm_n1 = (*it).first;
-      // fvm_node of node2
-      const FVM_Node * fvm_n2 = (*it).second;
+      const int begin = b*edge_block;
+      const int m = std::min(edge_block, n_edges - begin);
 
-      // fvm_node_data of node1
-      const FVM_NodeData * n1_data =  fvm_n1->node_data();
-      // fvm_node_data of node2
-      const FVM_NodeData * n2_data =  fvm_n2->node_data();
-
-      const unsigned int n1_local_offset = fvm_n1->local_offset();
-      const unsigned int n2_local_offset = fvm_n2->local_offset();
-
-      const double length = fvm_n1->distance(fvm_n2);
-
-      // build S-G current along edge
-
-      //for node 1 of the edge
-      mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-
-      const PetscScalar V1   =  x[n1_local_offset+0];                  // electrostatic potential
-      const PetscScalar n1   =  x[n1_local_offset+1];                  // electron density
-      const PetscScalar p1   =  x[n1_local_offset+2];                  // hole density
-
-      // NOTE: Here Ec1, Ev1 are not the conduction/valence band energy.
-      // They are here for the calculation of effective driving field for electrons and holes
-      // They differ from the conduction/valence band energy by the term with kb*T*log(Nc or Nv), which
-      // takes care of the change effective DOS.
-      // Ec/Ev should not be used except when its difference between two nodes.
-      // The same comment applies to Ec2/Ev2.
-      PetscScalar Ec1 =  -(e*V1 + n1_data->affinity() + kb*T*log(mt->band->nie(p1, n1, T)));
-      PetscScalar Ev1 =  -(e*V1 + n1_data->affinity() - kb*T*log(mt->band->nie(p1, n1, T)));
-      if(get_advanced_model()->Fermi)
+      PetscScalar dEc[edge_block], dEv[edge_block];
+      PetscScalar n1[edge_block], n2[edge_block], p1[edge_block], p2[edge_block];
+      for(int j=0; j<m; ++j)
       {
-        Ec1 = Ec1 - e*Vt*log(gamma_f(fabs(n1)/n1_data->Nc()));
-        Ev1 = Ev1 + e*Vt*log(gamma_f(fabs(p1)/n1_data->Nv()));
-      }
-      const PetscScalar eps1 =  n1_data->eps();
+        const int i = begin + j;
+        const unsigned int k1 = edge_data.node1[i];
+        const unsigned int k2 = edge_data.node2[i];
 
-      //for node 2 of the edge
-      mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
+        dEc[j] = (Ec_node[k2]-Ec_node[k1])/e;
+        dEv[j] = (Ev_node[k2]-Ev_node[k1])/e;
+        n1[j] = elec_node[k1];  n2[j] = elec_node[k2];
+        p1[j] = hole_node[k1];  p2[j] = hole_node[k2];
 
-      PetscScalar V2   =  x[n2_local_offset+0];                   // electrostatic potential
-      PetscScalar n2   =  x[n2_local_offset+1];                   // electron density
-      PetscScalar p2   =  x[n2_local_offset+2];                   // hole density
+        // poisson's equation
+        PetscScalar eps = 0.5*(eps_node[k1]+eps_node[k2]);
 
-      PetscScalar Ec2 =  -(e*V2 + n2_data->affinity() + kb*T*log(mt->band->nie(p2, n2, T)));
-      PetscScalar Ev2 =  -(e*V2 + n2_data->affinity() - kb*T*log(mt->band->nie(p2, n2, T)));
-      if(get_advanced_model()->Fermi)
-      {
-        Ec2 = Ec2 - e*Vt*log(gamma_f(fabs(n2)/n2_data->Nc()));
-        Ev2 = Ev2 + e*Vt*log(gamma_f(fabs(p2)/n2_data->Nv()));
+        // "flux" from node 2 to node 1
+        f_edge_buffer[i] =  eps*edge_data.area[i]*(V_node[k2] - V_node[k1])/edge_data.length[i] ;
       }
-      const PetscScalar eps2 =  n2_data->eps();
-
-      // S-G current along the edge
-      Jn_edge_buffer.push_back( In_dd(Vt,(Ec2-Ec1)/e,n1,n2,length) );
-      Jp_edge_buffer.push_back( Ip_dd(Vt,(Ev2-Ev1)/e,p1,p2,length) );
-
-
-      // poisson's equation
 
-      PetscScalar eps = 0.5*(eps1+eps2);
+      // S-G current along the edges
+      In_dd_batch(m, Vt, dEc, n1, n2, &edge_data.length[begin], &Jn_edge_buffer[begin]);
+      Ip_dd_batch(m, Vt, dEv, p1, p2, &edge_data.length[begin], &Jp_edge_buffer[begin]);
+    }
 
-      // "flux" from node 2 to node 1
-      PetscScalar f =  eps*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
+    // flush the poisson "flux" in edge order
+    for(int i=0; i<n_edges; ++i)
+    {
+      const std::pair<FVM_Node *, FVM_Node *> & edge = *(edges_begin() + i);
 
       // ignore thoese ghost nodes
-      if( fvm_n1->on_processor() )
+      if( edge.first->on_processor() )
       {
-        iy.push_back(fvm_n1->global_offset());
-        y.push_back(f);
+        iy.push_back(edge.first->global_offset());
+        y.push_back(f_edge_buffer[i]);
       }
 
-      if( fvm_n2->on_processor() )
+      if( edge.second->on_processor() )
       {
-        iy.push_back(fvm_n2->global_offset());
-        y.push_back(-f);
+        iy.push_back(edge.second->global_offset());
+        y.push_back(-f_edge_buffer[i]);
       }
     }
   }
@@ -213,20 +423,27 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
   // note, they are all local element, thus must be processed
 
 
+  const CellEdgeArrays & cell_edges = this->cell_edge_arrays();
+
+  // the current along each cell edge, the cell current vectors are reconstructed after the cell loop
+  std::vector<PetscScalar> Jn_cell_edge(cell_edges.edge.size());
+  std::vector<PetscScalar> Jp_cell_edge(cell_edges.edge.size());
+
   const_element_iterator it = elements_begin();
   const_element_iterator it_end = elements_end();
   for(unsigned int nelem=0 ; it!=it_end; ++it, ++nelem)
   {
     const Elem * elem = *it;
 
-    FVM_CellData * elem_data = this->get_region_elem_data(nelem);
     bool insulator_interface_elem = is_elem_on_insulator_interface(elem);
     bool mos_channel_elem = is_elem_in_mos_channel(elem);
     bool truncation =  SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationAlways ||
         (SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationBoundary && (elem->on_boundary() || elem->on_interface())) ;
 
-    std::vector<PetscScalar> Jn_edge_cell; //store all the edge Jn
-    std::vector<PetscScalar> Jp_edge_cell; //store all the edge Jp
+    std::vector<PetscScalar> Jn_edge_cell; //store all the edge Jn, only for HALL
+    std::vector<PetscScalar> Jp_edge_cell; //store all the edge Jp, only for HALL
+    std::vector<PetscScalar> mun_edge_cell; //store all the edge mun, only for HALL
+    std::vector<PetscScalar> mup_edge_cell; //store all the edge mup, only for HALL
 
     // E field parallel to current flow
     PetscScalar Epn=0;
@@ -283,9 +500,9 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
 
 
       // compute the gradient
-      E = - elem->gradient(psi_vertex);  // E = - grad(psi)
-      Jnv = - elem->gradient(phin_vertex); // we only need the direction of Jnv, here Jnv = - gradient of Fn
-      Jpv = - elem->gradient(phip_vertex); // Jpv = - gradient of Fp
+      E = - this->cell_gradient(nelem, &psi_vertex[0]);  // E = - grad(psi)
+      Jnv = - this->cell_gradient(nelem, &phin_vertex[0]); // we only need the direction of Jnv, here Jnv = - gradient of Fn
+      Jpv = - this->cell_gradient(nelem, &phip_vertex[0]); // Jpv = - gradient of Fp
     }
 
     if(highfield_mob)
@@ -379,24 +596,24 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
 
     // process \nabla psi and S-G current along the cell's edge
     // search for all the edges this cell own
-    for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
+    // the edge geometry of this cell is read from the flattened cell edge arrays
+    for(unsigned int ce=cell_edges.begin[nelem]; ce<cell_edges.begin[nelem+1]; ++ce )
     {
-      std::pair<unsigned int, unsigned int> edge_nodes;
-      elem->nodes_on_edge(ne, edge_nodes);
+      const std::pair<unsigned int, unsigned int> edge_nodes(cell_edges.node1[ce], cell_edges.node2[ce]);
 
-      const unsigned int edge_index = this->elem_edge_index(elem, ne);
+      const unsigned int edge_index = cell_edges.edge[ce];
 
-      const double length = elem->edge_length(ne);                         // the length of this edge
+      const double length = cell_edges.length[ce];                         // the length of this edge
 
-      double partial_area = elem->partial_area_with_edge(ne);        // partial area associated with this edge
-      double partial_volume = elem->partial_volume_with_edge(ne);    // partial volume associated with this edge
+      double partial_area = cell_edges.area[ce];        // partial area associated with this edge
+      double partial_volume = cell_edges.volume[ce];    // partial volume associated with this edge
 
       double truncated_partial_area =  partial_area;
       double truncated_partial_volume =  partial_volume;
       if(truncation)
       {
-        truncated_partial_area =  elem->partial_area_with_edge_truncated(ne);
-        truncated_partial_volume =  elem->partial_volume_with_edge_truncated(ne);
+        truncated_partial_area =  cell_edges.area_truncated[ce];
+        truncated_partial_volume =  cell_edges.volume_truncated[ce];
       }
 
       const FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);   // fvm_node of node1
@@ -478,8 +695,15 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
         PetscScalar Jn =  mun*(inverse ? -Jn_edge_buffer[edge_index] : Jn_edge_buffer[edge_index]);
         PetscScalar Jp =  mup*(inverse ? -Jp_edge_buffer[edge_index] : Jp_edge_buffer[edge_index]);
 
-        Jn_edge_cell.push_back(Jn);
-        Jp_edge_cell.push_back(Jp);
+        Jn_cell_edge[ce] = Jn;
+        Jp_cell_edge[ce] = Jp;
+        if(B)
+        {
+          Jn_edge_cell.push_back(Jn);
+          Jp_edge_cell.push_back(Jp);
+          mun_edge_cell.push_back(mun);
+          mup_edge_cell.push_back(mup);
+        }
 
 
         // ignore thoese ghost nodes (ghost nodes is local but with different processor_id())
@@ -605,12 +829,16 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
         }
       }
     }
-    // the average cell electron/hole current density vector
-    elem_data->Jn() = -elem->reconstruct_vector(Jn_edge_cell);
-    elem_data->Jp() =  elem->reconstruct_vector(Jp_edge_cell);
+    // magnetic field term of HALL solver
+    if(B)
+      HALL_Cell_Function(*B, elem, nelem, truncation, mun_edge_cell, mup_edge_cell, Jn_edge_cell, Jp_edge_cell, iy, y);
 
   }
 
+  // the average cell electron/hole current density vector
+  if( !Jn_cell_edge.empty() )
+    this->update_cell_fields(0, &Jn_cell_edge[0], &Jp_cell_edge[0]);
+
 
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
@@ -656,10 +884,26 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
     y.push_back( rho + pesudo_Vs );                                                       // save value in the buffer
     y.push_back( R + Field_G + node_data->EIn());
     y.push_back( R + Field_G + node_data->HIn());
+  }
 
-
-    if (get_advanced_model()->Trap)
+  // bulk trap terms, only the nodes which carry traps are visited
+  if (get_advanced_model()->Trap)
+  {
+    const std::vector<FVM_Node *> & nodes_with_trap = trap_nodes();
+    for(unsigned int i=0; i<nodes_with_trap.size(); ++i)
     {
+      const FVM_Node * fvm_node = nodes_with_trap[i];
+      if( !fvm_node->on_processor() ) continue;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+
+      const unsigned int local_offset  = fvm_node->local_offset();
+      const unsigned int global_offset = fvm_node->global_offset();
+
+      PetscScalar n   =  x[local_offset+1];                         // electron density
+      PetscScalar p   =  x[local_offset+2];                         // hole density
+
+      mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);      // map this node and its data to material database
+
       // consider charge trapping in semiconductor bulk (bulk_flag=true)
 
       // call the Trap MPI to calculate trap occupancy using the local carrier densities and lattice temperature
@@ -717,6 +961,16 @@ void SemiconductorSimulationRegion::DDM1_Function(PetscScalar * x, Vec f, Insert
  * AD is fully used here
  */
 void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, InsertMode &add_value_flag)
+{
+  this->DDM1_Jacobian_Kernel(0, x, jac, add_value_flag);
+}
+
+
+/*---------------------------------------------------------------------
+ * the DDML1 jacobian kernel, also used by HALL solver.
+ * when B is given, the jacobian of magnetic field term is added to the cell block
+ */
+void SemiconductorSimulationRegion::DDM1_Jacobian_Kernel(const VectorValue<double> * B, PetscScalar * x, Mat *jac, InsertMode &add_value_flag)
 {
   // note, we will use ADD_VALUES to set values of matrix J
   // if the previous operator is not ADD_VALUES, we should flush the matrix
@@ -732,114 +986,139 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
   bool  highfield_mob   = highfield_mobility() && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM;
 
   // precompute S-G current on each edge
-  std::vector<AutoDScalar> Jn_edge_buffer;
-  std::vector<AutoDScalar> Jp_edge_buffer;
+  // the edge current only depends on 6 independent variables, store it with the narrow AD type
+  AD6Array Jn_edge_buffer(n_edge());
+  AD6Array Jp_edge_buffer(n_edge());
   {
-    Jn_edge_buffer.reserve(n_edge());
-    Jp_edge_buffer.reserve(n_edge());
-
-    //the indepedent variable number, 2 nodes * 3 variables per edge
-    adtl::AutoDScalar::numdir = 6;
-
-    //synchronize with material database
-    mt->set_ad_num(adtl::AutoDScalar::numdir);
-
-    // search all the edges of this region
-    const_edge_iterator it = edges_begin();
-    const_edge_iterator it_end = edges_end();
-    for(; it!=it_end; ++it)
+    // the effective band edges only depend on the 3 variables of the node, they are evaluated once per node
+    // and gathered into arrays indexed by the position of the node in the local node list,
+    // the same index used by edge_arrays().
+    // the on processor nodes may have been filled by DDM1_Jacobian_Interior already
+    if( !_ddm1_node_cache.ad_ready )
+      DDM1_Fill_Node_AD_Cache(x, false);
+    DDM1_Fill_Node_AD_Cache(x, true);
+    _ddm1_node_cache.ad_ready = false;
+
+    const RealArray & elec_node = _ddm1_node_cache.n;
+    const RealArray & hole_node = _ddm1_node_cache.p;
+    const RealArray & eps_node  = _ddm1_node_cache.eps;
+    const AD6Array  & Ec_node   = _ddm1_node_cache.Ec_ad;
+    const AD6Array  & Ev_node   = _ddm1_node_cache.Ev_ad;
+
+    // the edge loop only reads the node and edge arrays and writes the slot of its own edge,
+    // so it can be shared by threads without conflict.
+    const EdgeArrays & edge_data = edge_arrays();
+    RealArray f_edge_buffer(n_edge());
+    const int n_edges = n_edge();
+
+#pragma omp parallel num_threads(Genius::n_threads())
     {
-      // fvm_node of node1
-      const FVM_Node * fvm_n1 = (*it).first;
-      // fvm_node of node2
-      const FVM_Node * fvm_n2 = (*it).second;
-
-      // fvm_node_data of node1
-      const FVM_NodeData * n1_data =  fvm_n1->node_data();
-      // fvm_node_data of node2
-      const FVM_NodeData * n2_data =  fvm_n2->node_data();
-
-      const unsigned int n1_local_offset = fvm_n1->local_offset();
-      const unsigned int n2_local_offset = fvm_n2->local_offset();
-
-      const double length = fvm_n1->distance(fvm_n2);
+      //the indepedent variable number, 2 nodes * 3 variables per edge.
+      //numdir is thread local, each thread should set it
+      adtl::AutoDScalar::numdir = 6;
 
-      // build S-G current along edge
+      // the variables of node 2 are shifted to the position 3-5
+      unsigned int n2_order[3] = {3, 4, 5};
 
+      // the edges are processed by blocks. the S-G current and its gradient to the band edge
+      // difference and the densities are evaluated for the whole block at once, then the
+      // AD of the edge current is assembled by the chain rule
+      const int edge_block = 64;
+      const int n_edge_blocks = (n_edges + edge_block - 1)/edge_block;
 
-      //for node 1 of the edge
-      mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-
-      AutoDScalar V1   =  x[n1_local_offset+0];   V1.setADValue(0, 1.0);               // electrostatic potential
-      AutoDScalar n1   =  x[n1_local_offset+1];   n1.setADValue(1, 1.0);               // electron density
-      AutoDScalar p1   =  x[n1_local_offset+2];   p1.setADValue(2, 1.0);               // hole density
-
-      // NOTE: Here Ec1, Ev1 are not the conduction/valence band energy.
-      // They are here for the calculation of effective driving field for electrons and holes
-      // They differ from the conduction/valence band energy by the term with kb*T*log(Nc or Nv), which
-      // takes care of the change effective DOS.
-      // Ec/Ev should not be used except when its difference between two nodes.
-      // The same comment applies to Ec2/Ev2.
-      AutoDScalar Ec1 =  -(e*V1 + n1_data->affinity() + kb*T*log(mt->band->nie(p1, n1, T)) );
-      AutoDScalar Ev1 =  -(e*V1 + n1_data->affinity() - kb*T*log(mt->band->nie(p1, n1, T)) );
-      if(get_advanced_model()->Fermi)
+#pragma omp for schedule(static)
+      for(int b=0; b<n_edge_blocks; ++b)
       {
-        Ec1 = Ec1 - e*Vt*log(gamma_f(fabs(n1)/n1_data->Nc()));
-        Ev1 = Ev1 + e*Vt*log(gamma_f(fabs(p1)/n1_data->Nv()));
-      }
-      const PetscScalar eps1 =  n1_data->eps();
+        const int begin = b*edge_block;
+        const int m = std::min(edge_block, n_edges - begin);
 
-      //for node 2 of the edge
-      mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
+        PetscScalar dEc[edge_block], dEv[edge_block];
+        PetscScalar n1[edge_block], n2[edge_block], p1[edge_block], p2[edge_block];
+        for(int j=0; j<m; ++j)
+        {
+          const int i = begin + j;
+          const unsigned int k1 = edge_data.node1[i];
+          const unsigned int k2 = edge_data.node2[i];
+
+          dEc[j] = (Ec_node[k2].getValue()-Ec_node[k1].getValue())/e;
+          dEv[j] = (Ev_node[k2].getValue()-Ev_node[k1].getValue())/e;
+          n1[j] = elec_node[k1];  n2[j] = elec_node[k2];
+          p1[j] = hole_node[k1];  p2[j] = hole_node[k2];
+
+          // poisson's equation, the "flux" is linear to V1 and V2
+          const PetscScalar eps = 0.5*(eps_node[k1]+eps_node[k2]);
+          f_edge_buffer[i] = eps*edge_data.area[i]/edge_data.length[i];
+        }
 
-      AutoDScalar V2   =  x[n2_local_offset+0];   V2.setADValue(3, 1.0);                // electrostatic potential
-      AutoDScalar n2   =  x[n2_local_offset+1];   n2.setADValue(4, 1.0);                // electron density
-      AutoDScalar p2   =  x[n2_local_offset+2];   p2.setADValue(5, 1.0);                // hole density
+        PetscScalar Jn[edge_block], dJn_dV[edge_block], dJn_dn1[edge_block], dJn_dn2[edge_block];
+        PetscScalar Jp[edge_block], dJp_dV[edge_block], dJp_dp1[edge_block], dJp_dp2[edge_block];
+        In_dd_batch(m, Vt, dEc, n1, n2, &edge_data.length[begin], Jn, dJn_dV, dJn_dn1, dJn_dn2);
+        Ip_dd_batch(m, Vt, dEv, p1, p2, &edge_data.length[begin], Jp, dJp_dV, dJp_dp1, dJp_dp2);
 
-      AutoDScalar Ec2 =  -(e*V2 + n2_data->affinity() + kb*T*log(mt->band->nie(p2, n2, T)) );
-      AutoDScalar Ev2 =  -(e*V2 + n2_data->affinity() - kb*T*log(mt->band->nie(p2, n2, T)) );
-      if(get_advanced_model()->Fermi)
-      {
-        Ec2 = Ec2 - e*Vt*log(gamma_f(fabs(n2)/n2_data->Nc()));
-        Ev2 = Ev2 + e*Vt*log(gamma_f(fabs(p2)/n2_data->Nv()));
+        for(int j=0; j<m; ++j)
+        {
+          const int i = begin + j;
+          const unsigned int k1 = edge_data.node1[i];
+          const unsigned int k2 = edge_data.node2[i];
+
+          AutoDScalar Ec1(Ec_node[k1]);
+          AutoDScalar Ev1(Ev_node[k1]);
+          AutoDScalar Ec2(Ec_node[k2], n2_order, 3);
+          AutoDScalar Ev2(Ev_node[k2], n2_order, 3);
+
+          // S-G current along the edge, the band edges carry the derivatives to V, n and p of both nodes
+          AutoDScalar In = (Ec2-Ec1)/e*dJn_dV[j];
+          In.setValue(Jn[j]);
+          In.setADValue(1, In.getADValue(1) + dJn_dn1[j]);
+          In.setADValue(4, In.getADValue(4) + dJn_dn2[j]);
+
+          AutoDScalar Ip = (Ev2-Ev1)/e*dJp_dV[j];
+          Ip.setValue(Jp[j]);
+          Ip.setADValue(2, Ip.getADValue(2) + dJp_dp1[j]);
+          Ip.setADValue(5, Ip.getADValue(5) + dJp_dp2[j]);
+
+          Jn_edge_buffer[i] = AutoDScalar6(In);
+          Jp_edge_buffer[i] = AutoDScalar6(Ip);
+        }
       }
-      const PetscScalar eps2 =  n2_data->eps();
-
-      // S-G current along the edge
-      Jn_edge_buffer.push_back( In_dd(Vt,(Ec2-Ec1)/e,n1,n2,length) );
-      Jp_edge_buffer.push_back( Ip_dd(Vt,(Ev2-Ev1)/e,p1,p2,length) );
-
-      // poisson's equation
+    }
 
-      const PetscScalar eps = 0.5*(eps1+eps2);
-      AutoDScalar f_phi =  eps*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
+    // flush the jacobian of poisson's equation in edge order
+    for(int i=0; i<n_edges; ++i)
+    {
+      const std::pair<FVM_Node *, FVM_Node *> & edge = *(edges_begin() + i);
 
       PetscInt row[2],col[2];
-      row[0] = col[0] = fvm_n1->global_offset();
-      row[1] = col[1] = fvm_n2->global_offset();
+      row[0] = col[0] = edge.first->global_offset();
+      row[1] = col[1] = edge.second->global_offset();
 
       // ignore thoese ghost nodes
-      if( fvm_n1->on_processor() )
+      if( edge.first->on_processor() )
       {
-        MatSetValue(*jac, row[0], col[0], f_phi.getADValue(0), ADD_VALUES);
-        MatSetValue(*jac, row[0], col[1], f_phi.getADValue(3), ADD_VALUES);
+        MatSetValue(*jac, row[0], col[0], -f_edge_buffer[i], ADD_VALUES);
+        MatSetValue(*jac, row[0], col[1],  f_edge_buffer[i], ADD_VALUES);
       }
 
-      if( fvm_n2->on_processor() )
+      if( edge.second->on_processor() )
       {
-        MatSetValue(*jac, row[1], col[0], -f_phi.getADValue(0), ADD_VALUES);
-        MatSetValue(*jac, row[1], col[1], -f_phi.getADValue(3), ADD_VALUES);
+        MatSetValue(*jac, row[1], col[0],  f_edge_buffer[i], ADD_VALUES);
+        MatSetValue(*jac, row[1], col[1], -f_edge_buffer[i], ADD_VALUES);
       }
-
     }
   }
 
+  // the cell blocks can be added directly by precomputed slots after the first assembly of the matrix
+  MatSlotMap * slot_map = MatSlotMap::get(*jac);
+  if( slot_map && !slot_map->active() ) slot_map = 0;
+
   // search all the element in this region.
   // note, they are all local element, thus must be processed
 
+  const CellEdgeArrays & cell_edges = this->cell_edge_arrays();
+
   const_element_iterator it = elements_begin();
   const_element_iterator it_end = elements_end();
-  for(; it!=it_end; ++it)
+  for(unsigned int nelem=0; it!=it_end; ++it, ++nelem)
   {
     const Elem * elem = *it;
     bool insulator_interface_elem = is_elem_on_insulator_interface(elem);
@@ -847,6 +1126,14 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
     bool truncation =  SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationAlways ||
         (SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationBoundary && (elem->on_boundary() || elem->on_interface())) ;
 
+    // when the edge flux only depends on the two nodes of the edge (no E field or current direction of the cell
+    // is used by mobility, band-band tunneling, impact ionization and magnetic field), the AD of each edge only carries the
+    // 6 variables of its two nodes, and the gradient is scattered into the cell block.
+    bool local_edge_ad = !B &&
+                         !(highfield_mob && (get_advanced_model()->Mob_Force != ModelSpecify::ESimple || insulator_interface_elem || mos_channel_elem)) &&
+                         !(get_advanced_model()->BandBandTunneling && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM) &&
+                         !(get_advanced_model()->ImpactIonization && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM);
+
     //the indepedent variable number, 3*n_nodes
     adtl::AutoDScalar::numdir = 3*elem->n_nodes();
 
@@ -880,7 +1167,7 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
     AutoDScalar Etp(0);
 
     // evaluate E field parallel and vertical to current flow
-    if(highfield_mob)
+    if(highfield_mob && !local_edge_ad)
     {
       // which are the vector of electric field and current density.
       // here use type AutoDScalar, we should make sure the order of independent variable keeps the
@@ -922,12 +1209,12 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
       }
 
       // compute the gradient
-      E   = - elem->gradient(psi_vertex);  // E = - grad(psi)
-      Jnv = - elem->gradient(phin_vertex); // we only need the direction of Jnv, here Jnv = - gradient of Fn
-      Jpv = - elem->gradient(phip_vertex); // the same as Jnv
+      E   = - this->cell_gradient(nelem, &psi_vertex[0]);  // E = - grad(psi)
+      Jnv = - this->cell_gradient(nelem, &phin_vertex[0]); // we only need the direction of Jnv, here Jnv = - gradient of Fn
+      Jpv = - this->cell_gradient(nelem, &phip_vertex[0]); // the same as Jnv
     }
 
-    if(highfield_mob)
+    if(highfield_mob && !local_edge_ad)
     {
       // for elem on insulator interface, we will do special treatment to electrical field
       if(get_advanced_model()->ESurface && insulator_interface_elem)
@@ -1036,28 +1323,52 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
     }
 
 
+    // the jacobian of continuity equations of this cell is accumulated into a dense block,
+    // 2 rows for each node (electron and hole continuity equation), and added to the matrix at once.
+    std::vector<PetscInt> cell_row;
+    for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
+    {
+      const FVM_Node * fvm_node = elem->get_fvm_node(nd);
+      // ghost rows are skipped by negative index
+      cell_row.push_back( fvm_node->on_processor() ? fvm_node->global_offset()+1 : -1 );
+      cell_row.push_back( fvm_node->on_processor() ? fvm_node->global_offset()+2 : -1 );
+    }
+    std::vector<PetscScalar> cell_jac(cell_row.size()*cell_col.size(), 0.0);
+
+    // edge mobility and current of this cell, only for HALL
+    std::vector<AutoDScalar> mun_edge_cell, mup_edge_cell;
+    std::vector<AutoDScalar> Jn_edge_cell, Jp_edge_cell;
+
+    // only 6 AD directions for each edge
+    if( local_edge_ad )
+    {
+      adtl::AutoDScalar::numdir = 6;
+      mt->set_ad_num(adtl::AutoDScalar::numdir);
+    }
+
+
     // process conservation terms: laplace operator of poisson's equation and div operator of continuation equation
     // search for all the Edge this cell own
-    for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
+    // the edge geometry of this cell is read from the flattened cell edge arrays
+    for(unsigned int ce=cell_edges.begin[nelem]; ce<cell_edges.begin[nelem+1]; ++ce )
     {
-      std::pair<unsigned int, unsigned int> edge_nodes;
-      elem->nodes_on_edge(ne, edge_nodes);
+      const std::pair<unsigned int, unsigned int> edge_nodes(cell_edges.node1[ce], cell_edges.node2[ce]);
 
-      const unsigned int edge_index = this->elem_edge_index(elem, ne);
+      const unsigned int edge_index = cell_edges.edge[ce];
 
       // the length of this edge
-      const double length = elem->edge_length(ne);
+      const double length = cell_edges.length[ce];
 
       // partial area associated with this edge
-      double partial_area = elem->partial_area_with_edge(ne);
-      double partial_volume = elem->partial_volume_with_edge(ne); // partial volume associated with this edge
+      double partial_area = cell_edges.area[ce];
+      double partial_volume = cell_edges.volume[ce]; // partial volume associated with this edge
 
       double truncated_partial_area =  partial_area;
       double truncated_partial_volume =  partial_volume;
       if(truncation)
       {
-        truncated_partial_area =  elem->partial_area_with_edge_truncated(ne);
-        truncated_partial_volume =  elem->partial_volume_with_edge_truncated(ne);
+        truncated_partial_area =  cell_edges.area_truncated[ce];
+        truncated_partial_volume =  cell_edges.volume_truncated[ce];
       }
 
       const FVM_Node * fvm_n1 = elem->get_fvm_node(edge_nodes.first);   // fvm_node of node1
@@ -1080,10 +1391,18 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
       for(int i=0; i<3; ++i) row[i]   = n1_global_offset+i;
       for(int i=0; i<3; ++i) row[i+3] = n2_global_offset+i;
 
+      // the AD index of the two nodes, and the cell block columns of the local AD directions
+      const unsigned int nd1 = local_edge_ad ? 0 : edge_nodes.first;
+      const unsigned int nd2 = local_edge_ad ? 1 : edge_nodes.second;
+      unsigned int edge_col[6];
+      for(int i=0; i<3; ++i) edge_col[i]   = 3*edge_nodes.first+i;
+      for(int i=0; i<3; ++i) edge_col[i+3] = 3*edge_nodes.second+i;
+      const unsigned int * cols = local_edge_ad ? edge_col : 0;
+
       // here we use AD again. Can we hand write it for more efficient?
       {
-        AutoDScalar V1(x[n1_local_offset+0]);       V1.setADValue(3*edge_nodes.first+0, 1.0);           // electrostatic potential
-        AutoDScalar V2(x[n2_local_offset+0]);       V2.setADValue(3*edge_nodes.second+0, 1.0);             // electrostatic potential
+        AutoDScalar V1(x[n1_local_offset+0]);       V1.setADValue(3*nd1+0, 1.0);           // electrostatic potential
+        AutoDScalar V2(x[n2_local_offset+0]);       V2.setADValue(3*nd2+0, 1.0);             // electrostatic potential
 
         AutoDScalar mun1;   // electron mobility for node 1 of the edge
         AutoDScalar mup1;   // hole mobility for node 1 of the edge
@@ -1092,11 +1411,11 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
 
         if(highfield_mob)
         {
-          AutoDScalar n1(x[n1_local_offset+1]);       n1.setADValue(3*edge_nodes.first+1, 1.0);           // electron density
-          AutoDScalar p1(x[n1_local_offset+2]);       p1.setADValue(3*edge_nodes.first+2, 1.0);           // hole density
+          AutoDScalar n1(x[n1_local_offset+1]);       n1.setADValue(3*nd1+1, 1.0);           // electron density
+          AutoDScalar p1(x[n1_local_offset+2]);       p1.setADValue(3*nd1+2, 1.0);           // hole density
 
-          AutoDScalar n2(x[n2_local_offset+1]);       n2.setADValue(3*edge_nodes.second+1, 1.0);          // electron density
-          AutoDScalar p2(x[n2_local_offset+2]);       p2.setADValue(3*edge_nodes.second+2, 1.0);          // hole density
+          AutoDScalar n2(x[n2_local_offset+1]);       n2.setADValue(3*nd2+1, 1.0);          // electron density
+          AutoDScalar p2(x[n2_local_offset+2]);       p2.setADValue(3*nd2+2, 1.0);          // hole density
 
           // high field mobility
           if (get_advanced_model()->Mob_Force == ModelSpecify::ESimple && !insulator_interface_elem )
@@ -1141,33 +1460,41 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
         AutoDScalar mup = 0.5*(mup1+mup2);  // the hole mobility at the mid point of the edge, use linear interpolation
 
         // S-G current along the edge
-        const AutoDScalar & Jn_edge = Jn_edge_buffer[edge_index];
-        const AutoDScalar & Jp_edge = Jp_edge_buffer[edge_index];
+        const AutoDScalar6 & Jn_edge = Jn_edge_buffer[edge_index];
+        const AutoDScalar6 & Jp_edge = Jp_edge_buffer[edge_index];
 
         // shift AD value since they have different location
         unsigned int order[6];
         if(inverse)
         {
-          order[0]= 3*edge_nodes.second+0;
-          order[1]= 3*edge_nodes.second+1;
-          order[2]= 3*edge_nodes.second+2;
-          order[3]= 3*edge_nodes.first+0;
-          order[4]= 3*edge_nodes.first+1;
-          order[5]= 3*edge_nodes.first+2;
+          order[0]= 3*nd2+0;
+          order[1]= 3*nd2+1;
+          order[2]= 3*nd2+2;
+          order[3]= 3*nd1+0;
+          order[4]= 3*nd1+1;
+          order[5]= 3*nd1+2;
         }
         else
         {
-          order[0]= 3*edge_nodes.first+0;
-          order[1]= 3*edge_nodes.first+1;
-          order[2]= 3*edge_nodes.first+2;
-          order[3]= 3*edge_nodes.second+0;
-          order[4]= 3*edge_nodes.second+1;
-          order[5]= 3*edge_nodes.second+2;
+          order[0]= 3*nd1+0;
+          order[1]= 3*nd1+1;
+          order[2]= 3*nd1+2;
+          order[3]= 3*nd2+0;
+          order[4]= 3*nd2+1;
+          order[5]= 3*nd2+2;
         }
 
         AutoDScalar Jn = (inverse ? -1.0 : 1.0)*mun*AutoDScalar(Jn_edge, order, 6);
         AutoDScalar Jp = (inverse ? -1.0 : 1.0)*mup*AutoDScalar(Jp_edge, order, 6);
 
+        if(B)
+        {
+          mun_edge_cell.push_back(mun);
+          mup_edge_cell.push_back(mup);
+          Jn_edge_cell.push_back(Jn);
+          Jp_edge_cell.push_back(Jp);
+        }
+
         // ignore thoese ghost nodes (ghost nodes is local but with different processor_id())
         if( fvm_n1->on_processor() )
         {
@@ -1175,8 +1502,8 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
           AutoDScalar f_Jn  =  Jn*truncated_partial_area ;
           AutoDScalar f_Jp  = -Jp*truncated_partial_area;
           // general coding always has some overkill... bypass it.
-          MatSetValues(*jac, 1, &row[1], cell_col.size(), &cell_col[0], f_Jn.getADValue(), ADD_VALUES);
-          MatSetValues(*jac, 1, &row[2], cell_col.size(), &cell_col[0], f_Jp.getADValue(), ADD_VALUES);
+          add_to_cell_block(cell_jac, 2*edge_nodes.first+0, f_Jn.getADValue(), cell_col.size(), cols, 6);
+          add_to_cell_block(cell_jac, 2*edge_nodes.first+1, f_Jp.getADValue(), cell_col.size(), cols, 6);
         }
 
         if( fvm_n2->on_processor() )
@@ -1184,8 +1511,8 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
           // flux on edge
           AutoDScalar f_Jn  = -Jn*truncated_partial_area ;
           AutoDScalar f_Jp  =  Jp*truncated_partial_area;
-          MatSetValues(*jac, 1, &row[4], cell_col.size(), &cell_col[0], f_Jn.getADValue(), ADD_VALUES);
-          MatSetValues(*jac, 1, &row[5], cell_col.size(), &cell_col[0], f_Jp.getADValue(), ADD_VALUES);
+          add_to_cell_block(cell_jac, 2*edge_nodes.second+0, f_Jn.getADValue(), cell_col.size(), cols, 6);
+          add_to_cell_block(cell_jac, 2*edge_nodes.second+1, f_Jp.getADValue(), cell_col.size(), cols, 6);
         }
 
         // BandBandTunneling && ImpactIonization
@@ -1199,16 +1526,16 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT1*truncated_partial_volume;
-            MatSetValues(*jac, 1, &row[1], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row[2], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
+            add_to_cell_block(cell_jac, 2*edge_nodes.first+0, continuity.getADValue(), cell_col.size());
+            add_to_cell_block(cell_jac, 2*edge_nodes.first+1, continuity.getADValue(), cell_col.size());
           }
 
           if( fvm_n2->on_processor() )
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT2*truncated_partial_volume;
-            MatSetValues(*jac, 1, &row[4], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row[5], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
+            add_to_cell_block(cell_jac, 2*edge_nodes.second+0, continuity.getADValue(), cell_col.size());
+            add_to_cell_block(cell_jac, 2*edge_nodes.second+1, continuity.getADValue(), cell_col.size());
           }
         }
 
@@ -1233,20 +1560,20 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
               case ModelSpecify::IIForce_EdotJ:
               Epn = adtl::fmax(E.dot(Jnv.unit(true)), 0.0);
               Epp = adtl::fmax(E.dot(Jpv.unit(true)), 0.0);
-              IIn = mt->gen->ElecGenRate(T,Epn,Eg);
-              IIp = mt->gen->HoleGenRate(T,Epp,Eg);
+              IIn = ii_rate(mt->gen, true, T, Epn, Eg);
+              IIp = ii_rate(mt->gen, false, T, Epp, Eg);
               break;
               case ModelSpecify::EVector:
-              IIn = mt->gen->ElecGenRate(T,E.size(),Eg);
-              IIp = mt->gen->HoleGenRate(T,E.size(),Eg);
+              IIn = ii_rate(mt->gen, true, T, E.size(), Eg);
+              IIp = ii_rate(mt->gen, false, T, E.size(), Eg);
               break;
               case ModelSpecify::ESide:
-              IIn = mt->gen->ElecGenRate(T,fabs((V2-V1)/length),Eg);
-              IIp = mt->gen->HoleGenRate(T,fabs((V2-V1)/length),Eg);
+              IIn = ii_rate(mt->gen, true, T, fabs((V2-V1)/length), Eg);
+              IIp = ii_rate(mt->gen, false, T, fabs((V2-V1)/length), Eg);
               break;
               case ModelSpecify::GradQf:
-              IIn = mt->gen->ElecGenRate(T,Jnv.size(),Eg);
-              IIp = mt->gen->HoleGenRate(T,Jpv.size(),Eg);
+              IIn = ii_rate(mt->gen, true, T, Jnv.size(), Eg);
+              IIp = ii_rate(mt->gen, false, T, Jpv.size(), Eg);
               break;
               default:
               {
@@ -1262,8 +1589,8 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
             // continuity equation
             AutoDScalar electron_continuity = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
-            MatSetValues(*jac, 1, &row[1], cell_col.size(), &cell_col[0], electron_continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row[2], cell_col.size(), &cell_col[0], hole_continuity.getADValue(), ADD_VALUES);
+            add_to_cell_block(cell_jac, 2*edge_nodes.first+0, electron_continuity.getADValue(), cell_col.size());
+            add_to_cell_block(cell_jac, 2*edge_nodes.first+1, hole_continuity.getADValue(), cell_col.size());
           }
 
           if( fvm_n2->on_processor() )
@@ -1271,14 +1598,26 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
             // continuity equation
             AutoDScalar electron_continuity = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
-            MatSetValues(*jac, 1, &row[4], cell_col.size(), &cell_col[0], electron_continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row[5], cell_col.size(), &cell_col[0], hole_continuity.getADValue(), ADD_VALUES);
+            add_to_cell_block(cell_jac, 2*edge_nodes.second+0, electron_continuity.getADValue(), cell_col.size());
+            add_to_cell_block(cell_jac, 2*edge_nodes.second+1, hole_continuity.getADValue(), cell_col.size());
           }
         }
 
       }
     }// end of scan all edges of the cell
 
+    // magnetic field term of HALL solver
+    if(B)
+      HALL_Cell_Jacobian(*B, elem, nelem, truncation, mun_edge_cell, mup_edge_cell, Jn_edge_cell, Jp_edge_cell, cell_jac, cell_col.size());
+
+    // add the cell block to the matrix, directly by the precomputed slots when it is possible
+    const PetscInt * slots = slot_map ? _ddm1_cell_slots.slots(*slot_map, nelem, cell_row.size(), &cell_row[0], cell_col.size(), &cell_col[0]) : 0;
+    if( slots )
+      slot_map->add(cell_jac.size(), slots, &cell_jac[0]);
+    else
+      MatSetValues(*jac, cell_row.size(), &cell_row[0], cell_col.size(), &cell_col[0], &cell_jac[0], ADD_VALUES);
+
+
   }// end of scan all the cell
 
 
@@ -1328,9 +1667,28 @@ void SemiconductorSimulationRegion::DDM1_Jacobian(PetscScalar * x, Mat *jac, Ins
     MatSetValues(*jac, 1, &index[0], 3, &index[0], rho.getADValue(), ADD_VALUES);
     MatSetValues(*jac, 1, &index[1], 3, &index[0], R.getADValue(), ADD_VALUES);
     MatSetValues(*jac, 1, &index[2], 3, &index[0], R.getADValue(), ADD_VALUES);
+  }
 
-    if (get_advanced_model()->Trap)
+  // bulk trap terms, only the nodes which carry traps are visited
+  if (get_advanced_model()->Trap)
+  {
+    const std::vector<FVM_Node *> & nodes_with_trap = trap_nodes();
+    for(unsigned int i=0; i<nodes_with_trap.size(); ++i)
     {
+      const FVM_Node * fvm_node = nodes_with_trap[i];
+      if( !fvm_node->on_processor() ) continue;
+
+      const unsigned int local_offset = fvm_node->local_offset();
+      const unsigned int global_offset = fvm_node->global_offset();
+      const FVM_NodeData * node_data = fvm_node->node_data();
+
+      PetscInt index[3] = {global_offset+0, global_offset+1, global_offset+2};
+
+      AutoDScalar n(x[local_offset+1]);   n.setADValue(1, 1.0);              // electron density
+      AutoDScalar p(x[local_offset+2]);   p.setADValue(2, 1.0);              // hole density
+
+      mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);                   // map this node and its data to material database
+
       AutoDScalar ni = mt->band->nie(p, n, T);
       mt->trap->Calculate(true,p,n,ni,T);
 
@@ -1498,6 +1856,19 @@ void SemiconductorSimulationRegion::DDM1_Update_Solution(PetscScalar *lxx)
   const PetscScalar T   = T_external();
   const PetscScalar Vt  = kb*T/e;
 
+  // every local node holds one entry of the node data storage, and psi, n, p of all the
+  // entries are overwritten below. so the values of last step are rotated in by exchanging
+  // the data blocks instead of copying them node by node
+  const bool rotated = _node_data_storage.scalar_allocated(FVM_Semiconductor_NodeData::_psi_last_) &&
+                       _node_data_storage.scalar_allocated(FVM_Semiconductor_NodeData::_n_last_)   &&
+                       _node_data_storage.scalar_allocated(FVM_Semiconductor_NodeData::_p_last_);
+  if( rotated )
+  {
+    _node_data_storage.swap_scalar(FVM_Semiconductor_NodeData::_psi_, FVM_Semiconductor_NodeData::_psi_last_);
+    _node_data_storage.swap_scalar(FVM_Semiconductor_NodeData::_n_,   FVM_Semiconductor_NodeData::_n_last_);
+    _node_data_storage.swap_scalar(FVM_Semiconductor_NodeData::_p_,   FVM_Semiconductor_NodeData::_p_last_);
+  }
+
   local_node_iterator node_it = on_local_nodes_begin();
   local_node_iterator node_it_end = on_local_nodes_end();
   for(; node_it!=node_it_end; ++node_it)
@@ -1512,17 +1883,17 @@ void SemiconductorSimulationRegion::DDM1_Update_Solution(PetscScalar *lxx)
     mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);
 
     //update psi
-    node_data->psi_last() =  node_data->psi();
+    if( !rotated ) node_data->psi_last() =  node_data->psi();
     node_data->psi()      =  V;
     // clear E. for later electrical field computation
     node_data->E() = VectorValue<PetscScalar>(0.0, 0.0, 0.0);
 
     // electron density
-    node_data->n_last()   = node_data->n();
+    if( !rotated ) node_data->n_last()   = node_data->n();
     node_data->n()        =  n;
 
     // hole density
-    node_data->p_last()   = node_data->p();
+    if( !rotated ) node_data->p_last()   = node_data->p();
     node_data->p()        =  p;
 
 
@@ -1545,36 +1916,26 @@ void SemiconductorSimulationRegion::DDM1_Update_Solution(PetscScalar *lxx)
     node_data->Recomb_Dir() = mt->band->R_Direct(p, n, T);
     node_data->Recomb_SRH() = mt->band->R_SHR(p, n, T);
     node_data->Recomb_Auger() = mt->band->R_Auger(p, n, T);
+  }
 
-    if (get_advanced_model()->Trap)
+  // update traps, only the nodes which carry traps are visited
+  if (get_advanced_model()->Trap)
+  {
+    const std::vector<FVM_Node *> & nodes_with_trap = trap_nodes();
+    for(unsigned int i=0; i<nodes_with_trap.size(); ++i)
     {
-      // update traps
+      FVM_Node * fvm_node = nodes_with_trap[i];
+      FVM_NodeData * node_data = fvm_node->node_data();
       mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);
-      mt->trap->Update(true, p, n, node_data->ni(), T_external());
-      mt->trap->Update(false, p, n, node_data->ni(), T_external());
+      mt->trap->Update(true, node_data->p(), node_data->n(), node_data->ni(), T_external());
+      mt->trap->Update(false, node_data->p(), node_data->n(), node_data->ni(), T_external());
     }
   }
 
   // addtional work: compute electrical field for all the cell.
   // Since this value is only used for reference.
   // It can be done simply by weighted average of cell's electrical field
-  for(unsigned int n=0; n<n_cell(); ++n)
-  {
-    const Elem * elem = this->get_region_elem(n);
-    FVM_CellData * elem_data = this->get_region_elem_data(n);
-
-    std::vector<PetscScalar> psi_vertex;
-    psi_vertex.reserve(elem->n_nodes());
-
-    for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
-    {
-      const FVM_Node * fvm_node = elem->get_fvm_node(nd);
-      const FVM_NodeData * fvm_node_data = fvm_node->node_data();
-      psi_vertex.push_back  ( fvm_node_data->psi() );
-    }
-    // compute the gradient in the cell
-    elem_data->E()  = - elem->gradient(psi_vertex);  // E = - grad(psi)
-  }
+  this->update_cell_electric_field();
 
 
 }
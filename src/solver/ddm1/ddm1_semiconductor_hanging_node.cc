@@ -49,12 +49,12 @@ void SemiconductorSimulationRegion::DDM1_Function_Hanging_Node(PetscScalar *x, V
     std::vector<PetscInt>    insert_index;
     std::vector<PetscScalar> insert_buffer;
 
-    hanging_node_on_elem_side_iterator  hanging_node_it = hanging_node_on_elem_side_begin();
-    hanging_node_on_elem_side_iterator  hanging_node_it_end = hanging_node_on_elem_side_end();
+    hanging_node_constraint_iterator  hanging_node_it = hanging_node_on_elem_side_constraints_begin();
+    hanging_node_constraint_iterator  hanging_node_it_end = hanging_node_on_elem_side_constraints_end();
 
     for(; hanging_node_it!=hanging_node_it_end; ++hanging_node_it )
     {
-      const FVM_Node * fvm_node = (*hanging_node_it).first;
+      const FVM_Node * fvm_node = (*hanging_node_it).node;
 
       // skip node not belongs to this processor
       if( fvm_node->root_node()->processor_id()!=Genius::processor_id() ) continue;
@@ -62,18 +62,12 @@ void SemiconductorSimulationRegion::DDM1_Function_Hanging_Node(PetscScalar *x, V
       // let the flux of hanging node flow into other "non-hanging" node on the element side averagely
       // this process ensure the global conservation of flux
 
-      const Elem * elem = (*hanging_node_it).second.first;
-      unsigned int side_index = (*hanging_node_it).second.second;
-
-      AutoPtr<Elem>  side = elem->build_side(side_index);
-
-      unsigned int n_side_node = side->n_nodes();
+      unsigned int n_side_node = (*hanging_node_it).parents.size();
       std::vector<const FVM_Node *> side_fvm_nodes;
 
       for(unsigned int n=0; n < n_side_node; n++)
       {
-        const Node * side_node = side->get_node(n);
-        const FVM_Node * side_fvm_node = region_fvm_node(side_node);
+        const FVM_Node * side_fvm_node = (*hanging_node_it).parents[n];
         side_fvm_nodes.push_back(side_fvm_node);
 
         src_row.push_back(fvm_node->global_offset()+0);
@@ -160,12 +154,12 @@ void SemiconductorSimulationRegion::DDM1_Function_Hanging_Node(PetscScalar *x, V
       std::vector<PetscInt>    insert_index;
       std::vector<PetscScalar> insert_buffer;
 
-      hanging_node_on_elem_side_iterator  hanging_node_it = hanging_node_on_elem_side_begin();
-      hanging_node_on_elem_side_iterator  hanging_node_it_end = hanging_node_on_elem_side_end();
+      hanging_node_constraint_iterator  hanging_node_it = hanging_node_on_elem_side_constraints_begin();
+      hanging_node_constraint_iterator  hanging_node_it_end = hanging_node_on_elem_side_constraints_end();
 
       for(; hanging_node_it!=hanging_node_it_end; ++hanging_node_it )
       {
-        const FVM_Node * fvm_node = (*hanging_node_it).first;
+        const FVM_Node * fvm_node = (*hanging_node_it).node;
 
         // skip node not belongs to this processor
         if( fvm_node->root_node()->processor_id()!=Genius::processor_id() ) continue;
@@ -173,18 +167,12 @@ void SemiconductorSimulationRegion::DDM1_Function_Hanging_Node(PetscScalar *x, V
         // let the flux of hanging node flow into other "non-hanging" node on the element side averagely
         // this process ensure the global conservation of flux
 
-        const Elem * elem = (*hanging_node_it).second.first;
-        unsigned int side_index = (*hanging_node_it).second.second;
-
-        AutoPtr<Elem>  side = elem->build_side(side_index);
-
-        unsigned int n_side_node = side->n_nodes();
+        unsigned int n_side_node = (*hanging_node_it).parents.size();
         std::vector<const FVM_Node *> side_fvm_nodes;
 
         for(unsigned int n=0; n < n_side_node; n++)
         {
-          const Node * side_node = side->get_node(n);
-          const FVM_Node * side_fvm_node = region_fvm_node(side_node);
+          const FVM_Node * side_fvm_node = (*hanging_node_it).parents[n];
           side_fvm_nodes.push_back(side_fvm_node);
 
           src_row.push_back(fvm_node->global_offset()+0);
@@ -273,12 +261,12 @@ void SemiconductorSimulationRegion::DDM1_Function_Hanging_Node(PetscScalar *x, V
       std::vector<PetscInt>    insert_index;
       std::vector<PetscScalar> insert_buffer;
 
-      hanging_node_on_elem_edge_iterator  hanging_node_it = hanging_node_on_elem_edge_begin();
-      hanging_node_on_elem_edge_iterator  hanging_node_it_end = hanging_node_on_elem_edge_end();
+      hanging_node_constraint_iterator  hanging_node_it = hanging_node_on_elem_edge_constraints_begin();
+      hanging_node_constraint_iterator  hanging_node_it_end = hanging_node_on_elem_edge_constraints_end();
 
       for(; hanging_node_it!=hanging_node_it_end; ++hanging_node_it )
       {
-        const FVM_Node * fvm_node = (*hanging_node_it).first;
+        const FVM_Node * fvm_node = (*hanging_node_it).node;
 
         // skip node not belongs to this processor
         if( fvm_node->root_node()->processor_id()!=Genius::processor_id() ) continue;
@@ -286,18 +274,12 @@ void SemiconductorSimulationRegion::DDM1_Function_Hanging_Node(PetscScalar *x, V
         // let the flux of hanging node flow into other "non-hanging" node on the element side averagely
         // this process ensure the global conservation of flux
 
-        const Elem * elem = (*hanging_node_it).second.first;
-        unsigned int edge_index = (*hanging_node_it).second.second;
-
-        AutoPtr<Elem>  edge = elem->build_edge(edge_index);
-
         unsigned int n_edge_node = 2;
         std::vector<const FVM_Node *> edge_fvm_nodes;
 
         for(unsigned int n=0; n < n_edge_node; n++)
         {
-          const Node * edge_node = edge->get_node(n);
-          const FVM_Node * edge_fvm_node = region_fvm_node(edge_node);
+          const FVM_Node * edge_fvm_node = (*hanging_node_it).parents[n];
           genius_assert(edge_fvm_node!=NULL);
 
           edge_fvm_nodes.push_back(edge_fvm_node);
@@ -381,12 +363,12 @@ void SemiconductorSimulationRegion::DDM1_Jacobian_Hanging_Node(PetscScalar *x, M
     std::vector< std::vector<PetscInt> >    cols_index;
     std::vector< AutoDScalar >              ad_values;
 
-    hanging_node_on_elem_side_iterator  hanging_node_it = hanging_node_on_elem_side_begin();
-    hanging_node_on_elem_side_iterator  hanging_node_it_end = hanging_node_on_elem_side_end();
+    hanging_node_constraint_iterator  hanging_node_it = hanging_node_on_elem_side_constraints_begin();
+    hanging_node_constraint_iterator  hanging_node_it_end = hanging_node_on_elem_side_constraints_end();
 
     for(; hanging_node_it!=hanging_node_it_end; ++hanging_node_it )
     {
-      const FVM_Node * fvm_node = (*hanging_node_it).first;
+      const FVM_Node * fvm_node = (*hanging_node_it).node;
 
       // skip node not belongs to this processor
       if( fvm_node->root_node()->processor_id()!=Genius::processor_id() ) continue;
@@ -394,18 +376,12 @@ void SemiconductorSimulationRegion::DDM1_Jacobian_Hanging_Node(PetscScalar *x, M
       // let the flux of hanging node flow into other "non-hanging" node on the element side averagely
       // this process ensure the global conservation of flux
 
-      const Elem * elem = (*hanging_node_it).second.first;
-      unsigned int side_index = (*hanging_node_it).second.second;
-
-      AutoPtr<Elem>  side = elem->build_side(side_index);
-
-      unsigned int n_side_node = side->n_nodes();
+      unsigned int n_side_node = (*hanging_node_it).parents.size();
       std::vector<const FVM_Node *> side_fvm_nodes;
 
       for(unsigned int n=0; n < n_side_node; n++)
       {
-        const Node * side_node = side->get_node(n);
-        const FVM_Node * side_fvm_node = region_fvm_node(side_node);
+        const FVM_Node * side_fvm_node = (*hanging_node_it).parents[n];
         side_fvm_nodes.push_back(side_fvm_node);
 
         src_row.push_back(fvm_node->global_offset()+0);
@@ -518,12 +494,12 @@ void SemiconductorSimulationRegion::DDM1_Jacobian_Hanging_Node(PetscScalar *x, M
       std::vector< std::vector<PetscInt> >    cols_index;
       std::vector< AutoDScalar >              ad_values;
 
-      hanging_node_on_elem_side_iterator  hanging_node_it = hanging_node_on_elem_side_begin();
-      hanging_node_on_elem_side_iterator  hanging_node_it_end = hanging_node_on_elem_side_end();
+      hanging_node_constraint_iterator  hanging_node_it = hanging_node_on_elem_side_constraints_begin();
+      hanging_node_constraint_iterator  hanging_node_it_end = hanging_node_on_elem_side_constraints_end();
 
       for(; hanging_node_it!=hanging_node_it_end; ++hanging_node_it )
       {
-        const FVM_Node * fvm_node = (*hanging_node_it).first;
+        const FVM_Node * fvm_node = (*hanging_node_it).node;
 
         // skip node not belongs to this processor
         if( fvm_node->root_node()->processor_id()!=Genius::processor_id() ) continue;
@@ -531,18 +507,12 @@ void SemiconductorSimulationRegion::DDM1_Jacobian_Hanging_Node(PetscScalar *x, M
         // let the flux of hanging node flow into other "non-hanging" node on the element side averagely
         // this process ensure the global conservation of flux
 
-        const Elem * elem = (*hanging_node_it).second.first;
-        unsigned int side_index = (*hanging_node_it).second.second;
-
-        AutoPtr<Elem>  side = elem->build_side(side_index);
-
-        unsigned int n_side_node = side->n_nodes();
+        unsigned int n_side_node = (*hanging_node_it).parents.size();
         std::vector<const FVM_Node *> side_fvm_nodes;
 
         for(unsigned int n=0; n < n_side_node; n++)
         {
-          const Node * side_node = side->get_node(n);
-          const FVM_Node * side_fvm_node = region_fvm_node(side_node);
+          const FVM_Node * side_fvm_node = (*hanging_node_it).parents[n];
           side_fvm_nodes.push_back(side_fvm_node);
 
           src_row.push_back(fvm_node->global_offset()+0);
@@ -656,12 +626,12 @@ void SemiconductorSimulationRegion::DDM1_Jacobian_Hanging_Node(PetscScalar *x, M
       std::vector< std::vector<PetscInt> >    cols_index;
       std::vector< AutoDScalar >              ad_values;
 
-      hanging_node_on_elem_edge_iterator  hanging_node_it = hanging_node_on_elem_edge_begin();
-      hanging_node_on_elem_edge_iterator  hanging_node_it_end = hanging_node_on_elem_edge_end();
+      hanging_node_constraint_iterator  hanging_node_it = hanging_node_on_elem_edge_constraints_begin();
+      hanging_node_constraint_iterator  hanging_node_it_end = hanging_node_on_elem_edge_constraints_end();
 
       for(; hanging_node_it!=hanging_node_it_end; ++hanging_node_it )
       {
-        const FVM_Node * fvm_node = (*hanging_node_it).first;
+        const FVM_Node * fvm_node = (*hanging_node_it).node;
 
         // skip node not belongs to this processor
         if( fvm_node->root_node()->processor_id()!=Genius::processor_id() ) continue;
@@ -669,18 +639,12 @@ void SemiconductorSimulationRegion::DDM1_Jacobian_Hanging_Node(PetscScalar *x, M
         // let the flux of hanging node flow into other "non-hanging" node on the element side averagely
         // this process ensure the global conservation of flux
 
-        const Elem * elem = (*hanging_node_it).second.first;
-        unsigned int edge_index = (*hanging_node_it).second.second;
-
-        AutoPtr<Elem>  edge = elem->build_edge(edge_index);
-
         unsigned int n_edge_node = 2;
         std::vector<const FVM_Node *> edge_fvm_nodes;
 
         for(unsigned int n=0; n < n_edge_node; n++)
         {
-          const Node * edge_node = edge->get_node(n);
-          const FVM_Node * edge_fvm_node = region_fvm_node(edge_node);
+          const FVM_Node * edge_fvm_node = (*hanging_node_it).parents[n];
           edge_fvm_nodes.push_back(edge_fvm_node);
 
           src_row.push_back(fvm_node->global_offset()+0);
@@ -627,21 +627,20 @@ PetscScalar DDM2Solver::LTE_norm()
 void DDM2Solver::error_norm()
 {
   PetscScalar    *xx;
-  PetscScalar    *ff;
+  const PetscScalar *ff;
 
   // scatte global solution vector x to local vector lx
   // this is not necessary since it had already done in function evaluation
   //VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
   //VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
 
-  // scatte global function vector f to local vector lf
-  VecScatterBegin(scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
+  // only the on processor dofs are involved, read them from the global function vector f
+  // directly (indexed by global offset) instead of scattering f to local vector lf
 
 
 
   VecGetArray(lx, &xx);  // solution value
-  VecGetArray(lf, &ff);  // function value
+  VecGetArrayRead(f, &ff);   // function value
 
   // do clear
   potential_norm        = 0;
@@ -670,6 +669,7 @@ void DDM2Solver::error_norm()
     {
       const FVM_Node * fvm_node = *it;
       unsigned int offset = fvm_node->local_offset();
+      unsigned int f_offset = fvm_node->global_offset() - global_offset;
 
       switch ( region->type() )
       {
@@ -680,10 +680,10 @@ void DDM2Solver::error_norm()
             hole_norm        += xx[offset+2]*xx[offset+2];
             temperature_norm += xx[offset+3]*xx[offset+3];
 
-            poisson_norm         += ff[offset+0]*ff[offset+0];
-            elec_continuity_norm += ff[offset+1]*ff[offset+1];
-            hole_continuity_norm += ff[offset+2]*ff[offset+2];
-            heat_equation_norm   += ff[offset+3]*ff[offset+3];
+            poisson_norm         += ff[f_offset+0]*ff[f_offset+0];
+            elec_continuity_norm += ff[f_offset+1]*ff[f_offset+1];
+            hole_continuity_norm += ff[f_offset+2]*ff[f_offset+2];
+            heat_equation_norm   += ff[f_offset+3]*ff[f_offset+3];
             break;
           }
           case InsulatorRegion :
@@ -691,8 +691,8 @@ void DDM2Solver::error_norm()
             potential_norm   += xx[offset]*xx[offset];
             temperature_norm += xx[offset+1]*xx[offset+1];
 
-            poisson_norm        += ff[offset]*ff[offset];
-            heat_equation_norm  += ff[offset+1]*ff[offset+1];
+            poisson_norm        += ff[f_offset]*ff[f_offset];
+            heat_equation_norm  += ff[f_offset+1]*ff[f_offset+1];
             break;
           }
           case ElectrodeRegion :
@@ -700,8 +700,8 @@ void DDM2Solver::error_norm()
             potential_norm   += xx[offset]*xx[offset];
             temperature_norm += xx[offset+1]*xx[offset+1];
 
-            poisson_norm        += ff[offset]*ff[offset];
-            heat_equation_norm  += ff[offset+1]*ff[offset+1];
+            poisson_norm        += ff[f_offset]*ff[f_offset];
+            heat_equation_norm  += ff[f_offset+1]*ff[f_offset+1];
             break;
           }
           case MetalRegion :
@@ -709,8 +709,8 @@ void DDM2Solver::error_norm()
             potential_norm   += xx[offset]*xx[offset];
             temperature_norm += xx[offset+1]*xx[offset+1];
 
-            poisson_norm        += ff[offset]*ff[offset];
-            heat_equation_norm  += ff[offset+1]*ff[offset+1];
+            poisson_norm        += ff[f_offset]*ff[f_offset];
+            heat_equation_norm  += ff[f_offset+1]*ff[f_offset+1];
             break;
           }
           case VacuumRegion:
@@ -725,10 +725,11 @@ void DDM2Solver::error_norm()
     {
       const BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
       unsigned int offset = bc->local_offset();
+      unsigned int f_offset = bc->global_offset() - global_offset;
       if( offset != invalid_uint )
       {
         potential_norm += xx[offset]*xx[offset];
-        electrode_norm += ff[offset]*ff[offset];
+        electrode_norm += ff[f_offset]*ff[f_offset];
       }
     }
 
@@ -762,7 +763,7 @@ void DDM2Solver::error_norm()
   electrode_norm      = sqrt(norm_buffer[8]);
 
   VecRestoreArray(lx, &xx);
-  VecRestoreArray(lf, &ff);
+  VecRestoreArrayRead(f, &ff);
 
 }
 
@@ -803,7 +804,11 @@ void DDM2Solver::build_petsc_sens_residual(Vec x, Vec r)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    START_LOG("Region_Function()", "DDM2Solver");
+    START_DYNAMIC_LOG(region->kernel_label(), "DDM2 Region_Function");
     region->DDM2_Function(lxx, r, add_value_flag);
+    STOP_DYNAMIC_LOG(region->kernel_label(), "DDM2 Region_Function");
+    STOP_LOG("Region_Function()", "DDM2Solver");
   }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
@@ -843,8 +848,8 @@ void DDM2Solver::build_petsc_sens_residual(Vec x, Vec r)
     bc->DDM2_Function_Preprocess(r, src_row, dst_row, clear_row);
   }
   //add source rows to destination rows, and clear rows
-  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row);
-  add_value_flag = NOT_SET_VALUES;
+  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
 
   // evaluate governing equations of DDML1 for all the boundaries
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
@@ -853,6 +858,9 @@ void DDM2Solver::build_petsc_sens_residual(Vec x, Vec r)
     bc->DDM2_Function(lxx, r, add_value_flag);
   }
 
+  // the external circuit of all the electrodes
+  _system.get_bcs()->electrode_circuit_function(lxx, r, add_value_flag);
+
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
@@ -865,20 +873,9 @@ void DDM2Solver::build_petsc_sens_residual(Vec x, Vec r)
   VecAssemblyBegin(r);
   VecAssemblyEnd(r);
 
-  // scale the function vec
-  PetscScalar *ff,*scale;
-  // get function array and scale array.
-  VecGetArray(r, &ff);
-  // L is the scaling vector, the Jacobian evaluate function may dynamically update it.
-  VecGetArray(L, &scale);
-
-  // scale it!
-  for(unsigned int n=0; n<n_local_dofs; n++)
-    ff[n] *= scale[n];
-
-  // restore back
-  VecRestoreArray(r, &ff);
-  VecRestoreArray(L, &scale);
+  // scale the function vec, L is the scaling vector, the Jacobian evaluate function may dynamically update it.
+  // a vector operation does not pull device vector types back to host memory
+  VecPointwiseMult(r, r, L);
 
   STOP_LOG("DDM2Solver_Residual()", "DDM2Solver");
 
@@ -910,7 +907,11 @@ void DDM2Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    START_LOG("Region_Jacobian()", "DDM2Solver");
+    START_DYNAMIC_LOG(region->kernel_label(), "DDM2 Region_Jacobian");
     region->DDM2_Jacobian(lxx, &J, add_value_flag);
+    STOP_DYNAMIC_LOG(region->kernel_label(), "DDM2 Region_Jacobian");
+    STOP_LOG("Region_Jacobian()", "DDM2Solver");
   }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
@@ -967,11 +968,9 @@ void DDM2Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
     bc->DDM2_Jacobian_Preprocess(&J, src_row, dst_row, clear_row);
   }
 
-  //add source rows to destination rows
-  PetscUtils::MatAddRowToRow(J, src_row, dst_row);
-  // clear row
-  PetscUtils::MatZeroRows(J, clear_row.size(), clear_row.empty() ? NULL : &clear_row[0], 0.0);
-  add_value_flag = NOT_SET_VALUES;
+  //add source rows to destination rows, and clear rows
+  PetscUtils::MatAddClearRow(J, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
 
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
   {
@@ -979,6 +978,9 @@ void DDM2Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
     bc->DDM2_Jacobian(lxx, &J, add_value_flag);
   }
 
+  // the external circuit of all the electrodes
+  _system.get_bcs()->electrode_circuit_jacobian(&J, add_value_flag);
+
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
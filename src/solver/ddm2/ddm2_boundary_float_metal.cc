@@ -19,15 +19,11 @@
 /*                                                                              */
 /********************************************************************************/
 
-// C++ includes
-#include <numeric>
-
 #include "simulation_system.h"
 #include "semiconductor_region.h"
 #include "conductor_region.h"
 #include "insulator_region.h"
 #include "boundary_condition_charge.h"
-#include "petsc_utils.h"
 #include "parallel.h"
 
 using PhysicalUnit::kb;
@@ -39,6 +35,57 @@ using PhysicalUnit::e;
 ///////////////////////////////////////////////////////////////////////
 
 
+/*---------------------------------------------------------------------
+ * the rows of float metal interface: the lattice temperature equation of insulator
+ * node is added to the one of metal node, the psi and T rows of insulator node and the psi
+ * row of metal node are replaced by the float metal equations
+ */
+static void float_metal_rows(const BoundaryCondition * bc, std::vector<PetscInt> &src_row,
+                             std::vector<PetscInt> &dst_row, std::vector<PetscInt> &clear_row)
+{
+  const std::vector<BoundaryCondition::RegionNode> & table = bc->region_node_table();
+  for(unsigned int n=0; n<bc->n_nodes(); ++n)
+  {
+    // the insulator node is the first one, then the metal node
+    const unsigned int begin = bc->region_node_table_begin(n);
+    const unsigned int end   = bc->region_node_table_begin(n+1);
+    if( end - begin < 2 ) continue;
+
+    const FVM_Node * insulator_node = table[begin].fvm_node;
+    const FVM_Node * metal_node = table[begin+1].fvm_node;
+    genius_assert(table[begin].region->type() == InsulatorRegion);
+    genius_assert(table[begin+1].region->type() == ElectrodeRegion);
+
+    src_row.push_back(insulator_node->global_offset()+1);
+    dst_row.push_back(metal_node->global_offset()+1);
+
+    clear_row.push_back(insulator_node->global_offset()+0);
+    clear_row.push_back(insulator_node->global_offset()+1);
+    clear_row.push_back(metal_node->global_offset()+0);
+  }
+}
+
+
+/*---------------------------------------------------------------------
+ * do pre-process to function for DDM2 solver
+ */
+void ChargedContactBC::DDM2_Function_Preprocess(Vec, std::vector<PetscInt> &src_row,
+    std::vector<PetscInt> &dst_row, std::vector<PetscInt> &clear_row)
+{
+  float_metal_rows(this, src_row, dst_row, clear_row);
+}
+
+
+/*---------------------------------------------------------------------
+ * do pre-process to jacobian matrix for DDM2 solver
+ */
+void ChargedContactBC::DDM2_Jacobian_Preprocess(Mat *, std::vector<PetscInt> &src_row,
+    std::vector<PetscInt> &dst_row, std::vector<PetscInt> &clear_row)
+{
+  float_metal_rows(this, src_row, dst_row, clear_row);
+}
+
+
 /*---------------------------------------------------------------------
  * build function and its jacobian for DDM2 solver
  */
@@ -54,20 +101,10 @@ void ChargedContactBC::DDM2_Function(PetscScalar * x, Vec f, InsertMode &add_val
     VecAssemblyEnd(f);
   }
 
-  // buffer for Vec location
-  std::vector<PetscInt> src_row;
-  std::vector<PetscInt> dst_row;
-
   // buffer for Vec value
   std::vector<PetscInt>    iy;
   std::vector<PetscScalar> y_new;
 
-  // for 2D mesh, z_width() is the device dimension in Z direction; for 3D mesh, z_width() is 1.0
-  PetscScalar z_width = this->z_width();
-
-  // buffer for float metal surface potential equation \integral {\eps \frac{\partial P}{\partial n} } + \sigma = 0
-  std::vector<PetscScalar> surface_equ;
-
   // the float metal potential in current iteration
   genius_assert( local_offset()!=invalid_uint );
   PetscScalar Vm = x[this->local_offset()];
@@ -101,8 +138,6 @@ void ChargedContactBC::DDM2_Function(PetscScalar * x, Vec f, InsertMode &add_val
         {
           // Insulator region should be the first region
           genius_assert(i==0);
-          const FVM_NodeData * node_data = fvm_nodes[i]->node_data();
-
           // find the position of ghost node
           // since we know only one ghost node exit, there is ghost_node_begin()
           FVM_Node::fvm_ghost_node_iterator gn_it = fvm_nodes[i]->ghost_node_begin();
@@ -134,26 +169,6 @@ void ChargedContactBC::DDM2_Function(PetscScalar * x, Vec f, InsertMode &add_val
           iy.push_back(fvm_nodes[i]->global_offset()+1);
           y_new.push_back(ff2);
 
-          // process float metal surface equation
-          FVM_Node::fvm_neighbor_node_iterator nb_it = fvm_nodes[i]->neighbor_node_begin();
-          FVM_Node::fvm_neighbor_node_iterator nb_it_end = fvm_nodes[i]->neighbor_node_end();
-          for(; nb_it != nb_it_end; ++nb_it)
-          {
-            const FVM_Node *nb_node = (*nb_it).second;
-            // the psi of neighbor node
-            PetscScalar V_nb = x[nb_node->local_offset()];
-            // distance from nb node to this node
-            PetscScalar distance = (*(fvm_nodes[i]->root_node()) - *(nb_node->root_node())).size();
-            // area of out surface of control volume related with neighbor node,
-            // here we should consider the difference of 2D/3D by multiply z_width
-            PetscScalar cv_boundary = fvm_nodes[i]->cv_surface_area(nb_node->root_node())*z_width;
-            // surface electric field
-            PetscScalar E = (V_nb-V)/distance;
-            PetscScalar D = node_data->eps()*E;
-            // insert surface integral of electric displacement of this node into surface_equ buffer
-            surface_equ.push_back(cv_boundary*D);
-          }
-
           break;
         }
         // FloatMetal-Insulator interface at Conductor side
@@ -171,11 +186,6 @@ void ChargedContactBC::DDM2_Function(PetscScalar * x, Vec f, InsertMode &add_val
           iy.push_back(fvm_nodes[i]->global_offset()+0);
           y_new.push_back(ff1);
 
-          // process lattice temperature equation
-          // record the source row and dst row
-          src_row.push_back(fvm_nodes[0]->global_offset()+1);
-          dst_row.push_back(fvm_nodes[i]->global_offset()+1);
-
           break;
         }
       default: genius_error(); //we should never reach here
@@ -184,18 +194,14 @@ void ChargedContactBC::DDM2_Function(PetscScalar * x, Vec f, InsertMode &add_val
 
   }
 
-  // add src row to dst row, it will assemble vec automatically
-  PetscUtils::VecAddRowToRow(f, src_row, dst_row);
-
-  // insert new value to src row
+  // insert new value to src row, the lattice temperature row has been added to
+  // the electrode side and cleared in DDM2_Function_Preprocess
   if( iy.size() )
     VecSetValues(f, iy.size(), &(iy[0]), &(y_new[0]), INSERT_VALUES);
 
-  // we first gather the nodal surface integral of electric displacement from all the processors
-  Parallel::allgather(surface_equ);
-
-  // we sum all the terms in surface_equ buffer, that is surface integral of electric displacement for the whole float metal
-  PetscScalar surface_integral_electric_displacement = std::accumulate(surface_equ.begin(), surface_equ.end(), 0.0 );
+  // surface integral of electric displacement for the whole float metal, by the precomputed integration weights
+  PetscScalar surface_integral_electric_displacement = this->surface_integral(x);
+  Parallel::sum(surface_integral_electric_displacement);
 
   if(Genius::processor_id() == Genius::n_processors() -1)
   {
@@ -216,7 +222,6 @@ void ChargedContactBC::DDM2_Function(PetscScalar * x, Vec f, InsertMode &add_val
  */
 void ChargedContactBC::DDM2_Jacobian_Reserve(Mat *jac, InsertMode &add_value_flag)
 {
-
   // ADD 0 to some position of Jacobian matrix to prevent MatAssembly expurgation these position.
 
   // since we will use ADD_VALUES operat, check the matrix state.
@@ -337,74 +342,7 @@ void ChargedContactBC::DDM2_Jacobian(PetscScalar * x, Mat *jac, InsertMode &add_
 
   // Jacobian of Electrode-Insulator interface is processed here
 
-  // for 2D mesh, z_width() is the device dimension in Z direction; for 3D mesh, z_width() is 1.0
-  PetscScalar z_width = this->z_width();
-
-  {
-    // buffer for mat rows which should be removed
-    std::vector<PetscInt> rm_row;
-
-    // buffer for mat rows which should be added to other row
-    std::vector<PetscInt> src_row;
-    std::vector<PetscInt> dst_row;
-
-    // search for all the node with this boundary type
-    BoundaryCondition::const_node_iterator node_it = nodes_begin();
-    BoundaryCondition::const_node_iterator end_it = nodes_end();
-    for(; node_it!=end_it; ++node_it )
-    {
-      // skip node not belongs to this processor
-      if( (*node_it)->processor_id()!=Genius::processor_id() ) continue;
-
-      // buffer for saving regions and fvm_nodes this *node_it involves
-      std::vector<const SimulationRegion *> regions;
-      std::vector<const FVM_Node *> fvm_nodes;
-
-      // search all the fvm_node which has *node_it as root node, these fvm_nodes have the same location in geometry,
-      // but belong to different regions in logic.
-      BoundaryCondition::region_node_iterator  rnode_it     = region_node_begin(*node_it);
-      BoundaryCondition::region_node_iterator  end_rnode_it = region_node_end(*node_it);
-      for(unsigned int i=0 ; rnode_it!=end_rnode_it; ++i, ++rnode_it  )
-      {
-        regions.push_back( (*rnode_it).second.first );
-        fvm_nodes.push_back( (*rnode_it).second.second );
-
-        switch ( regions[i]->type() )
-        {
-          // FloatMetal-Insulator interface at Insulator side
-        case InsulatorRegion:
-          {
-            rm_row.push_back(fvm_nodes[i]->global_offset()+0);
-            rm_row.push_back(fvm_nodes[i]->global_offset()+1);
-
-            break;
-          }
-          // FloatMetal-Insulator interface at Conductor side
-        case ElectrodeRegion:
-          {
-
-            src_row.push_back(fvm_nodes[0]->global_offset()+1);
-            dst_row.push_back(fvm_nodes[i]->global_offset()+1);
-
-
-            rm_row.push_back(fvm_nodes[i]->global_offset()+0);
-            break;
-          }
-        default: genius_error(); //we should never reach here
-        }
-      }
-
-    }
-
-    //ok, we add source rows to destination rows
-    PetscUtils::MatAddRowToRow(*jac, src_row, dst_row);
-
-    // clear rows
-    PetscUtils::MatZeroRows(*jac, rm_row.size(), rm_row.empty() ? NULL : &rm_row[0], 0.0);
-
-  }
-
-  // after that, set new Jacobian entrance to source rows
+  // the rows have been added and cleared in DDM2_Jacobian_Preprocess, set new Jacobian entrance to them
   BoundaryCondition::const_node_iterator node_it = nodes_begin();
   BoundaryCondition::const_node_iterator end_it = nodes_end();
   for(node_it = nodes_begin(); node_it!=end_it; ++node_it )
@@ -430,8 +368,6 @@ void ChargedContactBC::DDM2_Jacobian(PetscScalar * x, Mat *jac, InsertMode &add_
         // Insulator-Semiconductor interface at Insulator side, we should add the rows to semiconductor region
       case InsulatorRegion:
         {
-          const FVM_NodeData * node_data = fvm_nodes[i]->node_data();
-
           //the indepedent variable number, we need 2 here.
           adtl::AutoDScalar::numdir=2;
 
@@ -467,31 +403,6 @@ void ChargedContactBC::DDM2_Jacobian(PetscScalar * x, Mat *jac, InsertMode &add_
           MatSetValue(*jac, fvm_nodes[i]->global_offset()+1, fvm_nodes[i]->global_offset()+1, ff2.getADValue(0), ADD_VALUES);
           MatSetValue(*jac, fvm_nodes[i]->global_offset()+1, ghost_fvm_node->global_offset()+1, ff2.getADValue(1), ADD_VALUES);
 
-          // process float metal surface equation
-
-          FVM_Node::fvm_neighbor_node_iterator nb_it = fvm_nodes[i]->neighbor_node_begin();
-          FVM_Node::fvm_neighbor_node_iterator nb_it_end = fvm_nodes[i]->neighbor_node_end();
-          for(; nb_it != nb_it_end; ++nb_it)
-          {
-            const FVM_Node *nb_node = (*nb_it).second;
-            // the psi of neighbor node
-            AutoDScalar V_nb = x[nb_node->local_offset()];  V_nb.setADValue(1,1.0);
-            // distance from nb node to this node
-            PetscScalar distance = (*(fvm_nodes[i]->root_node()) - *(nb_node->root_node())).size();
-            // area of out surface of control volume related with neighbor node,
-            // here we should consider the difference of 2D/3D by multiply z_width
-            PetscScalar cv_boundary = fvm_nodes[i]->cv_surface_area(nb_node->root_node())*z_width;
-            // surface electric field and electrc displacement
-            AutoDScalar E = (V_nb-V)/distance;
-            AutoDScalar D = node_data->eps()*E;
-
-            // since the governing equation is \sum \integral D + \sigma = 0
-            // and \integral D = \sum cv_boundary*D
-            // here we use MatSetValue ADD_VALUES to process \sum \integral D one by one
-            MatSetValue(*jac, this->global_offset(), fvm_nodes[i]->global_offset(), (cv_boundary*D).getADValue(0), ADD_VALUES);
-            MatSetValue(*jac, this->global_offset(), nb_node->global_offset(), (cv_boundary*D).getADValue(1), ADD_VALUES);
-          }
-
           break;
 
         }
@@ -524,6 +435,9 @@ void ChargedContactBC::DDM2_Jacobian(PetscScalar * x, Mat *jac, InsertMode &add_
 
   }
 
+  // the surface integral of electric displacement is linear in psi, its jacobian is the integration weights
+  this->surface_integral_jacobian(jac, this->global_offset());
+
   // the last operator is ADD_VALUES
   add_value_flag = ADD_VALUES;
 }
@@ -22,6 +22,7 @@
 
 #include "elem.h"
 #include "simulation_system.h"
+#include "fvm_edge_assembly.h"
 #include "conductor_region.h"
 #include "solver_specify.h"
 
@@ -97,68 +98,7 @@ void ElectrodeSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, InsertMode
   y.reserve(4*n_edge());
 
   // search all the edges of this region, do integral over control volume...
-  const_edge_iterator it = edges_begin();
-  const_edge_iterator it_end = edges_end();
-  for(; it!=it_end; ++it)
-  {
-    // fvm_node of node1
-    const FVM_Node * fvm_n1 = (*it).first;
-    // fvm_node of node2
-    const FVM_Node * fvm_n2 = (*it).second;
-
-    // fvm_node_data of node1
-    const FVM_NodeData * n1_data =  fvm_n1->node_data();
-    // fvm_node_data of node2
-    const FVM_NodeData * n2_data =  fvm_n2->node_data();
-
-    const unsigned int n1_global_offset = fvm_n1->global_offset();
-    const unsigned int n2_global_offset = fvm_n2->global_offset();
-    const unsigned int n1_local_offset = fvm_n1->local_offset();
-    const unsigned int n2_local_offset = fvm_n2->local_offset();
-
-    {
-      //for node 1 of the edge
-      mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-      PetscScalar V1   =  x[n1_local_offset+0];             // electrostatic potential
-      PetscScalar T1   =  x[n1_local_offset+1];             // lattice temperature
-      PetscScalar rho1 =  0;                                // charge density
-      PetscScalar eps1 =  n1_data->eps();                   // permittivity
-      PetscScalar kap1 =  mt->thermal->HeatConduction(T1);
-
-        //for node 2 of the edge
-      mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
-      PetscScalar V2   =  x[n2_local_offset+0];
-      PetscScalar T2   =  x[n2_local_offset+1];
-      PetscScalar rho2 =  0;
-      PetscScalar eps2 =  n2_data->eps();
-      PetscScalar kap2 =  mt->thermal->HeatConduction(T2);
-
-      PetscScalar eps = 0.5*(eps1+eps2);       // eps at mid point of the edge
-      PetscScalar kap = 0.5*(kap1+kap2);       // kapa at mid point of the edge
-
-
-      // "flux" from node 2 to node 1
-      PetscScalar f_psi =  eps*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
-      PetscScalar f_q =  kap*fvm_n1->cv_surface_area(fvm_n2->root_node())*(T2 - T1)/fvm_n1->distance(fvm_n2) ;
-
-      // ignore thoese ghost nodes
-      if( fvm_n1->on_processor() )
-      {
-        iy.push_back(n1_global_offset+0);
-        y.push_back(f_psi);
-        iy.push_back(n1_global_offset+1);
-        y.push_back(f_q);
-      }
-
-      if( fvm_n2->on_processor() )
-      {
-        iy.push_back(n2_global_offset+0);
-        y.push_back(-f_psi);
-        iy.push_back(n2_global_offset+1);
-        y.push_back(-f_q);
-      }
-    }
-  }
+  FVM_EdgeAssembly::function(*this, FVM_EdgeAssembly::PoissonHeatFlux<Material::MaterialConductor>(*this, mt), x, iy, y);
 
   if(iy.size()) VecSetValues(f, iy.size(), &iy[0], &y[0], ADD_VALUES);
 
@@ -189,77 +129,9 @@ void ElectrodeSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, InsertM
     MatAssemblyEnd(*jac, MAT_FLUSH_ASSEMBLY);
   }
 
-  //the indepedent variable number, since we only process edges, 2 is enough
-  adtl::AutoDScalar::numdir=2;
-
-  //synchronize with material database
-  mt->set_ad_num(adtl::AutoDScalar::numdir);
 
   // search all the edges of this region, do integral over control volume...
-  const_edge_iterator it = edges_begin();
-  const_edge_iterator it_end = edges_end();
-  for(; it!=it_end; ++it)
-  {
-    // fvm_node of node1
-    const FVM_Node * fvm_n1 = (*it).first;
-    // fvm_node of node2
-    const FVM_Node * fvm_n2 = (*it).second;
-
-    // fvm_node_data of node1
-    const FVM_NodeData * n1_data =  fvm_n1->node_data();
-    // fvm_node_data of node2
-    const FVM_NodeData * n2_data =  fvm_n2->node_data();
-
-    const unsigned int n1_global_offset = fvm_n1->global_offset();
-    const unsigned int n2_global_offset = fvm_n2->global_offset();
-    const unsigned int n1_local_offset = fvm_n1->local_offset();
-    const unsigned int n2_local_offset = fvm_n2->local_offset();
-
-    {
-      //for node 1 of the edge
-      mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-      AutoDScalar V1   =  x[n1_local_offset+0];  V1.setADValue(0,1.0);           // electrostatic potential
-      AutoDScalar T1   =  x[n1_local_offset+1];  T1.setADValue(0,1.0);           // lattice temperature
-      PetscScalar rho1 =  0;                                // charge density
-      PetscScalar eps1 =  n1_data->eps();                   // permittivity
-      PetscScalar kap1 =  mt->thermal->HeatConduction(T1.getValue());
-
-      //for node 2 of the edge
-      mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
-      AutoDScalar V2   =  x[n2_local_offset+0];  V2.setADValue(1,1.0);
-      AutoDScalar T2   =  x[n2_local_offset+1];  T2.setADValue(1,1.0);
-      PetscScalar rho2 =  0;
-      PetscScalar eps2 =  n2_data->eps();
-      PetscScalar kap2 =  mt->thermal->HeatConduction(T2.getValue());
-
-      PetscScalar eps = 0.5*(eps1+eps2);       // eps at mid point of the edge
-      PetscScalar kap = 0.5*(kap1+kap2);       // kapa at mid point of the edge
-
-
-      // "flux" from node 2 to node 1
-      AutoDScalar f_psi =  eps*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
-      AutoDScalar f_q =  kap*fvm_n1->cv_surface_area(fvm_n2->root_node())*(T2 - T1)/fvm_n1->distance(fvm_n2) ;
-
-      // ignore thoese ghost nodes
-      if( fvm_n1->on_processor() )
-      {
-        MatSetValue(*jac, n1_global_offset, n1_global_offset, f_psi.getADValue(0), ADD_VALUES);
-        MatSetValue(*jac, n1_global_offset, n2_global_offset, f_psi.getADValue(1), ADD_VALUES);
-
-        MatSetValue(*jac, n1_global_offset+1, n1_global_offset+1, f_q.getADValue(0), ADD_VALUES);
-        MatSetValue(*jac, n1_global_offset+1, n2_global_offset+1, f_q.getADValue(1), ADD_VALUES);
-      }
-
-      if( fvm_n2->on_processor() )
-      {
-        MatSetValue(*jac, n2_global_offset, n1_global_offset, -f_psi.getADValue(0), ADD_VALUES);
-        MatSetValue(*jac, n2_global_offset, n2_global_offset, -f_psi.getADValue(1), ADD_VALUES);
-
-        MatSetValue(*jac, n2_global_offset+1, n1_global_offset+1, -f_q.getADValue(0), ADD_VALUES);
-        MatSetValue(*jac, n2_global_offset+1, n2_global_offset+1, -f_q.getADValue(1), ADD_VALUES);
-      }
-    }
-  }
+  FVM_EdgeAssembly::jacobian(*this, FVM_EdgeAssembly::PoissonHeatFlux<Material::MaterialConductor>(*this, mt), x, jac);
 
 
   // boundary condition should be processed later!
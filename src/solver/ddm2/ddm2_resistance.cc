@@ -228,21 +228,21 @@ void MetalSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, InsertMode
     {
       //for node 1 of the edge
       mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-      AutoDScalar V1   =  x[n1_local_offset+0];  V1.setADValue(0,1.0);           // electrostatic potential
-      AutoDScalar T1   =  x[n1_local_offset+1];  T1.setADValue(0,1.0);           // lattice temperature
+      AutoDScalar2 V1   =  x[n1_local_offset+0];  V1.setADValue(0,1.0);           // electrostatic potential
+      AutoDScalar2 T1   =  x[n1_local_offset+1];  T1.setADValue(0,1.0);           // lattice temperature
       PetscScalar kap1 =  mt->thermal->HeatConduction(T1.getValue());
 
       //for node 2 of the edge
       mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
-      AutoDScalar V2   =  x[n2_local_offset+0];  V2.setADValue(1,1.0);
-      AutoDScalar T2   =  x[n2_local_offset+1];  T2.setADValue(1,1.0);
+      AutoDScalar2 V2   =  x[n2_local_offset+0];  V2.setADValue(1,1.0);
+      AutoDScalar2 T2   =  x[n2_local_offset+1];  T2.setADValue(1,1.0);
       PetscScalar kap2 =  mt->thermal->HeatConduction(T2.getValue());
 
       PetscScalar kap = 0.5*(kap1+kap2);       // kapa at mid point of the edge
 
       // "flux" from node 2 to node 1
-      AutoDScalar f_psi = sigma*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
-      AutoDScalar f_q =  kap*fvm_n1->cv_surface_area(fvm_n2->root_node())*(T2 - T1)/fvm_n1->distance(fvm_n2) ;
+      AutoDScalar2 f_psi = sigma*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
+      AutoDScalar2 f_q =  kap*fvm_n1->cv_surface_area(fvm_n2->root_node())*(T2 - T1)/fvm_n1->distance(fvm_n2) ;
 
       // ignore thoese ghost nodes
       if( fvm_n1->on_processor() )
@@ -43,6 +43,9 @@ using PhysicalUnit::cm;
 
 void SemiconductorSimulationRegion::DDM2_Fill_Value(Vec x, Vec L)
 {
+  // cache the field independent material quantities at the initial lattice temperature
+  update_material_cache(false);
+
   std::vector<int> ix;
   std::vector<PetscScalar> y;
   std::vector<PetscScalar> s;
@@ -609,9 +612,27 @@ void SemiconductorSimulationRegion::DDM2_Function(PetscScalar * x, Vec f, Insert
     y.push_back( Field_G - R  + node_data->EIn());
     y.push_back( Field_G - R  + node_data->HIn());
     y.push_back( HR + OptQ );
+  }
 
-    if (get_advanced_model()->Trap)
+  // bulk trap terms, only the nodes which carry traps are visited
+  if (get_advanced_model()->Trap)
+  {
+    const std::vector<FVM_Node *> & nodes_with_trap = trap_nodes();
+    for(unsigned int i=0; i<nodes_with_trap.size(); ++i)
     {
+      const FVM_Node * fvm_node = nodes_with_trap[i];
+      if( !fvm_node->on_processor() ) continue;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+
+      const unsigned int local_offset  = fvm_node->local_offset();
+      const unsigned int global_offset = fvm_node->global_offset();
+
+      PetscScalar n   =  x[local_offset+1];                         // electron density
+      PetscScalar p   =  x[local_offset+2];                         // hole density
+      PetscScalar T   =  x[local_offset+3];                         // lattice temperature
+
+      mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);      // map this node and its data to material database
+
       // consider charge trapping in semiconductor bulk (bulk_flag=true)
 
       // call the Trap MPI to calculate trap occupancy using the local carrier densities and lattice temperature
@@ -700,6 +721,13 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
     bool truncation =  SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationAlways ||
         (SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationBoundary && (elem->on_boundary() || elem->on_interface())) ;
 
+    // when the edge flux only depends on the two nodes of the edge (no E field or current direction of the cell
+    // is used by mobility, band-band tunneling and impact ionization), the AD of each edge only carries the
+    // 8 variables of its two nodes.
+    bool local_edge_ad = !(highfield_mob && (get_advanced_model()->Mob_Force != ModelSpecify::ESimple || insulator_interface_elem || mos_channel_elem)) &&
+                         !(get_advanced_model()->BandBandTunneling && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM) &&
+                         !(get_advanced_model()->ImpactIonization && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM);
+
     //the indepedent variable number, 4*n_nodes
     adtl::AutoDScalar::numdir = 4*elem->n_nodes();
 
@@ -732,7 +760,7 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
     AutoDScalar Etp=0;
 
     // evaluate E field parallel and vertical to current flow
-    if(highfield_mob)
+    if(highfield_mob && !local_edge_ad)
     {
       // which are the vector of electric field and current density.
       // here use type AutoDScalar, we should make sure the order of independent variable keeps the
@@ -781,7 +809,7 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
       Jpv = - elem->gradient(phip_vertex); // the same as Jnv
     }
 
-    if(highfield_mob)
+    if(highfield_mob && !local_edge_ad)
     {
       // for elem on insulator interface, we will do special treatment to electrical field
       if(get_advanced_model()->ESurface && insulator_interface_elem)
@@ -885,6 +913,13 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
       }
     }
 
+    // only 8 AD directions for each edge
+    if( local_edge_ad )
+    {
+      adtl::AutoDScalar::numdir = 8;
+      mt->set_ad_num(adtl::AutoDScalar::numdir);
+    }
+
     // process conservation terms: laplace operator of poisson's equation and div operator of continuation equation
     // search for all the Edge this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
@@ -925,6 +960,12 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
       for(unsigned int i=0; i<4; ++i) row[i]   = fvm_n1->global_offset()+i;
       for(unsigned int i=0; i<4; ++i) row[i+4] = fvm_n2->global_offset()+i;
 
+      // the AD index of the two nodes, and the matrix columns of the AD directions
+      const unsigned int nd1 = local_edge_ad ? 0 : edge_nodes.first;
+      const unsigned int nd2 = local_edge_ad ? 1 : edge_nodes.second;
+      const PetscInt * col = local_edge_ad ? &row[0] : &cell_col[0];
+      const PetscInt n_col = local_edge_ad ? 8 : cell_col.size();
+
 
       // here we use AD again. Can we hand write it for more efficient?
       {
@@ -932,10 +973,10 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
         //for node 1 of the edge
         mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
 
-        AutoDScalar V1   =  x[n1_local_offset+0];       V1.setADValue(4*edge_nodes.first+0, 1.0);           // electrostatic potential
-        AutoDScalar n1   =  x[n1_local_offset+1];       n1.setADValue(4*edge_nodes.first+1, 1.0);           // electron density
-        AutoDScalar p1   =  x[n1_local_offset+2];       p1.setADValue(4*edge_nodes.first+2, 1.0);           // hole density
-        AutoDScalar T1   =  x[n1_local_offset+3];       T1.setADValue(4*edge_nodes.first+3, 1.0);           // lattice temperature
+        AutoDScalar V1   =  x[n1_local_offset+0];       V1.setADValue(4*nd1+0, 1.0);           // electrostatic potential
+        AutoDScalar n1   =  x[n1_local_offset+1];       n1.setADValue(4*nd1+1, 1.0);           // electron density
+        AutoDScalar p1   =  x[n1_local_offset+2];       p1.setADValue(4*nd1+2, 1.0);           // hole density
+        AutoDScalar T1   =  x[n1_local_offset+3];       T1.setADValue(4*nd1+3, 1.0);           // lattice temperature
 
         AutoDScalar Ec1 =  -(e*V1 + n1_data->affinity() + kb*T1*log(mt->band->nie(p1, n1, T1)));//conduct band energy level
         AutoDScalar Ev1 =  -(e*V1 + n1_data->affinity() - kb*T1*log(mt->band->nie(p1, n1, T1)));//valence band energy level
@@ -952,10 +993,10 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
         //for node 2 of the edge
         mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
 
-        AutoDScalar V2   =  x[n2_local_offset+0];       V2.setADValue(4*edge_nodes.second+0, 1.0);             // electrostatic potential
-        AutoDScalar n2   =  x[n2_local_offset+1];       n2.setADValue(4*edge_nodes.second+1, 1.0);             // electron density
-        AutoDScalar p2   =  x[n2_local_offset+2];       p2.setADValue(4*edge_nodes.second+2, 1.0);             // hole density
-        AutoDScalar T2   =  x[n2_local_offset+3];       T2.setADValue(4*edge_nodes.second+3, 1.0);             // hole density
+        AutoDScalar V2   =  x[n2_local_offset+0];       V2.setADValue(4*nd2+0, 1.0);             // electrostatic potential
+        AutoDScalar n2   =  x[n2_local_offset+1];       n2.setADValue(4*nd2+1, 1.0);             // electron density
+        AutoDScalar p2   =  x[n2_local_offset+2];       p2.setADValue(4*nd2+2, 1.0);             // hole density
+        AutoDScalar T2   =  x[n2_local_offset+3];       T2.setADValue(4*nd2+3, 1.0);             // hole density
 
         AutoDScalar Ec2 =  -(e*V2 + n2_data->affinity() + kb*T2*log(mt->band->nie(p2, n2, T2)));//conduct band energy level
         AutoDScalar Ev2 =  -(e*V2 + n2_data->affinity() - kb*T2*log(mt->band->nie(p2, n2, T2)));//valence band energy level
@@ -1045,10 +1086,10 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
           AutoDScalar ff4 = ( kap*(T2 - T1)/length*partial_area + H*truncated_partial_area);
 
           // general coding always has some overkill... bypass it.
-          MatSetValues(*jac, 1, &row[0], cell_col.size(), &cell_col[0], ff1.getADValue(), ADD_VALUES);
-          MatSetValues(*jac, 1, &row[1], cell_col.size(), &cell_col[0], ff2.getADValue(), ADD_VALUES);
-          MatSetValues(*jac, 1, &row[2], cell_col.size(), &cell_col[0], ff3.getADValue(), ADD_VALUES);
-          MatSetValues(*jac, 1, &row[3], cell_col.size(), &cell_col[0], ff4.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row[0], n_col, col, ff1.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row[1], n_col, col, ff2.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row[2], n_col, col, ff3.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row[3], n_col, col, ff4.getADValue(), ADD_VALUES);
         }
 
         if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
@@ -1061,10 +1102,10 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
 
           AutoDScalar ff4 = ( kap*(T1 - T2)/length*partial_area + H*truncated_partial_area);
 
-          MatSetValues(*jac, 1, &row[4], cell_col.size(), &cell_col[0], ff1.getADValue(), ADD_VALUES);
-          MatSetValues(*jac, 1, &row[5], cell_col.size(), &cell_col[0], ff2.getADValue(), ADD_VALUES);
-          MatSetValues(*jac, 1, &row[6], cell_col.size(), &cell_col[0], ff3.getADValue(), ADD_VALUES);
-          MatSetValues(*jac, 1, &row[7], cell_col.size(), &cell_col[0], ff4.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row[4], n_col, col, ff1.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row[5], n_col, col, ff2.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row[6], n_col, col, ff3.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row[7], n_col, col, ff4.getADValue(), ADD_VALUES);
         }
 
         if (get_advanced_model()->BandBandTunneling && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM)
@@ -1076,16 +1117,16 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT1*truncated_partial_volume;
-            MatSetValues(*jac, 1, &row[1], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row[2], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row[1], n_col, col, continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row[2], n_col, col, continuity.getADValue(), ADD_VALUES);
           }
 
           if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT2*truncated_partial_volume;
-            MatSetValues(*jac, 1, &row[5], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row[6], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row[5], n_col, col, continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row[6], n_col, col, continuity.getADValue(), ADD_VALUES);
           }
         }
 
@@ -1141,8 +1182,8 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
             // continuity equation
             AutoDScalar electron_continuity = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
-            MatSetValues(*jac, 1, &row[1], cell_col.size(), &cell_col[0], electron_continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row[2], cell_col.size(), &cell_col[0], hole_continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row[1], n_col, col, electron_continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row[2], n_col, col, hole_continuity.getADValue(), ADD_VALUES);
           }
 
           if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
@@ -1150,8 +1191,8 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
             // continuity equation
             AutoDScalar electron_continuity = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
-            MatSetValues(*jac, 1, &row[5], cell_col.size(), &cell_col[0], electron_continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row[6], cell_col.size(), &cell_col[0], hole_continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row[5], n_col, col, electron_continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row[6], n_col, col, hole_continuity.getADValue(), ADD_VALUES);
           }
         }
 
@@ -1199,8 +1240,27 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
     MatSetValues(*jac, 1, &index[2], 4, &index[0], (-R).getADValue(),   ADD_VALUES);
     MatSetValues(*jac, 1, &index[3], 4, &index[0], HR.getADValue(),  ADD_VALUES);
 
-    if (get_advanced_model()->Trap)
+  }
+
+  // bulk trap terms, only the nodes which carry traps are visited
+  if (get_advanced_model()->Trap)
+  {
+    const std::vector<FVM_Node *> & nodes_with_trap = trap_nodes();
+    for(unsigned int i=0; i<nodes_with_trap.size(); ++i)
     {
+      const FVM_Node * fvm_node = nodes_with_trap[i];
+      if( !fvm_node->on_processor() ) continue;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+
+      PetscInt index[4] = {fvm_node->global_offset()+0, fvm_node->global_offset()+1,
+                           fvm_node->global_offset()+2, fvm_node->global_offset()+3};
+
+      AutoDScalar n   =  x[fvm_node->local_offset()+1];   n.setADValue(1, 1.0);              // electron density
+      AutoDScalar p   =  x[fvm_node->local_offset()+2];   p.setADValue(2, 1.0);              // hole density
+      AutoDScalar T   =  x[fvm_node->local_offset()+3];   T.setADValue(3, 1.0);              // lattice temperature
+
+      mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);                   // map this node and its data to material database
+
       AutoDScalar ni = mt->band->nie(p, n, T);
       mt->trap->Calculate(true,p,n,ni,T);
 
@@ -1219,7 +1279,6 @@ void SemiconductorSimulationRegion::DDM2_Jacobian(PetscScalar * x, Mat *jac, Ins
       MatSetValues(*jac, 1, &index[3], 4, &index[0], (H*fvm_node->volume()).getADValue(),   ADD_VALUES);
 
     }
-
   }
 
 
@@ -1453,35 +1512,26 @@ void SemiconductorSimulationRegion::DDM2_Update_Solution(PetscScalar *lxx)
     node_data->Recomb_SRH() = mt->band->R_SHR(p, n, T);
     node_data->Recomb_Auger() = mt->band->R_Auger(p, n, T);
 
-    if (get_advanced_model()->Trap)
+  }
+
+  // update traps, only the nodes which carry traps are visited
+  if (get_advanced_model()->Trap)
+  {
+    const std::vector<FVM_Node *> & nodes_with_trap = trap_nodes();
+    for(unsigned int i=0; i<nodes_with_trap.size(); ++i)
     {
-      // update traps
+      FVM_Node * fvm_node = nodes_with_trap[i];
+      FVM_NodeData * node_data = fvm_node->node_data();
       mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);
-      mt->trap->Update(true, p, n, node_data->ni(), T_external());
-      mt->trap->Update(false, p, n, node_data->ni(), T_external());
+      mt->trap->Update(true, node_data->p(), node_data->n(), node_data->ni(), T_external());
+      mt->trap->Update(false, node_data->p(), node_data->n(), node_data->ni(), T_external());
     }
-
   }
 
   // addtional work: compute electrical field for all the cell.
   // Since this value is only used for reference.
   // It can be done simply by weighted average of cell's electrical field
-  for(unsigned int n=0; n<n_cell(); ++n)
-  {
-    const Elem * elem = this->get_region_elem(n);
-    FVM_CellData * elem_data = this->get_region_elem_data(n);
-
-    std::vector<PetscScalar> psi_vertex;
-
-    for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
-    {
-      const FVM_Node * fvm_node = elem->get_fvm_node(nd);
-      const FVM_NodeData * fvm_node_data = fvm_node->node_data();
-      psi_vertex.push_back  ( fvm_node_data->psi() );
-    }
-    // compute the gradient in the cell
-    elem_data->E()  = - elem->gradient(psi_vertex);  // E = - grad(psi)
-  }
+  this->update_cell_electric_field();
 
 
 }
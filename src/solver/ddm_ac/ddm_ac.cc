@@ -20,6 +20,8 @@
 /********************************************************************************/
 
 #include <iomanip>
+#include <vector>
+#include <cmath>
 
 #include "ddm_ac/ddm_ac.h"
 #include "parallel.h"
@@ -251,6 +253,41 @@ int DDMACSolver::solve()
 
   this->pre_solve_process();
 
+  // frequency sweep by reduced model
+  if ( SolverSpecify::ACMOROrder > 0 && solve_mor() )
+  {
+    STOP_LOG ( "ACSolver()", "KSP_Solver" );
+    return 0;
+  }
+
+  // batched frequency mode: reuse the factorization of the first frequency of each batch
+  // as preconditioner of GMRES for the other frequencies
+  bool affine = false;
+  Mat K, G, TK, TG;
+  Vec b0;
+  if ( SolverSpecify::ACBatch > 1 )
+  {
+    // when the AC system is affine in omega, the other frequencies of a batch are built as
+    // A = T (K + omega G) with the transformation matrix T of the first frequency, instead of full assembly
+    affine = split_ddm_ac ( 2*PI*SolverSpecify::FStart, K, G, b0 );
+    if ( !affine )
+    {
+      MESSAGE<<"Warning: AC system is not affine in frequency (electrode with inductance?), assemble each frequency of batch.\n\n";
+      RECORD();
+    }
+
+    // direct solver applies the factorization only once, use it as preconditioner of GMRES instead
+    if ( linear_solver_type() >= SolverSpecify::LU && linear_solver_type() <= SolverSpecify::GSS )
+    {
+      KSPSetType ( ksp, (char*) KSPGMRES );
+      KSPGMRESSetRestart ( ksp, 100 );
+    }
+    // the solution of last frequency is a good initial guess
+    KSPSetInitialGuessNonzero ( ksp, PETSC_TRUE );
+  }
+
+  unsigned int batch_count = 0;
+  bool batch_split_created = false;
 
   for ( SolverSpecify::Freq = SolverSpecify::FStart; SolverSpecify::Freq <= SolverSpecify::FStop;  )
   {
@@ -263,13 +300,46 @@ int DDMACSolver::solve()
     <<SolverSpecify::Freq*PhysicalUnit::s/1e6<<" MHz "<<"\n";
     RECORD();
 
-    build_ddm_ac ( omega );
+    // factorize the matrix only at the first frequency of batch
+    bool refactor = ( batch_count == 0 );
+
+    if ( affine && !refactor )
+    {
+      // keep the transformation matrix and the rhs b = T b0 of the first frequency
+      MatCopy ( TK, A, DIFFERENT_NONZERO_PATTERN );
+      MatAXPY ( A, omega, TG, DIFFERENT_NONZERO_PATTERN );
+    }
+    else
+    {
+      build_ddm_ac ( omega );
+      if ( affine )
+      {
+        MatReuse reuse = batch_split_created ? MAT_REUSE_MATRIX : MAT_INITIAL_MATRIX;
+        MatMatMult ( T_, K, reuse, PETSC_DEFAULT, &TK );
+        MatMatMult ( T_, G, reuse, PETSC_DEFAULT, &TG );
+        batch_split_created = true;
+      }
+    }
+
+    KSPSetOperators ( ksp, A, A, refactor ? SAME_NONZERO_PATTERN : SAME_PRECONDITIONER );
 
     KSPSolve ( ksp, b, x );
 
     KSPConvergedReason reason;
     KSPGetConvergedReason ( ksp, &reason );
 
+    // the old factorization does not work for this frequency, update it
+    if ( reason < 0 && !refactor )
+    {
+      MESSAGE<<"------> preconditioner of frequency batch failed with "<<KSPConvergedReasons[reason]<<", refactorize...\n";
+      RECORD();
+      KSPSetOperators ( ksp, A, A, SAME_NONZERO_PATTERN );
+      KSPSolve ( ksp, b, x );
+      KSPGetConvergedReason ( ksp, &reason );
+      batch_count = 0;
+    }
+    batch_count = ( batch_count+1 ) % SolverSpecify::ACBatch;
+
     PetscInt   its;
     KSPGetIterationNumber ( ksp, &its );
 
@@ -287,6 +357,17 @@ int DDMACSolver::solve()
       SolverSpecify::Freq*=SolverSpecify::FMultiple;
   }
 
+  if ( affine )
+  {
+    MatDestroy ( K );
+    MatDestroy ( G );
+    VecDestroy ( b0 );
+    if ( batch_split_created )
+    {
+      MatDestroy ( TK );
+      MatDestroy ( TG );
+    }
+  }
 
   STOP_LOG ( "ACSolver()", "KSP_Solver" );
 
@@ -296,6 +377,252 @@ int DDMACSolver::solve()
 
 
 
+/*------------------------------------------------------------------
+ * time the assembly and solve of AC system at one frequency
+ */
+void DDMACSolver::benchmark_frequency ( double omega, double & t_build, double & t_solve, KSPConvergedReason & reason )
+{
+  PetscLogDouble t0, t1, t2;
+
+  PetscGetTime ( &t0 );
+  build_ddm_ac ( omega );
+  PetscGetTime ( &t1 );
+  KSPSolve ( ksp, b, x );
+  PetscGetTime ( &t2 );
+
+  KSPGetConvergedReason ( ksp, &reason );
+
+  t_build = t1-t0;
+  t_solve = t2-t1;
+}
+
+
+
+/*------------------------------------------------------------------
+ * solve the small dense system a y = r by gauss elimination with partial pivoting,
+ * a is stored row by row, and destroyed on return. r is replaced by solution y
+ */
+static void dense_solve ( std::vector<PetscScalar> & a, std::vector<PetscScalar> & r )
+{
+  const unsigned int n = r.size();
+  for ( unsigned int k=0; k<n; ++k )
+  {
+    unsigned int p = k;
+    for ( unsigned int i=k+1; i<n; ++i )
+      if ( std::abs ( a[i*n+k] ) > std::abs ( a[p*n+k] ) ) p = i;
+    if ( p != k )
+    {
+      for ( unsigned int j=0; j<n; ++j ) std::swap ( a[k*n+j], a[p*n+j] );
+      std::swap ( r[k], r[p] );
+    }
+    for ( unsigned int i=k+1; i<n; ++i )
+    {
+      PetscScalar f = a[i*n+k]/a[k*n+k];
+      for ( unsigned int j=k; j<n; ++j ) a[i*n+j] -= f*a[k*n+j];
+      r[i] -= f*r[k];
+    }
+  }
+  for ( int i=n-1; i>=0; --i )
+  {
+    for ( unsigned int j=i+1; j<n; ++j ) r[i] -= a[i*n+j]*r[j];
+    r[i] /= a[i*n+i];
+  }
+}
+
+
+
+/*------------------------------------------------------------------
+ * split the AC system into K + omega G
+ */
+bool DDMACSolver::split_ddm_ac ( double omega_check, Mat & K, Mat & G, Vec & b0 )
+{
+  build_ddm_ac ( 0.0 );
+  MatDuplicate ( A_, MAT_COPY_VALUES, &K );
+  VecDuplicate ( b_, &b0 );
+  VecCopy ( b_, b0 );
+
+  build_ddm_ac ( 1.0 );
+  MatDuplicate ( A_, MAT_COPY_VALUES, &G );
+  MatAXPY ( G, -1.0, K, DIFFERENT_NONZERO_PATTERN );
+
+  build_ddm_ac ( omega_check );
+
+  // check the AC system is affine in omega, and the rhs does not depend on omega
+  Mat E;
+  Vec e;
+  PetscReal e_norm, a_norm, eb_norm, b_norm;
+  MatDuplicate ( A_, MAT_COPY_VALUES, &E );
+  MatAXPY ( E, -1.0, K, DIFFERENT_NONZERO_PATTERN );
+  MatAXPY ( E, -omega_check, G, DIFFERENT_NONZERO_PATTERN );
+  MatNorm ( E, NORM_FROBENIUS, &e_norm );
+  MatNorm ( A_, NORM_FROBENIUS, &a_norm );
+  MatDestroy ( E );
+
+  VecDuplicate ( b_, &e );
+  VecWAXPY ( e, -1.0, b0, b_ );
+  VecNorm ( e, NORM_2, &eb_norm );
+  VecNorm ( b_, NORM_2, &b_norm );
+  VecDestroy ( e );
+
+  if ( e_norm > 1e-10*a_norm || eb_norm > 1e-10*b_norm )
+  {
+    MatDestroy ( K );
+    MatDestroy ( G );
+    VecDestroy ( b0 );
+    return false;
+  }
+
+  return true;
+}
+
+
+
+/*------------------------------------------------------------------
+ * AC sweep by reduced model
+ */
+bool DDMACSolver::solve_mor()
+{
+  Mat K, G;
+  Vec b0, r;
+
+  // the center frequency of the sweep, as expansion point
+  const double omega0 = 2*PI*std::sqrt ( SolverSpecify::FStart*SolverSpecify::FStop );
+
+  // split the AC system into K + omega G, checked at the expansion point
+  if ( !split_ddm_ac ( omega0, K, G, b0 ) )
+  {
+    MESSAGE<<"Warning: AC system is not affine in frequency (electrode with inductance?), reduced model is not used.\n\n";
+    RECORD();
+    return false;
+  }
+
+  MESSAGE<<"Build reduced AC model of order "<<SolverSpecify::ACMOROrder<<" at "
+  <<omega0/(2*PI)*PhysicalUnit::s/1e6<<" MHz...\n";
+  RECORD();
+
+  // factorize K + omega0 G, which is preconditioned by the transformation matrix as in full AC solve
+  KSPSetOperators ( ksp, A, A, SAME_NONZERO_PATTERN );
+  VecDuplicate ( b0, &r );
+
+  // orthonormal basis of Krylov subspace
+  std::vector<Vec> V;
+  for ( unsigned int k=0; k<SolverSpecify::ACMOROrder; ++k )
+  {
+    // the next krylov vector, solve (K + omega0 G) v = r with r = b0 or G v_{k-1}
+    Vec v;
+    VecDuplicate ( b0, &v );
+    if ( k==0 )
+      VecCopy ( b0, r );
+    else
+      MatMult ( G, V.back(), r );
+    MatMult ( T_, r, b );
+    KSPSolve ( ksp, b, v );
+
+    // modified Gram-Schmidt, applied twice for stability
+    PetscReal v_norm0;
+    VecNorm ( v, NORM_2, &v_norm0 );
+    for ( unsigned int pass=0; pass<2; ++pass )
+      for ( unsigned int i=0; i<V.size(); ++i )
+      {
+        PetscScalar h;
+        VecDot ( v, V[i], &h );
+        VecAXPY ( v, -h, V[i] );
+      }
+
+    PetscReal v_norm;
+    VecNorm ( v, NORM_2, &v_norm );
+    // krylov subspace is exhausted
+    if ( v_norm < 1e-12*v_norm0 || v_norm == 0.0 )
+    {
+      VecDestroy ( v );
+      break;
+    }
+    VecScale ( v, 1.0/v_norm );
+    V.push_back ( v );
+  }
+
+  const unsigned int q = V.size();
+  MESSAGE<<"------> reduced model order "<<q<<"\n\n";
+  RECORD();
+
+  // zero excitation, nothing to reduce
+  if ( q==0 )
+  {
+    MatDestroy ( K );
+    MatDestroy ( G );
+    VecDestroy ( b0 );
+    VecDestroy ( r );
+    return false;
+  }
+
+  // reduced matrices Kr = V^T K V, Gr = V^T G V and rhs br = V^T b0
+  std::vector<PetscScalar> Kr ( q*q ), Gr ( q*q ), br ( q );
+  VecMDot ( b0, q, &V[0], &br[0] );
+  for ( unsigned int j=0; j<q; ++j )
+  {
+    std::vector<PetscScalar> col ( q );
+    MatMult ( K, V[j], r );
+    VecMDot ( r, q, &V[0], &col[0] );
+    for ( unsigned int i=0; i<q; ++i ) Kr[i*q+j] = col[i];
+
+    MatMult ( G, V[j], r );
+    VecMDot ( r, q, &V[0], &col[0] );
+    for ( unsigned int i=0; i<q; ++i ) Gr[i*q+j] = col[i];
+  }
+
+  PetscReal b_norm;
+  VecNorm ( b0, NORM_2, &b_norm );
+
+  // evaluate reduced model at each frequency
+  for ( SolverSpecify::Freq = SolverSpecify::FStart; SolverSpecify::Freq <= SolverSpecify::FStop;  )
+  {
+    double omega = 2*PI*SolverSpecify::Freq;
+
+    MESSAGE
+    <<"AC Scan: f("<<SolverSpecify::Electrode_ACScan[0]<<") = "
+    << std::setiosflags ( std::ios::fixed )
+    <<SolverSpecify::Freq*PhysicalUnit::s/1e6<<" MHz "<<"\n";
+    RECORD();
+
+    std::vector<PetscScalar> Ar ( q*q ), y ( br );
+    for ( unsigned int i=0; i<q*q; ++i ) Ar[i] = Kr[i] + omega*Gr[i];
+    dense_solve ( Ar, y );
+
+    // project back to full space
+    VecZeroEntries ( x );
+    VecMAXPY ( x, q, &y[0], &V[0] );
+
+    // residual of full AC system, measures the quality of reduced model
+    PetscReal rnorm;
+    MatMult ( K, x, r );
+    VecAXPY ( r, -1.0, b0 );
+    MatMult ( G, x, b_ );
+    VecAXPY ( r, omega, b_ );
+    VecNorm ( r, NORM_2, &rnorm );
+
+    MESSAGE<<"------> relative residual norm of reduced model = "<<rnorm/b_norm<<"\n\n";
+    RECORD();
+
+    this->post_solve_process();
+
+    if( SolverSpecify::Freq  < SolverSpecify::FStop && SolverSpecify::Freq*SolverSpecify::FMultiple > SolverSpecify::FStop)
+      SolverSpecify::Freq  = SolverSpecify::FStop;
+    else
+      SolverSpecify::Freq*=SolverSpecify::FMultiple;
+  }
+
+  for ( unsigned int k=0; k<q; ++k )
+    VecDestroy ( V[k] );
+  MatDestroy ( K );
+  MatDestroy ( G );
+  VecDestroy ( b0 );
+  VecDestroy ( r );
+
+  return true;
+}
+
+
+
 /*------------------------------------------------------------------
  * call this function after each solution process
  */
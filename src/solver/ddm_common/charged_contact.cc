@@ -0,0 +1,118 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+// C++ includes
+#include <map>
+
+// Local includes
+#include "simulation_system.h"
+#include "simulation_region.h"
+#include "boundary_condition_charge.h"
+
+
+/*---------------------------------------------------------------------
+ * build the integration weights of float metal surface integral
+ */
+void ChargedContactBC::build_surface_integral_weights()
+{
+  // for 2D mesh, z_width() is the device dimension in Z direction; for 3D mesh, z_width() is 1.0
+  PetscScalar z_width = this->z_width();
+
+  // weight of each psi dof, by global offset. the insulator node and its neighbors share the dofs
+  std::map<PetscInt, std::pair<PetscInt, PetscScalar> > weights;
+
+  const std::vector<RegionNode> & table = this->region_node_table();
+  for(unsigned int n=0; n<table.size(); ++n)
+  {
+    // skip node not belongs to this processor
+    if( table[n].node->processor_id()!=Genius::processor_id() ) continue;
+    if( table[n].region->type() != InsulatorRegion ) continue;
+
+    const FVM_Node * insulator_node = table[n].fvm_node;
+    const PetscScalar eps = insulator_node->node_data()->eps();
+
+    std::pair<PetscInt, PetscScalar> & w = weights[insulator_node->global_offset()];
+    w.first = insulator_node->local_offset();
+
+    FVM_Node::fvm_neighbor_node_iterator nb_it = insulator_node->neighbor_node_begin();
+    FVM_Node::fvm_neighbor_node_iterator nb_it_end = insulator_node->neighbor_node_end();
+    for(; nb_it != nb_it_end; ++nb_it)
+    {
+      const FVM_Node *nb_node = (*nb_it).second;
+      // distance from nb node to this node
+      PetscScalar distance = insulator_node->distance(nb_node);
+      // area of out surface of control volume related with neighbor node,
+      // here we should consider the difference of 2D/3D by multiply z_width
+      PetscScalar cv_boundary = insulator_node->cv_surface_area(nb_node->root_node())*z_width;
+      // electric displacement cv_boundary*eps*(V_nb-V)/distance
+      PetscScalar g = cv_boundary*eps/distance;
+
+      std::pair<PetscInt, PetscScalar> & w_nb = weights[nb_node->global_offset()];
+      w_nb.first = nb_node->local_offset();
+      w_nb.second += g;
+      weights[insulator_node->global_offset()].second -= g;
+    }
+  }
+
+  this->clear_solver_data();
+
+  std::map<PetscInt, std::pair<PetscInt, PetscScalar> >::const_iterator it = weights.begin();
+  for(; it != weights.end(); ++it)
+  {
+    _surface_weight_global_offset.push_back(it->first);
+    _surface_weight_local_offset.push_back(it->second.first);
+    _surface_weight.push_back(it->second.second);
+  }
+}
+
+
+/*---------------------------------------------------------------------
+ * clear the integration weights, they are only valid for the solver they were built for
+ */
+void ChargedContactBC::clear_solver_data()
+{
+  _surface_weight_local_offset.clear();
+  _surface_weight_global_offset.clear();
+  _surface_weight.clear();
+}
+
+
+/*---------------------------------------------------------------------
+ * surface integral of electric displacement on this processor
+ */
+PetscScalar ChargedContactBC::surface_integral(const PetscScalar *x) const
+{
+  PetscScalar sum = 0.0;
+  for(unsigned int i=0; i<_surface_weight.size(); ++i)
+    sum += _surface_weight[i]*x[_surface_weight_local_offset[i]];
+  return sum;
+}
+
+
+/*---------------------------------------------------------------------
+ * add jacobian of surface integral of electric displacement to row
+ */
+void ChargedContactBC::surface_integral_jacobian(Mat *jac, PetscInt row) const
+{
+  if( _surface_weight.empty() ) return;
+  MatSetValues(*jac, 1, &row, _surface_weight.size(), &_surface_weight_global_offset[0], &_surface_weight[0], ADD_VALUES);
+}
@@ -21,6 +21,10 @@
 
 //  $Id: ddm_solver.cc,v 1.11 2008/07/09 05:58:16 gdiso Exp $
 #include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
 #include <stack>
 
 #include "solver_specify.h"
@@ -28,7 +32,11 @@
 #include "electrical_source.h"
 #include "field_source.h"
 #include "ddm_solver.h"
+#include "material.h"
 #include "MXMLUtil.h"
+#include "parallel.h"
+#include "solver_stats.h"
+#include "perf_log.h"
 
 
 DDMSolverBase::DDMSolverBase(SimulationSystem & system): FVM_NonlinearSolver(system)
@@ -171,6 +179,8 @@ int DDMSolverBase::solve_equ()
   PetscInt lits;
   SNESGetLinearSolveIterations(snes, &lits);
 
+  record_step_stats("equilibrium", 0.0, 0, false);
+
   // print convergence/divergence reason
   {
     MESSAGE
@@ -184,6 +194,25 @@ int DDMSolverBase::solve_equ()
 
 
 
+/*----------------------------------------------------------------------------
+ * the max difference of applied voltage between two electrode bias, huge when the applied currents differ
+ */
+static PetscScalar bias_distance(const std::vector<PetscScalar> & vapp0, const std::vector<PetscScalar> & iapp0,
+                                 const std::vector<PetscScalar> & vapp1, const std::vector<PetscScalar> & iapp1)
+{
+  if ( vapp0.size() != vapp1.size() || iapp0.size() != iapp1.size() ) return 1e100;
+
+  for ( unsigned int i=0; i<iapp0.size(); ++i )
+    if ( std::abs ( iapp0[i]-iapp1[i] ) > 1e-9*std::max ( std::abs ( iapp0[i] ), std::abs ( iapp1[i] ) ) ) return 1e100;
+
+  PetscScalar d = 0.0;
+  for ( unsigned int i=0; i<vapp0.size(); ++i )
+    d = std::max ( d, std::abs ( vapp0[i]-vapp1[i] ) );
+  return d;
+}
+
+
+
 /* ----------------------------------------------------------------------------
  * compute steadystate
  * all the stimulate source(s) are set with transient time 0 value. time step set to inf
@@ -193,6 +222,10 @@ int DDMSolverBase::solve_steadystate()
   MESSAGE<<"Compute steady-state\n";
   RECORD();
 
+  // the electrode bias of the last solution
+  std::vector<PetscScalar> vapp0, iapp0;
+  electrode_bias(vapp0, iapp0);
+
   // set electrode with transient time 0 value of stimulate source(s)
   _system.get_sources()->update ( 0 );
   _system.get_field_source()->update ( 0 );
@@ -205,20 +238,39 @@ int DDMSolverBase::solve_steadystate()
   // call pre_solve_process
   this->pre_solve_process();
 
+  // a solution of earlier SOLVE nearer to this bias than the last one
+  {
+    std::vector<PetscScalar> vapp, iapp;
+    electrode_bias(vapp, iapp);
+    load_bias_solution ( bias_distance ( vapp, iapp, vapp0, iapp0 ) );
+  }
+
   // here call Petsc to solve the nonlinear equations
   sens_solve();
 
-  // call post_solve_process
-  this->post_solve_process();
-
   // get the converged reason
   SNESConvergedReason reason;
   SNESGetConvergedReason ( snes, &reason );
 
+  // Newton failed from the last solution, try continuation
+  if ( reason <= 0 && SolverSpecify::Homotopy )
+  {
+    homotopy_solve ( vapp0, iapp0 );
+    SNESGetConvergedReason ( snes, &reason );
+  }
+
+  // call post_solve_process
+  this->post_solve_process();
+
+  if ( reason>0 )
+    cache_bias_solution();
+
   // linear solver iteration
   PetscInt lits;
   SNESGetLinearSolveIterations(snes, &lits);
 
+  record_step_stats("steadystate", 0.0, 0, false);
+
   // print convergence/divergence reason
   {
     MESSAGE
@@ -239,6 +291,22 @@ int DDMSolverBase::solve_steadystate()
  */
 int DDMSolverBase::solve_dcsweep()
 {
+  // voltage scan shared by the bias process groups
+  if ( SolverSpecify::ParallelBias > 1 && SolverSpecify::Electrode_VScan.size() )
+    return solve_dcsweep_parallel_bias();
+
+  if ( SolverSpecify::ParallelBias > 1 )
+  {
+    MESSAGE<<"Warning: parallel.bias only applies to voltage scan, current scan is solved in serial.\n\n";
+    RECORD();
+  }
+
+  // nonzero when the sweep gives up before the stop bias
+  int ierr = 0;
+
+  // the electrode bias of the last solution
+  std::vector<PetscScalar> vapp0, iapp0;
+  electrode_bias(vapp0, iapp0);
 
   // set electrode with transient time 0 value of stimulate source(s)
   _system.get_sources()->update ( 0 );
@@ -287,9 +355,9 @@ int DDMSolverBase::solve_dcsweep()
     Vec xs1, xs2, xs3;
     PetscScalar Vs1=Vscan, Vs2=Vscan, Vs3=Vscan;
     std::stack<PetscScalar> V_retry;
-    VecDuplicate ( x,&xs1 );
-    VecDuplicate ( x,&xs2 );
-    VecDuplicate ( x,&xs3 );
+    xs1 = get_work_vector();
+    xs2 = get_work_vector();
+    xs3 = get_work_vector();
 
     // main loop
     for ( SolverSpecify::DC_Cycles=0;  (Vscan*SolverSpecify::VStep) <= SolverSpecify::VStop*SolverSpecify::VStep* ( 1.0+1e-7 ); )
@@ -311,6 +379,14 @@ int DDMSolverBase::solve_dcsweep()
       else
         this->pre_solve_process ( false );
 
+      // the first bias point may be nearer to a solution of earlier SOLVE than to the last one,
+      // later ones only take the solution of the same bias
+      {
+        std::vector<PetscScalar> vapp, iapp;
+        electrode_bias(vapp, iapp);
+        load_bias_solution ( SolverSpecify::DC_Cycles == 0 ? bias_distance ( vapp, iapp, vapp0, iapp0 ) : 1e-6*PhysicalUnit::V );
+      }
+
       // here call Petsc to solve the nonlinear equations
       sens_solve();
 
@@ -318,17 +394,36 @@ int DDMSolverBase::solve_dcsweep()
       SNESConvergedReason reason;
       SNESGetConvergedReason ( snes,&reason );
 
+      // Newton failed at the first bias point, try continuation from the last solution
+      if ( reason<=0 && SolverSpecify::DC_Cycles == 0 && SolverSpecify::Homotopy )
+      {
+        homotopy_solve ( vapp0, iapp0 );
+        SNESGetConvergedReason ( snes,&reason );
+      }
+
       // linear solver iteration
       PetscInt lits;
       SNESGetLinearSolveIterations(snes, &lits);
       total_lits += lits;
 
+      record_step_stats("dcsweep", Vscan/PhysicalUnit::V, static_cast<int>(V_retry.size()),
+                        reason<=0 && SolverSpecify::DC_Cycles>0 && V_retry.size()<8);
+
       if ( reason>0 ) //ok, converged.
       {
 
         // call post_solve_process
         this->post_solve_process();
 
+        cache_bias_solution();
+
+        // a hook has got what it wants
+        if ( this->stop_requested() )
+        {
+          MESSAGE<<"Solve stopped by request: " << this->stop_reason() << "\n\n\n"; RECORD();
+          break;
+        }
+
         SolverSpecify::DC_Cycles++;
 
         // save solution for linear/quadratic projection
@@ -355,8 +450,8 @@ int DDMSolverBase::solve_dcsweep()
         if ( fabs ( Vscan-SolverSpecify::VStop ) <1e-10 )
           Vscan=SolverSpecify::VStop;
 
-        // if v step small than VStepMax, mult by factor of 1.1
-        if ( fabs ( VStep ) < fabs ( SolverSpecify::VStepMax ) )  VStep *= 1.1;
+        // adjust v step, bounded by VStepMax
+        VStep = sweep_step ( VStep, SolverSpecify::VStepMax );
 
 
         // however, for last step, we force V equal to VStop
@@ -378,12 +473,14 @@ int DDMSolverBase::solve_dcsweep()
         {
           MESSAGE <<"------> nonlinear solver " << SNESConvergedReasons[reason] <<". Failed in the first step.\n\n\n";
           RECORD();
+          ierr = 1;
           break;
         }
         if ( V_retry.size() >=8 )
         {
           MESSAGE <<"------> nonlinear solver " << SNESConvergedReasons[reason] <<". Too many failed steps, give up tring.\n\n\n";
           RECORD();
+          ierr = 1;
           break;
         }
 
@@ -399,36 +496,12 @@ int DDMSolverBase::solve_dcsweep()
       }
 
       if ( SolverSpecify::Predict )
-      {
-        PetscScalar hn = Vscan-Vs1;
-        PetscScalar hn1 = Vs1-Vs2;
-        PetscScalar hn2 = Vs2-Vs3;
-
-        if ( SolverSpecify::DC_Cycles>=3 )
-        {
-          // quadradic projection
-          PetscScalar cn=hn* ( hn+2*hn1+hn2 ) / ( hn1* ( hn1+hn2 ) );
-          PetscScalar cn1=-hn* ( hn+hn1+hn2 ) / ( hn1*hn2 );
-          PetscScalar cn2=hn* ( hn+hn1 ) / ( hn2* ( hn1+hn2 ) );
-
-          VecAXPY ( x,cn,xs1 );
-          VecAXPY ( x,cn1,xs2 );
-          VecAXPY ( x,cn2,xs3 );
-          this->projection_positive_density_check ( x,xs1 );
-        }
-        else if ( SolverSpecify::DC_Cycles>=2 )
-        {
-          // linear projection
-          VecAXPY ( x, hn/hn1,xs1 );
-          VecAXPY ( x,-hn/hn1,xs2 );
-          this->projection_positive_density_check ( x,xs1 );
-        }
-      }
+        sweep_predict ( Vscan, Vs1, Vs2, Vs3, xs1, xs2, xs3, SolverSpecify::DC_Cycles );
     }
 
-    VecDestroy ( xs1 );
-    VecDestroy ( xs2 );
-    VecDestroy ( xs3 );
+    restore_work_vector ( xs1 );
+    restore_work_vector ( xs2 );
+    restore_work_vector ( xs3 );
 
   }
 
@@ -447,9 +520,9 @@ int DDMSolverBase::solve_dcsweep()
     Vec xs1, xs2, xs3;
     PetscScalar Is1=Iscan, Is2=Iscan, Is3=Iscan;
     std::stack<PetscScalar> I_retry;
-    VecDuplicate ( x,&xs1 );
-    VecDuplicate ( x,&xs2 );
-    VecDuplicate ( x,&xs3 );
+    xs1 = get_work_vector();
+    xs2 = get_work_vector();
+    xs3 = get_work_vector();
 
     // main loop
     for ( SolverSpecify::DC_Cycles=0;  (Iscan*SolverSpecify::IStep) <= SolverSpecify::IStop*SolverSpecify::IStep* ( 1.0+1e-7 ); )
@@ -471,22 +544,49 @@ int DDMSolverBase::solve_dcsweep()
       else
         this->pre_solve_process ( false );
 
+      // the first bias point may be nearer to a solution of earlier SOLVE than to the last one,
+      // later ones only take the solution of the same bias
+      {
+        std::vector<PetscScalar> vapp, iapp;
+        electrode_bias(vapp, iapp);
+        load_bias_solution ( SolverSpecify::DC_Cycles == 0 ? bias_distance ( vapp, iapp, vapp0, iapp0 ) : 1e-6*PhysicalUnit::V );
+      }
+
       sens_solve();
       // get the converged reason
       SNESConvergedReason reason;
       SNESGetConvergedReason ( snes,&reason );
 
+      // Newton failed at the first bias point, try continuation from the last solution
+      if ( reason<=0 && SolverSpecify::DC_Cycles == 0 && SolverSpecify::Homotopy )
+      {
+        homotopy_solve ( vapp0, iapp0 );
+        SNESGetConvergedReason ( snes,&reason );
+      }
+
       // linear solver iteration
       PetscInt lits;
       SNESGetLinearSolveIterations(snes, &lits);
       total_lits += lits;
 
+      record_step_stats("dcsweep", Iscan/PhysicalUnit::A, static_cast<int>(I_retry.size()),
+                        reason<=0 && SolverSpecify::DC_Cycles>0 && I_retry.size()<8);
+
       if ( reason>0 ) //ok, converged.
       {
 
         // call post_solve_process
         this->post_solve_process();
 
+        cache_bias_solution();
+
+        // a hook has got what it wants
+        if ( this->stop_requested() )
+        {
+          MESSAGE<<"Solve stopped by request: " << this->stop_reason() << "\n\n\n"; RECORD();
+          break;
+        }
+
         SolverSpecify::DC_Cycles++;
 
         // save solution for linear/quadratic projection
@@ -513,8 +613,8 @@ int DDMSolverBase::solve_dcsweep()
         if ( fabs ( Iscan-SolverSpecify::IStop ) <1e-10 )
           Iscan=SolverSpecify::IStop;
 
-        // if I step small than IStepMax, mult by factor of 1.1
-        if ( fabs ( IStep ) < fabs ( SolverSpecify::IStepMax ) )  IStep *= 1.1;
+        // adjust I step, bounded by IStepMax
+        IStep = sweep_step ( IStep, SolverSpecify::IStepMax );
 
 
         // however, for last step, we force I equal to IStop
@@ -534,12 +634,14 @@ int DDMSolverBase::solve_dcsweep()
         {
           MESSAGE <<"------> nonlinear solver " << SNESConvergedReasons[reason] <<". Failed in the first step.\n\n\n";
           RECORD();
+          ierr = 1;
           break;
         }
         if ( I_retry.size() >=8 )
         {
           MESSAGE <<"------> nonlinear solver " << SNESConvergedReasons[reason] <<". Too many failed steps, give up tring.\n\n\n";
           RECORD();
+          ierr = 1;
           break;
         }
 
@@ -555,329 +657,1366 @@ int DDMSolverBase::solve_dcsweep()
       }
 
       if ( SolverSpecify::Predict )
-      {
-        PetscScalar hn = Iscan-Is1;
-        PetscScalar hn1 = Is1-Is2;
-        PetscScalar hn2 = Is2-Is3;
-
-        if ( SolverSpecify::DC_Cycles>=3 )
-        {
-          // quadradic projection
-          PetscScalar cn=hn* ( hn+2*hn1+hn2 ) / ( hn1* ( hn1+hn2 ) );
-          PetscScalar cn1=-hn* ( hn+hn1+hn2 ) / ( hn1*hn2 );
-          PetscScalar cn2=hn* ( hn+hn1 ) / ( hn2* ( hn1+hn2 ) );
-
-          VecAXPY ( x,cn,xs1 );
-          VecAXPY ( x,cn1,xs2 );
-          VecAXPY ( x,cn2,xs3 );
-          this->projection_positive_density_check ( x,xs1 );
-        }
-        else if ( SolverSpecify::DC_Cycles>=2 )
-        {
-          // linear projection
-          VecAXPY ( x, hn/hn1,xs1 );
-          VecAXPY ( x,-hn/hn1,xs2 );
-          this->projection_positive_density_check ( x,xs1 );
-        }
-      }
+        sweep_predict ( Iscan, Is1, Is2, Is3, xs1, xs2, xs3, SolverSpecify::DC_Cycles );
     }
 
-    VecDestroy ( xs1 );
-    VecDestroy ( xs2 );
-    VecDestroy ( xs3 );
+    restore_work_vector ( xs1 );
+    restore_work_vector ( xs2 );
+    restore_work_vector ( xs3 );
   }
 
-  return 0;
+  return ierr;
 }
 
 
 
-
-
-/**
- * create ksp solver for trace mode
+/* ----------------------------------------------------------------------------
+ * DC voltage sweep in slices. group g solves slice n_slices-1-g, so group 0, which writes the output,
+ * ends at VStop as the serial sweep does. before its slice, a group sweeps from VStart to the start
+ * of the slice with the slice width as step, these seed solutions are not recorded.
  */
-void DDMSolverBase::solve_iv_trace_begin()
+int DDMSolverBase::solve_dcsweep_parallel_bias()
 {
-  VecDuplicate(x, &pdI_pdx);
-  VecDuplicate(x, &pdF_pdV);
-  VecDuplicate(x, &pdx_pdV);
-
-  // build special linear solver contex
+  const PetscScalar VStart   = SolverSpecify::VStart;
+  const PetscScalar VStep    = SolverSpecify::VStep;
+  const PetscScalar VStepMax = SolverSpecify::VStepMax;
+  const PetscScalar VStop    = SolverSpecify::VStop;
+  const unsigned int parallel_bias = SolverSpecify::ParallelBias;
+
+  // the bias points of the sweep without step growth, and the points of each slice
+  const int n_steps = static_cast<int> ( std::floor ( ( VStop-VStart ) /VStep + 1e-7 ) );
+  const unsigned int n_points = n_steps >= 0 ? n_steps+1 : 0;
+  unsigned int n_slices = std::min ( parallel_bias, Genius::n_bias_groups() );
+  const unsigned int slice_points = n_slices ? ( n_points + n_slices - 1 ) /n_slices : 0;
+  if ( slice_points ) n_slices = ( n_points + slice_points - 1 ) /slice_points;
+
+  // solve in serial
+  SolverSpecify::ParallelBias = 1;
+
+  if ( n_slices < 2 || slice_points < 2 )
   {
-    PetscErrorCode ierr;
+    if ( Genius::n_bias_groups() < 2 )
+    {
+      MESSAGE<<"Warning: parallel.bias needs bias process groups (genius -bias_groups n), DC sweep is solved in serial.\n\n";
+      RECORD();
+    }
+    int ierr = solve_dcsweep();
+    SolverSpecify::ParallelBias = parallel_bias;
+    return ierr;
+  }
 
-    ierr = KSPCreate(PETSC_COMM_WORLD, &kspc); genius_assert(!ierr);
+  const unsigned int group = Genius::bias_group();
+  const int slice = group < n_slices ? static_cast<int> ( n_slices-1-group ) : -1;
 
-    ierr = KSPGetPC(kspc, &pcc); genius_assert(!ierr);
+  MESSAGE<<"DC voltage scan in " << n_slices << " slices of " << slice_points << " bias points";
+  if ( slice >= 0 )
+    MESSAGE<<", this group solves slice " << slice+1;
+  MESSAGE<<"\n\n";
+  RECORD();
 
-    if(Genius::n_processors()>1)
+  // the hooks see the merged results only
+  _step_hooks = false;
+
+  int ierr = 0;
+  unsigned int r = iv_store().n_rows();
+  if ( slice >= 0 )
+  {
+    const PetscScalar slice_start = VStart + slice*slice_points*VStep;
+    const PetscScalar slice_stop  = slice == static_cast<int> ( n_slices-1 ) ? VStop : VStart + ( ( slice+1 ) *slice_points-1 ) *VStep;
+
+    // coarse sweep to the start of the slice
+    if ( slice > 0 )
     {
-#if defined(PETSC_HAVE_LIBSUPERLU_DIST_2) || defined(PETSC_HAVE_MUMPS)
-      ierr = KSPSetType(kspc, KSPPREONLY); genius_assert(!ierr);
-      ierr = PCSetType(pcc, PCLU); genius_assert(!ierr);
-#ifdef PETSC_HAVE_MUMPS
-      ierr = PCFactorSetMatSolverPackage (pcc, "mumps"); genius_assert(!ierr);
-#else
-      ierr = PCFactorSetMatSolverPackage (pcc, "superlu_dist"); genius_assert(!ierr);
-#endif
- #else
-      // no parallel LU solver? we have to use krylov method for parallel!
-      ierr = KSPSetType(kspc, KSPBCGS); genius_assert(!ierr);
-      ierr = PCSetType(pcc, PCASM); genius_assert(!ierr);
-#endif
+      MESSAGE<<"Seed slice " << slice+1 << " by coarse sweep to " << slice_start/PhysicalUnit::V << " V\n\n";
+      RECORD();
 
+      _record_steps = false;
+      SolverSpecify::VStep    = slice_points*VStep;
+      SolverSpecify::VStepMax = slice_points*VStep;
+      SolverSpecify::VStop    = slice_start;
+      ierr = solve_dcsweep();
+      _record_steps = true;
     }
-    else
+
+    SolverSpecify::VStart   = slice_start;
+    SolverSpecify::VStep    = VStep;
+    SolverSpecify::VStepMax = VStepMax;
+    SolverSpecify::VStop    = slice_stop;
+    r = iv_store().n_rows();
+    if ( !ierr )
+      ierr = solve_dcsweep();
+  }
+
+  SolverSpecify::VStart       = VStart;
+  SolverSpecify::VStep        = VStep;
+  SolverSpecify::VStepMax     = VStepMax;
+  SolverSpecify::VStop        = VStop;
+  SolverSpecify::ParallelBias = parallel_bias;
+  _step_hooks = true;
+
+  // every group learns whether a slice failed, a broken IV curve is not merged
+  ierr = merge_parallel_bias_iv ( r, slice, n_slices, ierr );
+  if ( ierr )
+  {
+    MESSAGE<<"------> DC voltage scan failed in a bias slice, the IV curve of this group is kept unmerged.\n\n\n";
+    RECORD();
+  }
+
+  // group 0 is at the last bias point, pass the merged results to the hooks
+  if ( group == 0 )
+    hook_list()->post_solve();
+
+  return ierr;
+}
+
+
+
+int DDMSolverBase::merge_parallel_bias_iv ( unsigned int r, int slice, unsigned int n_slices, int ierr )
+{
+#ifdef HAVE_MPI
+  // status of all the groups
+  int failed = ierr ? 1 : 0, any_failed = 0;
+  MPI_Allreduce ( &failed, &any_failed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD );
+  if ( any_failed ) return 1;
+
+  // the first processor of each group sends the rows of its slice
+  std::vector<double> rows;
+  if ( slice >= 0 && Genius::processor_id() == 0 )
+    for ( unsigned int n=r; n<iv_store().n_rows(); ++n )
+      for ( unsigned int c=0; c<iv_store().n_columns(); ++c )
+        rows.push_back ( iv_store().value ( n, c ) );
+
+  int world_rank, world_size;
+  MPI_Comm_rank ( MPI_COMM_WORLD, &world_rank );
+  MPI_Comm_size ( MPI_COMM_WORLD, &world_size );
+
+  int head[2] = { slice, static_cast<int> ( rows.size() ) };
+  std::vector<int> heads ( 2*world_size );
+  MPI_Gather ( head, 2, MPI_INT, &heads[0], 2, MPI_INT, 0, MPI_COMM_WORLD );
+
+  std::vector<int> counts ( world_size, 0 ), displs ( world_size, 0 );
+  int total = 0;
+  if ( world_rank == 0 )
+    for ( int p=0; p<world_size; ++p )
     {
-      ierr = KSPSetType(kspc, KSPPREONLY); genius_assert(!ierr);
-      ierr = PCSetType(pcc, PCLU); genius_assert(!ierr);
+      counts[p] = heads[2*p+1];
+      displs[p] = total;
+      total += counts[p];
     }
 
+  std::vector<double> all ( std::max ( total, 1 ) );
+  MPI_Gatherv ( rows.empty() ? NULL : &rows[0], static_cast<int> ( rows.size() ), MPI_DOUBLE,
+                &all[0], &counts[0], &displs[0], MPI_DOUBLE, 0, MPI_COMM_WORLD );
 
-    ierr = KSPSetOperators(kspc, J, J, SAME_NONZERO_PATTERN); genius_assert(!ierr);
+  // processor 0 of group 0 puts the slices in bias order
+  std::vector<double> merged;
+  if ( world_rank == 0 )
+    for ( unsigned int s=0; s<n_slices; ++s )
+      for ( int p=0; p<world_size; ++p )
+        if ( heads[2*p] == static_cast<int> ( s ) )
+          merged.insert ( merged.end(), all.begin() +displs[p], all.begin() +displs[p]+counts[p] );
+
+  if ( Genius::bias_group() == 0 )
+  {
+    Parallel::broadcast ( merged );
+    replace_iv_rows ( r, merged );
   }
+  return 0;
+#else
+  ( void ) r;
+  ( void ) slice;
+  ( void ) n_slices;
+  return ierr;
+#endif
 }
 
 
-/**
- * destroy ksp solver for trace mode
+
+/*----------------------------------------------------------------------------
+ * polynomial predict of the solution at next bias point
  */
-void DDMSolverBase::solve_iv_trace_end()
+void DDMSolverBase::sweep_predict(PetscScalar s, PetscScalar s1, PetscScalar s2, PetscScalar s3,
+                                  Vec xs1, Vec xs2, Vec xs3, unsigned int n_points)
 {
-  KSPDestroy(kspc);
-  VecDestroy(pdI_pdx);
-  VecDestroy(pdF_pdV);
-  VecDestroy(pdx_pdV);
-}
+  PetscScalar hn = s-s1;
+  PetscScalar hn1 = s1-s2;
+  PetscScalar hn2 = s2-s3;
 
+  if ( n_points>=3 && SolverSpecify::PredictOrder>=2 )
+  {
+    // quadradic projection
+    PetscScalar cn=hn* ( hn+2*hn1+hn2 ) / ( hn1* ( hn1+hn2 ) );
+    PetscScalar cn1=-hn* ( hn+hn1+hn2 ) / ( hn1*hn2 );
+    PetscScalar cn2=hn* ( hn+hn1 ) / ( hn2* ( hn1+hn2 ) );
+
+    VecAXPY ( x,cn,xs1 );
+    VecAXPY ( x,cn1,xs2 );
+    VecAXPY ( x,cn2,xs3 );
+    this->projection_positive_density_check ( x,xs1 );
+  }
+  else if ( n_points>=2 && SolverSpecify::PredictOrder>=1 )
+  {
+    // linear (secant) projection
+    VecAXPY ( x, hn/hn1,xs1 );
+    VecAXPY ( x,-hn/hn1,xs2 );
+    this->projection_positive_density_check ( x,xs1 );
+  }
+}
 
 
-/* ----------------------------------------------------------------------------
- * DDMSolverBase::solve_iv_trace:  This function use continuation method to trace
- * IV curve automatically
+/*----------------------------------------------------------------------------
+ * step control of DC sweep
  */
-int DDMSolverBase::solve_iv_trace()
+PetscScalar DDMSolverBase::sweep_step(PetscScalar step, PetscScalar step_max)
 {
-  int         error=0;
-  int         first_step=1;
-  int         slope_flag=0;
+  if ( !SolverSpecify::SweepAutoStep )
+  {
+    // if step small than step_max, mult by factor of 1.1
+    if ( fabs ( step ) < fabs ( step_max ) )  step *= 1.1;
+    return step;
+  }
 
-  const PetscScalar PI = 3.14159265359;
+  // Newton iterations of the bias point just solved
+  PetscInt its;
+  SNESGetIterationNumber ( snes, &its );
 
-  PetscScalar I=0;
-  PetscScalar dI_dV;
+  // grow the step when Newton converges fast, shrink it when Newton works hard
+  PetscScalar factor = static_cast<PetscScalar> ( SolverSpecify::SweepAutoStepIts ) / std::max ( its, PetscInt ( 1 ) );
+  factor = std::max ( 0.5, std::min ( 2.0, factor ) );
 
-  std::string electrode_trace = SolverSpecify::Electrode_VScan[0];
-  BoundaryCondition * bc_trace = _system.get_bcs()->get_bc(electrode_trace);
+  PetscScalar new_step = step*factor;
+  // never grow beyond max step, but do not force a larger step to shrink
+  if ( fabs ( new_step ) > fabs ( step_max ) && factor > 1.0 )
+    new_step = fabs ( step ) > fabs ( step_max ) ? step : ( step > 0 ? fabs ( step_max ) : -fabs ( step_max ) );
 
-  // the current vscan voltage
-  PetscScalar V = SolverSpecify::VStart;
-  // set current vscan voltage to corresponding electrode
-  _system.get_sources()->assign_voltage_to ( electrode_trace, V );
+  if ( factor != 1.0 )
+  {
+    MESSAGE<<"      " << its << " Newton iterations, sweep step scaled by " << fabs(new_step/step) << "\n";
+    RECORD();
+  }
+  return new_step;
+}
 
-  // the current vscan step
-  PetscScalar VStep = SolverSpecify::VStep;
 
-  // the current potential of vscan electrode
-  PetscScalar Potential = bc_trace->ext_circuit()->potential();
 
-  PetscScalar Rload=0;
-  PetscScalar Rload_new;
-  PetscScalar Rref;
+/*----------------------------------------------------------------------------
+ * the applied voltage and current of all the electrodes
+ */
+void DDMSolverBase::electrode_bias(std::vector<PetscScalar> & vapp, std::vector<PetscScalar> & iapp) const
+{
+  const BoundaryConditionCollector * bcs = _system.get_bcs();
+  vapp.assign(bcs->n_bcs(), 0.0);
+  iapp.assign(bcs->n_bcs(), 0.0);
+  for(unsigned int b=0; b<bcs->n_bcs(); b++)
+  {
+    const BoundaryCondition * bc = bcs->get_bc(b);
+    if( !bc->is_electrode() ) continue;
+    vapp[b] = bc->ext_circuit()->Vapp();
+    iapp[b] = bc->ext_circuit()->Iapp();
+  }
+}
 
-  PetscScalar angle;
-  PetscScalar slope=PI/2;
-  PetscScalar slope_new;
-  PetscScalar slope_chord;
 
-  // set electrode with transient time 0 value of stimulate source(s)
-  _system.get_sources()->update ( 0 );
-  _system.get_field_source()->update ( 0 );
+/*----------------------------------------------------------------------------
+ * solution of the same model at other electrode bias, kept by the simulation system
+ */
+bool DDMSolverBase::load_bias_solution(PetscScalar max_distance)
+{
+  if ( !SolverSpecify::BiasCache ) return false;
 
-  // not time dependent
-  SolverSpecify::TimeDependent = false;
-  SolverSpecify::dt = 1e100;
-  SolverSpecify::clock = 0.0;
+  std::vector<PetscScalar> vapp, iapp;
+  electrode_bias(vapp, iapp);
 
-  solve_iv_trace_begin();
+  PetscInt n_local;
+  VecGetLocalSize(x, &n_local);
 
+  PetscScalar distance = 0.0;
+  const std::vector<PetscScalar> * xc = _system.nearest_bias_solution(this->solver_type(), n_local, vapp, iapp, distance);
 
-  // output TRACE information
-  MESSAGE<<"IV automatically trace by continuation method\n"; RECORD();
+  // all the processors should agree
+  int found = ( xc != NULL && distance < max_distance );
+  Parallel::min(found);
+  if ( !found ) return false;
 
-  // initial condition check
-  bc_trace->ext_circuit()->R() = Rload;
+  PetscScalar * xx;
+  VecGetArray(x, &xx);
+  std::copy(xc->begin(), xc->end(), xx);
+  VecRestoreArray(x, &xx);
 
-  // call pre_solve_process
-  this->pre_solve_process();
-  // here call Petsc to solve the nonlinear equations
-  sens_solve();
+  MESSAGE<<"Initial guess from the cached solution at bias distance " << distance/PhysicalUnit::V << " V\n"; RECORD();
 
-  // get the converged reason
-  SNESConvergedReason reason;
-  SNESGetConvergedReason ( snes, &reason );
+  return true;
+}
 
-  if(reason<0)
-  {
-    MESSAGE<<"I can't get convergence even at initial point, please give a good initial condition.\n\n"; RECORD();
-    error = 1;
-    goto trace_end;
-  }
 
-  // call post_solve_process
-  this->post_solve_process();
+void DDMSolverBase::cache_bias_solution()
+{
+  if ( !SolverSpecify::BiasCache ) return;
+
+  std::vector<PetscScalar> vapp, iapp;
+  electrode_bias(vapp, iapp);
+
+  PetscInt n_local;
+  VecGetLocalSize(x, &n_local);
+
+  PetscScalar * xx;
+  VecGetArray(x, &xx);
+  std::vector<PetscScalar> solution(xx, xx+n_local);
+  VecRestoreArray(x, &xx);
+
+  _system.cache_bias_solution(this->solver_type(), vapp, iapp, solution);
+}
+
 
 
-  //loop here
-  while(Potential*SolverSpecify::VStep < SolverSpecify::VStop*SolverSpecify::VStep && fabs(I)<SolverSpecify::IStop)
+/*----------------------------------------------------------------------------
+ * set the electrode bias to bias0 + lambda*(bias1 - bias0)
+ */
+static void ramp_electrode_bias(BoundaryConditionCollector * bcs,
+                                const std::vector<PetscScalar> & vapp0, const std::vector<PetscScalar> & iapp0,
+                                const std::vector<PetscScalar> & vapp1, const std::vector<PetscScalar> & iapp1,
+                                PetscScalar lambda)
+{
+  for(unsigned int b=0; b<bcs->n_bcs(); b++)
   {
-    MESSAGE << "Trace for V(" << electrode_trace << ")=" << Potential << "(V)\n"; RECORD();
+    BoundaryCondition * bc = bcs->get_bc(b);
+    if( !bc->is_electrode() ) continue;
+    bc->ext_circuit()->Vapp() = vapp0[b] + lambda*(vapp1[b] - vapp0[b]);
+    bc->ext_circuit()->Iapp() = iapp0[b] + lambda*(iapp1[b] - iapp0[b]);
+  }
+}
 
-    // for last Rload, increase VStep
-    int recovery=0;
-    do
-    {
-      V += VStep;
-      bc_trace->ext_circuit()->Vapp() =  V;
 
-      this->pre_solve_process ( false );
-      sens_solve();
+/*----------------------------------------------------------------------------
+ * continuation to the electrode bias already set: adaptive bias ramping, then
+ * pseudo transient continuation at the full bias
+ */
+bool DDMSolverBase::homotopy_solve(const std::vector<PetscScalar> & vapp0, const std::vector<PetscScalar> & iapp0)
+{
+  START_LOG("homotopy_solve()", "DDMSolverBase");
 
-      SNESGetConvergedReason(snes,&reason);
-      if(reason<0)
-      {
-        MESSAGE<<"I can't get convergence at this step, do recovery...\n\n";RECORD();
-        diverged_recovery();
-        V -= VStep;
-        VStep/=2;
-        recovery++;
-      }
-      if(recovery>8)
-      {
-        MESSAGE<<"Too many failed steps, give up tring.\n\n\n";RECORD();
-        error = 1;
-        goto trace_end;
-      }
-    }
-    while(reason<0);
+  BoundaryConditionCollector * bcs = _system.get_bcs();
 
+  // the bias to be reached
+  std::vector<PetscScalar> vapp1, iapp1;
+  electrode_bias(vapp1, iapp1);
 
+  // start from the last solution, x0 holds the last converged step of continuation
+  this->diverged_recovery();
+  Vec x0 = get_work_vector();
+  VecCopy(x, x0);
 
-    // for the new bias point, recompute slope
-    // calculate the dynamic resistance of IV curve by different approximation
-    this->set_trace_electrode(bc_trace);
+  SNESConvergedReason reason = SNES_CONVERGED_ITERATING;
 
-    KSPSolve(kspc, pdF_pdV, pdx_pdV);
-    VecDot(pdI_pdx, pdx_pdV, &dI_dV);
+  // bias ramping, the step is adapted by Newton iterations as the DC sweep step
+  MESSAGE<<"------> continuation by bias ramping from the last solution.\n"; RECORD();
+  PetscScalar lambda = 0.0;
+  PetscScalar step = 0.25;
+  const PetscScalar step_min = 1.0/64;
+  while( step >= step_min )
+  {
+    PetscScalar lambda_next = std::min(1.0, lambda + step);
+    ramp_electrode_bias(bcs, vapp0, iapp0, vapp1, iapp1, lambda_next);
 
-    PetscScalar r=1/dI_dV;
+    sens_solve();
+    SNESGetConvergedReason(snes, &reason);
 
+    PetscInt its;
+    SNESGetIterationNumber(snes, &its);
+    MESSAGE<<"      bias "<<100*lambda_next<<"%, "<<its<<" Newton iterations, "<<SNESConvergedReasons[reason]<<"\n"; RECORD();
 
-    if(first_step)
+    if( reason <= 0 )
     {
-      Rref = 1.0;
-      slope=slope_new=atan(Rref/r);
+      VecCopy(x0, x);
+      step *= 0.5;
+      continue;
     }
-    else
-    {
-      // Rref, for scaling the dynamic resistance
-      I = bc_trace->ext_circuit()->current_itering();
-      Potential = bc_trace->ext_circuit()->potential_itering();
 
-      if( fabs(1e6*I) < fabs(Potential) )
-        Rref = 1e6;
-      else
-        Rref = Potential/I;
+    lambda = lambda_next;
+    if( lambda >= 1.0 ) break;
 
-      slope_new = atan(Rref/r);
-    }
+    VecCopy(x, x0);
+    PetscScalar factor = static_cast<PetscScalar>(SolverSpecify::SweepAutoStepIts)/std::max(its, PetscInt(1));
+    step *= std::max(0.5, std::min(2.0, factor));
+  }
 
+  // pseudo transient continuation at the full bias from the furthest ramped solution.
+  // each accepted BDF1 step is written to the regions as the previous time level
+  if( reason <= 0 )
+  {
+    MESSAGE<<"------> bias ramping stopped at "<<100*lambda<<"%, continuation by pseudo transient.\n"; RECORD();
+    ramp_electrode_bias(bcs, vapp0, iapp0, vapp1, iapp1, 1.0);
 
-    //resolve turning point
-    if(tan(slope)*tan(slope_new)<0) //the sign is changed
-    {
-      PetscScalar chord = (Potential-bc_trace->ext_circuit()->potential_old())/(I-bc_trace->ext_circuit()->current_old());
-      slope_chord = atan(Rref/chord);
+    const bool time_dependent = SolverSpecify::TimeDependent;
+    const SolverSpecify::TemporalScheme ts_type = SolverSpecify::TS_type;
+    const PetscScalar dt = SolverSpecify::dt;
 
-      //for vertical turning point
-      if(fabs(slope)/PI*180 >70 && fabs(slope_new)/PI*180 >70 &&
-          ((slope_chord*slope>0 && fabs(slope_chord)>fabs(slope)) || (slope_chord*slope_new>0 && fabs(slope_chord)>fabs(slope_new))))
-      {
-        VStep*=-1.0;
-      }
-      //for horizontal turning point
-      if( fabs(slope)/PI*180 <20 && fabs(slope_new)/PI*180 <20 &&
-          ((slope_chord*slope>0 && fabs(slope_chord)<fabs(slope)) || (slope_chord*slope_new>0 && fabs(slope_chord)<fabs(slope_new))))
-      {
-        VStep*=1.0;
-      }
-    }
+    // the previous time level is the solution in x0
+    this->flush_system();
 
-    // check the slope change
-    angle=fabs(slope-slope_new);
-    if(angle>PI/2) angle=PI-angle;
+    SolverSpecify::TimeDependent = true;
+    SolverSpecify::TS_type = SolverSpecify::BDF1;
+    SolverSpecify::dt = 1.0*PhysicalUnit::ps;
 
-    if(angle<PI/36)      VStep*=1.5;   // slope change less than 5 degree
-    else if(angle<PI/24) VStep=VStep;  // slope change less than 10 degree, but greater than 5  degree
-    else if(angle<PI/12) VStep/=2;     // slope change less than 15 degree, but greater than 10 degree
-    else                                               // slope greater than 15 degree, reject this solution
+    for(unsigned int n=0; n<100; ++n)
     {
-      //printf("slope change old=%e new=%e angle=%e \n",slope/PI*180, slope_new/PI*180,  angle/PI*180);
-      MESSAGE<<"Slope of IV curve changes too quickly, do recovery...\n\n";RECORD();
-      VStep/=2;
-    }
+      sens_solve();
+      SNESGetConvergedReason(snes, &reason);
 
-    // ok, update solutions
-    this->post_solve_process();
+      PetscInt its;
+      SNESGetIterationNumber(snes, &its);
+      MESSAGE<<"      dt = "<<SolverSpecify::dt/PhysicalUnit::s<<" s, "<<its<<" Newton iterations, "<<SNESConvergedReasons[reason]<<"\n"; RECORD();
 
-    // since Rload will be changed, we should change bias voltage to meet the truncation point.
+      if( reason <= 0 )
+      {
+        VecCopy(x0, x);
+        SolverSpecify::dt *= 0.25;
+        if( SolverSpecify::dt < 1e-6*PhysicalUnit::ps ) break;
+        continue;
+      }
 
-    Rload_new=Rref/r;
-    V += I*(Rload_new-Rload);
-    bc_trace->ext_circuit()->R() = Rload_new;
-    bc_trace->ext_circuit()->Vapp() = V;
+      this->flush_system();
+      VecCopy(x, x0);
 
-    Rload=Rload_new;
-    slope = slope_new;
-    first_step=0;
+      // the transient is close to steady state
+      if( SolverSpecify::dt > 1.0*PhysicalUnit::us ) break;
 
-  }
+      // grow the time step fast when Newton converges easily
+      SolverSpecify::dt *= its <= static_cast<PetscInt>(SolverSpecify::SweepAutoStepIts) ? 4.0 : 1.5;
+    }
 
+    SolverSpecify::TimeDependent = time_dependent;
+    SolverSpecify::TS_type = ts_type;
+    SolverSpecify::dt = dt;
 
+    // steady state from the relaxed solution
+    if( reason > 0 )
+    {
+      sens_solve();
+      SNESGetConvergedReason(snes, &reason);
+    }
+  }
 
-trace_end:
-  solve_iv_trace_end();
+  restore_work_vector(x0);
 
-  return error;
+  MESSAGE<<"------> continuation "<<(reason > 0 ? "reached" : "failed to reach")<<" the bias point.\n\n"; RECORD();
+
+  STOP_LOG("homotopy_solve()", "DDMSolverBase");
+  return reason > 0;
 }
 
 
-/*----------------------------------------------------------------------------
- * transient simulation!
+
+/**
+ * create ksp solver for trace mode
  */
-int DDMSolverBase::solve_transient()
+void DDMSolverBase::solve_iv_trace_begin()
 {
+  pdI_pdx = get_work_vector();
+  pdF_pdV = get_work_vector();
+  pdx_pdV = get_work_vector();
+  x_trace = get_work_vector();
 
-  // init aux vectors used in transient simulation
-  VecDuplicate ( x, &x_n );
-  VecDuplicate ( x, &x_n1 );
-  VecDuplicate ( x, &x_n2 );
-  VecDuplicate ( x, &xp );
-  VecDuplicate ( x, &LTE );
+  // build special linear solver contex
+  {
+    PetscErrorCode ierr;
 
-  // time dependent
-  SolverSpecify::TimeDependent = true;
+    ierr = KSPCreate(PETSC_COMM_WORLD, &kspc); genius_assert(!ierr);
 
-  // if BDF2 scheme is used, we should set SolverSpecify::BDF2_restart flag to true
-  if ( SolverSpecify::TS_type==SolverSpecify::BDF2 )
+    ierr = KSPGetPC(kspc, &pcc); genius_assert(!ierr);
+
+    if(Genius::n_processors()>1)
+    {
+#if defined(PETSC_HAVE_LIBSUPERLU_DIST_2) || defined(PETSC_HAVE_MUMPS)
+      ierr = KSPSetType(kspc, KSPPREONLY); genius_assert(!ierr);
+      ierr = PCSetType(pcc, PCLU); genius_assert(!ierr);
+#ifdef PETSC_HAVE_MUMPS
+      ierr = PCFactorSetMatSolverPackage (pcc, "mumps"); genius_assert(!ierr);
+#else
+      ierr = PCFactorSetMatSolverPackage (pcc, "superlu_dist"); genius_assert(!ierr);
+#endif
+ #else
+      // no parallel LU solver? we have to use krylov method for parallel!
+      ierr = KSPSetType(kspc, KSPBCGS); genius_assert(!ierr);
+      ierr = PCSetType(pcc, PCASM); genius_assert(!ierr);
+#endif
+
+    }
+    else
+    {
+      ierr = KSPSetType(kspc, KSPPREONLY); genius_assert(!ierr);
+      ierr = PCSetType(pcc, PCLU); genius_assert(!ierr);
+    }
+
+
+    ierr = KSPSetOperators(kspc, J, J, SAME_NONZERO_PATTERN); genius_assert(!ierr);
+  }
+}
+
+
+/**
+ * destroy ksp solver for trace mode
+ */
+void DDMSolverBase::solve_iv_trace_end()
+{
+  KSPDestroy(kspc);
+  restore_work_vector(pdI_pdx);
+  restore_work_vector(pdF_pdV);
+  restore_work_vector(pdx_pdV);
+  restore_work_vector(x_trace);
+}
+
+
+
+/* ----------------------------------------------------------------------------
+ * DDMSolverBase::trace_tangent:  unit tangent of IV curve at the solution in x,
+ * in the IV plane scaled by Vs and Is. the tangent keeps the orientation of (tv, ti)
+ */
+void DDMSolverBase::trace_tangent(BoundaryCondition * bc, PetscScalar Vs, PetscScalar Is, PetscScalar &tv, PetscScalar &ti)
+{
+  // dx/dV at fixed electrode potential, with the jacobian of the converged point
+  this->set_trace_electrode(bc);
+
+  KSPSolve(kspc, pdF_pdV, pdx_pdV);
+  VecDot(pdI_pdx, pdx_pdV, &dI_dV);
+
+  PetscScalar tv_new = 1.0/Vs;
+  PetscScalar ti_new = dI_dV/Is;
+  PetscScalar norm = sqrt(tv_new*tv_new + ti_new*ti_new);
+  tv_new /= norm;
+  ti_new /= norm;
+
+  if( tv_new*tv + ti_new*ti < 0 )
+  {
+    tv_new = -tv_new;
+    ti_new = -ti_new;
+  }
+
+  tv = tv_new;
+  ti = ti_new;
+}
+
+
+/* ----------------------------------------------------------------------------
+ * DDMSolverBase::current_adjoint:  solve J^T lambda = dI/dx for electrode bc with
+ * the jacobian of IV trace, the electrode row of it is replaced by fixed potential
+ */
+bool DDMSolverBase::current_adjoint(BoundaryCondition * bc, Vec lambda)
+{
+  // set_trace_electrode modifies the electrode row of J, build a clean one each time
+  SNESComputeFunction(snes, x, f);
+  build_petsc_sens_jacobian(x, &J, &J);
+  this->set_trace_electrode(bc);
+
+  KSPSolveTranspose(kspc, pdI_pdx, lambda);
+  KSPConvergedReason reason;
+  KSPGetConvergedReason(kspc, &reason);
+  if( reason < 0 ) return false;
+
+  // the electrode potential is fixed, its equation takes no part in the response
+  VecSetValue(lambda, bc->global_offset(), 0.0, INSERT_VALUES);
+  VecAssemblyBegin(lambda);
+  VecAssemblyEnd(lambda);
+
+  return true;
+}
+
+
+/* ----------------------------------------------------------------------------
+ * DDMSolverBase::current_sensitivity:  adjoint sensitivity of electrode currents
+ * to PMI parameters. the jacobian with the electrode row replaced by fixed potential
+ * and dI/dx come from the IV trace machinery, the transposed system is factorized once
+ * per electrode. dF/dp is a forward difference of the residual, one residual per parameter.
+ */
+bool DDMSolverBase::current_sensitivity(const std::vector<BoundaryCondition *> & electrodes, const std::string & region,
+                                        const std::string & pmi, const std::vector<std::string> & parameters,
+                                        std::vector<std::vector<PetscScalar> > & dIdp)
+{
+  const unsigned int n_electrodes = electrodes.size();
+  const unsigned int n_parameters = parameters.size();
+  dIdp.assign(n_electrodes, std::vector<PetscScalar>(n_parameters, 0.0));
+
+  SimulationRegion * r = _system.region(region);
+  if( r == NULL ) return false;
+
+  PMI_Server * server = r->get_material_base()->get_pmi(pmi);
+  if( server == NULL ) return false;
+
+  std::vector<PetscScalar> p0(n_parameters);
+  for(unsigned int k=0; k<n_parameters; ++k)
+    if( server->get_real_parameter(parameters[k], p0[k]) ) return false;
+
+  START_LOG("current_sensitivity()", "DDMSolverBase");
+
+  solve_iv_trace_begin();
+
+  Vec f0     = get_work_vector();
+  Vec lambda = get_work_vector();
+  std::vector<Vec> dF_dp(n_parameters);
+
+  // residual at the converged solution, with the electrode currents of it
+  SNESComputeFunction(snes, x, f0);
+  std::vector<PetscScalar> I0(n_electrodes);
+  for(unsigned int e=0; e<n_electrodes; ++e)
+    I0[e] = electrodes[e]->ext_circuit()->current_itering();
+
+  // dF/dp and the explicit dI/dp, the residual is perturbed by each parameter in turn
+  for(unsigned int k=0; k<n_parameters; ++k)
+  {
+    const PetscScalar h = p0[k] != 0.0 ? 1e-4*std::abs(p0[k]) : 1e-4;
+
+    server->calibrate_real_parameter(parameters[k], p0[k] + h);
+    server->post_calibrate_process();
+
+    dF_dp[k] = get_work_vector();
+    SNESComputeFunction(snes, x, dF_dp[k]);
+    for(unsigned int e=0; e<n_electrodes; ++e)
+      dIdp[e][k] = (electrodes[e]->ext_circuit()->current_itering() - I0[e])/h;
+
+    server->calibrate_real_parameter(parameters[k], p0[k]);
+    server->post_calibrate_process();
+
+    VecAXPY(dF_dp[k], -1.0, f0);
+    VecScale(dF_dp[k], 1.0/h);
+  }
+
+  bool converged = true;
+  for(unsigned int e=0; e<n_electrodes; ++e)
+  {
+    if( !current_adjoint(electrodes[e], lambda) )
+    {
+      converged = false;
+      break;
+    }
+
+    for(unsigned int k=0; k<n_parameters; ++k)
+    {
+      PetscScalar lambda_dF;
+      VecDot(lambda, dF_dp[k], &lambda_dF);
+      dIdp[e][k] -= lambda_dF;
+    }
+  }
+
+  // restore the residual and jacobian of the converged solution, also the IV of current iteration saved by the bcs
+  SNESComputeFunction(snes, x, f0);
+  build_petsc_sens_jacobian(x, &J, &J);
+
+  for(unsigned int k=0; k<n_parameters; ++k)
+    restore_work_vector(dF_dp[k]);
+  restore_work_vector(f0);
+  restore_work_vector(lambda);
+
+  solve_iv_trace_end();
+
+  STOP_LOG("current_sensitivity()", "DDMSolverBase");
+
+  return converged;
+}
+
+
+/* ----------------------------------------------------------------------------
+ * DDMSolverBase::doping_sensitivity:  impedance field of electrode currents to the
+ * net doping of each semiconductor node. the doping of node i enters the poisson
+ * equation of node i only, by e*volume, so dI/dN_i = -lambda_i*e*volume
+ */
+bool DDMSolverBase::doping_sensitivity(const std::vector<BoundaryCondition *> & electrodes,
+                                       std::vector<FVM_Node *> & nodes,
+                                       std::vector<std::vector<PetscScalar> > & dIdN)
+{
+  START_LOG("doping_sensitivity()", "DDMSolverBase");
+
+  const BoundaryConditionCollector * bcs = _system.get_bcs();
+
+  // the on processor semiconductor nodes, except the ones whose poisson equation is replaced by the contact
+  nodes.clear();
+  for(unsigned int n=0; n<_system.n_regions(); ++n)
+  {
+    SimulationRegion * region = _system.region(n);
+    if( region->type() != SemiconductorRegion ) continue;
+
+    SimulationRegion::processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+    {
+      FVM_Node * fvm_node = *it;
+      if( fvm_node->on_boundary() && bcs->get_bc_by_bd_id(fvm_node->boundary_id())->is_electrode() ) continue;
+      nodes.push_back(fvm_node);
+    }
+  }
+
+  dIdN.assign(electrodes.size(), std::vector<PetscScalar>(nodes.size(), 0.0));
+
+  solve_iv_trace_begin();
+  Vec lambda = get_work_vector();
+
+  PetscInt low, high;
+  VecGetOwnershipRange(lambda, &low, &high);
+
+  bool converged = true;
+  for(unsigned int e=0; e<electrodes.size(); ++e)
+  {
+    if( !current_adjoint(electrodes[e], lambda) )
+    {
+      converged = false;
+      break;
+    }
+
+    PetscScalar * ll;
+    VecGetArray(lambda, &ll);
+    for(unsigned int i=0; i<nodes.size(); ++i)
+      dIdN[e][i] = -ll[nodes[i]->global_offset() - low]*PhysicalUnit::e*nodes[i]->volume();
+    VecRestoreArray(lambda, &ll);
+  }
+
+  // restore the residual and jacobian of the converged solution
+  SNESComputeFunction(snes, x, f);
+  build_petsc_sens_jacobian(x, &J, &J);
+
+  restore_work_vector(lambda);
+  solve_iv_trace_end();
+
+  STOP_LOG("doping_sensitivity()", "DDMSolverBase");
+
+  return converged;
+}
+
+
+/* ----------------------------------------------------------------------------
+ * DDMSolverBase::doping_instance_solve:  Newton solve of one doping instance from
+ * the nominal solution, with the same mesh, jacobian structure and linear solver
+ */
+bool DDMSolverBase::doping_instance_solve(const std::vector<FVM_Node *> & nodes,
+                                          const std::vector<PetscScalar> & dNd, const std::vector<PetscScalar> & dNa,
+                                          const std::vector<BoundaryCondition *> & electrodes, std::vector<PetscScalar> & I)
+{
+  START_LOG("doping_instance_solve()", "DDMSolverBase");
+
+  genius_assert(dNd.size() == nodes.size() && dNa.size() == nodes.size());
+
+  Vec x0 = get_work_vector();
+  VecCopy(x, x0);
+
+  for(unsigned int i=0; i<nodes.size(); ++i)
+  {
+    FVM_NodeData * node_data = nodes[i]->node_data();
+    node_data->Nd() += dNd[i];
+    node_data->Na() += dNa[i];
+  }
+
+  sens_solve();
+
+  SNESConvergedReason reason;
+  SNESGetConvergedReason(snes, &reason);
+
+  // the currents of the last residual, which is evaluated at the solution
+  I.resize(electrodes.size());
+  for(unsigned int e=0; e<electrodes.size(); ++e)
+    I[e] = electrodes[e]->ext_circuit()->current_itering();
+
+  // back to the nominal device
+  for(unsigned int i=0; i<nodes.size(); ++i)
+  {
+    FVM_NodeData * node_data = nodes[i]->node_data();
+    node_data->Nd() -= dNd[i];
+    node_data->Na() -= dNa[i];
+  }
+
+  VecCopy(x0, x);
+  SNESComputeFunction(snes, x, f);
+  restore_work_vector(x0);
+
+  STOP_LOG("doping_instance_solve()", "DDMSolverBase");
+
+  return reason > 0;
+}
+
+
+/* ----------------------------------------------------------------------------
+ * DDMSolverBase::solve_iv_trace:  This function use pseudo arc-length continuation
+ * to trace IV curve automatically.
+ *
+ * in the IV plane scaled by Vs and Is, the next point is predicted along the unit tangent
+ * (tv, ti) by arc-length ds. the arc-length constraint, the line through the predicted point
+ * perpendicular to the tangent, is a load line of the trace electrode:
+ *   Vapp = V + R*I,  R = (ti*Vs)/(tv*Is)
+ * so the bordered system is the electrode circuit row, and the corrector is the usual
+ * Newton solve with the extra row factorized together with the device equations.
+ */
+int DDMSolverBase::solve_iv_trace()
+{
+  int         error=0;
+
+  const PetscScalar PI = 3.14159265359;
+
+  std::string electrode_trace = SolverSpecify::Electrode_VScan[0];
+  BoundaryCondition * bc_trace = _system.get_bcs()->get_bc(electrode_trace);
+
+  // set start voltage to corresponding electrode
+  _system.get_sources()->assign_voltage_to ( electrode_trace, SolverSpecify::VStart );
+
+  // scale of the IV plane
+  const PetscScalar Vs = std::max(fabs(SolverSpecify::VStop-SolverSpecify::VStart), 1.0*PhysicalUnit::V);
+  const PetscScalar Is = SolverSpecify::IStop;
+
+  // arc-length of the step and its limit, no limit when VStepMax is not given
+  PetscScalar ds = fabs(SolverSpecify::VStep)/Vs;
+  const PetscScalar ds_max = SolverSpecify::VStepMax != 0.0 ?
+                             std::max(fabs(SolverSpecify::VStepMax), fabs(SolverSpecify::VStep))/Vs : 1e30;
+
+  // unit tangent of IV curve, start in the direction of VStep
+  PetscScalar tv = SolverSpecify::VStep > 0 ? 1.0 : -1.0;
+  PetscScalar ti = 0;
+
+  // set electrode with transient time 0 value of stimulate source(s)
+  _system.get_sources()->update ( 0 );
+  _system.get_field_source()->update ( 0 );
+
+  // not time dependent
+  SolverSpecify::TimeDependent = false;
+  SolverSpecify::dt = 1e100;
+  SolverSpecify::clock = 0.0;
+
+  solve_iv_trace_begin();
+
+
+  // output TRACE information
+  MESSAGE<<"IV automatically trace by arc-length continuation method\n"; RECORD();
+
+  // initial condition check
+  bc_trace->ext_circuit()->R() = 0;
+
+  // call pre_solve_process
+  this->pre_solve_process();
+  // here call Petsc to solve the nonlinear equations
+  sens_solve();
+
+  // get the converged reason
+  SNESConvergedReason reason;
+  SNESGetConvergedReason ( snes, &reason );
+
+  if(reason<0)
+  {
+    MESSAGE<<"I can't get convergence even at initial point, please give a good initial condition.\n\n"; RECORD();
+    error = 1;
+    goto trace_end;
+  }
+
+  this->trace_tangent(bc_trace, Vs, Is, tv, ti);
+
+  // call post_solve_process
+  this->post_solve_process();
+
+  VecCopy(x, x_trace);
+
+  {
+    // the potential and current of trace electrode at last accepted point
+    PetscScalar Potential = bc_trace->ext_circuit()->potential();
+    PetscScalar I = bc_trace->ext_circuit()->current();
+
+    //loop here
+    while(Potential*SolverSpecify::VStep < SolverSpecify::VStop*SolverSpecify::VStep && fabs(I)<SolverSpecify::IStop)
+    {
+      MESSAGE << "Trace for V(" << electrode_trace << ")=" << Potential/PhysicalUnit::V << "(V)\n"; RECORD();
+
+      int recovery=0;
+      do
+      {
+        // predicted point on the tangent
+        PetscScalar dV = ds*tv*Vs;
+        PetscScalar dI = ds*ti*Is;
+
+        // the load line perpendicular to the tangent, limit its slope when the tangent is near vertical
+        PetscScalar tv_limit = fabs(tv) > 1e-6 ? tv : (tv < 0 ? -1e-6 : 1e-6);
+        PetscScalar R = (ti*Vs)/(tv_limit*Is);
+        bc_trace->ext_circuit()->R() = R;
+        bc_trace->ext_circuit()->Vapp() = (Potential+dV) + R*(I+dI);
+
+        if ( SolverSpecify::Predict )
+        {
+          VecAXPY(x, dV, pdx_pdV);
+          this->projection_positive_density_check(x, x_trace);
+        }
+
+        this->pre_solve_process ( false );
+        sens_solve();
+
+        SNESGetConvergedReason(snes,&reason);
+        if(reason<0)
+        {
+          MESSAGE<<"I can't get convergence at this step, do recovery...\n\n";RECORD();
+          diverged_recovery();
+          ds/=2;
+          recovery++;
+        }
+        if(recovery>8)
+        {
+          MESSAGE<<"Too many failed steps, give up tring.\n\n\n";RECORD();
+          error = 1;
+          goto trace_end;
+        }
+      }
+      while(reason<0);
+
+      // tangent at the new point
+      PetscScalar tv_new = tv;
+      PetscScalar ti_new = ti;
+      this->trace_tangent(bc_trace, Vs, Is, tv_new, ti_new);
+
+      // secant step control, by the angle of the chord and the new tangent against the old tangent
+      {
+        PetscScalar cv = (bc_trace->ext_circuit()->potential_itering() - Potential)/Vs;
+        PetscScalar ci = (bc_trace->ext_circuit()->current_itering() - I)/Is;
+        PetscScalar chord = sqrt(cv*cv + ci*ci);
+
+        PetscScalar cos_tangent = std::min(1.0, tv*tv_new + ti*ti_new);
+        PetscScalar cos_chord = chord > 0 ? std::min(1.0, fabs(tv*cv + ti*ci)/chord) : 1.0;
+        PetscScalar angle = std::max(acos(cos_tangent), acos(cos_chord));
+
+        if(angle<PI/36)      ds*=1.5;   // slope change less than 5 degree
+        else if(angle<PI/18) ds=ds;     // slope change less than 10 degree, but greater than 5  degree
+        else if(angle<PI/12) ds/=2;     // slope change less than 15 degree, but greater than 10 degree
+        else
+        {
+          MESSAGE<<"Slope of IV curve changes too quickly, reduce the step...\n\n";RECORD();
+          ds/=2;
+        }
+        ds = std::min(ds, ds_max);
+      }
+
+      tv = tv_new;
+      ti = ti_new;
+
+      // ok, update solutions
+      this->post_solve_process();
+
+      // a hook has got what it wants
+      if ( this->stop_requested() )
+      {
+        MESSAGE<<"Solve stopped by request: " << this->stop_reason() << "\n\n\n"; RECORD();
+        break;
+      }
+
+      VecCopy(x, x_trace);
+
+      Potential = bc_trace->ext_circuit()->potential();
+      I = bc_trace->ext_circuit()->current();
+    }
+  }
+
+
+trace_end:
+  solve_iv_trace_end();
+
+  return error;
+}
+
+
+/*----------------------------------------------------------------------------
+ * PI controller of time step
+ */
+PetscScalar DDMSolverBase::pi_step_factor(PetscScalar lte, unsigned int order)
+{
+  // integral and proportional gains, scaled by the order of LTE
+  const PetscScalar kI = 0.3/(order+1);
+  const PetscScalar kP = 0.4/(order+1);
+
+  PetscScalar factor = 0.9*std::pow ( lte, -kI-kP );
+  // the proportional part uses the LTE history, which is not available for the first step
+  if ( lte_last > 0.0 )
+    factor *= std::pow ( lte_last, kP );
+
+  // avoid too aggressive step change
+  return std::max ( PetscScalar ( 0.2 ), std::min ( PetscScalar ( 5.0 ), factor ) );
+}
+
+
+
+/*----------------------------------------------------------------------------
+ * land time step on the breakpoints of sources
+ */
+PetscScalar DDMSolverBase::limit_dt_by_breakpoint(PetscScalar time, PetscScalar dt)
+{
+  // skip the breakpoint we just landed on
+  PetscScalar t_search = time + 1e-6*dt;
+  PetscScalar t_break = std::min( _system.get_sources()->next_breakpoint(t_search),
+                                  _system.get_field_source()->next_breakpoint(t_search) );
+
+  // the period boundary of PSS detection
+  if ( SolverSpecify::PSSPeriod > 0.0 && pss_clock > t_search )
+    t_break = std::min( t_break, pss_clock );
+
+  // the step would pass over the breakpoint, stop exactly on it
+  if ( time + dt > t_break )
+    return t_break - time;
+
+  // the step would leave a tiny step before the breakpoint, split the rest into two
+  if ( time + 1.5*dt > t_break )
+    return 0.5*( t_break - time );
+
+  return dt;
+}
+
+
+
+/*----------------------------------------------------------------------------
+ * periodic steady state detection
+ */
+bool DDMSolverBase::pss_converged()
+{
+  if ( SolverSpecify::PSSPeriod <= 0.0 ) return false;
+
+  // the first accepted time step is the reference of period boundaries
+  if ( pss_clock < 0.0 )
+  {
+    pss_clock = SolverSpecify::clock + SolverSpecify::PSSPeriod;
+    VecCopy ( x, x_pss );
+    return false;
+  }
+
+  if ( SolverSpecify::clock < pss_clock - 1e-6*SolverSpecify::dt ) return false;
+
+  // relative change of solution over one period
+  PetscScalar x_norm, dx_norm;
+  VecNorm ( x, NORM_2, &x_norm );
+  VecAXPY ( x_pss, -1.0, x );
+  VecNorm ( x_pss, NORM_2, &dx_norm );
+  VecCopy ( x, x_pss );
+
+  pss_clock += SolverSpecify::PSSPeriod;
+
+  PetscScalar change = dx_norm/(x_norm + 1e-30);
+  MESSAGE<<"PSS: relative change over one period " << change << "\n\n"; RECORD();
+
+  return change < SolverSpecify::PSSTol;
+}
+
+
+
+/*----------------------------------------------------------------------------
+ * transient checkpoint, binary dump of the state on each processor
+ */
+static const char transient_checkpoint_magic[8] = "GSSCKP1";
+
+/**
+ * the checkpoint file of this processor
+ */
+static std::string transient_checkpoint_file(const std::string & prefix)
+{
+  if( Genius::n_processors() == 1 ) return prefix;
+
+  std::stringstream ss;
+  ss << prefix << "." << Genius::processor_id();
+  return ss.str();
+}
+
+
+void DDMSolverBase::write_transient_checkpoint(const std::string & prefix)
+{
+  std::string filename = transient_checkpoint_file(prefix);
+  // write to a temporary file first, a job killed during writing does not destroy the last checkpoint
+  std::string tmpname = filename + ".tmp";
+
+  std::ofstream out(tmpname.c_str(), std::ios::binary | std::ios::trunc);
+  if( !out.good() )
+  {
+    MESSAGE<<"Warning: can't open checkpoint file " << tmpname << " for writing." << std::endl; RECORD();
+    return;
+  }
+
+  out.write(transient_checkpoint_magic, sizeof(transient_checkpoint_magic));
+
+  unsigned int n_proc = Genius::n_processors();
+  PetscInt n_local;
+  VecGetLocalSize(x, &n_local);
+  out.write(reinterpret_cast<const char *>(&n_proc), sizeof(n_proc));
+  out.write(reinterpret_cast<const char *>(&n_local), sizeof(n_local));
+
+  // time step and controller state
+  const PetscScalar time_state[5] = { SolverSpecify::clock, SolverSpecify::dt, SolverSpecify::dt_last,
+                                      SolverSpecify::dt_last_last, lte_last };
+  const int cycle_state[2] = { SolverSpecify::T_Cycles, SolverSpecify::BDF2_restart };
+  out.write(reinterpret_cast<const char *>(time_state), sizeof(time_state));
+  out.write(reinterpret_cast<const char *>(cycle_state), sizeof(cycle_state));
+
+  // initial guess of next step and solution history
+  Vec vecs[4] = { x, x_n, x_n1, x_n2 };
+  for(unsigned int i=0; i<4; ++i)
+  {
+    PetscScalar * xx;
+    VecGetArray(vecs[i], &xx);
+    out.write(reinterpret_cast<const char *>(xx), n_local*sizeof(PetscScalar));
+    VecRestoreArray(vecs[i], &xx);
+  }
+
+  // node data (with BDF history) and external circuit state
+  _system.write_checkpoint(out);
+
+  out.close();
+  if( !out.good() || std::rename(tmpname.c_str(), filename.c_str()) != 0 )
+  {
+    MESSAGE<<"Warning: write checkpoint file " << filename << " failed." << std::endl; RECORD();
+    return;
+  }
+
+  MESSAGE<<"Checkpoint at t = " << SolverSpecify::clock/PhysicalUnit::s << " s written to " << prefix << "\n\n"; RECORD();
+}
+
+
+void DDMSolverBase::read_transient_checkpoint()
+{
+  std::string filename = transient_checkpoint_file(SolverSpecify::RestartFile);
+
+  std::ifstream in(filename.c_str(), std::ios::binary);
+
+  char magic[sizeof(transient_checkpoint_magic)];
+  unsigned int n_proc = 0;
+  PetscInt n_local = 0, n_local_x;
+  VecGetLocalSize(x, &n_local_x);
+
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char *>(&n_proc), sizeof(n_proc));
+  in.read(reinterpret_cast<char *>(&n_local), sizeof(n_local));
+
+  int ok = in.good() && !std::memcmp(magic, transient_checkpoint_magic, sizeof(magic)) &&
+           n_proc == Genius::n_processors() && n_local == n_local_x;
+
+  if( ok )
+  {
+    PetscScalar time_state[5];
+    int cycle_state[2];
+    in.read(reinterpret_cast<char *>(time_state), sizeof(time_state));
+    in.read(reinterpret_cast<char *>(cycle_state), sizeof(cycle_state));
+
+    SolverSpecify::clock        = time_state[0];
+    SolverSpecify::dt           = time_state[1];
+    SolverSpecify::dt_last      = time_state[2];
+    SolverSpecify::dt_last_last = time_state[3];
+    lte_last                    = time_state[4];
+    SolverSpecify::T_Cycles     = cycle_state[0];
+    SolverSpecify::BDF2_restart = cycle_state[1];
+
+    // the initial guess of next step goes to xp, since x will be filled from node data by pre_solve_process
+    Vec vecs[4] = { xp, x_n, x_n1, x_n2 };
+    for(unsigned int i=0; i<4; ++i)
+    {
+      PetscScalar * xx;
+      VecGetArray(vecs[i], &xx);
+      in.read(reinterpret_cast<char *>(xx), n_local*sizeof(PetscScalar));
+      VecRestoreArray(vecs[i], &xx);
+    }
+
+    ok = _system.read_checkpoint(in);
+  }
+
+  // all the processors should agree
+  Parallel::min(ok);
+  if( !ok )
+  {
+    MESSAGE<<"ERROR: checkpoint file " << SolverSpecify::RestartFile << " can't be read or does not match this simulation." << std::endl; RECORD();
+    genius_error();
+  }
+
+  MESSAGE<<"Resume transient simulation from checkpoint " << SolverSpecify::RestartFile
+         <<" at t = " << SolverSpecify::clock/PhysicalUnit::s << " s\n\n"; RECORD();
+}
+
+
+
+/*----------------------------------------------------------------------------
+ * parareal, the coarse pass writes the start points of the time slices,
+ * the fine slices are independent restarts which can run concurrently
+ */
+void DDMSolverBase::parareal_coarse_pass()
+{
+  if ( SolverSpecify::CheckpointFile.empty() )
+  {
+    MESSAGE<<"ERROR: parareal coarse pass requires a checkpoint file to write the time slices." << std::endl; RECORD();
+    genius_error();
+  }
+
+  const unsigned int n_slices = SolverSpecify::PararealSlices;
+  const PetscScalar t_slice = ( SolverSpecify::TStop - SolverSpecify::TStart )/n_slices;
+
+  // the coarse propagator is BDF1 with one step per slice
+  SolverSpecify::TemporalScheme ts_type = SolverSpecify::TS_type;
+  SolverSpecify::TS_type = SolverSpecify::BDF1;
+  SolverSpecify::BDF2_restart = false;
+
+  SolverSpecify::clock = SolverSpecify::TStart;
+  SolverSpecify::dt = SolverSpecify::dt_last = SolverSpecify::dt_last_last = t_slice;
+
+  MESSAGE<<"Parareal coarse pass, " << n_slices << " slices of " << t_slice/PhysicalUnit::ps << " ps\n\n"; RECORD();
+
+  for ( unsigned int slice=0; slice<n_slices; ++slice )
+  {
+    SolverSpecify::T_Cycles = slice;
+    SolverSpecify::clock = SolverSpecify::TStart + ( slice+1 )*t_slice;
+    SolverSpecify::dt = t_slice;
+
+    MESSAGE
+    <<"t = "<<SolverSpecify::clock<<" ps (coarse)"<<'\n'
+    <<"--------------------------------------------------------------------------------\n";
+    RECORD();
+
+    _system.get_sources()->update ( SolverSpecify::clock );
+    _system.get_field_source()->update ( SolverSpecify::clock );
+
+    this->pre_solve_process ( slice == 0 );
+
+    sens_solve();
+
+    SNESConvergedReason reason;
+    SNESGetConvergedReason ( snes,&reason );
+    if ( reason<0 )
+    {
+      MESSAGE<<"------> coarse step "<<SNESConvergedReasons[reason]<<", use more parareal slices.\n\n\n"; RECORD();
+      break;
+    }
+
+    this->post_solve_process();
+
+    // the fine slice starts from this solution with the fresh time step of the fine propagator
+    SolverSpecify::clock += SolverSpecify::TStep;
+    SolverSpecify::dt = SolverSpecify::dt_last = SolverSpecify::dt_last_last = SolverSpecify::TStep;
+    SolverSpecify::T_Cycles = 0;
+    SolverSpecify::BDF2_restart = ( ts_type == SolverSpecify::BDF2 );
+    lte_last = 0.0;
+    VecCopy ( x, x_n );
+    VecCopy ( x, x_n1 );
+    VecCopy ( x, x_n2 );
+
+    std::stringstream ss;
+    ss << SolverSpecify::CheckpointFile << ".slice" << slice+1;
+    write_transient_checkpoint ( ss.str() );
+
+    if ( slice+1 < n_slices )
+    {
+      MESSAGE<<"Slice " << slice+2 << ": restart from " << ss.str() << " with tstop = "
+             << ( SolverSpecify::TStart + ( slice+2 )*t_slice )/PhysicalUnit::s << " s\n\n"; RECORD();
+    }
+
+    SolverSpecify::BDF2_restart = false;
+  }
+
+  SolverSpecify::TS_type = ts_type;
+}
+
+
+void DDMSolverBase::parareal_jump()
+{
+  std::string filename = transient_checkpoint_file(SolverSpecify::PararealNext);
+  std::ifstream in(filename.c_str(), std::ios::binary);
+
+  char magic[sizeof(transient_checkpoint_magic)];
+  unsigned int n_proc = 0;
+  PetscInt n_local = 0, n_local_x;
+  VecGetLocalSize(x, &n_local_x);
+
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char *>(&n_proc), sizeof(n_proc));
+  in.read(reinterpret_cast<char *>(&n_local), sizeof(n_local));
+
+  int ok = in.good() && !std::memcmp(magic, transient_checkpoint_magic, sizeof(magic)) &&
+           n_proc == Genius::n_processors() && n_local == n_local_x;
+
+  // skip the time step state, the coarse solution is the first vector
+  std::vector<PetscScalar> xc(n_local_x);
+  if( ok )
+  {
+    in.seekg(5*sizeof(PetscScalar) + 2*sizeof(int), std::ios::cur);
+    if( n_local_x )
+      in.read(reinterpret_cast<char *>(&xc[0]), n_local_x*sizeof(PetscScalar));
+    ok = in.good();
+  }
+
+  Parallel::min(ok);
+  if( !ok )
+  {
+    MESSAGE<<"Warning: parareal checkpoint " << SolverSpecify::PararealNext << " can't be read or does not match this simulation." << std::endl; RECORD();
+    return;
+  }
+
+  PetscScalar norms[2] = {0.0, 0.0};
+  PetscScalar * xx;
+  VecGetArray(x, &xx);
+  for(PetscInt i=0; i<n_local_x; ++i)
+  {
+    norms[0] += ( xx[i]-xc[i] )*( xx[i]-xc[i] );
+    norms[1] += xx[i]*xx[i];
+  }
+  VecRestoreArray(x, &xx);
+  Parallel::sum(norms[0]);
+  Parallel::sum(norms[1]);
+
+  MESSAGE<<"Parareal: relative jump to the coarse solution in " << SolverSpecify::PararealNext << " is "
+         << std::sqrt(norms[0]/(norms[1]+1e-30)) << "\n\n"; RECORD();
+}
+
+
+
+/*----------------------------------------------------------------------------
+ * transient simulation!
+ */
+int DDMSolverBase::solve_transient()
+{
+
+  // init aux vectors used in transient simulation
+  x_n = get_work_vector();
+  x_n1 = get_work_vector();
+  x_n2 = get_work_vector();
+  xp = get_work_vector();
+  LTE = get_work_vector();
+  x_pss = get_work_vector();
+  f_tr = get_work_vector();
+
+  // no LTE history for PI control yet
+  lte_last = 0.0;
+
+  // no period boundary for PSS detection yet
+  pss_clock = -1.0;
+
+  // time dependent
+  SolverSpecify::TimeDependent = true;
+
+  // coarse pass of parareal only, a restarted run is a fine slice
+  if ( SolverSpecify::PararealSlices > 0 && SolverSpecify::RestartFile.empty() )
+  {
+    parareal_coarse_pass();
+
+    restore_work_vector ( x_n );
+    restore_work_vector ( x_n1 );
+    restore_work_vector ( x_n2 );
+    restore_work_vector ( xp );
+    restore_work_vector ( LTE );
+    restore_work_vector ( x_pss );
+    restore_work_vector ( f_tr );
+    return 0;
+  }
+
+  // if BDF2 scheme is used, we should set SolverSpecify::BDF2_restart flag to true
+  if ( SolverSpecify::TS_type==SolverSpecify::BDF2 )
     SolverSpecify::BDF2_restart = true;
 
-  // transient simulation clock
-  SolverSpecify::clock = SolverSpecify::TStart + SolverSpecify::TStep;
+  // TR-BDF2 takes each time step h in two stages, a trapezoidal stage to t+gamma*h and a BDF2 stage
+  // on t, t+gamma*h and t+h. the trapezoidal stage is the BDF1 assembly with half of the stage step
+  // and the function of time level t added, the BDF2 stage is the variable step BDF2 assembly.
+  // it is one step, no restart is needed
+  const bool trbdf2 = ( SolverSpecify::TS_type==SolverSpecify::TRBDF2 );
+  const PetscScalar gamma = 2.0 - std::sqrt ( 2.0 );
+  bool tr_stage = trbdf2;
+  bool f_tr_valid = false;
+  if ( trbdf2 )
+    SolverSpecify::TS_type = SolverSpecify::BDF1;
+
+  // the hooks and IV records see the whole TR-BDF2 steps only
+  const bool record_steps = _record_steps;
+  const bool step_hooks = _step_hooks;
 
   // for the first step, dt equals TStep
-  SolverSpecify::dt = SolverSpecify::TStep;
+  SolverSpecify::dt = trbdf2 ? gamma*SolverSpecify::TStep : SolverSpecify::TStep;
+
+  // transient simulation clock
+  SolverSpecify::clock = SolverSpecify::TStart + SolverSpecify::dt;
 
   MESSAGE<<"Transient compute from "<<SolverSpecify::TStart
   <<" ps step "<<SolverSpecify::TStep
@@ -894,6 +2033,11 @@ int DDMSolverBase::solve_transient()
   // time step counter
   SolverSpecify::T_Cycles=0;
 
+  // resume from checkpoint, the node data should be loaded into x by the first pre_solve_process
+  bool restart = !SolverSpecify::RestartFile.empty();
+  if ( restart )
+    read_transient_checkpoint();
+
   // the main loop of transient solver.
   do
   {
@@ -907,13 +2051,39 @@ int DDMSolverBase::solve_transient()
     _system.get_field_source()->update ( SolverSpecify::clock );
     //we do solve here!
 
+    _record_steps = record_steps && !tr_stage;
+    _step_hooks   = step_hooks && !tr_stage;
+
     // call pre_solve_process
-    if ( SolverSpecify::T_Cycles == 0 )
+    if ( SolverSpecify::T_Cycles == 0 || restart )
       this->pre_solve_process();
     else
       this->pre_solve_process ( false );
 
-    sens_solve();
+    // the function of the first trapezoidal stage, x is the start solution here
+    if ( tr_stage && !f_tr_valid )
+    {
+      trbdf2_function ( SolverSpecify::clock - SolverSpecify::dt );
+      f_tr_valid = true;
+    }
+
+    // continue with the initial guess saved in checkpoint
+    if ( restart )
+    {
+      VecCopy ( xp, x );
+      restart = false;
+    }
+
+    if ( tr_stage )
+    {
+      residual_shift = f_tr;
+      SolverSpecify::dt *= 0.5;
+      sens_solve();
+      SolverSpecify::dt *= 2.0;
+      residual_shift = PETSC_NULL;
+    }
+    else
+      sens_solve();
     // get the converged reason
     SNESConvergedReason reason;
     SNESGetConvergedReason ( snes,&reason );
@@ -923,6 +2093,9 @@ int DDMSolverBase::solve_transient()
     PetscInt lits;
     SNESGetLinearSolveIterations(snes, &lits);
 
+    record_step_stats("transient", SolverSpecify::clock/PhysicalUnit::ps, diverged_retry+autostep_retry,
+                      reason<0 && diverged_retry+1<8);
+
     //nonlinear solution diverged? try to do recovery
     if ( reason<0 )
     {
@@ -956,12 +2129,13 @@ int DDMSolverBase::solve_transient()
 
     //ok, nonlinear solution converged.
 
-    //do LTE estimation and auto time step control
-    if ( SolverSpecify::AutoStep &&
+    //do LTE estimation and auto time step control, the BDF2 stage of TR-BDF2 is controlled as BDF2
+    if ( SolverSpecify::AutoStep && !tr_stage &&
          ( ( SolverSpecify::TS_type==SolverSpecify::BDF1 && SolverSpecify::T_Cycles>=3 ) ||
            ( SolverSpecify::TS_type==SolverSpecify::BDF2 && SolverSpecify::T_Cycles>=4 ) ) )
     {
-      PetscScalar r = this->LTE_norm() + 1e-10;
+      PetscScalar lte = this->LTE_norm() + 1e-10;
+      PetscScalar r = lte;
 
       if ( SolverSpecify::TS_type==SolverSpecify::BDF1 )
         r = std::pow ( r, PetscScalar ( -1.0/2 ) );
@@ -978,6 +2152,12 @@ int DDMSolverBase::solve_transient()
         MESSAGE<<"------> LTE too large, time step rejected...\n\n\n";
         RECORD();
 
+        if ( SolverStats::enabled() )
+          SolverStats("lte_reject").add("clock", SolverSpecify::clock/PhysicalUnit::ps)
+                                   .add("dt", SolverSpecify::dt/PhysicalUnit::ps)
+                                   .add("lte", static_cast<double>(lte))
+                                   .write();
+
         // reduce time step by a factor of 0.9*r
         SolverSpecify::clock -= SolverSpecify::dt;
         PetscScalar hn  = SolverSpecify::dt;           // here dt is the current time step
@@ -1008,6 +2188,10 @@ int DDMSolverBase::solve_transient()
           autostep_retry = 0;
           diverged_retry = 0;
         }
+        else if ( SolverSpecify::TS_PIControl )
+        {
+          SolverSpecify::dt *= pi_step_factor ( lte, SolverSpecify::TS_type==SolverSpecify::BDF1 ? 1 : 2 );
+        }
         else
         {
           if ( r > 1.0 )
@@ -1015,6 +2199,7 @@ int DDMSolverBase::solve_transient()
           else
             SolverSpecify::dt *= 0.9;
         }
+        lte_last = lte;
 
         // limit the max time step to TStepMax
         if ( SolverSpecify::dt > SolverSpecify::TStepMax )
@@ -1051,19 +2236,68 @@ int DDMSolverBase::solve_transient()
     // call post_solve_process
     this->post_solve_process();
 
-    // prepare for next time step
+    // stop at periodic steady state
+    if ( !tr_stage && pss_converged() )
+    {
+      MESSAGE<<"Periodic steady state reached at t = " << SolverSpecify::clock/PhysicalUnit::s << " s\n\n"; RECORD();
+      break;
+    }
 
-    // limit time step by changes of external source, i.e. max allowed changes of vsource
-    SolverSpecify::dt = _system.get_sources()->limit_dt(SolverSpecify::clock, SolverSpecify::dt, SolverSpecify::VStepMax, SolverSpecify::IStepMax);
+    // a hook has got what it wants
+    if ( this->stop_requested() )
+    {
+      MESSAGE<<"Solve stopped by request: " << this->stop_reason() << "\n\n\n"; RECORD();
+      break;
+    }
 
-    // set clock to next time step
-    SolverSpecify::clock += SolverSpecify::dt;
+    // prepare for next time step
 
-    //make sure we can terminat near TStop, the relative error should less than 1e-10.
-    if ( SolverSpecify::clock > SolverSpecify::TStop && SolverSpecify::clock < ( SolverSpecify::TStop + SolverSpecify::dt - 1e-10*SolverSpecify::dt ) )
+    if ( trbdf2 && tr_stage )
     {
-      SolverSpecify::dt -= SolverSpecify::clock - SolverSpecify::TStop;
-      SolverSpecify::clock = SolverSpecify::TStop;
+      // the BDF2 stage completes the step of the trapezoidal stage
+      SolverSpecify::dt = SolverSpecify::dt_last* ( 1-gamma ) /gamma;
+      SolverSpecify::TS_type = SolverSpecify::BDF2;
+      SolverSpecify::clock += SolverSpecify::dt;
+      tr_stage = false;
+    }
+    else if ( trbdf2 )
+    {
+      // dt is the next BDF2 stage given by the step control, scale it to the whole step
+      PetscScalar h = SolverSpecify::dt* ( SolverSpecify::dt_last_last+SolverSpecify::dt_last ) /SolverSpecify::dt_last;
+      const PetscScalar h_max = SolverSpecify::AutoStep ? SolverSpecify::TStepMax : SolverSpecify::TStep;
+      if ( h > h_max ) h = h_max;
+      h = _system.get_sources()->limit_dt(SolverSpecify::clock, h, SolverSpecify::VStepMax, SolverSpecify::IStepMax);
+      h = limit_dt_by_breakpoint(SolverSpecify::clock, h);
+
+      //make sure we can terminat near TStop, the relative error should less than 1e-10.
+      if ( SolverSpecify::clock + h > SolverSpecify::TStop && SolverSpecify::clock < SolverSpecify::TStop - 1e-10*h )
+        h = SolverSpecify::TStop - SolverSpecify::clock;
+
+      // the function of the next trapezoidal stage, the sources are still at this clock
+      trbdf2_function ( SolverSpecify::clock );
+
+      SolverSpecify::dt = gamma*h;
+      SolverSpecify::TS_type = SolverSpecify::BDF1;
+      SolverSpecify::clock += SolverSpecify::dt;
+      tr_stage = true;
+    }
+    else
+    {
+      // limit time step by changes of external source, i.e. max allowed changes of vsource
+      SolverSpecify::dt = _system.get_sources()->limit_dt(SolverSpecify::clock, SolverSpecify::dt, SolverSpecify::VStepMax, SolverSpecify::IStepMax);
+
+      // do not step over the corners of source waveforms
+      SolverSpecify::dt = limit_dt_by_breakpoint(SolverSpecify::clock, SolverSpecify::dt);
+
+      // set clock to next time step
+      SolverSpecify::clock += SolverSpecify::dt;
+
+      //make sure we can terminat near TStop, the relative error should less than 1e-10.
+      if ( SolverSpecify::clock > SolverSpecify::TStop && SolverSpecify::clock < ( SolverSpecify::TStop + SolverSpecify::dt - 1e-10*SolverSpecify::dt ) )
+      {
+        SolverSpecify::dt -= SolverSpecify::clock - SolverSpecify::TStop;
+        SolverSpecify::clock = SolverSpecify::TStop;
+      }
     }
 
     // use by auto step control and predict
@@ -1106,21 +2340,65 @@ int DDMSolverBase::solve_transient()
       }
     }
 
+    // checkpoint after accepted time step, TR-BDF2 at the end of a whole step
+    if ( reason>0 && ( !trbdf2 || tr_stage ) && !SolverSpecify::CheckpointFile.empty() && SolverSpecify::T_Cycles%SolverSpecify::CheckpointSteps==0 )
+      write_transient_checkpoint(SolverSpecify::CheckpointFile);
+
   }
   while ( SolverSpecify::clock < SolverSpecify::TStop+0.5*SolverSpecify::dt );
 
+  if ( trbdf2 )
+    SolverSpecify::TS_type = SolverSpecify::TRBDF2;
+  _record_steps = record_steps;
+  _step_hooks   = step_hooks;
+
+  // end of a fine slice, see how far the coarse pass is off here
+  if ( !SolverSpecify::PararealNext.empty() )
+    parareal_jump();
+
   // free aux vectors
-  VecDestroy ( x_n );
-  VecDestroy ( x_n1 );
-  VecDestroy ( x_n2 );
-  VecDestroy ( xp );
-  VecDestroy ( LTE );
+  restore_work_vector ( x_n );
+  restore_work_vector ( x_n1 );
+  restore_work_vector ( x_n2 );
+  restore_work_vector ( xp );
+  restore_work_vector ( LTE );
+  restore_work_vector ( x_pss );
+  restore_work_vector ( f_tr );
 
   return 0;
 }
 
 
 
+/*----------------------------------------------------------------------------
+ * the DC function at solution x with the sources at time t, it is the function of the
+ * last time level in the trapezoidal stage of TR-BDF2
+ */
+void DDMSolverBase::trbdf2_function ( PetscScalar t )
+{
+  if ( t != SolverSpecify::clock )
+  {
+    _system.get_sources()->update ( t );
+    _system.get_field_source()->update ( t );
+  }
+
+  // no time derivative, and the circuit of electrodes with infinite time step
+  const PetscScalar dt = SolverSpecify::dt;
+  SolverSpecify::TimeDependent = false;
+  SolverSpecify::dt = 1e100;
+  build_petsc_sens_residual ( x, f_tr );
+  SolverSpecify::TimeDependent = true;
+  SolverSpecify::dt = dt;
+
+  if ( t != SolverSpecify::clock )
+  {
+    _system.get_sources()->update ( SolverSpecify::clock );
+    _system.get_field_source()->update ( SolverSpecify::clock );
+  }
+}
+
+
+
 
 
 
@@ -1140,15 +2418,19 @@ void DDMSolverBase::petsc_snes_convergence_test ( PetscInt its, PetscReal , Pets
   {
     snes->ttol = fnorm*snes->rtol;
 
-    MESSAGE<<" "<<" n ";
-    MESSAGE<<"| Eq(V) | "<<"| Eq(n) | "<<"| Eq(p) | ";
-    MESSAGE<<"| Eq(T) | ";
-    MESSAGE<<"|Eq(Tn)|  ";
-    MESSAGE<<"|Eq(Tp)|  ";
-    MESSAGE<<"|Eq(BC)|  ";
-    MESSAGE<<"Lg(dx)"<<'\n';
-    MESSAGE<<"--------------------------------------------------------------------------------\n";
-    RECORD();
+    // the table of residual norms, one row per iteration
+    if( genius_log.enabled(GENIUS_LOG_STREAM::ITERATION) )
+    {
+      MESSAGE<<" "<<" n ";
+      MESSAGE<<"| Eq(V) | "<<"| Eq(n) | "<<"| Eq(p) | ";
+      MESSAGE<<"| Eq(T) | ";
+      MESSAGE<<"|Eq(Tn)|  ";
+      MESSAGE<<"|Eq(Tp)|  ";
+      MESSAGE<<"|Eq(BC)|  ";
+      MESSAGE<<"Lg(dx)"<<'\n';
+      MESSAGE<<"--------------------------------------------------------------------------------\n";
+      RECORD();
+    }
   }
 
   bool  poisson_conv              = poisson_norm              < SolverSpecify::toler_relax*SolverSpecify::poisson_abs_toler;
@@ -1159,26 +2441,30 @@ void DDMSolverBase::petsc_snes_convergence_test ( PetscInt its, PetscReal , Pets
   bool  elec_energy_equation_conv = elec_energy_equation_norm < SolverSpecify::toler_relax*SolverSpecify::elec_energy_abs_toler;
   bool  hole_energy_equation_conv = hole_energy_equation_norm < SolverSpecify::toler_relax*SolverSpecify::hole_energy_abs_toler;
 
+  if( genius_log.enabled(GENIUS_LOG_STREAM::ITERATION) )
+  {
 #ifdef CYGWIN
-  MESSAGE.precision ( 1 );
+    MESSAGE.precision ( 1 );
 #else
-  MESSAGE.precision ( 2 );
+    MESSAGE.precision ( 2 );
 #endif
 
-  MESSAGE<< std::setw(3) << its << " " ;
-  MESSAGE<< std::scientific;
-  MESSAGE<< poisson_norm << (poisson_conv ? "* " : "  ");
-  MESSAGE<< elec_continuity_norm << (elec_continuity_conv ? "* " : "  ");
-  MESSAGE<< hole_continuity_norm << (hole_continuity_conv ? "* " : "  ");
-  MESSAGE<< heat_equation_norm   << (heat_equation_conv ? "* " : "  ");
-  MESSAGE<< elec_energy_equation_norm << (elec_energy_equation_conv ? "* " : "  ");
-  MESSAGE<< hole_energy_equation_norm << (hole_energy_equation_conv ? "* " : "  ");
-  MESSAGE<< electrode_norm << (electrode_conv ? "* " : "  ");
-  MESSAGE<< std::fixed << std::setw(4) << (pnorm==0.0 ? -std::numeric_limits<PetscScalar>::infinity():log10(pnorm))
-    << (pnorm < SolverSpecify::relative_toler ? "*" : " ") << "\n" ;
-  RECORD();
-  MESSAGE.precision ( 6 );
-  MESSAGE<< std::scientific;
+    MESSAGE<< std::setw(3) << its << " " ;
+    MESSAGE<< std::scientific;
+    MESSAGE<< poisson_norm << (poisson_conv ? "* " : "  ");
+    MESSAGE<< elec_continuity_norm << (elec_continuity_conv ? "* " : "  ");
+    MESSAGE<< hole_continuity_norm << (hole_continuity_conv ? "* " : "  ");
+    MESSAGE<< heat_equation_norm   << (heat_equation_conv ? "* " : "  ");
+    MESSAGE<< elec_energy_equation_norm << (elec_energy_equation_conv ? "* " : "  ");
+    MESSAGE<< hole_energy_equation_norm << (hole_energy_equation_conv ? "* " : "  ");
+    MESSAGE<< electrode_norm << (electrode_conv ? "* " : "  ");
+    MESSAGE<< std::fixed << std::setw(4) << (pnorm==0.0 ? -std::numeric_limits<PetscScalar>::infinity():log10(pnorm))
+      << (pnorm < SolverSpecify::relative_toler ? "*" : " ") << "\n" ;
+    RECORD();
+    MESSAGE.precision ( 6 );
+    MESSAGE<< std::scientific;
+  }
+
   // check for NaN (Not a Number)
   if ( fnorm != fnorm )
   {
@@ -1244,6 +2530,52 @@ void DDMSolverBase::petsc_snes_convergence_test ( PetscInt its, PetscReal , Pets
 
 
 
+/*------------------------------------------------------------------
+ * f norm of each governing equation
+ */
+void DDMSolverBase::equation_norms(std::vector<std::pair<std::string, PetscReal> > &norms) const
+{
+  norms.push_back(std::make_pair(std::string("poisson_norm"),              poisson_norm));
+  norms.push_back(std::make_pair(std::string("elec_continuity_norm"),      elec_continuity_norm));
+  norms.push_back(std::make_pair(std::string("hole_continuity_norm"),      hole_continuity_norm));
+  norms.push_back(std::make_pair(std::string("heat_equation_norm"),        heat_equation_norm));
+  norms.push_back(std::make_pair(std::string("elec_energy_equation_norm"), elec_energy_equation_norm));
+  norms.push_back(std::make_pair(std::string("hole_energy_equation_norm"), hole_energy_equation_norm));
+  norms.push_back(std::make_pair(std::string("electrode_norm"),            electrode_norm));
+}
+
+
+
+/*------------------------------------------------------------------
+ * write the statistics of a bias point or time step
+ */
+void DDMSolverBase::record_step_stats(const char * solve, double value, int retries, bool recovery)
+{
+  if ( !SolverStats::enabled() ) return;
+
+  SNESConvergedReason reason;
+  SNESGetConvergedReason ( snes, &reason );
+
+  PetscInt lits;
+  SNESGetLinearSolveIterations(snes, &lits);
+
+  SolverStats stats("step");
+  stats.add("solve", _stats_solve)
+       .add("type", solve)
+       .add("value", value);
+  if ( SolverSpecify::TimeDependent )
+    stats.add("dt", SolverSpecify::dt/PhysicalUnit::ps);
+  stats.add("converged", reason>0)
+       .add("reason", SNESConvergedReasons[reason])
+       .add("its", static_cast<int>(nonlinear_iteration))
+       .add("ksp_its", static_cast<int>(lits))
+       .add("retries", retries)
+       .add("diverged_recovery", recovery)
+       .write();
+}
+
+
+
 /*------------------------------------------------------------------
  * ksp convergence criteria
  */
@@ -20,8 +20,12 @@
 /********************************************************************************/
 
 
+#include <set>
 #include <stack>
+#include <cmath>
 #include <iomanip>
+#include <sstream>
+#include <algorithm>
 
 #include "solver_specify.h"
 #include "physical_unit.h"
@@ -49,6 +53,10 @@ int MixASolverBase::create_solver()
   // abstol = 1e-20*n_global_dofs  - the absolute convergence tolerance (absolute size of the residual norm)
   KSPSetTolerances(ksp, 1e-12*n_global_dofs, 1e-20*n_global_dofs, PETSC_DEFAULT, std::max(50, std::min(1000, static_cast<int>(n_global_dofs/10))));
 
+  // eliminate the device to the circuit dofs
+  if( SolverSpecify::SpiceSchur )
+    set_spice_schur_preconditioner();
+
   // user can do further adjusment from command line
   SNESSetFromOptions (snes);
 
@@ -76,6 +84,73 @@ int MixASolverBase::pre_solve_process(bool load_solution)
 
 
 
+void MixASolverBase::set_spice_schur_preconditioner()
+{
+#if PETSC_VERSION_GE(3,1,0)
+  int ierr = 0;
+
+  // the circuit dofs are the extra dofs at the end of the last processor
+  const unsigned int n_circuit_dofs = Genius::is_last_processor() ? this->extra_dofs() : 0;
+  const unsigned int n_device_dofs  = n_local_dofs - n_circuit_dofs;
+
+  std::vector< std::vector<PetscInt> > split_index(2);
+  for(unsigned int i=0; i<n_device_dofs; ++i)
+    split_index[0].push_back(global_offset + i);
+  for(unsigned int i=n_device_dofs; i<n_local_dofs; ++i)
+    split_index[1].push_back(global_offset + i);
+
+  // the schur complement is solved by GMRES, the outer solver should be a krylov method
+  ierr = KSPSetType (ksp, (char*) KSPGMRES);  genius_assert(!ierr);
+  ierr = PCSetType (pc, (char*) PCFIELDSPLIT);  genius_assert(!ierr);
+  ierr = PCFieldSplitSetType(pc, PC_COMPOSITE_SCHUR);  genius_assert(!ierr);
+  set_solver_option("-pc_fieldsplit_schur_factorization_type", "full");
+
+  for(unsigned int v=0; v<2; ++v)
+  {
+    std::stringstream split_name;
+    split_name << v;
+
+    IS is;
+    PetscInt * index = split_index[v].empty() ? PETSC_NULL : &split_index[v][0];
+#ifdef PETSC_VERSION_DEV
+    ierr = ISCreateGeneral(PETSC_COMM_WORLD, split_index[v].size(), index, PETSC_COPY_VALUES, &is); genius_assert(!ierr);
+    ierr = PCFieldSplitSetIS(pc, split_name.str().c_str(), is);  genius_assert(!ierr);
+#else
+    ierr = ISCreateGeneral(PETSC_COMM_WORLD, split_index[v].size(), index, &is); genius_assert(!ierr);
+    ierr = PCFieldSplitSetIS(pc, is);  genius_assert(!ierr);
+#endif
+    ierr = ISDestroy(is);  genius_assert(!ierr);
+  }
+
+  // the device block has no circuit rows, it is factorized without shift
+  set_solver_option("-fieldsplit_0_ksp_type", "preonly");
+  set_solver_option("-fieldsplit_0_pc_type", "lu");
+  if (Genius::n_processors() > 1)
+  {
+#ifdef PETSC_HAVE_MUMPS
+    set_solver_option("-fieldsplit_0_pc_factor_mat_solver_package", "mumps");
+#else
+    set_solver_option("-fieldsplit_0_pc_factor_mat_solver_package", "superlu_dist");
+#endif
+  }
+
+  // the schur complement is as small as the circuit, GMRES without restart solves it exactly
+  std::stringstream restart;
+  restart << this->extra_dofs() + 1;
+  set_solver_option("-fieldsplit_1_ksp_type", "gmres");
+  set_solver_option("-fieldsplit_1_ksp_gmres_restart", restart.str());
+  set_solver_option("-fieldsplit_1_ksp_max_it", restart.str());
+  set_solver_option("-fieldsplit_1_ksp_rtol", "1e-12");
+  set_solver_option("-fieldsplit_1_pc_type", "none");
+
+  MESSAGE<<"Using schur complement on " << this->extra_dofs() << " circuit dofs for device/circuit coupling."<<std::endl;  RECORD();
+#else
+  MESSAGE<<"Warning: schur complement preconditioner requires PETSc 3.1 or later, ignored."<<std::endl;  RECORD();
+#endif
+}
+
+
+
 //FIXME the default LU solver of petsc has many problems with mixA solver
 // one must use PCFactorSetShiftNonzero to avoid zero pivot -- however, nonlinear convergence maybe poor with this argument
 // and PCFactorReorderForNonzeroDiagonal may cause a segment fault error.
@@ -287,12 +362,8 @@ void MixASolverBase::build_spice_function(PetscScalar *lxx, Vec f, InsertMode &a
   // only the last processor do this
   if(Genius::is_last_processor())
   {
-    // insert x into spice rhs old
-    for(unsigned int n=0; n<_circuit->n_ckt_nodes(); ++n)
-      _circuit->rhs_old(n) = lxx[_circuit->local_offset(n)];
-
     // ask spice to build new rhs and matrix
-    _circuit->circuit_load();
+    spice_circuit_load(lxx, false);
 
     std::vector<PetscInt> iy;
     std::vector<PetscScalar> y;
@@ -319,26 +390,43 @@ void MixASolverBase::build_spice_jacobian(PetscScalar *lxx, Mat *jac, InsertMode
   // only the last processor do this
   if(Genius::is_last_processor())
   {
-    // ckt load has been done in build_spice_function
+    // ckt load has usually been done in build_spice_function, reload only when x or circuit mode changed
+    spice_circuit_load(lxx, true);
+
+    // gather all the circuit rows
+    const unsigned int n_rows = _circuit->n_ckt_nodes();
+    _spice_row_ptr.resize(n_rows+1);
+    _spice_rows.resize(n_rows);
+    _spice_cols.clear();
+    _spice_values.clear();
+    _spice_row_ptr[0] = 0;
+    for(unsigned int row=0; row<n_rows; ++row)
+    {
+      _circuit->ckt_matrix_row(row, _spice_rows[row], _spice_cols, _spice_values);
+      _spice_row_ptr[row+1] = _spice_cols.size();
+    }
 
-    // insert x into spice rhs old
-    for(unsigned int n=0; n<_circuit->n_ckt_nodes(); ++n)
-      _circuit->rhs_old(n) = lxx[_circuit->local_offset(n)];
+    // after the first assembly, the rows are added directly by precomputed slots
+    bool slot_add = J_slot_map.valid() && !J_slot_map.active();
+    if( slot_add )
+      J_slot_map.begin(*jac);
 
-    // ask spice to build new rhs and matrix
-    _circuit->circuit_load();
-
-    for(PetscInt row=0; row<static_cast<PetscInt>(_circuit->n_ckt_nodes())
-        ;
-        ++row)
+    for(unsigned int row=0; row<n_rows; ++row)
     {
-      std::vector<PetscInt> cols;
-      std::vector<PetscScalar> v;
-      PetscInt global_row;
-
-      _circuit->ckt_matrix_row(static_cast<unsigned int>(row), global_row, cols, v);
-      MatSetValues(*jac, 1, &global_row, cols.size(), &cols[0], &v[0], ADD_VALUES);
+      const PetscInt ncols = _spice_row_ptr[row+1] - _spice_row_ptr[row];
+      if( !ncols ) continue;
+
+      const PetscInt * cols = &_spice_cols[_spice_row_ptr[row]];
+      const PetscScalar * v = &_spice_values[_spice_row_ptr[row]];
+      const PetscInt * slots = slot_add ? _spice_slots.slots(J_slot_map, row, 1, &_spice_rows[row], ncols, cols) : 0;
+      if( slots )
+        J_slot_map.add(ncols, slots, v);
+      else
+        MatSetValues(*jac, 1, &_spice_rows[row], ncols, cols, v, ADD_VALUES);
     }
+
+    if( slot_add )
+      J_slot_map.end(*jac);
   }
 
   // the last operator is ADD_VALUES
@@ -346,6 +434,25 @@ void MixASolverBase::build_spice_jacobian(PetscScalar *lxx, Mat *jac, InsertMode
 }
 
 
+void MixASolverBase::spice_circuit_load(const PetscScalar *lxx, bool reuse)
+{
+  const unsigned int n_nodes = _circuit->n_ckt_nodes();
+
+  bool changed = !reuse || _spice_load_x.size() != n_nodes || _spice_load_mode != _circuit->ckt_mode();
+  for(unsigned int n=0; n<n_nodes && !changed; ++n)
+    changed = ( _spice_load_x[n] != lxx[_circuit->local_offset(n)] );
+  if( !changed ) return;
+
+  // insert x into spice rhs old
+  _spice_load_x.resize(n_nodes);
+  for(unsigned int n=0; n<n_nodes; ++n)
+    _circuit->rhs_old(n) = _spice_load_x[n] = lxx[_circuit->local_offset(n)];
+
+  _circuit->circuit_load();
+  _spice_load_mode = _circuit->ckt_mode();
+}
+
+
 void MixASolverBase::ground_spice_0_node(Vec f,InsertMode &add_value_flag)
 {
   // since we will use INSERT_VALUES operat, check the vec state.
@@ -490,9 +597,9 @@ int MixASolverBase::solve_dcop(bool tran_op)
   // saved solutions and vscan values for solution projection.
   Vec xs1, xs2, xs3;
   PetscScalar Vs1, Vs2, Vs3;
-  VecDuplicate(x,&xs1);
-  VecDuplicate(x,&xs2);
-  VecDuplicate(x,&xs3);
+  xs1 = get_work_vector();
+  xs2 = get_work_vector();
+  xs3 = get_work_vector();
 
   SolverSpecify::DC_Cycles=0;
   int retry=0;
@@ -580,35 +687,12 @@ int MixASolverBase::solve_dcop(bool tran_op)
     }
 
     if (SolverSpecify::Predict)
-    {
-      PetscScalar hn = double(step)/rampup_steps-Vs1;
-      PetscScalar hn1 = Vs1-Vs2;
-      PetscScalar hn2 = Vs2-Vs3;
-      if(SolverSpecify::DC_Cycles>=3)
-      {
-        // quadradic projection
-        PetscScalar cn=hn*(hn+2*hn1+hn2)/(hn1*(hn1+hn2));
-        PetscScalar cn1=-hn*(hn+hn1+hn2)/(hn1*hn2);
-        PetscScalar cn2=hn*(hn+hn1)/(hn2*(hn1+hn2));
-
-        VecAXPY(x,cn,xs1);
-        VecAXPY(x,cn1,xs2);
-        VecAXPY(x,cn2,xs3);
-        this->projection_positive_density_check(x,xs1);
-      }
-      else if(SolverSpecify::DC_Cycles>=2)
-      {
-        // linear projection
-        VecAXPY(x, hn/hn1,xs1);
-        VecAXPY(x,-hn/hn1,xs2);
-        this->projection_positive_density_check(x,xs1);
-      }
-    }
+      sweep_predict(double(step)/rampup_steps, Vs1, Vs2, Vs3, xs1, xs2, xs3, SolverSpecify::DC_Cycles);
   }
 
-  VecDestroy(xs1);
-  VecDestroy(xs2);
-  VecDestroy(xs3);
+  restore_work_vector(xs1);
+  restore_work_vector(xs2);
+  restore_work_vector(xs3);
 
 
   // scale gmin back to user given value
@@ -721,9 +805,9 @@ int MixASolverBase::solve_dcsweep()
     Vec xs1, xs2, xs3;
     PetscScalar Vs1, Vs2, Vs3;
     std::stack<PetscScalar> V_retry;
-    VecDuplicate(x,&xs1);
-    VecDuplicate(x,&xs2);
-    VecDuplicate(x,&xs3);
+    xs1 = get_work_vector();
+    xs2 = get_work_vector();
+    xs3 = get_work_vector();
 
     // main loop
     for(SolverSpecify::DC_Cycles=0;  Vscan*SolverSpecify::VStep < SolverSpecify::VStop*SolverSpecify::VStep*(1.0+1e-7);)
@@ -756,6 +840,13 @@ int MixASolverBase::solve_dcsweep()
         if(Genius::is_last_processor())
           _circuit->rotate_state_vectors();
 
+        // a hook has got what it wants
+        if ( this->stop_requested() )
+        {
+          MESSAGE<<"Solve stopped by request: " << this->stop_reason() << "\n\n\n"; RECORD();
+          break;
+        }
+
         SolverSpecify::DC_Cycles++;
 
         // save solution for linear/quadratic projection
@@ -784,9 +875,8 @@ int MixASolverBase::solve_dcsweep()
         if(fabs(Vscan-SolverSpecify::VStop)<1e-10)
           Vscan=SolverSpecify::VStop;
 
-        // if v step small than VStepMax, mult by factor of 1.1
-        if( fabs(VStep) < fabs(SolverSpecify::VStepMax) )
-          VStep *= 1.1;
+        // adjust v step, bounded by VStepMax
+        VStep = sweep_step(VStep, SolverSpecify::VStepMax);
 
 
         // however, for last step, we force V equal to VStop
@@ -827,35 +917,12 @@ int MixASolverBase::solve_dcsweep()
       }
 
       if (SolverSpecify::Predict)
-      {
-        PetscScalar hn = Vscan-Vs1;
-        PetscScalar hn1 = Vs1-Vs2;
-        PetscScalar hn2 = Vs2-Vs3;
-        if(SolverSpecify::DC_Cycles>=3)
-        {
-          // quadradic projection
-          PetscScalar cn=hn*(hn+2*hn1+hn2)/(hn1*(hn1+hn2));
-          PetscScalar cn1=-hn*(hn+hn1+hn2)/(hn1*hn2);
-          PetscScalar cn2=hn*(hn+hn1)/(hn2*(hn1+hn2));
-
-          VecAXPY(x,cn,xs1);
-          VecAXPY(x,cn1,xs2);
-          VecAXPY(x,cn2,xs3);
-          this->projection_positive_density_check(x,xs1);
-        }
-        else if(SolverSpecify::DC_Cycles>=2)
-        {
-          // linear projection
-          VecAXPY(x, hn/hn1,xs1);
-          VecAXPY(x,-hn/hn1,xs2);
-          this->projection_positive_density_check(x,xs1);
-        }
-      }
+        sweep_predict(Vscan, Vs1, Vs2, Vs3, xs1, xs2, xs3, SolverSpecify::DC_Cycles);
     }
 
-    VecDestroy(xs1);
-    VecDestroy(xs2);
-    VecDestroy(xs3);
+    restore_work_vector(xs1);
+    restore_work_vector(xs2);
+    restore_work_vector(xs3);
 
   }
 
@@ -879,9 +946,9 @@ int MixASolverBase::solve_dcsweep()
     Vec xs1, xs2, xs3;
     PetscScalar Is1, Is2, Is3;
     std::stack<PetscScalar> I_retry;
-    VecDuplicate(x,&xs1);
-    VecDuplicate(x,&xs2);
-    VecDuplicate(x,&xs3);
+    xs1 = get_work_vector();
+    xs2 = get_work_vector();
+    xs3 = get_work_vector();
 
     // main loop
     for(SolverSpecify::DC_Cycles=0;  Iscan*SolverSpecify::IStep < SolverSpecify::IStop*SolverSpecify::IStep*(1.0+1e-7);)
@@ -910,6 +977,13 @@ int MixASolverBase::solve_dcsweep()
         // call post_solve_process
         this->post_solve_process();
 
+        // a hook has got what it wants
+        if ( this->stop_requested() )
+        {
+          MESSAGE<<"Solve stopped by request: " << this->stop_reason() << "\n\n\n"; RECORD();
+          break;
+        }
+
         SolverSpecify::DC_Cycles++;
 
         // save solution for linear/quadratic projection
@@ -938,9 +1012,8 @@ int MixASolverBase::solve_dcsweep()
         if(fabs(Iscan-SolverSpecify::IStop)<1e-10)
           Iscan=SolverSpecify::IStop;
 
-        // if I step small than IStepMax, mult by factor of 1.1
-        if( fabs(IStep) < fabs(SolverSpecify::IStepMax) )
-          IStep *= 1.1;
+        // adjust I step, bounded by IStepMax
+        IStep = sweep_step(IStep, SolverSpecify::IStepMax);
 
 
         // however, for last step, we force I equal to IStop
@@ -981,38 +1054,284 @@ int MixASolverBase::solve_dcsweep()
       }
 
       if (SolverSpecify::Predict)
+        sweep_predict(Iscan, Is1, Is2, Is3, xs1, xs2, xs3, SolverSpecify::DC_Cycles);
+    }
+
+    restore_work_vector(xs1);
+    restore_work_vector(xs2);
+    restore_work_vector(xs3);
+  }
+
+  return 0;
+}
+
+
+
+/*----------------------------------------------------------------------------
+ * solve the dense system A x = b by gauss elimination with partial pivoting,
+ * x is returned in b. the circuit matrix has zero diagonal of voltage source branch
+ */
+static bool dense_pivot_solve(std::vector<PetscScalar> &A, std::vector<PetscScalar> &b, const unsigned int n)
+{
+  for(unsigned int k=0; k<n; ++k)
+  {
+    unsigned int p = k;
+    for(unsigned int i=k+1; i<n; ++i)
+      if( std::abs(A[i*n+k]) > std::abs(A[p*n+k]) ) p = i;
+    if( A[p*n+k] == 0.0 ) return false;
+
+    if( p != k )
+    {
+      for(unsigned int j=0; j<n; ++j)
+        std::swap(A[k*n+j], A[p*n+j]);
+      std::swap(b[k], b[p]);
+    }
+
+    for(unsigned int i=k+1; i<n; ++i)
+    {
+      const PetscScalar l = A[i*n+k]/A[k*n+k];
+      if( l == 0.0 ) continue;
+      for(unsigned int j=k+1; j<n; ++j)
+        A[i*n+j] -= l*A[k*n+j];
+      b[i] -= l*b[k];
+    }
+  }
+
+  for(unsigned int ii=n; ii>0; --ii)
+  {
+    const unsigned int i = ii-1;
+    for(unsigned int j=i+1; j<n; ++j)
+      b[i] -= A[i*n+j]*b[j];
+    b[i] /= A[i*n+i];
+  }
+
+  return true;
+}
+
+
+
+/*----------------------------------------------------------------------------
+ * the device seen by the circuit between two synchronized steps is a norton companion
+ * I(V) = I_sync + G*(V - V_sync) at each spice node linked to electrode
+ */
+void MixASolverBase::spice_multirate_sync()
+{
+  _spice_clock = SolverSpecify::clock;
+
+  if( !Genius::is_last_processor() ) return;
+
+  // spice nodes linked to electrode, the ground node is excluded
+  bool first_sync = _spice_sync_nodes.empty();
+  if( first_sync )
+  {
+    std::set<unsigned int> nodes;
+    for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); ++b)
+    {
+      const BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
+      if( !bc->is_electrode() ) continue;
+      unsigned int n = _circuit->get_spice_node_by_bc(bc);
+      if( n != 0 && n != invalid_uint ) nodes.insert(n);
+    }
+    _spice_sync_nodes.assign(nodes.begin(), nodes.end());
+    _spice_sync_v.resize(_spice_sync_nodes.size());
+    _spice_sync_i.resize(_spice_sync_nodes.size());
+    _spice_sync_g.assign(_spice_sync_nodes.size(), SolverSpecify::Gmin);
+  }
+
+  // the circuit has been loaded with the converged solution by the last residual evaluation.
+  // the device current into the spice node balances the circuit residual of this row
+  std::vector<PetscInt> iy;
+  std::vector<PetscScalar> y;
+  _circuit->ckt_residual(iy, y);
+
+  for(unsigned int k=0; k<_spice_sync_nodes.size(); ++k)
+  {
+    const unsigned int n = _spice_sync_nodes[k];
+    const PetscScalar v = _circuit->rhs_old(n);
+    const PetscScalar i = -y[n];
+
+    // secant conductance to the last synchronized step, keep the old one for tiny voltage change
+    if( !first_sync && std::abs(v - _spice_sync_v[k]) > 1e-6 )
+      _spice_sync_g[k] = std::max( (i - _spice_sync_i[k])/(v - _spice_sync_v[k]), PetscScalar(SolverSpecify::Gmin) );
+
+    _spice_sync_v[k] = v;
+    _spice_sync_i[k] = i;
+  }
+}
+
+
+
+/*----------------------------------------------------------------------------
+ * newton iteration of circuit alone, with the device replaced by norton companion
+ */
+bool MixASolverBase::spice_circuit_newton()
+{
+  const unsigned int n_nodes = _circuit->n_ckt_nodes();
+  const unsigned int offset = _circuit->spice_global_offset();
+
+  // the unknowns are ordered as the columns of spice matrix
+  std::vector<unsigned int> node_col(n_nodes);
+  for(unsigned int n=0; n<n_nodes; ++n)
+    node_col[n] = _circuit->global_offset(n) - offset;
+
+  std::vector<PetscScalar> J(n_nodes*n_nodes);
+  std::vector<PetscScalar> f(n_nodes);
+  std::vector<PetscInt> iy, cols;
+  std::vector<PetscScalar> y, values;
+
+  for(unsigned int its=0; its<SolverSpecify::MaxIteration; ++its)
+  {
+    _circuit->circuit_load();
+
+    iy.clear();
+    y.clear();
+    _circuit->ckt_residual(iy, y);
+
+    std::fill(J.begin(), J.end(), 0.0);
+    for(unsigned int row=1; row<n_nodes; ++row)
+    {
+      PetscInt global_row;
+      cols.clear();
+      values.clear();
+      _circuit->ckt_matrix_row(row, global_row, cols, values);
+      for(unsigned int i=0; i<cols.size(); ++i)
+        J[row*n_nodes + cols[i] - offset] += values[i];
+      f[row] = -y[row];
+    }
+
+    // the ground node
+    J[node_col[0]] = 1.0;
+    f[0] = -_circuit->rhs_old(0);
+
+    // the device current flow out of the spice node
+    for(unsigned int k=0; k<_spice_sync_nodes.size(); ++k)
+    {
+      const unsigned int n = _spice_sync_nodes[k];
+      f[n] -= _spice_sync_i[k] + _spice_sync_g[k]*(_circuit->rhs_old(n) - _spice_sync_v[k]);
+      J[n*n_nodes + node_col[n]] += _spice_sync_g[k];
+    }
+
+    if( !dense_pivot_solve(J, f, n_nodes) ) return false;
+
+    // update the node values, converged by the tolerance of spice
+    bool converged = true;
+    for(unsigned int n=0; n<n_nodes; ++n)
+    {
+      const PetscScalar dv = f[node_col[n]];
+      if( dv != dv ) return false;
+
+      const PetscScalar v = _circuit->rhs_old(n);
+      const PetscScalar abs_tol = _circuit->is_current_node(n) ? 1e-12 : 1e-6;
+      if( std::abs(dv) > 1e-3*std::abs(v) + abs_tol ) converged = false;
+      _circuit->rhs_old(n) = v + dv;
+    }
+
+    // spice may ask for more iterations after circuit mode changed
+    if( _circuit->change_ckt_mode(int(converged ? SNES_CONVERGED_FNORM_ABS : SNES_CONVERGED_ITERATING)) )
+      continue;
+
+    if( converged )
+    {
+      // the states of the reactive elements should be evaluated with the final node values
+      _circuit->circuit_load();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+
+/*----------------------------------------------------------------------------
+ * advance the circuit alone by its own sub-steps
+ */
+PetscScalar MixASolverBase::spice_multirate_advance(PetscScalar t_sync, PetscScalar t_next)
+{
+  START_LOG("spice_multirate_advance()", "MixASolverBase");
+
+  PetscScalar t_end = t_next;
+  int n_substeps = 0;
+
+  if( Genius::is_last_processor() )
+  {
+    const PetscScalar window = t_next - t_sync;
+    const PetscScalar h_min = 1e-3*window/SolverSpecify::SpiceMultirateSubsteps;
+    PetscScalar h = std::max(_spice_substep, window/SolverSpecify::SpiceMultirateSubsteps);
+    PetscScalar t = t_sync;
+
+    std::vector<PetscScalar> v_old(_circuit->n_ckt_nodes());
+
+    while( n_substeps < SolverSpecify::SpiceMultirateSubsteps )
+    {
+      h = limit_dt_by_breakpoint(t, std::min(h, window));
+
+      // the last circuit step is solved together with the device
+      if( t + 1.5*h > t_next ) break;
+
+      for(unsigned int n=0; n<v_old.size(); ++n)
+        v_old[n] = _circuit->rhs_old(n);
+
+      _circuit->set_time((t+h)/PhysicalUnit::s);
+      _circuit->set_delta(h/PhysicalUnit::s);
+
+      if( !spice_circuit_newton() )
       {
-        PetscScalar hn = Iscan-Is1;
-        PetscScalar hn1 = Is1-Is2;
-        PetscScalar hn2 = Is2-Is3;
-        if(SolverSpecify::DC_Cycles>=3)
-        {
-          // quadradic projection
-          PetscScalar cn=hn*(hn+2*hn1+hn2)/(hn1*(hn1+hn2));
-          PetscScalar cn1=-hn*(hn+hn1+hn2)/(hn1*hn2);
-          PetscScalar cn2=hn*(hn+hn1)/(hn2*(hn1+hn2));
-
-          VecAXPY(x,cn,xs1);
-          VecAXPY(x,cn1,xs2);
-          VecAXPY(x,cn2,xs3);
-          this->projection_positive_density_check(x,xs1);
-        }
-        else if(SolverSpecify::DC_Cycles>=2)
-        {
-          // linear projection
-          VecAXPY(x, hn/hn1,xs1);
-          VecAXPY(x,-hn/hn1,xs2);
-          this->projection_positive_density_check(x,xs1);
-        }
+        for(unsigned int n=0; n<v_old.size(); ++n)
+          _circuit->rhs_old(n) = v_old[n];
+        _circuit->set_ckt_mode( MODETRAN | MODEINITPRED );
+
+        h *= 0.5;
+        if( h < h_min ) break;
+        continue;
+      }
+
+      // the electrode voltage leaves the range the norton companion is good for, the device
+      // synchronizes at t+h. the circuit solution at t+h is kept as initial guess
+      bool drift = false;
+      for(unsigned int k=0; k<_spice_sync_nodes.size(); ++k)
+      {
+        const PetscScalar v = _circuit->rhs_old(_spice_sync_nodes[k]);
+        const PetscScalar v_sync = _spice_sync_v[k];
+        if( std::abs(v - v_sync) > SolverSpecify::SpiceMultirateTol*std::max(std::abs(v_sync), PetscScalar(1.0)) )
+          drift = true;
+      }
+      if( drift )
+      {
+        t_end = t + h;
+        break;
       }
+
+      // accept this sub-step
+      _circuit->rotate_state_vectors();
+      _circuit->set_ckt_mode( MODETRAN | MODEINITPRED );
+      _circuit->set_time_order(2);
+
+      t += h;
+      _spice_substep = h;
+      n_substeps++;
+      h *= 1.5;
     }
 
-    VecDestroy(xs1);
-    VecDestroy(xs2);
-    VecDestroy(xs3);
+    _spice_clock = t;
+    _circuit->set_ckt_mode( MODETRAN | MODEINITPRED );
   }
 
-  return 0;
+  Parallel::broadcast(t_end, Genius::last_processor_id());
+  Parallel::broadcast(n_substeps, Genius::last_processor_id());
+  Parallel::broadcast(_spice_clock, Genius::last_processor_id());
+  Parallel::broadcast(_spice_substep, Genius::last_processor_id());
+
+  if( n_substeps )
+  {
+    MESSAGE<<"Circuit advanced "<<n_substeps<<" sub-steps to t = "<<_spice_clock/PhysicalUnit::s<<" s"
+           <<", device synchronizes at t = "<<t_end/PhysicalUnit::s<<" s\n";
+    RECORD();
+  }
+
+  STOP_LOG("spice_multirate_advance()", "MixASolverBase");
+
+  return t_end;
 }
 
 
@@ -1025,12 +1344,22 @@ int MixASolverBase::solve_transient()
   // diverged counter
   int diverged_retry=0;
 
+  // circuit dofs should take the values predicted by multirate sub-steps
+  bool spice_predicted = false;
+
   // init aux vectors used in transient simulation
-  VecDuplicate(x, &x_n);
-  VecDuplicate(x, &x_n1);
-  VecDuplicate(x, &x_n2);
-  VecDuplicate(x, &xp);
-  VecDuplicate(x, &LTE);
+  x_n = get_work_vector();
+  x_n1 = get_work_vector();
+  x_n2 = get_work_vector();
+  xp = get_work_vector();
+  LTE = get_work_vector();
+  x_pss = get_work_vector();
+
+  // no LTE history for PI control yet
+  lte_last = 0.0;
+
+  // no period boundary for PSS detection yet
+  pss_clock = -1.0;
 
   // set spice circuit, does uic required?
   if(Genius::is_last_processor())
@@ -1051,6 +1380,14 @@ int MixASolverBase::solve_transient()
   // time dependent
   SolverSpecify::TimeDependent = true;
 
+  // the spice circuit is integrated by BDF1/BDF2 only
+  const bool trbdf2 = ( SolverSpecify::TS_type==SolverSpecify::TRBDF2 );
+  if(trbdf2)
+  {
+    MESSAGE<<"Warning: TRBDF2 scheme is not supported by mixed-mode transient, BDF2 is used instead.\n"; RECORD();
+    SolverSpecify::TS_type = SolverSpecify::BDF2;
+  }
+
   // if BDF2 scheme is used, we should set SolverSpecify::BDF2_restart flag to true
   if(SolverSpecify::TS_type==SolverSpecify::BDF2)
     SolverSpecify::BDF2_restart = true;
@@ -1068,6 +1405,11 @@ int MixASolverBase::solve_transient()
   // time step counter
   SolverSpecify::T_Cycles=0;
 
+  // no synchronized step of multirate coupling yet
+  _spice_sync_nodes.clear();
+  _spice_clock = SolverSpecify::TStart;
+  _spice_substep = 0.0;
+
   // set spice circuit
   if(Genius::is_last_processor())
   {
@@ -1089,11 +1431,22 @@ int MixASolverBase::solve_transient()
     <<"--------------------------------------------------------------------------------\n";
     RECORD();
 
+    // the circuit has been advanced by multirate sub-steps, a rejected step can not go back before it
+    if( SolverSpecify::SpiceMultirate && SolverSpecify::clock <= _spice_clock )
+    {
+      PetscScalar t_sync = SolverSpecify::clock - SolverSpecify::dt;
+      _spice_substep *= 0.5;
+      SolverSpecify::clock = _spice_clock + _spice_substep;
+      SolverSpecify::dt = SolverSpecify::clock - t_sync;
+    }
+
     //update sources to current clock
     if(Genius::is_last_processor())
     {
+      // the circuit steps from its own last state, which is the last device step without multirate
+      PetscScalar ckt_dt = SolverSpecify::SpiceMultirate ? SolverSpecify::clock - _spice_clock : SolverSpecify::dt;
       _circuit->set_time(SolverSpecify::clock/PhysicalUnit::s);
-      _circuit->set_delta(SolverSpecify::dt/PhysicalUnit::s);
+      _circuit->set_delta(ckt_dt/PhysicalUnit::s);
     }
 
     _system.get_field_source()->update(SolverSpecify::clock);
@@ -1154,7 +1507,8 @@ int MixASolverBase::solve_transient()
          ((SolverSpecify::TS_type==SolverSpecify::BDF1 && SolverSpecify::T_Cycles>=3) ||
           (SolverSpecify::TS_type==SolverSpecify::BDF2 && SolverSpecify::T_Cycles>=4) )  )
     {
-      PetscScalar r = this->LTE_norm();
+      PetscScalar lte = this->LTE_norm() + 1e-10;
+      PetscScalar r = lte;
 
       if(SolverSpecify::TS_type==SolverSpecify::BDF1)
         r = std::pow(r, PetscScalar(-1.0/2));
@@ -1190,7 +1544,9 @@ int MixASolverBase::solve_transient()
         SolverSpecify::dt_last_last = SolverSpecify::dt_last;
         SolverSpecify::dt_last = SolverSpecify::dt;
         // set next time step
-        if( r > 10.0 )
+        if( SolverSpecify::TS_PIControl )
+          SolverSpecify::dt *= pi_step_factor(lte, SolverSpecify::TS_type==SolverSpecify::BDF1 ? 1 : 2);
+        else if( r > 10.0 )
           SolverSpecify::dt *= 2.0;
         else if( r > 3.0 )
           SolverSpecify::dt *= 1.5;
@@ -1200,6 +1556,7 @@ int MixASolverBase::solve_transient()
           SolverSpecify::dt *= 1.0;
         else
           SolverSpecify::dt *= 0.9;
+        lte_last = lte;
 
         // limit the max time step to TStepMax
         if(SolverSpecify::dt > SolverSpecify::TStepMax)
@@ -1229,9 +1586,29 @@ int MixASolverBase::solve_transient()
     if(Genius::is_last_processor() && SolverSpecify::T_Cycles==0)
       _circuit->prepare_ckt_state_first_time();
 
+    // device and circuit are synchronized at this step
+    if( SolverSpecify::SpiceMultirate )
+      this->spice_multirate_sync();
+
+    // stop at periodic steady state
+    if ( pss_converged() )
+    {
+      MESSAGE<<"Periodic steady state reached at t = " << SolverSpecify::clock/PhysicalUnit::s << " s\n\n"; RECORD();
+      break;
+    }
+
+    // a hook has got what it wants
+    if ( this->stop_requested() )
+    {
+      MESSAGE<<"Solve stopped by request: " << this->stop_reason() << "\n\n\n"; RECORD();
+      break;
+    }
+
     // time step counter ++
     SolverSpecify::T_Cycles++;
 
+    // do not step over the corners of source waveforms
+    SolverSpecify::dt = limit_dt_by_breakpoint(SolverSpecify::clock, SolverSpecify::dt);
 
     // set clock to next time step
     SolverSpecify::clock += SolverSpecify::dt;
@@ -1262,6 +1639,16 @@ int MixASolverBase::solve_transient()
       _circuit->set_time_order(2);
     }
 
+    // the circuit runs ahead with its own sub-steps, the device step ends where the circuit asks for synchronization.
+    // the secant conductance of norton companion needs two synchronized steps
+    if( SolverSpecify::SpiceMultirate && SolverSpecify::T_Cycles >= 2 )
+    {
+      PetscScalar t_sync = SolverSpecify::clock - SolverSpecify::dt;
+      SolverSpecify::clock = this->spice_multirate_advance(t_sync, SolverSpecify::clock);
+      SolverSpecify::dt = SolverSpecify::clock - t_sync;
+      spice_predicted = true;
+    }
+
   Predict:
 
     // predict next solution
@@ -1294,17 +1681,32 @@ int MixASolverBase::solve_transient()
       }
     }
 
+    // the circuit solution of sub-steps is a better guess than the polynomial predict
+    if ( spice_predicted )
+    {
+      spice_fill_value(x, L);
+      VecAssemblyBegin(x);
+      VecAssemblyBegin(L);
+      VecAssemblyEnd(x);
+      VecAssemblyEnd(L);
+      spice_predicted = false;
+    }
+
   }
   while(SolverSpecify::clock < SolverSpecify::TStop+0.5*SolverSpecify::dt);
 
 
 end:
+  if(trbdf2)
+    SolverSpecify::TS_type = SolverSpecify::TRBDF2;
+
   // free aux vectors
-  VecDestroy(x_n);
-  VecDestroy(x_n1);
-  VecDestroy(x_n2);
-  VecDestroy(xp);
-  VecDestroy(LTE);
+  restore_work_vector(x_n);
+  restore_work_vector(x_n1);
+  restore_work_vector(x_n2);
+  restore_work_vector(xp);
+  restore_work_vector(LTE);
+  restore_work_vector(x_pss);
 
   return 0;
 }
@@ -1326,15 +1728,19 @@ void MixASolverBase::petsc_snes_convergence_test(PetscInt its, PetscReal , Petsc
   {
     snes->ttol = fnorm*snes->rtol;
 
-    MESSAGE<<" "<<" n ";
-    MESSAGE<<"| Eq(V) | "<<"| Eq(n) | "<<"| Eq(p) | ";
-    MESSAGE<<"| Eq(T) | ";
-    MESSAGE<<"|Eq(Tn)|  ";
-    MESSAGE<<"|Eq(Tp)|  ";
-    MESSAGE<<"|Eq(BC)|  ";
-    MESSAGE<<"Lg(dx)"<<'\n';
-    MESSAGE<<"--------------------------------------------------------------------------------\n";
-    RECORD();
+    // the table of residual norms, one row per iteration
+    if( genius_log.enabled(GENIUS_LOG_STREAM::ITERATION) )
+    {
+      MESSAGE<<" "<<" n ";
+      MESSAGE<<"| Eq(V) | "<<"| Eq(n) | "<<"| Eq(p) | ";
+      MESSAGE<<"| Eq(T) | ";
+      MESSAGE<<"|Eq(Tn)|  ";
+      MESSAGE<<"|Eq(Tp)|  ";
+      MESSAGE<<"|Eq(BC)|  ";
+      MESSAGE<<"Lg(dx)"<<'\n';
+      MESSAGE<<"--------------------------------------------------------------------------------\n";
+      RECORD();
+    }
   }
 
   bool  poisson_conv              = poisson_norm              < SolverSpecify::toler_relax*SolverSpecify::poisson_abs_toler;
@@ -1345,27 +1751,30 @@ void MixASolverBase::petsc_snes_convergence_test(PetscInt its, PetscReal , Petsc
   bool  elec_energy_equation_conv = elec_energy_equation_norm < SolverSpecify::toler_relax*SolverSpecify::elec_energy_abs_toler;
   bool  hole_energy_equation_conv = hole_energy_equation_norm < SolverSpecify::toler_relax*SolverSpecify::hole_energy_abs_toler;
 
+  if( genius_log.enabled(GENIUS_LOG_STREAM::ITERATION) )
+  {
 #ifdef CYGWIN
-  MESSAGE.precision(1);
+    MESSAGE.precision(1);
 #else
 
-  MESSAGE.precision(2);
+    MESSAGE.precision(2);
 #endif
 
-  MESSAGE<< std::setw(3) << its << " " ;
-  MESSAGE<< std::scientific;
-  MESSAGE<< poisson_norm << (poisson_conv ? "* " : "  ");
-  MESSAGE<< elec_continuity_norm << (elec_continuity_conv ? "* " : "  ");
-  MESSAGE<< hole_continuity_norm << (hole_continuity_conv ? "* " : "  ");
-  MESSAGE<< heat_equation_norm   << (heat_equation_conv ? "* " : "  ");
-  MESSAGE<< elec_energy_equation_norm << (elec_energy_equation_conv ? "* " : "  ");
-  MESSAGE<< hole_energy_equation_norm << (hole_energy_equation_conv ? "* " : "  ");
-  MESSAGE<< electrode_norm << (electrode_conv ? "* " : "  ");
-  MESSAGE<< std::fixed << std::setw(4) << (pnorm==0.0 ? -std::numeric_limits<PetscScalar>::infinity():log10(pnorm))
-    << (pnorm < SolverSpecify::relative_toler ? "*" : " ") << "\n" ;
-  RECORD();
-  MESSAGE.precision ( 6 );
-  MESSAGE<< std::scientific;
+    MESSAGE<< std::setw(3) << its << " " ;
+    MESSAGE<< std::scientific;
+    MESSAGE<< poisson_norm << (poisson_conv ? "* " : "  ");
+    MESSAGE<< elec_continuity_norm << (elec_continuity_conv ? "* " : "  ");
+    MESSAGE<< hole_continuity_norm << (hole_continuity_conv ? "* " : "  ");
+    MESSAGE<< heat_equation_norm   << (heat_equation_conv ? "* " : "  ");
+    MESSAGE<< elec_energy_equation_norm << (elec_energy_equation_conv ? "* " : "  ");
+    MESSAGE<< hole_energy_equation_norm << (hole_energy_equation_conv ? "* " : "  ");
+    MESSAGE<< electrode_norm << (electrode_conv ? "* " : "  ");
+    MESSAGE<< std::fixed << std::setw(4) << (pnorm==0.0 ? -std::numeric_limits<PetscScalar>::infinity():log10(pnorm))
+      << (pnorm < SolverSpecify::relative_toler ? "*" : " ") << "\n" ;
+    RECORD();
+    MESSAGE.precision ( 6 );
+    MESSAGE<< std::scientific;
+  }
 
   // check for NaN (Not a Number)
   if (fnorm != fnorm)
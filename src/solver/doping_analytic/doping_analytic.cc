@@ -22,7 +22,17 @@
 //  $Id: doping_analytic.cc,v 1.10 2008/07/09 05:58:16 gdiso Exp $
 
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <sys/stat.h>
+
+#include "genius_env.h"
 #include "mesh_base.h"
+#include "mesh_tools.h"
 #include "doping_analytic/doping_analytic.h"
 #include "semiconductor_region.h"
 #include "interpolation_1d_linear.h"
@@ -31,10 +41,170 @@
 #include "interpolation_2d_nn.h"
 //#include "interpolation_3d_qshep.h"
 #include "interpolation_3d_nbtet.h"
+#include "interpolation_3d_shepard.h"
+#include "mapped_file.h"
 
 using PhysicalUnit::cm;
 using PhysicalUnit::um;
 
+
+namespace
+{
+  /**
+   * the doping functions binned by a uniform grid over the mesh bounding box.
+   * each cell lists, in order, the functions whose influence box overlaps it
+   */
+  class DopingFunctionBins
+  {
+  public:
+    DopingFunctionBins(const MeshTools::BoundingBox &bbox, const std::vector<DopingFunction *> &funs)
+    {
+      for(unsigned int d=0; d<3; ++d)
+      {
+        _min[d] = bbox.first(d);
+        const double extent = bbox.second(d) - bbox.first(d);
+        _n[d] = extent > 0.0 ? 32 : 1;
+        _h[d] = extent > 0.0 ? extent/_n[d] : 1.0;
+      }
+      _cells.resize(_n[0]*_n[1]*_n[2]);
+
+      for(unsigned int f=0; f<funs.size(); ++f)
+      {
+        double box[6];
+        funs[f]->influence_box(box[0], box[1], box[2], box[3], box[4], box[5]);
+
+        unsigned int lo[3], hi[3];
+        bool overlap = true;
+        for(unsigned int d=0; d<3; ++d)
+        {
+          if( box[2*d+1] < bbox.first(d) || box[2*d] > bbox.second(d) ) overlap = false;
+          lo[d] = _index(d, box[2*d]);
+          hi[d] = _index(d, box[2*d+1]);
+        }
+        if( !overlap ) continue;
+
+        for(unsigned int i=lo[0]; i<=hi[0]; ++i)
+          for(unsigned int j=lo[1]; j<=hi[1]; ++j)
+            for(unsigned int k=lo[2]; k<=hi[2]; ++k)
+              _cells[(i*_n[1] + j)*_n[2] + k].push_back(f);
+      }
+    }
+
+    /**
+     * @return the functions which may contribute at point p
+     */
+    const std::vector<unsigned int> & functions(const Point &p) const
+    {
+      return _cells[(_index(0, p(0))*_n[1] + _index(1, p(1)))*_n[2] + _index(2, p(2))];
+    }
+
+  private:
+
+    unsigned int _index(unsigned int d, double x) const
+    {
+      const double t = std::floor((x - _min[d])/_h[d]);
+      if( t <= 0.0 ) return 0;
+      return std::min(static_cast<unsigned int>(std::min(t, 1e9)), _n[d]-1);
+    }
+
+    double       _min[3];
+    double       _h[3];
+    unsigned int _n[3];
+
+    std::vector< std::vector<unsigned int> > _cells;
+  };
+
+  const char         cache_magic[8] = {'G','D','O','P','I','N','G','\0'};
+  const unsigned int cache_version  = 1;
+
+  /**
+   * header of the binary cache of a doping file, the records of n_col doubles follow
+   */
+  struct DopingCacheHeader
+  {
+    char               magic[8];
+    unsigned int       version;
+    unsigned int       n_col;
+    unsigned long long n_records;
+    unsigned long long key;
+  };
+
+  // 64-bit FNV-1a
+  inline void hash_bytes(unsigned long long &h, const void * p, size_t n)
+  {
+    const unsigned char * c = static_cast<const unsigned char *>(p);
+    for(size_t i=0; i<n; ++i)
+    {
+      h ^= c[i];
+      h *= 1099511628211ULL;
+    }
+  }
+
+  /**
+   * the cache key of a doping file, hash of its size, modification time
+   * and the way it is read. @return false if the file does not exist
+   */
+  bool doping_cache_key(const std::string &fname, int skip_line, unsigned int n_col, unsigned long long &key)
+  {
+    struct stat st;
+    if( stat(fname.c_str(), &st) != 0 ) return false;
+    long long size  = st.st_size;
+    long long mtime = st.st_mtime;
+
+    key = 14695981039346656037ULL;
+    hash_bytes(key, &size, sizeof(size));
+    hash_bytes(key, &mtime, sizeof(mtime));
+    hash_bytes(key, &skip_line, sizeof(skip_line));
+    hash_bytes(key, &n_col, sizeof(n_col));
+    return true;
+  }
+
+  /**
+   * load the records of doping file from its cache. @return false if the cache is missing or out of date
+   */
+  bool load_doping_cache(const std::string &cache_file, unsigned long long key, unsigned int n_col, std::vector<double> &records)
+  {
+    MappedFile file(cache_file);
+    if( !file.good() || file.size() < sizeof(DopingCacheHeader) ) return false;
+
+    DopingCacheHeader header;
+    memcpy(&header, file.begin(), sizeof(DopingCacheHeader));
+    if( memcmp(header.magic, cache_magic, sizeof(cache_magic)) ) return false;
+    if( header.version != cache_version || header.key != key || header.n_col != n_col ) return false;
+    if( file.size() != sizeof(DopingCacheHeader) + header.n_records*n_col*sizeof(double) ) return false;
+
+    records.resize(header.n_records*n_col);
+    if( !records.empty() )
+      memcpy(&records[0], file.begin() + sizeof(DopingCacheHeader), records.size()*sizeof(double));
+    return true;
+  }
+
+  /**
+   * save the records of doping file to its cache
+   */
+  bool save_doping_cache(const std::string &cache_file, unsigned long long key, unsigned int n_col, const std::vector<double> &records)
+  {
+    DopingCacheHeader header;
+    memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version   = cache_version;
+    header.n_col     = n_col;
+    header.n_records = records.size()/n_col;
+    header.key       = key;
+
+    // write to a temporary file first, so a concurrent run never sees a partial cache
+    const std::string tmp_file = cache_file + ".tmp";
+    std::ofstream out(tmp_file.c_str(), std::ios::binary);
+    if( !out.good() ) return false;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(DopingCacheHeader));
+    if( !records.empty() )
+      out.write(reinterpret_cast<const char *>(&records[0]), records.size()*sizeof(double));
+    out.close();
+    if( !out.good() ) { std::remove(tmp_file.c_str()); return false; }
+    return std::rename(tmp_file.c_str(), cache_file.c_str()) == 0;
+  }
+}
+
+
 /*------------------------------------------------------------------
  * we parse input deck for doping profile here
  */
@@ -90,6 +260,20 @@ int DopingAnalytic::post_solve_process()
  */
 int DopingAnalytic::solve()
 {
+  // all the analytic functions, the custom defined ones follow the explicit ones
+  std::vector<DopingFunction *> funs(_doping_funs.begin(), _doping_funs.end());
+  std::vector<std::string> custom_names;
+  for (std::map<std::string,DopingFunction *>::iterator it = _custom_profile_funs.begin();
+       it!=_custom_profile_funs.end(); it++)
+  {
+    custom_names.push_back(it->first);
+    funs.push_back(it->second);
+  }
+  const unsigned int n_explicit = _doping_funs.size();
+
+  // each node only evaluates the functions whose influence box may hold it
+  const DopingFunctionBins bins(MeshTools::bounding_box(_system.mesh()), funs);
+
   //search for all the regions
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
@@ -99,36 +283,78 @@ int DopingAnalytic::solve()
     if( region->type() != SemiconductorRegion ) continue;
     SemiconductorSimulationRegion * semiconductor_region = dynamic_cast<SemiconductorSimulationRegion *>(region);
     // prepare region custom defined variable
-    std::map<std::string, std::pair<unsigned int, int> > ion_map;
-    for (std::map<std::string,DopingFunction *>::iterator it = _custom_profile_funs.begin();
-         it!=_custom_profile_funs.end(); it++)
+    std::vector< std::pair<unsigned int, int> > ions;
+    for (unsigned int i=0; i<custom_names.size(); i++)
     {
-      const std::string & name = it->first;
+      const std::string & name = custom_names[i];
       unsigned int ion_index = region->add_variable(SimulationVariable(name, SCALAR, POINT_CENTER, "cm^-3", invalid_uint, true, true));
       int ion_type = semiconductor_region->material()->band->IonType(name);
-      ion_map.insert(std::make_pair(name, std::make_pair(ion_index, ion_type)));
+      ions.push_back(std::make_pair(ion_index, ion_type));
     }
 
     SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
-    SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
-    for(; node_it!=node_it_end; ++node_it)
+    const int n_nodes = static_cast<int>(region->on_local_nodes_end() - node_it);
+
+#pragma omp parallel for schedule(static) num_threads(Genius::n_threads())
+    for(int i=0; i<n_nodes; ++i)
     {
-      FVM_Node * fvm_node = *node_it;
+      FVM_Node * fvm_node = *(node_it + i);
       FVM_NodeData * node_data = fvm_node->node_data();
       genius_assert(node_data!=NULL);
 
       const Node * node = fvm_node->root_node();
-      node_data->Na() = doping_Na( node );
-      node_data->Nd() = doping_Nd( node );
-      // fill custom defined variable
-      for (std::map<std::string,DopingFunction *>::iterator it = _custom_profile_funs.begin();
-           it!=_custom_profile_funs.end(); it++)
+      const double x = (*node)(0), y = (*node)(1), z = (*node)(2);
+
+      double Na = 0.0, Nd = 0.0;
+      for (unsigned int k=0; k<ions.size(); k++)
+        node_data->data<Real>(ions[k].first) = 0.0;
+
+      const std::vector<unsigned int> & cell_funs = bins.functions(*node);
+      for (unsigned int k=0; k<cell_funs.size(); k++)
       {
-        const std::string & name = it->first;
-        double d = it->second->profile((*node)(0),(*node)(1),(*node)(2));
-        node_data->data<Real>(ion_map[name].first) = d;
-        if(ion_map[name].second < 0 ) node_data->Na() += d;
-        if(ion_map[name].second > 0 ) node_data->Nd() += d;
+        const unsigned int f = cell_funs[k];
+        double d = funs[f]->profile(x, y, z);
+        if( f < n_explicit )
+        {
+          if( d < 0.0 ) Na -= d;
+          if( d > 0.0 ) Nd += d;
+        }
+        else
+        {
+          // fill custom defined variable
+          const std::pair<unsigned int, int> & ion = ions[f - n_explicit];
+          node_data->data<Real>(ion.first) = d;
+          if(ion.second < 0 ) Na += d;
+          if(ion.second > 0 ) Nd += d;
+        }
+      }
+
+      node_data->Na() = Na;
+      node_data->Nd() = Nd;
+    }
+
+    // the doping files are interpolated at all the nodes at once,
+    // the interpolator decides whether threads can be used
+    const double unit = 1.0/std::pow(PhysicalUnit::cm,3.0);
+    for(size_t d=0; d<_doping_data.size(); d++)
+    {
+      std::vector<Point> points(n_nodes);
+      for(int i=0; i<n_nodes; ++i)
+        points[i] = _doping_data_point(_doping_data[d].first, (*(node_it + i))->root_node());
+
+      std::vector<double> values;
+      _doping_data[d].second->interpolate_points(points, 0, values);
+#if defined(HAVE_FENV_H) && defined(DEBUG)
+      // the points outside the profile data may raise float exceptions, ignored
+      feclearexcept(FE_ALL_EXCEPT);
+#endif
+
+      for(int i=0; i<n_nodes; ++i)
+      {
+        FVM_NodeData * node_data = (*(node_it + i))->node_data();
+        double dop = unit * values[i];
+        if( dop < 0.0 ) node_data->Na() -= dop;
+        if( dop > 0.0 ) node_data->Nd() += dop;
       }
     }
 
@@ -206,7 +432,10 @@ void DopingAnalytic::set_doping_function_file(const Parser::Card & c)
     //interpolator = new Interpolation2D_CSA; // 2D profile
     break;
   case AXES_XYZ:
-    interpolator = new Interpolation3D_nbtet; // 3D profile
+    if(c.is_enum_value("interpolation", "shepard"))
+      interpolator = new Interpolation3D_Shepard; // 3D profile
+    else
+      interpolator = new Interpolation3D_nbtet; // 3D profile
   }
 
   interpolator->set_interpolation_type(0, InterpolationBase::Linear);
@@ -216,41 +445,90 @@ void DopingAnalytic::set_doping_function_file(const Parser::Card & c)
 
   if(Genius::processor_id()==0)
   {
-    std::ifstream in(fname.c_str());
-    if(!in.good())
+    // number of coordinates in each record, followed by the doping
+    unsigned int n_coord = 1;
+    if(axes == AXES_XY || axes == AXES_XZ || axes == AXES_YZ) n_coord = 2;
+    if(axes == AXES_XYZ) n_coord = 3;
+    const unsigned int n_col = n_coord + 1;
+
+    // the records as they are in the file, the transform is applied later
+    // so the cache does not depend on it
+    std::vector<double> records;
+
+    unsigned long long key;
+    if( !doping_cache_key(fname, skip_line, n_col, key) )
     {
       MESSAGE<<"ERROR at " << c.get_fileline() <<": can not open doping file " << fname << std::endl; RECORD();
       genius_error();
     }
 
-    MESSAGE<<"Loading doping profile from " << fname << ".\n"; RECORD();
+    const bool use_cache = c.get_bool("cache", true);
+    const std::string cache_file = fname + ".gdc";
 
-    int i;
-    for (i=0; i<skip_line && !in.eof(); i++)
+    if( use_cache && load_doping_cache(cache_file, key, n_col, records) )
     {
-      std::string line;
-      std::getline(in, line);
+      MESSAGE<<"Loading doping profile from " << fname << " (cached).\n"; RECORD();
     }
+    else
+    {
+      MappedFile in(fname);
+      if(!in.good())
+      {
+        MESSAGE<<"ERROR at " << c.get_fileline() <<": can not open doping file " << fname << std::endl; RECORD();
+        genius_error();
+      }
 
-    while(!in.eof() && in.good())
+      MESSAGE<<"Loading doping profile from " << fname << ".\n"; RECORD();
+
+      const char * pos = in.begin();
+      const char * end = in.end();
+
+      int i;
+      for (i=0; i<skip_line && pos<end; i++)
+        pos = NumberScan::next_line(pos, end);
+
+      while( (pos = NumberScan::skip_space(pos, end)) < end )
+      {
+        double v[4];
+        for(unsigned int k=0; k<n_col && pos; ++k)
+          pos = NumberScan::read_real(NumberScan::skip_space(pos, end), end, v[k]);
+
+        if( pos == NULL )
+        {
+          MESSAGE<<"ERROR at " << c.get_fileline() <<": error reading doping file " << fname;
+          MESSAGE<<" at line " << i << "." << std::endl; RECORD();
+          genius_error();
+        }
+
+        records.insert(records.end(), v, v+n_col);
+        i++;
+      }
+
+      if( use_cache && !save_doping_cache(cache_file, key, n_col, records) )
+      {
+        MESSAGE<<"Warning: can not write doping cache " << cache_file << ".\n"; RECORD();
+      }
+    }
+
+    for(size_t r=0; r<records.size(); r+=n_col)
     {
+      const double * v = &records[r];
       switch(axes)
       {
       case AXES_X:
-        in >> p[0]; break; // read the only coordinate
+        p[0] = v[0]; break; // the only coordinate
       case AXES_Y:
-        in >> p[1]; break;
+        p[1] = v[0]; break;
       case AXES_Z:
-        in >> p[2]; break;
+        p[2] = v[0]; break;
       case AXES_XY:
-        in >> p[0] >> p[1]; break; // read two coordinates
+        p[0] = v[0]; p[1] = v[1]; break; // two coordinates
       case AXES_XZ:
-        in >> p[0] >> p[2]; break; // read two coordinates
-        break;
+        p[0] = v[0]; p[2] = v[1]; break;
       case AXES_YZ:
-        in >> p[1] >> p[2]; break; // read two coordinates
+        p[1] = v[0]; p[2] = v[1]; break;
       case AXES_XYZ:
-        in >> p[0] >> p[1] >> p[2]; break; // read three coordinates
+        p[0] = v[0]; p[1] = v[1]; p[2] = v[2]; break; // three coordinates
       }
 
       p *= PhysicalUnit::m*LUnit;     // scale to length unit
@@ -275,25 +553,41 @@ void DopingAnalytic::set_doping_function_file(const Parser::Card & c)
         p1[0] = p[0]; p1[1] = p[1]; p1[2] = p[2]; break;
       }
 
-      in >> doping;
-      doping *= ion;
+      doping = v[n_coord]*ion;
+      interpolator->add_scatter_data(p1, 0, doping);
+    }
+  }
+
+  interpolator->broadcast(0);
 
-      if(!in.fail())
+  // tiled mode, the 2D profile is only fitted near the semiconductor elements
+  if( c.get_bool("tiled", false) && (axes == AXES_XY || axes == AXES_XZ || axes == AXES_YZ) )
+  {
+    std::vector<std::pair<Point, Point> > boxes;
+    const MeshBase & mesh = _system.mesh();
+    MeshBase::const_element_iterator       el  = mesh.active_elements_begin();
+    const MeshBase::const_element_iterator end = mesh.active_elements_end();
+    for ( ; el != end; ++el)
+    {
+      const Elem * elem = *el;
+      if( _system.region(elem->subdomain_id())->type() != SemiconductorRegion ) continue;
+
+      Point pmin = _doping_data_point(axes, elem->get_node(0));
+      Point pmax = pmin;
+      for(unsigned int n=1; n<elem->n_nodes(); ++n)
       {
-        interpolator->add_scatter_data(p1, 0, doping);
+        const Point p = _doping_data_point(axes, elem->get_node(n));
+        for(unsigned int d=0; d<2; ++d)
+        {
+          pmin(d) = std::min(pmin(d), p(d));
+          pmax(d) = std::max(pmax(d), p(d));
+        }
       }
-      i++;
-    }
-    if(!in.eof())
-    {
-      MESSAGE<<"ERROR at " << c.get_fileline() <<": error reading doping file " << fname;
-      MESSAGE<<" at line " << i << "." << std::endl; RECORD();
-      genius_error();
+      boxes.push_back(std::make_pair(pmin, pmax));
     }
-    in.close();
+    interpolator->set_target_boxes(boxes);
   }
 
-  interpolator->broadcast(0);
   interpolator->setup(0);
   _doping_data.push_back(std::pair<int, InterpolationBase * >(axes, interpolator));
 }
@@ -464,11 +758,8 @@ void DopingAnalytic::set_doping_function_analytic(const Parser::Card & c)
 
 }
 
-double DopingAnalytic::_do_doping_interp(int i, const Node *node, const std::string &msg)
+Point DopingAnalytic::_doping_data_point(int axes, const Node *node) const
 {
-  int axes = _doping_data[i].first;
-  InterpolationBase * interp = _doping_data[i].second;
-
   Point p;
   switch(axes)
   {
@@ -499,59 +790,5 @@ double DopingAnalytic::_do_doping_interp(int i, const Node *node, const std::str
       p[2]=(*node)(2);
       break;
   }
-  double d = interp->get_interpolated_value(p, 0);
-#if defined(HAVE_FENV_H) && defined(DEBUG)
-  if(fetestexcept(FE_INVALID|FE_DIVBYZERO|FE_OVERFLOW))
-  {
-    MESSAGE<< "Warning: problem in interpolating " << msg << " at ";
-    MESSAGE<< (*node)(0)/um << "\t";
-    MESSAGE<< (*node)(1)/um << "\t";
-    MESSAGE<< (*node)(2)/um << " " << d << " , ignored.\n";
-    RECORD();
-    feclearexcept(FE_ALL_EXCEPT);
-  }
-#endif
-  return d;
-}
-
-double DopingAnalytic::doping_Na(const Node * node)
-{
-  double dop = 0.0;
-
-  //only add negative value
-  for(size_t i=0; i<_doping_funs.size(); i++)
-  {
-    double d = _doping_funs[i]->profile((*node)(0),(*node)(1),(*node)(2));
-    dop += d < 0.0 ? d: 0.0;
-  }
-  double unit = 1.0/std::pow(PhysicalUnit::cm,3.0);
-  for(size_t i=0; i<_doping_data.size(); i++)
-  {
-    double d = unit * _do_doping_interp(i, node, "Na");
-    dop += d < 0.0 ? d: 0.0;
-  }
-
-  return std::abs(dop);
-}
-
-
-
-double DopingAnalytic::doping_Nd(const Node * node)
-{
-  double dop = 0.0;
-
-  //only add positive value
-  for(size_t i=0; i<_doping_funs.size(); i++)
-  {
-    double d = _doping_funs[i]->profile((*node)(0),(*node)(1),(*node)(2));
-    dop += d > 0.0 ? d: 0.0;
-  }
-  double unit = 1.0/std::pow(PhysicalUnit::cm,3.0);
-  for(size_t i=0; i<_doping_data.size(); i++)
-  {
-    double d = unit * _do_doping_interp(i, node, "Nd");
-    dop += d > 0.0 ? d: 0.0;
-  }
-
-  return std::abs(dop);
+  return p;
 }
@@ -703,20 +703,19 @@ PetscScalar EBM3Solver::LTE_norm()
 void EBM3Solver::error_norm()
 {
   PetscScalar    *xx;
-  PetscScalar    *ff;
+  const PetscScalar *ff;
 
   // scatte global solution vector x to local vector lx
   // this is not necessary since it had already done in function evaluation
   //VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
   //VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
 
-  // scatte global function vector f to local vector lf
-  VecScatterBegin(scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
+  // only the on processor dofs are involved, read them from the global function vector f
+  // directly (indexed by global offset) instead of scattering f to local vector lf
 
 
   VecGetArray(lx, &xx);  // solution value
-  VecGetArray(lf, &ff);  // function value
+  VecGetArrayRead(f, &ff);   // function value
 
   // do clear
   potential_norm        = 0;
@@ -756,31 +755,32 @@ void EBM3Solver::error_norm()
           {
             const FVM_Node * fvm_node = *it;
             unsigned int offset = fvm_node->local_offset();
+            unsigned int f_offset = fvm_node->global_offset() - global_offset;
 
             potential_norm   += xx[offset+node_psi_offset]*xx[offset+node_psi_offset];
             electron_norm    += xx[offset+node_n_offset]*xx[offset+node_n_offset];
             hole_norm        += xx[offset+node_p_offset]*xx[offset+node_p_offset];
 
-            poisson_norm        += ff[offset+node_psi_offset]*ff[offset+node_psi_offset];
-            elec_continuity_norm += ff[offset+node_n_offset]*ff[offset+node_n_offset];
-            hole_continuity_norm += ff[offset+node_p_offset]*ff[offset+node_p_offset];
+            poisson_norm        += ff[f_offset+node_psi_offset]*ff[f_offset+node_psi_offset];
+            elec_continuity_norm += ff[f_offset+node_n_offset]*ff[f_offset+node_n_offset];
+            hole_continuity_norm += ff[f_offset+node_p_offset]*ff[f_offset+node_p_offset];
 
             if(region->get_advanced_model()->enable_Tl())
             {
               temperature_norm    += xx[offset+node_Tl_offset]*xx[offset+node_Tl_offset];
-              heat_equation_norm  += ff[offset+node_Tl_offset]*ff[offset+node_Tl_offset];
+              heat_equation_norm  += ff[f_offset+node_Tl_offset]*ff[f_offset+node_Tl_offset];
             }
 
             if(region->get_advanced_model()->enable_Tn())
             {
               elec_temperature_norm      += xx[offset+node_Tn_offset]/xx[offset+node_n_offset]*xx[offset+node_Tn_offset]/xx[offset+node_n_offset];
-              elec_energy_equation_norm  += ff[offset+node_Tn_offset]*ff[offset+node_Tn_offset];
+              elec_energy_equation_norm  += ff[f_offset+node_Tn_offset]*ff[f_offset+node_Tn_offset];
             }
 
             if(region->get_advanced_model()->enable_Tp())
             {
               hole_temperature_norm      += xx[offset+node_Tp_offset]/xx[offset+node_p_offset]*xx[offset+node_Tp_offset]/xx[offset+node_p_offset];
-              hole_energy_equation_norm  += ff[offset+node_Tp_offset]*ff[offset+node_Tp_offset];
+              hole_energy_equation_norm  += ff[f_offset+node_Tp_offset]*ff[f_offset+node_Tp_offset];
             }
           }
           break;
@@ -798,14 +798,15 @@ void EBM3Solver::error_norm()
           {
             const FVM_Node * fvm_node = *it;
             unsigned int offset = fvm_node->local_offset();
+            unsigned int f_offset = fvm_node->global_offset() - global_offset;
 
             potential_norm   += xx[offset+node_psi_offset]*xx[offset+node_psi_offset];
-            poisson_norm     += ff[offset+node_psi_offset]*ff[offset+node_psi_offset];
+            poisson_norm     += ff[f_offset+node_psi_offset]*ff[f_offset+node_psi_offset];
 
             if(region->get_advanced_model()->enable_Tl())
             {
               temperature_norm    += xx[offset+node_Tl_offset]*xx[offset+node_Tl_offset];
-              heat_equation_norm  += ff[offset+node_Tl_offset]*ff[offset+node_Tl_offset];
+              heat_equation_norm  += ff[f_offset+node_Tl_offset]*ff[f_offset+node_Tl_offset];
             }
           }
           break;
@@ -822,10 +823,11 @@ void EBM3Solver::error_norm()
     {
       const BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
       unsigned int offset = bc->local_offset();
+      unsigned int f_offset = bc->global_offset() - global_offset;
       if( offset != invalid_uint )
       {
         potential_norm += xx[offset]*xx[offset];
-        electrode_norm += ff[offset]*ff[offset];
+        electrode_norm += ff[f_offset]*ff[f_offset];
       }
     }
 
@@ -867,7 +869,7 @@ void EBM3Solver::error_norm()
   electrode_norm            = sqrt(norm_buffer[12]);
 
   VecRestoreArray(lx, &xx);
-  VecRestoreArray(lf, &ff);
+  VecRestoreArrayRead(f, &ff);
 
 }
 
@@ -912,7 +914,11 @@ void EBM3Solver::build_petsc_sens_residual(Vec x, Vec r)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    START_LOG("Region_Function()", "EBM3Solver");
+    START_DYNAMIC_LOG(region->kernel_label(), "EBM3 Region_Function");
     region->EBM3_Function(lxx, r, add_value_flag);
+    STOP_DYNAMIC_LOG(region->kernel_label(), "EBM3 Region_Function");
+    STOP_LOG("Region_Function()", "EBM3Solver");
   }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
@@ -952,8 +958,8 @@ void EBM3Solver::build_petsc_sens_residual(Vec x, Vec r)
     bc->EBM3_Function_Preprocess(r, src_row, dst_row, clear_row);
   }
   //add source rows to destination rows, and clear rows
-  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row);
-  add_value_flag = NOT_SET_VALUES;
+  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
 
   // evaluate governing equations of DDML1 for all the boundaries
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
@@ -962,6 +968,9 @@ void EBM3Solver::build_petsc_sens_residual(Vec x, Vec r)
     bc->EBM3_Function(lxx, r, add_value_flag);
   }
 
+  // the external circuit of all the electrodes
+  _system.get_bcs()->electrode_circuit_function(lxx, r, add_value_flag);
+
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
@@ -973,20 +982,9 @@ void EBM3Solver::build_petsc_sens_residual(Vec x, Vec r)
   VecAssemblyBegin(r);
   VecAssemblyEnd(r);
 
-  // scale the function vec
-  PetscScalar *ff,*scale;
-  // get function array and scale array.
-  VecGetArray(r, &ff);
-  // L is the scaling vector, the Jacobian evaluate function may dynamically update it.
-  VecGetArray(L, &scale);
-
-  // scale it!
-  for(unsigned int n=0; n<n_local_dofs; n++)
-    ff[n] *= scale[n];
-
-  // restore back
-  VecRestoreArray(r, &ff);
-  VecRestoreArray(L, &scale);
+  // scale the function vec, L is the scaling vector, the Jacobian evaluate function may dynamically update it.
+  // a vector operation does not pull device vector types back to host memory
+  VecPointwiseMult(r, r, L);
 
   STOP_LOG("EBM3Solver_Residual()", "EBM3Solver");
 
@@ -1019,7 +1017,11 @@ void EBM3Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   for(unsigned int n=0; n<_system.n_regions(); n++)
   {
     SimulationRegion * region = _system.region(n);
+    START_LOG("Region_Jacobian()", "EBM3Solver");
+    START_DYNAMIC_LOG(region->kernel_label(), "EBM3 Region_Jacobian");
     region->EBM3_Jacobian(lxx, &J, add_value_flag);
+    STOP_DYNAMIC_LOG(region->kernel_label(), "EBM3 Region_Jacobian");
+    STOP_LOG("Region_Jacobian()", "EBM3Solver");
   }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
@@ -1074,11 +1076,9 @@ void EBM3Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
     bc->EBM3_Jacobian_Preprocess(&J, src_row, dst_row, clear_row);
   }
 
-  //add source rows to destination rows
-  PetscUtils::MatAddRowToRow(J, src_row, dst_row);
-  // clear row
-  PetscUtils::MatZeroRows(J, clear_row.size(), clear_row.empty() ? NULL : &clear_row[0], 0.0);
-  add_value_flag = NOT_SET_VALUES;
+  //add source rows to destination rows, and clear rows
+  PetscUtils::MatAddClearRow(J, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
   // evaluate Jacobian matrix of governing equations of EBM for all the boundaries
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
   {
@@ -1086,6 +1086,9 @@ void EBM3Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
     bc->EBM3_Jacobian(lxx, &J, add_value_flag);
   }
 
+  // the external circuit of all the electrodes
+  _system.get_bcs()->electrode_circuit_jacobian(&J, add_value_flag);
+
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
@@ -22,6 +22,7 @@
 
 #include "elem.h"
 #include "simulation_system.h"
+#include "fvm_edge_assembly.h"
 #include "insulator_region.h"
 #include "solver_specify.h"
 
@@ -148,86 +149,10 @@ void InsulatorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, InsertMode
 
 
   // search all the edges of this region, do integral over control volume...
-  const_edge_iterator it = edges_begin();
-  const_edge_iterator it_end = edges_end();
-  for(; it!=it_end; ++it)
-  {
-    // fvm_node of node1
-    const FVM_Node * fvm_n1 = (*it).first;
-    // fvm_node of node2
-    const FVM_Node * fvm_n2 = (*it).second;
-
-    // fvm_node_data of node1
-    const FVM_NodeData * n1_data =  fvm_n1->node_data();
-    // fvm_node_data of node2
-    const FVM_NodeData * n2_data =  fvm_n2->node_data();
-
-    const unsigned int n1_global_offset = fvm_n1->global_offset();
-    const unsigned int n2_global_offset = fvm_n2->global_offset();
-    const unsigned int n1_local_offset = fvm_n1->local_offset();
-    const unsigned int n2_local_offset = fvm_n2->local_offset();
-
-    {
-      //for node 1 of the edge
-      mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-      PetscScalar V1   =  x[n1_local_offset+node_psi_offset];             // electrostatic potential
-      PetscScalar rho1 =  0;                                // charge density
-      PetscScalar eps1 =  n1_data->eps();                   // permittivity
-
-
-      //for node 2 of the edge
-      mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
-      PetscScalar V2   =  x[n2_local_offset+node_psi_offset];
-      PetscScalar rho2 =  0;
-      PetscScalar eps2 =  n2_data->eps();
-
-      PetscScalar eps = 0.5*(eps1+eps2);       // eps at mid point of the edge
-
-      // "flux" from node 2 to node 1
-      PetscScalar f_psi =  eps*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
-
-      // ignore thoese ghost nodes
-      if( fvm_n1->on_processor() )
-      {
-        iy.push_back(n1_global_offset+node_psi_offset);
-        y.push_back(f_psi);
-      }
-
-      if( fvm_n2->on_processor() )
-      {
-        iy.push_back(n2_global_offset+node_psi_offset);
-        y.push_back(-f_psi);
-      }
-
-      /*
-      * process heating equation if required
-      */
-      if(get_advanced_model()->enable_Tl())
-      {
-        mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-        PetscScalar T1   =  x[n1_local_offset+node_Tl_offset];             // lattice temperature
-        PetscScalar kap1 =  mt->thermal->HeatConduction(T1);
-
-        mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
-        PetscScalar T2   =  x[n2_local_offset+node_Tl_offset];
-        PetscScalar kap2 =  mt->thermal->HeatConduction(T2);
-        PetscScalar kap = 0.5*(kap1+kap2);       // kapa at mid point of the edge
-        PetscScalar f_q =  kap*fvm_n1->cv_surface_area(fvm_n2->root_node())*(T2 - T1)/fvm_n1->distance(fvm_n2) ;
-        // ignore thoese ghost nodes
-        if( fvm_n1->on_processor() )
-        {
-          iy.push_back(n1_global_offset+node_Tl_offset);
-          y.push_back(f_q);
-        }
-
-        if( fvm_n2->on_processor() )
-        {
-          iy.push_back(n2_global_offset+node_Tl_offset);
-          y.push_back(-f_q);
-        }
-      }
-    }
-  }
+  if(get_advanced_model()->enable_Tl())
+    FVM_EdgeAssembly::function(*this, FVM_EdgeAssembly::PoissonHeatFlux<Material::MaterialInsulator>(*this, mt, node_psi_offset, node_Tl_offset), x, iy, y);
+  else
+    FVM_EdgeAssembly::function(*this, FVM_EdgeAssembly::PoissonFlux(*this, node_psi_offset), x, iy, y);
 
   if(iy.size()) VecSetValues(f, iy.size(), &iy[0], &y[0], ADD_VALUES);
 
@@ -254,11 +179,6 @@ void InsulatorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, InsertM
   unsigned int node_psi_offset = ebm_variable_offset(POTENTIAL);
   unsigned int node_Tl_offset  = ebm_variable_offset(TEMPERATURE);
 
-  //the indepedent variable number, since we only process edges, 2 (2 nodes x 2 variables_per_node) is enough
-  adtl::AutoDScalar::numdir=2;
-
-  //synchronize with material database
-  mt->set_ad_num(adtl::AutoDScalar::numdir);
 
   // note, we will use ADD_VALUES to set values of matrix J
   // if the previous operator is not ADD_VALUES, we should flush the matrix
@@ -270,88 +190,10 @@ void InsulatorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, InsertM
 
 
   // search all the edges of this region, do integral over control volume...
-  const_edge_iterator it = edges_begin();
-  const_edge_iterator it_end = edges_end();
-  for(; it!=it_end; ++it)
-  {
-    // fvm_node of node1
-    const FVM_Node * fvm_n1 = (*it).first;
-    // fvm_node of node2
-    const FVM_Node * fvm_n2 = (*it).second;
-
-    // fvm_node_data of node1
-    const FVM_NodeData * n1_data =  fvm_n1->node_data();
-    // fvm_node_data of node2
-    const FVM_NodeData * n2_data =  fvm_n2->node_data();
-
-    const unsigned int n1_global_offset = fvm_n1->global_offset();
-    const unsigned int n2_global_offset = fvm_n2->global_offset();
-    const unsigned int n1_local_offset = fvm_n1->local_offset();
-    const unsigned int n2_local_offset = fvm_n2->local_offset();
-
-    {
-      //for node 1 of the edge
-      mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-      AutoDScalar V1   =  x[n1_local_offset+node_psi_offset];  V1.setADValue(0,1.0);           // electrostatic potential
-      PetscScalar rho1 =  0;                                // charge density
-      PetscScalar eps1 =  n1_data->eps();                   // permittivity
-
-
-      //for node 2 of the edge
-      mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
-      AutoDScalar V2   =  x[n2_local_offset+node_psi_offset];  V2.setADValue(1,1.0);
-      PetscScalar rho2 =  0;
-      PetscScalar eps2 =  n2_data->eps();
-
-
-      PetscScalar eps = 0.5*(eps1+eps2);       // eps at mid point of the edge
-      // "flux" from node 2 to node 1
-      AutoDScalar f_psi =  eps*fvm_n1->cv_surface_area(fvm_n2->root_node())*(V2 - V1)/fvm_n1->distance(fvm_n2) ;
-
-      // ignore thoese ghost nodes
-      if( fvm_n1->on_processor() )
-      {
-        MatSetValue(*jac, n1_global_offset+node_psi_offset, n1_global_offset+node_psi_offset, f_psi.getADValue(0), ADD_VALUES);
-        MatSetValue(*jac, n1_global_offset+node_psi_offset, n2_global_offset+node_psi_offset, f_psi.getADValue(1), ADD_VALUES);
-      }
-
-      if( fvm_n2->on_processor() )
-      {
-        MatSetValue(*jac, n2_global_offset+node_psi_offset, n1_global_offset+node_psi_offset, -f_psi.getADValue(0), ADD_VALUES);
-        MatSetValue(*jac, n2_global_offset+node_psi_offset, n2_global_offset+node_psi_offset, -f_psi.getADValue(1), ADD_VALUES);
-      }
-
-      /*
-      * process heating equation if required
-      */
-      if(get_advanced_model()->enable_Tl())
-      {
-        mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
-        AutoDScalar T1   =  x[n1_local_offset+node_Tl_offset];  T1.setADValue(0,1.0);           // lattice temperature
-        PetscScalar kap1 =  mt->thermal->HeatConduction(T1.getValue());
-
-        mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
-        AutoDScalar T2   =  x[n2_local_offset+node_Tl_offset];  T2.setADValue(1,1.0);
-        PetscScalar kap2 =  mt->thermal->HeatConduction(T2.getValue());
-
-        PetscScalar kap = 0.5*(kap1+kap2);       // kapa at mid point of the edge
-        AutoDScalar f_q =  kap*fvm_n1->cv_surface_area(fvm_n2->root_node())*(T2 - T1)/fvm_n1->distance(fvm_n2) ;
-
-        // ignore thoese ghost nodes
-        if( fvm_n1->on_processor() )
-        {
-          MatSetValue(*jac, n1_global_offset+node_Tl_offset, n1_global_offset+node_Tl_offset, f_q.getADValue(0), ADD_VALUES);
-          MatSetValue(*jac, n1_global_offset+node_Tl_offset, n2_global_offset+node_Tl_offset, f_q.getADValue(1), ADD_VALUES);
-        }
-
-        if( fvm_n2->on_processor() )
-        {
-          MatSetValue(*jac, n2_global_offset+node_Tl_offset, n1_global_offset+node_Tl_offset, -f_q.getADValue(0), ADD_VALUES);
-          MatSetValue(*jac, n2_global_offset+node_Tl_offset, n2_global_offset+node_Tl_offset, -f_q.getADValue(1), ADD_VALUES);
-        }
-      }
-    }
-  }
+  if(get_advanced_model()->enable_Tl())
+    FVM_EdgeAssembly::jacobian(*this, FVM_EdgeAssembly::PoissonHeatFlux<Material::MaterialInsulator>(*this, mt, node_psi_offset, node_Tl_offset), x, jac);
+  else
+    FVM_EdgeAssembly::poisson_jacobian(*this, jac, node_psi_offset);
 
   // boundary condition should be processed later!
 
@@ -523,22 +365,7 @@ void InsulatorSimulationRegion::EBM3_Update_Solution(PetscScalar *lxx)
   // addtional work: compute electrical field for all the cell.
   // Since this value is only used for reference.
   // It can be done simply by weighted average of cell's electrical field
-  for(unsigned int n=0; n<n_cell(); ++n)
-  {
-    const Elem * elem = this->get_region_elem(n);
-    FVM_CellData * elem_data = this->get_region_elem_data(n);
-
-    std::vector<PetscScalar> psi_vertex;
-
-    for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
-    {
-      const FVM_Node * fvm_node = elem->get_fvm_node(nd);
-      const FVM_NodeData * fvm_node_data = fvm_node->node_data();
-      psi_vertex.push_back  ( fvm_node_data->psi() );
-    }
-    // compute the gradient in the cell
-    elem_data->E()  = - elem->gradient(psi_vertex);  // E = - grad(psi)
-  }
+  this->update_cell_electric_field();
 
 }
 
@@ -939,10 +939,43 @@ void SemiconductorSimulationRegion::EBM3_Function(PetscScalar * x, Vec f, Insert
       iy.push_back(fvm_node->global_offset()+node_Tp_offset);
       y.push_back( Hp*fvm_node->volume() );
     }
+  }
 
-
-    if (get_advanced_model()->Trap)
+  // bulk trap terms, only the nodes which carry traps are visited
+  if (get_advanced_model()->Trap)
+  {
+    const std::vector<FVM_Node *> & nodes_with_trap = trap_nodes();
+    for(unsigned int i=0; i<nodes_with_trap.size(); ++i)
     {
+      const FVM_Node * fvm_node = nodes_with_trap[i];
+      if( !fvm_node->on_processor() ) continue;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+
+      PetscScalar n   =  x[fvm_node->local_offset() + node_n_offset];           // electron density
+      PetscScalar p   =  x[fvm_node->local_offset() + node_p_offset];           // hole density
+
+      PetscScalar T  = T_external();
+      PetscScalar Tn = T_external();
+      PetscScalar Tp = T_external();
+
+      // lattice temperature if required
+      if(get_advanced_model()->enable_Tl())
+        T =  x[fvm_node->local_offset() + node_Tl_offset];
+
+      // electron temperature if required
+      if(get_advanced_model()->enable_Tn())
+        Tn = x[fvm_node->local_offset() + node_Tn_offset]/n;
+
+      // hole temperature if required
+      if(get_advanced_model()->enable_Tp())
+        Tp = x[fvm_node->local_offset() + node_Tp_offset]/p;
+
+      // map this node and its data to material database
+      mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);
+
+      PetscScalar H=0, Hn=0, Hp=0;
+      PetscScalar Eg = mt->band->Eg(T);
+
       // consider charge trapping in semiconductor bulk (bulk_flag=true)
 
       // call the Trap MPI to calculate trap occupancy using the local carrier densities and lattice temperature
@@ -84,6 +84,13 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
     bool truncation =  SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationAlways ||
         (SolverSpecify::VoronoiTruncation == SolverSpecify::VoronoiTruncationBoundary && (elem->on_boundary() || elem->on_interface())) ;
 
+    // when the edge flux only depends on the two nodes of the edge (no E field or current direction of the cell
+    // is used by mobility, band-band tunneling and impact ionization), the AD of each edge only carries the
+    // variables of its two nodes.
+    bool local_edge_ad = !(highfield_mob && (get_advanced_model()->Mob_Force != ModelSpecify::ESimple || insulator_interface_elem || mos_channel_elem)) &&
+                         !(get_advanced_model()->BandBandTunneling && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM) &&
+                         !(get_advanced_model()->ImpactIonization && SolverSpecify::Type!=SolverSpecify::EQUILIBRIUM);
+
     //the indepedent variable number, this->ebm_n_variables()*n_nodes
     adtl::AutoDScalar::numdir = n_node_var*elem->n_nodes();
 
@@ -112,7 +119,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
     AutoDScalar Etn=0;
     AutoDScalar Etp=0;
 
-    if(highfield_mob)
+    if(highfield_mob && !local_edge_ad)
     {
       // which are the vector of electric field and current density.
       // here use type AutoDScalar, we should make sure the order of independent variable keeps the
@@ -160,7 +167,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
       Jpv = - elem->gradient(phip_vertex); // the same as Jnv
     }
 
-    if(highfield_mob)
+    if(highfield_mob && !local_edge_ad)
     {
       // for elem on insulator interface, we will do special treatment to electrical field
       if(get_advanced_model()->ESurface && insulator_interface_elem)
@@ -264,6 +271,13 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
       }
     }
 
+    // only the variables of two nodes as AD directions for each edge
+    if( local_edge_ad )
+    {
+      adtl::AutoDScalar::numdir = 2*n_node_var;
+      mt->set_ad_num(adtl::AutoDScalar::numdir);
+    }
+
     // process conservation terms: laplace operator of poisson's equation and div operator of continuation equation
     // search for all the Edge this cell own
     for(unsigned int ne=0; ne<elem->n_edges(); ++ne )
@@ -304,6 +318,18 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
       for(unsigned int nv=0; nv<n_node_var; ++nv)  row1.push_back( fvm_n1->global_offset()+nv );
       for(unsigned int nv=0; nv<n_node_var; ++nv)  row2.push_back( fvm_n2->global_offset()+nv );
 
+      // the AD index of the two nodes, and the matrix columns of the AD directions
+      const unsigned int nd1 = local_edge_ad ? 0 : edge_nodes.first;
+      const unsigned int nd2 = local_edge_ad ? 1 : edge_nodes.second;
+      std::vector<PetscInt> edge_col;
+      if( local_edge_ad )
+      {
+        edge_col = row1;
+        edge_col.insert(edge_col.end(), row2.begin(), row2.end());
+      }
+      const PetscInt * col = local_edge_ad ? &edge_col[0] : &cell_col[0];
+      const PetscInt n_col = local_edge_ad ? edge_col.size() : cell_col.size();
+
 
       // here we use AD again. Can we hand write it for more efficient?
       {
@@ -312,13 +338,13 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
         mt->mapping(fvm_n1->root_node(), n1_data, SolverSpecify::clock);
 
         AutoDScalar V1 = x[n1_local_offset + node_psi_offset];
-        V1.setADValue(n_node_var*edge_nodes.first + node_psi_offset, 1.0);   // electrostatic potential
+        V1.setADValue(n_node_var*nd1 + node_psi_offset, 1.0);   // electrostatic potential
 
         AutoDScalar n1 = x[n1_local_offset + node_n_offset];
-        n1.setADValue(n_node_var*edge_nodes.first + node_n_offset, 1.0);     // electron density
+        n1.setADValue(n_node_var*nd1 + node_n_offset, 1.0);     // electron density
 
         AutoDScalar p1 = x[n1_local_offset + node_p_offset];
-        p1.setADValue(n_node_var*edge_nodes.first + node_p_offset, 1.0);     // hole density
+        p1.setADValue(n_node_var*nd1 + node_p_offset, 1.0);     // hole density
 
         AutoDScalar T1  =  T_external();
         AutoDScalar Tn1 =  T_external();
@@ -328,14 +354,14 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
         if(get_advanced_model()->enable_Tl())
         {
           T1 =  x[n1_local_offset + node_Tl_offset];
-          T1.setADValue(n_node_var*edge_nodes.first + node_Tl_offset, 1.0);
+          T1.setADValue(n_node_var*nd1 + node_Tl_offset, 1.0);
         }
 
         // electron temperature if required
         if(get_advanced_model()->enable_Tn())
         {
           AutoDScalar n1Tn1 = x[n1_local_offset + node_Tn_offset];
-          n1Tn1.setADValue(n_node_var*edge_nodes.first + node_Tn_offset, 1.0);
+          n1Tn1.setADValue(n_node_var*nd1 + node_Tn_offset, 1.0);
           Tn1 = n1Tn1/n1;
         }
 
@@ -343,7 +369,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
         if(get_advanced_model()->enable_Tp())
         {
           AutoDScalar p1Tp1 = x[n1_local_offset + node_Tp_offset];
-          p1Tp1.setADValue(n_node_var*edge_nodes.first + node_Tp_offset, 1.0);
+          p1Tp1.setADValue(n_node_var*nd1 + node_Tp_offset, 1.0);
           Tp1 = p1Tp1/p1;
         }
 
@@ -363,13 +389,13 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
         mt->mapping(fvm_n2->root_node(), n2_data, SolverSpecify::clock);
 
         AutoDScalar V2   =  x[n2_local_offset + node_psi_offset];
-        V2.setADValue(n_node_var*edge_nodes.second + node_psi_offset, 1.0);   // electrostatic potential
+        V2.setADValue(n_node_var*nd2 + node_psi_offset, 1.0);   // electrostatic potential
 
         AutoDScalar n2   =  x[n2_local_offset + node_n_offset];
-        n2.setADValue(n_node_var*edge_nodes.second + node_n_offset, 1.0);     // electron density
+        n2.setADValue(n_node_var*nd2 + node_n_offset, 1.0);     // electron density
 
         AutoDScalar p2   =  x[n2_local_offset + node_p_offset];
-        p2.setADValue(n_node_var*edge_nodes.second + node_p_offset, 1.0);     // hole density
+        p2.setADValue(n_node_var*nd2 + node_p_offset, 1.0);     // hole density
 
         AutoDScalar T2  =  T_external();
         AutoDScalar Tn2 =  T_external();
@@ -379,14 +405,14 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
         if(get_advanced_model()->enable_Tl())
         {
           T2 =  x[n2_local_offset + node_Tl_offset];
-          T2.setADValue(n_node_var*edge_nodes.second+node_Tl_offset, 1.0);
+          T2.setADValue(n_node_var*nd2+node_Tl_offset, 1.0);
         }
 
         // electron temperature if required
         if(get_advanced_model()->enable_Tn())
         {
           AutoDScalar n2Tn2 = x[n2_local_offset + node_Tn_offset];
-          n2Tn2.setADValue(n_node_var*edge_nodes.second+node_Tn_offset, 1.0);
+          n2Tn2.setADValue(n_node_var*nd2+node_Tn_offset, 1.0);
           Tn2 = n2Tn2/n2;
         }
 
@@ -394,7 +420,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
         if(get_advanced_model()->enable_Tp())
         {
           AutoDScalar p2Tp2 = x[n2_local_offset + node_Tp_offset];
-          p2Tp2.setADValue(n_node_var*edge_nodes.second+node_Tp_offset, 1.0);
+          p2Tp2.setADValue(n_node_var*nd2+node_Tp_offset, 1.0);
           Tp2 = p2Tp2/p2;
         }
 
@@ -519,19 +545,19 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
         {
 
           AutoDScalar poisson = ( eps*(V2 - V1)/length*partial_area );
-          MatSetValues(*jac, 1, &row1[node_psi_offset], cell_col.size(), &cell_col[0], poisson.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row1[node_psi_offset], n_col, col, poisson.getADValue(), ADD_VALUES);
 
           AutoDScalar electron_continuation = ( Jn*truncated_partial_area );
-          MatSetValues(*jac, 1, &row1[node_n_offset], cell_col.size(), &cell_col[0], electron_continuation.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row1[node_n_offset], n_col, col, electron_continuation.getADValue(), ADD_VALUES);
 
           AutoDScalar hole_continuation = ( - Jp*truncated_partial_area );
-          MatSetValues(*jac, 1, &row1[node_p_offset], cell_col.size(), &cell_col[0], hole_continuation.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row1[node_p_offset], n_col, col, hole_continuation.getADValue(), ADD_VALUES);
 
           // heat transport equation if required
           if(get_advanced_model()->enable_Tl())
           {
             AutoDScalar heating_equ = ( kap*(T2 - T1)/length*partial_area + H*truncated_partial_area);
-            MatSetValues(*jac, 1, &row1[node_Tl_offset], cell_col.size(), &cell_col[0], heating_equ.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row1[node_Tl_offset], n_col, col, heating_equ.getADValue(), ADD_VALUES);
           }
 
 
@@ -539,7 +565,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
           if(get_advanced_model()->enable_Tn())
           {
             AutoDScalar electron_energy = -Sn*truncated_partial_area + Hn*truncated_partial_area;
-            MatSetValues(*jac, 1, &row1[node_Tn_offset], cell_col.size(), &cell_col[0], electron_energy.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row1[node_Tn_offset], n_col, col, electron_energy.getADValue(), ADD_VALUES);
           }
 
 
@@ -547,7 +573,7 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
           if(get_advanced_model()->enable_Tp())
           {
             AutoDScalar hole_energy = -Sp*truncated_partial_area + Hp*truncated_partial_area;
-            MatSetValues(*jac, 1, &row1[node_Tp_offset], cell_col.size(), &cell_col[0], hole_energy.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row1[node_Tp_offset], n_col, col, hole_energy.getADValue(), ADD_VALUES);
           }
 
         }
@@ -556,33 +582,33 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
         {
 
           AutoDScalar poisson = ( eps*(V1 - V2)/length*partial_area );
-          MatSetValues(*jac, 1, &row2[node_psi_offset], cell_col.size(), &cell_col[0], poisson.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row2[node_psi_offset], n_col, col, poisson.getADValue(), ADD_VALUES);
 
           AutoDScalar electron_continuation = ( - Jn*truncated_partial_area );
-          MatSetValues(*jac, 1, &row2[node_n_offset], cell_col.size(), &cell_col[0], electron_continuation.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row2[node_n_offset], n_col, col, electron_continuation.getADValue(), ADD_VALUES);
 
           AutoDScalar hole_continuation = ( Jp*truncated_partial_area );
-          MatSetValues(*jac, 1, &row2[node_p_offset], cell_col.size(), &cell_col[0], hole_continuation.getADValue(), ADD_VALUES);
+          MatSetValues(*jac, 1, &row2[node_p_offset], n_col, col, hole_continuation.getADValue(), ADD_VALUES);
 
           // heat transport equation if required
           if(get_advanced_model()->enable_Tl())
           {
             AutoDScalar heating_equ = ( kap*(T1 - T2)/length*partial_area + H*truncated_partial_area);
-            MatSetValues(*jac, 1, &row2[node_Tl_offset], cell_col.size(), &cell_col[0], heating_equ.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row2[node_Tl_offset], n_col, col, heating_equ.getADValue(), ADD_VALUES);
           }
 
           // energy balance equation for electron if required
           if(get_advanced_model()->enable_Tn())
           {
             AutoDScalar electron_energy = Sn*truncated_partial_area + Hn*truncated_partial_area;
-            MatSetValues(*jac, 1, &row2[node_Tn_offset], cell_col.size(), &cell_col[0], electron_energy.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row2[node_Tn_offset], n_col, col, electron_energy.getADValue(), ADD_VALUES);
           }
 
           // energy balance equation for hole if required
           if(get_advanced_model()->enable_Tp())
           {
             AutoDScalar hole_energy = Sp*truncated_partial_area + Hp*truncated_partial_area;
-            MatSetValues(*jac, 1, &row2[node_Tp_offset], cell_col.size(), &cell_col[0], hole_energy.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row2[node_Tp_offset], n_col, col, hole_energy.getADValue(), ADD_VALUES);
           }
 
         }
@@ -597,16 +623,16 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT1*truncated_partial_volume;
-            MatSetValues(*jac, 1, &row1[node_n_offset], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row1[node_p_offset], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row1[node_n_offset], n_col, col, continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row1[node_p_offset], n_col, col, continuity.getADValue(), ADD_VALUES);
           }
 
           if( fvm_n2->root_node()->processor_id()==Genius::processor_id() )
           {
             // continuity equation
             AutoDScalar continuity = 0.5*GBTBT2*truncated_partial_volume;
-            MatSetValues(*jac, 1, &row2[node_n_offset], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row2[node_p_offset], cell_col.size(), &cell_col[0], continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row2[node_n_offset], n_col, col, continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row2[node_p_offset], n_col, col, continuity.getADValue(), ADD_VALUES);
           }
         }
 
@@ -670,20 +696,20 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
             // continuity equation
             AutoDScalar electron_continuity = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin1*GIIn+riip1*GIIp)*truncated_partial_volume ;
-            MatSetValues(*jac, 1, &row1[node_n_offset], cell_col.size(), &cell_col[0], electron_continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row1[node_p_offset], cell_col.size(), &cell_col[0], hole_continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row1[node_n_offset], n_col, col, electron_continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row1[node_p_offset], n_col, col, hole_continuity.getADValue(), ADD_VALUES);
 
             if (get_advanced_model()->enable_Tn())
             {
               Hn = - (Eg+1.5*kb*Tp) * riin1*GIIn + 1.5*kb*Tn * riip1*GIIp;
               AutoDScalar electron_energy = Hn*truncated_partial_volume;
-              MatSetValues(*jac, 1, &row1[node_Tn_offset], cell_col.size(), &cell_col[0], electron_energy.getADValue(), ADD_VALUES);
+              MatSetValues(*jac, 1, &row1[node_Tn_offset], n_col, col, electron_energy.getADValue(), ADD_VALUES);
             }
             if (get_advanced_model()->enable_Tp())
             {
               Hp = - (Eg+1.5*kb*Tn) * riip1*GIIp + 1.5*kb*Tp * riin1*GIIn;
               AutoDScalar hole_energy = Hp*truncated_partial_volume;
-              MatSetValues(*jac, 1, &row1[node_Tp_offset], cell_col.size(), &cell_col[0], hole_energy.getADValue(), ADD_VALUES);
+              MatSetValues(*jac, 1, &row1[node_Tp_offset], n_col, col, hole_energy.getADValue(), ADD_VALUES);
             }
           }
 
@@ -692,20 +718,20 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
             // continuity equation of electron
             AutoDScalar electron_continuity = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
             AutoDScalar hole_continuity     = (riin2*GIIn+riip2*GIIp)*truncated_partial_volume ;
-            MatSetValues(*jac, 1, &row2[node_n_offset], cell_col.size(), &cell_col[0], electron_continuity.getADValue(), ADD_VALUES);
-            MatSetValues(*jac, 1, &row2[node_p_offset], cell_col.size(), &cell_col[0], hole_continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row2[node_n_offset], n_col, col, electron_continuity.getADValue(), ADD_VALUES);
+            MatSetValues(*jac, 1, &row2[node_p_offset], n_col, col, hole_continuity.getADValue(), ADD_VALUES);
 
             if (get_advanced_model()->enable_Tn())
             {
               Hn = - (Eg+1.5*kb*Tp) * riin2*GIIn + 1.5*kb*Tn * riip2*GIIp;
               AutoDScalar electron_energy = Hn*truncated_partial_volume;
-              MatSetValues(*jac, 1, &row2[node_Tn_offset], cell_col.size(), &cell_col[0], electron_energy.getADValue(), ADD_VALUES);
+              MatSetValues(*jac, 1, &row2[node_Tn_offset], n_col, col, electron_energy.getADValue(), ADD_VALUES);
             }
             if (get_advanced_model()->enable_Tp())
             {
               Hp = - (Eg+1.5*kb*Tn) * riip2*GIIp + 1.5*kb*Tp * riin2*GIIn;
               AutoDScalar hole_energy = Hp*truncated_partial_volume;
-              MatSetValues(*jac, 1, &row2[node_Tp_offset], cell_col.size(), &cell_col[0], hole_energy.getADValue(), ADD_VALUES);
+              MatSetValues(*jac, 1, &row2[node_Tp_offset], n_col, col, hole_energy.getADValue(), ADD_VALUES);
             }
           }
         } // end of II
@@ -835,8 +861,60 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
       MatSetValues(*jac, 1, &index[node_Tp_offset], n_node_var, &index[0], (Hp*fvm_node->volume()).getADValue(),   ADD_VALUES);
     }
 
-    if (get_advanced_model()->Trap)
+  }
+
+  // bulk trap terms, only the nodes which carry traps are visited
+  if (get_advanced_model()->Trap)
+  {
+    const std::vector<FVM_Node *> & nodes_with_trap = trap_nodes();
+    for(unsigned int i=0; i<nodes_with_trap.size(); ++i)
     {
+      const FVM_Node * fvm_node = nodes_with_trap[i];
+      if( !fvm_node->on_processor() ) continue;
+      const FVM_NodeData * node_data = fvm_node->node_data();
+
+      std::vector<PetscInt> index;
+      for(unsigned int nv=0; nv<n_node_var; ++nv)  index.push_back( fvm_node->global_offset()+nv );
+
+      AutoDScalar n = x[fvm_node->local_offset() + node_n_offset];
+      n.setADValue(node_n_offset, 1.0);     // electron density
+
+      AutoDScalar p = x[fvm_node->local_offset() + node_p_offset];
+      p.setADValue(node_p_offset, 1.0);     // hole density
+
+      AutoDScalar T  =  T_external();
+      AutoDScalar Tn =  T_external();
+      AutoDScalar Tp =  T_external();
+
+      // lattice temperature if required
+      if(get_advanced_model()->enable_Tl())
+      {
+        T =  x[fvm_node->local_offset() + node_Tl_offset];
+        T.setADValue(node_Tl_offset, 1.0);
+      }
+
+      // electron temperature if required
+      if(get_advanced_model()->enable_Tn())
+      {
+        AutoDScalar nTn = x[fvm_node->local_offset() + node_Tn_offset];
+        nTn.setADValue(node_Tn_offset, 1.0);
+        Tn = nTn/n;
+      }
+
+      // hole temperature if required
+      if(get_advanced_model()->enable_Tp())
+      {
+        AutoDScalar pTp = x[fvm_node->local_offset() + node_Tp_offset];
+        pTp.setADValue(node_Tp_offset, 1.0);
+        Tp = pTp/p;
+      }
+
+      // map this node and its data to material database
+      mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);
+
+      AutoDScalar H=0, Hn=0, Hp=0;
+      AutoDScalar Eg = mt->band->Eg(T);
+
       // consider charge trapping in semiconductor bulk (bulk_flag=true)
 
       // call the Trap MPI to calculate trap occupancy using the local carrier densities and lattice temperature
@@ -877,7 +955,6 @@ void SemiconductorSimulationRegion::EBM3_Jacobian(PetscScalar * x, Mat *jac, Ins
         MatSetValues(*jac, 1, &index[node_Tl_offset], n_node_var, &index[0], (H*fvm_node->volume()).getADValue(),   ADD_VALUES);
       }
     }
-
   }
 
 
@@ -1284,34 +1361,26 @@ void SemiconductorSimulationRegion::EBM3_Update_Solution(PetscScalar *lxx)
     }
 
     // Update traps
-    if (get_advanced_model()->Trap)
+  }
+
+  // update traps, only the nodes which carry traps are visited
+  if (get_advanced_model()->Trap)
+  {
+    const std::vector<FVM_Node *> & nodes_with_trap = trap_nodes();
+    for(unsigned int i=0; i<nodes_with_trap.size(); ++i)
     {
-      // update traps
+      FVM_Node * fvm_node = nodes_with_trap[i];
+      FVM_NodeData * node_data = fvm_node->node_data();
       mt->mapping(fvm_node->root_node(), node_data, SolverSpecify::clock);
-      mt->trap->Update(true, p, n, node_data->ni(), T_external());
-      mt->trap->Update(false, p, n, node_data->ni(), T_external());
+      mt->trap->Update(true, node_data->p(), node_data->n(), node_data->ni(), T_external());
+      mt->trap->Update(false, node_data->p(), node_data->n(), node_data->ni(), T_external());
     }
   }
 
   // addtional work: compute electrical field for all the cell.
   // Since this value is only used for reference.
   // It can be done simply by weighted average of cell's electrical field
-  for(unsigned int n=0; n<n_cell(); ++n)
-  {
-    const Elem * elem = this->get_region_elem(n);
-    FVM_CellData * elem_data = this->get_region_elem_data(n);
-
-    std::vector<PetscScalar> psi_vertex;
-
-    for(unsigned int nd=0; nd<elem->n_nodes(); ++nd)
-    {
-      const FVM_Node * fvm_node = elem->get_fvm_node(nd);
-      const FVM_NodeData * fvm_node_data = fvm_node->node_data();
-      psi_vertex.push_back  ( fvm_node_data->psi() );
-    }
-    // compute the gradient in the cell
-    elem_data->E()  = - elem->gradient(psi_vertex);  // E = - grad(psi)
-  }
+  this->update_cell_electric_field();
 
 
 }
@@ -96,7 +96,24 @@ int EMFEM2DSolver::solve()
 {
   START_LOG("EM FEM 2D Linear Solver", "solve");
 
+  // batched wave length mode: reuse the factorization of the first wave length of each batch
+  // as preconditioner of GMRES for the other wave lengths
+  if(_batch > 1)
+  {
+    // direct solver applies the factorization only once, use it as preconditioner of GMRES instead
+    if ( linear_solver_type() >= SolverSpecify::LU && linear_solver_type() <= SolverSpecify::GSS )
+    {
+      KSPSetType ( ksp, (char*) KSPGMRES );
+      KSPGMRESSetRestart ( ksp, 100 );
+    }
+    // the solution of last wave length is a good initial guess
+    KSPSetInitialGuessNonzero ( ksp, PETSC_TRUE );
+  }
+
+  // TE and TM problems have different matrix, sweep all the wave lengths of one mode
+  // before the other, so neighbor wave lengths can share the factorization.
   // for each wave length, solve 2d fem probelm
+  _batch_count = 0;
   for(unsigned int n=0; n<_optical_sources.size(); ++n)
   {
     if(_optical_sources[n].TE_weight>0)
@@ -112,7 +129,11 @@ int EMFEM2DSolver::solve()
                        _optical_sources[n].eta,
                        _optical_sources[n].eta_auto);
     }
+  }
 
+  _batch_count = 0;
+  for(unsigned int n=0; n<_optical_sources.size(); ++n)
+  {
     if(_optical_sources[n].TM_weight>0)
     {
       solve_TM_scatter_problem(_optical_sources[n].wave_length,
@@ -126,7 +147,6 @@ int EMFEM2DSolver::solve()
                        _optical_sources[n].eta,
                        _optical_sources[n].eta_auto);
     }
-
   }
 
   STOP_LOG("EM FEM 2D Linear Solver", "solve");
@@ -151,21 +171,7 @@ void EMFEM2DSolver::solve_TM_scatter_problem(double lambda, double power, double
 
   build_TM_matrix_rhs(lambda, power, phase0);
 
-  KSPSetOperators(ksp, A, A, SAME_NONZERO_PATTERN);//must reset pc by is call!
-  KSPSolve(ksp,b,x);
-
-  KSPConvergedReason reason;
-  KSPGetConvergedReason(ksp, &reason);
-
-  PetscInt   its;
-  KSPGetIterationNumber(ksp, &its);
-
-  PetscReal  rnorm;
-  KSPGetResidualNorm(ksp, &rnorm);
-
-  MESSAGE<<"------> residual norm = "<<rnorm<<" its = "<<its<<" with "<<KSPConvergedReasons[reason]<<"\n\n";
-  RECORD();
-
+  solve_linear_system();
 }
 
 
@@ -176,12 +182,33 @@ void EMFEM2DSolver::solve_TE_scatter_problem(double lambda, double power, double
 
   build_TE_matrix_rhs(lambda, power, phase0);
 
-  KSPSetOperators(ksp, A, A, SAME_NONZERO_PATTERN);//must reset pc by is call!
+  solve_linear_system();
+}
+
+
+
+void EMFEM2DSolver::solve_linear_system()
+{
+  // factorize the matrix only at the first wave length of batch
+  bool refactor = ( _batch_count == 0 );
+  KSPSetOperators(ksp, A, A, refactor ? SAME_NONZERO_PATTERN : SAME_PRECONDITIONER);//must reset pc by is call!
   KSPSolve(ksp,b,x);
 
   KSPConvergedReason reason;
   KSPGetConvergedReason(ksp, &reason);
 
+  // the old factorization does not work for this wave length, update it
+  if ( reason < 0 && !refactor )
+  {
+    MESSAGE<<"------> preconditioner of wave length batch failed with "<<KSPConvergedReasons[reason]<<", refactorize...\n";
+    RECORD();
+    KSPSetOperators ( ksp, A, A, SAME_NONZERO_PATTERN );
+    KSPSolve ( ksp, b, x );
+    KSPGetConvergedReason ( ksp, &reason );
+    _batch_count = 0;
+  }
+  _batch_count = ( _batch_count+1 ) % _batch;
+
   PetscInt   its;
   KSPGetIterationNumber(ksp, &its);
 
@@ -211,7 +238,9 @@ void EMFEM2DSolver::build_TE_matrix_rhs(double lambda, double power, double phas
   Order int_order=SECOND;
   FEType fe_type;
 
-  VecZeroEntries(x);
+  // inside a batch, the solution of last wave length is kept as initial guess
+  if(_batch_count == 0)
+    VecZeroEntries(x);
   VecZeroEntries(b);
   MatZeroEntries(A);
 
@@ -414,7 +443,9 @@ void EMFEM2DSolver::build_TM_matrix_rhs(double lambda, double power, double phas
   Order int_order=SECOND;
   FEType fe_type;
 
-  VecZeroEntries(x);
+  // inside a batch, the solution of last wave length is kept as initial guess
+  if(_batch_count == 0)
+    VecZeroEntries(x);
   VecZeroEntries(b);
   MatZeroEntries(A);
 
@@ -1047,6 +1078,10 @@ void EMFEM2DSolver::setup_solver_parameters()
   // set preconditioner type
   SolverSpecify::PC = SolverSpecify::preconditioner_type(_card.get_string("pc", "asm"));
 
+  // wave lengths sharing one factorization
+  _batch = std::max(1, _card.get_int("batch", 1));
+  _batch_count = 0;
+
   // build the absorbing boundary
   build_absorb_chain();
 }
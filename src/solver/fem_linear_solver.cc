@@ -161,6 +161,13 @@ void FEM_LinearSolver::set_petsc_linear_solver_type(SolverSpecify::LinearSolverT
 {
   int ierr = 0;
 
+  // LS=auto is selected by the nonlinear solvers only, a linear problem is solved by LU
+  if( linear_solver_type == SolverSpecify::AUTO_LINEAR_SOLVER )
+  {
+    MESSAGE<< "Linear solver auto selection is for nonlinear solvers, use LU instead..."<<std::endl;  RECORD();
+    linear_solver_type = SolverSpecify::LU;
+  }
+
   _linear_solver_type = linear_solver_type;
 
   switch (linear_solver_type)
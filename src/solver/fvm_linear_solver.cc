@@ -46,8 +46,14 @@ void FVM_LinearSolver::setup_linear_data()
 
   PetscErrorCode ierr;
 
-  // create the global solution vector
-  ierr = VecCreateMPI(PETSC_COMM_WORLD, n_local_dofs, n_global_dofs, &x); genius_assert(!ierr);
+  // create the global solution vector, its type can be selected by METHOD card or -vec_type
+  ierr = VecCreate(PETSC_COMM_WORLD, &x); genius_assert(!ierr);
+  ierr = VecSetSizes(x, n_local_dofs, n_global_dofs); genius_assert(!ierr);
+  if( !SolverSpecify::VectorType.empty() )
+  {
+    ierr = VecSetType(x, SolverSpecify::VectorType.c_str()); genius_assert(!ierr);
+  }
+  ierr = VecSetFromOptions(x); genius_assert(!ierr);
   // use VecDuplicate to create vector with same pattern
   ierr = VecDuplicate(x, &b);genius_assert(!ierr);
   ierr = VecDuplicate(x, &L);genius_assert(!ierr);
@@ -83,16 +89,26 @@ void FVM_LinearSolver::setup_linear_data()
   if (Genius::n_processors()>1)
   {
     ierr = MatSetType(A,MATMPIAIJ); genius_assert(!ierr);
-    // alloc memory for parallel matrix here
-    ierr = MatMPIAIJSetPreallocation(A, 0, &n_nz[0], 0, &n_oz[0]); genius_assert(!ierr);
   }
   else
   {
     ierr = MatSetType(A,MATSEQAIJ); genius_assert(!ierr);
-    // alloc memory for sequence matrix here
-    ierr = MatSeqAIJSetPreallocation(A, 0, &n_nz[0]); genius_assert(!ierr);
   }
 
+  // METHOD card or -mat_type may select a format derived from AIJ, i.e. a GPU matrix.
+  // it must be done before preallocation, since changing matrix type drops the preallocation.
+  // the preallocation routine which does not match the matrix type is ignored by PETSC
+  if( !SolverSpecify::MatrixType.empty() )
+  {
+    ierr = MatSetType(A, SolverSpecify::MatrixType.c_str()); genius_assert(!ierr);
+  }
+  ierr = MatSetFromOptions(A); genius_assert(!ierr);
+
+  // alloc memory for parallel matrix here
+  ierr = MatMPIAIJSetPreallocation(A, 0, &n_nz[0], 0, &n_oz[0]); genius_assert(!ierr);
+  // alloc memory for sequence matrix here
+  ierr = MatSeqAIJSetPreallocation(A, 0, &n_nz[0]); genius_assert(!ierr);
+
 
 
   // indicates when PetscUtils::MatZeroRows() is called the zeroed entries are kept in the nonzero structure
@@ -150,6 +166,23 @@ void FVM_LinearSolver::clear_linear_data()
 }
 
 
+/*------------------------------------------------------------------
+ * record the bytes of matrix and vectors
+ */
+void FVM_LinearSolver::memory_usage(MemoryLog & log) const
+{
+  MatInfo info;
+  MatGetInfo(A, MAT_LOCAL, &info);
+  log.add("PETSc matrix", static_cast<size_t>(info.memory));
+
+  // x, b and L are distributed vectors, lx and lb are local vectors with ghosts
+  PetscInt n_local, n_ghost;
+  VecGetLocalSize(x, &n_local);
+  VecGetLocalSize(lx, &n_ghost);
+  log.add("PETSc vector", (3*n_local + 2*n_ghost)*sizeof(PetscScalar));
+}
+
+
 /*------------------------------------------------------------------
  * destructor: destroy context
  */
@@ -168,6 +201,13 @@ void FVM_LinearSolver::set_petsc_linear_solver_type(SolverSpecify::LinearSolverT
 {
   int ierr = 0;
 
+  // LS=auto is selected by the nonlinear solvers only, a linear problem is solved by LU
+  if( linear_solver_type == SolverSpecify::AUTO_LINEAR_SOLVER )
+  {
+    MESSAGE<< "Linear solver auto selection is for nonlinear solvers, use LU instead..."<<std::endl;  RECORD();
+    linear_solver_type = SolverSpecify::LU;
+  }
+
   _linear_solver_type = linear_solver_type;
 
   switch (linear_solver_type)
@@ -20,10 +20,20 @@
 /********************************************************************************/
 
 
+#include <algorithm>
+#include <cstring>
+#include <map>
 #include <numeric>
+#include <sstream>
 
 #include "fvm_nonlinear_solver.h"
+#include "perf_log.h"
+#include "memory_log.h"
+#include "solver_stats.h"
+#include "mesh_base.h"
+#include "elem.h"
 #include "parallel.h"
+#include "petsc_utils.h"
 
 #ifdef HAVE_SLEPC
 #include "slepceps.h"
@@ -47,6 +57,7 @@ extern "C"
     // convert void* to FVM_NonlinearSolver*
     FVM_NonlinearSolver * nonlinear_solver = (FVM_NonlinearSolver *)ctx;
 
+    nonlinear_solver->record_function_norm(its, fnorm);
     nonlinear_solver->petsc_snes_monitor(its, fnorm);
 
     return ierr;
@@ -64,6 +75,8 @@ extern "C"
     FVM_NonlinearSolver * nonlinear_solver = (FVM_NonlinearSolver *)ctx;
 
     nonlinear_solver->petsc_snes_convergence_test(its, xnorm, gnorm, fnorm, reason);
+    nonlinear_solver->record_converged_reason(*reason);
+    nonlinear_solver->record_iteration_stats(its, fnorm, *reason);
 
     return ierr;
   }
@@ -90,7 +103,14 @@ extern "C"
     // convert void* to FVM_NonlinearSolver*
     FVM_NonlinearSolver * nonlinear_solver = (FVM_NonlinearSolver *)ctx;
 
+    START_LOG("SNES_Residual()", "FVM_NonlinearSolver");
+    const double t_begin = SolverStats::enabled() ? MPI_Wtime() : 0.0;
     nonlinear_solver->build_petsc_sens_residual(x, f);
+    if( nonlinear_solver->residual_shift != PETSC_NULL )
+      VecAXPY(f, 1.0, nonlinear_solver->residual_shift);
+    if( SolverStats::enabled() )
+      nonlinear_solver->stats_residual_time += MPI_Wtime() - t_begin;
+    STOP_LOG("SNES_Residual()", "FVM_NonlinearSolver");
 
     return ierr;
   }
@@ -104,7 +124,31 @@ extern "C"
     // convert void* to FVM_NonlinearSolver*
     FVM_NonlinearSolver * nonlinear_solver = (FVM_NonlinearSolver *)ctx;
 
+    // the matrix free operator should always be assembled to update its base vector
+    if( *jac != *pc )
+    {
+      START_LOG("MatAssembly()", "FVM_NonlinearSolver");
+      MatAssemblyBegin(*jac, MAT_FINAL_ASSEMBLY);
+      MatAssemblyEnd(*jac, MAT_FINAL_ASSEMBLY);
+      STOP_LOG("MatAssembly()", "FVM_NonlinearSolver");
+    }
+
+    // keep the jacobian matrix and the factorized preconditioner of previous Newton iteration
+    if( nonlinear_solver->reuse_jacobian_matrix() )
+    {
+      *msflag = SAME_PRECONDITIONER;
+      return ierr;
+    }
+
+    START_LOG("SNES_Jacobian()", "FVM_NonlinearSolver");
+    const double t_begin = SolverStats::enabled() ? MPI_Wtime() : 0.0;
     nonlinear_solver->build_petsc_sens_jacobian(x, jac, pc);
+    if( SolverStats::enabled() )
+      nonlinear_solver->stats_jacobian_time += MPI_Wtime() - t_begin;
+    STOP_LOG("SNES_Jacobian()", "FVM_NonlinearSolver");
+
+    // the nonzero pattern is known after the first assembly
+    nonlinear_solver->compact_jacobian_matrix();
 
     *msflag = SAME_NONZERO_PATTERN;
 
@@ -122,7 +166,9 @@ extern "C"
     // convert void* to FVM_NonlinearSolver*
     FVM_NonlinearSolver * nonlinear_solver = (FVM_NonlinearSolver *)ctx;
 
+    START_LOG("LineSearch_PreCheck()", "FVM_NonlinearSolver");
     nonlinear_solver->sens_line_search_pre_check(x, y, changed_y);
+    STOP_LOG("LineSearch_PreCheck()", "FVM_NonlinearSolver");
 
     return ierr;
   }
@@ -136,8 +182,33 @@ extern "C"
     // convert void* to FVM_NonlinearSolver*
     FVM_NonlinearSolver * nonlinear_solver = (FVM_NonlinearSolver *)ctx;
 
+    START_LOG("LineSearch_PostCheck()", "FVM_NonlinearSolver");
+
+    // the Newton step is x-w, its length before and after the damping of post check
+    PetscReal step_norm = 0.0;
+    if( SolverStats::enabled() )
+    {
+      Vec step = nonlinear_solver->get_work_vector();
+      VecWAXPY(step, -1.0, w, x);
+      VecNorm(step, NORM_2, &step_norm);
+      nonlinear_solver->restore_work_vector(step);
+    }
+
     nonlinear_solver->sens_line_search_post_check(x, y, w, changed_y, changed_w);
 
+    nonlinear_solver->stats_damping = 1.0;
+    if( SolverStats::enabled() && (*changed_y || *changed_w) && step_norm > 0.0 )
+    {
+      Vec step = nonlinear_solver->get_work_vector();
+      PetscReal damped_norm;
+      VecWAXPY(step, -1.0, w, x);
+      VecNorm(step, NORM_2, &damped_norm);
+      nonlinear_solver->restore_work_vector(step);
+      nonlinear_solver->stats_damping = damped_norm/step_norm;
+    }
+
+    STOP_LOG("LineSearch_PostCheck()", "FVM_NonlinearSolver");
+
     return ierr;
   }
 
@@ -149,7 +220,12 @@ extern "C"
 /*------------------------------------------------------------------
  * constructor, setup context
  */
-FVM_NonlinearSolver::FVM_NonlinearSolver(SimulationSystem & system): FVM_PDESolver(system)
+FVM_NonlinearSolver::FVM_NonlinearSolver(SimulationSystem & system): FVM_PDESolver(system),
+    jacobian_matrix_first_assemble(false), jacobian_matrix_compacted(false), jacobian_matrix_reusable(false), jacobian_matrix_reuse_count(0),
+    nonlinear_solve_converged(false), _snes_its(0), _fnorm(0.0), _fnorm_previous(0.0),
+    stats_residual_time(0.0), stats_jacobian_time(0.0), stats_damping(1.0), residual_shift(PETSC_NULL),
+    _damping_radius(0.0), _damping_fnorm(0.0), _damping_predicted_fnorm(0.0), _damping_step_limited(false),
+    _global_clear_rows_valid(false), _auto_linear_solver(-1), _stats_solve(0), _stats_iteration_begin(0.0), _stats_lits(0)
 {
   PetscErrorCode ierr;
 
@@ -167,24 +243,42 @@ void FVM_NonlinearSolver::setup_nonlinear_data()
   // map mesh to PETSC solver
   build_dof_map();
 
+  // the bcs set up the data depend on dof offsets before the first residual evaluation
+  for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+    _system.get_bcs()->get_bc(b)->prepare_for_solver();
+
   // set petsc routine
 
   PetscErrorCode ierr;
 
-  // create the global solution vector
-  ierr = VecCreateMPI(PETSC_COMM_WORLD, n_local_dofs, n_global_dofs, &x); genius_assert(!ierr);
+  // create the global solution vector. its type can be selected by METHOD card or -vec_type, i.e. a GPU
+  // vector type for device side linear solvers, the assembly always works on host array of lx/lf
+  ierr = VecCreate(PETSC_COMM_WORLD, &x); genius_assert(!ierr);
+  ierr = VecSetSizes(x, n_local_dofs, n_global_dofs); genius_assert(!ierr);
+  if( !SolverSpecify::VectorType.empty() )
+  {
+    ierr = VecSetType(x, SolverSpecify::VectorType.c_str()); genius_assert(!ierr);
+  }
+  ierr = VecSetFromOptions(x); genius_assert(!ierr);
   // use VecDuplicate to create vector with same pattern
   ierr = VecDuplicate(x, &f);genius_assert(!ierr);
   ierr = VecDuplicate(x, &L);genius_assert(!ierr);
 
-  // set all the components of scale vector L to 1.0
-  ierr = VecSet(L, 1.0); genius_assert(!ierr);
-
   // create local vector, which has extra room for ghost dofs! the MPI_COMM here is PETSC_COMM_SELF
   ierr = VecCreateSeq(PETSC_COMM_SELF,  local_index_array.size() , &lx); genius_assert(!ierr);
   // use VecDuplicate to create vector with same pattern
   ierr = VecDuplicate(lx, &lf);genius_assert(!ierr);
 
+  // the threaded assembly works on the arrays of these vectors, place their pages by first touch
+  ierr = PetscUtils::VecFirstTouch(x); genius_assert(!ierr);
+  ierr = PetscUtils::VecFirstTouch(f); genius_assert(!ierr);
+  ierr = PetscUtils::VecFirstTouch(L); genius_assert(!ierr);
+  ierr = PetscUtils::VecFirstTouch(lx); genius_assert(!ierr);
+  ierr = PetscUtils::VecFirstTouch(lf); genius_assert(!ierr);
+
+  // set all the components of scale vector L to 1.0
+  ierr = VecSet(L, 1.0); genius_assert(!ierr);
+
   // create the index for vector statter
 #ifdef PETSC_VERSION_DEV
   ierr = ISCreateGeneral(PETSC_COMM_WORLD, global_index_array.size(), &global_index_array[0] , PETSC_COPY_VALUES, &gis); genius_assert(!ierr);
@@ -199,6 +293,34 @@ void FVM_NonlinearSolver::setup_nonlinear_data()
   // create the vector statter
   ierr = VecScatterCreate(x, gis, lx, lis, &scatter); genius_assert(!ierr);
 
+  // when the head of lx is the on processor block of x, only the ghost dofs need communication
+  {
+    bool ghost_tail = local_index_array.size() >= n_local_dofs;
+    for(unsigned int i=0; i<n_local_dofs && ghost_tail; ++i)
+      if( local_index_array[i] != static_cast<PetscInt>(i) ||
+          global_index_array[i] != static_cast<PetscInt>(global_offset+i) ) ghost_tail = false;
+    Parallel::min(ghost_tail);
+
+    ghost_scatter = PETSC_NULL;
+    if( ghost_tail )
+    {
+      const unsigned int n_ghost_dofs = local_index_array.size() - n_local_dofs;
+      PetscInt * ghost_global_index = n_ghost_dofs ? &global_index_array[n_local_dofs] : PETSC_NULL;
+      PetscInt * ghost_local_index  = n_ghost_dofs ? &local_index_array[n_local_dofs] : PETSC_NULL;
+      IS ghost_gis, ghost_lis;
+#ifdef PETSC_VERSION_DEV
+      ierr = ISCreateGeneral(PETSC_COMM_WORLD, n_ghost_dofs, ghost_global_index, PETSC_COPY_VALUES, &ghost_gis); genius_assert(!ierr);
+      ierr = ISCreateGeneral(PETSC_COMM_SELF,  n_ghost_dofs, ghost_local_index,  PETSC_COPY_VALUES, &ghost_lis); genius_assert(!ierr);
+#else
+      ierr = ISCreateGeneral(PETSC_COMM_WORLD, n_ghost_dofs, ghost_global_index, &ghost_gis); genius_assert(!ierr);
+      ierr = ISCreateGeneral(PETSC_COMM_SELF,  n_ghost_dofs, ghost_local_index,  &ghost_lis); genius_assert(!ierr);
+#endif
+      ierr = VecScatterCreate(x, ghost_gis, lx, ghost_lis, &ghost_scatter); genius_assert(!ierr);
+      ierr = ISDestroy(ghost_gis); genius_assert(!ierr);
+      ierr = ISDestroy(ghost_lis); genius_assert(!ierr);
+    }
+  }
+
 
 
   // create the jacobian matrix
@@ -206,17 +328,76 @@ void FVM_NonlinearSolver::setup_nonlinear_data()
   ierr = MatSetSizes(J, n_local_dofs, n_local_dofs, n_global_dofs, n_global_dofs); genius_assert(!ierr);
 
 
-  if (Genius::n_processors()>1)
+  // node-level block size of the jacobian matrix, 1 for scalar AIJ storage
+  PetscInt bs = 1;
+  if( SolverSpecify::JacobianBlock && !SolverSpecify::MatrixType.empty() )
   {
-    ierr = MatSetType(J,MATMPIAIJ); genius_assert(!ierr);
-    // alloc memory for parallel matrix here
-    ierr = MatMPIAIJSetPreallocation(J, 0, &n_nz[0], 0, &n_oz[0]); genius_assert(!ierr);
+    MESSAGE<< "Jacobian block storage is not used with matrix type " << SolverSpecify::MatrixType << "..."<<std::endl;  RECORD();
+  }
+  else if( SolverSpecify::JacobianBlock )
+  {
+    bs = jacobian_block_size();
+    if( bs == 1 )
+    {
+      MESSAGE<< "Jacobian block storage requires the same dofs on every node, using AIJ format..."<<std::endl;  RECORD();
+    }
+  }
+
+  if( bs > 1 )
+  {
+    // nonzero blocks of each block row. the scalar pattern counts whole nodes,
+    // the extra bc columns may straddle one more block
+    const PetscInt n_local_blocks  = n_local_dofs/bs;
+    const PetscInt n_remote_blocks = (n_global_dofs-n_local_dofs)/bs;
+    std::vector<PetscInt> n_bnz(n_local_blocks, 0);
+    std::vector<PetscInt> n_boz(n_local_blocks, 0);
+    for(unsigned int i=0; i<n_local_dofs; ++i)
+    {
+      n_bnz[i/bs] = std::max(n_bnz[i/bs], std::min((n_nz[i]+bs-1)/bs+1, n_local_blocks));
+      n_boz[i/bs] = std::max(n_boz[i/bs], std::min((n_oz[i]+bs-1)/bs+1, n_remote_blocks));
+    }
+
+    if (Genius::n_processors()>1)
+    {
+      ierr = MatSetType(J,MATMPIBAIJ); genius_assert(!ierr);
+      ierr = MatMPIBAIJSetPreallocation(J, bs, 0, &n_bnz[0], 0, &n_boz[0]); genius_assert(!ierr);
+    }
+    else
+    {
+      ierr = MatSetType(J,MATSEQBAIJ); genius_assert(!ierr);
+      ierr = MatSeqBAIJSetPreallocation(J, bs, 0, &n_bnz[0]); genius_assert(!ierr);
+    }
+
+    MESSAGE<< "Using BAIJ jacobian matrix with block size " << bs << "..."<<std::endl;  RECORD();
   }
   else
   {
-    ierr = MatSetType(J,MATSEQAIJ); genius_assert(!ierr);
+    if (Genius::n_processors()>1)
+    {
+      ierr = MatSetType(J,MATMPIAIJ); genius_assert(!ierr);
+    }
+    else
+    {
+      ierr = MatSetType(J,MATSEQAIJ); genius_assert(!ierr);
+    }
+
+    // METHOD card or -mat_type may select a format derived from AIJ, i.e. a GPU matrix to match
+    // the vector type. it must be done before preallocation, since changing matrix type drops the
+    // preallocation. the preallocation routine which does not match the matrix type is ignored by PETSC
+    if( !SolverSpecify::MatrixType.empty() )
+    {
+      ierr = MatSetType(J, SolverSpecify::MatrixType.c_str()); genius_assert(!ierr);
+    }
+    ierr = MatSetFromOptions(J); genius_assert(!ierr);
+
+    // alloc memory for parallel matrix here
+    ierr = MatMPIAIJSetPreallocation(J, 0, &n_nz[0], 0, &n_oz[0]); genius_assert(!ierr);
     // alloc memory for sequence matrix here
     ierr = MatSeqAIJSetPreallocation(J, 0, &n_nz[0]); genius_assert(!ierr);
+
+    // PETSC leaves the value array untouched till the first assembly, which is serial.
+    // touch it by the threads now, so the rows are close to the threads assembling them by slot map
+    ierr = PetscUtils::MatFirstTouch(J); genius_assert(!ierr);
   }
 
 
@@ -239,9 +420,15 @@ void FVM_NonlinearSolver::setup_nonlinear_data()
 
   // the jacobian matrix is not assembled yet.
   jacobian_matrix_first_assemble = false;
+  jacobian_matrix_compacted = false;
+  jacobian_matrix_reusable = false;
+  jacobian_matrix_reuse_count = 0;
 
   ierr = MatSetFromOptions(J); genius_assert(!ierr);
 
+  // assembly routines which only know J can find its slot map
+  MatSlotMap::attach(J, &J_slot_map);
+
 
 
   // set petsc nonlinear solver type here
@@ -251,7 +438,18 @@ void FVM_NonlinearSolver::setup_nonlinear_data()
   ierr = SNESSetFunction (snes, f, __genius_petsc_snes_residual, this);genius_assert(!ierr);
 
   // set the nonlinear Jacobian
-  ierr = SNESSetJacobian (snes, J, J, __genius_petsc_snes_jacobian, this);genius_assert(!ierr);
+  Jmf = PETSC_NULL;
+  if( SolverSpecify::JFNK )
+  {
+    // jacobian-vector product by finite difference of residual, J only used as preconditioner matrix
+    ierr = MatCreateSNESMF(snes, &Jmf); genius_assert(!ierr);
+    ierr = MatSetFromOptions(Jmf); genius_assert(!ierr);
+    ierr = SNESSetJacobian (snes, Jmf, J, __genius_petsc_snes_jacobian, this);genius_assert(!ierr);
+  }
+  else
+  {
+    ierr = SNESSetJacobian (snes, J, J, __genius_petsc_snes_jacobian, this);genius_assert(!ierr);
+  }
 
   // set nonlinear solver monitor
   ierr = SNESMonitorSet (snes, __genius_petsc_snes_monitor, this, PETSC_NULL); genius_assert(!ierr);
@@ -276,8 +474,84 @@ void FVM_NonlinearSolver::setup_nonlinear_data()
   ierr = KSPGetPC(ksp, &pc); genius_assert(!ierr);
 
   // Set user-specified linear solver and preconditioner types
-  set_petsc_linear_solver_type    ( SolverSpecify::LS );
-  set_petsc_preconditioner_type   ( SolverSpecify::PC );
+  SolverSpecify::LinearSolverType   ls_type = SolverSpecify::LS;
+  SolverSpecify::PreconditionerType pc_type = SolverSpecify::PC;
+  if( ls_type == SolverSpecify::AUTO_LINEAR_SOLVER )
+    select_auto_linear_solver(ls_type, pc_type);
+  set_petsc_linear_solver_type    ( ls_type );
+  set_petsc_preconditioner_type   ( pc_type );
+
+  // the nonzero pattern of jacobian matrix never changes (SAME_NONZERO_PATTERN is reported), so
+  // factor preconditioners only redo the numeric factorization. keep the ordering and fill as well,
+  // and let SuperLU_DIST reuse its row permutation, which is otherwise recomputed for every factorization
+  if( SolverSpecify::PCReuseOrdering )
+  {
+    ierr = PCFactorSetReuseOrdering(pc, PETSC_TRUE); genius_assert(!ierr);
+    ierr = PCFactorSetReuseFill(pc, PETSC_TRUE); genius_assert(!ierr);
+    if( _linear_solver_type == SolverSpecify::SuperLU_DIST )
+    {
+      set_solver_option("-mat_superlu_dist_fact", "SamePattern_SameRowPerm");
+    }
+  }
+
+  // lag the rebuild of preconditioner, the jacobian matrix is still built every Newton iteration
+  if( SolverSpecify::PCLag != 1 )
+  {
+    MESSAGE<< "Rebuild preconditioner every " << SolverSpecify::PCLag << " jacobian evaluations..."<<std::endl;  RECORD();
+    ierr = SNESSetLagPreconditioner(snes, SolverSpecify::PCLag); genius_assert(!ierr);
+  }
+
+  // factorization with static pivoting does not delay pivots, which keeps the memory of factor bounded,
+  // but only gives an approximate inverse. a few GMRES steps against the jacobian recover the accuracy
+  if( SolverSpecify::DirectRefine )
+  {
+    bool refine = false;
+    if (_linear_solver_type == SolverSpecify::MUMPS ||
+        (_linear_solver_type == SolverSpecify::LU && Genius::n_processors()>1) )
+    {
+#ifdef PETSC_HAVE_MUMPS
+      // row/column scaling of badly scaled DDM jacobian, and no threshold pivoting
+      set_solver_option("-mat_mumps_icntl_8", "77");
+      set_solver_option("-mat_mumps_cntl_1", "0.0");
+      refine = true;
+#endif
+    }
+    if( _linear_solver_type == SolverSpecify::SuperLU_DIST )
+    {
+#ifdef PETSC_HAVE_LIBSUPERLU_DIST_2
+      set_solver_option("-mat_superlu_dist_equil", "TRUE");
+      set_solver_option("-mat_superlu_dist_rowperm", "LargeDiag");
+      set_solver_option("-mat_superlu_dist_replacetinypivot", "TRUE");
+      set_solver_option("-mat_superlu_dist_iterrefine", "FALSE");
+      refine = true;
+#endif
+    }
+
+    if( refine )
+    {
+      MESSAGE<< "Direct solver with static pivoting, refined by GMRES..."<<std::endl;  RECORD();
+      ierr = KSPSetType (ksp, (char*) KSPGMRES);      genius_assert(!ierr);
+      ierr = KSPGMRESSetRestart(ksp, 100);            genius_assert(!ierr);
+    }
+  }
+
+  // direct method only applies the factorization of preconditioner matrix, which never sees
+  // the matrix free operator. use the factorization as preconditioner of GMRES instead
+  if( SolverSpecify::JFNK )
+  {
+    if (_linear_solver_type == SolverSpecify::LU ||
+        _linear_solver_type == SolverSpecify::UMFPACK ||
+        _linear_solver_type == SolverSpecify::SuperLU ||
+        _linear_solver_type == SolverSpecify::MUMPS   ||
+        _linear_solver_type == SolverSpecify::PASTIX  ||
+        _linear_solver_type == SolverSpecify::SuperLU_DIST
+       )
+    {
+      MESSAGE<< "JFNK: using GMRES with direct factorization as preconditioner..."<<std::endl;  RECORD();
+      ierr = KSPSetType (ksp, (char*) KSPGMRES);      genius_assert(!ierr);
+      ierr = KSPGMRESSetRestart(ksp, 100);            genius_assert(!ierr);
+    }
+  }
 
 
 
@@ -313,6 +587,66 @@ void FVM_NonlinearSolver::dump_function_vector_petsc(const std::string &file) co
 
 
 
+/*------------------------------------------------------------------
+ * node-level block size of the jacobian matrix
+ */
+PetscInt FVM_NonlinearSolver::jacobian_block_size()
+{
+  // the dofs of each node should be the same
+  unsigned int bs = 0;
+  bool uniform = true;
+  for(unsigned int n=0; n<_system.n_regions(); ++n)
+  {
+    const unsigned int region_node_dofs = this->node_dofs( _system.region(n) );
+    if( region_node_dofs == 0 ) continue;
+    if( bs == 0 ) bs = region_node_dofs;
+    if( bs != region_node_dofs ) uniform = false;
+  }
+  if( bs < 2 ) return 1;
+
+  // every block should start at a multiple of bs, the bc and extra dofs at the end included
+  if( n_global_dofs%bs || n_local_dofs%bs ) uniform = false;
+
+  for(unsigned int n=0; n<_system.n_regions() && uniform; ++n)
+  {
+    SimulationRegion * region = _system.region(n);
+    SimulationRegion::local_node_iterator it = region->on_local_nodes_begin();
+    SimulationRegion::local_node_iterator it_end = region->on_local_nodes_end();
+    for(; it!=it_end; ++it)
+      if( (*it)->global_offset()%bs ) { uniform = false; break; }
+  }
+
+  Parallel::min(uniform);
+
+  return uniform ? bs : 1;
+}
+
+
+
+Vec FVM_NonlinearSolver::get_work_vector(bool local)
+{
+  std::vector<Vec> & pool = local ? local_work_vectors : work_vectors;
+
+  Vec v;
+  if( pool.empty() )
+  {
+    PetscErrorCode ierr = VecDuplicate(local ? lx : x, &v); genius_assert(!ierr);
+    return v;
+  }
+
+  v = pool.back();
+  pool.pop_back();
+  return v;
+}
+
+
+void FVM_NonlinearSolver::restore_work_vector(Vec v, bool local)
+{
+  std::vector<Vec> & pool = local ? local_work_vectors : work_vectors;
+  pool.push_back(v);
+}
+
+
 /*------------------------------------------------------------------
  * destroy nonlinear data
  */
@@ -325,12 +659,57 @@ void FVM_NonlinearSolver::clear_nonlinear_data()
   ierr = VecDestroy(L);              genius_assert(!ierr);
   ierr = VecDestroy(lx);             genius_assert(!ierr);
   ierr = VecDestroy(lf);             genius_assert(!ierr);
+  for(unsigned int i=0; i<work_vectors.size(); ++i)
+  { ierr = VecDestroy(work_vectors[i]);  genius_assert(!ierr); }
+  for(unsigned int i=0; i<local_work_vectors.size(); ++i)
+  { ierr = VecDestroy(local_work_vectors[i]);  genius_assert(!ierr); }
+  work_vectors.clear();
+  local_work_vectors.clear();
   ierr = ISDestroy(gis);             genius_assert(!ierr);
   ierr = ISDestroy(lis);             genius_assert(!ierr);
   ierr = VecScatterDestroy(scatter); genius_assert(!ierr);
+  if( ghost_scatter )
+  {
+    ierr = VecScatterDestroy(ghost_scatter); genius_assert(!ierr);
+  }
+  MatSlotMap::detach(J);
+  J_slot_map.clear();
   ierr = MatDestroy(J);              genius_assert(!ierr);
+  if( Jmf )
+  {
+    ierr = MatDestroy(Jmf);          genius_assert(!ierr);
+  }
+
+  // the PETSc options of this solver should not be inherited by the next one
+  for(unsigned int i=0; i<_solver_options.size(); ++i)
+  { ierr = PetscOptionsClearValue(_solver_options[i].c_str()); genius_assert(!ierr); }
+  _solver_options.clear();
+
+  _global_clear_rows.clear();
+  _global_clear_rows_valid = false;
+
+  // the dof offsets are no longer valid for the bcs
+  for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
+    _system.get_bcs()->get_bc(b)->clear_solver_data();
 }
 
+/*------------------------------------------------------------------
+ * record the bytes of jacobian matrix and vectors
+ */
+void FVM_NonlinearSolver::memory_usage(MemoryLog & log) const
+{
+  MatInfo info;
+  MatGetInfo(J, MAT_LOCAL, &info);
+  log.add("PETSc matrix", static_cast<size_t>(info.memory));
+
+  // x, f and L are distributed vectors, lx and lf are local vectors with ghosts
+  PetscInt n_local, n_ghost;
+  VecGetLocalSize(x, &n_local);
+  VecGetLocalSize(lx, &n_ghost);
+  log.add("PETSc vector", (3*n_local + 2*n_ghost)*sizeof(PetscScalar));
+}
+
+
 /*------------------------------------------------------------------
  * destructor: destroy context
  */
@@ -355,7 +734,8 @@ void FVM_NonlinearSolver::petsc_snes_monitor(PetscInt its, PetscReal fnorm)
   PetscInt lits;
   SNESGetLinearSolveIterations(snes, &lits);
 
-  MESSAGE<< " its " << its << '\t'
+  MESSAGE_AT(GENIUS_LOG_STREAM::ITERATION)
+  << " its " << its << '\t'
   << std::scientific
   << " |residual|_2 = " << fnorm
   << "  linear iter = "  << lits - pre_lits
@@ -367,6 +747,291 @@ void FVM_NonlinearSolver::petsc_snes_monitor(PetscInt its, PetscReal fnorm)
 }
 
 
+/*------------------------------------------------------------------
+ * record function norm for jacobian reuse test
+ */
+void FVM_NonlinearSolver::record_function_norm(PetscInt its, PetscReal fnorm)
+{
+  if( its==0 )
+  {
+    // a new nonlinear solve begins, the jacobian matrix of a diverged solve should not be reused
+    if( !nonlinear_solve_converged ) jacobian_matrix_reusable = false;
+    nonlinear_solve_converged = false;
+    _fnorm_previous = fnorm;
+  }
+  else
+    _fnorm_previous = _fnorm;
+
+  _snes_its = its;
+  _fnorm    = fnorm;
+}
+
+
+/*------------------------------------------------------------------
+ * write the statistics of Newton iteration its
+ */
+void FVM_NonlinearSolver::record_iteration_stats(PetscInt its, PetscReal fnorm, SNESConvergedReason reason)
+{
+  if( !SolverStats::enabled() ) return;
+
+  const double now = MPI_Wtime();
+
+  PetscInt lits;
+  SNESGetLinearSolveIterations(snes, &lits);
+
+  // iteration 0 only evaluates the initial residual
+  if( its == 0 )
+  {
+    ++_stats_solve;
+    _stats_iteration_begin = now;
+    _stats_lits = lits;
+  }
+
+  // the time not spent in assembly is spent in linear solver and line search
+  const double iteration_time = now - _stats_iteration_begin;
+  const double linear_time = std::max(0.0, iteration_time - stats_residual_time - stats_jacobian_time);
+
+  SolverStats stats("iteration");
+  stats.add("solve", _stats_solve)
+       .add("its", static_cast<int>(its))
+       .add("fnorm", static_cast<double>(fnorm))
+       .add("reason", static_cast<int>(reason));
+
+  std::vector<std::pair<std::string, PetscReal> > norms;
+  this->equation_norms(norms);
+  for(unsigned int n=0; n<norms.size(); ++n)
+    stats.add(norms[n].first, static_cast<double>(norms[n].second));
+
+  stats.add("damping", static_cast<double>(its ? stats_damping : 1.0))
+       .add("ksp_its", static_cast<int>(lits - _stats_lits))
+       .add("residual_time", stats_residual_time)
+       .add("jacobian_time", stats_jacobian_time)
+       .add("linear_time", its ? linear_time : 0.0)
+       .add("rss", static_cast<double>(MemoryLog::resident_memory()))
+       .write();
+
+  // the next iteration begins
+  _stats_iteration_begin = now;
+  _stats_lits = lits;
+  stats_residual_time = 0.0;
+  stats_jacobian_time = 0.0;
+  stats_damping = 1.0;
+}
+
+
+/*------------------------------------------------------------------
+ * clear rows of all the processors, gathered once per nonlinear solve
+ */
+const std::vector<PetscInt> & FVM_NonlinearSolver::global_clear_rows(const std::vector<PetscInt> & clear_rows)
+{
+  // the iteration number is the same on all the processors, so is the decision to gather
+  PetscInt its;
+  SNESGetIterationNumber(snes, &its);
+  if( its == 0 || !_global_clear_rows_valid )
+  {
+    PetscUtils::GlobalClearRows(clear_rows, _global_clear_rows);
+    _global_clear_rows_valid = true;
+  }
+  return _global_clear_rows;
+}
+
+
+/*------------------------------------------------------------------
+ * set PETSc option for this solver only
+ */
+void FVM_NonlinearSolver::set_solver_option(const std::string &name, const std::string &value)
+{
+  PetscErrorCode ierr = PetscOptionsSetValue(name.c_str(), value.c_str()); genius_assert(!ierr);
+  if( std::find(_solver_options.begin(), _solver_options.end(), name) == _solver_options.end() )
+    _solver_options.push_back(name);
+}
+
+
+/*------------------------------------------------------------------
+ * scatter global solution vector x to local vector lx in two phases
+ */
+void FVM_NonlinearSolver::scatter_local_begin(Vec x)
+{
+  START_LOG("scatter_local_begin()", "FVM_NonlinearSolver");
+
+  // without the ghost tail layout, the position of the on processor dofs in lx is not known here.
+  // finish the whole scatter, lx must be ready on return for the caller
+  if( !ghost_scatter )
+  {
+    VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+    VecScatterEnd(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+    STOP_LOG("scatter_local_begin()", "FVM_NonlinearSolver");
+    return;
+  }
+
+  // ghost dofs go through the network
+  VecScatterBegin(ghost_scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+
+  // the on processor dofs are copied while the messages are in flight
+  PetscScalar *xx, *lxx;
+  VecGetArray(x, &xx);
+  VecGetArray(lx, &lxx);
+  std::copy(xx, xx+n_local_dofs, lxx);
+  VecRestoreArray(x, &xx);
+  VecRestoreArray(lx, &lxx);
+
+  STOP_LOG("scatter_local_begin()", "FVM_NonlinearSolver");
+}
+
+
+void FVM_NonlinearSolver::scatter_local_end(Vec x)
+{
+  // the wait for the ghost dofs of other processors shows up here
+  START_LOG("scatter_local_end()", "FVM_NonlinearSolver");
+  // the scatter has been finished by scatter_local_begin when there is no ghost_scatter
+  if( ghost_scatter )
+    VecScatterEnd(ghost_scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+  STOP_LOG("scatter_local_end()", "FVM_NonlinearSolver");
+}
+
+
+/*------------------------------------------------------------------
+ * trust region like damping factor by linear model of function norm
+ */
+PetscReal FVM_NonlinearSolver::model_damping_factor(Vec y, PetscReal step_max, PetscReal radius_init, PetscReal lambda_max)
+{
+  if( _snes_its == 0 )
+  {
+    // a new nonlinear solve begins
+    _damping_radius = radius_init;
+  }
+  else if( _damping_fnorm > _damping_predicted_fnorm )
+  {
+    // _fnorm is the function norm at the end of last step
+    const PetscReal rho = (_damping_fnorm - _fnorm)/(_damping_fnorm - _damping_predicted_fnorm);
+    if( rho < 0.25 )
+      _damping_radius = std::max(0.25*_damping_radius, 1e-3*radius_init);
+    else if( rho > 0.75 && _damping_step_limited )
+      _damping_radius = std::min(2.0*_damping_radius, 1e3*radius_init);
+  }
+
+  const PetscReal lambda = std::min(step_max > _damping_radius ? _damping_radius/step_max : 1.0, lambda_max);
+  _damping_step_limited = lambda < 1.0;
+
+  // the true residual norm of linear solve |F-J*y|. the norm reported by KSP is the preconditioned one
+  // for left preconditioning, and is not computed at all by KSPPREONLY
+  PetscReal rnorm;
+  {
+    Vec F, r = get_work_vector();
+    SNESGetFunction(snes, &F, PETSC_NULL, PETSC_NULL);
+    // the linear solve works on the matrix free operator in JFNK mode
+    MatMult(Jmf ? Jmf : J, y, r);
+    VecAXPY(r, -1.0, F);
+    VecNorm(r, NORM_2, &rnorm);
+    restore_work_vector(r);
+  }
+  rnorm = std::min(rnorm, _fnorm);
+
+  _damping_fnorm = _fnorm;
+  _damping_predicted_fnorm = (1.0-lambda)*_fnorm + lambda*rnorm;
+
+  return lambda;
+}
+
+
+/*------------------------------------------------------------------
+ * record converged reason for jacobian reuse test
+ */
+void FVM_NonlinearSolver::record_converged_reason(SNESConvergedReason reason)
+{
+  if( reason > 0 ) nonlinear_solve_converged = true;
+  if( reason < 0 ) jacobian_matrix_reusable = false;
+}
+
+
+/*------------------------------------------------------------------
+ * test if the jacobian matrix of previous Newton iteration can be reused
+ */
+bool FVM_NonlinearSolver::reuse_jacobian_matrix()
+{
+  // with JFNK method the jacobian matrix is only a preconditioner, it is always lagged
+  bool reuse = (SolverSpecify::JacobianReuse || SolverSpecify::JFNK) && jacobian_matrix_first_assemble && jacobian_matrix_reusable;
+
+  // too many Newton iterations with this jacobian matrix
+  if( jacobian_matrix_reuse_count >= SolverSpecify::JacobianReuseMax ) reuse = false;
+
+  // the residual reduction of last Newton iteration stalls
+  if( _snes_its > 0 && _fnorm > SolverSpecify::JacobianReuseRatio*_fnorm_previous ) reuse = false;
+
+  if( reuse )
+  {
+    jacobian_matrix_reuse_count++;
+    return true;
+  }
+
+  // the jacobian matrix will be rebuilt
+  jacobian_matrix_reuse_count = 0;
+  jacobian_matrix_reusable = true;
+  return false;
+}
+
+
+/*------------------------------------------------------------------
+ * shrink the preallocation of jacobian matrix to its nonzero pattern
+ */
+void FVM_NonlinearSolver::compact_jacobian_matrix()
+{
+  if( !jacobian_matrix_first_assemble || jacobian_matrix_compacted ) return;
+  jacobian_matrix_compacted = true;
+
+  // the off-processor block of parallel matrix can not be re-preallocated in place,
+  // and BAIJ/device matrix keeps its own storage
+  MatType type;
+  PetscErrorCode ierr = MatGetType(J, &type); genius_assert(!ierr);
+  if( strcmp(type, MATSEQAIJ) ) return;
+
+  MatInfo info;
+  ierr = MatGetInfo(J, MAT_LOCAL, &info); genius_assert(!ierr);
+  if( info.nz_unneeded <= 0 ) return;
+
+  START_LOG("compact_jacobian_matrix()", "FVM_NonlinearSolver");
+
+  // the row length of the assembled matrix
+  PetscInt  m;
+  PetscInt *ia=0, *ja=0;
+  PetscBool done;
+  ierr = MatGetRowIJ(J, 0, PETSC_FALSE, PETSC_FALSE, &m, &ia, &ja, &done); genius_assert(!ierr);
+  if( !done )
+  {
+    STOP_LOG("compact_jacobian_matrix()", "FVM_NonlinearSolver");
+    return;
+  }
+  std::vector<PetscInt> nnz(m);
+  for(PetscInt r=0; r<m; ++r)
+    nnz[r] = ia[r+1] - ia[r];
+  ierr = MatRestoreRowIJ(J, 0, PETSC_FALSE, PETSC_FALSE, &m, &ia, &ja, &done); genius_assert(!ierr);
+
+  // keep the values in a duplicate, which holds the used entries only
+  Mat A;
+  ierr = MatDuplicate(J, MAT_COPY_VALUES, &A); genius_assert(!ierr);
+
+  // re-preallocate J in place, so the SNES context and the slot map registry still refer to it
+  ierr = MatSeqAIJSetPreallocation(J, 0, &nnz[0]); genius_assert(!ierr);
+  ierr = MatCopy(A, J, DIFFERENT_NONZERO_PATTERN); genius_assert(!ierr);
+  ierr = MatDestroy(A); genius_assert(!ierr);
+
+#ifdef DEBUG
+  // all the entries should go into the pattern of first assembly from now on
+  ierr = MatSetOption(J, MAT_NEW_NONZERO_ALLOCATION_ERR, PETSC_TRUE); genius_assert(!ierr);
+#endif
+
+  // the storage position of the entries changed
+  if( J_slot_map.valid() )
+    J_slot_map.build(J);
+
+  MESSAGE<<"Jacobian matrix preallocation shrinked from " << static_cast<size_t>(info.nz_allocated)
+         <<" to " << static_cast<size_t>(info.nz_used) << " nonzeros." << std::endl;
+  RECORD();
+
+  STOP_LOG("compact_jacobian_matrix()", "FVM_NonlinearSolver");
+}
+
+
 /*------------------------------------------------------------------
  * default snes convergence test
  */
@@ -896,6 +1561,15 @@ void FVM_NonlinearSolver::set_petsc_preconditioner_type(SolverSpecify::Precondit
       case SolverSpecify::JACOBI_PRECOND:
       ierr = PCSetType (pc, (char*) PCJACOBI);    genius_assert(!ierr); return;
 
+      case SolverSpecify::FIELDSPLIT_PRECOND:
+      set_petsc_fieldsplit_preconditioner(); return;
+
+      case SolverSpecify::BORDERED_PRECOND:
+      set_petsc_bordered_preconditioner(); return;
+
+      case SolverSpecify::MG_PRECOND:
+      set_petsc_mg_preconditioner(); return;
+
       case SolverSpecify::BLOCK_JACOBI_PRECOND:
       ierr = PCSetType (pc, (char*) PCBJACOBI);   genius_assert(!ierr); return;
 
@@ -921,13 +1595,655 @@ void FVM_NonlinearSolver::set_petsc_preconditioner_type(SolverSpecify::Precondit
   }
 }
 
+
+
+void FVM_NonlinearSolver::variable_split_index(std::vector< std::vector<PetscInt> > & split_index)
+{
+  // the solution variables of the local dofs, bc and extra dofs are attached to potential
+  std::vector<SolutionVariable> dof_variable(n_local_dofs, POTENTIAL);
+  for(unsigned int n=0; n<_system.n_regions(); ++n)
+  {
+    SimulationRegion * region = _system.region(n);
+    const unsigned int region_node_dofs = this->node_dofs(region);
+
+    SimulationRegion::local_node_iterator it = region->on_local_nodes_begin();
+    SimulationRegion::local_node_iterator it_end = region->on_local_nodes_end();
+    for(; it!=it_end; ++it)
+    {
+      const FVM_Node * fvm_node = *it;
+      for(unsigned int i=0; i<region_node_dofs; ++i)
+      {
+        SolutionVariable var = this->node_dof_variable(region, i);
+        if( var == INVALID_Variable ) continue;
+        dof_variable[fvm_node->global_offset() + i - global_offset] = var;
+      }
+    }
+  }
+
+  // one split for each solution variable, in the order of Gummel iteration
+  const unsigned int n_vars = 6;
+  const SolutionVariable vars[n_vars] = {POTENTIAL, ELECTRON, HOLE, TEMPERATURE, E_TEMP, H_TEMP};
+  split_index.assign(n_vars, std::vector<PetscInt>());
+  for(unsigned int i=0; i<n_local_dofs; ++i)
+    for(unsigned int v=0; v<n_vars; ++v)
+      if( dof_variable[i] == vars[v] ) { split_index[v].push_back(global_offset + i); break; }
+}
+
+
+void FVM_NonlinearSolver::gummel_presolve()
+{
+  PetscInt  max_sweeps = 0;
+  PetscReal rtol = 1e-2;
+  PetscBool flg;
+  PetscOptionsGetInt(PETSC_NULL, "-gummel_presolve", &max_sweeps, &flg);
+  if( !flg || max_sweeps <= 0 ) return;
+  PetscOptionsGetReal(PETSC_NULL, "-gummel_presolve_rtol", &rtol, &flg);
+
+  PetscErrorCode ierr;
+
+  // the dofs, the sub vectors of function and update for each solution variable
+  std::vector< std::vector<PetscInt> > split_index;
+  variable_split_index(split_index);
+
+  std::vector<IS>         block_is;
+  std::vector<Vec>        block_f, block_dx;
+  std::vector<VecScatter> block_scatter;
+  for(unsigned int v=0; v<split_index.size(); ++v)
+  {
+    unsigned int n_split_dofs = split_index[v].size();
+    Parallel::sum(n_split_dofs);
+    if( n_split_dofs == 0 ) continue;
+
+    IS is;
+    Vec bf, bdx;
+    VecScatter scatter;
+    PetscInt * index = split_index[v].empty() ? PETSC_NULL : &split_index[v][0];
+#ifdef PETSC_VERSION_DEV
+    ierr = ISCreateGeneral(PETSC_COMM_WORLD, split_index[v].size(), index, PETSC_COPY_VALUES, &is); genius_assert(!ierr);
+#else
+    ierr = ISCreateGeneral(PETSC_COMM_WORLD, split_index[v].size(), index, &is); genius_assert(!ierr);
+#endif
+    ierr = VecCreateMPI(PETSC_COMM_WORLD, split_index[v].size(), PETSC_DETERMINE, &bf); genius_assert(!ierr);
+    ierr = VecDuplicate(bf, &bdx); genius_assert(!ierr);
+    ierr = VecScatterCreate(f, is, bf, PETSC_NULL, &scatter); genius_assert(!ierr);
+
+    block_is.push_back(is);
+    block_f.push_back(bf);
+    block_dx.push_back(bdx);
+    block_scatter.push_back(scatter);
+  }
+
+  // a single variable problem is solved by Newton directly
+  if( block_is.size() > 1 )
+  {
+    START_LOG("gummel_presolve()", "FVM_NonlinearSolver");
+
+    // the diagonal blocks are scalar per node matrices, an ILU preconditioned krylov solver is enough
+    KSP block_ksp;
+    PC  block_pc;
+    ierr = KSPCreate(PETSC_COMM_WORLD, &block_ksp); genius_assert(!ierr);
+    ierr = KSPSetType(block_ksp, (char*) KSPGMRES); genius_assert(!ierr);
+    ierr = KSPGetPC(block_ksp, &block_pc); genius_assert(!ierr);
+    ierr = PCSetType(block_pc, Genius::n_processors() > 1 ? (char*) PCBJACOBI : (char*) PCILU); genius_assert(!ierr);
+    ierr = KSPSetTolerances(block_ksp, 1e-6, 1e-30, PETSC_DEFAULT, 500); genius_assert(!ierr);
+    ierr = KSPSetOptionsPrefix(block_ksp, "gummel_"); genius_assert(!ierr);
+    ierr = KSPSetFromOptions(block_ksp); genius_assert(!ierr);
+
+    Vec y  = get_work_vector();
+    Vec w  = get_work_vector();
+    Vec x0 = get_work_vector();
+
+    PetscReal fnorm0, fnorm;
+    build_petsc_sens_residual(x, f);
+    ierr = VecNorm(f, NORM_2, &fnorm0); genius_assert(!ierr);
+    fnorm = fnorm0;
+
+    MESSAGE<<"  Gummel presolve, initial function norm " << std::scientific << fnorm0 << std::endl; RECORD();
+
+    for(PetscInt sweep=0; sweep<max_sweeps && fnorm > rtol*fnorm0; ++sweep)
+    {
+      ierr = VecCopy(x, x0); genius_assert(!ierr);
+
+      for(unsigned int b=0; b<block_is.size(); ++b)
+      {
+        build_petsc_sens_residual(x, f);
+        build_petsc_sens_jacobian(x, &J, &J);
+
+        Mat Jb;
+#if PETSC_VERSION_LE(3,0,0)
+        ierr = MatGetSubMatrix(J, block_is[b], block_is[b], PETSC_DECIDE, MAT_INITIAL_MATRIX, &Jb); genius_assert(!ierr);
+#else
+        ierr = MatGetSubMatrix(J, block_is[b], block_is[b], MAT_INITIAL_MATRIX, &Jb); genius_assert(!ierr);
+#endif
+        ierr = VecScatterBegin(block_scatter[b], f, block_f[b], INSERT_VALUES, SCATTER_FORWARD); genius_assert(!ierr);
+        ierr = VecScatterEnd  (block_scatter[b], f, block_f[b], INSERT_VALUES, SCATTER_FORWARD); genius_assert(!ierr);
+
+        ierr = KSPSetOperators(block_ksp, Jb, Jb, DIFFERENT_NONZERO_PATTERN); genius_assert(!ierr);
+        ierr = KSPSolve(block_ksp, block_f[b], block_dx[b]); genius_assert(!ierr);
+        ierr = MatDestroy(Jb); genius_assert(!ierr);
+
+        // the Newton step of this variable only
+        ierr = VecSet(y, 0.0); genius_assert(!ierr);
+        ierr = VecScatterBegin(block_scatter[b], block_dx[b], y, INSERT_VALUES, SCATTER_REVERSE); genius_assert(!ierr);
+        ierr = VecScatterEnd  (block_scatter[b], block_dx[b], y, INSERT_VALUES, SCATTER_REVERSE); genius_assert(!ierr);
+
+        // the same damping and projection as the line search of coupled Newton
+        PetscBool changed_y = PETSC_FALSE, changed_w = PETSC_FALSE;
+        sens_line_search_pre_check(x, y, &changed_y);
+        ierr = VecWAXPY(w, -1.0, y, x); genius_assert(!ierr);
+        sens_line_search_post_check(x, y, w, &changed_y, &changed_w);
+        ierr = VecCopy(w, x); genius_assert(!ierr);
+      }
+
+      PetscReal fnorm_sweep;
+      build_petsc_sens_residual(x, f);
+      ierr = VecNorm(f, NORM_2, &fnorm_sweep); genius_assert(!ierr);
+
+      MESSAGE<<"  Gummel sweep " << sweep << ", function norm " << std::scientific << fnorm_sweep << std::endl; RECORD();
+
+      // the decoupled iteration does not converge for this problem, keep the best one for Newton
+      if( fnorm_sweep > fnorm )
+      {
+        ierr = VecCopy(x0, x); genius_assert(!ierr);
+        break;
+      }
+      fnorm = fnorm_sweep;
+    }
+
+    restore_work_vector(y);
+    restore_work_vector(w);
+    restore_work_vector(x0);
+    ierr = KSPDestroy(block_ksp); genius_assert(!ierr);
+
+    STOP_LOG("gummel_presolve()", "FVM_NonlinearSolver");
+  }
+
+  for(unsigned int b=0; b<block_is.size(); ++b)
+  {
+    ierr = ISDestroy(block_is[b]); genius_assert(!ierr);
+    ierr = VecDestroy(block_f[b]); genius_assert(!ierr);
+    ierr = VecDestroy(block_dx[b]); genius_assert(!ierr);
+    ierr = VecScatterDestroy(block_scatter[b]); genius_assert(!ierr);
+  }
+}
+
+
+void FVM_NonlinearSolver::set_petsc_fieldsplit_preconditioner()
+{
+  int ierr = 0;
+
+  // one split for each solution variable, in the order of Gummel iteration
+  const unsigned int n_vars = 6;
+  const SolutionVariable vars[n_vars] = {POTENTIAL, ELECTRON, HOLE, TEMPERATURE, E_TEMP, H_TEMP};
+  std::vector< std::vector<PetscInt> > split_index;
+  variable_split_index(split_index);
+
+  ierr = PCSetType (pc, (char*) PCFIELDSPLIT);  genius_assert(!ierr);
+  // block Gauss-Seidel sweep over the splits, each linear iteration is a Gummel iteration
+  ierr = PCFieldSplitSetType(pc, PC_COMPOSITE_MULTIPLICATIVE);  genius_assert(!ierr);
+
+  unsigned int n_splits = 0;
+  for(unsigned int v=0; v<n_vars; ++v)
+  {
+    // all the processors should set the same splits, even if its local part is empty
+    unsigned int n_split_dofs = split_index[v].size();
+    Parallel::sum(n_split_dofs);
+    if( n_split_dofs == 0 ) continue;
+
+    std::stringstream split_name;
+    split_name << n_splits;
+
+    IS is;
+    PetscInt * index = split_index[v].empty() ? PETSC_NULL : &split_index[v][0];
+#ifdef PETSC_VERSION_DEV
+    ierr = ISCreateGeneral(PETSC_COMM_WORLD, split_index[v].size(), index, PETSC_COPY_VALUES, &is); genius_assert(!ierr);
+    ierr = PCFieldSplitSetIS(pc, split_name.str().c_str(), is);  genius_assert(!ierr);
+#else
+    ierr = ISCreateGeneral(PETSC_COMM_WORLD, split_index[v].size(), index, &is); genius_assert(!ierr);
+    ierr = PCFieldSplitSetIS(pc, is);  genius_assert(!ierr);
+#endif
+    // the split holds its own reference
+    ierr = ISDestroy(is);  genius_assert(!ierr);
+
+    // the sub solver of each split only applies its preconditioner once
+    const std::string prefix = "-fieldsplit_" + split_name.str() + "_";
+    set_solver_option(prefix + "ksp_type", "preonly");
+
+    // elliptic poisson block is best solved by multigrid
+    if( vars[v] == POTENTIAL )
+    {
+#ifdef PETSC_HAVE_LIBHYPRE
+      set_solver_option(prefix + "pc_type", "hypre");
+      set_solver_option(prefix + "pc_hypre_type", "boomeramg");
+      n_splits++;
+      continue;
+#else
+      MESSAGE << "Warning:  no Hypre/BoomerAMG preconditioner configured, use ILU for potential block!" << std::endl;
+      RECORD();
+#endif
+    }
+
+    // the continuity and energy balance blocks are convection dominated, use ILU
+    if (Genius::n_processors() > 1)
+    {
+      set_solver_option(prefix + "pc_type", "bjacobi");
+      set_solver_option(prefix + "sub_pc_type", "ilu");
+      set_solver_option(prefix + "sub_pc_factor_shift_nonzero", "1e-12");
+    }
+    else
+    {
+      set_solver_option(prefix + "pc_type", "ilu");
+      set_solver_option(prefix + "pc_factor_shift_nonzero", "1e-12");
+    }
+    n_splits++;
+  }
+
+  MESSAGE<< "Using field split preconditioner with " << n_splits << " blocks..."<<std::endl;
+  RECORD();
+}
+
+
+void FVM_NonlinearSolver::set_petsc_bordered_preconditioner()
+{
+  int ierr = 0;
+
+  // the bc and extra dofs are numbered after all the node dofs
+  std::vector<PetscInt> node_index, border_index;
+  for(unsigned int i=0; i<n_local_dofs; ++i)
+  {
+    const unsigned int dof = global_offset + i;
+    if( dof < n_global_node_dofs ) node_index.push_back(dof);
+    else                           border_index.push_back(dof);
+  }
+
+  unsigned int n_border_dofs = border_index.size();
+  Parallel::sum(n_border_dofs);
+
+  if( n_border_dofs == 0 )
+  {
+    // nothing to condense
+    MESSAGE << "Warning:  no border dofs, use LU instead of bordered preconditioner!" << std::endl;
+    RECORD();
+    set_petsc_preconditioner_type(SolverSpecify::LU_PRECOND);
+    return;
+  }
+
+  ierr = PCSetType (pc, (char*) PCFIELDSPLIT);  genius_assert(!ierr);
+  ierr = PCFieldSplitSetType(pc, PC_COMPOSITE_SCHUR);  genius_assert(!ierr);
+
+  std::vector<PetscInt> * split_index[2] = {&node_index, &border_index};
+  for(unsigned int v=0; v<2; ++v)
+  {
+    IS is;
+    PetscInt * index = split_index[v]->empty() ? PETSC_NULL : &(*split_index[v])[0];
+#ifdef PETSC_VERSION_DEV
+    ierr = ISCreateGeneral(PETSC_COMM_WORLD, split_index[v]->size(), index, PETSC_COPY_VALUES, &is); genius_assert(!ierr);
+    ierr = PCFieldSplitSetIS(pc, v ? "1" : "0", is);  genius_assert(!ierr);
+#else
+    ierr = ISCreateGeneral(PETSC_COMM_WORLD, split_index[v]->size(), index, &is); genius_assert(!ierr);
+    ierr = PCFieldSplitSetIS(pc, is);  genius_assert(!ierr);
+#endif
+    // the split holds its own reference
+    ierr = ISDestroy(is);  genius_assert(!ierr);
+  }
+
+  // the node block is factorized once, without the dense border rows and columns
+  set_solver_option("-fieldsplit_0_ksp_type", "preonly");
+  if (Genius::n_processors() == 1)
+  {
+    set_solver_option("-fieldsplit_0_pc_type", "lu");
+    set_solver_option("-fieldsplit_0_pc_factor_shift_nonzero", "1e-12");
+  }
+  else
+  {
+#ifdef PETSC_HAVE_MUMPS
+    set_solver_option("-fieldsplit_0_pc_type", "lu");
+    set_solver_option("-fieldsplit_0_pc_factor_mat_solver_package", "mumps");
+#else
+    MESSAGE << "Warning:  no parallel LU preconditioner configured, use ASM for node block!" << std::endl;
+    RECORD();
+    set_solver_option("-fieldsplit_0_pc_type", "asm");
+    set_solver_option("-fieldsplit_0_sub_pc_type", "ilu");
+#endif
+  }
+
+  // the schur complement of the border is a small dense operator applied matrix free,
+  // krylov iterations converge in at most n_border_dofs steps
+  set_solver_option("-fieldsplit_1_ksp_type", "gmres");
+  set_solver_option("-fieldsplit_1_pc_type", "none");
+  set_solver_option("-fieldsplit_1_ksp_rtol", "1e-12");
+
+  MESSAGE<< "Using bordered preconditioner with " << n_border_dofs << " border dofs..."<<std::endl;
+  RECORD();
+}
+
+
+
+unsigned int FVM_NonlinearSolver::build_mg_interpolation(Mat *P)
+{
+#ifdef ENABLE_AMR
+  const MeshBase & mesh = _system.mesh();
+
+  // the weights of each mesh node to the level 0 nodes
+  typedef std::vector< std::pair<unsigned int, Real> > Weights;
+  std::vector<Weights> node_weights(mesh.max_node_id());
+
+  {
+    MeshBase::const_element_iterator el = mesh.level_elements_begin(0);
+    MeshBase::const_element_iterator el_end = mesh.level_elements_end(0);
+    for(; el!=el_end; ++el)
+      for(unsigned int n=0; n<(*el)->n_nodes(); ++n)
+      {
+        const unsigned int id = (*el)->node(n);
+        if( node_weights[id].empty() )
+          node_weights[id].push_back( std::make_pair(id, 1.0) );
+      }
+  }
+
+  // the children nodes are given by the embedding matrix of their parent, level by level
+  bool refined = false;
+  for(unsigned int level=0; ; ++level)
+  {
+    MeshBase::const_element_iterator el = mesh.level_elements_begin(level);
+    MeshBase::const_element_iterator el_end = mesh.level_elements_end(level);
+    if( el == el_end ) break;
+
+    for(; el!=el_end; ++el)
+    {
+      const Elem * parent = *el;
+      if( !parent->has_children() ) continue;
+      refined = true;
+
+      for(unsigned int c=0; c<parent->n_children(); ++c)
+      {
+        const Elem * child = parent->child(c);
+        for(unsigned int nc=0; nc<child->n_nodes(); ++nc)
+        {
+          Weights & w = node_weights[child->node(nc)];
+          if( !w.empty() ) continue;
+
+          std::map<unsigned int, Real> sum;
+          for(unsigned int n=0; n<parent->n_nodes(); ++n)
+          {
+            const Real em = parent->embedding_matrix(c, nc, n);
+            if( em == 0.0 ) continue;
+            const Weights & wp = node_weights[parent->node(n)];
+            for(unsigned int k=0; k<wp.size(); ++k)
+              sum[wp[k].first] += em*wp[k].second;
+          }
+          w.assign(sum.begin(), sum.end());
+        }
+      }
+    }
+  }
+
+  if( !refined ) return 0;
+
+  // the coarse dofs: the dofs of level 0 nodes in each region, then the bc and extra dofs
+  std::vector< std::map<unsigned int, unsigned int> > coarse_offset(_system.n_regions());
+  unsigned int n_coarse_dofs = 0;
+  for(unsigned int r=0; r<_system.n_regions(); ++r)
+  {
+    const SimulationRegion * region = _system.region(r);
+    const unsigned int region_node_dofs = this->node_dofs(region);
+
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+    {
+      const unsigned int id = (*it)->root_node()->id();
+      const Weights & w = node_weights[id];
+      if( w.size() == 1 && w[0].first == id )
+      {
+        coarse_offset[r][id] = n_coarse_dofs;
+        n_coarse_dofs += region_node_dofs;
+      }
+    }
+  }
+  const unsigned int n_border_dofs = n_global_dofs - n_global_node_dofs;
+  const unsigned int coarse_border_offset = n_coarse_dofs;
+  n_coarse_dofs += n_border_dofs;
+
+  // nonzeros of each fine row
+  std::vector<PetscInt> nnz(n_global_dofs, 1);
+  for(unsigned int r=0; r<_system.n_regions(); ++r)
+  {
+    const SimulationRegion * region = _system.region(r);
+    const unsigned int region_node_dofs = this->node_dofs(region);
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+      for(unsigned int i=0; i<region_node_dofs; ++i)
+        nnz[(*it)->global_offset()+i] = std::max(static_cast<size_t>(1), node_weights[(*it)->root_node()->id()].size());
+  }
+
+  PetscErrorCode ierr;
+  ierr = MatCreateSeqAIJ(PETSC_COMM_SELF, n_global_dofs, n_coarse_dofs, 0, &nnz[0], P); genius_assert(!ierr);
+
+  for(unsigned int r=0; r<_system.n_regions(); ++r)
+  {
+    const SimulationRegion * region = _system.region(r);
+    const unsigned int region_node_dofs = this->node_dofs(region);
+
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+    {
+      const Weights & w = node_weights[(*it)->root_node()->id()];
+
+      std::vector<PetscInt>    cols;
+      std::vector<PetscScalar> values;
+      for(unsigned int k=0; k<w.size(); ++k)
+      {
+        // the level 0 node should be in the same region as its descendants
+        std::map<unsigned int, unsigned int>::const_iterator c = coarse_offset[r].find(w[k].first);
+        if( c == coarse_offset[r].end() ) continue;
+        cols.push_back(c->second);
+        values.push_back(w[k].second);
+      }
+      if( cols.empty() ) continue;
+
+      for(unsigned int i=0; i<region_node_dofs; ++i)
+      {
+        PetscInt row = (*it)->global_offset() + i;
+        std::vector<PetscInt> dof_cols(cols);
+        for(unsigned int k=0; k<dof_cols.size(); ++k) dof_cols[k] += i;
+        ierr = MatSetValues(*P, 1, &row, dof_cols.size(), &dof_cols[0], &values[0], INSERT_VALUES); genius_assert(!ierr);
+      }
+    }
+  }
+
+  // bc and extra dofs are kept on the coarse level
+  for(unsigned int i=0; i<n_border_dofs; ++i)
+  {
+    PetscInt row = n_global_node_dofs + i;
+    PetscInt col = coarse_border_offset + i;
+    ierr = MatSetValue(*P, row, col, 1.0, INSERT_VALUES); genius_assert(!ierr);
+  }
+
+  ierr = MatAssemblyBegin(*P, MAT_FINAL_ASSEMBLY); genius_assert(!ierr);
+  ierr = MatAssemblyEnd(*P, MAT_FINAL_ASSEMBLY); genius_assert(!ierr);
+
+  return n_coarse_dofs;
+#else
+  return 0;
+#endif
+}
+
+
+
+void FVM_NonlinearSolver::set_petsc_mg_preconditioner()
+{
+  int ierr = 0;
+
+  Mat P;
+  unsigned int n_coarse_dofs = 0;
+  // the interpolation is built on the serial dof map
+  if (Genius::n_processors() == 1)
+    n_coarse_dofs = build_mg_interpolation(&P);
+
+  if( n_coarse_dofs == 0 )
+  {
+    MESSAGE << "Warning:  multigrid preconditioner requires hierarchical refined mesh on one processor, use ASM instead!" << std::endl;
+    RECORD();
+    set_petsc_preconditioner_type(SolverSpecify::ASM_PRECOND);
+    return;
+  }
+
+  ierr = PCSetType (pc, (char*) PCMG);  genius_assert(!ierr);
+  ierr = PCMGSetLevels(pc, 2, PETSC_NULL);  genius_assert(!ierr);
+  ierr = PCMGSetType(pc, PC_MG_MULTIPLICATIVE);  genius_assert(!ierr);
+#if PETSC_VERSION_GE(3,3,0)
+  ierr = PCMGSetGalerkin(pc, PETSC_TRUE);  genius_assert(!ierr);
+#else
+  ierr = PCMGSetGalerkin(pc);  genius_assert(!ierr);
+#endif
+  ierr = PCMGSetInterpolation(pc, 1, P);  genius_assert(!ierr);
+  // the preconditioner holds its own reference
+  ierr = MatDestroy(P);  genius_assert(!ierr);
+
+  // the jacobian of DDM is not symmetric, smooth by ILU and solve the coarse level directly
+  set_solver_option("-mg_levels_ksp_type", "richardson");
+  set_solver_option("-mg_levels_pc_type", "ilu");
+  set_solver_option("-mg_coarse_ksp_type", "preonly");
+  set_solver_option("-mg_coarse_pc_type", "lu");
+  set_solver_option("-mg_coarse_pc_factor_shift_nonzero", "1e-12");
+
+  MESSAGE<< "Using geometric multigrid preconditioner with " << n_coarse_dofs << " coarse dofs..."<<std::endl;
+  RECORD();
+}
+
+
+
+
+namespace
+{
+  /**
+   * the linear solver strategies of LS=auto
+   */
+  enum AutoLinearSolver {AUTO_DIRECT=0, AUTO_ASM, AUTO_FIELDSPLIT, N_AUTO_LINEAR_SOLVER};
+
+  const char * auto_linear_solver_name[N_AUTO_LINEAR_SOLVER] =
+    {"direct LU", "GMRES with ASM/ILU", "GMRES with field split"};
+
+  /**
+   * linear convergence statistic of each strategy, kept over all the solves of this run
+   */
+  struct AutoLinearSolverHistory
+  {
+    unsigned int n_newton;        // Newton iterations
+    unsigned int n_linear_its;    // linear iterations
+    unsigned int n_linear_failed; // nonlinear solves stopped by linear solver failure
+  };
+
+  AutoLinearSolverHistory auto_linear_solver_history[N_AUTO_LINEAR_SOLVER];
+
+  /**
+   * the strategy is known to be poor: it ever failed, or needs too many linear iterations in average
+   */
+  bool auto_linear_solver_poor(int s)
+  {
+    const AutoLinearSolverHistory & h = auto_linear_solver_history[s];
+    if( h.n_linear_failed ) return true;
+    return h.n_newton && h.n_linear_its > 200*h.n_newton;
+  }
+}
+
+
+
+void FVM_NonlinearSolver::select_auto_linear_solver(SolverSpecify::LinearSolverType &ls, SolverSpecify::PreconditionerType &pc)
+{
+  const unsigned int n_procs = Genius::n_processors();
+  const double dofs_per_processor = static_cast<double>(n_global_dofs)/n_procs;
+  const bool is_3d = _system.mesh().mesh_dimension() == 3;
+
+  // the fill of LU factorization grows much faster on 3D mesh
+  const unsigned int direct_max_dofs = is_3d ? 200000 : 1000000;
+
+  // direct solver package available for this processor number
+  SolverSpecify::LinearSolverType direct = SolverSpecify::INVALID_LINEAR_SOLVER;
+#if defined(PETSC_HAVE_MUMPS)
+  direct = SolverSpecify::MUMPS;
+#elif defined (PETSC_HAVE_LIBSUPERLU_DIST_2)
+  direct = SolverSpecify::SuperLU_DIST;
+#endif
+  if( direct == SolverSpecify::INVALID_LINEAR_SOLVER && n_procs == 1 )
+    direct = SolverSpecify::LU;
+
+  std::stringstream reason;
+  int s;
+  if( direct != SolverSpecify::INVALID_LINEAR_SOLVER && n_global_dofs <= direct_max_dofs )
+  {
+    s = AUTO_DIRECT;
+    reason << n_global_dofs << " dofs";
+  }
+  // one level ASM loses its strength with small subdomains, use physics based blocks instead
+  else if( n_global_dofs <= 2000000 && dofs_per_processor >= 20000 )
+  {
+    s = AUTO_ASM;
+    reason << n_global_dofs << " dofs, " << static_cast<unsigned int>(dofs_per_processor) << " dofs per processor";
+  }
+  else
+  {
+    s = AUTO_FIELDSPLIT;
+    reason << n_global_dofs << " dofs, " << static_cast<unsigned int>(dofs_per_processor) << " dofs per processor";
+  }
+
+  // iterative solver did poorly in previous solves, try a stronger one
+  if( s == AUTO_ASM && auto_linear_solver_poor(AUTO_ASM) )
+  {
+    s = AUTO_FIELDSPLIT;
+    reason << ", ASM/ILU converged poorly before";
+  }
+  if( s == AUTO_FIELDSPLIT && auto_linear_solver_poor(AUTO_FIELDSPLIT) &&
+      direct != SolverSpecify::INVALID_LINEAR_SOLVER && n_global_dofs <= 4*direct_max_dofs )
+  {
+    s = AUTO_DIRECT;
+    reason << ", field split converged poorly before";
+  }
+
+  switch(s)
+  {
+    case AUTO_DIRECT     : ls = direct;              pc = SolverSpecify::LU_PRECOND;         break;
+    case AUTO_ASM        : ls = SolverSpecify::GMRES; pc = SolverSpecify::ASM_PRECOND;        break;
+    case AUTO_FIELDSPLIT : ls = SolverSpecify::GMRES; pc = SolverSpecify::FIELDSPLIT_PRECOND; break;
+  }
+  _auto_linear_solver = s;
+
+  MESSAGE<< "Auto linear solver: " << auto_linear_solver_name[s] << " (" << reason.str() << ")..."<<std::endl;
+  RECORD();
+}
+
+
+
+void FVM_NonlinearSolver::record_auto_linear_solver()
+{
+  PetscInt its, lits;
+  SNESConvergedReason reason;
+  SNESGetIterationNumber(snes, &its);
+  SNESGetLinearSolveIterations(snes, &lits);
+  SNESGetConvergedReason(snes, &reason);
+
+  AutoLinearSolverHistory & h = auto_linear_solver_history[_auto_linear_solver];
+  h.n_newton += its;
+  h.n_linear_its += lits;
+  if( reason == SNES_DIVERGED_LINEAR_SOLVE ) h.n_linear_failed++;
+}
+
+
+
 #ifndef PETSC_VERSION_DEV
 #define SNES_DIVERGED_LINE_SEARCH SNES_DIVERGED_LS_FAILURE
 #endif
 void FVM_NonlinearSolver::sens_solve()
 {
+  // a better start point for coupled Newton when required
+  gummel_presolve();
+
   // do snes solve
+  START_LOG("SNESSolve()", "FVM_NonlinearSolver");
   SNESSolve ( snes, PETSC_NULL, x );
+  STOP_LOG("SNESSolve()", "FVM_NonlinearSolver");
 
   // get the converged reason
   SNESConvergedReason reason;
@@ -939,15 +2255,93 @@ void FVM_NonlinearSolver::sens_solve()
     MESSAGE <<"------> nonlinear solver " << SNESConvergedReasons[reason] <<". Disable Line Search.\n\n\n";
     RECORD();
     SNESLineSearchSet ( snes,SNESLineSearchNo,PETSC_NULL );
+    START_LOG("SNESSolve()", "FVM_NonlinearSolver");
     SNESSolve ( snes, PETSC_NULL, x );
+    STOP_LOG("SNESSolve()", "FVM_NonlinearSolver");
   }
 
+  if( _auto_linear_solver >= 0 )
+    record_auto_linear_solver();
 }
 
 
 
-double FVM_NonlinearSolver::condition_number_of_jacobian_matrix()
+bool FVM_NonlinearSolver::electrode_capacitance(const std::vector<BoundaryCondition *> & electrodes,
+                                                std::vector<std::vector<PetscScalar> > & C)
 {
+  START_LOG("electrode_capacitance()", "FVM_NonlinearSolver");
+
+  const unsigned int n_electrodes = electrodes.size();
+  C.assign(n_electrodes, std::vector<PetscScalar>(n_electrodes, 0.0));
+
+  const BoundaryConditionCollector * bcs = _system.get_bcs();
+
+  Vec f0  = get_work_vector();
+  Vec b   = get_work_vector();
+  Vec dx  = get_work_vector();
+  Vec ldx = get_work_vector(true);
+
+  // residual at the converged solution
+  SNESComputeFunction(snes, x, f0);
+
+  bool converged = true;
+  for(unsigned int j=0; j<n_electrodes; ++j)
+  {
+    // dF/dV_j, the residual is linear in Vapp so the difference is exact up to round off
+    ExternalCircuit * ext_circuit = electrodes[j]->ext_circuit();
+    const PetscScalar Vapp = ext_circuit->Vapp();
+    const PetscScalar dV = 1e-3*PhysicalUnit::V;
+    ext_circuit->Vapp() = Vapp + dV;
+    SNESComputeFunction(snes, x, b);
+    ext_circuit->Vapp() = Vapp;
+
+    // b = -dF/dV_j
+    VecAXPY(b, -1.0, f0);
+    VecScale(b, -1.0/dV);
+
+    // the preconditioner is still the one of last newton step, no new factorization
+    KSPSolve(ksp, b, dx);
+    KSPConvergedReason reason;
+    KSPGetConvergedReason(ksp, &reason);
+    if( reason < 0 )
+    {
+      converged = false;
+      break;
+    }
+
+    // the charge integral needs the ghost nodes
+    VecScatterBegin(scatter, dx, ldx, INSERT_VALUES, SCATTER_FORWARD);
+    VecScatterEnd(scatter, dx, ldx, INSERT_VALUES, SCATTER_FORWARD);
+
+    PetscScalar * ldxx;
+    VecGetArray(ldx, &ldxx);
+    for(unsigned int i=0; i<n_electrodes; ++i)
+      C[i][j] = bcs->local_electrode_charge(electrodes[i], ldxx);
+    VecRestoreArray(ldx, &ldxx);
+  }
+
+  for(unsigned int i=0; i<n_electrodes; ++i)
+    Parallel::sum(C[i]);
+
+  // restore the residual of the converged solution, also the IV of current iteration saved by the bcs
+  SNESComputeFunction(snes, x, f0);
+
+  restore_work_vector(f0);
+  restore_work_vector(b);
+  restore_work_vector(dx);
+  restore_work_vector(ldx, true);
+
+  STOP_LOG("electrode_capacitance()", "FVM_NonlinearSolver");
+
+  return converged;
+}
+
+
+
+double FVM_NonlinearSolver::condition_number_of_jacobian_matrix(bool slepc)
+{
+  if( !slepc ) return condition_number_estimate();
+
 #ifdef HAVE_SLEPC
 
   // SVD solver for largest singular value
@@ -1052,6 +2446,98 @@ double FVM_NonlinearSolver::condition_number_of_jacobian_matrix()
 
 
 
+double FVM_NonlinearSolver::condition_number_estimate()
+{
+  PetscInt n, begin, end;
+  VecGetSize(x, &n);
+  VecGetOwnershipRange(x, &begin, &end);
+
+  PetscReal J_norm;
+  MatNorm(J, NORM_1, &J_norm);
+
+  Vec v = get_work_vector();
+  Vec y = get_work_vector();
+  Vec z = get_work_vector();
+
+  // Hager's iteration for |J^-1|_1, start from the uniform vector
+  VecSet(v, 1.0/n);
+  PetscReal inv_norm = 0.0;
+  PetscInt  j_last = -1;
+  for(unsigned int k=0; k<5; ++k)
+  {
+    PCApply(pc, v, y);
+    PetscReal y_norm;
+    VecNorm(y, NORM_1, &y_norm);
+    if( k>0 && y_norm <= inv_norm ) break;
+    inv_norm = y_norm;
+
+    // z = J^-T sign(y)
+    PetscScalar * yy;
+    VecGetArray(y, &yy);
+    for(PetscInt i=0; i<end-begin; ++i)
+      yy[i] = yy[i] >= 0.0 ? 1.0 : -1.0;
+    VecRestoreArray(y, &yy);
+
+    // not every factor package does transposed solve
+    PetscPushErrorHandler(PetscIgnoreErrorHandler, PETSC_NULL);
+    PetscErrorCode ierr = PCApplyTranspose(pc, y, z);
+    PetscPopErrorHandler();
+    if( ierr ) break;
+
+    PetscScalar ztv;
+    PetscReal   z_max;
+    PetscInt    j;
+    VecDot(z, v, &ztv);
+    VecAbs(z);
+    VecMax(z, &j, &z_max);
+    if( z_max <= ztv || j == j_last ) break;
+
+    // next try the unit vector of the largest gradient
+    VecSet(v, 0.0);
+    VecSetValue(v, j, 1.0, INSERT_VALUES);
+    VecAssemblyBegin(v);
+    VecAssemblyEnd(v);
+    j_last = j;
+  }
+
+  // Higham's alternating sign vector, guards against underestimate
+  PetscScalar * vv;
+  VecGetArray(v, &vv);
+  for(PetscInt i=begin; i<end; ++i)
+    vv[i-begin] = (i%2 ? -1.0 : 1.0)*(1.0 + (n>1 ? double(i)/(n-1) : 0.0));
+  VecRestoreArray(v, &vv);
+  PCApply(pc, v, y);
+  PetscReal alt_norm;
+  VecNorm(y, NORM_1, &alt_norm);
+  inv_norm = std::max(inv_norm, 2*alt_norm/(3*n));
+
+  restore_work_vector(v);
+  restore_work_vector(y);
+  restore_work_vector(z);
+
+  return J_norm*inv_norm;
+}
+
+
+void FVM_NonlinearSolver::compute_singular_values(bool flag)
+{
+  KSPSetComputeSingularValues(ksp, flag ? PETSC_TRUE : PETSC_FALSE);
+}
+
+
+bool FVM_NonlinearSolver::extreme_singular_values(PetscReal & emax, PetscReal & emin)
+{
+  // KSP complains when singular values were not requested before setup
+  PetscPushErrorHandler(PetscIgnoreErrorHandler, PETSC_NULL);
+  PetscErrorCode ierr = KSPComputeExtremeSingularValues(ksp, &emax, &emin);
+  PetscPopErrorHandler();
+
+  // preonly gives -1
+  return !ierr && emin > 0.0;
+}
+
+
+
 void FVM_NonlinearSolver::eigen_value_of_jacobian_matrix()
 {
 #ifdef HAVE_SLEPC
@@ -20,7 +20,9 @@
 /********************************************************************************/
 
 
+#include <map>
 #include <numeric>
+#include <algorithm>
 
 #include "boundary_info.h"
 #include "fvm_pde_solver.h"
@@ -45,6 +47,11 @@ void FVM_PDESolver::set_serial_dof_map()
     }
   }
 
+  // the node of slave periodic boundary -> the node of master periodic boundary
+  std::map<const Node *, const Node *> periodic_nodes;
+  if(_system.get_bcs()!=NULL)
+    periodic_nodes = _system.get_bcs()->periodic_node_map();
+
   // the local index of dof
   n_local_dofs = 0;
 
@@ -60,12 +67,31 @@ void FVM_PDESolver::set_serial_dof_map()
     {
       FVM_Node * fvm_node = (*it);
 
+      // the periodic node takes the dofs of its master later
+      std::map<const Node *, const Node *>::const_iterator periodic_it = periodic_nodes.find(fvm_node->root_node());
+      if( periodic_it != periodic_nodes.end() && region->region_fvm_node(periodic_it->second) != NULL ) continue;
+
       fvm_node->set_local_offset(n_local_dofs);
       fvm_node->set_global_offset(n_local_dofs);
       n_local_dofs += region_node_dofs;
     }
   }
 
+  // the periodic node shares the dofs of master node in the same region,
+  // all the solvers then add the flux of both nodes into the same equation
+  std::map<const Node *, const Node *>::const_iterator periodic_it = periodic_nodes.begin();
+  for(; periodic_it != periodic_nodes.end(); ++periodic_it)
+    for(unsigned int n=0; n<_system.n_regions(); ++n)
+    {
+      SimulationRegion * region = _system.region(n);
+      FVM_Node * fvm_node = region->region_fvm_node(periodic_it->first);
+      const FVM_Node * master_fvm_node = region->region_fvm_node(periodic_it->second);
+      if( fvm_node == NULL || master_fvm_node == NULL ) continue;
+
+      fvm_node->set_local_offset(master_fvm_node->local_offset());
+      fvm_node->set_global_offset(master_fvm_node->global_offset());
+    }
+
   // the total node's dof number
   n_global_node_dofs = n_local_dofs;
 
@@ -130,8 +156,9 @@ void FVM_PDESolver::set_serial_dof_map()
 
   // compute the nonzero pattern of matrix
   // search for all the regions...
-  n_nz.resize(n_local_dofs, 0);
-  n_oz.resize(n_local_dofs, 0); // always 0
+  // the rows of periodic node are accumulated, start from zero
+  n_nz.assign(n_local_dofs, 0);
+  n_oz.assign(n_local_dofs, 0); // always 0
 
   for(unsigned int n=0; n<_system.n_regions(); ++n)
   {
@@ -165,10 +192,10 @@ void FVM_PDESolver::set_serial_dof_map()
       }
 
 
-      // set the nonzero pattern
+      // set the nonzero pattern, the row of periodic node is shared with its master
       for(unsigned int i=0; i<local_node_dofs; ++i)
       {
-        n_nz[local_offset + i] = node_dofs-off_processor_node_dofs;
+        n_nz[local_offset + i] = std::min(n_nz[local_offset + i] + node_dofs-off_processor_node_dofs, n_local_dofs);
       }
 
       // not a boundary fvm_node? that's all
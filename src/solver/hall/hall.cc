@@ -544,19 +544,18 @@ PetscScalar HallSolver::LTE_norm()
 void HallSolver::error_norm()
 {
   PetscScalar    *xx;
-  PetscScalar    *ff;
+  const PetscScalar *ff;
 
   // scatte global solution vector x to local vector lx
   // this is not necessary since it had already done in function evaluation
   //VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
   //VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
 
-  // scatte global function vector f to local vector lf
-  VecScatterBegin(scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
+  // only the on processor dofs are involved, read them from the global function vector f
+  // directly (indexed by global offset) instead of scattering f to local vector lf
 
   VecGetArray(lx, &xx);  // solution value
-  VecGetArray(lf, &ff);  // function value
+  VecGetArrayRead(f, &ff);   // function value
 
   // do clear
   potential_norm        = 0;
@@ -586,6 +585,7 @@ void HallSolver::error_norm()
       const FVM_Node * fvm_node = *it;
 
       unsigned int offset = fvm_node->local_offset();
+      unsigned int f_offset = fvm_node->global_offset() - global_offset;
 
       switch ( region->type() )
       {
@@ -595,22 +595,22 @@ void HallSolver::error_norm()
             electron_norm  += xx[offset+1]*xx[offset+1];
             hole_norm      += xx[offset+2]*xx[offset+2];
 
-            poisson_norm         += ff[offset+0]*ff[offset+0];
-            elec_continuity_norm += ff[offset+1]*ff[offset+1];
-            hole_continuity_norm += ff[offset+2]*ff[offset+2];
+            poisson_norm         += ff[f_offset+0]*ff[f_offset+0];
+            elec_continuity_norm += ff[f_offset+1]*ff[f_offset+1];
+            hole_continuity_norm += ff[f_offset+2]*ff[f_offset+2];
             break;
           }
           case InsulatorRegion :
           {
             potential_norm += xx[offset]*xx[offset];
-            poisson_norm   += ff[offset]*ff[offset];
+            poisson_norm   += ff[f_offset]*ff[f_offset];
             break;
           }
           case ElectrodeRegion :
           case MetalRegion     :
           {
             potential_norm += xx[offset]*xx[offset];
-            poisson_norm   += ff[offset]*ff[offset];
+            poisson_norm   += ff[f_offset]*ff[f_offset];
             break;
           }
           case VacuumRegion:
@@ -625,39 +625,43 @@ void HallSolver::error_norm()
     {
       const BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
       unsigned int offset = bc->local_offset();
+      unsigned int f_offset = bc->global_offset() - global_offset;
       if( offset != invalid_uint )
       {
         potential_norm += xx[offset]*xx[offset];
-        electrode_norm += ff[offset]*ff[offset];
+        electrode_norm += ff[f_offset]*ff[f_offset];
       }
     }
 
 
 
   // sum of variable value on all processors
-  parallel_only();
-  Parallel::sum(potential_norm);
-  Parallel::sum(electron_norm);
-  Parallel::sum(hole_norm);
+  std::vector<PetscScalar> norm_buffer;
 
-  Parallel::sum(poisson_norm);
-  Parallel::sum(elec_continuity_norm);
-  Parallel::sum(hole_continuity_norm);
-  Parallel::sum(electrode_norm);
+  norm_buffer.push_back(potential_norm);
+  norm_buffer.push_back(electron_norm);
+  norm_buffer.push_back(hole_norm);
+
+  norm_buffer.push_back(poisson_norm);
+  norm_buffer.push_back(elec_continuity_norm);
+  norm_buffer.push_back(hole_continuity_norm);
+  norm_buffer.push_back(electrode_norm);
+
+  Parallel::sum(norm_buffer);
 
   // sqrt to get L2 norm
-  potential_norm = sqrt(potential_norm);
-  electron_norm  = sqrt(electron_norm);
-  hole_norm      = sqrt(hole_norm);
+  potential_norm = sqrt(norm_buffer[0]);
+  electron_norm  = sqrt(norm_buffer[1]);
+  hole_norm      = sqrt(norm_buffer[2]);
 
-  poisson_norm         = sqrt(poisson_norm);
-  elec_continuity_norm = sqrt(elec_continuity_norm);
-  hole_continuity_norm = sqrt(hole_continuity_norm);
-  electrode_norm       = sqrt(electrode_norm);
+  poisson_norm         = sqrt(norm_buffer[3]);
+  elec_continuity_norm = sqrt(norm_buffer[4]);
+  hole_continuity_norm = sqrt(norm_buffer[5]);
+  electrode_norm       = sqrt(norm_buffer[6]);
 
 
   VecRestoreArray(lx, &xx);
-  VecRestoreArray(lf, &ff);
+  VecRestoreArrayRead(f, &ff);
 
 }
 
@@ -739,8 +743,8 @@ void HallSolver::build_petsc_sens_residual(Vec x, Vec r)
     bc->DDM1_Function_Preprocess(r, src_row, dst_row, clear_row);
   }
   //add source rows to destination rows, and clear rows
-  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row);
-  add_value_flag = NOT_SET_VALUES;
+  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
 
   // evaluate governing equations of DDML1 for all the boundaries
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
@@ -749,6 +753,9 @@ void HallSolver::build_petsc_sens_residual(Vec x, Vec r)
     bc->DDM1_Function(lxx, r, add_value_flag);
   }
 
+  // the external circuit of all the electrodes
+  _system.get_bcs()->electrode_circuit_function(lxx, r, add_value_flag);
+
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
@@ -760,20 +767,9 @@ void HallSolver::build_petsc_sens_residual(Vec x, Vec r)
   VecAssemblyBegin(r);
   VecAssemblyEnd(r);
 
-  // scale the function vec
-  PetscScalar *ff,*scale;
-  // get function array and scale array.
-  VecGetArray(r, &ff);
-  // L is the scaling vector, the Jacobian evaluate function may dynamically update it.
-  VecGetArray(L, &scale);
-
-  // scale it!
-  for(unsigned int n=0; n<n_local_dofs; n++)
-    ff[n] *= scale[n];
-
-  // restore back
-  VecRestoreArray(r, &ff);
-  VecRestoreArray(L, &scale);
+  // scale the function vec, L is the scaling vector, the Jacobian evaluate function may dynamically update it.
+  // a vector operation does not pull device vector types back to host memory
+  VecPointwiseMult(r, r, L);
 
   STOP_LOG("DDM1Solver_Residual()", "HallSolver");
 
@@ -864,18 +860,19 @@ void HallSolver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
     BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
     bc->DDM1_Jacobian_Preprocess(&J, src_row, dst_row, clear_row);
   }
-  //add source rows to destination rows
-  PetscUtils::MatAddRowToRow(J, src_row, dst_row);
-  // clear row
-  PetscUtils::MatZeroRows(J, clear_row.size(), clear_row.empty() ? NULL : &clear_row[0], 0.0);
+  //add source rows to destination rows, and clear rows
+  PetscUtils::MatAddClearRow(J, src_row, dst_row, clear_row, global_clear_rows(clear_row));
 
-  add_value_flag = NOT_SET_VALUES;
+  add_value_flag = ADD_VALUES;
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
   {
     BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
     bc->DDM1_Jacobian(lxx, &J, add_value_flag);
   }
 
+  // the external circuit of all the electrodes
+  _system.get_bcs()->electrode_circuit_jacobian(&J, add_value_flag);
+
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
 #endif
@@ -145,7 +145,8 @@ void HDMSolver::solve_equ()
   bool converg = false;
   do
   {
-    local_time_advance(steps, 1.0/3.0);
+    // only the steady state is wanted, each node advances with its own time step
+    local_time_advance(steps, 1.0/3.0, true);
     update_solution();
     // call post_solve_process
     this->post_solve_process();
@@ -164,23 +165,26 @@ void HDMSolver::solve_transient()
 
 
 
-void HDMSolver::local_time_advance(int step, Real alpha)
+void HDMSolver::local_time_advance(int step, Real alpha, bool local_dt)
 {
-  // save current solution to x_prev
-  VecCopy(x, x_prev);
-
   PetscScalar *lxx, *ltt;
 
   // scatte global solution vector x to local vector lx
   VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
 
-  // get PetscScalar array contains solution from local solution vector lx
-  VecGetArray(lx, &lxx);
+  // the local work is done while the ghost values are on the way
+
+  // save current solution to x_prev
+  VecCopy(x, x_prev);
 
   VecZeroEntries(f);
   VecZeroEntries(t);
 
+  VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
+
+  // get PetscScalar array contains solution from local solution vector lx
+  VecGetArray(lx, &lxx);
+
   // build flux, compute local time step
   FVM_Node::set_solver_index(0);
   for(unsigned int n=0; n<_system.n_regions(); n++)
@@ -206,12 +210,13 @@ void HDMSolver::local_time_advance(int step, Real alpha)
   VecAssemblyEnd(f);
   VecAssemblyEnd(t);
 
-  //global time step
-
+  // the time step of each node is limited by the CFL condition of its own edges,
+  // a time accurate advance takes the smallest one as global time step
   PetscScalar dt;
   PetscInt p;
   VecMin(t, &p, &dt);
-  VecSet(t, dt);
+  if( !local_dt )
+    VecSet(t, dt);
 
   SolverSpecify::clock += dt;
 
@@ -103,6 +103,7 @@ void NeumannBC::HDM_Boundary( const PetscScalar * x, Vec flux, InsertMode &  )
 
           const PetscScalar mn = semi_region->material()->band->EffecElecMass(T_external());
           const PetscScalar mp = semi_region->material()->band->EffecHoleMass(T_external());
+          const PetscScalar kT = kb*T_external();
 
           // first, find the norm vector
           const VectorValue<Real> & norm = fvm_node->norm();
@@ -134,8 +135,8 @@ void NeumannBC::HDM_Boundary( const PetscScalar * x, Vec flux, InsertMode &  )
             HDMVector Un2(&x[neigbor_node->local_offset()]);   Un2.mirror(norm);
             HDMVector Up2(&x[neigbor_node->local_offset()+4]); Up2.mirror(norm);
 
-            HDMVector fn = AUSM_if_flux(Un1, Un2, mn, kb, d, S, dir, local_dt1);
-            HDMVector fp = AUSM_if_flux(Up1, Up2, mp, kb, d, S, dir, local_dt2);
+            HDMVector fn = AUSM_if_flux(Un1, Un2, mn, kT, d, S, dir, local_dt1);
+            HDMVector fp = AUSM_if_flux(Up1, Up2, mp, kT, d, S, dir, local_dt2);
 
             VecSetValues(flux, 4, &loc[0], &(fn[0]), ADD_VALUES);
             VecSetValues(flux, 4, &loc[4], &(fp[0]), ADD_VALUES);
@@ -19,6 +19,7 @@
 /*                                                                              */
 /********************************************************************************/
 
+#include "genius_env.h"
 #include "node.h"
 #include "elem.h"
 #include "simulation_system.h"
@@ -26,7 +27,7 @@
 #include "solver_specify.h"
 
 #include "hdm_flux.h"
-#include <TNT/jama_lu.h>
+#include "dense_matrix_fixed.h"
 
 using PhysicalUnit::kb;
 using PhysicalUnit::e;
@@ -126,46 +127,97 @@ void SemiconductorSimulationRegion::HDM_Flux(const PetscScalar * x, Vec flux, Ve
   const PetscScalar mn = mt->band->EffecElecMass(T_external());
   const PetscScalar mp = mt->band->EffecHoleMass(T_external());
 
-  const_processor_node_iterator node_it = on_processor_nodes_begin();
-  const_processor_node_iterator node_it_end = on_processor_nodes_end();
-  for(; node_it!=node_it_end; ++node_it)
+  // the numerical flux is conservative, F(U1,U2,n) = -F(U2,U1,-n), so it is
+  // evaluated once per edge and added to node 1, subtracted from node 2.
+  // the edge loop only reads the solution and writes the slot of its own edge,
+  // so it can be shared by threads without conflict.
+  const EdgeArrays & edge_data = edge_arrays();
+  const int n_edges = n_edge();
+
+  std::vector<int> offset(on_local_nodes_end() - on_local_nodes_begin());
   {
-    const FVM_Node * node = *node_it;
+    const_local_node_iterator node_it = on_local_nodes_begin();
+    for(unsigned int k=0; k<offset.size(); ++k, ++node_it)
+      offset[k] = (*node_it)->local_offset();
+  }
 
-    Real dt=1e38;
-    PetscInt loc[8];
-    for(int i=0; i<8; ++i)
-      loc[i] = node->global_offset() + i;
+  std::vector<PetscScalar> edge_flux(8*n_edges, 0.0);
+  std::vector<Real>        edge_dt(n_edges, 1e38);
 
-    HDMVector Un1(&x[node->local_offset()]);
-    HDMVector Up1(&x[node->local_offset()+4]);
+#pragma omp parallel for schedule(static) num_threads(Genius::n_threads())
+  for(int i=0; i<n_edges; ++i)
+  {
+    const unsigned int k1 = edge_data.node1[i];
+    const unsigned int k2 = edge_data.node2[i];
+    if( k1 == invalid_uint || k2 == invalid_uint ) continue;
 
+    const std::pair<FVM_Node *, FVM_Node *> & edge = *(edges_begin() + i);
+    const VectorValue<double> dir = (*(edge.second->root_node()) - *(edge.first->root_node())).unit();
+    const Real d = edge_data.length[i];
+    const Real S = edge_data.area[i];
 
-    FVM_Node::fvm_neighbor_node_iterator  neighbor_begin = node->neighbor_node_begin();
-    FVM_Node::fvm_neighbor_node_iterator  neighbor_end = node->neighbor_node_end();
-    for(; neighbor_begin!=neighbor_end; ++neighbor_begin )
+    HDMVector Un1(&x[offset[k1]]);
+    HDMVector Up1(&x[offset[k1]+4]);
+    HDMVector Un2(&x[offset[k2]]);
+    HDMVector Up2(&x[offset[k2]+4]);
+
+    PetscScalar local_dt1, local_dt2;
+    HDMVector fn = AUSM_if_flux(Un1, Un2, mn, kT, d, S, dir, local_dt1);
+    HDMVector fp = AUSM_if_flux(Up1, Up2, mp, kT, d, S, dir, local_dt2);
+
+    for(int v=0; v<4; ++v)
     {
-      const FVM_Node * neigbor_node = (*neighbor_begin).second;
-      Real d = (*(node->root_node()) - *(neigbor_node->root_node())).size();
-      Real S = node->cv_surface_area(neigbor_node->root_node());
-      VectorValue<double> dir = (*(neigbor_node->root_node()) - *(node->root_node())).unit();
-      PetscScalar local_dt1, local_dt2;
+      edge_flux[8*i+v]   = fn[v];
+      edge_flux[8*i+4+v] = fp[v];
+    }
+    edge_dt[i] = std::min(local_dt1, local_dt2);
+  }
 
-      HDMVector Un2(&x[neigbor_node->local_offset()]);
-      HDMVector Up2(&x[neigbor_node->local_offset()+4]);
+  // gather the edge flux and time step to the nodes, in edge order
+  std::vector<PetscScalar> node_flux(8*offset.size(), 0.0);
+  std::vector<Real>        node_dt(offset.size(), 1e38);
+  for(int i=0; i<n_edges; ++i)
+  {
+    const unsigned int k1 = edge_data.node1[i];
+    const unsigned int k2 = edge_data.node2[i];
+    if( k1 == invalid_uint || k2 == invalid_uint ) continue;
+
+    for(int v=0; v<8; ++v)
+    {
+      node_flux[8*k1+v] += edge_flux[8*i+v];
+      node_flux[8*k2+v] -= edge_flux[8*i+v];
+    }
+    node_dt[k1] = std::min(node_dt[k1], edge_dt[i]);
+    node_dt[k2] = std::min(node_dt[k2], edge_dt[i]);
+  }
 
-      HDMVector fn = AUSM_if_flux(Un1, Un2, mn, kb, d, S, dir, local_dt1);
-      HDMVector fp = AUSM_if_flux(Up1, Up2, mp, kb, d, S, dir, local_dt2);
+  // only the on processor nodes are written, by one call for each vector
+  std::vector<PetscInt>    index;
+  std::vector<PetscScalar> flux_value;
+  std::vector<PetscScalar> dt_value;
+  index.reserve(8*n_node());
+  flux_value.reserve(8*n_node());
+  dt_value.reserve(8*n_node());
 
-      VecSetValues(flux, 4, &loc[0], &(fn[0]), ADD_VALUES);
-      VecSetValues(flux, 4, &loc[4], &(fp[0]), ADD_VALUES);
+  const_local_node_iterator node_it = on_local_nodes_begin();
+  for(unsigned int k=0; k<offset.size(); ++k, ++node_it)
+  {
+    const FVM_Node * node = *node_it;
+    if( !node->on_processor() ) continue;
 
-      dt = std::min(dt, std::min(local_dt1, local_dt2));
+    for(int v=0; v<8; ++v)
+    {
+      index.push_back(node->global_offset() + v);
+      flux_value.push_back(node_flux[8*k+v]);
+      dt_value.push_back(node_dt[k]);
     }
-    std::vector<PetscScalar> dt_vector(8, dt);
-    VecSetValues(t, 8, &loc[0], &dt_vector[0], INSERT_VALUES);
   }
 
+  if( index.size() )
+  {
+    VecSetValues(flux, index.size(), &index[0], &flux_value[0], ADD_VALUES);
+    VecSetValues(t, index.size(), &index[0], &dt_value[0], INSERT_VALUES);
+  }
 
 #if defined(HAVE_FENV_H) && defined(DEBUG)
   genius_assert( !fetestexcept(FE_INVALID) );
@@ -180,9 +232,6 @@ void SemiconductorSimulationRegion::HDM_Source(const PetscScalar * lx, const Pet
   const PetscScalar mp = mt->band->EffecHoleMass(T);
   const PetscScalar damping_density = 1e17*std::pow(cm, -3);
 
-  TNT::Array2D<Real> I(4, 4, 0.0);
-  I[0][0]=I[1][1]=I[2][2]=I[3][3]=1.0;
-
   const_processor_node_iterator node_it = on_processor_nodes_begin();
   const_processor_node_iterator node_it_end = on_processor_nodes_end();
   for(; node_it!=node_it_end; ++node_it)
@@ -209,57 +258,59 @@ void SemiconductorSimulationRegion::HDM_Source(const PetscScalar * lx, const Pet
     PetscScalar taop = mp*mup/e;
 
     {
-      TNT::Array2D<Real> An (4, 4, 0.0);
-      TNT::Array1D<Real> bn (4);
-      TNT::Array1D<Real> rn (4);
-
-      An[0][0] = -R/n;
-      An[1][0] = -node_data->E()(0);
-      An[1][1] = -1/taon;
-      An[2][0] = -node_data->E()(1);
-      An[2][2] = -1/taon;
-      An[3][0] = -node_data->E()(2);
-      An[3][3] = -1/taon;
-
-      bn[0] = lx[node->local_offset()+0];
-      bn[1] = lx[node->local_offset()+1];
-      bn[2] = lx[node->local_offset()+2];
-      bn[3] = lx[node->local_offset()+3];
-
-      rn = dt*(An*bn);
-      An = I - dt*An;
-
-      JAMA::LU<Real> solver(An);
-      TNT::Array1D<Real> dx = solver.solve(rn);
+      DenseMatrix4 An(0.0);
+      DenseVector4 bn, rn, dx;
+
+      An(0,0) = -R/n;
+      An(1,0) = -node_data->E()(0);
+      An(1,1) = -1/taon;
+      An(2,0) = -node_data->E()(1);
+      An(2,2) = -1/taon;
+      An(3,0) = -node_data->E()(2);
+      An(3,3) = -1/taon;
+
+      bn(0) = lx[node->local_offset()+0];
+      bn(1) = lx[node->local_offset()+1];
+      bn(2) = lx[node->local_offset()+2];
+      bn(3) = lx[node->local_offset()+3];
+
+      An.vector_mult(rn, bn);
+      rn.scale(dt);
+      // I - dt*A
+      An.scale(-dt);
+      for(unsigned int i=0; i<4; ++i) An(i,i) += 1.0;
+
+      An.lu_solve(rn, dx);
       //dx = 0.1*dx;
-      VecSetValues(x, 4, &loc[0], &dx[0], ADD_VALUES);
+      VecSetValues(x, 4, &loc[0], dx.get_values(), ADD_VALUES);
     }
 
     {
-      TNT::Array2D<Real> Ap (4, 4, 0.0);
-      TNT::Array1D<Real> bp (4);
-      TNT::Array1D<Real> rp (4);
-
-      Ap[0][0] = -R/p;
-      Ap[1][0] = node_data->E()(0);
-      Ap[1][1] = -1/taop;
-      Ap[2][0] = node_data->E()(1);
-      Ap[2][2] = -1/taop;
-      Ap[3][0] = node_data->E()(2);
-      Ap[3][3] = -1/taop;
-
-      bp[0] = lx[node->local_offset()+4];
-      bp[1] = lx[node->local_offset()+5];
-      bp[2] = lx[node->local_offset()+6];
-      bp[3] = lx[node->local_offset()+7];
-
-      rp = dt*(Ap*bp);
-      Ap = I - dt*Ap;
-
-      JAMA::LU<Real> solver(Ap);
-      TNT::Array1D<Real> dx = solver.solve(rp);
+      DenseMatrix4 Ap(0.0);
+      DenseVector4 bp, rp, dx;
+
+      Ap(0,0) = -R/p;
+      Ap(1,0) = node_data->E()(0);
+      Ap(1,1) = -1/taop;
+      Ap(2,0) = node_data->E()(1);
+      Ap(2,2) = -1/taop;
+      Ap(3,0) = node_data->E()(2);
+      Ap(3,3) = -1/taop;
+
+      bp(0) = lx[node->local_offset()+4];
+      bp(1) = lx[node->local_offset()+5];
+      bp(2) = lx[node->local_offset()+6];
+      bp(3) = lx[node->local_offset()+7];
+
+      Ap.vector_mult(rp, bp);
+      rp.scale(dt);
+      // I - dt*A
+      Ap.scale(-dt);
+      for(unsigned int i=0; i<4; ++i) Ap(i,i) += 1.0;
+
+      Ap.lu_solve(rp, dx);
       //dx = 0.1*dx;
-      VecSetValues(x, 4, &loc[4], &dx[0], ADD_VALUES);
+      VecSetValues(x, 4, &loc[4], dx.get_values(), ADD_VALUES);
     }
   }
 
@@ -54,6 +54,18 @@ int LinearPoissonSolver::create_solver()
   // build the matrix here
   build_matrix ( A, A );
 
+  // the operator only depends on the mesh and material, it is never rebuilt.
+  // factorize it (or build the preconditioner) here once, the later solves reuse it
+  KSPSetOperators ( ksp, A, A, SAME_PRECONDITIONER );
+  KSPSetUp ( ksp );
+
+  // iterative solvers selected from command line start from the last potential.
+  // preonly refuses a nonzero initial guess
+  PetscBool preonly;
+  PetscTypeCompare ( (PetscObject)ksp, KSPPREONLY, &preonly );
+  if ( !preonly )
+    KSPSetInitialGuessNonzero ( ksp, PETSC_TRUE );
+
   return 0;
 }
 
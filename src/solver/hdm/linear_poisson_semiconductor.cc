@@ -143,7 +143,7 @@ void SemiconductorSimulationRegion::LinearPoissin_Matrix(Mat A, InsertMode &add_
   add_value_flag = ADD_VALUES;
 }
 
-#include <TNT/jama_lu.h>
+#include "dense_matrix_fixed.h"
 void SemiconductorSimulationRegion::LinearPoissin_Update_Solution(const PetscScalar * x)
 {
   PetscScalar damping_density = 1e17*std::pow(cm, -3);
@@ -181,8 +181,8 @@ void SemiconductorSimulationRegion::LinearPoissin_Update_Solution(const PetscSca
 
   // calculate E with least squares
   {
-    TNT::Array2D<Real> A (3, 3, 0.0);
-    TNT::Array1D<Real> r (3, 0.0);
+    DenseMatrix3 A;
+    DenseVector3 r, dphi;
 
     processor_node_iterator node_it = on_processor_nodes_begin();
     processor_node_iterator node_it_end = on_processor_nodes_end();
@@ -222,21 +222,20 @@ void SemiconductorSimulationRegion::LinearPoissin_Update_Solution(const PetscSca
       // so we set it to 1.0
       if(fabs(f)<1e-6) f=1.0;
 
-      A[0][0] = a; A[0][1] = b; A[0][2] = c;
-      A[1][0] = b; A[1][1] = d; A[1][2] = e;
-      A[2][0] = c; A[2][1] = e; A[2][2] = f;
+      A(0,0) = a; A(0,1) = b; A(0,2) = c;
+      A(1,0) = b; A(1,1) = d; A(1,2) = e;
+      A(2,0) = c; A(2,1) = e; A(2,2) = f;
 
-      r[0] = r1;
-      r[1] = r2;
-      r[2] = r3;
+      r(0) = r1;
+      r(1) = r2;
+      r(2) = r3;
 
-      JAMA::LU<Real> solver(A);
-      TNT::Array1D<Real> dphi = solver.solve(r);
+      A.lu_solve(r, dphi);
 
       //PetscScalar carrier = node_data->n() + node_data->p();
       //PetscScalar damping = carrier > damping_density ? damping_density/carrier : 1.0;
 
-      node_data->E() = -VectorValue<PetscScalar>(dphi[0], dphi[1], dphi[2]);
+      node_data->E() = -VectorValue<PetscScalar>(dphi(0), dphi(1), dphi(2));
 
     }
   }
@@ -577,20 +577,19 @@ PetscScalar MixA1Solver::LTE_norm()
 void MixA1Solver::error_norm()
 {
   PetscScalar    *xx;
-  PetscScalar    *ff;
+  const PetscScalar *ff;
 
   // scatte global solution vector x to local vector lx
   // this is not necessary since it had already done in function evaluation
   //VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
   //VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
 
-  // scatte global function vector f to local vector lf
-  VecScatterBegin(scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
+  // only the on processor dofs are involved, read them from the global function vector f
+  // directly (indexed by global offset) instead of scattering f to local vector lf
 
 
   VecGetArray(lx, &xx);  // solution value
-  VecGetArray(lf, &ff);  // function value
+  VecGetArrayRead(f, &ff);   // function value
 
   // do clear
   potential_norm        = 0;
@@ -620,6 +619,7 @@ void MixA1Solver::error_norm()
       const FVM_Node * fvm_node = *it;
 
       unsigned int offset = fvm_node->local_offset();
+      unsigned int f_offset = fvm_node->global_offset() - global_offset;
 
       switch ( region->type() )
       {
@@ -629,27 +629,27 @@ void MixA1Solver::error_norm()
             electron_norm  += xx[offset+1]*xx[offset+1];
             hole_norm      += xx[offset+2]*xx[offset+2];
 
-            poisson_norm         += ff[offset+0]*ff[offset+0];
-            elec_continuity_norm += ff[offset+1]*ff[offset+1];
-            hole_continuity_norm += ff[offset+2]*ff[offset+2];
+            poisson_norm         += ff[f_offset+0]*ff[f_offset+0];
+            elec_continuity_norm += ff[f_offset+1]*ff[f_offset+1];
+            hole_continuity_norm += ff[f_offset+2]*ff[f_offset+2];
             break;
           }
           case InsulatorRegion :
           {
             potential_norm += xx[offset]*xx[offset];
-            poisson_norm   += ff[offset]*ff[offset];
+            poisson_norm   += ff[f_offset]*ff[f_offset];
             break;
           }
           case ElectrodeRegion :
           {
             potential_norm += xx[offset]*xx[offset];
-            poisson_norm   += ff[offset]*ff[offset];
+            poisson_norm   += ff[f_offset]*ff[f_offset];
             break;
           }
           case MetalRegion :
           {
             potential_norm += xx[offset]*xx[offset];
-            poisson_norm   += ff[offset]*ff[offset];
+            poisson_norm   += ff[f_offset]*ff[f_offset];
             break;
           }
           case VacuumRegion:
@@ -673,8 +673,13 @@ void MixA1Solver::error_norm()
   norm_buffer.push_back(elec_continuity_norm);
   norm_buffer.push_back(hole_continuity_norm);
 
+  // the circuit residual is only computed on the last processor, it is zero on the others
+  norm_buffer.push_back(electrode_norm);
+
   Parallel::sum(norm_buffer);
 
+  electrode_norm = norm_buffer.back();
+
   // sqrt to get L2 norm
   potential_norm = sqrt(norm_buffer[0]);
   electron_norm  = sqrt(norm_buffer[1]);
@@ -684,11 +689,10 @@ void MixA1Solver::error_norm()
   elec_continuity_norm = sqrt(norm_buffer[4]);
   hole_continuity_norm = sqrt(norm_buffer[5]);
 
-  Parallel::broadcast(electrode_norm, Genius::last_processor_id());
 
 
   VecRestoreArray(lx, &xx);
-  VecRestoreArray(lf, &ff);
+  VecRestoreArrayRead(f, &ff);
 
 }
 
@@ -775,8 +779,8 @@ void MixA1Solver::build_petsc_sens_residual(Vec x, Vec r)
     bc->MixA_DDM1_Function_Preprocess(r, src_row, dst_row, clear_row);
   }
   //add source rows to destination rows, and clear rows
-  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row);
-  add_value_flag = NOT_SET_VALUES;
+  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
 
 
   // evaluate governing equations of MixA1 for all the boundaries
@@ -799,20 +803,9 @@ void MixA1Solver::build_petsc_sens_residual(Vec x, Vec r)
   VecAssemblyBegin(r);
   VecAssemblyEnd(r);
 
-  // scale the function vec
-  PetscScalar *ff,*scale;
-  // get function array and scale array.
-  VecGetArray(r, &ff);
-  // L is the scaling vector, the Jacobian evaluate function may dynamically update it.
-  VecGetArray(L, &scale);
-
-  // scale it!
-  for(unsigned int n=0; n<n_local_dofs; n++)
-    ff[n] *= scale[n];
-
-  // restore back
-  VecRestoreArray(r, &ff);
-  VecRestoreArray(L, &scale);
+  // scale the function vec, L is the scaling vector, the Jacobian evaluate function may dynamically update it.
+  // a vector operation does not pull device vector types back to host memory
+  VecPointwiseMult(r, r, L);
 
   STOP_LOG("MixA1Solver_Residual()", "MixA1Solver");
 
@@ -902,12 +895,10 @@ void MixA1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
     BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
     bc->MixA_DDM1_Jacobian_Preprocess(&J, src_row, dst_row, clear_row);
   }
-  //add source rows to destination rows
-  PetscUtils::MatAddRowToRow(J, src_row, dst_row);
-  // clear row
-  PetscUtils::MatZeroRows(J, clear_row.size(), clear_row.empty() ? NULL : &clear_row[0], 0.0);
+  //add source rows to destination rows, and clear rows
+  PetscUtils::MatAddClearRow(J, src_row, dst_row, clear_row, global_clear_rows(clear_row));
 
-  add_value_flag = NOT_SET_VALUES;
+  add_value_flag = ADD_VALUES;
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
   {
     BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
@@ -941,7 +932,11 @@ void MixA1Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   //getchar();
 
   if(!jacobian_matrix_first_assemble)
+  {
     jacobian_matrix_first_assemble = true;
+    // the nonzero pattern of J is fixed now
+    J_slot_map.build(J);
+  }
 
   STOP_LOG("MixA1Solver_Jacobian()", "MixA1Solver");
 
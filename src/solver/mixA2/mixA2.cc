@@ -589,20 +589,19 @@ PetscScalar MixA2Solver::LTE_norm()
 void MixA2Solver::error_norm()
 {
   PetscScalar    *xx;
-  PetscScalar    *ff;
+  const PetscScalar *ff;
 
   // scatte global solution vector x to local vector lx
   // this is not necessary since it had already done in function evaluation
   //VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
   //VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
 
-  // scatte global function vector f to local vector lf
-  VecScatterBegin(scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
+  // only the on processor dofs are involved, read them from the global function vector f
+  // directly (indexed by global offset) instead of scattering f to local vector lf
 
 
   VecGetArray(lx, &xx);  // solution value
-  VecGetArray(lf, &ff);  // function value
+  VecGetArrayRead(f, &ff);   // function value
 
   // do clear
   potential_norm        = 0;
@@ -632,6 +631,7 @@ void MixA2Solver::error_norm()
       const FVM_Node * fvm_node = *it;
 
       unsigned int offset = fvm_node->local_offset();
+      unsigned int f_offset = fvm_node->global_offset() - global_offset;
 
       switch ( region->type() )
       {
@@ -642,10 +642,10 @@ void MixA2Solver::error_norm()
             hole_norm        += xx[offset+2]*xx[offset+2];
             temperature_norm += xx[offset+3]*xx[offset+3];
 
-            poisson_norm         += ff[offset+0]*ff[offset+0];
-            elec_continuity_norm += ff[offset+1]*ff[offset+1];
-            hole_continuity_norm += ff[offset+2]*ff[offset+2];
-            heat_equation_norm   += ff[offset+3]*ff[offset+3];
+            poisson_norm         += ff[f_offset+0]*ff[f_offset+0];
+            elec_continuity_norm += ff[f_offset+1]*ff[f_offset+1];
+            hole_continuity_norm += ff[f_offset+2]*ff[f_offset+2];
+            heat_equation_norm   += ff[f_offset+3]*ff[f_offset+3];
             break;
           }
           case InsulatorRegion :
@@ -655,8 +655,8 @@ void MixA2Solver::error_norm()
             potential_norm   += xx[offset]*xx[offset];
             temperature_norm += xx[offset+1]*xx[offset+1];
 
-            poisson_norm        += ff[offset]*ff[offset];
-            heat_equation_norm  += ff[offset+1]*ff[offset+1];
+            poisson_norm        += ff[f_offset]*ff[f_offset];
+            heat_equation_norm  += ff[f_offset+1]*ff[f_offset+1];
             break;
           }
 
@@ -683,8 +683,13 @@ void MixA2Solver::error_norm()
   norm_buffer.push_back(hole_continuity_norm);
   norm_buffer.push_back(heat_equation_norm);
 
+  // the circuit residual is only computed on the last processor, it is zero on the others
+  norm_buffer.push_back(electrode_norm);
+
   Parallel::sum(norm_buffer);
 
+  electrode_norm = norm_buffer.back();
+
   // sqrt to get L2 norm
   potential_norm   = sqrt(norm_buffer[0]);
   electron_norm    = sqrt(norm_buffer[1]);
@@ -697,10 +702,9 @@ void MixA2Solver::error_norm()
   heat_equation_norm  = sqrt(norm_buffer[7]);
 
 
-  Parallel::broadcast(electrode_norm, Genius::last_processor_id());
 
   VecRestoreArray(lx, &xx);
-  VecRestoreArray(lf, &ff);
+  VecRestoreArrayRead(f, &ff);
 
 }
 
@@ -789,8 +793,8 @@ void MixA2Solver::build_petsc_sens_residual(Vec x, Vec r)
     bc->MixA_DDM2_Function_Preprocess(r, src_row, dst_row, clear_row);
   }
   //add source rows to destination rows, and clear rows
-  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row);
-  add_value_flag = NOT_SET_VALUES;
+  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
 
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
   {
@@ -811,20 +815,9 @@ void MixA2Solver::build_petsc_sens_residual(Vec x, Vec r)
   VecAssemblyBegin(r);
   VecAssemblyEnd(r);
 
-  // scale the function vec
-  PetscScalar *ff,*scale;
-  // get function array and scale array.
-  VecGetArray(r, &ff);
-  // L is the scaling vector, the Jacobian evaluate function may dynamically update it.
-  VecGetArray(L, &scale);
-
-  // scale it!
-  for(unsigned int n=0; n<n_local_dofs; n++)
-    ff[n] *= scale[n];
-
-  // restore back
-  VecRestoreArray(r, &ff);
-  VecRestoreArray(L, &scale);
+  // scale the function vec, L is the scaling vector, the Jacobian evaluate function may dynamically update it.
+  // a vector operation does not pull device vector types back to host memory
+  VecPointwiseMult(r, r, L);
 
   STOP_LOG("MixA2Solver_Residual()", "MixA2Solver");
 
@@ -917,11 +910,9 @@ void MixA2Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
     BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
     bc->MixA_DDM2_Jacobian_Preprocess(&J, src_row, dst_row, clear_row);
   }
-  //add source rows to destination rows
-  PetscUtils::MatAddRowToRow(J, src_row, dst_row);
-  // clear row
-  PetscUtils::MatZeroRows(J, clear_row.size(), clear_row.empty() ? NULL : &clear_row[0], 0.0);
-  add_value_flag = NOT_SET_VALUES;
+  //add source rows to destination rows, and clear rows
+  PetscUtils::MatAddClearRow(J, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
 
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
   {
@@ -955,7 +946,11 @@ void MixA2Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   //getchar();
 
   if(!jacobian_matrix_first_assemble)
+  {
     jacobian_matrix_first_assemble = true;
+    // the nonzero pattern of J is fixed now
+    J_slot_map.build(J);
+  }
 
   STOP_LOG("MixA2Solver_Jacobian()", "MixA2Solver");
 
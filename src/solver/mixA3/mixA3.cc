@@ -693,20 +693,19 @@ PetscScalar MixA3Solver::LTE_norm()
 void MixA3Solver::error_norm()
 {
   PetscScalar    *xx;
-  PetscScalar    *ff;
+  const PetscScalar *ff;
 
   // scatte global solution vector x to local vector lx
   // this is not necessary since it had already done in function evaluation
   //VecScatterBegin(scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
   //VecScatterEnd  (scatter, x, lx, INSERT_VALUES, SCATTER_FORWARD);
 
-  // scatte global function vector f to local vector lf
-  VecScatterBegin(scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
-  VecScatterEnd  (scatter, f, lf, INSERT_VALUES, SCATTER_FORWARD);
+  // only the on processor dofs are involved, read them from the global function vector f
+  // directly (indexed by global offset) instead of scattering f to local vector lf
 
 
   VecGetArray(lx, &xx);  // solution value
-  VecGetArray(lf, &ff);  // function value
+  VecGetArrayRead(f, &ff);   // function value
 
   // do clear
   potential_norm        = 0;
@@ -747,31 +746,32 @@ void MixA3Solver::error_norm()
             const FVM_Node * fvm_node = *it;
 
             unsigned int offset = fvm_node->local_offset();
+            unsigned int f_offset = fvm_node->global_offset() - global_offset;
 
             potential_norm   += xx[offset+node_psi_offset]*xx[offset+node_psi_offset];
             electron_norm    += xx[offset+node_n_offset]*xx[offset+node_n_offset];
             hole_norm        += xx[offset+node_p_offset]*xx[offset+node_p_offset];
 
-            poisson_norm        += ff[offset+node_psi_offset]*ff[offset+node_psi_offset];
-            elec_continuity_norm += ff[offset+node_n_offset]*ff[offset+node_n_offset];
-            hole_continuity_norm += ff[offset+node_p_offset]*ff[offset+node_p_offset];
+            poisson_norm        += ff[f_offset+node_psi_offset]*ff[f_offset+node_psi_offset];
+            elec_continuity_norm += ff[f_offset+node_n_offset]*ff[f_offset+node_n_offset];
+            hole_continuity_norm += ff[f_offset+node_p_offset]*ff[f_offset+node_p_offset];
 
             if(region->get_advanced_model()->enable_Tl())
             {
               temperature_norm    += xx[offset+node_Tl_offset]*xx[offset+node_Tl_offset];
-              heat_equation_norm  += ff[offset+node_Tl_offset]*ff[offset+node_Tl_offset];
+              heat_equation_norm  += ff[f_offset+node_Tl_offset]*ff[f_offset+node_Tl_offset];
             }
 
             if(region->get_advanced_model()->enable_Tn())
             {
               elec_temperature_norm      += xx[offset+node_Tn_offset]/xx[offset+node_n_offset]*xx[offset+node_Tn_offset]/xx[offset+node_n_offset];
-              elec_energy_equation_norm  += ff[offset+node_Tn_offset]*ff[offset+node_Tn_offset];
+              elec_energy_equation_norm  += ff[f_offset+node_Tn_offset]*ff[f_offset+node_Tn_offset];
             }
 
             if(region->get_advanced_model()->enable_Tp())
             {
               hole_temperature_norm      += xx[offset+node_Tp_offset]/xx[offset+node_p_offset]*xx[offset+node_Tp_offset]/xx[offset+node_p_offset];
-              hole_energy_equation_norm  += ff[offset+node_Tp_offset]*ff[offset+node_Tp_offset];
+              hole_energy_equation_norm  += ff[f_offset+node_Tp_offset]*ff[f_offset+node_Tp_offset];
             }
           }
           break;
@@ -790,13 +790,14 @@ void MixA3Solver::error_norm()
             const FVM_Node * fvm_node = *it;
 
             unsigned int offset = fvm_node->local_offset();
+            unsigned int f_offset = fvm_node->global_offset() - global_offset;
             potential_norm   += xx[offset+node_psi_offset]*xx[offset+node_psi_offset];
-            poisson_norm     += ff[offset+node_psi_offset]*ff[offset+node_psi_offset];
+            poisson_norm     += ff[f_offset+node_psi_offset]*ff[f_offset+node_psi_offset];
 
             if(region->get_advanced_model()->enable_Tl())
             {
               temperature_norm    += xx[offset+node_Tl_offset]*xx[offset+node_Tl_offset];
-              heat_equation_norm  += ff[offset+node_Tl_offset]*ff[offset+node_Tl_offset];
+              heat_equation_norm  += ff[f_offset+node_Tl_offset]*ff[f_offset+node_Tl_offset];
             }
           }
           break;
@@ -828,8 +829,13 @@ void MixA3Solver::error_norm()
   norm_buffer.push_back(elec_energy_equation_norm);
   norm_buffer.push_back(hole_energy_equation_norm);
 
+  // the circuit residual is only computed on the last processor, it is zero on the others
+  norm_buffer.push_back(electrode_norm);
+
   Parallel::sum(norm_buffer);
 
+  electrode_norm = norm_buffer.back();
+
 
   // sqrt to get L2 norm
   potential_norm        = sqrt(norm_buffer[0]);
@@ -846,10 +852,9 @@ void MixA3Solver::error_norm()
   elec_energy_equation_norm = sqrt(norm_buffer[10]);
   hole_energy_equation_norm = sqrt(norm_buffer[11]);
 
-  Parallel::broadcast(electrode_norm, Genius::last_processor_id());
 
   VecRestoreArray(lx, &xx);
-  VecRestoreArray(lf, &ff);
+  VecRestoreArrayRead(f, &ff);
 
 }
 
@@ -937,8 +942,8 @@ void MixA3Solver::build_petsc_sens_residual(Vec x, Vec r)
     bc->MixA_EBM3_Function_Preprocess(r, src_row, dst_row, clear_row);
   }
   //add source rows to destination rows, and clear rows
-  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row);
-  add_value_flag = NOT_SET_VALUES;
+  PetscUtils::VecAddClearRow(r, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
 
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
   {
@@ -959,20 +964,9 @@ void MixA3Solver::build_petsc_sens_residual(Vec x, Vec r)
   VecAssemblyBegin(r);
   VecAssemblyEnd(r);
 
-  // scale the function vec
-  PetscScalar *ff,*scale;
-  // get function array and scale array.
-  VecGetArray(r, &ff);
-  // L is the scaling vector, the Jacobian evaluate function may dynamically update it.
-  VecGetArray(L, &scale);
-
-  // scale it!
-  for(unsigned int n=0; n<n_local_dofs; n++)
-    ff[n] *= scale[n];
-
-  // restore back
-  VecRestoreArray(r, &ff);
-  VecRestoreArray(L, &scale);
+  // scale the function vec, L is the scaling vector, the Jacobian evaluate function may dynamically update it.
+  // a vector operation does not pull device vector types back to host memory
+  VecPointwiseMult(r, r, L);
 
   STOP_LOG("MixA3Solver_Residual()", "MixA3Solver");
 
@@ -1065,11 +1059,9 @@ void MixA3Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
     BoundaryCondition * bc = _system.get_bcs()->get_bc(b);
     bc->MixA_EBM3_Jacobian_Preprocess(&J, src_row, dst_row, clear_row);
   }
-  //add source rows to destination rows
-  PetscUtils::MatAddRowToRow(J, src_row, dst_row);
-  // clear row
-  PetscUtils::MatZeroRows(J, clear_row.size(), clear_row.empty() ? NULL : &clear_row[0], 0.0);
-  add_value_flag = NOT_SET_VALUES;
+  //add source rows to destination rows, and clear rows
+  PetscUtils::MatAddClearRow(J, src_row, dst_row, clear_row, global_clear_rows(clear_row));
+  add_value_flag = ADD_VALUES;
 
   for(unsigned int b=0; b<_system.get_bcs()->n_bcs(); b++)
   {
@@ -1103,7 +1095,11 @@ void MixA3Solver::build_petsc_sens_jacobian(Vec x, Mat *, Mat *)
   //getchar();
 
   if(!jacobian_matrix_first_assemble)
+  {
     jacobian_matrix_first_assemble = true;
+    // the nonzero pattern of J is fixed now
+    J_slot_map.build(J);
+  }
 
   STOP_LOG("MixA3Solver_Jacobian()", "MixA3Solver");
 
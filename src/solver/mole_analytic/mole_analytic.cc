@@ -19,6 +19,9 @@
 /*                                                                              */
 /********************************************************************************/
 
+#include <cmath>
+
+#include "genius_env.h"
 #include "mesh_base.h"
 #include "mole_analytic/mole_analytic.h"
 #include "interpolation_2d_csa.h"
@@ -68,13 +71,17 @@ int MoleAnalytic::solve()
     if( region->type() != SemiconductorRegion ) continue;
 
     SimulationRegion::local_node_iterator node_it = region->on_local_nodes_begin();
-    SimulationRegion::local_node_iterator node_it_end = region->on_local_nodes_end();
-    for(; node_it!=node_it_end; ++node_it)
+    const int n_nodes = static_cast<int>(region->on_local_nodes_end() - node_it);
+
+    std::vector<double> mole_x, mole_y;
+    this->mole_fraction( region->name(), true,  node_it, n_nodes, mole_x );
+    this->mole_fraction( region->name(), false, node_it, n_nodes, mole_y );
+
+    for(int i=0; i<n_nodes; ++i)
     {
-      FVM_Node * fvm_node = *node_it;
-      FVM_NodeData * node_data = fvm_node->node_data();
-      node_data->mole_x() = this->mole_x( region->name(), fvm_node->root_node() );
-      node_data->mole_y() = this->mole_y( region->name(), fvm_node->root_node() );
+      FVM_NodeData * node_data = (*(node_it + i))->node_data();
+      node_data->mole_x() = mole_x[i];
+      node_data->mole_y() = mole_y[i];
     }
   }
 
@@ -276,7 +283,7 @@ void MoleAnalytic::set_mole_function_linear(const Parser::Card & c)
       y_dir = Z_Direction;
 
     // determine the begin and end location
-    switch(x_dir)
+    switch(y_dir)
     {
     case X_Direction: y_base = xmin; y_end = xmax; break;
     case Y_Direction: y_base = ymin; y_end = ymax; break;
@@ -302,84 +309,61 @@ void MoleAnalytic::set_mole_function_linear(const Parser::Card & c)
 
 
 
-double MoleAnalytic::mole_x(const std::string & region, const Node * node)
+void MoleAnalytic::mole_fraction(const std::string & region, bool first,
+                                 SimulationRegion::local_node_iterator node_it, int n_nodes,
+                                 std::vector<double> & mole)
 {
-  double mole = 0.0;
+  mole.assign(n_nodes, 0.0);
 
-  // use the first Mole profile that specified an X composition
+  // use the first Mole profile that specified this composition
   for(size_t i=0; i<_mole_funs.size(); i++)
   {
-    if(_mole_funs[i]->region() != region) continue;
+    MoleFunction * mf = _mole_funs[i];
+    if(mf->region() != region) continue;
+    if(first ? !mf->mole_x() : !mf->mole_y()) continue;
 
-    if(_mole_funs[i]->mole_x())
-      return  _mole_funs[i]->profile((*node)(0),(*node)(1),(*node)(2));
+#pragma omp parallel for schedule(static) num_threads(Genius::n_threads())
+    for(int k=0; k<n_nodes; ++k)
+    {
+      const Node * node = (*(node_it + k))->root_node();
+      mole[k] = mf->profile((*node)(0),(*node)(1),(*node)(2));
+    }
+    return;
   }
 
-  // then check mole profile file
+  // then check mole profile file, all the nodes are interpolated at once
   for(size_t i=0; i<_mole_data.size(); i++)
   {
-    InterpolationBase * interp = _mole_data[i].first;
+    InterpolationBase * interp = first ? _mole_data[i].first : _mole_data[i].second;
     if (!interp)
       continue;
-    double mx = interp->get_interpolated_value(*node, 0);
-    mx = mx<0.0 ? 0.0 : mx;
-    mx = mx>1.0 ? 1.0 : mx;
-#if defined(HAVE_FENV_H) && defined(DEBUG)
-    if(fetestexcept(FE_INVALID|FE_DIVBYZERO|FE_OVERFLOW))
-    {
-      MESSAGE<< "Warning: problem in interpolating x mole fraction at ";
-      MESSAGE<< (*node)(0)/um << "\t";
-      MESSAGE<< (*node)(1)/um << "\t";
-      MESSAGE<< (*node)(2)/um << " " << mx << " , ignored.\n";
-      RECORD();
-      feclearexcept(FE_ALL_EXCEPT);
-      return mole;
-    }
-#endif
-    return mx;
-  }
-
-  return mole;
-}
-
-
 
-double MoleAnalytic::mole_y(const std::string & region, const Node * node)
-{
-  double mole = 0.0;
-
-  for(size_t i=0; i<_mole_funs.size(); i++)
-  {
-    if(_mole_funs[i]->region() != region) continue;
+    std::vector<Point> points(n_nodes);
+    for(int k=0; k<n_nodes; ++k)
+      points[k] = *(*(node_it + k))->root_node();
 
-    if(_mole_funs[i]->mole_y())
-      return  _mole_funs[i]->profile((*node)(0),(*node)(1),(*node)(2));
-  }
+    std::vector<double> values;
+    interp->interpolate_points(points, 0, values);
 
-  // then check mole profile file
-  for(size_t i=0; i<_mole_data.size(); i++)
-  {
-    InterpolationBase * interp = _mole_data[i].second;
-    if (!interp)
-      continue;
-    double mx = interp->get_interpolated_value(*node, 0);
-    mx = mx<0.0 ? 0.0 : mx;
-    mx = mx>1.0 ? 1.0 : mx;
+    unsigned int n_bad = 0;
+    for(int k=0; k<n_nodes; ++k)
+    {
+      double mx = values[k];
+      // problem in interpolating, ignored
+      if( !(mx == mx) || std::abs(mx) > 1e30 ) { mx = 0.0; n_bad++; }
+      mx = mx<0.0 ? 0.0 : mx;
+      mx = mx>1.0 ? 1.0 : mx;
+      mole[k] = mx;
+    }
 #if defined(HAVE_FENV_H) && defined(DEBUG)
-    if(fetestexcept(FE_INVALID|FE_DIVBYZERO|FE_OVERFLOW))
+    feclearexcept(FE_ALL_EXCEPT);
+#endif
+    if( n_bad )
     {
-      MESSAGE<< "Warning: problem in interpolating x mole fraction at ";
-      MESSAGE<< (*node)(0)/um << "\t";
-      MESSAGE<< (*node)(1)/um << "\t";
-      MESSAGE<< (*node)(2)/um << " " << mx << " , ignored.\n";
+      MESSAGE<< "Warning: problem in interpolating " << (first ? "x" : "y") << " mole fraction at "
+             << n_bad << " nodes of region " << region << ", ignored.\n";
       RECORD();
-      feclearexcept(FE_ALL_EXCEPT);
-      return mole;
     }
-#endif
-    return mx;
+    return;
   }
-
-  return mole;
 }
-
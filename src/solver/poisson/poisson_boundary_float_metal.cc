@@ -19,9 +19,6 @@
 /*                                                                              */
 /********************************************************************************/
 
-// C++ includes
-#include <numeric>
-
 #include "simulation_system.h"
 #include "conductor_region.h"
 #include "insulator_region.h"
@@ -89,12 +86,6 @@ void ChargedContactBC::Poissin_Function(PetscScalar * x, Vec f, InsertMode &add_
     VecAssemblyEnd(f);
   }
 
-  // for 2D mesh, z_width() is the device dimension in Z direction; for 3D mesh, z_width() is 1.0
-  PetscScalar z_width = this->z_width();
-
-  // buffer for float metal surface potential equation \integral {\eps \frac{\partial P}{\partial n} } + \sigma = 0
-  std::vector<PetscScalar> surface_equ;
-
   const SimulationRegion * _r1 = bc_regions().first;
   genius_assert(_r1->type() == InsulatorRegion);
   const SimulationRegion * _r2 = bc_regions().second;
@@ -132,36 +123,12 @@ void ChargedContactBC::Poissin_Function(PetscScalar * x, Vec f, InsertMode &add_
       if( region->type() != InsulatorRegion ) continue;
 
       const FVM_Node * insulator_node  = (*rnode_it).second.second;
-      const FVM_NodeData * insulator_node_data = insulator_node->node_data();
-
       // psi of insulator node
       PetscScalar V_insulator = x[insulator_node->local_offset()];
 
       // the psi of insulator node is equal to psi of float metal
       PetscScalar f_psi = V_insulator - V_metal;
       VecSetValue(f,  insulator_node->global_offset(), f_psi, ADD_VALUES);
-
-      // process float metal surface equation
-      {
-        FVM_Node::fvm_neighbor_node_iterator nb_it = insulator_node->neighbor_node_begin();
-        FVM_Node::fvm_neighbor_node_iterator nb_it_end = insulator_node->neighbor_node_end();
-        for(; nb_it != nb_it_end; ++nb_it)
-        {
-          const FVM_Node *nb_node = (*nb_it).second;
-          // the psi of neighbor node
-          PetscScalar V_nb = x[nb_node->local_offset()];
-          // distance from nb node to this node
-          PetscScalar distance = insulator_node->distance(nb_node);
-          // area of out surface of control volume related with neighbor node,
-          // here we should consider the difference of 2D/3D by multiply z_width
-          PetscScalar cv_boundary = insulator_node->cv_surface_area(nb_node->root_node())*z_width;
-          // surface electric field
-          PetscScalar E = (V_nb-V_insulator)/distance;
-          PetscScalar D = insulator_node_data->eps()*E;
-          // insert surface integral of electric displacement of this node into surface_equ buffer
-          surface_equ.push_back(cv_boundary*D);
-        }
-      }
     }
 
   }
@@ -169,8 +136,8 @@ void ChargedContactBC::Poissin_Function(PetscScalar * x, Vec f, InsertMode &add_
 
 
 
-  // we sum all the terms in surface_equ buffer, that is surface integral of electric displacement for this boundary
-  PetscScalar surface_integral_electric_displacement = std::accumulate(surface_equ.begin(), surface_equ.end(), 0.0 );
+  // surface integral of electric displacement for this boundary, by the precomputed integration weights
+  PetscScalar surface_integral_electric_displacement = this->surface_integral(x);
 
   // add to ChargeIntegralBC
   VecSetValue(f, this->inter_connect_hub()->global_offset(), surface_integral_electric_displacement, ADD_VALUES);
@@ -187,7 +154,6 @@ void ChargedContactBC::Poissin_Function(PetscScalar * x, Vec f, InsertMode &add_
  */
 void ChargedContactBC::Poissin_Jacobian_Reserve(Mat *jac, InsertMode &add_value_flag)
 {
-
   // ADD 0 to some position of Jacobian matrix to prevent MatAssembly expurgation these position.
 
   // since we will use ADD_VALUES operator, check the matrix state.
@@ -308,9 +274,6 @@ void ChargedContactBC::Poissin_Jacobian(PetscScalar * x, Mat *jac, InsertMode &a
   genius_assert( this->inter_connect_hub()->local_offset() != invalid_uint );
   AutoDScalar phi_f = x[this->inter_connect_hub()->local_offset()]; phi_f.setADValue(0, 1.0);
 
-  // for 2D mesh, z_width() is the device dimension in Z direction; for 3D mesh, z_width() is 1.0
-  PetscScalar z_width = this->z_width();
-
   // after that, set new Jacobian entrance to source rows
   BoundaryCondition::const_node_iterator node_it = nodes_begin();
   BoundaryCondition::const_node_iterator end_it = nodes_end();
@@ -340,7 +303,6 @@ void ChargedContactBC::Poissin_Jacobian(PetscScalar * x, Mat *jac, InsertMode &a
       if( region->type() != InsulatorRegion ) continue;
 
       const FVM_Node * insulator_node  = (*rnode_it).second.second;
-      const FVM_NodeData * insulator_node_data = insulator_node->node_data();
       // psi of insulator node
       AutoDScalar V_insulator = x[insulator_node->local_offset()];  V_insulator.setADValue(2, 1.0);
 
@@ -349,34 +311,12 @@ void ChargedContactBC::Poissin_Jacobian(PetscScalar * x, Mat *jac, InsertMode &a
       // set Jacobian of governing equation f_psi
       MatSetValue(*jac, insulator_node->global_offset(), insulator_node->global_offset(), f_psi.getADValue(2), ADD_VALUES);
       MatSetValue(*jac, insulator_node->global_offset(), metal_node->global_offset(), f_psi.getADValue(1), ADD_VALUES);
-
-      FVM_Node::fvm_neighbor_node_iterator nb_it = insulator_node->neighbor_node_begin();
-      FVM_Node::fvm_neighbor_node_iterator nb_it_end = insulator_node->neighbor_node_end();
-      for(; nb_it != nb_it_end; ++nb_it)
-      {
-        const FVM_Node *nb_node = (*nb_it).second;
-        genius_assert(nb_node->on_local());
-
-        // the psi of neighbor node
-        AutoDScalar V_nb = x[nb_node->local_offset()];  V_nb.setADValue(0, 1.0);
-        // distance from nb node to this node
-        PetscScalar distance = insulator_node->distance(nb_node);
-        // area of out surface of control volume related with neighbor node,
-        // here we should consider the difference of 2D/3D by multiply z_width
-        PetscScalar cv_boundary = insulator_node->cv_surface_area(nb_node->root_node())*z_width;
-        // surface electric field and electrc displacement
-        AutoDScalar E = (V_nb-V_insulator)/distance;
-        AutoDScalar D = insulator_node_data->eps()*E;
-
-        // since the governing equation is \sum \integral D + \sigma = 0
-        // and \integral D = \sum cv_boundary*D
-        // here we use MatSetValue ADD_VALUES to process \sum \integral D one by one
-        MatSetValue(*jac, this->inter_connect_hub()->global_offset(), insulator_node->global_offset(), (cv_boundary*D).getADValue(2), ADD_VALUES);
-        MatSetValue(*jac, this->inter_connect_hub()->global_offset(), nb_node->global_offset(), (cv_boundary*D).getADValue(0), ADD_VALUES);
-      }
     }
   }
 
+  // the surface integral of electric displacement is linear in psi, its jacobian is the integration weights
+  this->surface_integral_jacobian(jac, this->inter_connect_hub()->global_offset());
+
   // the last operator is ADD_VALUES
   add_value_flag = ADD_VALUES;
 
@@ -0,0 +1,304 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <algorithm>
+#include <limits>
+
+#include "elem.h"
+#include "mesh_base.h"
+#include "ray_tracing/face_bvh.h"
+
+
+namespace
+{
+  // the maximal depth of the tree, the traversal stack holds 2 nodes per level
+  const unsigned int max_depth = 48;
+
+  // the number of bins used to evaluate the surface area heuristic
+  const unsigned int n_bins = 12;
+
+  // leaf with no more faces than this are not split
+  const unsigned int leaf_faces = 2;
+
+  /**
+   * the cost measure of a box: half surface area in 3D, half perimeter in 2D
+   */
+  double box_cost(const Point &lower, const Point &upper, unsigned int dim)
+  {
+    Point e = upper - lower;
+    if(dim == 3)
+      return e(0)*e(1) + e(1)*e(2) + e(2)*e(0);
+    return e(0) + e(1) + e(2);
+  }
+
+  void grow(Point &lower, Point &upper, const Point &p)
+  {
+    for(unsigned int i=0; i<3; ++i)
+    {
+      lower(i) = std::min(lower(i), p(i));
+      upper(i) = std::max(upper(i), p(i));
+    }
+  }
+
+  void grow(Point &lower, Point &upper, const Point &l, const Point &u)
+  { grow(lower, upper, l); grow(lower, upper, u); }
+
+  /**
+   * which bin the centroid c falls in
+   */
+  struct bin_of
+  {
+    unsigned int axis;
+    double       lower, scale;
+    unsigned int operator()(const Point &c) const
+    {
+      int b = static_cast<int>((c(axis) - lower)*scale);
+      return std::min(static_cast<unsigned int>(std::max(b, 0)), n_bins-1);
+    }
+  };
+}
+
+
+
+FaceBVH::FaceBVH(const MeshBase& mesh, unsigned int subdomain, unsigned int dim)
+  : _dim(dim)
+{
+  MeshBase::const_element_iterator       el  = mesh.elements_begin();
+  const MeshBase::const_element_iterator end = mesh.elements_end();
+  for (; el != end; ++el)
+  {
+    const Elem * elem = *el;
+    if(elem->subdomain_id() != subdomain) continue;
+
+    for(unsigned int s=0; s<elem->n_sides(); ++s)
+    {
+      const Elem * neighbor = elem->neighbor(s);
+      if(neighbor && neighbor->subdomain_id() == subdomain) continue;
+
+      Face face;
+      face.elem      = elem;
+      face.side      = s;
+      face.side_elem = elem->build_side(s, false).release();
+      face.lower     = face.side_elem->point(0);
+      face.upper     = face.side_elem->point(0);
+      for(unsigned int n=1; n<face.side_elem->n_nodes(); ++n)
+        grow(face.lower, face.upper, face.side_elem->point(n));
+      face.centroid  = face.side_elem->centroid();
+      _faces.push_back(face);
+    }
+  }
+
+  if(_faces.empty()) return;
+
+  // at most 2*n_faces-1 nodes
+  _nodes.reserve(2*_faces.size());
+  _nodes.push_back(Node());
+  _build(0, 0, _faces.size(), 0);
+}
+
+
+FaceBVH::~FaceBVH()
+{
+  for(unsigned int n=0; n<_faces.size(); ++n)
+    delete _faces[n].side_elem;
+}
+
+
+void FaceBVH::_build(unsigned int n, unsigned int begin, unsigned int end, unsigned int depth)
+{
+  Point lower = _faces[begin].lower, upper = _faces[begin].upper;
+  Point c_lower = _faces[begin].centroid, c_upper = _faces[begin].centroid;
+  for(unsigned int f=begin+1; f<end; ++f)
+  {
+    grow(lower, upper, _faces[f].lower, _faces[f].upper);
+    grow(c_lower, c_upper, _faces[f].centroid);
+  }
+
+  _nodes[n].lower   = lower;
+  _nodes[n].upper   = upper;
+  _nodes[n].first   = begin;
+  _nodes[n].n_faces = end - begin;
+
+  const unsigned int count = end - begin;
+  if(count <= leaf_faces || depth >= max_depth) return;
+
+  // split along the largest extent of the centroids
+  Point extent = c_upper - c_lower;
+  unsigned int axis = 0;
+  for(unsigned int i=1; i<3; ++i)
+    if(extent(i) > extent(axis)) axis = i;
+  // all the centroids coincide
+  if(extent(axis) <= 0.0) return;
+
+  bin_of bin;
+  bin.axis  = axis;
+  bin.lower = c_lower(axis);
+  bin.scale = n_bins/extent(axis)*(1.0 - 1e-10);
+
+  unsigned int bin_count[n_bins];
+  Point        bin_lower[n_bins], bin_upper[n_bins];
+  for(unsigned int b=0; b<n_bins; ++b)
+    bin_count[b] = 0;
+  for(unsigned int f=begin; f<end; ++f)
+  {
+    unsigned int b = bin(_faces[f].centroid);
+    if(bin_count[b]++ == 0)
+    { bin_lower[b] = _faces[f].lower; bin_upper[b] = _faces[f].upper; }
+    else
+      grow(bin_lower[b], bin_upper[b], _faces[f].lower, _faces[f].upper);
+  }
+
+  // cost of the split after each bin: sweep from right, then from left
+  double right_cost[n_bins];
+  {
+    Point l, u;
+    unsigned int c = 0;
+    for(unsigned int b=n_bins-1; b>0; --b)
+    {
+      if(bin_count[b])
+      {
+        if(c == 0) { l = bin_lower[b]; u = bin_upper[b]; }
+        else         grow(l, u, bin_lower[b], bin_upper[b]);
+        c += bin_count[b];
+      }
+      right_cost[b-1] = c ? c*box_cost(l, u, _dim) : 0.0;
+    }
+  }
+
+  double best_cost = std::numeric_limits<double>::max();
+  unsigned int best_bin = n_bins;
+  {
+    Point l, u;
+    unsigned int c = 0;
+    for(unsigned int b=0; b<n_bins-1; ++b)
+    {
+      if(bin_count[b])
+      {
+        if(c == 0) { l = bin_lower[b]; u = bin_upper[b]; }
+        else         grow(l, u, bin_lower[b], bin_upper[b]);
+        c += bin_count[b];
+      }
+      if(c == 0 || c == count) continue;
+      double cost = c*box_cost(l, u, _dim) + right_cost[b];
+      if(cost < best_cost) { best_cost = cost; best_bin = b; }
+    }
+  }
+
+  // a split costs one more box test than testing all the faces
+  const double node_cost = box_cost(lower, upper, _dim);
+  if(best_bin == n_bins || best_cost >= (count - 1)*node_cost) return;
+
+  unsigned int mid = begin;
+  for(unsigned int f=begin; f<end; ++f)
+    if(bin(_faces[f].centroid) <= best_bin)
+      std::swap(_faces[f], _faces[mid++]);
+
+  unsigned int left = _nodes.size();
+  _nodes[n].first   = left;
+  _nodes[n].n_faces = 0;
+  _nodes.push_back(Node());
+  _nodes.push_back(Node());
+
+  _build(left,   begin, mid, depth+1);
+  _build(left+1, mid,   end, depth+1);
+}
+
+
+bool FaceBVH::_hit_box(const Node & node, const Point & p, const Point & inv_d, double t_max, double & t_enter)
+{
+  double t0 = -std::numeric_limits<double>::max();
+  double t1 = t_max;
+  for(unsigned int i=0; i<3; ++i)
+  {
+    double ta = (node.lower(i) - 1e-10 - p(i))*inv_d(i);
+    double tb = (node.upper(i) + 1e-10 - p(i))*inv_d(i);
+    if(ta > tb) std::swap(ta, tb);
+    t0 = std::max(t0, ta);
+    t1 = std::min(t1, tb);
+    if(t0 > t1) return false;
+  }
+  t_enter = t0;
+  return true;
+}
+
+
+const Elem * FaceBVH::hit(const Point & p, const Point & d, double t_min, unsigned int & side, double & t) const
+{
+  if(_nodes.empty()) return NULL;
+
+  Point inv_d;
+  for(unsigned int i=0; i<3; ++i)
+    inv_d(i) = d(i) != 0.0 ? 1.0/d(i) : (std::numeric_limits<double>::max());
+
+  const Elem * hit_elem = NULL;
+  t = std::numeric_limits<double>::max();
+
+  unsigned int stack[2*max_depth+2];
+  unsigned int top = 0;
+
+  double t_enter;
+  if(!_hit_box(_nodes[0], p, inv_d, t, t_enter)) return NULL;
+  stack[top++] = 0;
+
+  while(top)
+  {
+    const Node & node = _nodes[stack[--top]];
+
+    if(node.n_faces)
+    {
+      for(unsigned int f=node.first; f<node.first+node.n_faces; ++f)
+      {
+        const Face & face = _faces[f];
+        IntersectionResult result;
+        face.side_elem->ray_hit(p, d, result, _dim);
+        if(result.state == Missed || result.hit_points.empty()) continue;
+
+        // the ray may run along the side, take the part after t_min
+        double tf = result.hit_points[0].t;
+        if(tf <= t_min && result.hit_points.back().t > t_min)
+          tf = t_min;
+        if(tf <= t_min || tf >= t) continue;
+
+        t        = tf;
+        side     = face.side;
+        hit_elem = face.elem;
+      }
+      continue;
+    }
+
+    // visit the nearer child first
+    double t_left, t_right;
+    bool hit_left  = _hit_box(_nodes[node.first],   p, inv_d, t, t_left);
+    bool hit_right = _hit_box(_nodes[node.first+1], p, inv_d, t, t_right);
+    if(hit_left && hit_right)
+    {
+      if(t_left < t_right)
+      { stack[top++] = node.first+1; stack[top++] = node.first; }
+      else
+      { stack[top++] = node.first;   stack[top++] = node.first+1; }
+    }
+    else if(hit_left)  stack[top++] = node.first;
+    else if(hit_right) stack[top++] = node.first+1;
+  }
+
+  return hit_elem;
+}
@@ -0,0 +1,69 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include "elem.h"
+#include "genius_env.h"
+#include "object_pool.h"
+#include "ray_tracing/light_thread.h"
+
+
+std::vector<FixedSizePool *> LightThread::_pools;
+
+
+void LightThread::init_pools(unsigned int n_threads)
+{
+  while( _pools.size() < n_threads )
+  {
+    _pools.push_back(new FixedSizePool(sizeof(LightThread), 256));
+    // keep one block in use, or the pool frees its chunks after each primary ray
+    _pools.back()->allocate();
+  }
+}
+
+
+void LightThread::clear_pools()
+{
+  for(unsigned int n=0; n<_pools.size(); ++n)
+    delete _pools[n];
+  _pools.clear();
+}
+
+
+void * LightThread::operator new(size_t size)
+{
+  const unsigned int t = Genius::thread_id();
+  if( size != sizeof(LightThread) || t >= _pools.size() )
+    return ::operator new(size);
+  return _pools[t]->allocate();
+}
+
+
+void LightThread::operator delete(void * p, size_t size)
+{
+  const unsigned int t = Genius::thread_id();
+  if( size != sizeof(LightThread) || t >= _pools.size() )
+  {
+    ::operator delete(p);
+    return;
+  }
+  _pools[t]->deallocate(p);
+}
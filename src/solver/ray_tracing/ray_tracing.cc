@@ -20,7 +20,10 @@
 /********************************************************************************/
 
 #include <stack>
+#include <queue>
 #include <iomanip>
+#include <algorithm>
+#include <functional>
 
 #include "sphere.h"
 #include "mesh_base.h"
@@ -28,6 +31,7 @@
 #include "mesh_tools.h"
 #include "ray_tracing/light_thread.h"
 #include "ray_tracing/object_tree.h"
+#include "ray_tracing/face_bvh.h"
 #include "ray_tracing/ray_tracing.h"
 #include "parallel.h"
 
@@ -64,9 +68,17 @@ int RayTraceSolver::create_solver()
   build_elems_edge_map();
   build_boundary_elems_map();
 
+  // wave lengths whose refractive index differ less than this are traced together
+  _wave_tolerance = _card.get_real("wave.tolerance", 1e-3);
+
   // parse input deck
   create_rays();
 
+  // the rays cross the transparent regions from interface to interface
+  _region_face_bvh.resize(mesh.n_subdomains(), 0);
+  for(unsigned int r=0; r<mesh.n_subdomains(); ++r)
+    _region_face_bvh[r] = new FaceBVH(mesh, r, _dim);
+
   MESSAGE<< _total_rays <<" rays for each wave length."<<std::endl;
   RECORD();
 
@@ -76,55 +88,97 @@ int RayTraceSolver::create_solver()
 
 int RayTraceSolver::solve()
 {
-  // for each wavelentgh
-  for(unsigned int n=0; n<_optical_sources.size(); ++n)
+  // secondary rays are allocated from the pool of each thread
+  LightThread::init_pools(Genius::n_threads());
+
+  // for each bundle of wavelentghs
+  for(unsigned int n=0; n<_optical_sources.size(); )
   {
-    double lamda     = _optical_sources[n].wave_length;
-    double intensity = _optical_sources[n].power;
-    double power     = _dim==2 ? intensity*_wave_plane.min_dist : intensity*_wave_plane.ray_area();
+    // the wave lengths with nearly the same refractive index go the same path
+    const unsigned int n_waves = wave_bundle(n);
+    std::vector<double> lamda(n_waves), power(n_waves);
+    for(unsigned int w=0; w<n_waves; ++w)
+    {
+      double intensity = _optical_sources[n+w].power;
+      lamda[w] = _optical_sources[n+w].wave_length;
+      power[w] = _dim==2 ? intensity*_wave_plane.min_dist : intensity*_wave_plane.ray_area();
+    }
 
     build_region_refractive_index(lamda);
 
-    // clear and re-create the array to record energy deposition
-    _energy_deposit_in_elem.clear();
-    _energy_deposit_in_elem.resize(_system.mesh().n_elem(), 0.0);
-
-    MESSAGE<< "  process light of " /*<< std::setiosflags(std::ios::fixed)*/  << lamda/um << " um";
+    MESSAGE<< "  process light of " /*<< std::setiosflags(std::ios::fixed)*/  << lamda[0]/um;
+    if(n_waves > 1)
+      MESSAGE<< " - " << lamda[n_waves-1]/um;
+    MESSAGE<< " um";
     RECORD();
 
-    //process all the rays
-    unsigned int n_on_processor_rays = _wave_plane.n_on_processor_rays();
-    for(unsigned int k=0; k<n_on_processor_rays; ++k)
+    // balance the rays by the cost measured in last wave length
+    distribute_rays();
+
+    // each thread deposits energy to its own array, n_waves values per elem
+    const unsigned int n_threads = Genius::n_threads();
+    const unsigned int n_elem = _system.mesh().n_elem();
+    std::vector< std::vector<double> > thread_energy_deposit(n_threads, std::vector<double>(n_elem*n_waves, 0.0));
+    std::vector<unsigned int> ray_cost(_total_rays, 0);
+
+    //process all the rays, in 20 batches for the progress indicator.
+    // the cost of a ray varies a lot with reflections, the threads take rays one by one
+    const int n_on_processor_rays = _wave_plane.n_on_processor_rays();
+    const int n_batch = 20;
+    for(int b=0; b<n_batch; ++b)
     {
-      // create ray
-      LightThread * light = new  LightThread(_wave_plane.ray_start_point(k),
-                                             _wave_plane.norm,
-                                             _wave_plane.E_dir,
-                                             lamda,
-                                             power,
-                                             power
-                                            );
-      // call function ray_tracing to process a single ray
-      ray_tracing(light);
+      const int begin = n_on_processor_rays*b/n_batch;
+      const int end   = n_on_processor_rays*(b+1)/n_batch;
 
-      //indicator
-      if(k%(n_on_processor_rays/20)==0)
+#pragma omp parallel for schedule(dynamic, 1) num_threads(n_threads)
+      for(int k=begin; k<end; ++k)
       {
-        MESSAGE<< ".";
-        RECORD();
+        // create ray
+        LightThread * light = new  LightThread(_wave_plane.ray_start_point(k),
+                                               _wave_plane.norm,
+                                               _wave_plane.E_dir,
+                                               n_waves,
+                                               &lamda[0],
+                                               &power[0]
+                                              );
+        // call function ray_tracing to process a single ray
+        ray_cost[_wave_plane.local_rays[k]] = ray_tracing(light, thread_energy_deposit[Genius::thread_id()]);
       }
+
+      //indicator
+      MESSAGE<< ".";
+      RECORD();
     }
 
-    // gather energy deposit from all the processors
-    Parallel::sum(_energy_deposit_in_elem);
+    std::vector<double> & energy_deposit = thread_energy_deposit[0];
+    for(unsigned int t=1; t<n_threads; ++t)
+      for(unsigned int i=0; i<energy_deposit.size(); ++i)
+        energy_deposit[i] += thread_energy_deposit[t][i];
+
+    // gather energy deposit of all the wave lengths from all the processors
+    Parallel::sum(energy_deposit);
+
+    // the cost of each ray, for the distribution of next wave length
+    Parallel::sum(ray_cost);
+    _ray_cost.swap(ray_cost);
 
     // convert energy deposit to carrier optical generation
-    optical_generation(n);
+    for(unsigned int w=0; w<n_waves; ++w)
+    {
+      _energy_deposit_in_elem.resize(n_elem);
+      for(unsigned int i=0; i<n_elem; ++i)
+        _energy_deposit_in_elem[i] = energy_deposit[i*n_waves+w];
+      optical_generation(n+w);
+    }
 
     MESSAGE<< "ok" <<std::endl;
     RECORD();
+
+    n += n_waves;
   }
 
+  LightThread::clear_pools();
+
   return 0;
 }
 
@@ -133,6 +187,10 @@ int RayTraceSolver::destroy_solver()
 {
   delete surface_elem_tree;
 
+  for(unsigned int r=0; r<_region_face_bvh.size(); ++r)
+    delete _region_face_bvh[r];
+  _region_face_bvh.clear();
+
   {
     std::map<const Elem *, std::vector<const Elem *>,  lt_edge>::iterator it = _elems_shared_this_edge.begin();
     for(; it!=_elems_shared_this_edge.end(); ++it)
@@ -270,22 +328,55 @@ void RayTraceSolver::parse_spectrum_file(const std::string & filename)
 
 }
 
-void RayTraceSolver::build_region_refractive_index(double lamda)
+void RayTraceSolver::build_region_refractive_index(const std::vector<double> & lamdas)
 {
   _region_refractive_index.clear();
+  _region_extinction.clear();
 
   for(unsigned int n=0; n<_system.n_regions(); ++n)
   {
     SimulationRegion* region = _system.region(n);
-    Complex r_index = region->get_optical_refraction(lamda);
 
-    std::pair<double, double> refract_index = std::make_pair(r_index.real(), r_index.imag());
+    std::vector<double> & extinction = _region_extinction[n];
+    for(unsigned int w=0; w<lamdas.size(); ++w)
+      extinction.push_back(region->get_optical_refraction(lamdas[w]).imag());
 
-    _region_refractive_index[n] = refract_index;
+    double r_index = region->get_optical_refraction(lamdas[0]).real();
+    double k_max   = *std::max_element(extinction.begin(), extinction.end());
+
+    _region_refractive_index[n] = std::make_pair(r_index, k_max);
   }
 
   // set env refractive index
   _region_refractive_index[invalid_uint] = std::make_pair(1.0, 0.0);
+  _region_extinction[invalid_uint] = std::vector<double>(lamdas.size(), 0.0);
+}
+
+
+unsigned int RayTraceSolver::wave_bundle(unsigned int first)
+{
+  const double lamda = _optical_sources[first].wave_length;
+
+  std::vector<double> r_index;
+  for(unsigned int n=0; n<_system.n_regions(); ++n)
+    r_index.push_back(_system.region(n)->get_optical_refraction(lamda).real());
+
+  unsigned int n_waves = 1;
+  for( ; n_waves<LightThread::max_waves && first+n_waves<_optical_sources.size(); ++n_waves)
+  {
+    const double lamda_next = _optical_sources[first+n_waves].wave_length;
+
+    bool same_path = true;
+    for(unsigned int n=0; n<_system.n_regions() && same_path; ++n)
+    {
+      double r = _system.region(n)->get_optical_refraction(lamda_next).real();
+      if( std::abs(r - r_index[n]) > _wave_tolerance*std::abs(r_index[n]) )
+        same_path = false;
+    }
+    if(!same_path) break;
+  }
+
+  return n_waves;
 }
 
 
@@ -439,6 +530,34 @@ const Elem * RayTraceSolver::ray_hit(const Point &p, const Point &dir, const Ele
 }
 
 
+bool RayTraceSolver::jump_to_interface(LightThread *ray, const Elem *elem) const
+{
+  const unsigned int sub_id = elem->subdomain_id();
+  if(get_refractive_index_im(sub_id) != 0.0) return false;
+  if(sub_id >= _region_face_bvh.size()) return false;
+
+  unsigned int side;
+  double t;
+  const Elem * exit_elem = _region_face_bvh[sub_id]->hit(ray->start_point(), ray->dir(), 1e-10, side, t);
+  if(exit_elem==NULL || exit_elem==elem) return false;
+
+  // the ray should cross exit_elem and leave it by the interface side,
+  // otherwise (it passes a vertex or runs along a side) we step as usual
+  IntersectionResult result;
+  exit_elem->ray_hit(ray->start_point(), ray->dir(), result, _dim);
+  if(result.state!=Intersect_Body || result.hit_points.size()!=2) return false;
+  if(result.hit_points[0].t < 0) return false;
+
+  const Hit_Point & end_point = result.hit_points[1];
+  if(end_point.point_location!=on_face && end_point.point_location!=on_side) return false;
+  if(end_point.mark!=side) return false;
+
+  ray->hit_elem = exit_elem;
+  ray->result   = result;
+  return true;
+}
+
+
 void RayTraceSolver::create_rays()
 {
 
@@ -551,29 +670,85 @@ void RayTraceSolver::create_rays()
     _dim = 2;
   }
 
-  // compute start point on all the processors
+  // all the processors know all the rays, they are distributed for each wave length
   _total_rays = ray_start_points.size();
-  unsigned int on_process_rays = ray_start_points.size()/Genius::n_processors();
-  unsigned int begin = on_process_rays*Genius::processor_id();
-  unsigned int end   = std::min(begin+on_process_rays, ray_start_points.size());
-  for(unsigned int n=begin; n<end; ++n)
-    _wave_plane.ray_start_points.push_back(ray_start_points[n]);
+  _wave_plane.ray_start_points.swap(ray_start_points);
+  _ray_cost.clear();
 
 }
 
 
 
-void RayTraceSolver::ray_tracing(LightThread *ray)
+void RayTraceSolver::distribute_rays()
+{
+  const unsigned int n_processors = Genius::n_processors();
+  const unsigned int processor_id = Genius::processor_id();
+
+  _wave_plane.local_rays.clear();
+
+  // no cost known yet, deal the rays round robin
+  if( _ray_cost.size() != _total_rays )
+  {
+    for(unsigned int n=processor_id; n<_total_rays; n+=n_processors)
+      _wave_plane.local_rays.push_back(n);
+    return;
+  }
+
+  // the most expensive ray goes first to the least loaded processor.
+  // every processor does the same, so the result is identical
+  std::vector<std::pair<unsigned int, unsigned int> > order;
+  order.reserve(_total_rays);
+  for(unsigned int n=0; n<_total_rays; ++n)
+    order.push_back(std::make_pair(_ray_cost[n], n));
+  std::sort(order.begin(), order.end(), ray_cost_greater());
+
+  typedef std::pair<unsigned long long, unsigned int> Load;
+  std::priority_queue<Load, std::vector<Load>, std::greater<Load> > loads;
+  for(unsigned int p=0; p<n_processors; ++p)
+    loads.push(std::make_pair(0ull, p));
+
+  for(unsigned int n=0; n<order.size(); ++n)
+  {
+    Load load = loads.top();
+    loads.pop();
+    // a missed ray still costs the search of the surface tree
+    load.first += order[n].first + 1;
+    if( load.second == processor_id )
+      _wave_plane.local_rays.push_back(order[n].second);
+    loads.push(load);
+  }
+
+  std::sort(_wave_plane.local_rays.begin(), _wave_plane.local_rays.end());
+}
+
+
+
+/**
+ * add \p fraction of the energy loss of each wave length to elem \p id
+ */
+static inline void deposit(std::vector<double> & energy_deposit_in_elem, unsigned int id, unsigned int n_waves, const double * loss, double fraction)
+{
+  double * e = &energy_deposit_in_elem[id*n_waves];
+  for(unsigned int w=0; w<n_waves; ++w)
+    e[w] += fraction*loss[w];
+}
+
+
+unsigned int RayTraceSolver::ray_tracing(LightThread *ray, std::vector<double> & energy_deposit_in_elem) const
 {
 
   // use stack to save all the rays (origin and secondary)
   std::stack<LightThread *> ray_stack;
   ray_stack.push(ray);
 
+  // the number of traced segments
+  unsigned int n_segments = 0;
+
   while(!ray_stack.empty())
   {
     LightThread * current_ray = ray_stack.top();
     ray_stack.pop();
+    n_segments++;
 
     if(current_ray==NULL) continue;
 
@@ -653,7 +828,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
 
             //split current_ray, each edge on boundary shoud be shared by 2 elem
             unsigned int effective_faces = 2;
-            current_ray->power() = current_ray->power()/effective_faces;
+            current_ray->scale_power(1.0/effective_faces);
 
             for(unsigned int n=0; n<elems.size(); ++n)
             {
@@ -725,7 +900,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
               effective_faces++;
             }
             */
-            current_ray->power() = current_ray->power()/elems.size();
+            current_ray->scale_power(1.0/elems.size());
 
             for(unsigned int n=0; n<elems.size(); ++n)
             {
@@ -800,22 +975,24 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
     const Elem * elem = current_ray->hit_elem;
 
     Hit_Point  end_point = current_ray->result.hit_points[1];
-    double energy_deposit = current_ray->advance_to(end_point.p, get_refractive_index_im(elem->subdomain_id()));
+    double energy_deposit[LightThread::max_waves];
+    current_ray->advance_to(end_point.p, get_extinction(elem->subdomain_id()), energy_deposit);
+    const unsigned int n_waves = current_ray->n_waves();
 
     switch(current_ray->result.state)
     {
         // all the energy deposited in this elem
         case Intersect_Body :
-        _energy_deposit_in_elem[elem->id()] += energy_deposit;
+        deposit(energy_deposit_in_elem, elem->id(), n_waves, energy_deposit, 1.0);
         break;
         // two elem shares the energy deposite
         case On_Face        :
         {
-          _energy_deposit_in_elem[elem->id()] += 0.5*energy_deposit;
+          deposit(energy_deposit_in_elem, elem->id(), n_waves, energy_deposit, 0.5);
           unsigned int side = current_ray->result.mark;
           const Elem * neighbor = elem->neighbor(side);
           if(neighbor)
-            _energy_deposit_in_elem[neighbor->id()] += 0.5*energy_deposit;
+            deposit(energy_deposit_in_elem, neighbor->id(), n_waves, energy_deposit, 0.5);
           break;
         }
         // all the elems have this edge shares the deposited energy
@@ -826,7 +1003,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
           const std::vector<const Elem *> & elems = _elems_shared_this_edge.find(edge.get())->second;
           assert(elems.size());
           for(unsigned int n=0; n<elems.size(); ++n)
-            _energy_deposit_in_elem[elems[n]->id()] += energy_deposit/elems.size();
+            deposit(energy_deposit_in_elem, elems[n]->id(), n_waves, energy_deposit, 1.0/elems.size());
           break;
         }
         //we should never reach here
@@ -841,13 +1018,14 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
     // force to exit
     if(ray_stack.size()>1000)
     {
+      delete current_ray;
       while(!ray_stack.empty())
       {
         LightThread * current_ray = ray_stack.top();
         ray_stack.pop();
         delete current_ray;
       }
-      return;
+      return n_segments;
     }
 
     // find next ray elem intersection
@@ -862,8 +1040,11 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
           const Elem * next_elem = elem->neighbor(side);
           if(next_elem && next_elem->subdomain_id() == elem->subdomain_id())
           {
-            current_ray->hit_elem = next_elem;
-            next_elem->ray_hit(current_ray->start_point(), current_ray->dir(), current_ray->result, _dim);
+            if(!jump_to_interface(current_ray, elem))
+            {
+              current_ray->hit_elem = next_elem;
+              next_elem->ray_hit(current_ray->start_point(), current_ray->dir(), current_ray->result, _dim);
+            }
             ray_stack.push(current_ray);
           }
           else //we are on material interface
@@ -938,7 +1119,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
 
             //split current_ray, each edge on boundary shoud be shared by 2 elem
             unsigned int effective_faces = 2;
-            current_ray->power() = current_ray->power()/effective_faces;
+            current_ray->scale_power(1.0/effective_faces);
 
             for(unsigned int n=0; n<elems.size(); ++n)
             {
@@ -988,7 +1169,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
         {
           unsigned int vertex_index = end_point.mark;
           const Node * node = elem->get_node(vertex_index);
-          std::vector<const Elem *> & elems = _elems_shared_this_node[node->id()];
+          const std::vector<const Elem *> & elems = _elems_shared_this_node[node->id()];
           // the node is not on boundary
           if( _boundary_node_to_elem_side_map.find(node)==_boundary_node_to_elem_side_map.end())
           {
@@ -1014,7 +1195,7 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
               if(norm.dot(current_ray->dir()) > -1e-10) continue;
               effective_faces++;
             }
-            current_ray->power() = current_ray->power()/effective_faces;
+            current_ray->scale_power(1.0/effective_faces);
 
             for(unsigned int n=0; n<elems.size(); ++n)
             {
@@ -1064,6 +1245,8 @@ void RayTraceSolver::ray_tracing(LightThread *ray)
     }
 
   }
+
+  return n_segments;
 }
 
 
@@ -19,9 +19,10 @@
 /*                                                                              */
 /********************************************************************************/
 #include "solver_base.h"
+#include "spice_ckt.h"
 
 SolverBase::SolverBase(SimulationSystem & system)
-  :_system(system), _dom_solution_root(NULL), _dom_curr_solution(NULL)
+  :_system(system), _record_steps(true), _step_hooks(true), _dom_solution_root(NULL), _dom_curr_solution(NULL), _stop_requested(false)
 {
 }
 
@@ -31,6 +32,9 @@ SolverBase::~SolverBase()
 
 int SolverBase::create_solver()
 {
+  // the hooks read the columns of iv store
+  init_iv_store();
+
   // call hook function on_init
   hook_list()->on_init();
   return 0;
@@ -49,21 +53,234 @@ int SolverBase::destroy_solver()
 
 int SolverBase::pre_solve_process(bool /*load_solution*/)
 {
+  // the solver may load a new solution
+  _system.new_solution_version();
+
   // call (user defined) hook function hook_pre_solve_process
-  hook_list()->pre_solve();
+  if( _step_hooks )
+    hook_list()->pre_solve();
 
   return 0;
 }
 
 int SolverBase::post_solve_process()
 {
+  // the solution of this step is ready, the hooks share the output fields evaluated for it
+  _system.new_solution_version();
+
+  // electrode currents are updated by the boundary conditions, the charges are evaluated here once
+  _system.get_bcs()->update_electrode_charge();
+
+  // the terminal results of this step
+  if( _record_steps )
+    record_iv();
+
   // call (user defined) hook function hook_post_solve_process
-  hook_list()->post_solve();
+  if( _step_hooks )
+    hook_list()->post_solve();
 
   return 0;
 }
 
 
+/**
+ * the name of electrode in iv store
+ */
+static std::string _iv_label(const BoundaryCondition *bc)
+{
+  if( bc->is_electrode() && !bc->electrode_label().empty() )
+    return bc->electrode_label();
+  return bc->label();
+}
+
+
+void SolverBase::replace_iv_rows(unsigned int r, const std::vector<double> &rows)
+{
+  const unsigned int n_columns = _iv_store.n_columns();
+  if( !n_columns ) return;
+
+  _iv_store.truncate(r);
+  for(unsigned int n=0; n+n_columns<=rows.size(); n+=n_columns)
+    _iv_store.append_row(std::vector<double>(rows.begin()+n, rows.begin()+n+n_columns));
+}
+
+
+unsigned int SolverBase::iv_column(const BoundaryCondition *bc, const std::string &quantity) const
+{
+  return _iv_store.column_index(_iv_label(bc) + "_" + quantity);
+}
+
+
+void SolverBase::init_iv_store()
+{
+  _iv_store.clear();
+
+  const SolverSpecify::SolverType solver_type = this->solver_type();
+  const bool mixA = ( solver_type == SolverSpecify::DDML1MIXA ||
+                      solver_type == SolverSpecify::DDML2MIXA ||
+                      solver_type == SolverSpecify::EBML3MIXA );
+
+  const BoundaryConditionCollector * bcs = _system.get_bcs();
+
+  if( SolverSpecify::Type==SolverSpecify::DCSWEEP || SolverSpecify::Type==SolverSpecify::TRANSIENT )
+  {
+    // if transient simulation, we need to record time
+    if ( SolverSpecify::Type == SolverSpecify::TRANSIENT )
+    {
+      _iv_store.add_column("time", "time");
+      _iv_store.add_column("time_step", "time");
+    }
+
+    if( !mixA )
+    {
+      for(unsigned int n=0; n<bcs->n_bcs(); n++)
+      {
+        const BoundaryCondition * bc = bcs->get_bc(n);
+        const std::string bc_label = _iv_label(bc);
+        // electrode
+        if( bc->is_electrode() )
+        {
+          _iv_store.add_column(bc_label + "_Vapp", "voltage");
+          _iv_store.add_column(bc_label + "_potential", "voltage");
+          _iv_store.add_column(bc_label + "_current", "current");
+          continue;
+        }
+
+        if( bc->has_current_flow() )
+          _iv_store.add_column(bc_label + "_current", "current");
+
+        if( bc->bc_type() == IF_Metal_Ohmic || bc->bc_type() == IF_Metal_Schottky)
+          _iv_store.add_column(bc_label + "_average_potential", "voltage");
+
+        // charge integral interface
+        if( bc->bc_type() == ChargeIntegral )
+        {
+          _iv_store.add_column(bc_label + "_Q", "charge");
+          _iv_store.add_column(bc_label + "_potential", "voltage");
+        }
+      }
+
+      // electrode charges are not in the text views
+      for(unsigned int n=0; n<bcs->n_bcs(); n++)
+      {
+        const BoundaryCondition * bc = bcs->get_bc(n);
+        if( bc->is_electrode() )
+          _iv_store.add_column(_iv_label(bc) + "_charge", "charge", false);
+      }
+    }
+    else
+    {
+      const SPICE_CKT * spice_ckt = _system.get_circuit();
+      for(unsigned int n=0; n<spice_ckt->n_ckt_nodes(); n++)
+        _iv_store.add_column(spice_ckt->ckt_node_name(n), spice_ckt->is_voltage_node(n) ? "voltage" : "current");
+    }
+  }
+
+  if( SolverSpecify::Type==SolverSpecify::ACSWEEP )
+  {
+    _iv_store.add_column("frequency", "Hz");
+
+    for(unsigned int n=0; n<bcs->n_bcs(); n++)
+    {
+      const BoundaryCondition * bc = bcs->get_bc(n);
+      // skip bc which is not electrode
+      if( !bc->is_electrode() ) continue;
+
+      const std::string bc_label = _iv_label(bc);
+      _iv_store.add_column(bc_label + "_potential_magnitude", "voltage");
+      _iv_store.add_column(bc_label + "_potential_angle",     "");
+      _iv_store.add_column(bc_label + "_current_magnitude",   "current");
+      _iv_store.add_column(bc_label + "_current_angle",       "");
+    }
+  }
+}
+
+
+void SolverBase::record_iv()
+{
+  if( !_iv_store.n_columns() ) return;
+
+  const SolverSpecify::SolverType solver_type = this->solver_type();
+  const bool mixA = ( solver_type == SolverSpecify::DDML1MIXA ||
+                      solver_type == SolverSpecify::DDML2MIXA ||
+                      solver_type == SolverSpecify::EBML3MIXA );
+
+  const BoundaryConditionCollector * bcs = _system.get_bcs();
+
+  // the same order as init_iv_store()
+  std::vector<double> row;
+  row.reserve(_iv_store.n_columns());
+
+  if( SolverSpecify::Type==SolverSpecify::DCSWEEP || SolverSpecify::Type==SolverSpecify::TRANSIENT )
+  {
+    if (SolverSpecify::Type == SolverSpecify::TRANSIENT)
+    {
+      row.push_back( SolverSpecify::clock/PhysicalUnit::s );
+      row.push_back( SolverSpecify::dt/PhysicalUnit::s );
+    }
+
+    if( !mixA )
+    {
+      for(unsigned int n=0; n<bcs->n_bcs(); n++)
+      {
+        const BoundaryCondition * bc = bcs->get_bc(n);
+        if( bc->is_electrode() )
+        {
+          row.push_back( bc->ext_circuit()->Vapp()/PhysicalUnit::V );
+          row.push_back( bc->ext_circuit()->potential()/PhysicalUnit::V );
+          row.push_back( bc->ext_circuit()->current()/PhysicalUnit::A );
+          continue;
+        }
+
+        if( bc->has_current_flow() )
+          row.push_back( bc->current()/PhysicalUnit::A );
+
+        if( bc->bc_type() == IF_Metal_Ohmic || bc->bc_type() == IF_Metal_Schottky)
+          row.push_back( bc->psi()/PhysicalUnit::V );
+
+        if( bc->bc_type() == ChargeIntegral )
+        {
+          row.push_back( bc->Qf()/PhysicalUnit::C );
+          row.push_back( bc->psi()/PhysicalUnit::V );
+        }
+      }
+
+      // the charge is evaluated by BoundaryConditionCollector::update_electrode_charge()
+      for(unsigned int n=0; n<bcs->n_bcs(); n++)
+      {
+        const BoundaryCondition * bc = bcs->get_bc(n);
+        if( bc->is_electrode() )
+          row.push_back( bc->ext_circuit()->charge()/PhysicalUnit::C );
+      }
+    }
+    else
+    {
+      const SPICE_CKT * spice_ckt = _system.get_circuit();
+      for(unsigned int n=0; n<spice_ckt->n_ckt_nodes(); n++)
+        row.push_back( spice_ckt->get_solution(n) );
+    }
+  }
+
+  if( SolverSpecify::Type==SolverSpecify::ACSWEEP )
+  {
+    row.push_back( SolverSpecify::Freq*PhysicalUnit::s );
+
+    for(unsigned int n=0; n<bcs->n_bcs(); n++)
+    {
+      const BoundaryCondition * bc = bcs->get_bc(n);
+      if( !bc->is_electrode() ) continue;
+
+      row.push_back( std::abs(bc->ext_circuit()->potential_ac())/PhysicalUnit::V );
+      row.push_back( std::arg(bc->ext_circuit()->potential_ac()) );
+      row.push_back( std::abs(bc->ext_circuit()->current_ac())/PhysicalUnit::A );
+      row.push_back( std::arg(bc->ext_circuit()->current_ac()) );
+    }
+  }
+
+  _iv_store.append_row(row);
+}
+
+
 void SolverBase::set_solution_dom_root(mxml_node_t* root)
 {
   _dom_solution_root = root;
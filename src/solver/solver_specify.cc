@@ -64,6 +64,11 @@ namespace SolverSpecify
    */
   std::string      out_prefix;
 
+  /**
+   * write the IV results in binary: SPICE binary raw file and the columnar iv store
+   */
+  bool             IVBinary;
+
   /**
    * hooks to be installed \<id \<hook_name, hook_parameters\> \>
    */
@@ -130,6 +135,16 @@ namespace SolverSpecify
   */
   double   potential_update;
 
+  /**
+   * the max ratio a carrier density may grow in one Newton step with avalanche damping
+   */
+  double   carrier_update;
+
+  /**
+   * evaluate the derivative of impact ionization coefficient by its projection on the driving force
+   */
+  bool     IIProjectedJacobian;
+
   /**
    * When absolute error of equation less
    * than this value, solution is considered converged.
@@ -195,6 +210,104 @@ namespace SolverSpecify
    */
   double      electrode_abs_toler;
 
+  //--------------------------------------------
+  // preconditioner reuse
+  //--------------------------------------------
+
+  /**
+   * rebuild the preconditioner every PCLag times the jacobian is built in a Newton solve,
+   * -1 never rebuilds it after the first one
+   */
+  int         PCLag;
+
+  /**
+   * keep the ordering, fill and symbolic factorization of factor preconditioners (LU/ILU/ICC and
+   * the external direct solvers) across Newton iterations and bias steps
+   */
+  bool        PCReuseOrdering;
+
+  //--------------------------------------------
+  // jacobian storage
+  //--------------------------------------------
+
+  /**
+   * store the jacobian matrix in BAIJ format with node-level blocks,
+   * only used when every dof row belongs to a block of the same size
+   */
+  bool        JacobianBlock;
+
+  /**
+   * PETSC matrix type of the jacobian, i.e. aijcusparse for GPU linear solvers.
+   * empty for the default host AIJ/BAIJ format
+   */
+  std::string MatrixType;
+
+  /**
+   * PETSC vector type of the global solution/residual vectors, should match MatrixType.
+   * empty for the default host vector
+   */
+  std::string VectorType;
+
+  //--------------------------------------------
+  // jacobian reuse
+  //--------------------------------------------
+
+  /**
+   * keep the jacobian matrix (and the factorized preconditioner) across
+   * Newton iterations and sweep steps, rebuild it only when the residual
+   * reduction stalls
+   */
+  bool        JacobianReuse;
+
+  /**
+   * max Newton iterations one jacobian matrix can be reused
+   */
+  unsigned int JacobianReuseMax;
+
+  /**
+   * rebuild the jacobian matrix when the function norm reduction of one Newton
+   * iteration, |F|_{k}/|F|_{k-1}, is larger than this value
+   */
+  double      JacobianReuseRatio;
+
+  /**
+   * DDM1: keep the jacobian contribution of each region, and reuse it while the solution of
+   * the region hardly changes, i.e. the regions far from the swept electrode
+   */
+  bool        RegionJacobianReuse;
+
+  /**
+   * a region jacobian is reused while no potential changes more than this times kT/q, and
+   * no carrier density changes more than this ratio since the jacobian was evaluated
+   */
+  double      RegionJacobianReuseTol;
+
+  /**
+   * Jacobian-free Newton-Krylov: the Krylov solver uses matrix free jacobian-vector product
+   * by finite difference of the residual, the assembled jacobian matrix is only used as preconditioner
+   */
+  bool        JFNK;
+
+  //--------------------------------------------
+  // direct solver refinement
+  //--------------------------------------------
+
+  /**
+   * factorize the equilibrated jacobian with static pivoting by MUMPS/SuperLU_DIST, and
+   * recover the accuracy by GMRES against the jacobian with the factorization as preconditioner
+   */
+  bool        DirectRefine;
+
+  //--------------------------------------------
+  // device/circuit coupling of mixed mode solvers
+  //--------------------------------------------
+
+  /**
+   * eliminate the device dofs to a schur complement on the spice circuit dofs, the device block is
+   * factorized alone and the small circuit system is solved by GMRES on the complement
+   */
+  bool        SpiceSchur;
+
   //--------------------------------------------
   // TS (transient solver)
   //--------------------------------------------
@@ -240,6 +353,21 @@ namespace SolverSpecify
    */
   bool      Predict;
 
+  /**
+   * max order of polynomial predict of DC sweep, 1 for linear (secant) and 2 for quadratic
+   */
+  unsigned int PredictOrder;
+
+  /**
+   * adjust the step of DC sweep by Newton iterations of last bias point, bounded by VStepMax/IStepMax
+   */
+  bool      SweepAutoStep;
+
+  /**
+   * the Newton iterations of one bias point the adaptive DC sweep step aims at
+   */
+  unsigned int SweepAutoStepIts;
+
   /**
    * relative tol of TS truncate error, used in AutoStep
    */
@@ -250,6 +378,27 @@ namespace SolverSpecify
    */
   double    TS_atol;
 
+  /**
+   * use PI controller (on the LTE of current and last step) instead of the basic controller in AutoStep
+   */
+  bool      TS_PIControl;
+
+  /**
+   * mixed mode transient: spice circuit advances with its own sub-steps between device steps,
+   * the device is seen by the circuit as a norton companion of the last synchronized step
+   */
+  bool      SpiceMultirate;
+
+  /**
+   * relative change of electrode voltage after which the circuit sub-steps stop and the device is synchronized
+   */
+  double    SpiceMultirateTol;
+
+  /**
+   * max number of circuit sub-steps between two device steps
+   */
+  int       SpiceMultirateSubsteps;
+
   /**
    * indicate BDF2 can be started.
    */
@@ -290,6 +439,43 @@ namespace SolverSpecify
    */
   int       T_Cycles;
 
+  /**
+   * binary checkpoint file of transient simulation, empty for no checkpoint
+   */
+  std::string CheckpointFile;
+
+  /**
+   * write transient checkpoint every this number of time steps
+   */
+  unsigned int CheckpointSteps;
+
+  /**
+   * resume transient simulation from this binary checkpoint file, empty for a fresh start
+   */
+  std::string RestartFile;
+
+  /**
+   * period of periodic steady state (PSS) detection, transient stops when the solution
+   * changes less than PSSTol over one period. 0 for no detection
+   */
+  double    PSSPeriod;
+
+  /**
+   * relative tolerance of PSS detection
+   */
+  double    PSSTol;
+
+  /**
+   * number of time slices of parareal coarse pass. when nonzero, transient runs a BDF1 pass with one step
+   * per slice and writes a checkpoint at each slice boundary, the fine slices are then run as restarts
+   */
+  unsigned int PararealSlices;
+
+  /**
+   * checkpoint of the coarse pass at the end of this slice, the fine slice reports its jump to it
+   */
+  std::string PararealNext;
+
   //------------------------------------------------------
   // parameters for DC and TRACE simulation
   //------------------------------------------------------
@@ -364,6 +550,23 @@ namespace SolverSpecify
    */
   double    RampUpIStep;
 
+  /**
+   * when Newton fails at the first bias point of steadystate or DC sweep, reach it by
+   * adaptive bias ramping from the last solution and then pseudo transient continuation
+   */
+  bool      Homotopy;
+
+  /**
+   * start steadystate and DC sweep from the converged solution of the nearest electrode bias
+   * solved before on this system, i.e. by an earlier SOLVE command
+   */
+  bool      BiasCache;
+
+  /**
+   * the number of slices of DC voltage sweep, which are solved at the same time by
+   * the bias process groups (genius -bias_groups n). 1 for serial sweep
+   */
+  unsigned int ParallelBias;
 
   /**
    * the initial value of gmin
@@ -417,6 +620,17 @@ namespace SolverSpecify
    */
   double    Freq;
 
+  /**
+   * the number of frequencies in one batch for AC sweep. the matrix is factorized at the first frequency of each batch,
+   * the other frequencies of the batch are solved by GMRES preconditioned with this factorization
+   */
+  unsigned int ACBatch;
+
+  /**
+   * the order of reduced model for AC sweep, 0 for solving the full AC system at each frequency
+   */
+  unsigned int ACMOROrder;
+
 
   //------------------------------------------------------
   // parameters for MIX simulation
@@ -441,6 +655,7 @@ namespace SolverSpecify
   {
     Solver            = DDML1;
     Type              = EQUILIBRIUM;
+    IVBinary          = false;
     NS                = LineSearch;
 #ifdef PETSC_HAVE_MUMPS
     LS                = MUMPS;
@@ -456,6 +671,8 @@ namespace SolverSpecify
 
     MaxIteration              = 30;
     potential_update          = 1.0;
+    carrier_update            = 10.0;
+    IIProjectedJacobian       = false;
 
     ksp_rtol                  = 1e-8;
     ksp_atol                  = 1e-20;
@@ -474,13 +691,41 @@ namespace SolverSpecify
     elec_quantum_abs_toler    = 1e-29*C;
     hole_quantum_abs_toler    = 1e-29*C;
 
+    JacobianReuse             = false;
+    JacobianReuseMax          = 5;
+    JacobianReuseRatio        = 0.5;
+    RegionJacobianReuse       = false;
+    RegionJacobianReuseTol    = 1e-3;
+    JFNK                      = false;
+    JacobianBlock             = false;
+    MatrixType                = "";
+    VectorType                = "";
+    PCLag                     = 1;
+    PCReuseOrdering           = false;
+    DirectRefine              = false;
+    SpiceSchur                = false;
+
     TimeDependent     = false;
     TS_type           = BDF2;
     BDF2_restart      = true;
     UIC               = false;
     tran_op           = true;
     AutoStep          = true;
+    TS_PIControl      = false;
+    SpiceMultirate    = false;
+    SpiceMultirateTol = 1e-2;
+    SpiceMultirateSubsteps = 32;
+    CheckpointFile    = "";
+    CheckpointSteps   = 10;
+    RestartFile       = "";
+    PSSPeriod         = 0.0;
+    PSSTol            = 1e-4;
+    PararealSlices    = 0;
+    PararealNext      = "";
     Predict           = true;
+    PredictOrder      = 2;
+    SweepAutoStep     = false;
+    SweepAutoStepIts  = 6;
     clock             = 0.0;
 
     VStepMax          = 1.0;
@@ -489,11 +734,16 @@ namespace SolverSpecify
     RampUpSteps       = 1;
     RampUpVStep       = 0.25;
     RampUpIStep       = 0.1;
+    Homotopy          = true;
+    BiasCache         = false;
+    ParallelBias      = 1;
 
     GminInit          = 1e-6;
     Gmin              = 1e-12;
 
     VAC               = 0.0;
+    ACBatch           = 1;
+    ACMOROrder        = 0;
     OptG              = false;
     PatG              = false;
   }
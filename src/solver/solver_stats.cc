@@ -0,0 +1,165 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <fstream>
+#include <limits>
+#include <algorithm>
+
+#include "genius_env.h"
+#include "genius_common.h"
+#include "solver_stats.h"
+
+
+bool SolverStats::_enabled = false;
+std::vector<SolverStats::Listener *> SolverStats::_listeners;
+
+namespace
+{
+  std::ofstream _stats_out;
+
+  // escape the chars not allowed in json string
+  std::string json_string(const std::string &s)
+  {
+    std::string out("\"");
+    for(unsigned int i=0; i<s.size(); ++i)
+    {
+      if( s[i] == '"' || s[i] == '\\' ) out += '\\';
+      if( static_cast<unsigned char>(s[i]) < 0x20 ) continue;
+      out += s[i];
+    }
+    out += '"';
+    return out;
+  }
+}
+
+
+void SolverStats::open(const std::string &file)
+{
+  _enabled = true;
+
+  if( !Genius::is_first_processor() ) return;
+
+  _stats_out.open(file.c_str());
+  if( !_stats_out.good() )
+  {
+    std::cerr << "Warning: can not open solver statistics file " << file << std::endl;
+    _enabled = false;
+  }
+}
+
+
+void SolverStats::close()
+{
+  if( _stats_out.is_open() )
+    _stats_out.close();
+  _enabled = false;
+}
+
+
+void SolverStats::add_listener(Listener *listener)
+{
+  if( std::find(_listeners.begin(), _listeners.end(), listener) == _listeners.end() )
+    _listeners.push_back(listener);
+}
+
+
+void SolverStats::remove_listener(Listener *listener)
+{
+  _listeners.erase(std::remove(_listeners.begin(), _listeners.end(), listener), _listeners.end());
+}
+
+
+SolverStats::SolverStats(const std::string &record)
+  : _kind(record)
+{
+  _record.precision(std::numeric_limits<double>::digits10);
+  _record << "{\"record\":" << json_string(record);
+}
+
+
+void SolverStats::_key(const std::string &key)
+{
+  _record << ',' << json_string(key) << ':';
+}
+
+
+SolverStats & SolverStats::add(const std::string &key, double value)
+{
+  _key(key);
+  if( !_listeners.empty() ) _values.push_back(std::make_pair(key, value));
+  // json has no inf or nan
+  if( value != value || value > std::numeric_limits<double>::max() || value < -std::numeric_limits<double>::max() )
+    _record << "null";
+  else
+    _record << value;
+  return *this;
+}
+
+
+SolverStats & SolverStats::add(const std::string &key, int value)
+{
+  _key(key);
+  if( !_listeners.empty() ) _values.push_back(std::make_pair(key, static_cast<double>(value)));
+  _record << value;
+  return *this;
+}
+
+
+SolverStats & SolverStats::add(const std::string &key, unsigned int value)
+{
+  _key(key);
+  if( !_listeners.empty() ) _values.push_back(std::make_pair(key, static_cast<double>(value)));
+  _record << value;
+  return *this;
+}
+
+
+SolverStats & SolverStats::add(const std::string &key, bool value)
+{
+  _key(key);
+  if( !_listeners.empty() ) _values.push_back(std::make_pair(key, value ? 1.0 : 0.0));
+  _record << (value ? "true" : "false");
+  return *this;
+}
+
+
+SolverStats & SolverStats::add(const std::string &key, const std::string &value)
+{
+  _key(key);
+  if( !_listeners.empty() ) _strings.push_back(std::make_pair(key, value));
+  _record << json_string(value);
+  return *this;
+}
+
+
+void SolverStats::write()
+{
+  if( !Genius::is_first_processor() ) return;
+
+  for(unsigned int n=0; n<_listeners.size(); ++n)
+    _listeners[n]->record(_kind, _values, _strings);
+
+  if( !_enabled ) return;
+
+  _record << '}';
+  _stats_out << _record.str() << '\n';
+  _stats_out.flush();
+}
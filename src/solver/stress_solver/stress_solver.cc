@@ -24,36 +24,78 @@
 
 #include "elem.h"
 #include "mesh_base.h"
+#include "boundary_info.h"
 #include "stress_solver/stress_solver.h"
 #include "solver_specify.h"
 #include "fe_type.h"
 #include "fe_base.h"
 #include "quadrature_gauss.h"
-#include "tensor_value.h"
+#include "physical_unit.h"
+#include "petsc_utils.h"
 
 
 /*------------------------------------------------------------------
- * create the poisson solver contex
+ * add the eigenstrain of STRESS.LOAD card to its load case
  */
-int StressSolver::create_solver()
+void StressSolver::add_load(const Parser::Card & c)
 {
-  MESSAGE<< '\n' << "Stress Solver init..." << std::endl;
-  RECORD();
+  const std::string name   = c.get_string("id", "");
+  const std::string label  = c.get_string("region", "");
 
+  const SimulationRegion * region = _system.region(label);
+  if( region == NULL || !_solid(region) )
+  {
+    MESSAGE<<"ERROR at " <<c.get_fileline()<< " STRESS.LOAD: region " << label << " is not a solid region.\n";
+    RECORD();
+    genius_error();
+  }
 
-  // adjust default snes/ksp/pc/mat/vec settings
+  // isotropic eigenstrain, the stress is C(e-e0)
+  double e0 = 0.0;
+  if( c.is_enum_value("type", "intrinsic") )
+  {
+    // the strain of a clamped layer with intrinsic stress sigma
+    const double E  = _card.get_real("young", 1.69e11);
+    const double nu = _card.get_real("poisson", 0.28);
+    e0 = -c.get_real("sigma", 0.0)*(1-2*nu)/E;
+  }
+  else
+    e0 = c.get_real("alpha", 0.0)*c.get_real("dt", 0.0);
 
-  // use BCGS as default solver
-  KSPSetType(ksp, KSPBCGS);
+  unsigned int i=0;
+  for(; i<_load_cases.size(); ++i)
+    if( _load_cases[i].name == name ) break;
+  if( i == _load_cases.size() )
+  {
+    _load_cases.push_back(LoadCase());
+    _load_cases.back().name = name;
+  }
+  _load_cases[i].eigenstrain.push_back( std::make_pair(region->subdomain_id(), e0) );
+}
 
-  // Set user-specified  solver and preconditioner types
-  set_petsc_linear_solver_type    ( SolverSpecify::LS );
-  set_petsc_preconditioner_type   ( SolverSpecify::PC );
+
+/*------------------------------------------------------------------
+ * create the stress solver contex
+ */
+int StressSolver::create_solver()
+{
+  MESSAGE<< '\n' << "Stress Solver init..." << std::endl;
+  RECORD();
+
+  _E  = _card.get_real("young", 1.69e11);
+  _nu = _card.get_real("poisson", 0.28);
 
   // must set linear matrix/vector here!
   setup_linear_data();
 
-  //SNESLineSearchSet(snes,SNESLineSearchNo, 0);
+  // use BCGS with AMG preconditioner as default solver
+  KSPSetType(ksp, KSPBCGS);
+#if PETSC_VERSION_GE(3,3,0)
+  // GAMG takes the rigid body modes as near null space
+  PCSetType(pc, PCGAMG);
+#else
+  set_petsc_preconditioner_type ( SolverSpecify::BOOMERAMG_PRECOND );
+#endif
 
   // rtol   = 1e-10*n_global_dofs  - the relative convergence tolerance (relative decrease in the residual norm)
   // abstol = 1e-20*n_global_dofs  - the absolute convergence tolerance (absolute size of the residual norm)
@@ -62,26 +104,82 @@ int StressSolver::create_solver()
   // user can do further adjusment from command line
   KSPSetFromOptions (ksp);
 
-  return 0;
+  // the clamped boundary
+  const std::string label = _card.get_string("fixed", "");
+  const MeshBase & mesh = _system.mesh();
+  short int bd_id = mesh.boundary_info->get_id_by_label(label);
+  if( bd_id == BoundaryInfo::invalid_id )
+  {
+    MESSAGE<<"ERROR at " <<_card.get_fileline()<< " STRESS: boundary " << label << " not found.\n";
+    RECORD();
+    genius_error();
+  }
 
-}
+  std::vector<unsigned int> fixed_nodes;
+  mesh.boundary_info->nodes_with_boundary_id(fixed_nodes, bd_id);
+  _fixed_dofs.clear();
+  for(unsigned int n=0; n<_system.n_regions(); ++n)
+  {
+    const SimulationRegion * region = _system.region(n);
+    if( !_solid(region) ) continue;
+    for(unsigned int i=0; i<fixed_nodes.size(); ++i)
+    {
+      const FVM_Node * fvm_node = region->region_fvm_node(fixed_nodes[i]);
+      if( fvm_node == NULL || !fvm_node->on_processor() ) continue;
+      if( _master(fvm_node) != fvm_node ) continue;
+      for(unsigned int d=0; d<3; ++d)
+        _fixed_dofs.push_back(fvm_node->global_offset()+d);
+    }
+  }
 
+  // the stiffness matrix does not change with load case,
+  // assemble it and set up the preconditioner only once
+  build_matrix(A, A);
+  _set_near_null_space();
+  KSPSetOperators(ksp, A, A, SAME_PRECONDITIONER);
+  KSPSetUp(ksp);
 
+  return 0;
+}
 
 
 
 /*------------------------------------------------------------------
- *
+ * solve all the load cases with the same preconditioner
  */
 int StressSolver::solve()
 {
   START_LOG("StressSolver_Linear()", "StressSolver");
 
-  build_matrix(A, A);
+  if( _load_cases.empty() )
+  {
+    MESSAGE<<"Warning: STRESS has no load case, nothing to do.\n";
+    RECORD();
+  }
+
+  _displacement.resize(_load_cases.size());
+  for(unsigned int i=0; i<_load_cases.size(); ++i)
+  {
+    _current_case = i;
+    build_rhs(b);
+
+    VecZeroEntries(x);
+    KSPSolve(ksp, b, x);
 
-  build_rhs(b);
+    KSPConvergedReason reason;
+    PetscInt its;
+    PetscReal u_max;
+    KSPGetConvergedReason(ksp, &reason);
+    KSPGetIterationNumber(ksp, &its);
+    VecNorm(x, NORM_INFINITY, &u_max);
 
-  KSPSolve(ksp,b,x);
+    MESSAGE<<"  load case " << _load_cases[i].name << ": " << its << " KSP iterations, max displacement "
+           << u_max/PhysicalUnit::nm << " nm" << (reason < 0 ? ", not converged" : "") << '\n';
+    RECORD();
+
+    VecDuplicate(x, &_displacement[i]);
+    VecCopy(x, _displacement[i]);
+  }
 
   STOP_LOG("StressSolver_Linear()", "StressSolver");
 
@@ -90,6 +188,9 @@ int StressSolver::solve()
 
 int StressSolver::destroy_solver()
 {
+  for(unsigned int i=0; i<_displacement.size(); ++i)
+    VecDestroy(_displacement[i]);
+  _displacement.clear();
 
   // clear linear contex
   clear_linear_data();
@@ -99,349 +200,235 @@ int StressSolver::destroy_solver()
 
 
 
-void StressSolver::build_matrix(Mat A, Mat )
+const FVM_Node * StressSolver::_master(const FVM_Node * fvm_node) const
 {
-  // the integral order used in gauss intergral. default value= 2*fe_order+1
-  Order int_order=FIFTH;
+  // only the node on region boundary has ghost nodes
+  if( fvm_node->boundary_id() == BoundaryInfo::invalid_id ) return fvm_node;
 
-  const MeshBase& mesh = _system.mesh();
+  const FVM_Node * master = fvm_node;
+  FVM_Node::fvm_ghost_node_iterator git = fvm_node->ghost_node_begin();
+  for(; git != fvm_node->ghost_node_end(); ++git)
+  {
+    const FVM_Node * ghost_node = (*git).first;
+    if( ghost_node == NULL ) continue;
+    if( !_solid(_system.region(ghost_node->subdomain_id())) ) continue;
+    if( ghost_node->subdomain_id() < master->subdomain_id() )
+      master = ghost_node;
+  }
+  return master;
+}
 
+
+
+void StressSolver::build_matrix(Mat A, Mat )
+{
+  const MeshBase& mesh = _system.mesh();
   const unsigned int dim = mesh.mesh_dimension();
 
+  // linear shape function, second order gauss rule is exact for the stiffness matrix
   FEType fe_type;
-
   AutoPtr<FEBase> fe (FEBase::build(dim, fe_type));
-
-  // Gauss quadrature rule for numerical integration.
-  QGauss qrule (dim, int_order);
-
-  // Tell the finite element object to use our quadrature rule.
+  QGauss qrule (dim, SECOND);
   fe->attach_quadrature_rule (&qrule);
 
-  // Declare a special finite element object for boundary integration.
-  AutoPtr<FEBase> fe_face (FEBase::build(dim, fe_type));
-
-  // Boundary integration requires one quadraure rule,
-  // with dimensionality one less than the dimensionality
-  // of the element.
-  QGauss qface(dim-1, int_order);
+  const std::vector<Real>& JxW = fe->get_JxW();
+  const std::vector<std::vector<Real> >& dphidx = fe->get_dphidx();
+  const std::vector<std::vector<Real> >& dphidy = fe->get_dphidy();
+  const std::vector<std::vector<Real> >& dphidz = fe->get_dphidz();
 
-  // Tell the finite element object to use our
-  // quadrature rule.
-  fe_face->attach_quadrature_rule (&qface);
+  // isotropic material, lame parameters
+  const double lambda = _E*_nu/((1+_nu)*(1-2*_nu));
+  const double mu     = _E/(2*(1+_nu));
 
-  // Here we define some references to cell-specific data that
-  // will be used to assemble the linear system.
-  //
-  // The element Jacobian * quadrature weight at each integration point.
-  const std::vector<Real>& JxW = fe->get_JxW();
+  std::vector<PetscInt> dofs;
+  std::vector<PetscScalar> K;
 
-  // The physical XY locations of the quadrature points on the element.
-  // These might be useful for evaluating spatially varying material
-  // properties at the quadrature points.
-  const std::vector<Point>& q_point = fe->get_xyz();
-
-  // The element shape functions evaluated at the quadrature points.
-  const std::vector<std::vector<Real> >& phi = fe->get_phi();
-
-  // The element shape function gradients evaluated at the quadrature
-  // points.
-  //const std::vector<std::vector<RealGradient> >& dphi = fe->get_dphi();
-  const std::vector<std::vector<Real> >& dphidx       = fe->get_dphidx();
-  const std::vector<std::vector<Real> >& dphidy       = fe->get_dphidy();
-  const std::vector<std::vector<Real> >& dphidz       = fe->get_dphidz();
-
-  // Define data structures to contain the element matrix
-  // and right-hand-side vector contribution.  Following
-  // basic finite element terminology we will denote these
-  // "Ke" and "Fe".  These datatypes are templated on
-  //  Number, which allows the same code to work for real
-  // or complex numbers.
-  //DenseMatrix<Number> Ke;
-  //DenseVector<Number> Fe;
-
-
-  // This vector will hold the degree of freedom indices for
-  // the element.  These define where in the global system
-  // the element degrees of freedom get mapped.
-  //std::vector<unsigned int> dof_indices;
-
-  // Now we will loop over all the elements in the mesh.
-  // We will compute the element matrix and right-hand-side
-  // contribution.
-  //
-  // Element iterators are a nice way to iterate through
-  // all the elements, or all the elements that have some property.
-  // There are many types of element iterators, but here we will
-  // use the most basic type, the  const_elem_iterator.  The iterator
-  //  el will iterate from the first to the last element.  The
-  // iterator  end_el tells us when to stop.  It is smart to make
-  // this one  const so that we don't accidentally mess it up!
-  //   const_elem_iterator           el (mesh.elements_begin());
-  //   const const_elem_iterator end_el (mesh.elements_end());
-
-  //for(unsigned int n=0; n<_system.n_regions(); ++n)
-  //{
-  //	SimulationRegion * region = _system.region(n);
-  //}
-
-  MeshBase::const_element_iterator       el     = mesh.elements_begin();
-  const MeshBase::const_element_iterator end_el = mesh.elements_end();
-
-  //this should be function of node. for convinent, we take parameter as const in every element
-  // you should re_value it for your own use.
-  //VectorValue<double> E;      //yang's modul
-  //TensorValue<double> G;   //shear modul
-  //TensorValue<double> nu;  //possion ratio
-
-  //the stiff matrix. a general stiff matrix named C of 3D is a 6x6 symmetry matrx
-  // so it has 21 independent parameter. in some special case the independent parameter number will be reduce.
-  // note that in 2D case, plane stress and plane strain are two deferent case.
-  double C[6][6]={0.};
-
-  //std::cout<<"k="<<k<<std::endl;
-  // Loop over the elements.  Note that  ++el is preferred to
-  // el++ since the latter requires an unnecessary temporary
-  // object.
-  for ( ; el != end_el ; ++el)
+  for(unsigned int n=0; n<_system.n_regions(); ++n)
   {
-    //material initialization for every element, now only a sample is taken
-    C[0][0]=C[1][1]=C[2][2]=1.e9;
-    C[3][3]=C[4][4]=C[5][5]=1.e8;
+    const SimulationRegion * region = _system.region(n);
+    if( !_solid(region) ) continue;
 
-    // Store a pointer to the element we are currently
-    // working on.  This allows for nicer syntax later.
-    const Elem* elem = *el;
-
-    //matrix K and F are matrix of Ax=b in every element Kx=F, its size are changed with node in element,
-    // so initialize it in every element.
-    unsigned int n_node=elem->n_nodes();
-    unsigned int dim=3;   // 3 is 3D, 2D and 1D are regard as reduced 3D problem.
-    unsigned int dim_stress=6; //6 is the dim of stress. stress is 3x3 symmetry matrix and has 6 independent element.
+    SimulationRegion::const_element_iterator el = region->elements_begin();
+    for( ; el != region->elements_end(); ++el)
+    {
+      const Elem* elem = *el;
+      if( elem->processor_id() != Genius::processor_id() ) continue;
 
-    unsigned int n_node2=n_node*dim;
+      fe->reinit (elem);
 
-    double* K  =new double[n_node2*n_node2];   //K=B'CB
-    double* F  =new double[n_node2];
-    double* CB =new double[dim_stress*n_node2]; //a matrix=C*B
+      // 3 displacement dofs per node, 2D and 1D are regarded as reduced 3D problem
+      const unsigned int n_node = elem->n_nodes();
+      const unsigned int n_dofs = 3*n_node;
+      dofs.resize(n_dofs);
+      for(unsigned int i=0; i<n_node; ++i)
+      {
+        const FVM_Node * fvm_node = _master(region->region_fvm_node(elem->get_node(i)));
+        for(unsigned int d=0; d<3; ++d)
+          dofs[3*i+d] = fvm_node->global_offset()+d;
+      }
 
-    for(unsigned int ii=0;ii<n_node2*n_node2;++ii)
-    {
-      K[ii]=0.;
-    }
+      // K = B'CB, K(ia,jb) = lambda*di_a*dj_b + mu*di_b*dj_a + mu*(grad i . grad j)*delta_ab
+      K.assign(n_dofs*n_dofs, 0.0);
+      for (unsigned int qp=0; qp<qrule.n_points(); qp++)
+        for(unsigned int i=0; i<n_node; i++)
+        {
+          const double di[3] = {dphidx[i][qp], dphidy[i][qp], dphidz[i][qp]};
+          for(unsigned int j=0; j<n_node; j++)
+          {
+            const double dj[3] = {dphidx[j][qp], dphidy[j][qp], dphidz[j][qp]};
+            const double g = mu*(di[0]*dj[0] + di[1]*dj[1] + di[2]*dj[2]);
+            for(unsigned int a=0; a<3; ++a)
+              for(unsigned int b=0; b<3; ++b)
+                K[(3*i+a)*n_dofs + 3*j+b] += JxW[qp]*(lambda*di[a]*dj[b] + mu*di[b]*dj[a] + (a==b ? g : 0.0));
+          }
+        }
 
-    for(unsigned int ii=0;ii<n_node2;++ii)
-    {
-      F[ii]=0.;
+      MatSetValues(A, n_dofs, &dofs[0], n_dofs, &dofs[0], &K[0], ADD_VALUES);
     }
+  }
 
+  MatAssemblyBegin(A, MAT_FLUSH_ASSEMBLY);
+  MatAssemblyEnd(A, MAT_FLUSH_ASSEMBLY);
 
-    // Get the degree of freedom indices for the
-    // current element.  These define where in the global
-    // matrix and right-hand-side this element will
-    // contribute to.
-    //	dof_map.dof_indices (elem, dof_indices);
+  // the dofs of interface node in other regions follow the master one.
+  // scaled by E to keep the diagonal in the range of stiffness entries
+  for(unsigned int n=0; n<_system.n_regions(); ++n)
+  {
+    const SimulationRegion * region = _system.region(n);
+    if( !_solid(region) ) continue;
 
-    // Compute the element-specific data for the current
-    // element.  This involves computing the location of the
-    // quadrature points (q_point) and the shape functions
-    // (phi, dphi) for the current element.
-    fe->reinit (elem);
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    for(; it != region->on_processor_nodes_end(); ++it)
+    {
+      const FVM_Node * fvm_node = *it;
+      const FVM_Node * master = _master(fvm_node);
+      if( master == fvm_node ) continue;
+      for(unsigned int d=0; d<3; ++d)
+      {
+        MatSetValue(A, fvm_node->global_offset()+d, fvm_node->global_offset()+d,  _E, INSERT_VALUES);
+        MatSetValue(A, fvm_node->global_offset()+d, master->global_offset()+d,   -_E, INSERT_VALUES);
+      }
+    }
+  }
 
-    double B[6][81]={0.}; //81=27*3, and 27 is the max n_node in an element.
+  MatAssemblyBegin(A, MAT_FINAL_ASSEMBLY);
+  MatAssemblyEnd(A, MAT_FINAL_ASSEMBLY);
 
+  // clamp the fixed boundary
+  PetscUtils::MatZeroRows(A, _fixed_dofs.size(), _fixed_dofs.empty() ? NULL : &_fixed_dofs[0], _E);
+}
 
-    // Zero the element matrix and right-hand side before
-    // summing them.  We use the resize member here because
-    // the number of degrees of freedom might have changed from
-    // the last element.  Note that this will be the case if the
-    // element type is different (i.e. the last element was a
-    // triangle, now we are on a quadrilateral).
 
-    // The  DenseMatrix::resize() and the  DenseVector::resize()
-    // members will automatically zero out the matrix  and vector.
-    //	Ke.resize (dof_indices.size(),
-    //			dof_indices.size());
 
-    //	Fe.resize (dof_indices.size());
+void StressSolver::build_rhs(Vec b)
+{
+  VecZeroEntries(b);
 
-    // Now loop over the quadrature points.  This handles
-    // the numeric integration.
+  const LoadCase & load = _load_cases[_current_case];
 
-    for (unsigned int qp=0; qp<qrule.n_points(); qp++)
-    {
+  const MeshBase& mesh = _system.mesh();
+  const unsigned int dim = mesh.mesh_dimension();
 
-      // Now we will build the element matrix.  This involves
-      // a double loop to integrate the test funcions (i) against
-      // the trial functions (j).
-      for (unsigned int i=0; i<phi.size(); i++)
-      {
-        for (unsigned int j=0; j<phi.size(); j++)
-        {
-          //	Ke(i,j) += JxW[qp]*(dphi[i][qp]*dphi[j][qp]);
-        }
-      }
+  FEType fe_type;
+  AutoPtr<FEBase> fe (FEBase::build(dim, fe_type));
+  QGauss qrule (dim, SECOND);
+  fe->attach_quadrature_rule (&qrule);
 
-      for(unsigned int i=0;i<phi.size();i++)
-      {
-        B[0][i*3+0]=dphidx[i][qp];  //vd0[0][i];
+  const std::vector<Real>& JxW = fe->get_JxW();
+  const std::vector<std::vector<Real> >& dphidx = fe->get_dphidx();
+  const std::vector<std::vector<Real> >& dphidy = fe->get_dphidy();
+  const std::vector<std::vector<Real> >& dphidz = fe->get_dphidz();
 
-        B[1][i*3+1]=dphidy[i][qp];  //vd0[1][i];
+  // bulk modulus 3K, C*e0 of isotropic eigenstrain e0 is 3K*e0 on the normal components
+  const double K3 = _E/(1-2*_nu);
 
-        B[2][i*3+2]=dphidz[i][qp];  //vd0[2][i];
+  std::vector<PetscInt> dofs;
+  std::vector<PetscScalar> F;
 
-        B[3][i*3+0]=dphidy[i][qp];  //vd0[1][i];
-        B[3][i*3+1]=dphidx[i][qp];  //vd0[0][i];
+  for(unsigned int l=0; l<load.eigenstrain.size(); ++l)
+  {
+    const SimulationRegion * region = _system.region(load.eigenstrain[l].first);
+    const double e0 = load.eigenstrain[l].second;
 
-        B[4][i*3+1]=dphidz[i][qp];  //vd0[2][i];
-        B[4][i*3+2]=dphidy[i][qp];  //vd0[1][i];
+    // equivalent nodal force of the eigenstrain, F = int B'C e0
+    SimulationRegion::const_element_iterator el = region->elements_begin();
+    for( ; el != region->elements_end(); ++el)
+    {
+      const Elem* elem = *el;
+      if( elem->processor_id() != Genius::processor_id() ) continue;
 
-        B[5][i*3+0]=dphidz[i][qp];  //vd0[2][i];
-        B[5][i*3+2]=dphidx[i][qp];  //vd0[0][i];
-      }
+      fe->reinit (elem);
 
-      for(unsigned int ii=0;ii<dim_stress;ii++)
+      const unsigned int n_node = elem->n_nodes();
+      dofs.resize(3*n_node);
+      F.assign(3*n_node, 0.0);
+      for(unsigned int i=0; i<n_node; ++i)
       {
-        for(unsigned int jj=0;jj<n_node2;jj++)
-        {
-          CB[ii*n_node2+jj]=0.0;
-          for(unsigned int kk=0;kk<dim_stress;kk++)
-          {
-            CB[ii*n_node2+jj]+=C[ii][kk]*B[kk][jj];
-          }
-        }
+        const FVM_Node * fvm_node = _master(region->region_fvm_node(elem->get_node(i)));
+        for(unsigned int d=0; d<3; ++d)
+          dofs[3*i+d] = fvm_node->global_offset()+d;
       }
 
-      for(unsigned int ii=0;ii<n_node2;ii++)
-      {
-        for(unsigned int jj=0;jj<n_node2;jj++)
+      for (unsigned int qp=0; qp<qrule.n_points(); qp++)
+        for(unsigned int i=0; i<n_node; i++)
         {
-          for(unsigned int kk=0;kk<dim_stress;kk++)
-          {
-            K[ii*n_node2+jj]+=B[kk][ii]*CB[kk*n_node2+jj]*JxW[qp];
-          }
-          //	cout<<element_k[ii]<<endl;
+          F[3*i+0] += JxW[qp]*K3*e0*dphidx[i][qp];
+          F[3*i+1] += JxW[qp]*K3*e0*dphidy[i][qp];
+          F[3*i+2] += JxW[qp]*K3*e0*dphidz[i][qp];
         }
-      }
 
-      double f[3]={1.e3,0.,0.};
-      for (unsigned int ii=0; ii<n_node; ii++)
-      {
-        for(unsigned int jj=0; jj<dim; jj++)
-        {
-          F[ii*dim+jj] += JxW[qp]*f[jj]*phi[ii][qp];
-        }
-      }
+      VecSetValues(b, dofs.size(), &dofs[0], &F[0], ADD_VALUES);
     }
+  }
 
-    // We have now reached the end of the RHS summation,
-    // and the end of quadrature point loop, so
-    // the interior element integration has
-    // been completed.  However, we have not yet addressed
-    // boundary conditions.  For this example we will only
-    // consider simple Dirichlet boundary conditions.
-    //
-    // There are several ways Dirichlet boundary conditions
-    // can be imposed.  A simple approach, which works for
-    // interpolary bases like the standard Lagrange polynomials,
-    // is to assign function values to the
-    // degrees of freedom living on the domain boundary. This
-    // works well for interpolary bases, but is more difficult
-    // when non-interpolary (e.g Legendre or Hierarchic) bases
-    // are used.
-    //
-    // Dirichlet boundary conditions can also be imposed with a
-    // "penalty" method.  In this case essentially the L2 projection
-    // of the boundary values are added to the matrix. The
-    // projection is multiplied by some large factor so that, in
-    // floating point arithmetic, the existing (smaller) entries
-    // in the matrix and right-hand-side are effectively ignored.
-    //
-    // This amounts to adding a term of the form (in latex notation)
-    //
-    // \frac{1}{\epsilon} \int_{\delta \Omega} \phi_i \phi_j = \frac{1}{\epsilon} \int_{\delta \Omega} u \phi_i
-    //
-    // where
-    //
-    // \frac{1}{\epsilon} is the penalty parameter, defined such that \epsilon << 1
-    /*
-    {
+  VecAssemblyBegin(b);
+  VecAssemblyEnd(b);
 
-    	// The following loop is over the sides of the element.
-    	// If the element has no neighbor on a side then that
-    	// side MUST live on a boundary of the domain.
-    	for (unsigned int side=0; side<elem->n_sides(); side++)
-    	{
-    		if (elem->neighbor(side) == NULL)
-    		{
-    			// The value of the shape functions at the quadrature
-    			// points.
-    			const std::vector<std::vector<Real> >&  phi_face = fe_face->get_phi();
-
-    			// The Jacobian * Quadrature Weight at the quadrature
-    			// points on the face.
-    			const std::vector<Real>& JxW_face = fe_face->get_JxW();
-
-    			// The XYZ locations (in physical space) of the
-    			// quadrature points on the face.  This is where
-    			// we will interpolate the boundary value function.
-    			const std::vector<Point >& qface_point = fe_face->get_xyz();
-
-    			// Compute the shape function values on the element
-    			// face.
-    			fe_face->reinit(elem, side);
-
-    			// Loop over the face quadrature points for integration.
-    			for (unsigned int qp=0; qp<qface.n_points(); qp++)
-    			{
-
-    				// The location on the boundary of the current
-    				// face quadrature point.
-    				const Real xf = qface_point[qp](0);
-    				const Real yf = qface_point[qp](1);
-
-    				// The penalty value.  \frac{1}{\epsilon}
-    				// in the discussion above.
-    				const Real penalty = 1.e10;
-
-    				// The boundary value.
-    				const Real value = 20.;//exact_solution(xf, yf);
-
-    				// Matrix contribution of the L2 projection.
-    				for (unsigned int i=0; i<phi_face.size(); i++)
-    				for (unsigned int j=0; j<phi_face.size(); j++)
-    				Ke(i,j) += JxW_face[qp]*penalty*phi_face[i][qp]*phi_face[j][qp];
-
-    				// Right-hand-side contribution of the L2
-    				// projection.
-    				for (unsigned int i=0; i<phi_face.size(); i++)
-    				Fe(i) += JxW_face[qp]*penalty*value*phi_face[i][qp];
-    			}
-    		}
-    	}
-    }/*/
-
-    // We have now finished the quadrature point loop,
-    // and have therefore applied all the boundary conditions.
-    //
-    // The element matrix and right-hand-side are now built
-    // for this element.  Add them to the global matrix and
-    // right-hand-side vector.  The  SparseMatrix::add_matrix()
-    // and  NumericVector::add_vector() members do this for us.
-    //	system.matrix->add_matrix (Ke, dof_indices);
-    //	system.rhs->add_vector    (Fe, dof_indices);
-
-    delete []K;
-    delete []F;
-    delete []CB;
+  // the clamped dofs have zero displacement
+  std::vector<PetscScalar> zero(_fixed_dofs.size(), 0.0);
+  if( !_fixed_dofs.empty() )
+    VecSetValues(b, _fixed_dofs.size(), &_fixed_dofs[0], &zero[0], INSERT_VALUES);
 
-  }
-
-  // All done!
+  VecAssemblyBegin(b);
+  VecAssemblyEnd(b);
 }
 
-void StressSolver::build_rhs(Vec b)
+
+
+void StressSolver::_set_near_null_space()
 {
-  //std::cout<<"here b"<<std::endl;
-}
+#if PETSC_VERSION_GE(3,3,0)
+  // node coordinates in the layout of solution vector
+  PetscInt n_local;
+  VecGetLocalSize(x, &n_local);
+
+  Vec coords;
+  VecCreate(PETSC_COMM_WORLD, &coords);
+  VecSetSizes(coords, n_local, n_global_dofs);
+  VecSetBlockSize(coords, 3);
+  VecSetFromOptions(coords);
+
+  for(unsigned int n=0; n<_system.n_regions(); ++n)
+  {
+    const SimulationRegion * region = _system.region(n);
+    if( !_solid(region) ) continue;
 
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    for(; it != region->on_processor_nodes_end(); ++it)
+    {
+      const FVM_Node * fvm_node = *it;
+      const Node * node = fvm_node->root_node();
+      for(unsigned int d=0; d<3; ++d)
+        VecSetValue(coords, fvm_node->global_offset()+d, (*node)(d), INSERT_VALUES);
+    }
+  }
+  VecAssemblyBegin(coords);
+  VecAssemblyEnd(coords);
+
+  MatNullSpace near_null_space;
+  MatNullSpaceCreateRigidBody(coords, &near_null_space);
+  MatSetNearNullSpace(A, near_null_space);
+  MatNullSpaceDestroy(&near_null_space);
+  VecDestroy(&coords);
+#endif
+}
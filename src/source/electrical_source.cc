@@ -23,13 +23,12 @@
 #include "electrical_source.h"
 #include "simulation_system.h"
 #include "boundary_condition_collector.h"
+#include "shared_library.h"
 
 #ifdef CYGWIN
   #include <Windows.h>
   #undef max
   #undef min
-#else
-  #include <dlfcn.h>
 #endif
 
 // for short
@@ -250,6 +249,25 @@ PetscScalar ElectricalSource::limit_dt(PetscScalar time, PetscScalar dt, PetscSc
 
 
 
+PetscScalar ElectricalSource::next_breakpoint(PetscScalar time) const
+{
+  PetscScalar t_break = 1e100;
+
+  CBIt it = _bc_source_map.begin();
+  for(; it!=_bc_source_map.end(); ++it)
+  {
+    for(unsigned int i=0; i<(*it).second.first.size(); ++i)
+      t_break = std::min(t_break, (*it).second.first[i]->next_breakpoint(time));
+
+    for(unsigned int i=0; i<(*it).second.second.size(); ++i)
+      t_break = std::min(t_break, (*it).second.second[i]->next_breakpoint(time));
+  }
+
+  return t_break;
+}
+
+
+
 void ElectricalSource::update(PetscScalar time)
 {
   BIt it = _bc_source_map.begin();
@@ -540,10 +558,10 @@ void  ElectricalSource::SetVSHELL(const Parser::Card &c)
 
 #else
 
-  void * dp = dlopen(filename.c_str(), RTLD_LAZY);
+  void * dp = SharedLibrary::open(filename);
   genius_assert(dp);
 
-  void *fp = dlsym(dp,funcname.c_str());
+  void *fp = SharedLibrary::symbol(dp, funcname);
   genius_assert(fp);
 
   _vsource_list[label] = new VSHELL(label, dp, fp, s, V);
@@ -735,11 +753,11 @@ void  ElectricalSource::SetISHELL(const Parser::Card &c)
   _isource_list[label] = new ISHELL(label, hInstLibrary, fp, s, A);
 
 #else
-  void * dp = dlopen(filename.c_str(), RTLD_LAZY);
+  void * dp = SharedLibrary::open(filename);
   genius_assert(dp);
 
 
-  void *fp = dlsym(dp,funcname.c_str());
+  void *fp = SharedLibrary::symbol(dp, funcname);
   genius_assert(fp);
 
   _isource_list[label] = new ISHELL(label, dp, fp, s, A);
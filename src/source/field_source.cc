@@ -90,6 +90,12 @@ FieldSource::FieldSource(SimulationSystem & system, Parser::InputParser & decks)
         add_particle_source(particle_source);
       }
 
+      if( c.is_enum_value("profile", "deposit") )
+      {
+        Particle_Source * particle_source = new Particle_Source_Deposit(system, c);
+        add_particle_source(particle_source);
+      }
+
     }
 
     // parse input card to find if light source exist
@@ -194,6 +200,25 @@ void FieldSource::update(double time)
 }
 
 
+double FieldSource::next_breakpoint(double time) const
+{
+  double t_break = 1e100;
+
+  if(SolverSpecify::PatG)
+  {
+    std::vector<Particle_Source *>::const_iterator pit = _particle_sources.begin();
+    for(; pit!=_particle_sources.end(); ++pit)
+      t_break = std::min(t_break, (*pit)->next_breakpoint(time));
+  }
+
+  if(SolverSpecify::OptG && current_waveform)
+    t_break = std::min(t_break, current_waveform->next_breakpoint(time));
+
+  return t_break;
+}
+
+
+
 void FieldSource::update_system()
 {
   std::vector<Particle_Source *>::iterator pit = _particle_sources.begin();
@@ -206,6 +231,49 @@ void FieldSource::update_system()
 }
 
 
+Particle_Source_Track * FieldSource::particle_track_source()
+{
+  std::vector<Particle_Source *>::iterator pit = _particle_sources.begin();
+  for(; pit!=_particle_sources.end(); ++pit)
+  {
+    Particle_Source_Track * track_source = dynamic_cast<Particle_Source_Track *>(*pit);
+    if(track_source) return track_source;
+  }
+  return NULL;
+}
+
+
+Particle_Source_Deposit * FieldSource::particle_deposit_source()
+{
+  std::vector<Particle_Source *>::iterator pit = _particle_sources.begin();
+  for(; pit!=_particle_sources.end(); ++pit)
+  {
+    Particle_Source_Deposit * deposit_source = dynamic_cast<Particle_Source_Deposit *>(*pit);
+    if(deposit_source) return deposit_source;
+  }
+  return NULL;
+}
+
+
+void FieldSource::update_particle_generation()
+{
+  for(unsigned int n=0; n<_system.n_regions(); n++)
+  {
+    SimulationRegion * region = _system.region(n);
+    if( region->type() != SemiconductorRegion ) continue;
+
+    SimulationRegion::processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+      (*it)->node_data()->PatG() = 0.0;
+  }
+
+  std::vector<Particle_Source *>::iterator pit = _particle_sources.begin();
+  for(; pit!=_particle_sources.end(); ++pit)
+    (*pit)->update_system();
+}
+
+
 void FieldSource::parse_spectrum_file(const std::string & filename, SimulationSystem & system, const Parser::Card &c)
 {
   // only processor 0 read the spectrum file
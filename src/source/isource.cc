@@ -22,13 +22,12 @@
 #include <cassert>
 
 #include "isource.h"
+#include "shared_library.h"
 
 #ifdef CYGWIN
   #include <Windows.h>
   #undef max
   #undef min
-#else
-  #include <dlfcn.h>
 #endif
 
 
@@ -51,7 +50,6 @@ ISHELL::~ISHELL()
 #ifdef CYGWIN
   FreeLibrary(dll);
 #else
-  if ( dll )
-    dlclose( dll );
+  SharedLibrary::close( dll );
 #endif
 }
@@ -0,0 +1,260 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+
+#include "genius_env.h"
+#include "simulation_system.h"
+#include "simulation_region.h"
+#include "optical_cache.h"
+#include "parallel.h"
+#include "log.h"
+
+
+std::map<unsigned long long, std::vector<double> > OpticalCache::_memory;
+
+
+namespace
+{
+  const char         magic[8] = {'G','O','P','T','G','E','N','\0'};
+  const unsigned int version  = 1;
+
+  struct CacheHeader
+  {
+    char               magic[8];
+    unsigned int       version;
+    unsigned int       n_nodes;
+    unsigned long long key;
+  };
+
+  // 64-bit FNV-1a
+  inline void hash_bytes(unsigned long long &h, const void * p, size_t n)
+  {
+    const unsigned char * c = static_cast<const unsigned char *>(p);
+    for(size_t i=0; i<n; ++i)
+    {
+      h ^= c[i];
+      h *= 1099511628211ULL;
+    }
+  }
+
+  inline void hash_string(unsigned long long &h, const std::string &s)
+  { hash_bytes(h, s.c_str(), s.size()+1); }
+
+  // hash the content of a file, @return false if it can not be read
+  bool hash_file(unsigned long long &h, const std::string &fname)
+  {
+    std::ifstream in(fname.c_str(), std::ios::binary);
+    if( !in.good() ) return false;
+    char buffer[4096];
+    while( in.read(buffer, sizeof(buffer)) || in.gcount() )
+      hash_bytes(h, buffer, in.gcount());
+    return true;
+  }
+}
+
+
+OpticalCache::OpticalCache(SimulationSystem & system, const Parser::Card & c)
+  : _system(system)
+{
+  // the card and the files it names, only the first processor reads the files
+  unsigned long long card_hash = 14695981039346656037ULL;
+  if( Genius::is_first_processor() )
+  {
+    hash_string(card_hash, c.key());
+    for(unsigned int i=0; i<c.parameter_size(); ++i)
+    {
+      const Parser::Parameter & p = c.get_parameter(i);
+      hash_string(card_hash, p.name());
+      int type = p.type();
+      hash_bytes(card_hash, &type, sizeof(type));
+      switch(p.type())
+      {
+      case Parser::BOOL    : { bool v = p.get_bool();   hash_bytes(card_hash, &v, sizeof(v)); break; }
+      case Parser::INTEGER : { int v = p.get_int();     hash_bytes(card_hash, &v, sizeof(v)); break; }
+      case Parser::REAL    : { double v = p.get_real(); hash_bytes(card_hash, &v, sizeof(v)); break; }
+      case Parser::STRING  : hash_string(card_hash, p.get_string()); hash_file(card_hash, p.get_string()); break;
+      default              : hash_string(card_hash, p.get_string()); break;
+      }
+    }
+  }
+  Parallel::broadcast(card_hash);
+
+  _key = card_hash;
+  for(unsigned int n=0; n<_system.n_regions(); n++)
+  {
+    const SimulationRegion * region = _system.region(n);
+    hash_string(_key, region->name());
+    hash_string(_key, region->material());
+    if( region->type() != SemiconductorRegion ) continue;
+
+    SimulationRegion::const_processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::const_processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+    {
+      const Node * node = (*it)->root_node();
+      const unsigned int id = node->id();
+      hash_bytes(_key, &id, sizeof(id));
+      for(unsigned int i=0; i<3; ++i)
+      {
+        const Real x = (*node)(i);
+        hash_bytes(_key, &x, sizeof(x));
+      }
+    }
+  }
+
+  if( !Genius::optical_cache().empty() )
+  {
+    std::stringstream ss;
+    ss << Genius::optical_cache() << "." << std::hex << std::setw(16) << std::setfill('0') << card_hash << std::dec
+       << "." << Genius::n_processors() << "." << Genius::processor_id() << ".optg";
+    _file = ss.str();
+  }
+}
+
+
+void OpticalCache::_node_data(std::vector<FVM_NodeData *> & data) const
+{
+  for(unsigned int n=0; n<_system.n_regions(); n++)
+  {
+    SimulationRegion * region = _system.region(n);
+    if( region->type() != SemiconductorRegion ) continue;
+
+    SimulationRegion::processor_node_iterator it = region->on_processor_nodes_begin();
+    SimulationRegion::processor_node_iterator it_end = region->on_processor_nodes_end();
+    for(; it!=it_end; ++it)
+      data.push_back((*it)->node_data());
+  }
+}
+
+
+void OpticalCache::_values(std::vector<double> & values) const
+{
+  std::vector<FVM_NodeData *> data;
+  _node_data(data);
+
+  values.resize(2*data.size());
+  for(unsigned int n=0; n<data.size(); ++n)
+  {
+    values[2*n]   = data[n]->OptG();
+    values[2*n+1] = data[n]->OptQ();
+  }
+}
+
+
+bool OpticalCache::restore()
+{
+  std::vector<double> values;
+  bool found = false;
+
+  std::map<unsigned long long, std::vector<double> >::const_iterator it = _memory.find(_key);
+  if( it != _memory.end() )
+  {
+    values = it->second;
+    found = true;
+  }
+  else if( !_file.empty() )
+    found = _load(values);
+
+  // the solver is collective, all the processors must have the cache
+  Parallel::min(found);
+  if( !found ) return false;
+
+  std::vector<FVM_NodeData *> data;
+  _node_data(data);
+  genius_assert( values.size() == 2*data.size() );
+  for(unsigned int n=0; n<data.size(); ++n)
+  {
+    data[n]->OptG() += values[2*n];
+    data[n]->OptQ() += values[2*n+1];
+  }
+
+  _memory[_key] = values;
+
+  MESSAGE<< "Optical generation restored from cache.\n" << std::endl;
+  RECORD();
+
+  return true;
+}
+
+
+void OpticalCache::begin()
+{
+  _values(_before);
+}
+
+
+void OpticalCache::end()
+{
+  std::vector<double> values;
+  _values(values);
+  genius_assert( values.size() == _before.size() );
+  for(unsigned int i=0; i<values.size(); ++i)
+    values[i] -= _before[i];
+  _before.clear();
+
+  if( !_file.empty() )
+    _save(values);
+  _memory[_key].swap(values);
+}
+
+
+bool OpticalCache::_load(std::vector<double> & values) const
+{
+  std::ifstream in(_file.c_str(), std::ios::binary);
+  if( !in.good() ) return false;
+
+  CacheHeader header;
+  if( !in.read(reinterpret_cast<char *>(&header), sizeof(CacheHeader)).good() ) return false;
+  if( memcmp(header.magic, magic, sizeof(magic)) ) return false;
+  if( header.version != version || header.key != _key ) return false;
+
+  values.resize(2*header.n_nodes);
+  if( values.empty() ) return true;
+  return in.read(reinterpret_cast<char *>(&values[0]), values.size()*sizeof(double)).good();
+}
+
+
+bool OpticalCache::_save(const std::vector<double> & values) const
+{
+  CacheHeader header;
+  memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.n_nodes = values.size()/2;
+  header.key     = _key;
+
+  // write to a temporary file first, so a concurrent run never sees a partial cache
+  const std::string tmp_file = _file + ".tmp";
+  std::ofstream out(tmp_file.c_str(), std::ios::binary);
+  if( !out.good() ) return false;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(CacheHeader));
+  if( !values.empty() )
+    out.write(reinterpret_cast<const char *>(&values[0]), values.size()*sizeof(double));
+  out.close();
+  if( !out.good() ) return false;
+
+  return std::rename(tmp_file.c_str(), _file.c_str()) == 0;
+}
@@ -20,8 +20,13 @@
 /********************************************************************************/
 
 #include <fstream>
+#include <algorithm>
+#include <map>
+#include <kdtree.hpp>
 
 #include "mesh_base.h"
+#include "boundary_info.h"
+#include "point_locator_base.h"
 #include "particle_source.h"
 #include "simulation_system.h"
 #include "simulation_region.h"
@@ -29,8 +34,8 @@
 #include "interpolation_2d_csa.h"
 //#include "interpolation_3d_qshep.h"
 #include "interpolation_3d_nbtet.h"
-#include "nearest_node_locator.h"
 #include "parallel.h"
+#include "genius_env.h"
 #include "mathfunc.h"
 #include "log.h"
 
@@ -40,6 +45,23 @@ using PhysicalUnit::eV;
 using PhysicalUnit::cm;
 using PhysicalUnit::g;
 
+namespace
+{
+  /**
+   * a point sampled along a particle track, for the spatial index of the tracks
+   */
+  struct TrackSample
+  {
+    Point p;
+    unsigned int track;
+  };
+
+  inline Real track_sample_location(TrackSample sample, unsigned int k)
+  { return sample.p(k); }
+
+  typedef KDTree::KDTree<3, TrackSample, std::pointer_to_binary_function<TrackSample, unsigned int, Real> > track_kdtree_type;
+}
+
 //-------------------------------------------------------------------------------------------------------------------------
 
 Particle_Source_DataFile::Particle_Source_DataFile(SimulationSystem &system, const Parser::Card &c):Particle_Source(system)
@@ -304,7 +326,24 @@ Particle_Source_Track::Particle_Source_Track(SimulationSystem &system, const Par
 
 void Particle_Source_Track::_read_particle_profile_track(const std::string &file)
 {
+  // all the strikes of the file are incident together
+  std::vector<strike_t> strikes = read_strikes(file);
+  for(unsigned int n=0; n<strikes.size(); ++n)
+    _tracks.insert(_tracks.end(), strikes[n].tracks.begin(), strikes[n].tracks.end());
+
+  Parallel::verify(_tracks.size());
+}
+
+
+std::vector<Particle_Source_Track::strike_t> Particle_Source_Track::read_strikes(const std::string &file)
+{
+  // 7 values for each track, the strike index of each track
   std::vector<double> meta_data;
+  std::vector<unsigned int> track_strike;
+  // strike labels, separated by new line
+  std::string labels;
+  unsigned int n_strikes = 0;
+
   if(Genius::processor_id()==0)
   {
     std::ifstream in(file.c_str());
@@ -330,6 +369,22 @@ void Particle_Source_Track::_read_particle_profile_track(const std::string &file
           meta_data.push_back(p2[1]*um);
           meta_data.push_back(p2[2]*um);
           meta_data.push_back(energy*1e6*eV);
+          // tracks before the first strike line
+          if( n_strikes == 0 )
+          {
+            labels += '\n';
+            n_strikes = 1;
+          }
+          track_strike.push_back(n_strikes-1);
+        }
+        else if (flag == 'S' )
+        {
+          std::string label;
+          std::getline(in, label);
+          label.erase(0, label.find_first_not_of(" \t"));
+          label.erase(label.find_last_not_of(" \t\r")+1);
+          labels += label + '\n';
+          n_strikes++;
         }
         else
         {
@@ -343,6 +398,19 @@ void Particle_Source_Track::_read_particle_profile_track(const std::string &file
   }
 
   Parallel::broadcast(meta_data);
+  Parallel::broadcast(track_strike);
+  Parallel::broadcast(labels);
+  Parallel::broadcast(n_strikes);
+
+  std::vector<strike_t> strikes(n_strikes);
+  std::string::size_type pos = 0;
+  for(unsigned int n=0; n<n_strikes; ++n)
+  {
+    std::string::size_type end = labels.find('\n', pos);
+    strikes[n].label = labels.substr(pos, end-pos);
+    pos = end+1;
+  }
+
   for(unsigned int n=0; n<meta_data.size()/7; ++n)
   {
     track_t track;
@@ -353,11 +421,10 @@ void Particle_Source_Track::_read_particle_profile_track(const std::string &file
     track.end.y()   = meta_data[7*n+4];
     track.end.z()   = meta_data[7*n+5];
     track.energy    = meta_data[7*n+6];
-    _tracks.push_back(track);
+    strikes[track_strike[n]].tracks.push_back(track);
   }
 
-  Parallel::verify(_tracks.size());
-
+  return strikes;
 }
 
 void Particle_Source_Track::update_system()
@@ -365,57 +432,224 @@ void Particle_Source_Track::update_system()
   const double pi = 3.1415926536;
   genius_assert(_system.mesh().mesh_dimension() == 3);
 
-  AutoPtr<NearestNodeLocator> nn_locator( new NearestNodeLocator(_system.mesh()) );
+  // the gaussian deposit is negligible beyond the cutoff radius around a track
+  const Real cutoff = 5*_lateral_char;
 
-  // for each track
+  // index the tracks by points sampled along them with 2*cutoff spacing. a node within
+  // cutoff of a track is then within a box of half width 2*cutoff around a sample point
+  std::vector<double> track_length(_tracks.size(), 0.0);
+  track_kdtree_type kd_tree(std::ptr_fun(track_sample_location));
   for(unsigned int t=0; t<_tracks.size(); ++t)
   {
     const track_t & track = _tracks[t];
+    track_length[t] = (track.end - track.start).size();
+    if( track_length[t] <= 0.0 ) continue;
 
-    const Point track_dir = (track.end - track.start).unit(); // track direction
-    const double ed = track.energy/(track.end - track.start).size(); // linear energy density
-
-    // find the nodes that
-    std::map<FVM_Node *, double> impacted_fvm_nodes;
-    for(unsigned int r=0; r<_system.n_regions(); r++)
+    unsigned int n_segment = static_cast<unsigned int>(std::ceil(track_length[t]/(2*cutoff)));
+    for(unsigned int n=0; n<=n_segment; ++n)
     {
-      SimulationRegion * region = _system.region(r);
-      if( region->type() != SemiconductorRegion ) continue;
-
-      Real radii = 5*_lateral_char;
-      std::vector<const Node *> nn = nn_locator->nearest_nodes(track.start, track.end, radii, r);
-      for(unsigned int n=0; n<nn.size(); ++n)
-      {
-        Point loc = *nn[n];
-        FVM_Node * fvm_node = region->region_fvm_node(nn[n]);  genius_assert(fvm_node);
-        Point loc_pp = track.start + (loc-track.start)*track_dir*track_dir;
-        Real r = (loc-loc_pp).size();
-        double e_r = exp(-r*r/(_lateral_char*_lateral_char));
-        double e_z = Erf((loc_pp-track.start)*track_dir/_lateral_char) - Erf((loc_pp-track.end)*track_dir/_lateral_char);
-        double energy = ed/(2*pi*_lateral_char*_lateral_char)*e_r*e_z;
-        impacted_fvm_nodes.insert(std::make_pair(fvm_node, energy));
-      }
+      TrackSample sample;
+      sample.p = track.start + (track.end - track.start)*(static_cast<double>(n)/n_segment);
+      sample.track = t;
+      kd_tree.insert(sample);
     }
+  }
+  kd_tree.optimise();
+
+  // the on local semiconductor nodes, each processor only evaluates the nodes it owns
+  std::vector<FVM_Node *> fvm_nodes;
+  for(unsigned int r=0; r<_system.n_regions(); r++)
+  {
+    SimulationRegion * region = _system.region(r);
+    if( region->type() != SemiconductorRegion ) continue;
+    fvm_nodes.insert(fvm_nodes.end(), region->on_local_nodes_begin(), region->on_local_nodes_end());
+  }
+
+  // energy density of each track impacting each node
+  std::vector< std::vector< std::pair<unsigned int, double> > > node_deposit(fvm_nodes.size());
+
+#pragma omp parallel for schedule(dynamic, 64) num_threads(Genius::n_threads())
+  for(int i=0; i<static_cast<int>(fvm_nodes.size()); ++i)
+  {
+    const Point loc = *(fvm_nodes[i]->root_node());
+
+    TrackSample query;
+    query.p = loc;
+    std::vector<TrackSample> samples;
+    kd_tree.find_within_range(query, 2*cutoff, std::back_inserter(samples));
+    if( samples.empty() ) continue;
 
-    if(!impacted_fvm_nodes.size()) continue;
+    std::vector<unsigned int> tracks;
+    for(unsigned int n=0; n<samples.size(); ++n)
+      tracks.push_back(samples[n].track);
+    std::sort(tracks.begin(), tracks.end());
+    tracks.erase(std::unique(tracks.begin(), tracks.end()), tracks.end());
 
-    // statistic total energy deposit
-    double energy_statistics = 0.0;
-    std::map<FVM_Node *, double>::iterator it=impacted_fvm_nodes.begin();
-    for( ; it!=impacted_fvm_nodes.end(); ++it)
+    for(unsigned int n=0; n<tracks.size(); ++n)
     {
-      FVM_Node * fvm_node = it->first;
-      energy_statistics += it->second*fvm_node->volume();
+      const track_t & track = _tracks[tracks[n]];
+      const Point track_dir = (track.end - track.start).unit(); // track direction
+      const double ed = track.energy/track_length[tracks[n]]; // linear energy density
+
+      // distance to the track segment
+      double s = (loc-track.start)*track_dir;
+      Point loc_seg = track.start + std::max(0.0, std::min(s, track_length[tracks[n]]))*track_dir;
+      if( (loc-loc_seg).size() > cutoff ) continue;
+
+      Point loc_pp = track.start + s*track_dir;
+      Real r = (loc-loc_pp).size();
+      double e_r = exp(-r*r/(_lateral_char*_lateral_char));
+      double e_z = Erf((loc_pp-track.start)*track_dir/_lateral_char) - Erf((loc_pp-track.end)*track_dir/_lateral_char);
+      double energy = ed/(2*pi*_lateral_char*_lateral_char)*e_r*e_z;
+      node_deposit[i].push_back(std::make_pair(tracks[n], energy));
     }
-    double alpha = track.energy/energy_statistics;//used for keep energy conservation
+  }
+
+  // statistic total energy deposit of each track
+  std::vector<double> energy_statistics(_tracks.size(), 0.0);
+  for(unsigned int i=0; i<fvm_nodes.size(); ++i)
+    for(unsigned int n=0; n<node_deposit[i].size(); ++n)
+      energy_statistics[node_deposit[i][n].first] += node_deposit[i][n].second*fvm_nodes[i]->volume();
+  Parallel::sum(energy_statistics);
+
+  // used for keep energy conservation
+  std::vector<double> alpha(_tracks.size(), 0.0);
+  for(unsigned int t=0; t<_tracks.size(); ++t)
+    if( energy_statistics[t] > 0.0 )
+      alpha[t] = _tracks[t].energy/energy_statistics[t];
+
+  const double t_scale = _quan_eff*(_t_char/2.0*sqrt(pi)*(1+Erf((_t_max-_t0)/_t_char)));
+  for(unsigned int i=0; i<fvm_nodes.size(); ++i)
+  {
+    FVM_NodeData * node_data = fvm_nodes[i]->node_data();
+    for(unsigned int n=0; n<node_deposit[i].size(); ++n)
+      node_data->PatG() += alpha[node_deposit[i][n].first]*node_deposit[i][n].second/t_scale;
+  }
+}
+
+
+
+//-------------------------------------------------------------------------------------------------------------------------
 
-    for( it=impacted_fvm_nodes.begin(); it!=impacted_fvm_nodes.end(); ++it)
+Particle_Source_Deposit::Particle_Source_Deposit(SimulationSystem &system, const Parser::Card &c):Particle_Source(system)
+{
+  MESSAGE<<"Setting Radiation Source from in process energy deposit..."; RECORD();
+
+  genius_assert(c.key() == "PARTICLE");
+
+  _t0     = c.get_real("t0", 0.0)*s;
+  _t_max  = c.get_real("tmax", 0.0)*s;
+  _t_char = c.get_real("t.char", 2e-12)*s;
+  _quan_eff = c.get_real("quan.eff", 3.6)*eV;
+
+  _slots.resize(std::max(1, c.get_int("slots", 1)));
+
+  MESSAGE<<"ok\n"<<std::endl; RECORD();
+}
+
+
+void Particle_Source_Deposit::update_system()
+{
+  const double pi = 3.1415926536;
+
+  // collect the deposits of all the producers
+  std::vector<double> deposits;
+  if(Genius::processor_id()==0)
+    for(unsigned int n=0; n<_slots.size(); ++n)
+      deposits.insert(deposits.end(), _slots[n].begin(), _slots[n].end());
+  Parallel::broadcast(deposits);
+
+  const unsigned int n_deposits = deposits.size()/4;
+  if( !n_deposits ) return;
+
+  std::vector<Point> points(n_deposits);
+  for(unsigned int n=0; n<n_deposits; ++n)
+    points[n] = Point(deposits[4*n+0]*um, deposits[4*n+1]*um, deposits[4*n+2]*um);
+
+  std::vector<const Elem *> elems;
+  _system.mesh().point_locator().locate_batch(points, elems);
+
+  // the energy of each deposit goes to the nearest vertex of its element,
+  // each processor only takes the nodes it owns
+  std::map<FVM_Node *, double> node_energy;
+  double binned_energy = 0.0;
+  for(unsigned int n=0; n<n_deposits; ++n)
+  {
+    const Elem * elem = elems[n];
+    if( !elem ) continue;
+
+    const SimulationRegion * region = _system.region(elem->subdomain_id());
+    if( region->type() != SemiconductorRegion ) continue;
+
+    unsigned int nearest = 0;
+    for(unsigned int v=1; v<elem->n_vertices(); ++v)
+      if( (elem->point(v) - points[n]).size() < (elem->point(nearest) - points[n]).size() )
+        nearest = v;
+
+    FVM_Node * fvm_node = region->region_fvm_node(elem->get_node(nearest));
+    if( !fvm_node || !fvm_node->on_processor() ) continue;
+
+    const double energy = deposits[4*n+3]*1e6*eV;
+    node_energy[fvm_node] += energy;
+    binned_energy += energy;
+  }
+
+  const double t_scale = _quan_eff*(_t_char/2.0*sqrt(pi)*(1+Erf((_t_max-_t0)/_t_char)));
+  std::map<FVM_Node *, double>::iterator it = node_energy.begin();
+  for(; it!=node_energy.end(); ++it)
+    it->first->node_data()->PatG() += it->second/it->first->volume()/t_scale;
+
+  Parallel::sum(binned_energy);
+  MESSAGE<<"Particle: "<<n_deposits<<" energy deposits, "<<binned_energy/(1e6*eV)<<" MeV in semiconductor."<<std::endl; RECORD();
+}
+
+
+void Particle_Source_Deposit::region_surface(unsigned int r, std::vector<double> &vertices, std::vector<unsigned int> &facets) const
+{
+  const MeshBase & mesh = _system.mesh();
+  genius_assert(mesh.mesh_dimension()==3);
+
+  vertices.clear();
+  facets.clear();
+
+  std::vector<unsigned int>       el;
+  std::vector<unsigned short int> sl;
+  std::vector<short int>          il;
+  mesh.boundary_info->build_side_list (el, sl, il);
+
+  // mesh node id to vertex index
+  std::map<unsigned int, unsigned int> vertex_index;
+
+  for(unsigned int n=0; n<sl.size(); n++)
+  {
+    const Elem * elem = mesh.elem(el[n]);
+    if( elem->subdomain_id() != r) continue;
+
+    AutoPtr<Elem> side = elem->build_side(sl[n]);
+    const Point norm = elem->outside_unit_normal(sl[n]);
+
+    std::vector<unsigned int> v(side->n_vertices());
+    for(unsigned int i=0; i<side->n_vertices(); ++i)
     {
-      FVM_Node * fvm_node = it->first;
-      if(!fvm_node->on_local()) continue;
+      const Node * node = side->get_node(i);
+      std::map<unsigned int, unsigned int>::iterator vit = vertex_index.find(node->id());
+      if( vit == vertex_index.end() )
+      {
+        vit = vertex_index.insert(std::make_pair(node->id(), static_cast<unsigned int>(vertices.size()/3))).first;
+        vertices.push_back(node->x()/um);
+        vertices.push_back(node->y()/um);
+        vertices.push_back(node->z()/um);
+      }
+      v[i] = vit->second;
+    }
 
-      FVM_NodeData * node_data = fvm_node->node_data();
-      node_data->PatG() += alpha*it->second/_quan_eff/(_t_char/2.0*sqrt(pi)*(1+Erf((_t_max-_t0)/_t_char)));
+    // triangle fan of the side, oriented to the outside normal
+    const bool flip = ((side->point(1) - side->point(0)).cross(side->point(2) - side->point(0)))*norm < 0;
+    for(unsigned int i=1; i+1<v.size(); ++i)
+    {
+      facets.push_back(v[0]);
+      facets.push_back(flip ? v[i+1] : v[i]);
+      facets.push_back(flip ? v[i] : v[i+1]);
     }
   }
 }
@@ -22,13 +22,12 @@
 #include <cassert>
 
 #include "vsource.h"
+#include "shared_library.h"
 
 #ifdef CYGWIN
   #include <Windows.h>
   #undef max
   #undef min
-#else
-  #include <dlfcn.h>
 #endif
 
 
@@ -52,7 +51,6 @@ VSHELL::~VSHELL()
 #ifdef CYGWIN
     FreeLibrary(dll);
 #else
-    if ( dll )
-      dlclose( dll );
+    SharedLibrary::close( dll );
 #endif
 }
\ No newline at end of file
@@ -22,13 +22,12 @@
 #include <cassert>
 
 #include "waveform.h"
+#include "shared_library.h"
 
 #ifdef CYGWIN
   #include <Windows.h>
   #undef max
   #undef min
-#else
-  #include <dlfcn.h>
 #endif
 
 
@@ -42,8 +41,8 @@ WaveformShell::WaveformShell(const std::string & s, const std::string & dll_file
 
 #else
 
-  dll = dlopen(dll_file.c_str(), RTLD_LAZY);  assert(dll);
-  void *fp = dlsym(dll, function.c_str());  assert(fp);
+  dll = SharedLibrary::open(dll_file);  assert(dll);
+  void *fp = SharedLibrary::symbol(dll, function);  assert(fp);
 
 #endif
 
@@ -62,6 +61,6 @@ WaveformShell::~WaveformShell()
 #ifdef CYGWIN
   FreeLibrary(dll);
 #else
-  dlclose( dll );
+  SharedLibrary::close( dll );
 #endif
 }
@@ -0,0 +1,270 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <deque>
+#include <sstream>
+
+#include "async_exec.h"
+
+#ifndef CYGWIN
+  #include <unistd.h>
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <spawn.h>
+  #include <sys/types.h>
+  #include <sys/socket.h>
+  #include <sys/wait.h>
+
+  extern char **environ;
+#endif
+
+
+int  AsyncExec::_fd  = -1;
+int  AsyncExec::_pid = -1;
+bool AsyncExec::_started = false;
+
+
+bool AsyncExec::running()
+{ return _fd >= 0; }
+
+
+void AsyncExec::run(const std::string &command)
+{
+  if( !_send('R', command) )
+  {
+    int status = system(command.c_str());
+    (void)status;
+  }
+}
+
+
+void AsyncExec::set_max_jobs(unsigned int n)
+{
+  std::stringstream ss;
+  ss << n;
+  _send('J', ss.str());
+}
+
+
+#ifndef CYGWIN
+
+void AsyncExec::start()
+{
+  if( _started ) return;
+  _started = true;
+
+  int sv[2];
+  if( socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0 ) return;
+
+  // flush stdio, or the buffered output is written twice
+  fflush(NULL);
+
+  pid_t pid = fork();
+  if( pid < 0 )
+  {
+    close(sv[0]);
+    close(sv[1]);
+    return;
+  }
+
+  if( pid == 0 )
+  {
+    close(sv[0]);
+    fcntl(sv[1], F_SETFD, FD_CLOEXEC);
+    _helper_main(sv[1]);
+  }
+
+  close(sv[1]);
+  // the commands started by system() should not hold the socket
+  fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+  _fd  = sv[0];
+  _pid = pid;
+}
+
+
+void AsyncExec::stop()
+{
+  if( _fd < 0 ) return;
+
+  // the helper leaves when it sees the end of the stream and its children finished
+  close(_fd);
+  _fd = -1;
+
+  int status;
+  while( waitpid(_pid, &status, 0) < 0 && errno == EINTR ) {}
+  _pid = -1;
+}
+
+
+void AsyncExec::wait()
+{
+  // nothing was queued when the helper never started
+  if( _fd < 0 ) return;
+  if( !_send('W', std::string()) ) return;
+
+  char ack;
+  while( recv(_fd, &ack, 1, 0) < 0 && errno == EINTR ) {}
+}
+
+
+bool AsyncExec::_send(char type, const std::string &data)
+{
+  start();
+  if( _fd < 0 ) return false;
+
+  // type, length, then the data
+  std::string msg(1, type);
+  unsigned int len = data.size();
+  msg.append(reinterpret_cast<const char *>(&len), sizeof(len));
+  msg.append(data);
+
+#ifdef MSG_NOSIGNAL
+  const int flags = MSG_NOSIGNAL;
+#else
+  const int flags = 0;
+#endif
+
+  size_t pos = 0;
+  while( pos < msg.size() )
+  {
+    ssize_t n = send(_fd, msg.data()+pos, msg.size()-pos, flags);
+    if( n < 0 && errno == EINTR ) continue;
+    if( n <= 0 )
+    {
+      // the helper is gone, fall back to synchronous execution
+      close(_fd);
+      _fd = -1;
+      return false;
+    }
+    pos += n;
+  }
+  return true;
+}
+
+
+void AsyncExec::_helper_main(int fd)
+{
+  std::deque<std::string> queue;
+  std::string buffer;
+  unsigned int max_jobs  = 0;
+  unsigned int n_running = 0;
+  unsigned int n_waiting = 0;
+  bool eof = false;
+
+  for(;;)
+  {
+    // reap the finished commands
+    int status;
+    while( n_running && waitpid(-1, &status, WNOHANG) > 0 )
+      --n_running;
+
+    // launch the queued commands within the job limit
+    while( !queue.empty() && (max_jobs == 0 || n_running < max_jobs) )
+    {
+      const char * argv[] = {"sh", "-c", queue.front().c_str(), NULL};
+      pid_t pid;
+      if( posix_spawn(&pid, "/bin/sh", NULL, NULL, const_cast<char * const *>(argv), environ) == 0 )
+        ++n_running;
+      else
+      {
+        // stdio may be locked by a thread of the parent at the time of fork
+        const std::string msg = "AsyncExec: failed to run " + queue.front() + "\n";
+        while( write(STDERR_FILENO, msg.data(), msg.size()) < 0 && errno == EINTR ) {}
+      }
+      queue.pop_front();
+    }
+
+    // all the commands queued before the wait requests finished
+    if( queue.empty() && n_running == 0 )
+    {
+      for( ; n_waiting && !eof; --n_waiting )
+      {
+        char ack = 'W';
+        while( write(fd, &ack, 1) < 0 && errno == EINTR ) {}
+      }
+      if( eof ) _exit(0);
+    }
+
+    // the solver is gone, wait for the remaining commands
+    if( eof )
+    {
+      if( waitpid(-1, &status, 0) > 0 ) --n_running;
+      continue;
+    }
+
+    // poll for requests, wake up from time to time to reap the children
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if( poll(&pfd, 1, n_running ? 20 : -1) <= 0 ) continue;
+
+    char chunk[4096];
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if( n < 0 && errno == EINTR ) continue;
+    if( n <= 0 ) { eof = true; continue; }
+    buffer.append(chunk, n);
+
+    // decode the complete messages
+    const size_t header = 1 + sizeof(unsigned int);
+    size_t pos = 0;
+    while( buffer.size() - pos >= header )
+    {
+      unsigned int len;
+      memcpy(&len, buffer.data()+pos+1, sizeof(len));
+      if( buffer.size() - pos < header + len ) break;
+
+      const char type = buffer[pos];
+      const std::string data = buffer.substr(pos+header, len);
+      switch( type )
+      {
+      case 'R' : queue.push_back(data); break;
+      case 'J' : max_jobs = atoi(data.c_str()); break;
+      case 'W' : ++n_waiting; break;
+      }
+      pos += header + len;
+    }
+    buffer.erase(0, pos);
+  }
+}
+
+#else
+
+// no fork on windows, the commands run synchronously
+
+void AsyncExec::start() {}
+
+void AsyncExec::stop() {}
+
+void AsyncExec::wait() {}
+
+bool AsyncExec::_send(char, const std::string &)
+{ return false; }
+
+void AsyncExec::_helper_main(int)
+{}
+
+#endif
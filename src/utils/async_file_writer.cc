@@ -0,0 +1,144 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <fstream>
+
+#include "async_file_writer.h"
+#include "genius_common.h"
+
+
+AsyncFileWriter & AsyncFileWriter::instance()
+{
+  static AsyncFileWriter writer;
+  return writer;
+}
+
+
+void AsyncFileWriter::_write_file(const std::string &name, const std::string &content)
+{
+  std::ofstream out(name.c_str(), std::ofstream::trunc | std::ofstream::binary);
+  out.write(content.data(), content.size());
+  out.close();
+}
+
+
+#ifdef HAVE_PTHREAD
+
+AsyncFileWriter::AsyncFileWriter()
+  : _stop(false)
+{
+  pthread_mutex_init(&_mutex, NULL);
+  pthread_cond_init(&_staged_cond, NULL);
+  pthread_cond_init(&_written_cond, NULL);
+  pthread_create(&_thread, NULL, _thread_main, this);
+}
+
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+  pthread_mutex_lock(&_mutex);
+  _stop = true;
+  pthread_cond_signal(&_staged_cond);
+  pthread_mutex_unlock(&_mutex);
+
+  // the thread leaves after the last staged file is written
+  pthread_join(_thread, NULL);
+
+  pthread_cond_destroy(&_written_cond);
+  pthread_cond_destroy(&_staged_cond);
+  pthread_mutex_destroy(&_mutex);
+}
+
+
+void AsyncFileWriter::submit(const std::string &name, std::string &content)
+{
+  pthread_mutex_lock(&_mutex);
+
+  while( _staged.size() >= _max_staged )
+    pthread_cond_wait(&_written_cond, &_mutex);
+
+  _staged.push_back(std::make_pair(name, std::string()));
+  _staged.back().second.swap(content);
+
+  pthread_cond_signal(&_staged_cond);
+  pthread_mutex_unlock(&_mutex);
+}
+
+
+void AsyncFileWriter::flush()
+{
+  pthread_mutex_lock(&_mutex);
+  while( !_staged.empty() )
+    pthread_cond_wait(&_written_cond, &_mutex);
+  pthread_mutex_unlock(&_mutex);
+}
+
+
+void * AsyncFileWriter::_thread_main(void * arg)
+{
+  AsyncFileWriter * writer = static_cast<AsyncFileWriter *>(arg);
+
+  pthread_mutex_lock(&writer->_mutex);
+  while( true )
+  {
+    while( writer->_staged.empty() && !writer->_stop )
+      pthread_cond_wait(&writer->_staged_cond, &writer->_mutex);
+
+    if( writer->_staged.empty() ) break;
+
+    // the head stays in the queue while it is written, so it counts for the staging limit.
+    // submit only appends at the back, the reference keeps valid
+    const std::pair<std::string, std::string> & file = writer->_staged.front();
+    pthread_mutex_unlock(&writer->_mutex);
+
+    _write_file(file.first, file.second);
+
+    pthread_mutex_lock(&writer->_mutex);
+    writer->_staged.pop_front();
+    pthread_cond_broadcast(&writer->_written_cond);
+  }
+  pthread_mutex_unlock(&writer->_mutex);
+
+  return NULL;
+}
+
+#else
+
+AsyncFileWriter::AsyncFileWriter()
+{}
+
+
+AsyncFileWriter::~AsyncFileWriter()
+{}
+
+
+void AsyncFileWriter::submit(const std::string &name, std::string &content)
+{
+  _write_file(name, content);
+  content.clear();
+}
+
+
+void AsyncFileWriter::flush()
+{}
+
+#endif
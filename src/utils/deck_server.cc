@@ -0,0 +1,215 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cstring>
+#include <cerrno>
+#include <sstream>
+#include <streambuf>
+
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "deck_server.h"
+#include "genius_env.h"
+#include "genius_common.h"
+#include "parser.h"
+#include "control.h"
+#include "parallel.h"
+
+
+namespace
+{
+  // send all the bytes, return false on error
+  bool send_all(int fd, const char *data, size_t size)
+  {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    size_t pos = 0;
+    while( pos < size )
+    {
+      ssize_t n = send(fd, data+pos, size-pos, flags);
+      if( n < 0 && errno == EINTR ) continue;
+      if( n <= 0 ) return false;
+      pos += n;
+    }
+    return true;
+  }
+
+  // unbuffered stream to the client, as a log stream
+  class SocketBuf : public std::streambuf
+  {
+  public:
+    SocketBuf(int fd) : _fd(fd) {}
+
+  protected:
+    virtual int overflow(int c)
+    {
+      if( c == EOF ) return 0;
+      char ch = static_cast<char>(c);
+      return send_all(_fd, &ch, 1) ? c : EOF;
+    }
+
+    virtual std::streamsize xsputn(const char *s, std::streamsize n)
+    { return send_all(_fd, s, n) ? n : 0; }
+
+  private:
+    int _fd;
+  };
+}
+
+
+DeckServer::DeckServer(SolverControl &control, Parser::InputParser &decks)
+  : _control(control), _decks(decks), _listen_fd(-1)
+{}
+
+
+DeckServer::~DeckServer()
+{
+  if( _listen_fd >= 0 )
+    close(_listen_fd);
+}
+
+
+bool DeckServer::listen(const std::string &address, int port)
+{
+  int ok = 1;
+  if( Genius::is_first_processor() )
+  {
+    std::ostringstream service;
+    service << port;
+
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if( getaddrinfo(address.empty() ? NULL : address.c_str(), service.str().c_str(), &hints, &res) == 0 )
+    {
+      for( struct addrinfo *p = res; p && _listen_fd < 0; p = p->ai_next )
+      {
+        int fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        if( fd < 0 ) continue;
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if( bind(fd, p->ai_addr, p->ai_addrlen) == 0 && ::listen(fd, 8) == 0 )
+          _listen_fd = fd;
+        else
+          close(fd);
+      }
+      freeaddrinfo(res);
+    }
+    ok = _listen_fd >= 0;
+  }
+  Parallel::broadcast(ok);
+
+  if( ok )
+  {
+    MESSAGE<<"Deck server is listening on " << (address.empty() ? "*" : address) << ":" << port << std::endl; RECORD();
+  }
+  else
+  {
+    MESSAGE<<"ERROR: deck server can not listen on " << (address.empty() ? "*" : address) << ":" << port << std::endl; RECORD();
+  }
+  return ok;
+}
+
+
+std::string DeckServer::_read_cards(int fd)
+{
+  std::string text;
+  char buf[4096];
+  for(;;)
+  {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if( n < 0 && errno == EINTR ) continue;
+    if( n <= 0 ) break;
+    text.append(buf, n);
+
+    // a line END finishes the cards when the client keeps the connection open for the log
+    std::string::size_type end = text.find("\nEND");
+    if( text.compare(0, 3, "END") == 0 ) end = 0;
+    if( end != std::string::npos )
+    {
+      text.erase(end == 0 ? 0 : end+1);
+      break;
+    }
+  }
+  return text;
+}
+
+
+void DeckServer::run()
+{
+  for(;;)
+  {
+    int fd = -1;
+    std::string text;
+    if( Genius::is_first_processor() )
+    {
+      while( fd < 0 )
+      {
+        fd = accept(_listen_fd, NULL, NULL);
+        if( fd < 0 && errno != EINTR ) break;
+      }
+      if( fd >= 0 )
+        text = _read_cards(fd);
+      else
+        text = "SHUTDOWN";
+    }
+    Parallel::broadcast(text);
+
+    if( text.compare(0, 8, "SHUTDOWN") == 0 )
+    {
+      if( fd >= 0 ) close(fd);
+      MESSAGE<<"Deck server is shut down by client." << std::endl; RECORD();
+      break;
+    }
+
+    // the log of these cards goes to the client too
+    SocketBuf client(fd);
+    if( fd >= 0 )
+      genius_log.addStream("client", &client);
+
+    const size_t first = _decks.n_cards();
+    int error = _decks.read_card_buffer(text.data(), text.size());
+    Parallel::max(error);
+    if( error )
+    {
+      MESSAGE<<"ERROR: I can't parse the cards from client." << std::endl; RECORD();
+    }
+    else
+      _control.run_cards(first);
+
+    MESSAGE<<"Deck server: " << _decks.n_cards() - first << " cards done." << std::endl; RECORD();
+
+    if( fd >= 0 )
+    {
+      genius_log.removeStream("client");
+      close(fd);
+    }
+  }
+}
@@ -20,6 +20,8 @@
 /********************************************************************************/
 
 
+#include <cmath>
+
 #include "mesh_base.h"
 #include "simulation_system.h"
 #include "simulation_region.h"
@@ -164,11 +166,50 @@ void ExtendTo3D::sync_solution(const std::string &sol)
 }
 
 
+std::vector<double> ExtendTo3D::z_layers() const
+{
+  double zmin = _card.get_real("z.min", 0.0, "z.front")*um;
+  double zmax = _card.get_real("z.max", 1.0, "z.back")*um;
+  int    zdiv = _card.get_int("n.spaces", 1);
+  double ratio = _card.get_real("z.ratio", 1.0);
+  bool   symmetric = _card.get_bool("z.symmetric", false);
+
+  genius_assert(zdiv > 0 && ratio > 0.0);
+
+  // the spacing of each space, graded by ratio
+  std::vector<double> dz(zdiv);
+  if(symmetric)
+  {
+    // grow from both faces to the center
+    for(int z=0; z<zdiv; ++z)
+      dz[z] = std::pow(ratio, static_cast<double>(std::min(z, zdiv-1-z)));
+  }
+  else
+  {
+    for(int z=0; z<zdiv; ++z)
+      dz[z] = std::pow(ratio, static_cast<double>(z));
+  }
+
+  double total = 0.0;
+  for(int z=0; z<zdiv; ++z)
+    total += dz[z];
+
+  std::vector<double> zloc(zdiv+1);
+  zloc[0] = zmin;
+  for(int z=0; z<zdiv; ++z)
+    zloc[z+1] = zloc[z] + dz[z]*(zmax - zmin)/total;
+  zloc[zdiv] = zmax;
+
+  return zloc;
+}
+
+
 void ExtendTo3D::set_new_system()
 {
   MeshBase & mesh = _system.mesh();
 
-  std::map<const Node *, unsigned int> node_to_old_node_id;
+  // the new nodes in creation order, the k-th node is extruded from old node k%n_nodes
+  std::vector<const Node *> new_nodes;
 
   // set new mesh
   if(Genius::processor_id() == 0)
@@ -176,24 +217,41 @@ void ExtendTo3D::set_new_system()
     mesh.magic_num() = magic_num + 2008;
 
     // z locations
-    double zmin = _card.get_real("z.min", 0.0, "z.front")*um;
-    double zmax = _card.get_real("z.max", 1.0, "z.back")*um;
-    int    zdiv = _card.get_int("n.spaces", 1);
+    std::vector<double> zloc = z_layers();
+    int zdiv = static_cast<int>(zloc.size()) - 1;
 
-    // set new points
-    for(int z=0; z<=zdiv; ++z)
+    //set boundary on frond/back face
+    std::map<unsigned int, short int>    boundary_id_map;
+    for(unsigned int n=0; n<n_subs; ++n)
     {
-      double zloc = zmin + z*(zmax - zmin)/zdiv;
-      for(unsigned n=0; n<n_nodes; ++n)
+      std::string bd_label = subdomain_label[n] + "_Neumann";
+      if(bd_map.find(bd_label)==bd_map.end())
       {
-        Node * node = mesh.add_point(Point(mesh_points[n].x(), mesh_points[n].y(), zloc));
-        node_to_old_node_id[node] = n;
+        short int bd_id = 0;
+        for(Bd_It it = bd_map.begin(); it!=bd_map.end(); ++it)
+          bd_id = std::max(bd_id, it->second);
+        bd_map[bd_label] = bd_id+1;
       }
+      boundary_id_map[n] = bd_map[bd_label];
     }
 
-    // set new elem
+    // boundary sides of each old elem
+    std::multimap<unsigned int, std::pair<unsigned short int, short int> > elem_bd_sides;
+    for(unsigned int n=0; n<bd_elems.size(); ++n)
+      elem_bd_sides.insert(std::make_pair(bd_elems[n], std::make_pair(bd_sides[n], bd_ids[n])));
+
+    new_nodes.reserve(n_nodes*(zdiv+1));
+
+    // the front layer of nodes
+    for(unsigned n=0; n<n_nodes; ++n)
+      new_nodes.push_back(mesh.add_point(Point(mesh_points[n].x(), mesh_points[n].y(), zloc[0])));
+
+    // extrude layer by layer, the elems between layer z and z+1 only refer to these two layers
     for(int z=0; z<zdiv; ++z)
     {
+      for(unsigned n=0; n<n_nodes; ++n)
+        new_nodes.push_back(mesh.add_point(Point(mesh_points[n].x(), mesh_points[n].y(), zloc[z+1])));
+
       unsigned int cnt = 0;
 
       for(unsigned n=0; n<n_elem; ++n)
@@ -242,9 +300,26 @@ void ExtendTo3D::set_new_system()
             default: genius_error();
         }
         mesh.add_elem(elem);
+
+        // side boundary of this layer
+        std::multimap<unsigned int, std::pair<unsigned short int, short int> >::const_iterator bd_it = elem_bd_sides.lower_bound(n);
+        for(; bd_it!=elem_bd_sides.upper_bound(n); ++bd_it)
+          mesh.boundary_info->add_side (elem, bd_it->second.first + 1, bd_it->second.second);
+
+        //frond side
+        if(z==0)
+          mesh.boundary_info->add_side (elem, 0, boundary_id_map[subdomain_ID]);
+
+        // back side
+        if(z==zdiv-1)
+          mesh.boundary_info->add_side (elem, elem->n_sides()-1, boundary_id_map[subdomain_ID]);
       }
     }
 
+    // the 2D mesh is not needed any more
+    std::vector<Point>().swap(mesh_points);
+    std::vector<int>().swap(mesh_conn);
+
     // set new subdomains
     mesh.set_n_subdomains () = n_subs;
     for(unsigned int n=0; n<n_subs; ++n)
@@ -253,49 +328,6 @@ void ExtendTo3D::set_new_system()
       mesh.set_subdomain_material(n, subdomain_material[n]);
     }
 
-    // set boundary
-    for(int z=0; z<zdiv; ++z)
-      for(unsigned int n=0; n<bd_elems.size(); ++n)
-      {
-        unsigned int old_elem_id = bd_elems[n];
-        unsigned int old_side    = bd_sides[n];
-
-        unsigned int elem_id = old_elem_id + z*n_elem;
-        const Elem* elem = mesh.elem(elem_id);
-        unsigned int side = old_side + 1;
-
-        mesh.boundary_info->add_side (elem, side, bd_ids[n]);
-      }
-
-    //set boundary on frond/back face
-    std::map<unsigned int, short int>    boundary_id_map;
-    for(unsigned int n=0; n<n_subs; ++n)
-    {
-      std::string bd_label = mesh.subdomain_label_by_id(n) + "_Neumann";
-      if(bd_map.find(bd_label)==bd_map.end())
-      {
-        short int bd_id = 0;
-        for(Bd_It it = bd_map.begin(); it!=bd_map.end(); ++it)
-          bd_id = std::max(bd_id, it->second);
-        bd_map[bd_label] = bd_id+1;
-      }
-      boundary_id_map[n] = bd_map[bd_label];
-    }
-
-    //frond side
-    for(unsigned int n=0; n<n_elem; ++n)
-    {
-      const Elem* elem = mesh.elem(n);
-      mesh.boundary_info->add_side (elem, 0, boundary_id_map[elem->subdomain_id()]);
-    }
-
-    // back side
-    for(unsigned int n=0; n<n_elem; ++n)
-    {
-      const Elem* elem = mesh.elem(n + (zdiv-1)*n_elem);
-      mesh.boundary_info->add_side (elem, elem->n_sides()-1, boundary_id_map[elem->subdomain_id()]);
-    }
-
     // set boundary label
     for(Bd_It it = bd_map.begin(); it!=bd_map.end(); ++it)
       mesh.boundary_info->set_label_to_id(it->second, it->first);
@@ -311,15 +343,50 @@ void ExtendTo3D::set_new_system()
 
 
   // set renumbered node id to original node id map
+  std::vector<unsigned int> new_to_old;
   if(Genius::processor_id() == 0)
   {
-    std::map<const Node *, unsigned int>::iterator  it=node_to_old_node_id.begin();
-    for(; it!=node_to_old_node_id.end(); ++it)
-      _node_to_old_node_id_map[it->first->id()] = it->second;
+    new_to_old.resize(mesh.max_node_id(), invalid_uint);
+    for(unsigned int k=0; k<new_nodes.size(); ++k)
+      new_to_old[new_nodes[k]->id()] = k%n_nodes;
+    std::vector<const Node *>().swap(new_nodes);
   }
 
-  Parallel::broadcast(_node_to_old_node_id_map);
+  scatter_node_map(new_to_old);
+}
+
 
+
+void ExtendTo3D::scatter_node_map(const std::vector<unsigned int> &new_to_old)
+{
+  // the nodes this processor should know
+  for(unsigned int r=0; r<_system.n_regions(); r++)
+  {
+    const SimulationRegion * region = _system.region(r);
+    SimulationRegion::const_local_node_iterator it = region->on_local_nodes_begin();
+    SimulationRegion::const_local_node_iterator it_end = region->on_local_nodes_end();
+    for(; it!=it_end; ++it)
+      _node_to_old_node_id_map[(*it)->root_node()->id()] = invalid_uint;
+  }
+
+  unsigned int n_total = new_to_old.size();
+  Parallel::broadcast(n_total);
+
+  // broadcast the map piece by piece
+  const unsigned int piece_size = 1<<20;
+  for(unsigned int begin=0; begin<n_total; begin+=piece_size)
+  {
+    unsigned int end = std::min(begin+piece_size, n_total);
+
+    std::vector<unsigned int> piece;
+    if(Genius::processor_id() == 0)
+      piece.assign(new_to_old.begin()+begin, new_to_old.begin()+end);
+    Parallel::broadcast(piece);
+
+    std::map<unsigned int, unsigned int>::iterator it = _node_to_old_node_id_map.lower_bound(begin);
+    for(; it!=_node_to_old_node_id_map.end() && it->first<end; ++it)
+      it->second = piece[it->first - begin];
+  }
 }
 
 
@@ -348,7 +415,7 @@ void ExtendTo3D::set_new_regions()
       node_data->n()        =  variables["n"     ][r][old_node_id];
       node_data->p()        =  variables["p"     ][r][old_node_id];
       node_data->mole_x()   =  variables["mole_x"][r][old_node_id];
-      node_data->mole_x()   =  variables["mole_x"][r][old_node_id];
+      node_data->mole_y()   =  variables["mole_y"][r][old_node_id];
     }
     region->reinit_after_import();
   }
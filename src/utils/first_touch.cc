@@ -0,0 +1,54 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+#include <cstring>
+
+#include "genius_env.h"
+#include "first_touch.h"
+
+#ifdef HAVE_OPENMP
+  #include <omp.h>
+#endif
+
+
+void first_touch(void * p, size_t bytes)
+{
+  char * data = static_cast<char *>(p);
+
+  if( Genius::n_threads() < 2 || bytes < FirstTouchAllocator<char>::min_bytes )
+  {
+    memset(data, 0, bytes);
+    return;
+  }
+
+#pragma omp parallel num_threads(Genius::n_threads())
+  {
+#ifdef HAVE_OPENMP
+    const size_t n_threads = omp_get_num_threads();
+#else
+    const size_t n_threads = 1;
+#endif
+    const size_t t = Genius::thread_id();
+    const size_t begin = bytes*t/n_threads;
+    const size_t end   = bytes*(t+1)/n_threads;
+    memset(data + begin, 0, end - begin);
+  }
+}
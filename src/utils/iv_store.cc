@@ -0,0 +1,131 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <iomanip>
+
+#include "iv_store.h"
+
+
+unsigned int IVStore::add_column(const std::string &name, const std::string &type, bool text)
+{
+  genius_assert(_n_rows == 0);
+
+  Column column;
+  column.name = name;
+  column.type = type;
+  column.text = text;
+  _columns.push_back(column);
+
+  return _columns.size()-1;
+}
+
+
+unsigned int IVStore::column_index(const std::string &name) const
+{
+  for(unsigned int c=0; c<_columns.size(); ++c)
+    if( _columns[c].name == name ) return c;
+  return invalid_uint;
+}
+
+
+void IVStore::append_row(const std::vector<double> &row)
+{
+  genius_assert(row.size() == _columns.size());
+  if( _columns.empty() ) return;
+
+  for(unsigned int c=0; c<_columns.size(); ++c)
+    _columns[c].values.push_back(row[c]);
+  _n_rows++;
+}
+
+
+void IVStore::truncate(unsigned int n_rows)
+{
+  if( n_rows >= _n_rows ) return;
+
+  for(unsigned int c=0; c<_columns.size(); ++c)
+    _columns[c].values.resize(n_rows);
+  _n_rows = n_rows;
+}
+
+
+void IVStore::write_raw(std::ostream &out, bool binary) const
+{
+  std::vector<unsigned int> columns;
+  for(unsigned int c=0; c<_columns.size(); ++c)
+    if( _columns[c].text ) columns.push_back(c);
+
+  out << "Flags: real" << '\n';
+
+  out << "No. Variables: " << columns.size() << '\n';
+  out << "No. Points: "    << _n_rows  << '\n' << '\n';
+
+  // write variables
+  out << "Variables:" << '\n';
+  for(unsigned int n=0; n<columns.size(); n++)
+    out << '\t' << n << '\t' << _columns[columns[n]].name << '\t' << _columns[columns[n]].type << '\n';
+
+  out << '\n';
+
+  if( binary )
+  {
+    // SPICE binary raw is row major, one row of doubles per point
+    out << "Binary:" << '\n';
+    std::vector<double> buffer(_n_rows*columns.size());
+    for(unsigned int i=0; i<_n_rows; i++)
+      for(unsigned int n=0; n<columns.size(); n++)
+        buffer[i*columns.size()+n] = _columns[columns[n]].values[i];
+    if( !buffer.empty() )
+      out.write(reinterpret_cast<const char *>(&buffer[0]), buffer.size()*sizeof(double));
+    out.flush();
+    return;
+  }
+
+  // write values
+  out << "Values:" << '\n';
+
+  out << std::setprecision(15) << std::scientific << std::right;
+
+  for(unsigned int i=0; i<_n_rows; i++)
+  {
+    out << " " << i;
+    for(unsigned int n=0; n<columns.size(); n++)
+      out << '\t' << std::setw(25) << _columns[columns[n]].values[i] << '\n';
+  }
+  out.flush();
+}
+
+
+void IVStore::write_columns(std::ostream &out) const
+{
+  out << "Title: Genius IV Store" << '\n';
+  out << "No. Columns: " << _columns.size() << '\n';
+  out << "No. Rows: "    << _n_rows << '\n';
+  for(unsigned int c=0; c<_columns.size(); c++)
+    out << '\t' << c << '\t' << _columns[c].name << '\t' << _columns[c].type << '\n';
+
+  out << "Binary:" << '\n';
+  for(unsigned int c=0; c<_columns.size(); c++)
+    if( _n_rows )
+      out.write(reinterpret_cast<const char *>(&_columns[c].values[0]), _n_rows*sizeof(double));
+  out.flush();
+}
@@ -0,0 +1,172 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cstdlib>
+#include <string>
+#include <fstream>
+
+#include "mapped_file.h"
+#include "config.h"
+
+#ifndef CYGWIN
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+
+MappedFile::MappedFile(const std::string &filename)
+  : _data(0), _size(0), _good(false), _mapped(false)
+{
+#ifndef CYGWIN
+  int fd = open(filename.c_str(), O_RDONLY);
+  if( fd >= 0 )
+  {
+    struct stat st;
+    if( fstat(fd, &st) == 0 )
+    {
+      _size = st.st_size;
+      _good = true;
+      if( _size )
+      {
+        void * addr = mmap(0, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if( addr != MAP_FAILED )
+        {
+          // the file is read once from begin to end
+          madvise(addr, _size, MADV_SEQUENTIAL);
+          _data = static_cast<const char *>(addr);
+          _mapped = true;
+        }
+      }
+    }
+    close(fd);
+    if( _mapped || !_size ) return;
+  }
+#endif
+
+  // can not map the file, load it into buffer
+  std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+  if( !in.good() ) { _good = false; _size = 0; return; }
+
+  in.seekg(0, std::ios::end);
+  _size = in.tellg();
+  in.seekg(0, std::ios::beg);
+
+  _buffer.resize(_size);
+  if( _size ) in.read(&_buffer[0], _size);
+
+  _data = _size ? &_buffer[0] : 0;
+  _good = true;
+}
+
+
+MappedFile::~MappedFile()
+{
+#ifndef CYGWIN
+  if( _mapped )
+    munmap(const_cast<char *>(_data), _size);
+#endif
+}
+
+
+
+namespace NumberScan
+{
+
+  const char * read_number(const char *p, const char *end, double &value, bool &is_integer)
+  {
+    // exact powers of ten in double
+    static const double pow10[] =
+    {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char * begin = p;
+
+    bool negative = false;
+    if( p<end && (*p=='+' || *p=='-') ) { negative = (*p=='-'); ++p; }
+
+    // significant digits, as long as they fit in 2^53
+    unsigned long long mantissa = 0;
+    int  exponent = 0;
+    bool exact = true;
+
+    const char * digit_begin = p;
+    for( ; p<end && *p>='0' && *p<='9'; ++p )
+    {
+      if( mantissa < (1ULL<<53)/10 ) { mantissa = mantissa*10 + (*p-'0'); }
+      else { ++exponent; exact = false; }
+    }
+    int n_digits = p - digit_begin;
+
+    is_integer = true;
+    if( p<end && *p=='.' )
+    {
+      is_integer = false;
+      ++p;
+      const char * fraction_begin = p;
+      for( ; p<end && *p>='0' && *p<='9'; ++p )
+      {
+        if( mantissa < (1ULL<<53)/10 ) { mantissa = mantissa*10 + (*p-'0'); --exponent; }
+        else exact = false;
+      }
+      n_digits += p - fraction_begin;
+    }
+
+    // no digit at all
+    if( !n_digits ) return 0;
+
+    if( p<end && (*p=='e' || *p=='E') )
+    {
+      const char * q = p+1;
+      bool exp_negative = false;
+      if( q<end && (*q=='+' || *q=='-') ) { exp_negative = (*q=='-'); ++q; }
+      if( q<end && *q>='0' && *q<='9' )
+      {
+        int e = 0;
+        for( ; q<end && *q>='0' && *q<='9'; ++q )
+          if( e < 10000 ) e = e*10 + (*q-'0');
+        exponent += exp_negative ? -e : e;
+        is_integer = false;
+        p = q;
+      }
+    }
+
+    // the mantissa and the power of ten are both exact, so is their product or quotient
+    if( exact && exponent >= -22 && exponent <= 22 )
+    {
+      value = static_cast<double>(mantissa);
+      if( exponent < 0 ) value /= pow10[-exponent];
+      else               value *= pow10[exponent];
+      if( negative ) value = -value;
+      return p;
+    }
+
+    // too many digits or too large exponent, let strtod do the rounding
+    std::string token(begin, p);
+    value = strtod(token.c_str(), 0);
+    return p;
+  }
+
+}
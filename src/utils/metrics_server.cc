@@ -0,0 +1,469 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <algorithm>
+
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "metrics_server.h"
+#include "genius_env.h"
+#include "genius_common.h"
+
+
+namespace
+{
+  double wall_time()
+  {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + 1e-6*t.tv_usec;
+  }
+
+  // escape the label value
+  std::string label_value(const std::string &s)
+  {
+    std::string out;
+    for(unsigned int i=0; i<s.size(); ++i)
+    {
+      if( s[i] == '\n' ) { out += "\\n"; continue; }
+      if( s[i] == '"' || s[i] == '\\' ) out += '\\';
+      out += s[i];
+    }
+    return out;
+  }
+
+  // send all the bytes, return false on error
+  bool send_all(int fd, const std::string &data)
+  {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    size_t pos = 0;
+    while( pos < data.size() )
+    {
+      ssize_t n = send(fd, data.data()+pos, data.size()-pos, flags);
+      if( n < 0 && errno == EINTR ) continue;
+      if( n <= 0 ) return false;
+      pos += n;
+    }
+    return true;
+  }
+
+  // read the I/O counters of this process, linux only
+  bool io_bytes(double &read_bytes, double &write_bytes)
+  {
+    std::ifstream in("/proc/self/io");
+    if( !in.good() ) return false;
+    std::string key;
+    double value;
+    read_bytes = write_bytes = 0;
+    while( in >> key >> value )
+    {
+      if( key == "read_bytes:"  ) read_bytes  = value;
+      if( key == "write_bytes:" ) write_bytes = value;
+    }
+    return true;
+  }
+}
+
+
+MetricsServer & MetricsServer::instance()
+{
+  static MetricsServer server;
+  return server;
+}
+
+
+void MetricsServer::record(const std::string &record,
+                           const std::vector<std::pair<std::string, double> > &values,
+                           const std::vector<std::pair<std::string, std::string> > &strings)
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&_mutex);
+#endif
+
+  std::map<std::string, double> v(values.begin(), values.end());
+
+  if( record == "iteration" )
+  {
+    // Newton iterations and linear iterations are counted as they happen
+    if( v["its"] > 0 )
+      _counters["genius_newton_iterations_total"] += 1;
+    _counters["genius_ksp_iterations_total"] += v["ksp_its"];
+    _gauges["genius_newton_iteration"]        = v["its"];
+    _gauges["genius_function_norm"]           = v["fnorm"];
+    _gauges["genius_resident_memory_bytes"]   = v["rss"];
+
+    for(unsigned int n=0; n<values.size(); ++n)
+    {
+      const std::string &key = values[n].first;
+      const std::string suffix("_norm");
+      if( key.size() > suffix.size() && key.compare(key.size()-suffix.size(), suffix.size(), suffix) == 0 )
+        _norms[key.substr(0, key.size()-suffix.size())] = values[n].second;
+    }
+  }
+
+  if( record == "step" )
+  {
+    const double now = wall_time();
+    _counters["genius_steps_total"] += 1;
+    if( v["converged"] == 0 )
+      _counters["genius_failed_steps_total"] += 1;
+    _counters["genius_step_retries_total"] += v["retries"];
+    _gauges["genius_sweep_value"]           = v["value"];
+    _gauges["genius_step_newton_iterations"] = v["its"];
+    _gauges["genius_step_seconds"]          = now - _t_last_step;
+    _gauges["genius_last_step_timestamp_seconds"] = now;
+    if( v.count("dt") )
+      _gauges["genius_time_step_ps"] = v["dt"];
+    _t_last_step = now;
+
+    for(unsigned int n=0; n<strings.size(); ++n)
+      if( strings[n].first == "type" ) _step_type = strings[n].second;
+  }
+
+  if( record == "lte_reject" )
+    _counters["genius_lte_rejects_total"] += 1;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&_mutex);
+#endif
+}
+
+
+std::string MetricsServer::exposition()
+{
+  std::ostringstream out;
+  out.precision(std::numeric_limits<double>::digits10);
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&_mutex);
+#endif
+
+  const std::string run = "run=\"" + label_value(_job) + "\"";
+
+  out << "# TYPE genius_info gauge\n";
+  out << "genius_info{" << run << ",step_type=\"" << label_value(_step_type) << "\",processors=\"" << Genius::n_processors() << "\"} 1\n";
+
+  out << "# TYPE genius_uptime_seconds gauge\n";
+  out << "genius_uptime_seconds{" << run << "} " << wall_time() - _t_start << '\n';
+
+  std::map<std::string, double>::const_iterator it;
+  for( it = _counters.begin(); it != _counters.end(); ++it )
+  {
+    out << "# TYPE " << it->first << " counter\n";
+    out << it->first << '{' << run << "} " << it->second << '\n';
+  }
+  for( it = _gauges.begin(); it != _gauges.end(); ++it )
+  {
+    out << "# TYPE " << it->first << " gauge\n";
+    out << it->first << '{' << run << "} " << it->second << '\n';
+  }
+
+  if( !_norms.empty() )
+  {
+    out << "# TYPE genius_equation_norm gauge\n";
+    for( it = _norms.begin(); it != _norms.end(); ++it )
+      out << "genius_equation_norm{" << run << ",equation=\"" << label_value(it->first) << "\"} " << it->second << '\n';
+  }
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&_mutex);
+#endif
+
+  double read_bytes, write_bytes;
+  if( io_bytes(read_bytes, write_bytes) )
+  {
+    out << "# TYPE genius_io_read_bytes_total counter\n";
+    out << "genius_io_read_bytes_total{" << run << "} " << read_bytes << '\n';
+    out << "# TYPE genius_io_write_bytes_total counter\n";
+    out << "genius_io_write_bytes_total{" << run << "} " << write_bytes << '\n';
+  }
+
+  return out.str();
+}
+
+
+void MetricsServer::_serve(int fd)
+{
+  // read the request head, give up on slow clients
+  std::string request;
+  while( request.find("\r\n\r\n") == std::string::npos && request.size() < 8192 )
+  {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if( poll(&pfd, 1, 1000) <= 0 ) break;
+
+    char buf[1024];
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if( n <= 0 ) break;
+    request.append(buf, n);
+  }
+
+  std::string status, body;
+  if( request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0 )
+  {
+    status = "200 OK";
+    body = exposition();
+  }
+  else
+  {
+    status = "404 Not Found";
+    body = "genius metrics are at /metrics\n";
+  }
+
+  std::ostringstream response;
+  response << "HTTP/1.0 " << status << "\r\n"
+           << "Content-Type: text/plain; version=0.0.4\r\n"
+           << "Content-Length: " << body.size() << "\r\n"
+           << "Connection: close\r\n\r\n"
+           << body;
+  send_all(fd, response.str());
+}
+
+
+void MetricsServer::_push()
+{
+  std::string host = _gateway, port = "9091";
+  std::string::size_type colon = _gateway.rfind(':');
+  if( colon != std::string::npos )
+  {
+    host = _gateway.substr(0, colon);
+    port = _gateway.substr(colon+1);
+  }
+
+  struct addrinfo hints, *res;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if( getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0 ) return;
+
+  int fd = -1;
+  for( struct addrinfo *p = res; p; p = p->ai_next )
+  {
+    fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+    if( fd < 0 ) continue;
+    if( connect(fd, p->ai_addr, p->ai_addrlen) == 0 ) break;
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if( fd < 0 ) return;
+
+  const std::string body = exposition();
+  std::ostringstream request;
+  request << "PUT /metrics/job/" << _job << " HTTP/1.0\r\n"
+          << "Host: " << _gateway << "\r\n"
+          << "Content-Type: text/plain; version=0.0.4\r\n"
+          << "Content-Length: " << body.size() << "\r\n\r\n"
+          << body;
+  if( send_all(fd, request.str()) )
+  {
+    // wait for the status line, the gateway closes the connection
+    char buf[256];
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if( poll(&pfd, 1, 2000) > 0 )
+    {
+      ssize_t n = recv(fd, buf, sizeof(buf), 0);
+      (void)n;
+    }
+  }
+  close(fd);
+}
+
+
+#ifdef HAVE_PTHREAD
+
+MetricsServer::MetricsServer()
+  : _started(false), _interval(15.0), _listen_fd(-1), _stop(false)
+{
+  _t_start = _t_last_step = wall_time();
+  pthread_mutex_init(&_mutex, NULL);
+}
+
+
+MetricsServer::~MetricsServer()
+{
+  if( _started )
+  {
+    SolverStats::remove_listener(this);
+
+    if( Genius::is_first_processor() )
+    {
+      pthread_mutex_lock(&_mutex);
+      _stop = true;
+      pthread_mutex_unlock(&_mutex);
+      pthread_join(_thread, NULL);
+    }
+  }
+  pthread_mutex_destroy(&_mutex);
+}
+
+
+void MetricsServer::start(const std::string &address, int port,
+                          const std::string &gateway, double interval,
+                          const std::string &job)
+{
+  if( _started ) return;
+  _started = true;
+
+  // the records are built on all the processors
+  SolverStats::add_listener(this);
+
+  if( !Genius::is_first_processor() ) return;
+
+  _job      = job;
+  _gateway  = gateway;
+  _interval = std::max(1.0, interval);
+
+  // the counters exist from the beginning, rate() needs a zero sample
+  const char * counters[] = {"genius_steps_total", "genius_failed_steps_total", "genius_step_retries_total",
+                             "genius_newton_iterations_total", "genius_ksp_iterations_total", "genius_lte_rejects_total"};
+  for(unsigned int n=0; n<sizeof(counters)/sizeof(counters[0]); ++n)
+    _counters[counters[n]] = 0.0;
+
+  if( !address.empty() )
+  {
+    std::ostringstream service;
+    service << port;
+
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if( getaddrinfo(address.c_str(), service.str().c_str(), &hints, &res) == 0 )
+    {
+      for( struct addrinfo *p = res; p && _listen_fd < 0; p = p->ai_next )
+      {
+        int fd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        if( fd < 0 ) continue;
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if( bind(fd, p->ai_addr, p->ai_addrlen) == 0 && listen(fd, 8) == 0 )
+          _listen_fd = fd;
+        else
+          close(fd);
+      }
+      freeaddrinfo(res);
+    }
+
+    if( _listen_fd < 0 )
+    {
+      MESSAGE<<"Warning: metrics server can not listen on " << address << ":" << port << std::endl; RECORD();
+    }
+  }
+
+  pthread_create(&_thread, NULL, _thread_main, this);
+}
+
+
+void * MetricsServer::_thread_main(void *arg)
+{
+  MetricsServer * server = static_cast<MetricsServer *>(arg);
+
+  double next_push = wall_time() + server->_interval;
+  for(;;)
+  {
+    pthread_mutex_lock(&server->_mutex);
+    const bool stop = server->_stop;
+    pthread_mutex_unlock(&server->_mutex);
+    if( stop ) break;
+
+    // wake up regularly to check the stop flag and the push clock
+    struct pollfd pfd;
+    pfd.fd = server->_listen_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if( server->_listen_fd >= 0 )
+    {
+      if( poll(&pfd, 1, 200) > 0 )
+      {
+        int fd = accept(server->_listen_fd, NULL, NULL);
+        if( fd >= 0 )
+        {
+          server->_serve(fd);
+          close(fd);
+        }
+      }
+    }
+    else
+      usleep(200000);
+
+    if( !server->_gateway.empty() && wall_time() >= next_push )
+    {
+      server->_push();
+      next_push = wall_time() + server->_interval;
+    }
+  }
+
+  // the final state
+  if( !server->_gateway.empty() )
+    server->_push();
+
+  if( server->_listen_fd >= 0 )
+    close(server->_listen_fd);
+
+  return NULL;
+}
+
+#else
+
+MetricsServer::MetricsServer()
+  : _started(false), _interval(15.0), _listen_fd(-1)
+{
+  _t_start = _t_last_step = wall_time();
+}
+
+
+MetricsServer::~MetricsServer()
+{}
+
+
+void MetricsServer::start(const std::string &, int, const std::string &, double, const std::string &)
+{
+  if( _started ) return;
+  _started = true;
+
+  MESSAGE<<"Warning: metrics server needs pthread support, it is disabled." << std::endl; RECORD();
+}
+
+#endif
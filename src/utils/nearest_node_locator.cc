@@ -20,11 +20,13 @@
 /********************************************************************************/
 
 #include <set>
-#include "mesh_base.h"
-#include "nearest_node_locator.h"
+#include <cmath>
+#include <algorithm>
 
+#include "ANN/ANN.h"
 
-inline Real get_location( const Node *n, unsigned int k ) { return n->coord(k); }
+#include "mesh_base.h"
+#include "nearest_node_locator.h"
 
 
 
@@ -44,15 +46,31 @@ NearestNodeLocator::NearestNodeLocator(const MeshBase& mesh)
       node_set.insert(elem->get_node(n));
   }
 
+  _nodes.resize(subdomain_nodes.size());
+  _coords.resize(subdomain_nodes.size());
+  _ann_points.resize(subdomain_nodes.size());
+  _kdtrees.resize(subdomain_nodes.size(), static_cast<ANNkd_tree *>(0));
+
   for(unsigned int n=0; n<subdomain_nodes.size(); ++n)
   {
     const std::set<const Node *> & node_set = subdomain_nodes[n];
-    kdtree_type * kd_tree = new kdtree_type(std::ptr_fun(get_location));
-    std::set<const Node *>::const_iterator node_it =node_set.begin();
-    for( ; node_it!=node_set.end(); ++node_it)
-      kd_tree->insert(*node_it);
+    if( node_set.empty() ) continue;
 
-    _kdtrees.push_back(kd_tree);
+    _nodes[n].assign(node_set.begin(), node_set.end());
+
+    std::vector<double> & coords = _coords[n];
+    coords.resize(3*_nodes[n].size());
+    for(unsigned int i=0; i<_nodes[n].size(); ++i)
+      for(unsigned int k=0; k<3; ++k)
+        coords[3*i+k] = _nodes[n][i]->coord(k);
+
+    // coords is not resized later, the points are stable
+    std::vector<double *> & points = _ann_points[n];
+    points.resize(_nodes[n].size());
+    for(unsigned int i=0; i<points.size(); ++i)
+      points[i] = &coords[3*i];
+
+    _kdtrees[n] = new ANNkd_tree(&points[0], points.size(), 3);
   }
 }
 
@@ -66,23 +84,35 @@ NearestNodeLocator::~NearestNodeLocator()
 
 Real NearestNodeLocator::distance_to_nearest_node(const Point &p, unsigned int subdomain) const
 {
-  const kdtree_type * kd_tree = _kdtrees[subdomain];
-  Node source_node(p);
+  ANNkd_tree * kd_tree = _kdtrees[subdomain];
+  genius_assert(kd_tree);
 
-  std::pair<kdtree_type::const_iterator,  kdtree_type::distance_type> pItr = kd_tree->find_nearest(&source_node, 1e30);
-  assert(pItr.first != kd_tree->end() );
+  ANNcoord q[3] = {p(0), p(1), p(2)};
+  ANNidx   idx;
+  ANNdist  dist;
+  kd_tree->annkSearch(q, 1, &idx, &dist);
 
-  return pItr.second;
+  return std::sqrt(dist);
 }
 
 
 std::vector<const Node * > NearestNodeLocator::nearest_nodes(const Point &p, Real radius, unsigned int subdomain) const
 {
-  const kdtree_type * kd_tree = _kdtrees[subdomain];
-  Node source_node(p);
-
   std::vector< const Node * > nn;
-  kd_tree->find_within_range(&source_node, radius, std::back_inserter(nn));
+
+  ANNkd_tree * kd_tree = _kdtrees[subdomain];
+  if( !kd_tree ) return nn;
+
+  ANNcoord q[3] = {p(0), p(1), p(2)};
+  const int n_found = kd_tree->annkFRSearch(q, radius*radius, 0);
+  if( n_found == 0 ) return nn;
+
+  std::vector<ANNidx>  idx(n_found);
+  std::vector<ANNdist> dist(n_found);
+  kd_tree->annkFRSearch(q, radius*radius, n_found, &idx[0], &dist[0]);
+
+  for(int i=0; i<n_found; ++i)
+    nn.push_back(_nodes[subdomain][idx[i]]);
 
   return nn;
 }
@@ -90,28 +120,75 @@ std::vector<const Node * > NearestNodeLocator::nearest_nodes(const Point &p, Rea
 
 std::vector<const Node * > NearestNodeLocator::nearest_nodes(const Point &p1, const Point &p2, Real radius, unsigned int subdomain) const
 {
+  std::vector<int>    idx;
+  std::vector<double> dist;
   std::vector<const Node *> nn;
-  std::set<const Node *> nn_set;
-  this->nearest_nodes(p1, p2, radius, subdomain, nn_set);
-  nn.insert(nn.end(), nn_set.begin(), nn_set.end());
+  this->_segment_search(p1, p2, radius, subdomain, idx, dist, nn);
   return nn;
 }
 
 
-void NearestNodeLocator::nearest_nodes(const Point &p1, const Point &p2, Real radius, unsigned int subdomain, std::set<const Node * >& nns) const
+void NearestNodeLocator::nearest_nodes(const std::vector< std::pair<Point, Point> > &segments, Real radius, unsigned int subdomain,
+                                       std::vector< std::vector<const Node * > > &nns) const
 {
-  unsigned int nn_num = nns.size();
-  std::vector< const Node * > nn1 = this->nearest_nodes(p1, radius, subdomain);
-  std::vector< const Node * > nn2 = this->nearest_nodes(p2, radius, subdomain);
-  nns.insert(nn1.begin(), nn1.end());
-  nns.insert(nn2.begin(), nn2.end());
+  // the work arrays are shared by all the segments
+  std::vector<int>    idx;
+  std::vector<double> dist;
 
-  if( nns.size() > nn_num )
+  nns.resize(segments.size());
+  for(unsigned int n=0; n<segments.size(); ++n)
   {
-    this->nearest_nodes( p1, 0.5*(p1+p2), radius, subdomain, nns );
-    this->nearest_nodes( 0.5*(p1+p2), p2, radius, subdomain, nns );
+    nns[n].clear();
+    this->_segment_search(segments[n].first, segments[n].second, radius, subdomain, idx, dist, nns[n]);
   }
 }
 
 
+void NearestNodeLocator::_segment_search(const Point &p1, const Point &p2, Real radius, unsigned int subdomain,
+                                         std::vector<int> &idx, std::vector<double> &dist, std::vector<const Node * > &nns) const
+{
+  ANNkd_tree * kd_tree = _kdtrees[subdomain];
+  if( !kd_tree || radius <= 0.0 ) return;
+
+  const std::vector<const Node *> & nodes = _nodes[subdomain];
+  const std::vector<double> & coords = _coords[subdomain];
+
+  // cover the segment by spheres centered at n+1 uniformly spaced points.
+  // with spacing h <= radius, spheres of radius sqrt(radius^2 + (h/2)^2) hold
+  // every node within radius to the segment
+  const Point  dir = p2 - p1;
+  const Real   length = dir.size();
+  const unsigned int n_interval = std::max(1, static_cast<int>(std::ceil(length/radius)));
+  const Real   h = length/n_interval;
+  const Real   r2 = radius*radius + 0.25*h*h;
+
+  const std::size_t n_begin = nns.size();
+  for(unsigned int i=0; i<=n_interval; ++i)
+  {
+    const Point c = p1 + dir*(static_cast<Real>(i)/n_interval);
+    ANNcoord q[3] = {c(0), c(1), c(2)};
+
+    int n_found = kd_tree->annkFRSearch(q, r2, idx.size(), idx.empty() ? NULL : &idx[0], dist.empty() ? NULL : &dist[0]);
+    if( n_found > static_cast<int>(idx.size()) )
+    {
+      idx.resize(n_found);
+      dist.resize(n_found);
+      kd_tree->annkFRSearch(q, r2, n_found, &idx[0], &dist[0]);
+    }
+
+    for(int k=0; k<n_found; ++k)
+    {
+      // exact distance to the segment
+      const double * x = &coords[3*idx[k]];
+      const Point v(x[0]-p1(0), x[1]-p1(1), x[2]-p1(2));
+      Real t = length > 0.0 ? (v*dir)/(length*length) : 0.0;
+      t = std::max(0.0, std::min(1.0, t));
+      if( (v - dir*t).size_sq() <= radius*radius )
+        nns.push_back(nodes[idx[k]]);
+    }
+  }
+
+  std::sort(nns.begin()+n_begin, nns.end());
+  nns.erase(std::unique(nns.begin()+n_begin, nns.end()), nns.end());
+}
 
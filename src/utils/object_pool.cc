@@ -0,0 +1,139 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+#include <new>
+
+#include "object_pool.h"
+#include "genius_common.h"
+
+
+FixedSizePool::FixedSizePool(size_t size, size_t n_block_per_chunk)
+  : _block_size(aligned_size(size)), _n_block_per_chunk(n_block_per_chunk), _free_list(0), _n_used(0)
+{}
+
+
+size_t FixedSizePool::aligned_size(size_t size)
+{
+  const size_t align = sizeof(double) > sizeof(void *) ? sizeof(double) : sizeof(void *);
+  if( size < sizeof(FreeBlock) ) size = sizeof(FreeBlock);
+  return ((size + align - 1)/align)*align;
+}
+
+
+FixedSizePool::~FixedSizePool()
+{
+  // objects still alive at program exit are not our business, just free the memory
+  release();
+}
+
+
+void * FixedSizePool::allocate()
+{
+  if( _free_list == 0 )
+  {
+    char * chunk = static_cast<char *>(::operator new(_block_size*_n_block_per_chunk));
+    _chunks.push_back(chunk);
+
+    // link the blocks of the new chunk, so that they are allocated in address order
+    for(size_t n=_n_block_per_chunk; n>0; --n)
+    {
+      FreeBlock * block = reinterpret_cast<FreeBlock *>(chunk + (n-1)*_block_size);
+      block->next = _free_list;
+      _free_list = block;
+    }
+  }
+
+  FreeBlock * block = _free_list;
+  _free_list = block->next;
+  _n_used++;
+  return block;
+}
+
+
+void FixedSizePool::deallocate(void * p)
+{
+  if( p == 0 ) return;
+
+  genius_assert(_n_used > 0);
+
+  FreeBlock * block = static_cast<FreeBlock *>(p);
+  block->next = _free_list;
+  _free_list = block;
+
+  // every object is gone, free the memory in bulk
+  if( --_n_used == 0 )
+    release();
+}
+
+
+void FixedSizePool::release()
+{
+  for(size_t n=0; n<_chunks.size(); ++n)
+    ::operator delete(_chunks[n]);
+  _chunks.clear();
+  _free_list = 0;
+  _n_used = 0;
+}
+
+
+
+
+ObjectPool::~ObjectPool()
+{
+  for(size_t n=0; n<_pools.size(); ++n)
+    delete _pools[n];
+  _pools.clear();
+}
+
+
+FixedSizePool * ObjectPool::find_pool(size_t size)
+{
+  // objects with the same aligned size share one pool
+  const size_t block_size = FixedSizePool::aligned_size(size);
+  for(size_t n=0; n<_pools.size(); ++n)
+    if( _pools[n]->block_size() == block_size ) return _pools[n];
+
+  _pools.push_back(new FixedSizePool(block_size));
+  return _pools.back();
+}
+
+
+void * ObjectPool::allocate(size_t size)
+{
+  if( size > max_pool_size )
+    return ::operator new(size);
+  return find_pool(size)->allocate();
+}
+
+
+void ObjectPool::deallocate(void * p, size_t size)
+{
+  if( p == 0 ) return;
+
+  if( size > max_pool_size )
+  {
+    ::operator delete(p);
+    return;
+  }
+
+  find_pool(size)->deallocate(p);
+}
@@ -26,6 +26,7 @@
 #include "point_locator_base.h"
 #include "point_locator_tree.h"
 #include "point_locator_list.h"
+#include "point.h"
 
 
 
@@ -84,3 +85,12 @@ AutoPtr<PointLocatorBase> PointLocatorBase::build (const PointLocatorType t,
   return ap;
 }
 
+
+
+void PointLocatorBase::locate_batch (const std::vector<Point>& p, std::vector<const Elem*>& elems) const
+{
+  elems.resize(p.size());
+  for(unsigned int n=0; n<p.size(); ++n)
+    elems[n] = (*this)(p[n]);
+}
+
@@ -20,6 +20,7 @@
 
 
 // C++ includes
+#include <algorithm>
 
 // Local Includes
 #include "mesh_base.h"
@@ -175,47 +176,117 @@ const Elem* PointLocatorTree::operator() (const Point& p) const
   assert (this->_initialized);
 
   // First check the element from last time before asking the tree
-  if (this->_element==NULL || !(this->_element->contains_point(p)))
+  this->_element = this->_locate(p, this->_element);
+
+  // return the element
+  return this->_element;
+}
+
+
+
+const Elem* PointLocatorTree::_locate (const Point& p, const Elem * hint) const
+{
+  if (hint!=NULL && hint->contains_point(p))
+    return hint;
+
+  // ask the tree
+  const Elem * elem = this->_tree->find_element (p);
+
+  if (elem == NULL)
     {
-	// ask the tree
-	this->_element = this->_tree->find_element (p);
+      // No element seems to contain this point.  If out-of-mesh
+      // mode is enabled, just return NULL.  If not, however, we
+      // have to perform a linear search before we call \p
+      // genius_error() since in the case of curved elements, the
+      // bounding box computed in \p TreeNode::insert(const
+      // Elem*) might be slightly inaccurate.
+      if(!_out_of_mesh_mode)
+	{
+	  MeshBase::const_element_iterator       pos     = this->_mesh.active_elements_begin();
+	  const MeshBase::const_element_iterator end_pos = this->_mesh.active_elements_end();
+
+	  for ( ; pos != end_pos; ++pos)
+	    if ((*pos)->contains_point(p))
+	      return (*pos);
+
+	  std::cerr << std::endl
+		    << " ******** Serious Problem.  Could not find an Element "
+		    << "in the Mesh"
+		    << std:: endl
+		    << " ******** that contains the Point "
+		    << p;
+	  genius_error();
+	}
+    }
 
-	if (this->_element == NULL)
-	  {
-	      // No element seems to contain this point.  If out-of-mesh
-	      // mode is enabled, just return NULL.  If not, however, we
-	      // have to perform a linear search before we call \p
-	      // genius_error() since in the case of curved elements, the
-	      // bounding box computed in \p TreeNode::insert(const
-	      // Elem*) might be slightly inaccurate.
-	    if(!_out_of_mesh_mode)
-	      {
-		MeshBase::const_element_iterator       pos     = this->_mesh.active_elements_begin();
-		const MeshBase::const_element_iterator end_pos = this->_mesh.active_elements_end();
-
-		for ( ; pos != end_pos; ++pos)
-		  if ((*pos)->contains_point(p))
-		    return this->_element = (*pos);
-
-		if (this->_element == NULL)
-		  {
-		    std::cerr << std::endl
-			      << " ******** Serious Problem.  Could not find an Element "
-			      << "in the Mesh"
-			      << std:: endl
-			      << " ******** that contains the Point "
-			      << p;
-		    genius_error();
-		  }
-	      }
-	  }
+  return elem;
+}
+
+
+
+void PointLocatorTree::locate_batch (const std::vector<Point>& p, std::vector<const Elem*>& elems) const
+{
+  assert (this->_initialized);
+
+  elems.resize(p.size());
+  if (p.empty()) return;
+
+  // the bounding box of the points
+  Point min = p[0], max = p[0];
+  for (unsigned int n=1; n<p.size(); ++n)
+    for (unsigned int d=0; d<3; ++d)
+      {
+	min(d) = std::min(min(d), p[n](d));
+	max(d) = std::max(max(d), p[n](d));
+      }
+
+  // sort the points by Morton code of 21 bits each direction
+  std::vector< std::pair<unsigned long long, unsigned int> > order(p.size());
+  for (unsigned int n=0; n<p.size(); ++n)
+    {
+      unsigned long long code = 0;
+      for (unsigned int d=0; d<3; ++d)
+	{
+	  const Real range = max(d) - min(d);
+	  unsigned long long k = range > 0.0 ? static_cast<unsigned long long>((p[n](d) - min(d))/range*2097151.0) : 0;
+	  for (unsigned int b=0; b<21; ++b)
+	    code |= ((k >> b) & 1ULL) << (3*b + d);
+	}
+      order[n] = std::make_pair(code, n);
     }
+  std::sort(order.begin(), order.end());
+
+#pragma omp parallel num_threads(Genius::n_threads())
+  {
+    const Elem * hint = NULL;
+
+#pragma omp for schedule(static)
+    for (int i=0; i<static_cast<int>(order.size()); ++i)
+      {
+	const unsigned int n = order[i].second;
+	const Elem * elem = this->_locate(p[n], hint);
+	elems[n] = elem;
+	if (elem != NULL) hint = elem;
+      }
+  }
+}
 
-  // return the element
-  return this->_element;
+
+
+bool PointLocatorTree::update ()
+{
+  // the tree is shared with the master
+  if (this->_master != NULL || this->_tree == NULL)
+    return false;
+
+  // the cached element may be refined
+  this->_element = NULL;
+
+  return this->_tree->update();
 }
 
 
+
 void PointLocatorTree::enable_out_of_mesh_mode (void)
 {
   /* Out-of-mesh mode is currently only supported if all of the
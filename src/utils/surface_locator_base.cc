@@ -27,6 +27,7 @@
 #include "surface_locator_base.h"
 #include "surface_locator_list.h"
 #include "surface_locator_sphere.h"
+#include "surface_locator_bvh.h"
 
 
 
@@ -50,6 +51,12 @@ AutoPtr<SurfaceLocatorBase> SurfaceLocatorBase::build (const SurfaceLocatorType
         return ap;
       }
 
+      case SurfaceLocator_BVH:
+      {
+        AutoPtr<SurfaceLocatorBase> ap(new SurfaceLocatorBVH(mesh, subdomain));
+        return ap;
+      }
+
       default:
       {
         std::cerr << "ERROR: Bad SurfaceLocatorType = " << t << std::endl;
@@ -79,6 +86,12 @@ AutoPtr<SurfaceLocatorBase> SurfaceLocatorBase::build (const SurfaceLocatorType
       return ap;
     }
 
+    case SurfaceLocator_BVH:
+    {
+      AutoPtr<SurfaceLocatorBase> ap(new SurfaceLocatorBVH(mesh, boundary));
+      return ap;
+    }
+
     default:
     {
       std::cerr << "ERROR: Bad SurfaceLocatorType = " << t << std::endl;
@@ -91,3 +104,19 @@ AutoPtr<SurfaceLocatorBase> SurfaceLocatorBase::build (const SurfaceLocatorType
   return ap;
 }
 
+
+
+void SurfaceLocatorBase::locate_batch (const std::vector<Point>& p,
+                                       std::vector< std::pair<const Elem*, unsigned int> > & surface_elems,
+                                       std::vector<Point> & project_points,
+                                       Real dist) const
+{
+  surface_elems.resize(p.size());
+  project_points.resize(p.size());
+
+  // the locators are read only after init, the queries are independent
+#pragma omp parallel for schedule(dynamic, 64) num_threads(Genius::n_threads())
+  for(int n=0; n<static_cast<int>(p.size()); ++n)
+    surface_elems[n] = (*this)(p[n], project_points[n], dist);
+}
+
@@ -0,0 +1,255 @@
+/********************************************************************************/
+/*     888888    888888888   88     888  88888   888      888    88888888       */
+/*   8       8   8           8 8     8     8      8        8    8               */
+/*  8            8           8  8    8     8      8        8    8               */
+/*  8            888888888   8   8   8     8      8        8     8888888        */
+/*  8      8888  8           8    8  8     8      8        8            8       */
+/*   8       8   8           8     8 8     8      8        8            8       */
+/*     888888    888888888  888     88   88888     88888888     88888888        */
+/*                                                                              */
+/*       A Three-Dimensional General Purpose Semiconductor Simulator.           */
+/*                                                                              */
+/*                                                                              */
+/*  Copyright (C) 2007-2008                                                     */
+/*  Cogenda Pte Ltd                                                             */
+/*                                                                              */
+/*  Please contact Cogenda Pte Ltd for license information                      */
+/*                                                                              */
+/*  Author: Gong Ding   gdiso@ustc.edu                                          */
+/*                                                                              */
+/********************************************************************************/
+
+
+// C++ includes
+#include <algorithm>
+
+// Local Includes
+#include "mesh_base.h"
+#include "boundary_info.h"
+#include "elem.h"
+#include "surface_locator_bvh.h"
+
+
+namespace
+{
+  // max surface elements in a leaf
+  const unsigned int leaf_size = 4;
+
+  /**
+   * order surface elements by centroid along an axis
+   */
+  struct CentroidLess
+  {
+    CentroidLess(const std::vector<Point> &c, unsigned int axis) : centroids(c), k(axis) {}
+    bool operator() (unsigned int a, unsigned int b) const
+    { return centroids[a](k) < centroids[b](k); }
+    const std::vector<Point> & centroids;
+    unsigned int k;
+  };
+}
+
+
+
+//------------------------------------------------------------------
+// SurfaceLocator methods
+SurfaceLocatorBVH::SurfaceLocatorBVH (const MeshBase& mesh, const unsigned int subdomain) :
+    SurfaceLocatorBase (mesh, subdomain)
+{
+  this->init();
+}
+
+
+SurfaceLocatorBVH::SurfaceLocatorBVH (const MeshBase& mesh, const short int boundary) :
+    SurfaceLocatorBase (mesh, boundary)
+{
+  this->init();
+}
+
+
+SurfaceLocatorBVH::~SurfaceLocatorBVH ()
+{
+  this->clear ();
+}
+
+
+
+void SurfaceLocatorBVH::clear ()
+{
+  for(unsigned int n=0; n<_surface_element_list.size(); ++n)
+    delete _surface_element_list[n];
+  _surface_element_list.clear();
+  _surface_to_volume_element.clear();
+  _nodes.clear();
+}
+
+
+
+void SurfaceLocatorBVH::init()
+{
+  std::vector<unsigned int>       elems;
+  std::vector<unsigned short int> sides;
+  std::vector<short int>          bds;
+  _mesh.boundary_info->build_active_side_list (elems, sides, bds);
+
+  std::vector<const Elem *> surface_elems;
+  std::vector< std::pair<const Elem *, unsigned int> > volume_elems;
+  std::vector<Point> centroids, bmin, bmax;
+  for(unsigned int n=0; n<elems.size(); ++n)
+  {
+    const Elem * elem = _mesh.elem(elems[n]);
+    if(subdomain_locator() && elem->subdomain_id() != _subdomain) continue;
+    if(boundary_locator() && bds[n] != _boundary) continue;
+
+    const Elem * surface_elem = elem->build_side(sides[n], false).release();
+    surface_elems.push_back(surface_elem);
+    volume_elems.push_back(std::make_pair(elem, sides[n]));
+
+    Point min(1.e30,   1.e30,  1.e30);
+    Point max(-1.e30, -1.e30, -1.e30);
+    for (unsigned int i=0; i<surface_elem->n_nodes(); i++)
+      for (unsigned int k=0; k<3; k++)
+      {
+        min(k) = std::min(min(k), surface_elem->point(i)(k));
+        max(k) = std::max(max(k), surface_elem->point(i)(k));
+      }
+    bmin.push_back(min);
+    bmax.push_back(max);
+    centroids.push_back(0.5*(min+max));
+  }
+
+  genius_assert( !surface_elems.empty() );
+
+  std::vector<unsigned int> order(surface_elems.size());
+  for(unsigned int n=0; n<order.size(); ++n)
+    order[n] = n;
+
+  _nodes.reserve(2*surface_elems.size()/leaf_size + 1);
+  _build(0, order.size(), order, centroids, bmin, bmax);
+
+  // store the surface elements in leaf order
+  _surface_element_list.resize(order.size());
+  _surface_to_volume_element.resize(order.size());
+  for(unsigned int n=0; n<order.size(); ++n)
+  {
+    _surface_element_list[n] = surface_elems[order[n]];
+    _surface_to_volume_element[n] = volume_elems[order[n]];
+  }
+
+  // ready for take-off
+  this->_initialized = true;
+}
+
+
+
+unsigned int SurfaceLocatorBVH::_build(unsigned int first, unsigned int last, std::vector<unsigned int> &order,
+                                       const std::vector<Point> &centroids, const std::vector<Point> &bmin, const std::vector<Point> &bmax)
+{
+  unsigned int index = _nodes.size();
+  _nodes.push_back(BVHNode());
+
+  BVHNode node;
+  node.bmin = Point(1.e30,   1.e30,  1.e30);
+  node.bmax = Point(-1.e30, -1.e30, -1.e30);
+  Point cmin(1.e30,   1.e30,  1.e30);
+  Point cmax(-1.e30, -1.e30, -1.e30);
+  for(unsigned int n=first; n<last; ++n)
+    for (unsigned int k=0; k<3; k++)
+    {
+      node.bmin(k) = std::min(node.bmin(k), bmin[order[n]](k));
+      node.bmax(k) = std::max(node.bmax(k), bmax[order[n]](k));
+      cmin(k) = std::min(cmin(k), centroids[order[n]](k));
+      cmax(k) = std::max(cmax(k), centroids[order[n]](k));
+    }
+
+  node.left = node.right = invalid_uint;
+  node.first = first;
+  node.n_elems = last - first;
+
+  if( last - first > leaf_size )
+  {
+    // split at the median of the longest axis of centroids
+    unsigned int axis = 0;
+    for (unsigned int k=1; k<3; k++)
+      if( cmax(k) - cmin(k) > cmax(axis) - cmin(axis) ) axis = k;
+
+    unsigned int mid = (first + last)/2;
+    std::nth_element(order.begin()+first, order.begin()+mid, order.begin()+last, CentroidLess(centroids, axis));
+
+    node.n_elems = 0;
+    node.left  = _build(first, mid, order, centroids, bmin, bmax);
+    node.right = _build(mid, last, order, centroids, bmin, bmax);
+  }
+
+  _nodes[index] = node;
+  return index;
+}
+
+
+
+Real SurfaceLocatorBVH::_box_distance(const BVHNode & node, const Point &p)
+{
+  Real d2 = 0.0;
+  for (unsigned int k=0; k<3; k++)
+  {
+    Real d = std::max(node.bmin(k) - p(k), p(k) - node.bmax(k));
+    if( d > 0.0 ) d2 += d*d;
+  }
+  return std::sqrt(d2);
+}
+
+
+
+std::pair<const Elem*, unsigned int> SurfaceLocatorBVH::operator() (const Point& p, Point & project_point, const Real dist) const
+{
+  int nearest_elem = -1;
+  Point nearest_point;
+  Real  voting_dist = dist;
+
+  // nodes to be visited, the nearer child is visited first
+  std::vector<unsigned int> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+
+  while( !stack.empty() )
+  {
+    const BVHNode & node = _nodes[stack.back()];
+    stack.pop_back();
+
+    if( _box_distance(node, p) >= voting_dist ) continue;
+
+    if( node.n_elems )
+    {
+      for(unsigned int n=node.first; n<node.first+node.n_elems; ++n)
+      {
+        Real d;
+        Point np = _surface_element_list[n]->nearest_point(p, &d);
+        if( d < voting_dist )
+        {
+          nearest_elem = n;
+          nearest_point = np;
+          voting_dist = d;
+        }
+      }
+      continue;
+    }
+
+    Real d_left  = _box_distance(_nodes[node.left], p);
+    Real d_right = _box_distance(_nodes[node.right], p);
+    if( d_left < d_right )
+    {
+      stack.push_back(node.right);
+      stack.push_back(node.left);
+    }
+    else
+    {
+      stack.push_back(node.left);
+      stack.push_back(node.right);
+    }
+  }
+
+  if( nearest_elem < 0 ) return std::make_pair((const Elem*)0, invalid_uint);
+
+  project_point = nearest_point;
+  return _surface_to_volume_element[nearest_elem];
+}
+
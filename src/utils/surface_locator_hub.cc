@@ -54,22 +54,49 @@ void SurfaceLocatorHub::clear()
 }
 
 
-std::pair<const Elem*, unsigned int> SurfaceLocatorHub::operator() (const Point& p, const unsigned int subdomain, Point & project_point, const Real dist)
+const SurfaceLocatorBase * SurfaceLocatorHub::_subdomain_locator(const unsigned int subdomain)
 {
   const SurfaceLocatorBase * & subdomain_surface_locator = _subdomain_surface_locators[subdomain];
   if( subdomain_surface_locator == NULL )
     subdomain_surface_locator = SurfaceLocatorBase::build(_type, _mesh, subdomain).release();
-  return (*subdomain_surface_locator)(p, project_point, dist);
+  return subdomain_surface_locator;
 }
 
 
-std::pair<const Elem*, unsigned int> SurfaceLocatorHub::operator() (const Point& p, const short int boundary, Point & project_point, const Real dist)
+const SurfaceLocatorBase * SurfaceLocatorHub::_boundary_locator(const short int boundary)
 {
   if( _boundary_surface_locators.find(boundary) == _boundary_surface_locators.end() )
   {
     const SurfaceLocatorBase * _locator = SurfaceLocatorBase::build(_type, _mesh, boundary).release();
     _boundary_surface_locators.insert( std::make_pair(boundary,_locator ) );
   }
+  return _boundary_surface_locators.find(boundary)->second;
+}
+
+
+std::pair<const Elem*, unsigned int> SurfaceLocatorHub::operator() (const Point& p, const unsigned int subdomain, Point & project_point, const Real dist)
+{
+  return (*_subdomain_locator(subdomain))(p, project_point, dist);
+}
 
-  return (*_boundary_surface_locators.find(boundary)->second)(p, project_point, dist);
+
+std::pair<const Elem*, unsigned int> SurfaceLocatorHub::operator() (const Point& p, const short int boundary, Point & project_point, const Real dist)
+{
+  return (*_boundary_locator(boundary))(p, project_point, dist);
+}
+
+
+void SurfaceLocatorHub::operator() (const std::vector<Point>& p, const unsigned int subdomain,
+                                    std::vector< std::pair<const Elem*, unsigned int> > & surface_elems,
+                                    std::vector<Point> & project_points, const Real dist)
+{
+  _subdomain_locator(subdomain)->locate_batch(p, surface_elems, project_points, dist);
+}
+
+
+void SurfaceLocatorHub::operator() (const std::vector<Point>& p, const short int boundary,
+                                    std::vector< std::pair<const Elem*, unsigned int> > & surface_elems,
+                                    std::vector<Point> & project_points, const Real dist)
+{
+  _boundary_locator(boundary)->locate_batch(p, surface_elems, project_points, dist);
 }
@@ -22,81 +22,140 @@
 //  $Id: sync_file.cc,v 1.4 2008/07/09 05:58:16 gdiso Exp $
 
 #include "genius_common.h"
+#include <algorithm>
+#include <climits>
 #include <cstring>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include "parallel.h"
+#include "sync_file.h"
+
 
 /**
- * transport text file to other processor,
- * return local name as filename.processor_id 
+ * read the whole file into string
  */
-const std::string sync_file(const char * filename)
+static std::string read_file(const char * filename)
 {
-#ifdef HAVE_MPI
-  // buffer for file text
-  std::string   str;
-  
+  std::ifstream   in(filename);
+  // test if file exist
+  genius_assert(in.good());
+  // read file into string
+  std::istreambuf_iterator<char>   beg(in),   end;
+  std::string str(beg,   end);
+  in.close();
+  return str;
+}
+
+
+#if defined(HAVE_MPI) && MPI_VERSION >= 3
+
+SharedFile::SharedFile(const char * filename)
+  : _data(0), _size(0)
+{
+  MPI_Comm_split_type(PETSC_COMM_WORLD, MPI_COMM_TYPE_SHARED, Genius::processor_id(), MPI_INFO_NULL, &_node_comm);
+  int node_rank;
+  MPI_Comm_rank(_node_comm, &node_rank);
+
+  // processor 0 is the first one of its node, and the root of leaders
+  MPI_Comm_split(PETSC_COMM_WORLD, node_rank == 0 ? 0 : MPI_UNDEFINED, Genius::processor_id(), &_leader_comm);
+
   // read only at processor 0
+  std::string str;
   if (Genius::processor_id() == 0)
+    str = read_file(filename);
+
+  unsigned long size = str.size();
+  MPI_Bcast(&size, 1, MPI_UNSIGNED_LONG, 0, PETSC_COMM_WORLD);
+  _size = size;
+
+  // the first processor of the node owns the window, the others map it
+  char * base = 0;
+  MPI_Aint win_size = (node_rank == 0 ? static_cast<MPI_Aint>(_size) : 0);
+  MPI_Win_allocate_shared(win_size, 1, MPI_INFO_NULL, _node_comm, &base, &_win);
+  if (node_rank != 0)
   {
-    std::ifstream   in(filename);
-    // test if file exist
-    genius_assert(in.good());
-    // read file into string
-    std::istreambuf_iterator<char>   beg(in),   end;
-    str = std::string(beg,   end);
-    
-    in.close();
+    MPI_Aint owner_size;
+    int disp_unit;
+    MPI_Win_shared_query(_win, 0, &owner_size, &disp_unit, &base);
   }
 
-  // Broadcast the string
-  Parallel::broadcast(str);
-  
-  //generate local file name 
-  std::string localfilename(filename);
-  std::string processor;
-  std::stringstream   ss;
-  ss << Genius::processor_id();
-  ss >> processor;
-  localfilename = localfilename + "." + processor;
-  
-  // write down
-  std::ofstream   out(localfilename.c_str());
-  out << str;
-  out.close();
-  
-  return localfilename;
+  MPI_Win_fence(0, _win);
+  if (node_rank == 0 && _size)
+  {
+    if (Genius::processor_id() == 0)
+      memcpy(base, str.data(), _size);
+
+    // one copy to each node, in pieces fit for int count
+    for (size_t offset=0; offset<_size; offset+=INT_MAX)
+    {
+      int count = static_cast<int>(std::min(_size-offset, static_cast<size_t>(INT_MAX)));
+      MPI_Bcast(base+offset, count, MPI_CHAR, 0, _leader_comm);
+    }
+  }
+  MPI_Win_fence(0, _win);
+
+  _data = base;
+}
+
+
+SharedFile::~SharedFile()
+{
+  MPI_Win_free(&_win);
+  if (_leader_comm != MPI_COMM_NULL)
+    MPI_Comm_free(&_leader_comm);
+  MPI_Comm_free(&_node_comm);
+}
 
 #else
 
-  // test if file exist
-  std::ifstream   in(filename);
-  genius_assert(in.good());
-  
-  // read file into string
-  std::istreambuf_iterator<char>   beg(in),   end;
-  std::string str(beg,   end);
-  in.close();
-  
-  //generate local file name 
+SharedFile::SharedFile(const char * filename)
+{
+#ifdef HAVE_MPI
+  // read only at processor 0
+  if (Genius::processor_id() == 0)
+    _text = read_file(filename);
+
+  // Broadcast the string
+  Parallel::broadcast(_text);
+#else
+  _text = read_file(filename);
+#endif
+
+  _data = _text.data();
+  _size = _text.size();
+}
+
+
+SharedFile::~SharedFile()
+{}
+
+#endif
+
+
+
+/**
+ * transport text file to other processor,
+ * return local name as filename.processor_id
+ */
+const std::string sync_file(const char * filename)
+{
+  SharedFile text(filename);
+
+  //generate local file name
   std::string localfilename(filename);
   std::string processor;
   std::stringstream   ss;
   ss << Genius::processor_id();
   ss >> processor;
   localfilename = localfilename + "." + processor;
-  
+
   // write down
   std::ofstream   out(localfilename.c_str());
-  out << str;
+  out.write(text.data(), text.size());
   out.close();
-  
-  return localfilename;
-
-#endif  
 
+  return localfilename;
 }
 
@@ -20,6 +20,8 @@
 
 
 // C++ includes
+#include <algorithm>
+#include <iterator>
 
 // Local includes
 #include "tree.h"
@@ -62,6 +64,12 @@ Tree<N>::Tree (const MeshBase& m,
 
     MeshTools::build_nodes_to_elem_map (mesh, nodes_to_elem);
     root.transform_nodes_to_elements (nodes_to_elem);
+
+    // all the elements connected to the nodes are in the tree
+    MeshBase::const_element_iterator       el  = mesh.elements_begin();
+    const MeshBase::const_element_iterator el_end = mesh.elements_end();
+    for (; el != el_end; ++el)
+      tree_elems.push_back(*el);
   }
 
   else if (build_type == Trees::ELEMENTS)
@@ -74,6 +82,7 @@ Tree<N>::Tree (const MeshBase& m,
     for (; it != end; ++it)
     {
         root.insert (*it);
+        tree_elems.push_back(*it);
     }
   }
 
@@ -105,6 +114,8 @@ Tree<N>::Tree (const MeshBase& m,
       surface_elems.push_back(surface_elem);
     }
   }
+
+  std::sort(tree_elems.begin(), tree_elems.end());
 }
 
 
@@ -117,6 +128,40 @@ Tree<N>::~Tree()
 }
 
 
+template <unsigned int N>
+bool Tree<N>::update()
+{
+  // the boundary trees hold elements not owned by the mesh
+  if (build_type != Trees::NODES && build_type != Trees::ELEMENTS)
+    return false;
+
+  // new elements should be inside the root bounding box
+  const std::pair<Point, Point> & root_box = root.get_bounding_box();
+  const MeshTools::BoundingBox bbox = MeshTools::bounding_box(mesh);
+  for (unsigned int d=0; d<3; d++)
+    if (bbox.first(d) < root_box.first(d) || bbox.second(d) > root_box.second(d))
+      return false;
+
+  std::vector<const Elem *> new_elems;
+  MeshBase::const_element_iterator       it  = mesh.active_elements_begin();
+  const MeshBase::const_element_iterator end = mesh.active_elements_end();
+  for (; it != end; ++it)
+    if (!std::binary_search(tree_elems.begin(), tree_elems.end(), *it))
+      new_elems.push_back(*it);
+
+  for (unsigned int n=0; n<new_elems.size(); ++n)
+    root.insert (new_elems[n]);
+
+  std::sort(new_elems.begin(), new_elems.end());
+  std::vector<const Elem *> merged;
+  merged.reserve(tree_elems.size() + new_elems.size());
+  std::merge(tree_elems.begin(), tree_elems.end(), new_elems.begin(), new_elems.end(), std::back_inserter(merged));
+  tree_elems.swap(merged);
+
+  return true;
+}
+
+
 template <unsigned int N>
 const Elem* Tree<N>::find_element(const Point& p) const
 {